@@ -110,6 +110,7 @@ camera_metadata_t* CameraMetadata::release() {
     }
     camera_metadata_t *released = mBuffer;
     mBuffer = NULL;
+    mTagIndex.clear();
     return released;
 }
 
@@ -122,6 +123,7 @@ void CameraMetadata::clear() {
         free_camera_metadata(mBuffer);
         mBuffer = NULL;
     }
+    mTagIndex.clear();
 }
 
 void CameraMetadata::acquire(camera_metadata_t *buffer) {
@@ -158,6 +160,7 @@ status_t CameraMetadata::append(const camera_metadata_t* other) {
     size_t extraData = get_camera_metadata_data_count(other);
     resizeIfNeeded(extraEntries, extraData);
 
+    mTagIndex.clear();
     return append_camera_metadata(mBuffer, other);
 }
 
@@ -180,9 +183,84 @@ status_t CameraMetadata::sort() {
         ALOGE("%s: CameraMetadata is locked", __FUNCTION__);
         return INVALID_OPERATION;
     }
+    mTagIndex.clear();
     return sort_camera_metadata(mBuffer);
 }
 
+// First tag index slot of each section, the sections being laid out one after
+// the other; the last element is the total number of slots.
+static const std::vector<size_t>& tagIndexSectionSlots() {
+    static const std::vector<size_t> sectionSlots = [] {
+        std::vector<size_t> slots(ANDROID_SECTION_COUNT + 1, 0);
+        for (size_t i = 0; i < ANDROID_SECTION_COUNT; i++) {
+            slots[i + 1] = slots[i] +
+                    camera_metadata_section_bounds[i][1] - camera_metadata_section_bounds[i][0];
+        }
+        return slots;
+    }();
+    return sectionSlots;
+}
+
+ssize_t CameraMetadata::tagIndexSlot(uint32_t tag) {
+    uint32_t section = tag >> 16;
+    if (section >= ANDROID_SECTION_COUNT ||
+            tag >= camera_metadata_section_bounds[section][1]) {
+        return -1;
+    }
+    return tagIndexSectionSlots()[section] + (tag - camera_metadata_section_bounds[section][0]);
+}
+
+status_t CameraMetadata::buildTagIndex() {
+    if (mLocked) {
+        ALOGE("%s: CameraMetadata is locked", __FUNCTION__);
+        return INVALID_OPERATION;
+    }
+    mTagIndex.assign(tagIndexSectionSlots().back(), -1);
+    size_t count = entryCount();
+    for (size_t i = 0; i < count; i++) {
+        camera_metadata_ro_entry_t entry;
+        if (get_camera_metadata_ro_entry(mBuffer, i, &entry) != OK) {
+            mTagIndex.clear();
+            return INVALID_OPERATION;
+        }
+        ssize_t slot = tagIndexSlot(entry.tag);
+        if (slot < 0) {
+            continue;
+        }
+        if (mTagIndex[slot] >= 0) {
+            // Which of duplicate entries a search finds depends on the
+            // ordering; keep searching.
+            ALOGV("%s: Duplicate entries for tag %x, not indexing", __FUNCTION__, entry.tag);
+            mTagIndex.clear();
+            return OK;
+        }
+        mTagIndex[slot] = i;
+    }
+    return OK;
+}
+
+status_t CameraMetadata::findEntry(uint32_t tag, camera_metadata_entry_t *entry) {
+    ssize_t slot = mTagIndex.empty() ? -1 : tagIndexSlot(tag);
+    if (slot < 0) {
+        return find_camera_metadata_entry(mBuffer, tag, entry);
+    }
+    if (mTagIndex[slot] < 0) {
+        return NAME_NOT_FOUND;
+    }
+    return get_camera_metadata_entry(mBuffer, mTagIndex[slot], entry);
+}
+
+status_t CameraMetadata::findEntry(uint32_t tag, camera_metadata_ro_entry_t *entry) const {
+    ssize_t slot = mTagIndex.empty() ? -1 : tagIndexSlot(tag);
+    if (slot < 0) {
+        return find_camera_metadata_ro_entry(mBuffer, tag, entry);
+    }
+    if (mTagIndex[slot] < 0) {
+        return NAME_NOT_FOUND;
+    }
+    return get_camera_metadata_ro_entry(mBuffer, mTagIndex[slot], entry);
+}
+
 status_t CameraMetadata::checkType(uint32_t tag, uint8_t expectedType) {
     int tagType = get_local_camera_metadata_tag_type(tag, mBuffer);
     if ( CC_UNLIKELY(tagType == -1)) {
@@ -334,10 +412,14 @@ status_t CameraMetadata::updateImpl(uint32_t tag, const void *data,
 
     if (res == OK) {
         camera_metadata_entry_t entry;
-        res = find_camera_metadata_entry(mBuffer, tag, &entry);
+        res = findEntry(tag, &entry);
         if (res == NAME_NOT_FOUND) {
             res = add_camera_metadata_entry(mBuffer,
                     tag, data, data_count);
+            ssize_t slot = mTagIndex.empty() ? -1 : tagIndexSlot(tag);
+            if (res == OK && slot >= 0) {
+                mTagIndex[slot] = get_camera_metadata_entry_count(mBuffer) - 1;
+            }
         } else if (res == OK) {
             res = update_camera_metadata_entry(mBuffer,
                     entry.index, data, data_count, NULL);
@@ -364,7 +446,7 @@ status_t CameraMetadata::updateImpl(uint32_t tag, const void *data,
 
 bool CameraMetadata::exists(uint32_t tag) const {
     camera_metadata_ro_entry entry;
-    return find_camera_metadata_ro_entry(mBuffer, tag, &entry) == 0;
+    return findEntry(tag, &entry) == 0;
 }
 
 camera_metadata_entry_t CameraMetadata::find(uint32_t tag) {
@@ -375,7 +457,7 @@ camera_metadata_entry_t CameraMetadata::find(uint32_t tag) {
         entry.count = 0;
         return entry;
     }
-    res = find_camera_metadata_entry(mBuffer, tag, &entry);
+    res = findEntry(tag, &entry);
     if (CC_UNLIKELY( res != OK )) {
         entry.count = 0;
         entry.data.u8 = NULL;
@@ -386,7 +468,7 @@ camera_metadata_entry_t CameraMetadata::find(uint32_t tag) {
 camera_metadata_ro_entry_t CameraMetadata::find(uint32_t tag) const {
     status_t res;
     camera_metadata_ro_entry entry;
-    res = find_camera_metadata_ro_entry(mBuffer, tag, &entry);
+    res = findEntry(tag, &entry);
     if (CC_UNLIKELY( res != OK )) {
         entry.count = 0;
         entry.data.u8 = NULL;
@@ -401,7 +483,7 @@ status_t CameraMetadata::erase(uint32_t tag) {
         ALOGE("%s: CameraMetadata is locked", __FUNCTION__);
         return INVALID_OPERATION;
     }
-    res = find_camera_metadata_entry(mBuffer, tag, &entry);
+    res = findEntry(tag, &entry);
     if (res == NAME_NOT_FOUND) {
         return OK;
     } else if (res != OK) {
@@ -419,6 +501,16 @@ status_t CameraMetadata::erase(uint32_t tag) {
                 get_local_camera_metadata_section_name(tag, mBuffer),
                 get_local_camera_metadata_tag_name(tag, mBuffer),
                 tag, strerror(-res), res);
+        mTagIndex.clear();
+        return res;
+    }
+    // The entries after the deleted one moved down by one
+    for (int32_t &index : mTagIndex) {
+        if (index > (int32_t)entry.index) {
+            index--;
+        } else if (index == (int32_t)entry.index) {
+            index = -1;
+        }
     }
     return res;
 }
@@ -784,6 +876,7 @@ void CameraMetadata::swap(CameraMetadata& other) {
 
     other.mBuffer = thisBuf;
     mBuffer = otherBuf;
+    mTagIndex.swap(other.mTagIndex);
 }
 
 status_t CameraMetadata::getTagFromName(const char *name,
@@ -19,6 +19,8 @@
 
 #include "system/camera_metadata.h"
 
+#include <vector>
+
 #include <utils/String8.h>
 #include <utils/Vector.h>
 #include <binder/Parcelable.h>
@@ -137,6 +139,18 @@ class CameraMetadata: public Parcelable {
      */
     status_t sort();
 
+    /**
+     * Index the entries by tag, so that find(), exists(), update() and erase()
+     * of framework-defined tags no longer search the buffer. The index is kept
+     * up to date by update() and erase(), and dropped by anything that moves
+     * entries around (sort, append, acquire, assignment, ...); vendor tags are
+     * not indexed and are still searched.
+     *
+     * Meant for buffers that get many lookups after they're filled in, such as
+     * capture results going through the result mappers.
+     */
+    status_t buildTagIndex();
+
     /**
      * Update metadata entry. Will create entry if it doesn't exist already, and
      * will reallocate the buffer if insufficient space exists. Overloaded for
@@ -251,6 +265,23 @@ class CameraMetadata: public Parcelable {
     camera_metadata_t *mBuffer;
     mutable bool       mLocked;
 
+    /**
+     * Entry index of each framework-defined tag, -1 if it has no entry. Empty
+     * when the buffer isn't indexed.
+     */
+    std::vector<int32_t> mTagIndex;
+
+    /**
+     * Slot of tag in mTagIndex, or -1 if the tag isn't indexed
+     */
+    static ssize_t tagIndexSlot(uint32_t tag);
+
+    /**
+     * Find an entry, through the tag index if there is one
+     */
+    status_t findEntry(uint32_t tag, camera_metadata_entry_t *entry);
+    status_t findEntry(uint32_t tag, camera_metadata_ro_entry_t *entry) const;
+
     /**
      * Check if tag has a given type
      */
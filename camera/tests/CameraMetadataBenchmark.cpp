@@ -0,0 +1,112 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <camera/CameraMetadata.h>
+#include <camera_metadata_hidden.h>
+
+// Measures CameraMetadata tag lookups on a buffer the size of a typical
+// capture result, the way the result mappers do them: on the sorted result,
+// after a mapper added an entry (unsorted), and through the tag index.
+
+using namespace android;
+
+namespace {
+
+enum LookupMode {
+    SORTED,
+    UNSORTED,
+    INDEXED,
+};
+
+// Roughly what a HAL sends in a capture result
+const size_t kNumResultEntries = 150;
+
+// Tags looked up by every iteration, one in three of them missing
+std::vector<uint32_t> gLookedUpTags;
+
+CameraMetadata makeResult() {
+    CameraMetadata result;
+    std::vector<uint8_t> zeros(64);
+    gLookedUpTags.clear();
+    size_t numEntries = 0;
+    for (uint32_t section = 0;
+            section < ANDROID_SECTION_COUNT && numEntries < kNumResultEntries; section++) {
+        for (uint32_t tag = camera_metadata_section_bounds[section][0];
+                tag < camera_metadata_section_bounds[section][1] &&
+                numEntries < kNumResultEntries; tag++) {
+            int type = get_camera_metadata_tag_type(tag);
+            if (type < 0) {
+                continue;
+            }
+            gLookedUpTags.push_back(tag);
+            if (gLookedUpTags.size() % 3 == 0) {
+                continue;
+            }
+            camera_metadata_ro_entry_t entry = {};
+            entry.tag = tag;
+            entry.type = type;
+            entry.count = 1;
+            entry.data.u8 = zeros.data();
+            result.update(entry);
+            numEntries++;
+        }
+    }
+    result.sort();
+    return result;
+}
+
+void BM_Find(benchmark::State &state, LookupMode mode) {
+    CameraMetadata result = makeResult();
+    if (mode == UNSORTED) {
+        // Like a mapper adding an entry
+        float zoomRatio = 1.0f;
+        result.erase(ANDROID_CONTROL_ZOOM_RATIO);
+        result.update(ANDROID_CONTROL_ZOOM_RATIO, &zoomRatio, 1);
+    } else if (mode == INDEXED) {
+        result.buildTagIndex();
+    }
+    const CameraMetadata &constResult = result;
+
+    for (auto _ : state) {
+        for (uint32_t tag : gLookedUpTags) {
+            benchmark::DoNotOptimize(constResult.find(tag));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * gLookedUpTags.size());
+}
+
+void BM_BuildTagIndex(benchmark::State &state) {
+    CameraMetadata result = makeResult();
+    for (auto _ : state) {
+        result.sort();  // drops the index, and is part of what's measured
+        result.buildTagIndex();
+    }
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(BM_Find, sorted, SORTED);
+BENCHMARK_CAPTURE(BM_Find, unsorted, UNSORTED);
+BENCHMARK_CAPTURE(BM_Find, indexed, INDEXED);
+BENCHMARK(BM_BuildTagIndex);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "CameraMetadataTests"
+
+#include <camera/CameraMetadata.h>
+#include <utils/Errors.h>
+#include <utils/Log.h>
+
+#include <gtest/gtest.h>
+#include <stdint.h>
+#include <string.h>
+
+using namespace android;
+
+static const uint32_t kTestTags[] = {
+    ANDROID_SENSOR_TIMESTAMP,
+    ANDROID_CONTROL_AE_MODE,
+    ANDROID_SCALER_CROP_REGION,
+    ANDROID_CONTROL_ZOOM_RATIO,
+    ANDROID_LENS_FOCUS_DISTANCE,
+    ANDROID_FLASH_MODE,
+    ANDROID_STATISTICS_FACE_RECTANGLES,
+};
+
+#define ARRAY_SIZE(a)      (sizeof(a) / sizeof((a)[0]))
+
+// Expects the same entry for |tag| in both buffers.
+static void expectSameEntry(const CameraMetadata &expected, const CameraMetadata &actual,
+        uint32_t tag) {
+    camera_metadata_ro_entry_t e = expected.find(tag);
+    camera_metadata_ro_entry_t a = actual.find(tag);
+    EXPECT_EQ(expected.exists(tag), actual.exists(tag)) << "tag " << std::hex << tag;
+    ASSERT_EQ(e.count, a.count) << "tag " << std::hex << tag;
+    if (e.count > 0) {
+        EXPECT_EQ(e.tag, a.tag);
+        EXPECT_EQ(e.type, a.type);
+        size_t size = camera_metadata_type_size[e.type] * e.count;
+        EXPECT_EQ(0, memcmp(e.data.u8, a.data.u8, size)) << "tag " << std::hex << tag;
+    }
+}
+
+static void expectSameEntries(const CameraMetadata &expected, const CameraMetadata &actual) {
+    EXPECT_EQ(expected.entryCount(), actual.entryCount());
+    for (size_t i = 0; i < ARRAY_SIZE(kTestTags); i++) {
+        expectSameEntry(expected, actual, kTestTags[i]);
+    }
+}
+
+static CameraMetadata makeResult() {
+    CameraMetadata result;
+    int64_t timestamp = 1234567;
+    uint8_t aeMode = ANDROID_CONTROL_AE_MODE_ON;
+    int32_t cropRegion[] = {0, 0, 4000, 3000};
+    float focusDistance = 2.5f;
+    EXPECT_EQ(OK, result.update(ANDROID_SENSOR_TIMESTAMP, &timestamp, 1));
+    EXPECT_EQ(OK, result.update(ANDROID_CONTROL_AE_MODE, &aeMode, 1));
+    EXPECT_EQ(OK, result.update(ANDROID_SCALER_CROP_REGION, cropRegion, 4));
+    EXPECT_EQ(OK, result.update(ANDROID_LENS_FOCUS_DISTANCE, &focusDistance, 1));
+    return result;
+}
+
+TEST(CameraMetadataTest, TagIndexMatchesSearch) {
+    CameraMetadata expected = makeResult();
+    CameraMetadata actual = makeResult();
+    ASSERT_EQ(OK, actual.buildTagIndex());
+    expectSameEntries(expected, actual);
+
+    // Add entries, update one in place and one with a larger size
+    float zoomRatio = 2.0f;
+    uint8_t flashMode = ANDROID_FLASH_MODE_OFF;
+    uint8_t aeMode = ANDROID_CONTROL_AE_MODE_OFF;
+    int32_t faces[] = {0, 0, 10, 10, 20, 20, 30, 30};
+    for (CameraMetadata *metadata : {&expected, &actual}) {
+        EXPECT_EQ(OK, metadata->update(ANDROID_CONTROL_ZOOM_RATIO, &zoomRatio, 1));
+        EXPECT_EQ(OK, metadata->update(ANDROID_FLASH_MODE, &flashMode, 1));
+        EXPECT_EQ(OK, metadata->update(ANDROID_CONTROL_AE_MODE, &aeMode, 1));
+        EXPECT_EQ(OK, metadata->update(ANDROID_STATISTICS_FACE_RECTANGLES, faces, 4));
+        EXPECT_EQ(OK, metadata->update(ANDROID_STATISTICS_FACE_RECTANGLES, faces, 8));
+    }
+    expectSameEntries(expected, actual);
+
+    // Erase entries before, between and after the others
+    for (uint32_t tag : {ANDROID_SENSOR_TIMESTAMP, ANDROID_FLASH_MODE,
+            ANDROID_STATISTICS_FACE_RECTANGLES, ANDROID_FLASH_MODE}) {
+        EXPECT_EQ(OK, expected.erase(tag));
+        EXPECT_EQ(OK, actual.erase(tag));
+        expectSameEntries(expected, actual);
+    }
+
+    // Operations moving entries drop the index
+    EXPECT_EQ(OK, expected.sort());
+    EXPECT_EQ(OK, actual.sort());
+    expectSameEntries(expected, actual);
+
+    // The index goes along with the buffer
+    ASSERT_EQ(OK, actual.buildTagIndex());
+    CameraMetadata other = makeResult();
+    actual.swap(other);
+    other.swap(actual);
+    expectSameEntries(expected, actual);
+}
+
+TEST(CameraMetadataTest, TagIndexWithDuplicates) {
+    CameraMetadata expected = makeResult();
+    EXPECT_EQ(OK, expected.append(makeResult()));
+    CameraMetadata actual(expected);
+
+    ASSERT_EQ(OK, actual.buildTagIndex());
+    expectSameEntries(expected, actual);
+    EXPECT_EQ(OK, expected.erase(ANDROID_CONTROL_AE_MODE));
+    EXPECT_EQ(OK, actual.erase(ANDROID_CONTROL_AE_MODE));
+    expectSameEntries(expected, actual);
+}
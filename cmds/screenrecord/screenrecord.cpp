@@ -14,8 +14,14 @@
  * limitations under the License.
  */
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string_view>
+#include <thread>
 #include <type_traits>
+#include <vector>
 
 #include <assert.h>
 #include <ctype.h>
@@ -123,6 +129,7 @@ static uint32_t gVideoHeight = 0;
 static uint32_t gBitRate = 20000000;     // 20Mbps
 static uint32_t gTimeLimitSec = kMaxTimeLimitSec;
 static uint32_t gBframes = 0;
+static float gMaxFps = 0;               // cap on the encoded frame rate, 0 for none
 static std::optional<PhysicalDisplayId> gPhysicalDisplayId;
 // Set by signal handler to stop recording.
 static volatile bool gStopRequested = false;
@@ -199,6 +206,11 @@ static status_t prepareEncoder(float displayFps, sp<MediaCodec>* pCodec,
     format->setString(KEY_MIME, kMimeTypeAvc);
     format->setInt32(KEY_COLOR_FORMAT, OMX_COLOR_FormatAndroidOpaque);
     format->setInt32(KEY_BIT_RATE, gBitRate);
+    if (gMaxFps > 0) {
+        // Frames coming faster are dropped before the encoder.
+        format->setFloat(KEY_MAX_FPS_TO_ENCODER, gMaxFps);
+        displayFps = std::min(displayFps, gMaxFps);
+    }
     format->setFloat(KEY_FRAME_RATE, displayFps);
     format->setInt32(KEY_I_FRAME_INTERVAL, 10);
     format->setInt32(KEY_MAX_B_FRAMES, gBframes);
@@ -546,6 +558,105 @@ void updateDisplayProjection(const sp<IBinder>& virtualDpy, ui::DisplayState& di
     }
 }
 
+/*
+ * Writes the encoded samples to the muxer on its own thread, so that a slow
+ * write (e.g. when the storage flushes) doesn't keep the encoder output
+ * buffers and make the encoder drop frames.
+ */
+class SampleWriter {
+public:
+    explicit SampleWriter(AMediaMuxer* muxer) : mMuxer(muxer) {
+        mThread = std::thread(&SampleWriter::threadLoop, this);
+    }
+
+    ~SampleWriter() {
+        stop();
+    }
+
+    // Queues a copy of the sample.  Returns the error of a previous write if
+    // there was one.
+    status_t queue(size_t trackIdx, const uint8_t* data, size_t size, int64_t ptsUsec,
+            uint32_t flags) {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (mError != NO_ERROR) {
+            return mError;
+        }
+        mSamples.push_back({trackIdx, std::vector<uint8_t>(data, data + size), ptsUsec, flags});
+        mMaxQueued = std::max(mMaxQueued, mSamples.size());
+        mCondition.notify_one();
+        return NO_ERROR;
+    }
+
+    // Writes the queued samples and stops the thread.  Returns the first
+    // write error.
+    status_t stop() {
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            mStopping = true;
+            mCondition.notify_one();
+        }
+        if (mThread.joinable()) {
+            mThread.join();
+        }
+        return mError;
+    }
+
+    size_t getMaxQueued() const { return mMaxQueued; }
+    nsecs_t getMaxWriteNs() const { return mMaxWriteNs; }
+
+private:
+    struct Sample {
+        size_t trackIdx;
+        std::vector<uint8_t> data;
+        int64_t ptsUsec;
+        uint32_t flags;
+    };
+
+    void threadLoop() {
+        std::unique_lock<std::mutex> lock(mLock);
+        while (true) {
+            mCondition.wait(lock, [this] { return mStopping || !mSamples.empty(); });
+            if (mSamples.empty()) {
+                break;
+            }
+            Sample sample = std::move(mSamples.front());
+            mSamples.pop_front();
+            lock.unlock();
+
+            ATRACE_NAME("write sample");
+            nsecs_t startNs = systemTime(SYSTEM_TIME_MONOTONIC);
+            AMediaCodecBufferInfo bufferInfo = {
+                0 /* offset */,
+                static_cast<int32_t>(sample.data.size()),
+                sample.ptsUsec /* presentationTimeUs */,
+                sample.flags
+            };
+            status_t err = AMediaMuxer_writeSampleData(mMuxer, sample.trackIdx,
+                    sample.data.data(), &bufferInfo);
+            nsecs_t writeNs = systemTime(SYSTEM_TIME_MONOTONIC) - startNs;
+
+            lock.lock();
+            mMaxWriteNs = std::max(mMaxWriteNs, writeNs);
+            if (err != NO_ERROR) {
+                fprintf(stderr, "Failed writing data to muxer (err=%d)\n", err);
+                mError = err;
+                mSamples.clear();
+                break;
+            }
+        }
+    }
+
+    AMediaMuxer* const mMuxer;
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    std::deque<Sample> mSamples;
+    bool mStopping = false;
+    status_t mError = NO_ERROR;
+    size_t mMaxQueued = 0;
+    nsecs_t mMaxWriteNs = 0;
+    std::thread mThread;
+};
+
 /*
  * Runs the MediaCodec encoder, sending the output to the MediaMuxer.  The
  * input frames are coming from the virtual display as fast as SurfaceFlinger
@@ -577,6 +688,11 @@ static status_t runEncoder(const sp<MediaCodec>& encoder, AMediaMuxer* muxer, FI
         return err;
     }
 
+    std::unique_ptr<SampleWriter> writer;
+    if (muxer != NULL) {
+        writer = std::make_unique<SampleWriter>(muxer);
+    }
+
     // Run until we're signaled.
     while (!gStopRequested) {
         size_t bufIndex, offset, size;
@@ -638,23 +754,12 @@ static status_t runEncoder(const sp<MediaCodec>& encoder, AMediaMuxer* muxer, FI
                     // need to pass either the full set of BufferInfo flags, or
                     // (flags & BUFFER_FLAG_SYNCFRAME).
                     //
-                    // If this blocks for too long we could drop frames.  We may
-                    // want to queue these up and do them on a different thread.
-                    ATRACE_NAME("write sample");
+                    // The sample is written by the writer thread, so that a
+                    // slow write doesn't hold the encoder buffer.
                     assert(trackIdx != -1);
-                    // TODO
-                    sp<ABuffer> buffer = new ABuffer(
-                            buffers[bufIndex]->data(), buffers[bufIndex]->size());
-                    AMediaCodecBufferInfo bufferInfo = {
-                        0 /* offset */,
-                        static_cast<int32_t>(buffer->size()),
-                        ptsUsec /* presentationTimeUs */,
-                        flags
-                    };
-                    err = AMediaMuxer_writeSampleData(muxer, trackIdx, buffer->data(), &bufferInfo);
+                    err = writer->queue(trackIdx, buffers[bufIndex]->data(),
+                            buffers[bufIndex]->size(), ptsUsec, flags);
                     if (err != NO_ERROR) {
-                        fprintf(stderr,
-                            "Failed writing data to muxer (err=%d)\n", err);
                         return err;
                     }
                     if (gOutputFormat == FORMAT_MP4) {
@@ -725,10 +830,21 @@ static status_t runEncoder(const sp<MediaCodec>& encoder, AMediaMuxer* muxer, FI
     }
 
     ALOGV("Encoder stopping (req=%d)", gStopRequested);
+    if (writer != nullptr) {
+        err = writer->stop();
+        if (err != NO_ERROR) {
+            return err;
+        }
+    }
     if (gVerbose) {
         printf("Encoder stopping; recorded %u frames in %" PRId64 " seconds\n",
                 debugNumFrames, nanoseconds_to_seconds(
                         systemTime(CLOCK_MONOTONIC) - startWhenNsec));
+        if (writer != nullptr) {
+            printf("Muxer queued up to %zu samples, longest write %" PRId64 " ms\n",
+                    writer->getMaxQueued(),
+                    nanoseconds_to_milliseconds(writer->getMaxWriteNs()));
+        }
         fflush(stdout);
     }
     if (metaLegacyTrackIdx >= 0 && metaTrackIdx >= 0 && !timestampsMonotonicUs.isEmpty()) {
@@ -1222,6 +1338,9 @@ static void usage() {
         "--display-id ID\n"
         "    specify the physical display ID to record. Default is the primary display.\n"
         "    see \"dumpsys SurfaceFlinger --display-id\" for valid display IDs.\n"
+        "--max-fps FPS\n"
+        "    Cap the recorded frame rate, frames coming faster are dropped.  Default\n"
+        "    is the display refresh rate.\n"
         "--verbose\n"
         "    Display interesting information on stdout.\n"
         "--help\n"
@@ -1244,6 +1363,7 @@ int main(int argc, char* const argv[]) {
         { "bit-rate",           required_argument,  NULL, 'b' },
         { "time-limit",         required_argument,  NULL, 't' },
         { "bugreport",          no_argument,        NULL, 'u' },
+        { "max-fps",            required_argument,  NULL, 'F' },
         // "unofficial" options
         { "show-device-info",   no_argument,        NULL, 'i' },
         { "show-frame-time",    no_argument,        NULL, 'f' },
@@ -1323,6 +1443,16 @@ int main(int argc, char* const argv[]) {
             gWantInfoScreen = true;
             gWantFrameTime = true;
             break;
+        case 'F':
+        {
+            char *next;
+            gMaxFps = strtof(optarg, &next);
+            if (next == optarg || *next != '\0' || !(gMaxFps > 0)) {
+                fprintf(stderr, "Invalid max fps '%s'\n", optarg);
+                return 2;
+            }
+            break;
+        }
         case 'i':
             gWantInfoScreen = true;
             break;
@@ -300,18 +300,6 @@ ssize_t CryptoHalAidl::decrypt(const uint8_t keyId[16], const uint8_t iv[16],
             return UNKNOWN_ERROR;
     }
 
-    Pattern aPattern;
-    aPattern.encryptBlocks = pattern.mEncryptBlocks;
-    aPattern.skipBlocks = pattern.mSkipBlocks;
-
-    std::vector<SubSample> stdSubSamples;
-    for (size_t i = 0; i < numSubSamples; i++) {
-        SubSample subSample;
-        subSample.numBytesOfClearData = subSamples[i].mNumBytesOfClearData;
-        subSample.numBytesOfEncryptedData = subSamples[i].mNumBytesOfEncryptedData;
-        stdSubSamples.push_back(subSample);
-    }
-
     bool secure;
     if (hDestination.type == BufferTypeHidl::SHARED_MEMORY) {
         status_t status = checkSharedBuffer(hDestination.nonsecureMemory);
@@ -334,16 +322,20 @@ ssize_t CryptoHalAidl::decrypt(const uint8_t keyId[16], const uint8_t iv[16],
     status_t err = UNKNOWN_ERROR;
     mLock.unlock();
 
-    std::vector<uint8_t> keyIdAidl(toStdVec(keyId, 16));
-    std::vector<uint8_t> ivAidl(toStdVec(iv, 16));
-
+    // Samples are small and many for audio, build the arguments in place to
+    // avoid copying the key, iv and subsamples.
     DecryptArgs args;
     args.secure = secure;
-    args.keyId = keyIdAidl;
-    args.iv = ivAidl;
+    args.keyId = toStdVec(keyId, 16);
+    args.iv = toStdVec(iv, 16);
     args.mode = aMode;
-    args.pattern = aPattern;
-    args.subSamples = std::move(stdSubSamples);
+    args.pattern.encryptBlocks = pattern.mEncryptBlocks;
+    args.pattern.skipBlocks = pattern.mSkipBlocks;
+    args.subSamples.resize(numSubSamples);
+    for (size_t i = 0; i < numSubSamples; i++) {
+        args.subSamples[i].numBytesOfClearData = subSamples[i].mNumBytesOfClearData;
+        args.subSamples[i].numBytesOfEncryptedData = subSamples[i].mNumBytesOfEncryptedData;
+    }
     args.source = hidlSharedBufferToAidlSharedBuffer(hSource);
     args.offset = offset;
     args.destination = hidlDestinationBufferToAidlDestinationBuffer(hDestination);
@@ -50,6 +50,11 @@ public:
         return ERROR_UNSUPPORTED;
     }
 
+    // returns how many reads were served and how many bytes were read so far
+    virtual status_t getReadStatistics(int64_t * /*numReads*/, int64_t * /*numBytes*/) {
+        return ERROR_UNSUPPORTED;
+    }
+
     ////////////////////////////////////////////////////////////////////////////
 
     virtual String8 getUri() {
@@ -17,8 +17,8 @@
 #include <stdio.h>
 
 #include <algorithm>
-#include <map>
 #include <sstream>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -800,17 +800,54 @@ const detail::AudioFormatPairs& getAudioFormatPairs() {
     return pairs;
 }
 
+// Hashes of the AIDL types which are the keys of the reverse maps, consistent with
+// their operator==. The lookups of these maps are done on every conversion, so they
+// are hashed rather than ordered, which would compare strings at every tree level.
+struct AidlKeyHash {
+    static size_t combine(size_t seed, size_t value) {
+        return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+    }
+
+    size_t operator()(const AudioChannelLayout& aidl) const {
+        using Tag = AudioChannelLayout::Tag;
+        int value = 0;
+        switch (aidl.getTag()) {
+            case Tag::none: value = aidl.get<Tag::none>(); break;
+            case Tag::invalid: value = aidl.get<Tag::invalid>(); break;
+            case Tag::indexMask: value = aidl.get<Tag::indexMask>(); break;
+            case Tag::layoutMask: value = aidl.get<Tag::layoutMask>(); break;
+            case Tag::voiceMask: value = aidl.get<Tag::voiceMask>(); break;
+        }
+        return combine(static_cast<size_t>(aidl.getTag()), std::hash<int>{}(value));
+    }
+
+    size_t operator()(const AudioDeviceDescription& aidl) const {
+        return combine(static_cast<size_t>(aidl.type), std::hash<std::string>{}(aidl.connection));
+    }
+
+    size_t operator()(const AudioFormatDescription& aidl) const {
+        return combine(combine(static_cast<size_t>(aidl.type), static_cast<size_t>(aidl.pcm)),
+                std::hash<std::string>{}(aidl.encoding));
+    }
+};
+
+template<typename S, typename T>
+using DirectMap = std::unordered_map<S, T>;
+
+template<typename T, typename S>
+using ReverseMap = std::unordered_map<T, S, AidlKeyHash>;
+
 template<typename S, typename T>
-std::map<S, T> make_DirectMap(const std::vector<std::pair<S, T>>& v) {
-    std::map<S, T> result(v.begin(), v.end());
+DirectMap<S, T> make_DirectMap(const std::vector<std::pair<S, T>>& v) {
+    DirectMap<S, T> result(v.begin(), v.end());
     LOG_ALWAYS_FATAL_IF(result.size() != v.size(), "Duplicate key elements detected");
     return result;
 }
 
 template<typename S, typename T>
-std::map<S, T> make_DirectMap(
+DirectMap<S, T> make_DirectMap(
         const std::vector<std::pair<S, T>>& v1, const std::vector<std::pair<S, T>>& v2) {
-    std::map<S, T> result(v1.begin(), v1.end());
+    DirectMap<S, T> result(v1.begin(), v1.end());
     LOG_ALWAYS_FATAL_IF(result.size() != v1.size(), "Duplicate key elements detected in v1");
     result.insert(v2.begin(), v2.end());
     LOG_ALWAYS_FATAL_IF(result.size() != v1.size() + v2.size(),
@@ -819,8 +856,8 @@ std::map<S, T> make_DirectMap(
 }
 
 template<typename S, typename T>
-std::map<T, S> make_ReverseMap(const std::vector<std::pair<S, T>>& v) {
-    std::map<T, S> result;
+ReverseMap<T, S> make_ReverseMap(const std::vector<std::pair<S, T>>& v) {
+    ReverseMap<T, S> result;
     std::transform(v.begin(), v.end(), std::inserter(result, result.begin()),
             [](const std::pair<S, T>& p) {
                 return std::make_pair(p.second, p.first);
@@ -852,13 +889,13 @@ audio_channel_mask_t aidl2legacy_AudioChannelLayout_layout_audio_channel_mask_t_
 
 ConversionResult<audio_channel_mask_t> aidl2legacy_AudioChannelLayout_audio_channel_mask_t(
         const AudioChannelLayout& aidl, bool isInput) {
-    using ReverseMap = std::map<AudioChannelLayout, audio_channel_mask_t>;
+    using LayoutReverseMap = ReverseMap<AudioChannelLayout, audio_channel_mask_t>;
     using Tag = AudioChannelLayout::Tag;
-    static const ReverseMap mIn = make_ReverseMap(getInAudioChannelPairs());
-    static const ReverseMap mOut = make_ReverseMap(getOutAudioChannelPairs());
-    static const ReverseMap mVoice = make_ReverseMap(getVoiceAudioChannelPairs());
+    static const LayoutReverseMap mIn = make_ReverseMap(getInAudioChannelPairs());
+    static const LayoutReverseMap mOut = make_ReverseMap(getOutAudioChannelPairs());
+    static const LayoutReverseMap mVoice = make_ReverseMap(getVoiceAudioChannelPairs());
 
-    auto convert = [](const AudioChannelLayout& aidl, const ReverseMap& m,
+    auto convert = [](const AudioChannelLayout& aidl, const LayoutReverseMap& m,
             const char* func, const char* type) -> ConversionResult<audio_channel_mask_t> {
         if (auto it = m.find(aidl); it != m.end()) {
             return it->second;
@@ -929,13 +966,13 @@ int legacy2aidl_audio_channel_mask_t_bits_AudioChannelLayout_layout(
 
 ConversionResult<AudioChannelLayout> legacy2aidl_audio_channel_mask_t_AudioChannelLayout(
         audio_channel_mask_t legacy, bool isInput) {
-    using DirectMap = std::map<audio_channel_mask_t, AudioChannelLayout>;
+    using LayoutDirectMap = DirectMap<audio_channel_mask_t, AudioChannelLayout>;
     using Tag = AudioChannelLayout::Tag;
-    static const DirectMap mInAndVoice = make_DirectMap(
+    static const LayoutDirectMap mInAndVoice = make_DirectMap(
             getInAudioChannelPairs(), getVoiceAudioChannelPairs());
-    static const DirectMap mOut = make_DirectMap(getOutAudioChannelPairs());
+    static const LayoutDirectMap mOut = make_DirectMap(getOutAudioChannelPairs());
 
-    auto convert = [](const audio_channel_mask_t legacy, const DirectMap& m,
+    auto convert = [](const audio_channel_mask_t legacy, const LayoutDirectMap& m,
             const char* func, const char* type) -> ConversionResult<AudioChannelLayout> {
         if (auto it = m.find(legacy); it != m.end()) {
             return it->second;
@@ -993,7 +1030,7 @@ ConversionResult<AudioChannelLayout> legacy2aidl_audio_channel_mask_t_AudioChann
 
 ConversionResult<audio_devices_t> aidl2legacy_AudioDeviceDescription_audio_devices_t(
         const AudioDeviceDescription& aidl) {
-    static const std::map<AudioDeviceDescription, audio_devices_t> m =
+    static const ReverseMap<AudioDeviceDescription, audio_devices_t> m =
             make_ReverseMap(getAudioDevicePairs());
     if (auto it = m.find(aidl); it != m.end()) {
         return it->second;
@@ -1005,7 +1042,7 @@ ConversionResult<audio_devices_t> aidl2legacy_AudioDeviceDescription_audio_devic
 
 ConversionResult<AudioDeviceDescription> legacy2aidl_audio_devices_t_AudioDeviceDescription(
         audio_devices_t legacy) {
-    static const std::map<audio_devices_t, AudioDeviceDescription> m =
+    static const DirectMap<audio_devices_t, AudioDeviceDescription> m =
             make_DirectMap(getAudioDevicePairs());
     if (auto it = m.find(legacy); it != m.end()) {
         return it->second;
@@ -1180,7 +1217,7 @@ legacy2aidl_audio_device_AudioDevice(
 
 ConversionResult<audio_format_t> aidl2legacy_AudioFormatDescription_audio_format_t(
         const AudioFormatDescription& aidl) {
-    static const std::map<AudioFormatDescription, audio_format_t> m =
+    static const ReverseMap<AudioFormatDescription, audio_format_t> m =
             make_ReverseMap(getAudioFormatPairs());
     if (auto it = m.find(aidl); it != m.end()) {
         return it->second;
@@ -1192,7 +1229,7 @@ ConversionResult<audio_format_t> aidl2legacy_AudioFormatDescription_audio_format
 
 ConversionResult<AudioFormatDescription> legacy2aidl_audio_format_t_AudioFormatDescription(
         audio_format_t legacy) {
-    static const std::map<audio_format_t, AudioFormatDescription> m =
+    static const DirectMap<audio_format_t, AudioFormatDescription> m =
             make_DirectMap(getAudioFormatPairs());
     if (auto it = m.find(legacy); it != m.end()) {
         return it->second;
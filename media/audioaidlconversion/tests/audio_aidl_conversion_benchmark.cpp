@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/AidlConversionCppNdk.h>
+
+// Measures the lookups of the format, channel mask and device conversions,
+// which are done several times by every track creation and stream opening.
+
+using namespace aidl::android;  // for conversion functions
+using aidl::android::media::audio::common::AudioChannelLayout;
+using aidl::android::media::audio::common::AudioDeviceDescription;
+using aidl::android::media::audio::common::AudioFormatDescription;
+
+namespace {
+
+const std::vector<audio_format_t> kFormats = {
+        AUDIO_FORMAT_PCM_16_BIT, AUDIO_FORMAT_PCM_FLOAT, AUDIO_FORMAT_PCM_24_BIT_PACKED,
+        AUDIO_FORMAT_PCM_32_BIT, AUDIO_FORMAT_AAC_LC, AUDIO_FORMAT_AC3, AUDIO_FORMAT_E_AC3,
+        AUDIO_FORMAT_OPUS,
+};
+
+const std::vector<audio_channel_mask_t> kOutChannelMasks = {
+        AUDIO_CHANNEL_OUT_MONO, AUDIO_CHANNEL_OUT_STEREO, AUDIO_CHANNEL_OUT_5POINT1,
+        AUDIO_CHANNEL_OUT_7POINT1, AUDIO_CHANNEL_OUT_7POINT1POINT4,
+};
+
+const std::vector<audio_devices_t> kDevices = {
+        AUDIO_DEVICE_OUT_SPEAKER, AUDIO_DEVICE_OUT_WIRED_HEADSET,
+        AUDIO_DEVICE_OUT_BLUETOOTH_A2DP, AUDIO_DEVICE_OUT_USB_HEADSET,
+        AUDIO_DEVICE_OUT_BLE_HEADSET, AUDIO_DEVICE_IN_BUILTIN_MIC,
+        AUDIO_DEVICE_IN_BLUETOOTH_SCO_HEADSET, AUDIO_DEVICE_IN_USB_DEVICE,
+};
+
+template <typename T, typename F>
+auto toAidl(const std::vector<T>& legacy, F convert) {
+    std::vector<typename decltype(convert(legacy[0]))::value_type> result;
+    for (const T& value : legacy) result.push_back(convert(value).value());
+    return result;
+}
+
+void BM_FormatToAidl(benchmark::State& state) {
+    for (auto _ : state) {
+        for (audio_format_t format : kFormats) {
+            benchmark::DoNotOptimize(legacy2aidl_audio_format_t_AudioFormatDescription(format));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kFormats.size());
+}
+
+void BM_FormatToLegacy(benchmark::State& state) {
+    const auto aidl = toAidl(kFormats, &legacy2aidl_audio_format_t_AudioFormatDescription);
+    for (auto _ : state) {
+        for (const AudioFormatDescription& format : aidl) {
+            benchmark::DoNotOptimize(aidl2legacy_AudioFormatDescription_audio_format_t(format));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * aidl.size());
+}
+
+void BM_ChannelMaskToAidl(benchmark::State& state) {
+    for (auto _ : state) {
+        for (audio_channel_mask_t mask : kOutChannelMasks) {
+            benchmark::DoNotOptimize(legacy2aidl_audio_channel_mask_t_AudioChannelLayout(
+                    mask, false /*isInput*/));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kOutChannelMasks.size());
+}
+
+void BM_ChannelMaskToLegacy(benchmark::State& state) {
+    std::vector<AudioChannelLayout> aidl;
+    for (audio_channel_mask_t mask : kOutChannelMasks) {
+        aidl.push_back(legacy2aidl_audio_channel_mask_t_AudioChannelLayout(
+                mask, false /*isInput*/).value());
+    }
+    for (auto _ : state) {
+        for (const AudioChannelLayout& layout : aidl) {
+            benchmark::DoNotOptimize(aidl2legacy_AudioChannelLayout_audio_channel_mask_t(
+                    layout, false /*isInput*/));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * aidl.size());
+}
+
+void BM_DeviceToAidl(benchmark::State& state) {
+    for (auto _ : state) {
+        for (audio_devices_t device : kDevices) {
+            benchmark::DoNotOptimize(legacy2aidl_audio_devices_t_AudioDeviceDescription(device));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kDevices.size());
+}
+
+void BM_DeviceToLegacy(benchmark::State& state) {
+    const auto aidl = toAidl(kDevices, &legacy2aidl_audio_devices_t_AudioDeviceDescription);
+    for (auto _ : state) {
+        for (const AudioDeviceDescription& device : aidl) {
+            benchmark::DoNotOptimize(aidl2legacy_AudioDeviceDescription_audio_devices_t(device));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * aidl.size());
+}
+
+}  // namespace
+
+BENCHMARK(BM_FormatToAidl);
+BENCHMARK(BM_FormatToLegacy);
+BENCHMARK(BM_ChannelMaskToAidl);
+BENCHMARK(BM_ChannelMaskToLegacy);
+BENCHMARK(BM_DeviceToAidl);
+BENCHMARK(BM_DeviceToLegacy);
+
+BENCHMARK_MAIN();
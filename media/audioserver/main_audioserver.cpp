@@ -32,6 +32,7 @@
 #include <binder/ProcessState.h>
 #include <binder/IServiceManager.h>
 #include <hidl/HidlTransportSupport.h>
+#include <media/MediaMetricsItem.h>
 #include <mediautils/LimitProcessMemory.h>
 #include <utils/Log.h>
 
@@ -147,6 +148,11 @@ int main(int argc __unused, char **argv)
         }
         android::hardware::configureRpcThreadpool(4, false /*callerWillJoin*/);
 
+        // AudioFlinger and AudioPolicy log several items per stream event,
+        // send them to media.metrics together.
+        constexpr nsecs_t kMediaMetricsBatchDelayNs = 10'000'000;  // 10 ms
+        mediametrics::BaseItem::enableBatching(kMediaMetricsBatchDelayNs);
+
         // Ensure threads for possible callbacks.  Note that get_audio_flinger() does
         // this automatically when called from AudioPolicy, but we do this anyways here.
         ProcessState::self()->startThreadPool();
@@ -26,6 +26,17 @@
 #include <inttypes.h>
 #include <libyuv.h>
 
+// Android requires NEON on ARM and SSE4.2 on x86_64 (SSSE3 on x86), so the SIMD row
+// kernels below are selected at compile time.
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+#endif
+
 #include <C2Config.h>
 #include <C2Debug.h>
 #include <C2PlatformSupport.h>
@@ -46,6 +57,133 @@ namespace android {
 constexpr uint8_t kNeutralUVBitDepth8 = 128;
 constexpr uint16_t kNeutralUVBitDepth10 = 512;
 
+// Shift between 10-bit samples and P010 samples.
+constexpr int kP010Shift = 6;
+
+// Row kernels of the high bit depth conversions below. Each one processes as much of the row
+// as it can with SIMD instructions, and the rest with the reference scalar code.
+
+// dst[x] = src[x] << shift
+static void shiftLeftRow16(uint16_t *dst, const uint16_t *src, size_t count, int shift) {
+    size_t x = 0;
+#if defined(__ARM_NEON)
+    const int16x8_t vShift = vdupq_n_s16(shift);
+    for (; x + 8 <= count; x += 8) {
+        vst1q_u16(dst + x, vshlq_u16(vld1q_u16(src + x), vShift));
+    }
+#elif defined(__SSE2__)
+    const __m128i vShift = _mm_cvtsi32_si128(shift);
+    for (; x + 8 <= count; x += 8) {
+        const __m128i v = _mm_loadu_si128((const __m128i *)(src + x));
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_sll_epi16(v, vShift));
+    }
+#endif
+    for (; x < count; ++x) {
+        dst[x] = src[x] << shift;
+    }
+}
+
+// dst[x] = src[x] >> shift
+static void shiftRightRow16(uint16_t *dst, const uint16_t *src, size_t count, int shift) {
+    size_t x = 0;
+#if defined(__ARM_NEON)
+    const int16x8_t vShift = vdupq_n_s16(-shift);
+    for (; x + 8 <= count; x += 8) {
+        vst1q_u16(dst + x, vshlq_u16(vld1q_u16(src + x), vShift));
+    }
+#elif defined(__SSE2__)
+    const __m128i vShift = _mm_cvtsi32_si128(shift);
+    for (; x + 8 <= count; x += 8) {
+        const __m128i v = _mm_loadu_si128((const __m128i *)(src + x));
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_srl_epi16(v, vShift));
+    }
+#endif
+    for (; x < count; ++x) {
+        dst[x] = src[x] >> shift;
+    }
+}
+
+// dst[x] = (uint8_t)(src[x] >> 2), from 10-bit to 8-bit samples.
+static void narrowRow16To8(uint8_t *dst, const uint16_t *src, size_t count) {
+    size_t x = 0;
+#if defined(__ARM_NEON)
+    for (; x + 8 <= count; x += 8) {
+        vst1_u8(dst + x, vmovn_u16(vshrq_n_u16(vld1q_u16(src + x), 2)));
+    }
+#elif defined(__SSE2__)
+    const __m128i vMask = _mm_set1_epi16(0xFF);
+    for (; x + 16 <= count; x += 16) {
+        const __m128i lo = _mm_loadu_si128((const __m128i *)(src + x));
+        const __m128i hi = _mm_loadu_si128((const __m128i *)(src + x + 8));
+        _mm_storeu_si128((__m128i *)(dst + x),
+                         _mm_packus_epi16(_mm_and_si128(_mm_srli_epi16(lo, 2), vMask),
+                                          _mm_and_si128(_mm_srli_epi16(hi, 2), vMask)));
+    }
+#endif
+    for (; x < count; ++x) {
+        dst[x] = (uint8_t)(src[x] >> 2);
+    }
+}
+
+// dstUV[2 * x] = srcU[x] << shift, dstUV[2 * x + 1] = srcV[x] << shift
+static void interleaveRow16(uint16_t *dstUV, const uint16_t *srcU, const uint16_t *srcV,
+                            size_t count, int shift) {
+    size_t x = 0;
+#if defined(__ARM_NEON)
+    const int16x8_t vShift = vdupq_n_s16(shift);
+    for (; x + 8 <= count; x += 8) {
+        uint16x8x2_t uv;
+        uv.val[0] = vshlq_u16(vld1q_u16(srcU + x), vShift);
+        uv.val[1] = vshlq_u16(vld1q_u16(srcV + x), vShift);
+        vst2q_u16(dstUV + 2 * x, uv);
+    }
+#elif defined(__SSE2__)
+    const __m128i vShift = _mm_cvtsi32_si128(shift);
+    for (; x + 8 <= count; x += 8) {
+        const __m128i u = _mm_sll_epi16(_mm_loadu_si128((const __m128i *)(srcU + x)), vShift);
+        const __m128i v = _mm_sll_epi16(_mm_loadu_si128((const __m128i *)(srcV + x)), vShift);
+        _mm_storeu_si128((__m128i *)(dstUV + 2 * x), _mm_unpacklo_epi16(u, v));
+        _mm_storeu_si128((__m128i *)(dstUV + 2 * x + 8), _mm_unpackhi_epi16(u, v));
+    }
+#endif
+    for (; x < count; ++x) {
+        dstUV[2 * x] = srcU[x] << shift;
+        dstUV[2 * x + 1] = srcV[x] << shift;
+    }
+}
+
+// dstU[x] = srcUV[2 * x] >> shift, dstV[x] = srcUV[2 * x + 1] >> shift, shift > 0
+static void deinterleaveRow16(uint16_t *dstU, uint16_t *dstV, const uint16_t *srcUV,
+                              size_t count, int shift) {
+    size_t x = 0;
+#if defined(__ARM_NEON)
+    const int16x8_t vShift = vdupq_n_s16(-shift);
+    for (; x + 8 <= count; x += 8) {
+        const uint16x8x2_t uv = vld2q_u16(srcUV + 2 * x);
+        vst1q_u16(dstU + x, vshlq_u16(uv.val[0], vShift));
+        vst1q_u16(dstV + x, vshlq_u16(uv.val[1], vShift));
+    }
+#elif defined(__SSE2__)
+    // The shifted samples fit in 15 bits, so the signed pack does not saturate.
+    const __m128i vShift = _mm_cvtsi32_si128(shift);
+    for (; x + 8 <= count; x += 8) {
+        const __m128i lo =
+                _mm_srl_epi16(_mm_loadu_si128((const __m128i *)(srcUV + 2 * x)), vShift);
+        const __m128i hi =
+                _mm_srl_epi16(_mm_loadu_si128((const __m128i *)(srcUV + 2 * x + 8)), vShift);
+        _mm_storeu_si128((__m128i *)(dstU + x),
+                         _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(lo, 16), 16),
+                                         _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16)));
+        _mm_storeu_si128((__m128i *)(dstV + x),
+                         _mm_packs_epi32(_mm_srai_epi32(lo, 16), _mm_srai_epi32(hi, 16)));
+    }
+#endif
+    for (; x < count; ++x) {
+        dstU[x] = srcUV[2 * x] >> shift;
+        dstV[x] = srcUV[2 * x + 1] >> shift;
+    }
+}
+
 void convertYUV420Planar8ToYV12(uint8_t *dstY, uint8_t *dstU, uint8_t *dstV, const uint8_t *srcY,
                                 const uint8_t *srcU, const uint8_t *srcV, size_t srcYStride,
                                 size_t srcUStride, size_t srcVStride, size_t dstYStride,
@@ -246,6 +384,116 @@ static const struct Coeffs GetCoeffsForAspects(const C2ColorAspectsStruct &aspec
 }
 
 #define CLIP3(min, v, max) (((v) < (min)) ? (min) : (((max) > (v)) ? (v) : (max)))
+
+// Converts the first pixels of two rows sharing a chroma row, 8 pixels at a time, as the scalar
+// loop of convertYUV420Planar16ToRGBA1010102() does. Returns the number of pixels converted.
+// Note that an arithmetic shift by 10 matches the division by 1024 once clipped to [0, 1023].
+static size_t convertRowsToRGBA1010102Simd(
+        uint32_t *dstTop, uint32_t *dstBot, const uint16_t *ySrcTop, const uint16_t *ySrcBot,
+        const uint16_t *uSrc, const uint16_t *vSrc, size_t width, const Coeffs &coeffs) {
+    size_t x = 0;
+#if defined(__ARM_NEON)
+    const int32x4_t vY = vdupq_n_s32(coeffs._y);
+    const int32x4_t vBU = vdupq_n_s32(coeffs._b_u);
+    const int32x4_t vNegGU = vdupq_n_s32(-coeffs._g_u);
+    const int32x4_t vNegGV = vdupq_n_s32(-coeffs._g_v);
+    const int32x4_t vRV = vdupq_n_s32(coeffs._r_v);
+    const int32x4_t vC16 = vdupq_n_s32(coeffs._c16);
+    const int32x4_t v512 = vdupq_n_s32(512);
+    const int32x4_t vZero = vdupq_n_s32(0);
+    const int32x4_t vMax = vdupq_n_s32(1023);
+    const uint32x4_t vAlpha = vdupq_n_u32(3u << 30);
+
+    auto clip = [&](int32x4_t v) {
+        return vreinterpretq_u32_s32(vminq_s32(vmaxq_s32(vshrq_n_s32(v, 10), vZero), vMax));
+    };
+    auto pack = [&](int32x4_t yMult, int32x4_t uB, int32x4_t uvG, int32x4_t vR) {
+        const uint32x4_t b = clip(vaddq_s32(yMult, uB));
+        const uint32x4_t g = clip(vaddq_s32(yMult, uvG));
+        const uint32x4_t r = clip(vaddq_s32(yMult, vR));
+        return vorrq_u32(vorrq_u32(vAlpha, vshlq_n_u32(b, 20)),
+                         vorrq_u32(vshlq_n_u32(g, 10), r));
+    };
+    auto yMult = [&](uint16x4_t y) {
+        return vmlaq_s32(v512, vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(y)), vC16), vY);
+    };
+
+    for (; x + 8 <= width; x += 8) {
+        const int32x4_t u = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(vld1_u16(uSrc + x / 2))),
+                                      v512);
+        const int32x4_t v = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(vld1_u16(vSrc + x / 2))),
+                                      v512);
+        // Each chroma sample is used by two horizontally adjacent pixels.
+        const int32x4x2_t uB = vzipq_s32(vmulq_s32(u, vBU), vmulq_s32(u, vBU));
+        const int32x4_t uvGHalf = vmlaq_s32(vmulq_s32(u, vNegGU), v, vNegGV);
+        const int32x4x2_t uvG = vzipq_s32(uvGHalf, uvGHalf);
+        const int32x4x2_t vR = vzipq_s32(vmulq_s32(v, vRV), vmulq_s32(v, vRV));
+
+        const uint16x8_t yTop = vld1q_u16(ySrcTop + x);
+        const uint16x8_t yBot = vld1q_u16(ySrcBot + x);
+        vst1q_u32(dstTop + x, pack(yMult(vget_low_u16(yTop)), uB.val[0], uvG.val[0], vR.val[0]));
+        vst1q_u32(dstTop + x + 4,
+                  pack(yMult(vget_high_u16(yTop)), uB.val[1], uvG.val[1], vR.val[1]));
+        vst1q_u32(dstBot + x, pack(yMult(vget_low_u16(yBot)), uB.val[0], uvG.val[0], vR.val[0]));
+        vst1q_u32(dstBot + x + 4,
+                  pack(yMult(vget_high_u16(yBot)), uB.val[1], uvG.val[1], vR.val[1]));
+    }
+#elif defined(__SSE4_1__)
+    const __m128i vY = _mm_set1_epi32(coeffs._y);
+    const __m128i vBU = _mm_set1_epi32(coeffs._b_u);
+    const __m128i vNegGU = _mm_set1_epi32(-coeffs._g_u);
+    const __m128i vNegGV = _mm_set1_epi32(-coeffs._g_v);
+    const __m128i vRV = _mm_set1_epi32(coeffs._r_v);
+    const __m128i vC16 = _mm_set1_epi32(coeffs._c16);
+    const __m128i v512 = _mm_set1_epi32(512);
+    const __m128i vZero = _mm_setzero_si128();
+    const __m128i vMax = _mm_set1_epi32(1023);
+    const __m128i vAlpha = _mm_set1_epi32((int32_t)(3u << 30));
+
+    auto clip = [&](__m128i v) {
+        return _mm_min_epi32(_mm_max_epi32(_mm_srai_epi32(v, 10), vZero), vMax);
+    };
+    auto pack = [&](__m128i yMult, __m128i uB, __m128i uvG, __m128i vR) {
+        const __m128i b = clip(_mm_add_epi32(yMult, uB));
+        const __m128i g = clip(_mm_add_epi32(yMult, uvG));
+        const __m128i r = clip(_mm_add_epi32(yMult, vR));
+        return _mm_or_si128(_mm_or_si128(vAlpha, _mm_slli_epi32(b, 20)),
+                            _mm_or_si128(_mm_slli_epi32(g, 10), r));
+    };
+    auto yMult = [&](__m128i y) {
+        return _mm_add_epi32(_mm_mullo_epi32(_mm_sub_epi32(_mm_cvtepu16_epi32(y), vC16), vY),
+                             v512);
+    };
+
+    for (; x + 8 <= width; x += 8) {
+        const __m128i u = _mm_sub_epi32(
+                _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(uSrc + x / 2))), v512);
+        const __m128i v = _mm_sub_epi32(
+                _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(vSrc + x / 2))), v512);
+        // Each chroma sample is used by two horizontally adjacent pixels.
+        const __m128i uB = _mm_mullo_epi32(u, vBU);
+        const __m128i uvG = _mm_add_epi32(_mm_mullo_epi32(u, vNegGU), _mm_mullo_epi32(v, vNegGV));
+        const __m128i vR = _mm_mullo_epi32(v, vRV);
+        const __m128i uBLo = _mm_unpacklo_epi32(uB, uB), uBHi = _mm_unpackhi_epi32(uB, uB);
+        const __m128i uvGLo = _mm_unpacklo_epi32(uvG, uvG), uvGHi = _mm_unpackhi_epi32(uvG, uvG);
+        const __m128i vRLo = _mm_unpacklo_epi32(vR, vR), vRHi = _mm_unpackhi_epi32(vR, vR);
+
+        const __m128i yTop = _mm_loadu_si128((const __m128i *)(ySrcTop + x));
+        const __m128i yBot = _mm_loadu_si128((const __m128i *)(ySrcBot + x));
+        _mm_storeu_si128((__m128i *)(dstTop + x), pack(yMult(yTop), uBLo, uvGLo, vRLo));
+        _mm_storeu_si128((__m128i *)(dstTop + x + 4),
+                         pack(yMult(_mm_srli_si128(yTop, 8)), uBHi, uvGHi, vRHi));
+        _mm_storeu_si128((__m128i *)(dstBot + x), pack(yMult(yBot), uBLo, uvGLo, vRLo));
+        _mm_storeu_si128((__m128i *)(dstBot + x + 4),
+                         pack(yMult(_mm_srli_si128(yBot, 8)), uBHi, uvGHi, vRHi));
+    }
+#else
+    (void)dstTop, (void)dstBot, (void)ySrcTop, (void)ySrcBot, (void)uSrc, (void)vSrc;
+    (void)width, (void)coeffs;
+#endif
+    return x;
+}
+
 void convertYUV420Planar16ToRGBA1010102(
         uint32_t *dst, const uint16_t *srcY, const uint16_t *srcU,
         const uint16_t *srcV, size_t srcYStride, size_t srcUStride,
@@ -273,7 +521,16 @@ void convertYUV420Planar16ToRGBA1010102(
         uint16_t *uSrc = (uint16_t *)srcU;
         uint16_t *vSrc = (uint16_t *)srcV;
 
-        for (size_t x = 0; x < width; x += 2) {
+        size_t x = convertRowsToRGBA1010102Simd(dstTop, dstBot, ySrcTop, ySrcBot, uSrc, vSrc,
+                                                width, coeffs);
+        dstTop += x;
+        dstBot += x;
+        ySrcTop += x;
+        ySrcBot += x;
+        uSrc += x / 2;
+        vSrc += x / 2;
+
+        for (; x < width; x += 2) {
             int32_t u, v, y00, y01, y10, y11;
             u = *uSrc - 512;
             uSrc += 1;
@@ -360,9 +617,7 @@ void convertYUV420Planar16ToYV12(uint8_t *dstY, uint8_t *dstU, uint8_t *dstV, co
                                  size_t dstUVStride, size_t width, size_t height,
                                  bool isMonochrome) {
     for (size_t y = 0; y < height; ++y) {
-        for (size_t x = 0; x < width; ++x) {
-            dstY[x] = (uint8_t)(srcY[x] >> 2);
-        }
+        narrowRow16To8(dstY, srcY, width);
         srcY += srcYStride;
         dstY += dstYStride;
     }
@@ -379,10 +634,8 @@ void convertYUV420Planar16ToYV12(uint8_t *dstY, uint8_t *dstU, uint8_t *dstV, co
     }
 
     for (size_t y = 0; y < (height + 1) / 2; ++y) {
-        for (size_t x = 0; x < (width + 1) / 2; ++x) {
-            dstU[x] = (uint8_t)(srcU[x] >> 2);
-            dstV[x] = (uint8_t)(srcV[x] >> 2);
-        }
+        narrowRow16To8(dstU, srcU, (width + 1) / 2);
+        narrowRow16To8(dstV, srcV, (width + 1) / 2);
         srcU += srcUStride;
         srcV += srcVStride;
         dstU += dstUVStride;
@@ -396,9 +649,7 @@ void convertYUV420Planar16ToP010(uint16_t *dstY, uint16_t *dstUV, const uint16_t
                                  size_t dstUVStride, size_t width, size_t height,
                                  bool isMonochrome) {
     for (size_t y = 0; y < height; ++y) {
-        for (size_t x = 0; x < width; ++x) {
-            dstY[x] = srcY[x] << 6;
-        }
+        shiftLeftRow16(dstY, srcY, width, kP010Shift);
         srcY += srcYStride;
         dstY += dstYStride;
     }
@@ -416,10 +667,7 @@ void convertYUV420Planar16ToP010(uint16_t *dstY, uint16_t *dstUV, const uint16_t
     }
 
     for (size_t y = 0; y < (height + 1) / 2; ++y) {
-        for (size_t x = 0; x < (width + 1) / 2; ++x) {
-            dstUV[2 * x] = srcU[x] << 6;
-            dstUV[2 * x + 1] = srcV[x] << 6;
-        }
+        interleaveRow16(dstUV, srcU, srcV, (width + 1) / 2, kP010Shift);
         srcU += srcUStride;
         srcV += srcVStride;
         dstUV += dstUVStride;
@@ -432,9 +680,7 @@ void convertP010ToYUV420Planar16(uint16_t *dstY, uint16_t *dstU, uint16_t *dstV,
                                  size_t dstUStride, size_t dstVStride, size_t width,
                                  size_t height, bool isMonochrome) {
     for (size_t y = 0; y < height; ++y) {
-        for (size_t x = 0; x < width; ++x) {
-            dstY[x] = srcY[x] >> 6;
-        }
+        shiftRightRow16(dstY, srcY, width, kP010Shift);
         srcY += srcYStride;
         dstY += dstYStride;
     }
@@ -453,10 +699,7 @@ void convertP010ToYUV420Planar16(uint16_t *dstY, uint16_t *dstU, uint16_t *dstV,
     }
 
     for (size_t y = 0; y < (height + 1) / 2; ++y) {
-        for (size_t x = 0; x < (width + 1) / 2; ++x) {
-            dstU[x] = srcUV[2 * x] >> 6;
-            dstV[x] = srcUV[2 * x + 1] >> 6;
-        }
+        deinterleaveRow16(dstU, dstV, srcUV, (width + 1) / 2, kP010Shift);
         dstU += dstUStride;
         dstV += dstVStride;
         srcUV += srcUVStride;
@@ -692,7 +935,7 @@ void SimpleC2Component::WorkHandler::onMessageReceived(const sp<AMessage> &msg)
     switch (msg->what()) {
         case kWhatProcess: {
             if (mRunning) {
-                if (thiz->processQueue()) {
+                if (thiz->processQueueBatch()) {
                     (new AMessage(kWhatProcess, this))->post();
                 }
             } else {
@@ -710,6 +953,7 @@ void SimpleC2Component::WorkHandler::onMessageReceived(const sp<AMessage> &msg)
             break;
         }
         case kWhatStop: {
+            thiz->waitForOutput();
             int32_t err = thiz->onStop();
             thiz->mOutputBlockPool.reset();
             mRunning = false;
@@ -717,6 +961,7 @@ void SimpleC2Component::WorkHandler::onMessageReceived(const sp<AMessage> &msg)
             break;
         }
         case kWhatReset: {
+            thiz->waitForOutput();
             thiz->onReset();
             thiz->mOutputBlockPool.reset();
             mRunning = false;
@@ -724,6 +969,7 @@ void SimpleC2Component::WorkHandler::onMessageReceived(const sp<AMessage> &msg)
             break;
         }
         case kWhatRelease: {
+            thiz->waitForOutput();
             thiz->onRelease();
             thiz->mOutputBlockPool.reset();
             mRunning = false;
@@ -797,12 +1043,40 @@ struct DummyReadView : public C2ReadView {
 
 }  // namespace
 
+SimpleC2Component::OutputThread::OutputThread(
+        const std::shared_ptr<Mutexed<OutputQueue>> &queue)
+    : Thread(false), mQueue(queue) {}
+
+bool SimpleC2Component::OutputThread::threadLoop() {
+    Mutexed<OutputQueue>::Locked queue(*mQueue);
+    if (queue->entries.empty()) {
+        queue.waitForCondition(queue->cond);
+        if (queue->entries.empty()) {
+            return true;
+        }
+    }
+    std::function<void()> output = std::move(queue->entries.front());
+    queue->entries.pop_front();
+    queue.unlock();
+
+    output();
+
+    queue.lock();
+    --queue->numPending;
+    queue->cond.broadcast();
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 SimpleC2Component::SimpleC2Component(
         const std::shared_ptr<C2ComponentInterface> &intf)
     : mDummyReadView(DummyReadView()),
       mIntf(intf),
       mLooper(new ALooper),
-      mHandler(new WorkHandler) {
+      mHandler(new WorkHandler),
+      mOutputQueue(new Mutexed<OutputQueue>),
+      mBatchDoneWork(property_get_bool("debug.stagefright.c2-batch-done-work", false)) {
     mLooper->setName(intf->getName().c_str());
     (void)mLooper->registerHandler(mHandler);
     mLooper->start(false, false, ANDROID_PRIORITY_VIDEO);
@@ -811,6 +1085,7 @@ SimpleC2Component::SimpleC2Component(
 SimpleC2Component::~SimpleC2Component() {
     mLooper->unregisterHandler(mHandler->id());
     (void)mLooper->stop();
+    stopOutputStage();
 }
 
 c2_status_t SimpleC2Component::setListener_vb(
@@ -1007,8 +1282,7 @@ void SimpleC2Component::finish(
     }
     if (work) {
         fillWork(work);
-        std::shared_ptr<C2Component::Listener> listener = mExecState.lock()->mListener;
-        listener->onWorkDone_nb(shared_from_this(), vec(work));
+        sendDoneWork(std::move(work));
         ALOGV("returning pending work");
     }
 }
@@ -1033,12 +1307,134 @@ void SimpleC2Component::cloneAndSend(
     work->worklets.emplace_back(new C2Worklet);
     if (work) {
         fillWork(work);
-        std::shared_ptr<C2Component::Listener> listener = mExecState.lock()->mListener;
-        listener->onWorkDone_nb(shared_from_this(), vec(work));
+        sendDoneWork(std::move(work));
         ALOGV("cloned and sending work");
     }
 }
 
+c2_status_t SimpleC2Component::enableOutputStage() {
+    if (mOutputThread) {
+        return C2_OK;
+    }
+    sp<OutputThread> thread(new OutputThread(mOutputQueue));
+    if (thread->run((mIntf->getName() + " output").c_str(), ANDROID_PRIORITY_VIDEO) != OK) {
+        ALOGE("failed to start the output stage");
+        return C2_CORRUPTED;
+    }
+    mOutputThread = thread;
+    return C2_OK;
+}
+
+void SimpleC2Component::queueOutput(std::function<void()> output) {
+    mDeferredOutput.push_back(std::move(output));
+}
+
+void SimpleC2Component::submitDeferredOutput() {
+    while (!mDeferredOutput.empty()) {
+        std::function<void()> output = std::move(mDeferredOutput.front());
+        mDeferredOutput.pop_front();
+        if (!mOutputThread) {
+            output();
+            continue;
+        }
+        Mutexed<OutputQueue>::Locked queue(*mOutputQueue);
+        while (queue->numPending >= kMaxPendingOutput) {
+            queue.waitForCondition(queue->cond);
+        }
+        queue->entries.push_back(std::move(output));
+        ++queue->numPending;
+        queue->cond.broadcast();
+    }
+}
+
+void SimpleC2Component::waitForOutput() {
+    if (!mOutputThread) {
+        return;
+    }
+    Mutexed<OutputQueue>::Locked queue(*mOutputQueue);
+    while (queue->numPending != 0u) {
+        queue.waitForCondition(queue->cond);
+    }
+}
+
+void SimpleC2Component::stopOutputStage() {
+    if (!mOutputThread) {
+        return;
+    }
+    {
+        Mutexed<OutputQueue>::Locked queue(*mOutputQueue);
+        queue->numPending -= queue->entries.size();
+        queue->entries.clear();
+    }
+    mOutputThread->requestExit();
+    while (mOutputThread->isRunning()) {
+        mOutputQueue->lock()->cond.broadcast();
+    }
+    mOutputThread.clear();
+}
+
+void SimpleC2Component::returnWork(std::unique_ptr<C2Work> work) {
+    sendDoneWork(std::move(work));
+}
+
+namespace {
+
+// component whose work is being processed in a batch on this thread
+thread_local const SimpleC2Component *tBatchingComponent = nullptr;
+
+}  // namespace
+
+void SimpleC2Component::sendDoneWork(std::unique_ptr<C2Work> work) {
+    if (tBatchingComponent == this) {
+        uint64_t generation = mWorkQueue.lock()->generation();
+        mDoneWork.push_back({ generation, std::move(work) });
+        return;
+    }
+    Mutexed<ExecState>::Locked state(mExecState);
+    std::shared_ptr<C2Component::Listener> listener = state->mListener;
+    state.unlock();
+    listener->onWorkDone_nb(shared_from_this(), vec(work));
+}
+
+void SimpleC2Component::flushDoneWork() {
+    if (mDoneWork.empty()) {
+        return;
+    }
+    uint64_t generation = mWorkQueue.lock()->generation();
+    std::list<std::unique_ptr<C2Work>> works;
+    for (DoneWork &done : mDoneWork) {
+        if (done.generation != generation) {
+            // the component was flushed after this work was done; return it as processQueue()
+            // would have if the flush had happened first
+            done.work->result = C2_NOT_FOUND;
+        }
+        works.push_back(std::move(done.work));
+    }
+    mDoneWork.clear();
+    Mutexed<ExecState>::Locked state(mExecState);
+    std::shared_ptr<C2Component::Listener> listener = state->mListener;
+    state.unlock();
+    listener->onWorkDone_nb(shared_from_this(), std::move(works));
+}
+
+bool SimpleC2Component::processQueueBatch() {
+    if (!mBatchDoneWork || mOutputThread) {
+        return processQueue();
+    }
+    tBatchingComponent = this;
+    bool hasQueuedWork = false;
+    for (size_t i = 0; i < kMaxBatchedWork; ++i) {
+        hasQueuedWork = processQueue();
+        // process() may have enabled the output stage, which orders the output on its own
+        if (!hasQueuedWork || mOutputThread) {
+            break;
+        }
+    }
+    tBatchingComponent = nullptr;
+    flushDoneWork();
+    return hasQueuedWork;
+}
+
 bool SimpleC2Component::processQueue() {
     std::unique_ptr<C2Work> work;
     uint64_t generation;
@@ -1059,6 +1455,7 @@ bool SimpleC2Component::processQueue() {
     }
     if (isFlushPending) {
         ALOGV("processing pending flush");
+        waitForOutput();
         c2_status_t err = onFlush_sm();
         if (err != C2_OK) {
             ALOGD("flush err: %d", err);
@@ -1114,7 +1511,9 @@ bool SimpleC2Component::processQueue() {
     }
 
     if (!work) {
+        waitForOutput();
         c2_status_t err = drain(drainMode, mOutputBlockPool);
+        submitDeferredOutput();
         if (err != C2_OK) {
             Mutexed<ExecState>::Locked state(mExecState);
             std::shared_ptr<C2Component::Listener> listener = state->mListener;
@@ -1155,19 +1554,21 @@ bool SimpleC2Component::processQueue() {
         work->result = C2_NOT_FOUND;
         queue.unlock();
 
-        Mutexed<ExecState>::Locked state(mExecState);
-        std::shared_ptr<C2Component::Listener> listener = state->mListener;
-        state.unlock();
-        listener->onWorkDone_nb(shared_from_this(), vec(work));
+        sendDoneWork(std::move(work));
+        submitDeferredOutput();
         return hasQueuedWork;
     }
     if (work->workletsProcessed != 0u) {
         queue.unlock();
-        Mutexed<ExecState>::Locked state(mExecState);
-        ALOGV("returning this work");
-        std::shared_ptr<C2Component::Listener> listener = state->mListener;
-        state.unlock();
-        listener->onWorkDone_nb(shared_from_this(), vec(work));
+        if (mOutputThread) {
+            // return the work after the output queued before it, e.g. for earlier frames
+            ALOGV("returning this work from the output stage");
+            auto done = std::make_shared<std::unique_ptr<C2Work>>(std::move(work));
+            mDeferredOutput.push_back([this, done] { returnWork(std::move(*done)); });
+        } else {
+            ALOGV("returning this work");
+            returnWork(std::move(work));
+        }
     } else {
         ALOGV("queue pending work");
         work->input.buffers.clear();
@@ -1184,12 +1585,10 @@ bool SimpleC2Component::processQueue() {
         if (unexpected) {
             ALOGD("unexpected pending work");
             unexpected->result = C2_CORRUPTED;
-            Mutexed<ExecState>::Locked state(mExecState);
-            std::shared_ptr<C2Component::Listener> listener = state->mListener;
-            state.unlock();
-            listener->onWorkDone_nb(shared_from_this(), vec(unexpected));
+            sendDoneWork(std::move(unexpected));
         }
     }
+    submitDeferredOutput();
     return hasQueuedWork;
 }
 
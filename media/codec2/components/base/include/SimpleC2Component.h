@@ -17,6 +17,7 @@
 #ifndef SIMPLE_C2_COMPONENT_H_
 #define SIMPLE_C2_COMPONENT_H_
 
+#include <functional>
 #include <list>
 #include <unordered_map>
 
@@ -26,6 +27,7 @@
 #include <media/stagefright/foundation/AHandler.h>
 #include <media/stagefright/foundation/ALooper.h>
 #include <media/stagefright/foundation/Mutexed.h>
+#include <utils/Thread.h>
 
 struct C2ColorAspectsStruct;
 
@@ -121,6 +123,8 @@ public:
 
     // for handler
     bool processQueue();
+    // processQueue() for a batch of queued work, see mBatchDoneWork
+    bool processQueueBatch();
 
 protected:
     /**
@@ -208,6 +212,47 @@ protected:
             std::function<void(const std::unique_ptr<C2Work> &)> fillWork);
 
 
+    /**
+     * Enable the output stage, on which output work queued with queueOutput() then runs
+     * on a separate thread. This lets the copy or color conversion of a decoded frame run
+     * in parallel with process() for the following works.
+     *
+     * This method should be called from onInit().
+     */
+    c2_status_t enableOutputStage();
+
+    bool isOutputStageEnabled() const { return mOutputThread != nullptr; }
+
+    /**
+     * Queue output work, e.g. copying a decoded frame and calling finish() for its work.
+     *
+     * Output work runs in the order it was queued, after the process() or drain() call
+     * that queued it has returned, so it must only finish works that are pending. It runs
+     * on the output stage thread if enabled, and on the work thread otherwise. At most
+     * kMaxPendingOutput output works are pending on the output stage; process() then waits
+     * for the oldest to complete.
+     *
+     * While the output stage is enabled, the works completed by process() are also returned
+     * from the output stage, after the output work queued before them.
+     *
+     * \param[in]   output      the output work.
+     */
+    void queueOutput(std::function<void()> output);
+
+    /**
+     * Wait until all output work queued on the output stage has run.
+     *
+     * This is done before onFlush_sm(), drain(), onStop(), onReset() and onRelease().
+     */
+    void waitForOutput();
+
+    /**
+     * Discard the output work that has not started and stop the output stage.
+     *
+     * Components that enable the output stage must call this from their destructor.
+     */
+    void stopOutputStage();
+
     std::shared_ptr<C2Buffer> createLinearBuffer(
             const std::shared_ptr<C2LinearBlock> &block, size_t offset, size_t size);
 
@@ -302,6 +347,50 @@ private:
     class BlockingBlockPool;
     std::shared_ptr<BlockingBlockPool> mOutputBlockPool;
 
+    static constexpr size_t kMaxPendingOutput = 2;
+
+    struct OutputQueue {
+        std::list<std::function<void()>> entries;
+        Condition cond;
+        size_t numPending{0u};  // queued and running entries
+    };
+
+    class OutputThread : public Thread {
+    public:
+        explicit OutputThread(const std::shared_ptr<Mutexed<OutputQueue>> &queue);
+        ~OutputThread() override = default;
+        bool threadLoop() override;
+
+    private:
+        std::shared_ptr<Mutexed<OutputQueue>> mQueue;
+    };
+
+    std::shared_ptr<Mutexed<OutputQueue>> mOutputQueue;
+    sp<OutputThread> mOutputThread;
+    // output work queued by process() or drain(), only accessed by the work thread
+    std::list<std::function<void()>> mDeferredOutput;
+
+    void submitDeferredOutput();
+    void returnWork(std::unique_ptr<C2Work> work);
+
+    // Whether the work thread processes up to kMaxBatchedWork queued work items per message and
+    // returns the work done by them with a single onWorkDone_nb() call. This saves a callback
+    // (and an IPC for remote components) per access unit when a large audio frame is split into
+    // many small works.
+    const bool mBatchDoneWork;
+    static constexpr size_t kMaxBatchedWork = 16;
+    struct DoneWork {
+        uint64_t generation;
+        std::unique_ptr<C2Work> work;
+    };
+    // only accessed by the work thread
+    std::list<DoneWork> mDoneWork;
+
+    // Returns |work| to the listener, or adds it to mDoneWork while the calling thread is
+    // processing a batch.
+    void sendDoneWork(std::unique_ptr<C2Work> work);
+    void flushDoneWork();
+
     std::vector<int> mBitDepth10HalPixelFormats;
     SimpleC2Component() = delete;
 };
@@ -37,6 +37,10 @@ namespace android {
 static const int NUM_THREADS_DAV1D_DEFAULT = 0;
 static const char NUM_THREADS_DAV1D_PROPERTY[] = "debug.dav1d.numthreads";
 
+// Whether pictures are converted on the output stage, in parallel with decoding.
+static const bool PIPELINED_OUTPUT_DAV1D_DEFAULT = false;
+static const char PIPELINED_OUTPUT_DAV1D_PROPERTY[] = "debug.dav1d.pipelined_output";
+
 // codecname set and passed in as a compile flag from Android.bp
 constexpr char COMPONENT_NAME[] = CODECNAME;
 
@@ -448,11 +452,19 @@ C2SoftDav1dDec::C2SoftDav1dDec(const char* name, c2_node_id_t id,
 }
 
 C2SoftDav1dDec::~C2SoftDav1dDec() {
+    stopOutputStage();
     onRelease();
 }
 
 c2_status_t C2SoftDav1dDec::onInit() {
-    return initDecoder() ? C2_OK : C2_CORRUPTED;
+    if (!initDecoder()) {
+        return C2_CORRUPTED;
+    }
+    if (android::base::GetBoolProperty(PIPELINED_OUTPUT_DAV1D_PROPERTY,
+                                       PIPELINED_OUTPUT_DAV1D_DEFAULT)) {
+        return enableOutputStage();
+    }
+    return C2_OK;
 }
 
 c2_status_t C2SoftDav1dDec::onStop() {
@@ -588,8 +600,8 @@ void fillEmptyWork(const std::unique_ptr<C2Work>& work) {
 
 void C2SoftDav1dDec::finishWork(uint64_t index, const std::unique_ptr<C2Work>& work,
                                 const std::shared_ptr<C2GraphicBlock>& block,
-                                const Dav1dPicture &img) {
-    std::shared_ptr<C2Buffer> buffer = createGraphicBuffer(block, C2Rect(mWidth, mHeight));
+                                const Dav1dPicture &img, const C2Rect& crop) {
+    std::shared_ptr<C2Buffer> buffer = createGraphicBuffer(block, crop);
     {
         IntfImpl::Lock lock = mIntf->lock();
         buffer->setInfo(mIntf->getColorAspects_l());
@@ -964,8 +976,6 @@ bool C2SoftDav1dDec::outputBuffer(const std::shared_ptr<C2BlockPool>& pool,
     // out_frameIndex that the decoded picture returns from dav1d.
     int64_t out_frameIndex = img.m.timestamp;
 
-    const bool isMonochrome = img.p.layout == DAV1D_PIXEL_LAYOUT_I400;
-
     int bitdepth = img.p.bpc;
 
     std::shared_ptr<C2GraphicBlock> block;
@@ -1025,6 +1035,50 @@ bool C2SoftDav1dDec::outputBuffer(const std::shared_ptr<C2BlockPool>& pool,
     //       block->height(), mWidth, mHeight, (int)out_frameIndex);
 
     mOutputBufferIndex = out_frameIndex;
+    const C2Rect crop(mWidth, mHeight);
+
+    if (c2_cntr64_t(out_frameIndex) == work->input.ordinal.frameIndex || !isOutputStageEnabled()) {
+        // The conversion buffers are shared with the output stage.
+        waitForOutput();
+        c2_status_t err = convertPicture(img, wView, format, codedColorAspects, crop);
+        if (err != C2_OK) {
+            setError(work, err);
+            dav1d_picture_unref(&img);
+            return false;
+        }
+        finishWork(out_frameIndex, work, std::move(block), img, crop);
+        dav1d_picture_unref(&img);
+        return true;
+    }
+
+    // The picture is for an earlier work: convert it on the output stage while the next
+    // pictures are decoded. The output work owns the reference to img.
+    queueOutput([this, img, block, wView, format, codedColorAspects, crop,
+                 out_frameIndex]() mutable {
+        c2_status_t err = convertPicture(img, wView, format, codedColorAspects, crop);
+        if (err == C2_OK) {
+            finishWork(out_frameIndex, nullptr, block, img, crop);
+        } else {
+            mSignalledError = true;
+            finish(out_frameIndex, [err](const std::unique_ptr<C2Work>& work) {
+                work->result = err;
+                work->workletsProcessed = 1u;
+            });
+        }
+        dav1d_picture_unref(&img);
+    });
+    return true;
+}
+
+c2_status_t C2SoftDav1dDec::convertPicture(const Dav1dPicture& img, C2GraphicView& wView,
+                                           uint32_t format,
+                                           const std::shared_ptr<C2StreamColorAspectsInfo::output>&
+                                                   codedColorAspects,
+                                           const C2Rect& crop) {
+    const bool isMonochrome = img.p.layout == DAV1D_PIXEL_LAYOUT_I400;
+    const int bitdepth = img.p.bpc;
+    const uint32_t width = crop.width;
+    const uint32_t height = crop.height;
 
     uint8_t* dstY = const_cast<uint8_t*>(wView.data()[C2PlanarLayout::PLANE_Y]);
     uint8_t* dstU = const_cast<uint8_t*>(wView.data()[C2PlanarLayout::PLANE_U]);
@@ -1060,12 +1114,11 @@ bool C2SoftDav1dDec::outputBuffer(const std::shared_ptr<C2BlockPool>& pool,
 
         if (format == HAL_PIXEL_FORMAT_RGBA_1010102) {
             if (isMonochrome) {
-                const size_t tmpSize = mWidth;
+                const size_t tmpSize = width;
                 const bool needFill = tmpSize > mTmpFrameBufferSize;
                 if (!allocTmpFrameBuffer(tmpSize)) {
                     ALOGE("Error allocating temp conversion buffer (%zu bytes)", tmpSize);
-                    setError(work, C2_NO_MEMORY);
-                    return false;
+                    return C2_NO_MEMORY;
                 }
                 srcU = srcV = mTmpFrameBuffer.get();
                 srcUStride = srcVStride = 0;
@@ -1075,7 +1128,7 @@ bool C2SoftDav1dDec::outputBuffer(const std::shared_ptr<C2BlockPool>& pool,
             }
             convertPlanar16ToY410OrRGBA1010102(
                     dstY, srcY, srcU, srcV, srcYStride, srcUStride, srcVStride,
-                    dstYStride, mWidth, mHeight,
+                    dstYStride, width, height,
                     std::static_pointer_cast<const C2ColorAspectsStruct>(codedColorAspects),
                     convFormat);
         } else if (format == HAL_PIXEL_FORMAT_YCBCR_P010) {
@@ -1085,41 +1138,39 @@ bool C2SoftDav1dDec::outputBuffer(const std::shared_ptr<C2BlockPool>& pool,
             size_t tmpSize = 0;
             if ((img.p.layout == DAV1D_PIXEL_LAYOUT_I444) ||
                 (img.p.layout == DAV1D_PIXEL_LAYOUT_I422)) {
-                tmpSize = dstYStride * mHeight + dstUStride * align(mHeight, 2);
+                tmpSize = dstYStride * height + dstUStride * align(height, 2);
                 if (!allocTmpFrameBuffer(tmpSize)) {
                     ALOGE("Error allocating temp conversion buffer (%zu bytes)", tmpSize);
-                    setError(work, C2_NO_MEMORY);
-                    return false;
+                    return C2_NO_MEMORY;
                 }
             }
             convertPlanar16ToP010((uint16_t*)dstY, (uint16_t*)dstU, srcY, srcU, srcV, srcYStride,
                                   srcUStride, srcVStride, dstYStride, dstUStride, dstVStride,
-                                  mWidth, mHeight, isMonochrome, convFormat, mTmpFrameBuffer.get(),
+                                  width, height, isMonochrome, convFormat, mTmpFrameBuffer.get(),
                                   tmpSize);
         } else {
             size_t tmpSize = 0;
             if (img.p.layout == DAV1D_PIXEL_LAYOUT_I444) {
-                tmpSize = dstYStride * mHeight + dstUStride * align(mHeight, 2);
+                tmpSize = dstYStride * height + dstUStride * align(height, 2);
                 if (!allocTmpFrameBuffer(tmpSize)) {
                     ALOGE("Error allocating temp conversion buffer (%zu bytes)", tmpSize);
-                    setError(work, C2_NO_MEMORY);
-                    return false;
+                    return C2_NO_MEMORY;
                 }
             }
             convertPlanar16ToYV12(dstY, dstU, dstV, srcY, srcU, srcV, srcYStride, srcUStride,
-                                  srcVStride, dstYStride, dstUStride, dstVStride, mWidth, mHeight,
+                                  srcVStride, dstYStride, dstUStride, dstVStride, width, height,
                                   isMonochrome, convFormat, mTmpFrameBuffer.get(), tmpSize);
         }
 
         // if(mOutputBufferIndex % 100 == 0)
         ALOGV("output a 10bit picture %dx%d from dav1d "
               "(mInputBufferIndex=%d,mOutputBufferIndex=%d,format=%d).",
-              mWidth, mHeight, mInputBufferIndex, mOutputBufferIndex, format);
+              width, height, mInputBufferIndex, mOutputBufferIndex, format);
 
         // Dump the output buffer if dumping is enabled (debug only).
 #ifdef FILE_DUMP_ENABLE
         mC2SoftDav1dDump.dumpOutput<uint16_t>(srcY, srcU, srcV, srcYStride, srcUStride, srcVStride,
-                                              mWidth, mHeight);
+                                              width, height);
 #endif
     } else {
         const uint8_t* srcY = (const uint8_t*)img.data[0];
@@ -1133,22 +1184,20 @@ bool C2SoftDav1dDec::outputBuffer(const std::shared_ptr<C2BlockPool>& pool,
         // if(mOutputBufferIndex % 100 == 0)
         ALOGV("output a 8bit picture %dx%d from dav1d "
               "(mInputBufferIndex=%d,mOutputBufferIndex=%d,format=%d).",
-              mWidth, mHeight, mInputBufferIndex, mOutputBufferIndex, format);
+              width, height, mInputBufferIndex, mOutputBufferIndex, format);
 
         // Dump the output buffer is dumping is enabled (debug only)
 #ifdef FILE_DUMP_ENABLE
         mC2SoftDav1dDump.dumpOutput<uint8_t>(srcY, srcU, srcV, srcYStride, srcUStride, srcVStride,
-                                             mWidth, mHeight);
+                                             width, height);
 #endif
         convertPlanar8ToYV12(dstY, dstU, dstV, srcY, srcU, srcV, srcYStride, srcUStride, srcVStride,
-                             dstYStride, dstUStride, dstVStride, mWidth, mHeight, isMonochrome,
+                             dstYStride, dstUStride, dstVStride, width, height, isMonochrome,
                              convFormat);
     }
 
-    finishWork(out_frameIndex, work, std::move(block), img);
-    dav1d_picture_unref(&img);
-    block = nullptr;
-    return true;
+
+    return C2_OK;
 }
 
 c2_status_t C2SoftDav1dDec::drainInternal(uint32_t drainMode,
@@ -107,10 +107,15 @@ struct C2SoftDav1dDec : public SimpleC2Component {
     void destroyDecoder();
     void finishWork(uint64_t index, const std::unique_ptr<C2Work>& work,
                     const std::shared_ptr<C2GraphicBlock>& block,
-                    const Dav1dPicture &img);
+                    const Dav1dPicture &img, const C2Rect& crop);
     // Sets |work->result| and mSignalledError. Returns false.
     void setError(const std::unique_ptr<C2Work>& work, c2_status_t error);
     bool allocTmpFrameBuffer(size_t size);
+    // Converts |img| into |wView|. Runs on the output stage if it is enabled.
+    c2_status_t convertPicture(const Dav1dPicture& img, C2GraphicView& wView, uint32_t format,
+                               const std::shared_ptr<C2StreamColorAspectsInfo::output>&
+                                       codedColorAspects,
+                               const C2Rect& crop);
     bool outputBuffer(const std::shared_ptr<C2BlockPool>& pool,
                       const std::unique_ptr<C2Work>& work);
 
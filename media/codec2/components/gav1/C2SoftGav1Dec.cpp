@@ -30,6 +30,8 @@
 #include <media/stagefright/foundation/AUtils.h>
 #include <media/stagefright/foundation/MediaDefs.h>
 
+#include <new>
+
 // libyuv version required for I410ToAB30Matrix and I210ToAB30Matrix.
 #if LIBYUV_VERSION >= 1780
 #include <algorithm>
@@ -43,6 +45,9 @@ namespace android {
 // Property used to control the number of threads used in the gav1 decoder.
 constexpr char kNumThreadsProperty[] = "debug.c2.gav1.numthreads";
 
+// Property used to disable decoding directly into output blocks.
+constexpr char kDirectOutputProperty[] = "debug.c2.gav1.direct_output";
+
 // codecname set and passed in as a compile flag from Android.bp
 constexpr char COMPONENT_NAME[] = CODECNAME;
 
@@ -514,6 +519,10 @@ bool C2SoftGav1Dec::initDecoder() {
   if (numThreads > 0 && numThreads < settings.threads) {
     settings.threads = numThreads;
   }
+  mDirectOutput = android::base::GetBoolProperty(kDirectOutputProperty, true);
+  settings.get_frame_buffer = GetFrameBuffer;
+  settings.release_frame_buffer = ReleaseFrameBuffer;
+  settings.callback_private_data = this;
 
   ALOGV("Using libgav1 AV1 software decoder.");
   Libgav1StatusCode status = mCodecCtx->Init(&settings);
@@ -525,7 +534,125 @@ bool C2SoftGav1Dec::initDecoder() {
   return true;
 }
 
-void C2SoftGav1Dec::destroyDecoder() { mCodecCtx = nullptr; }
+void C2SoftGav1Dec::destroyDecoder() {
+  // Releases all frame buffers.
+  mCodecCtx = nullptr;
+  mOutputPool = nullptr;
+}
+
+// static
+Libgav1StatusCode C2SoftGav1Dec::GetFrameBuffer(
+    void *callbackPrivateData, int bitdepth, Libgav1ImageFormat imageFormat,
+    int width, int height, int leftBorder, int rightBorder, int topBorder,
+    int bottomBorder, int strideAlignment, Libgav1FrameBuffer *frameBuffer) {
+  return static_cast<C2SoftGav1Dec *>(callbackPrivateData)->getFrameBuffer(
+      bitdepth, imageFormat, width, height, leftBorder, rightBorder, topBorder,
+      bottomBorder, strideAlignment, frameBuffer);
+}
+
+// static
+void C2SoftGav1Dec::ReleaseFrameBuffer(void * /* callbackPrivateData */,
+                                       void *bufferPrivateData) {
+  delete static_cast<FrameBuffer *>(bufferPrivateData);
+}
+
+Libgav1StatusCode C2SoftGav1Dec::getFrameBuffer(
+    int bitdepth, Libgav1ImageFormat imageFormat, int width, int height,
+    int leftBorder, int rightBorder, int topBorder, int bottomBorder,
+    int strideAlignment, Libgav1FrameBuffer *frameBuffer) {
+  std::unique_ptr<FrameBuffer> fb(new (std::nothrow) FrameBuffer);
+  if (fb == nullptr) {
+    return kLibgav1StatusOutOfMemory;
+  }
+
+  // Only 8-bit 4:2:0 frames are output as they are decoded, as YV12. The
+  // output block is shared with the client while libgav1 may still read it as
+  // a reference, so this is not done for surfaces, which may be recycled as
+  // soon as they are rendered.
+  if (mDirectOutput && bitdepth == 8 && imageFormat == kLibgav1ImageFormatYuv420 &&
+      mOutputPool != nullptr &&
+      mOutputPool->getAllocatorId() != C2PlatformAllocatorStore::BUFFERQUEUE &&
+      mOutputPool->getAllocatorId() != C2PlatformAllocatorStore::IGBA &&
+      fetchDirectOutputBlock(fb.get(), width, height, leftBorder, rightBorder,
+                             topBorder, bottomBorder, strideAlignment,
+                             frameBuffer)) {
+    fb.release();
+    return kLibgav1StatusOk;
+  }
+  fb->view = nullptr;
+  fb->block = nullptr;
+
+  // Same allocation as the libgav1 internal frame buffers.
+  libgav1::FrameBufferInfo info;
+  Libgav1StatusCode status = libgav1::ComputeFrameBufferInfo(
+      bitdepth, imageFormat, width, height, leftBorder, rightBorder, topBorder,
+      bottomBorder, strideAlignment, &info);
+  if (status != kLibgav1StatusOk) {
+    return status;
+  }
+  const size_t size = info.y_buffer_size + 2 * info.uv_buffer_size;
+  fb->memory.reset(new (std::nothrow) uint8_t[size]);
+  if (fb->memory == nullptr) {
+    ALOGE("Error allocating frame buffer (%zu bytes)", size);
+    return kLibgav1StatusOutOfMemory;
+  }
+  uint8_t *const y = fb->memory.get();
+  uint8_t *const u = info.uv_buffer_size != 0 ? y + info.y_buffer_size : nullptr;
+  uint8_t *const v = info.uv_buffer_size != 0 ? u + info.uv_buffer_size : nullptr;
+  status = libgav1::SetFrameBuffer(&info, y, u, v, fb.get(), frameBuffer);
+  if (status != kLibgav1StatusOk) {
+    return status;
+  }
+  fb.release();
+  return kLibgav1StatusOk;
+}
+
+bool C2SoftGav1Dec::fetchDirectOutputBlock(
+    FrameBuffer *fb, int width, int height, int leftBorder, int rightBorder,
+    int topBorder, int bottomBorder, int strideAlignment,
+    Libgav1FrameBuffer *frameBuffer) {
+  // The borders are part of the block and are cropped out on output.
+  C2MemoryUsage usage = {C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE};
+  c2_status_t err = mOutputPool->fetchGraphicBlock(
+      align(leftBorder + width + rightBorder, 16),
+      align(topBorder + height + bottomBorder, 2), HAL_PIXEL_FORMAT_YV12, usage,
+      &fb->block);
+  if (err != C2_OK) {
+    ALOGV("fetchGraphicBlock for direct output failed with status %d", err);
+    return false;
+  }
+  fb->view.reset(new (std::nothrow) C2GraphicView(fb->block->map().get()));
+  if (fb->view == nullptr || fb->view->error() != C2_OK) {
+    ALOGV("graphic view map failed for direct output");
+    return false;
+  }
+
+  const C2PlanarLayout layout = fb->view->layout();
+  if (layout.type != C2PlanarLayout::TYPE_YUV || layout.numPlanes != 3) {
+    return false;
+  }
+  static constexpr uint32_t kPlanes[] = {C2PlanarLayout::PLANE_Y,
+                                         C2PlanarLayout::PLANE_U,
+                                         C2PlanarLayout::PLANE_V};
+  for (int i = 0; i < 3; ++i) {
+    const C2PlaneInfo &plane = layout.planes[kPlanes[i]];
+    // libgav1 decodes 4:2:0 only into planar buffers with aligned rows.
+    if (plane.colInc != 1 || plane.rowInc <= 0 ||
+        plane.rowInc % strideAlignment != 0) {
+      return false;
+    }
+    const int shift = i == 0 ? 0 : 1;
+    uint8_t *const data = const_cast<uint8_t *>(fb->view->data()[kPlanes[i]]) +
+                          (topBorder >> shift) * plane.rowInc + (leftBorder >> shift);
+    if (reinterpret_cast<uintptr_t>(data) % strideAlignment != 0) {
+      return false;
+    }
+    frameBuffer->plane[i] = data;
+    frameBuffer->stride[i] = plane.rowInc;
+  }
+  frameBuffer->private_data = fb;
+  return true;
+}
 
 void fillEmptyWork(const std::unique_ptr<C2Work> &work) {
   uint32_t flags = 0;
@@ -541,9 +668,9 @@ void fillEmptyWork(const std::unique_ptr<C2Work> &work) {
 
 void C2SoftGav1Dec::finishWork(uint64_t index,
                                const std::unique_ptr<C2Work> &work,
-                               const std::shared_ptr<C2GraphicBlock> &block) {
-  std::shared_ptr<C2Buffer> buffer =
-      createGraphicBuffer(block, C2Rect(mWidth, mHeight));
+                               const std::shared_ptr<C2GraphicBlock> &block,
+                               const C2Rect &crop) {
+  std::shared_ptr<C2Buffer> buffer = createGraphicBuffer(block, crop);
   {
       IntfImpl::Lock lock = mIntf->lock();
       buffer->setInfo(mIntf->getColorAspects_l());
@@ -578,6 +705,7 @@ void C2SoftGav1Dec::process(const std::unique_ptr<C2Work> &work,
     work->result = C2_BAD_VALUE;
     return;
   }
+  mOutputPool = pool;
 
   size_t inOffset = 0u;
   size_t inSize = 0u;
@@ -899,6 +1027,24 @@ bool C2SoftGav1Dec::outputBuffer(const std::shared_ptr<C2BlockPool> &pool,
     mHalPixelFormat = format;
   }
 
+  const FrameBuffer *frameBuffer =
+      static_cast<const FrameBuffer *>(buffer->buffer_private_data);
+  if (frameBuffer != nullptr && frameBuffer->block != nullptr &&
+      format == HAL_PIXEL_FORMAT_YV12) {
+    // The frame was decoded into the block, which is only read from now on.
+    const uint8_t *const blockY =
+        frameBuffer->view->data()[C2PlanarLayout::PLANE_Y];
+    const ptrdiff_t offset = buffer->plane[0] - blockY;
+    const int32_t rowInc =
+        frameBuffer->view->layout().planes[C2PlanarLayout::PLANE_Y].rowInc;
+    const C2Rect crop =
+        C2Rect(mWidth, mHeight).at(offset % rowInc, offset / rowInc);
+    ALOGV("direct output (%dx%d) at (%u,%u), out frameindex %d", mWidth,
+          mHeight, crop.left, crop.top, (int)buffer->user_private_data);
+    finishWork(buffer->user_private_data, work, frameBuffer->block, crop);
+    return true;
+  }
+
   C2MemoryUsage usage = {C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE};
 
   // We always create a graphic block that is width aligned to 16 and height
@@ -1105,7 +1251,8 @@ bool C2SoftGav1Dec::outputBuffer(const std::shared_ptr<C2BlockPool> &pool,
                                    isMonochrome);
     }
   }
-  finishWork(buffer->user_private_data, work, std::move(block));
+  finishWork(buffer->user_private_data, work, std::move(block),
+             C2Rect(mWidth, mHeight));
   block = nullptr;
   return true;
 }
@@ -1121,6 +1268,7 @@ c2_status_t C2SoftGav1Dec::drainInternal(
     ALOGW("DRAIN_CHAIN not supported");
     return C2_OMITTED;
   }
+  mOutputPool = pool;
 
   const Libgav1StatusCode status = mCodecCtx->SignalEOS();
   if (status != kLibgav1StatusOk) {
@@ -27,6 +27,7 @@
 #include <C2Config.h>
 #include <gav1/decoder.h>
 #include <gav1/decoder_settings.h>
+#include <gav1/frame_buffer.h>
 
 namespace android {
 
@@ -90,6 +91,21 @@ struct C2SoftGav1Dec : public SimpleC2Component {
       }
   } mBitstreamColorAspects;
 
+  // Frame buffer handed to libgav1 through the frame buffer callbacks. libgav1 owns it until it
+  // stops using the frame for output and as a reference, and then calls ReleaseFrameBuffer().
+  struct FrameBuffer {
+    // Set when libgav1 decodes directly into an output block; |view| keeps it mapped.
+    std::shared_ptr<C2GraphicBlock> block;
+    std::unique_ptr<C2GraphicView> view;
+    // Otherwise the frame is in |memory| and is converted into an output block.
+    std::unique_ptr<uint8_t[]> memory;
+  };
+
+  // Whether frames may be decoded directly into output blocks, see getFrameBuffer().
+  bool mDirectOutput = false;
+  // Pool of the work being processed, used by getFrameBuffer().
+  std::shared_ptr<C2BlockPool> mOutputPool;
+
   nsecs_t mTimeStart = 0;  // Time at the start of decode()
   nsecs_t mTimeEnd = 0;    // Time at the end of decode()
 
@@ -101,7 +117,22 @@ struct C2SoftGav1Dec : public SimpleC2Component {
   void getVuiParams(const libgav1::DecoderBuffer *buffer);
   void destroyDecoder();
   void finishWork(uint64_t index, const std::unique_ptr<C2Work>& work,
-                  const std::shared_ptr<C2GraphicBlock>& block);
+                  const std::shared_ptr<C2GraphicBlock>& block, const C2Rect& crop);
+  static Libgav1StatusCode GetFrameBuffer(void* callbackPrivateData, int bitdepth,
+                                          Libgav1ImageFormat imageFormat, int width,
+                                          int height, int leftBorder, int rightBorder,
+                                          int topBorder, int bottomBorder,
+                                          int strideAlignment,
+                                          Libgav1FrameBuffer* frameBuffer);
+  static void ReleaseFrameBuffer(void* callbackPrivateData, void* bufferPrivateData);
+  Libgav1StatusCode getFrameBuffer(int bitdepth, Libgav1ImageFormat imageFormat, int width,
+                                   int height, int leftBorder, int rightBorder, int topBorder,
+                                   int bottomBorder, int strideAlignment,
+                                   Libgav1FrameBuffer* frameBuffer);
+  // Decodes the frame into an output block if possible, see getFrameBuffer().
+  bool fetchDirectOutputBlock(FrameBuffer* fb, int width, int height, int leftBorder,
+                              int rightBorder, int topBorder, int bottomBorder,
+                              int strideAlignment, Libgav1FrameBuffer* frameBuffer);
   // Sets |work->result| and mSignalledError. Returns false.
   void setError(const std::unique_ptr<C2Work> &work, c2_status_t error);
   bool allocTmpFrameBuffer(size_t size);
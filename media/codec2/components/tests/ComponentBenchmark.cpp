@@ -0,0 +1,551 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks the throughput of the software codecs of the platform component store, run in
+// this process the way CCodec drives them: works are queued as long as fewer than
+// (input delay + pipeline delay + 1) are pending, until the end of stream is output.
+// - Encoders get a synthesized clip: a moving YUV 4:2:0 pattern, or a stereo sine in 20 ms
+//   chunks.
+// - Decoders get the output of the matching encoder for that clip, codec config included.
+//
+// One iteration runs the whole clip through a newly started component. The time per
+// iteration is the wall time from the first queue() to the end of stream. Counters:
+// - fps: frames (input works) per second of wall time,
+// - latencyP50Us, latencyP90Us, latencyP99Us: time from queue() to onWorkDone() of each work,
+// - inputBlocks, outputBlocks: buffers allocated for the input, and output buffers returned,
+//   per iteration,
+// - peakRssKb: peak RSS of the process so far. Run one codec per process (with
+//   --benchmark_filter) for a meaningful value.
+//
+// Results can be saved in JSON and compared across builds with the benchmark library tools:
+//   adb shell /data/benchmarktest64/codec2_component_benchmark/codec2_component_benchmark
+//       --benchmark_format=json --benchmark_out=/data/local/tmp/codec2_components.json
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string.h>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <system/graphics.h>
+
+#include <C2Buffer.h>
+#include <C2Component.h>
+#include <C2Config.h>
+#include <C2PlatformSupport.h>
+#include <C2Work.h>
+
+using namespace android;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::chrono::seconds kTimeout{10};
+constexpr size_t kVideoFrames = 60;
+constexpr float kVideoFrameRate = 30.;
+constexpr size_t kAudioChunks = 250;  // 5 seconds
+constexpr size_t kAudioChunksPerSecond = 50;
+
+struct CodecSpec {
+    const char *name;
+    // the encoder that produces the input of a decoder; null for an encoder
+    const char *encoder;
+    bool video;
+    uint32_t width;         // video
+    uint32_t height;        // video
+    uint32_t sampleRate;    // audio
+    uint32_t channelCount;  // audio
+    uint32_t bitrate;
+};
+
+constexpr CodecSpec kCodecs[] = {
+    { "c2.android.avc.encoder", nullptr, true, 1280, 720, 0, 0, 4000000 },
+    { "c2.android.hevc.encoder", nullptr, true, 1280, 720, 0, 0, 4000000 },
+    { "c2.android.vp8.encoder", nullptr, true, 1280, 720, 0, 0, 4000000 },
+    { "c2.android.vp9.encoder", nullptr, true, 1280, 720, 0, 0, 4000000 },
+    { "c2.android.av1.encoder", nullptr, true, 1280, 720, 0, 0, 4000000 },
+    { "c2.android.mpeg4.encoder", nullptr, true, 352, 288, 0, 0, 1000000 },
+    { "c2.android.h263.encoder", nullptr, true, 352, 288, 0, 0, 1000000 },
+    { "c2.android.aac.encoder", nullptr, false, 0, 0, 48000, 2, 128000 },
+    { "c2.android.opus.encoder", nullptr, false, 0, 0, 48000, 2, 128000 },
+    { "c2.android.amrnb.encoder", nullptr, false, 0, 0, 8000, 1, 12200 },
+    { "c2.android.amrwb.encoder", nullptr, false, 0, 0, 16000, 1, 23850 },
+    { "c2.android.flac.encoder", nullptr, false, 0, 0, 48000, 2, 0 },
+    { "c2.android.avc.decoder", "c2.android.avc.encoder", true, 1280, 720, 0, 0, 4000000 },
+    { "c2.android.hevc.decoder", "c2.android.hevc.encoder", true, 1280, 720, 0, 0, 4000000 },
+    { "c2.android.vp8.decoder", "c2.android.vp8.encoder", true, 1280, 720, 0, 0, 4000000 },
+    { "c2.android.vp9.decoder", "c2.android.vp9.encoder", true, 1280, 720, 0, 0, 4000000 },
+    { "c2.android.av1.decoder", "c2.android.av1.encoder", true, 1280, 720, 0, 0, 4000000 },
+    { "c2.android.mpeg4.decoder", "c2.android.mpeg4.encoder", true, 352, 288, 0, 0, 1000000 },
+    { "c2.android.h263.decoder", "c2.android.h263.encoder", true, 352, 288, 0, 0, 1000000 },
+    { "c2.android.aac.decoder", "c2.android.aac.encoder", false, 0, 0, 48000, 2, 128000 },
+    { "c2.android.opus.decoder", "c2.android.opus.encoder", false, 0, 0, 48000, 2, 128000 },
+    { "c2.android.amrnb.decoder", "c2.android.amrnb.encoder", false, 0, 0, 8000, 1, 12200 },
+    { "c2.android.amrwb.decoder", "c2.android.amrwb.encoder", false, 0, 0, 16000, 1, 23850 },
+    { "c2.android.flac.decoder", "c2.android.flac.encoder", false, 0, 0, 48000, 2, 0 },
+};
+
+// A compressed frame, as input of a decoder.
+struct Frame {
+    std::vector<uint8_t> data;
+    uint64_t timestampUs;
+    C2FrameData::flags_t flags;
+};
+
+class Listener : public C2Component::Listener {
+public:
+    void onWorkDone_nb(
+            std::weak_ptr<C2Component>, std::list<std::unique_ptr<C2Work>> workItems) override {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mDone.splice(mDone.end(), workItems);
+        mCondition.notify_all();
+    }
+
+    void onTripped_nb(
+            std::weak_ptr<C2Component>,
+            std::vector<std::shared_ptr<C2SettingResult>>) override {
+    }
+
+    void onError_nb(std::weak_ptr<C2Component>, uint32_t errorCode) override {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mError = errorCode;
+        mCondition.notify_all();
+    }
+
+    // Waits for done works; returns false on error or timeout.
+    bool wait(std::list<std::unique_ptr<C2Work>> *done) {
+        std::unique_lock<std::mutex> lock(mMutex);
+        if (!mCondition.wait_for(lock, kTimeout, [this] { return !mDone.empty() || mError; })
+                || mError) {
+            return false;
+        }
+        done->splice(done->end(), mDone);
+        return true;
+    }
+
+private:
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::list<std::unique_ptr<C2Work>> mDone;
+    uint32_t mError = 0;
+};
+
+struct RunStats {
+    std::chrono::duration<double> elapsed{0};
+    size_t frames = 0;
+    size_t inputBlocks = 0;
+    size_t outputBlocks = 0;
+    std::vector<int64_t> latenciesUs;
+};
+
+// Runs one clip through a component.
+class Runner {
+public:
+    explicit Runner(const CodecSpec &spec) : mSpec(spec) {}
+
+    // Creates, configures and starts the component.
+    const char *start(const char *name) {
+        std::shared_ptr<C2ComponentStore> store = GetCodec2PlatformComponentStore();
+        if (store->createComponent(name, &mComponent) != C2_OK || !mComponent) {
+            return "component not available";
+        }
+        bool encoder = strstr(name, ".encoder") != nullptr;
+        std::vector<std::unique_ptr<C2Param>> params;
+        if (mSpec.video) {
+            if (encoder) {
+                params.push_back(C2Param::Copy(
+                        C2StreamPictureSizeInfo::input(0u, mSpec.width, mSpec.height)));
+                params.push_back(C2Param::Copy(
+                        C2StreamFrameRateInfo::output(0u, kVideoFrameRate)));
+                params.push_back(C2Param::Copy(C2StreamBitrateInfo::output(0u, mSpec.bitrate)));
+            } else {
+                params.push_back(C2Param::Copy(
+                        C2StreamPictureSizeInfo::output(0u, mSpec.width, mSpec.height)));
+            }
+        } else if (encoder) {
+            params.push_back(C2Param::Copy(C2StreamSampleRateInfo::input(0u, mSpec.sampleRate)));
+            params.push_back(C2Param::Copy(
+                    C2StreamChannelCountInfo::input(0u, mSpec.channelCount)));
+            if (mSpec.bitrate) {
+                params.push_back(C2Param::Copy(C2StreamBitrateInfo::output(0u, mSpec.bitrate)));
+            }
+        } else {
+            params.push_back(C2Param::Copy(C2StreamSampleRateInfo::output(0u, mSpec.sampleRate)));
+            params.push_back(C2Param::Copy(
+                    C2StreamChannelCountInfo::output(0u, mSpec.channelCount)));
+        }
+        std::vector<C2Param *> configs;
+        for (const std::unique_ptr<C2Param> &param : params) {
+            configs.push_back(param.get());
+        }
+        std::vector<std::unique_ptr<C2SettingResult>> failures;
+        mComponent->intf()->config_vb(configs, C2_MAY_BLOCK, &failures);
+
+        C2PortActualDelayTuning::input inputDelay(0);
+        C2ActualPipelineDelayTuning pipelineDelay(0);
+        std::vector<std::unique_ptr<C2Param>> heapParams;
+        mComponent->intf()->query_vb(
+                { &inputDelay, &pipelineDelay }, {}, C2_MAY_BLOCK, &heapParams);
+        mMaxPending = 1 + inputDelay.value + pipelineDelay.value;
+
+        std::shared_ptr<C2BlockPool> pool;
+        GetCodec2BlockPool(
+                mSpec.video && encoder ? C2BlockPool::BASIC_GRAPHIC : C2BlockPool::BASIC_LINEAR,
+                nullptr, &pool);
+        mPool = pool;
+        if (!mPool) {
+            return "no input block pool";
+        }
+        mListener = std::make_shared<Listener>();
+        if (mComponent->setListener_vb(mListener, C2_MAY_BLOCK) != C2_OK
+                || mComponent->start() != C2_OK) {
+            return "cannot start component";
+        }
+        return nullptr;
+    }
+
+    void stop() {
+        if (mComponent) {
+            mComponent->stop();
+            mComponent->setListener_vb(nullptr, C2_MAY_BLOCK);
+            mComponent->release();
+            mComponent.reset();
+        }
+    }
+
+    ~Runner() { stop(); }
+
+    // Runs |numFrames| works, whose input is filled by |fill|. Appends the output of the
+    // component to |output| if not null.
+    const char *run(
+            size_t numFrames,
+            std::function<const char *(size_t index, C2Work *work, RunStats *stats)> fill,
+            RunStats *stats,
+            std::vector<Frame> *output = nullptr) {
+        std::map<uint64_t, Clock::time_point> queued;
+        size_t next = 0;
+        bool eos = false;
+        const Clock::time_point start = Clock::now();
+        while (!eos) {
+            std::list<std::unique_ptr<C2Work>> items;
+            while (next < numFrames && queued.size() + items.size() < mMaxPending) {
+                std::unique_ptr<C2Work> work = std::make_unique<C2Work>();
+                work->input.ordinal.frameIndex = next;
+                work->input.ordinal.customOrdinal = next;
+                work->worklets.emplace_back(new C2Worklet);
+                if (const char *error = fill(next, work.get(), stats)) {
+                    return error;
+                }
+                if (next + 1 == numFrames) {
+                    work->input.flags = C2FrameData::flags_t(
+                            work->input.flags | C2FrameData::FLAG_END_OF_STREAM);
+                }
+                items.push_back(std::move(work));
+                ++next;
+            }
+            if (!items.empty()) {
+                const Clock::time_point now = Clock::now();
+                for (const std::unique_ptr<C2Work> &work : items) {
+                    queued.emplace(work->input.ordinal.frameIndex.peeku(), now);
+                }
+                if (mComponent->queue_nb(&items) != C2_OK) {
+                    return "queue_nb failed";
+                }
+            }
+            std::list<std::unique_ptr<C2Work>> done;
+            if (!mListener->wait(&done)) {
+                return "component error or timeout";
+            }
+            const Clock::time_point now = Clock::now();
+            for (const std::unique_ptr<C2Work> &work : done) {
+                auto it = queued.find(work->input.ordinal.frameIndex.peeku());
+                if (it != queued.end()) {
+                    stats->latenciesUs.push_back(
+                            std::chrono::duration_cast<std::chrono::microseconds>(
+                                    now - it->second).count());
+                    queued.erase(it);
+                }
+                if (work->result != C2_OK || work->worklets.empty()) {
+                    continue;
+                }
+                const C2FrameData &out = work->worklets.front()->output;
+                collect(out, stats, output);
+                if (out.flags & C2FrameData::FLAG_END_OF_STREAM) {
+                    eos = true;
+                }
+            }
+        }
+        stats->elapsed += Clock::now() - start;
+        stats->frames += numFrames;
+        return nullptr;
+    }
+
+    std::shared_ptr<C2BlockPool> pool() const { return mPool; }
+
+private:
+    const CodecSpec &mSpec;
+    std::shared_ptr<C2Component> mComponent;
+    std::shared_ptr<Listener> mListener;
+    std::shared_ptr<C2BlockPool> mPool;
+    size_t mMaxPending = 1;
+
+    static void collect(const C2FrameData &out, RunStats *stats, std::vector<Frame> *output) {
+        if (output) {
+            for (const std::unique_ptr<C2Param> &param : out.configUpdate) {
+                if (const C2StreamInitDataInfo::output *csd =
+                        C2StreamInitDataInfo::output::From(param.get())) {
+                    output->push_back({
+                            std::vector<uint8_t>(
+                                    csd->m.value, csd->m.value + csd->flexCount()),
+                            0u, C2FrameData::FLAG_CODEC_CONFIG });
+                }
+            }
+        }
+        for (const std::shared_ptr<C2Buffer> &buffer : out.buffers) {
+            ++stats->outputBlocks;
+            if (!output || buffer->data().type() != C2BufferData::LINEAR
+                    || buffer->data().linearBlocks().empty()) {
+                continue;
+            }
+            C2ReadView view = buffer->data().linearBlocks().front().map().get();
+            if (view.error() != C2_OK || view.capacity() == 0) {
+                continue;
+            }
+            output->push_back({
+                    std::vector<uint8_t>(view.data(), view.data() + view.capacity()),
+                    out.ordinal.timestamp.peeku(),
+                    C2FrameData::flags_t(out.flags & C2FrameData::FLAG_CODEC_CONFIG) });
+        }
+    }
+};
+
+// Fills a graphic block with a pattern that moves with |index|.
+const char *fillVideoFrame(
+        const CodecSpec &spec, const std::shared_ptr<C2BlockPool> &pool, size_t index,
+        C2Work *work) {
+    std::shared_ptr<C2GraphicBlock> block;
+    if (pool->fetchGraphicBlock(
+                spec.width, spec.height, HAL_PIXEL_FORMAT_YCBCR_420_888,
+                { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE }, &block) != C2_OK) {
+        return "cannot allocate graphic block";
+    }
+    C2GraphicView view = block->map().get();
+    if (view.error() != C2_OK) {
+        return "cannot map graphic block";
+    }
+    const C2PlanarLayout &layout = view.layout();
+    for (uint32_t p = 0; p < layout.numPlanes; ++p) {
+        const C2PlaneInfo &plane = layout.planes[p];
+        uint8_t *data = view.data()[p];
+        for (uint32_t y = 0; y < spec.height / plane.rowSampling; ++y) {
+            uint8_t *row = data + y * plane.rowInc;
+            for (uint32_t x = 0; x < spec.width / plane.colSampling; ++x) {
+                row[x * plane.colInc] = (p == C2PlanarLayout::PLANE_Y)
+                        ? uint8_t(x + y + index * 4) : uint8_t(128 + ((x + index) & 0xF));
+            }
+        }
+    }
+    work->input.ordinal.timestamp = uint64_t(index * 1000000 / kVideoFrameRate);
+    work->input.buffers.push_back(C2Buffer::CreateGraphicBuffer(
+            block->share(C2Rect(spec.width, spec.height), C2Fence())));
+    return nullptr;
+}
+
+// Fills a linear block with a 20 ms chunk of a 440 Hz sine.
+const char *fillAudioChunk(
+        const CodecSpec &spec, const std::shared_ptr<C2BlockPool> &pool, size_t index,
+        C2Work *work) {
+    const size_t samples = spec.sampleRate / kAudioChunksPerSecond;
+    const size_t size = samples * spec.channelCount * sizeof(int16_t);
+    std::shared_ptr<C2LinearBlock> block;
+    if (pool->fetchLinearBlock(
+                size, { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE }, &block) != C2_OK) {
+        return "cannot allocate linear block";
+    }
+    C2WriteView view = block->map().get();
+    if (view.error() != C2_OK) {
+        return "cannot map linear block";
+    }
+    int16_t *pcm = reinterpret_cast<int16_t *>(view.data());
+    for (size_t i = 0; i < samples; ++i) {
+        const double t = double(index * samples + i) / spec.sampleRate;
+        const int16_t value = int16_t(8000 * sin(2 * M_PI * 440 * t));
+        for (size_t c = 0; c < spec.channelCount; ++c) {
+            pcm[i * spec.channelCount + c] = value;
+        }
+    }
+    work->input.ordinal.timestamp = uint64_t(index * 1000000 / kAudioChunksPerSecond);
+    work->input.buffers.push_back(C2Buffer::CreateLinearBuffer(block->share(0, size, C2Fence())));
+    return nullptr;
+}
+
+const char *fillRawFrame(
+        const CodecSpec &spec, const std::shared_ptr<C2BlockPool> &pool, size_t index,
+        C2Work *work, RunStats *stats) {
+    ++stats->inputBlocks;
+    return spec.video ? fillVideoFrame(spec, pool, index, work)
+                      : fillAudioChunk(spec, pool, index, work);
+}
+
+size_t numRawFrames(const CodecSpec &spec) {
+    return spec.video ? kVideoFrames : kAudioChunks;
+}
+
+// Encodes the clip once for each decoder, outside of the timed runs.
+const std::vector<Frame> *getEncodedClip(const CodecSpec &spec, const char **error) {
+    static std::map<std::string, std::vector<Frame>> sClips;
+    auto it = sClips.find(spec.encoder);
+    if (it != sClips.end()) {
+        return &it->second;
+    }
+    Runner encoder(spec);
+    if ((*error = encoder.start(spec.encoder)) != nullptr) {
+        return nullptr;
+    }
+    std::vector<Frame> clip;
+    RunStats stats;
+    std::shared_ptr<C2BlockPool> pool = encoder.pool();
+    *error = encoder.run(
+            numRawFrames(spec),
+            [&spec, pool](size_t index, C2Work *work, RunStats *runStats) {
+                return fillRawFrame(spec, pool, index, work, runStats);
+            },
+            &stats, &clip);
+    if (*error) {
+        return nullptr;
+    }
+    if (clip.empty()) {
+        *error = "encoder produced no output";
+        return nullptr;
+    }
+    return &sClips.emplace(spec.encoder, std::move(clip)).first->second;
+}
+
+const char *fillCompressedFrame(
+        const Frame &frame, const std::shared_ptr<C2BlockPool> &pool, C2Work *work,
+        RunStats *stats) {
+    std::shared_ptr<C2LinearBlock> block;
+    if (pool->fetchLinearBlock(
+                frame.data.size(), { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE },
+                &block) != C2_OK) {
+        return "cannot allocate linear block";
+    }
+    C2WriteView view = block->map().get();
+    if (view.error() != C2_OK) {
+        return "cannot map linear block";
+    }
+    ++stats->inputBlocks;
+    memcpy(view.data(), frame.data.data(), frame.data.size());
+    work->input.ordinal.timestamp = frame.timestampUs;
+    work->input.flags = frame.flags;
+    work->input.buffers.push_back(C2Buffer::CreateLinearBuffer(
+            block->share(0, frame.data.size(), C2Fence())));
+    return nullptr;
+}
+
+int64_t percentile(std::vector<int64_t> &values, double fraction) {
+    if (values.empty()) {
+        return 0;
+    }
+    size_t index = std::min(values.size() - 1, size_t(fraction * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+// Args: index in kCodecs.
+void BM_Codec2Component(benchmark::State &state) {
+    const CodecSpec &spec = kCodecs[state.range(0)];
+    state.SetLabel(spec.name);
+
+    const std::vector<Frame> *clip = nullptr;
+    if (spec.encoder) {
+        const char *error = nullptr;
+        if ((clip = getEncodedClip(spec, &error)) == nullptr) {
+            state.SkipWithError(error);
+            return;
+        }
+    }
+
+    RunStats stats;
+    const char *error = nullptr;
+    for (auto _ : state) {
+        Runner runner(spec);
+        if ((error = runner.start(spec.name)) != nullptr) {
+            break;
+        }
+        std::shared_ptr<C2BlockPool> pool = runner.pool();
+        const std::chrono::duration<double> before = stats.elapsed;
+        error = clip
+            ? runner.run(
+                    clip->size(),
+                    [clip, pool](size_t index, C2Work *work, RunStats *runStats) {
+                        return fillCompressedFrame((*clip)[index], pool, work, runStats);
+                    },
+                    &stats)
+            : runner.run(
+                    numRawFrames(spec),
+                    [&spec, pool](size_t index, C2Work *work, RunStats *runStats) {
+                        return fillRawFrame(spec, pool, index, work, runStats);
+                    },
+                    &stats);
+        if (error) {
+            break;
+        }
+        state.SetIterationTime((stats.elapsed - before).count());
+    }
+    if (error) {
+        state.SkipWithError(error);
+        return;
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    const double iterations = state.iterations();
+    state.counters["fps"] = stats.elapsed.count() > 0 ? stats.frames / stats.elapsed.count() : 0;
+    state.counters["latencyP50Us"] = percentile(stats.latenciesUs, 0.5);
+    state.counters["latencyP90Us"] = percentile(stats.latenciesUs, 0.9);
+    state.counters["latencyP99Us"] = percentile(stats.latenciesUs, 0.99);
+    state.counters["inputBlocks"] = stats.inputBlocks / iterations;
+    state.counters["outputBlocks"] = stats.outputBlocks / iterations;
+    state.counters["peakRssKb"] = usage.ru_maxrss;
+}
+
+void CodecArgs(benchmark::internal::Benchmark *b) {
+    for (size_t i = 0; i < std::size(kCodecs); ++i) {
+        b->Arg(i);
+    }
+}
+
+BENCHMARK(BM_Codec2Component)
+        ->Apply(CodecArgs)
+        ->UseManualTime()
+        ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks the high bit depth plane conversions of SimpleC2Component, which software
+// decoders use for each output frame, at common frame sizes.
+//
+// Run with, for example:
+//   adb shell /data/benchmarktest64/codec2_plane_conversion_benchmark/codec2_plane_conversion_benchmark
+
+#include <stdlib.h>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <SimpleC2Component.h>
+
+using namespace android;
+
+namespace {
+
+// 10-bit 4:2:0 planar frame, as output by the decoders.
+struct Planar16Frame {
+    Planar16Frame(size_t width, size_t height)
+        : width(width), height(height), y(width * height),
+          u((width / 2) * (height / 2)), v((width / 2) * (height / 2)) {
+        for (auto *plane : {&y, &u, &v}) {
+            for (auto &sample : *plane) {
+                sample = rand() & 0x3FF;
+            }
+        }
+    }
+
+    const size_t width;
+    const size_t height;
+    std::vector<uint16_t> y;
+    std::vector<uint16_t> u;
+    std::vector<uint16_t> v;
+};
+
+// Args: width, height.
+void BM_Planar16ToRGBA1010102(benchmark::State &state) {
+    const Planar16Frame src(state.range(0), state.range(1));
+    std::vector<uint32_t> dst(src.width * src.height);
+    auto aspects = std::make_shared<C2ColorAspectsStruct>(
+            C2Color::RANGE_LIMITED, C2Color::PRIMARIES_BT2020, C2Color::TRANSFER_ST2084,
+            C2Color::MATRIX_BT2020);
+    for (auto _ : state) {
+        convertYUV420Planar16ToY410OrRGBA1010102(
+                dst.data(), src.y.data(), src.u.data(), src.v.data(), src.width,
+                src.width / 2, src.width / 2, src.width, src.width, src.height, aspects);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * src.width * src.height * sizeof(uint32_t));
+}
+
+void BM_Planar16ToP010(benchmark::State &state) {
+    const Planar16Frame src(state.range(0), state.range(1));
+    std::vector<uint16_t> dstY(src.width * src.height);
+    std::vector<uint16_t> dstUV(src.width * src.height / 2);
+    for (auto _ : state) {
+        convertYUV420Planar16ToP010(dstY.data(), dstUV.data(), src.y.data(), src.u.data(),
+                                    src.v.data(), src.width, src.width / 2, src.width / 2,
+                                    src.width, src.width, src.width, src.height);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * src.width * src.height * 3 / 2 * 2);
+}
+
+void BM_P010ToPlanar16(benchmark::State &state) {
+    const size_t width = state.range(0);
+    const size_t height = state.range(1);
+    std::vector<uint16_t> srcY(width * height);
+    std::vector<uint16_t> srcUV(width * height / 2);
+    for (auto *plane : {&srcY, &srcUV}) {
+        for (auto &sample : *plane) {
+            sample = (rand() & 0x3FF) << 6;
+        }
+    }
+    Planar16Frame dst(width, height);
+    for (auto _ : state) {
+        convertP010ToYUV420Planar16(dst.y.data(), dst.u.data(), dst.v.data(), srcY.data(),
+                                    srcUV.data(), width, width, width, width / 2, width / 2,
+                                    width, height);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * width * height * 3 / 2 * 2);
+}
+
+void BM_Planar16ToYV12(benchmark::State &state) {
+    const Planar16Frame src(state.range(0), state.range(1));
+    std::vector<uint8_t> dstY(src.width * src.height);
+    std::vector<uint8_t> dstU(src.width * src.height / 4);
+    std::vector<uint8_t> dstV(src.width * src.height / 4);
+    for (auto _ : state) {
+        convertYUV420Planar16ToYV12(dstY.data(), dstU.data(), dstV.data(), src.y.data(),
+                                    src.u.data(), src.v.data(), src.width, src.width / 2,
+                                    src.width / 2, src.width, src.width / 2, src.width,
+                                    src.height);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * src.width * src.height * 3 / 2);
+}
+
+void FrameSizes(benchmark::internal::Benchmark *b) {
+    b->Args({1280, 720});
+    b->Args({1920, 1080});
+    b->Args({3840, 2160});
+}
+
+BENCHMARK(BM_Planar16ToRGBA1010102)->Apply(FrameSizes);
+BENCHMARK(BM_Planar16ToP010)->Apply(FrameSizes);
+BENCHMARK(BM_P010ToPlanar16)->Apply(FrameSizes);
+BENCHMARK(BM_Planar16ToYV12)->Apply(FrameSizes);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -72,6 +72,7 @@
 #include <media/stagefright/foundation/ADebug.h> // for asString(status_t)
 
 #include <deque>
+#include <future>
 #include <iterator>
 #include <limits>
 #include <map>
@@ -845,6 +846,7 @@ struct Codec2Client::Component::HidlListener : public c2_hidl::IComponentListene
     std::weak_ptr<Listener> base;
 
     virtual Return<void> onWorkDone(const c2_hidl::WorkBundle& workBundle) override {
+        ScopedTrace trace(ATRACE_TAG,"Codec2Client::Component::onWorkDone");
         std::list<std::unique_ptr<C2Work>> workItems;
         if (!c2_hidl::utils::objcpy(&workItems, workBundle)) {
             LOG(DEBUG) << "onWorkDone -- received corrupted WorkBundle.";
@@ -942,6 +944,7 @@ struct Codec2Client::Component::AidlListener : public c2_aidl::BnComponentListen
     std::weak_ptr<Listener> base;
 
     virtual ::ndk::ScopedAStatus onWorkDone(const c2_aidl::WorkBundle& workBundle) override {
+        ScopedTrace trace(ATRACE_TAG,"Codec2Client::Component::onWorkDone");
         std::list<std::unique_ptr<C2Work>> workItems;
         if (!c2_aidl::utils::FromAidl(&workItems, workBundle)) {
             LOG(DEBUG) << "onWorkDone -- received corrupted WorkBundle.";
@@ -1820,10 +1823,19 @@ std::shared_ptr<Codec2Client::Interface> Codec2Client::CreateInterfaceByName(
 
 std::vector<C2Component::Traits> const& Codec2Client::ListComponents() {
     static std::vector<C2Component::Traits> sList{[]() {
-        std::vector<C2Component::Traits> list;
+        // Query all services in parallel, as each listComponents() call may
+        // have to wait for its service to start. The list keeps the order of
+        // Cache::List().
+        std::vector<std::future<std::vector<C2Component::Traits> const*>> pending;
         for (Cache& cache : Cache::List()) {
-            std::vector<C2Component::Traits> const& traits = cache.getTraits();
-            list.insert(list.end(), traits.begin(), traits.end());
+            pending.push_back(std::async(std::launch::async, [&cache]() {
+                return &cache.getTraits();
+            }));
+        }
+        std::vector<C2Component::Traits> list;
+        for (auto& future : pending) {
+            std::vector<C2Component::Traits> const* traits = future.get();
+            list.insert(list.end(), traits->begin(), traits->end());
         }
         return list;
     }()};
@@ -2160,19 +2172,26 @@ void Codec2Client::Component::handleOnWorkDone(
 
 c2_status_t Codec2Client::Component::queue(
         std::list<std::unique_ptr<C2Work>>* const items) {
+    ScopedTrace trace(ATRACE_TAG,"Codec2Client::Component::queue");
     if (mAidlBase) {
         c2_aidl::WorkBundle workBundle;
-        if (!c2_aidl::utils::ToAidl(&workBundle, *items, mAidlBufferPoolSender.get())) {
-            LOG(ERROR) << "queue -- bad input.";
-            return C2_TRANSACTION_FAILED;
+        {
+            ScopedTrace marshalTrace(ATRACE_TAG,"Codec2Client::Component::queue-marshal");
+            if (!c2_aidl::utils::ToAidl(&workBundle, *items, mAidlBufferPoolSender.get())) {
+                LOG(ERROR) << "queue -- bad input.";
+                return C2_TRANSACTION_FAILED;
+            }
         }
         ::ndk::ScopedAStatus transStatus = mAidlBase->queue(workBundle);
         return GetC2Status(transStatus, "queue");
     }
     c2_hidl::WorkBundle workBundle;
-    if (!c2_hidl::utils::objcpy(&workBundle, *items, mHidlBufferPoolSender.get())) {
-        LOG(ERROR) << "queue -- bad input.";
-        return C2_TRANSACTION_FAILED;
+    {
+        ScopedTrace marshalTrace(ATRACE_TAG,"Codec2Client::Component::queue-marshal");
+        if (!c2_hidl::utils::objcpy(&workBundle, *items, mHidlBufferPoolSender.get())) {
+            LOG(ERROR) << "queue -- bad input.";
+            return C2_TRANSACTION_FAILED;
+        }
     }
     Return<c2_hidl::Status> transStatus = mHidlBase1_0->queue(workBundle);
     if (!transStatus.isOk()) {
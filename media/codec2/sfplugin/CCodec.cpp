@@ -25,6 +25,7 @@
 
 #include <C2Config.h>
 #include <C2Debug.h>
+#include <C2LinearAllocationRecycler.h>
 #include <C2ParamInternal.h>
 #include <C2PlatformSupport.h>
 
@@ -816,6 +817,34 @@ void AmendOutputFormatWithCodecSpecificData(
     }
 }
 
+sp<AMessage> MakeChannelMetrics(const std::shared_ptr<CCodecBufferChannel> &channel) {
+    sp<AMessage> metrics = new AMessage;
+    LockStats::Snapshot outputLockStats = channel->getOutputLockStats();
+    if (outputLockStats.count > 0) {
+        const int64_t count = outputLockStats.count;
+        metrics->setInt64(kCodecOutputLockCount, count);
+        metrics->setInt64(kCodecOutputLockAvgWaitUs, outputLockStats.totalWaitUs / count);
+        metrics->setInt64(kCodecOutputLockMaxWaitUs, outputLockStats.maxWaitUs);
+        metrics->setInt64(kCodecOutputLockAvgHoldUs, outputLockStats.totalHoldUs / count);
+        metrics->setInt64(kCodecOutputLockMaxHoldUs, outputLockStats.maxHoldUs);
+    }
+    size_t numInputSlots = 0;
+    size_t inputCapacity = 0;
+    if (channel->getAdaptiveInputSizes(&numInputSlots, &inputCapacity)) {
+        metrics->setInt32(kCodecInputSlots, numInputSlots);
+        metrics->setInt64(kCodecInputBufferCapacity, inputCapacity);
+    }
+    std::shared_ptr<C2LinearAllocationRecycler> recycler =
+            C2LinearAllocationRecycler::GetInstance();
+    if (recycler->enabled()) {
+        C2LinearAllocationRecycler::Stats recyclerStats = recycler->getStats();
+        metrics->setInt64(kCodecLinearRecyclerHits, recyclerStats.hits);
+        metrics->setInt64(kCodecLinearRecyclerMisses, recyclerStats.misses);
+        metrics->setInt64(kCodecLinearRecyclerEvictions, recyclerStats.evictions);
+    }
+    return metrics;
+}
+
 }  // namespace
 
 // CCodec::ClientListener
@@ -932,6 +961,10 @@ public:
         mCodec->mCallback->onFirstTunnelFrameReady();
     }
 
+    void onInputBatchStarted(int64_t maxLatencyUs) override {
+        (new AMessage(CCodec::kWhatFlushInputBatch, mCodec))->post(maxLatencyUs);
+    }
+
 private:
     CCodec *mCodec;
 };
@@ -1130,6 +1163,18 @@ void CCodec::configure(const sp<AMessage> &msg) {
                         config->mTunneled = true;
                     }
 
+                    // low latency clients may ask for frames to be rendered as soon as
+                    // they are decoded, without releasing each buffer for rendering
+                    int32_t lowLatency = 0;
+                    int32_t renderImmediately = 0;
+                    if (!config->mTunneled
+                            && msg->findInt32(KEY_LOW_LATENCY, &lowLatency) && lowLatency != 0
+                            && msg->findInt32(KEY_RENDER_IMMEDIATELY, &renderImmediately)
+                            && renderImmediately != 0) {
+                        ALOGI("Configuring video output to render immediately.");
+                        config->mRenderImmediately = true;
+                    }
+
                     int32_t pushBlankBuffersOnStop = 0;
                     if (msg->findInt32(KEY_PUSH_BLANK_BUFFERS_ON_STOP, &pushBlankBuffersOnStop)) {
                         config->mPushBlankBuffersOnStop = pushBlankBuffersOnStop == 1;
@@ -1763,6 +1808,9 @@ void CCodec::configure(const sp<AMessage> &msg) {
         if (config->mTunneled) {
             config->mOutputFormat->setInt32("android._tunneled", 1);
         }
+        if (config->mRenderImmediately) {
+            config->mOutputFormat->setInt32("android._render-immediately", 1);
+        }
 
         // Convert an encoding statistics level to corresponding encoding statistics
         // kinds
@@ -2266,6 +2314,10 @@ void CCodec::stop(bool pushBlankBuffer) {
             config->mInputSurfaceDataspace = HAL_DATASPACE_UNKNOWN;
         }
     }
+    sp<AMessage> channelMetrics = MakeChannelMetrics(mChannel);
+    if (channelMetrics->countEntries() > 0) {
+        mCallback->onMetricsUpdated(channelMetrics);
+    }
     {
         Mutexed<State>::Locked state(mState);
         if (state->get() == STOPPING) {
@@ -2363,6 +2415,10 @@ void CCodec::release(bool sendCallback, bool pushBlankBuffer) {
         comp->release();
     }
 
+    sp<AMessage> channelMetrics = MakeChannelMetrics(mChannel);
+    if (channelMetrics->countEntries() > 0) {
+        mCallback->onMetricsUpdated(channelMetrics);
+    }
     {
         Mutexed<State>::Locked state(mState);
         state->set(RELEASED);
@@ -2922,6 +2978,10 @@ void CCodec::onMessageReceived(const sp<AMessage> &msg) {
             // watch message already posted; no-op.
             break;
         }
+        case kWhatFlushInputBatch: {
+            mChannel->flushInputBatch();
+            break;
+        }
         default: {
             ALOGE("unrecognized message");
             break;
@@ -36,6 +36,7 @@
 #include <C2BlockInternal.h>
 #include <C2Config.h>
 #include <C2Debug.h>
+#include <C2LinearAllocationRecycler.h>
 
 #include <android/hardware/cas/native/1.0/IDescrambler.h>
 #include <android/hardware/drm/1.0/types.h>
@@ -91,12 +92,31 @@ const static size_t kDequeueTimeoutNs = 0;
 // This value is to monitor if decoding is paused then we can signal a new empty work to HAL
 // after app resume to foreground to notify HAL something
 const static uint64_t kPipelinePausedTimeoutMs = 500;
+// Input works queued to the component in one call at most, when batching input, and upper bound
+// of the media_native.ccodec_input_batch_max_latency_us flag.
+constexpr size_t kMaxInputBatchSize = 8;
+constexpr int64_t kMaxInputBatchLatencyUs = 100000;
+
+// Upper bound of the media_native.ccodec_linear_recycler_max_kb flag.
+constexpr uint64_t kMaxLinearRecyclerKb = 256 * 1024;
 
 static bool areRenderMetricsEnabled() {
     std::string v = GetServerConfigurableFlag("media_native", "render_metrics_enabled", "false");
     return v == "true";
 }
 
+static bool isAdaptiveInputSizingEnabled() {
+    std::string v = GetServerConfigurableFlag(
+            "media_native", "ccodec_adaptive_input_buffers", "false");
+    return v == "true";
+}
+
+static bool isInputPrefetchEnabled() {
+    std::string v = GetServerConfigurableFlag(
+            "media_native", "ccodec_prefetch_input_blocks", "false");
+    return v == "true";
+}
+
 // Flags can come with individual BufferInfos
 // when used with large frame audio
 constexpr static std::initializer_list<std::pair<uint32_t, uint32_t>> flagList = {
@@ -175,7 +195,7 @@ void CCodecBufferChannel::QueueSync::stop() {
 
 // Input
 
-CCodecBufferChannel::Input::Input() : extraBuffers("extra") {}
+CCodecBufferChannel::Input::Input() : extraBuffers("extra"), adaptive(false) {}
 
 // CCodecBufferChannel
 
@@ -183,6 +203,7 @@ CCodecBufferChannel::CCodecBufferChannel(
         const std::shared_ptr<CCodecCallback> &callback)
     : mHeapSeqNum(-1),
       mCCodecCallback(callback),
+      mOutputPending(false),
       mFrameIndex(0u),
       mFirstValidFrameIndex(0u),
       mAreRenderMetricsEnabled(areRenderMetricsEnabled()),
@@ -190,10 +211,12 @@ CCodecBufferChannel::CCodecBufferChannel(
       mHasPresentFenceTimes(false),
       mRenderingDepth(3u),
       mMetaMode(MODE_NONE),
+      mInputBatchMaxLatencyUs(0),
       mInputMetEos(false),
       mLastInputBufferAvailableTs(0u),
       mIsHWDecoder(false),
-      mSendEncryptedInfoBuffer(false) {
+      mSendEncryptedInfoBuffer(false),
+      mRenderImmediately(false) {
     {
         Mutexed<Input>::Locked input(mInput);
         input->buffers.reset(new DummyInputBuffers(""));
@@ -296,6 +319,11 @@ status_t CCodecBufferChannel::queueInputBufferInternal(
     if (buffer->size() > 0u) {
         Mutexed<Input>::Locked input(mInput);
         std::shared_ptr<C2Buffer> c2buffer;
+        if (input->adaptive) {
+            input->sizer.onBufferQueued(input->buffers->numActiveSlots(), buffer->size());
+            input->numSlots = input->sizer.numSlots();
+            input->buffers->setLinearCapacity(input->sizer.capacity());
+        }
         if (!input->buffers->releaseBuffer(buffer, &c2buffer, false)) {
             return -ENOENT;
         }
@@ -318,7 +346,7 @@ status_t CCodecBufferChannel::queueInputBufferInternal(
         }
         if (input->frameReassembler) {
             usesFrameReassembler = true;
-            input->frameReassembler.process(buffer, &items);
+            input->frameReassembler.process(buffer, c2buffer, &items);
         } else {
             int32_t cvo = 0;
             if (buffer->meta()->findInt32("cvo", &cvo)) {
@@ -421,26 +449,13 @@ status_t CCodecBufferChannel::queueInputBufferInternal(
     }
     c2_status_t err = C2_OK;
     if (!items.empty()) {
-        ScopedTrace trace(ATRACE_TAG, android::base::StringPrintf(
-                "CCodecBufferChannel::queue(%s@ts=%lld)", mName, (long long)timeUs).c_str());
-        {
-            Mutexed<PipelineWatcher>::Locked watcher(mPipelineWatcher);
-            PipelineWatcher::Clock::time_point now = PipelineWatcher::Clock::now();
-            for (const std::unique_ptr<C2Work> &work : items) {
-                watcher->onWorkQueued(
-                        work->input.ordinal.frameIndex.peeku(),
-                        std::vector(work->input.buffers),
-                        now);
-            }
-        }
-        err = mComponent->queue(&items);
+        // Queue codec config, EOS and the first tunneled frame right away, along with any
+        // works held back before them.
+        const bool batch = mInputBatchMaxLatencyUs > 0 && !eos && !tunnelFirstFrame
+                && (flags & C2FrameData::FLAG_CODEC_CONFIG) == 0;
+        err = queueInputWorks(&items, batch);
     }
-    if (err != C2_OK) {
-        Mutexed<PipelineWatcher>::Locked watcher(mPipelineWatcher);
-        for (const std::unique_ptr<C2Work> &work : items) {
-            watcher->onWorkDone(work->input.ordinal.frameIndex.peeku());
-        }
-    } else {
+    if (err == C2_OK) {
         Mutexed<Input>::Locked input(mInput);
         bool released = false;
         if (copy) {
@@ -1057,6 +1072,72 @@ status_t CCodecBufferChannel::queueSecureInputBuffers(
     return queueInputBufferInternal(buffer, block, bufferSize);
 }
 
+c2_status_t CCodecBufferChannel::queueInputWorks(
+        std::list<std::unique_ptr<C2Work>> *items, bool batch) {
+    Mutexed<InputBatch>::Locked inputBatch(mInputBatch);
+    const bool started = inputBatch->items.empty();
+    if (started) {
+        inputBatch->firstQueued = PipelineWatcher::Clock::now();
+    }
+    inputBatch->items.splice(inputBatch->items.end(), *items);
+    if (batch) {
+        const int64_t maxLatencyUs = mInputBatchMaxLatencyUs;
+        const PipelineWatcher::Clock::duration age =
+                PipelineWatcher::Clock::now() - inputBatch->firstQueued;
+        if (inputBatch->items.size() < kMaxInputBatchSize
+                && age < std::chrono::microseconds(maxLatencyUs)) {
+            if (started) {
+                mCCodecCallback->onInputBatchStarted(maxLatencyUs);
+            }
+            return C2_OK;
+        }
+    }
+    return queueInputBatch_l(&inputBatch->items);
+}
+
+c2_status_t CCodecBufferChannel::queueInputBatch_l(std::list<std::unique_ptr<C2Work>> *items) {
+    if (items->empty()) {
+        return C2_OK;
+    }
+    std::list<std::unique_ptr<C2Work>> works;
+    works.swap(*items);
+    ScopedTrace trace(ATRACE_TAG, android::base::StringPrintf(
+            "CCodecBufferChannel::queue(%s@ts=%lld, %zu works)", mName,
+            (long long)works.back()->input.ordinal.timestamp.peekll(), works.size()).c_str());
+    {
+        Mutexed<PipelineWatcher>::Locked watcher(mPipelineWatcher);
+        PipelineWatcher::Clock::time_point now = PipelineWatcher::Clock::now();
+        for (const std::unique_ptr<C2Work> &work : works) {
+            watcher->onWorkQueued(
+                    work->input.ordinal.frameIndex.peeku(),
+                    std::vector(work->input.buffers),
+                    now);
+        }
+    }
+    c2_status_t err = mComponent->queue(&works);
+    if (err != C2_OK) {
+        Mutexed<PipelineWatcher>::Locked watcher(mPipelineWatcher);
+        for (const std::unique_ptr<C2Work> &work : works) {
+            watcher->onWorkDone(work->input.ordinal.frameIndex.peeku());
+        }
+    }
+    return err;
+}
+
+void CCodecBufferChannel::flushInputBatch() {
+    QueueGuard guard(mSync);
+    if (!guard.isRunning()) {
+        ALOGV("[%s] flushInputBatch: not running", mName);
+        return;
+    }
+    c2_status_t err = queueInputBatch_l(&mInputBatch.lock()->items);
+    if (err != C2_OK) {
+        ALOGE("[%s] flushInputBatch: queue failed: %d", mName, err);
+        mCCodecCallback->onError(toStatusT(err, C2_OPERATION_Component_queue),
+                                 ACTION_CODE_FATAL);
+    }
+}
+
 void CCodecBufferChannel::queueDummyWork() {
     std::unique_ptr<C2Work> work(new C2Work);
     // WA: signal a empty work to HAL to trigger specific event, but totally drop the work
@@ -1095,7 +1176,9 @@ void CCodecBufferChannel::feedInputBufferIfAvailableInternal() {
         return;
     }
     {
+        LockStats::Clock::time_point requested = LockStats::Clock::now();
         Mutexed<Output>::Locked output(mOutput);
+        LockStats::Scope lockScope(&mOutputLockStats, requested);
         if (!output->buffers ||
                 output->buffers->hasPending() ||
                 (!output->bounded && output->buffers->numActiveSlots() >= output->numSlots)) {
@@ -1116,6 +1199,16 @@ void CCodecBufferChannel::feedInputBufferIfAvailableInternal() {
             Mutexed<Input>::Locked input(mInput);
             numActiveSlots = input->buffers->numActiveSlots();
             if (numActiveSlots >= input->numSlots) {
+                if (input->adaptive) {
+                    // The pipeline could take more work, but all input slots are in use.
+                    input->sizer.onSlotsExhausted();
+                    if (input->sizer.numSlots() > input->numSlots) {
+                        ALOGV("[%s] growing input slots to %zu",
+                              mName, input->sizer.numSlots());
+                        input->numSlots = input->sizer.numSlots();
+                        continue;
+                    }
+                }
                 break;
             }
 
@@ -1157,15 +1250,21 @@ status_t CCodecBufferChannel::renderOutputBuffer(
     ALOGV("[%s] renderOutputBuffer: %p", mName, buffer.get());
     std::shared_ptr<C2Buffer> c2Buffer;
     bool released = false;
+    bool outputPending = false;
     {
+        LockStats::Clock::time_point requested = LockStats::Clock::now();
         Mutexed<Output>::Locked output(mOutput);
+        LockStats::Scope lockScope(&mOutputLockStats, requested);
         if (output->buffers) {
             released = output->buffers->releaseBuffer(buffer, &c2Buffer);
         }
+        outputPending = mOutputPending;
     }
     // NOTE: some apps try to releaseOutputBuffer() with timestamp and/or render
     //       set to true.
-    sendOutputBuffers();
+    if (outputPending) {
+        sendOutputBuffers();
+    }
     // input buffer feeding may have been gated by pending output buffers
     feedInputBufferIfAvailable();
     if (!c2Buffer) {
@@ -1179,7 +1278,13 @@ status_t CCodecBufferChannel::renderOutputBuffer(
         }
         return INVALID_OPERATION;
     }
+    return queueToOutputSurface(buffer, c2Buffer, timestampNs);
+}
 
+status_t CCodecBufferChannel::queueToOutputSurface(
+        const sp<MediaCodecBuffer> &buffer,
+        const std::shared_ptr<C2Buffer> &c2Buffer,
+        int64_t timestampNs) {
 #if 0
     const std::vector<std::shared_ptr<const C2Info>> infoParams = c2Buffer->info();
     ALOGV("[%s] queuing gfx buffer with %zu infos", mName, infoParams.size());
@@ -1536,14 +1641,20 @@ status_t CCodecBufferChannel::discardBuffer(const sp<MediaCodecBuffer> &buffer)
             released = true;
         }
     }
+    bool outputPending = false;
     {
+        LockStats::Clock::time_point requested = LockStats::Clock::now();
         Mutexed<Output>::Locked output(mOutput);
+        LockStats::Scope lockScope(&mOutputLockStats, requested);
         if (output->buffers && output->buffers->releaseBuffer(buffer, nullptr)) {
             released = true;
         }
+        outputPending = mOutputPending;
     }
     if (released) {
-        sendOutputBuffers();
+        if (outputPending) {
+            sendOutputBuffers();
+        }
         feedInputBufferIfAvailable();
     } else {
         ALOGD("[%s] MediaCodec discarded an unknown buffer", mName);
@@ -1560,6 +1671,9 @@ void CCodecBufferChannel::getInputBufferArray(Vector<sp<MediaCodecBuffer>> *arra
         return;
     }
     if (!input->buffers->isArrayMode()) {
+        // The array keeps its size and buffers from now on.
+        input->adaptive = false;
+        input->buffers->setLinearCapacity(0);
         input->buffers = input->buffers->toArrayMode(input->numSlots);
     }
 
@@ -1797,6 +1911,21 @@ status_t CCodecBufferChannel::start(
         if (forceArrayMode) {
             input->buffers = input->buffers->toArrayMode(numInputSlots);
         }
+
+        input->adaptive = !mInputSurface && !input->buffers->isArrayMode()
+                && isAdaptiveInputSizingEnabled();
+        if (input->adaptive) {
+            int32_t maxInputSize = kLinearBufferSize;
+            (void)inputFormat->findInt32(KEY_MAX_INPUT_SIZE, &maxInputSize);
+            input->sizer.reset(
+                    numInputSlots,
+                    std::min((size_t)std::max(maxInputSize, 0), kMaxLinearBufferSize));
+        }
+        // Let the pool allocate the first input buffers in the background, instead of on
+        // the first requests after start.
+        if (!mInputSurface && isInputPrefetchEnabled()) {
+            input->buffers->prefetch(numInputSlots);
+        }
     }
 
     if (outputFormat != nullptr) {
@@ -1942,6 +2071,7 @@ status_t CCodecBufferChannel::start(
         output->buffers->setFormat(outputFormat);
 
         output->buffers->clearStash();
+        mOutputPending = false;
         if (reorderDepth) {
             output->buffers->setReorderDepth(reorderDepth.value);
         }
@@ -2006,6 +2136,14 @@ status_t CCodecBufferChannel::start(
             tunneled = 0;
         }
         mTunneled = (tunneled != 0);
+
+        int32_t renderImmediately = 0;
+        if (!outputFormat->findInt32("android._render-immediately", &renderImmediately)) {
+            renderImmediately = 0;
+        }
+        std::lock_guard<std::mutex> renderLock(mRenderImmediatelyLock);
+        mRenderImmediately = (renderImmediately != 0) && !mTunneled;
+        mRenderImmediatelyFormat.clear();
     }
 
     // Set up pipeline control. This has to be done after mInputBuffers and
@@ -2023,6 +2161,30 @@ status_t CCodecBufferChannel::start(
         watcher->flush();
     }
 
+    // Batch input works unless the input is paced by an input surface or by the
+    // tunneled renderer.
+    int64_t inputBatchMaxLatencyUs = 0;
+    if (mInputSurface == nullptr && !mTunneled) {
+        std::string value = GetServerConfigurableFlag(
+                "media_native", "ccodec_input_batch_max_latency_us", "0");
+        if (!android::base::ParseInt(value, &inputBatchMaxLatencyUs, int64_t(0),
+                                     kMaxInputBatchLatencyUs)) {
+            inputBatchMaxLatencyUs = 0;
+        }
+    }
+    mInputBatchMaxLatencyUs = inputBatchMaxLatencyUs;
+    mOutputLockStats.reset();
+
+    // Linear blocks from the basic pool are reused across codec instances of
+    // this process, up to this size.
+    uint64_t recyclerMaxKb = 0;
+    if (!android::base::ParseUint(
+            GetServerConfigurableFlag("media_native", "ccodec_linear_recycler_max_kb", "0"),
+            &recyclerMaxKb, kMaxLinearRecyclerKb)) {
+        recyclerMaxKb = 0;
+    }
+    C2LinearAllocationRecycler::GetInstance()->setMaxBytes(recyclerMaxKb * 1024);
+
     mInputMetEos = false;
     mSync.start();
     return OK;
@@ -2139,6 +2301,8 @@ status_t CCodecBufferChannel::requestInitialInputBuffers(
 
 void CCodecBufferChannel::stop() {
     mSync.stop();
+    // Works held back are dropped, as the component would have flushed them.
+    mInputBatch.lock()->items.clear();
     mFirstValidFrameIndex = mFrameIndex.load(std::memory_order_relaxed);
     mInfoBuffers.clear();
 }
@@ -2466,6 +2630,9 @@ bool CCodecBufferChannel::handleWork(
             }
             ALOGV("[%s] onWorkDone: updated number of extra slots to %zu (input array mode)",
                   mName, input->numExtraSlots);
+        } else if (input->adaptive) {
+            input->sizer.setBaseSlots(newNumSlots);
+            input->numSlots = input->sizer.numSlots();
         } else {
             input->numSlots = newNumSlots;
         }
@@ -2628,7 +2795,9 @@ bool CCodecBufferChannel::handleWork(
     }
 
     {
+        LockStats::Clock::time_point requested = LockStats::Clock::now();
         Mutexed<Output>::Locked output(mOutput);
+        LockStats::Scope lockScope(&mOutputLockStats, requested);
         if (!output->buffers) {
             return false;
         }
@@ -2639,6 +2808,7 @@ bool CCodecBufferChannel::handleWork(
                 flags,
                 outputFormat,
                 worklet->output.ordinal);
+        mOutputPending = true;
     }
     sendOutputBuffers();
     return true;
@@ -2653,8 +2823,17 @@ void CCodecBufferChannel::sendOutputBuffers() {
     constexpr int kMaxReallocTry = 5;
     int reallocTryNum = 0;
 
+    // When rendering immediately, buffers are queued to the surface outside the Output lock;
+    // serialize the callers so that frames still reach the surface in order.
+    std::unique_lock<std::mutex> renderLock(mRenderImmediatelyLock, std::defer_lock);
+    if (mRenderImmediately) {
+        renderLock.lock();
+    }
+
     while (true) {
+        LockStats::Clock::time_point requested = LockStats::Clock::now();
         Mutexed<Output>::Locked output(mOutput);
+        LockStats::Scope lockScope(&mOutputLockStats, requested);
         if (!output->buffers) {
             return;
         }
@@ -2665,11 +2844,25 @@ void CCodecBufferChannel::sendOutputBuffers() {
         }
         switch (action) {
         case OutputBuffers::SKIP:
+            // Nothing is left to send until the next pushToStash().
+            mOutputPending = false;
             return;
         case OutputBuffers::DISCARD:
             break;
         case OutputBuffers::NOTIFY_CLIENT:
         {
+            if (renderLock.owns_lock() && shouldRenderImmediately(outBuffer, c2Buffer)) {
+                // Skip the round trip through the client and render the frame right away.
+                std::shared_ptr<C2Buffer> renderBuffer;
+                (void)output->buffers->releaseBuffer(outBuffer, &renderBuffer);
+                lockScope.release();
+                output.unlock();
+                if (renderBuffer) {
+                    (void)queueToOutputSurface(
+                            outBuffer, renderBuffer, systemTime(SYSTEM_TIME_MONOTONIC));
+                }
+                break;
+            }
             // TRICKY: we want popped buffers reported in order, so sending
             // the callback while holding the lock here. This assumes that
             // onOutputBufferAvailable() does not block. onOutputBufferAvailable()
@@ -2694,11 +2887,14 @@ void CCodecBufferChannel::sendOutputBuffers() {
                     outBuffer->meta()->setObject("accessUnitInfo", obj);
                 }
             }
+            // lets MediaCodec tell codec processing apart from delivery to the client
+            outBuffer->meta()->setInt64("codecOutputNs", systemTime(SYSTEM_TIME_MONOTONIC));
             mCallback->onOutputBufferAvailable(index, outBuffer);
             break;
         }
         case OutputBuffers::REALLOCATE:
             if (++reallocTryNum > kMaxReallocTry) {
+                lockScope.release();
                 output.unlock();
                 ALOGE("[%s] sendOutputBuffers: tried %d realloc and failed",
                           mName, kMaxReallocTry);
@@ -2711,6 +2907,7 @@ void CCodecBufferChannel::sendOutputBuffers() {
             }
             static_cast<OutputBuffersArray*>(output->buffers.get())->
                     realloc(c2Buffer);
+            lockScope.release();
             output.unlock();
             mCCodecCallback->onOutputBuffersChanged();
             break;
@@ -2728,6 +2925,25 @@ void CCodecBufferChannel::sendOutputBuffers() {
     }
 }
 
+bool CCodecBufferChannel::shouldRenderImmediately(
+        const sp<MediaCodecBuffer> &buffer, const std::shared_ptr<C2Buffer> &c2Buffer) {
+    if (!c2Buffer || c2Buffer->data().type() != C2BufferData::GRAPHIC) {
+        return false;
+    }
+    int32_t flags = 0;
+    (void)buffer->meta()->findInt32("flags", &flags);
+    if (flags & (BUFFER_FLAG_END_OF_STREAM | BUFFER_FLAG_CODEC_CONFIG)) {
+        return false;
+    }
+    // The client learns about format changes through output buffers, so hand it the first
+    // buffer of every new format.
+    if (buffer->format() != mRenderImmediatelyFormat) {
+        mRenderImmediatelyFormat = buffer->format();
+        return false;
+    }
+    return true;
+}
+
 status_t CCodecBufferChannel::setSurface(const sp<Surface> &newSurface,
                                          uint32_t generation, bool pushBlankBuffer) {
     sp<IGraphicBufferProducer> producer;
@@ -2846,6 +3062,20 @@ uint32_t CCodecBufferChannel::getOutputBuffersPixelFormat() {
     return output->buffers->getPixelFormatIfApplicable();
 }
 
+LockStats::Snapshot CCodecBufferChannel::getOutputLockStats() const {
+    return mOutputLockStats.snapshot();
+}
+
+bool CCodecBufferChannel::getAdaptiveInputSizes(size_t *numSlots, size_t *capacity) {
+    Mutexed<Input>::Locked input(mInput);
+    if (!input->adaptive) {
+        return false;
+    }
+    *numSlots = input->sizer.numSlots();
+    *capacity = input->sizer.capacity();
+    return true;
+}
+
 void CCodecBufferChannel::resetBuffersPixelFormat(bool isEncoder) {
     if (isEncoder) {
         Mutexed<Input>::Locked input(mInput);
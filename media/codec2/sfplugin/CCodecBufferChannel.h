@@ -34,7 +34,9 @@
 
 #include "CCodecBuffers.h"
 #include "FrameReassembler.h"
+#include "InputSizer.h"
 #include "InputSurfaceWrapper.h"
+#include "LockStats.h"
 #include "PipelineWatcher.h"
 
 namespace android {
@@ -48,6 +50,9 @@ public:
     virtual void onOutputFramesRendered(int64_t mediaTimeUs, nsecs_t renderTimeNs) = 0;
     virtual void onOutputBuffersChanged() = 0;
     virtual void onFirstTunnelFrameReady() = 0;
+    // Input works are held back to be queued together; CCodecBufferChannel::flushInputBatch()
+    // must be called within |maxLatencyUs|.
+    virtual void onInputBatchStarted(int64_t maxLatencyUs) = 0;
 };
 
 /**
@@ -210,6 +215,11 @@ public:
      */
     void onInputBufferDone(uint64_t frameIndex, size_t arrayIndex);
 
+    /**
+     * Queue the input works held back for batching to the component.
+     */
+    void flushInputBatch();
+
     PipelineWatcher::Clock::duration elapsed();
 
     enum MetaMode {
@@ -228,6 +238,19 @@ public:
 
     void resetBuffersPixelFormat(bool isEncoder);
 
+    /**
+     * Get the wait and hold times of the output lock since start().
+     */
+    LockStats::Snapshot getOutputLockStats() const;
+
+    /**
+     * Get the number of input slots and the capacity of linear input buffers
+     * chosen by the adaptive input sizing.
+     *
+     * @return false if adaptive input sizing is not in use.
+     */
+    bool getAdaptiveInputSizes(size_t *numSlots, size_t *capacity);
+
     /**
      * Queue a C2 info buffer that will be sent to codec in the subsequent
      * queueInputBuffer
@@ -308,6 +331,10 @@ private:
     void feedInputBufferIfAvailable();
     void feedInputBufferIfAvailableInternal();
     void queueDummyWork();
+    // Queues |items| to the component, or holds them back with the works already held back
+    // if |batch| is true and the batch is neither full nor too old.
+    c2_status_t queueInputWorks(std::list<std::unique_ptr<C2Work>> *items, bool batch);
+    c2_status_t queueInputBatch_l(std::list<std::unique_ptr<C2Work>> *items);
     status_t queueInputBufferInternal(sp<MediaCodecBuffer> buffer,
                                       std::shared_ptr<C2LinearBlock> encryptedBlock = nullptr,
                                       size_t blockSize = 0);
@@ -315,6 +342,12 @@ private:
             std::unique_ptr<C2Work> work, const sp<AMessage> &outputFormat,
             const C2StreamInitDataInfo::output *initData);
     void sendOutputBuffers();
+    bool shouldRenderImmediately(
+            const sp<MediaCodecBuffer> &buffer, const std::shared_ptr<C2Buffer> &c2Buffer);
+    status_t queueToOutputSurface(
+            const sp<MediaCodecBuffer> &buffer,
+            const std::shared_ptr<C2Buffer> &c2Buffer,
+            int64_t timestampNs);
     void ensureDecryptDestination(size_t size);
     int32_t getHeapSeqNum(const sp<hardware::HidlMemory> &memory);
 
@@ -351,6 +384,10 @@ private:
         c2_cntr64_t lastFlushIndex;
 
         FrameReassembler frameReassembler;
+
+        // If true, numSlots and the capacity of linear buffers follow sizer.
+        bool adaptive;
+        InputSizer sizer;
     };
     Mutexed<Input> mInput;
     struct Output {
@@ -362,6 +399,11 @@ private:
         bool bounded;
     };
     Mutexed<Output> mOutput;
+    LockStats mOutputLockStats;
+    // false iff the output stash had nothing to send the last time it was checked, in which
+    // case releasing an output buffer does not need to call sendOutputBuffers(). Only written
+    // with mOutput locked.
+    std::atomic_bool mOutputPending;
     Mutexed<std::list<std::unique_ptr<C2Work>>> mFlushedConfigs;
 
     std::atomic_uint64_t mFrameIndex;
@@ -398,6 +440,15 @@ private:
 
     Mutexed<PipelineWatcher> mPipelineWatcher;
 
+    // Input works not yet queued to the component, so that several works are queued in one
+    // call. Disabled if mInputBatchMaxLatencyUs is 0.
+    struct InputBatch {
+        std::list<std::unique_ptr<C2Work>> items;
+        PipelineWatcher::Clock::time_point firstQueued;
+    };
+    Mutexed<InputBatch> mInputBatch;
+    std::atomic_int64_t mInputBatchMaxLatencyUs;
+
     std::atomic_bool mInputMetEos;
     std::once_flag mRenderWarningFlag;
 
@@ -415,6 +466,12 @@ private:
 
     std::atomic_bool mTunneled;
 
+    // Low latency mode where output frames are queued to the surface as soon as they are
+    // available instead of waiting for the client to release them for rendering.
+    std::atomic_bool mRenderImmediately;
+    std::mutex mRenderImmediatelyLock;
+    sp<AMessage> mRenderImmediatelyFormat;  // guarded by mRenderImmediatelyLock
+
     std::vector<std::shared_ptr<C2InfoBuffer>> mInfoBuffers;
 };
 
@@ -1052,7 +1052,7 @@ std::unique_ptr<InputBuffers> LinearInputBuffers::toArrayMode(size_t size) {
             mImpl,
             size,
             [pool = mPool, format = mFormat] () -> sp<Codec2Buffer> {
-                return Alloc(pool, format);
+                return Alloc(pool, format, 0);
             });
     return std::move(array);
 }
@@ -1065,19 +1065,48 @@ size_t LinearInputBuffers::numClientBuffers() const {
     return mImpl.numClientBuffers();
 }
 
+void LinearInputBuffers::setLinearCapacity(size_t capacity) {
+    mCapacity = capacity;
+}
+
+void LinearInputBuffers::prefetch(size_t count) {
+    if (!mPool || mFormat == nullptr) {
+        return;
+    }
+    uint32_t capacity;
+    C2MemoryUsage usage;
+    GetAllocParams(mFormat, mCapacity, &capacity, &usage);
+    c2_status_t err = PrefetchCodec2LinearBlocks(mPool, capacity, usage, count);
+    ALOGV("[%s] prefetch %zu blocks of %u bytes: %d", mName, count, capacity, err);
+}
+
 // static
-sp<Codec2Buffer> LinearInputBuffers::Alloc(
-        const std::shared_ptr<C2BlockPool> &pool, const sp<AMessage> &format) {
-    int32_t capacity = kLinearBufferSize;
-    (void)format->findInt32(KEY_MAX_INPUT_SIZE, &capacity);
-    if ((size_t)capacity > kMaxLinearBufferSize) {
-        ALOGD("client requested %d, capped to %zu", capacity, kMaxLinearBufferSize);
-        capacity = kMaxLinearBufferSize;
+void LinearInputBuffers::GetAllocParams(
+        const sp<AMessage> &format, size_t requestedCapacity,
+        uint32_t *capacity, C2MemoryUsage *usage) {
+    int32_t maxCapacity = kLinearBufferSize;
+    (void)format->findInt32(KEY_MAX_INPUT_SIZE, &maxCapacity);
+    if ((size_t)maxCapacity > kMaxLinearBufferSize) {
+        ALOGD("client requested %d, capped to %zu", maxCapacity, kMaxLinearBufferSize);
+        maxCapacity = kMaxLinearBufferSize;
+    }
+    if (requestedCapacity > 0 && requestedCapacity < (size_t)maxCapacity) {
+        maxCapacity = (int32_t)requestedCapacity;
     }
+    *capacity = maxCapacity;
 
     int64_t usageValue = 0;
     (void)format->findInt64("android._C2MemoryUsage", &usageValue);
-    C2MemoryUsage usage{usageValue | C2MemoryUsage::CPU_READ | C2MemoryUsage::CPU_WRITE};
+    *usage = C2MemoryUsage{usageValue | C2MemoryUsage::CPU_READ | C2MemoryUsage::CPU_WRITE};
+}
+
+// static
+sp<Codec2Buffer> LinearInputBuffers::Alloc(
+        const std::shared_ptr<C2BlockPool> &pool, const sp<AMessage> &format,
+        size_t requestedCapacity) {
+    uint32_t capacity;
+    C2MemoryUsage usage;
+    GetAllocParams(format, requestedCapacity, &capacity, &usage);
     std::shared_ptr<C2LinearBlock> block;
 
     c2_status_t err = pool->fetchLinearBlock(capacity, usage, &block);
@@ -1089,7 +1118,7 @@ sp<Codec2Buffer> LinearInputBuffers::Alloc(
 }
 
 sp<Codec2Buffer> LinearInputBuffers::createNewBuffer() {
-    return Alloc(mPool, mFormat);
+    return Alloc(mPool, mFormat, mCapacity);
 }
 
 // EncryptedLinearInputBuffers
@@ -169,6 +169,19 @@ public:
      */
     virtual size_t numClientBuffers() const = 0;
 
+    /**
+     * Set the capacity of linear buffers created from now on; 0 to use the
+     * max input size of the format. Ignored by other kinds of input buffers.
+     */
+    virtual void setLinearCapacity(size_t capacity) { (void)capacity; }
+
+    /**
+     * Hint the pool that |count| buffers will be requested soon, so that it
+     * can allocate them ahead of time. Ignored by input buffers that do not
+     * allocate linear blocks from the pool.
+     */
+    virtual void prefetch(size_t count) { (void)count; }
+
 protected:
     virtual sp<Codec2Buffer> createNewBuffer() = 0;
 
@@ -857,7 +870,8 @@ class LinearInputBuffers : public InputBuffers {
 public:
     LinearInputBuffers(const char *componentName, const char *name = "1D-Input")
         : InputBuffers(componentName, name),
-          mImpl(mName) { }
+          mImpl(mName),
+          mCapacity(0) { }
     ~LinearInputBuffers() override = default;
 
     bool requestNewBuffer(size_t *index, sp<MediaCodecBuffer> *buffer) override;
@@ -878,14 +892,26 @@ public:
 
     size_t numClientBuffers() const final;
 
+    void setLinearCapacity(size_t capacity) override;
+
+    void prefetch(size_t count) override;
+
 protected:
     sp<Codec2Buffer> createNewBuffer() override;
 
     FlexBuffersImpl mImpl;
 
 private:
+    // Capacity of new buffers; 0 to use the max input size of the format.
+    size_t mCapacity;
+
+    static void GetAllocParams(
+            const sp<AMessage> &format, size_t requestedCapacity,
+            uint32_t *capacity, C2MemoryUsage *usage);
+
     static sp<Codec2Buffer> Alloc(
-            const std::shared_ptr<C2BlockPool> &pool, const sp<AMessage> &format);
+            const std::shared_ptr<C2BlockPool> &pool, const sp<AMessage> &format,
+            size_t capacity);
 };
 
 class EncryptedLinearInputBuffers : public LinearInputBuffers {
@@ -18,6 +18,8 @@
 #define LOG_TAG "CCodecConfig"
 
 #include <initializer_list>
+#include <map>
+#include <mutex>
 
 #include <android_media_codec.h>
 
@@ -26,6 +28,7 @@
 #include <utils/NativeHandle.h>
 
 #include <android-base/properties.h>
+#include <server_configurable_flags/get_flags.h>
 
 #include <C2Component.h>
 #include <C2Param.h>
@@ -231,6 +234,96 @@ AString QueryMediaType(
     }
 }
 
+bool isReflectionCacheEnabled() {
+    std::string v = server_configurable_flags::GetServerConfigurableFlag(
+            "media_native", "ccodec_cache_param_reflection", "false");
+    return v == "true";
+}
+
+/**
+ * Reflection data of a component, shared by all instances of the component in this process.
+ * querySupportedParams() and each C2ParamReflector::describe() call take a round trip to the
+ * component store, and their results only depend on the component.
+ */
+class ReflectionCache : public std::enable_shared_from_this<ReflectionCache> {
+public:
+    static std::shared_ptr<ReflectionCache> For(const std::string &componentName) {
+        static std::mutex sMutex;
+        static std::map<std::string, std::shared_ptr<ReflectionCache>> sCaches;
+        std::lock_guard<std::mutex> lock(sMutex);
+        std::shared_ptr<ReflectionCache> &cache = sCaches[componentName];
+        if (!cache) {
+            cache = std::make_shared<ReflectionCache>();
+        }
+        return cache;
+    }
+
+    c2_status_t querySupportedParams(
+            const std::shared_ptr<Codec2Client::Configurable> &configurable,
+            std::vector<std::shared_ptr<C2ParamDescriptor>> *params) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mParamDescsValid) {
+            std::vector<std::shared_ptr<C2ParamDescriptor>> descs;
+            c2_status_t err = configurable->querySupportedParams(&descs);
+            if (err != C2_OK) {
+                *params = std::move(descs);
+                return err;
+            }
+            mParamDescs = std::move(descs);
+            mParamDescsValid = true;
+        }
+        // descriptors are immutable, so they can be shared
+        *params = mParamDescs;
+        return C2_OK;
+    }
+
+    /**
+     * Returns a reflector that describes structures from this cache, and uses |reflector|
+     * for the ones that are not yet cached.
+     */
+    std::shared_ptr<C2ParamReflector> wrap(const std::shared_ptr<C2ParamReflector> &reflector) {
+        if (reflector == nullptr) {
+            return nullptr;
+        }
+        return std::make_shared<Reflector>(shared_from_this(), reflector);
+    }
+
+    ReflectionCache() = default;
+
+private:
+    struct Reflector : public C2ParamReflector {
+        Reflector(const std::shared_ptr<ReflectionCache> &cache,
+                  const std::shared_ptr<C2ParamReflector> &base)
+            : mCache(cache), mBase(base) { }
+
+        std::unique_ptr<C2StructDescriptor> describe(
+                C2Param::CoreIndex coreIndex) const override {
+            {
+                std::lock_guard<std::mutex> lock(mCache->mMutex);
+                auto it = mCache->mStructDescs.find(coreIndex.coreIndex());
+                if (it != mCache->mStructDescs.end()) {
+                    return std::make_unique<C2StructDescriptor>(*it->second);
+                }
+            }
+            std::unique_ptr<C2StructDescriptor> desc = mBase->describe(coreIndex);
+            if (desc) {
+                std::lock_guard<std::mutex> lock(mCache->mMutex);
+                mCache->mStructDescs.emplace(
+                        coreIndex.coreIndex(), std::make_unique<C2StructDescriptor>(*desc));
+            }
+            return desc;
+        }
+
+        const std::shared_ptr<ReflectionCache> mCache;
+        const std::shared_ptr<C2ParamReflector> mBase;
+    };
+
+    std::mutex mMutex;
+    bool mParamDescsValid{false};
+    std::vector<std::shared_ptr<C2ParamDescriptor>> mParamDescs;
+    std::map<uint32_t, std::unique_ptr<C2StructDescriptor>> mStructDescs;
+};
+
 }  // namespace
 
 /**
@@ -338,7 +431,8 @@ CCodecConfig::CCodecConfig()
       mOutputFormat(new AMessage),
       mUsingSurface(false),
       mTunneled(false),
-      mPushBlankBuffersOnStop(false) { }
+      mPushBlankBuffersOnStop(false),
+      mRenderImmediately(false) { }
 
 void CCodecConfig::initializeStandardParams() {
     typedef Domain D;
@@ -1109,7 +1203,13 @@ status_t CCodecConfig::initialize(
         mCodingMediaType = "";
     }
 
-    c2err = configurable->querySupportedParams(&mParamDescs);
+    std::shared_ptr<ReflectionCache> reflectionCache;
+    if (isReflectionCacheEnabled()) {
+        reflectionCache = ReflectionCache::For(configurable->getName());
+        c2err = reflectionCache->querySupportedParams(configurable, &mParamDescs);
+    } else {
+        c2err = configurable->querySupportedParams(&mParamDescs);
+    }
     if (c2err != C2_OK) {
         ALOGD("Query supported params failed after returning %zu values => %s",
                 mParamDescs.size(), asString(c2err));
@@ -1119,7 +1219,7 @@ status_t CCodecConfig::initialize(
         mSupportedIndices.emplace(desc->index());
     }
 
-    mReflector = reflector;
+    mReflector = reflectionCache ? reflectionCache->wrap(reflector) : reflector;
     if (mReflector == nullptr) {
         ALOGE("Null param reflector");
         return UNKNOWN_ERROR;
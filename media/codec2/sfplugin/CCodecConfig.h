@@ -150,6 +150,9 @@ struct CCodecConfig {
 
     bool mPushBlankBuffersOnStop;
 
+    /// Output frames are rendered as soon as they are available (low latency only)
+    bool mRenderImmediately;
+
     CCodecConfig();
 
     /// initializes the members required to manage the format: descriptors, reflector,
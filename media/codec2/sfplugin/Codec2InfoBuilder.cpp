@@ -43,6 +43,7 @@
 #include <android/hardware/media/omx/1.0/IOmxNode.h>
 #include <android/hardware/media/omx/1.0/types.h>
 
+#include <android-base/file.h>
 #include <android-base/properties.h>
 #include <codec2/hidl/client.h>
 #include <cutils/native_handle.h>
@@ -54,6 +55,9 @@
 #include <media/stagefright/Codec2InfoBuilder.h>
 #include <media/stagefright/MediaCodecConstants.h>
 
+#include <atomic>
+#include <future>
+
 namespace android {
 
 using Traits = C2Component::Traits;
@@ -394,8 +398,101 @@ Switch isDomainEnabled(
     return isSettingEnabled("domain-" + domain, settings);
 }
 
+/**
+ * Creates the interfaces of a list of components (and their aliases) on a few worker threads,
+ * so that the round trips to the component stores overlap each other and the parsing of the
+ * XML files. Interfaces are returned in any order through take(), which waits for all of them
+ * to be created.
+ */
+class InterfaceFetcher {
+public:
+    explicit InterfaceFetcher(const std::vector<Traits> &traits) {
+        for (const Traits &trait : traits) {
+            addName(trait.name);
+            for (const std::string &alias : trait.aliases) {
+                addName(alias);
+            }
+        }
+        size_t numWorkers = std::min(kMaxWorkers, mEntries.size());
+        for (size_t i = 0; i < numWorkers; ++i) {
+            mWorkers.push_back(std::async(std::launch::async, [this] { work(); }));
+        }
+    }
+
+    // Moves the interface created for |name| and its owner into |client|. Returns nullptr if
+    // the interface could not be created.
+    std::shared_ptr<Codec2Client::Interface> take(
+            const std::string &name, std::shared_ptr<Codec2Client> *client) {
+        for (std::future<void> &worker : mWorkers) {
+            worker.wait();
+        }
+        auto it = mIndices.find(name);
+        if (it == mIndices.end() || mEntries[it->second].taken) {
+            return Codec2Client::CreateInterfaceByName(name.c_str(), client);
+        }
+        Entry &entry = mEntries[it->second];
+        entry.taken = true;
+        *client = std::move(entry.client);
+        return std::move(entry.intf);
+    }
+
+private:
+    static constexpr size_t kMaxWorkers = 8;
+
+    struct Entry {
+        std::string name;
+        std::shared_ptr<Codec2Client> client;
+        std::shared_ptr<Codec2Client::Interface> intf;
+        bool taken;
+    };
+    std::vector<Entry> mEntries;
+    std::map<std::string, size_t> mIndices;
+    std::atomic_size_t mNext{0};
+    // must be declared last so that the workers are joined before the entries are destroyed
+    std::vector<std::future<void>> mWorkers;
+
+    void addName(const std::string &name) {
+        if (mIndices.emplace(name, mEntries.size()).second) {
+            mEntries.push_back({name, nullptr, nullptr, false});
+        }
+    }
+
+    void work() {
+        for (size_t i = mNext++; i < mEntries.size(); i = mNext++) {
+            Entry &entry = mEntries[i];
+            entry.intf = Codec2Client::CreateInterfaceByName(entry.name.c_str(), &entry.client);
+        }
+    }
+};
+
 } // unnamed namespace
 
+std::string Codec2InfoBuilder::getFingerprint() {
+    // Everything buildMediaCodecList() uses besides the build fingerprints: the run-time
+    // configuration, the components, and the mainline module XML files.
+    std::string fingerprint = "c2:";
+    fingerprint += std::to_string(base::GetIntProperty("debug.stagefright.ccodec", 4));
+    fingerprint += com::android::media::codec::flags::provider_->large_audio_frame() ? "1" : "0";
+    fingerprint += android::media::codec::provider_->large_audio_frame_finish() ? "1" : "0";
+    fingerprint += android::media::codec::provider_->null_output_surface_support() ? "1" : "0";
+    fingerprint += android::media::codec::provider_->null_output_surface() ? "1" : "0";
+    for (const char *apex : { "com.android.media.swcodec", "com.android.media" }) {
+        std::string manifest;
+        base::ReadFileToString(std::string("/apex/") + apex + "/apex_manifest.pb", &manifest);
+        fingerprint += ";" + std::string(apex) + "=";
+        fingerprint += std::to_string(std::hash<std::string>{}(manifest));
+    }
+    for (const Traits &trait : Codec2Client::ListComponents()) {
+        fingerprint += ";" + trait.name + "," + trait.owner + "," + trait.mediaType;
+        fingerprint += "," + std::to_string(trait.domain) + "," + std::to_string(trait.kind);
+        fingerprint += "," + std::to_string(trait.rank);
+        for (const std::string &alias : trait.aliases) {
+            fingerprint += "," + alias;
+        }
+    }
+    return fingerprint;
+}
+
 status_t Codec2InfoBuilder::buildMediaCodecList(MediaCodecListWriter* writer) {
     // TODO: Remove run-time configurations once all codecs are working
     // properly. (Assume "full" behavior eventually.)
@@ -430,6 +527,9 @@ status_t Codec2InfoBuilder::buildMediaCodecList(MediaCodecListWriter* writer) {
     // Obtain Codec2Client
     std::vector<Traits> traits = Codec2Client::ListComponents();
 
+    // Start creating the interfaces while the XML files are parsed.
+    InterfaceFetcher fetcher(traits);
+
     // parse APEX XML first, followed by vendor XML.
     // Note: APEX XML names do not depend on ro.media.xml_variant.* properties.
     MediaCodecsXmlParser parser;
@@ -526,8 +626,7 @@ status_t Codec2InfoBuilder::buildMediaCodecList(MediaCodecListWriter* writer) {
         for (const std::string &nameOrAlias : nameAndAliases) {
             bool isAlias = trait.name != nameOrAlias;
             std::shared_ptr<Codec2Client> client;
-            std::shared_ptr<Codec2Client::Interface> intf =
-                Codec2Client::CreateInterfaceByName(nameOrAlias.c_str(), &client);
+            std::shared_ptr<Codec2Client::Interface> intf = fetcher.take(nameOrAlias, &client);
             if (!intf) {
                 ALOGD("could not create interface for %s'%s'",
                         isAlias ? "alias " : "",
@@ -87,6 +87,14 @@ FrameReassembler::operator bool() const {
 c2_status_t FrameReassembler::process(
         const sp<MediaCodecBuffer> &buffer,
         std::list<std::unique_ptr<C2Work>> *items) {
+    return process(buffer, nullptr, items);
+}
+
+c2_status_t FrameReassembler::process(
+        const sp<MediaCodecBuffer> &buffer,
+        const std::shared_ptr<C2Buffer> &c2Buffer,
+        std::list<std::unique_ptr<C2Work>> *items) {
+    const size_t inputSize = buffer->size();
     int64_t timeUs;
     if (!buffer->meta()->findInt64("timeUs", &timeUs)) {
         return C2_BAD_VALUE;
@@ -146,6 +154,19 @@ c2_status_t FrameReassembler::process(
     }
 
     size_t frameSizeBytes = mFrameSize.value() * mChannelCount * bytesPerSample();
+    if (c2Buffer
+            && c2Buffer->data().type() == C2BufferData::LINEAR
+            && c2Buffer->data().linearBlocks().size() == 1u
+            && c2Buffer->data().linearBlocks().front().size() == inputSize) {
+        // The remaining data starts on a frame boundary: pass whole frames through.
+        const C2ConstLinearBlock &block = c2Buffer->data().linearBlocks().front();
+        while (!mCurrentBlock && buffer->size() >= frameSizeBytes) {
+            addWork(C2Buffer::CreateLinearBuffer(
+                    block.subBlock(inputSize - buffer->size(), frameSizeBytes)), items);
+            buffer->setRange(buffer->offset() + frameSizeBytes, buffer->size() - frameSizeBytes);
+        }
+    }
+
     while (buffer->size() > 0) {
         LOG_ALWAYS_FATAL_IF(
                 mCurrentBlock,
@@ -209,10 +230,17 @@ void FrameReassembler::finishCurrentBlock(std::list<std::unique_ptr<C2Work>> *it
                 mWriteView->capacity() - mWriteView->size());
         mWriteView->setSize(mWriteView->capacity());
     }
+    addWork(C2Buffer::CreateLinearBuffer(
+            mCurrentBlock->share(0, mCurrentBlock->capacity(), C2Fence())), items);
+    mCurrentBlock.reset();
+    mWriteView.reset();
+}
+
+void FrameReassembler::addWork(
+        const std::shared_ptr<C2Buffer> &frame, std::list<std::unique_ptr<C2Work>> *items) {
     std::unique_ptr<C2Work> work{std::make_unique<C2Work>()};
     work->input.ordinal = mCurrentOrdinal;
-    work->input.buffers.push_back(C2Buffer::CreateLinearBuffer(
-            mCurrentBlock->share(0, mCurrentBlock->capacity(), C2Fence())));
+    work->input.buffers.push_back(frame);
     work->worklets.clear();
     work->worklets.emplace_back(new C2Worklet);
     items->push_back(std::move(work));
@@ -220,8 +248,6 @@ void FrameReassembler::finishCurrentBlock(std::list<std::unique_ptr<C2Work>> *it
     ++mCurrentOrdinal.frameIndex;
     mCurrentOrdinal.timestamp += mFrameSize.value() * 1000000 / mSampleRate;
     mCurrentOrdinal.customOrdinal = mCurrentOrdinal.timestamp;
-    mCurrentBlock.reset();
-    mWriteView.reset();
 }
 
 }  // namespace android
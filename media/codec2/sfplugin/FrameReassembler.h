@@ -51,6 +51,16 @@ public:
             const sp<MediaCodecBuffer> &buffer,
             std::list<std::unique_ptr<C2Work>> *items);
 
+    /**
+     * Same as above, but |c2Buffer| holds the same data as |buffer|. Whole frames that start
+     * on a frame boundary are passed to the works as sub-blocks of |c2Buffer| instead of being
+     * copied. |c2Buffer| may be null.
+     */
+    c2_status_t process(
+            const sp<MediaCodecBuffer> &buffer,
+            const std::shared_ptr<C2Buffer> &c2Buffer,
+            std::list<std::unique_ptr<C2Work>> *items);
+
 private:
     std::shared_ptr<C2BlockPool> mBlockPool;
     C2MemoryUsage mUsage;
@@ -68,6 +78,8 @@ private:
     uint32_t bytesPerSample() const;
 
     void finishCurrentBlock(std::list<std::unique_ptr<C2Work>> *items);
+    void addWork(
+            const std::shared_ptr<C2Buffer> &frame, std::list<std::unique_ptr<C2Work>> *items);
 };
 
 }  // namespace android
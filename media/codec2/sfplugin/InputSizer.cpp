@@ -0,0 +1,78 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "InputSizer.h"
+
+#include <algorithm>
+
+namespace android {
+
+InputSizer::InputSizer() {
+    reset(0, 0);
+}
+
+void InputSizer::reset(size_t baseSlots, size_t maxCapacity) {
+    mBaseSlots = baseSlots;
+    mNumSlots = baseSlots;
+    mMaxCapacity = maxCapacity;
+    mCapacity = maxCapacity;
+    startWindow();
+}
+
+void InputSizer::setBaseSlots(size_t baseSlots) {
+    mBaseSlots = baseSlots;
+    mNumSlots = std::clamp(mNumSlots, baseSlots, 2 * baseSlots);
+}
+
+void InputSizer::onSlotsExhausted() {
+    if (mNumSlots < 2 * mBaseSlots) {
+        ++mNumSlots;
+        // Do not shrink based on what was observed with fewer slots.
+        startWindow();
+    }
+}
+
+void InputSizer::onBufferQueued(size_t numActiveSlots, size_t size) {
+    mWindowMaxActiveSlots = std::max(mWindowMaxActiveSlots, numActiveSlots);
+    mWindowMaxSize = std::max(mWindowMaxSize, size);
+    if (size > mCapacity / 2) {
+        mCapacity = std::max(mCapacity, capacityFor(size));
+    }
+    if (++mWindowCount < kWindowSize) {
+        return;
+    }
+    if (mNumSlots > mBaseSlots && mWindowMaxActiveSlots + 2 <= mNumSlots) {
+        --mNumSlots;
+    }
+    mCapacity = capacityFor(mWindowMaxSize);
+    startWindow();
+}
+
+void InputSizer::startWindow() {
+    mWindowCount = 0;
+    mWindowMaxActiveSlots = 0;
+    mWindowMaxSize = 0;
+}
+
+size_t InputSizer::capacityFor(size_t size) const {
+    size_t capacity = kMinCapacity;
+    while (capacity < 2 * size && capacity < mMaxCapacity) {
+        capacity <<= 1;
+    }
+    return std::min(capacity, mMaxCapacity);
+}
+
+}  // namespace android
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INPUT_SIZER_H_
+#define INPUT_SIZER_H_
+
+#include <stddef.h>
+
+namespace android {
+
+/**
+ * InputSizer chooses the number of input slots and the capacity of linear input buffers from
+ * what is observed while the codec is running.
+ *
+ * - The number of slots starts at the base number (input delay + pipeline delay + smoothness
+ *   factor), grows by one each time the client runs out of slots while the pipeline still has
+ *   room, and shrinks back by one when a window of queued buffers never used the last two
+ *   slots. It stays within [base, 2 * base].
+ * - The capacity starts at the max input size, and follows twice the largest buffer queued in
+ *   the last window, rounded up to a power of two. It grows as soon as a buffer is filled to
+ *   more than half of the capacity.
+ *
+ * This class is not thread-safe.
+ */
+class InputSizer {
+public:
+    // Number of queued buffers between two shrinking decisions.
+    static constexpr size_t kWindowSize = 64;
+    static constexpr size_t kMinCapacity = 4096;
+
+    InputSizer();
+
+    /**
+     * Start over from |baseSlots| slots and |maxCapacity| bytes.
+     */
+    void reset(size_t baseSlots, size_t maxCapacity);
+
+    /**
+     * The base number of slots changed, e.g. because the input delay changed.
+     */
+    void setBaseSlots(size_t baseSlots);
+
+    /**
+     * All slots were in use while the pipeline could take more work.
+     */
+    void onSlotsExhausted();
+
+    /**
+     * The client queued a buffer of |size| bytes while |numActiveSlots| slots were in use.
+     */
+    void onBufferQueued(size_t numActiveSlots, size_t size);
+
+    size_t numSlots() const { return mNumSlots; }
+    size_t capacity() const { return mCapacity; }
+
+private:
+    size_t mBaseSlots;
+    size_t mNumSlots;
+    size_t mMaxCapacity;
+    size_t mCapacity;
+
+    size_t mWindowCount;
+    size_t mWindowMaxActiveSlots;
+    size_t mWindowMaxSize;
+
+    void startWindow();
+    size_t capacityFor(size_t size) const;
+};
+
+}  // namespace android
+
+#endif  // INPUT_SIZER_H_
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LockStats.h"
+
+namespace android {
+
+namespace {
+
+void updateMax(std::atomic_int64_t *max, int64_t value) {
+    int64_t current = max->load(std::memory_order_relaxed);
+    while (value > current
+            && !max->compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+int64_t toUs(int64_t ns) {
+    return ns / 1000;
+}
+
+}  // namespace
+
+LockStats::Scope::Scope(LockStats *stats, Clock::time_point requested)
+    : mStats(stats), mRequested(requested), mAcquired(Clock::now()) {
+}
+
+LockStats::Scope::~Scope() {
+    release();
+}
+
+void LockStats::Scope::release() {
+    if (mStats) {
+        mStats->record(mAcquired - mRequested, Clock::now() - mAcquired);
+        mStats = nullptr;
+    }
+}
+
+LockStats::LockStats() {
+    reset();
+}
+
+void LockStats::record(Clock::duration wait, Clock::duration hold) {
+    const int64_t waitNs = std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count();
+    const int64_t holdNs = std::chrono::duration_cast<std::chrono::nanoseconds>(hold).count();
+    mCount.fetch_add(1, std::memory_order_relaxed);
+    mTotalWaitNs.fetch_add(waitNs, std::memory_order_relaxed);
+    mTotalHoldNs.fetch_add(holdNs, std::memory_order_relaxed);
+    updateMax(&mMaxWaitNs, waitNs);
+    updateMax(&mMaxHoldNs, holdNs);
+}
+
+LockStats::Snapshot LockStats::snapshot() const {
+    return Snapshot{
+        mCount.load(std::memory_order_relaxed),
+        toUs(mTotalWaitNs.load(std::memory_order_relaxed)),
+        toUs(mMaxWaitNs.load(std::memory_order_relaxed)),
+        toUs(mTotalHoldNs.load(std::memory_order_relaxed)),
+        toUs(mMaxHoldNs.load(std::memory_order_relaxed)),
+    };
+}
+
+void LockStats::reset() {
+    mCount = 0;
+    mTotalWaitNs = 0;
+    mMaxWaitNs = 0;
+    mTotalHoldNs = 0;
+    mMaxHoldNs = 0;
+}
+
+}  // namespace android
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LOCK_STATS_H_
+#define LOCK_STATS_H_
+
+#include <atomic>
+#include <chrono>
+
+namespace android {
+
+/**
+ * LockStats accumulates how long a lock is waited for and held, so that lock contention can be
+ * reported in metrics. It is thread-safe, and does not need to be guarded by the lock it
+ * measures.
+ *
+ * Usage:
+ *
+ *   LockStats::Clock::time_point requested = LockStats::Clock::now();
+ *   Mutexed<Foo>::Locked foo(mFoo);
+ *   LockStats::Scope scope(&mFooLockStats, requested);
+ *   ...
+ *   scope.release();  // if the lock is released before the end of the scope
+ *   foo.unlock();
+ */
+class LockStats {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Snapshot {
+        uint64_t count;         // number of times the lock was acquired
+        int64_t totalWaitUs;
+        int64_t maxWaitUs;
+        int64_t totalHoldUs;
+        int64_t maxHoldUs;
+    };
+
+    /**
+     * Records one acquisition of the lock, from the time it was acquired to the destruction of
+     * the scope or to release().
+     */
+    class Scope {
+    public:
+        Scope(LockStats *stats, Clock::time_point requested);
+        ~Scope();
+
+        void release();
+
+    private:
+        LockStats *mStats;
+        const Clock::time_point mRequested;
+        const Clock::time_point mAcquired;
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    };
+
+    LockStats();
+
+    Snapshot snapshot() const;
+    void reset();
+
+private:
+    void record(Clock::duration wait, Clock::duration hold);
+
+    std::atomic_uint64_t mCount;
+    std::atomic_int64_t mTotalWaitNs;
+    std::atomic_int64_t mMaxWaitNs;
+    std::atomic_int64_t mTotalHoldNs;
+    std::atomic_int64_t mMaxHoldNs;
+};
+
+}  // namespace android
+
+#endif  // LOCK_STATS_H_
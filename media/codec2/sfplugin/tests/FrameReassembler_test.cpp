@@ -133,6 +133,24 @@ public:
             << " input size = " << inputIndex << " frame size = " << encoderFrameSizeInBytes;
     }
 
+    // Returns a buffer with |size| bytes starting at |firstByte|, and a C2Buffer with the same
+    // data.
+    void makeInput(
+            size_t size, uint8_t firstByte, int64_t timeUs,
+            sp<MediaCodecBuffer> *buffer, std::shared_ptr<C2Buffer> *c2Buffer) {
+        *buffer = new MediaCodecBuffer(new AMessage, new ABuffer(size));
+        (*buffer)->setRange(0, size);
+        (*buffer)->meta()->setInt64("timeUs", timeUs);
+        std::shared_ptr<C2LinearBlock> block;
+        ASSERT_EQ(C2_OK, mPool->fetchLinearBlock(size, kUsage, &block));
+        C2WriteView view = block->map().get();
+        ASSERT_EQ(C2_OK, view.error());
+        for (size_t i = 0; i < size; ++i) {
+            (*buffer)->base()[i] = view.data()[i] = uint8_t(firstByte + i);
+        }
+        *c2Buffer = C2Buffer::CreateLinearBuffer(block->share(0, size, C2Fence()));
+    }
+
 private:
     status_t mInitStatus;
     std::shared_ptr<C2BlockPool> mPool;
@@ -378,4 +396,54 @@ TEST_F(FrameReassemblerTest, PushBigChunk) {
     }
 }
 
+// Whole frames that start on a frame boundary are passed through without a copy.
+TEST_F(FrameReassemblerTest, PassThroughAlignedFrames) {
+    ASSERT_EQ(OK, initStatus());
+    constexpr size_t kFrameSize = 1024;
+    constexpr size_t kFrameBytes = kFrameSize * 2;  // mono PCM_16
+    constexpr uint32_t kSampleRate = 48000;
+    FrameReassembler frameReassembler;
+    frameReassembler.init(mPool, kUsage, kFrameSize, kSampleRate, 1, PCM_16);
+    ASSERT_TRUE(frameReassembler);
+
+    // 2.5 frames, then 1.5 frames.
+    sp<MediaCodecBuffer> first, second;
+    std::shared_ptr<C2Buffer> firstC2, secondC2;
+    makeInput(kFrameBytes * 5 / 2, 0, 0, &first, &firstC2);
+    makeInput(kFrameBytes * 3 / 2, uint8_t(kFrameBytes * 5 / 2),
+            kFrameSize * 5 / 2 * 1000000 / kSampleRate, &second, &secondC2);
+    const C2Handle *firstHandle = firstC2->data().linearBlocks().front().handle();
+    const C2Handle *secondHandle = secondC2->data().linearBlocks().front().handle();
+
+    std::list<std::unique_ptr<C2Work>> items;
+    ASSERT_EQ(C2_OK, frameReassembler.process(first, firstC2, &items));
+    ASSERT_EQ(2u, items.size());
+    ASSERT_EQ(C2_OK, frameReassembler.process(second, secondC2, &items));
+    ASSERT_EQ(4u, items.size());
+
+    const C2Handle *expectedHandles[] = { firstHandle, firstHandle, nullptr, secondHandle };
+    size_t index = 0;
+    for (const std::unique_ptr<C2Work> &work : items) {
+        EXPECT_EQ(index, work->input.ordinal.frameIndex.peeku());
+        EXPECT_GE(kTimestampToleranceUs, Diff(
+                index * kFrameSize * 1000000 / kSampleRate, work->input.ordinal.timestamp));
+        ASSERT_EQ(1u, work->input.buffers.size());
+        const C2ConstLinearBlock &block = work->input.buffers[0]->data().linearBlocks().front();
+        if (expectedHandles[index]) {
+            EXPECT_EQ(expectedHandles[index], block.handle()) << "frame " << index;
+        } else {
+            EXPECT_NE(firstHandle, block.handle()) << "frame " << index;
+            EXPECT_NE(secondHandle, block.handle()) << "frame " << index;
+        }
+        C2ReadView view = block.map().get();
+        ASSERT_EQ(C2_OK, view.error());
+        ASSERT_EQ(kFrameBytes, view.capacity());
+        for (size_t i = 0; i < kFrameBytes; ++i) {
+            ASSERT_EQ(uint8_t(index * kFrameBytes + i), view.data()[i])
+                << "frame " << index << " byte " << i;
+        }
+        ++index;
+    }
+}
+
 } // namespace android
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "InputSizer.h"
+
+#include <gtest/gtest.h>
+
+namespace android {
+
+constexpr size_t kBaseSlots = 4;
+constexpr size_t kMaxCapacity = 1048576;
+
+TEST(InputSizerTest, Initial) {
+    InputSizer sizer;
+    sizer.reset(kBaseSlots, kMaxCapacity);
+    EXPECT_EQ(kBaseSlots, sizer.numSlots());
+    EXPECT_EQ(kMaxCapacity, sizer.capacity());
+}
+
+TEST(InputSizerTest, GrowAndShrinkSlots) {
+    InputSizer sizer;
+    sizer.reset(kBaseSlots, kMaxCapacity);
+    for (size_t i = 0; i < 3 * kBaseSlots; ++i) {
+        sizer.onSlotsExhausted();
+    }
+    EXPECT_EQ(2 * kBaseSlots, sizer.numSlots());
+
+    // All slots are used: keep them.
+    for (size_t i = 0; i < InputSizer::kWindowSize; ++i) {
+        sizer.onBufferQueued(2 * kBaseSlots, 1000);
+    }
+    EXPECT_EQ(2 * kBaseSlots, sizer.numSlots());
+
+    // Only one slot is used: shrink one slot per window, down to the base.
+    for (size_t i = 0; i < 2 * kBaseSlots * InputSizer::kWindowSize; ++i) {
+        sizer.onBufferQueued(1, 1000);
+    }
+    EXPECT_EQ(kBaseSlots, sizer.numSlots());
+}
+
+TEST(InputSizerTest, BaseSlots) {
+    InputSizer sizer;
+    sizer.reset(kBaseSlots, kMaxCapacity);
+    sizer.onSlotsExhausted();
+    EXPECT_EQ(kBaseSlots + 1, sizer.numSlots());
+    sizer.setBaseSlots(2 * kBaseSlots);
+    EXPECT_EQ(2 * kBaseSlots, sizer.numSlots());
+    sizer.setBaseSlots(1);
+    EXPECT_EQ(2u, sizer.numSlots());
+}
+
+TEST(InputSizerTest, Capacity) {
+    InputSizer sizer;
+    sizer.reset(kBaseSlots, kMaxCapacity);
+    for (size_t i = 0; i < InputSizer::kWindowSize; ++i) {
+        sizer.onBufferQueued(1, 1000);
+    }
+    EXPECT_EQ(InputSizer::kMinCapacity, sizer.capacity());
+
+    // Grow right away when a buffer is more than half full.
+    sizer.onBufferQueued(1, 3000);
+    EXPECT_EQ(8192u, sizer.capacity());
+    sizer.onBufferQueued(1, 600000);
+    EXPECT_EQ(kMaxCapacity, sizer.capacity());
+
+    // Shrink at the end of a window without large buffers.
+    for (size_t i = 0; i < 2 * InputSizer::kWindowSize; ++i) {
+        sizer.onBufferQueued(1, 10000);
+    }
+    EXPECT_EQ(32768u, sizer.capacity());
+}
+
+TEST(InputSizerTest, SmallMaxCapacity) {
+    InputSizer sizer;
+    sizer.reset(kBaseSlots, 1000);
+    for (size_t i = 0; i < InputSizer::kWindowSize; ++i) {
+        sizer.onBufferQueued(1, 10);
+    }
+    EXPECT_EQ(1000u, sizer.capacity());
+}
+
+}  // namespace android
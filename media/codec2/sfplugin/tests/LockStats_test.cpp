@@ -0,0 +1,82 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LockStats.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace android {
+
+using namespace std::chrono_literals;
+
+TEST(LockStatsTest, Empty) {
+    LockStats stats;
+    LockStats::Snapshot snapshot = stats.snapshot();
+    EXPECT_EQ(0u, snapshot.count);
+    EXPECT_EQ(0, snapshot.totalWaitUs);
+    EXPECT_EQ(0, snapshot.maxWaitUs);
+    EXPECT_EQ(0, snapshot.totalHoldUs);
+    EXPECT_EQ(0, snapshot.maxHoldUs);
+}
+
+TEST(LockStatsTest, HoldAndRelease) {
+    LockStats stats;
+    {
+        LockStats::Scope scope(&stats, LockStats::Clock::now());
+        std::this_thread::sleep_for(10ms);
+        scope.release();
+        // Not counted after release().
+        std::this_thread::sleep_for(50ms);
+    }
+    LockStats::Snapshot snapshot = stats.snapshot();
+    EXPECT_EQ(1u, snapshot.count);
+    EXPECT_GE(snapshot.maxHoldUs, 10000);
+    EXPECT_LT(snapshot.maxHoldUs, 50000);
+    EXPECT_EQ(snapshot.maxHoldUs, snapshot.totalHoldUs);
+
+    stats.reset();
+    EXPECT_EQ(0u, stats.snapshot().count);
+}
+
+TEST(LockStatsTest, Wait) {
+    LockStats stats;
+    std::mutex mutex;
+    std::atomic_bool requesting = false;
+    std::unique_lock<std::mutex> held(mutex);
+    std::thread waiter([&stats, &mutex, &requesting] {
+        LockStats::Clock::time_point requested = LockStats::Clock::now();
+        requesting = true;
+        std::lock_guard<std::mutex> lock(mutex);
+        LockStats::Scope scope(&stats, requested);
+    });
+    while (!requesting) {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(20ms);
+    held.unlock();
+    waiter.join();
+
+    LockStats::Snapshot snapshot = stats.snapshot();
+    EXPECT_EQ(1u, snapshot.count);
+    EXPECT_GE(snapshot.maxWaitUs, 20000);
+    EXPECT_EQ(snapshot.maxWaitUs, snapshot.totalWaitUs);
+}
+
+} // namespace android
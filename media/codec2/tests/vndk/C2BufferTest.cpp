@@ -20,6 +20,7 @@
 #include <C2Buffer.h>
 #include <C2BufferPriv.h>
 #include <C2Config.h>
+#include <C2LinearAllocationRecycler.h>
 #include <C2ParamDef.h>
 #include <C2PlatformSupport.h>
 
@@ -821,4 +822,49 @@ TEST_F(C2BufferTest, InfoBufferTest) {
     ASSERT_EQ(linearPool->getAllocatorId(), portInfo.data().linearBlocks()[0].getAllocatorId());
 }
 
+TEST(C2LinearAllocationRecyclerTest, RecycleTest) {
+    std::shared_ptr<C2AllocatorStore> store = GetCodec2PlatformAllocatorStore();
+    std::shared_ptr<C2Allocator> allocator;
+    ASSERT_EQ(C2_OK, store->fetchAllocator(C2AllocatorStore::DEFAULT_LINEAR, &allocator));
+    C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
+
+    auto recycler = std::make_shared<C2LinearAllocationRecycler>();
+    recycler->setMaxBytes(65536u);
+
+    std::shared_ptr<C2LinearAllocation> allocation;
+    ASSERT_EQ(C2_OK, recycler->fetchLinearAllocation(allocator, 10000u, usage, &allocation));
+    ASSERT_TRUE(allocation);
+    EXPECT_LE(10000u, allocation->capacity());
+    const C2LinearAllocation *first = allocation.get();
+    allocation.reset();
+
+    C2LinearAllocationRecycler::Stats stats = recycler->getStats();
+    EXPECT_EQ(0u, stats.hits);
+    EXPECT_EQ(1u, stats.misses);
+    EXPECT_EQ(1u, stats.cachedCount);
+
+    // Same size class: reuse the allocation.
+    ASSERT_EQ(C2_OK, recycler->fetchLinearAllocation(allocator, 9000u, usage, &allocation));
+    EXPECT_EQ(first, allocation.get());
+    stats = recycler->getStats();
+    EXPECT_EQ(1u, stats.hits);
+    EXPECT_EQ(0u, stats.cachedCount);
+
+    // Stay within the max size.
+    std::vector<std::shared_ptr<C2LinearAllocation>> allocations(3);
+    for (std::shared_ptr<C2LinearAllocation> &a : allocations) {
+        ASSERT_EQ(C2_OK, recycler->fetchLinearAllocation(allocator, 30000u, usage, &a));
+    }
+    allocations.clear();
+    stats = recycler->getStats();
+    EXPECT_EQ(1u, stats.evictions);
+    EXPECT_GE(65536u, stats.cachedBytes);
+
+    recycler->setMaxBytes(0u);
+    allocation.reset();
+    stats = recycler->getStats();
+    EXPECT_EQ(0u, stats.cachedCount);
+    EXPECT_EQ(0u, stats.cachedBytes);
+}
+
 } // namespace android
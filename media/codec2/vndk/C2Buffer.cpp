@@ -30,6 +30,7 @@
 #include <C2BufferPriv.h>
 #include <C2Debug.h>
 #include <C2BlockInternal.h>
+#include <C2LinearAllocationRecycler.h>
 #include <C2PlatformSupport.h>
 #include <bufferpool/ClientManager.h>
 #include <bufferpool2/ClientManager.h>
@@ -370,12 +371,14 @@ c2_status_t C2BasicLinearBlockPool::fetchLinearBlock(
     block->reset();
 
     std::shared_ptr<C2LinearAllocation> alloc;
-    c2_status_t err = mAllocator->newLinearAllocation(capacity, usage, &alloc);
+    c2_status_t err = C2LinearAllocationRecycler::GetInstance()->fetchLinearAllocation(
+            mAllocator, capacity, usage, &alloc);
     if (err != C2_OK) {
         return err;
     }
 
-    *block = _C2BlockFactory::CreateLinearBlock(alloc);
+    // A recycled allocation may be larger than requested.
+    *block = _C2BlockFactory::CreateLinearBlock(alloc, nullptr, 0, capacity);
 
     return C2_OK;
 }
@@ -847,6 +850,17 @@ public:
         return C2_CORRUPTED;
     }
 
+    c2_status_t prefetchLinearBlocks(
+            uint32_t capacity, C2MemoryUsage usage, size_t count) {
+        if (mInit != C2_OK) {
+            return mInit;
+        }
+        std::vector<uint8_t> params;
+        mAllocator->getLinearParams(capacity, usage, &params);
+        ResultStatus status = mBufferPoolManager->prefetch(mConnectionId, params, count);
+        return status == ResultStatus::OK ? C2_OK : C2_CORRUPTED;
+    }
+
     bufferpool_impl::ConnectionId getConnectionId() {
         return mInit != C2_OK ? bufferpool_impl::INVALID_CONNECTIONID : mConnectionId;
     }
@@ -1215,6 +1229,15 @@ c2_status_t C2PooledBlockPool::fetchGraphicBlock(
     return C2_CORRUPTED;
 }
 
+c2_status_t C2PooledBlockPool::prefetchLinearBlocks(
+        uint32_t capacity, C2MemoryUsage usage, size_t count) {
+    if (mBufferPoolVer == VER_HIDL && mImpl) {
+        return mImpl->prefetchLinearBlocks(capacity, usage, count);
+    }
+    // TODO: support prefetching from AIDL2 bufferpool
+    return C2_OMITTED;
+}
+
 int64_t C2PooledBlockPool::getConnectionId() {
     if (mBufferPoolVer == VER_HIDL && mImpl) {
         return mImpl->getConnectionId();
@@ -28,6 +28,7 @@
 #include <unistd.h>  // getpagesize, size_t, close, dup
 #include <utils/Log.h>
 
+#include <iterator>
 #include <list>
 
 #include <android-base/properties.h>
@@ -40,8 +41,100 @@ namespace {
 
     // max padding after ion/dmabuf allocations in bytes
     constexpr uint32_t MAX_PADDING = 0x8000; // 32KB
+
+    // max size of the freed buffers kept for reuse in KiB
+    constexpr uint32_t MAX_FREE_BUFFER_CACHE_KB = 0x100000; // 1GB
 }
 
+/* =========================== FREE BUFFER CACHE =========================== */
+/**
+ * Keeps the dmabuf fd of freed allocations so that a subsequent allocation of the same heap,
+ * flags and size can skip the heap allocation (and the page clearing that comes with it).
+ *
+ * Buffers are kept in LRU order up to a total size, and the least recently freed buffers are
+ * closed first when a freed buffer does not fit.
+ */
+class C2DmaBufFreeBufferCache {
+   public:
+    explicit C2DmaBufFreeBufferCache(size_t maxBytes) : mMaxBytes(maxBytes), mCachedBytes(0) {}
+
+    ~C2DmaBufFreeBufferCache() { trim(0); }
+
+    /**
+     * Returns a freed buffer fd matching the parameters, or -1 if there is none. The caller
+     * owns the returned fd.
+     */
+    int take(const C2String& heapName, unsigned flags, size_t size) {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+            if (it->size == size && it->flags == flags && it->heapName == heapName) {
+                int fd = it->fd;
+                mCachedBytes -= size;
+                mEntries.erase(it);
+                return fd;
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * Takes ownership of a freed buffer fd. Returns false if the buffer is not kept, in which
+     * case the caller still owns the fd.
+     */
+    bool put(const C2String& heapName, unsigned flags, size_t size, int fd) {
+        std::list<Entry> evicted;
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            if (size > mMaxBytes) {
+                return false;
+            }
+            while (mCachedBytes + size > mMaxBytes) {
+                mCachedBytes -= mEntries.back().size;
+                evicted.splice(evicted.end(), mEntries, std::prev(mEntries.end()));
+            }
+            mEntries.push_front({heapName, flags, size, fd});
+            mCachedBytes += size;
+        }
+        closeAll(evicted);
+        return true;
+    }
+
+    /**
+     * Closes freed buffers until at most |maxBytes| are kept.
+     */
+    void trim(size_t maxBytes) {
+        std::list<Entry> evicted;
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            while (mCachedBytes > maxBytes) {
+                mCachedBytes -= mEntries.back().size;
+                evicted.splice(evicted.end(), mEntries, std::prev(mEntries.end()));
+            }
+        }
+        ALOGV("trimmed %zu freed buffers", evicted.size());
+        closeAll(evicted);
+    }
+
+   private:
+    struct Entry {
+        C2String heapName;
+        unsigned flags;
+        size_t size;
+        int fd;
+    };
+
+    static void closeAll(const std::list<Entry>& entries) {
+        for (const Entry& entry : entries) {
+            close(entry.fd);
+        }
+    }
+
+    std::mutex mLock;
+    const size_t mMaxBytes;
+    size_t mCachedBytes;
+    std::list<Entry> mEntries;  // most recently freed first
+};
+
 /* =========================== BUFFER HANDLE =========================== */
 /**
  * Buffer handle
@@ -122,9 +215,12 @@ class C2DmaBufAllocation : public C2LinearAllocation {
       * @param heap_name name of the dmabuf heap (device)
       * @param flags     flags
       * @param id        allocator id
+      * @param cache     cache of freed buffers to allocate from and to return the buffer to on
+      *                  destruction, or null
       */
     C2DmaBufAllocation(BufferAllocator& alloc, size_t allocSize, size_t capacity,
-                       C2String heap_name, unsigned flags, C2Allocator::id_t id);
+                       C2String heap_name, unsigned flags, C2Allocator::id_t id,
+                       const std::shared_ptr<C2DmaBufFreeBufferCache>& cache = nullptr);
 
     /**
       * Constructs an allocation by wrapping an existing allocation.
@@ -164,6 +260,12 @@ class C2DmaBufAllocation : public C2LinearAllocation {
     };
     Mutexed<std::list<Mapping>> mMappings;
 
+    // set for new allocations only, as imported buffers may still be used by their owner
+    std::weak_ptr<C2DmaBufFreeBufferCache> mCache;
+    C2String mHeapName;
+    unsigned mFlags;
+    size_t mAllocSize;
+
     // TODO: we could make this encapsulate shared_ptr and copiable
     C2_DO_NOT_COPY(C2DmaBufAllocation);
 };
@@ -264,18 +366,33 @@ C2DmaBufAllocation::~C2DmaBufAllocation() {
             if (err) ALOGD("munmap failed");
         }
     }
-    if (mInit == C2_OK) {
-        native_handle_close(&mHandle);
+    if (mInit != C2_OK) {
+        return;
+    }
+    std::shared_ptr<C2DmaBufFreeBufferCache> cache = mCache.lock();
+    if (cache && cache->put(mHeapName, mFlags, mAllocSize, mHandle.bufferFd())) {
+        ALOGV("kept freed buffer %d for reuse", mHandle.bufferFd());
+        return;
     }
+    native_handle_close(&mHandle);
 }
 
 C2DmaBufAllocation::C2DmaBufAllocation(BufferAllocator& alloc, size_t allocSize, size_t capacity,
-                                       C2String heap_name, unsigned flags, C2Allocator::id_t id)
-    : C2LinearAllocation(capacity), mHandle(-1, 0) {
+                                       C2String heap_name, unsigned flags, C2Allocator::id_t id,
+                                       const std::shared_ptr<C2DmaBufFreeBufferCache>& cache)
+    : C2LinearAllocation(capacity), mHandle(-1, 0), mCache(cache), mHeapName(heap_name),
+      mFlags(flags), mAllocSize(allocSize) {
     int bufferFd = -1;
     int ret = 0;
 
-    bufferFd = alloc.Alloc(heap_name, allocSize, flags);
+    if (cache) {
+        bufferFd = cache->take(heap_name, flags, allocSize);
+    }
+    if (bufferFd < 0) {
+        bufferFd = alloc.Alloc(heap_name, allocSize, flags);
+    } else {
+        ALOGV("reusing freed buffer %d", bufferFd);
+    }
     if (bufferFd < 0) {
         ret = bufferFd;
     }
@@ -287,7 +404,7 @@ C2DmaBufAllocation::C2DmaBufAllocation(BufferAllocator& alloc, size_t allocSize,
 }
 
 C2DmaBufAllocation::C2DmaBufAllocation(size_t size, int shareFd, C2Allocator::id_t id)
-    : C2LinearAllocation(size), mHandle(-1, 0) {
+    : C2LinearAllocation(size), mHandle(-1, 0), mFlags(0), mAllocSize(0) {
     mHandle = C2HandleBuf(shareFd, size);
     mId = id;
     mInit = c2_status_t(c2_map_errno<ENOMEM, EACCES, EINVAL>(0));
@@ -299,6 +416,20 @@ C2DmaBufAllocator::C2DmaBufAllocator(id_t id) : mInit(C2_OK) {
     C2MemoryUsage maxUsage = {C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE};
     Traits traits = {"android.allocator.dmabuf", id, LINEAR, minUsage, maxUsage};
     mTraits = std::make_shared<Traits>(traits);
+
+    // NOTE: freed buffers are reused without clearing them, so this is only suitable for
+    // processes that do not share the allocator between untrusted clients.
+    uint32_t cacheKb = base::GetUintProperty(
+            "media.c2.dmabuf.cache_kb", (uint32_t)0, MAX_FREE_BUFFER_CACHE_KB);
+    if (cacheKb > 0) {
+        mFreeBuffers = std::make_shared<C2DmaBufFreeBufferCache>(size_t(cacheKb) * 1024);
+    }
+}
+
+void C2DmaBufAllocator::trimFreeBuffers() {
+    if (mFreeBuffers) {
+        mFreeBuffers->trim(0);
+    }
 }
 
 C2Allocator::id_t C2DmaBufAllocator::getId() const {
@@ -404,7 +535,8 @@ c2_status_t C2DmaBufAllocator::newLinearAllocation(
     size_t allocSize = (size_t)capacity + sPadding;
     // TODO: should we align allocation size to mBlockSize to reflect the true allocation size?
     std::shared_ptr<C2DmaBufAllocation> alloc = std::make_shared<C2DmaBufAllocation>(
-            mBufferAllocator, allocSize, allocSize - sPadding, heap_name, flags, getId());
+            mBufferAllocator, allocSize, allocSize - sPadding, heap_name, flags, getId(),
+            mFreeBuffers);
     ret = alloc->status();
     if (ret == C2_OK) {
         *allocation = alloc;
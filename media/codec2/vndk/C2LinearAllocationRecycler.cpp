@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "C2LinearAllocationRecycler"
+#include <utils/Log.h>
+
+#include <iterator>
+
+#include <C2LinearAllocationRecycler.h>
+
+// static
+std::shared_ptr<C2LinearAllocationRecycler> C2LinearAllocationRecycler::GetInstance() {
+    static std::shared_ptr<C2LinearAllocationRecycler> sInstance =
+        std::make_shared<C2LinearAllocationRecycler>();
+    return sInstance;
+}
+
+C2LinearAllocationRecycler::C2LinearAllocationRecycler()
+    : mMaxBytes(0),
+      mCachedBytes(0),
+      mHits(0),
+      mMisses(0),
+      mEvictions(0) { }
+
+// static
+uint32_t C2LinearAllocationRecycler::SizeClass(uint32_t capacity) {
+    if (capacity <= kMinSizeClass) {
+        return kMinSizeClass;
+    }
+    // largest power of two below capacity
+    uint32_t step = (1u << (31 - __builtin_clz(capacity - 1))) / 4;
+    return (capacity + step - 1) / step * step;
+}
+
+void C2LinearAllocationRecycler::setMaxBytes(size_t maxBytes) {
+    std::list<Entry> evicted;
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mMaxBytes != maxBytes) {
+        ALOGD("max size %zu => %zu bytes", mMaxBytes, maxBytes);
+    }
+    mMaxBytes = maxBytes;
+    trim_l(&evicted);
+    // evicted allocations are freed after the lock is released
+}
+
+bool C2LinearAllocationRecycler::enabled() const {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mMaxBytes > 0;
+}
+
+c2_status_t C2LinearAllocationRecycler::fetchLinearAllocation(
+        const std::shared_ptr<C2Allocator> &allocator,
+        uint32_t capacity,
+        C2MemoryUsage usage,
+        std::shared_ptr<C2LinearAllocation> *allocation /* nonnull */) {
+    allocation->reset();
+    constexpr uint64_t kProtected = C2MemoryUsage::READ_PROTECTED | C2MemoryUsage::WRITE_PROTECTED;
+    if (!enabled() || (usage.expected & kProtected) || capacity > kMaxSizeClass) {
+        return allocator->newLinearAllocation(capacity, usage, allocation);
+    }
+
+    Entry entry{allocator->getId(), usage.expected, SizeClass(capacity), nullptr};
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+            if (it->allocatorId == entry.allocatorId
+                    && it->usage == entry.usage
+                    && it->sizeClass == entry.sizeClass) {
+                entry.allocation = std::move(it->allocation);
+                mCachedBytes -= it->sizeClass;
+                mEntries.erase(it);
+                break;
+            }
+        }
+        if (entry.allocation) {
+            ++mHits;
+        } else {
+            ++mMisses;
+        }
+    }
+    if (!entry.allocation) {
+        c2_status_t err = allocator->newLinearAllocation(
+                entry.sizeClass, usage, &entry.allocation);
+        if (err != C2_OK) {
+            return err;
+        }
+    }
+
+    C2LinearAllocation *raw = entry.allocation.get();
+    *allocation = std::shared_ptr<C2LinearAllocation>(
+            raw,
+            [weak = weak_from_this(), entry = std::move(entry)](C2LinearAllocation *) mutable {
+                std::shared_ptr<C2LinearAllocationRecycler> recycler = weak.lock();
+                if (recycler) {
+                    recycler->recycle(std::move(entry));
+                }
+            });
+    return C2_OK;
+}
+
+void C2LinearAllocationRecycler::recycle(Entry &&entry) {
+    std::list<Entry> evicted;
+    std::lock_guard<std::mutex> lock(mLock);
+    if (entry.sizeClass > mMaxBytes) {
+        return;
+    }
+    mCachedBytes += entry.sizeClass;
+    mEntries.push_front(std::move(entry));
+    trim_l(&evicted);
+}
+
+void C2LinearAllocationRecycler::trim_l(std::list<Entry> *evicted) {
+    while (mCachedBytes > mMaxBytes && !mEntries.empty()) {
+        mCachedBytes -= mEntries.back().sizeClass;
+        evicted->splice(evicted->begin(), mEntries, std::prev(mEntries.end()));
+        ++mEvictions;
+    }
+}
+
+C2LinearAllocationRecycler::Stats C2LinearAllocationRecycler::getStats() const {
+    std::lock_guard<std::mutex> lock(mLock);
+    return Stats{mHits, mMisses, mEvictions, mCachedBytes, mEntries.size()};
+}
@@ -468,6 +468,28 @@ C2PlatformAllocatorStore::id_t GetPreferredLinearAllocatorId(int poolMask) {
                                                               : C2PlatformAllocatorStore::ION;
 }
 
+c2_status_t PrefetchCodec2LinearBlocks(
+        const std::shared_ptr<C2BlockPool> &pool, uint32_t capacity, C2MemoryUsage usage,
+        size_t count) {
+    std::shared_ptr<C2PooledBlockPool> pooledPool =
+            std::dynamic_pointer_cast<C2PooledBlockPool>(pool);
+    if (!pooledPool) {
+        return C2_OMITTED;
+    }
+    return pooledPool->prefetchLinearBlocks(capacity, usage, count);
+}
+
+void TrimCodec2PlatformAllocatorCaches() {
+    std::shared_ptr<C2DmaBufAllocator> dmaAllocator;
+    {
+        std::lock_guard<std::mutex> lock(gDmaBufAllocatorMutex);
+        dmaAllocator = gDmaBufAllocator.lock();
+    }
+    if (dmaAllocator) {
+        dmaAllocator->trimFreeBuffers();
+    }
+}
+
 namespace {
 
 static C2PooledBlockPool::BufferPoolVer GetBufferPoolVer() {
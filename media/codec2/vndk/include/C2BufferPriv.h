@@ -105,6 +105,16 @@ public:
             C2MemoryUsage usage,
             std::shared_ptr<C2GraphicBlock> *block) override;
 
+    /**
+     * Hints that |count| linear blocks of |capacity| bytes with |usage| will be
+     * fetched soon. The underlying bufferpool allocates them in the background
+     * so that the first fetchLinearBlock() calls recycle them.
+     *
+     * \retval C2_OK       the blocks are being allocated
+     * \retval C2_OMITTED  the underlying bufferpool does not support prefetching
+     */
+    c2_status_t prefetchLinearBlocks(uint32_t capacity, C2MemoryUsage usage, size_t count);
+
     /**
      * Retrieves the connection Id for underlying bufferpool
      */
@@ -29,6 +29,8 @@
 
 namespace android {
 
+class C2DmaBufFreeBufferCache;
+
 class C2DmaBufAllocator : public C2Allocator {
    public:
     virtual c2_status_t newLinearAllocation(
@@ -94,9 +96,21 @@ class C2DmaBufAllocator : public C2Allocator {
         return (cached_result == 1);
     };
 
+    /**
+     * Closes the freed buffers kept for reuse, e.g. when the process is asked to reduce its
+     * memory usage.
+     *
+     * New allocations keep the dmabuf fd of freed allocations for reuse by subsequent
+     * allocations of the same heap, flags and size, up to "media.c2.dmabuf.cache_kb" KiB
+     * (disabled by default). This releases all of them.
+     */
+    void trimFreeBuffers();
+
    private:
     c2_status_t mInit;
     BufferAllocator mBufferAllocator;
+    // freed buffers kept for reuse, or null if disabled
+    std::shared_ptr<C2DmaBufFreeBufferCache> mFreeBuffers;
 
     c2_status_t mapUsage(C2MemoryUsage usage, size_t size,
                          /* => */ C2String* heap_name, unsigned* flags);
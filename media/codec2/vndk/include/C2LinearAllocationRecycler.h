@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef STAGEFRIGHT_CODEC2_LINEAR_ALLOCATION_RECYCLER_H_
+#define STAGEFRIGHT_CODEC2_LINEAR_ALLOCATION_RECYCLER_H_
+
+#include <list>
+#include <memory>
+#include <mutex>
+
+#include <C2Buffer.h>
+
+/**
+ * Process-wide cache of the linear allocations of C2BasicLinearBlockPool, so that codecs that
+ * are created and released in quick succession reuse memory instead of allocating and mapping
+ * it again.
+ *
+ * Allocations are rounded up to size classes a quarter of a power of two apart, and are
+ * returned to the cache when the last block referencing them is destroyed. The cache is bounded by a total size; the
+ * allocations released the longest time ago are freed first. Protected allocations are never
+ * cached.
+ *
+ * The cache is disabled (max size 0) by default. As a recycled allocation may contain data of
+ * previous blocks, it should only be enabled in processes that do not serve multiple clients.
+ */
+class C2LinearAllocationRecycler
+        : public std::enable_shared_from_this<C2LinearAllocationRecycler> {
+public:
+    struct Stats {
+        uint64_t hits;          // fetches served from the cache
+        uint64_t misses;        // fetches that needed a new allocation
+        uint64_t evictions;     // allocations freed to stay within the max size
+        size_t cachedBytes;
+        size_t cachedCount;
+    };
+
+    static constexpr uint32_t kMinSizeClass = 4096;
+    // Larger allocations are not cached.
+    static constexpr uint32_t kMaxSizeClass = 1u << 30;
+
+    static std::shared_ptr<C2LinearAllocationRecycler> GetInstance();
+
+    C2LinearAllocationRecycler();
+
+    /**
+     * Set the max total size of the cached allocations, freeing cached allocations as needed.
+     * 0 disables the cache.
+     */
+    void setMaxBytes(size_t maxBytes);
+
+    bool enabled() const;
+
+    /**
+     * Get an allocation of at least |capacity| bytes from the cache, or allocate a new one of
+     * the size class of |capacity| from |allocator|.
+     */
+    c2_status_t fetchLinearAllocation(
+            const std::shared_ptr<C2Allocator> &allocator,
+            uint32_t capacity,
+            C2MemoryUsage usage,
+            std::shared_ptr<C2LinearAllocation> *allocation /* nonnull */);
+
+    Stats getStats() const;
+
+private:
+    struct Entry {
+        C2Allocator::id_t allocatorId;
+        uint64_t usage;
+        uint32_t sizeClass;
+        std::shared_ptr<C2LinearAllocation> allocation;
+    };
+
+    mutable std::mutex mLock;
+    size_t mMaxBytes;
+    size_t mCachedBytes;
+    // Most recently released first.
+    std::list<Entry> mEntries;
+    uint64_t mHits;
+    uint64_t mMisses;
+    uint64_t mEvictions;
+
+    static uint32_t SizeClass(uint32_t capacity);
+
+    void recycle(Entry &&entry);
+    void trim_l(std::list<Entry> *evicted);
+};
+
+#endif // STAGEFRIGHT_CODEC2_LINEAR_ALLOCATION_RECYCLER_H_
@@ -253,6 +253,23 @@ int GetCodec2PoolMask();
  */
 C2PlatformAllocatorStore::id_t GetPreferredLinearAllocatorId(int poolMask);
 
+/**
+ * Hints |pool| that |count| linear blocks of |capacity| bytes with |usage| will be fetched soon,
+ * so that it can allocate them ahead of time in the background.
+ *
+ * \retval C2_OK       the blocks are being allocated
+ * \retval C2_OMITTED  |pool| does not support allocating ahead of time
+ */
+c2_status_t PrefetchCodec2LinearBlocks(
+        const std::shared_ptr<C2BlockPool> &pool, uint32_t capacity, C2MemoryUsage usage,
+        size_t count);
+
+/**
+ * Releases the memory kept for reuse by the platform allocators, e.g. the freed buffers kept by
+ * the dmabuf allocator. Call this when the process is asked to reduce its memory usage.
+ */
+void TrimCodec2PlatformAllocatorCaches();
+
 } // namespace android
 
 #endif // STAGEFRIGHT_CODEC2_PLATFORM_SUPPORT_H_
@@ -131,34 +131,31 @@ class ANDROID_API EndianOutput : public Output {
 template<typename T>
 inline status_t EndianOutput::writeHelper(const T* buf, size_t offset, size_t count) {
     assert(offset <= count);
+    if (mEndian != BIG && mEndian != LITTLE) {
+        return BAD_VALUE;
+    }
+    // Elements are converted into a chunk which is written at once, rather than
+    // writing elements one by one to the wrapped output.
+    const size_t kChunkCount = 256;
+    T chunk[kChunkCount];
     status_t res = OK;
     size_t size = sizeof(T);
-    switch(mEndian) {
-        case BIG: {
-            for (size_t i = offset; i < count; ++i) {
-                T tmp = convertToBigEndian<T>(buf[offset + i]);
-                if ((res = mOutput->write(reinterpret_cast<uint8_t*>(&tmp), 0, size))
-                        != OK) {
-                    return res;
-                }
-                mOffset += size;
+    for (size_t i = offset; i < count;) {
+        size_t n = (count - i < kChunkCount) ? count - i : kChunkCount;
+        if (mEndian == BIG) {
+            for (size_t j = 0; j < n; ++j) {
+                chunk[j] = convertToBigEndian<T>(buf[offset + i + j]);
             }
-            break;
-        }
-        case LITTLE: {
-            for (size_t i = offset; i < count; ++i) {
-                T tmp = convertToLittleEndian<T>(buf[offset + i]);
-                if ((res = mOutput->write(reinterpret_cast<uint8_t*>(&tmp), 0, size))
-                        != OK) {
-                    return res;
-                }
-                mOffset += size;
+        } else {
+            for (size_t j = 0; j < n; ++j) {
+                chunk[j] = convertToLittleEndian<T>(buf[offset + i + j]);
             }
-            break;
         }
-        default: {
-            return BAD_VALUE;
+        if ((res = mOutput->write(reinterpret_cast<uint8_t*>(chunk), 0, n * size)) != OK) {
+            return res;
         }
+        mOffset += n * size;
+        i += n;
     }
     return res;
 }
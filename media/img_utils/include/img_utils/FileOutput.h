@@ -36,6 +36,8 @@ class ANDROID_API FileOutput : public Output {
         virtual status_t close();
     private:
         FILE *mFp;
+        // Buffer of mFp, much larger than the stdio default for the image data.
+        char* mBuffer;
         String8 mPath;
         bool mOpen;
 };
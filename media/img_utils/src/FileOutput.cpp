@@ -18,16 +18,21 @@
 
 #include <utils/Log.h>
 
+#include <stdlib.h>
+
 namespace android {
 namespace img_utils {
 
-FileOutput::FileOutput(String8 path) : mFp(NULL), mPath(path), mOpen(false) {}
+static const size_t kBufferSize = 256 * 1024;
+
+FileOutput::FileOutput(String8 path) : mFp(NULL), mBuffer(NULL), mPath(path), mOpen(false) {}
 
 FileOutput::~FileOutput() {
     if (mOpen) {
         ALOGW("%s: Destructor called with %s still open.", __FUNCTION__, mPath.c_str());
         close();
     }
+    free(mBuffer);
 }
 
 status_t FileOutput::open() {
@@ -40,6 +45,12 @@ status_t FileOutput::open() {
         ALOGE("%s: Could not open file %s", __FUNCTION__, mPath.c_str());
         return BAD_VALUE;
     }
+    if (mBuffer == NULL) {
+        mBuffer = static_cast<char*>(malloc(kBufferSize));
+    }
+    if (mBuffer != NULL && ::setvbuf(mFp, mBuffer, _IOFBF, kBufferSize) != 0) {
+        ALOGW("%s: Could not set the buffer of file %s", __FUNCTION__, mPath.c_str());
+    }
     mOpen = true;
     return OK;
 }
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <img_utils/EndianUtils.h>
+#include <img_utils/FileOutput.h>
+#include <img_utils/Output.h>
+
+// Measures the writes of a DNG: the 16-bit data written through EndianOutput,
+// and the image rows written to a FileOutput the way DngCreator writes its strips.
+
+using namespace android;
+using namespace android::img_utils;
+
+namespace {
+
+class NullOutput : public Output {
+  public:
+    status_t write(const uint8_t* buf, size_t offset, size_t count) override {
+        benchmark::DoNotOptimize(buf + offset);
+        benchmark::DoNotOptimize(count);
+        return OK;
+    }
+};
+
+void BM_EndianOutputWrite16(benchmark::State& state, Endianness end) {
+    std::vector<uint16_t> data(state.range(0), 0x1234);
+    NullOutput out;
+    EndianOutput endOut(&out, end);
+    for (auto _ : state) {
+        endOut.write(data.data(), 0, data.size());
+    }
+    state.SetBytesProcessed(state.iterations() * data.size() * sizeof(uint16_t));
+}
+
+// A 12 MP sensor with 16-bit pixels, written row by row.
+void BM_FileOutputRows(benchmark::State& state) {
+    const size_t kRowBytes = 4000 * sizeof(uint16_t);
+    const size_t kRows = 3000;
+    const char* kPath = "/data/local/tmp/img_utils_benchmark.dng";
+    std::vector<uint8_t> row(kRowBytes, 0x55);
+    for (auto _ : state) {
+        FileOutput out(String8(kPath));
+        if (out.open() != OK) {
+            state.SkipWithError("could not open the output file");
+            break;
+        }
+        for (size_t i = 0; i < kRows; i++) {
+            out.write(row.data(), 0, row.size());
+        }
+        out.close();
+    }
+    state.SetBytesProcessed(state.iterations() * kRowBytes * kRows);
+    remove(kPath);
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(BM_EndianOutputWrite16, little, LITTLE)->Arg(64)->Arg(4096);
+BENCHMARK_CAPTURE(BM_EndianOutputWrite16, big, BIG)->Arg(64)->Arg(4096);
+BENCHMARK(BM_FileOutputRows)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
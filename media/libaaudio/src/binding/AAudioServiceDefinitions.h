@@ -62,6 +62,13 @@ enum RingbufferFlags : uint32_t {
     COHERENCY_DMA = 0x0004,
     COHERENCY_ACQUIRE_RELEASE = 0x0008,
     COHERENCY_AUTO = 0x0010,
+    // The read and write counters are in separate cache lines, see kFifoCounterAlignment.
+    // The counters are located by their offsets, so this only describes the layout.
+    COUNTERS_CACHE_ALIGNED = 0x0020,
+    // The data and the write counter are shared by several clients and mapped read-only.
+    // Only the read counter belongs to the client, the client must not clear the data
+    // or reset the write counter.
+    SHARED_READ_ONLY = 0x0040,
 };
 
 // This is not passed through Binder.
@@ -103,12 +103,13 @@ Endpoint AudioEndpointParcelable::parcelable()&& {
  * @return index in table or negative error
  */
 int32_t AudioEndpointParcelable::addFileDescriptor(const unique_fd& fd,
-                                                   int32_t sizeInBytes) {
+                                                   int32_t sizeInBytes,
+                                                   bool writeable) {
     const int32_t index = getNextAvailableSharedMemoryPosition();
     if (index < 0) {
         return AAUDIO_ERROR_OUT_OF_RANGE;
     }
-    mSharedMemories[index].setup(fd, sizeInBytes);
+    mSharedMemories[index].setup(fd, sizeInBytes, writeable);
     return index;
 }
 
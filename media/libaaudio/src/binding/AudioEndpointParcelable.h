@@ -48,9 +48,11 @@ public:
 
     /**
      * Add the file descriptor to the table.
+     * @param writeable false if the client may only map the memory for reading
      * @return index in table or negative error
      */
-    int32_t addFileDescriptor(const android::base::unique_fd& fd, int32_t sizeInBytes);
+    int32_t addFileDescriptor(const android::base::unique_fd& fd, int32_t sizeInBytes,
+                              bool writeable = true);
 
     /**
      * Close current data file descriptor. The duplicated file descriptor will be closed.
@@ -41,6 +41,7 @@ SharedMemoryParcelable::SharedMemoryParcelable(SharedFileRegion&& parcelable) {
     mFd = parcelable.fd.release();
     mSizeInBytes = parcelable.size;
     mOffsetInBytes = parcelable.offset;
+    mWriteable = parcelable.writeable;
 }
 
 SharedFileRegion SharedMemoryParcelable::parcelable() && {
@@ -48,24 +49,27 @@ SharedFileRegion SharedMemoryParcelable::parcelable() && {
     result.fd.reset(std::move(mFd));
     result.size = mSizeInBytes;
     result.offset = mOffsetInBytes;
+    result.writeable = mWriteable;
     return result;
 }
 
 SharedMemoryParcelable SharedMemoryParcelable::dup() const {
     SharedMemoryParcelable result;
-    result.setup(mFd, static_cast<int32_t>(mSizeInBytes));
+    result.setup(mFd, static_cast<int32_t>(mSizeInBytes), mWriteable);
     return result;
 }
 
-void SharedMemoryParcelable::setup(const unique_fd& fd, int32_t sizeInBytes) {
+void SharedMemoryParcelable::setup(const unique_fd& fd, int32_t sizeInBytes, bool writeable) {
     constexpr int minFd = 3; // skip over stdout, stdin and stderr
     mFd.reset(fcntl(fd.get(), F_DUPFD_CLOEXEC, minFd)); // store a duplicate FD
     ALOGV("setup(fd = %d -> %d, size = %d) this = %p\n", fd.get(), mFd.get(), sizeInBytes, this);
     mSizeInBytes = sizeInBytes;
+    mWriteable = writeable;
 }
 
 void SharedMemoryParcelable::setup(const SharedMemoryParcelable &sharedMemoryParcelable) {
-    setup(sharedMemoryParcelable.mFd, sharedMemoryParcelable.mSizeInBytes);
+    setup(sharedMemoryParcelable.mFd, sharedMemoryParcelable.mSizeInBytes,
+          sharedMemoryParcelable.mWriteable);
 }
 
 aaudio_result_t SharedMemoryParcelable::close() {
@@ -89,7 +93,9 @@ aaudio_result_t SharedMemoryParcelable::closeAndReleaseFd() {
 }
 
 aaudio_result_t SharedMemoryParcelable::resolveSharedMemory(const unique_fd& fd) {
-    mResolvedAddress = (uint8_t *) mmap(nullptr, mSizeInBytes, PROT_READ | PROT_WRITE,
+    // Memory shared with other clients may be restricted to reading by the service.
+    const int prot = mWriteable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    mResolvedAddress = (uint8_t *) mmap(nullptr, mSizeInBytes, prot,
                                         MAP_SHARED, fd.get(), 0);
     if (mResolvedAddress == MMAP_UNRESOLVED_ADDRESS) {
         ALOGE("mmap() failed for fd = %d, nBytes = %" PRId64 ", errno = %s",
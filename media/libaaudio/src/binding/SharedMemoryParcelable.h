@@ -49,8 +49,9 @@ public:
      *
      * @param fd
      * @param sizeInBytes
+     * @param writeable false if the memory can only be mapped for reading
      */
-    void setup(const android::base::unique_fd& fd, int32_t sizeInBytes);
+    void setup(const android::base::unique_fd& fd, int32_t sizeInBytes, bool writeable = true);
 
     void setup(const SharedMemoryParcelable& sharedMemoryParcelable);
 
@@ -81,6 +82,7 @@ private:
     android::base::unique_fd   mFd;
     int64_t                    mSizeInBytes = 0;
     int64_t                    mOffsetInBytes = 0;
+    bool                       mWriteable = true;
     uint8_t                   *mResolvedAddress = MMAP_UNRESOLVED_ADDRESS;
 
     aaudio_result_t resolveSharedMemory(const android::base::unique_fd& fd);
@@ -20,6 +20,11 @@
 
 #include "AAudioFlowGraph.h"
 
+#include <algorithm>
+#include <string.h>
+
+#include <audio_utils/primitives.h>
+
 #include <flowgraph/Limiter.h>
 #include <flowgraph/ManyToMultiConverter.h>
 #include <flowgraph/MonoBlend.h>
@@ -153,15 +158,162 @@ aaudio_result_t AAudioFlowGraph::configure(audio_format_t sourceFormat,
     }
     lastOutput->connect(&mSink->input);
 
+    // The graph is still built, so that a configuration is validated in the same way.
+    // Its ramps and limiter are also used by the fused kernel.
+    mPassThrough = sourceFormat == sinkFormat
+            && sourceChannelCount == sinkChannelCount
+            && sourceSampleRate == sinkSampleRate
+            && !useMonoBlend && !useVolumeRamps;
+    if (!mPassThrough && sourceSampleRate == sinkSampleRate && !useMonoBlend) {
+        mFusedKernel = selectFusedKernel(sourceFormat, sourceChannelCount,
+                                         sinkFormat, sinkChannelCount);
+    }
+    mSinkChannelCount = sinkChannelCount;
+    mSourceBytesPerFrame = sourceChannelCount * audio_bytes_per_sample(sourceFormat);
+    mSinkBytesPerFrame = sinkChannelCount * audio_bytes_per_sample(sinkFormat);
+    ALOGD_IF(mPassThrough, "%s() pass through", __func__);
+    ALOGD_IF(isFused(), "%s() fused", __func__);
+
     return AAUDIO_OK;
 }
 
+AAudioFlowGraph::FusedKernel AAudioFlowGraph::selectFusedKernel(audio_format_t sourceFormat,
+                                                                int32_t sourceChannelCount,
+                                                                audio_format_t sinkFormat,
+                                                                int32_t sinkChannelCount) {
+    if (sinkChannelCount > kMaxFusedChannelCount) {
+        return nullptr;
+    }
+    const bool monoSource = sourceChannelCount == 1;
+    if (sourceFormat == AUDIO_FORMAT_PCM_16_BIT && sinkFormat == AUDIO_FORMAT_PCM_FLOAT) {
+        return monoSource ? &AAudioFlowGraph::processFused<int16_t, float, true>
+                : &AAudioFlowGraph::processFused<int16_t, float, false>;
+    } else if (sourceFormat == AUDIO_FORMAT_PCM_FLOAT && sinkFormat == AUDIO_FORMAT_PCM_16_BIT) {
+        return monoSource ? &AAudioFlowGraph::processFused<float, int16_t, true>
+                : &AAudioFlowGraph::processFused<float, int16_t, false>;
+    } else if (sourceFormat == AUDIO_FORMAT_PCM_16_BIT && sinkFormat == AUDIO_FORMAT_PCM_16_BIT) {
+        return monoSource ? &AAudioFlowGraph::processFused<int16_t, int16_t, true>
+                : &AAudioFlowGraph::processFused<int16_t, int16_t, false>;
+    } else if (sourceFormat == AUDIO_FORMAT_PCM_FLOAT && sinkFormat == AUDIO_FORMAT_PCM_FLOAT) {
+        return monoSource ? &AAudioFlowGraph::processFused<float, float, true>
+                : &AAudioFlowGraph::processFused<float, float, false>;
+    }
+    return nullptr;
+}
+
+namespace {
+
+inline float sampleToFloat(float sample) {
+    return sample;
+}
+
+inline float sampleToFloat(int16_t sample) {
+    return float_from_i16(sample);
+}
+
+template <typename D>
+D sampleFromFloat(float sample);
+
+template <>
+inline float sampleFromFloat<float>(float sample) {
+    return sample;
+}
+
+template <>
+inline int16_t sampleFromFloat<int16_t>(float sample) {
+    return clamp16_from_float(sample);
+}
+
+} // namespace
+
+// Does the work of Source -> Limiter -> MonoToMultiConverter -> RampLinear -> Sink
+// in one pass, with the same arithmetic as the nodes.
+template <typename S, typename D, bool kMonoSource>
+void AAudioFlowGraph::processFused(const void *source, void *destination, int32_t numFrames) {
+    const S *input = static_cast<const S *>(source);
+    D *output = static_cast<D *>(destination);
+    const int32_t channelCount = mSinkChannelCount;
+    const int32_t rampCount = mVolumeRamps.size();
+    Limiter *limiter = mLimiter.get();
+
+    // The ramps are started once per call, as when pulled through the graph.
+    bool ramping = false;
+    for (auto &ramp : mVolumeRamps) {
+        ramping |= ramp->updateRamp();
+    }
+
+    float gains[kMaxFusedChannelCount];
+    std::fill(gains, gains + channelCount, 1.0f);
+    int32_t framesLeft = numFrames;
+    while (framesLeft > 0) {
+        // While ramping the gains change every frame, which does not happen very often.
+        int32_t framesToProcess = framesLeft;
+        if (ramping) {
+            ramping = false;
+            for (int32_t i = 0; i < rampCount; i++) {
+                RampLinear *ramp = mVolumeRamps[i].get();
+                if (ramp->isRamping()) {
+                    gains[i] = ramp->nextLevel();
+                    ramping = true;
+                } else {
+                    gains[i] = ramp->getLevelTo();
+                }
+            }
+            if (ramping) framesToProcess = 1;
+        } else {
+            for (int32_t i = 0; i < rampCount; i++) {
+                gains[i] = mVolumeRamps[i]->getLevelTo();
+            }
+        }
+
+        for (int32_t frame = 0; frame < framesToProcess; frame++) {
+            if constexpr (kMonoSource) {
+                float sample = sampleToFloat(*input++);
+                if (limiter != nullptr) sample = limiter->processSample(sample);
+                for (int32_t channel = 0; channel < channelCount; channel++) {
+                    *output++ = sampleFromFloat<D>(sample * gains[channel]);
+                }
+            } else {
+                for (int32_t channel = 0; channel < channelCount; channel++) {
+                    float sample = sampleToFloat(*input++);
+                    if (limiter != nullptr) sample = limiter->processSample(sample);
+                    *output++ = sampleFromFloat<D>(sample * gains[channel]);
+                }
+            }
+        }
+        framesLeft -= framesToProcess;
+    }
+}
+
 int32_t AAudioFlowGraph::pull(void *destination, int32_t targetFramesToRead) {
+    if (isDirect()) {
+        const int32_t framesToRead = std::min(targetFramesToRead, mDirectFrames);
+        if (framesToRead <= 0) {
+            return 0;
+        }
+        if (mFusedKernel != nullptr) {
+            (this->*mFusedKernel)(mDirectData, destination, framesToRead);
+        } else if (mLimiter) {
+            mLimiter->processSamples(reinterpret_cast<const float *>(mDirectData),
+                    static_cast<float *>(destination),
+                    framesToRead * mSinkBytesPerFrame / sizeof(float));
+        } else {
+            memcpy(destination, mDirectData, framesToRead * mSinkBytesPerFrame);
+        }
+        mDirectData += framesToRead * mSourceBytesPerFrame;
+        mDirectFrames -= framesToRead;
+        return framesToRead;
+    }
     return mSink->read(destination, targetFramesToRead);
 }
 
 int32_t AAudioFlowGraph::process(const void *source, int32_t numFramesToWrite, void *destination,
                     int32_t targetFramesToRead) {
+    if (isDirect()) {
+        mDirectData = static_cast<const uint8_t *>(source);
+        mDirectFrames = numFramesToWrite;
+        return pull(destination, targetFramesToRead);
+    }
     mSource->setData(source, numFramesToWrite);
     return mSink->read(destination, targetFramesToRead);
 }
@@ -97,6 +97,35 @@ public:
     int32_t process(const void *source, int32_t numFramesToWrite, void *destination,
                     int32_t targetFramesToRead);
 
+    /**
+     * True if the source and sink have the same format, channel count and sample rate,
+     * and there is no mono blend or volume ramp. Then process() and pull() copy the data
+     * directly, only limited for float, without going through the graph 8 frames at a time,
+     * so the caller can pass large buffers.
+     */
+    bool isPassThrough() const {
+        return mPassThrough;
+    }
+
+    /**
+     * True if the conversion chain is done by a single fused kernel chosen by configure(),
+     * instead of pulling the data through the nodes of the graph.
+     * This is used when there is no sample rate conversion and no mono blend,
+     * and the source and sink formats are I16 or float.
+     */
+    bool isFused() const {
+        return mFusedKernel != nullptr;
+    }
+
+    /**
+     * True if process() and pull() convert the data directly, by pass through or with a
+     * fused kernel. Then the number of frames read is the number of frames written,
+     * so the caller can pass large buffers.
+     */
+    bool isDirect() const {
+        return mPassThrough || isFused();
+    }
+
     /**
      * @param volume between 0.0 and 1.0
      */
@@ -113,6 +142,19 @@ public:
     void setRampLengthInFrames(int32_t numFrames);
 
 private:
+    // Source format, sink format, channel count and volume ramps are fixed at configure time.
+    using FusedKernel = void (AAudioFlowGraph::*)(const void *source, void *destination,
+                                                  int32_t numFrames);
+    static constexpr int32_t kMaxFusedChannelCount = 8;
+
+    static FusedKernel selectFusedKernel(audio_format_t sourceFormat,
+                                         int32_t sourceChannelCount,
+                                         audio_format_t sinkFormat,
+                                         int32_t sinkChannelCount);
+
+    template <typename S, typename D, bool kMonoSource>
+    void processFused(const void *source, void *destination, int32_t numFrames);
+
     std::unique_ptr<FLOWGRAPH_OUTER_NAMESPACE::flowgraph::FlowGraphSourceBuffered> mSource;
     std::unique_ptr<RESAMPLER_OUTER_NAMESPACE::resampler::MultiChannelResampler> mResampler;
     std::unique_ptr<FLOWGRAPH_OUTER_NAMESPACE::flowgraph::SampleRateConverter> mRateConverter;
@@ -128,6 +170,15 @@ private:
     float mTargetVolume = 1.0f;
     android::audio_utils::Balance mBalance;
     std::unique_ptr<FLOWGRAPH_OUTER_NAMESPACE::flowgraph::FlowGraphSink> mSink;
+
+    // Pass through and fused state, see isDirect().
+    bool mPassThrough = false;
+    FusedKernel mFusedKernel = nullptr;
+    int32_t mSinkChannelCount = 0;
+    int32_t mSourceBytesPerFrame = 0;
+    int32_t mSinkBytesPerFrame = 0;
+    const uint8_t *mDirectData = nullptr; // data of process() not read yet
+    int32_t mDirectFrames = 0;
 };
 
 
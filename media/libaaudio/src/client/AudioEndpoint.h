@@ -88,6 +88,14 @@ public:
      */
     bool isFreeRunning() const { return mFreeRunning; }
 
+    /**
+     * The result is not valid until after configure() is called.
+     *
+     * @return true if the data and the write counter are shared with other clients,
+     *         and only the read counter may be modified, see RingbufferFlags::SHARED_READ_ONLY
+     */
+    bool isSharedReadOnly() const { return mSharedReadOnly; }
+
     int32_t setBufferSizeInFrames(int32_t requestedFrames,
                                   int32_t *actualFrames);
     int32_t getBufferSizeInFrames() const;
@@ -117,6 +125,7 @@ private:
     std::unique_ptr<android::FifoBufferIndirect> mUpCommandQueue;
     std::unique_ptr<android::FifoBufferIndirect> mDataQueue;
     bool                    mFreeRunning{false};
+    bool                    mSharedReadOnly{false};
     android::fifo_counter_t mDataReadCounter{0}; // only used if free-running
     android::fifo_counter_t mDataWriteCounter{0}; // only used if free-running
 };
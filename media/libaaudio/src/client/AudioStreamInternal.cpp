@@ -229,6 +229,10 @@ aaudio_result_t AudioStreamInternal::open(const AudioStreamBuilder &builder) {
     if (result != AAUDIO_OK) {
         goto error;
     }
+    if (mAudioEndpoint->isSharedReadOnly()) {
+        // A shared capture ring was already running, so count frames from the current position.
+        mFramesOffsetFromService = -mAudioEndpoint->getDataReadCounter();
+    }
 
     if ((result = configureDataInformation(builder.getFramesPerDataCallback())) != AAUDIO_OK) {
         goto error;
@@ -290,6 +294,9 @@ aaudio_result_t AudioStreamInternal::configureDataInformation(int32_t callbackFr
     mClockModel.setFramesPerBurst(deviceFramesPerBurst);
 
     if (isDataCallbackSet()) {
+        // Also keep coalescing when reconfigured after standby.
+        const bool coalesceCallbacks = callbackFrames == AAUDIO_UNSPECIFIED
+                || mMaxCallbackFrames > mCallbackFrames;
         mCallbackFrames = callbackFrames;
         if (mCallbackFrames > getBufferCapacity() / 2) {
             ALOGW("%s - framesPerCallback too big = %d, capacity = %d",
@@ -303,7 +310,20 @@ aaudio_result_t AudioStreamInternal::configureDataInformation(int32_t callbackFr
             mCallbackFrames = getFramesPerBurst();
         }
 
-        const int32_t callbackBufferSize = mCallbackFrames * getBytesPerFrame();
+        // The app accepts any callback size, so output callbacks may be coalesced
+        // when the buffer is deep, see AudioStreamInternalPlay::waitForCallbackFrames().
+        mMaxCallbackFrames = mCallbackFrames;
+        if (coalesceCallbacks && getDirection() == AAUDIO_DIRECTION_OUTPUT) {
+            const int64_t coalescingFrames = static_cast<int64_t>(
+                    AAudioProperty_getCallbackCoalescingMicros()) * getSampleRate()
+                    / (AAUDIO_NANOS_PER_SECOND / AAUDIO_NANOS_PER_MICROSECOND);
+            const int64_t maxFrames = std::min<int64_t>(coalescingFrames,
+                                                        getBufferCapacity() / 2);
+            mMaxCallbackFrames = std::max<int64_t>(1, maxFrames / mCallbackFrames)
+                    * mCallbackFrames;
+        }
+
+        const int32_t callbackBufferSize = mMaxCallbackFrames * getBytesPerFrame();
         mCallbackBuffer = std::make_unique<uint8_t[]>(callbackBufferSize);
     }
 
@@ -900,7 +920,7 @@ aaudio_result_t AudioStreamInternal::processData(void *buffer, int32_t numFrames
                 ATRACE_INT("aaSlpNs", (int32_t)sleepForNanos);
             }
 
-            AudioClock::sleepUntilNanoTime(wakeTimeNanos);
+            sleepUntilNanoTime(wakeTimeNanos);
             currentTimeNanos = AudioClock::getNanoseconds();
         }
     }
@@ -920,6 +940,13 @@ void AudioStreamInternal::processTimestamp(uint64_t position, int64_t time) {
     mClockModel.processTimestamp(position, time);
 }
 
+double AudioStreamInternal::getWakeupsPerSecond() const {
+    const int64_t activeNanos = mCallbackActiveNanos.load();
+    return activeNanos > 0
+            ? mCallbackWakeups.load() * static_cast<double>(AAUDIO_NANOS_PER_SECOND) / activeNanos
+            : 0.0;
+}
+
 aaudio_result_t AudioStreamInternal::setBufferSize(int32_t requestedFrames) {
     const int32_t maximumSize = getBufferCapacity() - getFramesPerBurst();
     int32_t adjustedFrames = std::min(requestedFrames, maximumSize);
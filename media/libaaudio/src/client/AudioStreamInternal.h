@@ -17,6 +17,7 @@
 #ifndef ANDROID_AAUDIO_AUDIO_STREAM_INTERNAL_H
 #define ANDROID_AAUDIO_AUDIO_STREAM_INTERNAL_H
 
+#include <atomic>
 #include <stdint.h>
 #include <aaudio/AAudio.h>
 
@@ -67,6 +68,8 @@ public:
         return mXRunCount;
     }
 
+    double getWakeupsPerSecond() const override;
+
     aaudio_result_t registerThread() override;
 
     aaudio_result_t unregisterThread() override;
@@ -167,6 +170,22 @@ protected:
 
     std::unique_ptr<uint8_t[]> mCallbackBuffer;
     int32_t                  mCallbackFrames = 0;
+    // Several callbacks may be coalesced up to this size, see AAUDIO_PROP_CALLBACK_COALESCING_USEC.
+    // Equal to mCallbackFrames if the callbacks are not coalesced.
+    int32_t                  mMaxCallbackFrames = 0;
+
+    // Sleep of a blocking read or write, counted for the wakeup rate.
+    void sleepUntilNanoTime(int64_t wakeTimeNanos) {
+        mWakeupCount++;
+        AudioClock::sleepUntilNanoTime(wakeTimeNanos);
+    }
+
+    int32_t getWakeupDelayNanos() const { return mWakeupDelayNanos; }
+
+    // Wakeup statistics of the data callback thread.
+    std::atomic<int64_t>     mWakeupCount{0};
+    std::atomic<int64_t>     mCallbackWakeups{0};
+    std::atomic<int64_t>     mCallbackActiveNanos{0};
 
     // The service uses this for SHARED mode.
     bool                     mInService = false;  // Is this running in the client or the service?
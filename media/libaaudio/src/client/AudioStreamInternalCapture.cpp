@@ -141,6 +141,11 @@ aaudio_result_t AudioStreamInternalCapture::processDataNow(void *buffer, int32_t
         if (ATRACE_ENABLED()) {
             ATRACE_INT("aaOverRuns", mXRunCount);
         }
+    } else if (mAudioEndpoint->isSharedReadOnly()
+        && mAudioEndpoint->getFullFramesAvailable() > mAudioEndpoint->getBufferCapacityInFrames()) {
+        // The service does not wait for us in a shared capture ring, so the oldest data
+        // has been overwritten. The overrun is counted by the service, skip to the newest data.
+        advanceClientToMatchServerPosition(0 /*serverMargin*/);
     }
 
     // Read some data from the buffer.
@@ -220,8 +225,11 @@ aaudio_result_t AudioStreamInternalCapture::readNowWithConversion(void *buffer,
         // Continuously pull as much data as possible from the flowgraph into the byte buffer.
         // The return value of mFlowGraph.process is the number of frames actually pulled.
         while (framesAvailableInWrappingBuffer > 0 && framesLeftInByteBuffer > 0) {
-            const int32_t framesToReadFromWrappingBuffer = std::min(flowgraph::kDefaultBufferSize,
-                    framesAvailableInWrappingBuffer);
+            // The data is converted directly if the flowgraph passes through or is fused,
+            // so read as much as fits in the byte buffer.
+            const int32_t framesToReadFromWrappingBuffer = mFlowGraph.isDirect()
+                    ? std::min(framesLeftInByteBuffer, framesAvailableInWrappingBuffer)
+                    : std::min(flowgraph::kDefaultBufferSize, framesAvailableInWrappingBuffer);
 
             const int32_t numBytesToReadFromWrappingBuffer = getBytesPerDeviceFrame() *
                     framesToReadFromWrappingBuffer;
@@ -329,8 +329,12 @@ aaudio_result_t AudioStreamInternalPlay::writeNowWithConversion(const void *buff
         while (framesAvailableInWrappingBuffer > 0 && framesLeftInByteBuffer > 0) {
             int32_t framesToWriteFromByteBuffer = std::min(flowgraph::kDefaultBufferSize,
                     framesLeftInByteBuffer);
-            // If the wrapping buffer is running low, write one frame at a time.
-            if (framesAvailableInWrappingBuffer < flowgraph::kDefaultBufferSize) {
+            if (mFlowGraph.isDirect()) {
+                // The data is converted directly, so write as much as fits.
+                framesToWriteFromByteBuffer = std::min(framesAvailableInWrappingBuffer,
+                        framesLeftInByteBuffer);
+            } else if (framesAvailableInWrappingBuffer < flowgraph::kDefaultBufferSize) {
+                // If the wrapping buffer is running low, write one frame at a time.
                 framesToWriteFromByteBuffer = 1;
             }
 
@@ -403,12 +407,18 @@ void *AudioStreamInternalPlay::callbackLoop() {
     aaudio_result_t result = AAUDIO_OK;
     aaudio_data_callback_result_t callbackResult = AAUDIO_CALLBACK_RESULT_CONTINUE;
     if (!isDataCallbackSet()) return nullptr;
-    int64_t timeoutNanos = calculateReasonableTimeout(mCallbackFrames);
+    int64_t timeoutNanos = calculateReasonableTimeout(mMaxCallbackFrames);
+    mCoalescingLimitFrames = mMaxCallbackFrames;
+    mCoalescingXRunCount = getXRunCount();
+    const int64_t startNanos = AudioClock::getNanoseconds();
+    const int64_t startWakeups = mWakeupCount;
 
     // result might be a frame count
     while (mCallbackEnabled.load() && isActive() && (result >= 0)) {
+        const int32_t callbackFrames = waitForCallbackFrames();
+
         // Call application using the AAudio callback interface.
-        callbackResult = maybeCallDataCallback(mCallbackBuffer.get(), mCallbackFrames);
+        callbackResult = maybeCallDataCallback(mCallbackBuffer.get(), callbackFrames);
 
         // Write audio data to stream. This is a BLOCKING WRITE!
         // Write data regardless of the callbackResult because we assume the data
@@ -417,8 +427,8 @@ void *AudioStreamInternalPlay::callbackLoop() {
         // When it gets to the end of the sound it can partially fill
         // the last buffer with the end of the sound, then zero pad the buffer, then return STOP.
         // If the callback has no valid data then it should zero-fill the entire buffer.
-        result = write(mCallbackBuffer.get(), mCallbackFrames, timeoutNanos);
-        if ((result != mCallbackFrames)) {
+        result = write(mCallbackBuffer.get(), callbackFrames, timeoutNanos);
+        if ((result != callbackFrames)) {
             if (result >= 0) {
                 // Only wrote some of the frames requested. The stream can be disconnected
                 // or timed out.
@@ -436,11 +446,61 @@ void *AudioStreamInternalPlay::callbackLoop() {
         }
     }
 
+    mCallbackActiveNanos += AudioClock::getNanoseconds() - startNanos;
+    mCallbackWakeups += mWakeupCount - startWakeups;
+
     ALOGD("%s() exiting, result = %d, isActive() = %d <<<<<<<<<<<<<<",
           __func__, result, (int) isActive());
     return nullptr;
 }
 
+int32_t AudioStreamInternalPlay::waitForCallbackFrames() {
+    if (mMaxCallbackFrames <= mCallbackFrames
+            || getState() != AAUDIO_STREAM_STATE_STARTED
+            || mClockModel.isStarting()) {
+        return mCallbackFrames;
+    }
+
+    // Back off after an underrun, the app may not keep up with the larger callbacks.
+    const int32_t xRunCount = getXRunCount();
+    if (xRunCount != mCoalescingXRunCount) {
+        mCoalescingXRunCount = xRunCount;
+        mCoalescingLimitFrames = std::max(mCallbackFrames,
+                mCoalescingLimitFrames / 2 / mCallbackFrames * mCallbackFrames);
+        ALOGD("%s() underrun, coalesce at most %d frames", __func__, mCoalescingLimitFrames);
+    }
+
+    // Keep at least half of the buffer filled when the callback is called.
+    const int32_t callbackFrames = std::clamp(
+            getBufferSize() / 2 / mCallbackFrames * mCallbackFrames,
+            mCallbackFrames, mCoalescingLimitFrames);
+    if (callbackFrames == mCallbackFrames) {
+        return mCallbackFrames;
+    }
+
+    // Use the timing model to sleep until the device has read enough data
+    // to leave room for the whole callback in the buffer.
+    const int64_t deviceCallbackFrames = static_cast<int64_t>(callbackFrames)
+            * getDeviceSampleRate() / getSampleRate();
+    const int64_t targetReadPosition = mAudioEndpoint->getDataWriteCounter()
+            - getDeviceBufferSize() + deviceCallbackFrames;
+    int64_t wakeTimeNanos = mClockModel.convertPositionToTime(targetReadPosition);
+    if (!mAudioEndpoint->isFreeRunning()) {
+        wakeTimeNanos += getWakeupDelayNanos();
+    }
+    // Do not trust the model for more than the duration of the callback.
+    const int64_t currentTimeNanos = AudioClock::getNanoseconds();
+    wakeTimeNanos = std::min(wakeTimeNanos, currentTimeNanos
+            + callbackFrames * AAUDIO_NANOS_PER_SECOND / getSampleRate());
+    if (wakeTimeNanos > currentTimeNanos) {
+        if (ATRACE_ENABLED()) {
+            ATRACE_INT("aaCoalesce", callbackFrames);
+        }
+        sleepUntilNanoTime(wakeTimeNanos);
+    }
+    return callbackFrames;
+}
+
 //------------------------------------------------------------------------------
 // Implementation of PlayerBase
 status_t AudioStreamInternalPlay::doSetVolume() {
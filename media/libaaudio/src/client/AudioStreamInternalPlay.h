@@ -95,6 +95,16 @@ private:
     aaudio_result_t writeNowWithConversion(const void *buffer,
                                            int32_t numFrames);
 
+    /*
+     * Choose the size of the next data callback.
+     * If the buffer is deep then several callbacks are coalesced, and this sleeps until
+     * there is room for all of them. So the thread wakes up once per coalesced callback.
+     * @return number of frames for the next callback
+     */
+    int32_t waitForCallbackFrames();
+
+    int32_t mCoalescingLimitFrames = 0; // halved after an underrun
+    int32_t mCoalescingXRunCount = 0;   // underruns seen by waitForCallbackFrames()
 };
 
 } /* namespace aaudio */
@@ -19,6 +19,7 @@
 #include <log/log.h>
 
 #include <inttypes.h>
+#include <math.h>
 #include <stdint.h>
 #include <algorithm>
 
@@ -40,13 +41,24 @@ using namespace android::audio_utils;
 // A histogram of the lateness of the timestamps will be cleared when the stream is started.
 // It will be updated when the model is stable and receives a timestamp,
 // and dumped to the log when the stream is stopped.
+//
+// To capture a trace of the timestamps that can be replayed by test_clock_model:
+//    adb shell setprop aaudio.log_mask 2
+//    adb logcat -s IsochronousClockModel > trace.txt
+//    AAUDIO_CLOCK_MODEL_TRACE=trace.txt test_clock_model
+//
+// To use the drift tracking estimator:
+//    adb shell setprop aaudio.clock_model 1
 
 IsochronousClockModel::IsochronousClockModel()
 {
-    if ((AAudioProperty_getLogMask() & AAUDIO_LOG_CLOCK_MODEL_HISTOGRAM) != 0) {
+    const int32_t logMask = AAudioProperty_getLogMask();
+    if ((logMask & AAUDIO_LOG_CLOCK_MODEL_HISTOGRAM) != 0) {
         mHistogramMicros = std::make_unique<Histogram>(kHistogramBinCount,
                 kHistogramBinWidthMicros);
     }
+    mLogTrace = (logMask & AAUDIO_LOG_CLOCK_MODEL_TRACE) != 0;
+    mDriftTracking = AAudioProperty_getClockModel() == AAUDIO_CLOCK_MODEL_DRIFT_TRACKING;
     update();
 }
 
@@ -62,9 +74,14 @@ void IsochronousClockModel::start(int64_t nanoTime) {
     mState = STATE_STARTING;
     mConsecutiveVeryLateCount = 0;
     mDspStallCount = 0;
+    mLateEstimateMissCount = 0;
+    mDriftNanosPerSecond = 0.0;
     if (mHistogramMicros) {
         mHistogramMicros->clear();
     }
+    if (mLogTrace) {
+        ALOGD("%s() CSV config, %d, %d", __func__, mSampleRate, mFramesPerBurst);
+    }
 }
 
 void IsochronousClockModel::stop(int64_t nanoTime) {
@@ -73,6 +90,14 @@ void IsochronousClockModel::stop(int64_t nanoTime) {
           (int) (mMaxMeasuredLatenessNanos / 1000),
           mDspStallCount
     );
+    if (mDriftTracking) {
+        ALOGD("stop() late offset = %d micros, drift = %d nanos/sec, missed %d of %d",
+              (int) (getLateTimeOffsetNanos() / AAUDIO_NANOS_PER_MICROSECOND),
+              (int) mDriftNanosPerSecond,
+              mLateEstimateMissCount,
+              mFilterCount
+        );
+    }
     setPositionAndTime(convertTimeToPosition(nanoTime), nanoTime);
     // TODO should we set position?
     mState = STATE_STOPPED;
@@ -91,9 +116,11 @@ bool IsochronousClockModel::isRunning() const {
 
 void IsochronousClockModel::processTimestamp(int64_t framePosition, int64_t nanoTime) {
     mTimestampCount++;
-// Log position and time in CSV format so we can import it easily into spreadsheets.
-    //ALOGD("%s() CSV, %d, %lld, %lld", __func__,
-          //mTimestampCount, (long long)framePosition, (long long)nanoTime);
+    // Log position and time in CSV format so we can import it easily into spreadsheets.
+    if (mLogTrace) {
+        ALOGD("%s() CSV, %d, %lld, %lld", __func__,
+              mTimestampCount, (long long)framePosition, (long long)nanoTime);
+    }
     int64_t framesDelta = framePosition - mMarkerFramePosition;
     int64_t nanosDelta = nanoTime - mMarkerNanoTime;
     if (nanosDelta < 1000) {
@@ -128,15 +155,19 @@ void IsochronousClockModel::processTimestamp(int64_t framePosition, int64_t nano
         } else {
 //            ALOGD("processTimestamp() - advance to STATE_RUNNING");
             mState = STATE_RUNNING;
+            resetDriftFilter(nanoTime, latenessNanos);
         }
         break;
     case STATE_RUNNING:
         if (mHistogramMicros) {
             mHistogramMicros->add(latenessNanos / AAUDIO_NANOS_PER_MICROSECOND);
         }
+        if (mDriftTracking) {
+            nextConsecutiveVeryLateCount = trackDrift(framePosition, nanoTime,
+                                                      latenessNanos, expectedNanosDelta);
         // Modify estimated position based on lateness.
         // This affects the "early" side of the window, which controls output glitches.
-        if (latenessNanos < 0) {
+        } else if (latenessNanos < 0) {
             // Earlier than expected timestamp.
             // This data is probably more accurate, so use it.
             // Or we may be drifting due to a fast HW clock.
@@ -158,22 +189,7 @@ void IsochronousClockModel::processTimestamp(int64_t framePosition, int64_t nano
             // A pause causes a persistent lateness so we can detect it by counting
             // consecutive late timestamps.
             if (mConsecutiveVeryLateCount >= kVeryLateCountsNeededToTriggerJump) {
-                // Assume the timestamp is valid and let subsequent EARLY timestamps
-                // move the window quickly to the correct place.
-                setPositionAndTime(framePosition, nanoTime); // JUMP!
-                mDspStallCount++;
-                // Throttle the warnings but do not silence them.
-                // They indicate a bug that needs to be fixed!
-                if ((nanoTime - mLastJumpWarningTimeNanos) > AAUDIO_NANOS_PER_SECOND) {
-                    ALOGW("%s() - STATE_RUNNING - #%d, %5d micros VERY LATE! Force window jump"
-                          ", mDspStallCount = %d",
-                          __func__,
-                          mTimestampCount,
-                          (int) (latenessNanos / AAUDIO_NANOS_PER_MICROSECOND),
-                          mDspStallCount
-                    );
-                    mLastJumpWarningTimeNanos = nanoTime;
-                }
+                jumpToTimestamp(framePosition, nanoTime, latenessNanos);
             } else {
                 nextConsecutiveVeryLateCount = mConsecutiveVeryLateCount + 1;
                 driftForward(latenessNanos, expectedNanosDelta, framePosition);
@@ -230,6 +246,130 @@ void IsochronousClockModel::driftForward(int64_t latenessNanos,
 #endif
 }
 
+void IsochronousClockModel::jumpToTimestamp(int64_t framePosition,
+                                            int64_t nanoTime,
+                                            int64_t latenessNanos) {
+    // Assume the timestamp is valid and let subsequent EARLY timestamps
+    // move the window quickly to the correct place.
+    setPositionAndTime(framePosition, nanoTime); // JUMP!
+    mDspStallCount++;
+    // Throttle the warnings but do not silence them.
+    // They indicate a bug that needs to be fixed!
+    if ((nanoTime - mLastJumpWarningTimeNanos) > AAUDIO_NANOS_PER_SECOND) {
+        ALOGW("%s() - STATE_RUNNING - #%d, %5d micros VERY LATE! Force window jump"
+              ", mDspStallCount = %d",
+              __func__,
+              mTimestampCount,
+              (int) (latenessNanos / AAUDIO_NANOS_PER_MICROSECOND),
+              mDspStallCount
+        );
+        mLastJumpWarningTimeNanos = nanoTime;
+    }
+}
+
+// The drift tracking estimator runs a Kalman filter on the lateness of the timestamps
+// relative to the marker. The state is the expected lateness, which includes the
+// average delay due to sampling the clock at random times within a burst, and its rate
+// of change, which is the rate error of the DSP clock. The measurement noise is the
+// jitter of the timestamps, which is estimated from the innovations.
+//
+// The early side of the window is handled like the state machine: an early timestamp
+// moves the marker. On the late side the marker follows the estimated drift, and the
+// window covers kJitterSigmas standard deviations above the expected lateness.
+// Whenever the marker moves, the expected lateness is shifted by the same amount.
+int32_t IsochronousClockModel::trackDrift(int64_t framePosition,
+                                          int64_t nanoTime,
+                                          int64_t latenessNanos,
+                                          int64_t expectedNanosDelta) {
+    const double elapsedSeconds = predictLateness(nanoTime);
+    if (latenessNanos > mLatenessForJumpNanos) {
+        ALOGD("%s() - STATE_RUNNING - #%d, %5d micros VERY LATE, %d times",
+              __func__,
+              mTimestampCount,
+              (int) (latenessNanos / AAUDIO_NANOS_PER_MICROSECOND),
+              mConsecutiveVeryLateCount
+        );
+        // Probably a stall in the DSP, do not let it affect the jitter estimate.
+        if (mConsecutiveVeryLateCount < kVeryLateCountsNeededToTriggerJump) {
+            return mConsecutiveVeryLateCount + 1;
+        }
+        jumpToTimestamp(framePosition, nanoTime, latenessNanos);
+        // The lateness of this timestamp within its burst is unknown, so restart
+        // the level but keep the drift.
+        mLevelNanos = 0.0;
+        mCovariance[0][0] = mJitterVariance;
+        mCovariance[0][1] = mCovariance[1][0] = 0.0;
+        return 0;
+    }
+
+    if (mFilterCount >= kMinTimestampsForJitter && latenessNanos > getLateTimeOffsetNanos()) {
+        mLateEstimateMissCount++;
+    }
+    correctLateness(latenessNanos);
+
+    if (latenessNanos < 0) {
+        // Earlier than expected timestamp, this data is probably more accurate.
+        setPositionAndTime(framePosition, nanoTime);
+        mLevelNanos -= latenessNanos;
+    } else {
+        // Move the marker by the drift predicted since the last timestamp.
+        // A fast clock will be corrected by the early timestamps.
+        const int64_t driftNanos = std::clamp(
+                (int64_t) (mDriftNanosPerSecond * elapsedSeconds), (int64_t) 0, kMaxDriftNanos);
+        setPositionAndTime(framePosition, mMarkerNanoTime + expectedNanosDelta + driftNanos);
+        mLevelNanos -= driftNanos;
+    }
+    return 0;
+}
+
+void IsochronousClockModel::resetDriftFilter(int64_t nanoTime, int64_t latenessNanos) {
+    // Start with a jitter that gives about the same window as the state machine.
+    const double jitterNanos = mLatenessForDriftNanos / 2.0;
+    mJitterVariance = jitterNanos * jitterNanos;
+    mLevelNanos = latenessNanos;
+    mCovariance[0][0] = mJitterVariance;
+    mCovariance[0][1] = mCovariance[1][0] = 0.0;
+    mCovariance[1][1] = kInitialDriftNanosPerSecond * kInitialDriftNanosPerSecond;
+    mFilterNanoTime = nanoTime;
+    mFilterCount = 0;
+}
+
+double IsochronousClockModel::predictLateness(int64_t nanoTime) {
+    const double dt = (double) (nanoTime - mFilterNanoTime) / AAUDIO_NANOS_PER_SECOND;
+    mFilterNanoTime = nanoTime;
+    mLevelNanos += mDriftNanosPerSecond * dt;
+    // P = F * P * F' + Q, with F = [1 dt; 0 1]
+    mCovariance[0][0] += dt * (mCovariance[0][1] + mCovariance[1][0])
+            + dt * dt * mCovariance[1][1] + kLevelNoiseNanos2PerSecond * dt;
+    mCovariance[0][1] += dt * mCovariance[1][1];
+    mCovariance[1][0] = mCovariance[0][1];
+    mCovariance[1][1] += kDriftNoiseNanos2PerSecond3 * dt;
+    return dt;
+}
+
+void IsochronousClockModel::correctLateness(int64_t latenessNanos) {
+    const double innovation = latenessNanos - mLevelNanos;
+    const double innovationVariance = mCovariance[0][0] + mJitterVariance;
+    const double limit = kOutlierSigmas * sqrt(innovationVariance);
+    const double clippedInnovation = std::clamp(innovation, -limit, limit);
+
+    // Measurement z = level + jitter, so H = [1 0].
+    const double gainLevel = mCovariance[0][0] / innovationVariance;
+    const double gainDrift = mCovariance[1][0] / innovationVariance;
+    mLevelNanos += gainLevel * clippedInnovation;
+    mDriftNanosPerSecond += gainDrift * clippedInnovation;
+    mCovariance[1][1] -= gainDrift * mCovariance[0][1];
+    mCovariance[0][0] -= gainLevel * mCovariance[0][0];
+    mCovariance[0][1] -= gainLevel * mCovariance[0][1];
+    mCovariance[1][0] = mCovariance[0][1];
+
+    // The expected squared innovation is the variance of the level plus the jitter.
+    const double jitterVariance = mJitterVariance + kJitterSmoothing
+            * (clippedInnovation * clippedInnovation - innovationVariance);
+    mJitterVariance = std::max(jitterVariance, kMinJitterNanos * kMinJitterNanos);
+    mFilterCount++;
+}
+
 void IsochronousClockModel::setSampleRate(int32_t sampleRate) {
     mSampleRate = sampleRate;
     update();
@@ -293,7 +433,15 @@ int64_t IsochronousClockModel::convertTimeToPosition(int64_t nanoTime) const {
 }
 
 int32_t IsochronousClockModel::getLateTimeOffsetNanos() const {
-    return mMaxMeasuredLatenessNanos + kExtraLatenessNanos;
+    const int32_t maxLatenessOffsetNanos = mMaxMeasuredLatenessNanos + kExtraLatenessNanos;
+    if (!mDriftTracking || mState != STATE_RUNNING || mFilterCount < kMinTimestampsForJitter) {
+        return maxLatenessOffsetNanos;
+    }
+    const double sigmaNanos = sqrt(mCovariance[0][0] + mJitterVariance);
+    const double offsetNanos = mLevelNanos + (kJitterSigmas * sigmaNanos) + kExtraLatenessNanos;
+    // Never wider than the state machine.
+    return (int32_t) std::clamp(offsetNanos, (double) kExtraLatenessNanos,
+                                (double) maxLatenessOffsetNanos);
 }
 
 int64_t IsochronousClockModel::convertPositionToLatestTime(int64_t framePosition) const {
@@ -311,6 +459,12 @@ void IsochronousClockModel::dump() const {
     ALOGD("mFramesPerBurst      = %6d", mFramesPerBurst);
     ALOGD("mMaxMeasuredLatenessNanos = %6" PRId64, mMaxMeasuredLatenessNanos);
     ALOGD("mState               = %6d", mState);
+    if (mDriftTracking) {
+        ALOGD("mLevelNanos          = %6d", (int) mLevelNanos);
+        ALOGD("mDriftNanosPerSecond = %6d", (int) mDriftNanosPerSecond);
+        ALOGD("jitter nanos         = %6d", (int) sqrt(mJitterVariance));
+        ALOGD("late offset nanos    = %6d", getLateTimeOffsetNanos());
+    }
 }
 
 void IsochronousClockModel::dumpHistogram() const {
@@ -74,6 +74,27 @@ public:
         return mFramesPerBurst;
     }
 
+    /**
+     * Select the estimator of the late side of the window.
+     * The default is set by AAUDIO_PROP_CLOCK_MODEL.
+     *
+     * When enabled, a Kalman filter tracks the mean lateness of the timestamps, its drift
+     * and its jitter. The marker follows the estimated drift instead of fixed nudges,
+     * and the late offset is a few standard deviations above the mean lateness
+     * instead of the maximum lateness ever measured.
+     *
+     * This should be called before start().
+     *
+     * @param enabled true to use the drift tracking estimator
+     */
+    void setDriftTrackingEnabled(bool enabled) {
+        mDriftTracking = enabled;
+    }
+
+    bool isDriftTrackingEnabled() const {
+        return mDriftTracking;
+    }
+
     /**
      * Calculate an estimated time when the stream will be at that position.
      *
@@ -132,9 +153,21 @@ private:
     void driftForward(int64_t latenessNanos,
                       int64_t expectedNanosDelta,
                       int64_t framePosition);
+    void jumpToTimestamp(int64_t framePosition, int64_t nanoTime, int64_t latenessNanos);
     int32_t getLateTimeOffsetNanos() const;
     void update();
 
+    // Drift tracking estimator, see setDriftTrackingEnabled().
+    // @return the next value of mConsecutiveVeryLateCount
+    int32_t trackDrift(int64_t framePosition,
+                       int64_t nanoTime,
+                       int64_t latenessNanos,
+                       int64_t expectedNanosDelta);
+    void resetDriftFilter(int64_t nanoTime, int64_t latenessNanos);
+    // @return seconds elapsed since the previous timestamp
+    double predictLateness(int64_t nanoTime);
+    void correctLateness(int64_t latenessNanos);
+
     enum clock_model_state_t {
         STATE_STOPPED,
         STATE_STARTING,
@@ -158,6 +191,22 @@ private:
     static constexpr int32_t   kShifterForDrift = 6; // divide by 2^N
     static constexpr int32_t   kVeryLateCountsNeededToTriggerJump = 2;
 
+    // Number of standard deviations of the lateness covered by the late side of the window.
+    static constexpr double    kJitterSigmas = 3.0;
+    // Innovations are clipped to this many standard deviations when estimating the jitter
+    // so that a rare preemption does not widen the window for a long time.
+    static constexpr double    kOutlierSigmas = 4.0;
+    // Weight of each timestamp in the running estimate of the jitter variance.
+    static constexpr double    kJitterSmoothing = 1.0 / 64;
+    static constexpr double    kMinJitterNanos = 10.0 * AAUDIO_NANOS_PER_MICROSECOND;
+    // Process noise, as the variance added per second, of the lateness and of its drift.
+    static constexpr double    kLevelNoiseNanos2PerSecond = 4.0e8;  // (20 usec)^2
+    static constexpr double    kDriftNoiseNanos2PerSecond3 = 1.0e6; // (1 ppm)^2 per second
+    // Expected range of the rate error of the DSP clock.
+    static constexpr double    kInitialDriftNanosPerSecond = 100.0 * AAUDIO_NANOS_PER_MICROSECOND;
+    // Use the maximum lateness until the filter has settled.
+    static constexpr int32_t   kMinTimestampsForJitter = 32;
+
     static constexpr int32_t   kHistogramBinWidthMicros = 50;
     static constexpr int32_t   kHistogramBinCount       = 128;
 
@@ -180,6 +229,18 @@ private:
 
     int32_t             mTimestampCount = 0;  // For logging.
     int32_t             mDspStallCount = 0;  // For logging.
+    int32_t             mLateEstimateMissCount = 0;  // For logging.
+
+    bool                mDriftTracking{false};
+    bool                mLogTrace{false};     // AAUDIO_LOG_CLOCK_MODEL_TRACE
+
+    // State of the drift tracking filter, relative to the marker.
+    double              mLevelNanos{0.0};           // expected lateness
+    double              mDriftNanosPerSecond{0.0};  // rate of change of the lateness
+    double              mCovariance[2][2]{};        // of the level and the drift
+    double              mJitterVariance{0.0};       // of the lateness around the level
+    int64_t             mFilterNanoTime{0};         // time of the last update
+    int32_t             mFilterCount{0};            // timestamps since reset
 
     // distribution of timestamps relative to earliest
     std::unique_ptr<android::audio_utils::Histogram>   mHistogramMicros;
@@ -146,11 +146,15 @@ void AudioStream::logOpenActual() {
 
 void AudioStream::logReleaseBufferState() {
     if (mMetricsId.size() > 0) {
-        android::mediametrics::LogItem(mMetricsId)
-                .set(AMEDIAMETRICS_PROP_EVENT, AMEDIAMETRICS_PROP_EVENT_VALUE_RELEASE)
-                .set(AMEDIAMETRICS_PROP_BUFFERSIZEFRAMES, (int32_t) getBufferSize())
-                .set(AMEDIAMETRICS_PROP_UNDERRUN, (int32_t) getXRunCount())
-                .record();
+        android::mediametrics::LogItem item(mMetricsId);
+        item.set(AMEDIAMETRICS_PROP_EVENT, AMEDIAMETRICS_PROP_EVENT_VALUE_RELEASE)
+            .set(AMEDIAMETRICS_PROP_BUFFERSIZEFRAMES, (int32_t) getBufferSize())
+            .set(AMEDIAMETRICS_PROP_UNDERRUN, (int32_t) getXRunCount());
+        const double wakeupsPerSecond = getWakeupsPerSecond();
+        if (wakeupsPerSecond > 0.0) {
+            item.set(AMEDIAMETRICS_PROP_WAKEUPSPERSECOND, wakeupsPerSecond);
+        }
+        item.record();
     }
 }
 
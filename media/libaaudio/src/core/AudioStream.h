@@ -220,6 +220,13 @@ public:
         return AAUDIO_ERROR_UNIMPLEMENTED;
     }
 
+    /**
+     * @return average wakeups per second of the data callback thread, or 0 if unknown
+     */
+    virtual double getWakeupsPerSecond() const {
+        return 0.0;
+    }
+
     bool isActive() const {
         return mState == AAUDIO_STREAM_STATE_STARTING || mState == AAUDIO_STREAM_STATE_STARTED;
     }
@@ -53,15 +53,27 @@ FifoBufferIndirect::FifoBufferIndirect( int32_t   bytesPerFrame,
                         fifo_frames_t   capacityInFrames,
                         fifo_counter_t *readIndexAddress,
                         fifo_counter_t *writeIndexAddress,
-                        void *  dataStorageAddress
+                        void *  dataStorageAddress,
+                        bool    resetCounters
                         )
         : FifoBuffer(bytesPerFrame)
         , mExternalStorage(static_cast<uint8_t *>(dataStorageAddress))
 {
-    mFifo = std::make_unique<FifoControllerIndirect>(capacityInFrames,
+    auto fifo = std::make_unique<FifoControllerIndirect>(capacityInFrames,
                                        capacityInFrames,
                                        readIndexAddress,
-                                       writeIndexAddress);
+                                       writeIndexAddress,
+                                       resetCounters);
+    mFifoIndirect = fifo.get();
+    mFifo = std::move(fifo);
+}
+
+void FifoBufferIndirect::setWritePublishBatch(fifo_frames_t batchFrames) {
+    mFifoIndirect->setWritePublishBatch(batchFrames);
+}
+
+void FifoBufferIndirect::publishWriteCounter() {
+    mFifoIndirect->publishWriteCounter();
 }
 
 int32_t FifoBuffer::convertFramesToBytes(fifo_frames_t frames) {
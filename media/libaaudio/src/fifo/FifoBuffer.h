@@ -21,6 +21,7 @@
 #include <stdint.h>
 
 #include "FifoControllerBase.h"
+#include "FifoControllerIndirect.h"
 
 namespace android {
 
@@ -154,11 +155,21 @@ class FifoBufferIndirect : public FifoBuffer {
 public:
     // We use raw pointers because the memory may be
     // in the middle of an allocated block and cannot be deleted directly.
+    // If resetCounters is false then the counters keep their current values.
     FifoBufferIndirect(int32_t bytesPerFrame,
                        fifo_frames_t capacityInFrames,
                        fifo_counter_t* readCounterAddress,
                        fifo_counter_t* writeCounterAddress,
-                       void* dataStorageAddress);
+                       void* dataStorageAddress,
+                       bool resetCounters = true);
+
+    /**
+     * Only publish the write counter to shared memory every batchFrames,
+     * see FifoControllerIndirect::setWritePublishBatch().
+     */
+    void setWritePublishBatch(fifo_frames_t batchFrames);
+
+    void publishWriteCounter();
 
 private:
 
@@ -167,6 +178,7 @@ private:
     };
 
     uint8_t *mExternalStorage = nullptr;
+    FifoControllerIndirect *mFifoIndirect = nullptr; // owned by mFifo
 };
 
 }  // namespace android
@@ -53,8 +53,8 @@ public:
     }
 
 private:
-    std::atomic<fifo_counter_t> mReadCounter;
-    std::atomic<fifo_counter_t> mWriteCounter;
+    alignas(kFifoCounterAlignment) std::atomic<fifo_counter_t> mReadCounter;
+    alignas(kFifoCounterAlignment) std::atomic<fifo_counter_t> mWriteCounter;
 };
 
 }  // namespace android
@@ -17,6 +17,7 @@
 #ifndef FIFO_FIFO_CONTROLLER_BASE_H
 #define FIFO_FIFO_CONTROLLER_BASE_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 namespace android {
@@ -24,6 +25,13 @@ namespace android {
 typedef int64_t fifo_counter_t;
 typedef int32_t fifo_frames_t;
 
+/**
+ * Alignment of the read and write counters, so that the reader and the writer,
+ * which may run in different processes on different cores, do not bounce the same
+ * cache line when they advance their counter.
+ */
+constexpr size_t kFifoCounterAlignment = 64;
+
 /**
  * Manage the read/write indices of a circular buffer.
  *
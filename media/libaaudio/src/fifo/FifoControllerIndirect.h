@@ -33,16 +33,23 @@ namespace android {
 class FifoControllerIndirect : public FifoControllerBase {
 
 public:
+    /**
+     * @param resetCounters false to keep the current values of the counters,
+     *                      e.g. when attaching a reader to a FIFO that is already running
+     */
     FifoControllerIndirect(fifo_frames_t capacity,
                            fifo_frames_t threshold,
                            fifo_counter_t * readCounterAddress,
-                           fifo_counter_t * writeCounterAddress)
+                           fifo_counter_t * writeCounterAddress,
+                           bool resetCounters = true)
         : FifoControllerBase(capacity, threshold)
         , mReadCounterAddress((std::atomic<fifo_counter_t> *) readCounterAddress)
         , mWriteCounterAddress((std::atomic<fifo_counter_t> *) writeCounterAddress)
     {
-        setReadCounter(0);
-        setWriteCounter(0);
+        if (resetCounters) {
+            setReadCounter(0);
+            setWriteCounter(0);
+        }
     }
     virtual ~FifoControllerIndirect() = default;
 
@@ -56,16 +63,64 @@ public:
     }
 
     virtual fifo_counter_t getWriteCounter() override {
+        if (mWritePublishBatch > 0) {
+            return mLocalWriteCounter;
+        }
         return mWriteCounterAddress->load(std::memory_order_acquire);
     }
 
     virtual void setWriteCounter(fifo_counter_t count) override {
+        if (mWritePublishBatch > 0) {
+            mLocalWriteCounter = count;
+            fifo_counter_t pending = 0;
+            if (__builtin_sub_overflow(count, mPublishedWriteCounter, &pending)
+                    || pending < 0 || pending >= mWritePublishBatch) {
+                publishWriteCounter();
+            }
+            return;
+        }
         mWriteCounterAddress->store(count, std::memory_order_release);
     }
 
+    /**
+     * Batched position publish, for the writer only.
+     *
+     * The write counter in shared memory is only updated once at least batchFrames
+     * have been written since it was last published, or by publishWriteCounter().
+     * This reduces the traffic on the write counter cache line when the writer
+     * advances in small steps, at the cost of the reader seeing the data later.
+     * The writer must call publishWriteCounter() before it waits for the reader.
+     *
+     * @param batchFrames minimum number of frames to publish, 0 to publish every write
+     */
+    void setWritePublishBatch(fifo_frames_t batchFrames) {
+        if (mWritePublishBatch > 0) {
+            publishWriteCounter();
+        } else {
+            mLocalWriteCounter = mWriteCounterAddress->load(std::memory_order_acquire);
+            mPublishedWriteCounter = mLocalWriteCounter;
+        }
+        mWritePublishBatch = batchFrames > 0 ? batchFrames : 0;
+    }
+
+    /**
+     * Store the write counter to shared memory if a batch is pending.
+     */
+    void publishWriteCounter() {
+        if (mWritePublishBatch > 0 && mPublishedWriteCounter != mLocalWriteCounter) {
+            mWriteCounterAddress->store(mLocalWriteCounter, std::memory_order_release);
+            mPublishedWriteCounter = mLocalWriteCounter;
+        }
+    }
+
 private:
     std::atomic<fifo_counter_t> * mReadCounterAddress;
     std::atomic<fifo_counter_t> * mWriteCounterAddress;
+
+    // Batched position publish state, only used by the writer.
+    fifo_frames_t  mWritePublishBatch = 0;
+    fifo_counter_t mLocalWriteCounter = 0;
+    fifo_counter_t mPublishedWriteCounter = 0;
 };
 
 }  // namespace android
@@ -27,11 +27,12 @@ Limiter::Limiter(int32_t channelCount)
 }
 
 int32_t Limiter::onProcess(int32_t numFrames) {
-    const float *inputBuffer = input.getBuffer();
-    float *outputBuffer = output.getBuffer();
-
-    int32_t numSamples = numFrames * output.getSamplesPerFrame();
+    processSamples(input.getBuffer(), output.getBuffer(),
+            numFrames * output.getSamplesPerFrame());
+    return numFrames;
+}
 
+void Limiter::processSamples(const float *inputBuffer, float *outputBuffer, int32_t numSamples) {
     // Cache the last valid output to reduce memory read/write
     float lastValidOutput = mLastValidOutput;
 
@@ -44,24 +45,4 @@ int32_t Limiter::onProcess(int32_t numFrames) {
         *outputBuffer++ = lastValidOutput;
     }
     mLastValidOutput = lastValidOutput;
-
-    return numFrames;
-}
-
-float Limiter::processFloat(float in)
-{
-    float in_abs = fabsf(in);
-    if (in_abs <= 1) {
-        return in;
-    }
-    float out;
-    if (in_abs < kXWhenYis3Decibels) {
-        out = (kPolynomialSplineA * in_abs + kPolynomialSplineB) * in_abs + kPolynomialSplineC;
-    } else {
-        out = M_SQRT2;
-    }
-    if (in < 0) {
-        out = -out;
-    }
-    return out;
 }
@@ -18,6 +18,7 @@
 #define FLOWGRAPH_LIMITER_H
 
 #include <atomic>
+#include <math.h>
 #include <unistd.h>
 #include <sys/types.h>
 
@@ -35,6 +36,25 @@ public:
         return "Limiter";
     }
 
+    /**
+     * Limit numSamples interleaved samples from inputBuffer into outputBuffer,
+     * as onProcess() does for the ports. This allows the limiter to be applied
+     * outside of a graph. The buffers may be the same.
+     */
+    void processSamples(const float *inputBuffer, float *outputBuffer, int32_t numSamples);
+
+    /**
+     * Limit one sample, as processSamples() does.
+     * This is inline so that it can be fused with other conversions.
+     */
+    float processSample(float in) {
+        // Use the previous output if the input is NaN
+        if (!isnan(in)) {
+            mLastValidOutput = processFloat(in);
+        }
+        return mLastValidOutput;
+    }
+
 private:
     // These numbers are based on a polynomial spline for a quadratic solution Ax^2 + Bx + C
     // The range is up to 3 dB, (10^(3/20)), to match AudioTrack for float data.
@@ -53,7 +73,23 @@ private:
      * The derivative of the spline is 1 at 1 and 0 at kXWhenYis3Decibels.
      * This way, the graph is both continuous and differentiable.
      */
-    float processFloat(float in);
+    float processFloat(float in) {
+        float in_abs = fabsf(in);
+        if (in_abs <= 1) {
+            return in;
+        }
+        float out;
+        if (in_abs < kXWhenYis3Decibels) {
+            out = (kPolynomialSplineA * in_abs + kPolynomialSplineB) * in_abs
+                    + kPolynomialSplineC;
+        } else {
+            out = M_SQRT2;
+        }
+        if (in < 0) {
+            out = -out;
+        }
+        return out;
+    }
 
     // Use the previous valid output for NaN inputs
     float mLastValidOutput = 0.0f;
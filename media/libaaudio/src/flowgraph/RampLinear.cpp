@@ -33,7 +33,7 @@ void RampLinear::setLengthInFrames(int32_t frames) {
 void RampLinear::setTarget(float target) {
     mTarget.store(target);
     // If the ramp has not been used then start immediately at this level.
-    if (mLastCallCount == kInitialCallCount) {
+    if (mLastCallCount == kInitialCallCount && !mUpdated) {
         forceCurrent(target);
     }
 }
@@ -42,11 +42,13 @@ float RampLinear::interpolateCurrent() {
     return mLevelTo - (mRemaining * mScaler);
 }
 
-int32_t RampLinear::onProcess(int32_t numFrames) {
-    const float *inputBuffer = input.getBuffer();
-    float *outputBuffer = output.getBuffer();
-    int32_t channelCount = output.getSamplesPerFrame();
+void RampLinear::reset() {
+    FlowGraphFilter::reset();
+    mUpdated = false;
+}
 
+bool RampLinear::updateRamp() {
+    mUpdated = true;
     float target = getTarget();
     if (target != mLevelTo) {
         // Start new ramp. Continue from previous level.
@@ -55,6 +57,21 @@ int32_t RampLinear::onProcess(int32_t numFrames) {
         mRemaining = mLengthInFrames;
         mScaler = (mLevelTo - mLevelFrom) / mLengthInFrames; // for interpolation
     }
+    return isRamping();
+}
+
+float RampLinear::nextLevel() {
+    const float level = interpolateCurrent();
+    mRemaining--;
+    return level;
+}
+
+int32_t RampLinear::onProcess(int32_t numFrames) {
+    const float *inputBuffer = input.getBuffer();
+    float *outputBuffer = output.getBuffer();
+    int32_t channelCount = output.getSamplesPerFrame();
+
+    updateRamp();
 
     int32_t framesLeft = numFrames;
 
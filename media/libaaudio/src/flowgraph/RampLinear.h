@@ -78,6 +78,35 @@ public:
         return "RampLinear";
     }
 
+    void reset() override;
+
+    /**
+     * Start a new ramp if the target has changed, as onProcess() does.
+     * This and nextLevel() allow the ramp to be applied to data outside of a graph,
+     * for example by a conversion that is fused with other nodes.
+     *
+     * @return true if a ramp is in progress
+     */
+    bool updateRamp();
+
+    bool isRamping() const {
+        return mRemaining > 0;
+    }
+
+    /**
+     * Advance a ramp in progress by one frame.
+     *
+     * @return level of the frame
+     */
+    float nextLevel();
+
+    /**
+     * @return level at the end of the ramp, or the current level if not ramping
+     */
+    float getLevelTo() const {
+        return mLevelTo;
+    }
+
 private:
 
     float interpolateCurrent();
@@ -89,6 +118,7 @@ private:
     float               mScaler          = 0.0f;
     float               mLevelFrom       = 0.0f;
     float               mLevelTo         = 0.0f;
+    bool                mUpdated         = false; // updateRamp() called since reset()
 };
 
 } /* namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph */
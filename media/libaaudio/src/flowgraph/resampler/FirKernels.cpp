@@ -0,0 +1,306 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FirKernels.h"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RESAMPLER_USE_NEON 1
+#elif defined(__SSE2__)
+#include <immintrin.h>
+#define RESAMPLER_USE_SSE2 1
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RESAMPLER_USE_AVX2 1
+#endif
+#endif
+
+using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
+
+namespace {
+
+// Portable versions, these add the products in the same order as the original loops.
+
+float monoScalar(const float *samples, const float *coefficients, int32_t numTaps) {
+    float sum = 0.0f;
+    for (int32_t i = 0; i < numTaps; i++) {
+        sum += *samples++ * *coefficients++;
+    }
+    return sum;
+}
+
+void stereoScalar(const float *samples, const float *coefficients, int32_t numTaps,
+                  float *frame) {
+    float left = 0.0f;
+    float right = 0.0f;
+    for (int32_t i = 0; i < numTaps; i++) {
+        const float coefficient = *coefficients++;
+        left += *samples++ * coefficient;
+        right += *samples++ * coefficient;
+    }
+    frame[0] = left;
+    frame[1] = right;
+}
+
+void stereoDualScalar(const float *samples, const float *coefficients1,
+                      const float *coefficients2, int32_t numTaps,
+                      float *frame1, float *frame2) {
+    float left1 = 0.0f;
+    float right1 = 0.0f;
+    float left2 = 0.0f;
+    float right2 = 0.0f;
+    for (int32_t i = 0; i < numTaps; i++) {
+        const float coefficient1 = *coefficients1++;
+        const float coefficient2 = *coefficients2++;
+        const float left = *samples++;
+        const float right = *samples++;
+        left1 += left * coefficient1;
+        right1 += right * coefficient1;
+        left2 += left * coefficient2;
+        right2 += right * coefficient2;
+    }
+    frame1[0] = left1;
+    frame1[1] = right1;
+    frame2[0] = left2;
+    frame2[1] = right2;
+}
+
+constexpr FirKernels kScalarKernels = {
+    "scalar",
+    monoScalar,
+    stereoScalar,
+    stereoDualScalar,
+};
+
+#if RESAMPLER_USE_NEON
+
+inline float32x2_t addHalves(float32x4_t sum) {
+    return vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+}
+
+float monoNeon(const float *samples, const float *coefficients, int32_t numTaps) {
+    float32x4_t sum = vdupq_n_f32(0.0f);
+    for (int32_t i = 0; i < numTaps; i += 4) {
+        sum = vmlaq_f32(sum, vld1q_f32(samples + i), vld1q_f32(coefficients + i));
+    }
+    const float32x2_t half = addHalves(sum);
+    return vget_lane_f32(vpadd_f32(half, half), 0);
+}
+
+// The coefficients of 4 taps are duplicated to match the L R L R layout of the samples.
+void stereoNeon(const float *samples, const float *coefficients, int32_t numTaps,
+                float *frame) {
+    float32x4_t sum = vdupq_n_f32(0.0f);
+    for (int32_t i = 0; i < numTaps; i += 4) {
+        const float32x4x2_t c = vzipq_f32(vld1q_f32(coefficients + i),
+                                          vld1q_f32(coefficients + i));
+        sum = vmlaq_f32(sum, vld1q_f32(samples), c.val[0]);
+        sum = vmlaq_f32(sum, vld1q_f32(samples + 4), c.val[1]);
+        samples += 8;
+    }
+    vst1_f32(frame, addHalves(sum));
+}
+
+void stereoDualNeon(const float *samples, const float *coefficients1,
+                    const float *coefficients2, int32_t numTaps,
+                    float *frame1, float *frame2) {
+    float32x4_t sum1 = vdupq_n_f32(0.0f);
+    float32x4_t sum2 = vdupq_n_f32(0.0f);
+    for (int32_t i = 0; i < numTaps; i += 4) {
+        const float32x4_t x0 = vld1q_f32(samples);
+        const float32x4_t x1 = vld1q_f32(samples + 4);
+        const float32x4x2_t c1 = vzipq_f32(vld1q_f32(coefficients1 + i),
+                                           vld1q_f32(coefficients1 + i));
+        const float32x4x2_t c2 = vzipq_f32(vld1q_f32(coefficients2 + i),
+                                           vld1q_f32(coefficients2 + i));
+        sum1 = vmlaq_f32(sum1, x0, c1.val[0]);
+        sum1 = vmlaq_f32(sum1, x1, c1.val[1]);
+        sum2 = vmlaq_f32(sum2, x0, c2.val[0]);
+        sum2 = vmlaq_f32(sum2, x1, c2.val[1]);
+        samples += 8;
+    }
+    vst1_f32(frame1, addHalves(sum1));
+    vst1_f32(frame2, addHalves(sum2));
+}
+
+constexpr FirKernels kNeonKernels = {
+    "neon",
+    monoNeon,
+    stereoNeon,
+    stereoDualNeon,
+};
+
+#endif // RESAMPLER_USE_NEON
+
+#if RESAMPLER_USE_SSE2
+
+// @return a + b for the low and high halves, as L R in the low half
+inline __m128 addHalves(__m128 sum) {
+    return _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+}
+
+inline void storeStereo(float *frame, __m128 sum) {
+    _mm_storel_pi(reinterpret_cast<__m64 *>(frame), addHalves(sum));
+}
+
+float monoSse2(const float *samples, const float *coefficients, int32_t numTaps) {
+    __m128 sum = _mm_setzero_ps();
+    for (int32_t i = 0; i < numTaps; i += 4) {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(samples + i),
+                                         _mm_loadu_ps(coefficients + i)));
+    }
+    const __m128 half = addHalves(sum);
+    return _mm_cvtss_f32(_mm_add_ss(half, _mm_shuffle_ps(half, half, 1)));
+}
+
+void stereoSse2(const float *samples, const float *coefficients, int32_t numTaps,
+                float *frame) {
+    __m128 sum = _mm_setzero_ps();
+    for (int32_t i = 0; i < numTaps; i += 4) {
+        const __m128 c = _mm_loadu_ps(coefficients + i);
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(samples), _mm_unpacklo_ps(c, c)));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(samples + 4), _mm_unpackhi_ps(c, c)));
+        samples += 8;
+    }
+    storeStereo(frame, sum);
+}
+
+void stereoDualSse2(const float *samples, const float *coefficients1,
+                    const float *coefficients2, int32_t numTaps,
+                    float *frame1, float *frame2) {
+    __m128 sum1 = _mm_setzero_ps();
+    __m128 sum2 = _mm_setzero_ps();
+    for (int32_t i = 0; i < numTaps; i += 4) {
+        const __m128 x0 = _mm_loadu_ps(samples);
+        const __m128 x1 = _mm_loadu_ps(samples + 4);
+        const __m128 c1 = _mm_loadu_ps(coefficients1 + i);
+        const __m128 c2 = _mm_loadu_ps(coefficients2 + i);
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(x0, _mm_unpacklo_ps(c1, c1)));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(x1, _mm_unpackhi_ps(c1, c1)));
+        sum2 = _mm_add_ps(sum2, _mm_mul_ps(x0, _mm_unpacklo_ps(c2, c2)));
+        sum2 = _mm_add_ps(sum2, _mm_mul_ps(x1, _mm_unpackhi_ps(c2, c2)));
+        samples += 8;
+    }
+    storeStereo(frame1, sum1);
+    storeStereo(frame2, sum2);
+}
+
+constexpr FirKernels kSse2Kernels = {
+    "sse2",
+    monoSse2,
+    stereoSse2,
+    stereoDualSse2,
+};
+
+#endif // RESAMPLER_USE_SSE2
+
+#if RESAMPLER_USE_AVX2
+
+#define RESAMPLER_TARGET_AVX2 __attribute__((target("avx2,fma")))
+
+RESAMPLER_TARGET_AVX2
+float monoAvx2(const float *samples, const float *coefficients, int32_t numTaps) {
+    __m256 sum = _mm256_setzero_ps();
+    int32_t i = 0;
+    for (; i + 8 <= numTaps; i += 8) {
+        sum = _mm256_fmadd_ps(_mm256_loadu_ps(samples + i), _mm256_loadu_ps(coefficients + i),
+                              sum);
+    }
+    __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+    if (i < numTaps) { // 4 taps left
+        sum4 = _mm_fmadd_ps(_mm_loadu_ps(samples + i), _mm_loadu_ps(coefficients + i), sum4);
+    }
+    const __m128 half = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+    return _mm_cvtss_f32(_mm_add_ss(half, _mm_shuffle_ps(half, half, 1)));
+}
+
+// Duplicate 4 coefficients to c0 c0 c1 c1 c2 c2 c3 c3, to match 4 stereo frames.
+RESAMPLER_TARGET_AVX2
+inline __m256 loadStereoCoefficients(const float *coefficients) {
+    const __m256i index = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+    return _mm256_permutevar8x32_ps(_mm256_castps128_ps256(_mm_loadu_ps(coefficients)), index);
+}
+
+RESAMPLER_TARGET_AVX2
+inline __m128 addHalvesAvx2(__m256 sum) {
+    const __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+    return _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+}
+
+RESAMPLER_TARGET_AVX2
+void stereoAvx2(const float *samples, const float *coefficients, int32_t numTaps,
+                float *frame) {
+    __m256 sum = _mm256_setzero_ps();
+    for (int32_t i = 0; i < numTaps; i += 4) {
+        sum = _mm256_fmadd_ps(_mm256_loadu_ps(samples), loadStereoCoefficients(coefficients + i),
+                              sum);
+        samples += 8;
+    }
+    _mm_storel_pi(reinterpret_cast<__m64 *>(frame), addHalvesAvx2(sum));
+}
+
+RESAMPLER_TARGET_AVX2
+void stereoDualAvx2(const float *samples, const float *coefficients1,
+                    const float *coefficients2, int32_t numTaps,
+                    float *frame1, float *frame2) {
+    __m256 sum1 = _mm256_setzero_ps();
+    __m256 sum2 = _mm256_setzero_ps();
+    for (int32_t i = 0; i < numTaps; i += 4) {
+        const __m256 x = _mm256_loadu_ps(samples);
+        sum1 = _mm256_fmadd_ps(x, loadStereoCoefficients(coefficients1 + i), sum1);
+        sum2 = _mm256_fmadd_ps(x, loadStereoCoefficients(coefficients2 + i), sum2);
+        samples += 8;
+    }
+    _mm_storel_pi(reinterpret_cast<__m64 *>(frame1), addHalvesAvx2(sum1));
+    _mm_storel_pi(reinterpret_cast<__m64 *>(frame2), addHalvesAvx2(sum2));
+}
+
+constexpr FirKernels kAvx2Kernels = {
+    "avx2",
+    monoAvx2,
+    stereoAvx2,
+    stereoDualAvx2,
+};
+
+bool isAvx2Supported() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+#endif // RESAMPLER_USE_AVX2
+
+} // namespace
+
+std::vector<const FirKernels *> RESAMPLER_OUTER_NAMESPACE::resampler::getSupportedFirKernels() {
+    std::vector<const FirKernels *> kernels{&kScalarKernels};
+#if RESAMPLER_USE_NEON
+    kernels.push_back(&kNeonKernels);
+#endif
+#if RESAMPLER_USE_SSE2
+    kernels.push_back(&kSse2Kernels);
+#endif
+#if RESAMPLER_USE_AVX2
+    if (isAvx2Supported()) {
+        kernels.push_back(&kAvx2Kernels);
+    }
+#endif
+    return kernels;
+}
+
+const FirKernels &RESAMPLER_OUTER_NAMESPACE::resampler::getFirKernels() {
+    // The last supported kernels are the fastest.
+    static const FirKernels &kernels = *getSupportedFirKernels().back();
+    return kernels;
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RESAMPLER_FIR_KERNELS_H
+#define RESAMPLER_FIR_KERNELS_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "ResamplerDefinitions.h"
+
+namespace RESAMPLER_OUTER_NAMESPACE::resampler {
+
+/**
+ * Inner loops of the FIR filters of the resamplers.
+ *
+ * The samples are the interleaved frames of the delay line, read forward from the cursor,
+ * and there is one coefficient per tap. The number of taps must be a multiple of 4.
+ *
+ * There are SIMD versions for NEON and SSE2, which are selected when compiling,
+ * and one for AVX2 with FMA, which is selected at run time if the CPU supports it.
+ * They add the products in a different order than the scalar version,
+ * so the results may differ by rounding.
+ */
+struct FirKernels {
+    const char *name;
+
+    // @return sum of samples[i] * coefficients[i]
+    float (*mono)(const float *samples, const float *coefficients, int32_t numTaps);
+
+    // Filter two channels with the same coefficients.
+    // @param frame receives the left and right sums
+    void (*stereo)(const float *samples, const float *coefficients, int32_t numTaps,
+                   float *frame);
+
+    // Filter two channels with two sets of coefficients, for interpolating between phases.
+    // @param frame1 receives the left and right sums for coefficients1
+    // @param frame2 receives the left and right sums for coefficients2
+    void (*stereoDual)(const float *samples, const float *coefficients1,
+                       const float *coefficients2, int32_t numTaps,
+                       float *frame1, float *frame2);
+};
+
+/**
+ * @return the fastest kernels supported by this CPU, selected on the first call
+ */
+const FirKernels &getFirKernels();
+
+/**
+ * @return all the kernels supported by this CPU, starting with the portable C++ ones,
+ *         for testing and benchmarking
+ */
+std::vector<const FirKernels *> getSupportedFirKernels();
+
+} /* namespace RESAMPLER_OUTER_NAMESPACE::resampler */
+
+#endif //RESAMPLER_FIR_KERNELS_H
@@ -32,6 +32,7 @@ MultiChannelResampler::MultiChannelResampler(const MultiChannelResampler::Builde
         , mX(static_cast<size_t>(builder.getChannelCount())
                 * static_cast<size_t>(builder.getNumTaps()) * 2)
         , mSingleFrame(builder.getChannelCount())
+        , mFirKernels(getFirKernels())
         , mChannelCount(builder.getChannelCount())
         {
     // Reduce sample rates to the smallest ratio.
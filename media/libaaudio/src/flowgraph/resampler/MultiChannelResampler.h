@@ -34,6 +34,8 @@
 #include "HyperbolicCosineWindow.h"
 #endif
 
+#include "FirKernels.h"
+
 #include "ResamplerDefinitions.h"
 
 namespace RESAMPLER_OUTER_NAMESPACE::resampler {
@@ -258,6 +260,7 @@ protected:
     int                  mCursor = 0;
     std::vector<float>   mX;           // delayed input values for the FIR
     std::vector<float>   mSingleFrame; // one frame for temporary use
+    const FirKernels    &mFirKernels;  // SIMD inner loops for this CPU
     int32_t              mIntegerPhase = 0;
     int32_t              mNumerator = 0;
     int32_t              mDenominator = 0;
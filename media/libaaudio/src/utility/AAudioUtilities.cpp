@@ -606,6 +606,46 @@ int32_t AAudioProperty_getMinimumSleepMicros() {
     return prop;
 }
 
+int32_t AAudioProperty_getCallbackCoalescingMicros() {
+    const int32_t minMicros = 0; // disabled
+    const int32_t defaultMicros = 20 * 1000; // arbitrary, a few bursts of a typical MMAP stream
+    const int32_t maxMicros = 100 * 1000; // arbitrary, keep the buffer responsive
+    int32_t prop = property_get_int32(AAUDIO_PROP_CALLBACK_COALESCING_USEC, defaultMicros);
+    if (prop < minMicros) {
+        ALOGW("AAudioProperty_getCallbackCoalescingMicros: clipped %d to %d", prop, minMicros);
+        prop = minMicros;
+    } else if (prop > maxMicros) {
+        ALOGW("AAudioProperty_getCallbackCoalescingMicros: clipped %d to %d", prop, maxMicros);
+        prop = maxMicros;
+    }
+    return prop;
+}
+
+int32_t AAudioProperty_getEndpointLingerMillis() {
+    const int32_t minMillis = 0; // disabled
+    const int32_t defaultMillis = 0; // keep the previous behavior unless a device opts in
+    const int32_t maxMillis = 10 * 1000; // arbitrary, do not hold the HAL stream for long
+    int32_t prop = property_get_int32(AAUDIO_PROP_ENDPOINT_LINGER_MSEC, defaultMillis);
+    if (prop < minMillis) {
+        ALOGW("AAudioProperty_getEndpointLingerMillis: clipped %d to %d", prop, minMillis);
+        prop = minMillis;
+    } else if (prop > maxMillis) {
+        ALOGW("AAudioProperty_getEndpointLingerMillis: clipped %d to %d", prop, maxMillis);
+        prop = maxMillis;
+    }
+    return prop;
+}
+
+int32_t AAudioProperty_getClockModel() {
+    int32_t prop = property_get_int32(AAUDIO_PROP_CLOCK_MODEL, AAUDIO_CLOCK_MODEL_STATE_MACHINE);
+    if (prop != AAUDIO_CLOCK_MODEL_STATE_MACHINE && prop != AAUDIO_CLOCK_MODEL_DRIFT_TRACKING) {
+        ALOGW("AAudioProperty_getClockModel: invalid %d, use %d",
+                prop, AAUDIO_CLOCK_MODEL_STATE_MACHINE);
+        prop = AAUDIO_CLOCK_MODEL_STATE_MACHINE;
+    }
+    return prop;
+}
+
 static int32_t AAudioProperty_getMMapOffsetMicros(const char *functionName,
         const char *propertyName) {
     const int32_t minMicros = -20000; // arbitrary
@@ -152,6 +152,42 @@ int32_t AAudioProperty_getWakeupDelayMicros();
 int32_t AAudioProperty_getMinimumSleepMicros();
 #define AAUDIO_PROP_MINIMUM_SLEEP_USEC      "aaudio.minimum_sleep_usec"
 
+/**
+ * Read a system property that specifies the longest data callback of an output stream
+ * into which several callbacks may be coalesced when the buffer is deep.
+ * This reduces the number of wakeups. Zero disables the coalescing.
+ *
+ * @return maximum duration of a coalesced callback in microseconds
+ */
+int32_t AAudioProperty_getCallbackCoalescingMicros();
+#define AAUDIO_PROP_CALLBACK_COALESCING_USEC "aaudio.callback_coalescing_usec"
+
+/**
+ * Read a system property that specifies how long the AAudio service keeps an endpoint
+ * open after its last stream is closed, so that it can be reused by the next stream
+ * with a matching configuration. Zero closes the endpoint immediately.
+ *
+ * @return linger time in milliseconds
+ */
+int32_t AAudioProperty_getEndpointLingerMillis();
+#define AAUDIO_PROP_ENDPOINT_LINGER_MSEC "aaudio.endpoint_linger_msec"
+
+// Values for AAUDIO_PROP_CLOCK_MODEL.
+// The state machine only ever widens the late side of the timing window.
+#define AAUDIO_CLOCK_MODEL_STATE_MACHINE   0
+// Estimate the drift and jitter of the DSP clock with a Kalman filter.
+// This gives a narrower window when the timestamps are regular.
+#define AAUDIO_CLOCK_MODEL_DRIFT_TRACKING  1
+
+/**
+ * Read a system property that selects the estimator of the IsochronousClockModel.
+ * This must be set before the stream is opened.
+ *
+ * @return AAUDIO_CLOCK_MODEL_STATE_MACHINE or AAUDIO_CLOCK_MODEL_DRIFT_TRACKING
+ */
+int32_t AAudioProperty_getClockModel();
+#define AAUDIO_PROP_CLOCK_MODEL "aaudio.clock_model"
+
 /**
  * Read a system property that specifies an offset that will be added to MMAP timestamps.
  * This can be used to correct bias in the timestamp.
@@ -169,7 +205,8 @@ int32_t AAudioProperty_getOutputMMapOffsetMicros();
 // These are powers of two that can be combined as a bit mask.
 // AAUDIO_LOG_CLOCK_MODEL_HISTOGRAM must be enabled before the stream is opened.
 #define AAUDIO_LOG_CLOCK_MODEL_HISTOGRAM   1
-#define AAUDIO_LOG_RESERVED_2              2
+// Log the timestamps received by the clock model so they can be replayed by test_clock_model.
+#define AAUDIO_LOG_CLOCK_MODEL_TRACE       2
 #define AAUDIO_LOG_RESERVED_4              4
 #define AAUDIO_LOG_RESERVED_8              8
 
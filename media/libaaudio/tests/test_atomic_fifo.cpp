@@ -387,3 +387,81 @@ TEST(test_fifo_buffer, fifo_full_wrap) {
     TestFifoBuffer tester(capacity);
     tester.checkFullWrap();
 }
+
+TEST(test_fifo_buffer, fifo_batched_write_publish) {
+    constexpr int capacity = 64; // arbitrary
+    constexpr int batch = 16;
+    fifo_counter_t readCounter = 0;
+    fifo_counter_t writeCounter = 0;
+    int16_t storage[capacity]{};
+    int16_t data[capacity]{};
+    FifoBufferIndirect writer(sizeof(int16_t), capacity, &readCounter, &writeCounter, storage);
+    writer.setWritePublishBatch(batch);
+
+    // Writes smaller than the batch are only visible to the writer.
+    ASSERT_EQ(batch / 2, writer.write(data, batch / 2));
+    EXPECT_EQ(batch / 2, writer.getWriteCounter());
+    EXPECT_EQ(batch / 2, writer.getFullFramesAvailable());
+    EXPECT_EQ(0, writeCounter);
+
+    // Published once the batch is complete.
+    ASSERT_EQ(batch / 2, writer.write(data, batch / 2));
+    EXPECT_EQ(batch, writeCounter);
+
+    // Or when requested.
+    ASSERT_EQ(1, writer.write(data, 1));
+    EXPECT_EQ(batch, writeCounter);
+    writer.publishWriteCounter();
+    EXPECT_EQ(batch + 1, writeCounter);
+
+    // Setting the counter backwards publishes immediately.
+    writer.setWriteCounter(0);
+    EXPECT_EQ(0, writeCounter);
+
+    // Disabling the batch publishes the pending frames.
+    ASSERT_EQ(1, writer.write(data, 1));
+    EXPECT_EQ(0, writeCounter);
+    writer.setWritePublishBatch(0);
+    EXPECT_EQ(1, writeCounter);
+    ASSERT_EQ(1, writer.write(data, 1));
+    EXPECT_EQ(2, writeCounter);
+}
+
+TEST(test_fifo_buffer, fifo_shared_ring_readers) {
+    constexpr int capacity = 64; // arbitrary
+    constexpr int burst = 16;
+    fifo_counter_t ringReadCounter = 0;
+    fifo_counter_t writeCounter = 0;
+    int16_t storage[capacity]{};
+    int16_t data[burst];
+    FifoBufferIndirect ring(sizeof(int16_t), capacity, &ringReadCounter, &writeCounter, storage);
+    for (int i = 0; i < burst; i++) {
+        data[i] = i;
+    }
+    ASSERT_EQ(burst, ring.write(data, burst));
+
+    // A reader attached to the running ring keeps the write counter.
+    fifo_counter_t readCounter = writeCounter;
+    FifoBufferIndirect reader(sizeof(int16_t), capacity, &readCounter, &writeCounter, storage,
+                              false /* resetCounters */);
+    EXPECT_EQ(burst, writeCounter);
+    EXPECT_EQ(burst, reader.getReadCounter());
+    EXPECT_EQ(0, reader.getFullFramesAvailable());
+
+    // The reader sees the data written to the ring without a copy.
+    ring.setReadCounter(ring.getWriteCounter());
+    ASSERT_EQ(burst, ring.write(data, burst));
+    EXPECT_EQ(burst, reader.getFullFramesAvailable());
+    int16_t result[burst]{};
+    ASSERT_EQ(burst, reader.read(result, burst));
+    for (int i = 0; i < burst; i++) {
+        EXPECT_EQ(data[i], result[i]);
+    }
+
+    // The ring does not wait for the reader, which detects its own overrun.
+    for (int i = 0; i <= capacity / burst; i++) {
+        ring.setReadCounter(ring.getWriteCounter());
+        ASSERT_EQ(burst, ring.write(data, burst));
+    }
+    EXPECT_GT(reader.getFullFramesAvailable(), capacity);
+}
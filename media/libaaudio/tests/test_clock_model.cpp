@@ -17,8 +17,13 @@
 // Unit tests for Isochronous Clock Model
 
 #include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
 
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <aaudio/AAudio.h>
 #include <audio_utils/clock.h>
@@ -208,3 +213,153 @@ TEST_F(ClockModelTestFixture, clock_fast_drift) {
 TEST_F(ClockModelTestFixture, clock_jump_forward_500) {
     checkDriftingClock(SAMPLE_RATE, NUM_LOOPS_DRIFT, 0.500);
 }
+
+// Check the drift tracking estimator with the same drifting clocks.
+TEST_F(ClockModelTestFixture, clock_tracking_no_drift) {
+    model.setDriftTrackingEnabled(true);
+    checkDriftingClock(SAMPLE_RATE, NUM_LOOPS_DRIFT);
+}
+
+TEST_F(ClockModelTestFixture, clock_tracking_slow_drift) {
+    model.setDriftTrackingEnabled(true);
+    checkDriftingClock(0.99998 * SAMPLE_RATE, NUM_LOOPS_DRIFT);
+}
+
+TEST_F(ClockModelTestFixture, clock_tracking_fast_drift) {
+    model.setDriftTrackingEnabled(true);
+    checkDriftingClock(1.00002 * SAMPLE_RATE, NUM_LOOPS_DRIFT);
+}
+
+TEST_F(ClockModelTestFixture, clock_tracking_jump_forward_500) {
+    model.setDriftTrackingEnabled(true);
+    checkDriftingClock(SAMPLE_RATE, NUM_LOOPS_DRIFT, 0.500);
+}
+
+// Replay harness, to compare the estimators on a sequence of timestamps.
+
+struct TimestampTrace {
+    int32_t sampleRate = SAMPLE_RATE;
+    int32_t framesPerBurst = HW_FRAMES_PER_BURST;
+    std::vector<std::pair<int64_t, int64_t>> timestamps; // position, nanoTime
+};
+
+struct ReplayResult {
+    int32_t checked = 0;
+    int32_t lateMisses = 0;  // timestamp later than the late edge of the window, input glitch
+    int32_t earlyMisses = 0; // timestamp a burst before the early edge, output glitch
+    double meanLateOffsetMicros = 0.0; // width of the window
+};
+
+static ReplayResult replayTrace(const TimestampTrace &trace, bool driftTracking) {
+    IsochronousClockModel replayModel;
+    replayModel.setSampleRate(trace.sampleRate);
+    replayModel.setFramesPerBurst(trace.framesPerBurst);
+    replayModel.setDriftTrackingEnabled(driftTracking);
+    ReplayResult result;
+    if (trace.timestamps.empty()) {
+        return result;
+    }
+    const int64_t nanosPerBurst = replayModel.convertDeltaPositionToTime(trace.framesPerBurst);
+    replayModel.start(trace.timestamps[0].second - nanosPerBurst);
+    double sumLateOffsetNanos = 0.0;
+    for (const auto &[position, nanoTime] : trace.timestamps) {
+        if (replayModel.isRunning()) {
+            const int64_t earliestTime = replayModel.convertPositionToTime(position);
+            const int64_t latestTime = replayModel.convertPositionToLatestTime(position);
+            result.checked++;
+            if (nanoTime > latestTime) result.lateMisses++;
+            if (nanoTime + nanosPerBurst < earliestTime) result.earlyMisses++;
+            sumLateOffsetNanos += latestTime - earliestTime;
+        }
+        replayModel.processTimestamp(position, nanoTime);
+    }
+    if (result.checked > 0) {
+        result.meanLateOffsetMicros = sumLateOffsetNanos / result.checked / NANOS_PER_MICROSECOND;
+    }
+    return result;
+}
+
+static void printReplayResult(const char *name, const ReplayResult &result) {
+    printf("%-16s checked %6d, late misses %5d, early misses %5d, mean late offset %7.1f us\n",
+           name, result.checked, result.lateMisses, result.earlyMisses,
+           result.meanLateOffsetMicros);
+}
+
+// Simulate a DSP that advances one burst at a time, sampled at random times
+// with scheduling jitter and occasional preemption of the timestamp thread.
+static TimestampTrace makeJitteryTrace(double hardwareFramesPerSecond, int numTimestamps) {
+    TimestampTrace trace;
+    srand48(654321); // arbitrary seed for repeatable test results
+    double elapsedTimeSeconds = 0.0;
+    const int64_t startTimeNanos = 500000000; // arbitrary
+    for (int i = 0; i < numTimestamps; i++) {
+        elapsedTimeSeconds += 4.0 * drand48() * NANOS_PER_BURST / NANOS_PER_SECOND;
+        const int64_t numBursts = (int64_t) (hardwareFramesPerSecond * elapsedTimeSeconds)
+                / HW_FRAMES_PER_BURST;
+        const int64_t hardwarePosition = (numBursts + 1) * HW_FRAMES_PER_BURST;
+        double delayNanos = drand48() * NANOS_PER_BURST + 200 * NANOS_PER_MICROSECOND * drand48();
+        if (drand48() < 0.002) {
+            delayNanos += 3 * NANOS_PER_MILLISECOND; // preempted
+        }
+        trace.timestamps.emplace_back(hardwarePosition, startTimeNanos
+                + (int64_t) (elapsedTimeSeconds * NANOS_PER_SECOND) + (int64_t) delayNanos);
+    }
+    return trace;
+}
+
+// Read a trace logged with AAUDIO_LOG_CLOCK_MODEL_TRACE.
+static bool readTrace(const char *fileName, TimestampTrace *trace) {
+    std::ifstream input(fileName);
+    if (!input) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(input, line)) {
+        size_t index = line.find("CSV config,");
+        if (index != std::string::npos) {
+            sscanf(line.c_str() + index, "CSV config, %d, %d",
+                   &trace->sampleRate, &trace->framesPerBurst);
+            continue;
+        }
+        index = line.find("CSV,");
+        long long position = 0;
+        long long nanoTime = 0;
+        int count = 0;
+        if (index != std::string::npos && sscanf(line.c_str() + index, "CSV, %d, %lld, %lld",
+                                                 &count, &position, &nanoTime) == 3) {
+            trace->timestamps.emplace_back(position, nanoTime);
+        }
+    }
+    return true;
+}
+
+TEST(ClockModelReplay, clock_replay_jitter) {
+    for (const double rate : {0.99998 * SAMPLE_RATE, 1.0 * SAMPLE_RATE, 1.00002 * SAMPLE_RATE}) {
+        const TimestampTrace trace = makeJitteryTrace(rate, NUM_LOOPS_DRIFT);
+        const ReplayResult stateMachine = replayTrace(trace, false /* driftTracking */);
+        const ReplayResult tracking = replayTrace(trace, true /* driftTracking */);
+        printf("hardware rate %.2f\n", rate);
+        printReplayResult("state machine", stateMachine);
+        printReplayResult("drift tracking", tracking);
+        // The window should be narrower with a near constant miss rate.
+        EXPECT_LT(tracking.meanLateOffsetMicros, stateMachine.meanLateOffsetMicros);
+        EXPECT_LT(tracking.lateMisses, tracking.checked / 100);
+        EXPECT_LE(tracking.earlyMisses, stateMachine.earlyMisses + tracking.checked / 1000);
+    }
+}
+
+// Replay a captured trace, for example:
+//    AAUDIO_CLOCK_MODEL_TRACE=/data/local/tmp/trace.txt test_clock_model
+TEST(ClockModelReplay, clock_replay_file) {
+    const char *fileName = getenv("AAUDIO_CLOCK_MODEL_TRACE");
+    if (fileName == nullptr) {
+        GTEST_SKIP() << "set AAUDIO_CLOCK_MODEL_TRACE to the name of a trace file";
+    }
+    TimestampTrace trace;
+    ASSERT_TRUE(readTrace(fileName, &trace)) << "cannot read " << fileName;
+    ASSERT_FALSE(trace.timestamps.empty()) << "no timestamps in " << fileName;
+    printf("%zu timestamps, sample rate %d, burst %d\n",
+           trace.timestamps.size(), trace.sampleRate, trace.framesPerBurst);
+    printReplayResult("state machine", replayTrace(trace, false /* driftTracking */));
+    printReplayResult("drift tracking", replayTrace(trace, true /* driftTracking */));
+}
@@ -509,6 +509,184 @@ TEST(test_flowgraph, module_sourceI8_24) {
     }
 }
 
+TEST(test_flowgraph, flowgraph_pass_through_float) {
+    constexpr int kChannelCount = 2;
+    constexpr float tolerance = 0.00001f;
+    AAudioFlowGraph flowgraph;
+    ASSERT_EQ(AAUDIO_OK, flowgraph.configure(AUDIO_FORMAT_PCM_FLOAT /* sourceFormat */,
+            kChannelCount /* sourceChannelCount */,
+            48000 /* sourceSampleRate */,
+            AUDIO_FORMAT_PCM_FLOAT /* sinkFormat */,
+            kChannelCount /* sinkChannelCount */,
+            48000 /* sinkSampleRate */,
+            false /* useMonoBlend */,
+            false /* useVolumeRamps */,
+            0.0f /* audioBalance */,
+            MultiChannelResampler::Quality::Medium));
+    ASSERT_TRUE(flowgraph.isPassThrough());
+
+    // Read part of the data with process() and the rest with pull().
+    constexpr int kNumFrames = kNumSamples / kChannelCount;
+    float output[kNumSamples];
+    int32_t numRead = flowgraph.process(kInputFloat.data(), kNumFrames, output, 1);
+    ASSERT_EQ(1, numRead);
+    numRead += flowgraph.pull(output + numRead * kChannelCount, kNumFrames);
+    ASSERT_EQ(kNumFrames, numRead);
+    EXPECT_EQ(0, flowgraph.pull(output, kNumFrames));
+
+    // Float data is still limited.
+    Limiter limiter{1};
+    for (int i = 0; i < kNumSamples; i++) {
+        float expected;
+        limiter.processSamples(&kInputFloat[i], &expected, 1);
+        EXPECT_NEAR(expected, output[i], tolerance) << ", i = " << i;
+    }
+}
+
+TEST(test_flowgraph, flowgraph_pass_through_i16) {
+    AAudioFlowGraph flowgraph;
+    ASSERT_EQ(AAUDIO_OK, flowgraph.configure(AUDIO_FORMAT_PCM_16_BIT /* sourceFormat */,
+            1 /* sourceChannelCount */,
+            48000 /* sourceSampleRate */,
+            AUDIO_FORMAT_PCM_16_BIT /* sinkFormat */,
+            1 /* sinkChannelCount */,
+            48000 /* sinkSampleRate */,
+            false /* useMonoBlend */,
+            false /* useVolumeRamps */,
+            0.0f /* audioBalance */,
+            MultiChannelResampler::Quality::Medium));
+    ASSERT_TRUE(flowgraph.isPassThrough());
+
+    int16_t output[kNumSamples];
+    ASSERT_EQ(kNumSamples, flowgraph.process(kExpectedI16.data(), kNumSamples, output,
+            kNumSamples));
+    for (int i = 0; i < kNumSamples; i++) {
+        EXPECT_EQ(kExpectedI16[i], output[i]) << ", i = " << i;
+    }
+}
+
+TEST(test_flowgraph, flowgraph_no_pass_through) {
+    AAudioFlowGraph flowgraph;
+    ASSERT_EQ(AAUDIO_OK, flowgraph.configure(AUDIO_FORMAT_PCM_FLOAT /* sourceFormat */,
+            2 /* sourceChannelCount */,
+            48000 /* sourceSampleRate */,
+            AUDIO_FORMAT_PCM_FLOAT /* sinkFormat */,
+            2 /* sinkChannelCount */,
+            48000 /* sinkSampleRate */,
+            true /* useMonoBlend */,
+            false /* useVolumeRamps */,
+            0.0f /* audioBalance */,
+            MultiChannelResampler::Quality::Medium));
+    EXPECT_FALSE(flowgraph.isPassThrough());
+    EXPECT_FALSE(flowgraph.isFused());
+}
+
+TEST(test_flowgraph, flowgraph_fused_mono_i16_to_stereo_float) {
+    constexpr int kChannelCount = 2;
+    constexpr int kRampSize = 4;
+    constexpr float kInitialVolume = 0.5f;
+    constexpr float kFinalVolume = 1.0f;
+    constexpr float tolerance = 0.00001f;
+    AAudioFlowGraph flowgraph;
+    ASSERT_EQ(AAUDIO_OK, flowgraph.configure(AUDIO_FORMAT_PCM_16_BIT /* sourceFormat */,
+            1 /* sourceChannelCount */,
+            48000 /* sourceSampleRate */,
+            AUDIO_FORMAT_PCM_FLOAT /* sinkFormat */,
+            kChannelCount /* sinkChannelCount */,
+            48000 /* sinkSampleRate */,
+            false /* useMonoBlend */,
+            true /* useVolumeRamps */,
+            0.0f /* audioBalance */,
+            MultiChannelResampler::Quality::Medium));
+    ASSERT_TRUE(flowgraph.isFused());
+    ASSERT_TRUE(flowgraph.isDirect());
+    flowgraph.setRampLengthInFrames(kRampSize);
+    // The first volume is used immediately.
+    flowgraph.setTargetVolume(kInitialVolume);
+
+    // Read part of the data with process() and the rest with pull().
+    float output[kNumSamples * kChannelCount];
+    int32_t numRead = flowgraph.process(kExpectedI16.data(), kNumSamples, output, 3);
+    ASSERT_EQ(3, numRead);
+    numRead += flowgraph.pull(output + numRead * kChannelCount, kNumSamples);
+    ASSERT_EQ(kNumSamples, numRead);
+    for (int i = 0; i < kNumSamples; i++) {
+        const float expected = kExpectedI16[i] * (1.0f / 32768) * kInitialVolume;
+        EXPECT_NEAR(expected, output[i * kChannelCount], tolerance) << ", i = " << i;
+        EXPECT_NEAR(expected, output[i * kChannelCount + 1], tolerance) << ", i = " << i;
+    }
+
+    // A later volume change is ramped, as by RampLinear.
+    flowgraph.setTargetVolume(kFinalVolume);
+    ASSERT_EQ(kNumSamples, flowgraph.process(kExpectedI16.data(), kNumSamples, output,
+            kNumSamples));
+    for (int i = 0; i < kNumSamples; i++) {
+        const float volume = i < kRampSize
+                ? kInitialVolume + i * (kFinalVolume - kInitialVolume) / kRampSize
+                : kFinalVolume;
+        const float expected = kExpectedI16[i] * (1.0f / 32768) * volume;
+        EXPECT_NEAR(expected, output[i * kChannelCount], tolerance) << ", i = " << i;
+        EXPECT_NEAR(expected, output[i * kChannelCount + 1], tolerance) << ", i = " << i;
+    }
+}
+
+TEST(test_flowgraph, flowgraph_fused_float_to_i16) {
+    constexpr int kChannelCount = 2;
+    AAudioFlowGraph flowgraph;
+    ASSERT_EQ(AAUDIO_OK, flowgraph.configure(AUDIO_FORMAT_PCM_FLOAT /* sourceFormat */,
+            kChannelCount /* sourceChannelCount */,
+            48000 /* sourceSampleRate */,
+            AUDIO_FORMAT_PCM_16_BIT /* sinkFormat */,
+            kChannelCount /* sinkChannelCount */,
+            48000 /* sinkSampleRate */,
+            false /* useMonoBlend */,
+            false /* useVolumeRamps */,
+            0.0f /* audioBalance */,
+            MultiChannelResampler::Quality::Medium));
+    ASSERT_TRUE(flowgraph.isFused());
+
+    constexpr int kNumFrames = kNumSamples / kChannelCount;
+    int16_t output[kNumSamples];
+    ASSERT_EQ(kNumFrames, flowgraph.process(kInputFloat.data(), kNumFrames, output,
+            kNumFrames));
+    for (int i = 0; i < kNumSamples; i++) {
+        // Rounding may differ by one from the truncation of the graph.
+        EXPECT_NEAR(kExpectedI16[i], output[i], 1) << ", i = " << i;
+    }
+}
+
+TEST(test_flowgraph, flowgraph_fused_float_limiter) {
+    constexpr int kChannelCount = 2;
+    constexpr float kVolume = 0.5f;
+    constexpr float tolerance = 0.00001f;
+    AAudioFlowGraph flowgraph;
+    ASSERT_EQ(AAUDIO_OK, flowgraph.configure(AUDIO_FORMAT_PCM_FLOAT /* sourceFormat */,
+            1 /* sourceChannelCount */,
+            48000 /* sourceSampleRate */,
+            AUDIO_FORMAT_PCM_FLOAT /* sinkFormat */,
+            kChannelCount /* sinkChannelCount */,
+            48000 /* sinkSampleRate */,
+            false /* useMonoBlend */,
+            true /* useVolumeRamps */,
+            0.0f /* audioBalance */,
+            MultiChannelResampler::Quality::Medium));
+    ASSERT_TRUE(flowgraph.isFused());
+    flowgraph.setTargetVolume(kVolume);
+
+    float output[kNumSamples * kChannelCount];
+    ASSERT_EQ(kNumSamples, flowgraph.process(kInputFloat.data(), kNumSamples, output,
+            kNumSamples));
+    // The source is limited before the volume is applied.
+    Limiter limiter{1};
+    for (int i = 0; i < kNumSamples; i++) {
+        float expected;
+        limiter.processSamples(&kInputFloat[i], &expected, 1);
+        expected *= kVolume;
+        EXPECT_NEAR(expected, output[i * kChannelCount], tolerance) << ", i = " << i;
+        EXPECT_NEAR(expected, output[i * kChannelCount + 1], tolerance) << ", i = " << i;
+    }
+}
+
 void checkSampleRateConversionVariedSizes(int32_t sourceSampleRate,
                     int32_t sinkSampleRate,
                     MultiChannelResampler::Quality resamplerQuality) {
@@ -22,9 +22,11 @@
  */
 
 #include <iostream>
+#include <vector>
 
 #include <gtest/gtest.h>
 
+#include "flowgraph/resampler/FirKernels.h"
 #include "flowgraph/resampler/MultiChannelResampler.h"
 
 using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
@@ -223,3 +225,94 @@ TEST(test_resampler, resampler_48000_44100_best) {
 TEST(test_resampler, resampler_44100_11025_best) {
     checkResampler(44100, 11025, MultiChannelResampler::Quality::Best);
 }
+
+// Compare the SIMD inner loops with the portable ones.
+TEST(test_resampler, fir_kernels_match_scalar) {
+    const std::vector<const FirKernels *> kernels = getSupportedFirKernels();
+    ASSERT_FALSE(kernels.empty());
+    const FirKernels &scalar = *kernels[0];
+    srand48(1234); // arbitrary seed for repeatable test results
+    for (const int numTaps : {4, 8, 12, 16, 20, 32, 64}) {
+        std::vector<float> samples(2 * numTaps);
+        std::vector<float> coefficients1(numTaps);
+        std::vector<float> coefficients2(numTaps);
+        for (float &sample : samples) sample = 2.0 * drand48() - 1.0;
+        for (float &coefficient : coefficients1) coefficient = 2.0 * drand48() - 1.0;
+        for (float &coefficient : coefficients2) coefficient = 2.0 * drand48() - 1.0;
+        // The products are added in a different order.
+        const float tolerance = 1.0e-6f * numTaps;
+
+        const float expectedMono = scalar.mono(samples.data(), coefficients1.data(), numTaps);
+        float expectedStereo[2];
+        scalar.stereo(samples.data(), coefficients1.data(), numTaps, expectedStereo);
+        float expected1[2];
+        float expected2[2];
+        scalar.stereoDual(samples.data(), coefficients1.data(), coefficients2.data(), numTaps,
+                          expected1, expected2);
+
+        for (const FirKernels *kernel : kernels) {
+            SCOPED_TRACE(std::string(kernel->name) + ", numTaps = " + std::to_string(numTaps));
+            EXPECT_NEAR(expectedMono,
+                        kernel->mono(samples.data(), coefficients1.data(), numTaps),
+                        tolerance);
+            float stereo[2];
+            kernel->stereo(samples.data(), coefficients1.data(), numTaps, stereo);
+            EXPECT_NEAR(expectedStereo[0], stereo[0], tolerance);
+            EXPECT_NEAR(expectedStereo[1], stereo[1], tolerance);
+            float frame1[2];
+            float frame2[2];
+            kernel->stereoDual(samples.data(), coefficients1.data(), coefficients2.data(),
+                               numTaps, frame1, frame2);
+            EXPECT_NEAR(expected1[0], frame1[0], tolerance);
+            EXPECT_NEAR(expected1[1], frame1[1], tolerance);
+            EXPECT_NEAR(expected2[0], frame2[0], tolerance);
+            EXPECT_NEAR(expected2[1], frame2[1], tolerance);
+        }
+    }
+}
+
+/**
+ * Convert a sine wave in the left channel and its inverse in the right channel
+ * with a stereo resampler, and compare each channel with the output of a mono resampler.
+ */
+static void checkStereoResampler(int32_t sourceRate, int32_t sinkRate,
+        MultiChannelResampler::Quality quality) {
+    constexpr int kNumInputFrames = 2000;
+    constexpr float kTolerance = 0.0001f;
+    std::unique_ptr<MultiChannelResampler> mono(MultiChannelResampler::make(
+            1, sourceRate, sinkRate, quality));
+    std::unique_ptr<MultiChannelResampler> stereo(MultiChannelResampler::make(
+            2, sourceRate, sinkRate, quality));
+
+    int numRead = 0;
+    for (int i = 0; i < kNumInputFrames; i++) {
+        const float sample = sin(i * 0.05);
+        const float frame[2] = {sample, -sample};
+        // Both resamplers need input at the same time, they have the same ratio.
+        ASSERT_TRUE(mono->isWriteNeeded());
+        ASSERT_TRUE(stereo->isWriteNeeded());
+        mono->writeNextFrame(&sample);
+        stereo->writeNextFrame(frame);
+        while (!mono->isWriteNeeded()) {
+            ASSERT_FALSE(stereo->isWriteNeeded());
+            float monoOutput;
+            float stereoOutput[2];
+            mono->readNextFrame(&monoOutput);
+            stereo->readNextFrame(stereoOutput);
+            EXPECT_NEAR(monoOutput, stereoOutput[0], kTolerance) << ", frame " << numRead;
+            EXPECT_NEAR(-monoOutput, stereoOutput[1], kTolerance) << ", frame " << numRead;
+            numRead++;
+        }
+    }
+    EXPECT_GT(numRead, 0);
+}
+
+// Polyphase resampler.
+TEST(test_resampler, resampler_stereo_44100_48000_medium) {
+    checkStereoResampler(44100, 48000, MultiChannelResampler::Quality::Medium);
+}
+
+// Sinc resampler, because the ratio needs too many coefficients for polyphase.
+TEST(test_resampler, resampler_stereo_11025_48000_medium) {
+    checkStereoResampler(11025, 48000, MultiChannelResampler::Quality::Medium);
+}
@@ -26,6 +26,7 @@
 #include <binder/IServiceManager.h>
 #include <binder/ProcessState.h>
 #include <binder/IPCThreadState.h>
+#include <cutils/multiuser.h>
 #include <media/AidlConversion.h>
 #include <media/AudioResamplerPublic.h>
 #include <media/AudioSystem.h>
@@ -33,6 +34,14 @@
 #include <media/PolicyAidlConversion.h>
 #include <media/TypeConverter.h>
 #include <math.h>
+#include <private/android_filesystem_config.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <map>
+#include <optional>
+#include <string>
+#include <tuple>
 
 #include <system/audio.h>
 #include <android/media/GetInputForAttrResponse.h>
@@ -927,6 +936,76 @@ status_t AudioSystem::AudioFlingerClient::removeSupportedLatencyModesCallback(
     gVolRangeInitReqCallback = cb;
 }
 
+namespace {
+
+// Caches the results of audio policy queries which the service notifies the changes of.
+// A result is only cached if no invalidation happened while it was queried.
+template <typename Key, typename Value>
+class PolicyQueryCache {
+  public:
+    // Sets *generation to pass to put() with the result of the query, if not cached.
+    std::optional<Value> get(const Key& key, uint64_t* generation) const {
+        std::lock_guard _l(mMutex);
+        *generation = mGeneration;
+        if (auto it = mEntries.find(key); it != mEntries.end()) {
+            return it->second;
+        }
+        return std::nullopt;
+    }
+
+    void put(const Key& key, const Value& value, uint64_t generation) {
+        std::lock_guard _l(mMutex);
+        if (generation != mGeneration) return;
+        if (mEntries.size() >= kMaxEntries) mEntries.clear();
+        mEntries.emplace(key, value);
+    }
+
+    void invalidate() {
+        std::lock_guard _l(mMutex);
+        ++mGeneration;
+        mEntries.clear();
+    }
+
+  private:
+    static constexpr size_t kMaxEntries = 64;
+
+    mutable std::mutex mMutex;
+    uint64_t mGeneration GUARDED_BY(mMutex) = 0;
+    std::map<Key, Value> mEntries GUARDED_BY(mMutex);
+};
+
+// Invalidates a cache once the request changing what it caches has been processed.
+template <typename Cache>
+class ScopedInvalidation {
+  public:
+    explicit ScopedInvalidation(Cache& cache) : mCache(cache) {}
+    ~ScopedInvalidation() { mCache.invalidate(); }
+  private:
+    Cache& mCache;
+};
+
+// getDevicesForAttributes() results, keyed by attributes and 'forVolume'. Invalidated on
+// onRoutingUpdated(), which the service only sends to service uids.
+[[clang::no_destroy]] PolicyQueryCache<std::tuple<audio_usage_t, audio_content_type_t,
+        audio_source_t, audio_flags_mask_t, std::string, bool>, AudioDeviceTypeAddrVector>
+        gDevicesForAttributesCache;
+
+// getStreamVolumeIndex() results for a given device, keyed by stream and device.
+// Invalidated on onAudioVolumeGroupChanged(), which the service only sends if the process
+// has a volume group callback.
+[[clang::no_destroy]] PolicyQueryCache<std::pair<audio_stream_type_t, audio_devices_t>, int>
+        gStreamVolumeIndexCache;
+
+bool isServiceProcess() {
+    static const bool isService = multiuser_get_app_id(getuid()) < AID_APP_START;
+    return isService;
+}
+
+using RoutingChange = ScopedInvalidation<decltype(gDevicesForAttributesCache)>;
+using VolumeChange = ScopedInvalidation<decltype(gStreamVolumeIndexCache)>;
+
+}  // namespace
+
 struct AudioPolicyTraits {
     static void onServiceCreate(const sp<IAudioPolicyService>& ap,
             const sp<AudioSystem::AudioPolicyServiceClient>& apc) {
@@ -977,6 +1056,7 @@ status_t AudioSystem::setDeviceConnectionState(audio_policy_dev_state_t state,
     const sp<IAudioPolicyService> aps = get_audio_policy_service();
 
     if (aps == 0) return PERMISSION_DENIED;
+    const RoutingChange routingChange(gDevicesForAttributesCache);
 
     return statusTFromBinderStatus(
             aps->setDeviceConnectionState(
@@ -1014,6 +1094,7 @@ status_t AudioSystem::handleDeviceConfigChange(audio_devices_t device,
     const char* name = "";
 
     if (aps == 0) return PERMISSION_DENIED;
+    const RoutingChange routingChange(gDevicesForAttributesCache);
 
     if (device_address != NULL) {
         address = device_address;
@@ -1034,6 +1115,7 @@ status_t AudioSystem::setPhoneState(audio_mode_t state, uid_t uid) {
     if (uint32_t(state) >= AUDIO_MODE_CNT) return BAD_VALUE;
     const sp<IAudioPolicyService> aps = get_audio_policy_service();
     if (aps == 0) return PERMISSION_DENIED;
+    const RoutingChange routingChange(gDevicesForAttributesCache);
 
     return statusTFromBinderStatus(aps->setPhoneState(
             VALUE_OR_RETURN_STATUS(legacy2aidl_audio_mode_t_AudioMode(state)),
@@ -1044,6 +1126,7 @@ status_t
 AudioSystem::setForceUse(audio_policy_force_use_t usage, audio_policy_forced_cfg_t config) {
     const sp<IAudioPolicyService> aps = get_audio_policy_service();
     if (aps == 0) return PERMISSION_DENIED;
+    const RoutingChange routingChange(gDevicesForAttributesCache);
 
     return statusTFromBinderStatus(
             aps->setForceUse(
@@ -1309,6 +1392,7 @@ status_t AudioSystem::initStreamVolume(audio_stream_type_t stream,
                                        int indexMax) {
     const sp<IAudioPolicyService> aps = get_audio_policy_service();
     if (aps == 0) return PERMISSION_DENIED;
+    const VolumeChange volumeChange(gStreamVolumeIndexCache);
 
     AudioStreamType streamAidl = VALUE_OR_RETURN_STATUS(
             legacy2aidl_audio_stream_type_t_AudioStreamType(stream));
@@ -1330,6 +1414,7 @@ status_t AudioSystem::setStreamVolumeIndex(audio_stream_type_t stream,
                                            audio_devices_t device) {
     const sp<IAudioPolicyService> aps = get_audio_policy_service();
     if (aps == 0) return PERMISSION_DENIED;
+    const VolumeChange volumeChange(gStreamVolumeIndexCache);
 
     AudioStreamType streamAidl = VALUE_OR_RETURN_STATUS(
             legacy2aidl_audio_stream_type_t_AudioStreamType(stream));
@@ -1346,6 +1431,21 @@ status_t AudioSystem::getStreamVolumeIndex(audio_stream_type_t stream,
     const sp<IAudioPolicyService> aps = get_audio_policy_service();
     if (aps == 0) return PERMISSION_DENIED;
 
+    // The index for the default device depends on the routing, which isn't tracked here.
+    const auto apc = gAudioPolicyServiceHandler.getClient();
+    const bool cacheable = device != AUDIO_DEVICE_OUT_DEFAULT_FOR_VOLUME &&
+            apc != nullptr && apc->isAudioVolumeGroupCbEnabled();
+    const auto key = std::make_pair(stream, device);
+    uint64_t generation = 0;
+    if (cacheable) {
+        if (auto cached = gStreamVolumeIndexCache.get(key, &generation); cached.has_value()) {
+            if (index != nullptr) {
+                *index = *cached;
+            }
+            return OK;
+        }
+    }
+
     AudioStreamType streamAidl = VALUE_OR_RETURN_STATUS(
             legacy2aidl_audio_stream_type_t_AudioStreamType(stream));
     AudioDeviceDescription deviceAidl = VALUE_OR_RETURN_STATUS(
@@ -1353,8 +1453,12 @@ status_t AudioSystem::getStreamVolumeIndex(audio_stream_type_t stream,
     int32_t indexAidl;
     RETURN_STATUS_IF_ERROR(statusTFromBinderStatus(
             aps->getStreamVolumeIndex(streamAidl, deviceAidl, &indexAidl)));
+    const int indexLegacy = VALUE_OR_RETURN_STATUS(convertIntegral<int>(indexAidl));
+    if (cacheable) {
+        gStreamVolumeIndexCache.put(key, indexLegacy, generation);
+    }
     if (index != nullptr) {
-        *index = VALUE_OR_RETURN_STATUS(convertIntegral<int>(indexAidl));
+        *index = indexLegacy;
     }
     return OK;
 }
@@ -1364,6 +1468,7 @@ status_t AudioSystem::setVolumeIndexForAttributes(const audio_attributes_t& attr
                                                   audio_devices_t device) {
     const sp<IAudioPolicyService> aps = get_audio_policy_service();
     if (aps == 0) return PERMISSION_DENIED;
+    const VolumeChange volumeChange(gStreamVolumeIndexCache);
 
     media::audio::common::AudioAttributes attrAidl = VALUE_OR_RETURN_STATUS(
             legacy2aidl_audio_attributes_t_AudioAttributes(attr));
@@ -1441,6 +1546,17 @@ status_t AudioSystem::getDevicesForAttributes(const audio_attributes_t& aa,
     const sp<IAudioPolicyService> aps = get_audio_policy_service();
     if (aps == 0) return PERMISSION_DENIED;
 
+    const bool cacheable = isServiceProcess();
+    const auto key = std::make_tuple(aa.usage, aa.content_type, aa.source, aa.flags,
+            std::string(aa.tags, strnlen(aa.tags, AUDIO_ATTRIBUTES_TAGS_MAX_SIZE)), forVolume);
+    uint64_t generation = 0;
+    if (cacheable) {
+        if (auto cached = gDevicesForAttributesCache.get(key, &generation); cached.has_value()) {
+            *devices = std::move(*cached);
+            return OK;
+        }
+    }
+
     media::audio::common::AudioAttributes aaAidl = VALUE_OR_RETURN_STATUS(
              legacy2aidl_audio_attributes_t_AudioAttributes(aa));
     std::vector<AudioDevice> retAidl;
@@ -1450,6 +1566,9 @@ status_t AudioSystem::getDevicesForAttributes(const audio_attributes_t& aa,
             convertContainer<AudioDeviceTypeAddrVector>(
                     retAidl,
                     aidl2legacy_AudioDeviceTypeAddress));
+    if (cacheable) {
+        gDevicesForAttributesCache.put(key, *devices, generation);
+    }
     return OK;
 }
 
@@ -1789,6 +1908,8 @@ status_t AudioSystem::removeAudioVolumeGroupCallback(const sp<AudioVolumeGroupCa
     const int ret = apc->removeAudioVolumeGroupCallback(callback);
     if (ret == 0) {
         aps->setAudioVolumeGroupCallbacksEnabled(false);
+        // Changes are not notified anymore.
+        gStreamVolumeIndexCache.invalidate();
     }
     return (ret < 0) ? INVALID_OPERATION : NO_ERROR;
 }
@@ -1891,6 +2012,7 @@ audio_mode_t AudioSystem::getPhoneState() {
 status_t AudioSystem::registerPolicyMixes(const Vector<AudioMix>& mixes, bool registration) {
     const sp<IAudioPolicyService> aps = get_audio_policy_service();
     if (aps == 0) return PERMISSION_DENIED;
+    const RoutingChange routingChange(gDevicesForAttributesCache);
 
     size_t mixesSize = std::min(mixes.size(), size_t{MAX_MIXES_PER_POLICY});
     std::vector<media::AudioMix> mixesAidl;
@@ -1924,6 +2046,7 @@ status_t AudioSystem::updatePolicyMixes(
                 mixesWithUpdates) {
     const sp<IAudioPolicyService> aps = get_audio_policy_service();
     if (aps == 0) return PERMISSION_DENIED;
+    const RoutingChange routingChange(gDevicesForAttributesCache);
 
     std::vector<media::AudioMixUpdate> updatesAidl;
     updatesAidl.reserve(mixesWithUpdates.size());
@@ -1943,6 +2066,7 @@ status_t AudioSystem::updatePolicyMixes(
 status_t AudioSystem::setUidDeviceAffinities(uid_t uid, const AudioDeviceTypeAddrVector& devices) {
     const sp<IAudioPolicyService> aps = get_audio_policy_service();
     if (aps == 0) return PERMISSION_DENIED;
+    const RoutingChange routingChange(gDevicesForAttributesCache);
 
     int32_t uidAidl = VALUE_OR_RETURN_STATUS(legacy2aidl_uid_t_int32_t(uid));
     std::vector<AudioDevice> devicesAidl = VALUE_OR_RETURN_STATUS(
@@ -1954,6 +2078,7 @@ status_t AudioSystem::setUidDeviceAffinities(uid_t uid, const AudioDeviceTypeAdd
 status_t AudioSystem::removeUidDeviceAffinities(uid_t uid) {
     const sp<IAudioPolicyService> aps = get_audio_policy_service();
     if (aps == 0) return PERMISSION_DENIED;
+    const RoutingChange routingChange(gDevicesForAttributesCache);
 
     int32_t uidAidl = VALUE_OR_RETURN_STATUS(legacy2aidl_uid_t_int32_t(uid));
     return statusTFromBinderStatus(aps->removeUidDeviceAffinities(uidAidl));
@@ -1963,6 +2088,7 @@ status_t AudioSystem::setUserIdDeviceAffinities(int userId,
                                                 const AudioDeviceTypeAddrVector& devices) {
     const sp<IAudioPolicyService> aps = get_audio_policy_service();
     if (aps == 0) return PERMISSION_DENIED;
+    const RoutingChange routingChange(gDevicesForAttributesCache);
 
     int32_t userIdAidl = VALUE_OR_RETURN_STATUS(convertReinterpret<int32_t>(userId));
     std::vector<AudioDevice> devicesAidl = VALUE_OR_RETURN_STATUS(
@@ -1975,6 +2101,7 @@ status_t AudioSystem::setUserIdDeviceAffinities(int userId,
 status_t AudioSystem::removeUserIdDeviceAffinities(int userId) {
     const sp<IAudioPolicyService> aps = get_audio_policy_service();
     if (aps == 0) return PERMISSION_DENIED;
+    const RoutingChange routingChange(gDevicesForAttributesCache);
     int32_t userIdAidl = VALUE_OR_RETURN_STATUS(convertReinterpret<int32_t>(userId));
     return statusTFromBinderStatus(aps->removeUserIdDeviceAffinities(userIdAidl));
 }
@@ -2341,6 +2468,7 @@ status_t AudioSystem::setDevicesRoleForStrategy(product_strategy_t strategy,
     if (aps == 0) {
         return PERMISSION_DENIED;
     }
+    const RoutingChange routingChange(gDevicesForAttributesCache);
 
     int32_t strategyAidl = VALUE_OR_RETURN_STATUS(legacy2aidl_product_strategy_t_int32_t(strategy));
     media::DeviceRole roleAidl = VALUE_OR_RETURN_STATUS(legacy2aidl_device_role_t_DeviceRole(role));
@@ -2358,6 +2486,7 @@ status_t AudioSystem::removeDevicesRoleForStrategy(product_strategy_t strategy,
     if (aps == 0) {
         return PERMISSION_DENIED;
     }
+    const RoutingChange routingChange(gDevicesForAttributesCache);
 
     int32_t strategyAidl = VALUE_OR_RETURN_STATUS(legacy2aidl_product_strategy_t_int32_t(strategy));
     media::DeviceRole roleAidl = VALUE_OR_RETURN_STATUS(legacy2aidl_device_role_t_DeviceRole(role));
@@ -2374,6 +2503,7 @@ AudioSystem::clearDevicesRoleForStrategy(product_strategy_t strategy, device_rol
     if (aps == 0) {
         return PERMISSION_DENIED;
     }
+    const RoutingChange routingChange(gDevicesForAttributesCache);
     int32_t strategyAidl = VALUE_OR_RETURN_STATUS(legacy2aidl_product_strategy_t_int32_t(strategy));
     media::DeviceRole roleAidl = VALUE_OR_RETURN_STATUS(legacy2aidl_device_role_t_DeviceRole(role));
     return statusTFromBinderStatus(
@@ -2875,6 +3005,7 @@ Status AudioSystem::AudioPolicyServiceClient::onAudioVolumeGroupChanged(int32_t
     volume_group_t groupLegacy = VALUE_OR_RETURN_BINDER_STATUS(
             aidl2legacy_int32_t_volume_group_t(group));
     int flagsLegacy = VALUE_OR_RETURN_BINDER_STATUS(convertReinterpret<int>(flags));
+    gStreamVolumeIndexCache.invalidate();
 
     std::lock_guard _l(mMutex);
     for (const auto& callback : mAudioVolumeGroupCallbacks) {
@@ -2944,6 +3075,7 @@ Status AudioSystem::AudioPolicyServiceClient::onRecordingConfigurationUpdate(
 }
 
 Status AudioSystem::AudioPolicyServiceClient::onRoutingUpdated() {
+    gDevicesForAttributesCache.invalidate();
     routing_callback cb = NULL;
     {
         std::lock_guard _l(AudioSystem::gMutex);
@@ -2957,6 +3089,7 @@ Status AudioSystem::AudioPolicyServiceClient::onRoutingUpdated() {
 }
 
 Status AudioSystem::AudioPolicyServiceClient::onVolumeRangeInitRequest() {
+    gStreamVolumeIndexCache.invalidate();
     vol_range_init_req_callback cb = NULL;
     {
         std::lock_guard _l(AudioSystem::gMutex);
@@ -2970,6 +3103,8 @@ Status AudioSystem::AudioPolicyServiceClient::onVolumeRangeInitRequest() {
 }
 
 void AudioSystem::AudioPolicyServiceClient::binderDied(const wp<IBinder>& who __unused) {
+    gDevicesForAttributesCache.invalidate();
+    gStreamVolumeIndexCache.invalidate();
     {
         std::lock_guard _l(mMutex);
         for (const auto& callback : mAudioPortCallbacks) {
@@ -164,6 +164,7 @@ IAudioFlinger::CreateRecordInput::toAidl() const {
     aidl.riid = VALUE_OR_RETURN(legacy2aidl_audio_unique_id_t_int32_t(riid));
     aidl.maxSharedAudioHistoryMs = VALUE_OR_RETURN(
             convertIntegral<int32_t>(maxSharedAudioHistoryMs));
+    aidl.startTimeNs = VALUE_OR_RETURN(convertIntegral<int64_t>(startTimeNs));
     aidl.flags = VALUE_OR_RETURN(legacy2aidl_audio_input_flags_t_int32_t_mask(flags));
     aidl.frameCount = VALUE_OR_RETURN(convertIntegral<int64_t>(frameCount));
     aidl.notificationFrameCount = VALUE_OR_RETURN(convertIntegral<int64_t>(notificationFrameCount));
@@ -185,6 +186,7 @@ IAudioFlinger::CreateRecordInput::fromAidl(
     legacy.riid = VALUE_OR_RETURN(aidl2legacy_int32_t_audio_unique_id_t(aidl.riid));
     legacy.maxSharedAudioHistoryMs = VALUE_OR_RETURN(
             convertIntegral<int32_t>(aidl.maxSharedAudioHistoryMs));
+    legacy.startTimeNs = VALUE_OR_RETURN(convertIntegral<int64_t>(aidl.startTimeNs));
     legacy.flags = VALUE_OR_RETURN(aidl2legacy_int32_t_audio_input_flags_t_mask(aidl.flags));
     legacy.frameCount = VALUE_OR_RETURN(convertIntegral<size_t>(aidl.frameCount));
     legacy.notificationFrameCount = VALUE_OR_RETURN(
@@ -1287,8 +1287,8 @@ void ToneGenerator::stopTone() {
             ALOGE("--- Stop timed out");
             mState = TONE_IDLE;
             mpAudioTrack->stop();
+            clearWaveGens();
         }
-        clearWaveGens();
     }
 
     mLock.unlock();
@@ -1630,9 +1630,6 @@ bool ToneGenerator::prepareWave() {
         return false;
     }
 
-    // Remove existing wave generators if any
-    clearWaveGens();
-
     mpToneDesc = mpNewToneDesc;
 
     if (mDurationMs < 0) {  // mDurationMs is signed, treat all neg numbers as INF.
@@ -1643,19 +1640,33 @@ bool ToneGenerator::prepareWave() {
         ALOGV("prepareWave, duration limited to %d ms", mDurationMs);
     }
 
+    // Frequencies whose wave generator has been checked for this tone: the
+    // first segment using a frequency sets the gain of its generator.
+    KeyedVector<uint16_t, bool> lPrepared;
     while (mpToneDesc->segments[segmentIdx].duration) {
         // Get total number of sine waves: needed to adapt sine wave gain.
         unsigned int lNumWaves = numWaves(segmentIdx);
         unsigned int freqIdx = 0;
         unsigned int frequency = mpToneDesc->segments[segmentIdx].waveFreq[freqIdx];
         while (frequency) {
-            // Instantiate a wave generator if  ot already done for this frequency
-            if (mWaveGens.indexOfKey(frequency) == NAME_NOT_FOUND) {
-                ToneGenerator::WaveGenerator *lpWaveGen =
-                        new ToneGenerator::WaveGenerator(mSamplingRate,
-                                frequency,
-                                TONEGEN_GAIN/lNumWaves);
-                mWaveGens.add(frequency, lpWaveGen);
+            // Instantiate a wave generator if not already done for this frequency,
+            // or if the one of a previous tone has a different gain.
+            if (lPrepared.indexOfKey(frequency) == NAME_NOT_FOUND) {
+                const float volume = TONEGEN_GAIN/lNumWaves;
+                ssize_t lIdx = mWaveGens.indexOfKey(frequency);
+                if (lIdx >= 0 && mWaveGens.valueAt(lIdx)->getVolume() != volume) {
+                    delete mWaveGens.valueAt(lIdx);
+                    mWaveGens.removeItemsAt(lIdx);
+                    lIdx = NAME_NOT_FOUND;
+                }
+                if (lIdx < 0) {
+                    ToneGenerator::WaveGenerator *lpWaveGen =
+                            new ToneGenerator::WaveGenerator(mSamplingRate,
+                                    frequency,
+                                    volume);
+                    mWaveGens.add(frequency, lpWaveGen);
+                }
+                lPrepared.add(frequency, true);
             }
             frequency = mpNewToneDesc->segments[segmentIdx].waveFreq[++freqIdx];
         }
@@ -1782,6 +1793,7 @@ ToneGenerator::WaveGenerator::WaveGenerator(uint32_t samplingRate,
     double d0;
     double F_div_Fs;  // frequency / samplingRate
 
+    mVolume = volume;
     F_div_Fs = frequency / (double)samplingRate;
     d0 = - (float)GEN_AMP * sin(2 * M_PI * F_div_Fs);
     mS2_0 = (int16_t)d0;
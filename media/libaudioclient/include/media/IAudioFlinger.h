@@ -142,6 +142,7 @@ public:
         AudioClient clientInfo;
         audio_unique_id_t riid;
         int32_t maxSharedAudioHistoryMs;
+        int64_t startTimeNs = 0;  // CLOCK_MONOTONIC, 0 to start with the next captured frame
 
         /* input/output */
         audio_input_flags_t flags;
@@ -346,6 +346,8 @@ private:
         void getSamples(int16_t *outBuffer, unsigned int count,
                 unsigned int command);
 
+        float getVolume() const { return mVolume; }
+
     private:
         static const int16_t GEN_AMP = 32000;  // amplitude of generator
         static const int16_t S_Q14 = 14;  // shift for Q14
@@ -356,9 +358,12 @@ private:
         long mS1, mS2;  // delay line S2 oldest
         int16_t mS2_0;  // saved value for reinitialisation
         int16_t mAmplitude_Q15;  // Q15 amplitude
+        float mVolume;  // volume the generator was created with
     };
 
-    KeyedVector<uint16_t, WaveGenerator *> mWaveGens;  // list of active wave generators.
+    // Wave generators, kept from one tone to the next to be reused by the tones
+    // with the same frequencies, e.g. the DTMF tones.
+    KeyedVector<uint16_t, WaveGenerator *> mWaveGens;
 
     std::string mOpPackageName;
 };
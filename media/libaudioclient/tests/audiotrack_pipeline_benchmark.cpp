@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks the playback data path in a single process, one iteration per mixer period:
+// - the AudioTrack client side writes to the track buffer through AudioTrackClientProxy,
+// - the server side reads it through AudioTrackServerProxy, as Track::getNextBuffer() does,
+// - AudioMixer mixes all tracks and the mix is converted to the sink format,
+// - the mix is written to a stub HAL sink, a libnbaio MonoPipe drained one period at a time.
+//
+// The time per iteration is the CPU cost of one period. The "latencyMs" counter is the average
+// audio time buffered between AudioTrack::write() and the HAL, in the track and in the sink.
+//
+// Run with, for example:
+//   adb shell /data/benchmarktest64/audiotrack_pipeline_benchmark/audiotrack_pipeline_benchmark
+
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string.h>
+#include <vector>
+
+#include <audio_utils/primitives.h>
+#include <benchmark/benchmark.h>
+#include <media/AudioBufferProvider.h>
+#include <media/AudioMixer.h>
+#include <media/nbaio/MonoPipe.h>
+#include <media/nbaio/MonoPipeReader.h>
+#include <private/media/AudioTrackShared.h>
+
+using namespace android;
+
+namespace {
+
+constexpr uint32_t kSampleRate = 48000;
+constexpr audio_channel_mask_t kChannelMask = AUDIO_CHANNEL_OUT_STEREO;
+constexpr uint32_t kChannelCount = FCC_2;
+constexpr audio_format_t kFormat = AUDIO_FORMAT_PCM_16_BIT;
+constexpr size_t kFrameSize = kChannelCount * sizeof(int16_t);
+
+struct ThreadConfig {
+    const char* name;
+    size_t periodFrames;    // mixer and HAL period
+    size_t trackPeriods;    // track buffer size in periods
+    size_t sinkPeriods;     // HAL buffer size in periods
+};
+
+// Typical configurations of the playback thread types.
+constexpr ThreadConfig kThreadConfigs[] = {
+    { "fast", 192, 2, 2 },          // FastMixer, 4 ms period
+    { "normal", 960, 3, 2 },        // MixerThread, 20 ms period
+    { "deep_buffer", 3840, 2, 2 },  // MixerThread on a deep buffer output, 80 ms period
+};
+
+// The server and client sides of one track, sharing a control block in the same process
+// as TrackBase and AudioTrack do through shared memory.
+class PipelineTrack : public AudioBufferProvider {
+public:
+    explicit PipelineTrack(size_t frameCount)
+        : mMemory(sizeof(audio_track_cblk_t) + frameCount * kFrameSize) {
+        mCblk = new (mMemory.data()) audio_track_cblk_t();
+        void* buffer = mMemory.data() + sizeof(audio_track_cblk_t);
+        mClientProxy = new AudioTrackClientProxy(mCblk, buffer, frameCount, kFrameSize);
+        mServerProxy = new AudioTrackServerProxy(mCblk, buffer, frameCount, kFrameSize,
+                false /* clientInServer */, kSampleRate);
+    }
+
+    ~PipelineTrack() override {
+        mClientProxy.clear();
+        mServerProxy.clear();
+        mCblk->~audio_track_cblk_t();
+    }
+
+    // Same as AudioTrack::write() in non-blocking mode.
+    size_t write(const int16_t* data, size_t frameCount) {
+        size_t written = 0;
+        while (written < frameCount) {
+            Proxy::Buffer buffer;
+            buffer.mFrameCount = frameCount - written;
+            if (mClientProxy->obtainBuffer(&buffer, &ClientProxy::kNonBlocking) != NO_ERROR
+                    || buffer.mFrameCount == 0) {
+                break;
+            }
+            memcpy(buffer.mRaw, data + written * kChannelCount, buffer.mFrameCount * kFrameSize);
+            written += buffer.mFrameCount;
+            mClientProxy->releaseBuffer(&buffer);
+        }
+        mFramesWritten += written;
+        return written;
+    }
+
+    // Same as Track::getNextBuffer().
+    status_t getNextBuffer(AudioBufferProvider::Buffer* buffer) override {
+        ServerProxy::Buffer buf;
+        const size_t desiredFrames = buffer->frameCount;
+        buf.mFrameCount = desiredFrames;
+        const status_t status = mServerProxy->obtainBuffer(&buf);
+        buffer->frameCount = buf.mFrameCount;
+        buffer->raw = buf.mRaw;
+        mServerProxy->tallyUnderrunFrames(buf.mFrameCount == 0 ? desiredFrames : 0);
+        return status;
+    }
+
+    // Same as TrackBase::releaseBuffer().
+    void releaseBuffer(AudioBufferProvider::Buffer* buffer) override {
+        ServerProxy::Buffer buf;
+        buf.mFrameCount = buffer->frameCount;
+        buf.mRaw = buffer->raw;
+        buffer->frameCount = 0;
+        buffer->raw = nullptr;
+        mServerProxy->releaseBuffer(&buf);
+    }
+
+    int64_t framesBuffered() const { return mFramesWritten - mServerProxy->framesReleased(); }
+    uint32_t underrunFrames() const { return mServerProxy->getUnderrunFrames(); }
+
+private:
+    std::vector<uint8_t> mMemory;   // control block followed by the track buffer
+    audio_track_cblk_t* mCblk;
+    sp<AudioTrackClientProxy> mClientProxy;
+    sp<AudioTrackServerProxy> mServerProxy;
+    int64_t mFramesWritten = 0;
+};
+
+// Args: index in kThreadConfigs, number of tracks.
+void BM_AudioTrackPipeline(benchmark::State& state) {
+    const ThreadConfig& config = kThreadConfigs[state.range(0)];
+    const size_t trackCount = state.range(1);
+    const size_t period = config.periodFrames;
+
+    // A full scale square wave, so that the mixer clamps.
+    std::vector<int16_t> clientData(period * kChannelCount);
+    for (size_t i = 0; i < clientData.size(); ++i) {
+        clientData[i] = (i / kChannelCount) & 0x20 ? INT16_MAX : INT16_MIN;
+    }
+
+    std::vector<std::unique_ptr<PipelineTrack>> tracks;
+    std::vector<float> mixBuffer(period * kChannelCount);
+    AudioMixer mixer(period, kSampleRate);
+    float volume = AudioMixer::UNITY_GAIN_FLOAT;
+    for (size_t i = 0; i < trackCount; ++i) {
+        tracks.push_back(std::make_unique<PipelineTrack>(period * config.trackPeriods));
+        const int name = i;
+        if (mixer.create(name, kChannelMask, kFormat, AUDIO_SESSION_OUTPUT_MIX) != OK) {
+            state.SkipWithError("cannot create mixer track");
+            return;
+        }
+        mixer.setBufferProvider(name, tracks[i].get());
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MAIN_BUFFER, mixBuffer.data());
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_FORMAT,
+                (void *)(uintptr_t)AUDIO_FORMAT_PCM_FLOAT);
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::FORMAT,
+                (void *)(uintptr_t)kFormat);
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_CHANNEL_MASK,
+                (void *)(uintptr_t)kChannelMask);
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::CHANNEL_MASK,
+                (void *)(uintptr_t)kChannelMask);
+        mixer.setParameter(name, AudioMixer::RESAMPLE, AudioMixer::SAMPLE_RATE,
+                (void *)(uintptr_t)kSampleRate);
+        mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME0, &volume);
+        mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME1, &volume);
+        mixer.enable(name);
+    }
+
+    const NBAIO_Format format = Format_from_SR_C(kSampleRate, kChannelCount, kFormat);
+    NBAIO_Format offers[1] = {format};
+    size_t numCounterOffers = 0;
+    const sp<MonoPipe> sink = new MonoPipe(period * config.sinkPeriods, format);
+    MonoPipeReader halReader(sink.get());
+    if (sink->negotiate(offers, 1, nullptr, numCounterOffers) != 0
+            || halReader.negotiate(offers, 1, nullptr, numCounterOffers) != 0) {
+        state.SkipWithError("cannot negotiate stub HAL sink format");
+        return;
+    }
+    std::vector<int16_t> sinkBuffer(period * kChannelCount);
+    std::vector<int16_t> halBuffer(period * kChannelCount);
+
+    // Start with the track buffers full but for one period, and the HAL buffer full.
+    for (auto& track : tracks) {
+        for (size_t i = 1; i < config.trackPeriods; ++i) {
+            track->write(clientData.data(), period);
+        }
+    }
+    for (size_t i = 0; i < config.sinkPeriods; ++i) {
+        sink->write(sinkBuffer.data(), period);
+    }
+
+    double bufferedFrames = 0.;
+    for (auto _ : state) {
+        // The HAL consumes one period, after which each client writes one period.
+        halReader.read(halBuffer.data(), period);
+        for (auto& track : tracks) {
+            track->write(clientData.data(), period);
+        }
+
+        mixer.process();
+        memcpy_to_i16_from_float(sinkBuffer.data(), mixBuffer.data(), mixBuffer.size());
+        sink->write(sinkBuffer.data(), period);
+
+        int64_t trackFrames = 0;
+        for (const auto& track : tracks) {
+            trackFrames += track->framesBuffered();
+        }
+        bufferedFrames += (double)trackFrames / trackCount
+                + (sink->framesWritten() - halReader.framesRead());
+        benchmark::ClobberMemory();
+    }
+
+    uint32_t underrunFrames = 0;
+    for (const auto& track : tracks) {
+        underrunFrames += track->underrunFrames();
+    }
+    state.SetLabel(config.name);
+    state.counters["latencyMs"] = benchmark::Counter(
+            bufferedFrames * 1000. / kSampleRate, benchmark::Counter::kAvgIterations);
+    state.counters["underrunFrames"] = underrunFrames;
+}
+
+void PipelineArgs(benchmark::internal::Benchmark* b) {
+    for (size_t config = 0; config < std::size(kThreadConfigs); ++config) {
+        for (int tracks : {1, 2, 4, 8, 16}) {
+            b->Args({(int64_t)config, tracks});
+        }
+    }
+}
+
+BENCHMARK(BM_AudioTrackPipeline)->Apply(PipelineArgs);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -17,6 +17,14 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "AudioTrackTests"
 
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
 #include <binder/ProcessState.h>
 #include <gtest/gtest.h>
 
@@ -25,6 +33,29 @@
 
 using namespace android;
 
+// Allocations are counted on the threads which set tCountAllocations.
+static thread_local bool tCountAllocations = false;
+static std::atomic<size_t> gAllocationCount = 0;
+
+void* operator new(size_t size) {
+    if (tCountAllocations) gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    void* p = malloc(size != 0 ? size : 1);
+    if (p == nullptr) abort();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
 // Test that the basic constructor returns an object that doesn't crash
 // on stop() or destruction.
 
@@ -175,6 +206,71 @@ TEST(AudioTrackTest, TestAudioCbNotifier) {
     ap->stop();
 }
 
+// Counts the allocations made by the AudioTrack callback thread between two
+// EVENT_MORE_DATA callbacks, that is by the streaming path of AudioTrack itself.
+class AllocationCountingCallback : public AudioTrack::IAudioTrackCallback {
+  public:
+    static constexpr size_t kWarmupBuffers = 20;
+    static constexpr size_t kMeasuredBuffers = 1000;
+
+    size_t onMoreData(const AudioTrack::Buffer& buffer) override {
+        tCountAllocations = false;
+        const size_t buffers = ++mBuffers;
+        if (buffers == kWarmupBuffers) {
+            mAllocationsAtWarmup = gAllocationCount.load();
+        } else if (buffers == kWarmupBuffers + kMeasuredBuffers) {
+            std::lock_guard l(mMutex);
+            mAllocations = gAllocationCount.load() - mAllocationsAtWarmup;
+            mDone = true;
+            mCondition.notify_all();
+        }
+        memset(buffer.data(), 0, buffer.size());
+        tCountAllocations = true;
+        return buffer.size();
+    }
+
+    // Returns false if the buffers were not all requested in time.
+    bool waitForMeasurement(size_t* allocations) {
+        std::unique_lock l(mMutex);
+        if (!mCondition.wait_for(l, std::chrono::seconds(30), [this] { return mDone; })) {
+            return false;
+        }
+        *allocations = mAllocations;
+        return true;
+    }
+
+  private:
+    std::atomic<size_t> mBuffers = 0;
+    size_t mAllocationsAtWarmup = 0;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mDone = false;
+    size_t mAllocations = 0;
+};
+
+// Streams through EVENT_MORE_DATA with small buffers, the steady state must not allocate.
+TEST(AudioTrackTest, CallbackStreamingDoesNotAllocate) {
+    AttributionSourceState attributionSource;
+    attributionSource.packageName = "AudioTrackTest";
+    attributionSource.uid = VALUE_OR_FATAL(legacy2aidl_uid_t_int32_t(getuid()));
+    attributionSource.pid = VALUE_OR_FATAL(legacy2aidl_pid_t_int32_t(getpid()));
+    attributionSource.token = sp<BBinder>::make();
+    const auto callback = sp<AllocationCountingCallback>::make();
+    const auto track = sp<AudioTrack>::make(AUDIO_STREAM_MUSIC, 48000 /* sampleRate */,
+            AUDIO_FORMAT_PCM_16_BIT, AUDIO_CHANNEL_OUT_STEREO, 0 /* frameCount */,
+            AUDIO_OUTPUT_FLAG_FAST, callback, -4 /* notificationFrames, 4 buffers */,
+            AUDIO_SESSION_ALLOCATE, AudioTrack::TRANSFER_CALLBACK, nullptr /* offloadInfo */,
+            attributionSource);
+    ASSERT_EQ(OK, track->initCheck());
+    ASSERT_EQ(OK, track->start());
+    size_t allocations = 0;
+    const bool measured = callback->waitForMeasurement(&allocations);
+    track->stop();
+    ASSERT_TRUE(measured) << "the track did not request enough buffers";
+    EXPECT_EQ(0u, allocations) << "allocations over "
+            << AllocationCountingCallback::kMeasuredBuffers << " buffers";
+}
+
 class AudioTrackCreateTest
     : public ::testing::TestWithParam<std::tuple<uint32_t, audio_format_t, audio_channel_mask_t,
                                                  audio_output_flags_t, audio_session_t>> {
@@ -36,13 +36,18 @@ status_t EffectBufferHalAidl::allocate(size_t size, sp<EffectBufferHalInterface>
     return mirror(nullptr, size, buffer);
 }
 
+// The AIDL effect HAL receives the audio data through FMQs, so the buffer does not need to be
+// shared memory: a mirror buffer uses the external memory directly, and update() and commit()
+// are no-ops, saving two copies of the buffer per process().
 status_t EffectBufferHalAidl::mirror(void* external, size_t size,
                                      sp<EffectBufferHalInterface>* buffer) {
     sp<EffectBufferHalAidl> tempBuffer = new EffectBufferHalAidl(size);
-    status_t status = tempBuffer.get()->init();
-    if (status != OK) {
-        ALOGE("%s init failed %d", __func__, status);
-        return status;
+    if (external == nullptr) {
+        status_t status = tempBuffer.get()->init();
+        if (status != OK) {
+            ALOGE("%s init failed %d", __func__, status);
+            return status;
+        }
     }
 
     tempBuffer->setExternalData(external);
@@ -58,13 +63,15 @@ EffectBufferHalAidl::EffectBufferHalAidl(size_t size)
 }
 
 EffectBufferHalAidl::~EffectBufferHalAidl() {
-    if (mAudioBuffer.raw) free(mAudioBuffer.raw);
+    free(mAllocatedBuffer);
 }
 
 status_t EffectBufferHalAidl::init() {
-    if (0 != posix_memalign(&mAudioBuffer.raw, 32, mBufferSize)) {
+    if (0 != posix_memalign(&mAllocatedBuffer, 32, mBufferSize)) {
+        mAllocatedBuffer = nullptr;
         return NO_MEMORY;
     }
+    mAudioBuffer.raw = mAllocatedBuffer;
 
     return OK;
 }
@@ -90,6 +97,14 @@ bool EffectBufferHalAidl::checkFrameCountChange() {
 
 void EffectBufferHalAidl::setExternalData(void* external) {
     mExternalData = external;
+    if (external != nullptr) {
+        mAudioBuffer.raw = external;
+    } else {
+        if (mAllocatedBuffer == nullptr && init() != OK) {
+            ALOGE("%s cannot allocate %zu bytes", __func__, mBufferSize);
+        }
+        mAudioBuffer.raw = mAllocatedBuffer;
+    }
 }
 
 void EffectBufferHalAidl::update() {
@@ -101,7 +116,7 @@ void EffectBufferHalAidl::commit() {
 }
 
 void EffectBufferHalAidl::copy(void* dst, const void* src, size_t n) const {
-    if (!dst || !src) {
+    if (!dst || !src || dst == src) {
         return;
     }
     std::memcpy(dst, src, std::min(n, mBufferSize));
@@ -50,6 +50,9 @@ class EffectBufferHalAidl : public EffectBufferHalInterface {
     const size_t mBufferSize;
     bool mFrameCountChanged;
     void* mExternalData;
+    // memory owned by this buffer, only allocated when there is no external data
+    void* mAllocatedBuffer = nullptr;
+    // points to the external data if any, otherwise to mAllocatedBuffer
     audio_buffer_t mAudioBuffer;
 
     // Can not be constructed directly by clients.
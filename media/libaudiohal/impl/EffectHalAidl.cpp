@@ -257,12 +257,34 @@ status_t EffectHalAidl::process() {
         return INVALID_OPERATION;
     }
 
+    // In accumulate mode, accumulate directly from the output FMQ memory instead of
+    // reading the FMQ into a temporary buffer first.
+    if (mConversion->mOutputAccessMode == EFFECT_BUFFER_ACCESS_ACCUMULATE && !mIsHapticGenerator) {
+        EffectConversionHelperAidl::DataMQ::MemTransaction tx;
+        if (!outputQ->beginRead(floatsToRead, &tx)) {
+            ALOGE("%s failed to begin read of %zu from outputQ", __func__, floatsToRead);
+            return INVALID_OPERATION;
+        }
+        // the second region is not empty when the data wraps around the end of the FMQ.
+        float* out = mOutBuffer->audioBuffer()->f32;
+        for (const auto& region : {tx.getFirstRegion(), tx.getSecondRegion()}) {
+            if (region.getLength() == 0) continue;
+            accumulate_float(out, region.getAddress(), region.getLength());
+            out += region.getLength();
+        }
+        if (!outputQ->commitRead(floatsToRead)) {
+            ALOGE("%s failed to commit read of %zu from outputQ", __func__, floatsToRead);
+            return INVALID_OPERATION;
+        }
+        return OK;
+    }
+
     float *outputRawBuffer = mOutBuffer->audioBuffer()->f32;
-    std::vector<float> tempBuffer;
-    // keep original data in the output buffer for accumulate mode or HapticGenerator effect
-    if (mConversion->mOutputAccessMode == EFFECT_BUFFER_ACCESS_ACCUMULATE || mIsHapticGenerator) {
-        tempBuffer.resize(floatsToRead);
-        outputRawBuffer = tempBuffer.data();
+    // keep original data in the output buffer for HapticGenerator effect
+    if (mIsHapticGenerator) {
+        // only allocates when the buffer size grows, not on every process() call.
+        mTempBuffer.resize(floatsToRead);
+        outputRawBuffer = mTempBuffer.data();
     }
     // always read floating point data for AIDL
     if (!outputQ->read(outputRawBuffer, floatsToRead)) {
@@ -294,8 +316,6 @@ status_t EffectHalAidl::process() {
         memcpy_to_float_from_float_with_clamping(mInBuffer->audioBuffer()->f32 + audioSamples,
                                                  outputRawBuffer + audioSamples,
                                                  floatsToRead - audioSamples, kHalFloatSampleLimit);
-    } else if (mConversion->mOutputAccessMode == EFFECT_BUFFER_ACCESS_ACCUMULATE) {
-        accumulate_float(mOutBuffer->audioBuffer()->f32, outputRawBuffer, floatsToRead);
     }
 
     return OK;
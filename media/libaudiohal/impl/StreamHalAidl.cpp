@@ -19,8 +19,10 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <utility>
 
 #include <audio_utils/clock.h>
+#include <cutils/properties.h>
 #include <media/AidlConversion.h>
 #include <media/AidlConversionCore.h>
 #include <media/AidlConversionCppNdk.h>
@@ -88,7 +90,10 @@ StreamHalAidl::StreamHalAidl(
           mLastReplyLifeTimeNs(
                   std::min(static_cast<size_t>(100),
                           2 * mContext.getBufferDurationMs(mConfig.sample_rate))
-                  * NANOS_PER_MILLISECOND)
+                  * NANOS_PER_MILLISECOND),
+          mPipelinedBursts(!isInput && !mContext.isAsynchronous() && !mContext.isMmapped() &&
+                  property_get_bool("audio.hal.aidl.pipelined_writes", false)),
+          mTransferLatencyLog(isInput ? "Read" : "Write")
 {
     ALOGD("%p %s::%s", this, getClassName().c_str(), __func__);
     {
@@ -250,6 +255,7 @@ status_t StreamHalAidl::dump(int fd, const Vector<String16>& args) {
     newArgs.push(String16(kDumpFromAudioServerArgument));
     status_t status = mStream->dump(fd, Args(newArgs).args(), newArgs.size());
     mStreamPowerLog.dump(fd);
+    mTransferLatencyLog.dump(fd);
     return status;
 }
 
@@ -371,6 +377,13 @@ status_t StreamHalAidl::transfer(void *buffer, size_t bytes, size_t *transferred
     // TIME_CHECK();  // TODO(b/243839867) reenable only when optimized.
     if (!mStream || mContext.getDataMQ() == nullptr) return NO_INIT;
     mWorkerTid.store(gettid(), std::memory_order_release);
+    const nsecs_t startNs = systemTime();
+    if (mPipelinedBursts) {
+        // Wait for the HAL to consume the data of the previous write. The reply carries
+        // the positions and the latency, which are cached for the getters.
+        std::lock_guard l(mCommandReplyLock);
+        RETURN_STATUS_IF_ERROR(completePendingCommand());
+    }
     // Switch the stream into an active state if needed.
     // Note: in future we may add support for priming the audio pipeline
     // with data prior to enabling output (thus we can issue a "burst" command in the "standby"
@@ -398,9 +411,16 @@ status_t StreamHalAidl::transfer(void *buffer, size_t bytes, size_t *transferred
             return NOT_ENOUGH_DATA;
         }
     }
-    StreamDescriptor::Reply reply;
-    RETURN_STATUS_IF_ERROR(sendCommand(burst, &reply));
-    *transferred = reply.fmqByteCount;
+    if (mPipelinedBursts) {
+        // The HAL consumes from the data MQ all the bytes of the burst.
+        RETURN_STATUS_IF_ERROR(postCommand(burst));
+        *transferred = bytes;
+    } else {
+        StreamDescriptor::Reply reply;
+        RETURN_STATUS_IF_ERROR(sendCommand(burst, &reply));
+        *transferred = reply.fmqByteCount;
+    }
+    mTransferLatencyLog.log(startNs);
     if (mIsInput) {
         LOG_ALWAYS_FATAL_IF(*transferred > bytes,
                 "%s: HAL module read %zu bytes, which exceeds requested count %zu",
@@ -574,46 +594,74 @@ status_t StreamHalAidl::sendCommand(
                 __func__, command.toString().c_str(), workerTid);
     }
     StreamDescriptor::Reply localReply{};
-    {
-        std::lock_guard l(mCommandReplyLock);
-        if (!mContext.getCommandMQ()->writeBlocking(&command, 1)) {
-            ALOGE("%s: failed to write command %s to MQ", __func__, command.toString().c_str());
-            return NOT_ENOUGH_DATA;
+    if (reply == nullptr) {
+        reply = &localReply;
+    }
+    std::lock_guard l(mCommandReplyLock);
+    if (mPendingCommand.has_value()) {
+        // Nobody waits for the status of a pipelined burst anymore, only log failures.
+        if (status_t status = completePendingCommand(); status != OK) {
+            ALOGW("%s: pending burst failed before command %s: %d",
+                    __func__, command.toString().c_str(), status);
         }
-        if (reply == nullptr) {
-            reply = &localReply;
+    }
+    if (!mContext.getCommandMQ()->writeBlocking(&command, 1)) {
+        ALOGE("%s: failed to write command %s to MQ", __func__, command.toString().c_str());
+        return NOT_ENOUGH_DATA;
+    }
+    return readReply(command, reply, statePositions);
+}
+
+status_t StreamHalAidl::postCommand(const StreamDescriptor::Command& command) {
+    std::lock_guard l(mCommandReplyLock);
+    if (!mContext.getCommandMQ()->writeBlocking(&command, 1)) {
+        ALOGE("%s: failed to write command %s to MQ", __func__, command.toString().c_str());
+        return NOT_ENOUGH_DATA;
+    }
+    mPendingCommand = command;
+    return OK;
+}
+
+status_t StreamHalAidl::completePendingCommand() {
+    if (!mPendingCommand.has_value()) return OK;
+    const StreamDescriptor::Command command = *std::exchange(mPendingCommand, std::nullopt);
+    StreamDescriptor::Reply reply;
+    return readReply(command, &reply, nullptr /*statePositions*/);
+}
+
+status_t StreamHalAidl::readReply(
+        const StreamDescriptor::Command& command, StreamDescriptor::Reply* reply,
+        StatePositions* statePositions) {
+    if (!mContext.getReplyMQ()->readBlocking(reply, 1)) {
+        ALOGE("%s: failed to read from reply MQ, command %s",
+                __func__, command.toString().c_str());
+        return NOT_ENOUGH_DATA;
+    }
+    {
+        std::lock_guard l(mLock);
+        // Not every command replies with 'latencyMs' field filled out, substitute the last
+        // returned value in that case.
+        if (reply->latencyMs <= 0) {
+            reply->latencyMs = mLastReply.latencyMs;
         }
-        if (!mContext.getReplyMQ()->readBlocking(reply, 1)) {
-            ALOGE("%s: failed to read from reply MQ, command %s",
-                    __func__, command.toString().c_str());
-            return NOT_ENOUGH_DATA;
+        mLastReply = *reply;
+        mLastReplyExpirationNs = uptimeNanos() + mLastReplyLifeTimeNs;
+        if (!mIsInput && reply->status == STATUS_OK) {
+            if (command.getTag() == StreamDescriptor::Command::standby &&
+                    reply->state == StreamDescriptor::State::STANDBY) {
+                mStatePositions.framesAtStandby = reply->observable.frames;
+            } else if (command.getTag() == StreamDescriptor::Command::flush &&
+                       reply->state == StreamDescriptor::State::IDLE) {
+                mStatePositions.framesAtFlushOrDrain = reply->observable.frames;
+            } else if (!mContext.isAsynchronous() &&
+                    command.getTag() == StreamDescriptor::Command::drain &&
+                    (reply->state == StreamDescriptor::State::IDLE ||
+                            reply->state == StreamDescriptor::State::DRAINING)) {
+                mStatePositions.framesAtFlushOrDrain = reply->observable.frames;
+            } // for asynchronous drain, the frame count is saved in 'onAsyncDrainReady'
         }
-        {
-            std::lock_guard l(mLock);
-            // Not every command replies with 'latencyMs' field filled out, substitute the last
-            // returned value in that case.
-            if (reply->latencyMs <= 0) {
-                reply->latencyMs = mLastReply.latencyMs;
-            }
-            mLastReply = *reply;
-            mLastReplyExpirationNs = uptimeNanos() + mLastReplyLifeTimeNs;
-            if (!mIsInput && reply->status == STATUS_OK) {
-                if (command.getTag() == StreamDescriptor::Command::standby &&
-                        reply->state == StreamDescriptor::State::STANDBY) {
-                    mStatePositions.framesAtStandby = reply->observable.frames;
-                } else if (command.getTag() == StreamDescriptor::Command::flush &&
-                           reply->state == StreamDescriptor::State::IDLE) {
-                    mStatePositions.framesAtFlushOrDrain = reply->observable.frames;
-                } else if (!mContext.isAsynchronous() &&
-                        command.getTag() == StreamDescriptor::Command::drain &&
-                        (reply->state == StreamDescriptor::State::IDLE ||
-                                reply->state == StreamDescriptor::State::DRAINING)) {
-                    mStatePositions.framesAtFlushOrDrain = reply->observable.frames;
-                } // for asynchronous drain, the frame count is saved in 'onAsyncDrainReady'
-            }
-            if (statePositions != nullptr) {
-                *statePositions = mStatePositions;
-            }
+        if (statePositions != nullptr) {
+            *statePositions = mStatePositions;
         }
     }
     switch (reply->status) {
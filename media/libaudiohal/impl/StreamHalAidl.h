@@ -19,6 +19,7 @@
 #include <atomic>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string_view>
 
 #include <aidl/android/hardware/audio/common/AudioOffloadMetadata.h>
@@ -35,6 +36,7 @@
 #include <mediautils/Synchronization.h>
 
 #include "ConversionHelperAidl.h"
+#include "StreamLatencyLog.h"
 #include "StreamPowerLog.h"
 
 using ::aidl::android::hardware::audio::common::AudioOffloadMetadata;
@@ -279,6 +281,15 @@ class StreamHalAidl : public virtual StreamHalInterface, public ConversionHelper
             ::aidl::android::hardware::audio::core::StreamDescriptor::Reply* reply = nullptr,
             bool safeFromNonWorkerThread = false,
             StatePositions* statePositions = nullptr);
+    // Sends a burst command without waiting for its reply, which is read by
+    // 'completePendingCommand' before the next command is sent.
+    status_t postCommand(
+            const ::aidl::android::hardware::audio::core::StreamDescriptor::Command& command);
+    status_t completePendingCommand() REQUIRES(mCommandReplyLock);
+    status_t readReply(
+            const ::aidl::android::hardware::audio::core::StreamDescriptor::Command& command,
+            ::aidl::android::hardware::audio::core::StreamDescriptor::Reply* reply,
+            StatePositions* statePositions) REQUIRES(mCommandReplyLock);
     status_t updateCountersIfNeeded(
             ::aidl::android::hardware::audio::core::StreamDescriptor::Reply* reply = nullptr,
             StatePositions* statePositions = nullptr);
@@ -286,6 +297,13 @@ class StreamHalAidl : public virtual StreamHalInterface, public ConversionHelper
     const std::shared_ptr<::aidl::android::hardware::audio::core::IStreamCommon> mStream;
     const std::shared_ptr<::aidl::android::media::audio::IHalAdapterVendorExtension> mVendorExt;
     const int64_t mLastReplyLifeTimeNs;
+    // Whether writes are pipelined: the reply to a burst is only read at the next write,
+    // instead of blocking the writer until the HAL has consumed the data. Synchronous
+    // outputs only, see 'transfer'.
+    const bool mPipelinedBursts;
+    // The burst command posted by the last pipelined write, its reply is still pending.
+    std::optional<::aidl::android::hardware::audio::core::StreamDescriptor::Command>
+            mPendingCommand GUARDED_BY(mCommandReplyLock);
     std::mutex mLock;
     ::aidl::android::hardware::audio::core::StreamDescriptor::Reply mLastReply GUARDED_BY(mLock);
     int64_t mLastReplyExpirationNs GUARDED_BY(mLock) = 0;
@@ -294,6 +312,8 @@ class StreamHalAidl : public virtual StreamHalInterface, public ConversionHelper
     StatePositions mStatePositions GUARDED_BY(mLock) = {};
     // mStreamPowerLog is used for audio signal power logging.
     StreamPowerLog mStreamPowerLog;
+    // mTransferLatencyLog is used for logging the time spent in the HAL by reads and writes.
+    StreamLatencyLog mTransferLatencyLog;
     std::atomic<pid_t> mWorkerTid = -1;
 };
 
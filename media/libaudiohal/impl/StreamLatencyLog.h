@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+#include <cstdint>
+#include <mutex>
+
+#include <android-base/thread_annotations.h>
+#include <audio_utils/Statistics.h>
+#include <utils/Timers.h>
+
+namespace android {
+
+// Statistics of the time spent in the HAL by the stream I/O calls.
+class StreamLatencyLog {
+  public:
+    explicit StreamLatencyLog(const char* name) : mName(name) {}
+
+    // Log the duration of an I/O call which started at startNs (SYSTEM_TIME_MONOTONIC).
+    void log(nsecs_t startNs) {
+        const double durationMs = (systemTime() - startNs) * 1e-6;
+        std::lock_guard l(mLock);
+        mStatistics.add(durationMs);
+    }
+
+    // Dump the statistics to fd.
+    void dump(int fd) const {
+        std::lock_guard l(mLock);
+        if (mStatistics.getN() == 0) return;
+        dprintf(fd, "      %s latency (ms): %s\n", mName, mStatistics.toString().c_str());
+    }
+
+  private:
+    const char* const mName;
+    mutable std::mutex mLock;
+    audio_utils::Statistics<double> mStatistics GUARDED_BY(mLock);
+};
+
+} // namespace android
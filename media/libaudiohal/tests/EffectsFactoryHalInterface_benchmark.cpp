@@ -0,0 +1,262 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Runs every effect available through the effects factory HAL, AIDL or HIDL (the latter
+// wrapping the legacy effect libraries), over the same signals and configurations, so that
+// effects from different implementations can be compared with each other.
+//
+// Benchmarks are named BM_Effect/<effect name>/<signal>/<channel mask>/<sample rate>/<frames>,
+// use --benchmark_filter to select them. A configuration an effect doesn't accept is reported
+// as an error and skipped.
+// Each benchmark reports frames_per_second, and time_per_frame (in seconds).
+// The effects run in the HAL process, so their memory allocations are not visible from here:
+// use heapprofd on the HAL service to look at them.
+
+#define LOG_TAG "EffectsFactoryHalInterfaceBenchmark"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/audiohal/EffectsFactoryHalInterface.h>
+#include <system/audio.h>
+#include <system/audio_effect.h>
+#include <utils/Log.h>
+
+namespace android {
+namespace {
+
+enum Signal {
+    NOISE,
+    SINE,
+    SILENCE,
+};
+
+constexpr const char* kSignalNames[] = {"noise", "sine", "silence"};
+
+struct Configuration {
+    Signal signal;
+    audio_channel_mask_t channelMask;
+    uint32_t sampleRate;
+    size_t frameCount;
+};
+
+constexpr audio_channel_mask_t kOutputChannelMasks[] = {
+        AUDIO_CHANNEL_OUT_STEREO,
+        AUDIO_CHANNEL_OUT_5POINT1,
+        AUDIO_CHANNEL_OUT_7POINT1POINT4,
+};
+constexpr uint32_t kOutputSampleRates[] = {44100, 48000, 96000};
+constexpr size_t kOutputDurationsMs[] = {5, 10, 20};
+
+// Pre processing needs 10 ms buffers.
+constexpr audio_channel_mask_t kInputChannelMasks[] = {
+        AUDIO_CHANNEL_IN_MONO,
+        AUDIO_CHANNEL_IN_STEREO,
+};
+constexpr uint32_t kInputSampleRates[] = {16000, 48000};
+constexpr size_t kInputDurationMs = 10;
+
+bool isPreProcessing(const effect_descriptor_t& desc) {
+    return (desc.flags & EFFECT_FLAG_TYPE_MASK) == EFFECT_FLAG_TYPE_PRE_PROC;
+}
+
+// Like audioflinger, auxiliary effects get a mono input.
+bool isAuxiliary(const effect_descriptor_t& desc) {
+    return (desc.flags & EFFECT_FLAG_TYPE_MASK) == EFFECT_FLAG_TYPE_AUXILIARY;
+}
+
+// Noise is run with all the configurations, the other signals only with stereo at 48 kHz.
+std::vector<Configuration> getConfigurations(const effect_descriptor_t& desc) {
+    std::vector<Configuration> configurations;
+    for (Signal signal : {NOISE, SINE, SILENCE}) {
+        if (isPreProcessing(desc)) {
+            for (audio_channel_mask_t channelMask : kInputChannelMasks) {
+                for (uint32_t sampleRate : kInputSampleRates) {
+                    if (signal != NOISE && (channelMask != AUDIO_CHANNEL_IN_STEREO ||
+                                            sampleRate != 48000)) {
+                        continue;
+                    }
+                    configurations.push_back({signal, channelMask, sampleRate,
+                                              sampleRate * kInputDurationMs / 1000});
+                }
+            }
+            continue;
+        }
+        for (audio_channel_mask_t channelMask : kOutputChannelMasks) {
+            for (uint32_t sampleRate : kOutputSampleRates) {
+                for (size_t durationMs : kOutputDurationsMs) {
+                    if (signal != NOISE && (channelMask != AUDIO_CHANNEL_OUT_STEREO ||
+                                            sampleRate != 48000 || durationMs != 10)) {
+                        continue;
+                    }
+                    configurations.push_back(
+                            {signal, channelMask, sampleRate, sampleRate * durationMs / 1000});
+                }
+            }
+        }
+    }
+    return configurations;
+}
+
+void fillSignal(float* data, size_t frameCount, size_t channelCount, const Configuration& c) {
+    switch (c.signal) {
+        case NOISE: {
+            std::minstd_rand gen(frameCount * channelCount);
+            std::uniform_real_distribution<float> dis(-0.5f, 0.5f);
+            for (size_t i = 0; i < frameCount * channelCount; ++i) {
+                data[i] = dis(gen);
+            }
+        } break;
+        case SINE: {
+            constexpr float kFrequency = 1000.f;
+            for (size_t i = 0; i < frameCount; ++i) {
+                const float sample = 0.5f * std::sin(2 * M_PI * kFrequency * i / c.sampleRate);
+                std::fill(data + i * channelCount, data + (i + 1) * channelCount, sample);
+            }
+        } break;
+        case SILENCE:
+            std::fill(data, data + frameCount * channelCount, 0.f);
+            break;
+    }
+}
+
+void BM_Effect(benchmark::State& state, sp<EffectsFactoryHalInterface> factory,
+               effect_descriptor_t desc, Configuration c) {
+    constexpr int32_t kSessionId = AUDIO_SESSION_OUTPUT_MIX;
+    constexpr int32_t kIoId = 1;
+    constexpr int32_t kDeviceId = AUDIO_PORT_HANDLE_NONE;
+    sp<EffectHalInterface> effect;
+    if (factory->createEffect(&desc.uuid, kSessionId, kIoId, kDeviceId, &effect) != OK) {
+        state.SkipWithError("createEffect failed");
+        return;
+    }
+
+    const bool input = isPreProcessing(desc);
+    const audio_channel_mask_t inChannelMask = isAuxiliary(desc)
+            ? AUDIO_CHANNEL_OUT_MONO : c.channelMask;
+    const size_t inChannelCount = input ? audio_channel_count_from_in_mask(inChannelMask)
+                                        : audio_channel_count_from_out_mask(inChannelMask);
+    const size_t outChannelCount = input ? audio_channel_count_from_in_mask(c.channelMask)
+                                         : audio_channel_count_from_out_mask(c.channelMask);
+    effect_config_t config{};
+    config.inputCfg.accessMode = EFFECT_BUFFER_ACCESS_READ;
+    config.inputCfg.channels = inChannelMask;
+    config.inputCfg.samplingRate = c.sampleRate;
+    config.inputCfg.format = AUDIO_FORMAT_PCM_FLOAT;
+    config.inputCfg.buffer.frameCount = c.frameCount;
+    config.inputCfg.mask = EFFECT_CONFIG_ALL;
+    config.outputCfg = config.inputCfg;
+    config.outputCfg.accessMode = EFFECT_BUFFER_ACCESS_WRITE;
+    config.outputCfg.channels = c.channelMask;
+
+    int32_t reply = 0;
+    uint32_t replySize = sizeof(reply);
+    if (effect->command(EFFECT_CMD_INIT, 0, nullptr, &replySize, &reply) != OK || reply != 0) {
+        state.SkipWithError("EFFECT_CMD_INIT failed");
+        effect->close();
+        return;
+    }
+    if (effect->command(EFFECT_CMD_SET_CONFIG, sizeof(config), &config, &replySize, &reply) != OK
+            || reply != 0) {
+        state.SkipWithError("configuration not supported");
+        effect->close();
+        return;
+    }
+
+    sp<EffectBufferHalInterface> inBuffer, outBuffer;
+    if (factory->allocateBuffer(c.frameCount * inChannelCount * sizeof(float), &inBuffer) != OK
+            || factory->allocateBuffer(c.frameCount * outChannelCount * sizeof(float),
+                                       &outBuffer) != OK) {
+        state.SkipWithError("allocateBuffer failed");
+        effect->close();
+        return;
+    }
+    inBuffer->setFrameCount(c.frameCount);
+    outBuffer->setFrameCount(c.frameCount);
+    fillSignal(inBuffer->audioBuffer()->f32, c.frameCount, inChannelCount, c);
+    effect->setInBuffer(inBuffer);
+    effect->setOutBuffer(outBuffer);
+
+    if (effect->command(EFFECT_CMD_ENABLE, 0, nullptr, &replySize, &reply) != OK || reply != 0) {
+        state.SkipWithError("EFFECT_CMD_ENABLE failed");
+        effect->close();
+        return;
+    }
+
+    for (auto _ : state) {
+        // -ENODATA is returned by effects with nothing to output, e.g. before their tail ends.
+        if (status_t status = effect->process(); status != OK && status != -ENODATA) {
+            state.SkipWithError("process failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * c.frameCount);
+    state.counters["frames_per_second"] = benchmark::Counter(
+            c.frameCount, benchmark::Counter::kIsIterationInvariantRate);
+    state.counters["time_per_frame"] = benchmark::Counter(
+            c.frameCount,
+            benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+
+    effect->command(EFFECT_CMD_DISABLE, 0, nullptr, &replySize, &reply);
+    effect->close();
+}
+
+// Names must not contain the '/' separating the arguments.
+std::string sanitizeName(const char* name) {
+    std::string result(name);
+    std::replace(result.begin(), result.end(), '/', '_');
+    std::replace(result.begin(), result.end(), ' ', '_');
+    return result;
+}
+
+void registerBenchmarks() {
+    sp<EffectsFactoryHalInterface> factory = EffectsFactoryHalInterface::create();
+    uint32_t numEffects = 0;
+    if (factory == nullptr || factory->queryNumberEffects(&numEffects) != OK) {
+        ALOGE("%s: no effects factory", __func__);
+        return;
+    }
+    for (uint32_t i = 0; i < numEffects; i++) {
+        effect_descriptor_t desc;
+        if (factory->getDescriptor(i, &desc) != OK) {
+            continue;
+        }
+        const bool input = isPreProcessing(desc);
+        for (const Configuration& c : getConfigurations(desc)) {
+            const std::string name = std::string("BM_Effect/") + sanitizeName(desc.name) + "/" +
+                    kSignalNames[c.signal] + "/" +
+                    (input ? audio_channel_in_mask_to_string(c.channelMask)
+                           : audio_channel_out_mask_to_string(c.channelMask)) + "/" +
+                    std::to_string(c.sampleRate) + "/" + std::to_string(c.frameCount);
+            benchmark::RegisterBenchmark(name.c_str(), BM_Effect, factory, desc, c);
+        }
+    }
+}
+
+}  // namespace
+}  // namespace android
+
+int main(int argc, char** argv) {
+    android::registerBenchmarks();
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
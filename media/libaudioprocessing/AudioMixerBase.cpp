@@ -623,6 +623,7 @@ void AudioMixerBase::process__validate()
     // either properly handle muted tracks (it should ignore them)
     // or remove altogether as an obsolete optimization.
     bool all16BitsStereoNoResample = true;
+    bool allMultiTrackStereo = true;
     bool resampling = false;
     bool volumeRamp = false;
 
@@ -653,6 +654,10 @@ void AudioMixerBase::process__validate()
         }
         t->needs = n;
 
+        if ((n & (NEEDS_AUX | NEEDS_RESAMPLE)) != 0 || !t->isMultiTrackStereoFloat()) {
+            allMultiTrackStereo = false;
+        }
+
         if (n & NEEDS_MUTE) {
             t->hook = &TrackBase::track__nop;
         } else {
@@ -732,12 +737,16 @@ void AudioMixerBase::process__validate()
                     }
                 }
             }
+            if (allMultiTrackStereo && mEnabled.size() > 1) {
+                mHook = &AudioMixerBase::process__noResampleMultiTrackStereo;
+            }
         }
     }
 
     ALOGV("mixer configuration change: %zu "
-        "all16BitsStereoNoResample=%d, resampling=%d, volumeRamp=%d",
-        mEnabled.size(), all16BitsStereoNoResample, resampling, volumeRamp);
+        "all16BitsStereoNoResample=%d, allMultiTrackStereo=%d, resampling=%d, volumeRamp=%d",
+        mEnabled.size(), all16BitsStereoNoResample, allMultiTrackStereo, resampling,
+        volumeRamp);
 
     process();
 
@@ -757,15 +766,15 @@ void AudioMixerBase::process__validate()
         }
         if (allMuted) {
             mHook = &AudioMixerBase::process__nop;
-        } else if (all16BitsStereoNoResample) {
-            if (mEnabled.size() == 1) {
-                //const int i = 31 - __builtin_clz(enabledTracks);
-                const std::shared_ptr<TrackBase> &t = mTracks[mEnabled[0]];
-                // Muted single tracks handled by allMuted above.
-                mHook = getProcessHook(PROCESSTYPE_NORESAMPLEONETRACK,
-                        t->mMixerChannelCount, t->mMixerInFormat, t->mMixerFormat,
-                        t->useStereoVolume());
-            }
+        } else if (all16BitsStereoNoResample && mEnabled.size() == 1) {
+            //const int i = 31 - __builtin_clz(enabledTracks);
+            const std::shared_ptr<TrackBase> &t = mTracks[mEnabled[0]];
+            // Muted single tracks handled by allMuted above.
+            mHook = getProcessHook(PROCESSTYPE_NORESAMPLEONETRACK,
+                    t->mMixerChannelCount, t->mMixerInFormat, t->mMixerFormat,
+                    t->useStereoVolume());
+        } else if (allMultiTrackStereo && mEnabled.size() > 1) {
+            mHook = &AudioMixerBase::process__noResampleMultiTrackStereo;
         }
     }
 }
@@ -1222,6 +1231,199 @@ void AudioMixerBase::process__genericResampling()
     }
 }
 
+/* static */
+bool AudioMixerBase::finalizeStereo(void* out, audio_format_t outFormat, const float* in,
+        size_t frameCount, bool mono, float gain[FCC_2], const float gainInc[FCC_2],
+        float absMax)
+{
+    switch (outFormat) {
+    case AUDIO_FORMAT_PCM_FLOAT:
+        mono ? ::android::finalizeStereo<float, true>(
+                        (float*)out, in, frameCount, gain, gainInc, absMax)
+                : ::android::finalizeStereo<float, false>(
+                        (float*)out, in, frameCount, gain, gainInc, absMax);
+        return true;
+    case AUDIO_FORMAT_PCM_16_BIT:
+        mono ? ::android::finalizeStereo<int16_t, true>(
+                        (int16_t*)out, in, frameCount, gain, gainInc, absMax)
+                : ::android::finalizeStereo<int16_t, false>(
+                        (int16_t*)out, in, frameCount, gain, gainInc, absMax);
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Mixes a batch of kMaxMultiTracksStereo or fewer float stereo tracks into out.
+// If volinc is not nullptr, the volume is ramped and vol is updated.
+static void mixMultiTracksStereo(float *out, size_t frameCount,
+        const float* const* in, float (*vol)[FCC_2], const float (*volinc)[FCC_2],
+        size_t trackCount, bool accumulate)
+{
+#pragma push_macro("MIX_TRACKS")
+#undef MIX_TRACKS
+#define MIX_TRACKS(NTRACKS) \
+    if (volinc != nullptr) { \
+        accumulate \
+                ? volumeRampMultiTracksStereo<NTRACKS, true>(out, frameCount, in, vol, volinc) \
+                : volumeRampMultiTracksStereo<NTRACKS, false>(out, frameCount, in, vol, volinc); \
+    } else { \
+        accumulate ? volumeMultiTracksStereo<NTRACKS, true>(out, frameCount, in, vol) \
+                : volumeMultiTracksStereo<NTRACKS, false>(out, frameCount, in, vol); \
+    }
+
+    switch (trackCount) {
+    case 1:
+        MIX_TRACKS(1);
+        break;
+    case 2:
+        MIX_TRACKS(2);
+        break;
+    case 3:
+        MIX_TRACKS(3);
+        break;
+    case 4:
+        MIX_TRACKS(4);
+        break;
+    default:
+        LOG_ALWAYS_FATAL("%s: invalid track count %zu", __func__, trackCount);
+    }
+    static_assert(kMaxMultiTracksStereo == 4);
+#pragma pop_macro("MIX_TRACKS")
+}
+
+/* This process hook is called when all enabled tracks are float stereo, without
+ * resampling or aux, mixed to a stereo main buffer in float or 16 bit format.
+ *
+ * Instead of accumulating each track into a temporary buffer and converting afterwards,
+ * the tracks of a group are mixed kMaxMultiTracksStereo at a time, with volume ramp,
+ * directly into the float main buffer. For a 16 bit main buffer, the mix is done
+ * BLOCKSIZE frames at a time into a small stack buffer which is converted immediately,
+ * so the mixed data stays in cache.
+ *
+ * Processing proceeds in chunks bounded by the shortest track buffer available.
+ */
+void AudioMixerBase::process__noResampleMultiTrackStereo()
+{
+    ALOGVV("process__noResampleMultiTrackStereo\n");
+    float outTemp[BLOCKSIZE * FCC_2] __attribute__((aligned(32)));
+
+    for (const auto &pair : mGroups) {
+        const auto &group = pair.second;
+        const std::shared_ptr<TrackBase> &t1 = mTracks[group[0]];
+        const bool floatOut = t1->mMixerFormat == AUDIO_FORMAT_PCM_FLOAT;
+
+        // acquire buffer
+        for (const int name : group) {
+            const std::shared_ptr<TrackBase> &t = mTracks[name];
+            t->buffer.frameCount = mFrameCount;
+            t->bufferProvider->getNextBuffer(&t->buffer);
+            t->frameCount = t->buffer.frameCount;
+            t->mIn = t->buffer.raw;
+        }
+
+        uint8_t *out = static_cast<uint8_t *>(pair.first);
+        const size_t outFrameSize = audio_bytes_per_frame(FCC_2, t1->mMixerFormat);
+        size_t numFrames = 0;
+        while (numFrames < mFrameCount) {
+            size_t frameCount = mFrameCount - numFrames;
+            for (const int name : group) {
+                const std::shared_ptr<TrackBase> &t = mTracks[name];
+                // t->mIn == nullptr can happen if the track was flushed just after having
+                // been enabled for mixing.
+                if (t->mIn != nullptr && t->frameCount > 0) {
+                    frameCount = std::min(frameCount, (size_t)t->frameCount);
+                }
+            }
+            if (!floatOut) {
+                frameCount = std::min(frameCount, (size_t)BLOCKSIZE);
+            }
+            float *mixOut = floatOut ? reinterpret_cast<float *>(out) : outTemp;
+
+            const float *in[kMaxMultiTracksStereo];
+            TrackBase *tracks[kMaxMultiTracksStereo];
+            float vol[kMaxMultiTracksStereo][FCC_2];
+            float volinc[kMaxMultiTracksStereo][FCC_2];
+            size_t trackCount = 0;
+            bool ramp = false;
+            bool accumulate = false;
+            const auto mixBatch = [&]() {
+                mixMultiTracksStereo(mixOut, frameCount, in, vol, ramp ? volinc : nullptr,
+                        trackCount, accumulate);
+                if (ramp) {
+                    for (size_t i = 0; i < trackCount; ++i) {
+                        tracks[i]->mPrevVolume[0] = vol[i][0];
+                        tracks[i]->mPrevVolume[1] = vol[i][1];
+                    }
+                }
+                trackCount = 0;
+                ramp = false;
+                accumulate = true;
+            };
+            for (const int name : group) {
+                const std::shared_ptr<TrackBase> &t = mTracks[name];
+                if (t->mIn == nullptr || t->frameCount == 0 || (t->needs & NEEDS_MUTE)) {
+                    continue;
+                }
+                in[trackCount] = static_cast<const float *>(t->mIn);
+                tracks[trackCount] = t.get();
+                if (t->needsRamp()) {
+                    ramp = true;
+                    vol[trackCount][0] = t->mPrevVolume[0];
+                    vol[trackCount][1] = t->mPrevVolume[1];
+                    volinc[trackCount][0] = t->mVolumeInc[0];
+                    volinc[trackCount][1] = t->mVolumeInc[1];
+                } else {
+                    vol[trackCount][0] = t->mVolume[0];
+                    vol[trackCount][1] = t->mVolume[1];
+                    volinc[trackCount][0] = 0.f;
+                    volinc[trackCount][1] = 0.f;
+                }
+                if (++trackCount == kMaxMultiTracksStereo) {
+                    mixBatch();
+                }
+            }
+            if (trackCount > 0) {
+                mixBatch();
+            } else if (!accumulate) {
+                memset(mixOut, 0, frameCount * FCC_2 * sizeof(float));
+            }
+            if (!floatOut) {
+                convertMixerFormat(out, t1->mMixerFormat, outTemp, AUDIO_FORMAT_PCM_FLOAT,
+                        frameCount * FCC_2);
+            }
+            out += frameCount * outFrameSize;
+            numFrames += frameCount;
+
+            // advance the inputs, fetching the next buffer of exhausted tracks.
+            for (const int name : group) {
+                const std::shared_ptr<TrackBase> &t = mTracks[name];
+                if (t->mIn == nullptr || t->frameCount == 0) {
+                    continue;
+                }
+                t->mIn = static_cast<const float *>(t->mIn) + frameCount * FCC_2;
+                t->frameCount -= frameCount;
+                if (t->frameCount == 0 && numFrames < mFrameCount) {
+                    t->bufferProvider->releaseBuffer(&t->buffer);
+                    t->buffer.frameCount = mFrameCount - numFrames;
+                    t->bufferProvider->getNextBuffer(&t->buffer);
+                    t->mIn = t->buffer.raw;
+                    t->frameCount = t->buffer.frameCount;
+                }
+            }
+        }
+
+        // release each track's buffer and complete the volume ramps
+        for (const int name : group) {
+            const std::shared_ptr<TrackBase> &t = mTracks[name];
+            t->bufferProvider->releaseBuffer(&t->buffer);
+            if (t->needsRamp()) {
+                t->adjustVolumeRamp(false /* aux */, true /* useFloat */);
+            }
+        }
+    }
+}
+
 // one track, 16 bits stereo without resampling is the most common case
 void AudioMixerBase::process__oneTrack16BitsStereoNoResampling()
 {
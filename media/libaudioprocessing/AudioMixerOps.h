@@ -21,6 +21,23 @@
 #include <audio_utils/primitives.h>
 #include <system/audio.h>
 
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#define MIXER_USE_NEON (true)
+#include <arm_neon.h>
+#else
+#define MIXER_USE_NEON (false)
+#endif
+
+#if defined(__SSE__)  // Baseline for x86_64, supported in x86 ABI.
+#define MIXER_USE_SSE (true)
+#include <xmmintrin.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#else
+#define MIXER_USE_SSE (false)
+#endif
+
 namespace android {
 
 // Hack to make static_assert work in a constexpr
@@ -604,6 +621,260 @@ inline void volumeMulti(TO* out, size_t frameCount,
     }
 }
 
+/*
+ * volumeMultiTracksStereo mixes NTRACKS non-resampled stereo float tracks
+ * into a stereo float output in a single pass over the output buffer.
+ *
+ * This is equivalent to calling volumeMulti<MIXTYPE_MULTI_STEREOVOL, FCC_2>
+ * once per track without aux (MIXTYPE_MULTI_SAVEONLY_STEREOVOL for the first track
+ * if ACCUMULATE is false), but reads and writes the output only once for the batch.
+ *
+ *   NTRACKS:    number of input tracks, 1 to kMaxMultiTracksStereo.
+ *   ACCUMULATE: true to accumulate into out, false to overwrite out.
+ *   in:         array of NTRACKS interleaved stereo input pointers.
+ *   vol:        array of NTRACKS stereo (left, right) volumes.
+ *
+ * The NEON and SSE versions process 2 stereo frames per vector; the generic
+ * loop handles other architectures and the odd trailing frame.
+ */
+constexpr inline size_t kMaxMultiTracksStereo = 4;
+
+template <size_t NTRACKS, bool ACCUMULATE>
+inline void volumeMultiTracksStereo(float* out, size_t frameCount,
+        const float* const* in, const float (*vol)[FCC_2])
+{
+    static_assert(NTRACKS > 0 && NTRACKS <= kMaxMultiTracksStereo);
+    const float* inp[NTRACKS];
+    for (size_t t = 0; t < NTRACKS; ++t) {
+        inp[t] = in[t];
+    }
+#if MIXER_USE_NEON
+    float32x4_t volv[NTRACKS];
+    for (size_t t = 0; t < NTRACKS; ++t) {
+        const float32x2_t lr = vld1_f32(vol[t]);
+        volv[t] = vcombine_f32(lr, lr);
+    }
+    for (; frameCount >= 2; frameCount -= 2) {
+        float32x4_t accum = ACCUMULATE ? vld1q_f32(out) : vdupq_n_f32(0.f);
+        for (size_t t = 0; t < NTRACKS; ++t) {
+            accum = vmlaq_f32(accum, vld1q_f32(inp[t]), volv[t]);
+            inp[t] += 2 * FCC_2;
+        }
+        vst1q_f32(out, accum);
+        out += 2 * FCC_2;
+    }
+#elif MIXER_USE_SSE
+    __m128 volv[NTRACKS];
+    for (size_t t = 0; t < NTRACKS; ++t) {
+        volv[t] = _mm_setr_ps(vol[t][0], vol[t][1], vol[t][0], vol[t][1]);
+    }
+    for (; frameCount >= 2; frameCount -= 2) {
+        __m128 accum = ACCUMULATE ? _mm_loadu_ps(out) : _mm_setzero_ps();
+        for (size_t t = 0; t < NTRACKS; ++t) {
+            accum = _mm_add_ps(accum, _mm_mul_ps(_mm_loadu_ps(inp[t]), volv[t]));
+            inp[t] += 2 * FCC_2;
+        }
+        _mm_storeu_ps(out, accum);
+        out += 2 * FCC_2;
+    }
+#endif
+    for (; frameCount > 0; --frameCount) {
+        float left = ACCUMULATE ? out[0] : 0.f;
+        float right = ACCUMULATE ? out[1] : 0.f;
+        for (size_t t = 0; t < NTRACKS; ++t) {
+            left += inp[t][0] * vol[t][0];
+            right += inp[t][1] * vol[t][1];
+            inp[t] += FCC_2;
+        }
+        *out++ = left;
+        *out++ = right;
+    }
+}
+
+/*
+ * volumeRampMultiTracksStereo is the volume ramp version of volumeMultiTracksStereo,
+ * equivalent to volumeRampMulti<MIXTYPE_MULTI_STEREOVOL, FCC_2> once per track without aux.
+ *
+ *   vol:    array of NTRACKS stereo volumes, advanced by volinc every frame.
+ *           On return, vol contains the volume for the frame following the last one.
+ *   volinc: array of NTRACKS stereo volume increments per frame.
+ *
+ * The vector versions advance each lane by 2 * volinc, so the ramp may differ
+ * from the sequential sum by floating point rounding.
+ */
+template <size_t NTRACKS, bool ACCUMULATE>
+inline void volumeRampMultiTracksStereo(float* out, size_t frameCount,
+        const float* const* in, float (*vol)[FCC_2], const float (*volinc)[FCC_2])
+{
+    static_assert(NTRACKS > 0 && NTRACKS <= kMaxMultiTracksStereo);
+    const float* inp[NTRACKS];
+    for (size_t t = 0; t < NTRACKS; ++t) {
+        inp[t] = in[t];
+    }
+#if MIXER_USE_NEON
+    if (frameCount >= 2) {
+        float32x4_t volv[NTRACKS];
+        float32x4_t incv[NTRACKS];
+        for (size_t t = 0; t < NTRACKS; ++t) {
+            const float32x2_t lr = vld1_f32(vol[t]);
+            const float32x2_t inc = vld1_f32(volinc[t]);
+            volv[t] = vcombine_f32(lr, vadd_f32(lr, inc));
+            incv[t] = vcombine_f32(vadd_f32(inc, inc), vadd_f32(inc, inc));
+        }
+        for (; frameCount >= 2; frameCount -= 2) {
+            float32x4_t accum = ACCUMULATE ? vld1q_f32(out) : vdupq_n_f32(0.f);
+            for (size_t t = 0; t < NTRACKS; ++t) {
+                accum = vmlaq_f32(accum, vld1q_f32(inp[t]), volv[t]);
+                volv[t] = vaddq_f32(volv[t], incv[t]);
+                inp[t] += 2 * FCC_2;
+            }
+            vst1q_f32(out, accum);
+            out += 2 * FCC_2;
+        }
+        for (size_t t = 0; t < NTRACKS; ++t) {
+            vst1_f32(vol[t], vget_low_f32(volv[t]));
+        }
+    }
+#elif MIXER_USE_SSE
+    if (frameCount >= 2) {
+        __m128 volv[NTRACKS];
+        __m128 incv[NTRACKS];
+        for (size_t t = 0; t < NTRACKS; ++t) {
+            volv[t] = _mm_setr_ps(vol[t][0], vol[t][1],
+                    vol[t][0] + volinc[t][0], vol[t][1] + volinc[t][1]);
+            incv[t] = _mm_setr_ps(2.f * volinc[t][0], 2.f * volinc[t][1],
+                    2.f * volinc[t][0], 2.f * volinc[t][1]);
+        }
+        for (; frameCount >= 2; frameCount -= 2) {
+            __m128 accum = ACCUMULATE ? _mm_loadu_ps(out) : _mm_setzero_ps();
+            for (size_t t = 0; t < NTRACKS; ++t) {
+                accum = _mm_add_ps(accum, _mm_mul_ps(_mm_loadu_ps(inp[t]), volv[t]));
+                volv[t] = _mm_add_ps(volv[t], incv[t]);
+                inp[t] += 2 * FCC_2;
+            }
+            _mm_storeu_ps(out, accum);
+            out += 2 * FCC_2;
+        }
+        for (size_t t = 0; t < NTRACKS; ++t) {
+            _mm_storel_pi(reinterpret_cast<__m64*>(vol[t]), volv[t]);
+        }
+    }
+#endif
+    for (; frameCount > 0; --frameCount) {
+        float left = ACCUMULATE ? out[0] : 0.f;
+        float right = ACCUMULATE ? out[1] : 0.f;
+        for (size_t t = 0; t < NTRACKS; ++t) {
+            left += inp[t][0] * vol[t][0];
+            right += inp[t][1] * vol[t][1];
+            vol[t][0] += volinc[t][0];
+            vol[t][1] += volinc[t][1];
+            inp[t] += FCC_2;
+        }
+        *out++ = left;
+        *out++ = right;
+    }
+}
+
+
+/*
+ * finalizeStereo converts a stereo float mix to the sink format in a single pass,
+ * fusing the per-buffer passes of the playback thread after the mix and effects:
+ * mono blend, stereo balance gain (possibly ramped), and clamping or conversion.
+ *
+ *   TO:     float (clamped to [-absMax, absMax]) or int16_t (as clamp16_from_float).
+ *   MONO:   true to replace both channels by their average before the gain.
+ *   out:    interleaved stereo output, may be the same as in.
+ *   gain:   stereo (left, right) gain, advanced by gaininc every frame.
+ *           On return, gain contains the gain for the frame following the last one.
+ *   gaininc: stereo gain increments per frame, zero for a constant gain.
+ *
+ * The NEON version requires aarch64 for the rounding conversion and the fmin/fmax
+ * semantics of vminnmq/vmaxnmq; like volumeRampMultiTracksStereo, the vector ramp
+ * may differ from the sequential sum by floating point rounding.
+ */
+template <typename TO, bool MONO>
+inline void finalizeStereo(TO* out, const float* in, size_t frameCount,
+        float gain[FCC_2], const float gaininc[FCC_2], float absMax)
+{
+    static_assert(std::is_same_v<TO, float> || std::is_same_v<TO, int16_t>);
+#if MIXER_USE_NEON && defined(__aarch64__)
+    if (frameCount >= 2) {
+        const float32x2_t lr = vld1_f32(gain);
+        const float32x2_t inc = vld1_f32(gaininc);
+        float32x4_t gainv = vcombine_f32(lr, vadd_f32(lr, inc));
+        const float32x4_t incv = vcombine_f32(vadd_f32(inc, inc), vadd_f32(inc, inc));
+        const float32x4_t maxv = vdupq_n_f32(absMax);
+        const float32x4_t minv = vnegq_f32(maxv);
+        for (; frameCount >= 2; frameCount -= 2) {
+            float32x4_t v = vld1q_f32(in);
+            in += 2 * FCC_2;
+            if constexpr (MONO) {
+                v = vmulq_n_f32(vaddq_f32(v, vrev64q_f32(v)), 0.5f);
+            }
+            v = vmulq_f32(v, gainv);
+            gainv = vaddq_f32(gainv, incv);
+            if constexpr (std::is_same_v<TO, float>) {
+                vst1q_f32(out, vminnmq_f32(vmaxnmq_f32(v, minv), maxv));
+            } else {
+                // the conversion and the narrowing saturate.
+                vst1_s16(out, vqmovn_s32(vcvtnq_s32_f32(vmulq_n_f32(v, 32768.f))));
+            }
+            out += 2 * FCC_2;
+        }
+        vst1_f32(gain, vget_low_f32(gainv));
+    }
+#elif MIXER_USE_SSE && defined(__SSE2__)
+    if (frameCount >= 2) {
+        __m128 gainv = _mm_setr_ps(gain[0], gain[1],
+                gain[0] + gaininc[0], gain[1] + gaininc[1]);
+        const __m128 incv = _mm_setr_ps(2.f * gaininc[0], 2.f * gaininc[1],
+                2.f * gaininc[0], 2.f * gaininc[1]);
+        const __m128 maxv = std::is_same_v<TO, float> ? _mm_set1_ps(absMax) : _mm_set1_ps(1.f);
+        const __m128 minv = _mm_sub_ps(_mm_setzero_ps(), maxv);
+        for (; frameCount >= 2; frameCount -= 2) {
+            __m128 v = _mm_loadu_ps(in);
+            in += 2 * FCC_2;
+            if constexpr (MONO) {
+                v = _mm_mul_ps(_mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1))),
+                        _mm_set1_ps(0.5f));
+            }
+            v = _mm_mul_ps(v, gainv);
+            gainv = _mm_add_ps(gainv, incv);
+            // max then min with the constant as second operand returns the constant for NaN.
+            v = _mm_min_ps(_mm_max_ps(v, minv), maxv);
+            if constexpr (std::is_same_v<TO, float>) {
+                _mm_storeu_ps(out, v);
+            } else {
+                // clamped to [-1, 1] so the conversion does not overflow, 1.f saturates.
+                const __m128i i32 = _mm_cvtps_epi32(_mm_mul_ps(v, _mm_set1_ps(32768.f)));
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packs_epi32(i32, i32));
+            }
+            out += 2 * FCC_2;
+        }
+        _mm_storel_pi(reinterpret_cast<__m64*>(gain), gainv);
+    }
+#endif
+    for (; frameCount > 0; --frameCount) {
+        float left = in[0];
+        float right = in[1];
+        in += FCC_2;
+        if constexpr (MONO) {
+            left = right = (left + right) * 0.5f;
+        }
+        left *= gain[0];
+        right *= gain[1];
+        gain[0] += gaininc[0];
+        gain[1] += gaininc[1];
+        if constexpr (std::is_same_v<TO, float>) {
+            *out++ = fmin(fmax(left, -absMax), absMax);
+            *out++ = fmin(fmax(right, -absMax), absMax);
+        } else {
+            *out++ = clamp16_from_float(left);
+            *out++ = clamp16_from_float(right);
+        }
+    }
+}
+
 };
 
 #endif /* ANDROID_AUDIO_MIXER_OPS_H */
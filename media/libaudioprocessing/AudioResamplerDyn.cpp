@@ -23,6 +23,13 @@
 #include <dlfcn.h>
 #include <math.h>
 
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
 #include <cutils/compiler.h>
 #include <cutils/properties.h>
 #include <utils/Log.h>
@@ -163,6 +170,76 @@ void AudioResamplerDyn<TC, TI, TO>::InBuffer::reset()
     }
 }
 
+/*
+ * FilterCache shares the immutable polyphase filter banks between resampler instances
+ * of the same coefficient type, as many tracks use the same rate conversion.
+ *
+ * Filter banks are keyed by their design parameters and held weakly, so that they are
+ * freed when no longer in use, except for the kRetainedFilters most recently requested,
+ * which are held strongly so that short lived resamplers (e.g. for UI and notification
+ * sounds) start without designing the filter again.
+ */
+template<typename TC>
+class FilterCache {
+public:
+    // phases, halfLength, stopBandAtten, fcr
+    using Key = std::tuple<int, int, double, double>;
+
+    static FilterCache& getInstance() {
+        static FilterCache* const instance = new FilterCache(); // never deleted
+        return *instance;
+    }
+
+    // Returns the filter bank for key, calling generate() if it is not cached.
+    template<typename F>
+    std::shared_ptr<const TC> get(const Key& key, F&& generate) {
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            auto it = mFilters.find(key);
+            if (it != mFilters.end()) {
+                std::shared_ptr<const TC> filter = it->second.lock();
+                if (filter != nullptr) {
+                    retain_l(filter);
+                    return filter;
+                }
+            }
+        }
+        // design the filter outside of the lock, which may take several milliseconds.
+        std::shared_ptr<const TC> filter = generate();
+        std::lock_guard<std::mutex> lock(mLock);
+        auto& entry = mFilters[key];
+        std::shared_ptr<const TC> existing = entry.lock();
+        if (existing != nullptr) {
+            filter = std::move(existing); // someone else designed the same filter.
+        } else {
+            entry = filter;
+            // remove the entries of filters no longer in use.
+            for (auto it = mFilters.begin(); it != mFilters.end(); ) {
+                it = it->second.expired() ? mFilters.erase(it) : std::next(it);
+            }
+        }
+        retain_l(filter);
+        return filter;
+    }
+
+private:
+    static constexpr size_t kRetainedFilters = 4;
+
+    void retain_l(const std::shared_ptr<const TC>& filter) {
+        auto it = std::find(mRecent.begin(), mRecent.end(), filter);
+        if (it != mRecent.end()) {
+            mRecent.erase(it);
+        } else if (mRecent.size() >= kRetainedFilters) {
+            mRecent.pop_back();
+        }
+        mRecent.push_front(filter);
+    }
+
+    std::mutex mLock;
+    std::map<Key, std::weak_ptr<const TC>> mFilters;  // guarded by mLock
+    std::deque<std::shared_ptr<const TC>> mRecent;    // guarded by mLock, most recent first
+};
+
 template<typename TC, typename TI, typename TO>
 void AudioResamplerDyn<TC, TI, TO>::Constants::set(
         int L, int halfNumCoefs, int inSampleRate, int outSampleRate)
@@ -181,8 +258,7 @@ template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
         int inChannelCount, int32_t sampleRate, src_quality quality)
     : AudioResampler(inChannelCount, sampleRate, quality),
-      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY),
-    mCoefBuffer(NULL)
+      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY)
 {
     mVolumeSimd[0] = mVolumeSimd[1] = 0;
     // The AudioResampler base class assumes we are always ready for 1:1 resampling.
@@ -207,7 +283,6 @@ AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
 template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::~AudioResamplerDyn()
 {
-    free(mCoefBuffer);
 }
 
 template<typename TC, typename TI, typename TO>
@@ -263,24 +338,25 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
     const int phases = c.mL;
     const int halfLength = c.mHalfNumCoefs;
 
-    // create buffer
-    TC *coefs = nullptr;
-    int ret = posix_memalign(
-            reinterpret_cast<void **>(&coefs),
-            CACHE_LINE_SIZE /* alignment */,
-            (phases + 1) * halfLength * sizeof(TC));
-    LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
-    c.mFirCoefs = coefs;
-    free(mCoefBuffer);
-    mCoefBuffer = coefs;
-
     // square the computed minimum passband value (extra safety).
     double attenuation =
             computeWindowedSincMinimumPassbandValue(stopBandAtten);
     attenuation *= attenuation;
 
-    // design filter
-    firKaiserGen(coefs, phases, halfLength, stopBandAtten, fcr, attenuation);
+    // design filter, or reuse the identical filter bank of another resampler.
+    mCoefBuffer = FilterCache<TC>::getInstance().get(
+            {phases, halfLength, stopBandAtten, fcr}, [&]() {
+        // create buffer
+        TC *coefs = nullptr;
+        int ret = posix_memalign(
+                reinterpret_cast<void **>(&coefs),
+                CACHE_LINE_SIZE /* alignment */,
+                (phases + 1) * halfLength * sizeof(TC));
+        LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
+        firKaiserGen(coefs, phases, halfLength, stopBandAtten, fcr, attenuation);
+        return std::shared_ptr<const TC>(coefs, [](const TC *p) { free(const_cast<TC *>(p)); });
+    });
+    c.mFirCoefs = mCoefBuffer.get();
 
     // update the design criteria
     mNormalizedCutoffFrequency = fcr;
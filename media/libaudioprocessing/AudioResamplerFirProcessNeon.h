@@ -1207,6 +1207,235 @@ inline void Process<2, 16>(float* const out,
             lerpP, coefsP1, coefsN1);
 }
 
+//
+// Multichannel (e.g. 5.1, 7.1, 7.1.4) NEON kernels.
+//
+// Unlike the mono and stereo kernels above, which vectorize over 8 filter taps and
+// deinterleave the samples, these vectorize across the channels of a frame:
+// each filter tap is broadcast and multiplied with 4 channels at a time, so that the
+// interleaved frame is loaded directly. For an even CHANNELS which is not a multiple
+// of 4, the last channel pair occupies the low half of the last vector.
+//
+// The positive and negative halves of the filter use separate accumulators to
+// shorten the dependency chain; the integer variant is bit exact with ProcessBase().
+//
+
+template <int CHANNELS, int LANE>
+static inline void ProcessNeonMultiMac(float32x4_t* accum, const float* s, float32x2_t coefs)
+{
+    for (int j = 0; j < CHANNELS / 4; ++j) {
+        accum[j] = vmlaq_lane_f32(accum[j], vld1q_f32(s + 4 * j), coefs, LANE);
+    }
+    if (CHANNELS & 2) {
+        const float32x4_t samp = vcombine_f32(vld1_f32(s + (CHANNELS & ~3)), vdup_n_f32(0));
+        accum[CHANNELS / 4] = vmlaq_lane_f32(accum[CHANNELS / 4], samp, coefs, LANE);
+    }
+}
+
+template <int CHANNELS, int LANE>
+static inline void ProcessNeonMultiMac(int32x4_t* accum, const int16_t* s, int16x4_t coefs)
+{
+    for (int j = 0; j < CHANNELS / 4; ++j) {
+        accum[j] = vmlal_lane_s16(accum[j], vld1_s16(s + 4 * j), coefs, LANE);
+    }
+    if (CHANNELS & 2) {
+        // the frame is 32 bit aligned for an even number of 16 bit channels.
+        const int16x4_t samp = vreinterpret_s16_s32(
+                vld1_dup_s32(reinterpret_cast<const int32_t*>(s + (CHANNELS & ~3))));
+        accum[CHANNELS / 4] = vmlal_lane_s16(accum[CHANNELS / 4], samp, coefs, LANE);
+    }
+}
+
+template <int CHANNELS, bool FIXED>
+static inline void ProcessNeonIntrinsicMulti(float* out,
+        int count,
+        const float* coefsP,
+        const float* coefsN,
+        const float* sP,
+        const float* sN,
+        const float* volumeLR,
+        float lerpP,
+        const float* coefsP1,
+        const float* coefsN1)
+{
+    ALOG_ASSERT(count > 0 && (count & 3) == 0); // multiple of 4
+    static_assert(CHANNELS > 2 && (CHANNELS & 1) == 0, "CHANNELS must be even and > 2");
+    constexpr int VECTORS = (CHANNELS + 3) / 4;
+
+    coefsP = (const float*)__builtin_assume_aligned(coefsP, 16);
+    coefsN = (const float*)__builtin_assume_aligned(coefsN, 16);
+    if (!FIXED) {
+        coefsP1 = (const float*)__builtin_assume_aligned(coefsP1, 16);
+        coefsN1 = (const float*)__builtin_assume_aligned(coefsN1, 16);
+    }
+    float32x4_t accumP[VECTORS];
+    float32x4_t accumN[VECTORS];
+    for (int j = 0; j < VECTORS; ++j) {
+        accumP[j] = vdupq_n_f32(0);
+        accumN[j] = vdupq_n_f32(0);
+    }
+    do {
+        float32x4_t posCoef = vld1q_f32(coefsP);
+        coefsP += 4;
+        float32x4_t negCoef = vld1q_f32(coefsN);
+        coefsN += 4;
+        if (!FIXED) { // interpolate
+            const float32x4_t posCoef1 = vld1q_f32(coefsP1);
+            coefsP1 += 4;
+            const float32x4_t negCoef1 = vld1q_f32(coefsN1);
+            coefsN1 += 4;
+            posCoef = vmlaq_n_f32(posCoef, vsubq_f32(posCoef1, posCoef), lerpP);
+            negCoef = vmlaq_n_f32(negCoef1, vsubq_f32(negCoef, negCoef1), lerpP); // rev
+        }
+        const float32x2_t posLo = vget_low_f32(posCoef);
+        const float32x2_t posHi = vget_high_f32(posCoef);
+        const float32x2_t negLo = vget_low_f32(negCoef);
+        const float32x2_t negHi = vget_high_f32(negCoef);
+
+        ProcessNeonMultiMac<CHANNELS, 0>(accumP, sP, posLo);
+        ProcessNeonMultiMac<CHANNELS, 0>(accumN, sN, negLo);
+        ProcessNeonMultiMac<CHANNELS, 1>(accumP, sP - CHANNELS, posLo);
+        ProcessNeonMultiMac<CHANNELS, 1>(accumN, sN + CHANNELS, negLo);
+        ProcessNeonMultiMac<CHANNELS, 0>(accumP, sP - 2 * CHANNELS, posHi);
+        ProcessNeonMultiMac<CHANNELS, 0>(accumN, sN + 2 * CHANNELS, negHi);
+        ProcessNeonMultiMac<CHANNELS, 1>(accumP, sP - 3 * CHANNELS, posHi);
+        ProcessNeonMultiMac<CHANNELS, 1>(accumN, sN + 3 * CHANNELS, negHi);
+        sP -= 4 * CHANNELS;
+        sN += 4 * CHANNELS;
+    } while (count -= 4);
+
+    // multiply by volume and save, all channels use the left volume as in ProcessBase().
+    const float volume = volumeLR[0];
+    for (int j = 0; j < CHANNELS / 4; ++j) {
+        const float32x4_t accum = vaddq_f32(accumP[j], accumN[j]);
+        vst1q_f32(out + 4 * j, vmlaq_n_f32(vld1q_f32(out + 4 * j), accum, volume));
+    }
+    if (CHANNELS & 2) {
+        float* const outPair = out + (CHANNELS & ~3);
+        const float32x2_t accum = vadd_f32(
+                vget_low_f32(accumP[CHANNELS / 4]), vget_low_f32(accumN[CHANNELS / 4]));
+        vst1_f32(outPair, vmla_n_f32(vld1_f32(outPair), accum, volume));
+    }
+}
+
+template <int CHANNELS, bool FIXED>
+static inline void ProcessNeonIntrinsicMulti(int32_t* out,
+        int count,
+        const int16_t* coefsP,
+        const int16_t* coefsN,
+        const int16_t* sP,
+        const int16_t* sN,
+        const int32_t* volumeLR,
+        uint32_t lerpP,
+        const int16_t* coefsP1,
+        const int16_t* coefsN1)
+{
+    ALOG_ASSERT(count > 0 && (count & 3) == 0); // multiple of 4
+    static_assert(CHANNELS > 2 && (CHANNELS & 1) == 0, "CHANNELS must be even and > 2");
+    constexpr int VECTORS = (CHANNELS + 3) / 4;
+
+    coefsP = (const int16_t*)__builtin_assume_aligned(coefsP, 16);
+    coefsN = (const int16_t*)__builtin_assume_aligned(coefsN, 16);
+    int16x4_t interp;
+    if (!FIXED) {
+        interp = vdup_n_s16(static_cast<int16_t>(lerpP));
+        coefsP1 = (const int16_t*)__builtin_assume_aligned(coefsP1, 16);
+        coefsN1 = (const int16_t*)__builtin_assume_aligned(coefsN1, 16);
+    }
+    int32x4_t accumP[VECTORS];
+    int32x4_t accumN[VECTORS];
+    for (int j = 0; j < VECTORS; ++j) {
+        accumP[j] = vdupq_n_s32(0);
+        accumN[j] = vdupq_n_s32(0);
+    }
+    do {
+        int16x4_t posCoef = vld1_s16(coefsP);
+        coefsP += 4;
+        int16x4_t negCoef = vld1_s16(coefsN);
+        coefsN += 4;
+        if (!FIXED) { // interpolate, truncating as interpolate<int16_t, uint32_t>()
+            const int16x4_t posCoef1 = vld1_s16(coefsP1);
+            coefsP1 += 4;
+            const int16x4_t negCoef1 = vld1_s16(coefsN1);
+            coefsN1 += 4;
+            posCoef = vadd_s16(vshrn_n_s32(
+                    vmull_s16(interp, vsub_s16(posCoef1, posCoef)), 15), posCoef);
+            negCoef = vadd_s16(vshrn_n_s32(
+                    vmull_s16(interp, vsub_s16(negCoef, negCoef1)), 15), negCoef1); // rev
+        }
+        ProcessNeonMultiMac<CHANNELS, 0>(accumP, sP, posCoef);
+        ProcessNeonMultiMac<CHANNELS, 0>(accumN, sN, negCoef);
+        ProcessNeonMultiMac<CHANNELS, 1>(accumP, sP - CHANNELS, posCoef);
+        ProcessNeonMultiMac<CHANNELS, 1>(accumN, sN + CHANNELS, negCoef);
+        ProcessNeonMultiMac<CHANNELS, 2>(accumP, sP - 2 * CHANNELS, posCoef);
+        ProcessNeonMultiMac<CHANNELS, 2>(accumN, sN + 2 * CHANNELS, negCoef);
+        ProcessNeonMultiMac<CHANNELS, 3>(accumP, sP - 3 * CHANNELS, posCoef);
+        ProcessNeonMultiMac<CHANNELS, 3>(accumN, sN + 3 * CHANNELS, negCoef);
+        sP -= 4 * CHANNELS;
+        sN += 4 * CHANNELS;
+    } while (count -= 4);
+
+    // multiply by volume and save, matching volumeAdjust() (only the top 16b of the
+    // left volume are used).
+    const int32x2_t volume = vdup_n_s32(static_cast<int16_t>(volumeLR[0] >> 16));
+    for (int j = 0; j < CHANNELS / 4; ++j) {
+        const int32x4_t accum = vaddq_s32(accumP[j], accumN[j]);
+        const int32x4_t adjusted = vcombine_s32(
+                vshrn_n_s64(vmull_s32(vget_low_s32(accum), volume), 16),
+                vshrn_n_s64(vmull_s32(vget_high_s32(accum), volume), 16));
+        vst1q_s32(out + 4 * j, vaddq_s32(vld1q_s32(out + 4 * j), vshlq_n_s32(adjusted, 1)));
+    }
+    if (CHANNELS & 2) {
+        int32_t* const outPair = out + (CHANNELS & ~3);
+        const int32x2_t accum = vadd_s32(
+                vget_low_s32(accumP[CHANNELS / 4]), vget_low_s32(accumN[CHANNELS / 4]));
+        const int32x2_t adjusted = vshrn_n_s64(vmull_s32(accum, volume), 16);
+        vst1_s32(outPair, vadd_s32(vld1_s32(outPair), vshl_n_s32(adjusted, 1)));
+    }
+}
+
+// Specializations of ProcessL() and Process() for the common multichannel layouts,
+// other channel counts use the generic ProcessBase().
+#define DEFINE_PROCESS_NEON_MULTI(CHANNELS, TC, TI, TO, TINTERP) \
+template<> \
+inline void ProcessL<CHANNELS, 16>(TO* const out, \
+        int count, \
+        const TC* coefsP, \
+        const TC* coefsN, \
+        const TI* sP, \
+        const TI* sN, \
+        const TO* const volumeLR) \
+{ \
+    ProcessNeonIntrinsicMulti<CHANNELS, true>(out, count, coefsP, coefsN, sP, sN, volumeLR, \
+            0 /*lerpP*/, NULL /*coefsP1*/, NULL /*coefsN1*/); \
+} \
+\
+template<> \
+inline void Process<CHANNELS, 16>(TO* const out, \
+        int count, \
+        const TC* coefsP, \
+        const TC* coefsN, \
+        const TC* coefsP1, \
+        const TC* coefsN1, \
+        const TI* sP, \
+        const TI* sN, \
+        TINTERP lerpP, \
+        const TO* const volumeLR) \
+{ \
+    ProcessNeonIntrinsicMulti<CHANNELS, false>(out, count, coefsP, coefsN, sP, sN, volumeLR, \
+            lerpP, coefsP1, coefsN1); \
+}
+
+DEFINE_PROCESS_NEON_MULTI(4, float, float, float, float)
+DEFINE_PROCESS_NEON_MULTI(6, float, float, float, float)
+DEFINE_PROCESS_NEON_MULTI(8, float, float, float, float)
+DEFINE_PROCESS_NEON_MULTI(12, float, float, float, float)
+DEFINE_PROCESS_NEON_MULTI(4, int16_t, int16_t, int32_t, uint32_t)
+DEFINE_PROCESS_NEON_MULTI(6, int16_t, int16_t, int32_t, uint32_t)
+DEFINE_PROCESS_NEON_MULTI(8, int16_t, int16_t, int32_t, uint32_t)
+DEFINE_PROCESS_NEON_MULTI(12, int16_t, int16_t, int32_t, uint32_t)
+#undef DEFINE_PROCESS_NEON_MULTI
+
 #endif //USE_NEON
 
 } // namespace android
@@ -56,6 +56,7 @@ RecordBufferConverter::RecordBufferConverter(
             mIsLegacyDownmix(false),
             mIsLegacyUpmix(false),
             mRequiresFloat(false),
+            mNeedsReset(false),
             mInputConverterProvider(NULL)
 {
     (void)updateParameters(srcChannelMask, srcFormat, srcSampleRate,
@@ -77,6 +78,10 @@ void RecordBufferConverter::reset() {
 size_t RecordBufferConverter::convert(void *dst,
         AudioBufferProvider *provider, size_t frames)
 {
+    if (mNeedsReset) {
+        reset();
+        mNeedsReset = false;
+    }
     if (mInputConverterProvider != NULL) {
         mInputConverterProvider->setBufferProvider(provider);
         provider = mInputConverterProvider;
@@ -201,6 +201,15 @@ public:
     // process hook functionality
     using process_hook_t = void(AudioMixerBase::*)();
 
+    // Converts frameCount frames of the stereo float mix in to outFormat in a single pass:
+    // optional mono blend (average of the channels), stereo gain (e.g. balance) advanced
+    // by gainInc every frame, then clamping to [-absMax, absMax] for AUDIO_FORMAT_PCM_FLOAT
+    // or conversion to AUDIO_FORMAT_PCM_16_BIT.  On return, gain is the gain of the next frame.
+    // out may be the same as in.  Returns false, without processing, for other formats.
+    static bool finalizeStereo(void* out, audio_format_t outFormat, const float* in,
+            size_t frameCount, bool mono, float gain[FCC_2], const float gainInc[FCC_2],
+            float absMax);
+
     static bool isAudioChannelPositionMask(audio_channel_mask_t channelMask) {
         return audio_channel_mask_get_representation(channelMask)
                 == AUDIO_CHANNEL_REPRESENTATION_POSITION;
@@ -233,6 +242,15 @@ public:
         bool        useStereoVolume() const { return channelMask == AUDIO_CHANNEL_OUT_STEREO
                                         && isAudioChannelPositionMask(mMixerChannelMask); }
 
+        // true if the track can be mixed by process__noResampleMultiTrackStereo().
+        bool        isMultiTrackStereoFloat() {
+                        return mMixerInFormat == AUDIO_FORMAT_PCM_FLOAT
+                                && (mMixerFormat == AUDIO_FORMAT_PCM_FLOAT
+                                        || mMixerFormat == AUDIO_FORMAT_PCM_16_BIT)
+                                && mMixerChannelCount == FCC_2
+                                && getMixerChannelCount() == FCC_2
+                                && useStereoVolume(); }
+
         static hook_t getTrackHook(int trackType, uint32_t channelCount,
                 audio_format_t mixerInFormat, audio_format_t mixerOutFormat);
 
@@ -351,6 +369,7 @@ public:
     void process__genericNoResampling();
     void process__genericResampling();
     void process__oneTrack16BitsStereoNoResampling();
+    void process__noResampleMultiTrackStereo();
 
     template <int MIXTYPE, typename TO, typename TI, typename TA>
     void process__noResampleOneTrack();
@@ -78,6 +78,22 @@ public:
     // called to reset resampler buffers on record track discontinuity
     void reset();
 
+    // returns true if other converts the same source to the same destination,
+    // so that for the same input both produce the same output.
+    bool hasSameConversion(const RecordBufferConverter& other) const {
+        return mSrcChannelMask == other.mSrcChannelMask
+                && mSrcFormat == other.mSrcFormat
+                && mSrcSampleRate == other.mSrcSampleRate
+                && mDstChannelMask == other.mDstChannelMask
+                && mDstFormat == other.mDstFormat
+                && mDstSampleRate == other.mDstSampleRate;
+    }
+
+    // called when the output of another converter with the same conversion was used
+    // for the input instead of calling convert(). The resampler history no longer matches
+    // the input, so it is reset by the next convert().
+    void bypass() { mNeedsReset = true; }
+
 private:
     // format conversion when not using resampler
     void convertNoResampler(void *dst, const void *src, size_t frames);
@@ -109,6 +125,7 @@ private:
     bool                 mIsLegacyDownmix;  // legacy stereo to mono conversion needed
     bool                 mIsLegacyUpmix;    // legacy mono to stereo conversion needed
     bool                 mRequiresFloat;    // data processing requires float (e.g. resampler)
+    bool                 mNeedsReset;       // set by bypass()
     PassthruBufferProvider *mInputConverterProvider;    // converts input to float
     int8_t               mIdxAry[sizeof(uint32_t) * 8]; // used for channel mask conversion
 };
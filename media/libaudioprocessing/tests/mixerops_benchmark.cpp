@@ -72,6 +72,105 @@ static void BM_VolumeMulti(benchmark::State& state) {
     }
 }
 
+// Mixes NTRACKS stereo tracks one at a time with the generic templates,
+// as done by AudioMixerBase::process__genericNoResampling().
+template <int NTRACKS>
+static void BM_VolumeMultiPerTrack(benchmark::State& state) {
+    constexpr size_t FRAME_COUNT = 1000;
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * FCC_2;
+
+    float out[SAMPLE_COUNT]{};
+    float in[NTRACKS][SAMPLE_COUNT]{};
+    float vol[NTRACKS][2]{};
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(out);
+        benchmark::DoNotOptimize(in);
+        volumeMulti<MIXTYPE_MULTI_SAVEONLY_STEREOVOL, FCC_2>(
+                out, FRAME_COUNT, in[0], (float *)nullptr, vol[0], 0.f);
+        for (int i = 1; i < NTRACKS; ++i) {
+            volumeMulti<MIXTYPE_MULTI_STEREOVOL, FCC_2>(
+                    out, FRAME_COUNT, in[i], (float *)nullptr, vol[i], 0.f);
+        }
+        benchmark::ClobberMemory();
+    }
+}
+
+// Mixes NTRACKS stereo tracks in batches of kMaxMultiTracksStereo,
+// as done by AudioMixerBase::process__noResampleMultiTrackStereo().
+template <int NTRACKS>
+static void BM_VolumeMultiTracksStereo(benchmark::State& state) {
+    constexpr size_t FRAME_COUNT = 1000;
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * FCC_2;
+
+    float out[SAMPLE_COUNT]{};
+    float in[NTRACKS][SAMPLE_COUNT]{};
+    float vol[NTRACKS][2]{};
+    const float *inp[NTRACKS];
+    for (int i = 0; i < NTRACKS; ++i) {
+        inp[i] = in[i];
+    }
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(out);
+        benchmark::DoNotOptimize(in);
+        int i = 0;
+        for (; i + 4 <= NTRACKS; i += 4) {
+            i == 0 ? volumeMultiTracksStereo<4, false>(out, FRAME_COUNT, inp + i, vol + i)
+                    : volumeMultiTracksStereo<4, true>(out, FRAME_COUNT, inp + i, vol + i);
+        }
+        for (; i < NTRACKS; ++i) {
+            i == 0 ? volumeMultiTracksStereo<1, false>(out, FRAME_COUNT, inp + i, vol + i)
+                    : volumeMultiTracksStereo<1, true>(out, FRAME_COUNT, inp + i, vol + i);
+        }
+        benchmark::ClobberMemory();
+    }
+}
+
+// Converts a stereo float mix to the sink format with the separate passes of
+// PlaybackThread (mono blend, balance, clamp or conversion) if FUSED is false,
+// or with finalizeStereo() in a single pass.
+template <typename TO, bool FUSED>
+static void BM_FinalizeStereo(benchmark::State& state) {
+    constexpr size_t FRAME_COUNT = 1000;
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * FCC_2;
+    constexpr float kAbsMax = 2.f;
+
+    TO out[SAMPLE_COUNT]{};
+    float in[SAMPLE_COUNT]{};
+    float temp[SAMPLE_COUNT]{};
+    const float gaininc[FCC_2] = { -0.5f / FRAME_COUNT, 0.f };
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(out);
+        benchmark::DoNotOptimize(in);
+        float gain[FCC_2] = { 1.f, 1.f };
+        if constexpr (FUSED) {
+            finalizeStereo<TO, true /* MONO */>(out, in, FRAME_COUNT, gain, gaininc, kAbsMax);
+        } else {
+            for (size_t i = 0; i < SAMPLE_COUNT; i += FCC_2) {
+                temp[i] = temp[i + 1] = (in[i] + in[i + 1]) * 0.5f;
+            }
+            benchmark::ClobberMemory();
+            for (size_t i = 0; i < SAMPLE_COUNT; i += FCC_2) {
+                temp[i] *= gain[0];
+                temp[i + 1] *= gain[1];
+                gain[0] += gaininc[0];
+                gain[1] += gaininc[1];
+            }
+            benchmark::ClobberMemory();
+            for (size_t i = 0; i < SAMPLE_COUNT; ++i) {
+                if constexpr (std::is_same_v<TO, float>) {
+                    out[i] = fmin(fmax(temp[i], -kAbsMax), kAbsMax);
+                } else {
+                    out[i] = clamp16_from_float(temp[i]);
+                }
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+}
+
 // MULTI mode and MULTI_SAVEONLY mode are not used by AudioMixer for channels > 2,
 // which is ensured by a static_assert (won't compile for those configurations).
 // So we benchmark MIXTYPE_MULTI_MONOVOL and MIXTYPE_MULTI_SAVEONLY_MONOVOL compared
@@ -101,4 +200,19 @@ BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_MONOVOL, 8);
 BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_STEREOVOL, 8);
 BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 8);
 
+BENCHMARK_TEMPLATE(BM_VolumeMultiPerTrack, 1);
+BENCHMARK_TEMPLATE(BM_VolumeMultiPerTrack, 4);
+BENCHMARK_TEMPLATE(BM_VolumeMultiPerTrack, 8);
+BENCHMARK_TEMPLATE(BM_VolumeMultiPerTrack, 20);
+
+BENCHMARK_TEMPLATE(BM_VolumeMultiTracksStereo, 1);
+BENCHMARK_TEMPLATE(BM_VolumeMultiTracksStereo, 4);
+BENCHMARK_TEMPLATE(BM_VolumeMultiTracksStereo, 8);
+BENCHMARK_TEMPLATE(BM_VolumeMultiTracksStereo, 20);
+
+BENCHMARK_TEMPLATE(BM_FinalizeStereo, float, false /* FUSED */);
+BENCHMARK_TEMPLATE(BM_FinalizeStereo, float, true /* FUSED */);
+BENCHMARK_TEMPLATE(BM_FinalizeStereo, int16_t, false /* FUSED */);
+BENCHMARK_TEMPLATE(BM_FinalizeStereo, int16_t, true /* FUSED */);
+
 BENCHMARK_MAIN();
@@ -18,6 +18,7 @@
 #define LOG_TAG "mixerop_tests"
 #include <log/log.h>
 
+#include <algorithm>
 #include <inttypes.h>
 #include <type_traits>
 
@@ -173,3 +174,187 @@ TEST(mixerops, channel_equivalence) {
         EXPECT_EQ(system, actual);
     }
 }
+
+template <size_t NTRACKS>
+static void testMultiTracksStereo() {
+    constexpr size_t FRAME_COUNT = 1001; // odd, to test the trailing frame.
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * FCC_2;
+
+    float in[NTRACKS][SAMPLE_COUNT];
+    float vol[NTRACKS][FCC_2];
+    const float *inp[NTRACKS];
+    for (size_t t = 0; t < NTRACKS; ++t) {
+        for (size_t i = 0; i < SAMPLE_COUNT; ++i) {
+            in[t][i] = (float)((i * (t + 3)) % 17) / 16.f - 0.5f;
+        }
+        vol[t][0] = 0.125f * (t + 1);
+        vol[t][1] = 1.f - 0.25f * t;
+        inp[t] = in[t];
+    }
+
+    // reference: each track mixed separately with the generic template.
+    float expected[SAMPLE_COUNT]{};
+    for (size_t t = 0; t < NTRACKS; ++t) {
+        volumeMulti<MIXTYPE_MULTI_STEREOVOL, FCC_2>(
+                expected, FRAME_COUNT, in[t], (float *)nullptr, vol[t], 0.f);
+    }
+
+    float out[SAMPLE_COUNT];
+    std::fill(std::begin(out), std::end(out), 100.f); // must be overwritten.
+    volumeMultiTracksStereo<NTRACKS, false /* ACCUMULATE */>(out, FRAME_COUNT, inp, vol);
+    for (size_t i = 0; i < SAMPLE_COUNT; ++i) {
+        EXPECT_FLOAT_EQ(expected[i], out[i]) << "sample " << i;
+    }
+
+    // accumulate once more, doubling the output.
+    volumeMultiTracksStereo<NTRACKS, true /* ACCUMULATE */>(out, FRAME_COUNT, inp, vol);
+    for (size_t i = 0; i < SAMPLE_COUNT; ++i) {
+        EXPECT_FLOAT_EQ(expected[i] * 2.f, out[i]) << "sample " << i;
+    }
+}
+
+TEST(mixerops, multitracksstereo_1) {
+    testMultiTracksStereo<1>();
+}
+TEST(mixerops, multitracksstereo_2) {
+    testMultiTracksStereo<2>();
+}
+TEST(mixerops, multitracksstereo_3) {
+    testMultiTracksStereo<3>();
+}
+TEST(mixerops, multitracksstereo_4) {
+    testMultiTracksStereo<kMaxMultiTracksStereo>();
+}
+
+template <size_t NTRACKS>
+static void testRampMultiTracksStereo() {
+    constexpr size_t FRAME_COUNT = 1001; // odd, to test the trailing frame.
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * FCC_2;
+
+    float in[NTRACKS][SAMPLE_COUNT];
+    float volinc[NTRACKS][FCC_2];
+    const float *inp[NTRACKS];
+    for (size_t t = 0; t < NTRACKS; ++t) {
+        for (size_t i = 0; i < SAMPLE_COUNT; ++i) {
+            in[t][i] = (float)((i * (t + 5)) % 13) / 12.f - 0.5f;
+        }
+        volinc[t][0] = 1.f / FRAME_COUNT;      // ramp up
+        volinc[t][1] = -0.5f / FRAME_COUNT;    // ramp down
+        inp[t] = in[t];
+    }
+
+    // reference: each track ramped separately with the generic template.
+    float expected[SAMPLE_COUNT]{};
+    float expectedVol[NTRACKS][FCC_2];
+    for (size_t t = 0; t < NTRACKS; ++t) {
+        expectedVol[t][0] = 0.f;
+        expectedVol[t][1] = 1.f;
+        float vola = 0.f;
+        volumeRampMulti<MIXTYPE_MULTI_STEREOVOL, FCC_2>(expected, FRAME_COUNT, in[t],
+                (float *)nullptr, expectedVol[t], volinc[t], &vola, 0.f);
+    }
+
+    float vol[NTRACKS][FCC_2];
+    for (size_t t = 0; t < NTRACKS; ++t) {
+        vol[t][0] = 0.f;
+        vol[t][1] = 1.f;
+    }
+    float out[SAMPLE_COUNT];
+    volumeRampMultiTracksStereo<NTRACKS, false /* ACCUMULATE */>(
+            out, FRAME_COUNT, inp, vol, volinc);
+    // the vector versions may round the ramp differently.
+    constexpr float kTolerance = 1e-5f;
+    for (size_t i = 0; i < SAMPLE_COUNT; ++i) {
+        EXPECT_NEAR(expected[i], out[i], kTolerance) << "sample " << i;
+    }
+    for (size_t t = 0; t < NTRACKS; ++t) {
+        EXPECT_NEAR(expectedVol[t][0], vol[t][0], kTolerance);
+        EXPECT_NEAR(expectedVol[t][1], vol[t][1], kTolerance);
+    }
+}
+
+TEST(mixerops, rampmultitracksstereo_1) {
+    testRampMultiTracksStereo<1>();
+}
+TEST(mixerops, rampmultitracksstereo_2) {
+    testRampMultiTracksStereo<2>();
+}
+TEST(mixerops, rampmultitracksstereo_4) {
+    testRampMultiTracksStereo<kMaxMultiTracksStereo>();
+}
+
+// reference: the separate passes of the playback thread, mono blend, balance, conversion.
+template <typename TO>
+static void finalizeStereoReference(TO* out, const float* in, size_t frameCount, bool mono,
+        float gain[FCC_2], const float gaininc[FCC_2], float absMax) {
+    for (size_t i = 0; i < frameCount; ++i) {
+        float left = in[2 * i];
+        float right = in[2 * i + 1];
+        if (mono) {
+            left = right = (left + right) * 0.5f;
+        }
+        left *= gain[0];
+        right *= gain[1];
+        gain[0] += gaininc[0];
+        gain[1] += gaininc[1];
+        if constexpr (std::is_same_v<TO, float>) {
+            out[2 * i] = std::clamp(left, -absMax, absMax);
+            out[2 * i + 1] = std::clamp(right, -absMax, absMax);
+        } else {
+            out[2 * i] = clamp16_from_float(left);
+            out[2 * i + 1] = clamp16_from_float(right);
+        }
+    }
+}
+
+template <typename TO, bool MONO>
+static void testFinalizeStereo(bool ramp) {
+    constexpr size_t FRAME_COUNT = 1001; // odd, to test the trailing frame.
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * FCC_2;
+    constexpr float kAbsMax = 2.f;
+
+    // includes values beyond the int16 range and the float limit.
+    float in[SAMPLE_COUNT];
+    for (size_t i = 0; i < SAMPLE_COUNT; ++i) {
+        in[i] = (float)((i * 7) % 29) / 7.f - 2.f;
+    }
+    const float initialGain[FCC_2] = {1.f, 0.75f};
+    const float gaininc[FCC_2] = {
+        ramp ? -0.5f / FRAME_COUNT : 0.f, ramp ? 0.25f / FRAME_COUNT : 0.f};
+
+    TO expected[SAMPLE_COUNT];
+    float expectedGain[FCC_2] = {initialGain[0], initialGain[1]};
+    finalizeStereoReference(expected, in, FRAME_COUNT, MONO, expectedGain, gaininc, kAbsMax);
+
+    float gain[FCC_2] = {initialGain[0], initialGain[1]};
+    TO out[SAMPLE_COUNT];
+    finalizeStereo<TO, MONO>(out, in, FRAME_COUNT, gain, gaininc, kAbsMax);
+    // the vector versions may round the ramp differently.
+    constexpr float kTolerance = 1e-5f;
+    for (size_t i = 0; i < SAMPLE_COUNT; ++i) {
+        if constexpr (std::is_same_v<TO, float>) {
+            EXPECT_NEAR(expected[i], out[i], kTolerance) << "sample " << i;
+        } else {
+            EXPECT_NEAR(expected[i], out[i], ramp ? 1 : 0) << "sample " << i;
+        }
+    }
+    EXPECT_NEAR(expectedGain[0], gain[0], kTolerance);
+    EXPECT_NEAR(expectedGain[1], gain[1], kTolerance);
+}
+
+TEST(mixerops, finalizestereo_float) {
+    testFinalizeStereo<float, false /* MONO */>(false /* ramp */);
+    testFinalizeStereo<float, false /* MONO */>(true /* ramp */);
+}
+TEST(mixerops, finalizestereo_float_mono) {
+    testFinalizeStereo<float, true /* MONO */>(false /* ramp */);
+    testFinalizeStereo<float, true /* MONO */>(true /* ramp */);
+}
+TEST(mixerops, finalizestereo_i16) {
+    testFinalizeStereo<int16_t, false /* MONO */>(false /* ramp */);
+    testFinalizeStereo<int16_t, false /* MONO */>(true /* ramp */);
+}
+TEST(mixerops, finalizestereo_i16_mono) {
+    testFinalizeStereo<int16_t, true /* MONO */>(false /* ramp */);
+    testFinalizeStereo<int16_t, true /* MONO */>(true /* ramp */);
+}
@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "resampler_benchmark"
+
+#include <math.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/AudioResampler.h>
+#include <utils/Timers.h>
+
+#include "test_utils.h"
+
+/*
+ * Sweeps AudioResampler quality x channel count x rate pair x sample format.
+ *
+ * Each benchmark reports the throughput in output frames per second, and the
+ * SINAD (signal to noise and distortion) and THD of a resampled 1 kHz sine,
+ * in dB relative to the sine.
+ *
+ * After all benchmarks are run, a table lists the qualities of each configuration
+ * with the Pareto optimal ones (no other quality is both faster and cleaner) marked,
+ * to help choose the DYN_*_QUALITY defaults of a device.
+ */
+
+using android::AudioResampler;
+
+namespace {
+
+constexpr double kSineFrequency = 1000.;  // Hz
+constexpr size_t kFramesPerIteration = 1024;
+constexpr size_t kHarmonics = 5;          // harmonics used for THD, including the fundamental
+
+const AudioResampler::src_quality kQualities[] = {
+    AudioResampler::LOW_QUALITY,
+    AudioResampler::MED_QUALITY,
+    AudioResampler::HIGH_QUALITY,
+    AudioResampler::VERY_HIGH_QUALITY,
+    AudioResampler::DYN_LOW_QUALITY,
+    AudioResampler::DYN_MED_QUALITY,
+    AudioResampler::DYN_HIGH_QUALITY,
+};
+
+const int kChannels[] = { 1, 2, 6, 8 };
+
+const std::pair<int, int> kRatePairs[] = {  // input, output
+    { 44100, 48000 },
+    { 48000, 44100 },
+    { 16000, 48000 },
+    { 48000, 16000 },
+    { 96000, 48000 },
+};
+
+const char* qualityToString(AudioResampler::src_quality quality) {
+    switch (quality) {
+    case AudioResampler::LOW_QUALITY: return "LOW";
+    case AudioResampler::MED_QUALITY: return "MED";
+    case AudioResampler::HIGH_QUALITY: return "HIGH";
+    case AudioResampler::VERY_HIGH_QUALITY: return "VERY_HIGH";
+    case AudioResampler::DYN_LOW_QUALITY: return "DYN_LOW";
+    case AudioResampler::DYN_MED_QUALITY: return "DYN_MED";
+    case AudioResampler::DYN_HIGH_QUALITY: return "DYN_HIGH";
+    default: return "DEFAULT";
+    }
+}
+
+bool isDynamic(AudioResampler::src_quality quality) {
+    return quality >= AudioResampler::DYN_LOW_QUALITY;
+}
+
+// Results of the most recent run of each configuration, for the Pareto report.
+// channels, input rate, output rate, float
+using Configuration = std::tuple<int, int, int, bool>;
+struct Result {
+    AudioResampler::src_quality quality;
+    double framesPerSecond;
+    double sinadDb;
+    double thdDb;
+};
+std::map<Configuration, std::map<AudioResampler::src_quality, Result>> gResults;
+
+/*
+ * Measures the SINAD and THD of a sine of normalized frequency normFreq in the
+ * first channel of the interleaved data.
+ *
+ * The number of frames must be an integer number of periods of the sine,
+ * so that the harmonics are orthogonal over the interval.
+ */
+template <typename T>
+void measureSine(const T* data, size_t stride, size_t frames, double normFreq,
+        double* sinadDb, double* thdDb)
+{
+    double mean = 0.;
+    for (size_t i = 0; i < frames; ++i) {
+        mean += data[i * stride];
+    }
+    mean /= frames;
+    double total = 0.;
+    for (size_t i = 0; i < frames; ++i) {
+        const double x = data[i * stride] - mean;
+        total += x * x;
+    }
+    total /= frames;
+
+    double harmonicPower[kHarmonics + 1] = {};
+    for (size_t h = 1; h <= kHarmonics && h * normFreq < 0.5; ++h) {
+        double s = 0.;
+        double c = 0.;
+        for (size_t i = 0; i < frames; ++i) {
+            const double phase = 2. * M_PI * h * normFreq * i;
+            s += data[i * stride] * sin(phase);
+            c += data[i * stride] * cos(phase);
+        }
+        s *= 2. / frames;
+        c *= 2. / frames;
+        harmonicPower[h] = (s * s + c * c) * 0.5;
+    }
+    double distortion = 0.;
+    for (size_t h = 2; h <= kHarmonics; ++h) {
+        distortion += harmonicPower[h];
+    }
+    const double fundamental = harmonicPower[1];
+    *sinadDb = 10. * log10(fundamental / std::max(total - fundamental, 1e-30 * fundamental));
+    *thdDb = 10. * log10(std::max(distortion, 1e-30 * fundamental) / fundamental);
+}
+
+// Resamples frames output frames, rewinding the provider when the input is exhausted.
+void resampleFrames(int32_t* out, size_t outChannels, size_t frames,
+        SignalProvider* provider, AudioResampler* resampler)
+{
+    for (size_t i = 0; i < frames; ) {
+        const size_t resampled = resampler->resample(
+                out + outChannels * i, frames - i, provider);
+        if (resampled < frames - i) {
+            provider->reset();
+        }
+        i += resampled;
+    }
+}
+
+template <typename TI, typename TO>
+void runResampler(benchmark::State& state, AudioResampler::src_quality quality,
+        int channels, int inputRate, int outputRate)
+{
+    // mono is resampled to stereo.
+    const size_t outChannels = std::max(channels, 2);
+    SignalProvider provider;
+    provider.setSine<TI>(channels, kSineFrequency, inputRate, 1. /* seconds */);
+
+    std::unique_ptr<AudioResampler> resampler(AudioResampler::create(
+            std::is_same_v<TI, float> ? AUDIO_FORMAT_PCM_FLOAT : AUDIO_FORMAT_PCM_16_BIT,
+            channels, outputRate, quality));
+    resampler->setSampleRate(inputRate);
+    resampler->setVolume(AudioResampler::UNITY_GAIN_FLOAT, AudioResampler::UNITY_GAIN_FLOAT);
+
+    // Measure the quality after the filter has settled: skip 50 ms then
+    // analyze 100 ms, which is an integer number of periods of the sine.
+    const size_t settleFrames = outputRate / 20;
+    const size_t measureFrames = outputRate / 10;
+    std::vector<TO> measure((settleFrames + measureFrames) * outChannels);
+    resampleFrames(reinterpret_cast<int32_t*>(measure.data()), outChannels,
+            settleFrames + measureFrames, &provider, resampler.get());
+    double sinadDb;
+    double thdDb;
+    measureSine(measure.data() + settleFrames * outChannels, outChannels, measureFrames,
+            kSineFrequency / outputRate, &sinadDb, &thdDb);
+
+    // The resampler accumulates into the output buffer, which is cleared as by the mixer.
+    std::vector<TO> out(kFramesPerIteration * outChannels);
+    int64_t frames = 0;
+    const nsecs_t startNs = systemTime(SYSTEM_TIME_MONOTONIC);
+    while (state.KeepRunning()) {
+        std::fill(out.begin(), out.end(), 0);
+        benchmark::DoNotOptimize(out.data());
+        resampleFrames(reinterpret_cast<int32_t*>(out.data()), outChannels,
+                kFramesPerIteration, &provider, resampler.get());
+        benchmark::ClobberMemory();
+        frames += kFramesPerIteration;
+    }
+    const nsecs_t elapsedNs = systemTime(SYSTEM_TIME_MONOTONIC) - startNs;
+
+    state.counters["frames/s"] = benchmark::Counter(frames, benchmark::Counter::kIsRate);
+    state.counters["SINAD_dB"] = sinadDb;
+    state.counters["THD_dB"] = thdDb;
+    state.SetLabel(qualityToString(quality));
+
+    gResults[{channels, inputRate, outputRate, std::is_same_v<TI, float>}][quality] = {
+        quality,
+        elapsedNs > 0 ? frames * 1e9 / elapsedNs : 0.,
+        sinadDb,
+        thdDb,
+    };
+}
+
+void BM_Resampler(benchmark::State& state) {
+    const auto quality = static_cast<AudioResampler::src_quality>(state.range(0));
+    const int channels = state.range(1);
+    const int inputRate = state.range(2);
+    const int outputRate = state.range(3);
+    if (state.range(4)) {
+        runResampler<float, float>(state, quality, channels, inputRate, outputRate);
+    } else {
+        runResampler<int16_t, int32_t>(state, quality, channels, inputRate, outputRate);
+    }
+}
+
+void ResamplerArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"quality", "channels", "inRate", "outRate", "float"});
+    for (const bool useFloat : { false, true }) {
+        for (const auto quality : kQualities) {
+            // the non-dynamic resamplers are limited to 16 bit stereo.
+            if (!isDynamic(quality) && useFloat) continue;
+            for (const int channels : kChannels) {
+                if (!isDynamic(quality) && channels > 2) continue;
+                for (const auto& [inputRate, outputRate] : kRatePairs) {
+                    b->Args({quality, channels, inputRate, outputRate, useFloat});
+                }
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_Resampler)->Apply(ResamplerArgs);
+
+void printParetoReport() {
+    printf("\nResampler quality/CPU report, '*' marks the Pareto optimal qualities\n");
+    for (const auto& [configuration, results] : gResults) {
+        const auto& [channels, inputRate, outputRate, useFloat] = configuration;
+        printf("%s channels:%d %d -> %d\n",
+                useFloat ? "float" : "int16", channels, inputRate, outputRate);
+        for (const auto& [quality, result] : results) {
+            const bool dominated = std::any_of(results.begin(), results.end(),
+                    [&result = result](const auto& other) {
+                const Result& o = other.second;
+                return o.framesPerSecond >= result.framesPerSecond
+                        && o.sinadDb >= result.sinadDb
+                        && (o.framesPerSecond > result.framesPerSecond
+                                || o.sinadDb > result.sinadDb);
+            });
+            printf("  %c %-10s %12.0f frames/s %7.2fx realtime SINAD:%7.2f dB THD:%8.2f dB\n",
+                    dominated ? ' ' : '*', qualityToString(quality),
+                    result.framesPerSecond, result.framesPerSecond / outputRate,
+                    result.sinadDb, result.thdDb);
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    printParetoReport();
+    return 0;
+}
@@ -28,6 +28,7 @@
 #include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <utility>
@@ -36,10 +37,14 @@
 #include <gtest/gtest.h>
 #include <log/log.h>
 #include <media/AudioBufferProvider.h>
+#include <utils/Timers.h>
 
 #include <media/AudioResampler.h>
 #include "../AudioResamplerDyn.h"
 #include "../AudioResamplerFirGen.h"
+#include "../AudioResamplerFirOps.h"
+#include "../AudioResamplerFirProcess.h"
+#include "../AudioResamplerFirProcessNeon.h"
 #include "test_utils.h"
 
 template <typename T>
@@ -371,6 +376,26 @@ TEST(audioflinger_resampler, bufferincrement_interpolatedphase_multi_float) {
     }
 }
 
+TEST(audioflinger_resampler, bufferincrement_multichannel) {
+    // only dynamic quality
+    static const enum android::AudioResampler::src_quality kQualityArray[] = {
+            android::AudioResampler::DYN_LOW_QUALITY,
+            android::AudioResampler::DYN_MED_QUALITY,
+            android::AudioResampler::DYN_HIGH_QUALITY,
+    };
+    // 5.1, 7.1 and 7.1.4 layouts, which have specialized kernels on some platforms.
+    static const size_t kChannelsArray[] = { 6, 8, 12 };
+
+    for (size_t channels : kChannelsArray) {
+        for (size_t i = 0; i < ARRAY_SIZE(kQualityArray); ++i) {
+            testBufferIncrement(channels, false, 48000, 32000, kQualityArray[i]);
+            testBufferIncrement(channels, false, 22050, 48000, kQualityArray[i]);
+            testBufferIncrement(channels, true, 48000, 32000, kQualityArray[i]);
+            testBufferIncrement(channels, true, 22050, 48000, kQualityArray[i]);
+        }
+    }
+}
+
 /* Simple aliasing test
  *
  * This checks stopband response of the chirp signal to make sure frequencies
@@ -601,3 +626,150 @@ TEST(audioflinger_resampler, generalresponse) {
         }
     }
 }
+
+// Resamplers with the same conversion share the filter bank designed by the first one.
+TEST(audioflinger_resampler, filtercache) {
+    using ResamplerType = android::AudioResamplerDyn<float, float, float>;
+    const auto create = [](size_t channels, int32_t inSampleRate, int32_t outSampleRate) {
+        std::unique_ptr<ResamplerType> resampler(static_cast<ResamplerType *>(
+                android::AudioResampler::create(AUDIO_FORMAT_PCM_FLOAT, channels,
+                        outSampleRate, android::AudioResampler::DYN_MED_QUALITY)));
+        resampler->setSampleRate(inSampleRate);
+        return resampler;
+    };
+
+    auto first = create(2 /* channels */, 44100, 48000);
+    // the channel count does not affect the filter design.
+    auto second = create(6 /* channels */, 44100, 48000);
+    ASSERT_NE(nullptr, first->getFilterCoefs());
+    ASSERT_EQ(first->getFilterCoefs(), second->getFilterCoefs());
+    ASSERT_EQ(first->getPhases(), second->getPhases());
+    ASSERT_EQ(first->getHalfLength(), second->getHalfLength());
+
+    // the filter bank remains valid for the other resamplers using it.
+    const float* const coefs = second->getFilterCoefs();
+    const std::vector<float> copy(
+            coefs, coefs + (second->getPhases() + 1) * second->getHalfLength());
+    first.reset();
+    ASSERT_TRUE(std::equal(copy.begin(), copy.end(), second->getFilterCoefs()));
+
+    // a different conversion has its own filter bank.
+    auto third = create(2 /* channels */, 32000, 48000);
+    ASSERT_NE(second->getFilterCoefs(), third->getFilterCoefs());
+}
+
+// TC = filter coefficient type, TI = input sample type, TO = output sample type.
+// Compares the (possibly accelerated) ProcessL() and Process() specializations
+// against the generic ProcessBase() for one output frame.
+template <int CHANNELS, typename TC, typename TI, typename TO, typename TINTERP>
+void testProcessMultichannel(TINTERP lerpP, double tolerance)
+{
+    constexpr int kHalfNumCoefs = 32;
+    // polyphases P, P+1 and N, N+1 are contiguous, as in the filter bank.
+    alignas(16) TC coefs[4 * kHalfNumCoefs];
+    std::vector<TI> samples(CHANNELS * (2 * kHalfNumCoefs + 1));
+    for (size_t i = 0; i < ARRAY_SIZE(coefs); ++i) {
+        coefs[i] = is_same<TC, int16_t>::value
+                ? static_cast<TC>(rand() % 65536 - 32768)
+                : static_cast<TC>(rand() / (double)RAND_MAX - 0.5);
+    }
+    for (auto& sample : samples) {
+        sample = is_same<TI, int16_t>::value
+                ? static_cast<TI>(rand() % 65536 - 32768)
+                : static_cast<TI>(rand() / (double)RAND_MAX - 0.5);
+    }
+    const TC* const coefsP = coefs;
+    const TC* const coefsP1 = coefs + kHalfNumCoefs;
+    const TC* const coefsN = coefs + 2 * kHalfNumCoefs;
+    const TC* const coefsN1 = coefs + 3 * kHalfNumCoefs;
+    const TI* const sP = samples.data() + CHANNELS * (kHalfNumCoefs - 1);
+    const TI* const sN = sP + CHANNELS;
+    const TO volumeLR[2] = {
+            is_same<TO, float>::value ? static_cast<TO>(0.7) : static_cast<TO>(0x59990000),
+            0, // unused by multichannel
+    };
+
+    TO expected[CHANNELS];
+    TO actual[CHANNELS];
+    for (int i = 0; i < CHANNELS; ++i) {
+        expected[i] = actual[i] = static_cast<TO>(i);
+    }
+    android::ProcessBase<CHANNELS, 16, android::InterpNull>(
+            expected, kHalfNumCoefs, coefsP, coefsN, sP, sN, lerpP, volumeLR);
+    android::ProcessL<CHANNELS, 16>(
+            actual, kHalfNumCoefs, coefsP, coefsN, sP, sN, volumeLR);
+    for (int i = 0; i < CHANNELS; ++i) {
+        ASSERT_NEAR(expected[i], actual[i], tolerance) << "locked channel " << i;
+    }
+
+    for (int i = 0; i < CHANNELS; ++i) {
+        expected[i] = actual[i] = static_cast<TO>(i);
+    }
+    android::ProcessBase<CHANNELS, 16, android::InterpCompute>(
+            expected, kHalfNumCoefs, coefsP, coefsN, sP, sN, lerpP, volumeLR);
+    android::Process<CHANNELS, 16>(
+            actual, kHalfNumCoefs, coefsP, coefsN, coefsP1, coefsN1, sP, sN, lerpP, volumeLR);
+    for (int i = 0; i < CHANNELS; ++i) {
+        ASSERT_NEAR(expected[i], actual[i], tolerance) << "interpolated channel " << i;
+    }
+}
+
+TEST(audioflinger_resampler, process_multichannel) {
+    for (int i = 0; i < 16; ++i) {
+        // the integer kernels are bit exact, the float kernels accumulate in a different order.
+        testProcessMultichannel<6, int16_t, int16_t, int32_t>(uint32_t(rand() & 0x7fff), 0.);
+        testProcessMultichannel<8, int16_t, int16_t, int32_t>(uint32_t(rand() & 0x7fff), 0.);
+        testProcessMultichannel<12, int16_t, int16_t, int32_t>(uint32_t(rand() & 0x7fff), 0.);
+        testProcessMultichannel<6, float, float, float>(float(rand() / (double)RAND_MAX), 1e-4);
+        testProcessMultichannel<8, float, float, float>(float(rand() / (double)RAND_MAX), 1e-4);
+        testProcessMultichannel<12, float, float, float>(float(rand() / (double)RAND_MAX), 1e-4);
+    }
+}
+
+// Reports the resampler throughput in ns per output frame for multichannel content,
+// both for the locked (48 to 32 kHz) and the interpolated (44.1 to 48 kHz) polyphase.
+TEST(audioflinger_resampler, multichannel_benchmark) {
+    static const size_t kChannelsArray[] = { 2, 6, 8, 12 };
+    static const unsigned kRates[][2] = { { 48000, 32000 }, { 44100, 48000 } };
+    constexpr int kRepeat = 10;
+
+    for (bool useFloat : { false, true }) {
+        for (size_t channels : kChannelsArray) {
+            for (const auto& rates : kRates) {
+                const unsigned inputFreq = rates[0];
+                const unsigned outputFreq = rates[1];
+                SignalProvider provider;
+                if (useFloat) {
+                    provider.setChirp<float>(channels, 0., outputFreq / 2., outputFreq, 1.);
+                } else {
+                    provider.setChirp<int16_t>(channels, 0., outputFreq / 2., outputFreq, 1.);
+                }
+                const size_t outputFrames =
+                        ((int64_t)provider.getNumFrames() * outputFreq) / inputFreq;
+                std::vector<int32_t> output(outputFrames * channels); // same size as float
+                const std::vector<size_t> outputIncr{ 256 };
+
+                int64_t bestNs = INT64_MAX;
+                for (int i = 0; i < kRepeat; ++i) {
+                    provider.reset();
+                    std::unique_ptr<android::AudioResampler> resampler(
+                            android::AudioResampler::create(useFloat
+                                    ? AUDIO_FORMAT_PCM_FLOAT : AUDIO_FORMAT_PCM_16_BIT,
+                                    channels, outputFreq,
+                                    android::AudioResampler::DYN_MED_QUALITY));
+                    resampler->setSampleRate(inputFreq);
+                    resampler->setVolume(android::AudioResampler::UNITY_GAIN_FLOAT,
+                            android::AudioResampler::UNITY_GAIN_FLOAT);
+                    std::fill(output.begin(), output.end(), 0);
+                    const int64_t startNs = systemTime(SYSTEM_TIME_MONOTONIC);
+                    resample(channels, output.data(), outputFrames, outputIncr,
+                            &provider, resampler.get());
+                    bestNs = std::min(bestNs, systemTime(SYSTEM_TIME_MONOTONIC) - startNs);
+                }
+                printf("%s channels:%zu %u -> %u: %.2f ns/frame\n",
+                        useFloat ? "float" : "int16", channels, inputFreq, outputFreq,
+                        (double)bestNs / outputFrames);
+            }
+        }
+    }
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define LOG_TAG "ThreadCpuStats"
+//#define LOG_NDEBUG 0
+
+#include <sched.h>
+
+#include <utils/Log.h>
+
+#include <cpustats/ThreadCpuStats.h>
+
+namespace android {
+
+void ThreadCpuStats::sample()
+{
+    ++mSamples;
+    double ns;
+    const bool valid = mCpuUsage.sampleAndEnable(ns);
+
+    const int cpuNum = sched_getcpu();
+    if (cpuNum != mCpuNum) {
+        if (mCpuNum >= 0) {
+            ++mMigrations;
+        }
+        mCpuNum = cpuNum;
+        mFrequencyCountdown = 0;
+    }
+    if (mFrequencyCountdown == 0) {
+        mCpukHz = cpuNum >= 0 && cpuNum < MAX_CPU ? mCpuUsage.getCpukHz(cpuNum) : 0;
+        mFrequencyCountdown = FREQUENCY_PERIOD;
+    }
+    --mFrequencyCountdown;
+
+    if (!valid) {
+        return;
+    }
+    // the CPU time since the previous sample is attributed to the current CPU
+    const long long deltaNs = (long long) ns;
+    mCpuNs += deltaNs;
+    if (cpuNum >= 0 && cpuNum < MAX_CPU) {
+        mCpuNsPerCpu[cpuNum] += deltaNs;
+    }
+    if (mCpukHz > 0) {
+        mCycles += ns * mCpukHz * 0.000001;
+        mCyclesNs += deltaNs;
+    }
+}
+
+void ThreadCpuStats::reset()
+{
+    ALOGV("reset");
+    mSamples = 0;
+    mCpuNs = 0;
+    for (int i = 0; i < MAX_CPU; ++i) {
+        mCpuNsPerCpu[i] = 0;
+    }
+    mMigrations = 0;
+    mCycles = 0.0;
+    mCyclesNs = 0;
+    mCpuNum = -1;
+    mCpukHz = 0;
+    mFrequencyCountdown = 0;
+    mCpuUsage.resetElapsed();
+}
+
+long long ThreadCpuStats::cpuNs(int cpuNum) const
+{
+    if (cpuNum < 0 || cpuNum >= MAX_CPU) {
+        return 0;
+    }
+    return mCpuNsPerCpu[cpuNum];
+}
+
+double ThreadCpuStats::meanMHz() const
+{
+    // mCycles / (mCyclesNs * 1e-9) cycles per second, in MHz
+    return mCyclesNs > 0 ? mCycles * 1000.0 / mCyclesNs : 0.0;
+}
+
+}   // namespace android
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _THREAD_CPU_STATS_H
+#define _THREAD_CPU_STATS_H
+
+#include <cpustats/ThreadCpuUsage.h>
+
+namespace android {
+
+// Accumulate CPU placement statistics for a cyclic thread, built on ThreadCpuUsage:
+// the thread CPU time, how that time was split across CPUs, the number of migrations
+// to another CPU, and the mean frequency of the CPUs weighted by the thread CPU time.
+// Call sample() once per cycle, and reset() to start a new period once the summary of
+// the current period has been reported.
+// The CPU frequency is read from sysfs, which is more expensive than the rest of sample(),
+// so it is read only every FREQUENCY_PERIOD samples, and upon a migration.
+// Like ThreadCpuUsage, this class is not thread-safe; the methods of this class
+// may only be called by the current thread which constructed the object.
+
+class ThreadCpuStats
+{
+
+public:
+    static const int MAX_CPU = 8;           // same as ThreadCpuUsage
+    static const unsigned FREQUENCY_PERIOD = 16;
+
+    ThreadCpuStats() { reset(); }
+
+    // Add a sample for the CPU time used by the current thread since the previous sample.
+    void sample();
+
+    // Clear the statistics and restart the elapsed wall clock.
+    void reset();
+
+    // Return the elapsed wall clock ns since the first sample or reset.
+    long long elapsed() const { return mCpuUsage.elapsed(); }
+
+    // Return the number of calls to sample() since reset.
+    unsigned samples() const    { return mSamples; }
+
+    // Return the thread CPU ns since reset, over all CPUs or on the specified CPU.
+    long long cpuNs() const     { return mCpuNs; }
+    long long cpuNs(int cpuNum) const;
+
+    // Return the number of times the thread was found on another CPU than at the previous
+    // sample since reset.
+    unsigned migrations() const { return mMigrations; }
+
+    // Return the mean CPU frequency in MHz weighted by the thread CPU time, or 0 if unknown.
+    double meanMHz() const;
+
+private:
+    ThreadCpuUsage mCpuUsage;
+    unsigned mSamples;              // number of calls to sample() since reset
+    long long mCpuNs;               // thread CPU ns since reset
+    long long mCpuNsPerCpu[MAX_CPU];// thread CPU ns since reset, per CPU
+    unsigned mMigrations;           // number of CPU changes since reset
+    double mCycles;                 // CPU cycles of the samples with a known frequency
+    long long mCyclesNs;            // thread CPU ns of the samples in mCycles
+    int mCpuNum;                    // CPU number at previous sample, or -1 if unknown
+    uint32_t mCpukHz;               // most recently read frequency of mCpuNum, or 0 if unknown
+    unsigned mFrequencyCountdown;   // samples before the next frequency read
+};
+
+}   // namespace android
+
+#endif //  _THREAD_CPU_STATS_H
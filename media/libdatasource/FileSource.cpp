@@ -18,22 +18,39 @@
 #define LOG_TAG "FileSource"
 #include <utils/Log.h>
 
+#include <cutils/properties.h>
 #include <datasource/FileSource.h>
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/FoundationUtils.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 
+#include <algorithm>
+
 namespace android {
 
+// Do not map more than a fraction of the address space of 32-bit processes.
+static const int64_t kMaxMappedSize =
+        sizeof(void *) > 4 ? INT64_MAX : 256 * 1024 * 1024;
+
+static bool isMemoryMappedReadEnabled() {
+    return property_get_bool("media.stagefright.filesource.mmap", false /* default_value */);
+}
+
 FileSource::FileSource(const char *filename)
     : mFd(-1),
       mOffset(0),
       mLength(-1),
-      mName("<null>") {
+      mName("<null>"),
+      mMapBase(nullptr),
+      mMapSize(0),
+      mMapData(nullptr),
+      mNumReads(0),
+      mNumBytesRead(0) {
 
     if (filename) {
         mName = String8::format("FileSource(%s)", filename);
@@ -43,6 +60,7 @@ FileSource::FileSource(const char *filename)
 
     if (mFd >= 0) {
         mLength = lseek64(mFd, 0, SEEK_END);
+        mapFile();
     } else {
         ALOGE("Failed to open file '%s'. (%s)", filename, strerror(errno));
     }
@@ -52,7 +70,12 @@ FileSource::FileSource(int fd, int64_t offset, int64_t length)
     : mFd(fd),
       mOffset(offset),
       mLength(length),
-      mName("<null>") {
+      mName("<null>"),
+      mMapBase(nullptr),
+      mMapSize(0),
+      mMapData(nullptr),
+      mNumReads(0),
+      mNumBytesRead(0) {
     ALOGV("fd=%d (%s), offset=%lld, length=%lld",
             fd, nameForFd(fd).c_str(), (long long) offset, (long long) length);
 
@@ -87,9 +110,14 @@ FileSource::FileSource(int fd, int64_t offset, int64_t length)
             (long long) mOffset,
             (long long) mLength);
 
+    mapFile();
 }
 
 FileSource::~FileSource() {
+    if (mMapBase != nullptr) {
+        munmap(mMapBase, mMapSize);
+        mMapBase = nullptr;
+    }
     if (mFd >= 0) {
         ::close(mFd);
         mFd = -1;
@@ -100,11 +128,52 @@ status_t FileSource::initCheck() const {
     return mFd >= 0 ? OK : NO_INIT;
 }
 
+void FileSource::mapFile() {
+    if (mFd < 0 || mLength <= 0 || mLength > kMaxMappedSize || !isMemoryMappedReadEnabled()) {
+        return;
+    }
+    struct stat s;
+    if (fstat(mFd, &s) != 0 || !S_ISREG(s.st_mode)) {
+        // pipes, sockets and devices cannot be mapped reliably
+        return;
+    }
+
+    const off64_t pageSize = sysconf(_SC_PAGESIZE);
+    const off64_t mapOffset = mOffset - mOffset % pageSize;
+    const size_t mapSize = mLength + (mOffset - mapOffset);
+    void *base = mmap64(nullptr, mapSize, PROT_READ, MAP_SHARED, mFd, mapOffset);
+    if (base == MAP_FAILED) {
+        ALOGV("mmap failed (%s), using pread", strerror(errno));
+        return;
+    }
+    mMapBase = base;
+    mMapSize = mapSize;
+    mMapData = (const uint8_t *)base + (mOffset - mapOffset);
+}
+
 ssize_t FileSource::readAt(off64_t offset, void *data, size_t size) {
     if (mFd < 0) {
         return NO_INIT;
     }
 
+    if (mMapData != nullptr) {
+        // mLength is known for mapped files
+        if (offset < 0) {
+            return UNKNOWN_ERROR;
+        }
+        if (offset >= mLength) {
+            return 0;  // read beyond EOF.
+        }
+        uint64_t numAvailable = mLength - offset;
+        if ((uint64_t)size > numAvailable) {
+            size = numAvailable;
+        }
+        memcpy(data, mMapData + offset, size);
+        mNumReads.fetch_add(1, std::memory_order_relaxed);
+        mNumBytesRead.fetch_add(size, std::memory_order_relaxed);
+        return size;
+    }
+
     Mutex::Autolock autoLock(mLock);
     if (mLength >= 0) {
         if (offset < 0) {
@@ -122,13 +191,22 @@ ssize_t FileSource::readAt(off64_t offset, void *data, size_t size) {
 }
 
 ssize_t FileSource::readAt_l(off64_t offset, void *data, size_t size) {
-    off64_t result = lseek64(mFd, offset + mOffset, SEEK_SET);
-    if (result == -1) {
-        ALOGE("seek to %lld failed", (long long)(offset + mOffset));
-        return UNKNOWN_ERROR;
+    if (mMapData != nullptr && offset >= 0 && offset < mLength) {
+        size = std::min((uint64_t)size, (uint64_t)(mLength - offset));
+        memcpy(data, mMapData + offset, size);
+        mNumReads.fetch_add(1, std::memory_order_relaxed);
+        mNumBytesRead.fetch_add(size, std::memory_order_relaxed);
+        return size;
     }
 
-    return ::read(mFd, data, size);
+    ssize_t result = pread64(mFd, data, size, offset + mOffset);
+    if (result < 0) {
+        ALOGE("read at %lld failed (%s)", (long long)(offset + mOffset), strerror(errno));
+        return UNKNOWN_ERROR;
+    }
+    mNumReads.fetch_add(1, std::memory_order_relaxed);
+    mNumBytesRead.fetch_add(result, std::memory_order_relaxed);
+    return result;
 }
 
 status_t FileSource::getSize(off64_t *size) {
@@ -143,4 +221,10 @@ status_t FileSource::getSize(off64_t *size) {
     return OK;
 }
 
+status_t FileSource::getReadStatistics(int64_t *numReads, int64_t *numBytes) {
+    *numReads = mNumReads.load(std::memory_order_relaxed);
+    *numBytes = mNumBytesRead.load(std::memory_order_relaxed);
+    return OK;
+}
+
 }  // namespace android
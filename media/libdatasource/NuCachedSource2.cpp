@@ -31,15 +31,17 @@
 namespace android {
 
 struct PageCache {
-    explicit PageCache(size_t pageSize);
+    PageCache();
     ~PageCache();
 
     struct Page {
         void *mData;
         size_t mSize;
+        size_t mCapacity;
     };
 
-    Page *acquirePage();
+    // Returns a page that can hold at least |capacity| bytes.
+    Page *acquirePage(size_t capacity);
     void releasePage(Page *page);
 
     void appendPage(Page *page);
@@ -52,7 +54,6 @@ struct PageCache {
     void copy(size_t from, void *data, size_t size);
 
 private:
-    size_t mPageSize;
     size_t mTotalSize;
 
     List<Page *> mActivePages;
@@ -63,9 +64,8 @@ private:
     DISALLOW_EVIL_CONSTRUCTORS(PageCache);
 };
 
-PageCache::PageCache(size_t pageSize)
-    : mPageSize(pageSize),
-      mTotalSize(0) {
+PageCache::PageCache()
+    : mTotalSize(0) {
 }
 
 PageCache::~PageCache() {
@@ -86,18 +86,27 @@ void PageCache::freePages(List<Page *> *list) {
     }
 }
 
-PageCache::Page *PageCache::acquirePage() {
+PageCache::Page *PageCache::acquirePage(size_t capacity) {
     if (!mFreePages.empty()) {
         List<Page *>::iterator it = mFreePages.begin();
         Page *page = *it;
         mFreePages.erase(it);
 
+        if (page->mCapacity >= capacity) {
+            return page;
+        }
+
+        // The page size has grown since this page was allocated.
+        free(page->mData);
+        page->mData = malloc(capacity);
+        page->mCapacity = capacity;
         return page;
     }
 
     Page *page = new Page;
-    page->mData = malloc(mPageSize);
+    page->mData = malloc(capacity);
     page->mSize = 0;
+    page->mCapacity = capacity;
 
     return page;
 }
@@ -186,7 +195,7 @@ NuCachedSource2::NuCachedSource2(
     : mSource(source),
       mReflector(new AHandlerReflector<NuCachedSource2>(this)),
       mLooper(new ALooper),
-      mCache(new PageCache(kPageSize)),
+      mCache(new PageCache),
       mCacheOffset(0),
       mFinalStatus(OK),
       mLastAccessPos(0),
@@ -197,7 +206,17 @@ NuCachedSource2::NuCachedSource2(
       mHighwaterThresholdBytes(kDefaultHighWaterThreshold),
       mLowwaterThresholdBytes(kDefaultLowWaterThreshold),
       mKeepAliveIntervalUs(kDefaultKeepAliveIntervalUs),
-      mDisconnectAtHighwatermark(disconnectAtHighwatermark) {
+      mDisconnectAtHighwatermark(disconnectAtHighwatermark),
+      mTotalFetchTimeUs(0),
+      mTotalFetchBytes(0),
+      mFetchSize(kPageSize),
+      mAdaptiveWatermarks(true),
+      mMinHighwaterThresholdBytes(kMinHighWaterThreshold),
+      mRangeSourceConnected(false),
+      mRangeBuffer(NULL),
+      mRangeBufferOffset(-1),
+      mRangeBufferSize(0),
+      mNumSequentialRangeReads(0) {
     // We are NOT going to support disconnect-at-highwatermark indefinitely
     // and we are not guaranteeing support for client-specified cache
     // parameters. Both of these are temporary measures to solve a specific
@@ -234,6 +253,9 @@ NuCachedSource2::~NuCachedSource2() {
 
     delete mCache;
     mCache = NULL;
+
+    free(mRangeBuffer);
+    mRangeBuffer = NULL;
 }
 
 // static
@@ -253,7 +275,86 @@ status_t NuCachedSource2::getEstimatedBandwidthKbps(int32_t *kbps) {
         HTTPBase* source = static_cast<HTTPBase *>(mSource.get());
         return source->getEstimatedBandwidthKbps(kbps);
     }
-    return ERROR_UNSUPPORTED;
+
+    Mutex::Autolock autoLock(mLock);
+    if (!estimateBandwidth_l(kbps)) {
+        return ERROR_UNSUPPORTED;
+    }
+    return OK;
+}
+
+void NuCachedSource2::addBandwidthMeasurement_l(size_t numBytes, int64_t delayUs) {
+    BandwidthEntry entry;
+    entry.mDelayUs = delayUs;
+    entry.mNumBytes = numBytes;
+    mTotalFetchTimeUs += delayUs;
+    mTotalFetchBytes += numBytes;
+    mBandwidthHistory.push_back(entry);
+
+    if (mBandwidthHistory.size() > kMaxBandwidthHistoryItems) {
+        const BandwidthEntry &oldest = *mBandwidthHistory.begin();
+        mTotalFetchTimeUs -= oldest.mDelayUs;
+        mTotalFetchBytes -= oldest.mNumBytes;
+        mBandwidthHistory.erase(mBandwidthHistory.begin());
+    }
+
+    updateReadaheadPolicy_l();
+}
+
+bool NuCachedSource2::estimateBandwidth_l(int32_t *kbps) const {
+    // As in HTTPBase, a couple of small fetches make for a wild estimate.
+    if (mBandwidthHistory.size() < 2 || mTotalFetchBytes < 4 * kPageSize
+            || mTotalFetchTimeUs <= 0) {
+        return false;
+    }
+
+    *kbps = (int32_t)(mTotalFetchBytes * 8E3 / mTotalFetchTimeUs);
+    return true;
+}
+
+void NuCachedSource2::updateReadaheadPolicy_l() {
+    int32_t kbps;
+    if (!estimateBandwidth_l(&kbps)) {
+        return;
+    }
+    const size_t bytesPerSec = (size_t)kbps * 1000 / 8;
+
+    // Size the fetches so that each one takes about a quarter of a second:
+    // fast links then need fewer round trips through the source, slow ones
+    // still see the cache grow (and readers unblock) at a steady pace.
+    static const size_t kTargetFetchesPerSec = 4;
+    size_t fetchSize = bytesPerSec / kTargetFetchesPerSec / kPageSize * kPageSize;
+    if (fetchSize < kPageSize) {
+        fetchSize = kPageSize;
+    } else if (fetchSize > kMaxPageSize) {
+        fetchSize = kMaxPageSize;
+    }
+
+    if (fetchSize != mFetchSize) {
+        ALOGV("%d kbps, fetch size %zu -> %zu", kbps, mFetchSize, fetchSize);
+        mFetchSize = fetchSize;
+    }
+
+    if (!mAdaptiveWatermarks) {
+        return;
+    }
+
+    // Cache about 40 seconds of transfer, which is what the default
+    // watermarks amount to at 4 Mbps, keeping the default 5:1 ratio.
+    static const size_t kHighWaterSecs = 40;
+    size_t highwater = bytesPerSec * kHighWaterSecs;
+    if (highwater < mMinHighwaterThresholdBytes) {
+        highwater = mMinHighwaterThresholdBytes;
+    } else if (highwater > kMaxHighWaterThreshold) {
+        highwater = kMaxHighWaterThreshold;
+    }
+    highwater = highwater / kPageSize * kPageSize;
+
+    if (highwater != mHighwaterThresholdBytes) {
+        ALOGV("%d kbps, watermarks %zu/%zu bytes", kbps, highwater / 5, highwater);
+        mHighwaterThresholdBytes = highwater;
+        mLowwaterThresholdBytes = highwater / 5;
+    }
 }
 
 void NuCachedSource2::close() {
@@ -264,8 +365,11 @@ void NuCachedSource2::disconnect() {
     if (mSource->flags() & kIsHTTPBasedSource) {
         ALOGV("disconnecting HTTPBasedSource");
 
+        sp<HTTPBase> rangeSource;
         {
             Mutex::Autolock autoLock(mLock);
+            rangeSource = mRangeSource;
+
             // set mDisconnecting to true, if a fetch returns after
             // this, the source will be marked as EOS.
             mDisconnecting = true;
@@ -278,6 +382,9 @@ void NuCachedSource2::disconnect() {
         // explicitly disconnect from the source, to allow any
         // pending reads to return more promptly
         static_cast<HTTPBase *>(mSource.get())->disconnect();
+        if (rangeSource != NULL) {
+            rangeSource->disconnect();
+        }
     }
 }
 
@@ -361,10 +468,18 @@ void NuCachedSource2::fetchInternal() {
         }
     }
 
-    PageCache::Page *page = mCache->acquirePage();
+    PageCache::Page *page;
+    size_t fetchSize;
+    {
+        Mutex::Autolock autoLock(mLock);
+        fetchSize = mFetchSize;
+        page = mCache->acquirePage(fetchSize);
+    }
 
+    int64_t startTimeUs = ALooper::GetNowUs();
     ssize_t n = mSource->readAt(
-            mCacheOffset + mCache->totalSize(), page->mData, kPageSize);
+            mCacheOffset + mCache->totalSize(), page->mData, fetchSize);
+    int64_t delayUs = ALooper::GetNowUs() - startTimeUs;
 
     Mutex::Autolock autoLock(mLock);
 
@@ -394,6 +509,8 @@ void NuCachedSource2::fetchInternal() {
 
         page->mSize = n;
         mCache->appendPage(page);
+
+        addBandwidthMeasurement_l(n, delayUs);
     }
 }
 
@@ -537,6 +654,30 @@ ssize_t NuCachedSource2::readAt(off64_t offset, void *data, size_t size) {
         return size;
     }
 
+    if (shouldUseRangeSource_l(offset)) {
+        sp<HTTPBase> rangeSource = mRangeSource;
+
+        mLock.unlock();
+        ssize_t n = readFromRangeSource(rangeSource, offset, data, size);
+        mLock.lock();
+
+        if (mDisconnecting) {
+            return ERROR_END_OF_STREAM;
+        }
+
+        if (n >= 0) {
+            return n;
+        }
+
+        if (n != -EAGAIN) {
+            ALOGW("range source returned error %zd, not using it anymore", n);
+            mRangeSource.clear();
+        }
+
+        // Otherwise this is a seek; the cache follows, as without a range
+        // source.
+    }
+
     sp<AMessage> msg = new AMessage(kWhatRead, mReflector);
     msg->setInt64("offset", offset);
     msg->setPointer("data", data);
@@ -600,12 +741,20 @@ size_t NuCachedSource2::approxDataRemaining_l(off64_t offset, status_t *finalSta
 }
 
 ssize_t NuCachedSource2::readInternal(off64_t offset, void *data, size_t size) {
-    CHECK_LE(size, (size_t)mHighwaterThresholdBytes);
-
     ALOGV("readInternal offset %lld size %zu", (long long)offset, size);
 
     Mutex::Autolock autoLock(mLock);
 
+    if (mAdaptiveWatermarks && size > mHighwaterThresholdBytes
+            && size <= kDefaultHighWaterThreshold) {
+        // Don't let an adapted high watermark reject reads that the default
+        // one would have served.
+        mMinHighwaterThresholdBytes = size;
+        mHighwaterThresholdBytes = size;
+        mLowwaterThresholdBytes = size / 5;
+    }
+    CHECK_LE(size, (size_t)mHighwaterThresholdBytes);
+
     // If we're disconnecting, return EOS and don't access *data pointer.
     // data could be on the stack of the caller to NuCachedSource2::readAt(),
     // which may have exited already.
@@ -683,6 +832,93 @@ status_t NuCachedSource2::seekInternal_l(off64_t offset) {
     return OK;
 }
 
+bool NuCachedSource2::shouldUseRangeSource_l(off64_t offset) const {
+    if (mRangeSource == NULL) {
+        return false;
+    }
+
+    if (offset >= mRangeBufferOffset
+            && offset < mRangeBufferOffset + (off64_t)mRangeBufferSize) {
+        return true;
+    }
+
+    return offset < mCacheOffset
+            || offset > (off64_t)(mCacheOffset + mCache->totalSize() + kRangeReadThreshold);
+}
+
+ssize_t NuCachedSource2::readFromRangeSource(
+        const sp<HTTPBase> &source, off64_t offset, void *data, size_t size) {
+    if (offset >= mRangeBufferOffset
+            && offset + (off64_t)size <= mRangeBufferOffset + (off64_t)mRangeBufferSize) {
+        memcpy(data, (const uint8_t *)mRangeBuffer + (offset - mRangeBufferOffset), size);
+        return size;
+    }
+
+    if (offset >= mRangeBufferOffset
+            && offset <= mRangeBufferOffset + (off64_t)mRangeBufferSize) {
+        if (++mNumSequentialRangeReads >= kMaxSequentialRangeReads) {
+            ALOGV("sequential reads from %lld, moving the cache", (long long)offset);
+            mNumSequentialRangeReads = 0;
+            return -EAGAIN;
+        }
+    } else {
+        mNumSequentialRangeReads = 0;
+    }
+
+    if (!mRangeSourceConnected) {
+        status_t err = source->connect(mRangeSourceUri.c_str(), &mRangeSourceHeaders, offset);
+        if (err != OK) {
+            return err;
+        }
+        mRangeSourceConnected = true;
+    }
+
+    ALOGV("range read offset %lld size %zu", (long long)offset, size);
+
+    if (size >= kRangeReadSize) {
+        ssize_t n = source->readAt(offset, data, size);
+        mRangeBufferOffset = offset + (n > 0 ? n : 0);
+        mRangeBufferSize = 0;
+        return n;
+    }
+
+    if (mRangeBuffer == NULL) {
+        mRangeBuffer = malloc(kRangeReadSize);
+        if (mRangeBuffer == NULL) {
+            return NO_MEMORY;
+        }
+    }
+
+    ssize_t n = source->readAt(offset, mRangeBuffer, kRangeReadSize);
+    if (n < 0) {
+        mRangeBufferSize = 0;
+        return n;
+    }
+
+    mRangeBufferOffset = offset;
+    mRangeBufferSize = n;
+
+    size_t copy = (size_t)n < size ? n : size;
+    memcpy(data, mRangeBuffer, copy);
+    return copy;
+}
+
+void NuCachedSource2::setRangeSource(
+        const sp<HTTPBase> &source,
+        const char *uri,
+        const KeyedVector<String8, String8> *headers) {
+    Mutex::Autolock autoSerializer(mSerializer);
+    Mutex::Autolock autoLock(mLock);
+
+    mRangeSource = source;
+    mRangeSourceUri = uri;
+    mRangeSourceHeaders.clear();
+    if (headers != NULL) {
+        mRangeSourceHeaders = *headers;
+    }
+    mRangeSourceConnected = false;
+}
+
 void NuCachedSource2::resumeFetchingIfNecessary() {
     Mutex::Autolock autoLock(mLock);
 
@@ -716,6 +952,9 @@ void NuCachedSource2::updateCacheParamsFromString(const char *s) {
         return;
     }
 
+    // Explicitly configured watermarks are not second-guessed.
+    mAdaptiveWatermarks = false;
+
     if (lowwaterMarkKb >= 0) {
         mLowwaterThresholdBytes = lowwaterMarkKb * 1024;
     } else {
@@ -20,6 +20,8 @@
 
 #include <stdio.h>
 
+#include <atomic>
+
 #include <media/DataSource.h>
 #include <media/stagefright/MediaErrors.h>
 #include <utils/threads.h>
@@ -38,6 +40,8 @@ public:
 
     virtual status_t getSize(off64_t *size);
 
+    virtual status_t getReadStatistics(int64_t *numReads, int64_t *numBytes);
+
     virtual uint32_t flags() {
         return kIsLocalFileSource;
     }
@@ -58,6 +62,17 @@ protected:
 private:
     String8 mName;
 
+    // Read-only mapping of the file when memory-mapped reads are enabled. Reads from the
+    // mapping do not need mLock, as mMapData and mLength do not change after construction.
+    void *mMapBase;
+    size_t mMapSize;
+    const uint8_t *mMapData;
+
+    std::atomic<int64_t> mNumReads;
+    std::atomic<int64_t> mNumBytesRead;
+
+    void mapFile();
+
     FileSource(const FileSource &);
     FileSource &operator=(const FileSource &);
 };
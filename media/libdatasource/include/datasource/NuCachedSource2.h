@@ -21,10 +21,12 @@
 #include <media/DataSource.h>
 #include <media/stagefright/foundation/ABase.h>
 #include <media/stagefright/foundation/AHandlerReflector.h>
+#include <utils/List.h>
 
 namespace android {
 
 struct ALooper;
+struct HTTPBase;
 struct PageCache;
 
 struct NuCachedSource2 : public DataSource {
@@ -61,10 +63,23 @@ struct NuCachedSource2 : public DataSource {
 
     void resumeFetchingIfNecessary();
 
-    // The following methods are supported only if the
-    // data source is HTTP-based; otherwise, ERROR_UNSUPPORTED
-    // is returned.
+    // Gives the cache a second, not yet connected source for the same
+    // content. Reads far away from the cached range (the index at the end of
+    // a non-faststart MP4, for instance) are then served over it on the
+    // caller's thread, while the prefetcher carries on where it was rather
+    // than dropping the cache. The source is connected on first use.
+    void setRangeSource(
+            const sp<HTTPBase> &source,
+            const char *uri,
+            const KeyedVector<String8, String8> *headers);
+
+    // Returns the bandwidth reported by the source if it is HTTP-based,
+    // otherwise the throughput observed by the prefetcher. ERROR_UNSUPPORTED
+    // is returned if neither is available yet.
     status_t getEstimatedBandwidthKbps(int32_t *kbps);
+
+    // Supported only if the data source is HTTP-based; otherwise,
+    // ERROR_UNSUPPORTED is returned.
     status_t setCacheStatCollectFreq(int32_t freqMs);
 
     static void RemoveCacheSpecificHeaders(
@@ -88,6 +103,19 @@ private:
         kDefaultHighWaterThreshold      = 20 * 1024 * 1024,
         kDefaultLowWaterThreshold       = 4 * 1024 * 1024,
 
+        // Bounds of the readahead policy, see updateReadaheadPolicy_l().
+        kMaxPageSize                    = 1024 * 1024,
+        kMinHighWaterThreshold          = 8 * 1024 * 1024,
+        kMaxHighWaterThreshold          = 40 * 1024 * 1024,
+
+        // Reads starting this far past the end of the cache go to the range
+        // source, if any, in chunks of at least kRangeReadSize bytes. After
+        // kMaxSequentialRangeReads contiguous chunks it is taken to be a seek
+        // of the playback position, which the cache itself then moves to.
+        kRangeReadThreshold             = 2 * 1024 * 1024,
+        kRangeReadSize                  = 256 * 1024,
+        kMaxSequentialRangeReads        = 4,
+
         // Read data after a 15 sec timeout whether we're actively
         // fetching or not.
         kDefaultKeepAliveIntervalUs     = 15000000,
@@ -102,6 +130,15 @@ private:
         kMaxNumRetries = 10,
     };
 
+    enum {
+        kMaxBandwidthHistoryItems = 20,
+    };
+
+    struct BandwidthEntry {
+        int64_t mDelayUs;
+        size_t mNumBytes;
+    };
+
     sp<DataSource> mSource;
     sp<AHandlerReflector<NuCachedSource2> > mReflector;
     sp<ALooper> mLooper;
@@ -130,6 +167,27 @@ private:
 
     bool mDisconnectAtHighwatermark;
 
+    // Throughput of the last few fetches, used to size the pages and, unless
+    // the cache parameters were configured explicitly, the watermarks.
+    List<BandwidthEntry> mBandwidthHistory;
+    int64_t mTotalFetchTimeUs;
+    size_t mTotalFetchBytes;
+    size_t mFetchSize;
+    bool mAdaptiveWatermarks;
+    // No read may be larger than the high watermark, or it would never be
+    // satisfied; the policy does not shrink it below the largest one seen.
+    size_t mMinHighwaterThresholdBytes;
+
+    sp<HTTPBase> mRangeSource;
+    String8 mRangeSourceUri;
+    KeyedVector<String8, String8> mRangeSourceHeaders;
+    // The following are only accessed with mSerializer held.
+    bool mRangeSourceConnected;
+    void *mRangeBuffer;
+    off64_t mRangeBufferOffset;
+    size_t mRangeBufferSize;
+    size_t mNumSequentialRangeReads;
+
     void onMessageReceived(const sp<AMessage> &msg);
     void onFetch();
     void onRead(const sp<AMessage> &msg);
@@ -138,8 +196,16 @@ private:
     ssize_t readInternal(off64_t offset, void *data, size_t size);
     status_t seekInternal_l(off64_t offset);
 
+    bool shouldUseRangeSource_l(off64_t offset) const;
+    ssize_t readFromRangeSource(
+            const sp<HTTPBase> &source, off64_t offset, void *data, size_t size);
+
     size_t approxDataRemaining_l(off64_t offset, status_t *finalStatus) const;
 
+    void addBandwidthMeasurement_l(size_t numBytes, int64_t delayUs);
+    bool estimateBandwidth_l(int32_t *kbps) const;
+    void updateReadaheadPolicy_l();
+
     void restartPrefetcherIfNecessary_l(
             bool ignoreLowWaterThreshold = false, bool force = false);
 
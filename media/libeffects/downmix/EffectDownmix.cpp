@@ -369,8 +369,8 @@ static int32_t Downmix_Process(effect_handle_t self,
           break;
 
       case DOWNMIX_TYPE_FOLD: {
-            if (!pDownmixer->channelMix.process(
-                    pSrc, pDst, numFrames, accumulate, downmixInputChannelMask)) {
+            // the input channel mask was set by Downmix_Configure()
+            if (!pDownmixer->channelMix.process(pSrc, pDst, numFrames, accumulate)) {
                 ALOGE("Multichannel configuration %#x is not supported",
                       downmixInputChannelMask);
                 return -EINVAL;
@@ -655,6 +655,13 @@ static int Downmix_Configure(downmix_module_t *pDwmModule, effect_config_t *pCon
                                                     pConfig->inputCfg.channels);
         return -EINVAL;
     }
+    // select the downmix matrix now rather than on the first process call
+    if (!pDownmixer->channelMix.setInputChannelMask(
+            (audio_channel_mask_t)pConfig->inputCfg.channels)) {
+        ALOGE("Downmix_Configure error: multichannel configuration %#x is not supported",
+                pConfig->inputCfg.channels);
+        return -EINVAL;
+    }
 
     if (&pDwmModule->config != pConfig) {
         memcpy(&pDwmModule->config, pConfig, sizeof(effect_config_t));
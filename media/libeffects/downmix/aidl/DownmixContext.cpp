@@ -138,8 +138,8 @@ IEffect::Status DownmixContext::downmixProcess(float* in, float* out, int sample
             frames--;
         }
     } else {
-        int chMask = mChMask.get<AudioChannelLayout::layoutMask>();
-        if (!mChannelMix.process(in, out, frames, accumulate, (audio_channel_mask_t)chMask)) {
+        // the input channel mask was set by init_params()
+        if (!mChannelMix.process(in, out, frames, accumulate)) {
             LOG(ERROR) << "Multichannel configuration " << mChMask.toString()
                        << " is not supported";
             return status;
@@ -155,6 +155,11 @@ void DownmixContext::init_params(const Parameter::Common& common) {
     if (!isChannelMaskValid(channelMask)) {
         LOG(ERROR) << "Downmix_Configure error: input channel mask " << channelMask.toString()
                    << " not supported";
+    } else if (!mChannelMix.setInputChannelMask(
+                       (audio_channel_mask_t)channelMask.get<AudioChannelLayout::layoutMask>())) {
+        // select the downmix matrix now rather than on the first process call
+        LOG(ERROR) << "Downmix_Configure error: multichannel configuration "
+                   << channelMask.toString() << " not supported";
     } else {
         mType = Downmix::Type::FOLD;
         mChMask = channelMask;
@@ -52,6 +52,7 @@ static constexpr audio_channel_mask_t kChannelPositionMasks[] = {
     AUDIO_CHANNEL_OUT_7POINT1POINT4,
     AUDIO_CHANNEL_OUT_13POINT_360RA,
     AUDIO_CHANNEL_OUT_22POINT2,
+    AUDIO_CHANNEL_OUT_9POINT1POINT6,
 };
 
 static constexpr effect_uuid_t downmix_uuid = {
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "dsp/DPFrequency.h"
+
+// Runs DPFrequency with all stages in use and enabled, the way the effect
+// configures it for a 10 ms preferred frame duration.
+
+namespace {
+
+constexpr size_t kSampleRate = 48000;
+constexpr size_t kBlockSize = 512;  // next power of 2 of 10 ms
+constexpr size_t kFrameCount = 960;  // 20 ms per process call
+constexpr uint32_t kBandCount = 6;
+constexpr float kCutoffFrequenciesHz[kBandCount] = {100, 400, 1000, 3000, 8000, 24000};
+
+void configureChannel(dp_fx::DPChannel *channel) {
+    channel->setInputGain(-3);
+    channel->setOutputGain(1);
+    for (dp_fx::DPEq *eq : {channel->getPreEq(), channel->getPostEq()}) {
+        eq->setEnabled(true);
+        for (uint32_t b = 0; b < kBandCount; b++) {
+            dp_fx::DPEqBand band;
+            band.init(true /* enabled */, kCutoffFrequenciesHz[b], b % 2 ? 3 : -3 /* gain */);
+            eq->setBand(b, band);
+        }
+    }
+    dp_fx::DPMbc *mbc = channel->getMbc();
+    mbc->setEnabled(true);
+    for (uint32_t b = 0; b < kBandCount; b++) {
+        dp_fx::DPMbcBand band;
+        band.init(true /* enabled */, kCutoffFrequenciesHz[b], 3 /* attackTime */,
+                80 /* releaseTime */, 2 /* ratio */, -20 /* threshold */, 4 /* kneeWidth */,
+                -70 /* noiseGateThreshold */, 1 /* expanderRatio */, 0 /* preGain */,
+                3 /* postGain */);
+        mbc->setBand(b, band);
+    }
+    dp_fx::DPLimiter *limiter = channel->getLimiter();
+    limiter->setEnabled(true);
+    limiter->setThreshold(-6);
+}
+
+void BM_DPFrequency(benchmark::State &state) {
+    const uint32_t channelCount = state.range(0);
+
+    dp_fx::DPFrequency dynamics;
+    dynamics.init(channelCount, true /* preEqInUse */, kBandCount, true /* mbcInUse */,
+            kBandCount, true /* postEqInUse */, kBandCount, true /* limiterInUse */);
+    for (uint32_t ch = 0; ch < channelCount; ch++) {
+        configureChannel(dynamics.getChannel(ch));
+    }
+    dynamics.configure(kBlockSize, kBlockSize / 2, kSampleRate);
+
+    const size_t samples = kFrameCount * channelCount;
+    std::vector<float> input(samples);
+    std::vector<float> output(samples);
+    std::minstd_rand gen(channelCount);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    for (float &sample : input) {
+        sample = dis(gen);
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(input.data());
+        benchmark::DoNotOptimize(output.data());
+        dynamics.processSamples(input.data(), output.data(), samples);
+        benchmark::ClobberMemory();
+    }
+}
+
+}  // namespace
+
+BENCHMARK(BM_DPFrequency)->Arg(1)->Arg(2)->Arg(6)->Arg(8);
+
+BENCHMARK_MAIN();
@@ -163,7 +163,11 @@ void DPFrequency::configure(size_t blockSize, size_t overlapSize,
     //effective number of frames processed per second
     mBlocksPerSecond = (float)mSamplingRate / (mBlockSize - mOverlapSize);
 
+    //the input is real: only compute, and process, half the spectrum.
+    mFftServer.SetFlag(Eigen::FFT<float>::HalfSpectrum);
+
     fill_window(mVWindow, RDSP_WINDOW_HANNING_FLAT_TOP, mBlockSize, mOverlapSize);
+    mVWindowedInput.resize(mBlockSize);
 
     //split window into analysis and synthesis. Both are the sqrt() of original
     //window
@@ -386,10 +390,8 @@ size_t DPFrequency::processSamples(const float *in, float *out, size_t samples)
        }
 
        //**separate into channels
-       for (size_t k = 0; k < samples; k += channelCount) {
-           for (int ch = 0; ch < channelCount; ch++) {
-               mChannelBuffers[ch].cBInput.write(*pIn++);
-           }
+       for (int ch = 0; ch < channelCount; ch++) {
+           mChannelBuffers[ch].cBInput.write(pIn + ch, samples / channelCount, channelCount);
        }
 
        //**process all channelBuffers
@@ -413,10 +415,8 @@ size_t DPFrequency::processSamples(const float *in, float *out, size_t samples)
        }
 
        //**interleave channels
-       for (size_t k = 0; k < available; k++) {
-           for (int ch = 0; ch < channelCount; ch++) {
-               *pOut++ = mChannelBuffers[ch].cBOutput.read();
-           }
+       for (int ch = 0; ch < channelCount; ch++) {
+           mChannelBuffers[ch].cBOutput.read(pOut + ch, available, channelCount);
        }
 
        return samples;
@@ -442,9 +442,7 @@ size_t DPFrequency::processChannelBuffers(CBufferVector &channelBuffers) {
                     pCb->input.begin());
 
             //read new available data
-            for (unsigned int k = 0; k < processFrames; k++) {
-                pCb->input[mOverlapSize + k] = pCb->cBInput.read();
-            }
+            pCb->cBInput.read(&pCb->input[mOverlapSize], processFrames);
             //first stages: fft, preEq, mbc, postEq and start of Limiter
             processedSamples += processFirstStages(*pCb);
         }
@@ -466,9 +464,7 @@ size_t DPFrequency::processChannelBuffers(CBufferVector &channelBuffers) {
             }
 
             //output data
-            for (unsigned int k = 0; k < processFrames; k++) {
-                pCb->cBOutput.write(pCb->output[k]);
-            }
+            pCb->cBOutput.write(&pCb->output[0], processFrames);
         }
         available -= processFrames;
     }
@@ -480,37 +476,36 @@ size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
     Eigen::Map<Eigen::VectorXf> eWindow(&mVWindow[0], mVWindow.size());
     Eigen::Map<Eigen::VectorXf> eInput(&cb.input[0], cb.input.size());
 
-    Eigen::VectorXf eWin = eInput.cwiseProduct(eWindow); //apply window
+    mVWindowedInput = eInput.cwiseProduct(eWindow); //apply window
 
     //##fft
     //Note: we are using eigen with the default scaling, which ensures that
     //  IFFT( FFT(x) ) = x.
     // TODO: optimize by using the noscale option, and compensate with dB scale offsets
-    mFftServer.fwd(cb.complexTemp, eWin);
+    mFftServer.fwd(cb.complexTemp, mVWindowedInput);
 
-    size_t cSize = cb.complexTemp.size();
-    size_t maxBin = std::min(cSize/2, mHalfFFTSize);
+    //half spectrum, up to but not including the Nyquist bin
+    size_t maxBin = mHalfFFTSize - 1;
+    auto eSpectrum = cb.complexTemp.head(maxBin).array();
 
     //== EqPre (always runs)
-    for (size_t k = 0; k < maxBin; k++) {
-        cb.complexTemp[k] *= cb.mPreEqFactorVector[k];
-    }
+    eSpectrum *= Eigen::Map<Eigen::ArrayXf>(&cb.mPreEqFactorVector[0], maxBin);
 
     //== MBC
     if (cb.mMbcInUse && cb.mMbcEnabled) {
         for (size_t band = 0; band < cb.mMbcBands.size(); band++) {
             ChannelBuffer::MbcBandParams *pMbcBandParams = &cb.mMbcBands[band];
-            float fEnergySum = 0;
+            const size_t bandBins = pMbcBandParams->binStop >= pMbcBandParams->binStart ?
+                    pMbcBandParams->binStop - pMbcBandParams->binStart + 1 : 0;
+            auto eBand = cb.complexTemp.segment(pMbcBandParams->binStart, bandBins);
 
             //apply pre gain.
             float preGainFactor = dBtoLinear(pMbcBandParams->gainPreDb);
             float preGainSquared = preGainFactor * preGainFactor;
 
-            for (size_t k = pMbcBandParams->binStart; k <= pMbcBandParams->binStop; k++) {
-                fEnergySum += std::norm(cb.complexTemp[k]) * preGainSquared; //mag squared
-            }
+            float fEnergySum = eBand.squaredNorm() * preGainSquared; //mag squared
 
-            //Eigen FFT is full spectrum, even if the source was real data.
+            //Eigen FFT only computes the half spectrum of the real data (HalfSpectrum flag).
             // Each half spectrum has half the energy. This is taken into account with the * 2
             // factor in the energy computations.
             // energy = sqrt(sum_components_squared) number_points
@@ -567,9 +562,7 @@ size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
             newFactor *= dBtoLinear(pMbcBandParams->gainPostDb);
 
             //apply to this band
-            for (size_t k = pMbcBandParams->binStart; k <= pMbcBandParams->binStop; k++) {
-                cb.complexTemp[k] *= newFactor;
-            }
+            eBand *= newFactor;
 
         } //end per band process
 
@@ -577,17 +570,12 @@ size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
 
     //== EqPost
     if (cb.mPostEqInUse && cb.mPostEqEnabled) {
-        for (size_t k = 0; k < maxBin; k++) {
-            cb.complexTemp[k] *= cb.mPostEqFactorVector[k];
-        }
+        eSpectrum *= Eigen::Map<Eigen::ArrayXf>(&cb.mPostEqFactorVector[0], maxBin);
     }
 
     //== Limiter. First Pass
     if (cb.mLimiterInUse && cb.mLimiterEnabled) {
-        float fEnergySum = 0;
-        for (size_t k = 0; k < maxBin; k++) {
-            fEnergySum += std::norm(cb.complexTemp[k]);
-        }
+        float fEnergySum = eSpectrum.abs2().sum();
 
         //see explanation above for energy computation logic
         fEnergySum = sqrt(fEnergySum * 2) / (mBlockSize * mWindowRms);
@@ -656,11 +644,8 @@ size_t DPFrequency::processLastStages(ChannelBuffer &cb) {
 
     //apply to all if != 1.0
     if (!compareEquality(outputGainFactor, 1.0f)) {
-        size_t cSize = cb.complexTemp.size();
-        size_t maxBin = std::min(cSize/2, mHalfFFTSize);
-        for (size_t k = 0; k < maxBin; k++) {
-            cb.complexTemp[k] *= outputGainFactor;
-        }
+        size_t maxBin = mHalfFFTSize - 1;
+        cb.complexTemp.head(maxBin) *= outputGainFactor;
     }
 
     //##ifft directly to output.
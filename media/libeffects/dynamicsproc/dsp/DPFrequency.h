@@ -151,6 +151,7 @@ private:
 
     //dsp
     FloatVec mVWindow;  //window class.
+    Eigen::VectorXf mVWindowedInput; //temp vector for the windowed input, reused by all channels
     float mWindowRms;
     Eigen::FFT<float> mFftServer;
 };
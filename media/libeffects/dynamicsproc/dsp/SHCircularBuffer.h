@@ -17,6 +17,7 @@
 #ifndef SHCIRCULARBUFFER_H
 #define SHCIRCULARBUFFER_H
 
+#include <algorithm>
 #include <log/log.h>
 #include <vector>
 
@@ -60,6 +61,53 @@ public:
         }
         return value;
     }
+    //writes count values, taken every stride values from data.
+    void write(const T *data, size_t count, size_t stride = 1) {
+        if (count > availableToWrite()) {
+            ALOGE("Error: SHCircularBuffer no space to write %zu. allocated size %zu ",
+                    count, getSize());
+            count = availableToWrite();
+        }
+        mReadAvailable += count;
+        while (count > 0) {
+            const size_t chunk = std::min(count, getSize() - mWriteIndex);
+            T *dst = &mBuffer[mWriteIndex];
+            for (size_t k = 0; k < chunk; k++) {
+                dst[k] = data[k * stride];
+            }
+            data += chunk * stride;
+            count -= chunk;
+            mWriteIndex += chunk;
+            if (mWriteIndex >= getSize()) {
+                mWriteIndex = 0;
+            }
+        }
+    }
+    //reads count values, stored every stride values in data.
+    void read(T *data, size_t count, size_t stride = 1) {
+        if (count > availableToRead()) {
+            ALOGW("Warning: SHCircularBuffer no data available to read %zu. "
+                    "Default values returned", count);
+            for (size_t k = availableToRead(); k < count; k++) {
+                data[k * stride] = T();
+            }
+            count = availableToRead();
+        }
+        mReadAvailable -= count;
+        while (count > 0) {
+            const size_t chunk = std::min(count, getSize() - mReadIndex);
+            const T *src = &mBuffer[mReadIndex];
+            for (size_t k = 0; k < chunk; k++) {
+                data[k * stride] = src[k];
+            }
+            data += chunk * stride;
+            count -= chunk;
+            mReadIndex += chunk;
+            if (mReadIndex >= getSize()) {
+                mReadIndex = 0;
+            }
+        }
+    }
     inline size_t availableToRead() const {
         return mReadAvailable;
     }
@@ -20,6 +20,7 @@
 
 #include <assert.h>
 
+#include <algorithm>
 #include <cmath>
 
 #include "Processors.h"
@@ -60,18 +61,19 @@ Ramp::Ramp(size_t channelCount) : mChannelCount(channelCount) {}
 
 void Ramp::process(float *out, const float *in, size_t frameCount) {
     size_t i = 0;
+    const size_t sampleCount = frameCount * mChannelCount;
 #if USE_NEON
-    size_t sampleCount = frameCount * mChannelCount;
-    float32x2_t allZero = vdup_n_f32(0.0f);
-    while (i + 1 < sampleCount) {
-        vst1_f32(out, vmax_f32(vld1_f32(in), allZero));
-        in += 2;
-        out += 2;
-        i += 2;
+    float32x4_t allZero = vdupq_n_f32(0.0f);
+    while (i + 3 < sampleCount) {
+        vst1q_f32(out, vmaxq_f32(vld1q_f32(in), allZero));
+        in += 4;
+        out += 4;
+        i += 4;
     }
 #endif // USE_NEON
-    for (; i < frameCount * mChannelCount; ++i) {
-        *out = *in >= 0.0f ? *in : 0.0f;
+    // Branchless, so that it is vectorized by the compiler when NEON is not available.
+    for (; i < sampleCount; ++i) {
+        *out = std::max(*in, 0.0f);
         out++;
         in++;
     }
@@ -97,11 +99,12 @@ void SlowEnvelope::process(float* out, const float* in, size_t frameCount) {
         mLpfInBuffer.resize(sampleCount);
     }
     for (size_t i = 0; i < sampleCount; ++i) {
-        mLpfInBuffer[i] = fabs(in[i]);
+        mLpfInBuffer[i] = std::fabs(in[i]);
     }
     mLpf->process(mLpfOutBuffer.data(), mLpfInBuffer.data(), frameCount);
+    // Single precision pow, the double precision one is most of the processing time.
     for (size_t i = 0; i < sampleCount; ++i) {
-        out[i] = in[i] * pow(mLpfOutBuffer[i] + mEnvOffset, mNormalizationPower);
+        out[i] = in[i] * powf(mLpfOutBuffer[i] + mEnvOffset, mNormalizationPower);
     }
 }
 
@@ -142,7 +145,7 @@ void Distortion::process(float *out, const float *in, size_t frameCount) {
     mLpf->process(out, mLpfInBuffer.data(), frameCount);  // Reduce 3*F components.
     for (size_t i = 0; i < sampleCount; ++i) {
         const float x = out[i];
-        out[i] = mOutputGain * x / (1.0f + fabs(x));  // Soft limiter.
+        out[i] = mOutputGain * x / (1.0f + std::fabs(x));  // Soft limiter.
     }
 }
 
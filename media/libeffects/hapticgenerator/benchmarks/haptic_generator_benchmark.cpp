@@ -0,0 +1,141 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "Processors.h"
+
+// Runs the non-filter processors of the haptic generator with the parameters the effect uses,
+// on 10 ms blocks. Each benchmark first checks the processor against a double precision
+// reference, and fails if the relative error is above kMaxRelativeError.
+
+using namespace android::audio_effect::haptic_generator;
+
+namespace {
+
+constexpr float kSampleRate = 48000;
+constexpr size_t kFrameCount = 480;
+constexpr double kMaxRelativeError = 1e-4;
+
+std::vector<float> makeInput(size_t sampleCount) {
+    std::minstd_rand gen(sampleCount);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    std::vector<float> in(sampleCount);
+    for (auto& i : in) {
+        i = dis(gen);
+    }
+    return in;
+}
+
+// Returns the largest difference between |out| and |expected|, relative to the peak of |expected|.
+double maxRelativeError(const std::vector<float>& out, const std::vector<double>& expected) {
+    double error = 0;
+    double peak = 0;
+    for (size_t i = 0; i < out.size(); ++i) {
+        error = std::max(error, std::abs(out[i] - expected[i]));
+        peak = std::max(peak, std::abs(expected[i]));
+    }
+    return peak > 0 ? error / peak : error;
+}
+
+template <typename Processor>
+void runProcessor(benchmark::State& state, Processor& processor, const std::vector<float>& in,
+                  const std::vector<double>& expected) {
+    std::vector<float> out(in.size());
+    processor.process(out.data(), in.data(), kFrameCount);
+    const double error = maxRelativeError(out, expected);
+    state.counters["max_relative_error"] = error;
+    if (error > kMaxRelativeError) {
+        state.SkipWithError("output differs from the reference");
+        return;
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(in.data());
+        processor.process(out.data(), in.data(), kFrameCount);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kFrameCount);
+}
+
+void BM_Ramp(benchmark::State& state) {
+    const size_t channelCount = state.range(0);
+    const std::vector<float> in = makeInput(kFrameCount * channelCount);
+    std::vector<double> expected(in.size());
+    for (size_t i = 0; i < in.size(); ++i) {
+        expected[i] = std::max<double>(in[i], 0);
+    }
+
+    Ramp ramp(channelCount);
+    runProcessor(state, ramp, in, expected);
+}
+
+void BM_SlowEnvelope(benchmark::State& state) {
+    constexpr float kCornerFrequency = 5.0f;
+    constexpr float kNormalizationPower = -0.8f;
+    constexpr float kEnvOffset = 0.01f;
+    const size_t channelCount = state.range(0);
+    const std::vector<float> in = makeInput(kFrameCount * channelCount);
+    std::vector<float> envelope(in.size());
+    std::transform(in.begin(), in.end(), envelope.begin(), [](float x) { return std::fabs(x); });
+    createLPF(kCornerFrequency, kSampleRate, channelCount)
+            ->process(envelope.data(), envelope.data(), kFrameCount);
+    std::vector<double> expected(in.size());
+    for (size_t i = 0; i < in.size(); ++i) {
+        expected[i] = in[i] * std::pow((double)envelope[i] + kEnvOffset, kNormalizationPower);
+    }
+
+    SlowEnvelope slowEnvelope(kCornerFrequency, kSampleRate, kNormalizationPower, kEnvOffset,
+                              channelCount);
+    runProcessor(state, slowEnvelope, in, expected);
+}
+
+void BM_Distortion(benchmark::State& state) {
+    constexpr float kCornerFrequency = 300.0f;
+    constexpr float kInputGain = 0.3f;
+    constexpr float kCubeThreshold = 0.1f;
+    constexpr float kOutputGain = 1.5f;
+    const size_t channelCount = state.range(0);
+    const std::vector<float> in = makeInput(kFrameCount * channelCount);
+    std::vector<float> cored(in.size());
+    for (size_t i = 0; i < in.size(); ++i) {
+        const double x = kInputGain * in[i];
+        cored[i] = x * x * x / (kCubeThreshold + x * x);
+    }
+    createLPF2(kCornerFrequency, kSampleRate, channelCount)
+            ->process(cored.data(), cored.data(), kFrameCount);
+    std::vector<double> expected(in.size());
+    for (size_t i = 0; i < in.size(); ++i) {
+        expected[i] = kOutputGain * (double)cored[i] / (1.0 + std::abs((double)cored[i]));
+    }
+
+    Distortion distortion(kCornerFrequency, kSampleRate, kInputGain, kCubeThreshold, kOutputGain,
+                          channelCount);
+    runProcessor(state, distortion, in, expected);
+}
+
+}  // namespace
+
+BENCHMARK(BM_Ramp)->Arg(1)->Arg(2);
+BENCHMARK(BM_SlowEnvelope)->Arg(1)->Arg(2);
+BENCHMARK(BM_Distortion)->Arg(1)->Arg(2);
+
+BENCHMARK_MAIN();
@@ -76,14 +76,8 @@ IEffect::Status LoudnessEnhancerContext::process(float* in, float* out, int samp
     float leftSample, rightSample;
 
     if (mCompressor != nullptr) {
-        for (int inIdx = 0; inIdx < samples; inIdx += 2) {
-            // makeup gain is applied on the input of the compressor
-            leftSample = inputAmp * in[inIdx];
-            rightSample = inputAmp * in[inIdx + 1];
-            mCompressor->Compress(&leftSample, &rightSample);
-            in[inIdx] = leftSample * inverseScale;
-            in[inIdx + 1] = rightSample * inverseScale;
-        }
+        // makeup gain is applied on the input of the compressor
+        mCompressor->Compress(in, samples / 2, inputAmp, inverseScale);
     } else {
         for (int inIdx = 0; inIdx < samples; inIdx += 2) {
             leftSample = inputAmp * in[inIdx];
@@ -134,5 +134,39 @@ void AdaptiveDynamicRangeCompression::Compress(float *x1, float *x2) {
   }
 }
 
+void AdaptiveDynamicRangeCompression::Compress(float *x, size_t frame_count,
+                                               float input_gain,
+                                               float output_gain) {
+  float state = state_;
+  float compressor_gain = compressor_gain_;
+  for (size_t i = 0; i < frame_count; ++i, x += 2) {
+    const float x1 = input_gain * x[0];
+    const float x2 = input_gain * x[1];
+    // Taking the maximum amplitude of both channels
+    const float max_abs_x = std::max(std::fabs(x1),
+      std::max(std::fabs(x2), kMinLogAbsValue));
+    const float max_abs_x_dB = math::fast_log(max_abs_x);
+    // Subtract Threshold from log-encoded input to get the amount of overshoot
+    const float overshoot = max_abs_x_dB - knee_threshold_;
+    // Hard half-wave rectifier
+    const float rect = std::max(overshoot, 0.0f);
+    // Multiply rectified overshoot with slope
+    const float cv = rect * slope_;
+    const float prev_state = state;
+    if (cv <= state) {
+      state = alpha_attack_ * state + (1.0f - alpha_attack_) * cv;
+    } else {
+      state = alpha_release_ * state + (1.0f - alpha_release_) * cv;
+    }
+    compressor_gain *= expf(state - prev_state);
+    x[0] = std::min(std::max(x1 * compressor_gain, -kFixedPointLimit),
+                    kFixedPointLimit) * output_gain;
+    x[1] = std::min(std::max(x2 * compressor_gain, -kFixedPointLimit),
+                    kFixedPointLimit) * output_gain;
+  }
+  state_ = state;
+  compressor_gain_ = compressor_gain;
+}
+
 }  // namespace le_fx
 
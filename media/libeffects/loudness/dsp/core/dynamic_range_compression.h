@@ -58,6 +58,14 @@ class AdaptiveDynamicRangeCompression {
   // Stereo channel version of the compressor
   void Compress(float *x1, float *x2);
 
+  // Stereo channel version of the compressor for a block of `frame_count`
+  // interleaved frames, processed in place. Each sample is multiplied by
+  // `input_gain` before compression and by `output_gain` after. The result is
+  // the same as calling Compress(float *, float *) frame by frame, but the
+  // detector state stays in registers for the whole block.
+  void Compress(float *x, size_t frame_count, float input_gain,
+                float output_gain);
+
   // This version is slower than Compress(.) but faster than CompressSlow(.)
   float CompressNormalSpeed(float x);
 
@@ -178,7 +178,6 @@ void LVEQNB_SetCoefficients(LVEQNB_Instance_t* pInstance) {
     LVM_UINT16 i;                    /* Filter band index */
     LVEQNB_BiquadType_en BiquadType; /* Filter biquad type */
 
-    pInstance->gain.resize(pInstance->Params.NBands);
     /*
      * Set the coefficients for each band by the init function
      */
@@ -196,12 +195,14 @@ void LVEQNB_SetCoefficients(LVEQNB_Instance_t* pInstance) {
                 LVEQNB_SinglePrecCoefs((LVM_UINT16)pInstance->Params.SampleRate,
                                        &pInstance->pBandDefinitions[i], &Coefficients);
                 /*
-                 * Set the coefficients
+                 * Set the coefficients. The band adds G times the band pass filtered signal
+                 * H(z) = A0 * (1 - z^-2) / (1 - B1 * z^-1 - B2 * z^-2) to its input, which is
+                 * the single biquad 1 + G * H(z).
                  */
-                pInstance->gain[i] = Coefficients.G;
+                const LVM_FLOAT gainA0 = Coefficients.G * Coefficients.A0;
                 std::array<LVM_FLOAT, android::audio_utils::kBiquadNumCoefs> coefs = {
-                        Coefficients.A0, 0.0, -(Coefficients.A0), -(Coefficients.B1),
-                        -(Coefficients.B2)};
+                        1.0f + gainA0, -(Coefficients.B1), -(Coefficients.B2) - gainA0,
+                        -(Coefficients.B1), -(Coefficients.B2)};
                 pInstance->eqBiquad[i]
                         .setCoefficients<
                                 std::array<LVM_FLOAT, android::audio_utils::kBiquadNumCoefs>>(
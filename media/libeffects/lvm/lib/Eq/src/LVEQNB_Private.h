@@ -71,8 +71,7 @@ typedef struct {
     LVM_FLOAT* pFastTemporary; /* Fast temporary data base address */
 
     std::vector<android::audio_utils::BiquadFilter<LVM_FLOAT>>
-            eqBiquad;            /* Biquad filter instances */
-    std::vector<LVM_FLOAT> gain; /* Gain values for all bands*/
+            eqBiquad; /* Biquad filter instances, including the band gain */
 
     /* Filter definitions and call back */
     LVM_UINT16 NBands;                  /* Number of bands */
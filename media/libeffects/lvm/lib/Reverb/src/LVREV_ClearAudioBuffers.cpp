@@ -60,8 +60,15 @@ LVREV_ReturnStatus_en LVREV_ClearAudioBuffers(LVREV_Handle_t hInstance) {
     pLVREV_Private->pRevLPFBiquad->clear();
     for (size_t i = 0; i < pLVREV_Private->InstanceParams.NumDelays; i++) {
         pLVREV_Private->revLPFBiquad[i]->clear();
-        memset(pLVREV_Private->pDelay_T[i], 0, LVREV_MAX_T_DELAY[i] *
-                sizeof(pLVREV_Private->pDelay_T[i][0]));
+        memset(pLVREV_Private->pDelayBuffer_T[i], 0,
+               LVREV_DELAY_BUFFER_FACTOR * LVREV_MAX_T_DELAY[i] *
+                       sizeof(pLVREV_Private->pDelayBuffer_T[i][0]));
+        /* Move the delay line and its taps back to the start of the buffer */
+        LVM_INT32 Offset = (LVM_INT32)(pLVREV_Private->pDelay_T[i] -
+                                       pLVREV_Private->pDelayBuffer_T[i]);
+        pLVREV_Private->pDelay_T[i] -= Offset;
+        pLVREV_Private->pOffsetA[i] -= Offset;
+        pLVREV_Private->pOffsetB[i] -= Offset;
     }
     return LVREV_SUCCESS;
 }
@@ -95,7 +95,9 @@ LVREV_ReturnStatus_en LVREV_GetInstanceHandle(LVREV_Handle_t* phInstance,
      * Set the data, coefficient and temporary memory pointers
      */
     for (size_t i = 0; i < pInstanceParams->NumDelays; i++) {
-        pLVREV_Private->pDelay_T[i] = (LVM_FLOAT*)calloc(LVREV_MAX_T_DELAY[i], sizeof(LVM_FLOAT));
+        pLVREV_Private->pDelayBuffer_T[i] = (LVM_FLOAT*)calloc(
+                LVREV_DELAY_BUFFER_FACTOR * LVREV_MAX_T_DELAY[i], sizeof(LVM_FLOAT));
+        pLVREV_Private->pDelay_T[i] = pLVREV_Private->pDelayBuffer_T[i];
         /* Scratch for each delay line output */
         pLVREV_Private->pScratchDelayLine[i] = (LVM_FLOAT*)calloc(MaxBlockSize, sizeof(LVM_FLOAT));
     }
@@ -246,8 +248,9 @@ LVREV_ReturnStatus_en LVREV_FreeInstance(LVREV_Handle_t hInstance) {
     LVREV_Instance_st* pLVREV_Private = (LVREV_Instance_st*)hInstance;
 
     for (size_t i = 0; i < pLVREV_Private->InstanceParams.NumDelays; i++) {
-        if (pLVREV_Private->pDelay_T[i]) {
-            free(pLVREV_Private->pDelay_T[i]);
+        if (pLVREV_Private->pDelayBuffer_T[i]) {
+            free(pLVREV_Private->pDelayBuffer_T[i]);
+            pLVREV_Private->pDelayBuffer_T[i] = LVM_NULL;
             pLVREV_Private->pDelay_T[i] = LVM_NULL;
         }
         if (pLVREV_Private->pScratchDelayLine[i]) {
@@ -78,6 +78,10 @@
 #define LVREV_MAX_AP0_DELAY 15360
 
 #define LVREV_BYPASSMIXER_TC 1000  /* Bypass mixer time constant*/
+
+/* The delay buffers hold this many delay lines, so that the delay line can slide along the
+   buffer by one block at a time and is only moved back to the start once it reaches the end */
+#define LVREV_DELAY_BUFFER_FACTOR 2
 #define LVREV_ALLPASS_TC 1000      /* All-pass filter time constant */
 #define LVREV_ALLPASS_TAP_TC 10000 /* All-pass filter dely tap change */
 #define LVREV_FEEDBACKMIXER_TC 100 /* Feedback mixer time constant*/
@@ -137,7 +141,9 @@ typedef struct {
 
     /* All-Pass Filter */
     LVM_INT32 T[LVREV_DELAYLINES_4];                          /* Maximum delay size of buffer */
-    LVM_FLOAT* pDelay_T[LVREV_DELAYLINES_4];                  /* Pointer to delay buffers */
+    LVM_FLOAT* pDelayBuffer_T[LVREV_DELAYLINES_4];            /* Pointer to delay buffers */
+    LVM_FLOAT* pDelay_T[LVREV_DELAYLINES_4];                  /* Pointer to delay line start \
+                                                                 in the delay buffer */
     LVM_INT32 Delay_AP[LVREV_DELAYLINES_4];                   /* Offset to AP delay buffer start */
     LVM_INT16 AB_Selection;                     /* Smooth from tap A to B when 1 \
                                                    otherwise B to A */
@@ -218,6 +218,20 @@ void ReverbBlock(LVM_FLOAT* pInput, LVM_FLOAT* pOutput, LVREV_Instance_st* pPriv
     for (j = 0; j < NumberOfDelayLines; j++) {
         pDelayLine = pPrivate->pScratchDelayLine[j];
 
+        /*
+         * Move the delay line back to the start of its buffer when there is no room left
+         * to slide it by this block
+         */
+        LVM_INT32 Offset = (LVM_INT32)(pPrivate->pDelay_T[j] - pPrivate->pDelayBuffer_T[j]);
+        if (Offset + pPrivate->T[j] + NumSamples >
+            LVREV_DELAY_BUFFER_FACTOR * LVREV_MAX_T_DELAY[j]) {
+            Copy_Float(pPrivate->pDelay_T[j], pPrivate->pDelayBuffer_T[j],
+                       (LVM_INT16)pPrivate->T[j]); /* 32-bit data */
+            pPrivate->pDelay_T[j] -= Offset;
+            pPrivate->pOffsetA[j] -= Offset;
+            pPrivate->pOffsetB[j] -= Offset;
+        }
+
         /*
          * All-pass filter with pop and click suppression
          */
@@ -225,9 +239,10 @@ void ReverbBlock(LVM_FLOAT* pInput, LVM_FLOAT* pOutput, LVREV_Instance_st* pPriv
         MixSoft_2St_D32C31_SAT(&pPrivate->Mixer_APTaps[j], pPrivate->pOffsetA[j],
                                pPrivate->pOffsetB[j], pDelayLine, (LVM_INT16)NumSamples);
         /* Re-align the all pass filter delay buffer and copying the fixed delay data \
-           to the AP delay in the process */
-        Copy_Float(&pPrivate->pDelay_T[j][NumSamples], pPrivate->pDelay_T[j],
-                   (LVM_INT16)(pPrivate->T[j] - NumSamples)); /* 32-bit data */
+           to the AP delay in the process, by sliding the delay line and its taps along */
+        pPrivate->pDelay_T[j] += NumSamples;
+        pPrivate->pOffsetA[j] += NumSamples;
+        pPrivate->pOffsetB[j] += NumSamples;
         /* Apply the smoothed feedback and save to fixed delay input (currently empty) */
         MixSoft_1St_D32C31_WRA(&pPrivate->Mixer_SGFeedback[j], pDelayLine,
                                &pPrivate->pDelay_T[j][pPrivate->T[j] - NumSamples],
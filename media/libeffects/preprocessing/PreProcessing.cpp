@@ -16,6 +16,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <string>
 #define LOG_TAG "PreProcessing"
 //#define LOG_NDEBUG 0
 #include <audio_effects/effect_aec.h>
@@ -992,6 +993,31 @@ void Session_SetProcEnabled(preproc_session_t* session, uint32_t procId, bool en
 static int sInitStatus = 1;
 static preproc_session_t sSessions[PREPROC_NUM_SESSIONS];
 
+// Returns the first session on the same input stream running the same pre processors with the
+// same configuration as |session|, if it comes before |session|, or NULL.
+// When effects are processed in place, as the framework does for a capture stream, all the
+// sessions on a stream process the same buffer and the first one can process it for all of them.
+preproc_session_t* Session_GetLeader(preproc_session_t* session) {
+    std::string config;
+    for (preproc_session_t* other = sSessions; other < session; other++) {
+        if (other->id == 0 || other->io != session->io ||
+            other->state < PREPROC_SESSION_STATE_CONFIG ||
+            other->enabledMsk != session->enabledMsk ||
+            other->samplingRate != session->samplingRate ||
+            other->inChannelCount != session->inChannelCount ||
+            other->outChannelCount != session->outChannelCount) {
+            continue;
+        }
+        if (config.empty()) {
+            config = session->config.ToString();
+        }
+        if (other->config.ToString() == config) {
+            return other;
+        }
+    }
+    return NULL;
+}
+
 preproc_session_t* PreProc_GetSession(int32_t procId, int32_t sessionId, int32_t ioId) {
     size_t i;
     for (i = 0; i < PREPROC_NUM_SESSIONS; i++) {
@@ -1075,6 +1101,10 @@ int PreProcessingFx_Process(effect_handle_t self, audio_buffer_t* inBuffer,
     //         inBuffer->frameCount, session->enabledMsk, session->processedMsk);
     if ((session->processedMsk & session->enabledMsk) == session->enabledMsk) {
         effect->session->processedMsk = 0;
+        if (inBuffer->raw == outBuffer->raw && Session_GetLeader(session) != NULL) {
+            // the buffer is processed by the leader session
+            return 0;
+        }
         if (int status = effect->session->apm->ProcessStream(
                     (const int16_t* const)inBuffer->s16,
                     (const webrtc::StreamConfig)effect->session->inputConfig,
@@ -125,6 +125,7 @@
 
 #include <audio_effects/effect_aec.h>
 #include <audio_effects/effect_agc.h>
+#include <algorithm>
 #include <array>
 #include <climits>
 #include <cstdlib>
@@ -319,4 +320,105 @@ static void preprocessingArgs(benchmark::internal::Benchmark* b) {
 
 BENCHMARK(BM_PREPROCESSING)->Apply(preprocessingArgs);
 
+// Two sessions with the same effect on the same input stream, processed in place one after
+// the other like the framework does.
+static void BM_PREPROCESSING_SHARED(benchmark::State& state) {
+    constexpr size_t kNumSessions = 2;
+    const size_t chMask = kChMasks[state.range(0) - 1];
+    const size_t channelCount = audio_channel_count_from_in_mask(chMask);
+
+    PreProcId effectType = (PreProcId)state.range(1);
+
+    int32_t ioId = 1;
+    std::array<effect_handle_t, kNumSessions> effectHandles{};
+    effect_config_t config{};
+    config.inputCfg.samplingRate = config.outputCfg.samplingRate = kSampleRate;
+    config.inputCfg.channels = config.outputCfg.channels = chMask;
+    config.inputCfg.format = config.outputCfg.format = AUDIO_FORMAT_PCM_16_BIT;
+
+    for (size_t i = 0; i < kNumSessions; i++) {
+        if (int status = preProcCreateEffect(&effectHandles[i], state.range(1), &config,
+                                             i + 1 /* sessionId */, ioId);
+            status != 0) {
+            ALOGE("Create effect call returned error %i", status);
+            return;
+        }
+        int reply = 0;
+        uint32_t replySize = sizeof(reply);
+        if (int status = (*effectHandles[i])
+                                 ->command(effectHandles[i], EFFECT_CMD_ENABLE, 0, nullptr,
+                                           &replySize, &reply);
+            status != 0) {
+            ALOGE("Command enable call returned error %d\n", reply);
+            return;
+        }
+    }
+
+    // Initialize input buffer with deterministic pseudo-random values
+    const int frameLength = (int)(kSampleRate * kTenMilliSecVal);
+    std::minstd_rand gen(chMask);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    std::vector<short> in(frameLength * channelCount);
+    for (auto& i : in) {
+        i = preProcGetShortVal(dis(gen));
+    }
+    std::vector<short> farIn(frameLength * channelCount);
+    for (auto& i : farIn) {
+        i = preProcGetShortVal(dis(gen));
+    }
+    std::vector<short> buffer(frameLength * channelCount);
+    std::vector<short> farOut(frameLength * channelCount);
+
+    // Run the test
+    for (auto _ : state) {
+        std::copy(in.begin(), in.end(), buffer.begin());
+        benchmark::DoNotOptimize(buffer.data());
+        benchmark::DoNotOptimize(farIn.data());
+
+        audio_buffer_t ioBuffer = {.frameCount = (size_t)frameLength, .s16 = buffer.data()};
+        audio_buffer_t farInBuffer = {.frameCount = (size_t)frameLength, .s16 = farIn.data()};
+        audio_buffer_t farOutBuffer = {.frameCount = (size_t)frameLength, .s16 = farOut.data()};
+
+        for (effect_handle_t effectHandle : effectHandles) {
+            if (PREPROC_AEC == effectType) {
+                if (int status = preProcSetConfigParam(effectHandle, AEC_PARAM_ECHO_DELAY,
+                                                       kStreamDelayMs);
+                    status != 0) {
+                    ALOGE("preProcSetConfigParam returned Error %d\n", status);
+                    return;
+                }
+            }
+            if (int status = (*effectHandle)->process(effectHandle, &ioBuffer, &ioBuffer);
+                status != 0) {
+                ALOGE("\nError: Process i = %d returned with error %d\n", (int)state.range(1),
+                      status);
+                return;
+            }
+            if (PREPROC_AEC == effectType) {
+                if (int status = (*effectHandle)
+                                         ->process_reverse(effectHandle, &farInBuffer,
+                                                           &farOutBuffer);
+                    status != 0) {
+                    ALOGE("\nError: Process reverse i = %d returned with error %d\n",
+                          (int)state.range(1), status);
+                    return;
+                }
+            }
+        }
+    }
+    benchmark::ClobberMemory();
+
+    state.SetComplexityN(state.range(0));
+
+    for (effect_handle_t effectHandle : effectHandles) {
+        if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle);
+            status != 0) {
+            ALOGE("release_effect returned an error = %d\n", status);
+            return;
+        }
+    }
+}
+
+BENCHMARK(BM_PREPROCESSING_SHARED)->Apply(preprocessingArgs);
+
 BENCHMARK_MAIN();
@@ -15,6 +15,7 @@
  */
 
 #include <array>
+#include <cstring>
 #include <dlfcn.h>
 #include <random>
 #include <vector>
@@ -22,6 +23,7 @@
 #include <benchmark/benchmark.h>
 #include <hardware/audio_effect.h>
 #include <log/log.h>
+#include <system/audio_effects/effect_spatializer.h>
 
 audio_effect_library_t AUDIO_EFFECT_LIBRARY_INFO_SYM = [] {
     audio_effect_library_t symbol{};
@@ -64,6 +66,30 @@ constexpr effect_uuid_t kEffectUuid = {
 constexpr float kMinAmplitude = -1.0f;
 constexpr float kMaxAmplitude = 1.0f;
 
+// media::audio::common::HeadTracking::Mode::RELATIVE_WORLD
+constexpr uint8_t kHeadTrackingModeRelativeWorld = 2;
+
+template <typename T>
+int setParameter(effect_handle_t effectHandle, uint32_t type, const std::vector<T>& values) {
+    uint32_t cmd[sizeof(effect_param_t) / sizeof(uint32_t) + 1 + values.size()];
+    effect_param_t* p = (effect_param_t*)cmd;
+    p->psize = sizeof(uint32_t);
+    p->vsize = sizeof(T) * values.size();
+    *(uint32_t*)p->data = type;
+    memcpy((uint32_t*)p->data + 1, values.data(), sizeof(T) * values.size());
+
+    int reply = 0;
+    uint32_t replySize = sizeof(reply);
+    if (int status = (*effectHandle)
+                             ->command(effectHandle, EFFECT_CMD_SET_PARAM,
+                                       sizeof(effect_param_t) + p->psize + p->vsize, p,
+                                       &replySize, &reply);
+        status != 0) {
+        return status;
+    }
+    return reply;
+}
+
 /*******************************************************************
  * A test result running on Pixel 5 for comparison.
  * The first parameter indicates the sample rate.
@@ -84,7 +110,9 @@ constexpr float kMaxAmplitude = 1.0f;
  * BM_SPATIALIZER/2/2    4267814 ns      4259567 ns          155
  *******************************************************************/
 
-static void BM_SPATIALIZER(benchmark::State& state) {
+// With headUpdate, a new head pose is set before each process call, as the
+// Spatializer does for every head tracking sensor event.
+static void spatializerBenchmark(benchmark::State& state, bool headUpdate) {
     const size_t sampleRate = kSampleRates[state.range(0)];
     const size_t durationMs = kDurations[state.range(1)];
     const size_t frameCount = durationMs * sampleRate / 1000;
@@ -131,12 +159,28 @@ static void BM_SPATIALIZER(benchmark::State& state) {
         return;
     }
 
+    if (headUpdate) {
+        if (int status = setParameter(effectHandle, SPATIALIZER_PARAM_HEADTRACKING_MODE,
+                                      std::vector<uint8_t>{kHeadTrackingModeRelativeWorld});
+            status != 0) {
+            ALOGE("setting the head tracking mode returned an error = %d\n", status);
+            return;
+        }
+    }
+
     // Run the test
     std::vector<float> output(frameCount * outputChannelCount);
+    // translation then rotation vector, rotating the head around the vertical axis
+    std::vector<float> headToStage(6, 0.f);
     for (auto _ : state) {
         benchmark::DoNotOptimize(input.data());
         benchmark::DoNotOptimize(output.data());
 
+        if (headUpdate) {
+            headToStage[4] = headToStage[4] > 1.f ? -1.f : headToStage[4] + 0.01f;
+            setParameter(effectHandle, SPATIALIZER_PARAM_HEAD_TO_STAGE, headToStage);
+        }
+
         audio_buffer_t inBuffer = {.frameCount = frameCount, .f32 = input.data()};
         audio_buffer_t outBuffer = {.frameCount = frameCount, .f32 = output.data()};
         (*effectHandle)->process(effectHandle, &inBuffer, &outBuffer);
@@ -152,6 +196,14 @@ static void BM_SPATIALIZER(benchmark::State& state) {
     }
 }
 
+static void BM_SPATIALIZER(benchmark::State& state) {
+    spatializerBenchmark(state, false /* headUpdate */);
+}
+
+static void BM_SPATIALIZER_HEAD_UPDATE(benchmark::State& state) {
+    spatializerBenchmark(state, true /* headUpdate */);
+}
+
 static void SPATIALIZERArgs(benchmark::internal::Benchmark* b) {
     for (int i = 0; i < kNumSampleRates; i++) {
         for (int j = 0; j < kNumDurations; ++j) {
@@ -161,5 +213,6 @@ static void SPATIALIZERArgs(benchmark::internal::Benchmark* b) {
 }
 
 BENCHMARK(BM_SPATIALIZER)->Apply(SPATIALIZERArgs);
+BENCHMARK(BM_SPATIALIZER_HEAD_UPDATE)->Apply(SPATIALIZERArgs);
 
 BENCHMARK_MAIN();
@@ -25,6 +25,7 @@
 #include <time.h>
 
 #include <algorithm> // max
+#include <atomic>
 #include <new>
 
 #include <log/log.h>
@@ -85,51 +86,66 @@ struct BufferStats {
     float mRmsSquared; // the average square of the samples in a buffer
 };
 
+// The capture buffer and the measurements are a single producer, single consumer ring:
+// process() writes them and publishes mCaptureIdx and mBufferUpdateTimeNs, and the
+// capture and measure commands read them, without a lock, as they can be called from
+// another thread than the one processing.
 struct VisualizerContext {
     const struct effect_interface_s *mItfe;
     effect_config_t mConfig;
-    uint32_t mCaptureIdx;
+    std::atomic<uint32_t> mCaptureIdx;  // written by process() only
     uint32_t mCaptureSize;
     uint32_t mScalingMode;
     uint8_t mState;
     uint32_t mLastCaptureIdx;
     uint32_t mLatency;
-    struct timespec mBufferUpdateTime;
+    std::atomic<int64_t> mBufferUpdateTimeNs;  // CLOCK_MONOTONIC, 0 if not updated
     uint8_t mCaptureBuf[CAPTURE_BUF_SIZE];
     // for measurements
     uint8_t mChannelCount; // to avoid recomputing it every time a buffer is processed
     uint32_t mMeasurementMode;
     uint8_t mMeasurementWindowSizeInBuffers;
     uint8_t mMeasurementBufferIdx;
-    BufferStats mPastMeasurements[MEASUREMENT_WINDOW_MAX_SIZE_IN_BUFFERS];
+    std::atomic<BufferStats> mPastMeasurements[MEASUREMENT_WINDOW_MAX_SIZE_IN_BUFFERS];
 };
 
 //
 //--- Local functions
 //
+int64_t Visualizer_getNowNs() {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) < 0) {
+        return 0;
+    }
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
 uint32_t Visualizer_getDeltaTimeMsFromUpdatedTime(VisualizerContext* pContext) {
     uint32_t deltaMs = 0;
-    if (pContext->mBufferUpdateTime.tv_sec != 0) {
-        struct timespec ts;
-        if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
-            time_t secs = ts.tv_sec - pContext->mBufferUpdateTime.tv_sec;
-            long nsec = ts.tv_nsec - pContext->mBufferUpdateTime.tv_nsec;
-            if (nsec < 0) {
-                --secs;
-                nsec += 1000000000;
-            }
-            deltaMs = secs * 1000 + nsec / 1000000;
+    const int64_t updateTimeNs = pContext->mBufferUpdateTimeNs.load(std::memory_order_relaxed);
+    if (updateTimeNs != 0) {
+        const int64_t nowNs = Visualizer_getNowNs();
+        if (nowNs != 0) {
+            deltaMs = (nowNs - updateTimeNs) / 1000000;
         }
     }
     return deltaMs;
 }
 
+void Visualizer_clearMeasurements(VisualizerContext *pContext)
+{
+    for (uint32_t i=0 ; i<pContext->mMeasurementWindowSizeInBuffers ; i++) {
+        pContext->mPastMeasurements[i].store(
+                {.mIsValid = false, .mPeakU16 = 0, .mRmsSquared = 0}, std::memory_order_relaxed);
+    }
+    pContext->mMeasurementBufferIdx = 0;
+}
 
 void Visualizer_reset(VisualizerContext *pContext)
 {
     pContext->mCaptureIdx = 0;
     pContext->mLastCaptureIdx = 0;
-    pContext->mBufferUpdateTime.tv_sec = 0;
+    pContext->mBufferUpdateTimeNs = 0;
     pContext->mLatency = 0;
     memset(pContext->mCaptureBuf, 0x80, CAPTURE_BUF_SIZE);
 }
@@ -232,12 +248,7 @@ int Visualizer_init(VisualizerContext *pContext)
     // measurement initialization
     pContext->mMeasurementMode = MEASUREMENT_MODE_NONE;
     pContext->mMeasurementWindowSizeInBuffers = MEASUREMENT_WINDOW_MAX_SIZE_IN_BUFFERS;
-    pContext->mMeasurementBufferIdx = 0;
-    for (uint32_t i=0 ; i<pContext->mMeasurementWindowSizeInBuffers ; i++) {
-        pContext->mPastMeasurements[i].mIsValid = false;
-        pContext->mPastMeasurements[i].mPeakU16 = 0;
-        pContext->mPastMeasurements[i].mRmsSquared = 0;
-    }
+    Visualizer_clearMeasurements(pContext);
 
     Visualizer_setConfig(pContext, &pContext->mConfig);
 
@@ -337,6 +348,13 @@ int Visualizer_process(
 
     // perform measurements if needed
     if (pContext->mMeasurementMode & MEASUREMENT_MODE_PEAK_RMS) {
+        // reset measurements if last measurement was too long ago (which implies stored
+        // measurements aren't relevant anymore and shouldn't bias the new one).
+        // This is done here rather than when measuring, so that only process() writes them.
+        if (Visualizer_getDeltaTimeMsFromUpdatedTime(pContext) > DISCARD_MEASUREMENTS_TIME_MS) {
+            Visualizer_clearMeasurements(pContext);
+        }
+
         // find the peak and RMS squared for the new buffer
         float rmsSqAcc = 0;
 
@@ -356,10 +374,11 @@ int Visualizer_process(
         }
 #endif
         // store the measurement
-        pContext->mPastMeasurements[pContext->mMeasurementBufferIdx].mPeakU16 = (uint16_t)maxSample;
-        pContext->mPastMeasurements[pContext->mMeasurementBufferIdx].mRmsSquared =
-                rmsSqAcc / sampleLen;
-        pContext->mPastMeasurements[pContext->mMeasurementBufferIdx].mIsValid = true;
+        pContext->mPastMeasurements[pContext->mMeasurementBufferIdx].store(
+                {.mIsValid = true,
+                 .mPeakU16 = (uint16_t)maxSample,
+                 .mRmsSquared = rmsSqAcc / sampleLen},
+                std::memory_order_relaxed);
         if (++pContext->mMeasurementBufferIdx >= pContext->mMeasurementWindowSizeInBuffers) {
             pContext->mMeasurementBufferIdx = 0;
         }
@@ -429,7 +448,7 @@ int Visualizer_process(
     uint32_t captIdx;
     uint32_t inIdx;
     uint8_t *buf = pContext->mCaptureBuf;
-    for (inIdx = 0, captIdx = pContext->mCaptureIdx;
+    for (inIdx = 0, captIdx = pContext->mCaptureIdx.load(std::memory_order_relaxed);
          inIdx < sampleLen;
          captIdx++) {
         if (captIdx >= CAPTURE_BUF_SIZE) captIdx = 0; // wrap
@@ -447,13 +466,10 @@ int Visualizer_process(
 #endif // BUILD_FLOAT
     }
 
-    // XXX the following two should really be atomic, though it probably doesn't
-    // matter much for visualization purposes
-    pContext->mCaptureIdx = captIdx;
+    // publish the captured samples
+    pContext->mCaptureIdx.store(captIdx, std::memory_order_release);
     // update last buffer update time stamp
-    if (clock_gettime(CLOCK_MONOTONIC, &pContext->mBufferUpdateTime) < 0) {
-        pContext->mBufferUpdateTime.tv_sec = 0;
-    }
+    pContext->mBufferUpdateTimeNs.store(Visualizer_getNowNs(), std::memory_order_relaxed);
 
     if (inBuffer->raw != outBuffer->raw) {
 #ifdef BUILD_FLOAT
@@ -634,15 +650,17 @@ int Visualizer_command(effect_handle_t self, uint32_t cmdCode, uint32_t cmdSize,
             return -EINVAL;
         }
         if (pContext->mState == VISUALIZER_STATE_ACTIVE) {
+            // the samples before captureIdx are published by process()
+            const uint32_t captureIdx = pContext->mCaptureIdx.load(std::memory_order_acquire);
             const uint32_t deltaMs = Visualizer_getDeltaTimeMsFromUpdatedTime(pContext);
 
             // if audio framework has stopped playing audio although the effect is still
             // active we must clear the capture buffer to return silence
-            if ((pContext->mLastCaptureIdx == pContext->mCaptureIdx) &&
-                    (pContext->mBufferUpdateTime.tv_sec != 0) &&
+            if ((pContext->mLastCaptureIdx == captureIdx) &&
+                    (pContext->mBufferUpdateTimeNs != 0) &&
                     (deltaMs > MAX_STALL_TIME_MS)) {
                     ALOGV("capture going to idle");
-                    pContext->mBufferUpdateTime.tv_sec = 0;
+                    pContext->mBufferUpdateTimeNs = 0;
                     memset(pReplyData, 0x80, captureSize);
             } else {
                 int32_t latencyMs = pContext->mLatency;
@@ -661,8 +679,8 @@ int Visualizer_command(effect_handle_t self, uint32_t cmdCode, uint32_t cmdSize,
                 }
 
                 int32_t capturePoint;
-                //capturePoint = (int32_t)pContext->mCaptureIdx - deltaSmpl;
-                __builtin_sub_overflow((int32_t)pContext->mCaptureIdx, deltaSmpl, &capturePoint);
+                //capturePoint = (int32_t)captureIdx - deltaSmpl;
+                __builtin_sub_overflow((int32_t)captureIdx, deltaSmpl, &capturePoint);
                 // a negative capturePoint means we wrap the buffer.
                 if (capturePoint < 0) {
                     uint32_t size = -capturePoint;
@@ -681,7 +699,7 @@ int Visualizer_command(effect_handle_t self, uint32_t cmdCode, uint32_t cmdSize,
                        captureSize);
             }
 
-            pContext->mLastCaptureIdx = pContext->mCaptureIdx;
+            pContext->mLastCaptureIdx = captureIdx;
         } else {
             memset(pReplyData, 0x80, captureSize);
         }
@@ -705,27 +723,24 @@ int Visualizer_command(effect_handle_t self, uint32_t cmdCode, uint32_t cmdSize,
         uint16_t peakU16 = 0;
         float sumRmsSquared = 0.0f;
         uint8_t nbValidMeasurements = 0;
-        // reset measurements if last measurement was too long ago (which implies stored
-        // measurements aren't relevant anymore and shouldn't bias the new one)
+        // ignore measurements if last measurement was too long ago (which implies stored
+        // measurements aren't relevant anymore and shouldn't bias the new one).
+        // process() clears them when it measures again.
         const int32_t delayMs = Visualizer_getDeltaTimeMsFromUpdatedTime(pContext);
         if (delayMs > DISCARD_MEASUREMENTS_TIME_MS) {
             ALOGV("Discarding measurements, last measurement is %" PRId32 "ms old", delayMs);
-            for (uint32_t i=0 ; i<pContext->mMeasurementWindowSizeInBuffers ; i++) {
-                pContext->mPastMeasurements[i].mIsValid = false;
-                pContext->mPastMeasurements[i].mPeakU16 = 0;
-                pContext->mPastMeasurements[i].mRmsSquared = 0;
-            }
-            pContext->mMeasurementBufferIdx = 0;
         } else {
             // only use actual measurements, otherwise the first RMS measure happening before
             // MEASUREMENT_WINDOW_MAX_SIZE_IN_BUFFERS have been played will always be artificially
             // low
             for (uint32_t i=0 ; i < pContext->mMeasurementWindowSizeInBuffers ; i++) {
-                if (pContext->mPastMeasurements[i].mIsValid) {
-                    if (pContext->mPastMeasurements[i].mPeakU16 > peakU16) {
-                        peakU16 = pContext->mPastMeasurements[i].mPeakU16;
+                const BufferStats stats =
+                        pContext->mPastMeasurements[i].load(std::memory_order_relaxed);
+                if (stats.mIsValid) {
+                    if (stats.mPeakU16 > peakU16) {
+                        peakU16 = stats.mPeakU16;
                     }
-                    sumRmsSquared += pContext->mPastMeasurements[i].mRmsSquared;
+                    sumRmsSquared += stats.mRmsSquared;
                     nbValidMeasurements++;
                 }
             }
@@ -33,8 +33,17 @@ using aidl::android::hardware::audio::common::getChannelCount;
 
 namespace aidl::android::hardware::audio::effect {
 
+static int64_t getNowNs() {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) < 0) {
+        return 0;
+    }
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
 VisualizerContext::VisualizerContext(int statusDepth, const Parameter::Common& common)
     : EffectContext(statusDepth, common) {
+    clearMeasurements();
 }
 
 VisualizerContext::~VisualizerContext() {
@@ -116,48 +125,47 @@ int VisualizerContext::getDownstreamLatency() {
 
 uint32_t VisualizerContext::getDeltaTimeMsFromUpdatedTime_l() {
     uint32_t deltaMs = 0;
-    if (mBufferUpdateTime.tv_sec != 0) {
-        struct timespec ts;
-        if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
-            time_t secs = ts.tv_sec - mBufferUpdateTime.tv_sec;
-            long nsec = ts.tv_nsec - mBufferUpdateTime.tv_nsec;
-            if (nsec < 0) {
-                --secs;
-                nsec += 1000000000;
-            }
-            deltaMs = secs * 1000 + nsec / 1000000;
+    const int64_t updateTimeNs = mBufferUpdateTimeNs.load(std::memory_order_relaxed);
+    if (updateTimeNs != 0) {
+        const int64_t nowNs = getNowNs();
+        if (nowNs != 0) {
+            deltaMs = (nowNs - updateTimeNs) / 1000000;
         }
     }
     return deltaMs;
 }
 
+void VisualizerContext::clearMeasurements() {
+    for (auto& measurement : mPastMeasurements) {
+        measurement.store({.mIsValid = false, .mPeakU16 = 0, .mRmsSquared = 0},
+                          std::memory_order_relaxed);
+    }
+    mMeasurementBufferIdx = 0;
+}
+
 Visualizer::Measurement VisualizerContext::getMeasure() {
     uint16_t peakU16 = 0;
     float sumRmsSquared = 0.0f;
     uint8_t nbValidMeasurements = 0;
 
     {
-        // reset measurements if last measurement was too long ago (which implies stored
-        // measurements aren't relevant anymore and shouldn't bias the new one)
+        // ignore measurements if last measurement was too long ago (which implies stored
+        // measurements aren't relevant anymore and shouldn't bias the new one).
+        // process() clears them when it measures again.
         const uint32_t delayMs = getDeltaTimeMsFromUpdatedTime_l();
         if (delayMs > kDiscardMeasurementsTimeMs) {
             LOG(INFO) << __func__ << " Discarding " << delayMs << " ms old measurements";
-            for (uint32_t i = 0; i < mMeasurementWindowSizeInBuffers; i++) {
-                mPastMeasurements[i].mIsValid = false;
-                mPastMeasurements[i].mPeakU16 = 0;
-                mPastMeasurements[i].mRmsSquared = 0;
-            }
-            mMeasurementBufferIdx = 0;
         } else {
             // only use actual measurements, otherwise the first RMS measure happening before
             // MEASUREMENT_WINDOW_MAX_SIZE_IN_BUFFERS have been played will always be artificially
             // low
             for (uint32_t i = 0; i < mMeasurementWindowSizeInBuffers; i++) {
-                if (mPastMeasurements[i].mIsValid) {
-                    if (mPastMeasurements[i].mPeakU16 > peakU16) {
-                        peakU16 = mPastMeasurements[i].mPeakU16;
+                const BufferStats stats = mPastMeasurements[i].load(std::memory_order_relaxed);
+                if (stats.mIsValid) {
+                    if (stats.mPeakU16 > peakU16) {
+                        peakU16 = stats.mPeakU16;
                     }
-                    sumRmsSquared += mPastMeasurements[i].mRmsSquared;
+                    sumRmsSquared += stats.mRmsSquared;
                     nbValidMeasurements++;
                 }
             }
@@ -183,12 +191,14 @@ std::vector<uint8_t> VisualizerContext::capture() {
         return result;
     }
 
+    // the samples before captureIdx are published by process()
+    const uint32_t captureIdx = mCaptureIdx.load(std::memory_order_acquire);
     const uint32_t deltaMs = getDeltaTimeMsFromUpdatedTime_l();
     // if audio framework has stopped playing audio although the effect is still active we must
     // clear the capture buffer to return silence
-    if ((mLastCaptureIdx == mCaptureIdx) && (mBufferUpdateTime.tv_sec != 0) &&
+    if ((mLastCaptureIdx == captureIdx) && (mBufferUpdateTimeNs != 0) &&
         (deltaMs > kMaxStallTimeMs)) {
-        mBufferUpdateTime.tv_sec = 0;
+        mBufferUpdateTimeNs = 0;
         return result;
     }
     int32_t latencyMs = mDownstreamLatency;
@@ -206,7 +216,7 @@ std::vector<uint8_t> VisualizerContext::capture() {
     }
 
     int32_t capturePoint;
-    __builtin_sub_overflow((int32_t) mCaptureIdx, deltaSamples, &capturePoint);
+    __builtin_sub_overflow((int32_t) captureIdx, deltaSamples, &capturePoint);
     // a negative capturePoint means we wrap the buffer.
     if (capturePoint < 0) {
         uint32_t size = -capturePoint;
@@ -221,7 +231,7 @@ std::vector<uint8_t> VisualizerContext::capture() {
     std::copy(std::begin(mCaptureBuf) + capturePoint,
               std::begin(mCaptureBuf) + capturePoint + captureSamples,
               result.begin() + mCaptureSamples - captureSamples);
-    mLastCaptureIdx = mCaptureIdx;
+    mLastCaptureIdx = captureIdx;
     return result;
 }
 
@@ -233,6 +243,12 @@ IEffect::Status VisualizerContext::process(float* in, float* out, int samples) {
     RETURN_VALUE_IF(mState != State::ACTIVE, result, "stateNotActive");
     // perform measurements if needed
     if (mMeasurementMode == Visualizer::MeasurementMode::PEAK_RMS) {
+        // reset measurements if last measurement was too long ago (which implies stored
+        // measurements aren't relevant anymore and shouldn't bias the new one).
+        // This is done here rather than in getMeasure(), so that only process() writes them.
+        if (getDeltaTimeMsFromUpdatedTime_l() > kDiscardMeasurementsTimeMs) {
+            clearMeasurements();
+        }
         // find the peak and RMS squared for the new buffer
         float rmsSqAcc = 0;
         float maxSample = 0.f;
@@ -242,9 +258,10 @@ IEffect::Status VisualizerContext::process(float* in, float* out, int samples) {
         }
         maxSample *= 1 << 15; // scale to int16_t, with exactly 1 << 15 representing positive num.
         rmsSqAcc *= 1 << 30; // scale to int16_t * 2
-        mPastMeasurements[mMeasurementBufferIdx] = {.mIsValid = true,
-                                                    .mPeakU16 = (uint16_t)maxSample,
-                                                    .mRmsSquared = rmsSqAcc / samples};
+        mPastMeasurements[mMeasurementBufferIdx].store({.mIsValid = true,
+                                                        .mPeakU16 = (uint16_t)maxSample,
+                                                        .mRmsSquared = rmsSqAcc / samples},
+                                                       std::memory_order_relaxed);
         if (++mMeasurementBufferIdx >= mMeasurementWindowSizeInBuffers) {
             mMeasurementBufferIdx = 0;
         }
@@ -283,7 +300,8 @@ IEffect::Status VisualizerContext::process(float* in, float* out, int samples) {
 
     uint32_t captIdx;
     uint32_t inIdx;
-    for (inIdx = 0, captIdx = mCaptureIdx; inIdx < (unsigned)samples; captIdx++) {
+    for (inIdx = 0, captIdx = mCaptureIdx.load(std::memory_order_relaxed);
+         inIdx < (unsigned)samples; captIdx++) {
         // wrap
         if (captIdx >= kMaxCaptureBufSize) {
             captIdx = 0;
@@ -296,13 +314,10 @@ IEffect::Status VisualizerContext::process(float* in, float* out, int samples) {
         mCaptureBuf[captIdx] = clamp8_from_float(smp * fscale);
     }
 
-    // the following two should really be atomic, though it probably doesn't
-    // matter much for visualization purposes
-    mCaptureIdx = captIdx;
+    // publish the captured samples
+    mCaptureIdx.store(captIdx, std::memory_order_release);
     // update last buffer update time stamp
-    if (clock_gettime(CLOCK_MONOTONIC, &mBufferUpdateTime) < 0) {
-        mBufferUpdateTime.tv_sec = 0;
-    }
+    mBufferUpdateTimeNs.store(getNowNs(), std::memory_order_relaxed);
 
     // TODO: handle access_mode
     memcpy(out, in, samples * sizeof(float));
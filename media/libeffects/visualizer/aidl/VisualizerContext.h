@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include <audio_effects/effect_dynamicsprocessing.h>
 #include <system/audio_effects/effect_visualizer.h>
 
@@ -80,10 +82,13 @@ class VisualizerContext final : public EffectContext {
 
     Parameter::Common mCommon;
     State mState = State::UNINITIALIZED;
-    uint32_t mCaptureIdx = 0;
+    // The capture buffer and the measurements are a single producer, single consumer ring:
+    // process() writes them and publishes mCaptureIdx and mBufferUpdateTimeNs, and
+    // capture() and getMeasure() read them from the binder thread without a lock.
+    std::atomic<uint32_t> mCaptureIdx = 0;  // written by process() only
     uint32_t mLastCaptureIdx = 0;
     Visualizer::ScalingMode mScalingMode = Visualizer::ScalingMode::NORMALIZED;
-    struct timespec mBufferUpdateTime;
+    std::atomic<int64_t> mBufferUpdateTimeNs = 0;  // CLOCK_MONOTONIC, 0 if not updated
     // capture buf with 8 bits mono PCM samples
     std::array<uint8_t, kMaxCaptureBufSize> mCaptureBuf;
     uint32_t mDownstreamLatency = 0;
@@ -94,9 +99,10 @@ class VisualizerContext final : public EffectContext {
     Visualizer::MeasurementMode mMeasurementMode =
             Visualizer::MeasurementMode::NONE;
     uint8_t mMeasurementWindowSizeInBuffers = kMeasurementWindowMaxSizeInBuffers;
-    uint8_t mMeasurementBufferIdx = 0;
-    std::array<BufferStats, kMeasurementWindowMaxSizeInBuffers> mPastMeasurements;
+    uint8_t mMeasurementBufferIdx = 0;  // written by process() only
+    std::array<std::atomic<BufferStats>, kMeasurementWindowMaxSizeInBuffers> mPastMeasurements;
     void init_params();
+    void clearMeasurements();
 
     uint32_t getDeltaTimeMsFromUpdatedTime_l();
 };
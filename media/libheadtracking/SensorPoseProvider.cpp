@@ -45,6 +45,10 @@ using android::base::StringAppendF;
 // Note: Instead of a fixed number, the SensorEventQueue's fd could be used instead.
 constexpr int kIdent = 19;
 
+// Maximum number of events read from the queue per wakeup. Sensors batching in their FIFO, or
+// running faster than we get scheduled, deliver several events at once.
+constexpr size_t kMaxEventsPerRead = 16;
+
 static inline Looper* ALooper_to_Looper(ALooper* alooper) {
     return reinterpret_cast<Looper*>(alooper);
 }
@@ -293,15 +297,15 @@ class SensorPoseProviderImpl : public SensorPoseProvider {
                     continue;
             }
 
-            // Process an event.
-            ASensorEvent event;
-            ssize_t actual = mQueue->read(&event, 1);
+            // Process the events available, up to kMaxEventsPerRead at once.
+            ASensorEvent events[kMaxEventsPerRead];
+            ssize_t actual = mQueue->read(events, kMaxEventsPerRead);
             if (actual > 0) {
-                mQueue->sendAck(&event, actual);
+                mQueue->sendAck(events, actual);
             }
-            ssize_t size = mQueue->filterEvents(&event, actual);
+            ssize_t size = mQueue->filterEvents(events, actual);
 
-            if (size < 0 || size > 1) {
+            if (size < 0 || size > static_cast<ssize_t>(kMaxEventsPerRead)) {
                 ALOGE("%s: Unexpected return value from SensorEventQueue::filterEvents: %zd",
                         __func__, size);
                 break;
@@ -311,25 +315,33 @@ class SensorPoseProviderImpl : public SensorPoseProvider {
                 continue;
             }
 
-            handleEvent(event);
+            handleEvents(events, size);
         }
         ALOGD("%s: Exiting sensor event loop", __func__);
     }
 
-    void handleEvent(const ASensorEvent& event) {
-        PoseEvent value;
+    void handleEvents(const ASensorEvent* events, size_t count) {
+        PoseEvent values[kMaxEventsPerRead];
+        bool enabled[kMaxEventsPerRead];
         {
+            // Parse the whole batch under a single lock.
             std::lock_guard lock(mMutex);
-            auto iter = mEnabledSensorsExtra.find(event.sensor);
-            if (iter == mEnabledSensorsExtra.end()) {
+            for (size_t i = 0; i < count; ++i) {
+                auto iter = mEnabledSensorsExtra.find(events[i].sensor);
                 // This can happen if we have any pending events shortly after stopping.
-                return;
+                enabled[i] = iter != mEnabledSensorsExtra.end();
+                if (!enabled[i]) continue;
+                values[i] = parseEvent(events[i], iter->second.format,
+                                       &iter->second.discontinuityCount);
+                updateEventTimestamp(events[i], iter->second);
             }
-            value = parseEvent(event, iter->second.format, &iter->second.discontinuityCount);
-            updateEventTimestamp(event, iter->second);
         }
-        mListener->onPose(event.timestamp, event.sensor, value.pose, value.twist,
-                          value.isNewReference);
+        // In order, since the pose processing relies on the pose history.
+        for (size_t i = 0; i < count; ++i) {
+            if (!enabled[i]) continue;
+            mListener->onPose(events[i].timestamp, events[i].sensor, values[i].pose,
+                              values[i].twist, values[i].isNewReference);
+        }
     }
 
     DataFormat getSensorFormat(int32_t handle) {
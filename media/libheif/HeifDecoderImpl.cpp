@@ -318,6 +318,11 @@ HeifDecoderImpl::HeifDecoderImpl() :
     mHasImage(false),
     mHasVideo(false),
     mSequenceLength(0),
+    mDisplayLeft(0),
+    mDisplayTop(0),
+    mRegionLeft(0),
+    mRegionTop(0),
+    mRegionWidth(0),
     mAvailableLines(0),
     mNumSlices(1),
     mSliceHeight(0),
@@ -346,6 +351,7 @@ bool HeifDecoderImpl::init(HeifStream* stream, HeifFrameInfo* frameInfo) {
 bool HeifDecoderImpl::reinit(HeifFrameInfo* frameInfo) {
     mFrameDecoded = false;
     mFrameMemory.clear();
+    mRegionLeft = mRegionTop = mRegionWidth = 0;
 
     sp<MediaMetadataRetriever> retriever = new MediaMetadataRetriever();
     status_t err = retriever->setDataSource(mDataSource, "image/heif");
@@ -394,6 +400,8 @@ bool HeifDecoderImpl::reinit(HeifFrameInfo* frameInfo) {
                 videoFrame->mBitDepth);
 
         initFrameInfo(&mImageInfo, videoFrame);
+        mDisplayLeft = videoFrame->mDisplayLeft;
+        mDisplayTop = videoFrame->mDisplayTop;
 
         if (videoFrame->mTileHeight >= 512) {
             // Try decoding in slices only if the image has tiles and is big enough.
@@ -575,11 +583,15 @@ bool HeifDecoderImpl::decode(HeifFrameInfo* frameInfo) {
     sp<MediaMetadataRetriever> retriever;
     {
         Mutex::Autolock _l(mRetrieverLock);
-        if (mRetriever == nullptr) {
+        retriever = mRetriever;
+    }
+    if (retriever == nullptr) {
+        // cleared by decodeRegion(), set up a new one
+        if (mDataSource == nullptr || !reinit(nullptr)) {
             ALOGE("Failed to get MediaMetadataRetriever!");
             return false;
         }
-
+        Mutex::Autolock _l(mRetrieverLock);
         retriever = mRetriever;
     }
 
@@ -737,6 +749,87 @@ bool HeifDecoderImpl::decodeSequence(int frameIndex, HeifFrameInfo* frameInfo) {
     return true;
 }
 
+bool HeifDecoderImpl::decodeRegion(uint32_t left, uint32_t top, uint32_t right, uint32_t bottom,
+        HeifFrameInfo* frameInfo) {
+    ALOGV("%s: region {%u, %u, %u, %u}", __FUNCTION__, left, top, right, bottom);
+    if (!mHasImage) {
+        return false;
+    }
+
+    if (left >= right || top >= bottom
+            || right > mImageInfo.mWidth || bottom > mImageInfo.mHeight) {
+        ALOGE("invalid region {%u, %u, %u, %u}, image size %ux%u",
+                left, top, right, bottom, mImageInfo.mWidth, mImageInfo.mHeight);
+        return false;
+    }
+
+    // A slice decode started by decode() owns the retriever and the frame until it is done.
+    if (mThread != nullptr) {
+        mThread->join();
+        mThread.clear();
+    }
+    mNumSlices = 1;
+
+    sp<MediaMetadataRetriever> retriever;
+    {
+        Mutex::Autolock _l(mRetrieverLock);
+        retriever = mRetriever;
+    }
+    if (retriever == nullptr) {
+        if (mDataSource == nullptr || !reinit(nullptr)) {
+            ALOGE("failed to get MediaMetadataRetriever!");
+            return false;
+        }
+        Mutex::Autolock _l(mRetrieverLock);
+        retriever = mRetriever;
+    }
+    // mFrameMemory no longer holds the full picture
+    mFrameDecoded = false;
+
+    // image index < 0 to retrieve primary image
+    mFrameMemory = retriever->getImageRectAtIndex(-1, mOutputColor,
+            mDisplayLeft + left, mDisplayTop + top, mDisplayLeft + right, mDisplayTop + bottom);
+
+    // Aggressively clear to avoid holding on to resources, the next decode
+    // sets up a new retriever.
+    {
+        Mutex::Autolock _l(mRetrieverLock);
+        mRetriever.clear();
+    }
+
+    if (mFrameMemory == nullptr || mFrameMemory->unsecurePointer() == nullptr) {
+        ALOGE("decodeRegion: videoFrame is a nullptr");
+        return false;
+    }
+
+    // TODO: Using unsecurePointer() has some associated security pitfalls
+    //       (see declaration for details).
+    //       Either document why it is safe in this case or address the
+    //       issue (e.g. by copying).
+    VideoFrame* videoFrame = static_cast<VideoFrame*>(mFrameMemory->unsecurePointer());
+    if (videoFrame->mSize == 0 ||
+            mFrameMemory->size() < videoFrame->getFlattenedSize() ||
+            videoFrame->mDisplayLeft + right > videoFrame->mWidth ||
+            videoFrame->mDisplayTop + bottom > videoFrame->mHeight) {
+        ALOGE("decodeRegion: videoFrame size is invalid");
+        mFrameMemory.clear();
+        return false;
+    }
+
+    mRegionLeft = left;
+    mRegionTop = top;
+    mRegionWidth = right - left;
+    mCurScanline = 0;
+    mTotalScanline = bottom - top;
+
+    if (frameInfo != nullptr) {
+        initFrameInfo(frameInfo, videoFrame);
+        frameInfo->mWidth = right - left;
+        frameInfo->mHeight = bottom - top;
+    }
+    return true;
+}
+
 bool HeifDecoderImpl::getScanlineInner(uint8_t* dst) {
     if (mFrameMemory == nullptr || mFrameMemory->unsecurePointer() == nullptr) {
         return false;
@@ -747,11 +840,16 @@ bool HeifDecoderImpl::getScanlineInner(uint8_t* dst) {
     //       issue (e.g. by copying).
     VideoFrame* videoFrame = static_cast<VideoFrame*>(mFrameMemory->unsecurePointer());
     uint8_t* src = videoFrame->getFlattenedData() +
-                   (videoFrame->mRowBytes * (mCurScanline + videoFrame->mDisplayTop)) +
-                   (videoFrame->mBytesPerPixel * videoFrame->mDisplayLeft);
+                   (videoFrame->mRowBytes *
+                           (mCurScanline + videoFrame->mDisplayTop + mRegionTop)) +
+                   (videoFrame->mBytesPerPixel * (videoFrame->mDisplayLeft + mRegionLeft));
     mCurScanline++;
     // Do not try to copy more than |videoFrame->mWidth| pixels.
     uint32_t width = std::min(videoFrame->mDisplayWidth, videoFrame->mWidth);
+    if (mRegionWidth > 0) {
+        // checked against the frame size in decodeRegion()
+        width = mRegionWidth;
+    }
     memcpy(dst, src, videoFrame->mBytesPerPixel * width);
     return true;
 }
@@ -50,6 +50,9 @@ public:
 
     bool decodeSequence(int frameIndex, HeifFrameInfo* frameInfo) override;
 
+    bool decodeRegion(uint32_t left, uint32_t top, uint32_t right, uint32_t bottom,
+            HeifFrameInfo* frameInfo) override;
+
     bool getScanline(uint8_t* dst) override;
 
     size_t skipScanlines(size_t count) override;
@@ -71,6 +74,13 @@ private:
     bool mHasImage;
     bool mHasVideo;
     size_t mSequenceLength;
+    // display crop of the primary picture
+    uint32_t mDisplayLeft;
+    uint32_t mDisplayTop;
+    // region returned by getScanline, in display coordinates; whole frame if width is 0
+    uint32_t mRegionLeft;
+    uint32_t mRegionTop;
+    uint32_t mRegionWidth;
 
     Mutex mRetrieverLock;
 
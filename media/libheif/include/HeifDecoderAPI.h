@@ -151,6 +151,22 @@ struct HeifDecoder {
      */
     virtual bool decodeSequence(int frameIndex, HeifFrameInfo* frameInfo) = 0;
 
+    /*
+     * Decode the region [left, right) x [top, bottom) of the primary picture,
+     * in the coordinates of the picture before rotation. For grid pictures, only
+     * the tiles overlapping the region are decoded. |frameInfo| will be filled
+     * with information of the primary picture, with the size of the region, upon
+     * success and unmodified upon failure.
+     *
+     * After this succeeded, getScanline can be called to read the scanlines
+     * of the region. Returns false if the region can't be decoded on its own,
+     * in which case decode() can be used instead.
+     */
+    virtual bool decodeRegion(uint32_t /*left*/, uint32_t /*top*/,
+            uint32_t /*right*/, uint32_t /*bottom*/, HeifFrameInfo* /*frameInfo*/) {
+        return false;
+    }
+
     /*
      * Read the next scanline (in top-down order), returns true upon success
      * and false otherwise.
@@ -40,8 +40,12 @@ enum {
     GET_FRAME_AT_INDEX,
     EXTRACT_ALBUM_ART,
     EXTRACT_METADATA,
+    GET_FRAMES_AT_TIME,
 };
 
+// Upper bound on the number of frames requested in one GET_FRAMES_AT_TIME transaction.
+static constexpr size_t kMaxFramesPerCall = 64;
+
 class BpMediaMetadataRetriever: public BpInterface<IMediaMetadataRetriever>
 {
 public:
@@ -188,6 +192,40 @@ public:
         return interface_cast<IMemory>(reply.readStrongBinder());
     }
 
+    status_t getFramesAtTime(
+            const std::vector<int64_t> &timesUs, int option, int colorFormat,
+            std::vector<sp<IMemory>> *frames)
+    {
+        ALOGV("getFramesAtTime: %zu frames, option(%d), colorFormat(%d)",
+                timesUs.size(), option, colorFormat);
+        Parcel data, reply;
+        data.writeInterfaceToken(IMediaMetadataRetriever::getInterfaceDescriptor());
+        data.writeInt64Vector(timesUs);
+        data.writeInt32(option);
+        data.writeInt32(colorFormat);
+        status_t err = remote()->transact(GET_FRAMES_AT_TIME, data, &reply);
+        if (err != NO_ERROR) {
+            return err;
+        }
+        status_t ret = reply.readInt32();
+        if (ret != NO_ERROR) {
+            return ret;
+        }
+        uint32_t count = reply.readUint32();
+        if (count != timesUs.size()) {
+            return BAD_VALUE;
+        }
+        frames->clear();
+        for (uint32_t i = 0; i < count; ++i) {
+            sp<IMemory> frame;
+            if (reply.readInt32() != 0) {
+                frame = interface_cast<IMemory>(reply.readStrongBinder());
+            }
+            frames->push_back(frame);
+        }
+        return NO_ERROR;
+    }
+
     sp<IMemory> extractAlbumArt()
     {
         Parcel data, reply;
@@ -378,6 +416,38 @@ status_t BnMediaMetadataRetriever::onTransact(
             }
             return NO_ERROR;
         } break;
+        case GET_FRAMES_AT_TIME: {
+            CHECK_INTERFACE(IMediaMetadataRetriever, data, reply);
+            std::vector<int64_t> timesUs;
+            status_t err = data.readInt64Vector(&timesUs);
+            if (err != NO_ERROR) {
+                return err;
+            }
+            int option = data.readInt32();
+            int colorFormat = data.readInt32();
+            ALOGV("getFramesAtTime: %zu frames, option(%d), colorFormat(%d)",
+                    timesUs.size(), option, colorFormat);
+            if (timesUs.empty() || timesUs.size() > kMaxFramesPerCall) {
+                reply->writeInt32(BAD_VALUE);
+                return NO_ERROR;
+            }
+            std::vector<sp<IMemory>> frames;
+            err = getFramesAtTime(timesUs, option, colorFormat, &frames);
+            if (err != NO_ERROR || frames.size() != timesUs.size()) {
+                reply->writeInt32(err != NO_ERROR ? err : UNKNOWN_ERROR);
+                return NO_ERROR;
+            }
+            reply->writeInt32(NO_ERROR);
+            reply->writeUint32(frames.size());
+            for (const sp<IMemory> &frame : frames) {
+                // Don't send NULL across the binder interface
+                reply->writeInt32(frame != nullptr);
+                if (frame != nullptr) {
+                    reply->writeStrongBinder(IInterface::asBinder(frame));
+                }
+            }
+            return NO_ERROR;
+        } break;
         case EXTRACT_ALBUM_ART: {
             CHECK_INTERFACE(IMediaMetadataRetriever, data, reply);
             sp<IMemory> albumArt = extractAlbumArt();
@@ -23,6 +23,8 @@
 #include <utils/KeyedVector.h>
 #include <utils/RefBase.h>
 
+#include <vector>
+
 namespace android {
 class Parcel;
 class IDataSource;
@@ -50,6 +52,11 @@ public:
             int index, int colorFormat, int left, int top, int right, int bottom) = 0;
     virtual sp<IMemory>     getFrameAtIndex(
             int index, int colorFormat, bool metaOnly) = 0;
+    // Extracts one frame per entry of |timesUs|; |frames| gets a null entry for each frame that
+    // could not be extracted.
+    virtual status_t        getFramesAtTime(
+            const std::vector<int64_t> &timesUs, int option, int colorFormat,
+            std::vector<sp<IMemory>> *frames) = 0;
     virtual sp<IMemory>     extractAlbumArt() = 0;
     virtual const char*     extractMetadata(int keyCode) = 0;
 };
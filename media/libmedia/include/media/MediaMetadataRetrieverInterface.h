@@ -18,6 +18,9 @@
 #ifndef ANDROID_MEDIAMETADATARETRIEVERINTERFACE_H
 #define ANDROID_MEDIAMETADATARETRIEVERINTERFACE_H
 
+#include <functional>
+#include <vector>
+
 #include <utils/RefBase.h>
 #include <media/mediametadataretriever.h>
 #include <media/mediascanner.h>
@@ -51,6 +54,20 @@ public:
             int index, int colorFormat, int left, int top, int right, int bottom) = 0;
     virtual sp<IMemory> getFrameAtIndex(
             int frameIndex, int colorFormat, bool metaOnly) = 0;
+
+    // Extracts the frames at |timesUs| as getFrameAtTime() would, calling |onFrame| with the
+    // index into |timesUs| and the frame (nullptr on failure) as each of them completes.
+    // Implementations may extract frames in parallel and call |onFrame| in any order, but not
+    // concurrently.
+    virtual status_t getFramesAtTime(
+            const std::vector<int64_t> &timesUs, int option, int colorFormat,
+            const std::function<void(size_t, const sp<IMemory> &)> &onFrame) {
+        for (size_t i = 0; i < timesUs.size(); ++i) {
+            onFrame(i, getFrameAtTime(timesUs[i], option, colorFormat, false /* metaOnly */));
+        }
+        return OK;
+    }
+
     virtual MediaAlbumArt* extractAlbumArt() = 0;
     virtual const char* extractMetadata(int keyCode) = 0;
 };
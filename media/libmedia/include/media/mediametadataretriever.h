@@ -103,6 +103,8 @@ public:
             int index, int colorFormat, int left, int top, int right, int bottom);
     sp<IMemory>  getFrameAtIndex(
             int index, int colorFormat, bool metaOnly = false);
+    status_t getFramesAtTime(const std::vector<int64_t> &timesUs, int option,
+            int colorFormat, std::vector<sp<IMemory>> *frames);
     sp<IMemory> extractAlbumArt();
     const char* extractMetadata(int keyCode);
 
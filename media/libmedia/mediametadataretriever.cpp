@@ -187,6 +187,19 @@ sp<IMemory>  MediaMetadataRetriever::getFrameAtIndex(
     return mRetriever->getFrameAtIndex(index, colorFormat, metaOnly);
 }
 
+status_t MediaMetadataRetriever::getFramesAtTime(
+        const std::vector<int64_t> &timesUs, int option, int colorFormat,
+        std::vector<sp<IMemory>> *frames) {
+    ALOGV("getFramesAtTime: %zu frames, option(%d), colorFormat(%d)",
+            timesUs.size(), option, colorFormat);
+    Mutex::Autolock _l(mLock);
+    if (mRetriever == 0) {
+        ALOGE("retriever is not initialized");
+        return INVALID_OPERATION;
+    }
+    return mRetriever->getFramesAtTime(timesUs, option, colorFormat, frames);
+}
+
 const char* MediaMetadataRetriever::extractMetadata(int keyCode)
 {
     ALOGV("extractMetadata(%d)", keyCode);
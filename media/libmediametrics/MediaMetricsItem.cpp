@@ -21,9 +21,15 @@
 #include <string.h>
 #include <sys/types.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <mutex>
 #include <set>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include <binder/Parcel.h>
 #include <cutils/multiuser.h>
@@ -304,6 +310,129 @@ std::string mediametrics::Item::toString() const {
     return result;
 }
 
+// Property names sent by their index in version 1 byte strings.
+// DO NOT MODIFY ORDER OR REMOVE (OK to add new ones at the end, up to 256 of them):
+// the service must read the byte strings of an older libmediametrics, e.g. of a vendor.
+static constexpr const char * const kPropertyNameDictionary[] = {
+    AMEDIAMETRICS_PROP_ADDRESS,
+    AMEDIAMETRICS_PROP_ALLOWUID,
+    AMEDIAMETRICS_PROP_AUDIOMODE,
+    AMEDIAMETRICS_PROP_AUXEFFECTID,
+    AMEDIAMETRICS_PROP_BUFFERSIZEFRAMES,
+    AMEDIAMETRICS_PROP_BUFFERCAPACITYFRAMES,
+    AMEDIAMETRICS_PROP_BURSTFRAMES,
+    AMEDIAMETRICS_PROP_CALLERNAME,
+    AMEDIAMETRICS_PROP_CHANNELCOUNT,
+    AMEDIAMETRICS_PROP_CHANNELCOUNTHARDWARE,
+    AMEDIAMETRICS_PROP_CHANNELMASK,
+    AMEDIAMETRICS_PROP_CHANNELMASKS,
+    AMEDIAMETRICS_PROP_CLOSEDCOUNT,
+    AMEDIAMETRICS_PROP_CONTENTTYPE,
+    AMEDIAMETRICS_PROP_CUMULATIVETIMENS,
+    AMEDIAMETRICS_PROP_DEVICEDISCONNECTED,
+    AMEDIAMETRICS_PROP_DEVICEID,
+    AMEDIAMETRICS_PROP_DEVICELATENCYMS,
+    AMEDIAMETRICS_PROP_DEVICESTARTUPMS,
+    AMEDIAMETRICS_PROP_DEVICETIMENS,
+    AMEDIAMETRICS_PROP_DEVICEVOLUME,
+    AMEDIAMETRICS_PROP_DEVICEMAXVOLUMEDURATIONNS,
+    AMEDIAMETRICS_PROP_DEVICEMAXVOLUME,
+    AMEDIAMETRICS_PROP_DEVICEMINVOLUMEDURATIONNS,
+    AMEDIAMETRICS_PROP_DEVICEMINVOLUME,
+    AMEDIAMETRICS_PROP_DIRECTION,
+    AMEDIAMETRICS_PROP_DURATIONNS,
+    AMEDIAMETRICS_PROP_ENABLED,
+    AMEDIAMETRICS_PROP_ENCODING,
+    AMEDIAMETRICS_PROP_ENCODINGHARDWARE,
+    AMEDIAMETRICS_PROP_EVENT,
+    AMEDIAMETRICS_PROP_EXECUTIONTIMENS,
+    AMEDIAMETRICS_PROP_FLAGS,
+    AMEDIAMETRICS_PROP_FRAMECOUNT,
+    AMEDIAMETRICS_PROP_HARDWARETYPE,
+    AMEDIAMETRICS_PROP_HASHEADTRACKER,
+    AMEDIAMETRICS_PROP_HEADTRACKERENABLED,
+    AMEDIAMETRICS_PROP_HEADTRACKINGMODES,
+    AMEDIAMETRICS_PROP_INPUTDEVICES,
+    AMEDIAMETRICS_PROP_INPUTPORTCOUNT,
+    AMEDIAMETRICS_PROP_INTERNALTRACKID,
+    AMEDIAMETRICS_PROP_INTERVALCOUNT,
+    AMEDIAMETRICS_PROP_ISSHARED,
+    AMEDIAMETRICS_PROP_LATENCYMS,
+    AMEDIAMETRICS_PROP_LEVELS,
+    AMEDIAMETRICS_PROP_LOGSESSIONID,
+    AMEDIAMETRICS_PROP_METHODCODE,
+    AMEDIAMETRICS_PROP_METHODNAME,
+    AMEDIAMETRICS_PROP_MODE,
+    AMEDIAMETRICS_PROP_MODES,
+    AMEDIAMETRICS_PROP_NAME,
+    AMEDIAMETRICS_PROP_ORIGINALFLAGS,
+    AMEDIAMETRICS_PROP_OPENEDCOUNT,
+    AMEDIAMETRICS_PROP_OUTPUTDEVICES,
+    AMEDIAMETRICS_PROP_OUTPUTPORTCOUNT,
+    AMEDIAMETRICS_PROP_PERFORMANCEMODE,
+    AMEDIAMETRICS_PROP_PLAYBACK_PITCH,
+    AMEDIAMETRICS_PROP_PLAYBACK_SPEED,
+    AMEDIAMETRICS_PROP_PLAYERIID,
+    AMEDIAMETRICS_PROP_ROUTEDDEVICEID,
+    AMEDIAMETRICS_PROP_SAMPLERATE,
+    AMEDIAMETRICS_PROP_SAMPLERATECLIENT,
+    AMEDIAMETRICS_PROP_SAMPLERATEHARDWARE,
+    AMEDIAMETRICS_PROP_SELECTEDDEVICEID,
+    AMEDIAMETRICS_PROP_SELECTEDMICDIRECTION,
+    AMEDIAMETRICS_PROP_SELECTEDMICFIELDDIRECTION,
+    AMEDIAMETRICS_PROP_SESSIONID,
+    AMEDIAMETRICS_PROP_SHARINGMODE,
+    AMEDIAMETRICS_PROP_SOURCE,
+    AMEDIAMETRICS_PROP_STARTTHRESHOLDFRAMES,
+    AMEDIAMETRICS_PROP_STARTUPMS,
+    AMEDIAMETRICS_PROP_STATE,
+    AMEDIAMETRICS_PROP_STATUS,
+    AMEDIAMETRICS_PROP_STATUSSUBCODE,
+    AMEDIAMETRICS_PROP_STATUSMESSAGE,
+    AMEDIAMETRICS_PROP_STREAMTYPE,
+    AMEDIAMETRICS_PROP_SUPPORTSMIDIUMP,
+    AMEDIAMETRICS_PROP_TOSTRING,
+    AMEDIAMETRICS_PROP_TOTALINPUTBYTES,
+    AMEDIAMETRICS_PROP_TOTALOUTPUTBYTES,
+    AMEDIAMETRICS_PROP_THREADID,
+    AMEDIAMETRICS_PROP_THROTTLEMS,
+    AMEDIAMETRICS_PROP_TRACKID,
+    AMEDIAMETRICS_PROP_TRAITS,
+    AMEDIAMETRICS_PROP_TYPE,
+    AMEDIAMETRICS_PROP_UNDERRUN,
+    AMEDIAMETRICS_PROP_UNDERRUNFRAMES,
+    AMEDIAMETRICS_PROP_USAGE,
+    AMEDIAMETRICS_PROP_USINGALSA,
+    AMEDIAMETRICS_PROP_VOICEVOLUME,
+    AMEDIAMETRICS_PROP_VOLUME_LEFT,
+    AMEDIAMETRICS_PROP_VOLUME_RIGHT,
+    AMEDIAMETRICS_PROP_WHERE,
+    AMEDIAMETRICS_PROP_ENCODINGCLIENT,
+    AMEDIAMETRICS_PROP_PERFORMANCEMODEACTUAL,
+    AMEDIAMETRICS_PROP_FRAMESTRANSFERRED,
+    AMEDIAMETRICS_PROP_SHARINGMODEACTUAL,
+    AMEDIAMETRICS_PROP_WAKEUPSPERSECOND,
+};
+static_assert(std::size(kPropertyNameDictionary) <= UINT8_MAX + 1);
+
+// static
+int32_t BaseItem::getDictionaryIndex(const char *name) {
+    static const std::unordered_map<std::string_view, int32_t> map = [] {
+        std::unordered_map<std::string_view, int32_t> m;
+        for (size_t i = 0; i < std::size(kPropertyNameDictionary); ++i) {
+            m.emplace(kPropertyNameDictionary[i], (int32_t)i);
+        }
+        return m;
+    }();
+    const auto it = map.find(name);
+    return it != map.end() ? it->second : -1;
+}
+
+// static
+const char *BaseItem::getDictionaryName(uint8_t index) {
+    return index < std::size(kPropertyNameDictionary) ? kPropertyNameDictionary[index] : nullptr;
+}
+
 // for the lazy, we offer methods that finds the service and
 // calls the appropriate daemon
 bool mediametrics::Item::selfrecord() {
@@ -382,6 +511,92 @@ void BaseItem::dropInstance() {
     sMediaMetricsService = nullptr;
 }
 
+// Collects the buffers submitted by the process into batches sent by a single transaction,
+// either when large enough, or from its thread maxDelayNs after the first buffer of the batch.
+class SubmitBatcher {
+public:
+    explicit SubmitBatcher(nsecs_t maxDelayNs) : mMaxDelayNs(maxDelayNs) {}
+
+    status_t enqueue(const char *buffer, size_t size) {
+        std::vector<char> batch;
+        {
+            std::lock_guard _l(mLock);
+            // started here rather than on creation, in case the process forks in between.
+            std::call_once(mThreadOnce, [this] {
+                std::thread(&SubmitBatcher::threadLoop, this).detach();
+            });
+            if (mBatch.empty()) {
+                mBatch.reserve(kMaxBatchSize);
+                mFirstEnqueueNs = systemTime(SYSTEM_TIME_MONOTONIC);
+                mCondition.notify_one();
+            }
+            const size_t offset = mBatch.size();
+            mBatch.insert(mBatch.end(), buffer, buffer + size);
+            setTimestampIfNone(mBatch.data() + offset, size);
+            if (mBatch.size() < kMaxBatchSize) return NO_ERROR;
+            batch.swap(mBatch);
+        }
+        return BaseItem::submitBuffers(batch.data(), batch.size());
+    }
+
+private:
+    // Well below the 1MB binder buffer shared by the transactions in flight.
+    static constexpr size_t kMaxBatchSize = 16384;
+
+    // Otherwise the service would use the time the batch is received.
+    static void setTimestampIfNone(char *buffer, size_t size) {
+        uint32_t headerSize;
+        if (size < 2 * sizeof(uint32_t)) return;
+        memcpy(&headerSize, buffer + sizeof(uint32_t), sizeof(headerSize));
+        if (headerSize < 2 * sizeof(uint32_t) + sizeof(int64_t) || headerSize > size) return;
+        int64_t timestamp;
+        memcpy(&timestamp, buffer + headerSize - sizeof(timestamp), sizeof(timestamp));
+        if (timestamp != 0) return;
+        timestamp = systemTime(SYSTEM_TIME_REALTIME);
+        memcpy(buffer + headerSize - sizeof(timestamp), &timestamp, sizeof(timestamp));
+    }
+
+    void threadLoop() {
+        std::unique_lock l(mLock);
+        while (true) {
+            if (mBatch.empty()) {
+                mCondition.wait(l);
+                continue;
+            }
+            const nsecs_t delayNs =
+                    mFirstEnqueueNs + mMaxDelayNs - systemTime(SYSTEM_TIME_MONOTONIC);
+            if (delayNs > 0) {
+                mCondition.wait_for(l, std::chrono::nanoseconds(delayNs));
+                continue;
+            }
+            std::vector<char> batch;
+            batch.swap(mBatch);
+            l.unlock();
+            (void)BaseItem::submitBuffers(batch.data(), batch.size());
+            l.lock();
+        }
+    }
+
+    const nsecs_t mMaxDelayNs;
+    std::once_flag mThreadOnce;
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    std::vector<char> mBatch;       // guarded by mLock
+    nsecs_t mFirstEnqueueNs = 0;    // guarded by mLock
+};
+
+// never deleted, as used by a detached thread.
+static std::atomic<SubmitBatcher *> sSubmitBatcher{};
+
+// static
+void BaseItem::enableBatching(nsecs_t maxDelayNs) {
+    SubmitBatcher *expected = nullptr;
+    SubmitBatcher *batcher = new SubmitBatcher(maxDelayNs);
+    if (!sSubmitBatcher.compare_exchange_strong(expected, batcher)) {
+        delete batcher;  // already enabled
+    }
+}
+
 // static
 status_t BaseItem::submitBuffer(const char *buffer, size_t size) {
     ALOGD_IF(DEBUG_API, "%s: delivering %zu bytes", __func__, size);
@@ -393,16 +608,42 @@ status_t BaseItem::submitBuffer(const char *buffer, size_t size) {
     sp<media::IMediaMetricsService> svc = getService();
     if (svc == nullptr)  return NO_INIT;
 
+    if (SubmitBatcher *batcher = sSubmitBatcher.load(std::memory_order_acquire);
+            batcher != nullptr) {
+        return batcher->enqueue(buffer, size);
+    }
+    return transactBuffer(svc, media::BnMediaMetricsService::TRANSACTION_submitBuffer,
+            buffer, size);
+}
+
+// static
+status_t BaseItem::submitBuffers(const char *buffers, size_t size) {
+    ALOGD_IF(DEBUG_API, "%s: delivering %zu bytes", __func__, size);
+
+    if (size > std::numeric_limits<int32_t>::max()) return BAD_VALUE;
+
+    sp<media::IMediaMetricsService> svc = getService();
+    if (svc == nullptr)  return NO_INIT;
+
+    return transactBuffer(svc, media::BnMediaMetricsService::TRANSACTION_submitBuffers,
+            buffers, size);
+}
+
+// static
+status_t BaseItem::transactBuffer(const sp<media::IMediaMetricsService>& svc,
+        uint32_t code, const char *buffer, size_t size) {
     ::android::status_t status = NO_ERROR;
     if constexpr (/* DISABLES CODE */ (false)) {
         // THIS PATH IS FOR REFERENCE ONLY.
         // It is compiled so that any changes to IMediaMetricsService::submitBuffer()
-        // will lead here.  If this code is changed, the else branch must
+        // or submitBuffers() will lead here.  If this code is changed, the else branch must
         // be changed as well.
         //
         // Use the AIDL calling interface - this is a bit slower as a byte vector must be
         // constructed. As the call is one-way, the only a transaction error occurs.
-        status = svc->submitBuffer({buffer, buffer + size}).transactionError();
+        status = code == ::android::media::BnMediaMetricsService::TRANSACTION_submitBuffers
+                ? svc->submitBuffers({buffer, buffer + size}).transactionError()
+                : svc->submitBuffer({buffer, buffer + size}).transactionError();
     } else {
         // Use the Binder calling interface - this direct implementation avoids
         // malloc/copy/free for the vector and reduces the overhead for logging.
@@ -422,8 +663,7 @@ status_t BaseItem::submitBuffer(const char *buffer, size_t size) {
         if (status != ::android::OK) goto _aidl_error;
 
         status = ::android::IInterface::asBinder(svc)->transact(
-                ::android::media::BnMediaMetricsService::TRANSACTION_submitBuffer,
-                _aidl_data, &_aidl_reply, ::android::IBinder::FLAG_ONEWAY);
+                code, _aidl_data, &_aidl_reply, ::android::IBinder::FLAG_ONEWAY);
 
         // AIDL permits setting a default implementation for additional functionality.
         // See go/aog/713984. This is not used here.
@@ -493,7 +733,7 @@ status_t mediametrics::Item::writeToByteString(char **pbuffer, size_t *plength)
         ALOGW("%s: key size %zu too large", __func__, keySizeZeroTerminated);
         return INVALID_OPERATION;
     }
-    const uint16_t version = 0;
+    const uint16_t version = kByteStringVersion;
     const uint32_t header_size =
         sizeof(uint32_t)      // total size
         + sizeof(header_size) // header size
@@ -585,6 +825,7 @@ status_t mediametrics::Item::readFromByteString(const char *bufferptr, size_t le
             || extract(&uid, &read, readend) != NO_ERROR
             || extract(&timestamp, &read, readend) != NO_ERROR
             || size > length
+            || version > kByteStringVersion
             || key.size() + 1 != key_size
             || header_size > size) {
         ALOGW("%s: invalid header", __func__);
@@ -610,7 +851,7 @@ status_t mediametrics::Item::readFromByteString(const char *bufferptr, size_t le
     mTimestamp = timestamp;
     for (size_t i = 0; i < propCount; ++i) {
         Prop prop;
-        if (prop.readFromByteString(&read, readend) != NO_ERROR) {
+        if (prop.readFromByteString(&read, readend, version) != NO_ERROR) {
             ALOGW("%s: cannot read prop %zu", __func__, i);
             return INVALID_OPERATION;
         }
@@ -669,15 +910,29 @@ status_t mediametrics::Item::Prop::readFromParcel(const Parcel& data)
 }
 
 status_t mediametrics::Item::Prop::readFromByteString(
-        const char **bufferpptr, const char *bufferptrmax)
+        const char **bufferpptr, const char *bufferptrmax, uint16_t version)
 {
     uint16_t len;
     std::string name;
     uint8_t type;
     status_t status = extract(&len, bufferpptr, bufferptrmax)
-            ?: extract(&type, bufferpptr, bufferptrmax)
-            ?: extract(&name, bufferpptr, bufferptrmax);
+            ?: extract(&type, bufferpptr, bufferptrmax);
     if (status != NO_ERROR) return status;
+    if (version >= 1 && (type & kTypeFlagDictionaryName) != 0) {
+        uint8_t index;
+        status = extract(&index, bufferpptr, bufferptrmax);
+        if (status != NO_ERROR) return status;
+        const char *dictionaryName = getDictionaryName(index);
+        if (dictionaryName == nullptr) {
+            ALOGE("%s: found bad prop name index: %d", __func__, (int)index);
+            return BAD_VALUE;
+        }
+        name = dictionaryName;
+        type &= (uint8_t)~kTypeFlagDictionaryName;
+    } else {
+        status = extract(&name, bufferpptr, bufferptrmax);
+        if (status != NO_ERROR) return status;
+    }
     switch (type) {
     case mediametrics::kTypeInt32: {
         int32_t value;
@@ -43,6 +43,13 @@
 // Device related key prefix.
 #define AMEDIAMETRICS_KEY_PREFIX_AUDIO_DEVICE  AMEDIAMETRICS_KEY_PREFIX_AUDIO "device."
 
+// The binder and HAL method latency histograms append the interface name to the prefix,
+// e.g. "audio.methodStatistics.IAudioFlinger".
+// Each property is a method name, with the comma separated counts of
+// the mediautils::MethodStatistics histogram since the previous item.
+#define AMEDIAMETRICS_KEY_PREFIX_AUDIO_METHOD_STATISTICS \
+        AMEDIAMETRICS_KEY_PREFIX_AUDIO "methodStatistics."
+
 // The AudioMmap key appends the "trackId" to the prefix.
 // This is the AudioFlinger equivalent of the AAudio Stream.
 // TODO: unify with AMEDIAMETRICS_KEY_PREFIX_AUDIO_STREAM
@@ -128,6 +135,12 @@
                                                            // separated by |.
 #define AMEDIAMETRICS_PROP_CLOSEDCOUNT   "closedCount"    // int32 (MIDI)
 #define AMEDIAMETRICS_PROP_CONTENTTYPE    "contentType"    // string attributes (AudioTrack)
+#define AMEDIAMETRICS_PROP_CPUMEANMHZ     "cpuMeanMHz"     // double CPU frequency weighted by
+                                                           // thread CPU time (Thread)
+#define AMEDIAMETRICS_PROP_CPUMIGRATIONS  "cpuMigrations"  // int32 changes of CPU (Thread)
+#define AMEDIAMETRICS_PROP_CPURESIDENCY   "cpuResidency"   // string with cpu:percent of thread
+                                                           // CPU time, separated by |. (Thread)
+#define AMEDIAMETRICS_PROP_CPUTIMENS      "cpuTimeNs"      // int64_t thread CPU time (Thread)
 #define AMEDIAMETRICS_PROP_CUMULATIVETIMENS "cumulativeTimeNs" // int64_t playback/record time
                                                            // since start
 #define AMEDIAMETRICS_PROP_DEVICEDISCONNECTED "deviceDisconnected" // string true/false (MIDI)
@@ -237,6 +250,8 @@
 #define AMEDIAMETRICS_PROP_FRAMESTRANSFERRED "framesTransferred" // int64_t, transferred frames
 // string value, "exclusive", "shared". the actual selected sharing mode by the server
 #define AMEDIAMETRICS_PROP_SHARINGMODEACTUAL "sharingModeActual"
+// The average number of wakeups per second of the data callback thread of an AAudio stream.
+#define AMEDIAMETRICS_PROP_WAKEUPSPERSECOND "wakeupsPerSecond" // double
 
 // Timing values: millisecond values are suffixed with MS and the type is double
 // nanosecond values are suffixed with NS and the type is int64.
@@ -247,6 +262,7 @@
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_APPLYVOLUMESHAPER "applyVolumeShaper"
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_BEGINAUDIOINTERVALGROUP "beginAudioIntervalGroup"
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_CLOSE      "close"
+#define AMEDIAMETRICS_PROP_EVENT_VALUE_CPUSTATS   "cpuStats" // Thread
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_CREATE     "create"
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_CREATEAUDIOPATCH "createAudioPatch"
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_CTOR       "ctor"
@@ -68,7 +68,7 @@ class Parcel;
  * -- begin of header
  * (uint32) item size: including the item size field
  * (uint32) header size, including the item size and header size fields.
- * (uint16) version: exactly 0
+ * (uint16) version: 0, or 1 if property names may be dictionary indices
  * (uint16) key size, that is key strlen + 1 for zero termination.
  * (int8)+ key, a string which is 0 terminated (UTF-8).
  * (int32) pid
@@ -79,8 +79,10 @@ class Parcel;
  * (uint32) number of properties
  * -- repeat for number of properties
  *     (uint16) property size, including property size field itself
- *     (uint8) type of property
- *     (int8)+ key string, including 0 termination
+ *     (uint8) type of property, ORed with kTypeFlagDictionaryName (version 1)
+ *         if the key string is replaced by its index in the dictionary
+ *     (int8)+ key string, including 0 termination, or
+ *     (uint8) key dictionary index with kTypeFlagDictionaryName
  *      based on type of property (given above), one of:
  *       (int32)
  *       (int64)
@@ -105,6 +107,10 @@ enum Type {
     kTypeRate = 5,
 };
 
+// Set in the type of a property of a version 1 byte string when its name
+// is sent as its index in the property name dictionary.
+inline constexpr uint8_t kTypeFlagDictionaryName = 0x80;
+
 /*
  * Helper for status conversions
  */
@@ -274,7 +280,21 @@ public:
     // returns the MediaMetrics service if active.
     static sp<media::IMediaMetricsService> getService();
     // submits a raw buffer directly to the MediaMetrics service - this is highly optimized.
+    // With batching enabled, the buffer is sent later along with the ones that follow.
     static status_t submitBuffer(const char *buffer, size_t len);
+    // submits raw buffers one after the other, each starting with its total size.
+    static status_t submitBuffers(const char *buffers, size_t len);
+    // batches the buffers submitted by the process from now on, each batch being sent
+    // at most maxDelayNs after its first buffer, or once it is large enough.
+    // A buffer without timestamp gets the time of its submission.
+    static void enableBatching(nsecs_t maxDelayNs);
+
+    // byte string encoding version written.
+    static inline constexpr uint16_t kByteStringVersion = 1;
+    // returns the index of a property name in the dictionary, or -1 if not in it.
+    static int32_t getDictionaryIndex(const char *name);
+    // returns the property name at an index of the dictionary, or nullptr if none.
+    static const char *getDictionaryName(uint8_t index);
 
 protected:
     static constexpr const char * const EnabledProperty = "media.metrics.enabled";
@@ -286,6 +306,10 @@ protected:
 
     static void dropInstance();
 
+    // sends the buffer to the service with the transaction code of submitBuffer(s).
+    static status_t transactBuffer(const sp<media::IMediaMetricsService>& svc,
+            uint32_t code, const char *buffer, size_t size);
+
     template <typename T>
     struct is_item_type {
         static constexpr inline bool value =
@@ -310,22 +334,27 @@ protected:
          : kTypeNone;
     };
 
+    // the name is replaced by its dictionary index if not negative.
+    static size_t sizeOfName(const char *name, int32_t index) {
+        return index >= 0 ? 1 : strlen(name) + 1;
+    }
+
     template <typename T>
-    static size_t sizeOfByteString(const char *name, const T& value) {
+    static size_t sizeOfByteString(const char *name, int32_t index, const T& value) {
         static_assert(is_item_type<T>::value);
-        return 2 + 1 + strlen(name) + 1 + sizeof(value);
+        return 2 + 1 + sizeOfName(name, index) + sizeof(value);
     }
     template <> // static
-    size_t sizeOfByteString(const char *name, const std::string& value) {
-        return 2 + 1 + strlen(name) + 1 + value.size() + 1;
+    size_t sizeOfByteString(const char *name, int32_t index, const std::string& value) {
+        return 2 + 1 + sizeOfName(name, index) + value.size() + 1;
     }
     template <> // static
-    size_t sizeOfByteString(const char *name, const std::monostate&) {
-         return 2 + 1 + strlen(name) + 1;
+    size_t sizeOfByteString(const char *name, int32_t index, const std::monostate&) {
+         return 2 + 1 + sizeOfName(name, index);
     }
     // for speed
-    static size_t sizeOfByteString(const char *name, const char *value) {
-        return 2 + 1 + strlen(name) + 1 + strlen(value) + 1;
+    static size_t sizeOfByteString(const char *name, int32_t index, const char *value) {
+        return 2 + 1 + sizeOfName(name, index) + strlen(value) + 1;
     }
 
     template <typename T>
@@ -380,25 +409,35 @@ protected:
         return NO_ERROR;
     }
 
+    static status_t insertTypeAndName(uint8_t type, const char *name, int32_t index,
+            char **bufferpptr, char *bufferptrmax) {
+        if (index >= 0) {
+            return insert((uint8_t)(type | kTypeFlagDictionaryName), bufferpptr, bufferptrmax)
+                    ?: insert((uint8_t)index, bufferpptr, bufferptrmax);
+        }
+        return insert(type, bufferpptr, bufferptrmax)
+                ?: insert(name, bufferpptr, bufferptrmax);
+    }
+
     template <typename T>
-    static status_t writeToByteString(
-            const char *name, const T& value, char **bufferpptr, char *bufferptrmax) {
+    static status_t writeToByteString(const char *name, int32_t index, const T& value,
+            char **bufferpptr, char *bufferptrmax) {
         static_assert(is_item_type<T>::value);
-        const size_t len = sizeOfByteString(name, value);
+        const size_t len = sizeOfByteString(name, index, value);
         if (len > UINT16_MAX) return BAD_VALUE;
         return insert((uint16_t)len, bufferpptr, bufferptrmax)
-                ?: insert((uint8_t)get_type_of<T>::value, bufferpptr, bufferptrmax)
-                ?: insert(name, bufferpptr, bufferptrmax)
+                ?: insertTypeAndName((uint8_t)get_type_of<T>::value, name, index,
+                        bufferpptr, bufferptrmax)
                 ?: insert(value, bufferpptr, bufferptrmax);
     }
     // for speed
-    static status_t writeToByteString(
-            const char *name, const char *value, char **bufferpptr, char *bufferptrmax) {
-        const size_t len = sizeOfByteString(name, value);
+    static status_t writeToByteString(const char *name, int32_t index, const char *value,
+            char **bufferpptr, char *bufferptrmax) {
+        const size_t len = sizeOfByteString(name, index, value);
         if (len > UINT16_MAX) return BAD_VALUE;
         return insert((uint16_t)len, bufferpptr, bufferptrmax)
-                ?: insert((uint8_t)kTypeCString, bufferpptr, bufferptrmax)
-                ?: insert(name, bufferpptr, bufferptrmax)
+                ?: insertTypeAndName((uint8_t)kTypeCString, name, index,
+                        bufferpptr, bufferptrmax)
                 ?: insert(value, bufferpptr, bufferptrmax);
     }
 
@@ -546,7 +585,7 @@ protected:
  */
 class BufferedItem : public BaseItem {
 public:
-    static inline constexpr uint16_t kVersion = 0;
+    static inline constexpr uint16_t kVersion = kByteStringVersion;
 
     virtual ~BufferedItem() = default;
     BufferedItem(const BufferedItem&) = delete;
@@ -571,9 +610,10 @@ public:
 
     template<typename T>
     BufferedItem &set(const char *key, const T& value) {
-        reallocFor(sizeOfByteString(key, value));
+        const int32_t index = getDictionaryIndex(key);
+        reallocFor(sizeOfByteString(key, index, value));
         if (mStatus == NO_ERROR) {
-            mStatus = BaseItem::writeToByteString(key, value, &mBptr, mEnd);
+            mStatus = BaseItem::writeToByteString(key, index, value, &mBptr, mEnd);
             ++mPropCount;
         }
         return *this;
@@ -865,18 +905,23 @@ public:
 
         size_t getByteStringSize() const {
             return std::visit([this](auto &value) {
-                return BaseItem::sizeOfByteString(mName.c_str(), value);}, mElem);
+                return BaseItem::sizeOfByteString(
+                        mName.c_str(), BaseItem::getDictionaryIndex(mName.c_str()), value);
+            }, mElem);
         }
 
         status_t writeToByteString(char **bufferpptr, char *bufferptrmax) const {
             return std::visit([this, bufferpptr, bufferptrmax](auto &value) {
-                return BaseItem::writeToByteString(mName.c_str(), value, bufferpptr, bufferptrmax);
+                return BaseItem::writeToByteString(
+                        mName.c_str(), BaseItem::getDictionaryIndex(mName.c_str()), value,
+                        bufferpptr, bufferptrmax);
             }, mElem);
         }
 
         status_t readFromParcel(const Parcel& data);
 
-        status_t readFromByteString(const char **bufferpptr, const char *bufferptrmax);
+        status_t readFromByteString(
+                const char **bufferpptr, const char *bufferptrmax, uint16_t version);
 
     private:
         std::string mName;
@@ -0,0 +1,291 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "FrameCache"
+#include <utils/Log.h>
+
+#include "FrameCache.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include <android-base/unique_fd.h>
+#include <binder/MemoryBase.h>
+#include <binder/MemoryHeapBase.h>
+#include <cutils/properties.h>
+
+namespace android {
+
+namespace {
+
+constexpr uint32_t kMagic = 0x434d5246;  // 'FRMC'
+constexpr uint32_t kVersion = 1;
+constexpr const char *kSuffix = ".frame";
+// Trim down to this fraction of the capacity so that trimming does not run on every insert.
+constexpr size_t kTrimPercent = 90;
+
+struct Header {
+    uint32_t mMagic;
+    uint32_t mVersion;
+    FrameCache::Key mKey;
+    uint64_t mDataSize;
+};
+
+// Maps |size| bytes of |fd| and unmaps them when going out of scope.
+struct ScopedMapping {
+    ScopedMapping(int fd, size_t size, int prot) : mSize(size) {
+        mData = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+    }
+    ~ScopedMapping() {
+        if (mData != MAP_FAILED) {
+            munmap(mData, mSize);
+        }
+    }
+    bool valid() const { return mData != MAP_FAILED; }
+    uint8_t *data() const { return static_cast<uint8_t *>(mData); }
+
+private:
+    void *mData;
+    size_t mSize;
+};
+
+}  // namespace
+
+bool FrameCache::Key::setSource(int fd, int64_t offset, int64_t length) {
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    mDevice = st.st_dev;
+    mInode = st.st_ino;
+    mFileSize = st.st_size;
+    mModifiedNs = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    mOffset = offset;
+    mLength = length;
+    return true;
+}
+
+uint64_t FrameCache::Key::hash() const {
+    // FNV-1a over the fields
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            hash = (hash ^ ((value >> (8 * i)) & 0xff)) * 1099511628211ULL;
+        }
+    };
+    mix(mDevice);
+    mix(mInode);
+    mix(mFileSize);
+    mix(mModifiedNs);
+    mix(mOffset);
+    mix(mLength);
+    mix(mKind);
+    mix(mColorFormat);
+    mix(mIndex);
+    mix(mOption);
+    return hash;
+}
+
+bool FrameCache::Key::operator==(const Key &other) const {
+    return std::tie(mDevice, mInode, mFileSize, mModifiedNs, mOffset, mLength,
+                    mKind, mColorFormat, mIndex, mOption)
+            == std::tie(other.mDevice, other.mInode, other.mFileSize, other.mModifiedNs,
+                        other.mOffset, other.mLength,
+                        other.mKind, other.mColorFormat, other.mIndex, other.mOption);
+}
+
+// static
+FrameCache *FrameCache::getInstance() {
+    static FrameCache *sInstance = []() -> FrameCache * {
+        char dir[PROPERTY_VALUE_MAX];
+        if (property_get("media.stagefright.thumbnail.cache_dir", dir, "") <= 0) {
+            return nullptr;
+        }
+        int32_t sizeMb = property_get_int32("media.stagefright.thumbnail.cache_size_mb", 64);
+        if (sizeMb <= 0) {
+            return nullptr;
+        }
+        ALOGI("caching frames in %s, up to %d MB", dir, sizeMb);
+        return new FrameCache(dir, (size_t)sizeMb << 20);
+    }();
+    return sInstance;
+}
+
+FrameCache::FrameCache(const std::string &dir, size_t capacityBytes)
+    : mDir(dir),
+      mCapacityBytes(capacityBytes),
+      mScanned(false),
+      mTotalBytes(0) {
+}
+
+std::string FrameCache::pathFor(const Key &key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016" PRIx64, key.hash());
+    return mDir + "/" + name + kSuffix;
+}
+
+sp<IMemory> FrameCache::lookup(const Key &key) {
+    if (!key.hasSource()) {
+        return nullptr;
+    }
+    std::string path = pathFor(key);
+    base::unique_fd fd(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Header)) {
+        return nullptr;
+    }
+
+    ScopedMapping mapping(fd, st.st_size, PROT_READ);
+    if (!mapping.valid()) {
+        return nullptr;
+    }
+    Header header;
+    memcpy(&header, mapping.data(), sizeof(header));
+    if (header.mMagic != kMagic || header.mVersion != kVersion || !(header.mKey == key)
+            || header.mDataSize != (uint64_t)st.st_size - sizeof(Header)
+            || header.mDataSize == 0) {
+        // a hash collision or a stale entry; the next insert replaces it
+        return nullptr;
+    }
+
+    sp<MemoryHeapBase> heap = new MemoryHeapBase(header.mDataSize, 0, "FrameCache");
+    if (heap->getHeapID() < 0) {
+        return nullptr;
+    }
+    memcpy(heap->getBase(), mapping.data() + sizeof(Header), header.mDataSize);
+
+    // bump the entry in the LRU order
+    futimens(fd, nullptr);
+    ALOGV("hit %s", path.c_str());
+    return new MemoryBase(heap, 0, header.mDataSize);
+}
+
+void FrameCache::insert(const Key &key, const sp<IMemory> &frame) {
+    if (!key.hasSource() || frame == nullptr || frame->size() == 0) {
+        return;
+    }
+    const size_t dataSize = frame->size();
+    const size_t fileSize = sizeof(Header) + dataSize;
+    if (fileSize > mCapacityBytes) {
+        return;
+    }
+
+    std::string path = pathFor(key);
+    std::string tmpPath = path + "." + std::to_string(gettid()) + ".tmp";
+    {
+        base::unique_fd fd(open(tmpPath.c_str(),
+                O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR));
+        if (fd < 0) {
+            ALOGW("cannot create %s: %s", tmpPath.c_str(), strerror(errno));
+            return;
+        }
+        if (ftruncate(fd, fileSize) != 0) {
+            unlink(tmpPath.c_str());
+            return;
+        }
+        ScopedMapping mapping(fd, fileSize, PROT_READ | PROT_WRITE);
+        if (!mapping.valid()) {
+            unlink(tmpPath.c_str());
+            return;
+        }
+        Header header = {};
+        header.mMagic = kMagic;
+        header.mVersion = kVersion;
+        header.mKey = key;
+        header.mDataSize = dataSize;
+        memcpy(mapping.data(), &header, sizeof(header));
+        memcpy(mapping.data() + sizeof(Header), frame->unsecurePointer(), dataSize);
+    }
+
+    std::lock_guard<std::mutex> lock(mLock);
+    struct stat st;
+    bool replacing = (stat(path.c_str(), &st) == 0);
+    if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+        return;
+    }
+    ALOGV("stored %s (%zu bytes)", path.c_str(), fileSize);
+    if (mScanned) {
+        mTotalBytes -= replacing ? std::min<size_t>(st.st_size, mTotalBytes) : 0;
+        mTotalBytes += fileSize;
+    }
+    if (!mScanned || mTotalBytes > mCapacityBytes) {
+        trimLocked();
+    }
+}
+
+void FrameCache::trimLocked() {
+    struct Entry {
+        std::string mPath;
+        struct timespec mLastUse;
+        size_t mSize;
+    };
+    std::vector<Entry> entries;
+    size_t totalBytes = 0;
+
+    std::unique_ptr<DIR, int (*)(DIR *)> dir(opendir(mDir.c_str()), closedir);
+    if (dir == nullptr) {
+        ALOGW("cannot open %s: %s", mDir.c_str(), strerror(errno));
+        return;
+    }
+    const size_t suffixLength = strlen(kSuffix);
+    while (struct dirent *ent = readdir(dir.get())) {
+        size_t nameLength = strlen(ent->d_name);
+        if (nameLength <= suffixLength
+                || strcmp(ent->d_name + nameLength - suffixLength, kSuffix) != 0) {
+            continue;
+        }
+        std::string path = mDir + "/" + ent->d_name;
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        entries.push_back({path, st.st_mtim, (size_t)st.st_size});
+        totalBytes += st.st_size;
+    }
+
+    if (totalBytes > mCapacityBytes) {
+        std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+            return std::tie(a.mLastUse.tv_sec, a.mLastUse.tv_nsec)
+                    < std::tie(b.mLastUse.tv_sec, b.mLastUse.tv_nsec);
+        });
+        const size_t target = mCapacityBytes / 100 * kTrimPercent;
+        for (const Entry &entry : entries) {
+            if (totalBytes <= target) {
+                break;
+            }
+            if (unlink(entry.mPath.c_str()) == 0) {
+                ALOGV("evicted %s", entry.mPath.c_str());
+                totalBytes -= entry.mSize;
+            }
+        }
+    }
+    mTotalBytes = totalBytes;
+    mScanned = true;
+}
+
+}  // namespace android
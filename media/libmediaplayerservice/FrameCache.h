@@ -0,0 +1,107 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_MEDIASERVICE_FRAMECACHE_H
+#define ANDROID_MEDIASERVICE_FRAMECACHE_H
+
+#include <mutex>
+#include <string>
+
+#include <binder/IMemory.h>
+#include <utils/RefBase.h>
+
+namespace android {
+
+/**
+ * Persistent cache of decoded frames, shared by all metadata retrievers of the process.
+ *
+ * Each frame is stored in its own file under the cache directory, named after a hash of its
+ * key. The key identifies the source file by device, inode, size and modification time, so an
+ * entry is never returned for a file that changed. Files are written and read through mmap. The
+ * modification time of a cache file is its last use; the least recently used files are removed
+ * when the cache grows over its capacity.
+ *
+ * The cache is enabled by setting media.stagefright.thumbnail.cache_dir to a directory writable
+ * by the process. Its capacity is media.stagefright.thumbnail.cache_size_mb (64 MB by default).
+ */
+class FrameCache {
+public:
+    enum Kind : int32_t {
+        kKindImage = 1,
+        kKindImageThumbnail,
+        kKindVideoFrame,
+    };
+
+    struct Key {
+        // fingerprint of the source
+        uint64_t mDevice;
+        uint64_t mInode;
+        int64_t mFileSize;
+        int64_t mModifiedNs;
+        int64_t mOffset;
+        int64_t mLength;
+        // what was extracted from it
+        int32_t mKind;
+        int32_t mColorFormat;
+        int64_t mIndex;     // image index or frame time
+        int32_t mOption;    // seek option for video frames
+        int32_t mReserved;
+
+        // Fills in the source fingerprint of |fd|. Returns false if |fd| is not a regular file.
+        bool setSource(int fd, int64_t offset, int64_t length);
+        bool hasSource() const { return mDevice != 0 || mInode != 0; }
+
+        uint64_t hash() const;
+        bool operator==(const Key &other) const;
+    };
+
+    /**
+     * Returns the cache of this process, or nullptr if caching is disabled.
+     */
+    static FrameCache *getInstance();
+
+    FrameCache(const std::string &dir, size_t capacityBytes);
+
+    /**
+     * Returns the cached frame for |key|, or nullptr.
+     */
+    sp<IMemory> lookup(const Key &key);
+
+    /**
+     * Stores |frame| under |key|, evicting the least recently used frames as needed.
+     */
+    void insert(const Key &key, const sp<IMemory> &frame);
+
+private:
+    const std::string mDir;
+    const size_t mCapacityBytes;
+
+    std::mutex mLock;
+    bool mScanned;              // whether mTotalBytes was computed
+    size_t mTotalBytes;         // size of all entries in the directory
+
+    std::string pathFor(const Key &key) const;
+    // Rescans the directory, and removes the least recently used entries until the cache is
+    // below its capacity. Called with mLock held.
+    void trimLocked();
+
+    FrameCache(const FrameCache &) = delete;
+    FrameCache &operator=(const FrameCache &) = delete;
+};
+
+}  // namespace android
+
+#endif  // ANDROID_MEDIASERVICE_FRAMECACHE_H
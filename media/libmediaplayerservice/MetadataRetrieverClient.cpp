@@ -19,6 +19,7 @@
 #define LOG_TAG "MetadataRetrieverClient"
 #include <utils/Log.h>
 
+#include <inttypes.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <dirent.h>
@@ -266,6 +267,28 @@ sp<IMemory> MetadataRetrieverClient::getFrameAtIndex(
     return frame;
 }
 
+status_t MetadataRetrieverClient::getFramesAtTime(
+        const std::vector<int64_t> &timesUs, int option, int colorFormat,
+        std::vector<sp<IMemory>> *frames) {
+    ALOGV("getFramesAtTime: %zu frames, option(%d), colorFormat(%d)",
+            timesUs.size(), option, colorFormat);
+    Mutex::Autolock lock(mLock);
+    Mutex::Autolock glock(sLock);
+    if (mRetriever == NULL) {
+        ALOGE("retriever is not initialized");
+        return INVALID_OPERATION;
+    }
+
+    frames->assign(timesUs.size(), nullptr);
+    return mRetriever->getFramesAtTime(timesUs, option, colorFormat,
+            [frames, &timesUs](size_t index, const sp<IMemory> &frame) {
+                if (frame == NULL) {
+                    ALOGE("failed to extract frame at %" PRId64 " us", timesUs[index]);
+                }
+                (*frames)[index] = frame;
+            });
+}
+
 sp<IMemory> MetadataRetrieverClient::extractAlbumArt()
 {
     ALOGV("extractAlbumArt");
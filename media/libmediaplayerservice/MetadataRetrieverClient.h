@@ -58,6 +58,9 @@ public:
             int index, int colorFormat, int left, int top, int right, int bottom);
     virtual sp<IMemory>             getFrameAtIndex(
             int index, int colorFormat, bool metaOnly);
+    virtual status_t                getFramesAtTime(
+            const std::vector<int64_t> &timesUs, int option, int colorFormat,
+            std::vector<sp<IMemory>> *frames);
     virtual sp<IMemory>             extractAlbumArt();
     virtual const char*             extractMetadata(int keyCode);
 
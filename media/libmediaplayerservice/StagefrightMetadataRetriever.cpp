@@ -19,6 +19,12 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
 #include <utils/Log.h>
 #include <cutils/properties.h>
 
@@ -45,7 +51,9 @@ namespace android {
 StagefrightMetadataRetriever::StagefrightMetadataRetriever()
     : mParsedMetaData(false),
       mAlbumArt(NULL),
-      mLastDecodedIndex(-1) {
+      mLastDecodedIndex(-1),
+      mLastRect{},
+      mCacheKey{} {
     ALOGV("StagefrightMetadataRetriever()");
 }
 
@@ -64,6 +72,7 @@ status_t StagefrightMetadataRetriever::setDataSource(
     ALOGV("setDataSource(%s)", uri);
 
     clearMetadata();
+    mCacheKey = {};
     mSource = PlayerServiceDataSourceFactory::getInstance()->CreateFromURI(
             httpService, uri, headers);
 
@@ -93,6 +102,8 @@ status_t StagefrightMetadataRetriever::setDataSource(
     ALOGV("setDataSource(%d, %" PRId64 ", %" PRId64 ")", fd, offset, length);
 
     clearMetadata();
+    mCacheKey = {};
+    mCacheKey.setSource(fd, offset, length);
     mSource = new PlayerServiceFileSource(fd, offset, length);
 
     status_t err;
@@ -118,6 +129,7 @@ status_t StagefrightMetadataRetriever::setDataSource(
     ALOGV("setDataSource(DataSource)");
 
     clearMetadata();
+    mCacheKey = {};
     mSource = source;
     mExtractor = MediaExtractorFactory::Create(mSource, mime);
 
@@ -135,7 +147,15 @@ sp<IMemory> StagefrightMetadataRetriever::getImageAtIndex(
     ALOGV("getImageAtIndex: index(%d) colorFormat(%d) metaOnly(%d) thumbnail(%d)",
             index, colorFormat, metaOnly, thumbnail);
 
-    return getImageInternal(index, colorFormat, metaOnly, thumbnail, NULL);
+    if (metaOnly) {
+        return getImageInternal(index, colorFormat, metaOnly, thumbnail, NULL);
+    }
+    return getCachedFrame(
+            thumbnail ? FrameCache::kKindImageThumbnail : FrameCache::kKindImage,
+            index, 0 /* option */, colorFormat, [&] {
+                return getImageInternal(
+                        index, colorFormat, false /* metaOnly */, thumbnail, NULL);
+            });
 }
 
 sp<IMemory> StagefrightMetadataRetriever::getImageRectAtIndex(
@@ -145,8 +165,18 @@ sp<IMemory> StagefrightMetadataRetriever::getImageRectAtIndex(
 
     FrameRect rect = {left, top, right, bottom};
 
-    if (mDecoder != NULL && index == mLastDecodedIndex) {
-        return mDecoder->extractFrame(&rect);
+    // Continue with the kept decoders if |rect| is the next slice of the last one, otherwise
+    // start over, e.g. to decode another region of the image.
+    if (index == mLastDecodedIndex && rect.left == mLastRect.left
+            && rect.right == mLastRect.right && rect.top == mLastRect.bottom) {
+        sp<IMemory> frame;
+        if (mDecoder != NULL) {
+            frame = mDecoder->extractFrame(&rect);
+        } else if (!mTileDecoders.empty()) {
+            frame = extractTiles(mTileDecoders, &rect);
+        }
+        mLastRect = rect;
+        return frame;
     }
 
     return getImageInternal(
@@ -156,6 +186,7 @@ sp<IMemory> StagefrightMetadataRetriever::getImageRectAtIndex(
 sp<IMemory> StagefrightMetadataRetriever::getImageInternal(
         int index, int colorFormat, bool metaOnly, bool thumbnail, FrameRect* rect) {
     mDecoder.clear();
+    mTileDecoders.clear();
     mLastDecodedIndex = -1;
 
     if (mExtractor.get() == NULL) {
@@ -251,6 +282,21 @@ sp<IMemory> StagefrightMetadataRetriever::getImageInternal(
         return NULL;
     }
 
+    const size_t trackIndex = i;
+    int32_t numLanes = 1;
+    int32_t gridCols, gridTileWidth;
+    if (!thumbnail && isHeif && trackMeta->findInt32(kKeyGridCols, &gridCols) && gridCols > 1
+            && trackMeta->findInt32(kKeyTileWidth, &gridTileWidth) && gridTileWidth > 0) {
+        // only the tile columns overlapping |rect| are decoded
+        int32_t numCols = gridCols;
+        if (rect != NULL && rect->left >= 0 && rect->right > rect->left) {
+            numCols = std::clamp(
+                    (rect->right - 1) / gridTileWidth - rect->left / gridTileWidth + 1, 1, gridCols);
+        }
+        numLanes = std::clamp<int32_t>(property_get_int32(
+                "media.stagefright.thumbnail.max_parallel_tile_decoders", 1), 1, numCols);
+    }
+
     bool preferhw = property_get_bool(
             "media.stagefright.thumbnail.prefer_hw_codecs", false);
     uint32_t flags = preferhw ? 0 : MediaCodecList::kPreferSoftwareCodecs;
@@ -284,6 +330,17 @@ sp<IMemory> StagefrightMetadataRetriever::getImageInternal(
 
     for (size_t i = 0; i < matchingCodecs.size(); ++i) {
         const AString &componentName = matchingCodecs[i];
+        if (numLanes > 1) {
+            sp<IMemory> frame = extractImageTiles(
+                    componentName, trackMeta, trackIndex, source, numLanes, colorFormat, rect);
+            if (frame != NULL) {
+                if (rect != NULL) {
+                    mLastDecodedIndex = index;
+                    mLastRect = *rect;
+                }
+                return frame;
+            }
+        }
         sp<MediaImageDecoder> decoder = new MediaImageDecoder(componentName, trackMeta, source);
         int64_t frameTimeUs = thumbnail ? -1 : 0;
         if (decoder->init(frameTimeUs, 0 /*option*/, colorFormat) == OK) {
@@ -294,6 +351,7 @@ sp<IMemory> StagefrightMetadataRetriever::getImageInternal(
                     // keep the decoder if slice decoding
                     mDecoder = decoder;
                     mLastDecodedIndex = index;
+                    mLastRect = *rect;
                 }
                 return frame;
             }
@@ -305,12 +363,101 @@ sp<IMemory> StagefrightMetadataRetriever::getImageInternal(
     return NULL;
 }
 
+sp<IMemory> StagefrightMetadataRetriever::extractImageTiles(
+        const AString &componentName, const sp<MetaData> &trackMeta, size_t trackIndex,
+        const sp<IMediaSource> &source, int32_t numLanes, int colorFormat, FrameRect *rect) {
+    std::shared_ptr<MediaImageDecoder::SharedFrame> sharedFrame =
+            std::make_shared<MediaImageDecoder::SharedFrame>();
+    std::vector<sp<FrameDecoder>> decoders;
+    for (int32_t lane = 0; lane < numLanes; ++lane) {
+        sp<IMediaSource> laneSource = (lane == 0) ? source : mExtractor->getTrack(trackIndex);
+        if (laneSource == NULL) {
+            return NULL;
+        }
+        sp<MediaImageDecoder> decoder =
+                new MediaImageDecoder(componentName, trackMeta, laneSource);
+        decoder->setTileLane(lane, numLanes, sharedFrame);
+        if (decoder->init(0 /*frameTimeUs*/, 0 /*option*/, colorFormat) != OK) {
+            ALOGW("unable to start %d instances of %s, decoding tiles serially",
+                    numLanes, componentName.c_str());
+            return NULL;
+        }
+        decoders.push_back(decoder);
+    }
+
+    sp<IMemory> frame = extractTiles(decoders, rect);
+    if (frame != NULL && rect != NULL) {
+        // keep the decoders if slice decoding
+        mTileDecoders = std::move(decoders);
+    }
+    return frame;
+}
+
+// static
+sp<IMemory> StagefrightMetadataRetriever::extractTiles(
+        const std::vector<sp<FrameDecoder>> &decoders, FrameRect *rect) {
+    std::vector<sp<IMemory>> frames(decoders.size());
+    std::vector<std::thread> threads;
+    for (size_t k = 1; k < decoders.size(); ++k) {
+        threads.emplace_back([&, k] {
+            frames[k] = decoders[k]->extractFrame(rect);
+        });
+    }
+    frames[0] = decoders[0]->extractFrame(rect);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    // all decoders write into the same frame
+    for (const sp<IMemory> &frame : frames) {
+        if (frame == NULL) {
+            return NULL;
+        }
+    }
+    return frames[0];
+}
+
 sp<IMemory> StagefrightMetadataRetriever::getFrameAtTime(
         int64_t timeUs, int option, int colorFormat, bool metaOnly) {
     ALOGV("getFrameAtTime: %" PRId64 " us option: %d colorFormat: %d, metaOnly: %d",
             timeUs, option, colorFormat, metaOnly);
 
-    return getFrameInternal(timeUs, option, colorFormat, metaOnly);
+    if (metaOnly || option == MediaSource::ReadOptions::SEEK_FRAME_INDEX) {
+        return getFrameInternal(timeUs, option, colorFormat, metaOnly);
+    }
+    return getCachedFrame(
+            FrameCache::kKindVideoFrame, timeUs, option, colorFormat, [&] {
+                return getFrameInternal(timeUs, option, colorFormat, false /* metaOnly */);
+            });
+}
+
+sp<IMemory> StagefrightMetadataRetriever::getCachedFrame(
+        FrameCache::Kind kind, int64_t index, int option, int colorFormat,
+        const std::function<sp<IMemory>()> &extract) {
+    FrameCache *cache = FrameCache::getInstance();
+    if (cache == nullptr || !mCacheKey.hasSource()) {
+        return extract();
+    }
+
+    FrameCache::Key key = mCacheKey;
+    key.mKind = kind;
+    key.mIndex = index;
+    key.mOption = option;
+    key.mColorFormat = colorFormat;
+    sp<IMemory> frame = cache->lookup(key);
+    if (frame != nullptr) {
+        // same state as after a decode that does not keep its decoder
+        mDecoder.clear();
+        mTileDecoders.clear();
+        mLastDecodedIndex = -1;
+        return frame;
+    }
+
+    frame = extract();
+    if (frame != nullptr) {
+        cache->insert(key, frame);
+    }
+    return frame;
 }
 
 sp<IMemory> StagefrightMetadataRetriever::getFrameAtIndex(
@@ -329,21 +476,18 @@ sp<IMemory> StagefrightMetadataRetriever::getFrameAtIndex(
             MediaSource::ReadOptions::SEEK_FRAME_INDEX, colorFormat, metaOnly);
 }
 
-sp<IMemory> StagefrightMetadataRetriever::getFrameInternal(
-        int64_t timeUs, int option, int colorFormat, bool metaOnly) {
-    mDecoder.clear();
-    mLastDecodedIndex = -1;
-
+size_t StagefrightMetadataRetriever::findVideoTrack(
+        sp<MetaData> *fileMeta, sp<MetaData> *trackMeta) {
     if (mExtractor.get() == NULL) {
         ALOGE("no extractor.");
-        return NULL;
+        return 0;
     }
 
-    sp<MetaData> fileMeta = mExtractor->getMetaData();
+    *fileMeta = mExtractor->getMetaData();
 
-    if (fileMeta == NULL) {
+    if (*fileMeta == NULL) {
         ALOGE("extractor doesn't publish metadata, failed to initialize?");
-        return NULL;
+        return 0;
     }
 
     size_t n = mExtractor->countTracks();
@@ -362,12 +506,52 @@ sp<IMemory> StagefrightMetadataRetriever::getFrameInternal(
 
     if (i == n) {
         ALOGE("no video track found.");
-        return NULL;
+        return n;
     }
 
-    sp<MetaData> trackMeta = mExtractor->getTrackMetaData(
+    *trackMeta = mExtractor->getTrackMetaData(
             i, MediaExtractor::kIncludeExtensiveMetaData);
-    if (!trackMeta) {
+    return *trackMeta ? i : n;
+}
+
+// static
+status_t StagefrightMetadataRetriever::findVideoDecoders(
+        const sp<MetaData> &trackMeta, Vector<AString> *matchingCodecs) {
+    const char *mime;
+    if (!trackMeta->findCString(kKeyMIMEType, &mime)) {
+        ALOGE("video track has no mime information.");
+        return ERROR_MALFORMED;
+    }
+
+    bool preferhw = property_get_bool(
+            "media.stagefright.thumbnail.prefer_hw_codecs", false);
+    uint32_t flags = preferhw ? 0 : MediaCodecList::kPreferSoftwareCodecs;
+    sp<AMessage> format = new AMessage;
+    status_t err = convertMetaDataToMessage(trackMeta, &format);
+    if (err != OK) {
+        ALOGE("getFrameInternal: convertMetaDataToMessage() failed, unable to extract frame");
+        return err;
+    }
+
+    MediaCodecList::findMatchingCodecs(
+            mime,
+            false, /* encoder */
+            flags,
+            format,
+            matchingCodecs);
+    return OK;
+}
+
+sp<IMemory> StagefrightMetadataRetriever::getFrameInternal(
+        int64_t timeUs, int option, int colorFormat, bool metaOnly) {
+    mDecoder.clear();
+    mTileDecoders.clear();
+    mLastDecodedIndex = -1;
+
+    sp<MetaData> fileMeta;
+    sp<MetaData> trackMeta;
+    size_t i = findVideoTrack(&fileMeta, &trackMeta);
+    if (trackMeta == NULL) {
         return NULL;
     }
 
@@ -390,30 +574,11 @@ sp<IMemory> StagefrightMetadataRetriever::getFrameInternal(
         mAlbumArt = MediaAlbumArt::fromData(dataSize, data);
     }
 
-    const char *mime;
-    if (!trackMeta->findCString(kKeyMIMEType, &mime)) {
-        ALOGE("video track has no mime information.");
-        return NULL;
-    }
-
-    bool preferhw = property_get_bool(
-            "media.stagefright.thumbnail.prefer_hw_codecs", false);
-    uint32_t flags = preferhw ? 0 : MediaCodecList::kPreferSoftwareCodecs;
-    sp<AMessage> format = new AMessage;
-    status_t err = convertMetaDataToMessage(trackMeta, &format);
-    if (err != OK) {
-        ALOGE("getFrameInternal: convertMetaDataToMessage() failed, unable to extract frame");
+    Vector<AString> matchingCodecs;
+    if (findVideoDecoders(trackMeta, &matchingCodecs) != OK) {
         return NULL;
     }
 
-    Vector<AString> matchingCodecs;
-    MediaCodecList::findMatchingCodecs(
-            mime,
-            false, /* encoder */
-            flags,
-            format,
-            &matchingCodecs);
-
     for (size_t i = 0; i < matchingCodecs.size(); ++i) {
         const AString &componentName = matchingCodecs[i];
         sp<VideoFrameDecoder> decoder = new VideoFrameDecoder(componentName, trackMeta, source);
@@ -435,6 +600,82 @@ sp<IMemory> StagefrightMetadataRetriever::getFrameInternal(
     return NULL;
 }
 
+status_t StagefrightMetadataRetriever::getFramesAtTime(
+        const std::vector<int64_t> &timesUs, int option, int colorFormat,
+        const std::function<void(size_t, const sp<IMemory> &)> &onFrame) {
+    mDecoder.clear();
+    mTileDecoders.clear();
+    mLastDecodedIndex = -1;
+
+    sp<MetaData> fileMeta;
+    sp<MetaData> trackMeta;
+    size_t trackIndex = findVideoTrack(&fileMeta, &trackMeta);
+    if (trackMeta == NULL) {
+        return NAME_NOT_FOUND;
+    }
+    Vector<AString> matchingCodecs;
+    status_t err = findVideoDecoders(trackMeta, &matchingCodecs);
+    if (err != OK) {
+        return err;
+    }
+
+    // Each worker has its own track source and decoder instance. The number of workers is kept
+    // small as every decoder instance counts against the codec resources of the device.
+    int32_t maxWorkers = property_get_int32(
+            "media.stagefright.thumbnail.max_parallel_decoders", 2);
+    size_t numWorkers = std::min(timesUs.size(), (size_t)std::max(maxWorkers, 1));
+    std::vector<sp<IMediaSource>> sources;
+    for (size_t i = 0; i < numWorkers; ++i) {
+        sp<IMediaSource> source = mExtractor->getTrack(trackIndex);
+        if (source == NULL) {
+            break;
+        }
+        sources.push_back(source);
+    }
+    if (sources.empty()) {
+        ALOGV("unable to instantiate video track.");
+        return UNKNOWN_ERROR;
+    }
+
+    // hand out the requests in presentation order so that each worker mostly seeks forward
+    std::vector<size_t> order(timesUs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&timesUs](size_t a, size_t b) {
+        return timesUs[a] < timesUs[b];
+    });
+
+    std::atomic<size_t> next{0};
+    std::mutex callbackLock;
+    auto work = [&](const sp<IMediaSource> &source) {
+        size_t i;
+        while ((i = next++) < order.size()) {
+            int64_t timeUs = timesUs[order[i]];
+            sp<IMemory> frame;
+            for (size_t j = 0; j < matchingCodecs.size() && frame == nullptr; ++j) {
+                sp<VideoFrameDecoder> decoder =
+                    new VideoFrameDecoder(matchingCodecs[j], trackMeta, source);
+                if (decoder->init(timeUs, option, colorFormat) == OK) {
+                    frame = decoder->extractFrame();
+                }
+            }
+            if (frame == nullptr) {
+                ALOGE("all codecs failed to extract frame at %" PRId64 " us.", timeUs);
+            }
+            std::lock_guard<std::mutex> lock(callbackLock);
+            onFrame(order[i], frame);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < sources.size(); ++i) {
+        workers.emplace_back(work, sources[i]);
+    }
+    work(sources[0]);
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    return OK;
+}
+
 MediaAlbumArt *StagefrightMetadataRetriever::extractAlbumArt() {
     ALOGV("extractAlbumArt (extractor: %s)", mExtractor.get() != NULL ? "YES" : "NO");
 
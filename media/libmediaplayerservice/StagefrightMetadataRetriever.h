@@ -18,16 +18,20 @@
 
 #define STAGEFRIGHT_METADATA_RETRIEVER_H_
 
+#include <vector>
+
 #include <android/IMediaExtractor.h>
 #include <media/MediaMetadataRetrieverInterface.h>
 
 #include <utils/KeyedVector.h>
 
+#include "FrameCache.h"
+#include "FrameDecoder.h"
+
 namespace android {
 
 class DataSource;
-struct FrameDecoder;
-struct FrameRect;
+struct AString;
 
 struct StagefrightMetadataRetriever : public MediaMetadataRetrieverBase {
     StagefrightMetadataRetriever();
@@ -49,6 +53,9 @@ struct StagefrightMetadataRetriever : public MediaMetadataRetrieverBase {
             int index, int colorFormat, int left, int top, int right, int bottom);
     virtual sp<IMemory> getFrameAtIndex(
             int index, int colorFormat, bool metaOnly);
+    virtual status_t getFramesAtTime(
+            const std::vector<int64_t> &timesUs, int option, int colorFormat,
+            const std::function<void(size_t, const sp<IMemory> &)> &onFrame) override;
 
     virtual MediaAlbumArt *extractAlbumArt();
     virtual const char *extractMetadata(int keyCode);
@@ -62,7 +69,14 @@ private:
     MediaAlbumArt *mAlbumArt;
 
     sp<FrameDecoder> mDecoder;
+    // decoders sharing the tile columns of the image being decoded by slices, if any
+    std::vector<sp<FrameDecoder>> mTileDecoders;
     int mLastDecodedIndex;
+    // last slice decoded by the kept decoders
+    FrameRect mLastRect;
+
+    // identifies the source in FrameCache; only file descriptor sources are cached
+    FrameCache::Key mCacheKey;
     void parseMetaData();
     void parseColorAspects(const sp<MetaData>& meta);
     // Delete album art and clear metadata.
@@ -71,9 +85,30 @@ private:
     sp<IMemory> getFrameInternal(
             int64_t timeUs, int option, int colorFormat, bool metaOnly);
 
+    // Finds the first video track. Returns its index, or the number of tracks if none is found.
+    size_t findVideoTrack(sp<MetaData> *fileMeta, sp<MetaData> *trackMeta);
+    // Returns the decoders to try for |trackMeta|, in order.
+    static status_t findVideoDecoders(
+            const sp<MetaData> &trackMeta, Vector<AString> *matchingCodecs);
+
     sp<IMemory> getImageInternal(
             int index, int colorFormat, bool metaOnly, bool thumbnail, FrameRect* rect);
 
+    // Decodes the grid image of track |trackIndex| with |numLanes| instances of |componentName|,
+    // each decoding every numLanes-th tile column. Returns NULL if not all instances can be set
+    // up, in which case the caller falls back to a single decoder.
+    sp<IMemory> extractImageTiles(
+            const AString &componentName, const sp<MetaData> &trackMeta, size_t trackIndex,
+            const sp<IMediaSource> &source, int32_t numLanes, int colorFormat, FrameRect *rect);
+    // Runs extractFrame(|rect|) on all |decoders| in parallel.
+    static sp<IMemory> extractTiles(
+            const std::vector<sp<FrameDecoder>> &decoders, FrameRect *rect);
+
+    // Returns the frame cached for the current source, or stores the result of |extract|.
+    sp<IMemory> getCachedFrame(
+            FrameCache::Kind kind, int64_t index, int option, int colorFormat,
+            const std::function<sp<IMemory>()> &extract);
+
     StagefrightMetadataRetriever(const StagefrightMetadataRetriever &);
 
     StagefrightMetadataRetriever &operator=(
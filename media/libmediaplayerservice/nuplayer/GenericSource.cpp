@@ -346,6 +346,12 @@ NuPlayer::GenericSource::~GenericSource() {
         mLooper->unregisterHandler(id());
         mLooper->stop();
     }
+    for (Track *track : {&mAudioTrack, &mVideoTrack}) {
+        if (track->mReadLooper != NULL) {
+            track->mReadLooper->unregisterHandler(track->mReader->id());
+            track->mReadLooper->stop();
+        }
+    }
     resetDataSource();
 }
 
@@ -448,8 +454,26 @@ void NuPlayer::GenericSource::onPrepareAsync() {
         mCachedSource = static_cast<NuCachedSource2 *>(mDataSource.get());
     }
 
+    bool isHTTP = (mHttpSource != NULL);
     mDisconnectLock.unlock();
 
+    if (mCachedSource != NULL && isHTTP
+            && property_get_bool("media.stagefright.cache-range-reads", true)) {
+        // A second connection lets the extractor read the index of files
+        // that keep it at the end while the cache fetches the media data.
+        sp<DataSource> rangeSource = PlayerServiceDataSourceFactory::getInstance()
+                ->CreateMediaHTTP(mHTTPService);
+        if (rangeSource != NULL) {
+            KeyedVector<String8, String8> headers = mUriHeaders;
+            String8 cacheConfig;
+            bool disconnectAtHighwatermark;
+            NuCachedSource2::RemoveCacheSpecificHeaders(
+                    &headers, &cacheConfig, &disconnectAtHighwatermark);
+            mCachedSource->setRangeSource(
+                    static_cast<HTTPBase *>(rangeSource.get()), mUri.c_str(), &headers);
+        }
+    }
+
     // For cached streaming cases, we need to wait for enough
     // buffering before reporting prepared.
     mIsStreaming = (mCachedSource != NULL);
@@ -663,12 +687,15 @@ void NuPlayer::GenericSource::onMessageReceived(const sp<AMessage> &msg) {
               counterpartType = MEDIA_TRACK_TYPE_AUDIO;;
           }
 
-
-          if (track->mSource != NULL) {
-              track->mSource->stop();
+          {
+              // The track may be in the middle of a read on its own looper.
+              Mutex::Autolock _rl(mReadLock);
+              if (track->mSource != NULL) {
+                  track->mSource->stop();
+              }
+              track->mSource = source;
+              track->mSource->start();
           }
-          track->mSource = source;
-          track->mSource->start();
           track->mIndex = trackIndex;
           ++mAudioDataGeneration;
           ++mVideoDataGeneration;
@@ -855,6 +882,7 @@ status_t NuPlayer::GenericSource::dequeueAccessUnit(
     status_t finalResult;
     if (!track->mPackets->hasBufferAvailable(&finalResult)) {
         if (finalResult == OK) {
+            ++track->mReadStats.mUnderruns;
             postReadBuffer(
                     audio ? MEDIA_TRACK_TYPE_AUDIO : MEDIA_TRACK_TYPE_VIDEO);
             return -EWOULDBLOCK;
@@ -1312,17 +1340,55 @@ int32_t NuPlayer::GenericSource::getDataGeneration(media_track_type type) const
 void NuPlayer::GenericSource::postReadBuffer(media_track_type trackType) {
     if ((mPendingReadBufferTypes & (1 << trackType)) == 0) {
         mPendingReadBufferTypes |= (1 << trackType);
-        sp<AMessage> msg = new AMessage(kWhatReadBuffer, this);
+        sp<AMessage> msg = new AMessage(kWhatReadBuffer, getReadHandler_l(trackType));
         msg->setInt32("trackType", trackType);
+        msg->setInt64("postTimeUs", ALooper::GetNowUs());
         msg->post();
     }
 }
 
+sp<AHandler> NuPlayer::GenericSource::getReadHandler_l(media_track_type trackType) {
+    Track *track;
+    const char *name;
+    switch (trackType) {
+        case MEDIA_TRACK_TYPE_VIDEO:
+            track = &mVideoTrack;
+            name = "generic-video";
+            break;
+        case MEDIA_TRACK_TYPE_AUDIO:
+            track = &mAudioTrack;
+            name = "generic-audio";
+            break;
+        default:
+            return this;
+    }
+
+    if (track->mReadLooper == NULL) {
+        track->mReadLooper = new ALooper;
+        track->mReadLooper->setName(name);
+        track->mReadLooper->start();
+
+        track->mReader = new AHandlerReflector<GenericSource>(this);
+        track->mReadLooper->registerHandler(track->mReader);
+    }
+    return track->mReader;
+}
+
 void NuPlayer::GenericSource::onReadBuffer(const sp<AMessage>& msg) {
     int32_t tmpType;
     CHECK(msg->findInt32("trackType", &tmpType));
     media_track_type trackType = (media_track_type)tmpType;
     mPendingReadBufferTypes &= ~(1 << trackType);
+
+    int64_t postTimeUs;
+    if (msg->findInt64("postTimeUs", &postTimeUs)) {
+        Track *track = trackType == MEDIA_TRACK_TYPE_AUDIO ? &mAudioTrack : &mVideoTrack;
+        const int64_t queueTimeUs = ALooper::GetNowUs() - postTimeUs;
+        ++track->mReadStats.mRequests;
+        track->mReadStats.mQueueTimeUs += queueTimeUs;
+        track->mReadStats.mMaxQueueTimeUs =
+                std::max(track->mReadStats.mMaxQueueTimeUs, queueTimeUs);
+    }
     readBuffer(trackType);
 }
 
@@ -1379,18 +1445,28 @@ void NuPlayer::GenericSource::readBuffer(
 
         sp<IMediaSource> source = track->mSource;
         mLock.unlock();
-        if (couldReadMultiple) {
-            err = source->readMultiple(
-                    &mediaBuffers, maxBuffers - numBuffers, &options);
-        } else {
-            MediaBufferBase *mbuf = NULL;
-            err = source->read(&mbuf, &options);
-            if (err == OK && mbuf != NULL) {
-                mediaBuffers.push_back(mbuf);
+        int64_t readTimeUs;
+        {
+            Mutex::Autolock _rl(mReadLock);
+            const int64_t startUs = ALooper::GetNowUs();
+            if (couldReadMultiple) {
+                err = source->readMultiple(
+                        &mediaBuffers, maxBuffers - numBuffers, &options);
+            } else {
+                MediaBufferBase *mbuf = NULL;
+                err = source->read(&mbuf, &options);
+                if (err == OK && mbuf != NULL) {
+                    mediaBuffers.push_back(mbuf);
+                }
             }
+            readTimeUs = ALooper::GetNowUs() - startUs;
         }
         mLock.lock();
 
+        ++track->mReadStats.mReads;
+        track->mReadStats.mReadTimeUs += readTimeUs;
+        track->mReadStats.mMaxReadTimeUs = std::max(track->mReadStats.mMaxReadTimeUs, readTimeUs);
+
         options.clearNonPersistent();
 
         size_t id = 0;
@@ -1438,6 +1514,7 @@ void NuPlayer::GenericSource::readBuffer(
             formatChange = false;
             seeking = false;
             ++numBuffers;
+            ++track->mReadStats.mBuffers;
         }
         if (id < count) {
             // Error, some mediaBuffer doesn't have kKeyTime.
@@ -1720,4 +1797,47 @@ void NuPlayer::GenericSource::signalBufferReturned(MediaBufferBase *buffer)
     buffer->release(); // this leads to delete since that there is no observor
 }
 
+void NuPlayer::GenericSource::dump(AString& logString) {
+    // Don't wait behind a prepare stuck on the network.
+    if (mLock.tryLock() != NO_ERROR) {
+        logString.append("lock is taken");
+        return;
+    }
+    const char *separator = "";
+    for (const Track *track : {&mAudioTrack, &mVideoTrack}) {
+        if (track->mSource == NULL) {
+            continue;
+        }
+        const ReadStats &stats = track->mReadStats;
+        logString.append(separator);
+        logString.append(track == &mAudioTrack ? "audio(" : "video(");
+        if (track->mPackets != NULL) {
+            status_t finalResult;
+            logString.append("bufferedUs=");
+            logString.append((long long)track->mPackets->getBufferedDurationUs(&finalResult));
+            logString.append(", ");
+        }
+        logString.append("requests=");
+        logString.append((long long)stats.mRequests);
+        logString.append(", reads=");
+        logString.append((long long)stats.mReads);
+        logString.append(", buffers=");
+        logString.append((long long)stats.mBuffers);
+        logString.append(", underruns=");
+        logString.append((long long)stats.mUnderruns);
+        logString.append(", readUs(avg=");
+        logString.append((long long)(stats.mReads == 0 ? 0 : stats.mReadTimeUs / stats.mReads));
+        logString.append(", max=");
+        logString.append((long long)stats.mMaxReadTimeUs);
+        logString.append("), queueUs(avg=");
+        logString.append((long long)(stats.mRequests == 0
+                ? 0 : stats.mQueueTimeUs / stats.mRequests));
+        logString.append(", max=");
+        logString.append((long long)stats.mMaxQueueTimeUs);
+        logString.append("))");
+        separator = ", ";
+    }
+    mLock.unlock();
+}
+
 }  // namespace android
@@ -180,6 +180,10 @@ NuPlayer::NuPlayer(pid_t pid, const sp<MediaClock> &mediaClock)
       mMediaClock(mediaClock),
       mSourceFlags(0),
       mOffloadAudio(false),
+      mOffloadDisabledByError(false),
+      mOffloadRetries(0),
+      mOffloadFallbacks(0),
+      mOffloadRecoveries(0),
       mAudioDecoderGeneration(0),
       mVideoDecoderGeneration(0),
       mRendererGeneration(0),
@@ -1340,6 +1344,11 @@ void NuPlayer::onMessageReceived(const sp<AMessage> &msg) {
                 if (!msg->findInt64("positionUs", &positionUs)) {
                     positionUs = mPreviousSeekTimeUs;
                 }
+                if (reason == Renderer::kForceNonOffload) {
+                    // The offload sink couldn't be opened, which may be transient.
+                    mOffloadDisabledByError = true;
+                    ++mOffloadFallbacks;
+                }
 
                 restartAudio(
                         positionUs, reason == Renderer::kForceNonOffload /* forceNonOffload */,
@@ -1512,6 +1521,7 @@ void NuPlayer::onResume() {
     if (audioDecoderStillNeeded() && mAudioDecoder == NULL) {
         instantiateDecoder(true /* audio */, &mAudioDecoder);
     }
+    retryOffloadAudioIfNeeded();
     if (mRenderer != NULL) {
         mRenderer->resume();
     } else {
@@ -1566,6 +1576,8 @@ void NuPlayer::onStart(int64_t startPositionUs, MediaPlayerSeekMode mode) {
     }
 
     mOffloadAudio = false;
+    mOffloadDisabledByError = false;
+    mOffloadRetries = 0;
     mAudioEOS = false;
     mVideoEOS = false;
     mStarted = true;
@@ -1891,6 +1903,36 @@ void NuPlayer::restartAudio(
     }
 }
 
+// Audio falls back to PCM when the offload sink can't be opened, for instance when the
+// offload resources are all in use. That may not last, so offload is given another chance
+// when resuming, while the sink is stopped and restarting audio can't be heard.
+void NuPlayer::retryOffloadAudioIfNeeded() {
+    static const int32_t kMaxOffloadRetries = 3;
+    if (!mOffloadDisabledByError || mOffloadAudio || mOffloadRetries >= kMaxOffloadRetries
+            || mAudioDecoder == NULL || mVideoDecoder != NULL || mRenderer == NULL) {
+        return;
+    }
+    mOffloadDisabledByError = false;
+    ++mOffloadRetries;
+
+    int64_t currentPositionUs;
+    if (getCurrentPosition(&currentPositionUs) != OK) {
+        currentPositionUs = mPreviousSeekTimeUs;
+    }
+    restartAudio(currentPositionUs, false /* forceNonOffload */,
+            true /* needsToCreateAudioDecoder */);
+    ALOGI("retryOffloadAudioIfNeeded: attempt %d %s", mOffloadRetries,
+            mOffloadAudio ? "succeeded" : "failed");
+    if (mOffloadAudio) {
+        ++mOffloadRecoveries;
+    }
+}
+
+void NuPlayer::getAudioOffloadStats(int32_t *fallbacks, int32_t *recoveries) {
+    *fallbacks = mOffloadFallbacks;
+    *recoveries = mOffloadRecoveries;
+}
+
 void NuPlayer::determineAudioModeChange(const sp<AMessage> &audioFormat) {
     if (mSource == NULL || mAudioSink == NULL) {
         return;
@@ -3046,6 +3088,17 @@ const char *NuPlayer::getDataSourceType() {
     } else {
         logString.append("null");
     }
+    logString.append("), source(");
+    sp<Source> source;
+    {
+        Mutex::Autolock autoLock(mSourceLock);
+        source = mSource;
+    }
+    if (source != nullptr) {
+        source->dump(logString);
+    } else {
+        logString.append("null");
+    }
     logString.append(")");
  }
 
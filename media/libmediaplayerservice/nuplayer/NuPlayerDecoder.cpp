@@ -55,6 +55,10 @@ static inline bool getAudioDeepBufferSetting() {
     return property_get_bool("media.stagefright.audio.deep", false /* default_value */);
 }
 
+static inline bool getVideoRenderFeedbackSetting() {
+    return property_get_bool("media.stagefright.video.render_feedback", false /* default_value */);
+}
+
 NuPlayer::Decoder::Decoder(
         const sp<AMessage> &notify,
         const sp<Source> &source,
@@ -89,7 +93,8 @@ NuPlayer::Decoder::Decoder(
       mNumVideoTemporalLayerAllowed(1),
       mCurrentMaxVideoTemporalLayerId(0),
       mResumePending(false),
-      mComponentName("decoder") {
+      mComponentName("decoder"),
+      mRenderFeedbackEnabled(false) {
     mCodecLooper = new ALooper;
     mCodecLooper->setName("NPDecoder-CL");
     mCodecLooper->start(false, false, ANDROID_PRIORITY_AUDIO);
@@ -217,6 +222,12 @@ void NuPlayer::Decoder::onMessageReceived(const sp<AMessage> &msg) {
             break;
         }
 
+        case kWhatFrameRendered:
+        {
+            onFrameRendered(msg);
+            break;
+        }
+
         case kWhatAudioOutputFormatChanged:
         {
             if (!isStaleReply(msg)) {
@@ -381,6 +392,13 @@ void NuPlayer::Decoder::onConfigure(const sp<AMessage> &format) {
     sp<AMessage> reply = new AMessage(kWhatCodecNotify, this);
     mCodec->setCallback(reply);
 
+    mPendingRenderTimesNs.clear();
+    mRenderFeedbackEnabled =
+            !mIsAudio && mSurface != NULL && getVideoRenderFeedbackSetting();
+    if (mRenderFeedbackEnabled) {
+        mCodec->setOnFrameRenderedNotification(new AMessage(kWhatFrameRendered, this));
+    }
+
     err = mCodec->start();
     if (err != OK) {
         ALOGE("Failed to start [%s] decoder (err=%d)", mComponentName.c_str(), err);
@@ -512,6 +530,7 @@ void NuPlayer::Decoder::doFlush(bool notifyComplete) {
         // we attempt to release the buffers even if flush fails.
     }
     releaseAndResetMediaBuffers();
+    mPendingRenderTimesNs.clear();
     mPaused = true;
 }
 
@@ -1180,8 +1199,8 @@ void NuPlayer::Decoder::onRenderBuffer(const sp<AMessage> &msg) {
     size_t size;
     CHECK(msg->findSize("buffer-ix", &bufferIx));
 
+    int64_t timeUs = -1;
     if (!mIsAudio) {
-        int64_t timeUs;
         sp<MediaCodecBuffer> buffer = mOutputBuffers[bufferIx];
         buffer->meta()->findInt64("timeUs", &timeUs);
 
@@ -1196,6 +1215,13 @@ void NuPlayer::Decoder::onRenderBuffer(const sp<AMessage> &msg) {
         int64_t timestampNs;
         CHECK(msg->findInt64("timestampNs", &timestampNs));
         err = mCodec->renderOutputBufferAndRelease(bufferIx, timestampNs);
+        if (err == OK && timeUs >= 0 && mRenderFeedbackEnabled) {
+            if (mPendingRenderTimesNs.size() >= kMaxPendingRenderTimes) {
+                // frames that were never reported as rendered
+                mPendingRenderTimesNs.erase(mPendingRenderTimesNs.begin());
+            }
+            mPendingRenderTimesNs[timeUs] = timestampNs;
+        }
     } else {
         if (!msg->findInt32("eos", &eos) || !eos ||
                 !msg->findSize("size", &size) || size) {
@@ -1214,6 +1240,27 @@ void NuPlayer::Decoder::onRenderBuffer(const sp<AMessage> &msg) {
     }
 }
 
+void NuPlayer::Decoder::onFrameRendered(const sp<AMessage> &msg) {
+    if (!mRenderFeedbackEnabled || mRenderer == NULL) {
+        return;
+    }
+    for (size_t index = 0; ; ++index) {
+        int64_t mediaTimeUs, presentTimeNs;
+        if (!msg->findInt64(AStringPrintf("%zu-media-time-us", index).c_str(), &mediaTimeUs)
+                || !msg->findInt64(
+                        AStringPrintf("%zu-system-nano", index).c_str(), &presentTimeNs)) {
+            break;
+        }
+        auto it = mPendingRenderTimesNs.find(mediaTimeUs);
+        if (it == mPendingRenderTimesNs.end()) {
+            continue;
+        }
+        mRenderer->notifyVideoFramePresented(it->second, presentTimeNs);
+        // frames are presented in order; anything older has been dropped by the surface
+        mPendingRenderTimesNs.erase(mPendingRenderTimesNs.begin(), ++it);
+    }
+}
+
 bool NuPlayer::Decoder::isDiscontinuityPending() const {
     return mFormatChangePending || mTimeChangePending;
 }
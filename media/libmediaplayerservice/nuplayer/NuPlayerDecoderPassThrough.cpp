@@ -26,6 +26,7 @@
 
 #include <mediadrm/ICrypto.h>
 #include <media/MediaCodecBuffer.h>
+#include <cutils/properties.h>
 #include <media/stagefright/foundation/ABuffer.h>
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/AMessage.h>
@@ -38,6 +39,14 @@ namespace android {
 // The offload read buffer size is 32 KB but 24 KB uses less power.
 static const size_t kAggregateBufferSizeBytes = 24 * 1024;
 static const size_t kMaxCachedBytes = 200000;
+// Without video nor network source, start up latency matters less than the wakeups, so
+// larger chunks are sent to the renderer.
+static const size_t kLargeAggregateBufferSizeBytes = 64 * 1024;
+static const size_t kLargeMaxCachedBytes = 500000;
+
+static inline bool getLargeChunksSetting() {
+    return property_get_bool("media.stagefright.passthrough.large_chunks", true /* default */);
+}
 
 NuPlayer::DecoderPassThrough::DecoderPassThrough(
         const sp<AMessage> &notify,
@@ -51,6 +60,8 @@ NuPlayer::DecoderPassThrough::DecoderPassThrough(
       mPendingAudioErr(OK),
       mPendingBuffersToDrain(0),
       mCachedBytes(0),
+      mAggregateBufferSizeBytes(kAggregateBufferSizeBytes),
+      mMaxCachedBytes(kMaxCachedBytes),
       mComponentName("pass through decoder") {
     ALOGW_IF(renderer == NULL, "expect a non-NULL renderer");
 }
@@ -65,11 +76,18 @@ void NuPlayer::DecoderPassThrough::onConfigure(const sp<AMessage> &format) {
     mReachedEOS = false;
     ++mBufferGeneration;
 
-    onRequestInputBuffers();
-
     int32_t hasVideo = 0;
     format->findInt32("has-video", &hasVideo);
 
+    const bool largeChunks = !hasVideo && !mSource->isStreaming() && getLargeChunksSetting();
+    mAggregateBufferSizeBytes = largeChunks
+            ? kLargeAggregateBufferSizeBytes : kAggregateBufferSizeBytes;
+    mMaxCachedBytes = largeChunks ? kLargeMaxCachedBytes : kMaxCachedBytes;
+    ALOGV("[%s] onConfigure: %zu bytes chunks", mComponentName.c_str(),
+            mAggregateBufferSizeBytes);
+
+    onRequestInputBuffers();
+
     // The audio sink is already opened before the PassThrough decoder is created.
     // Opening again might be relevant if decoder is instantiated after shutdown and
     // format is different.
@@ -102,7 +120,7 @@ bool NuPlayer::DecoderPassThrough::isDoneFetching() const {
     ALOGV("[%s] mCachedBytes = %zu, mReachedEOS = %d mPaused = %d",
             mComponentName.c_str(), mCachedBytes, mReachedEOS, mPaused);
 
-    return mCachedBytes >= kMaxCachedBytes || mReachedEOS || mPaused;
+    return mCachedBytes >= mMaxCachedBytes || mReachedEOS || mPaused;
 }
 
 /*
@@ -167,9 +185,9 @@ sp<ABuffer> NuPlayer::DecoderPassThrough::aggregateBuffer(
     size_t smallSize = accessUnit->size();
     if ((mAggregateBuffer == NULL)
             // Don't bother if only room for a few small buffers.
-            && (smallSize < (kAggregateBufferSizeBytes / 3))) {
+            && (smallSize < (mAggregateBufferSizeBytes / 3))) {
         // Create a larger buffer for combining smaller buffers from the extractor.
-        mAggregateBuffer = new ABuffer(kAggregateBufferSizeBytes);
+        mAggregateBuffer = new ABuffer(mAggregateBufferSizeBytes);
         mAggregateBuffer->setRange(0, 0); // start empty
     }
 
@@ -68,6 +68,9 @@ static const char *kPlayerDataSourceType = "android.media.mediaplayer.dataSource
 static const char *kPlayerRebuffering = "android.media.mediaplayer.rebufferingMs";
 static const char *kPlayerRebufferingCount = "android.media.mediaplayer.rebuffers";
 static const char *kPlayerRebufferingAtExit = "android.media.mediaplayer.rebufferExit";
+static const char *kPlayerAOffloadFallbacks = "android.media.mediaplayer.audio.offloadFallbacks";
+static const char *kPlayerAOffloadRecoveries =
+        "android.media.mediaplayer.audio.offloadRecoveries";
 
 
 NuPlayerDriver::NuPlayerDriver(pid_t pid)
@@ -611,6 +614,13 @@ void NuPlayerDriver::updateMetrics(const char *where) {
 
     mMetricsItem->setCString(kPlayerDataSourceType, mPlayer->getDataSourceType());
 
+    int32_t offloadFallbacks, offloadRecoveries;
+    mPlayer->getAudioOffloadStats(&offloadFallbacks, &offloadRecoveries);
+    if (offloadFallbacks != 0) {
+        mMetricsItem->setInt32(kPlayerAOffloadFallbacks, offloadFallbacks);
+        mMetricsItem->setInt32(kPlayerAOffloadRecoveries, offloadRecoveries);
+    }
+
     if (trackStats.size() > 0) {
         for (size_t i = 0; i < trackStats.size(); ++i) {
             const sp<AMessage> &stats = trackStats.itemAt(i);
@@ -69,6 +69,15 @@ static inline int32_t getAudioSinkPcmMsSetting() {
             "media.stagefright.audio.sink", 500 /* default_value */);
 }
 
+static inline bool getPowerEfficientDrainSetting() {
+    return property_get_bool(
+            "media.stagefright.audio.power_efficient_drain", false /* default_value */);
+}
+
+// In power efficient drain mode, the audio queue is drained when the sink has about this
+// much left to play, so that the buffers queued meanwhile are written in one wakeup.
+static const int64_t kPowerEfficientDrainMarginUs = 200000LL;
+
 // Maximum time in paused state when offloading audio decompression. When elapsed, the AudioSink
 // is closed to allow the audio DSP to power down.
 static const int64_t kOffloadPauseMaxUs = 10000000LL;
@@ -162,6 +171,7 @@ NuPlayer::Renderer::Renderer(
       mTotalBuffersQueued(0),
       mLastAudioBufferDrained(0),
       mUseAudioCallback(false),
+      mPowerEfficientDrain(false),
       mWakeLock(new AWakeLock()),
       mNeedVideoClearAnchor(false) {
     CHECK(mediaClock != NULL);
@@ -389,6 +399,13 @@ void NuPlayer::Renderer::setVideoFrameRate(float fps) {
     msg->post();
 }
 
+void NuPlayer::Renderer::notifyVideoFramePresented(int64_t renderTimeNs, int64_t presentTimeNs) {
+    sp<AMessage> msg = new AMessage(kWhatVideoFramePresented, this);
+    msg->setInt64("render-time-ns", renderTimeNs);
+    msg->setInt64("present-time-ns", presentTimeNs);
+    msg->post();
+}
+
 // Called on any threads without mLock acquired.
 status_t NuPlayer::Renderer::getCurrentPosition(int64_t *mediaUs) {
     status_t result = mMediaClock->getMediaTime(ALooper::GetNowUs(), mediaUs);
@@ -502,6 +519,12 @@ void NuPlayer::Renderer::dump(AString& logString) {
     mWakelockReleaseEvent.dump(logString);
     logString.append(", cancel=");
     mWakelockCancelEvent.dump(logString);
+    logString.append("), audioDrain(powerEfficient=");
+    logString.append(mPowerEfficientDrain);
+    logString.append(", wakeups=");
+    logString.append((long long)mAudioDrainWakeups.load());
+    logString.append(", writes=");
+    logString.append((long long)mAudioSinkWrites.load());
     logString.append(")");
 }
 
@@ -621,28 +644,15 @@ void NuPlayer::Renderer::onMessageReceived(const sp<AMessage> &msg) {
                 break;
             }
 
+            ++mAudioDrainWakeups;
             if (onDrainAudioQueue()) {
-                uint32_t numFramesPlayed;
-                CHECK_EQ(mAudioSink->getPosition(&numFramesPlayed),
-                         (status_t)OK);
-
-                // Handle AudioTrack race when start is immediately called after flush.
-                uint32_t numFramesPendingPlayout =
-                    (mNumFramesWritten > numFramesPlayed ?
-                        mNumFramesWritten - numFramesPlayed : 0);
-
                 // This is how long the audio sink will have data to
                 // play back.
-                int64_t delayUs =
-                    mAudioSink->msecsPerFrame()
-                        * numFramesPendingPlayout * 1000LL;
-                if (mPlaybackRate > 1.0f) {
-                    delayUs /= mPlaybackRate;
-                }
+                const int64_t pendingUs = getAudioSinkPendingDurationUs();
 
                 // Let's give it more data after about half that time
-                // has elapsed.
-                delayUs /= 2;
+                // has elapsed, or later when draining in batches.
+                int64_t delayUs = std::max(pendingUs / 2, getPowerEfficientDrainDelayUs(pendingUs));
                 // check the buffer size to estimate maximum delay permitted.
                 const int64_t maxDrainDelayUs = std::max(
                         mAudioSink->getBufferDurationInUs(), (int64_t)500000 /* half second */);
@@ -806,6 +816,15 @@ void NuPlayer::Renderer::onMessageReceived(const sp<AMessage> &msg) {
             break;
         }
 
+        case kWhatVideoFramePresented:
+        {
+            int64_t renderTimeNs, presentTimeNs;
+            CHECK(msg->findInt64("render-time-ns", &renderTimeNs));
+            CHECK(msg->findInt64("present-time-ns", &presentTimeNs));
+            onVideoFramePresented(renderTimeNs, presentTimeNs);
+            break;
+        }
+
         case kWhatAudioTearDown:
         {
             int32_t reason;
@@ -1166,6 +1185,7 @@ bool NuPlayer::Renderer::onDrainAudioQueue() {
 
         ssize_t written = mAudioSink->write(entry->mBuffer->data() + entry->mOffset,
                                             copy, false /* blocking */);
+        ++mAudioSinkWrites;
         if (written < 0) {
             // An error in AudioSink write. Perhaps the AudioSink was not properly opened.
             if (written == WOULD_BLOCK) {
@@ -1255,6 +1275,35 @@ int64_t NuPlayer::Renderer::getDurationUsIfPlayedAtSampleRate(uint32_t numFrames
     return (int64_t)(numFrames * 1000000LL / sampleRate);
 }
 
+// Returns how long the audio sink will have data to play back, 0 if unknown.
+int64_t NuPlayer::Renderer::getAudioSinkPendingDurationUs() {
+    uint32_t numFramesPlayed;
+    if (mAudioSink->getPosition(&numFramesPlayed) != OK) {
+        return 0;
+    }
+
+    // Handle AudioTrack race when start is immediately called after flush.
+    uint32_t numFramesPendingPlayout =
+        (mNumFramesWritten > numFramesPlayed ?
+            mNumFramesWritten - numFramesPlayed : 0);
+
+    int64_t pendingUs = mAudioSink->msecsPerFrame() * numFramesPendingPlayout * 1000LL;
+    if (mPlaybackRate > 1.0f) {
+        pendingUs /= mPlaybackRate;
+    }
+    return pendingUs;
+}
+
+// In power efficient drain mode, returns how long the audio queue can wait before being
+// drained, given the sink has pendingUs to play. The buffers queued meanwhile are then
+// written in one go, instead of a wakeup per decoded buffer.
+int64_t NuPlayer::Renderer::getPowerEfficientDrainDelayUs(int64_t pendingUs) {
+    if (!mPowerEfficientDrain) {
+        return 0;
+    }
+    return std::max(pendingUs - kPowerEfficientDrainMarginUs, (int64_t)0);
+}
+
 // Calculate duration of pending samples if played at normal rate (i.e., 1.0).
 int64_t NuPlayer::Renderer::getPendingAudioPlayoutDurationUs(int64_t nowUs) {
     int64_t writtenAudioDurationUs = getDurationUsIfPlayedAtSampleRate(mNumFramesWritten);
@@ -1404,9 +1453,11 @@ void NuPlayer::Renderer::postDrainVideoQueue() {
         msg->post();
     } else {
         int64_t twoVsyncsUs = 2 * (mVideoScheduler->getVsyncPeriod() / 1000);
+        int64_t latencyUs = mVideoScheduler->getLatencyCorrection() / 1000;
 
-        // post 2 display refreshes before rendering is due
-        mMediaClock->addTimer(msg, mediaTimeUs, -twoVsyncsUs);
+        // post 2 display refreshes before rendering is due, plus however much earlier the
+        // scheduler renders to offset display latency
+        mMediaClock->addTimer(msg, mediaTimeUs, -twoVsyncsUs - latencyUs);
     }
 
     mDrainVideoQueuePending = true;
@@ -1590,9 +1641,12 @@ void NuPlayer::Renderer::onQueueBuffer(const sp<AMessage> &msg) {
     entry.mBufferOrdinal = ++mTotalBuffersQueued;
 
     if (audio) {
+        // Buffers queued while the sink has enough to play are drained together.
+        const int64_t delayUs = mPowerEfficientDrain
+                ? getPowerEfficientDrainDelayUs(getAudioSinkPendingDurationUs()) : 0;
         Mutex::Autolock autoLock(mLock);
         mAudioQueue.push_back(entry);
-        postDrainAudioQueue_l();
+        postDrainAudioQueue_l(delayUs);
     } else {
         mVideoQueue.push_back(entry);
         postDrainVideoQueue();
@@ -1926,6 +1980,12 @@ void NuPlayer::Renderer::onSetVideoFrameRate(float fps) {
     mVideoScheduler->init(fps);
 }
 
+void NuPlayer::Renderer::onVideoFramePresented(int64_t renderTimeNs, int64_t presentTimeNs) {
+    if (mVideoScheduler != NULL) {
+        mVideoScheduler->onFrameRendered(renderTimeNs, presentTimeNs);
+    }
+}
+
 int32_t NuPlayer::Renderer::getQueueGeneration(bool audio) {
     Mutex::Autolock autoLock(mLock);
     return (audio ? mAudioQueueGeneration : mVideoQueueGeneration);
@@ -2119,6 +2179,7 @@ status_t NuPlayer::Renderer::onOpenAudioSink(
                 }
             } else {
                 mUseAudioCallback = true;  // offload mode transfers data through callback
+                mPowerEfficientDrain = false;
                 ++mAudioDrainGeneration;  // discard pending kWhatDrainAudioQueue message.
             }
         }
@@ -2150,6 +2211,10 @@ status_t NuPlayer::Renderer::onOpenAudioSink(
         if (mUseAudioCallback) {
             ++mAudioDrainGeneration;  // discard pending kWhatDrainAudioQueue message.
         }
+        // Batching the drains adds latency, so only deep buffer outputs do it.
+        mPowerEfficientDrain = !mUseAudioCallback
+                && (pcmFlags & AUDIO_OUTPUT_FLAG_DEEP_BUFFER) != 0
+                && getPowerEfficientDrainSetting();
 
         // Compute the desired buffer size.
         // For callback mode, the amount of time before wakeup is about half the buffer size.
@@ -24,6 +24,7 @@
 #include <android-base/unique_fd.h>
 #include <media/mediaplayer.h>
 #include <media/stagefright/MediaBuffer.h>
+#include <media/stagefright/foundation/AHandlerReflector.h>
 #include <mpeg2ts/ATSParser.h>
 
 namespace android {
@@ -93,6 +94,7 @@ struct NuPlayer::GenericSource : public NuPlayer::Source,
 
     virtual status_t releaseDrm();
 
+    virtual void dump(AString& logString);
 
 protected:
     virtual ~GenericSource();
@@ -118,10 +120,27 @@ private:
         kWhatSecureDecodersInstantiated,
     };
 
+    // Counters of the reads of a track, read by dump().
+    struct ReadStats {
+        int64_t mRequests = 0;        // kWhatReadBuffer messages handled
+        int64_t mReads = 0;           // IMediaSource::read* calls
+        int64_t mBuffers = 0;         // buffers queued to mPackets
+        int64_t mUnderruns = 0;       // dequeueAccessUnit() found mPackets empty
+        int64_t mReadTimeUs = 0;      // total time spent in IMediaSource::read*
+        int64_t mMaxReadTimeUs = 0;
+        int64_t mQueueTimeUs = 0;     // total time from postReadBuffer() to the read
+        int64_t mMaxQueueTimeUs = 0;
+    };
+
     struct Track {
         size_t mIndex;
         sp<IMediaSource> mSource;
         sp<AnotherPacketSource> mPackets;
+        // Audio and video are read on their own looper, so that the refill of
+        // one track doesn't wait behind the reads of the other.
+        sp<ALooper> mReadLooper;
+        sp<AHandlerReflector<GenericSource> > mReader;
+        ReadStats mReadStats;
     };
 
     Vector<sp<IMediaSource> > mSources;
@@ -171,6 +190,9 @@ private:
 
     mutable Mutex mLock;
     mutable Mutex mDisconnectLock; // Protects mDataSource, mHttpSource and mDisconnected
+    // Serializes the IMediaSource::read* calls of all the tracks, which share the
+    // extractor's data source. Never held while waiting for |mLock|.
+    Mutex mReadLock;
 
     sp<ALooper> mLooper;
 
@@ -206,6 +228,7 @@ private:
             media_track_type trackType);
 
     void postReadBuffer(media_track_type trackType);
+    sp<AHandler> getReadHandler_l(media_track_type trackType);
     void onReadBuffer(const sp<AMessage>& msg);
     // When |mode| is MediaPlayerSeekMode::SEEK_CLOSEST, the buffer read shall
     // include an item indicating skipping rendering all buffers with timestamp
@@ -239,6 +262,8 @@ private:
 
     status_t checkDrmInfo();
 
+    friend struct AHandlerReflector<GenericSource>;
+
     DISALLOW_EVIL_CONSTRUCTORS(GenericSource);
 };
 
@@ -100,6 +100,10 @@ struct NuPlayer : public AHandler {
 
     const char *getDataSourceType();
 
+    // Number of times the audio fell back from offload because of an error, and then
+    // went back to offload.
+    void getAudioOffloadStats(int32_t *fallbacks, int32_t *recoveries);
+
     void updateInternalTimers();
 
     void setTargetBitrate(int bitrate /* bps */);
@@ -179,6 +183,11 @@ private:
     sp<MediaPlayerBase::AudioSink> mAudioSink;
     sp<DecoderBase> mVideoDecoder;
     bool mOffloadAudio;
+    // Offload was disabled by a failure, it is retried on resume up to kMaxOffloadRetries.
+    bool mOffloadDisabledByError;
+    int32_t mOffloadRetries;
+    std::atomic<int32_t> mOffloadFallbacks;
+    std::atomic<int32_t> mOffloadRecoveries;
     sp<DecoderBase> mAudioDecoder;
     Mutex mDecoderLock;  // guard |mAudioDecoder| and |mVideoDecoder|.
     sp<CCDecoder> mCCDecoder;
@@ -310,6 +319,7 @@ private:
             int64_t startPositionUs = -1,
             MediaPlayerSeekMode mode = MediaPlayerSeekMode::SEEK_PREVIOUS_SYNC);
     void onResume();
+    void retryOffloadAudioIfNeeded();
     void onPause();
 
     bool audioDecoderStillNeeded();
@@ -17,6 +17,8 @@
 #ifndef NUPLAYER_DECODER_H_
 #define NUPLAYER_DECODER_H_
 
+#include <map>
+
 #include "NuPlayer.h"
 
 #include "NuPlayerDecoderBase.h"
@@ -61,10 +63,12 @@ private:
         kWhatSetVideoSurface     = 'sSur',
         kWhatAudioOutputFormatChanged = 'aofc',
         kWhatDrmReleaseCrypto    = 'rDrm',
+        kWhatFrameRendered       = 'frRn',
     };
 
     enum {
         kMaxNumVideoTemporalLayers = 32,
+        kMaxPendingRenderTimes = 64,
     };
 
     sp<Surface> mSurface;
@@ -113,6 +117,11 @@ private:
     bool mResumePending;
     AString mComponentName;
 
+    // render time requested for each frame sent to the surface, keyed by media time; used
+    // to feed back presentation latency to the renderer when render feedback is enabled.
+    bool mRenderFeedbackEnabled;
+    std::map<int64_t, int64_t> mPendingRenderTimesNs;
+
     void handleError(int32_t err);
     bool handleAnInputBuffer(size_t index);
     bool handleAnOutputBuffer(
@@ -131,6 +140,7 @@ private:
     status_t fetchInputData(sp<AMessage> &reply);
     bool onInputBufferFetched(const sp<AMessage> &msg);
     void onRenderBuffer(const sp<AMessage> &msg);
+    void onFrameRendered(const sp<AMessage> &msg);
 
     bool supportsSeamlessFormatChange(const sp<AMessage> &to) const;
     bool supportsSeamlessAudioFormatChange(const sp<AMessage> &targetFormat) const;
@@ -64,6 +64,8 @@ private:
     // when the power investigation is done.
     size_t  mPendingBuffersToDrain;
     size_t  mCachedBytes;
+    size_t  mAggregateBufferSizeBytes;
+    size_t  mMaxCachedBytes;
     AString mComponentName;
 
     bool isStaleReply(const sp<AMessage> &msg);
@@ -71,6 +71,10 @@ struct NuPlayer::Renderer : public AHandler {
 
     void setVideoFrameRate(float fps);
 
+    // feeds back the actual presentation time of a video frame that was released for
+    // rendering at renderTimeNs, so the frame scheduler can offset display latency.
+    void notifyVideoFramePresented(int64_t renderTimeNs, int64_t presentTimeNs);
+
     status_t getCurrentPosition(int64_t *mediaUs);
     int64_t getVideoLateByUs();
 
@@ -137,6 +141,7 @@ private:
         kWhatDisableOffloadAudio = 'noOA',
         kWhatEnableOffloadAudio  = 'enOA',
         kWhatSetVideoFrameRate   = 'sVFR',
+        kWhatVideoFramePresented = 'vFPr',
     };
 
     // if mBuffer != nullptr, it's a buffer containing real data.
@@ -225,6 +230,11 @@ private:
     int32_t mTotalBuffersQueued;
     int32_t mLastAudioBufferDrained;
     bool mUseAudioCallback;
+    // The audio queue is drained in batches, see getPowerEfficientDrainDelayUs().
+    bool mPowerEfficientDrain;
+    // Counters of the audio drains, read by dump().
+    std::atomic<int64_t> mAudioDrainWakeups{0};
+    std::atomic<int64_t> mAudioSinkWrites{0};
 
     sp<AWakeLock> mWakeLock;
 
@@ -272,6 +282,8 @@ private:
     bool onDrainAudioQueue();
     void drainAudioQueueUntilLastEOS();
     int64_t getPendingAudioPlayoutDurationUs(int64_t nowUs);
+    int64_t getAudioSinkPendingDurationUs();
+    int64_t getPowerEfficientDrainDelayUs(int64_t pendingUs);
     void postDrainAudioQueue_l(int64_t delayUs = 0);
 
     void clearAnchorTime();
@@ -302,6 +314,7 @@ private:
     void onPause();
     void onResume();
     void onSetVideoFrameRate(float fps);
+    void onVideoFramePresented(int64_t renderTimeNs, int64_t presentTimeNs);
     int32_t getQueueGeneration(bool audio);
     int32_t getDrainGeneration(bool audio);
     bool getSyncQueues();
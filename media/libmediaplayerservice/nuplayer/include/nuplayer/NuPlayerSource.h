@@ -134,6 +134,8 @@ struct NuPlayer::Source : public AHandler {
 
     virtual void setTargetBitrate(int32_t) {}
 
+    virtual void dump(AString& /* logString */) {}
+
     // Modular DRM
     virtual status_t prepareDrm(
             const uint8_t /*uuid*/[16], const Vector<uint8_t> &/*drmSessionId*/,
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "FrameCache_test"
+#include <utils/Log.h>
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <android-base/file.h>
+#include <android-base/unique_fd.h>
+#include <binder/MemoryBase.h>
+#include <binder/MemoryHeapBase.h>
+
+#include "FrameCache.h"
+
+namespace android {
+
+static constexpr size_t kFrameSize = 4096;
+// Room for three frames and their headers.
+static constexpr size_t kCapacity = 3 * (kFrameSize + 256);
+
+static sp<IMemory> makeFrame(uint8_t value) {
+    sp<MemoryHeapBase> heap = new MemoryHeapBase(kFrameSize, 0, "FrameCache_test");
+    memset(heap->getBase(), value, kFrameSize);
+    return new MemoryBase(heap, 0, kFrameSize);
+}
+
+class FrameCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        mSourcePath = std::string(mDir.path) + "/source";
+        mSource.reset(open(mSourcePath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600));
+        ASSERT_GE(mSource.get(), 0);
+        ASSERT_EQ(3, write(mSource.get(), "abc", 3));
+
+        mKey = {};
+        ASSERT_TRUE(mKey.setSource(mSource.get(), 0, 3));
+        mKey.mKind = FrameCache::kKindImage;
+    }
+
+    FrameCache::Key keyAt(int64_t index) const {
+        FrameCache::Key key = mKey;
+        key.mIndex = index;
+        return key;
+    }
+
+    TemporaryDir mDir;
+    std::string mSourcePath;
+    base::unique_fd mSource;
+    FrameCache::Key mKey;
+};
+
+TEST_F(FrameCacheTest, StoresAndReturnsFrames) {
+    FrameCache cache(mDir.path, kCapacity);
+    EXPECT_EQ(nullptr, cache.lookup(keyAt(0)));
+
+    cache.insert(keyAt(0), makeFrame(0x5a));
+    sp<IMemory> frame = cache.lookup(keyAt(0));
+    ASSERT_NE(nullptr, frame);
+    ASSERT_EQ(kFrameSize, frame->size());
+    EXPECT_EQ(0x5a, static_cast<uint8_t *>(frame->unsecurePointer())[kFrameSize - 1]);
+
+    // A new instance, e.g. after a restart, finds the same frame.
+    FrameCache restarted(mDir.path, kCapacity);
+    EXPECT_NE(nullptr, restarted.lookup(keyAt(0)));
+
+    // Other requests on the same source miss.
+    FrameCache::Key thumbnail = keyAt(0);
+    thumbnail.mKind = FrameCache::kKindImageThumbnail;
+    EXPECT_EQ(nullptr, cache.lookup(thumbnail));
+    EXPECT_EQ(nullptr, cache.lookup(keyAt(1)));
+}
+
+TEST_F(FrameCacheTest, ModifiedSourceMisses) {
+    FrameCache cache(mDir.path, kCapacity);
+    cache.insert(keyAt(0), makeFrame(1));
+
+    ASSERT_EQ(1, write(mSource.get(), "d", 1));
+    FrameCache::Key key = {};
+    ASSERT_TRUE(key.setSource(mSource.get(), 0, 3));
+    key.mKind = FrameCache::kKindImage;
+    EXPECT_EQ(nullptr, cache.lookup(key));
+}
+
+TEST_F(FrameCacheTest, EvictsLeastRecentlyUsed) {
+    FrameCache cache(mDir.path, kCapacity);
+    for (int64_t i = 0; i < 5; ++i) {
+        cache.insert(keyAt(i), makeFrame(i));
+        // keep modification times apart
+        usleep(10000);
+        if (i == 2) {
+            EXPECT_NE(nullptr, cache.lookup(keyAt(0)));
+            usleep(10000);
+        }
+    }
+
+    EXPECT_NE(nullptr, cache.lookup(keyAt(0)));
+    EXPECT_EQ(nullptr, cache.lookup(keyAt(1)));
+    EXPECT_EQ(nullptr, cache.lookup(keyAt(2)));
+    EXPECT_NE(nullptr, cache.lookup(keyAt(3)));
+    EXPECT_NE(nullptr, cache.lookup(keyAt(4)));
+}
+
+}  // namespace android
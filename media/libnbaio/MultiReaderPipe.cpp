@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "MultiReaderPipe"
+//#define LOG_NDEBUG 0
+
+#include <string.h>
+
+#include <algorithm>
+
+#include <cutils/compiler.h>
+#include <utils/Log.h>
+#include <utils/Timers.h>
+#include <media/nbaio/MultiReaderPipe.h>
+#include <audio_utils/roundup.h>
+
+namespace android {
+
+MultiReaderPipe::MultiReaderPipe(size_t maxFrames, const NBAIO_Format& format) :
+        NBAIO_Sink(format),
+        mMaxFrames(roundup(maxFrames)),
+        mBuffer(malloc(mMaxFrames * Format_frameSize(format)))
+{
+}
+
+MultiReaderPipe::~MultiReaderPipe()
+{
+    ALOG_ASSERT(mReaders.load(std::memory_order_acquire) == 0);
+    free(mBuffer);
+}
+
+ssize_t MultiReaderPipe::write(const void *buffer, size_t count)
+{
+    return write(buffer, count, systemTime(SYSTEM_TIME_MONOTONIC));
+}
+
+ssize_t MultiReaderPipe::write(const void *buffer, size_t count, int64_t timeNs)
+{
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    const int64_t rear = mRear.load(std::memory_order_relaxed);
+    const int64_t newRear = rear + count;
+
+    // Tell the readers which frames are about to be overwritten before modifying them.
+    mWriteEnd.store(newRear, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // Only the last mMaxFrames frames of a large write can be read.
+    const size_t skip = count > mMaxFrames ? count - mMaxFrames : 0;
+    const size_t frames = count - skip;
+    const size_t index = (size_t) (rear + skip) & (mMaxFrames - 1);
+    const size_t part1 = std::min(frames, mMaxFrames - index);
+    const uint8_t *src = (const uint8_t *) buffer + skip * mFrameSize;
+    memcpy((uint8_t *) mBuffer + index * mFrameSize, src, part1 * mFrameSize);
+    if (part1 < frames) {
+        memcpy(mBuffer, src + part1 * mFrameSize, (frames - part1) * mFrameSize);
+    }
+    mRear.store(newRear, std::memory_order_release);
+
+    const uint32_t sequence = mTimestampSequence.load(std::memory_order_relaxed);
+    mTimestampSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    mTimestampPosition.store(newRear, std::memory_order_relaxed);
+    mTimestampTimeNs.store(timeNs, std::memory_order_relaxed);
+    mTimestampSequence.store(sequence + 2, std::memory_order_release);
+
+    mFramesWritten += count;
+    return count;
+}
+
+status_t MultiReaderPipe::getWriteTimestamp(int64_t *position, int64_t *timeNs) const
+{
+    // The writer holds the sequence odd only for a few stores, so this rarely loops.
+    static constexpr int kMaxTries = 16; // arbitrary
+    for (int i = 0; i < kMaxTries; ++i) {
+        const uint32_t sequence = mTimestampSequence.load(std::memory_order_acquire);
+        if (sequence & 1) {
+            continue;
+        }
+        const int64_t timestampPosition = mTimestampPosition.load(std::memory_order_relaxed);
+        const int64_t timestampTimeNs = mTimestampTimeNs.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (mTimestampSequence.load(std::memory_order_relaxed) != sequence) {
+            continue;
+        }
+        if (sequence == 0) {
+            return INVALID_OPERATION;
+        }
+        *position = timestampPosition;
+        *timeNs = timestampTimeNs;
+        return OK;
+    }
+    return WOULD_BLOCK;
+}
+
+}   // namespace android
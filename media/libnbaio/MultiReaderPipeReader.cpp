@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "MultiReaderPipeReader"
+//#define LOG_NDEBUG 0
+
+#include <string.h>
+
+#include <algorithm>
+
+#include <cutils/compiler.h>
+#include <utils/Log.h>
+#include <media/nbaio/MultiReaderPipeReader.h>
+
+namespace android {
+
+MultiReaderPipeReader::MultiReaderPipeReader(MultiReaderPipe& pipe) :
+        NBAIO_Source(pipe.mFormat),
+        mPipe(pipe),
+        mMask(pipe.mMaxFrames - 1),
+        mFront(pipe.mRear.load(std::memory_order_acquire)),
+        mObtained(0),
+        mFramesOverrun(0),
+        mOverruns(0)
+{
+    mPipe.mReaders.fetch_add(1, std::memory_order_acq_rel);
+}
+
+MultiReaderPipeReader::~MultiReaderPipeReader()
+{
+    const int32_t readers = mPipe.mReaders.fetch_sub(1, std::memory_order_acq_rel);
+    ALOG_ASSERT(readers > 0);
+    (void) readers;
+}
+
+ssize_t MultiReaderPipeReader::overrun(int64_t rear)
+{
+    mFramesOverrun += rear - mFront;
+    ++mOverruns;
+    mFront = rear;
+    mObtained = 0;
+    return OVERRUN;
+}
+
+ssize_t MultiReaderPipeReader::availableFrames()
+{
+    const int64_t rear = mPipe.mRear.load(std::memory_order_acquire);
+    const int64_t avail = rear - mFront;
+    if (avail > (int64_t) mPipe.mMaxFrames) {
+        return overrun(rear);
+    }
+    return (ssize_t) avail;
+}
+
+bool MultiReaderPipeReader::isOverwritten() const
+{
+    // Pairs with the fence in MultiReaderPipe::write(): if any frame that was loaded
+    // had been modified by the writer, then its mWriteEnd is visible here.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const int64_t writeEnd = mPipe.mWriteEnd.load(std::memory_order_relaxed);
+    return writeEnd - mFront > (int64_t) mPipe.mMaxFrames;
+}
+
+ssize_t MultiReaderPipeReader::availableToRead()
+{
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    return availableFrames();
+}
+
+ssize_t MultiReaderPipeReader::read(void *buffer, size_t count)
+{
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    const ssize_t avail = availableFrames();
+    if (avail <= 0) {
+        return avail;
+    }
+    const size_t frames = std::min(count, (size_t) avail);
+    const size_t index = (size_t) mFront & mMask;
+    const size_t part1 = std::min(frames, mPipe.mMaxFrames - index);
+    memcpy(buffer, (const uint8_t *) mPipe.mBuffer + index * mFrameSize, part1 * mFrameSize);
+    if (part1 < frames) {
+        memcpy((uint8_t *) buffer + part1 * mFrameSize, mPipe.mBuffer,
+                (frames - part1) * mFrameSize);
+    }
+    if (isOverwritten()) {
+        return overrun(mPipe.mRear.load(std::memory_order_acquire));
+    }
+    mFront += frames;
+    mFramesRead += frames;
+    return frames;
+}
+
+ssize_t MultiReaderPipeReader::flush()
+{
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    const ssize_t avail = availableFrames();
+    if (avail <= 0) {
+        return avail;
+    }
+    mFront += avail;
+    mFramesRead += avail;  // we consider flushed frames as read, but not lost frames
+    return avail;
+}
+
+ssize_t MultiReaderPipeReader::obtain(const void **buffer, size_t count)
+{
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    mObtained = 0;
+    const ssize_t avail = availableFrames();
+    if (avail <= 0) {
+        return avail;
+    }
+    const size_t index = (size_t) mFront & mMask;
+    mObtained = std::min({count, (size_t) avail, mPipe.mMaxFrames - index});
+    *buffer = (const uint8_t *) mPipe.mBuffer + index * mFrameSize;
+    return mObtained;
+}
+
+ssize_t MultiReaderPipeReader::release(size_t count)
+{
+    ALOG_ASSERT(count <= mObtained);
+    if (isOverwritten()) {
+        return overrun(mPipe.mRear.load(std::memory_order_acquire));
+    }
+    mObtained = 0;
+    mFront += count;
+    mFramesRead += count;
+    return count;
+}
+
+status_t MultiReaderPipeReader::getReadTimestamp(int64_t *position, int64_t *timeNs)
+{
+    int64_t writePosition;
+    int64_t writeTimeNs;
+    const status_t status = mPipe.getWriteTimestamp(&writePosition, &writeTimeNs);
+    if (status != OK) {
+        return status;
+    }
+    *position = mFront;
+    *timeNs = writeTimeNs - (writePosition - mFront) * 1000000000LL
+            / (int64_t) Format_sampleRate(mFormat);
+    return OK;
+}
+
+}   // namespace android
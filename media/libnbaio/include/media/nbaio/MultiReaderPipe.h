@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_MULTI_READER_PIPE_H
+#define ANDROID_AUDIO_MULTI_READER_PIPE_H
+
+#include <atomic>
+
+#include <media/nbaio/NBAIO.h>
+
+namespace android {
+
+// MultiReaderPipe is similar to Pipe except:
+//  - a reader can access the data in place with obtain() and release(), so that each reader
+//    can convert directly from the pipe buffer instead of copying to its own buffer first
+//  - each write is time-stamped, so a reader can tell the time of the frames it reads
+//  - the indices are 64-bit frame counts that never wrap
+// Like Pipe, it is safe for only a single writer thread, and for any number of readers,
+// each reader being used by a single thread. Readers can be added and removed dynamically.
+// The writer is never blocked nor throttled: a reader which does not keep up is overrun,
+// and detects it independently of the other readers.
+class MultiReaderPipe : public NBAIO_Sink {
+
+    friend class MultiReaderPipeReader;
+
+public:
+    // maxFrames will be rounded up to a power of 2, and all slots are available. Must be >= 2.
+    MultiReaderPipe(size_t maxFrames, const NBAIO_Format& format);
+    virtual ~MultiReaderPipe();
+
+    // NBAIO_Sink interface
+
+    //virtual int64_t framesWritten() const;
+
+    // The write side of a pipe permits overruns; flow control is the caller's responsibility.
+    virtual ssize_t availableToWrite() { return mMaxFrames; }
+
+    // Equivalent to write(buffer, count, systemTime()).
+    virtual ssize_t write(const void *buffer, size_t count);
+
+    // NBAIO_Sink end
+
+    // Writes count frames, and time-stamps the end of the data: timeNs is the CLOCK_MONOTONIC
+    // time of the frame following the last frame written, e.g. the capture time reported by
+    // the HAL. Never returns a short transfer count.
+    ssize_t write(const void *buffer, size_t count, int64_t timeNs);
+
+    // Returns the index of the frame following the last frame written, and its time,
+    // as passed to the last write().
+    // Returns INVALID_OPERATION if nothing was written yet.
+    // May be called from any thread.
+    status_t getWriteTimestamp(int64_t *position, int64_t *timeNs) const;
+
+    size_t maxFrames() const { return mMaxFrames; }
+
+private:
+    const size_t    mMaxFrames;     // always a power of 2
+    void * const    mBuffer;
+
+    // Index of the frame following the last frame published to the readers.
+    std::atomic<int64_t> mRear{0};
+    // Index of the frame following the last frame the writer may be modifying.
+    // It is advanced before the frames are copied so that a reader can detect data that
+    // was overwritten while it was reading it.
+    std::atomic<int64_t> mWriteEnd{0};
+
+    // The timestamp of the last write, updated with a sequence lock.
+    std::atomic<uint32_t> mTimestampSequence{0};  // odd while the timestamp is updated
+    std::atomic<int64_t> mTimestampPosition{0};
+    std::atomic<int64_t> mTimestampTimeNs{0};
+
+    std::atomic<int32_t> mReaders{0};  // number of readers attached to this pipe
+};
+
+}   // namespace android
+
+#endif  // ANDROID_AUDIO_MULTI_READER_PIPE_H
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_MULTI_READER_PIPE_READER_H
+#define ANDROID_AUDIO_MULTI_READER_PIPE_READER_H
+
+#include "MultiReaderPipe.h"
+
+namespace android {
+
+// MultiReaderPipeReader is safe for only a single thread.
+//
+// A reader that falls more than maxFrames behind the writer is overrun: the call that
+// detects it returns OVERRUN, and the reader continues with the frames written after that.
+// The frames it did not read are counted by framesOverrun().
+class MultiReaderPipeReader : public NBAIO_Source {
+
+public:
+
+    // Construct a reader and associate it with a MultiReaderPipe.
+    // The reader starts at the current write position: the data already
+    // in the pipe is not visible to it.
+    explicit MultiReaderPipeReader(MultiReaderPipe& pipe);
+    virtual ~MultiReaderPipeReader();
+
+    // NBAIO_Source interface
+
+    //virtual size_t framesRead() const;
+    virtual int64_t framesOverrun() { return mFramesOverrun; }
+    virtual int64_t overruns()  { return mOverruns; }
+
+    virtual ssize_t availableToRead();
+
+    virtual ssize_t read(void *buffer, size_t count);
+
+    virtual ssize_t flush();
+
+    // NBAIO_Source end
+
+    // Obtains up to count frames that can be read in place, without a copy.
+    // Fewer frames than available may be returned when the data wraps around the end of
+    // the pipe buffer; call again after release() for the rest.
+    // Returns the number of frames at *buffer, 0 if there is no data, or OVERRUN.
+    // The data must not be modified.
+    ssize_t obtain(const void **buffer, size_t count);
+
+    // Releases count frames, at most the count returned by the last obtain().
+    // Returns count, or OVERRUN if the writer overwrote the data while it was in use,
+    // in which case the data that was obtained must be discarded.
+    ssize_t release(size_t count);
+
+    // Returns the index in the pipe of the next frame to read, and its estimated
+    // CLOCK_MONOTONIC time based on the timestamp of the last write and the sample rate.
+    // Returns INVALID_OPERATION if nothing was written yet.
+    status_t getReadTimestamp(int64_t *position, int64_t *timeNs);
+
+private:
+    // Returns the number of frames available at mFront, or OVERRUN after skipping to the rear.
+    ssize_t availableFrames();
+    // Returns true if the frames from mFront may have been overwritten since being loaded.
+    bool isOverwritten() const;
+    // Counts the frames that are lost and skips to the rear, returns OVERRUN.
+    ssize_t overrun(int64_t rear);
+
+    MultiReaderPipe& mPipe;
+    const size_t    mMask;          // mPipe.mMaxFrames - 1
+    int64_t         mFront;         // index of the next frame to read
+    size_t          mObtained;      // frames returned by the last obtain()
+    int64_t         mFramesOverrun;
+    int64_t         mOverruns;
+};
+
+}   // namespace android
+
+#endif  // ANDROID_AUDIO_MULTI_READER_PIPE_READER_H
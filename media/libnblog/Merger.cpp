@@ -17,13 +17,20 @@
 #define LOG_TAG "NBLog"
 //#define LOG_NDEBUG 0
 
+#include <errno.h>
+#include <fcntl.h>
 #include <memory>
 #include <queue>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <vector>
 
 #include <audio_utils/fifo.h>
+#include <cutils/properties.h>
 #include <json/json.h>
 #include <media/nblog/Merger.h>
 #include <media/nblog/PerformanceAnalysis.h>
@@ -128,6 +135,13 @@ MergeReader::MergeReader(const void *shared, size_t size, Merger &merger)
 {
 }
 
+MergeReader::~MergeReader()
+{
+    if (mBinaryExportFd >= 0) {
+        close(mBinaryExportFd);
+    }
+}
+
 // Takes raw content of the local merger FIFO, processes log entries, and
 // writes the data to a map of class PerformanceAnalysis, based on their thread ID.
 void MergeReader::processSnapshot(Snapshot &snapshot, int author)
@@ -166,11 +180,14 @@ void MergeReader::processSnapshot(Snapshot &snapshot, int author)
         case EVENT_WARMUP_TIME: {
             const double timeMs = it.payload<double>();
             data.warmupHist.add(timeMs);
+            // The warmup entry has no timestamp, use the time it is processed.
+            appendBinaryEvent(author, EVENT_WARMUP_TIME, systemTime(), timeMs);
         } break;
         case EVENT_UNDERRUN: {
             const int64_t ts = it.payload<int64_t>();
             data.underruns++;
             data.snapshots.emplace_front(EVENT_UNDERRUN, ts);
+            appendBinaryEvent(author, EVENT_UNDERRUN, ts);
             // TODO have a data structure to automatically handle resizing
             if (data.snapshots.size() > ReportPerformance::PerformanceData::kMaxSnapshotsToStore) {
                 data.snapshots.pop_back();
@@ -180,6 +197,7 @@ void MergeReader::processSnapshot(Snapshot &snapshot, int author)
             const int64_t ts = it.payload<int64_t>();
             data.overruns++;
             data.snapshots.emplace_front(EVENT_UNDERRUN, ts);
+            appendBinaryEvent(author, EVENT_OVERRUN, ts);
             // TODO have a data structure to automatically handle resizing
             if (data.snapshots.size() > ReportPerformance::PerformanceData::kMaxSnapshotsToStore) {
                 data.snapshots.pop_back();
@@ -210,6 +228,7 @@ void MergeReader::getAndProcessSnapshot()
             processSnapshot(*(snapshots[i]), i);
         }
     }
+    checkBinaryExport();
     checkPushToMediaMetrics();
 }
 
@@ -225,11 +244,86 @@ void MergeReader::checkPushToMediaMetrics()
     }
 }
 
+void MergeReader::appendBinaryEvent(int author, Event event, int64_t timeNs, double value)
+{
+    if (!mBinaryExportEnabled || mBinaryRecords.size() >= kMaxBinaryRecordsSize) {
+        return;
+    }
+    ReportPerformance::appendBinaryEvent(&mBinaryRecords, author, event, timeNs, value);
+}
+
+void MergeReader::checkBinaryExport()
+{
+    const nsecs_t now = systemTime();
+    if (now - mLastBinaryExport < kPeriodicBinaryExport) {
+        return;
+    }
+    mLastBinaryExport = now;
+    // The property is checked here rather than once, so that the export can be
+    // enabled or disabled without restarting the service.
+    mBinaryExportEnabled = property_get_bool(kBinaryExportProperty, false /*default*/);
+    if (!mBinaryExportEnabled) {
+        mBinaryRecords.clear();
+        if (mBinaryExportFd >= 0) {
+            close(mBinaryExportFd);
+            mBinaryExportFd = -1;
+        }
+        return;
+    }
+    // This runs before checkPushToMediaMetrics() resets the data of a thread.
+    for (const auto& item : mThreadPerformanceData) {
+        const ReportPerformance::PerformanceData& data = item.second;
+        if (!data.empty()) {
+            ReportPerformance::appendBinaryPerformanceData(
+                    &mBinaryRecords, item.first, data, now);
+        }
+    }
+    writeBinaryRecords();
+    mBinaryRecords.clear();
+}
+
+void MergeReader::writeBinaryRecords()
+{
+    if (mBinaryRecords.empty()) {
+        return;
+    }
+    if (mBinaryExportFd >= 0) {
+        const off_t fileSize = lseek(mBinaryExportFd, 0, SEEK_END);
+        if (fileSize < 0 || fileSize + (off_t)mBinaryRecords.size() > kMaxBinaryExportFileSize) {
+            close(mBinaryExportFd);
+            mBinaryExportFd = -1;
+            if (rename(kBinaryExportPath, kBinaryExportOldPath) != 0) {
+                ALOGW("%s: rename %s failed: %s", __func__, kBinaryExportPath, strerror(errno));
+                unlink(kBinaryExportPath);
+            }
+        }
+    }
+    if (mBinaryExportFd < 0) {
+        mBinaryExportFd = open(kBinaryExportPath,
+                O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP);
+        if (mBinaryExportFd < 0) {
+            ALOGW("%s: open %s failed: %s", __func__, kBinaryExportPath, strerror(errno));
+            return;
+        }
+        // Start every new file with a header, so that each one can be parsed alone.
+        if (lseek(mBinaryExportFd, 0, SEEK_END) == 0) {
+            std::vector<uint8_t> header;
+            ReportPerformance::appendBinaryFileHeader(&header);
+            mBinaryRecords.insert(mBinaryRecords.begin(), header.begin(), header.end());
+        }
+    }
+    const ssize_t written = write(mBinaryExportFd, mBinaryRecords.data(), mBinaryRecords.size());
+    if (written != (ssize_t)mBinaryRecords.size()) {
+        ALOGW("%s: write %s failed: %s", __func__, kBinaryExportPath,
+                written < 0 ? strerror(errno) : "short write");
+    }
+}
+
 void MergeReader::dump(int fd, const Vector<String16>& args)
 {
     // TODO: add a mutex around media.log dump
     // Options for dumpsys
-    bool pa = false, json = false, plots = false, retro = false;
+    bool pa = false, json = false, plots = false, retro = false, binary = false;
     for (const auto &arg : args) {
         if (arg == String16("--pa")) {
             pa = true;
@@ -239,6 +333,8 @@ void MergeReader::dump(int fd, const Vector<String16>& args)
             plots = true;
         } else if (arg == String16("--retro")) {
             retro = true;
+        } else if (arg == String16("--binary")) {
+            binary = true;
         }
     }
     if (pa) {
@@ -253,6 +349,9 @@ void MergeReader::dump(int fd, const Vector<String16>& args)
     if (retro) {
         ReportPerformance::dumpRetro(fd, mThreadPerformanceData);
     }
+    if (binary) {
+        ReportPerformance::dumpBinary(fd, mThreadPerformanceData);
+    }
 }
 
 void MergeReader::handleAuthor(const AbstractEntry &entry, String8 *body)
@@ -17,17 +17,20 @@
 #define LOG_TAG "ReportPerformance"
 //#define LOG_NDEBUG 0
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <queue>
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <sstream>
 #include <sys/prctl.h>
 #include <sys/time.h>
+#include <type_traits>
 #include <utility>
 #include <json/json.h>
 #include <media/MediaMetricsItem.h>
@@ -148,6 +151,110 @@ void dumpRetro(int fd, const std::map<int, PerformanceData>& threadDataMap)
     }
 }
 
+template <typename T>
+static void appendBinaryValue(std::vector<uint8_t> *buffer, const T& value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "value must be trivially copyable");
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+    buffer->insert(buffer->end(), bytes, bytes + sizeof(T));
+}
+
+// Appends a record header with a size to be filled in by endBinaryRecord().
+// Returns the offset of the record header in buffer.
+static size_t beginBinaryRecord(std::vector<uint8_t> *buffer, BinaryRecordType type,
+                                int author, int64_t timeNs)
+{
+    const size_t offset = buffer->size();
+    const BinaryRecordHeader header{type, 0 /*reserved*/, 0 /*size*/, author, timeNs};
+    appendBinaryValue(buffer, header);
+    return offset;
+}
+
+static void endBinaryRecord(std::vector<uint8_t> *buffer, size_t offset)
+{
+    const size_t size = buffer->size() - offset - sizeof(BinaryRecordHeader);
+    // The largest record is a histogram, which is well below the limit.
+    ALOG_ASSERT(size <= UINT16_MAX);
+    const uint16_t size16 = size;
+    memcpy(buffer->data() + offset + offsetof(BinaryRecordHeader, size), &size16, sizeof(size16));
+}
+
+static void appendBinaryHistogram(std::vector<uint8_t> *buffer, int author, int64_t nowNs,
+                                  BinaryHistogramId id, const Histogram& hist)
+{
+    if (hist.totalCount() == 0) {
+        return;
+    }
+    const std::vector<uint64_t>& bins = hist.bins();
+    const uint32_t nonzeroBins = bins.size() - std::count(bins.begin(), bins.end(), 0);
+    const size_t offset = beginBinaryRecord(buffer, BINARY_RECORD_HISTOGRAM, author, nowNs);
+    appendBinaryValue(buffer, id);
+    appendBinaryValue(buffer, hist.binSize());
+    appendBinaryValue(buffer, (uint32_t)hist.numBins());
+    appendBinaryValue(buffer, hist.low());
+    appendBinaryValue(buffer, nonzeroBins);
+    for (size_t i = 0; i < bins.size(); i++) {
+        if (bins[i] != 0) {
+            appendBinaryValue(buffer, static_cast<int32_t>(i) - 1);
+            appendBinaryValue(buffer, bins[i]);
+        }
+    }
+    endBinaryRecord(buffer, offset);
+}
+
+void appendBinaryFileHeader(std::vector<uint8_t> *buffer)
+{
+    const BinaryFileHeader header{kBinaryMagic, kBinaryVersion, sizeof(BinaryRecordHeader)};
+    appendBinaryValue(buffer, header);
+}
+
+void appendBinaryPerformanceData(std::vector<uint8_t> *buffer, int author,
+                                 const PerformanceData& data, int64_t nowNs)
+{
+    const size_t offset = beginBinaryRecord(buffer, BINARY_RECORD_THREAD, author, nowNs);
+    appendBinaryValue(buffer, (int32_t)data.threadInfo.id);
+    appendBinaryValue(buffer, (int32_t)data.threadInfo.type);
+    appendBinaryValue(buffer, (uint32_t)data.threadParams.frameCount);
+    appendBinaryValue(buffer, (uint32_t)data.threadParams.sampleRate);
+    appendBinaryValue(buffer, data.underruns);
+    appendBinaryValue(buffer, data.overruns);
+    appendBinaryValue(buffer, (int64_t)data.active);
+    appendBinaryValue(buffer, (int64_t)data.start);
+    endBinaryRecord(buffer, offset);
+
+    appendBinaryHistogram(buffer, author, nowNs, BINARY_HISTOGRAM_WORK, data.workHist);
+    appendBinaryHistogram(buffer, author, nowNs, BINARY_HISTOGRAM_LATENCY, data.latencyHist);
+    appendBinaryHistogram(buffer, author, nowNs, BINARY_HISTOGRAM_WARMUP, data.warmupHist);
+}
+
+void appendBinaryEvent(std::vector<uint8_t> *buffer, int author, NBLog::Event event,
+                       int64_t timeNs, double value)
+{
+    const size_t offset = beginBinaryRecord(buffer, BINARY_RECORD_EVENT, author, timeNs);
+    appendBinaryValue(buffer, event);
+    appendBinaryValue(buffer, value);
+    endBinaryRecord(buffer, offset);
+}
+
+void dumpBinary(int fd, const std::map<int, PerformanceData>& threadDataMap)
+{
+    if (fd < 0) {
+        return;
+    }
+
+    std::vector<uint8_t> buffer;
+    appendBinaryFileHeader(&buffer);
+    const nsecs_t now = systemTime();
+    for (const auto &item : threadDataMap) {
+        const ReportPerformance::PerformanceData& data = item.second;
+        if (data.empty()) {
+            continue;
+        }
+        appendBinaryPerformanceData(&buffer, item.first, data, now);
+    }
+    write(fd, buffer.data(), buffer.size());
+}
+
 bool sendToMediaMetrics(const PerformanceData& data)
 {
     // See documentation for these metrics here:
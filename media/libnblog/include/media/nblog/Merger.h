@@ -20,6 +20,7 @@
 #include <memory>
 #include <stddef.h>
 #include <stdint.h>
+#include <sys/types.h>
 #include <vector>
 
 #include <audio_utils/fifo.h>
@@ -75,6 +76,7 @@ private:
 class MergeReader : public Reader {
 public:
     MergeReader(const void *shared, size_t size, Merger &merger);
+    ~MergeReader() override;
 
     // process a particular snapshot of the reader
     void processSnapshot(Snapshot &snap, int author);
@@ -86,6 +88,11 @@ public:
     // the send if it is time to do so.
     void checkPushToMediaMetrics();
 
+    // check for periodic export of performance data and events to the binary export file,
+    // and perform the export if it is enabled and it is time to do so.
+    // See ReportPerformance.h for the file format.
+    void checkBinaryExport();
+
     void dump(int fd, const Vector<String16>& args);
 
 private:
@@ -106,6 +113,31 @@ private:
     // how often to push data to Media Metrics
     static constexpr nsecs_t kPeriodicMediaMetricsPush = s2ns((nsecs_t)2 * 60 * 60); // 2 hours
 
+    // Binary export: the underrun, overrun and warmup events are appended to
+    // mBinaryRecords as they are processed, and written to the export file with the
+    // histograms of each thread every kPeriodicBinaryExport.
+    // The export file is renamed to kBinaryExportOldPath when it exceeds
+    // kMaxBinaryExportFileSize, so at most twice that size is used.
+    static constexpr const char *kBinaryExportProperty = "media.nblog.binary_export";
+    static constexpr const char *kBinaryExportPath = "/data/misc/audioserver/nblog_perf.bin";
+    static constexpr const char *kBinaryExportOldPath =
+            "/data/misc/audioserver/nblog_perf.bin.old";
+    static constexpr nsecs_t kPeriodicBinaryExport = s2ns(10);
+    static constexpr off_t kMaxBinaryExportFileSize = 1024 * 1024;
+    // events beyond this are dropped until the next export
+    static constexpr size_t kMaxBinaryRecordsSize = 64 * 1024;
+
+    // append an event to mBinaryRecords if the binary export is enabled
+    void appendBinaryEvent(int author, Event event, int64_t timeNs, double value = 0.);
+
+    // write mBinaryRecords to the export file, opening or rotating it first if needed
+    void writeBinaryRecords();
+
+    bool mBinaryExportEnabled = false;
+    nsecs_t mLastBinaryExport = 0;
+    int mBinaryExportFd = -1;
+    std::vector<uint8_t> mBinaryRecords;
+
     // handle author entry by looking up the author's name and appending it to the body
     // returns number of bytes read from fmtEntry
     void handleAuthor(const AbstractEntry &fmtEntry, String8 *body);
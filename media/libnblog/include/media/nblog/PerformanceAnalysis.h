@@ -117,6 +117,13 @@ public:
     // Empty string is returned if totalCount() == 0.
     std::string asciiArtString(size_t indent = 0) const;
 
+    double binSize() const { return mBinSize; }
+    size_t numBins() const { return mNumBins; }
+    double low() const { return mLow; }
+
+    // Returns the bin counts, including the low and high bins, see mBins below.
+    const std::vector<uint64_t>& bins() const { return mBins; }
+
 private:
     // Histogram version number.
     static constexpr int kVersion = 1;
@@ -19,8 +19,11 @@
 
 #include <deque>
 #include <map>
+#include <stdint.h>
 #include <vector>
 
+#include <media/nblog/Events.h>
+
 namespace android {
 namespace ReportPerformance {
 
@@ -35,6 +38,68 @@ void dumpPlots(int fd, const std::map<int, PerformanceData>& threadDataMap);
 // Dumps snapshots at important events in the past.
 void dumpRetro(int fd, const std::map<int, PerformanceData>& threadDataMap);
 
+// Compact binary format of the performance data, meant to be streamed to a file and parsed
+// offline, so that jitter can be analyzed without running dumpsys.
+// A stream starts with a BinaryFileHeader followed by records. Each record is a
+// BinaryRecordHeader followed by recordHeader.size bytes of payload. All values are
+// in native (little-endian) byte order and are not padded.
+//
+// BINARY_RECORD_THREAD payload:
+//     int32 ioHandle, int32 threadType, uint32 frameCount, uint32 sampleRate,
+//     int64 underruns, int64 overruns, int64 activeNs, int64 startNs
+// BINARY_RECORD_HISTOGRAM payload, counts are cumulative since startNs:
+//     uint8 BinaryHistogramId, double binSize, uint32 numBins, double low,
+//     uint32 nonzeroBins, nonzeroBins x { int32 binIndex, uint64 count }
+//     where binIndex is -1 for the low bin and numBins for the high bin, as in toString().
+// BINARY_RECORD_EVENT payload:
+//     uint8 NBLog::Event, double value
+//     where value is the time in ms for EVENT_WARMUP_TIME and 0 otherwise.
+// Unknown record types must be skipped by the parser, so that records can be added.
+
+constexpr uint32_t kBinaryMagic = 0x424c424e;   // "NBLB"
+constexpr uint16_t kBinaryVersion = 1;
+
+struct BinaryFileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;    // sizeof(BinaryRecordHeader)
+} __attribute__((packed));
+
+enum BinaryRecordType : uint8_t {
+    BINARY_RECORD_THREAD = 1,
+    BINARY_RECORD_HISTOGRAM = 2,
+    BINARY_RECORD_EVENT = 3,
+};
+
+enum BinaryHistogramId : uint8_t {
+    BINARY_HISTOGRAM_WORK = 0,
+    BINARY_HISTOGRAM_LATENCY = 1,
+    BINARY_HISTOGRAM_WARMUP = 2,
+};
+
+struct BinaryRecordHeader {
+    uint8_t type;           // BinaryRecordType
+    uint8_t reserved;
+    uint16_t size;          // payload size in bytes
+    int32_t author;         // thread index, as the key of the maps below
+    int64_t timeNs;         // CLOCK_MONOTONIC time of the event or of the export
+} __attribute__((packed));
+
+// Appends the BinaryFileHeader to buffer.
+void appendBinaryFileHeader(std::vector<uint8_t> *buffer);
+
+// Appends a BINARY_RECORD_THREAD record followed by one BINARY_RECORD_HISTOGRAM record
+// per nonempty histogram of data.
+void appendBinaryPerformanceData(std::vector<uint8_t> *buffer, int author,
+                                 const PerformanceData& data, int64_t nowNs);
+
+// Appends a BINARY_RECORD_EVENT record.
+void appendBinaryEvent(std::vector<uint8_t> *buffer, int author, NBLog::Event event,
+                       int64_t timeNs, double value = 0.);
+
+// Dumps the performance data of all threads in the binary format, including the file header.
+void dumpBinary(int fd, const std::map<int, PerformanceData>& threadDataMap);
+
 // Send one thread's data to media metrics, if the performance data is nontrivial (i.e. not
 // all zero values). Return true if data was sent, false if there is nothing to write
 // or an error occurred while writing.
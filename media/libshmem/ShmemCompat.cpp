@@ -15,12 +15,62 @@
  */
 #include "media/ShmemCompat.h"
 
+#include <sys/stat.h>
+
+#include <map>
+#include <mutex>
+#include <tuple>
+
 #include "binder/MemoryBase.h"
 #include "binder/MemoryHeapBase.h"
 #include "media/ShmemUtil.h"
 
 namespace android {
 namespace media {
+namespace {
+
+// The heaps mapped by convertSharedFileRegionToIMemory(), so that converting again a region of
+// the same file reuses its mapping while it is alive. The heap holds its own dup of the fd, so
+// the file, and its inode, can't go away and be reused while the entry is alive.
+// Only regular files (memfd) are cached: all the ashmem regions are the same character device.
+class HeapCache {
+  public:
+    sp<MemoryHeapBase> getHeap(int fd, size_t size, uint32_t flags, off_t offset) {
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            return sp<MemoryHeapBase>::make(fd, size, flags, offset);
+        }
+        const Key key{st.st_dev, st.st_ino, offset, size, flags};
+        std::lock_guard l(mLock);
+        if (auto it = mHeaps.find(key); it != mHeaps.end()) {
+            if (sp<MemoryHeapBase> heap = it->second.promote(); heap != nullptr) {
+                return heap;
+            }
+        }
+        const auto heap = sp<MemoryHeapBase>::make(fd, size, flags, offset);
+        if (heap->getHeapID() < 0) {  // don't cache a failed mapping
+            return heap;
+        }
+        for (auto it = mHeaps.begin(); it != mHeaps.end();) {
+            it = it->second.promote() == nullptr ? mHeaps.erase(it) : std::next(it);
+        }
+        mHeaps[key] = heap;
+        return heap;
+    }
+
+  private:
+    using Key = std::tuple<dev_t, ino_t, off_t, size_t, uint32_t>;
+
+    std::mutex mLock;
+    std::map<Key, wp<MemoryHeapBase>> mHeaps;  // GUARDED_BY(mLock)
+};
+
+HeapCache& getHeapCache() {
+    [[clang::no_destroy]] static HeapCache cache;
+    return cache;
+}
+
+}  // namespace
 
 bool convertSharedFileRegionToIMemory(const SharedFileRegion& shmem,
                                       sp<IMemory>* result) {
@@ -52,7 +102,7 @@ bool convertSharedFileRegionToIMemory(const SharedFileRegion& shmem,
     uint32_t flags = !shmem.writeable ? IMemoryHeap::READ_ONLY : 0;
 
     const sp<MemoryHeapBase> heap =
-            new MemoryHeapBase(shmem.fd.get(), heapSize, flags, heapStartOffset);
+            getHeapCache().getHeap(shmem.fd.get(), heapSize, flags, heapStartOffset);
     *result = sp<MemoryBase>::make(heap,
                                    shmem.offset - heapStartOffset,
                                    shmem.size);
@@ -15,6 +15,9 @@
  */
 #include <gtest/gtest.h>
 
+#include <sys/mman.h>
+#include <unistd.h>
+
 #include "binder/MemoryBase.h"
 #include "binder/MemoryHeapBase.h"
 #include "cutils/ashmem.h"
@@ -114,6 +117,33 @@ TEST(ShmemTest, NullConversion) {
     ASSERT_EQ(nullptr, reconstructed);
 }
 
+TEST(ShmemTest, ConversionReusesMapping) {
+    const size_t pageSize = getpagesize();
+    base::unique_fd fd(memfd_create("ShmemTest", MFD_CLOEXEC));
+    ASSERT_TRUE(fd.ok());
+    ASSERT_EQ(0, ftruncate(fd.get(), 2 * pageSize));
+
+    // Every region carries its own dup of the fd, like after a binder transaction.
+    auto makeRegion = [&fd](int64_t offset, int64_t size) {
+        SharedFileRegion shmem;
+        shmem.offset = offset;
+        shmem.size = size;
+        shmem.fd = os::ParcelFileDescriptor(base::unique_fd(dup(fd.get())));
+        shmem.writeable = true;
+        return shmem;
+    };
+    sp<IMemory> first, second, otherPage;
+    ASSERT_TRUE(convertSharedFileRegionToIMemory(makeRegion(0, 3), &first));
+    ASSERT_TRUE(convertSharedFileRegionToIMemory(makeRegion(8, 3), &second));
+    ASSERT_TRUE(convertSharedFileRegionToIMemory(makeRegion(pageSize, 3), &otherPage));
+    EXPECT_EQ(first->getMemory(), second->getMemory());
+    EXPECT_NE(first->getMemory(), otherPage->getMemory());
+
+    uint8_t* p = reinterpret_cast<uint8_t*>(first->unsecurePointer());
+    p[8] = 42;
+    EXPECT_EQ(42, reinterpret_cast<const uint8_t*>(second->unsecurePointer())[0]);
+}
+
 }  // namespace
 }  // namespace media
 }  // namespace android
@@ -30,6 +30,8 @@ namespace media {
 
 /**
  * Converts a SharedFileRegion parcelable to an IMemory instance.
+ * The regions of a regular file (memfd) within the same pages share the heap mapping them,
+ * as long as one of the IMemory instances referencing it is alive.
  * @param shmem The SharedFileRegion instance.
  * @param result The resulting IMemory instance. May not be null.
  * @return true if the conversion is successful (should always succeed under normal circumstances,
@@ -32,7 +32,9 @@ namespace android {
 CallbackDataSource::CallbackDataSource(
     const sp<IDataSource>& binderDataSource)
     : mIDataSource(binderDataSource),
-      mIsClosed(false) {
+      mIsClosed(false),
+      mNumReads(0),
+      mNumBytesRead(0) {
     // Set up the buffer to read into.
     mMemory = mIDataSource->getIMemory();
     mName = String8::format("CallbackDataSource(%d->%d, %s)",
@@ -87,6 +89,8 @@ ssize_t CallbackDataSource::readAt(off64_t offset, void* data, size_t size) {
         totalNumRead += numRead;
     }
 
+    mNumReads.fetch_add(1, std::memory_order_relaxed);
+    mNumBytesRead.fetch_add(totalNumRead, std::memory_order_relaxed);
     return totalNumRead;
 }
 
@@ -114,6 +118,12 @@ void CallbackDataSource::close() {
     }
 }
 
+status_t CallbackDataSource::getReadStatistics(int64_t *numReads, int64_t *numBytes) {
+    *numReads = mNumReads.load(std::memory_order_relaxed);
+    *numBytes = mNumBytesRead.load(std::memory_order_relaxed);
+    return OK;
+}
+
 sp<IDataSource> CallbackDataSource::getIDataSource() const {
     return mIDataSource;
 }
@@ -191,4 +201,138 @@ sp<IDataSource> TinyCacheSource::getIDataSource() const {
     return mSource->getIDataSource();
 }
 
+BlockCacheSource::BlockCacheSource(const sp<DataSource>& source, size_t blockSize)
+    : mSource(source),
+      mBlockSize(blockSize),
+      mFillBuffer(new uint8_t[blockSize * kReadaheadBlocks]),
+      mUseCount(0),
+      mNextFillOffset(-1),
+      mHits(0),
+      mMisses(0) {
+    for (Block &block : mBlocks) {
+        block.mOffset = -1;
+        block.mSize = 0;
+        block.mLastUse = 0;
+        block.mData.reset(new uint8_t[blockSize]);
+    }
+    mName = String8::format("BlockCacheSource(%zu, %s)", blockSize, mSource->toString().c_str());
+}
+
+BlockCacheSource::~BlockCacheSource() {
+    ALOGV("%s: %lld hits, %lld misses", mName.c_str(), (long long)mHits, (long long)mMisses);
+}
+
+status_t BlockCacheSource::initCheck() const {
+    return mSource->initCheck();
+}
+
+BlockCacheSource::Block *BlockCacheSource::findBlock_l(off64_t offset) {
+    for (Block &block : mBlocks) {
+        if (block.mLastUse != 0 && block.mOffset == offset) {
+            return &block;
+        }
+    }
+    return nullptr;
+}
+
+ssize_t BlockCacheSource::fill_l(off64_t offset) {
+    // read ahead only when the misses follow each other
+    const size_t numBlocks = offset == mNextFillOffset ? kReadaheadBlocks : 1;
+    const ssize_t numRead = mSource->readAt(offset, mFillBuffer.get(), numBlocks * mBlockSize);
+    if (numRead <= 0) {
+        return numRead;
+    }
+    if ((size_t)numRead > numBlocks * mBlockSize) {
+        return ERROR_OUT_OF_RANGE;
+    }
+    mNextFillOffset = offset + numBlocks * mBlockSize;
+
+    for (size_t filled = 0; filled < (size_t)numRead; filled += mBlockSize) {
+        Block *block = findBlock_l(offset + filled);
+        if (block == nullptr) {
+            block = &mBlocks[0];
+            for (Block &candidate : mBlocks) {
+                if (candidate.mLastUse < block->mLastUse) {
+                    block = &candidate;
+                }
+            }
+        }
+        block->mOffset = offset + filled;
+        block->mSize = std::min(mBlockSize, (size_t)numRead - filled);
+        block->mLastUse = ++mUseCount;
+        memcpy(block->mData.get(), mFillBuffer.get() + filled, block->mSize);
+    }
+    return numRead;
+}
+
+ssize_t BlockCacheSource::readAt(off64_t offset, void* data, size_t size) {
+    if (offset < 0) {
+        return ERROR_OUT_OF_RANGE;
+    }
+    if (size > mBlockSize) {
+        return mSource->readAt(offset, data, size);
+    }
+
+    Mutex::Autolock autoLock(mLock);
+    bool hit = true;
+    size_t numCopied = 0;
+    while (numCopied < size) {
+        const off64_t position = offset + numCopied;
+        const off64_t blockOffset = position - position % mBlockSize;
+        Block *block = findBlock_l(blockOffset);
+        if (block == nullptr) {
+            hit = false;
+            const ssize_t numRead = fill_l(blockOffset);
+            if (numRead < 0 && numCopied == 0) {
+                ++mMisses;
+                return numRead;
+            }
+            block = numRead > 0 ? findBlock_l(blockOffset) : nullptr;
+            if (block == nullptr) {
+                break;
+            }
+        }
+        block->mLastUse = ++mUseCount;
+
+        const size_t blockPosition = position - blockOffset;
+        if (blockPosition >= block->mSize) {
+            break;  // end of source
+        }
+        const size_t numToCopy = std::min(size - numCopied, block->mSize - blockPosition);
+        memcpy((uint8_t*)data + numCopied, block->mData.get() + blockPosition, numToCopy);
+        numCopied += numToCopy;
+        if (block->mSize < mBlockSize) {
+            break;  // end of source
+        }
+    }
+    if (hit) {
+        ++mHits;
+    } else {
+        ++mMisses;
+    }
+    return numCopied;
+}
+
+status_t BlockCacheSource::getSize(off64_t *size) {
+    return mSource->getSize(size);
+}
+
+uint32_t BlockCacheSource::flags() {
+    return mSource->flags();
+}
+
+void BlockCacheSource::close() {
+    mSource->close();
+}
+
+sp<IDataSource> BlockCacheSource::getIDataSource() const {
+    return mSource->getIDataSource();
+}
+
+void BlockCacheSource::getCacheStatistics(int64_t *hits, int64_t *misses) {
+    Mutex::Autolock autoLock(mLock);
+    *hits = mHits;
+    *misses = mMisses;
+}
+
 } // namespace android
@@ -17,7 +17,9 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "CryptoAsync"
 
+#include <cutils/properties.h>
 #include <log/log.h>
+#include <utils/Timers.h>
 
 #include "hidl/HidlSupport.h"
 #include <media/stagefright/foundation/AMessage.h>
@@ -60,9 +62,41 @@ CryptoAsync::CryptoAsyncInfo::CryptoAsyncInfo(const std::unique_ptr<CodecCryptoI
     }
 }
 
+// Decrypts typically take from 100 us to a few ms.
+static const size_t kDecryptLatencyHistBuckets = 25;
+static const int64_t kDecryptLatencyHistWidthUs = 250;
+static const int32_t kDefaultDecryptDepth = 4;
+
+static size_t getDecryptDepth() {
+    int32_t depth = property_get_int32("media.stagefright.crypto_async.depth",
+            kDefaultDecryptDepth);
+    return depth > 0 ? depth : 1;
+}
+
+CryptoAsync::CryptoAsync(std::weak_ptr<BufferChannelBase> bufferChannel)
+    : mState(kCryptoAsyncActive),
+      mDecryptDepth(getDecryptDepth()),
+      mBufferChannel(std::move(bufferChannel)) {
+    mDecryptLatencyHist.setup(kDecryptLatencyHistBuckets, kDecryptLatencyHistWidthUs);
+}
+
 CryptoAsync::~CryptoAsync() {
 }
 
+CryptoAsync::DecryptLatency CryptoAsync::getDecryptLatency() {
+    DecryptLatency latency;
+    std::lock_guard<std::mutex> lock(mLatencyLock);
+    latency.count = mDecryptLatencyHist.getCount();
+    if (latency.count > 0) {
+        latency.min = mDecryptLatencyHist.getMin();
+        latency.max = mDecryptLatencyHist.getMax();
+        latency.avg = mDecryptLatencyHist.getAvg();
+        latency.hist = mDecryptLatencyHist.emit();
+        latency.histBuckets = mDecryptLatencyHist.emitBuckets();
+    }
+    return latency;
+}
+
 status_t CryptoAsync::decrypt(sp<AMessage> &msg) {
     int32_t decryptAction;
     CHECK(msg->findInt32("action", &decryptAction));
@@ -245,36 +279,51 @@ void CryptoAsync::onMessageReceived(const sp<AMessage> & msg) {
     switch(msg->what()) {
         case kWhatDecrypt:
         {
-            sp<AMessage> thisMsg;
+            // Up to mDecryptDepth buffers are decrypted without going back to the
+            // looper, to save a message round trip per buffer when the input is
+            // queued faster than it is decrypted.
             uint32_t nextTask = kWhatDoNothing;
-            if(OK != getCurrentAndNextTask(&thisMsg, nextTask)) {
-                return;
-            }
-            if (thisMsg != nullptr) {
-                int32_t action;
-                err = OK;
-                CHECK(thisMsg->findInt32("action", &action));
-                switch(action) {
-                    case kActionDecrypt:
-                    {
-                        err = decryptAndQueue(thisMsg);
-                        break;
-                    }
+            for (size_t i = 0; i < mDecryptDepth; ++i) {
+                sp<AMessage> thisMsg;
+                nextTask = kWhatDoNothing;
+                if(OK != getCurrentAndNextTask(&thisMsg, nextTask)) {
+                    return;
+                }
+                if (thisMsg != nullptr) {
+                    const nsecs_t startNs = systemTime(SYSTEM_TIME_MONOTONIC);
+                    int32_t action;
+                    err = OK;
+                    CHECK(thisMsg->findInt32("action", &action));
+                    switch(action) {
+                        case kActionDecrypt:
+                        {
+                            err = decryptAndQueue(thisMsg);
+                            break;
+                        }
 
-                    case kActionAttachEncryptedBuffer:
-                    {
-                        err = attachEncryptedBufferAndQueue(thisMsg);
-                        break;
-                    }
+                        case kActionAttachEncryptedBuffer:
+                        {
+                            err = attachEncryptedBufferAndQueue(thisMsg);
+                            break;
+                        }
 
-                    default:
-                    {
-                        ALOGE("Unrecognized action in decrypt");
+                        default:
+                        {
+                            ALOGE("Unrecognized action in decrypt");
+                        }
+                    }
+                    if (err != OK) {
+                        Mutexed<std::list<sp<AMessage>>>::Locked pendingBuffers(mPendingBuffers);
+                        mState = kCryptoAsyncError;
+                    } else {
+                        const int64_t latencyUs =
+                                (systemTime(SYSTEM_TIME_MONOTONIC) - startNs + 500) / 1000;
+                        std::lock_guard<std::mutex> lock(mLatencyLock);
+                        mDecryptLatencyHist.insert(latencyUs);
                     }
                 }
-                if (err != OK) {
-                    Mutexed<std::list<sp<AMessage>>>::Locked pendingBuffers(mPendingBuffers);
-                    mState = kCryptoAsyncError;
+                if (mState != kCryptoAsyncActive || nextTask == kWhatDoNothing) {
+                    break;
                 }
             }
             // we won't take  next buffers if buffer caused
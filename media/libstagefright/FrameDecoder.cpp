@@ -22,11 +22,14 @@
 #include "include/HevcUtils.h"
 #include <binder/MemoryBase.h>
 #include <binder/MemoryHeapBase.h>
+#include <cutils/properties.h>
 #include <gui/Surface.h>
 #include <inttypes.h>
+#include <algorithm>
 #include <mediadrm/ICrypto.h>
 #include <media/IMediaSource.h>
 #include <media/MediaCodecBuffer.h>
+#include <media/MediaCodecInfo.h>
 #include <media/stagefright/foundation/avc_utils.h>
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/AMessage.h>
@@ -36,6 +39,7 @@
 #include <media/stagefright/MediaBuffer.h>
 #include <media/stagefright/MediaCodec.h>
 #include <media/stagefright/MediaCodecConstants.h>
+#include <media/stagefright/MediaCodecList.h>
 #include <media/stagefright/MediaDefs.h>
 #include <media/stagefright/MediaErrors.h>
 #include <media/stagefright/Utils.h>
@@ -52,6 +56,12 @@ static const int64_t kDefaultSampleDurationUs = 33333LL; // 33ms
 // To make codec for thumbnail less important, give it a value more than 0.
 static const int kThumbnailImportance = 1;
 
+// Codecs that can decode at a reduced resolution advertise this feature in media_codecs.xml, and
+// take the downscale factor (a power of 2) through this vendor parameter.
+static const char *kFeatureReducedResolutionDecode = "feature-reduced-resolution-decode";
+static const char *kKeyReducedResolutionScale = "vendor.reduced-resolution-decode.scale";
+static const int32_t kMaxReducedResolutionScale = 8;
+
 sp<IMemory> allocVideoFrame(const sp<MetaData>& trackMeta,
         int32_t width, int32_t height, int32_t tileWidth, int32_t tileHeight,
         int32_t dstBpp, uint32_t bitDepth, bool allocRotated, bool metaOnly) {
@@ -286,7 +296,8 @@ FrameDecoder::FrameDecoder(
       mDstFormat(OMX_COLOR_Format16bitRGB565),
       mDstBpp(2),
       mHaveMoreInputs(true),
-      mFirstSample(true) {
+      mFirstSample(true),
+      mSamplesRead(0) {
 }
 
 FrameDecoder::~FrameDecoder() {
@@ -335,6 +346,13 @@ status_t FrameDecoder::init(
 
     err = decoder->configure(
             videoFormat, mSurface, NULL /* crypto */, 0 /* flags */);
+    if (err != OK && videoFormat->contains(kKeyReducedResolutionScale)) {
+        ALOGW("configure at reduced resolution returned error %d (%s), retrying at full size",
+                err, asString(err));
+        videoFormat->removeEntryByName(kKeyReducedResolutionScale);
+        err = decoder->configure(
+                videoFormat, mSurface, NULL /* crypto */, 0 /* flags */);
+    }
     if (err != OK) {
         ALOGW("configure returned error %d (%s)", err, asString(err));
         decoder->release();
@@ -406,8 +424,15 @@ status_t FrameDecoder::extractInternal() {
 
             MediaBufferBase *mediaBuffer = NULL;
 
-            err = mSource->read(&mediaBuffer, &mReadOptions);
-            mReadOptions.clearSeekTo();
+            for (;;) {
+                err = mSource->read(&mediaBuffer, &mReadOptions);
+                mReadOptions.clearSeekTo();
+                if (err != OK || shouldQueueSample(mSamplesRead++)) {
+                    break;
+                }
+                mediaBuffer->release();
+                mediaBuffer = NULL;
+            }
             if (err != OK) {
                 mHaveMoreInputs = false;
                 if (!mFirstSample && err == ERROR_END_OF_STREAM) {
@@ -588,6 +613,14 @@ sp<AMessage> VideoFrameDecoder::onGetFormatAndSeekOptions(
         }
     }
 
+    // Let the decoder skip the full resolution reconstruction when a smaller frame is enough.
+    // Frames captured through a surface keep the full resolution.
+    int32_t scale = (*window == NULL) ? getReducedResolutionScale() : 1;
+    if (scale > 1) {
+        ALOGV("requesting decode at 1/%d resolution", scale);
+        videoFormat->setInt32(kKeyReducedResolutionScale, scale);
+    }
+
     // Set the importance for thumbnail.
     videoFormat->setInt32(KEY_IMPORTANCE, kThumbnailImportance);
 
@@ -703,6 +736,9 @@ status_t VideoFrameDecoder::onOutputReceived(
         }
 
         mFrame = static_cast<VideoFrame*>(frameMem->unsecurePointer());
+        if (mCaptureLayer == nullptr) {
+            scaleDisplayRect(mFrame->mWidth, mFrame->mHeight);
+        }
 
         setFrame(frameMem);
     }
@@ -713,6 +749,9 @@ status_t VideoFrameDecoder::onOutputReceived(
         return captureSurface();
     }
     ColorConverter converter((OMX_COLOR_FORMATTYPE)srcFormat, dstFormat());
+    // Large frames can be converted on several threads.
+    converter.setMaxThreads(std::max(property_get_int32(
+            "media.stagefright.thumbnail.color_convert_threads", 1), 1));
 
     uint32_t standard, range, transfer;
     if (!outputFormat->findInt32("color-standard", (int32_t*)&standard)) {
@@ -755,6 +794,68 @@ status_t VideoFrameDecoder::onOutputReceived(
     return ERROR_UNSUPPORTED;
 }
 
+int32_t VideoFrameDecoder::getReducedResolutionScale() const {
+    int32_t maxDimension = property_get_int32(
+            "media.stagefright.thumbnail.max_decode_dimension", 0);
+    int32_t width, height;
+    if (maxDimension <= 0
+            || !trackMeta()->findInt32(kKeyWidth, &width)
+            || !trackMeta()->findInt32(kKeyHeight, &height)) {
+        return 1;
+    }
+
+    // Largest scale that keeps the longer side at or above the requested dimension.
+    int32_t scale = 1;
+    while (scale < kMaxReducedResolutionScale
+            && std::max(width, height) / (scale * 2) >= maxDimension) {
+        scale *= 2;
+    }
+    if (scale == 1) {
+        return 1;
+    }
+
+    const char *mime;
+    sp<IMediaCodecList> list = MediaCodecList::getInstance();
+    if (list == NULL || !trackMeta()->findCString(kKeyMIMEType, &mime)) {
+        return 1;
+    }
+    ssize_t index = list->findCodecByName(componentName().c_str());
+    sp<MediaCodecInfo> info = (index < 0) ? NULL : list->getCodecInfo(index);
+    sp<MediaCodecInfo::Capabilities> caps = (info == NULL) ? NULL : info->getCapabilitiesFor(mime);
+    int32_t supported;
+    if (caps == NULL
+            || !caps->getDetails()->findInt32(kFeatureReducedResolutionDecode, &supported)
+            || !supported) {
+        return 1;
+    }
+    return scale;
+}
+
+void VideoFrameDecoder::scaleDisplayRect(int32_t decodedWidth, int32_t decodedHeight) {
+    // The display size and crop are in stream coordinates; bring them down to the size that
+    // was actually decoded so that the client does not scale the frame back up. A display size
+    // derived from the sample aspect ratio already follows the decoded size.
+    int32_t sarWidth, sarHeight;
+    if (trackMeta()->findInt32(kKeySARWidth, &sarWidth)
+            && trackMeta()->findInt32(kKeySARHeight, &sarHeight)
+            && sarHeight != 0) {
+        return;
+    }
+    int32_t width, height;
+    if (!trackMeta()->findInt32(kKeyWidth, &width)
+            || !trackMeta()->findInt32(kKeyHeight, &height)
+            || width <= 0 || height <= 0
+            || (decodedWidth >= width && decodedHeight >= height)) {
+        return;
+    }
+    mFrame->mDisplayLeft = (int64_t)mFrame->mDisplayLeft * decodedWidth / width;
+    mFrame->mDisplayTop = (int64_t)mFrame->mDisplayTop * decodedHeight / height;
+    mFrame->mDisplayWidth =
+            std::max<int64_t>(1, (int64_t)mFrame->mDisplayWidth * decodedWidth / width);
+    mFrame->mDisplayHeight =
+            std::max<int64_t>(1, (int64_t)mFrame->mDisplayHeight * decodedHeight / height);
+}
+
 sp<Surface> VideoFrameDecoder::initSurface() {
     // create the consumer listener interface, and hold sp so that this
     // interface lives as long as the GraphicBufferSource.
@@ -821,7 +922,35 @@ MediaImageDecoder::MediaImageDecoder(
       mTileWidth(0),
       mTileHeight(0),
       mTilesDecoded(0),
-      mTargetTiles(0) {
+      mTargetTiles(0),
+      mLane(0),
+      mNumLanes(1),
+      mFirstRow(0),
+      mFirstCol(0),
+      mLastCol(0) {
+}
+
+void MediaImageDecoder::setTileLane(
+        int32_t lane, int32_t numLanes, const std::shared_ptr<SharedFrame> &frame) {
+    mLane = lane;
+    mNumLanes = numLanes;
+    mSharedFrame = frame;
+}
+
+bool MediaImageDecoder::shouldQueueSample(size_t index) {
+    // samples are stored in raster order, one per tile
+    int32_t row = index / mGridCols;
+    int32_t col = index % mGridCols;
+    return row >= mFirstRow && std::binary_search(mColumns.begin(), mColumns.end(), col);
+}
+
+void MediaImageDecoder::setColumns(int32_t firstCol, int32_t lastCol) {
+    mFirstCol = firstCol;
+    mLastCol = lastCol;
+    mColumns.clear();
+    for (int32_t col = firstCol + mLane; col <= lastCol; col += mNumLanes) {
+        mColumns.push_back(col);
+    }
 }
 
 sp<AMessage> MediaImageDecoder::onGetFormatAndSeekOptions(
@@ -889,7 +1018,14 @@ sp<AMessage> MediaImageDecoder::onGetFormatAndSeekOptions(
             overrideMeta = trackMeta();
         }
     }
-    mTargetTiles = mGridCols * mGridRows;
+    mFirstRow = 0;
+    setColumns(0, mGridCols - 1);
+    if (mColumns.empty()) {
+        ALOGE("no tile column left for lane %d of %d, grid: %dx%d",
+                mLane, mNumLanes, mGridCols, mGridRows);
+        return NULL;
+    }
+    mTargetTiles = (int32_t)mColumns.size() * mGridRows;
 
     sp<AMessage> videoFormat;
     if (convertMetaDataToMessage(overrideMeta, &videoFormat) != OK) {
@@ -916,20 +1052,18 @@ sp<AMessage> MediaImageDecoder::onGetFormatAndSeekOptions(
 }
 
 status_t MediaImageDecoder::onExtractRect(FrameRect *rect) {
-    // TODO:
     // This callback is for verifying whether we can decode the rect,
     // and if so, set up the internal variables for decoding.
-    // Currently, rect decoding is restricted to sequentially decoding one
-    // row of tiles at a time. We can't decode arbitrary rects, as the image
-    // track doesn't yet support seeking by tiles. So all we do here is to
-    // verify the rect against what we expect.
-    // When seeking by tile is supported, this code should be updated to
-    // set the seek parameters.
+    // The image track doesn't support seeking by tiles, so samples are read
+    // in order and only those of the tiles overlapping the rect are queued.
+    // The first rect selects the tile columns and the first tile row; the
+    // following rects must continue with the next rows of the same columns,
+    // e.g. when decoding the full width of the image one slice at a time.
     if (rect == NULL) {
         if (mTilesDecoded > 0) {
             return ERROR_UNSUPPORTED;
         }
-        mTargetTiles = mGridRows * mGridCols;
+        mTargetTiles = mGridRows * (int32_t)mColumns.size();
         return OK;
     }
 
@@ -937,20 +1071,32 @@ status_t MediaImageDecoder::onExtractRect(FrameRect *rect) {
         return ERROR_UNSUPPORTED;
     }
 
-    int32_t row = mTilesDecoded / mGridCols;
-    int32_t expectedTop = row * mTileHeight;
-    int32_t expectedBot = (row + 1) * mTileHeight;
-    if (expectedBot > mHeight) {
-        expectedBot = mHeight;
+    if (rect->left < 0 || rect->top < 0 || rect->right > mWidth || rect->bottom > mHeight
+            || rect->left >= rect->right || rect->top >= rect->bottom) {
+        ALOGE("invalid rect {%d, %d, %d, %d} for picture size %dx%d",
+                rect->left, rect->top, rect->right, rect->bottom, mWidth, mHeight);
+        return ERROR_UNSUPPORTED;
     }
-    if (rect->left != 0 || rect->top != expectedTop
-            || rect->right != mWidth || rect->bottom != expectedBot) {
+
+    int32_t firstCol = rect->left / mTileWidth;
+    int32_t lastCol = (rect->right - 1) / mTileWidth;
+    int32_t firstRow = rect->top / mTileHeight;
+    int32_t lastRow = (rect->bottom - 1) / mTileHeight;
+    if (mTilesDecoded == 0) {
+        setColumns(firstCol, lastCol);
+        if (mColumns.empty()) {
+            ALOGE("no tile column left for lane %d of %d in columns [%d, %d]",
+                    mLane, mNumLanes, firstCol, lastCol);
+            return ERROR_UNSUPPORTED;
+        }
+        mFirstRow = firstRow;
+    } else if (firstCol != mFirstCol || lastCol != mLastCol
+            || firstRow != mFirstRow + mTilesDecoded / (int32_t)mColumns.size()) {
         ALOGE("currently only support sequential decoding of slices");
         return ERROR_UNSUPPORTED;
     }
 
-    // advance one row
-    mTargetTiles = mTilesDecoded + mGridCols;
+    mTargetTiles = mTilesDecoded + (lastRow - firstRow + 1) * (int32_t)mColumns.size();
     return OK;
 }
 
@@ -984,8 +1130,18 @@ status_t MediaImageDecoder::onOutputReceived(
     }
 
     if (mFrame == NULL) {
-        sp<IMemory> frameMem = allocVideoFrame(
-                trackMeta(), mWidth, mHeight, mTileWidth, mTileHeight, dstBpp(), bitDepth);
+        sp<IMemory> frameMem;
+        if (mSharedFrame != nullptr) {
+            std::lock_guard<std::mutex> lock(mSharedFrame->mLock);
+            if (mSharedFrame->mMemory == nullptr) {
+                mSharedFrame->mMemory = allocVideoFrame(
+                        trackMeta(), mWidth, mHeight, mTileWidth, mTileHeight, dstBpp(), bitDepth);
+            }
+            frameMem = mSharedFrame->mMemory;
+        } else {
+            frameMem = allocVideoFrame(
+                    trackMeta(), mWidth, mHeight, mTileWidth, mTileHeight, dstBpp(), bitDepth);
+        }
 
         if (frameMem == nullptr) {
             return NO_MEMORY;
@@ -1038,8 +1194,8 @@ status_t MediaImageDecoder::onOutputReceived(
     crop_height = crop_bottom - crop_top + 1;
 
     int32_t dstLeft, dstTop, dstRight, dstBottom;
-    dstLeft = mTilesDecoded % mGridCols * crop_width;
-    dstTop = mTilesDecoded / mGridCols * crop_height;
+    dstLeft = mColumns[mTilesDecoded % (int32_t)mColumns.size()] * crop_width;
+    dstTop = (mFirstRow + mTilesDecoded / (int32_t)mColumns.size()) * crop_height;
     dstRight = dstLeft + crop_width - 1;
     dstBottom = dstTop + crop_height - 1;
 
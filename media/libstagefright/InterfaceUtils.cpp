@@ -16,6 +16,7 @@
 
 #include "include/CallbackDataSource.h"
 
+#include <cutils/properties.h>
 #include <media/stagefright/CallbackMediaSource.h>
 #include <media/stagefright/InterfaceUtils.h>
 #include <media/stagefright/RemoteDataSource.h>
@@ -23,10 +24,24 @@
 
 namespace android {
 
+// Block size of the cache in front of remote data sources; 0 keeps the tiny cache.
+static size_t getRemoteSourceCacheBlockSize() {
+    int32_t blockSize = property_get_int32(
+            "media.stagefright.extractor.cache_block_size", 0 /* default_value */);
+    if (blockSize < 512 || blockSize > 1024 * 1024) {
+        return 0;
+    }
+    return blockSize;
+}
+
 sp<DataSource> CreateDataSourceFromIDataSource(const sp<IDataSource> &source) {
     if (source == nullptr) {
         return nullptr;
     }
+    size_t blockSize = getRemoteSourceCacheBlockSize();
+    if (blockSize > 0) {
+        return new BlockCacheSource(new CallbackDataSource(source), blockSize);
+    }
     return new TinyCacheSource(new CallbackDataSource(source));
 }
 
@@ -40,11 +55,12 @@ sp<IDataSource> CreateIDataSourceFromDataSource(const sp<DataSource> &source) {
 sp<IMediaExtractor> CreateIMediaExtractorFromMediaExtractor(
         MediaExtractor *extractor,
         const sp<DataSource> &source,
-        const sp<RefBase> &plugin) {
+        const sp<RefBase> &plugin,
+        int64_t sniffTimeUs) {
     if (extractor == nullptr) {
         return nullptr;
     }
-    return RemoteMediaExtractor::wrap(extractor, source, plugin);
+    return RemoteMediaExtractor::wrap(extractor, source, plugin, sniffTimeUs);
 }
 
 sp<MediaSource> CreateMediaSourceFromIMediaSource(const sp<IMediaSource> &source) {
@@ -31,6 +31,7 @@
 #include <utils/Log.h>
 
 #include <functional>
+#include <vector>
 
 #include <media/stagefright/MediaSource.h>
 #include <media/stagefright/foundation/ADebug.h>
@@ -84,6 +85,9 @@ static const char kMetaKey_CaptureFps[] = "com.android.capture.fps";
 static const char kMetaKey_TemporalLayerCount[] = "com.android.video.temporal_layers_count";
 
 static const int kTimestampDebugCount = 10;
+// Chunks a track may queue for the writer thread when not recording in real
+// time, before its thread waits for the writer to catch up.
+static const size_t kMaxPendingChunksPerTrack = 2;
 static const int kItemIdBase = 10000;
 static const char kExifHeader[] = {'E', 'x', 'i', 'f', '\0', '\0'};
 static const uint8_t kExifApp1Marker[] = {'E', 'x', 'i', 'f', 0xff, 0xe1};
@@ -150,6 +154,9 @@ public:
     int64_t getEstimatedTrackSizeBytes() const;
     int32_t getMetaSizeIncrease(int32_t angle, int32_t trackCount) const;
     void writeTrackHeader();
+    void writeTrexBox();
+    void writeTrafBox(const List<MediaBuffer *> &samples, size_t numSamples, int32_t dataOffset,
+            const uint32_t *sampleSizes);
     int64_t getMinCttsOffsetTimeUs();
     void bufferChunk(int64_t timestampUs);
     bool isAvc() const { return mIsAvc; }
@@ -240,21 +247,6 @@ private:
             return true;
         }
 
-        // adjusts all values by |adjust(value)|
-        void adjustEntries(
-                std::function<void(size_t /* ix */, TYPE(& /* entry */)[ENTRY_SIZE])> update) {
-            size_t nEntries = mTotalNumTableEntries + mNumValuesInCurrEntry / ENTRY_SIZE;
-            size_t ix = 0;
-            for (TYPE *entryArray : mTableEntryList) {
-                size_t num = std::min(nEntries, (size_t)mElementCapacity);
-                for (size_t i = 0; i < num; ++i) {
-                    update(ix++, (TYPE(&)[ENTRY_SIZE])(*entryArray));
-                    entryArray += ENTRY_SIZE;
-                }
-                nEntries -= num;
-            }
-        }
-
         // Store a single value.
         // @arg value must be in network byte order.
         void add(const TYPE& value) {
@@ -311,6 +303,116 @@ private:
         DISALLOW_EVIL_CONSTRUCTORS(ListTableEntries);
     };
 
+    // Table entries that grow with every sample or chunk (stsz, co64, stts and
+    // ctts). Each value is kept as a zigzag varint of its difference from the
+    // same column of the previous entry, which takes one to three bytes for
+    // typical recordings instead of four or eight. Values are only expanded
+    // back to their fixed-size form when the table is written out.
+    template<class TYPE, unsigned ENTRY_SIZE>
+    // ENTRY_SIZE: # of values in each entry
+    struct CompactTableEntries {
+        static_assert(ENTRY_SIZE > 0, "ENTRY_SIZE must be positive");
+        CompactTableEntries()
+            : mTotalNumTableEntries(0),
+            mNumValuesInCurrEntry(0),
+            mPrevValues{} {
+        }
+
+        // Store a single value.
+        // @arg value must be in network byte order.
+        void add(const TYPE& value) {
+            TYPE hostValue = swapNetworkOrder(value);
+            int64_t delta = (int64_t)hostValue - (int64_t)mPrevValues[mNumValuesInCurrEntry];
+            mPrevValues[mNumValuesInCurrEntry] = hostValue;
+
+            if (mBlocks.empty() || mBlocks.back().size() + kMaxVarintBytes > kBlockBytes) {
+                mBlocks.emplace_back();
+                mBlocks.back().reserve(kBlockBytes);
+            }
+            std::vector<uint8_t> &block = mBlocks.back();
+            uint64_t zigzag = ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);
+            while (zigzag >= 0x80) {
+                block.push_back((zigzag & 0x7f) | 0x80);
+                zigzag >>= 7;
+            }
+            block.push_back(zigzag);
+
+            ++mNumValuesInCurrEntry;
+            if (mNumValuesInCurrEntry == ENTRY_SIZE) {
+                ++mTotalNumTableEntries;
+                mNumValuesInCurrEntry = 0;
+            }
+        }
+
+        // Write out the table entries:
+        // 1. the number of entries goes first
+        // 2. followed by the values in the table enties in order
+        // @arg writer the writer to actual write to the storage
+        // @arg update if set, called on every entry (in network byte order)
+        //      before it is written; the stored table is left unchanged.
+        void write(MPEG4Writer *writer,
+                const std::function<void(TYPE(& /* entry */)[ENTRY_SIZE])> &update =
+                        nullptr) const {
+            CHECK_EQ(mNumValuesInCurrEntry, 0u);
+            writer->writeInt32(mTotalNumTableEntries);
+
+            TYPE batch[kWriteBatchEntries][ENTRY_SIZE];
+            TYPE prevValues[ENTRY_SIZE] = {};
+            size_t numInBatch = 0;
+            unsigned column = 0;
+            for (const std::vector<uint8_t> &block : mBlocks) {
+                size_t i = 0;
+                while (i < block.size()) {
+                    uint64_t zigzag = 0;
+                    unsigned shift = 0;
+                    uint8_t byte;
+                    do {
+                        byte = block[i++];
+                        zigzag |= (uint64_t)(byte & 0x7f) << shift;
+                        shift += 7;
+                    } while ((byte & 0x80) && i < block.size());
+                    int64_t delta = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+                    prevValues[column] = (TYPE)((int64_t)prevValues[column] + delta);
+                    batch[numInBatch][column] = swapNetworkOrder(prevValues[column]);
+
+                    if (++column < ENTRY_SIZE) {
+                        continue;
+                    }
+                    column = 0;
+                    if (update) {
+                        update(batch[numInBatch]);
+                    }
+                    if (++numInBatch == kWriteBatchEntries) {
+                        writer->write(batch, sizeof(TYPE) * ENTRY_SIZE, numInBatch);
+                        numInBatch = 0;
+                    }
+                }
+            }
+            if (numInBatch > 0) {
+                writer->write(batch, sizeof(TYPE) * ENTRY_SIZE, numInBatch);
+            }
+        }
+
+        // Return the number of entries in the table.
+        uint32_t count() const { return mTotalNumTableEntries; }
+
+    private:
+        static constexpr size_t kBlockBytes = 16384;
+        static constexpr size_t kMaxVarintBytes = 10;
+        static constexpr size_t kWriteBatchEntries = 1024;
+
+        // htonl/ntohl and hton64/ntoh64 are their own inverses.
+        static uint32_t swapNetworkOrder(uint32_t value) { return ntohl(value); }
+        static off64_t swapNetworkOrder(off64_t value) { return ntoh64(value); }
+
+        uint32_t         mTotalNumTableEntries;
+        uint32_t         mNumValuesInCurrEntry;  // up to ENTRY_SIZE
+        TYPE             mPrevValues[ENTRY_SIZE];  // host byte order
+        std::vector<std::vector<uint8_t>> mBlocks;
+
+        DISALLOW_EVIL_CONSTRUCTORS(CompactTableEntries);
+    };
+
 
 
     MPEG4Writer *mOwner;
@@ -345,12 +447,12 @@ private:
     List<MediaBuffer *> mChunkSamples;
 
     bool mSamplesHaveSameSize;
-    ListTableEntries<uint32_t, 1> *mStszTableEntries;
-    ListTableEntries<off64_t, 1> *mCo64TableEntries;
+    CompactTableEntries<uint32_t, 1> *mStszTableEntries;
+    CompactTableEntries<off64_t, 1> *mCo64TableEntries;
     ListTableEntries<uint32_t, 3> *mStscTableEntries;
     ListTableEntries<uint32_t, 1> *mStssTableEntries;
-    ListTableEntries<uint32_t, 2> *mSttsTableEntries;
-    ListTableEntries<uint32_t, 2> *mCttsTableEntries;
+    CompactTableEntries<uint32_t, 2> *mSttsTableEntries;
+    CompactTableEntries<uint32_t, 2> *mCttsTableEntries;
     ListTableEntries<uint32_t, 3> *mElstTableEntries; // 3columns: segDuration, mediaTime, mediaRate
 
     int64_t mMinCttsOffsetTimeUs;
@@ -493,6 +595,7 @@ private:
     void writeVideoFourCCBox();
     void writeMetadataFourCCBox();
     void writeStblBox();
+    void writeStsdBox();
     void writeEdtsBox();
 
     Track(const Track &);
@@ -536,6 +639,21 @@ void MPEG4Writer::initInternal(int fd, bool isFirstSession) {
     mSendNotify = false;
     mWriteSeekErr = false;
     mFallocateErr = false;
+    mNumWriteCalls = 0;
+    mNumBytesWritten = 0;
+    mTotalWriteDurationUs = 0;
+    mNumFallocateCalls = 0;
+    mTotalFallocateDurationUs = 0;
+    mNumIOStalls = 0;
+    mTotalIOStallDurationUs = 0;
+    mBatchWrites = property_get_bool("media.stagefright.mpeg4writer.batch-writes", true);
+    mBatchingChunk = false;
+    mNumPendingWrites = 0;
+    mPendingWriteHeadersSize = 0;
+    mFragmentDurationUs = 0;
+    mFragmentStartTimeUs = -1;
+    mFragmentSequenceNumber = 0;
+    mFragmentMoovWritten = false;
     // Reset following variables for all the sessions and they will be
     // initialized in start(MetaData *param).
     mIsRealTimeRecording = true;
@@ -544,6 +662,7 @@ void MPEG4Writer::initInternal(int fd, bool isFirstSession) {
     mOffset = 0;
     mMaxOffsetAppend = 0;
     mPreAllocateFileEndOffset = 0;
+    mPreAllocateDemandOffset = 0;
     mMdatOffset = 0;
     mMdatEndOffset = 0;
     mInMemoryCache = NULL;
@@ -614,6 +733,15 @@ status_t MPEG4Writer::dump(
     result.append(buffer);
     snprintf(buffer, SIZE, "     mStarted: %s\n", mStarted? "true": "false");
     result.append(buffer);
+    snprintf(buffer, SIZE, "     writes: %" PRIu64 " calls, %" PRIu64 " bytes, %" PRId64 " us\n",
+            mNumWriteCalls, mNumBytesWritten, mTotalWriteDurationUs);
+    result.append(buffer);
+    snprintf(buffer, SIZE, "     fallocates: %" PRIu64 " calls, %" PRId64 " us\n",
+            mNumFallocateCalls, mTotalFallocateDurationUs);
+    result.append(buffer);
+    snprintf(buffer, SIZE, "     stalls (>= %" PRId64 " ms): %" PRIu64 ", %" PRId64 " us\n",
+            kIOStallThresholdUs / 1000, mNumIOStalls, mTotalIOStallDurationUs);
+    result.append(buffer);
     ::write(fd, result.c_str(), result.size());
     for (List<Track *>::iterator it = mTracks.begin();
          it != mTracks.end(); ++it) {
@@ -963,6 +1091,18 @@ status_t MPEG4Writer::start(MetaData *param) {
         (mMaxFileSizeLimitBytes != 0 &&
          mMaxFileSizeLimitBytes >= kMinStreamableFileSizeInBytes);
 
+    int64_t fragmentDurationUs;
+    if (!param || !param->findInt64(kKeyMovieFragmentDurationUs, &fragmentDurationUs)) {
+        fragmentDurationUs =
+                property_get_int64("media.stagefright.mpeg4writer.fragment-duration-us", 0);
+    }
+    if (fragmentDurationUs > 0 && mHasMoovBox && !mHasFileLevelMeta) {
+        ALOGI("Writing %" PRId64 " us movie fragments", fragmentDurationUs);
+        mFragmentDurationUs = fragmentDurationUs;
+        // The moov is at the front of a fragmented file anyway.
+        mStreamableFile = false;
+    }
+
     /*
      * mWriteBoxToMemory is true if the amount of data in a file-level meta or
      * moov box is smaller than the reserved free space at the beginning of a
@@ -1068,7 +1208,9 @@ status_t MPEG4Writer::start(MetaData *param) {
 
     mOffset = mMdatOffset;
     seekOrPostError(mFd, mMdatOffset, SEEK_SET);
-    write("\x00\x00\x00\x01mdat????????", 16);
+    if (!isFragmented()) {
+        write("\x00\x00\x00\x01mdat????????", 16);
+    }
 
     /* Confirm whether the writing of the initial file atoms, ftyp and free,
      * are written to the file properly by posting kWhatNoIOErrorSoFar to the
@@ -1117,6 +1259,7 @@ status_t MPEG4Writer::stopWriterThread() {
         Mutex::Autolock autolock(mLock);
         mDone = true;
         mChunkReadyCondition.signal();
+        mChunkWrittenCondition.broadcast();
     }
 
     void *dummy;
@@ -1189,6 +1332,11 @@ void MPEG4Writer::printWriteDurations() {
     if (mWriteDurationPQ.empty()) {
         return;
     }
+    ALOGD("%" PRIu64 " write calls, %" PRIu64 " bytes, %" PRId64 " us total",
+            mNumWriteCalls, mNumBytesWritten, mTotalWriteDurationUs);
+    ALOGD("%" PRIu64 " fallocate calls, %" PRId64 " us total; %" PRIu64 " I/O stalls, %" PRId64
+            " us total", mNumFallocateCalls, mTotalFallocateDurationUs, mNumIOStalls,
+            mTotalIOStallDurationUs);
     std::string writeDurationsString =
             "Top " + std::to_string(mWriteDurationPQ.size()) + " write durations(microseconds):";
     uint8_t i = 0;
@@ -1363,6 +1511,17 @@ status_t MPEG4Writer::reset(bool stopSource, bool waitForAnyPreviousCallToComple
         return mResetStatus;
     }
 
+    if (isFragmented()) {
+        // The writer thread has written out the last fragment, there is no moov to add.
+        mMdatEndOffset = mOffset;
+        status_t errRelease = release();
+        if (err == OK) {
+            err = errRelease;
+        }
+        mResetStatus = err;
+        return mResetStatus;
+    }
+
     // Fix up the size of the 'mdat' chunk.
     seekOrPostError(mFd, mMdatOffset + 8, SEEK_SET);
     uint64_t size = mOffset - mMdatOffset;
@@ -1531,6 +1690,24 @@ void MPEG4Writer::writeMoovBox(int64_t durationUs) {
     endBox();  // moov
 }
 
+void MPEG4Writer::writeFragmentedMoovBox() {
+    beginBox("moov");
+    writeMvhdBox(0);
+    if (mAreGeoTagsAvailable) {
+        writeUdtaBox();
+    }
+    writeMoovLevelMetaBox();
+    for (List<Track *>::iterator it = mTracks.begin(); it != mTracks.end(); ++it) {
+        (*it)->writeTrackHeader();
+    }
+    beginBox("mvex");
+    for (List<Track *>::iterator it = mTracks.begin(); it != mTracks.end(); ++it) {
+        (*it)->writeTrexBox();
+    }
+    endBox();  // mvex
+    endBox();  // moov
+}
+
 void MPEG4Writer::writeFtypBox(MetaData *param) {
     beginBox("ftyp");
 
@@ -1656,6 +1833,7 @@ off64_t MPEG4Writer::addSample_l(
         ALOGV("mOffset:%lld, mMaxOffsetAppend:%lld, bytesWritten:%lld", (long long)mOffset,
                   (long long)mMaxOffsetAppend, (long long)*bytesWritten);
         mMaxOffsetAppend = std::max(mOffset, mMaxOffsetAppend);
+        flushSampleData_l();
         seekOrPostError(mFd, mMaxOffsetAppend, SEEK_SET);
         return offset;
     }
@@ -1667,11 +1845,11 @@ off64_t MPEG4Writer::addSample_l(
     } else {
         if (tiffHdrOffset > 0) {
             tiffHdrOffset = htonl(tiffHdrOffset);
-            writeOrPostError(mFd, &tiffHdrOffset, 4);  // exif_tiff_header_offset field
+            writeSampleData_l(&tiffHdrOffset, 4);  // exif_tiff_header_offset field
             mOffset += 4;
         }
 
-        writeOrPostError(mFd, (const uint8_t*)buffer->data() + buffer->range_offset(),
+        writeSampleData_l((const uint8_t*)buffer->data() + buffer->range_offset(),
                          buffer->range_length());
 
         mOffset += buffer->range_length();
@@ -1733,8 +1911,8 @@ void MPEG4Writer::addLengthPrefixedSample_l(MediaBuffer *buffer) {
         x[1] = (length >> 16) & 0xff;
         x[2] = (length >> 8) & 0xff;
         x[3] = length & 0xff;
-        writeOrPostError(mFd, &x, 4);
-        writeOrPostError(mFd, (const uint8_t*)buffer->data() + buffer->range_offset(), length);
+        writeSampleData_l(&x, 4);
+        writeSampleData_l((const uint8_t*)buffer->data() + buffer->range_offset(), length);
         mOffset += length + 4;
     } else {
         ALOGV("mUse2ByteNalLength");
@@ -1743,8 +1921,8 @@ void MPEG4Writer::addLengthPrefixedSample_l(MediaBuffer *buffer) {
         uint8_t x[2];
         x[0] = length >> 8;
         x[1] = length & 0xff;
-        writeOrPostError(mFd, &x, 2);
-        writeOrPostError(mFd, (const uint8_t*)buffer->data() + buffer->range_offset(), length);
+        writeSampleData_l(&x, 2);
+        writeSampleData_l((const uint8_t*)buffer->data() + buffer->range_offset(), length);
         mOffset += length + 2;
     }
 }
@@ -1784,6 +1962,20 @@ size_t MPEG4Writer::write(
     return bytes;
 }
 
+void MPEG4Writer::recordWrite(std::chrono::microseconds writeDuration, ssize_t bytesWritten) {
+    mWriteDurationPQ.emplace(writeDuration);
+    if (mWriteDurationPQ.size() > kWriteDurationsCount) {
+        mWriteDurationPQ.pop();
+    }
+    ++mNumWriteCalls;
+    mNumBytesWritten += bytesWritten > 0 ? bytesWritten : 0;
+    mTotalWriteDurationUs += writeDuration.count();
+    if (writeDuration.count() >= kIOStallThresholdUs) {
+        ++mNumIOStalls;
+        mTotalIOStallDurationUs += writeDuration.count();
+    }
+}
+
 void MPEG4Writer::writeOrPostError(int fd, const void* buf, size_t count) {
     if (mWriteSeekErr == true)
         return;
@@ -1791,12 +1983,8 @@ void MPEG4Writer::writeOrPostError(int fd, const void* buf, size_t count) {
     auto beforeTP = std::chrono::high_resolution_clock::now();
     ssize_t bytesWritten = ::write(fd, buf, count);
     auto afterTP = std::chrono::high_resolution_clock::now();
-    auto writeDuration =
-            std::chrono::duration_cast<std::chrono::microseconds>(afterTP - beforeTP).count();
-    mWriteDurationPQ.emplace(writeDuration);
-    if (mWriteDurationPQ.size() > kWriteDurationsCount) {
-        mWriteDurationPQ.pop();
-    }
+    recordWrite(std::chrono::duration_cast<std::chrono::microseconds>(afterTP - beforeTP),
+            bytesWritten);
 
     /* Write as much as possible during stop() execution when there was an error
      * (mWriteSeekErr == true) in the previous call to write() or lseek64().
@@ -1814,6 +2002,63 @@ void MPEG4Writer::writeOrPostError(int fd, const void* buf, size_t count) {
     WARN_UNLESS(msg->post() == OK, "writeOrPostError:error posting ERROR_IO");
 }
 
+void MPEG4Writer::writeSampleData_l(const void *buf, size_t count) {
+    if (!mBatchingChunk) {
+        writeOrPostError(mFd, buf, count);
+        return;
+    }
+
+    if (mNumPendingWrites == kMaxPendingWrites
+            || (count <= 4 && mPendingWriteHeadersSize + count > sizeof(mPendingWriteHeaders))) {
+        flushSampleData_l();
+    }
+
+    if (count <= 4) {
+        uint8_t *header = mPendingWriteHeaders + mPendingWriteHeadersSize;
+        memcpy(header, buf, count);
+        mPendingWriteHeadersSize += count;
+        buf = header;
+    }
+
+    mPendingWrites[mNumPendingWrites].iov_base = const_cast<void *>(buf);
+    mPendingWrites[mNumPendingWrites].iov_len = count;
+    ++mNumPendingWrites;
+}
+
+void MPEG4Writer::flushSampleData_l() {
+    if (mNumPendingWrites == 0) {
+        return;
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < mNumPendingWrites; ++i) {
+        count += mPendingWrites[i].iov_len;
+    }
+    size_t numPendingWrites = mNumPendingWrites;
+    mNumPendingWrites = 0;
+    mPendingWriteHeadersSize = 0;
+
+    if (mWriteSeekErr == true)
+        return;
+
+    auto beforeTP = std::chrono::high_resolution_clock::now();
+    ssize_t bytesWritten = ::writev(mFd, mPendingWrites, numPendingWrites);
+    auto afterTP = std::chrono::high_resolution_clock::now();
+    recordWrite(std::chrono::duration_cast<std::chrono::microseconds>(afterTP - beforeTP),
+            bytesWritten);
+
+    if (bytesWritten == count)
+        return;
+    mWriteSeekErr = true;
+    ALOGE("flushSampleData_l bytesWritten:%zd, count:%zu, error:%s(%d)", bytesWritten, count,
+          std::strerror(errno), errno);
+
+    // Same as in writeOrPostError().
+    sp<AMessage> msg = new AMessage(kWhatIOError, mReflector);
+    msg->setInt32("err", ERROR_IO);
+    WARN_UNLESS(msg->post() == OK, "flushSampleData_l:error posting ERROR_IO");
+}
+
 void MPEG4Writer::seekOrPostError(int fd, off64_t offset, int whence) {
     if (mWriteSeekErr == true)
         return;
@@ -2022,6 +2267,10 @@ bool MPEG4Writer::isFileStreamable() const {
     return mStreamableFile;
 }
 
+bool MPEG4Writer::isFragmented() const {
+    return mFragmentDurationUs > 0;
+}
+
 bool MPEG4Writer::preAllocate(uint64_t wantSize) {
     if (!mPreAllocationEnabled)
         return true;
@@ -2058,14 +2307,41 @@ bool MPEG4Writer::preAllocate(uint64_t wantSize) {
     ALOGV("approxMetaDataSizeIncrease:%" PRIu64  " wantSize:%" PRIu64, approxMetaDataSizeIncrease,
           wantSize);
     mPrevAllTracksTotalMetaDataSizeEstimate = allTracksTotalMetaDataSizeEstimate;
-    ALOGV("mPreAllocateFileEndOffset:%" PRIu64 " mOffset:%" PRIu64, mPreAllocateFileEndOffset,
+    ALOGV("mPreAllocateDemandOffset:%" PRIu64 " mOffset:%" PRIu64, mPreAllocateDemandOffset,
           mOffset);
-    off64_t lastFileEndOffset = std::max(mPreAllocateFileEndOffset, mOffset);
     uint64_t preAllocateSize = wantSize + approxMOOVBoxSize + approxMetaDataSizeIncrease;
+    mPreAllocateDemandOffset = std::max(mPreAllocateDemandOffset, mOffset) + preAllocateSize;
+    if (mPreAllocateDemandOffset <= mPreAllocateFileEndOffset) {
+        // Still within the space reserved ahead by an earlier call.
+        return true;
+    }
+
+    /* fallocate64() can block the calling track thread for as long as a write, so reserve
+     * kPreAllocateAheadBytes more than asked for and skip the calls until that is used up.
+     * Near a full disk, fall back to reserving only what is needed.
+     */
+    off64_t lastFileEndOffset = std::max(mPreAllocateFileEndOffset, mOffset);
+    off64_t fileEndOffset = mPreAllocateDemandOffset + kPreAllocateAheadBytes;
     ALOGV("preAllocateSize :%" PRIu64 " lastFileEndOffset:%" PRIu64, preAllocateSize,
           lastFileEndOffset);
 
-    int res = fallocate64(mFd, FALLOC_FL_KEEP_SIZE, lastFileEndOffset, preAllocateSize);
+    auto beforeTP = std::chrono::high_resolution_clock::now();
+    int res = fallocate64(mFd, FALLOC_FL_KEEP_SIZE, lastFileEndOffset,
+            fileEndOffset - lastFileEndOffset);
+    if (res == -1 && errno == ENOSPC) {
+        fileEndOffset = mPreAllocateDemandOffset;
+        res = fallocate64(mFd, FALLOC_FL_KEEP_SIZE, lastFileEndOffset,
+                fileEndOffset - lastFileEndOffset);
+    }
+    auto afterTP = std::chrono::high_resolution_clock::now();
+    int64_t fallocateDurationUs =
+            std::chrono::duration_cast<std::chrono::microseconds>(afterTP - beforeTP).count();
+    ++mNumFallocateCalls;
+    mTotalFallocateDurationUs += fallocateDurationUs;
+    if (fallocateDurationUs >= kIOStallThresholdUs) {
+        ++mNumIOStalls;
+        mTotalIOStallDurationUs += fallocateDurationUs;
+    }
     if (res == -1) {
         ALOGE("fallocate err:%s, %d, fd:%d", strerror(errno), errno, mFd);
         sp<AMessage> msg = new AMessage(kWhatFallocateError, mReflector);
@@ -2074,7 +2350,7 @@ bool MPEG4Writer::preAllocate(uint64_t wantSize) {
         mFallocateErr = true;
         ALOGD("preAllocation post:%d", err);
     } else {
-        mPreAllocateFileEndOffset = lastFileEndOffset + preAllocateSize;
+        mPreAllocateFileEndOffset = fileEndOffset;
         ALOGV("mPreAllocateFileEndOffset:%" PRIu64, mPreAllocateFileEndOffset);
     }
     return (res == -1) ? false : true;
@@ -2219,12 +2495,12 @@ MPEG4Writer::Track::Track(
       mTrackDurationUs(0),
       mEstimatedTrackSizeBytes(0),
       mSamplesHaveSameSize(true),
-      mStszTableEntries(new ListTableEntries<uint32_t, 1>(1000)),
-      mCo64TableEntries(new ListTableEntries<off64_t, 1>(1000)),
+      mStszTableEntries(new CompactTableEntries<uint32_t, 1>()),
+      mCo64TableEntries(new CompactTableEntries<off64_t, 1>()),
       mStscTableEntries(new ListTableEntries<uint32_t, 3>(1000)),
       mStssTableEntries(new ListTableEntries<uint32_t, 1>(1000)),
-      mSttsTableEntries(new ListTableEntries<uint32_t, 2>(1000)),
-      mCttsTableEntries(new ListTableEntries<uint32_t, 2>(1000)),
+      mSttsTableEntries(new CompactTableEntries<uint32_t, 2>()),
+      mCttsTableEntries(new CompactTableEntries<uint32_t, 2>()),
       mElstTableEntries(new ListTableEntries<uint32_t, 3>(3)), // Reserve 3 rows, a row has 3 items
       mMinCttsOffsetTimeUs(0),
       mMinCttsOffsetTicks(0),
@@ -2310,11 +2586,11 @@ void MPEG4Writer::Track::resetInternal() {
     mSamplesHaveSameSize = false;
     if (mStszTableEntries != NULL) {
         delete mStszTableEntries;
-        mStszTableEntries = new ListTableEntries<uint32_t, 1>(1000);
+        mStszTableEntries = new CompactTableEntries<uint32_t, 1>();
     }
     if (mCo64TableEntries != NULL) {
         delete mCo64TableEntries;
-        mCo64TableEntries = new ListTableEntries<off64_t, 1>(1000);
+        mCo64TableEntries = new CompactTableEntries<off64_t, 1>();
     }
     if (mStscTableEntries != NULL) {
         delete mStscTableEntries;
@@ -2326,11 +2602,11 @@ void MPEG4Writer::Track::resetInternal() {
     }
     if (mSttsTableEntries != NULL) {
         delete mSttsTableEntries;
-        mSttsTableEntries = new ListTableEntries<uint32_t, 2>(1000);
+        mSttsTableEntries = new CompactTableEntries<uint32_t, 2>();
     }
     if (mCttsTableEntries != NULL) {
         delete mCttsTableEntries;
-        mCttsTableEntries = new ListTableEntries<uint32_t, 2>(1000);
+        mCttsTableEntries = new CompactTableEntries<uint32_t, 2>();
     }
     if (mElstTableEntries != NULL) {
         delete mElstTableEntries;
@@ -2340,6 +2616,10 @@ void MPEG4Writer::Track::resetInternal() {
 }
 
 int64_t MPEG4Writer::Track::trackMetaDataSize() {
+    if (mOwner->isFragmented()) {
+        // A trun entry per sample.
+        return mStszTableEntries->count() * 16;
+    }
     int64_t co64BoxSizeBytes = mCo64TableEntries->count() * 8;
     int64_t stszBoxSizeBytes = mStszTableEntries->count() * 4;
     int64_t trackMetaDataSize = mStscTableEntries->count() * 12 +  // stsc box size
@@ -2362,12 +2642,19 @@ void MPEG4Writer::Track::updateTrackSizeEstimate() {
 
 void MPEG4Writer::Track::addOneStscTableEntry(
         size_t chunkId, size_t sampleId) {
+    // Movie fragments carry their own sample tables.
+    if (mOwner->isFragmented()) {
+        return;
+    }
     mStscTableEntries->add(htonl(chunkId));
     mStscTableEntries->add(htonl(sampleId));
     mStscTableEntries->add(htonl(1));
 }
 
 void MPEG4Writer::Track::addOneStssTableEntry(size_t sampleId) {
+    if (mOwner->isFragmented()) {
+        return;
+    }
     mStssTableEntries->add(htonl(sampleId));
 }
 
@@ -2375,12 +2662,15 @@ void MPEG4Writer::Track::addOneSttsTableEntry(size_t sampleCount, int32_t delta)
     if (delta == 0) {
         ALOGW("0-duration samples found: %zu", sampleCount);
     }
+    if (mOwner->isFragmented()) {
+        return;
+    }
     mSttsTableEntries->add(htonl(sampleCount));
     mSttsTableEntries->add(htonl(delta));
 }
 
 void MPEG4Writer::Track::addOneCttsTableEntry(size_t sampleCount, int32_t sampleOffset) {
-    if (!mIsVideo) {
+    if (!mIsVideo || mOwner->isFragmented()) {
         return;
     }
     mCttsTableEntries->add(htonl(sampleCount));
@@ -2782,6 +3072,14 @@ void MPEG4Writer::bufferChunk(const Chunk& chunk) {
         if (chunk.mTrack == it->mTrack) {  // Found owner
             it->mChunks.push_back(chunk);
             mChunkReadyCondition.signal();
+
+            // The writer thread does not hold the lock while it writes, so
+            // without real time constraints the track would otherwise run
+            // ahead of the file and keep buffering samples.
+            while (!mIsRealTimeRecording && !mDone &&
+                    it->mChunks.size() > kMaxPendingChunksPerTrack) {
+                mChunkWrittenCondition.wait(mLock);
+            }
             return;
         }
     }
@@ -2793,9 +3091,18 @@ void MPEG4Writer::writeChunkToFile(Chunk* chunk) {
     ALOGV("writeChunkToFile: %" PRId64 " from %s track",
         chunk->mTimeStampUs, chunk->mTrack->getTrackType());
 
+    if (isFragmented()) {
+        bufferFragmentChunk(chunk);
+        return;
+    }
+
+    // The samples are released only once the whole chunk is on its way to
+    // the file, since batched writes still point at their data.
+    mBatchingChunk = mBatchWrites;
+
     int32_t isFirstSample = true;
-    while (!chunk->mSamples.empty()) {
-        List<MediaBuffer *>::iterator it = chunk->mSamples.begin();
+    for (List<MediaBuffer *>::iterator it = chunk->mSamples.begin();
+            it != chunk->mSamples.end(); ++it) {
 
         uint32_t tiffHdrOffset;
         if (!(*it)->meta_data().findInt32(
@@ -2814,14 +3121,144 @@ void MPEG4Writer::writeChunkToFile(Chunk* chunk) {
             chunk->mTrack->addChunkOffset(offset);
             isFirstSample = false;
         }
+    }
 
+    flushSampleData_l();
+    mBatchingChunk = false;
+
+    for (List<MediaBuffer *>::iterator it = chunk->mSamples.begin();
+            it != chunk->mSamples.end(); ++it) {
         (*it)->release();
         (*it) = NULL;
-        chunk->mSamples.erase(it);
     }
     chunk->mSamples.clear();
 }
 
+void MPEG4Writer::bufferFragmentChunk(Chunk *chunk) {
+    for (List<ChunkInfo>::iterator it = mChunkInfos.begin();
+         it != mChunkInfos.end(); ++it) {
+        if (it->mTrack == chunk->mTrack) {
+            for (List<MediaBuffer *>::iterator sampleIt = chunk->mSamples.begin();
+                    sampleIt != chunk->mSamples.end(); ++sampleIt) {
+                it->mFragmentSamples.push_back(*sampleIt);
+            }
+            break;
+        }
+    }
+    chunk->mSamples.clear();
+
+    if (mFragmentStartTimeUs < 0) {
+        mFragmentStartTimeUs = chunk->mTimeStampUs;
+    } else if (chunk->mTimeStampUs - mFragmentStartTimeUs >= mFragmentDurationUs
+            && writeFragment(false /* last */)) {
+        mFragmentStartTimeUs = chunk->mTimeStampUs;
+    }
+}
+
+/*
+ * Writes a moof box for the gathered samples, followed by their mdat. The
+ * moof goes in first, in space left for it, once the samples are written and
+ * their sizes known.
+ *
+ * Unless this is the last fragment, the last sample of each track waits for
+ * the next one, as its duration is only known from the sample after it. The
+ * moov waits for a sample of every track, as their sample descriptions need
+ * the codec specific data.
+ */
+bool MPEG4Writer::writeFragment(bool last) {
+    if (!mFragmentMoovWritten) {
+        for (List<ChunkInfo>::iterator it = mChunkInfos.begin();
+             it != mChunkInfos.end(); ++it) {
+            if (!last && it->mFragmentSamples.empty()) {
+                return false;
+            }
+        }
+        writeFragmentedMoovBox();
+        mFragmentMoovWritten = true;
+    }
+
+    const size_t kMoofHeaderSize = 8 + 16;  // moof + mfhd
+    const size_t kTrafHeaderSize = 8 + 16 + 20 + 20;  // traf + tfhd + tfdt + trun
+    const size_t kTrunEntrySize = 16;
+    std::vector<size_t> numSamples;
+    size_t moofSize = kMoofHeaderSize;
+    for (List<ChunkInfo>::iterator it = mChunkInfos.begin();
+         it != mChunkInfos.end(); ++it) {
+        size_t n = it->mFragmentSamples.size();
+        if (n > 0 && !last) {
+            --n;
+        }
+        numSamples.push_back(n);
+        if (n > 0) {
+            moofSize += kTrafHeaderSize + n * kTrunEntrySize;
+        }
+    }
+    if (moofSize == kMoofHeaderSize) {
+        return false;
+    }
+
+    off64_t moofOffset = mOffset;
+    off64_t mdatOffset = moofOffset + moofSize;
+    seekOrPostError(mFd, mdatOffset, SEEK_SET);
+    mOffset = mdatOffset;
+    write("\x00\x00\x00\x01mdat????????", 16);
+
+    std::vector<int32_t> dataOffsets;
+    std::vector<uint32_t> sampleSizes;
+    mBatchingChunk = mBatchWrites;
+    size_t trackIndex = 0;
+    for (List<ChunkInfo>::iterator it = mChunkInfos.begin();
+         it != mChunkInfos.end(); ++it, ++trackIndex) {
+        dataOffsets.push_back(mOffset - moofOffset);
+        List<MediaBuffer *>::iterator sampleIt = it->mFragmentSamples.begin();
+        for (size_t i = 0; i < numSamples[trackIndex]; ++i, ++sampleIt) {
+            size_t bytesWritten;
+            addSample_l(*sampleIt, it->mTrack->usePrefix(), 0, &bytesWritten);
+            sampleSizes.push_back(bytesWritten);
+        }
+    }
+    flushSampleData_l();
+    mBatchingChunk = false;
+    off64_t endOffset = mOffset;
+
+    seekOrPostError(mFd, mdatOffset + 8, SEEK_SET);
+    uint64_t mdatSize = hton64(endOffset - mdatOffset);
+    writeOrPostError(mFd, &mdatSize, 8);
+
+    seekOrPostError(mFd, moofOffset, SEEK_SET);
+    mOffset = moofOffset;
+    beginBox("moof");
+    beginBox("mfhd");
+    writeInt32(0);  // version=0, flags=0
+    writeInt32(++mFragmentSequenceNumber);
+    endBox();  // mfhd
+    trackIndex = 0;
+    const uint32_t *trackSampleSizes = sampleSizes.data();
+    for (List<ChunkInfo>::iterator it = mChunkInfos.begin();
+         it != mChunkInfos.end(); ++it, ++trackIndex) {
+        if (numSamples[trackIndex] > 0) {
+            it->mTrack->writeTrafBox(it->mFragmentSamples, numSamples[trackIndex],
+                    dataOffsets[trackIndex], trackSampleSizes);
+            trackSampleSizes += numSamples[trackIndex];
+        }
+    }
+    endBox();  // moof
+    CHECK_EQ(mOffset, mdatOffset);
+
+    seekOrPostError(mFd, endOffset, SEEK_SET);
+    mOffset = endOffset;
+
+    trackIndex = 0;
+    for (List<ChunkInfo>::iterator it = mChunkInfos.begin();
+         it != mChunkInfos.end(); ++it, ++trackIndex) {
+        for (size_t i = 0; i < numSamples[trackIndex]; ++i) {
+            (*it->mFragmentSamples.begin())->release();
+            it->mFragmentSamples.erase(it->mFragmentSamples.begin());
+        }
+    }
+    return true;
+}
+
 void MPEG4Writer::writeAllChunks() {
     ALOGV("writeAllChunks");
     size_t outstandingChunks = 0;
@@ -2830,6 +3267,9 @@ void MPEG4Writer::writeAllChunks() {
         writeChunkToFile(&chunk);
         ++outstandingChunks;
     }
+    if (isFragmented()) {
+        writeFragment(true /* last */);
+    }
 
     sendSessionSummary();
 
@@ -2900,18 +3340,16 @@ void MPEG4Writer::threadFunc() {
             mChunkReadyCondition.wait(mLock);
         }
 
-        // In real time recording mode, write without holding the lock in order
-        // to reduce the blocking time for media track threads.
-        // Otherwise, hold the lock until the existing chunks get written to the
-        // file.
+        // Write without holding the lock, so that the track threads keep
+        // preparing their next chunks while this one goes to the file. Only
+        // the file offsets are assigned here, one chunk at a time. Outside of
+        // real time recording, bufferChunk() bounds how far a track can get
+        // ahead of the writer.
         if (chunkFound) {
-            if (mIsRealTimeRecording) {
-                mLock.unlock();
-            }
+            mLock.unlock();
             writeChunkToFile(&chunk);
-            if (mIsRealTimeRecording) {
-                mLock.lock();
-            }
+            mLock.lock();
+            mChunkWrittenCondition.broadcast();
         }
     }
 
@@ -3494,6 +3932,8 @@ status_t MPEG4Writer::Track::threadEntry() {
     int32_t count = 0;
     const int64_t interleaveDurationUs = mOwner->interleaveDuration();
     const bool hasMultipleTracks = (mOwner->numTracks() > 1);
+    // Movie fragments are written from the writer thread, even for a single track.
+    const bool bufferChunks = hasMultipleTracks || mOwner->isFragmented();
     int64_t chunkTimestampUs = 0;
     int32_t nChunks = 0;
     int32_t nActualFrames = 0;        // frames containing non-CSD data (non-0 length)
@@ -3671,6 +4111,13 @@ status_t MPEG4Writer::Track::threadEntry() {
             lastSample = -1;
         }
         ALOGV("sampleFileOffset:%lld", (long long)sampleFileOffset);
+        if (sampleFileOffset != -1 && mOwner->isFragmented()) {
+            ALOGE("Samples already in the file cannot go in movie fragments");
+            buffer->release();
+            mSource->stop();
+            mIsMalformed = true;
+            break;
+        }
 
         /*
          * Reserve space in the file for the current sample + to be written MOOV box. If reservation
@@ -3687,19 +4134,28 @@ status_t MPEG4Writer::Track::threadEntry() {
         ++nActualFrames;
 
         // Make a deep copy of the MediaBuffer and Metadata and release
-        // the original as soon as we can
-        MediaBuffer *copy = new MediaBuffer(buffer->range_length());
-        if (sampleFileOffset != -1) {
-            copy->meta_data().setInt64(kKeySampleFileOffset, sampleFileOffset);
+        // the original as soon as we can, unless the source already handed
+        // over a copy of its own (see MediaAdapter::pushBuffer()).
+        MediaBuffer *copy;
+        int32_t isPrivateCopy = false;
+        if (buffer->meta_data().findInt32(kKeyIsPrivateCopy, &isPrivateCopy) && isPrivateCopy) {
+            meta_data = new MetaData(buffer->meta_data());
+            copy = static_cast<MediaBuffer *>(buffer);
+            buffer = NULL;
         } else {
-            memcpy(copy->data(), (uint8_t*)buffer->data() + buffer->range_offset(),
-                   buffer->range_length());
-        }
-        copy->set_range(0, buffer->range_length());
+            copy = new MediaBuffer(buffer->range_length());
+            if (sampleFileOffset != -1) {
+                copy->meta_data().setInt64(kKeySampleFileOffset, sampleFileOffset);
+            } else {
+                memcpy(copy->data(), (uint8_t*)buffer->data() + buffer->range_offset(),
+                       buffer->range_length());
+            }
+            copy->set_range(0, buffer->range_length());
 
-        meta_data = new MetaData(buffer->meta_data());
-        buffer->release();
-        buffer = NULL;
+            meta_data = new MetaData(buffer->meta_data());
+            buffer->release();
+            buffer = NULL;
+        }
         if (isExif) {
             copy->meta_data().setInt32(kKeyExifTiffOffset, tiffHdrOffset);
         }
@@ -3978,8 +4434,16 @@ status_t MPEG4Writer::Track::threadEntry() {
                 }
                 trackProgressStatus(timestampUs);
             }
+
+            if (mOwner->isFragmented()) {
+                // What writeTrafBox() needs to describe the sample.
+                copy->meta_data().setInt64(kKeyDecodingTime, timestampUs);
+                copy->meta_data().setInt64(kKeyTime, mIsVideo ?
+                        timestampUs + cttsOffsetTimeUs - kMaxCttsOffsetTimeUs : timestampUs);
+                copy->meta_data().setInt32(kKeyIsSyncFrame, isSync);
+            }
         }
-        if (!hasMultipleTracks) {
+        if (!bufferChunks) {
             size_t bytesWritten;
             off64_t offset = mOwner->addSample_l(
                     copy, usePrefix, tiffHdrOffset, &bytesWritten);
@@ -4042,7 +4506,7 @@ status_t MPEG4Writer::Track::threadEntry() {
             }
         } else {
             // Last chunk
-            if (!hasMultipleTracks) {
+            if (!bufferChunks) {
                 addOneStscTableEntry(1, mStszTableEntries->count());
             } else if (!mChunkSamples.empty()) {
                 addOneStscTableEntry(++nChunks, mChunkSamples.size());
@@ -4351,7 +4815,9 @@ void MPEG4Writer::Track::writeTrackHeader() {
     uint32_t now = getMpeg4Time();
     mOwner->beginBox("trak");
         writeTkhdBox(now);
-        writeEdtsBox();
+        if (!mOwner->isFragmented()) {
+            writeEdtsBox();
+        }
         mOwner->beginBox("mdia");
             writeMdhdBox(now);
             writeHdlrBox();
@@ -4382,19 +4848,23 @@ int64_t MPEG4Writer::Track::getMinCttsOffsetTimeUs() {
 
 void MPEG4Writer::Track::writeStblBox() {
     mOwner->beginBox("stbl");
-    // Add subboxes for only non-empty and well-formed tracks.
-    if (mStszTableEntries->count() > 0 && !isTrackMalFormed()) {
-        mOwner->beginBox("stsd");
-        mOwner->writeInt32(0);               // version=0, flags=0
-        mOwner->writeInt32(1);               // entry count
-        if (mIsAudio) {
-            writeAudioFourCCBox();
-        } else if (mIsVideo) {
-            writeVideoFourCCBox();
-        } else {
-            writeMetadataFourCCBox();
+    if (mOwner->isFragmented()) {
+        // The samples are all in movie fragments, leave the tables empty.
+        if (checkCodecSpecificData() == OK) {
+            writeStsdBox();
+        }
+        for (const char *fourcc : {"stts", "stsc", "stsz", "stco"}) {
+            mOwner->beginBox(fourcc);
+            mOwner->writeInt32(0);  // version=0, flags=0
+            if (!strcmp(fourcc, "stsz")) {
+                mOwner->writeInt32(0);  // sample size
+            }
+            mOwner->writeInt32(0);  // entry count
+            mOwner->endBox();
         }
-        mOwner->endBox();  // stsd
+    } else if (mStszTableEntries->count() > 0 && !isTrackMalFormed()) {
+        // Add subboxes for only non-empty and well-formed tracks.
+        writeStsdBox();
         writeSttsBox();
         if (mIsVideo) {
             writeCttsBox();
@@ -4407,6 +4877,87 @@ void MPEG4Writer::Track::writeStblBox() {
     mOwner->endBox();  // stbl
 }
 
+void MPEG4Writer::Track::writeStsdBox() {
+    mOwner->beginBox("stsd");
+    mOwner->writeInt32(0);               // version=0, flags=0
+    mOwner->writeInt32(1);               // entry count
+    if (mIsAudio) {
+        writeAudioFourCCBox();
+    } else if (mIsVideo) {
+        writeVideoFourCCBox();
+    } else {
+        writeMetadataFourCCBox();
+    }
+    mOwner->endBox();  // stsd
+}
+
+void MPEG4Writer::Track::writeTrexBox() {
+    mOwner->beginBox("trex");
+    mOwner->writeInt32(0);  // version=0, flags=0
+    mOwner->writeInt32(mTrackId.getId());
+    mOwner->writeInt32(1);  // default sample description index
+    mOwner->writeInt32(0);  // default sample duration
+    mOwner->writeInt32(0);  // default sample size
+    mOwner->writeInt32(0);  // default sample flags
+    mOwner->endBox();  // trex
+}
+
+/*
+ * Describes the first |numSamples| of |samples|, whose data is |dataOffset|
+ * bytes from the start of the moof. A sample's duration is the time to the
+ * next one; the very last sample of the track lasts up to the track duration.
+ */
+void MPEG4Writer::Track::writeTrafBox(
+        const List<MediaBuffer *> &samples, size_t numSamples, int32_t dataOffset,
+        const uint32_t *sampleSizes) {
+    auto toTicks = [this](int64_t timeUs) {
+        return (timeUs * mTimeScale + 500000LL) / 1000000LL;
+    };
+    const uint32_t kSyncSampleFlags = 0x02000000;     // depends on no other sample
+    const uint32_t kNonSyncSampleFlags = 0x01010000;  // depends on others, non-sync
+
+    List<MediaBuffer *>::const_iterator it = samples.begin();
+    int64_t decodingTimeUs;
+    CHECK((*it)->meta_data().findInt64(kKeyDecodingTime, &decodingTimeUs));
+
+    mOwner->beginBox("traf");
+    mOwner->beginBox("tfhd");
+    mOwner->writeInt32(0x020000);  // version=0, flags=default-base-is-moof
+    mOwner->writeInt32(mTrackId.getId());
+    mOwner->endBox();  // tfhd
+    mOwner->beginBox("tfdt");
+    mOwner->writeInt32(0x01000000);  // version=1, flags=0
+    mOwner->writeInt64(getStartTimeOffsetScaledTime() + toTicks(decodingTimeUs));
+    mOwner->endBox();  // tfdt
+    mOwner->beginBox("trun");
+    // version=1 for signed composition time offsets; flags: data offset, and sample
+    // duration, size, flags and composition time offset present
+    mOwner->writeInt32(0x01000f01);
+    mOwner->writeInt32(numSamples);
+    mOwner->writeInt32(dataOffset);
+    int64_t durationTicks = 0;
+    for (size_t i = 0; i < numSamples; ++i) {
+        int64_t timeUs;
+        int32_t isSync;
+        CHECK((*it)->meta_data().findInt64(kKeyTime, &timeUs));
+        CHECK((*it)->meta_data().findInt32(kKeyIsSyncFrame, &isSync));
+        int64_t nextDecodingTimeUs = decodingTimeUs;
+        if (++it != samples.end()) {
+            CHECK((*it)->meta_data().findInt64(kKeyDecodingTime, &nextDecodingTimeUs));
+            durationTicks = toTicks(nextDecodingTimeUs) - toTicks(decodingTimeUs);
+        } else if (toTicks(mTrackDurationUs) > toTicks(decodingTimeUs)) {
+            durationTicks = toTicks(mTrackDurationUs) - toTicks(decodingTimeUs);
+        }
+        mOwner->writeInt32(durationTicks);
+        mOwner->writeInt32(sampleSizes[i]);
+        mOwner->writeInt32(!mIsVideo || isSync ? kSyncSampleFlags : kNonSyncSampleFlags);
+        mOwner->writeInt32(toTicks(timeUs) - toTicks(decodingTimeUs));
+        decodingTimeUs = nextDecodingTimeUs;
+    }
+    mOwner->endBox();  // trun
+    mOwner->endBox();  // traf
+}
+
 void MPEG4Writer::Track::writeMetadataFourCCBox() {
     const char *mime;
     bool success = mMeta->findCString(kKeyMIMEType, &mime);
@@ -4769,7 +5320,7 @@ void MPEG4Writer::Track::writeTkhdBox(uint32_t now) {
     mOwner->writeInt32(now);           // modification time
     mOwner->writeInt32(mTrackId.getId()); // track id starts with 1
     mOwner->writeInt32(0);             // reserved
-    int64_t trakDurationUs = getDurationUs();
+    int64_t trakDurationUs = mOwner->isFragmented() ? 0 : getDurationUs();
     int32_t mvhdTimeScale = mOwner->getTimeScale();
     int32_t tkhdDuration =
         (trakDurationUs * mvhdTimeScale + 5E5) / 1E6;
@@ -4972,7 +5523,7 @@ void MPEG4Writer::Track::writeEdtsBox() {
 }
 
 void MPEG4Writer::Track::writeMdhdBox(uint32_t now) {
-    int64_t trakDurationUs = getDurationUs();
+    int64_t trakDurationUs = mOwner->isFragmented() ? 0 : getDurationUs();
     int64_t mdhdDuration = (trakDurationUs * mTimeScale + 5E5) / 1E6;
     mOwner->beginBox("mdhd");
 
@@ -5164,7 +5715,7 @@ void MPEG4Writer::Track::writeCttsBox() {
     int64_t deltaTimeUs = mMinCttsOffsetTimeUs;
     ALOGV("ctts deltaTimeUs:%" PRId64, deltaTimeUs);
     int64_t delta = (deltaTimeUs * mTimeScale + 500000LL) / 1000000LL;
-    mCttsTableEntries->adjustEntries([delta](size_t /* ix */, uint32_t (&value)[2]) {
+    mCttsTableEntries->write(mOwner, [delta](uint32_t (&value)[2]) {
         // entries are <count, ctts> pairs; adjust only ctts
         uint32_t duration = htonl(value[1]); // back to host byte order
         // Prevent overflow and underflow
@@ -5177,7 +5728,6 @@ void MPEG4Writer::Track::writeCttsBox() {
         }
         value[1] = htonl(duration);
     });
-    mCttsTableEntries->write(mOwner);
     mOwner->endBox();  // ctts
 }
 
@@ -22,10 +22,13 @@
 #include <media/stagefright/MediaAdapter.h>
 #include <media/stagefright/MediaBuffer.h>
 
+#include <string.h>
+#include <unistd.h>
+
 namespace android {
 
 MediaAdapter::MediaAdapter(const sp<MetaData> &meta)
-    : mCurrentMediaBuffer(NULL),
+    : mReaderTid(-1),
       mStarted(false),
       mOutputFormat(meta) {
 }
@@ -33,7 +36,7 @@ MediaAdapter::MediaAdapter(const sp<MetaData> &meta)
 MediaAdapter::~MediaAdapter() {
     Mutex::Autolock autoLock(mAdapterLock);
     mOutputFormat.clear();
-    CHECK(mCurrentMediaBuffer == NULL);
+    releaseQueuedBuffers_l();
 }
 
 status_t MediaAdapter::start(MetaData * /* params */) {
@@ -45,65 +48,74 @@ status_t MediaAdapter::start(MetaData * /* params */) {
 }
 
 status_t MediaAdapter::stop() {
-    MediaBuffer *currentBuffer = NULL;
-    {
-        Mutex::Autolock autoLock(mAdapterLock);
-        if (mStarted) {
-            mStarted = false;
-            // If stop() happens immediately after a pushBuffer(), we should
-            // clean up the mCurrentMediaBuffer. But need to release without
-            // the lock as signalBufferReturned() will acquire the lock.
-            currentBuffer = mCurrentMediaBuffer;
-            mCurrentMediaBuffer = NULL;
-
-            // While read() is still waiting, we should signal it to finish.
-            mBufferReadCond.signal();
+    Mutex::Autolock autoLock(mAdapterLock);
+    if (mStarted) {
+        // Give the reader a chance to take the samples that were already
+        // queued, unless it is the reader itself giving up on them.
+        if (gettid() != mReaderTid) {
+            while (!mQueuedBuffers.empty()) {
+                if (mBufferTakenCond.waitRelative(mAdapterLock, kDrainTimeoutNs) != OK) {
+                    ALOGW("dropping %zu samples the reader did not take",
+                            mQueuedBuffers.size());
+                    break;
+                }
+            }
         }
-    }
-    if (currentBuffer != NULL) {
-        currentBuffer->release();
-        currentBuffer = NULL;
+        mStarted = false;
+        releaseQueuedBuffers_l();
+
+        // While read() or pushBuffer() is still waiting, we should signal it
+        // to finish.
+        mBufferReadCond.signal();
+        mBufferTakenCond.broadcast();
     }
     return OK;
 }
 
+void MediaAdapter::releaseQueuedBuffers_l() {
+    // The queued copies have no observer, so releasing them does not call
+    // back into signalBufferReturned().
+    while (!mQueuedBuffers.empty()) {
+        (*mQueuedBuffers.begin())->release();
+        mQueuedBuffers.erase(mQueuedBuffers.begin());
+    }
+}
+
 sp<MetaData> MediaAdapter::getFormat() {
     Mutex::Autolock autoLock(mAdapterLock);
     return mOutputFormat;
 }
 
 void MediaAdapter::signalBufferReturned(MediaBufferBase *buffer) {
-    Mutex::Autolock autoLock(mAdapterLock);
     CHECK(buffer != NULL);
     buffer->setObserver(0);
     buffer->release();
     ALOGV("buffer returned %p", buffer);
-    mBufferReturnedCond.signal();
 }
 
 status_t MediaAdapter::read(
             MediaBufferBase **buffer, const ReadOptions * /* options */) {
     Mutex::Autolock autoLock(mAdapterLock);
+    mReaderTid = gettid();
     if (!mStarted) {
         ALOGV("Read before even started!");
         return ERROR_END_OF_STREAM;
     }
 
-    while (mCurrentMediaBuffer == NULL && mStarted) {
+    while (mQueuedBuffers.empty() && mStarted) {
         ALOGV("waiting @ read()");
         mBufferReadCond.wait(mAdapterLock);
     }
 
     if (!mStarted) {
         ALOGV("read interrupted after stop");
-        CHECK(mCurrentMediaBuffer == NULL);
+        CHECK(mQueuedBuffers.empty());
         return ERROR_END_OF_STREAM;
     }
 
-    CHECK(mCurrentMediaBuffer != NULL);
-
-    *buffer = mCurrentMediaBuffer;
-    mCurrentMediaBuffer = NULL;
+    *buffer = *mQueuedBuffers.begin();
+    mQueuedBuffers.erase(mQueuedBuffers.begin());
+    mBufferTakenCond.broadcast();
 
     return OK;
 }
@@ -114,25 +126,40 @@ status_t MediaAdapter::pushBuffer(MediaBuffer *buffer) {
         return -EINVAL;
     }
 
-    /* As mAdapterLock is unlocked while waiting for signalBufferReturned,
+    // Copy the sample outside of the lock, so that the caller can re-use its
+    // buffer once we return and the reader can keep the copy instead of
+    // making its own.
+    MediaBuffer *copy = new MediaBuffer(buffer->range_length());
+    memcpy(copy->data(), (const uint8_t *)buffer->data() + buffer->range_offset(),
+            buffer->range_length());
+    copy->meta_data() = buffer->meta_data();
+    copy->meta_data().setInt32(kKeyIsPrivateCopy, true);
+
+    // The caller handed over a reference, see signalBufferReturned().
+    buffer->setObserver(this);
+    buffer->release();
+    buffer = NULL;
+
+    /* As mAdapterLock is unlocked while waiting for room in the queue,
      * a new buffer for the same track could be pushed from another thread
      * in the client process, mBufferGatingMutex will help to hold that
-     * until the previous buffer is processed.
+     * until the previous buffer is queued.
      */
     std::unique_lock<std::mutex> lk(mBufferGatingMutex);
 
     Mutex::Autolock autoLock(mAdapterLock);
+    while (mStarted && mQueuedBuffers.size() >= kMaxQueuedBuffers) {
+        ALOGV("wait for room in the queue @ pushBuffer!");
+        mBufferTakenCond.wait(mAdapterLock);
+    }
     if (!mStarted) {
         ALOGE("pushBuffer called before start");
+        copy->release();
         return INVALID_OPERATION;
     }
-    mCurrentMediaBuffer = buffer;
-    mCurrentMediaBuffer->setObserver(this);
+    mQueuedBuffers.push_back(copy);
     mBufferReadCond.signal();
 
-    ALOGV("wait for the buffer returned @ pushBuffer! %p", buffer);
-    mBufferReturnedCond.wait(mAdapterLock);
-
     return OK;
 }
 
@@ -19,6 +19,7 @@
 #define LOG_TAG "MediaCodec"
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <dlfcn.h>
 #include <inttypes.h>
 #include <future>
@@ -159,6 +160,17 @@ static const char *kCodecLatencyAvg = "android.media.mediacodec.latency.avg";
 static const char *kCodecLatencyCount = "android.media.mediacodec.latency.n";
 static const char *kCodecLatencyHist = "android.media.mediacodec.latency.hist"; /* in us */
 static const char *kCodecLatencyUnknown = "android.media.mediacodec.latency.unknown";
+// per-stage latency is reported as <prefix>.<stage>.{max,avg,n,hist}, in us
+static const char *kCodecStageLatencyPrefix = "android.media.mediacodec.latency.";
+static const char *kCodecStageLatencyNames[] = {"input", "codec", "output", "client", "render"};
+// decrypt and queue of a buffer by CryptoAsync, in us
+static const char *kCodecDecryptLatencyMax = "android.media.mediacodec.latency.decrypt.max";
+static const char *kCodecDecryptLatencyMin = "android.media.mediacodec.latency.decrypt.min";
+static const char *kCodecDecryptLatencyAvg = "android.media.mediacodec.latency.decrypt.avg";
+static const char *kCodecDecryptLatencyCount = "android.media.mediacodec.latency.decrypt.n";
+static const char *kCodecDecryptLatencyHist = "android.media.mediacodec.latency.decrypt.hist";
+static const char *kCodecDecryptLatencyHistBuckets =
+        "android.media.mediacodec.latency.decrypt.hist-buckets";
 static const char *kCodecQueueSecureInputBufferError = "android.media.mediacodec.queueSecureInputBufferError";
 static const char *kCodecQueueInputBufferError = "android.media.mediacodec.queueInputBufferError";
 static const char *kCodecComponentColorFormat = "android.media.mediacodec.component-color-format";
@@ -207,6 +219,8 @@ static const char *kCodecRecentLatencyHist = "android.media.mediacodec.recent.hi
 /* -1: shaper disabled
    >=0: number of fields changed */
 static const char *kCodecShapingEnhanced = "android.media.mediacodec.shaped";
+/* time spent shaping the format, including the format conversions */
+static const char *kCodecShapingDurationUs = "android.media.mediacodec.shaping.durationUs";
 
 // Render metrics
 static const char *kCodecPlaybackDurationSec = "android.media.mediacodec.playback-duration-sec";
@@ -215,6 +229,7 @@ static const char *kCodecLastRenderTimeUs = "android.media.mediacodec.last-rende
 static const char *kCodecFramesReleased = "android.media.mediacodec.frames-released";
 static const char *kCodecFramesRendered = "android.media.mediacodec.frames-rendered";
 static const char *kCodecFramesDropped = "android.media.mediacodec.frames-dropped";
+static const char *kCodecFramesLate = "android.media.mediacodec.frames-late";
 static const char *kCodecFramesSkipped = "android.media.mediacodec.frames-skipped";
 static const char *kCodecFramerateContent = "android.media.mediacodec.framerate-content";
 static const char *kCodecFramerateDesired = "android.media.mediacodec.framerate-desired";
@@ -1310,6 +1325,10 @@ void MediaCodec::initMediametrics() {
     {
         Mutex::Autolock al(mLatencyLock);
         mBuffersInFlight.clear();
+        mFramesAwaitingRender.clear();
+        for (MediaHistogram<int64_t> &hist : mStageLatencyHist) {
+            hist.setup(kLatencyHistBuckets, kLatencyHistWidth, kLatencyHistFloor);
+        }
         mNumLowLatencyEnables = 0;
         mNumLowLatencyDisables = 0;
         mIsLowLatencyModeOn = false;
@@ -1368,6 +1387,7 @@ void MediaCodec::updateMediametrics() {
             mediametrics_setInt64(mMetricsHandle, kCodecFramesRendered, m.frameRenderedCount);
             mediametrics_setInt64(mMetricsHandle, kCodecFramesSkipped, m.frameSkippedCount);
             mediametrics_setInt64(mMetricsHandle, kCodecFramesDropped, m.frameDroppedCount);
+            mediametrics_setInt64(mMetricsHandle, kCodecFramesLate, m.frameLateCount);
             mediametrics_setDouble(mMetricsHandle, kCodecFramerateContent, m.contentFrameRate);
             mediametrics_setDouble(mMetricsHandle, kCodecFramerateDesired, m.desiredFrameRate);
             mediametrics_setDouble(mMetricsHandle, kCodecFramerateActual, m.actualFrameRate);
@@ -1424,6 +1444,36 @@ void MediaCodec::updateMediametrics() {
     if (mLatencyUnknown > 0) {
         mediametrics_setInt64(mMetricsHandle, kCodecLatencyUnknown, mLatencyUnknown);
     }
+    {
+        Mutex::Autolock al(mLatencyLock);
+        for (size_t stage = 0; stage < kLatencyStageCount; ++stage) {
+            const MediaHistogram<int64_t> &hist = mStageLatencyHist[stage];
+            if (hist.getCount() == 0) {
+                continue;
+            }
+            std::string key = std::string(kCodecStageLatencyPrefix)
+                    + kCodecStageLatencyNames[stage];
+            mediametrics_setInt64(mMetricsHandle, (key + ".max").c_str(), hist.getMax());
+            mediametrics_setInt64(mMetricsHandle, (key + ".avg").c_str(), hist.getAvg());
+            mediametrics_setInt64(mMetricsHandle, (key + ".n").c_str(), hist.getCount());
+            if (kEmitHistogram) {
+                mediametrics_setCString(mMetricsHandle, (key + ".hist").c_str(),
+                                        hist.emit().c_str());
+            }
+        }
+    }
+    if (mCryptoAsync) {
+        CryptoAsync::DecryptLatency latency = mCryptoAsync->getDecryptLatency();
+        if (latency.count > 0) {
+            mediametrics_setInt64(mMetricsHandle, kCodecDecryptLatencyMax, latency.max);
+            mediametrics_setInt64(mMetricsHandle, kCodecDecryptLatencyMin, latency.min);
+            mediametrics_setInt64(mMetricsHandle, kCodecDecryptLatencyAvg, latency.avg);
+            mediametrics_setInt64(mMetricsHandle, kCodecDecryptLatencyCount, latency.count);
+            mediametrics_setString(mMetricsHandle, kCodecDecryptLatencyHist, latency.hist);
+            mediametrics_setString(mMetricsHandle, kCodecDecryptLatencyHistBuckets,
+                                   latency.histBuckets);
+        }
+    }
     int64_t playbackDurationSec = mPlaybackDurationAccumulator.getDurationInSeconds();
     if (playbackDurationSec > 0) {
         mediametrics_setInt64(mMetricsHandle, kCodecPlaybackDurationSec, playbackDurationSec);
@@ -1841,6 +1891,7 @@ void MediaCodec::processRenderedFrames(const sp<AMessage> &msg) {
                 ALOGE("processRenderedFrames: no media time found");
                 continue;
             }
+            statsFrameRendered(mediaTimeUs, renderTimeNs);
             // Tunneled frames use INT64_MAX to indicate end-of-stream, so don't report it as a
             // rendered frame.
             if (!mTunneled || mediaTimeUs != INT64_MAX) {
@@ -1897,6 +1948,9 @@ void MediaCodec::statsBufferReceived(int64_t presentationUs, const sp<MediaCodec
 
     CHECK_NE(mState, UNINITIALIZED);
 
+    // the client owns the buffer from now on, see onReleaseOutputBuffer()
+    buffer->meta()->setInt64("clientOutputNs", systemTime(SYSTEM_TIME_MONOTONIC));
+
     if (mDomain == DOMAIN_VIDEO && (mFlags & kFlagIsEncoder)) {
         int32_t flags = 0;
         (void) buffer->meta()->findInt32("flags", &flags);
@@ -1982,6 +2036,14 @@ void MediaCodec::statsBufferReceived(int64_t presentationUs, const sp<MediaCodec
 
     mLatencyHist.insert(latencyUs);
 
+    // split the round trip where the buffer channel reports when it released the output
+    int64_t codecOutputNs;
+    if (buffer->meta()->findInt64("codecOutputNs", &codecOutputNs)
+            && codecOutputNs >= startdata.startedNs && codecOutputNs <= nowNs) {
+        statsStageLatency_l(kLatencyStageCodec, startdata.startedNs, codecOutputNs);
+        statsStageLatency_l(kLatencyStageOutput, codecOutputNs, nowNs);
+    }
+
     // push into the recent samples
     {
         Mutex::Autolock al(mRecentLock);
@@ -1993,6 +2055,43 @@ void MediaCodec::statsBufferReceived(int64_t presentationUs, const sp<MediaCodec
     }
 }
 
+void MediaCodec::statsStageLatency_l(LatencyStage stage, int64_t startNs, int64_t endNs) {
+    mStageLatencyHist[stage].insert((endNs - startNs + 500) / 1000);
+}
+
+// when the client releases a video frame for rendering at renderTimeNs
+void MediaCodec::statsFrameReleased(int64_t mediaTimeUs, int64_t renderTimeNs) {
+    Mutex::Autolock al(mLatencyLock);
+    // frames cannot be rendered before they are released
+    const int64_t nowNs = systemTime(SYSTEM_TIME_MONOTONIC);
+    BufferFlightTiming_t releasedata = { mediaTimeUs, std::max(nowNs, renderTimeNs) };
+    mFramesAwaitingRender.push_back(releasedata);
+    if (mFramesAwaitingRender.size() > kMaxFramesAwaitingRender) {
+        mFramesAwaitingRender.pop_front();
+    }
+}
+
+// when a released video frame is reported as rendered
+void MediaCodec::statsFrameRendered(int64_t mediaTimeUs, int64_t renderTimeNs) {
+    Mutex::Autolock al(mLatencyLock);
+    // frames are rendered in release order; earlier frames were dropped
+    while (!mFramesAwaitingRender.empty()
+            && mFramesAwaitingRender.front().presentationUs != mediaTimeUs) {
+        if (mFramesAwaitingRender.front().presentationUs > mediaTimeUs) {
+            return;
+        }
+        mFramesAwaitingRender.pop_front();
+    }
+    if (mFramesAwaitingRender.empty()) {
+        return;
+    }
+    int64_t releasedNs = mFramesAwaitingRender.front().startedNs;
+    mFramesAwaitingRender.pop_front();
+    if (renderTimeNs >= releasedNs) {
+        statsStageLatency_l(kLatencyStageRender, releasedNs, renderTimeNs);
+    }
+}
+
 bool MediaCodec::discardDecodeOnlyOutputBuffer(size_t index) {
     Mutex::Autolock al(mBufferLock);
     BufferInfo *info = &mPortBuffers[kPortIndexOutput][index];
@@ -2830,6 +2929,7 @@ status_t MediaCodec::shapeMediaFormat(
     //
 
     ALOGV("Shaping input: %s", format->debugString(0).c_str());
+    const nsecs_t shapingStartNs = systemTime(SYSTEM_TIME_MONOTONIC);
 
     sp<AMessage> updatedFormat = format->dup();
     AMediaFormat *updatedNdkFormat = AMediaFormat_fromMsg(&updatedFormat);
@@ -2882,6 +2982,10 @@ status_t MediaCodec::shapeMediaFormat(
     }
 
     AMediaFormat_delete(updatedNdkFormat);
+    if (metricsHandle != 0) {
+        mediametrics_setInt64(metricsHandle, kCodecShapingDurationUs,
+                (systemTime(SYSTEM_TIME_MONOTONIC) - shapingStartNs) / 1000);
+    }
     return OK;
 }
 
@@ -3216,6 +3320,7 @@ status_t MediaCodec::queueInputBuffer(
     }
 
     sp<AMessage> msg = new AMessage(kWhatQueueInputBuffer, this);
+    msg->setInt64("queuedNs", systemTime(SYSTEM_TIME_MONOTONIC));
     msg->setSize("index", index);
     msg->setSize("offset", offset);
     msg->setSize("size", size);
@@ -3233,6 +3338,7 @@ status_t MediaCodec::queueInputBuffers(
         const sp<BufferInfosWrapper> &infos,
         AString *errorDetailMsg) {
     sp<AMessage> msg = new AMessage(kWhatQueueInputBuffer, this);
+    msg->setInt64("queuedNs", systemTime(SYSTEM_TIME_MONOTONIC));
     uint32_t bufferFlags = 0;
     uint32_t flagsinAllAU = BUFFER_FLAG_DECODE_ONLY | BUFFER_FLAG_CODECCONFIG;
     uint32_t andFlags = flagsinAllAU;
@@ -3286,6 +3392,7 @@ status_t MediaCodec::queueSecureInputBuffer(
     }
 
     sp<AMessage> msg = new AMessage(kWhatQueueInputBuffer, this);
+    msg->setInt64("queuedNs", systemTime(SYSTEM_TIME_MONOTONIC));
     msg->setSize("index", index);
     msg->setSize("offset", offset);
     msg->setPointer("subSamples", (void *)subSamples);
@@ -3316,6 +3423,7 @@ status_t MediaCodec::queueSecureInputBuffers(
         errorDetailMsg->clear();
     }
     sp<AMessage> msg = new AMessage(kWhatQueueInputBuffer, this);
+    msg->setInt64("queuedNs", systemTime(SYSTEM_TIME_MONOTONIC));
     uint32_t bufferFlags = 0;
     uint32_t flagsinAllAU = BUFFER_FLAG_DECODE_ONLY | BUFFER_FLAG_CODECCONFIG;
     uint32_t andFlags = flagsinAllAU;
@@ -3371,6 +3479,7 @@ status_t MediaCodec::queueBuffer(
     }
     status_t err = OK;
     sp<AMessage> msg = new AMessage(kWhatQueueInputBuffer, this);
+    msg->setInt64("queuedNs", systemTime(SYSTEM_TIME_MONOTONIC));
     msg->setSize("index", index);
     sp<WrapperObject<std::shared_ptr<C2Buffer>>> obj{
         new WrapperObject<std::shared_ptr<C2Buffer>>{buffer}};
@@ -3406,6 +3515,7 @@ status_t MediaCodec::queueEncryptedBuffer(
     }
     status_t err = OK;
     sp<AMessage> msg = new AMessage(kWhatQueueInputBuffer, this);
+    msg->setInt64("queuedNs", systemTime(SYSTEM_TIME_MONOTONIC));
     msg->setSize("index", index);
     sp<WrapperObject<sp<hardware::HidlMemory>>> memory{
         new WrapperObject<sp<hardware::HidlMemory>>{buffer}};
@@ -4926,6 +5036,15 @@ void MediaCodec::onMessageReceived(const sp<AMessage> &msg) {
                     }
                 }
             }
+            if (flags & CONFIGURE_FLAG_BATCH_OUTPUT_CALLBACKS) {
+                if (!(mFlags & kFlagUseBlockModel)) {
+                    mErrorLog.log(
+                            LOG_TAG, "Batched output callbacks are only valid with block model");
+                    PostReplyWithError(replyID, INVALID_OPERATION);
+                    break;
+                }
+                mFlags |= kFlagBatchOutputCallbacks;
+            }
             int32_t largeFrameParamMax = 0, largeFrameParamThreshold = 0;
             if (format->findInt32(KEY_BUFFER_BATCH_MAX_OUTPUT_SIZE, &largeFrameParamMax) ||
                     format->findInt32(KEY_BUFFER_BATCH_THRESHOLD_OUTPUT_SIZE,
@@ -6461,6 +6580,11 @@ status_t MediaCodec::onQueueInputBuffer(const sp<AMessage> &msg) {
         info->mOwnedByClient = false;
         info->mData.clear();
 
+        int64_t queuedNs;
+        if (msg->findInt64("queuedNs", &queuedNs)) {
+            Mutex::Autolock al(mLatencyLock);
+            statsStageLatency_l(kLatencyStageInput, queuedNs, systemTime(SYSTEM_TIME_MONOTONIC));
+        }
         statsBufferSent(timeUs, buffer);
     }
 
@@ -6547,6 +6671,13 @@ status_t MediaCodec::onReleaseOutputBuffer(const sp<AMessage> &msg) {
         info->mData.clear();
     }
 
+    int64_t clientOutputNs;
+    if (buffer->meta()->findInt64("clientOutputNs", &clientOutputNs)) {
+        Mutex::Autolock al(mLatencyLock);
+        statsStageLatency_l(kLatencyStageClient, clientOutputNs,
+                            systemTime(SYSTEM_TIME_MONOTONIC));
+    }
+
     if (render && buffer->size() != 0) {
         int64_t mediaTimeUs = INT64_MIN;
         buffer->meta()->findInt64("timeUs", &mediaTimeUs);
@@ -6583,6 +6714,7 @@ status_t MediaCodec::onReleaseOutputBuffer(const sp<AMessage> &msg) {
                 noRenderTime ? mVideoRenderQualityTracker.onFrameReleased(mediaTimeUs)
                              : mVideoRenderQualityTracker.onFrameReleased(mediaTimeUs,
                                                                           renderTimeNs);
+                statsFrameReleased(mediaTimeUs, noRenderTime ? 0 : renderTimeNs);
             }
             // can't initialize this in the constructor because the Looper parent class needs to be
             // initialized first
@@ -6839,6 +6971,10 @@ void MediaCodec::onInputBufferAvailable() {
 }
 
 void MediaCodec::onOutputBufferAvailable() {
+    if (mFlags & kFlagBatchOutputCallbacks) {
+        onOutputBuffersAvailable();
+        return;
+    }
     int32_t index;
     while ((index = dequeuePortBuffer(kPortIndexOutput)) >= 0) {
         if (discardDecodeOnlyOutputBuffer(index)) {
@@ -6877,6 +7013,43 @@ void MediaCodec::onOutputBufferAvailable() {
         msg->post();
     }
 }
+
+void MediaCodec::onOutputBuffersAvailable() {
+    sp<OutputCallbackInfosWrapper> outputs;
+    int32_t index;
+    while ((index = dequeuePortBuffer(kPortIndexOutput)) >= 0) {
+        if (discardDecodeOnlyOutputBuffer(index)) {
+            continue;
+        }
+        if (outputs == nullptr) {
+            outputs = new OutputCallbackInfosWrapper(std::vector<OutputCallbackInfo>());
+        }
+        const sp<MediaCodecBuffer> &buffer =
+            mPortBuffers[kPortIndexOutput][index].mData;
+        OutputCallbackInfo &info = outputs->value.emplace_back();
+        info.index = index;
+        info.offset = buffer->offset();
+        info.size = buffer->size();
+        CHECK(buffer->meta()->findInt64("timeUs", &info.timeUs));
+        CHECK(buffer->meta()->findInt32("flags", &info.flags));
+
+        sp<RefBase> accessUnitInfoObj;
+        buffer->meta()->findObject("accessUnitInfo", &accessUnitInfoObj);
+        if (accessUnitInfoObj) {
+            info.accessUnitInfo = static_cast<BufferInfosWrapper *>(accessUnitInfoObj.get());
+            info.accessUnitInfo->value.back().mFlags |= info.flags & BUFFER_FLAG_END_OF_STREAM;
+        }
+
+        statsBufferReceived(info.timeUs, buffer);
+    }
+    if (outputs == nullptr) {
+        return;
+    }
+    sp<AMessage> msg = mCallback->dup();
+    msg->setInt32("callbackID", CB_OUTPUTS_AVAILABLE);
+    msg->setObject("outputs", outputs);
+    msg->post();
+}
 void MediaCodec::onCryptoError(const sp<AMessage> & msg) {
     if (mCallback != NULL) {
         sp<AMessage> cb_msg = mCallback->dup();
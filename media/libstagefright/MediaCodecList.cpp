@@ -18,7 +18,10 @@
 #define LOG_TAG "MediaCodecList"
 #include <utils/Log.h>
 
+#include <android-base/file.h>
+#include <android-base/properties.h>
 #include <binder/IServiceManager.h>
+#include <binder/Parcel.h>
 
 #include <media/IMediaCodecList.h>
 #include <media/IMediaPlayerService.h>
@@ -39,6 +42,7 @@
 #include <media/stagefright/PersistentSurface.h>
 
 #include <sys/stat.h>
+#include <unistd.h>
 #include <utils/threads.h>
 
 #include <cutils/properties.h>
@@ -80,6 +84,111 @@ bool isProfilingNeeded() {
     return profilingNeeded;
 }
 
+// The built list is persisted here so that it is not rebuilt after each mediaserver restart.
+constexpr const char* kCodecListCache = "/data/misc/media/media_codec_list.cache";
+// Increment when the format of the cache or the way the list is built changes.
+constexpr int32_t kCodecListCacheVersion = 1;
+constexpr int32_t kMaxCachedCodecInfos = 4096;
+
+bool isCodecListCacheEnabled() {
+    return property_get_bool("debug.stagefright.cache-codec-list", false);
+}
+
+// Returns an empty string if the list cannot be cached.
+std::string getCodecListFingerprint(const std::vector<MediaCodecListBuilderBase*> &builders) {
+    std::string fingerprint;
+    for (const char *key : {
+            "ro.build.fingerprint",
+            "ro.vendor.build.fingerprint",
+            "ro.odm.build.fingerprint",
+            "ro.product.build.fingerprint" }) {
+        fingerprint += base::GetProperty(key, "") + "\n";
+    }
+    // profiling results are merged into the list
+    struct stat st;
+    if (stat(kProfilingResults, &st) == 0) {
+        fingerprint += std::to_string(st.st_mtime) + "," + std::to_string(st.st_size);
+    }
+    fingerprint += "\n";
+    for (MediaCodecListBuilderBase *builder : builders) {
+        if (builder == nullptr) {
+            continue;
+        }
+        std::string builderFingerprint = builder->getFingerprint();
+        if (builderFingerprint.empty()) {
+            return std::string();
+        }
+        fingerprint += builderFingerprint + "\n";
+    }
+    return fingerprint;
+}
+
+bool loadCodecList(
+        const std::string &fingerprint,
+        sp<AMessage> *globalSettings,
+        std::vector<sp<MediaCodecInfo>> *codecInfos) {
+    std::string data;
+    if (!base::ReadFileToString(kCodecListCache, &data)) {
+        return false;
+    }
+    Parcel parcel;
+    if (parcel.setData(reinterpret_cast<const uint8_t *>(data.data()), data.size()) != OK
+            || parcel.readInt32() != kCodecListCacheVersion) {
+        return false;
+    }
+    const char *cachedFingerprint = parcel.readCString();
+    if (cachedFingerprint == nullptr || fingerprint != cachedFingerprint) {
+        ALOGD("cached codec list is out of date");
+        return false;
+    }
+    sp<AMessage> settings = AMessage::FromParcel(parcel);
+    int32_t numCodecInfos = parcel.readInt32();
+    if (settings == nullptr || numCodecInfos < 0 || numCodecInfos > kMaxCachedCodecInfos) {
+        return false;
+    }
+    std::vector<sp<MediaCodecInfo>> infos;
+    for (int32_t i = 0; i < numCodecInfos; ++i) {
+        sp<MediaCodecInfo> info = MediaCodecInfo::FromParcel(parcel);
+        if (info == nullptr) {
+            return false;
+        }
+        infos.push_back(info);
+    }
+    // the version is repeated at the end to detect truncated files
+    if (parcel.readInt32() != kCodecListCacheVersion || parcel.dataAvail() != 0) {
+        ALOGW("cached codec list is corrupted");
+        return false;
+    }
+    *globalSettings = settings;
+    *codecInfos = std::move(infos);
+    return true;
+}
+
+void saveCodecList(
+        const std::string &fingerprint,
+        const sp<AMessage> &globalSettings,
+        const std::vector<sp<MediaCodecInfo>> &codecInfos) {
+    Parcel parcel;
+    parcel.writeInt32(kCodecListCacheVersion);
+    parcel.writeCString(fingerprint.c_str());
+    globalSettings->writeToParcel(&parcel);
+    parcel.writeInt32(codecInfos.size());
+    for (const sp<MediaCodecInfo> &info : codecInfos) {
+        info->writeToParcel(&parcel);
+    }
+    parcel.writeInt32(kCodecListCacheVersion);
+
+    // write to a temporary file first so that a reader never sees a partial file
+    std::string tmpPath = std::string(kCodecListCache) + ".tmp";
+    if (!base::WriteStringToFile(
+                std::string(reinterpret_cast<const char *>(parcel.data()), parcel.dataSize()),
+                tmpPath)
+            || rename(tmpPath.c_str(), kCodecListCache) != 0) {
+        ALOGD("could not persist codec list: %s", strerror(errno));
+        unlink(tmpPath.c_str());
+    }
+}
+
 OmxInfoBuilder sOmxInfoBuilder{true /* allowSurfaceEncoders */};
 OmxInfoBuilder sOmxNoSurfaceEncoderInfoBuilder{false /* allowSurfaceEncoders */};
 
@@ -204,22 +313,34 @@ sp<IMediaCodecList> MediaCodecList::getInstance() {
 MediaCodecList::MediaCodecList(std::vector<MediaCodecListBuilderBase*> builders) {
     mGlobalSettings = new AMessage();
     mCodecInfos.clear();
-    MediaCodecListWriter writer;
-    for (MediaCodecListBuilderBase *builder : builders) {
-        if (builder == nullptr) {
-            ALOGD("ignored a null builder");
-            continue;
+    std::string fingerprint;
+    if (isCodecListCacheEnabled()) {
+        fingerprint = getCodecListFingerprint(builders);
+    }
+    if (!fingerprint.empty() && loadCodecList(fingerprint, &mGlobalSettings, &mCodecInfos)) {
+        ALOGV("using cached codec list");
+        mInitCheck = OK;
+    } else {
+        MediaCodecListWriter writer;
+        for (MediaCodecListBuilderBase *builder : builders) {
+            if (builder == nullptr) {
+                ALOGD("ignored a null builder");
+                continue;
+            }
+            auto currentCheck = builder->buildMediaCodecList(&writer);
+            if (currentCheck != OK) {
+                ALOGD("ignored failed builder");
+                continue;
+            } else {
+                mInitCheck = currentCheck;
+            }
         }
-        auto currentCheck = builder->buildMediaCodecList(&writer);
-        if (currentCheck != OK) {
-            ALOGD("ignored failed builder");
-            continue;
-        } else {
-            mInitCheck = currentCheck;
+        writer.writeGlobalSettings(mGlobalSettings);
+        writer.writeCodecInfos(&mCodecInfos);
+        if (mInitCheck == OK && !fingerprint.empty()) {
+            saveCodecList(fingerprint, mGlobalSettings, mCodecInfos);
         }
     }
-    writer.writeGlobalSettings(mGlobalSettings);
-    writer.writeCodecInfos(&mCodecInfos);
     std::stable_sort(
             mCodecInfos.begin(),
             mCodecInfos.end(),
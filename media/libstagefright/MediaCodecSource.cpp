@@ -758,7 +758,17 @@ status_t MediaCodecSource::feedEncoderInputBuffers() {
             }
 
             size = mbuf->size();
+            if (size > inbuf->capacity()) {
+                ALOGE("source buffer too large (%zu) for encoder input size (%zu)",
+                        size, inbuf->capacity());
+                mbuf->release();
+                signalEOS();
+                break;
+            }
 
+            // Video sources in metadata mode (e.g. CameraSource) only hand over a
+            // VideoNativeMetadata referencing the gralloc buffer, which the encoder
+            // wraps as its input without copying the pixels.
             memcpy(inbuf->data(), mbuf->data(), size);
 
             if (mIsVideo) {
@@ -33,7 +33,9 @@
 #include <private/android_filesystem_config.h>
 #include <cutils/properties.h>
 #include <utils/String8.h>
+#include <utils/Timers.h>
 
+#include <ctype.h>
 #include <dirent.h>
 #include <dlfcn.h>
 
@@ -81,7 +83,9 @@ sp<IMediaExtractor> MediaExtractorFactory::CreateFromService(
     float confidence;
     sp<ExtractorPlugin> plugin;
     uint32_t creatorVersion = 0;
+    nsecs_t sniffStartNs = systemTime(SYSTEM_TIME_MONOTONIC);
     creator = sniff(source, &confidence, &meta, &freeMeta, plugin, &creatorVersion);
+    int64_t sniffTimeUs = ns2us(systemTime(SYSTEM_TIME_MONOTONIC) - sniffStartNs);
     if (!creator) {
         ALOGV("FAILED to autodetect media content.");
         return NULL;
@@ -97,10 +101,10 @@ sp<IMediaExtractor> MediaExtractorFactory::CreateFromService(
         ex = ret != nullptr ? new MediaExtractorCUnwrapper(ret) : nullptr;
     }
 
-    ALOGV("Created an extractor '%s' with confidence %.2f",
-         ex != nullptr ? ex->name() : "<null>", confidence);
+    ALOGV("Created an extractor '%s' with confidence %.2f in %lld us",
+         ex != nullptr ? ex->name() : "<null>", confidence, (long long)sniffTimeUs);
 
-    return CreateIMediaExtractorFromMediaExtractor(ex, source, plugin);
+    return CreateIMediaExtractorFromMediaExtractor(ex, source, plugin, sniffTimeUs);
 }
 
 struct ExtractorPlugin : public RefBase {
@@ -128,6 +132,52 @@ std::shared_ptr<std::list<sp<ExtractorPlugin>>> MediaExtractorFactory::gPlugins;
 bool MediaExtractorFactory::gPluginsRegistered = false;
 bool MediaExtractorFactory::gIgnoreVersion = false;
 
+// The plugin that won the last full sniff of content starting with |key|.
+struct SniffHint {
+    std::string key;
+    sp<ExtractorPlugin> plugin;
+    float confidence;
+};
+
+// Most recently used first, guarded by gPluginMutex.
+static std::list<SniffHint> gSniffHints;
+static const size_t kMaxSniffHints = 32;
+static const size_t kSniffKeySize = 16;
+
+// Files of the same type mostly start with the same bytes (ftyp box and
+// brands, EBML header, ...); together with the file extension, when the
+// source knows it, that makes a good guess at the extractor.
+static bool makeSniffKey(const sp<DataSource> &source, std::string *key) {
+    uint8_t header[kSniffKeySize];
+    if (source->readAt(0, header, sizeof(header)) != (ssize_t)sizeof(header)) {
+        return false;
+    }
+
+    key->clear();
+    String8 uri = source->getUri();
+    const char *ext = strrchr(uri.c_str(), '.');
+    if (ext != nullptr && strchr(ext, '/') == nullptr) {
+        for (++ext; *ext != '\0' && *ext != '?'; ++ext) {
+            key->push_back(tolower((unsigned char)*ext));
+        }
+    }
+    key->push_back('\0');
+    key->append((const char *)header, sizeof(header));
+    return true;
+}
+
+static void *sniffPlugin(
+        const sp<ExtractorPlugin> &plugin, const sp<DataSource> &source,
+        float *confidence, void **meta, FreeMetaFunc *freeMeta) {
+    ALOGV("sniffing %s", plugin->def.extractor_name);
+    if (plugin->def.def_version == EXTRACTORDEF_VERSION_NDK_V1) {
+        return (void*) plugin->def.u.v2.sniff(source->wrap(), confidence, meta, freeMeta);
+    } else if (plugin->def.def_version == EXTRACTORDEF_VERSION_NDK_V2) {
+        return (void*) plugin->def.u.v3.sniff(source->wrap(), confidence, meta, freeMeta);
+    }
+    return NULL;
+}
+
 // static
 void *MediaExtractorFactory::sniff(
         const sp<DataSource> &source, float *confidence, void **meta,
@@ -135,6 +185,11 @@ void *MediaExtractorFactory::sniff(
     *confidence = 0.0f;
     *meta = nullptr;
 
+    std::string key;
+    bool haveKey = makeSniffKey(source, &key);
+    sp<ExtractorPlugin> hintedPlugin;
+    float hintedConfidence = 0.0f;
+
     std::shared_ptr<std::list<sp<ExtractorPlugin>>> plugins;
     {
         Mutex::Autolock autoLock(gPluginMutex);
@@ -142,23 +197,46 @@ void *MediaExtractorFactory::sniff(
             return NULL;
         }
         plugins = gPlugins;
+
+        for (auto it = gSniffHints.begin(); haveKey && it != gSniffHints.end(); ++it) {
+            if (it->key == key) {
+                hintedPlugin = it->plugin;
+                hintedConfidence = it->confidence;
+                gSniffHints.splice(gSniffHints.begin(), gSniffHints, it);
+                break;
+            }
+        }
+    }
+
+    // Try the extractor that recognized similar content before. If it is as
+    // sure of itself as it was then, no other one would have won then
+    // either, so skip the others.
+    if (hintedPlugin != nullptr) {
+        float newConfidence;
+        void *newMeta = nullptr;
+        FreeMetaFunc newFreeMeta = nullptr;
+        void *curCreator = sniffPlugin(
+                hintedPlugin, source, &newConfidence, &newMeta, &newFreeMeta);
+        if (curCreator && newConfidence >= hintedConfidence) {
+            *confidence = newConfidence;
+            *meta = newMeta;
+            *freeMeta = newFreeMeta;
+            plugin = hintedPlugin;
+            *creatorVersion = hintedPlugin->def.def_version;
+            return curCreator;
+        }
+        if (curCreator && newMeta != nullptr && newFreeMeta != nullptr) {
+            newFreeMeta(newMeta);
+        }
     }
 
     void *bestCreator = NULL;
     for (auto it = plugins->begin(); it != plugins->end(); ++it) {
-        ALOGV("sniffing %s", (*it)->def.extractor_name);
         float newConfidence;
         void *newMeta = nullptr;
         FreeMetaFunc newFreeMeta = nullptr;
 
-        void *curCreator = NULL;
-        if ((*it)->def.def_version == EXTRACTORDEF_VERSION_NDK_V1) {
-            curCreator = (void*) (*it)->def.u.v2.sniff(
-                    source->wrap(), &newConfidence, &newMeta, &newFreeMeta);
-        } else if ((*it)->def.def_version == EXTRACTORDEF_VERSION_NDK_V2) {
-            curCreator = (void*) (*it)->def.u.v3.sniff(
-                    source->wrap(), &newConfidence, &newMeta, &newFreeMeta);
-        }
+        void *curCreator = sniffPlugin(*it, source, &newConfidence, &newMeta, &newFreeMeta);
 
         if (curCreator) {
             if (newConfidence > *confidence) {
@@ -179,6 +257,20 @@ void *MediaExtractorFactory::sniff(
         }
     }
 
+    if (bestCreator && haveKey) {
+        Mutex::Autolock autoLock(gPluginMutex);
+        for (auto it = gSniffHints.begin(); it != gSniffHints.end(); ++it) {
+            if (it->key == key) {
+                gSniffHints.erase(it);
+                break;
+            }
+        }
+        gSniffHints.push_front({key, plugin, *confidence});
+        if (gSniffHints.size() > kMaxSniffHints) {
+            gSniffHints.pop_back();
+        }
+    }
+
     return bestCreator;
 }
 
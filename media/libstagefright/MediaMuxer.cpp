@@ -271,7 +271,7 @@ status_t MediaMuxer::writeSampleData(const sp<ABuffer> &buffer, size_t trackInde
     }
 
     sp<MediaAdapter> currentTrack = mTrackList[trackIndex];
-    // This pushBuffer will wait until the mediaBuffer is consumed.
+    // This pushBuffer copies the sample and only waits while the track's queue is full.
     return currentTrack->pushBuffer(mediaBuffer);
 }
 
@@ -91,6 +91,42 @@ OmxInfoBuilder::OmxInfoBuilder(bool allowSurfaceEncoders)
     : mAllowSurfaceEncoders(allowSurfaceEncoders) {
 }
 
+std::string OmxInfoBuilder::getFingerprint() {
+    sp<IOmxStore> omxStore = IOmxStore::getService();
+    if (omxStore == nullptr) {
+        return "omx:none";
+    }
+    hidl_vec<IOmxStore::RoleInfo> roles;
+    auto transStatus = omxStore->listRoles(
+            [&roles] (
+            const hidl_vec<IOmxStore::RoleInfo>& inRoleList) {
+                roles = inRoleList;
+            });
+    if (!transStatus.isOk()) {
+        return std::string();
+    }
+
+    // The capabilities of a node depend only on its attributes and on the node itself, which is
+    // covered by the vendor build fingerprint.
+    std::string fingerprint = mAllowSurfaceEncoders ? "omx:surface" : "omx:nosurface";
+    for (const char *key : {
+            "debug.stagefright.omx_default_rank",
+            "debug.stagefright.omx_default_rank.sw-audio",
+            "debug.stagefright.omx_default_rank.sw-other" }) {
+        fingerprint += "," + ::android::base::GetProperty(key, "");
+    }
+    for (const IOmxStore::RoleInfo& role : roles) {
+        fingerprint += ";" + std::string(role.type) + (role.isEncoder ? ",enc" : ",dec");
+        for (const IOmxStore::NodeInfo &node : role.nodes) {
+            fingerprint += "," + std::string(node.name) + "/" + std::string(node.owner);
+            for (const IOmxStore::Attribute& attribute : node.attributes) {
+                fingerprint += "/" + std::string(attribute.key) + "=" + std::string(attribute.value);
+            }
+        }
+    }
+    return fingerprint;
+}
+
 status_t OmxInfoBuilder::buildMediaCodecList(MediaCodecListWriter* writer) {
     // Obtain IOmxStore
     sp<IOmxStore> omxStore = IOmxStore::getService();
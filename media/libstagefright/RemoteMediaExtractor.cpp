@@ -51,6 +51,9 @@ static const char *kExtractorTracks = "android.media.mediaextractor.ntrk";
 // because they are not applicable or useful to that API.
 static const char *kExtractorEntryPoint = "android.media.mediaextractor.entry";
 static const char *kExtractorLogSessionId = "android.media.mediaextractor.logSessionId";
+static const char *kExtractorReads = "android.media.mediaextractor.nread";
+static const char *kExtractorReadBytes = "android.media.mediaextractor.readbytes";
+static const char *kExtractorSniffTimeUs = "android.media.mediaextractor.sniffus";
 
 static const char *kEntryPointSdk = "sdk";
 static const char *kEntryPointWithJvm = "ndk-with-jvm";
@@ -60,7 +63,8 @@ static const char *kEntryPointOther = "other";
 RemoteMediaExtractor::RemoteMediaExtractor(
         MediaExtractor *extractor,
         const sp<DataSource> &source,
-        const sp<RefBase> &plugin)
+        const sp<RefBase> &plugin,
+        int64_t sniffTimeUs)
     :mExtractor(extractor),
      mSource(source),
      mExtractorPlugin(plugin) {
@@ -79,6 +83,10 @@ RemoteMediaExtractor::RemoteMediaExtractor(
         mMetricsItem->setCString(kExtractorFormat, extractor->name());
         // tracks (size_t)
         mMetricsItem->setInt32(kExtractorTracks, ntracks);
+        // time spent picking the extractor
+        if (sniffTimeUs >= 0) {
+            mMetricsItem->setInt64(kExtractorSniffTimeUs, sniffTimeUs);
+        }
         // metadata
         MetaDataBase pMetaData;
         if (extractor->getMetaData(pMetaData) == OK) {
@@ -150,6 +158,7 @@ static void asyncDataSourceClose(sp<DataSource> &ds) {
 
 RemoteMediaExtractor::~RemoteMediaExtractor() {
     delete mExtractor;
+    updateReadMetrics();
     // TODO(287851984) hook for changing behavior this dynamically, drop after testing
     int8_t new_scheme = property_get_bool("debug.mediaextractor.delayedclose", 1);
     if (new_scheme != 0) {
@@ -207,10 +216,21 @@ status_t RemoteMediaExtractor::getMetrics(Parcel *reply) {
         return UNKNOWN_ERROR;
     }
 
+    updateReadMetrics();
     mMetricsItem->writeToParcel(reply);
     return OK;
 }
 
+void RemoteMediaExtractor::updateReadMetrics() {
+    int64_t numReads;
+    int64_t numBytes;
+    if (mMetricsItem != nullptr && mSource != nullptr
+            && mSource->getReadStatistics(&numReads, &numBytes) == OK) {
+        mMetricsItem->setInt64(kExtractorReads, numReads);
+        mMetricsItem->setInt64(kExtractorReadBytes, numBytes);
+    }
+}
+
 uint32_t RemoteMediaExtractor::flags() const {
     return mExtractor->flags();
 }
@@ -256,11 +276,12 @@ status_t RemoteMediaExtractor::setLogSessionId(const String8& logSessionId) {
 sp<IMediaExtractor> RemoteMediaExtractor::wrap(
         MediaExtractor *extractor,
         const sp<DataSource> &source,
-        const sp<RefBase> &plugin) {
+        const sp<RefBase> &plugin,
+        int64_t sniffTimeUs) {
     if (extractor == nullptr) {
         return nullptr;
     }
-    return new RemoteMediaExtractor(extractor, source, plugin);
+    return new RemoteMediaExtractor(extractor, source, plugin, sniffTimeUs);
 }
 
 }  // namespace android
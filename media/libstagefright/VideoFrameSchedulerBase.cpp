@@ -331,7 +331,11 @@ VideoFrameSchedulerBase::VideoFrameSchedulerBase()
       mVsyncPeriod(0),
       mVsyncRefreshAt(0),
       mLastVsyncTime(-1),
-      mTimeCorrection(0) {
+      mTimeCorrection(0),
+      mLatencyVsyncs(0),
+      mLatencySamples(0),
+      mLateFrames(0),
+      mEarlyFrames(0) {
 }
 
 void VideoFrameSchedulerBase::init(float videoFps) {
@@ -339,6 +343,10 @@ void VideoFrameSchedulerBase::init(float videoFps) {
 
     mLastVsyncTime = -1;
     mTimeCorrection = 0;
+    mLatencyVsyncs = 0;
+    mLatencySamples = 0;
+    mLateFrames = 0;
+    mEarlyFrames = 0;
 
     mPll.reset(videoFps);
 }
@@ -346,6 +354,10 @@ void VideoFrameSchedulerBase::init(float videoFps) {
 void VideoFrameSchedulerBase::restart() {
     mLastVsyncTime = -1;
     mTimeCorrection = 0;
+    // keep the latency correction; it depends on the display pipeline, not on the video
+    mLatencySamples = 0;
+    mLateFrames = 0;
+    mEarlyFrames = 0;
 
     mPll.restart();
 }
@@ -459,11 +471,50 @@ nsecs_t VideoFrameSchedulerBase::schedule(nsecs_t renderTime) {
     // align rendertime to the center between VSYNC edges
     renderTime -= (renderTime - mVsyncTime) % mVsyncPeriod;
     renderTime += mVsyncPeriod / 2;
+    // compensate for display latency observed through onFrameRendered
+    renderTime -= mLatencyVsyncs * mVsyncPeriod;
     ALOGV("adjusting render: %lld => %lld", (long long)origRenderTime, (long long)renderTime);
     ATRACE_INT64("FRAME_FLIP_IN(ms)", (renderTime - now) / 1000000);
     return renderTime;
 }
 
+nsecs_t VideoFrameSchedulerBase::getLatencyCorrection() {
+    return mLatencyVsyncs * getVsyncPeriod();
+}
+
+void VideoFrameSchedulerBase::onFrameRendered(nsecs_t renderTime, nsecs_t presentTime) {
+    if (mVsyncPeriod == 0 || renderTime <= 0 || presentTime <= 0) {
+        return;
+    }
+
+    // The frame was meant to be presented at the VSYNC after the uncorrected render time,
+    // which schedule() centered between VSYNC edges.
+    nsecs_t intendedTime = renderTime + mLatencyVsyncs * mVsyncPeriod + mVsyncPeriod / 2;
+    nsecs_t lateVsyncs = divRound(presentTime - intendedTime, mVsyncPeriod);
+    if (lateVsyncs > 0) {
+        ++mLateFrames;
+    } else if (lateVsyncs < 0) {
+        ++mEarlyFrames;
+    }
+    if (++mLatencySamples < kLatencyWindowSize) {
+        return;
+    }
+
+    // only act on a clear majority so that occasional dropped VSYNCs do not move the schedule
+    if (mLateFrames > kLatencyWindowSize / 2 && mLatencyVsyncs < kMaxLatencyVsyncs) {
+        ++mLatencyVsyncs;
+    } else if (mEarlyFrames > kLatencyWindowSize / 2 && mLatencyVsyncs > 0) {
+        --mLatencyVsyncs;
+    }
+    ALOGV("latency window: late=%zu early=%zu => correction %d vsyncs",
+            mLateFrames, mEarlyFrames, mLatencyVsyncs);
+    ATRACE_INT64("FRAME_LATENCY_VSYNCS", mLatencyVsyncs);
+
+    mLatencySamples = 0;
+    mLateFrames = 0;
+    mEarlyFrames = 0;
+}
+
 VideoFrameSchedulerBase::~VideoFrameSchedulerBase() {}
 
 } // namespace android
@@ -124,6 +124,7 @@ void VideoRenderQualityMetrics::clear() {
     frameRenderedCount = 0;
     frameDroppedCount = 0;
     frameSkippedCount = 0;
+    frameLateCount = 0;
     contentFrameRate = FRAME_RATE_UNDETERMINED;
     desiredFrameRate = FRAME_RATE_UNDETERMINED;
     actualFrameRate = FRAME_RATE_UNDETERMINED;
@@ -159,6 +160,7 @@ VideoRenderQualityTracker::Configuration
     getFlag(judderEventMax, "judder_event_max");
     getFlag(judderEventDetailsMax, "judder_event_details_max");
     getFlag(judderEventDistanceToleranceMs, "judder_event_distance_tolerance_ms");
+    getFlag(lateFrameToleranceUs, "late_frame_tolerance_us");
     getFlag(traceTriggerEnabled, "trace_trigger_enabled");
     getFlag(traceTriggerThrottleMs, "trace_trigger_throttle_ms");
     getFlag(traceMinFreezeDurationMs, "trace_minimum_freeze_duration_ms");
@@ -203,6 +205,11 @@ VideoRenderQualityTracker::Configuration::Configuration() {
     judderEventDetailsMax = 20;
     judderEventDistanceToleranceMs = 5000; // lump judder occurrences together when 5s or less
 
+    // Late frame configuration
+    // Frames scheduled between two vsyncs reach the display half a refresh after their desired
+    // render time; one refresh later is 12.5ms at 120Hz and 25ms at 60Hz.
+    lateFrameToleranceUs = 10 * 1000;
+
     // Perfetto trigger configuration.
     traceTriggerEnabled = android::base::GetProperty(
         "ro.build.type", "user") != "user"; // Enabled for non-user builds for debugging.
@@ -515,6 +522,9 @@ void VideoRenderQualityTracker::processMetricsForRenderedFrame(int64_t contentTi
     if (contentTimeUs == -1) {
         return;
     }
+    if (actualRenderTimeUs - desiredRenderTimeUs > c.lateFrameToleranceUs) {
+        mMetrics.frameLateCount++;
+    }
     updateFrameDurations(mContentFrameDurationUs, contentTimeUs);
     updateFrameDurations(mDesiredFrameDurationUs, desiredRenderTimeUs);
     updateFrameDurations(mActualFrameDurationUs, actualRenderTimeUs);
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/ColorConverter.h>
+#include <media/stagefright/MediaCodecConstants.h>
+
+using namespace android;
+
+/*
+ * Converts one frame per iteration.
+ *
+ * Args: width, height, number of threads.
+ */
+static void BM_Convert(benchmark::State &state,
+        OMX_COLOR_FORMATTYPE srcFormat, OMX_COLOR_FORMATTYPE dstFormat,
+        size_t srcBytesPerPixel, size_t dstBytesPerPixel) {
+    const size_t width = state.range(0);
+    const size_t height = state.range(1);
+
+    // Room for the luma plane and the 4:2:0 chroma planes at |srcBytesPerPixel| per sample.
+    std::vector<uint8_t> src(width * height * srcBytesPerPixel * 3 / 2);
+    std::vector<uint8_t> dst(width * height * dstBytesPerPixel);
+    std::minstd_rand gen(42);
+    for (uint8_t &byte : src) {
+        byte = gen();
+    }
+
+    ColorConverter converter(srcFormat, dstFormat);
+    if (!converter.isValid()) {
+        state.SkipWithError("conversion not supported");
+        return;
+    }
+    converter.setMaxThreads(state.range(2));
+
+    for (auto _ : state) {
+        status_t err = converter.convert(
+                src.data(), width, height, width * srcBytesPerPixel,
+                0, 0, width - 1, height - 1,
+                dst.data(), width, height, width * dstBytesPerPixel,
+                0, 0, width - 1, height - 1);
+        if (err != OK) {
+            state.SkipWithError("convert failed");
+            return;
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * width * height);
+}
+
+static void ConvertArgs(benchmark::internal::Benchmark *b) {
+    b->ArgNames({"width", "height", "threads"});
+    for (auto [width, height] : {std::pair{1920, 1080}, {3840, 2160}, {7680, 4320}}) {
+        for (int threads : {1, 2, 4}) {
+            b->Args({width, height, threads});
+        }
+    }
+}
+
+BENCHMARK_CAPTURE(BM_Convert, I420ToRGBA8888,
+        OMX_COLOR_FormatYUV420Planar, OMX_COLOR_Format32BitRGBA8888, 1, 4)
+        ->Apply(ConvertArgs);
+BENCHMARK_CAPTURE(BM_Convert, NV12ToRGB565,
+        OMX_COLOR_FormatYUV420SemiPlanar, OMX_COLOR_Format16bitRGB565, 1, 2)
+        ->Apply(ConvertArgs);
+BENCHMARK_CAPTURE(BM_Convert, P010ToRGBA1010102,
+        (OMX_COLOR_FORMATTYPE)COLOR_FormatYUVP010,
+        (OMX_COLOR_FORMATTYPE)COLOR_Format32bitABGR2101010, 2, 4)
+        ->Apply(ConvertArgs);
+BENCHMARK_CAPTURE(BM_Convert, I010ToY410,
+        OMX_COLOR_FormatYUV420Planar16, OMX_COLOR_FormatYUV444Y410, 2, 4)
+        ->Apply(ConvertArgs);
+
+BENCHMARK_MAIN();
@@ -89,6 +89,7 @@ void ColorConversionFuzzer::process() {
             static_cast<OMX_COLOR_FORMATTYPE>(mFdp.PickValueInArray(kDstFormatType));
     std::unique_ptr<ColorConverter> converter(new ColorConverter(srcColorFormat, dstColorFormat));
     if (converter->isValid()) {
+        converter->setMaxThreads(mFdp.ConsumeIntegralInRange<size_t>(1, 4));
         int32_t srcLeft, srcTop, srcRight, srcBottom, width, height, stride;
         width = mFdp.ConsumeIntegralInRange<int32_t>(kMinFrameSize, kMaxFrameSize);
         height = mFdp.ConsumeIntegralInRange<int32_t>(kMinFrameSize, kMaxFrameSize);
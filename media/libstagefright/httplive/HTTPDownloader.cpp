@@ -28,6 +28,7 @@
 #include <media/MediaHTTPService.h>
 #include <media/stagefright/foundation/ABuffer.h>
 #include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/ALooper.h>
 #include <openssl/aes.h>
 #include <openssl/md5.h>
 #include <utils/Mutex.h>
@@ -40,7 +41,8 @@ HTTPDownloader::HTTPDownloader(
         const KeyedVector<String8, String8> &headers) :
     mHTTPDataSource(new MediaHTTP(httpService->makeHTTPConnection())),
     mExtraHeaders(headers),
-    mDisconnecting(false) {
+    mDisconnecting(false),
+    mLastConnectDelayUs(-1) {
 }
 
 void HTTPDownloader::reconnect() {
@@ -89,6 +91,7 @@ ssize_t HTTPDownloader::fetchBlock(
 
     off64_t size;
 
+    mLastConnectDelayUs = -1;
     if (reconnect) {
         if (!strncasecmp(url, "file://", 7)) {
             mDataSource = new FileSource(url + 7);
@@ -109,7 +112,9 @@ ssize_t HTTPDownloader::fetchBlock(
                                             range_offset + range_length - 1).c_str()).c_str()));
             }
 
+            int64_t connectStartUs = ALooper::GetNowUs();
             status_t err = mHTTPDataSource->connect(url, &headers);
+            mLastConnectDelayUs = ALooper::GetNowUs() - connectStartUs;
 
             if (isDisconnecting()) {
                 return ERROR_NOT_CONNECTED;
@@ -70,6 +70,12 @@ struct HTTPDownloader : public RefBase {
     sp<M3UParser> fetchPlaylist(
             const char *url, uint8_t *curPlaylistHash, bool *unchanged);
 
+    // Time the last (re)connect of fetchBlock() took until the server responded,
+    // or -1 if the last fetch did not connect.
+    int64_t getLastConnectDelayUs() const {
+        return mLastConnectDelayUs;
+    }
+
 private:
     sp<HTTPBase> mHTTPDataSource;
     sp<DataSource> mDataSource;
@@ -77,6 +83,7 @@ private:
 
     Mutex mLock;
     bool mDisconnecting;
+    int64_t mLastConnectDelayUs;
 
     DISALLOW_EVIL_CONSTRUCTORS(HTTPDownloader);
 };
@@ -54,6 +54,10 @@ const int64_t LiveSession::kResumeThresholdUs = 100000LL;
 // default buffer underflow mark
 static const int kUnderflowMarkMs = 1000;  // 1 second
 
+// default number of segments each fetcher downloads ahead of the one it's parsing
+static const int kDefaultNumPrefetchSegments = 2;
+static const int kMaxNumPrefetchSegments = 4;
+
 struct LiveSession::BandwidthEstimator : public RefBase {
     BandwidthEstimator();
 
@@ -63,6 +67,20 @@ struct LiveSession::BandwidthEstimator : public RefBase {
             bool *isStable = NULL,
             int32_t *shortTermBps = NULL);
 
+    // Downloads running at the same time share the link, so measurements
+    // taken while several are open are weighted by their number.
+    void onTransferStarted();
+    void onTransferEnded();
+
+    // Time from sending a segment request to the server's response, and
+    // the duration of the segment requested.
+    void addLatencyMeasurement(int64_t latencyUs, int64_t segmentDurationUs);
+
+    // Predicts the share of the estimated bandwidth a variant can use: each
+    // segment also pays the request latency, which |numConnections| requests
+    // in flight overlap with the transfers.
+    float getUsableBandwidthRatio(size_t numConnections);
+
 private:
     // Bandwidth estimation parameters
     static const int32_t kShortTermBandwidthItems = 3;
@@ -70,6 +88,10 @@ private:
     static const int64_t kMinBandwidthHistoryWindowUs = 5000000LL; // 5 sec
     static const int64_t kMaxBandwidthHistoryWindowUs = 30000000LL; // 30 sec
     static const int64_t kMaxBandwidthHistoryAgeUs = 60000000LL; // 60 sec
+    // be conservative (70%) to avoid overestimating and immediately
+    // switching down again, but keep some headroom when latency is high.
+    static constexpr float kMaxUsableBandwidthRatio = 0.7f;
+    static constexpr float kMinUsableBandwidthRatio = 0.35f;
 
     struct BandwidthEntry {
         int64_t mTimestampUs;
@@ -85,6 +107,9 @@ private:
     bool mIsStable;
     int64_t mTotalTransferTimeUs;
     size_t mTotalTransferBytes;
+    int32_t mNumActiveTransfers;
+    int64_t mLatencyUs;
+    int64_t mSegmentDurationUs;
 
     DISALLOW_EVIL_CONSTRUCTORS(BandwidthEstimator);
 };
@@ -94,13 +119,64 @@ LiveSession::BandwidthEstimator::BandwidthEstimator() :
     mHasNewSample(false),
     mIsStable(true),
     mTotalTransferTimeUs(0),
-    mTotalTransferBytes(0) {
+    mTotalTransferBytes(0),
+    mNumActiveTransfers(0),
+    mLatencyUs(-1LL),
+    mSegmentDurationUs(-1LL) {
+}
+
+void LiveSession::BandwidthEstimator::onTransferStarted() {
+    AutoMutex autoLock(mLock);
+    ++mNumActiveTransfers;
+}
+
+void LiveSession::BandwidthEstimator::onTransferEnded() {
+    AutoMutex autoLock(mLock);
+    CHECK_GT(mNumActiveTransfers, 0);
+    --mNumActiveTransfers;
+}
+
+void LiveSession::BandwidthEstimator::addLatencyMeasurement(
+        int64_t latencyUs, int64_t segmentDurationUs) {
+    AutoMutex autoLock(mLock);
+
+    // exponential moving averages, weighting the latest sample by 1/4
+    if (mLatencyUs < 0) {
+        mLatencyUs = latencyUs;
+    } else {
+        mLatencyUs = (mLatencyUs * 3 + latencyUs) / 4;
+    }
+    if (segmentDurationUs > 0) {
+        if (mSegmentDurationUs < 0) {
+            mSegmentDurationUs = segmentDurationUs;
+        } else {
+            mSegmentDurationUs = (mSegmentDurationUs * 3 + segmentDurationUs) / 4;
+        }
+    }
+}
+
+float LiveSession::BandwidthEstimator::getUsableBandwidthRatio(size_t numConnections) {
+    AutoMutex autoLock(mLock);
+
+    float ratio = kMaxUsableBandwidthRatio;
+    if (mLatencyUs > 0 && mSegmentDurationUs > 0 && numConnections > 0) {
+        // Fetching a segment of duration D at bitrate b takes L + b * D / bw;
+        // with the latency L spread over the connections in flight, it keeps
+        // up with playback at the usual margin if b <= bw * (0.7 - L / (N * D)).
+        ratio -= (float)mLatencyUs / ((float)mSegmentDurationUs * numConnections);
+    }
+    return ratio < kMinUsableBandwidthRatio ? kMinUsableBandwidthRatio : ratio;
 }
 
 void LiveSession::BandwidthEstimator::addBandwidthMeasurement(
         size_t numBytes, int64_t delayUs) {
     AutoMutex autoLock(mLock);
 
+    // Each of the concurrent transfers only got its share of the bandwidth.
+    if (mNumActiveTransfers > 1) {
+        delayUs /= mNumActiveTransfers;
+    }
+
     int64_t nowUs = ALooper::GetNowUs();
     BandwidthEntry entry;
     entry.mTimestampUs = nowUs;
@@ -305,7 +381,14 @@ LiveSession::LiveSession(
       mFirstTimeUsValid(false),
       mFirstTimeUs(0),
       mLastSeekTimeUs(0),
-      mHasMetadata(false) {
+      mHasMetadata(false),
+      mConnectTimeUs(-1LL),
+      mMasterPlaylistFetchTimeUs(-1LL),
+      mBufferingStartTimeUs(-1LL) {
+    int32_t numPrefetchSegments = property_get_int32(
+            "media.httplive.prefetch-segments", kDefaultNumPrefetchSegments);
+    mNumPrefetchSegments = min(max(numPrefetchSegments, 0), kMaxNumPrefetchSegments);
+
     mStreams[kAudioIndex] = StreamItem("audio");
     mStreams[kVideoIndex] = StreamItem("video");
     mStreams[kSubtitleIndex] = StreamItem("subtitles");
@@ -495,6 +578,10 @@ sp<HTTPDownloader> LiveSession::getHTTPDownloader() {
     return new HTTPDownloader(mHTTPService, mExtraHeaders);
 }
 
+size_t LiveSession::getNumPrefetchSegments() const {
+    return mNumPrefetchSegments;
+}
+
 void LiveSession::setBufferingSettings(
         const BufferingSettings &buffering) {
     sp<AMessage> msg = new AMessage(kWhatSetBufferingSettings, this);
@@ -999,6 +1086,7 @@ void LiveSession::onConnect(const sp<AMessage> &msg) {
 
     // TODO currently we don't know if we are coming here from incognito mode
     ALOGI("onConnect %s", uriDebugString(mMasterURL).c_str());
+    mConnectTimeUs = ALooper::GetNowUs();
 
     KeyedVector<String8, String8> *headers = NULL;
     if (!msg->findPointer("headers", (void **)&headers)) {
@@ -1035,6 +1123,7 @@ void LiveSession::onMasterPlaylistFetched(const sp<AMessage> &msg) {
     // no longer useful, remove
     mFetcherLooper->unregisterHandler(mFetcherInfos[index].mFetcher->id());
     mFetcherInfos.removeItemsAt(index);
+    mMasterPlaylistFetchTimeUs = ALooper::GetNowUs();
 
     CHECK(msg->findObject("playlist", (sp<RefBase> *)&mPlaylist));
     if (mPlaylist == NULL) {
@@ -1333,6 +1422,18 @@ void LiveSession::addBandwidthMeasurement(size_t numBytes, int64_t delayUs) {
     mBandwidthEstimator->addBandwidthMeasurement(numBytes, delayUs);
 }
 
+void LiveSession::addLatencyMeasurement(int64_t latencyUs, int64_t segmentDurationUs) {
+    mBandwidthEstimator->addLatencyMeasurement(latencyUs, segmentDurationUs);
+}
+
+void LiveSession::onTransferStarted() {
+    mBandwidthEstimator->onTransferStarted();
+}
+
+void LiveSession::onTransferEnded() {
+    mBandwidthEstimator->onTransferEnded();
+}
+
 ssize_t LiveSession::getLowestValidBandwidthIndex() const {
     for (size_t index = 0; index < mBandwidthItems.size(); index++) {
         if (isBandwidthValid(mBandwidthItems[index])) {
@@ -1380,12 +1481,18 @@ size_t LiveSession::getBandwidthIndex(int32_t bandwidthBps) {
         // Pick the highest bandwidth stream that's not currently blacklisted
         // below or equal to estimated bandwidth.
 
+        // be conservative (at most 70%) to avoid overestimating and immediately
+        // switching down again, and leave room for the request latency of
+        // each segment.
+        float usableRatio = mBandwidthEstimator->getUsableBandwidthRatio(
+                1 + mNumPrefetchSegments);
+        size_t adjustedBandwidthBps = bandwidthBps * usableRatio;
+        ALOGV("usable bandwidth %zu bps (%.0f%% of estimate)",
+                adjustedBandwidthBps, usableRatio * 100);
+
         index = mBandwidthItems.size() - 1;
         ssize_t lowestBandwidth = getLowestValidBandwidthIndex();
         while (index > lowestBandwidth) {
-            // be conservative (70%) to avoid overestimating and immediately
-            // switching down again.
-            size_t adjustedBandwidthBps = bandwidthBps * .7f;
             const BandwidthItem &item = mBandwidthItems[index];
             if (item.mBandwidth <= adjustedBandwidthBps
                     && isBandwidthValid(item)) {
@@ -2247,6 +2354,7 @@ void LiveSession::startBufferingIfNecessary() {
             mInPreparationPhase, mBuffering);
     if (!mBuffering) {
         mBuffering = true;
+        mBufferingStartTimeUs = ALooper::GetNowUs();
 
         sp<AMessage> notify = mNotify->dup();
         notify->setInt32("what", kWhatBufferingStart);
@@ -2263,6 +2371,13 @@ void LiveSession::stopBufferingIfNecessary() {
 
         sp<AMessage> notify = mNotify->dup();
         notify->setInt32("what", kWhatBufferingEnd);
+        if (!mInPreparationPhase && mBufferingStartTimeUs >= 0) {
+            int64_t rebufferingTimeUs = ALooper::GetNowUs() - mBufferingStartTimeUs;
+            ALOGI("rebuffered for %lld ms at bandwidth index %zd",
+                    (long long)rebufferingTimeUs / 1000, mCurBandwidthIndex);
+            notify->setInt64("rebufferingTimeUs", rebufferingTimeUs);
+        }
+        mBufferingStartTimeUs = -1LL;
         notify->post();
     }
 }
@@ -2400,6 +2515,19 @@ void LiveSession::postPrepared(status_t err) {
     sp<AMessage> notify = mNotify->dup();
     if (err == OK || err == ERROR_END_OF_STREAM) {
         notify->setInt32("what", kWhatPrepared);
+
+        // startup metrics, measured from onConnect()
+        if (mConnectTimeUs >= 0) {
+            int64_t startupTimeUs = ALooper::GetNowUs() - mConnectTimeUs;
+            int64_t playlistTimeUs = mMasterPlaylistFetchTimeUs >= 0
+                    ? mMasterPlaylistFetchTimeUs - mConnectTimeUs : -1LL;
+            ALOGI("prepared in %lld ms (master playlist %lld ms), "
+                    "bandwidth index %zd, %zu segments prefetched per fetcher",
+                    (long long)startupTimeUs / 1000, (long long)playlistTimeUs / 1000,
+                    mCurBandwidthIndex, mNumPrefetchSegments);
+            notify->setInt64("startupTimeUs", startupTimeUs);
+            notify->setInt64("playlistFetchTimeUs", playlistTimeUs);
+        }
     } else {
         cancelPollBuffering();
 
@@ -37,6 +37,7 @@ struct MediaHTTPService;
 struct LiveDataSource;
 struct M3UParser;
 struct PlaylistFetcher;
+struct SegmentPrefetcher;
 struct HLSTime;
 struct HTTPDownloader;
 
@@ -122,6 +123,7 @@ protected:
 
 private:
     friend struct PlaylistFetcher;
+    friend struct SegmentPrefetcher;
 
     enum {
         kWhatConnect                    = 'conn',
@@ -253,6 +255,15 @@ private:
     KeyedVector<size_t, int64_t> mDiscontinuityAbsStartTimesUs;
     KeyedVector<size_t, int64_t> mDiscontinuityOffsetTimesUs;
 
+    // Number of segments each fetcher downloads ahead, in parallel with the
+    // segment it's parsing ("media.httplive.prefetch-segments").
+    size_t mNumPrefetchSegments;
+
+    // Startup and rebuffering metrics.
+    int64_t mConnectTimeUs;
+    int64_t mMasterPlaylistFetchTimeUs;
+    int64_t mBufferingStartTimeUs;
+
     sp<PlaylistFetcher> addFetcher(const char *uri);
 
     void onConnect(const sp<AMessage> &msg);
@@ -271,6 +282,10 @@ private:
     float getAbortThreshold(
             ssize_t currentBWIndex, ssize_t targetBWIndex) const;
     void addBandwidthMeasurement(size_t numBytes, int64_t delayUs);
+    void addLatencyMeasurement(int64_t latencyUs, int64_t segmentDurationUs);
+    void onTransferStarted();
+    void onTransferEnded();
+    size_t getNumPrefetchSegments() const;
     size_t getBandwidthIndex(int32_t bandwidthBps);
     ssize_t getLowestValidBandwidthIndex() const;
     HLSTime latestMediaSegmentStartTime() const;
@@ -24,6 +24,7 @@
 #include "HTTPDownloader.h"
 #include "LiveSession.h"
 #include "M3UParser.h"
+#include "SegmentPrefetcher.h"
 #include <ID3.h>
 #include <mpeg2ts/AnotherPacketSource.h>
 #include <mpeg2ts/HlsSampleDecryptor.h>
@@ -55,6 +56,9 @@ const int64_t PlaylistFetcher::kMinBufferedDurationUs = 30000000LL;
 const int64_t PlaylistFetcher::kMaxMonitorDelayUs = 3000000LL;
 // LCM of 188 (size of a TS packet) & 1k works well
 const int32_t PlaylistFetcher::kDownloadBlockSize = 47 * 1024;
+// Smaller blocks at the start of a transport stream segment let the parser
+// queue the first access units sooner; a multiple of 188 and of the AES block size.
+const int32_t PlaylistFetcher::kStartDownloadBlockSize = 188 * 64;
 
 struct PlaylistFetcher::DownloadState : public RefBase {
     DownloadState();
@@ -186,6 +190,9 @@ PlaylistFetcher::PlaylistFetcher(
 }
 
 PlaylistFetcher::~PlaylistFetcher() {
+    if (mPrefetcher != NULL) {
+        mPrefetcher->stop();
+    }
 }
 
 int32_t PlaylistFetcher::getFetcherID() const {
@@ -758,6 +765,14 @@ status_t PlaylistFetcher::onStart(const sp<AMessage> &msg) {
 
     mStreamTypeMask = streamTypeMask;
 
+    if (mPrefetcher == NULL
+            && (mStreamTypeMask
+                    & (LiveSession::STREAMTYPE_AUDIO | LiveSession::STREAMTYPE_VIDEO))
+            && mSession->getNumPrefetchSegments() > 0) {
+        mPrefetcher = new SegmentPrefetcher(
+                mSession, mSession->getNumPrefetchSegments(), mFetcherID);
+    }
+
     mSegmentStartTimeUs = segmentStartTimeUs;
 
     if (startDiscontinuitySeq >= 0) {
@@ -779,6 +794,9 @@ status_t PlaylistFetcher::onStart(const sp<AMessage> &msg) {
         mSeqNumber = -1;
         mTimeChangeSignaled = false;
         mDownloadState->resetState();
+        if (mPrefetcher != NULL) {
+            mPrefetcher->flush();
+        }
     }
 
     postMonitorQueue();
@@ -806,6 +824,9 @@ void PlaylistFetcher::onStop(const sp<AMessage> &msg) {
     }
 
     mDownloadState->resetState();
+    if (mPrefetcher != NULL) {
+        mPrefetcher->flush();
+    }
     mPacketSources.clear();
     mStreamTypeMask = 0;
 
@@ -978,6 +999,20 @@ bool PlaylistFetcher::bufferStartsWithTsSyncByte(const sp<ABuffer>& buffer) {
     return buffer->size() > 0 && buffer->data()[0] == 0x47;
 }
 
+int32_t PlaylistFetcher::getDownloadBlockSize(const sp<ABuffer> &buffer) const {
+    // The first block tells whether the segment is a transport stream, which
+    // is extracted as it arrives. Keep the blocks small until the segment's
+    // first access units are out, and while starting up (after a seek or
+    // a switch) until every stream found its start.
+    if (buffer == NULL) {
+        return kStartDownloadBlockSize;
+    }
+    if (bufferStartsWithTsSyncByte(buffer) && (mStartup || mSegmentFirstPTS < 0)) {
+        return kStartDownloadBlockSize;
+    }
+    return kDownloadBlockSize;
+}
+
 bool PlaylistFetcher::shouldPauseDownload() {
     if (mStreamTypeMask == LiveSession::STREAMTYPE_SUBTITLES) {
         // doesn't apply to subtitles
@@ -1327,6 +1362,44 @@ bool PlaylistFetcher::initDownloadState(
     return true;
 }
 
+void PlaylistFetcher::prefetchNextSegments(
+        int32_t firstSeqNumberInPlaylist, int32_t lastSeqNumberInPlaylist) {
+    if (mPrefetcher == NULL) {
+        return;
+    }
+    // Don't prefetch while switching, the fetcher stops at a boundary that's
+    // likely in this segment.
+    if (mStopParams != NULL
+            || (mSeekMode != LiveSession::kSeekModeExactPosition
+                    && mStartTimeUsNotify != NULL)) {
+        return;
+    }
+
+    int32_t lastSeqNumber = mSeqNumber + (int32_t)mSession->getNumPrefetchSegments();
+    if (lastSeqNumber > lastSeqNumberInPlaylist) {
+        lastSeqNumber = lastSeqNumberInPlaylist;
+    }
+    for (int32_t seqNumber = mSeqNumber + 1; seqNumber <= lastSeqNumber; ++seqNumber) {
+        AString uri;
+        sp<AMessage> itemMeta;
+        if (!mPlaylist->itemAt(seqNumber - firstSeqNumberInPlaylist, &uri, &itemMeta)) {
+            break;
+        }
+
+        int64_t rangeOffset, rangeLength;
+        if (!itemMeta->findInt64("range-offset", &rangeOffset)
+                || !itemMeta->findInt64("range-length", &rangeLength)) {
+            rangeOffset = 0;
+            rangeLength = -1;
+        }
+        int64_t durationUs;
+        if (!itemMeta->findInt64("durationUs", &durationUs)) {
+            durationUs = -1LL;
+        }
+        mPrefetcher->prefetch(seqNumber, uri, rangeOffset, rangeLength, durationUs);
+    }
+}
+
 void PlaylistFetcher::onDownloadNext() {
     AString uri;
     sp<AMessage> itemMeta;
@@ -1335,6 +1408,7 @@ void PlaylistFetcher::onDownloadNext() {
     int32_t firstSeqNumberInPlaylist = 0;
     int32_t lastSeqNumberInPlaylist = 0;
     bool connectHTTP = true;
+    bool prefetched = false;
 
     if (mDownloadState->hasSavedState()) {
         mDownloadState->restoreState(
@@ -1364,15 +1438,33 @@ void PlaylistFetcher::onDownloadNext() {
         range_length = -1;
     }
 
-    // block-wise download
+    if (connectHTTP && mPrefetcher != NULL) {
+        buffer = mPrefetcher->take(
+                mSeqNumber, uri, range_offset, range_length, mHTTPDownloader);
+        prefetched = buffer != NULL;
+        if (prefetched) {
+            FLOGV("segment %d was prefetched", mSeqNumber);
+        }
+        prefetchNextSegments(firstSeqNumberInPlaylist, lastSeqNumberInPlaylist);
+    }
+
+    // block-wise download, or the whole segment at once if prefetched
     bool shouldPause = false;
     ssize_t bytesRead;
     do {
         int64_t startUs = ALooper::GetNowUs();
-        bytesRead = mHTTPDownloader->fetchBlock(
-                uri.c_str(), &buffer, range_offset, range_length, kDownloadBlockSize,
-                NULL /* actualURL */, connectHTTP);
+        if (prefetched) {
+            bytesRead = buffer->size();
+        } else {
+            mSession->onTransferStarted();
+            bytesRead = mHTTPDownloader->fetchBlock(
+                    uri.c_str(), &buffer, range_offset, range_length,
+                    getDownloadBlockSize(buffer), NULL /* actualURL */, connectHTTP);
+            mSession->onTransferEnded();
+        }
         int64_t delayUs = ALooper::GetNowUs() - startUs;
+        int64_t connectDelayUs = (!prefetched && connectHTTP)
+                ? mHTTPDownloader->getLastConnectDelayUs() : -1LL;
 
         if (bytesRead == ERROR_NOT_CONNECTED) {
             return;
@@ -1386,17 +1478,30 @@ void PlaylistFetcher::onDownloadNext() {
 
         // add sample for bandwidth estimation, excluding samples from subtitles (as
         // its too small), or during startup/resumeUntil (when we could have more than
-        // one connection open which affects bandwidth)
-        if (!mStartup && mStopParams == NULL && bytesRead > 0
+        // one connection open which affects bandwidth). The prefetcher measured
+        // prefetched segments itself.
+        // The request latency is measured separately, and would weigh too much
+        // on the small first blocks.
+        if (!prefetched && !mStartup && mStopParams == NULL && bytesRead > 0
                 && (mStreamTypeMask
                         & (LiveSession::STREAMTYPE_AUDIO
                         | LiveSession::STREAMTYPE_VIDEO))) {
-            mSession->addBandwidthMeasurement(bytesRead, delayUs);
+            int64_t transferDelayUs = delayUs;
+            if (connectDelayUs >= 0 && connectDelayUs < delayUs) {
+                transferDelayUs -= connectDelayUs;
+            }
+            mSession->addBandwidthMeasurement(bytesRead, transferDelayUs);
             if (delayUs > 2000000LL) {
                 FLOGV("bytesRead %zd took %.2f seconds - abnormal bandwidth dip",
                         bytesRead, (double)delayUs / 1.0e6);
             }
         }
+        if (connectDelayUs >= 0
+                && (mStreamTypeMask
+                        & (LiveSession::STREAMTYPE_AUDIO
+                        | LiveSession::STREAMTYPE_VIDEO))) {
+            mSession->addLatencyMeasurement(connectDelayUs, getSegmentDurationUs(mSeqNumber));
+        }
 
         connectHTTP = false;
 
@@ -1461,8 +1566,9 @@ void PlaylistFetcher::onDownloadNext() {
         }
         if (shouldPause || shouldPauseDownload()) {
             // save state and return if this is not the last chunk,
-            // leaving the fetcher in paused state.
-            if (bytesRead != 0) {
+            // leaving the fetcher in paused state. A prefetched segment
+            // has no more chunks.
+            if (bytesRead != 0 && !prefetched) {
                 mDownloadState->saveState(
                         uri,
                         itemMeta,
@@ -1474,7 +1580,7 @@ void PlaylistFetcher::onDownloadNext() {
             }
             shouldPause = true;
         }
-    } while (bytesRead != 0);
+    } while (bytesRead != 0 && !prefetched);
 
     if (bufferStartsWithTsSyncByte(buffer)) {
         // If we don't see a stream in the program table after fetching a full ts segment
@@ -1740,15 +1846,10 @@ status_t PlaylistFetcher::extractAndQueueAccessUnitsFromTs(const sp<ABuffer> &bu
         mSampleAesKeyItemChanged = false;
     }
 
-    size_t offset = 0;
-    while (offset + 188 <= buffer->size()) {
-        status_t err = mTSParser->feedTSPacket(buffer->data() + offset, 188);
-
-        if (err != OK) {
-            return err;
-        }
-
-        offset += 188;
+    size_t offset;
+    status_t err = mTSParser->feedTSPackets(buffer->data(), buffer->size(), &offset);
+    if (err != OK) {
+        return err;
     }
     // setRange to indicate consumed bytes.
     buffer->setRange(buffer->offset() + offset, buffer->size() - offset);
@@ -1810,7 +1911,7 @@ status_t PlaylistFetcher::extractAndQueueAccessUnitsFromTs(const sp<ABuffer> &bu
         }
     }
 
-    status_t err = OK;
+    err = OK;
     for (size_t i = mPacketSources.size(); i > 0;) {
         i--;
         sp<AnotherPacketSource> packetSource = mPacketSources.valueAt(i);
@@ -32,11 +32,13 @@ class DataSource;
 struct HTTPBase;
 struct LiveDataSource;
 struct M3UParser;
+struct SegmentPrefetcher;
 class String8;
 
 struct PlaylistFetcher : public AHandler {
     static const int64_t kMinBufferedDurationUs;
     static const int32_t kDownloadBlockSize;
+    static const int32_t kStartDownloadBlockSize;
     static const int64_t kFetcherResumeThreshold;
 
     enum {
@@ -111,6 +113,7 @@ private:
     static const int32_t kNumSkipFrames;
 
     static bool bufferStartsWithTsSyncByte(const sp<ABuffer>& buffer);
+    int32_t getDownloadBlockSize(const sp<ABuffer> &buffer) const;
     static bool bufferStartsWithWebVTTMagicSequence(const sp<ABuffer>& buffer);
 
     // notifications to mSession
@@ -187,6 +190,9 @@ private:
 
     sp<DownloadState> mDownloadState;
 
+    // Downloads the segments after mSeqNumber while this one is parsed.
+    sp<SegmentPrefetcher> mPrefetcher;
+
     bool mHasMetadata;
 
     // Set first to true if decrypting the first segment of a playlist segment. When
@@ -231,6 +237,9 @@ private:
             sp<AMessage> &itemMeta,
             int32_t &firstSeqNumberInPlaylist,
             int32_t &lastSeqNumberInPlaylist);
+    void prefetchNextSegments(
+            int32_t firstSeqNumberInPlaylist,
+            int32_t lastSeqNumberInPlaylist);
 
     // Resume a fetcher to continue until the stopping point stored in msg.
     status_t onResumeUntil(const sp<AMessage> &msg);
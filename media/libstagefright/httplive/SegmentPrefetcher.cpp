@@ -0,0 +1,302 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SegmentPrefetcher"
+#include <utils/Log.h>
+
+#include "SegmentPrefetcher.h"
+#include "HTTPDownloader.h"
+#include "LiveSession.h"
+#include "PlaylistFetcher.h"
+
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/AHandler.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AMessage.h>
+#include <media/stagefright/FoundationUtils.h>
+
+#define PLOGV(fmt, ...) ALOGV("[fetcher-%d] " fmt, mFetcherID, ##__VA_ARGS__)
+
+namespace android {
+
+// How long take() waits at a time before checking for a disconnect.
+static const int64_t kTakeWaitTimeoutNs = 100000000LL;  // 100 ms
+
+struct SegmentPrefetcher::Worker : public AHandler {
+    Worker(const wp<SegmentPrefetcher> &prefetcher,
+            const sp<LiveSession> &session, size_t index)
+        : mPrefetcher(prefetcher),
+          mSession(session),
+          mIndex(index),
+          mHTTPDownloader(session->getHTTPDownloader()) {
+    }
+
+    void downloadAsync(
+            int32_t generation, int32_t seqNumber, const AString &uri,
+            int64_t rangeOffset, int64_t rangeLength, int64_t durationUs) {
+        sp<AMessage> msg = new AMessage(kWhatDownload, this);
+        msg->setInt32("generation", generation);
+        msg->setInt32("seqNumber", seqNumber);
+        msg->setString("uri", uri);
+        msg->setInt64("rangeOffset", rangeOffset);
+        msg->setInt64("rangeLength", rangeLength);
+        msg->setInt64("durationUs", durationUs);
+        msg->post();
+    }
+
+    const sp<HTTPDownloader> &getHTTPDownloader() const {
+        return mHTTPDownloader;
+    }
+
+protected:
+    virtual void onMessageReceived(const sp<AMessage> &msg);
+
+private:
+    enum {
+        kWhatDownload = 'dnld',
+    };
+
+    wp<SegmentPrefetcher> mPrefetcher;
+    sp<LiveSession> mSession;
+    size_t mIndex;
+    sp<HTTPDownloader> mHTTPDownloader;
+
+    DISALLOW_EVIL_CONSTRUCTORS(Worker);
+};
+
+void SegmentPrefetcher::Worker::onMessageReceived(const sp<AMessage> &msg) {
+    CHECK_EQ(msg->what(), (uint32_t)kWhatDownload);
+
+    int32_t generation, seqNumber;
+    AString uri;
+    int64_t rangeOffset, rangeLength, durationUs;
+    CHECK(msg->findInt32("generation", &generation));
+    CHECK(msg->findInt32("seqNumber", &seqNumber));
+    CHECK(msg->findString("uri", &uri));
+    CHECK(msg->findInt64("rangeOffset", &rangeOffset));
+    CHECK(msg->findInt64("rangeLength", &rangeLength));
+    CHECK(msg->findInt64("durationUs", &durationUs));
+
+    sp<SegmentPrefetcher> prefetcher = mPrefetcher.promote();
+    if (prefetcher == NULL || !prefetcher->startDownload(mIndex, generation, seqNumber)) {
+        return;
+    }
+
+    // block-wise download, like PlaylistFetcher does, so that the concurrent
+    // transfers are counted for each bandwidth measurement
+    sp<ABuffer> buffer;
+    bool connectHTTP = true;
+    ssize_t bytesRead;
+    do {
+        int64_t startUs = ALooper::GetNowUs();
+        mSession->onTransferStarted();
+        bytesRead = mHTTPDownloader->fetchBlock(
+                uri.c_str(), &buffer, rangeOffset, rangeLength,
+                PlaylistFetcher::kDownloadBlockSize, NULL /* actualURL */, connectHTTP);
+        mSession->onTransferEnded();
+        int64_t delayUs = ALooper::GetNowUs() - startUs;
+
+        int64_t connectDelayUs = connectHTTP ? mHTTPDownloader->getLastConnectDelayUs() : -1LL;
+        if (connectDelayUs >= 0) {
+            mSession->addLatencyMeasurement(connectDelayUs, durationUs);
+            if (connectDelayUs < delayUs) {
+                delayUs -= connectDelayUs;
+            }
+        }
+        if (bytesRead > 0) {
+            mSession->addBandwidthMeasurement(bytesRead, delayUs);
+        }
+        connectHTTP = false;
+    } while (bytesRead > 0);
+
+    // close off the connection after use
+    mHTTPDownloader->disconnect();
+
+    prefetcher->onDownloadDone(
+            mIndex, generation, seqNumber, bytesRead < 0 ? (status_t)bytesRead : OK, buffer);
+}
+
+SegmentPrefetcher::SegmentPrefetcher(
+        const sp<LiveSession> &session, size_t numConnections, int32_t fetcherID)
+    : mSession(session),
+      mFetcherID(fetcherID),
+      mGeneration(0) {
+    for (size_t i = 0; i < numConnections; ++i) {
+        sp<ALooper> looper = new ALooper;
+        looper->setName("SegmentPrefetcher");
+        looper->start(false /* runOnCallingThread */, true /* canCallJava */);
+
+        sp<Worker> worker = new Worker(this, session, i);
+        looper->registerHandler(worker);
+
+        mLoopers.push(looper);
+        mWorkers.push(worker);
+        mWorkerBusy.push(false);
+    }
+}
+
+SegmentPrefetcher::~SegmentPrefetcher() {
+    CHECK(mLoopers.empty());
+}
+
+void SegmentPrefetcher::prefetch(
+        int32_t seqNumber, const AString &uri,
+        int64_t rangeOffset, int64_t rangeLength, int64_t durationUs) {
+    AutoMutex _l(mLock);
+
+    // Keep at most one segment per connection, downloaded or not.
+    if (mSegments.indexOfKey(seqNumber) >= 0 || mSegments.size() >= mWorkers.size()) {
+        return;
+    }
+
+    for (size_t i = 0; i < mWorkers.size(); ++i) {
+        if (mWorkerBusy[i]) {
+            continue;
+        }
+
+        PLOGV("prefetching segment %d: '%s'", seqNumber, uriDebugString(uri).c_str());
+
+        Segment segment;
+        segment.mUri = uri;
+        segment.mRangeOffset = rangeOffset;
+        segment.mRangeLength = rangeLength;
+        segment.mWorkerIndex = i;
+        segment.mStatus = OK;
+        mSegments.add(seqNumber, segment);
+
+        mWorkerBusy.editItemAt(i) = true;
+        mWorkers[i]->downloadAsync(
+                mGeneration, seqNumber, uri, rangeOffset, rangeLength, durationUs);
+        return;
+    }
+}
+
+sp<ABuffer> SegmentPrefetcher::take(
+        int32_t seqNumber, const AString &uri,
+        int64_t rangeOffset, int64_t rangeLength,
+        const sp<HTTPDownloader> &downloader) {
+    AutoMutex _l(mLock);
+
+    // Segments before |seqNumber| won't be asked for anymore, and neither will
+    // ones prefetched from a different location (the playlist changed).
+    for (size_t i = mSegments.size(); i-- > 0;) {
+        const Segment &segment = mSegments.valueAt(i);
+        if (mSegments.keyAt(i) > seqNumber) {
+            continue;
+        }
+        if (mSegments.keyAt(i) == seqNumber
+                && segment.mUri == uri
+                && segment.mRangeOffset == rangeOffset
+                && segment.mRangeLength == rangeLength) {
+            continue;
+        }
+        if (segment.mWorkerIndex >= 0) {
+            mWorkers[segment.mWorkerIndex]->getHTTPDownloader()->disconnect();
+        }
+        mSegments.removeItemsAt(i);
+    }
+
+    ssize_t index = mSegments.indexOfKey(seqNumber);
+    while (index >= 0 && mSegments.valueAt(index).mWorkerIndex >= 0) {
+        if (downloader->isDisconnecting()) {
+            return NULL;
+        }
+        mCondition.waitRelative(mLock, kTakeWaitTimeoutNs);
+        index = mSegments.indexOfKey(seqNumber);
+    }
+    if (index < 0) {
+        return NULL;
+    }
+
+    Segment segment = mSegments.valueAt(index);
+    mSegments.removeItemsAt(index);
+    if (segment.mStatus != OK) {
+        PLOGV("prefetching segment %d failed (%d)", seqNumber, segment.mStatus);
+        return NULL;
+    }
+    return segment.mBuffer;
+}
+
+void SegmentPrefetcher::flush() {
+    AutoMutex _l(mLock);
+
+    ++mGeneration;
+    for (size_t i = 0; i < mSegments.size(); ++i) {
+        ssize_t workerIndex = mSegments.valueAt(i).mWorkerIndex;
+        if (workerIndex >= 0) {
+            mWorkers[workerIndex]->getHTTPDownloader()->disconnect();
+        }
+    }
+    mSegments.clear();
+    mCondition.broadcast();
+}
+
+void SegmentPrefetcher::stop() {
+    flush();
+
+    for (size_t i = 0; i < mLoopers.size(); ++i) {
+        mLoopers[i]->unregisterHandler(mWorkers[i]->id());
+        mLoopers[i]->stop();
+    }
+    mLoopers.clear();
+    mWorkers.clear();
+}
+
+bool SegmentPrefetcher::startDownload(
+        size_t workerIndex, int32_t generation, int32_t seqNumber) {
+    AutoMutex _l(mLock);
+
+    ssize_t index = mSegments.indexOfKey(seqNumber);
+    if (generation != mGeneration || index < 0
+            || mSegments.valueAt(index).mWorkerIndex != (ssize_t)workerIndex) {
+        mWorkerBusy.editItemAt(workerIndex) = false;
+        return false;
+    }
+    // Under the lock, so that a flush() or take() either comes before and
+    // cancels the download, or after and disconnects it.
+    mWorkers[workerIndex]->getHTTPDownloader()->reconnect();
+    return true;
+}
+
+void SegmentPrefetcher::onDownloadDone(
+        size_t workerIndex, int32_t generation, int32_t seqNumber,
+        status_t status, const sp<ABuffer> &buffer) {
+    AutoMutex _l(mLock);
+
+    mWorkerBusy.editItemAt(workerIndex) = false;
+    if (generation != mGeneration) {
+        return;
+    }
+
+    ssize_t index = mSegments.indexOfKey(seqNumber);
+    if (index < 0 || mSegments.valueAt(index).mWorkerIndex != (ssize_t)workerIndex) {
+        // dropped by take()
+        return;
+    }
+
+    PLOGV("prefetched segment %d: %zu bytes, status %d",
+            seqNumber, buffer != NULL ? buffer->size() : 0, status);
+
+    Segment &segment = mSegments.editValueAt(index);
+    segment.mWorkerIndex = -1;
+    segment.mStatus = status;
+    segment.mBuffer = buffer;
+    mCondition.broadcast();
+}
+
+}  // namespace android
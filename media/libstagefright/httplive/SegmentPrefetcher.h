@@ -0,0 +1,103 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SEGMENT_PREFETCHER_H_
+
+#define SEGMENT_PREFETCHER_H_
+
+#include <media/stagefright/foundation/ABase.h>
+#include <media/stagefright/foundation/AString.h>
+#include <utils/Condition.h>
+#include <utils/KeyedVector.h>
+#include <utils/Mutex.h>
+#include <utils/RefBase.h>
+#include <utils/Vector.h>
+
+namespace android {
+
+struct ABuffer;
+struct ALooper;
+struct HTTPDownloader;
+struct LiveSession;
+
+// Downloads the segments following the one a PlaylistFetcher is parsing, each
+// on its own connection, so that request latency and the transfer of the next
+// segments overlap with the current one. The content is kept as downloaded
+// (still encrypted) until the fetcher takes it, in segment order.
+struct SegmentPrefetcher : public RefBase {
+    SegmentPrefetcher(const sp<LiveSession> &session, size_t numConnections, int32_t fetcherID);
+
+    // Starts downloading segment |seqNumber| if a connection is free and
+    // it's not downloaded or being downloaded yet.
+    void prefetch(
+            int32_t seqNumber, const AString &uri,
+            int64_t rangeOffset, int64_t rangeLength, int64_t durationUs);
+
+    // Returns the content of segment |seqNumber| if it was prefetched from
+    // |uri| and range, waiting for its download to finish if needed. Returns
+    // NULL if it wasn't prefetched, its download failed, or |downloader|
+    // (the fetcher's own) is disconnected while waiting. Drops the content
+    // of earlier segments.
+    sp<ABuffer> take(
+            int32_t seqNumber, const AString &uri,
+            int64_t rangeOffset, int64_t rangeLength,
+            const sp<HTTPDownloader> &downloader);
+
+    // Aborts the downloads in progress and drops all prefetched content.
+    void flush();
+
+    // Flushes and stops the download threads. No other method may be called afterwards.
+    void stop();
+
+protected:
+    virtual ~SegmentPrefetcher();
+
+private:
+    struct Worker;
+
+    struct Segment {
+        AString mUri;
+        int64_t mRangeOffset;
+        int64_t mRangeLength;
+        ssize_t mWorkerIndex;  // -1 when finished
+        status_t mStatus;
+        sp<ABuffer> mBuffer;
+    };
+
+    sp<LiveSession> mSession;
+    int32_t mFetcherID;
+
+    Vector<sp<ALooper> > mLoopers;
+    Vector<sp<Worker> > mWorkers;
+
+    Mutex mLock;
+    Condition mCondition;
+    KeyedVector<int32_t, Segment> mSegments;
+    Vector<bool> mWorkerBusy;
+    int32_t mGeneration;
+
+    // Called by the workers.
+    bool startDownload(size_t workerIndex, int32_t generation, int32_t seqNumber);
+    void onDownloadDone(
+            size_t workerIndex, int32_t generation, int32_t seqNumber,
+            status_t status, const sp<ABuffer> &buffer);
+
+    DISALLOW_EVIL_CONSTRUCTORS(SegmentPrefetcher);
+};
+
+}  // namespace android
+
+#endif  // SEGMENT_PREFETCHER_H_
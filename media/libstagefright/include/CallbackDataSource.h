@@ -17,6 +17,9 @@
 #ifndef ANDROID_CALLBACKDATASOURCE_H
 #define ANDROID_CALLBACKDATASOURCE_H
 
+#include <atomic>
+#include <memory>
+
 #include <media/DataSource.h>
 #include <media/stagefright/foundation/ADebug.h>
 
@@ -42,12 +45,15 @@ public:
         return mName;
     }
     virtual sp<IDataSource> getIDataSource() const;
+    virtual status_t getReadStatistics(int64_t *numReads, int64_t *numBytes);
 
 private:
     sp<IDataSource> mIDataSource;
     sp<IMemory> mMemory;
     bool mIsClosed;
     String8 mName;
+    std::atomic<int64_t> mNumReads;
+    std::atomic<int64_t> mNumBytesRead;
 
     DISALLOW_EVIL_CONSTRUCTORS(CallbackDataSource);
 };
@@ -70,6 +76,9 @@ public:
         return mName;
     }
     virtual sp<IDataSource> getIDataSource() const;
+    virtual status_t getReadStatistics(int64_t *numReads, int64_t *numBytes) {
+        return mSource->getReadStatistics(numReads, numBytes);
+    }
 
 private:
     // 2kb comes from experimenting with the time-to-first-frame from a MediaPlayer
@@ -88,6 +97,63 @@ private:
     DISALLOW_EVIL_CONSTRUCTORS(TinyCacheSource);
 };
 
+// A caching DataSource for sources where each read is expensive, e.g. a CallbackDataSource
+// read across binder. Small reads are served from a set of aligned blocks that are evicted
+// least recently used first; misses that continue a sequential scan read ahead several
+// blocks in one call to the wrapped source. Reads larger than a block bypass the cache.
+class BlockCacheSource : public DataSource {
+public:
+    BlockCacheSource(const sp<DataSource>& source, size_t blockSize);
+
+    virtual status_t initCheck() const;
+    virtual ssize_t readAt(off64_t offset, void* data, size_t size);
+    virtual status_t getSize(off64_t* size);
+    virtual uint32_t flags();
+    virtual void close();
+    virtual String8 toString() {
+        return mName;
+    }
+    virtual sp<IDataSource> getIDataSource() const;
+    virtual status_t getReadStatistics(int64_t *numReads, int64_t *numBytes) {
+        return mSource->getReadStatistics(numReads, numBytes);
+    }
+
+    // returns the number of reads served from the cache and those that needed a fill
+    void getCacheStatistics(int64_t *hits, int64_t *misses);
+
+protected:
+    virtual ~BlockCacheSource();
+
+private:
+    enum {
+        kNumBlocks = 8,
+        kReadaheadBlocks = 4,
+    };
+
+    struct Block {
+        off64_t mOffset;
+        size_t mSize;       // less than the block size only at the end of the source
+        uint64_t mLastUse;  // 0 if unused
+        std::unique_ptr<uint8_t[]> mData;
+    };
+
+    sp<DataSource> mSource;
+    const size_t mBlockSize;
+    Mutex mLock;
+    Block mBlocks[kNumBlocks];
+    std::unique_ptr<uint8_t[]> mFillBuffer;
+    uint64_t mUseCount;
+    off64_t mNextFillOffset;  // where a sequential scan would miss next
+    int64_t mHits;
+    int64_t mMisses;
+    String8 mName;
+
+    Block *findBlock_l(off64_t offset);
+    ssize_t fill_l(off64_t offset);
+
+    DISALLOW_EVIL_CONSTRUCTORS(BlockCacheSource);
+};
+
 }; // namespace android
 
 #endif // ANDROID_CALLBACKDATASOURCE_H
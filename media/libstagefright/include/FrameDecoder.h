@@ -18,6 +18,7 @@
 #define FRAME_DECODER_H_
 
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include <media/stagefright/foundation/AString.h>
@@ -76,6 +77,10 @@ protected:
             int64_t timeUs,
             bool *done) = 0;
 
+    // Returns false to drop the |index|-th sample read from the source without queueing it.
+    virtual bool shouldQueueSample(size_t /*index*/) { return true; }
+
+    const AString &componentName() const    { return mComponentName; }
     sp<MetaData> trackMeta()     const      { return mTrackMeta; }
     OMX_COLOR_FORMATTYPE dstFormat() const  { return mDstFormat; }
     ui::PixelFormat captureFormat() const   { return mCaptureFormat; }
@@ -95,6 +100,7 @@ private:
     sp<AMessage> mOutputFormat;
     bool mHaveMoreInputs;
     bool mFirstSample;
+    size_t mSamplesRead;
     sp<Surface> mSurface;
 
     status_t extractInternal();
@@ -143,6 +149,8 @@ private:
     List<int64_t> mSampleDurations;
     int64_t mDefaultSampleDurationUs;
 
+    int32_t getReducedResolutionScale() const;
+    void scaleDisplayRect(int32_t decodedWidth, int32_t decodedHeight);
     sp<Surface> initSurface();
     status_t captureSurface();
 };
@@ -153,6 +161,18 @@ struct MediaImageDecoder : public FrameDecoder {
             const sp<MetaData> &trackMeta,
             const sp<IMediaSource> &source);
 
+    // Output frame shared by the decoders splitting one grid image between them.
+    struct SharedFrame {
+        std::mutex mLock;
+        sp<IMemory> mMemory;
+    };
+
+    // Restricts this decoder to every |numLanes|-th tile column starting from the |lane|-th one
+    // of the decoded columns, so that |numLanes| decoders on separate sources can decode a grid
+    // image in parallel, each writing its tiles into |frame|. Must be called before init().
+    void setTileLane(
+            int32_t lane, int32_t numLanes, const std::shared_ptr<SharedFrame> &frame);
+
 protected:
     virtual sp<AMessage> onGetFormatAndSeekOptions(
             int64_t frameTimeUs,
@@ -162,6 +182,8 @@ protected:
 
     virtual status_t onExtractRect(FrameRect *rect) override;
 
+    virtual bool shouldQueueSample(size_t index) override;
+
     virtual status_t onInputReceived(
             const sp<MediaCodecBuffer> &codecBuffer __unused,
             MetaDataBase &sampleMeta __unused,
@@ -184,6 +206,17 @@ private:
     int32_t mTileHeight;
     int32_t mTilesDecoded;
     int32_t mTargetTiles;
+    int32_t mLane;
+    int32_t mNumLanes;
+    std::shared_ptr<SharedFrame> mSharedFrame;
+    // tiles decoded: the columns in |mColumns|, from row |mFirstRow| on
+    int32_t mFirstRow;
+    int32_t mFirstCol;
+    int32_t mLastCol;
+    std::vector<int32_t> mColumns;
+
+    // Selects this lane's columns among [firstCol, lastCol].
+    void setColumns(int32_t firstCol, int32_t lastCol);
 };
 
 }  // namespace android
@@ -42,6 +42,10 @@ struct ColorConverter {
 
     void setSrcColorSpace(uint32_t standard, uint32_t range, uint32_t transfer);
 
+    // Converts large frames in horizontal stripes on up to |maxThreads| threads, including the
+    // calling one. The default of 1 converts on the calling thread only.
+    void setMaxThreads(size_t maxThreads);
+
     status_t convert(
             const void *srcBits,
             size_t srcWidth, size_t srcHeight, size_t srcStride,
@@ -166,6 +170,7 @@ private:
     ColorSpace mSrcColorSpace;
     uint8_t *mClip;
     uint16_t *mClip10Bit;
+    size_t mMaxThreads;
 
     uint8_t *initClip();
     uint16_t *initClip10Bit();
@@ -173,6 +178,14 @@ private:
     // resolve YUVFormat from YUV420Flexible
     bool isValidForMediaImage2() const;
 
+    // converts the crop rects of |src| and |dst|, on the calling thread
+    status_t convertRect(const BitmapParams &src, const BitmapParams &dst);
+
+    // splits the crop rects of |src| and |dst| into stripes of even height that are converted
+    // in parallel
+    status_t convertInStripes(
+            const BitmapParams &src, const BitmapParams &dst, size_t numStripes);
+
     // get plane offsets from Formats
     status_t getSrcYUVPlaneOffsetAndStride(
             const BitmapParams &src,
@@ -17,7 +17,11 @@
 #ifndef CRYPTO_ASYNC_H_
 #define CRYPTO_ASYNC_H_
 
+#include <mutex>
+#include <string>
+
 #include <media/stagefright/CodecBase.h>
+#include <media/stagefright/MediaHistogram.h>
 #include <media/stagefright/foundation/Mutexed.h>
 namespace android {
 
@@ -51,10 +55,7 @@ public:
     // In order to prevent thread hop to just do that, we have created
     // a dependency on BufferChannel here to queue the buffer to the codec
     // immediately after decryption.
-    CryptoAsync(std::weak_ptr<BufferChannelBase> bufferChannel)
-        :mState(kCryptoAsyncActive) {
-        mBufferChannel = std::move(bufferChannel);
-    }
+    CryptoAsync(std::weak_ptr<BufferChannelBase> bufferChannel);
 
     // Destructor
     virtual ~CryptoAsync();
@@ -74,6 +75,17 @@ public:
     // for the queue to become operational again. Also acts like a rest.
     void stop(std::list<sp<AMessage>> * const buffers = nullptr);
 
+    // Latency of decrypting and queuing a buffer to the codec, in us.
+    struct DecryptLatency {
+        int64_t count = 0;
+        int64_t min = 0;
+        int64_t max = 0;
+        int64_t avg = 0;
+        std::string hist;
+        std::string histBuckets;
+    };
+    DecryptLatency getDecryptLatency();
+
     // Describes two actions for decrypt();
     // kActionDecrypt - decrypts the buffer and queues to codec
     // kActionAttachEncryptedBuffer - decrypts and attaches the buffer
@@ -140,6 +152,13 @@ private:
 
     CryptoAsyncState mState;
 
+    // Number of buffers decrypted by a kWhatDecrypt message before the looper
+    // handles the other messages, set by media.stagefright.crypto_async.depth
+    const size_t mDecryptDepth;
+
+    std::mutex mLatencyLock;
+    MediaHistogram<int64_t> mDecryptLatencyHist;  // GUARDED_BY(mLatencyLock)
+
     // Queue holding any pending buffers
     Mutexed<std::list<sp<AMessage>>> mPendingBuffers;
 
@@ -19,6 +19,7 @@
 #define MPEG4_WRITER_H_
 
 #include <stdio.h>
+#include <sys/uio.h>
 
 #include <media/stagefright/MediaWriter.h>
 #include <utils/List.h>
@@ -63,6 +64,8 @@ public:
     inline size_t write(const void *ptr, size_t size, size_t nmemb);
     // Write to file system by calling ::write() or post error message to looper on failure.
     void writeOrPostError(int fd, const void *buf, size_t count);
+    // Adds one write() or writev() to the write statistics.
+    void recordWrite(std::chrono::microseconds writeDuration, ssize_t bytesWritten);
     // Seek in the file by calling ::lseek64() or post error message to looper on failure.
     void seekOrPostError(int fd, off64_t offset, int whence);
     void endBox();
@@ -106,6 +109,7 @@ private:
     bool mSendNotify;
     off64_t mOffset;
     off64_t mPreAllocateFileEndOffset;  //End of file offset during preallocation.
+    off64_t mPreAllocateDemandOffset;  // End of the space asked of preAllocate() so far.
     off64_t mMdatOffset;
     off64_t mMaxOffsetAppend; // File offset written upto while appending.
     off64_t mMdatEndOffset;  // End offset of mdat atom.
@@ -133,6 +137,39 @@ private:
     std::priority_queue<std::chrono::microseconds, std::vector<std::chrono::microseconds>,
                         std::greater<std::chrono::microseconds>> mWriteDurationPQ;
     const uint8_t kWriteDurationsCount = 5;
+    // Write statistics of the session, see printWriteDurations() and dump().
+    uint64_t mNumWriteCalls;
+    uint64_t mNumBytesWritten;
+    int64_t mTotalWriteDurationUs;
+    uint64_t mNumFallocateCalls;
+    int64_t mTotalFallocateDurationUs;
+    // Writes and fallocates that blocked for at least kIOStallThresholdUs; at that point a
+    // track thread waiting on them starts to drop behind its source.
+    static constexpr int64_t kIOStallThresholdUs = 100000;
+    uint64_t mNumIOStalls;
+    int64_t mTotalIOStallDurationUs;
+
+    // While a chunk is written, its samples and their NAL length prefixes are
+    // gathered into a single writev() instead of a write() each. The prefixes
+    // (and exif offsets) live on the stack of their writer, so they are
+    // copied into mPendingWriteHeaders.
+    enum {
+        kMaxPendingWrites = 64,
+    };
+    bool mBatchWrites;
+    bool mBatchingChunk;
+    struct iovec mPendingWrites[kMaxPendingWrites];
+    size_t mNumPendingWrites;
+    uint8_t mPendingWriteHeaders[kMaxPendingWrites * 4];
+    size_t mPendingWriteHeadersSize;
+
+    // In movie fragment mode (mFragmentDurationUs > 0), a moov without samples is followed
+    // by moof/mdat pairs of about mFragmentDurationUs each. A crash then loses at most the
+    // last fragment, and stop() has no moov to build.
+    int64_t mFragmentDurationUs;
+    int64_t mFragmentStartTimeUs;
+    uint32_t mFragmentSequenceNumber;
+    bool mFragmentMoovWritten;
 
     sp<ALooper> mLooper;
     sp<AHandlerReflector<MPEG4Writer> > mReflector;
@@ -143,6 +180,7 @@ private:
     // Serialize preallocation calls from different track threads.
     std::mutex mFallocMutex;
     bool mPreAllocFirstTime; // Pre-allocate space for file and track headers only once per file.
+    static constexpr off64_t kPreAllocateAheadBytes = 4 * 1024 * 1024;
     uint64_t mPrevAllTracksTotalMetaDataSizeEstimate;
 
     List<Track *> mTracks;
@@ -160,6 +198,7 @@ private:
     int64_t estimateFileLevelMetaSize(MetaData *params);
     void writeCachedBoxToFile(const char *type);
     void printWriteDurations();
+    bool isFragmented() const;
 
     struct Chunk {
         Track               *mTrack;        // Owner
@@ -184,6 +223,8 @@ private:
         // Max time interval between neighboring chunks
         int64_t mMaxInterChunkDurUs;
 
+        // Samples waiting for the next movie fragment, see writeFragment().
+        List<MediaBuffer *> mFragmentSamples;
     };
 
     bool            mIsFirstChunk;
@@ -191,6 +232,7 @@ private:
     pthread_t       mThread;                // Thread id for the writer
     List<ChunkInfo> mChunkInfos;            // Chunk infos
     Condition       mChunkReadyCondition;   // Signal that chunks are available
+    Condition       mChunkWrittenCondition; // Signal that a chunk has been written
 
     // HEIF writing
     typedef key_value_pair_t< const char *, Vector<uint16_t> > ItemRefs;
@@ -264,6 +306,14 @@ private:
     // Actually write the given chunk to the file.
     void writeChunkToFile(Chunk* chunk);
 
+    // In movie fragment mode, hold the samples of the given chunk for the next fragment
+    // and write one out once enough have been gathered.
+    void bufferFragmentChunk(Chunk *chunk);
+
+    // Write the gathered samples as a movie fragment. Return false if there was
+    // nothing to write yet.
+    bool writeFragment(bool last);
+
     // Adjust other track media clock (presumably wall clock)
     // based on audio track media clock with the drift time.
     int64_t mDriftTimeUs;
@@ -299,6 +349,10 @@ private:
             uint32_t tiffHdrOffset, size_t *bytesWritten);
     void addLengthPrefixedSample_l(MediaBuffer *buffer);
     void addMultipleLengthPrefixedSamples_l(MediaBuffer *buffer);
+    // Writes sample data, or queues it while batching a chunk. |buf| must stay
+    // valid until flushSampleData_l() unless it is at most 4 bytes long.
+    void writeSampleData_l(const void *buf, size_t count);
+    void flushSampleData_l();
     uint16_t addProperty_l(const ItemProperty &);
     status_t reserveItemId_l(size_t numItems, uint16_t *itemIdBase);
     uint16_t addItem_l(const ItemInfo &);
@@ -313,6 +367,7 @@ private:
     void writeCompositionMatrix(int32_t degrees);
     void writeMvhdBox(int64_t durationUs);
     void writeMoovBox(int64_t durationUs);
+    void writeFragmentedMoovBox();
     void writeFtypBox(MetaData *param);
     void writeUdtaBox();
     void writeGeoDataBox();
@@ -21,6 +21,7 @@
 #include <media/stagefright/foundation/ABase.h>
 #include <media/stagefright/MediaBuffer.h>
 #include <media/stagefright/MetaData.h>
+#include <utils/List.h>
 #include <utils/threads.h>
 
 namespace android {
@@ -52,23 +53,32 @@ public:
     // Non-inherited functions:
     /////////////////////////////////////////////////
 
-    // pushBuffer() will wait for the read() finish, and read() will have a
-    // deep copy, such that after pushBuffer return, the buffer can be re-used.
+    // pushBuffer() copies the sample into a buffer that read() hands over
+    // to the reader, such that after pushBuffer return, the buffer can be
+    // re-used. It only waits while kMaxQueuedBuffers samples are queued.
     status_t pushBuffer(MediaBuffer *buffer);
 
 private:
+    static constexpr size_t kMaxQueuedBuffers = 8;
+    // How long stop() waits for the reader to take each queued sample.
+    static constexpr nsecs_t kDrainTimeoutNs = 1000000000LL;
+
     Mutex mAdapterLock;
     std::mutex mBufferGatingMutex;
     // Make sure the read() wait for the incoming buffer.
     Condition mBufferReadCond;
-    // Make sure the pushBuffer() wait for the current buffer consumed.
-    Condition mBufferReturnedCond;
+    // Make sure the pushBuffer() wait for room in the queue.
+    Condition mBufferTakenCond;
 
-    MediaBuffer *mCurrentMediaBuffer;
+    List<MediaBuffer *> mQueuedBuffers;
+    // The thread calling read(), which may stop() us without draining.
+    pid_t mReaderTid;
 
     bool mStarted;
     sp<MetaData> mOutputFormat;
 
+    void releaseQueuedBuffers_l();
+
     DISALLOW_EVIL_CONSTRUCTORS(MediaAdapter);
 };
 
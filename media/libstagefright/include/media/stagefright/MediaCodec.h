@@ -97,6 +97,9 @@ struct MediaCodec : public AHandler {
         CONFIGURE_FLAG_USE_BLOCK_MODEL  = 2,
         CONFIGURE_FLAG_USE_CRYPTO_ASYNC = 4,
         CONFIGURE_FLAG_DETACHED_SURFACE = 8,
+        // Report all output buffers that are available at once in a single
+        // CB_OUTPUTS_AVAILABLE callback. Only valid with CONFIGURE_FLAG_USE_BLOCK_MODEL.
+        CONFIGURE_FLAG_BATCH_OUTPUT_CALLBACKS = 16,
     };
 
     enum BufferFlags {
@@ -123,8 +126,24 @@ struct MediaCodec : public AHandler {
         CB_RESOURCE_RECLAIMED = 5,
         CB_CRYPTO_ERROR = 6,
         CB_LARGE_FRAME_OUTPUT_AVAILABLE = 7,
+        // "outputs" is an OutputCallbackInfosWrapper
+        CB_OUTPUTS_AVAILABLE = 8,
     };
 
+    // One output buffer of a CB_OUTPUTS_AVAILABLE callback. The fields are the ones passed with
+    // CB_OUTPUT_AVAILABLE; accessUnitInfo is set where CB_LARGE_FRAME_OUTPUT_AVAILABLE would have
+    // been used.
+    struct OutputCallbackInfo {
+        int32_t index;
+        size_t offset;
+        size_t size;
+        int64_t timeUs;
+        int32_t flags;
+        sp<BufferInfosWrapper> accessUnitInfo;
+    };
+    // MediaCodec::WrapperObject is only declared further below
+    typedef ::android::WrapperObject<std::vector<OutputCallbackInfo>> OutputCallbackInfosWrapper;
+
     static const pid_t kNoPid = -1;
     static const uid_t kNoUid = -1;
 
@@ -417,6 +436,7 @@ private:
         kFlagPushBlankBuffersOnShutdown = 4096,
         kFlagUseBlockModel              = 8192,
         kFlagUseCryptoAsync             = 16384,
+        kFlagBatchOutputCallbacks       = 32768,
     };
 
     struct BufferInfo {
@@ -668,6 +688,8 @@ private:
 
     void onInputBufferAvailable();
     void onOutputBufferAvailable();
+    // onOutputBufferAvailable() with kFlagBatchOutputCallbacks
+    void onOutputBuffersAvailable();
     void onCryptoError(const sp<AMessage> &msg);
     void onError(status_t err, int32_t actionCode, const char *detail = NULL);
     void onOutputFormatChanged();
@@ -738,6 +760,8 @@ private:
 
     void statsBufferSent(int64_t presentationUs, const sp<MediaCodecBuffer> &buffer);
     void statsBufferReceived(int64_t presentationUs, const sp<MediaCodecBuffer> &buffer);
+    void statsFrameReleased(int64_t mediaTimeUs, int64_t renderTimeNs);
+    void statsFrameRendered(int64_t mediaTimeUs, int64_t renderTimeNs);
     bool discardDecodeOnlyOutputBuffer(size_t index);
 
     enum {
@@ -753,13 +777,30 @@ private:
 
         // how we initialize mRecentSamples
         kRecentSampleInvalid = -1,
+
+        // how many released frames we wait on to be rendered
+        kMaxFramesAwaitingRender = 64,
+    };
+
+    // stages of the buffer round trip, in order
+    enum LatencyStage {
+        kLatencyStageInput,     // queueInputBuffer() -> handed to the buffer channel
+        kLatencyStageCodec,     // handed to the buffer channel -> output released by it
+        kLatencyStageOutput,    // output released by the buffer channel -> sent to the client
+        kLatencyStageClient,    // sent to the client -> released by the client
+        kLatencyStageRender,    // released (or requested render time) -> rendered
+        kLatencyStageCount,
     };
+    void statsStageLatency_l(LatencyStage stage, int64_t startNs, int64_t endNs);
 
     int64_t mRecentSamples[kRecentLatencyFrames];
     int mRecentHead;
     Mutex mRecentLock;
 
     MediaHistogram<int64_t> mLatencyHist;
+    // guarded by mLatencyLock
+    MediaHistogram<int64_t> mStageLatencyHist[kLatencyStageCount];
+    std::deque<BufferFlightTiming_t> mFramesAwaitingRender;
 
     // An unique ID for the codec - Used by the metrics.
     uint64_t mCodecId = 0;
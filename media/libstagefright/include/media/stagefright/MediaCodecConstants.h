@@ -829,6 +829,7 @@ inline constexpr char KEY_PRIORITY[] = "priority";
 inline constexpr char KEY_PROFILE[] = "profile";
 inline constexpr char KEY_PUSH_BLANK_BUFFERS_ON_STOP[] = "push-blank-buffers-on-shutdown";
 inline constexpr char KEY_QUALITY[] = "quality";
+inline constexpr char KEY_RENDER_IMMEDIATELY[] = "render-immediately";
 inline constexpr char KEY_REPEAT_PREVIOUS_FRAME_AFTER[] = "repeat-previous-frame-after";
 inline constexpr char KEY_ROTATION[] = "rotation-degrees";
 inline constexpr char KEY_SAMPLE_RATE[] = "sample-rate";
@@ -24,6 +24,8 @@
 #include <utils/Errors.h>
 #include <utils/StrongPointer.h>
 
+#include <string>
+
 namespace android {
 
 /**
@@ -81,6 +83,17 @@ struct MediaCodecListBuilderBase {
      */
     virtual status_t buildMediaCodecList(MediaCodecListWriter* writer) = 0;
 
+    /**
+     * Describe everything that `buildMediaCodecList()` depends on besides the
+     * build fingerprints, e.g. the run-time configuration and the list of
+     * components. `MediaCodecList` reuses a persisted list only if the
+     * fingerprints of all builders are unchanged.
+     *
+     * @return The fingerprint, or an empty string if the list built by this
+     * builder must not be persisted.
+     */
+    virtual std::string getFingerprint() { return std::string(); }
+
     /**
      * The default destructor does nothing.
      */
@@ -26,6 +26,32 @@ namespace android {
 inline constexpr char kCodecPixelFormat[] =
         "android.media.mediacodec.pixel-format";
 
+// Wait and hold times of the CCodec output buffer lock, from start to stop.
+inline constexpr char kCodecOutputLockCount[] =
+        "android.media.mediacodec.output-lock-count";
+inline constexpr char kCodecOutputLockAvgWaitUs[] =
+        "android.media.mediacodec.output-lock-avg-wait-us";
+inline constexpr char kCodecOutputLockMaxWaitUs[] =
+        "android.media.mediacodec.output-lock-max-wait-us";
+inline constexpr char kCodecOutputLockAvgHoldUs[] =
+        "android.media.mediacodec.output-lock-avg-hold-us";
+inline constexpr char kCodecOutputLockMaxHoldUs[] =
+        "android.media.mediacodec.output-lock-max-hold-us";
+
+// Input sizes chosen by the CCodec adaptive input buffer sizing, at stop.
+inline constexpr char kCodecInputSlots[] =
+        "android.media.mediacodec.input-slots";
+inline constexpr char kCodecInputBufferCapacity[] =
+        "android.media.mediacodec.input-buffer-capacity";
+
+// Process-wide statistics of the linear allocation recycler, if enabled.
+inline constexpr char kCodecLinearRecyclerHits[] =
+        "android.media.mediacodec.linear-recycler-hits";
+inline constexpr char kCodecLinearRecyclerMisses[] =
+        "android.media.mediacodec.linear-recycler-misses";
+inline constexpr char kCodecLinearRecyclerEvictions[] =
+        "android.media.mediacodec.linear-recycler-evictions";
+
 }
 
 #endif  // MEDIA_CODEC_METRICS_CONSTANTS_H_
\ No newline at end of file
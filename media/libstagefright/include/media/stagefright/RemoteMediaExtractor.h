@@ -31,7 +31,8 @@ public:
     static sp<IMediaExtractor> wrap(
             MediaExtractor *extractor,
             const sp<DataSource> &source,
-            const sp<RefBase> &plugin);
+            const sp<RefBase> &plugin,
+            int64_t sniffTimeUs = -1);
 
     virtual ~RemoteMediaExtractor();
     virtual size_t countTracks();
@@ -52,10 +53,13 @@ private:
 
     mediametrics::Item *mMetricsItem;
 
+    void updateReadMetrics();
+
     explicit RemoteMediaExtractor(
             MediaExtractor *extractor,
             const sp<DataSource> &source,
-            const sp<RefBase> &plugin);
+            const sp<RefBase> &plugin,
+            int64_t sniffTimeUs);
 
     DISALLOW_EVIL_CONSTRUCTORS(RemoteMediaExtractor);
 };
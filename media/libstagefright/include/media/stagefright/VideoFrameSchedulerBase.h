@@ -33,6 +33,13 @@ struct VideoFrameSchedulerBase : public RefBase {
     void restart();
     // get adjusted nanotime for a video frame render at renderTime
     nsecs_t schedule(nsecs_t renderTime);
+    // report that a frame scheduled for renderTime (as returned by schedule) was presented
+    // at presentTime. If frames are consistently presented late, subsequent frames are
+    // scheduled earlier by whole VSYNCs to compensate for the display pipeline latency.
+    void onFrameRendered(nsecs_t renderTime, nsecs_t presentTime);
+
+    // returns how much earlier frames are scheduled to compensate for display latency
+    nsecs_t getLatencyCorrection();
 
     // returns the vsync period for the main display
     nsecs_t getVsyncPeriod();
@@ -46,6 +53,8 @@ struct VideoFrameSchedulerBase : public RefBase {
     static const nsecs_t kNanosIn1s = 1000000000;
     static const nsecs_t kDefaultVsyncPeriod = kNanosIn1s / 60;  // 60Hz
     static const nsecs_t kVsyncRefreshPeriod = kNanosIn1s;       // 1 sec
+    static const size_t kLatencyWindowSize = 30;                 // frames per latency decision
+    static const int32_t kMaxLatencyVsyncs = 2;
 
 protected:
     virtual ~VideoFrameSchedulerBase();
@@ -92,6 +101,11 @@ private:
     nsecs_t mTimeCorrection;   // running adjustment
     PLL mPll;                  // PLL for video frame rate based on render time
 
+    int32_t mLatencyVsyncs;    // VSYNCs frames are scheduled early to offset display latency
+    size_t mLatencySamples;    // presented frames in the current latency window
+    size_t mLateFrames;        // of which presented at least a VSYNC late
+    size_t mEarlyFrames;       // of which presented at least a VSYNC early
+
     DISALLOW_EVIL_CONSTRUCTORS(VideoFrameSchedulerBase);
 };
 
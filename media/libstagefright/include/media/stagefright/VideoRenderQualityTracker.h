@@ -53,6 +53,10 @@ struct VideoRenderQualityMetrics {
     // The number of frames that were intentionally dropped/skipped by the app.
     int64_t frameSkippedCount;
 
+    // The number of frames rendered later than the configured tolerance after the desired render
+    // time passed in by the app.
+    int64_t frameLateCount;
+
     // The frame rate as detected by looking at the position timestamp from the content stream.
     float contentFrameRate;
 
@@ -210,6 +214,13 @@ public:
         // The maximum distance in time between two judder occurrences such that both will be
         // lumped into the same judder event.
         int32_t judderEventDistanceToleranceMs;
+
+        // Late frame configuration
+        //
+        // A frame rendered more than this after its desired render time is counted as late. A
+        // frame rendered on time may still reach the display up to one refresh after its desired
+        // render time.
+        int32_t lateFrameToleranceUs;
         //
         // Whether or not Perfetto trace trigger is enabled.
         bool traceTriggerEnabled;
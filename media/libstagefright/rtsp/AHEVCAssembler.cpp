@@ -43,6 +43,13 @@ namespace android {
 
 const double JITTER_MULTIPLE = 1.5f;
 
+// Whether |buffer| continues the NAL unit before it in mNALUnits, without a
+// start code of its own.
+static bool IsNALFragment(const sp<ABuffer> &buffer) {
+    int32_t fragment;
+    return buffer->meta()->findInt32("nal-fragment", &fragment) && fragment;
+}
+
 // static
 AHEVCAssembler::AHEVCAssembler(const sp<AMessage> &notify)
     : mNotifyMsg(notify),
@@ -340,7 +347,8 @@ bool AHEVCAssembler::dropFramesUntilIframe(const sp<ABuffer> &buffer) {
     return !mFirstIFrameProvided && nalType < 0x10;
 }
 
-void AHEVCAssembler::addSingleNALUnit(const sp<ABuffer> &buffer) {
+void AHEVCAssembler::addSingleNALUnit(
+        const sp<ABuffer> &buffer, const List<sp<ABuffer> > &fragments) {
     ALOGV("addSingleNALUnit of size %zu", buffer->size());
 #if !LOG_NDEBUG
     hexdump(buffer->data(), buffer->size());
@@ -368,6 +376,10 @@ void AHEVCAssembler::addSingleNALUnit(const sp<ABuffer> &buffer) {
     mAccessUnitRTPTime = rtpTime;
 
     mNALUnits.push_back(buffer);
+    for (List<sp<ABuffer> >::const_iterator it = fragments.begin();
+         it != fragments.end(); ++it) {
+        mNALUnits.push_back(*it);
+    }
 }
 
 bool AHEVCAssembler::addSingleTimeAggregationPacket(const sp<ABuffer> &buffer) {
@@ -526,20 +538,25 @@ ARTPAssembler::AssemblyStatus AHEVCAssembler::addFragmentedNALUnit(
 
     // We found all the fragments that make up the complete NAL unit.
 
-    // Leave room for the header. So far totalSize did not include the
-    // header byte.
-    totalSize += 2;
-
-    sp<ABuffer> unit = new ABuffer(totalSize);
-    CopyTimes(unit, *queue->begin());
-
-    unit->data()[0] = (nalType << 1);
-    unit->data()[1] = tid;
+    // The first fragment becomes the head of the unit in place, with the NAL
+    // header written over its FU headers, and the others are trimmed to their
+    // payload. They are only copied once, into the access unit.
+    sp<ABuffer> unit = *queue->begin();
+    queue->erase(queue->begin());
+#if !LOG_NDEBUG
+    ALOGV("piece #1/%zu", totalCount);
+    hexdump(unit->data(), unit->size());
+#endif
+    unit->data()[1] = (nalType << 1);
+    unit->data()[2] = tid;
+    unit->setRange(unit->offset() + 1, unit->size() - 1);
 
-    size_t offset = 2;
     int32_t cvo = -1;
+    unit->meta()->findInt32("cvo", &cvo);
+
+    List<sp<ABuffer> > fragments;
     List<sp<ABuffer> >::iterator it = queue->begin();
-    for (size_t i = 0; i < totalCount; ++i) {
+    for (size_t i = 1; i < totalCount; ++i) {
         const sp<ABuffer> &buffer = *it;
 
         ALOGV("piece #%zu/%zu", i + 1, totalCount);
@@ -547,14 +564,32 @@ ARTPAssembler::AssemblyStatus AHEVCAssembler::addFragmentedNALUnit(
         hexdump(buffer->data(), buffer->size());
 #endif
 
-        memcpy(unit->data() + offset, buffer->data() + 3, buffer->size() - 3);
         buffer->meta()->findInt32("cvo", &cvo);
-        offset += buffer->size() - 3;
+        buffer->setRange(buffer->offset() + 3, buffer->size() - 3);
+        buffer->meta()->setInt32("nal-fragment", true);
+        fragments.push_back(buffer);
 
         it = queue->erase(it);
     }
 
-    unit->setRange(0, totalSize);
+    if (nalType == H265_NALU_SPS && !fragments.empty()) {
+        // The SPS is parsed for the resolution, so it is kept contiguous.
+        // So far totalSize did not include the header.
+        sp<ABuffer> sps = new ABuffer(totalSize + 2);
+        CopyTimes(sps, unit);
+
+        memcpy(sps->data(), unit->data(), unit->size());
+        size_t offset = unit->size();
+        for (List<sp<ABuffer> >::iterator frag = fragments.begin();
+             frag != fragments.end(); ++frag) {
+            memcpy(sps->data() + offset, (*frag)->data(), (*frag)->size());
+            offset += (*frag)->size();
+        }
+        sps->setRange(0, offset);
+
+        unit = sps;
+        fragments.clear();
+    }
 
     if (cvo >= 0) {
         unit->meta()->setInt32("cvo", cvo);
@@ -563,7 +598,7 @@ ARTPAssembler::AssemblyStatus AHEVCAssembler::addFragmentedNALUnit(
         unit->meta()->setInt32("cvo", mLastCvo);
     }
 
-    addSingleNALUnit(unit);
+    addSingleNALUnit(unit, fragments);
 
     ALOGV("successfully assembled a NAL unit from fragments.");
 
@@ -578,7 +613,7 @@ void AHEVCAssembler::submitAccessUnit() {
     size_t totalSize = 0;
     for (List<sp<ABuffer> >::iterator it = mNALUnits.begin();
          it != mNALUnits.end(); ++it) {
-        totalSize += 4 + (*it)->size();
+        totalSize += (IsNALFragment(*it) ? 0 : 4) + (*it)->size();
     }
 
     sp<ABuffer> accessUnit = new ABuffer(totalSize);
@@ -586,10 +621,12 @@ void AHEVCAssembler::submitAccessUnit() {
     int32_t cvo = -1;
     for (List<sp<ABuffer> >::iterator it = mNALUnits.begin();
          it != mNALUnits.end(); ++it) {
-        memcpy(accessUnit->data() + offset, "\x00\x00\x00\x01", 4);
-        offset += 4;
-
         sp<ABuffer> nal = *it;
+        if (!IsNALFragment(nal)) {
+            memcpy(accessUnit->data() + offset, "\x00\x00\x00\x01", 4);
+            offset += 4;
+        }
+
         memcpy(accessUnit->data() + offset, nal->data(), nal->size());
         offset += nal->size();
         nal->meta()->findInt32("cvo", &cvo);
@@ -341,8 +341,11 @@ static bool ExtractDimensionsMPEG4Config(
     size_t offset = 0;
     bool foundVOL = false;
     while (offset + 3 < config->size()) {
-        if (memcmp("\x00\x00\x01", &ptr[offset], 3)
-                || (ptr[offset + 3] & 0xf0) != 0x20) {
+        offset += findNextStartCode(&ptr[offset], config->size() - offset);
+        if (offset + 3 >= config->size()) {
+            break;
+        }
+        if ((ptr[offset + 3] & 0xf0) != 0x20) {
             ++offset;
             continue;
         }
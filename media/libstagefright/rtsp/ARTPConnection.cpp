@@ -38,12 +38,23 @@
 #include <android/multinetwork.h>
 
 #include <arpa/inet.h>
+#include <inttypes.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 
 namespace android {
 
 static const size_t kMaxUDPSize = 1500;
 
+// Datagrams received per recvmmsg() call, and the size of each receive buffer,
+// large enough for any UDP datagram.
+static const size_t kReceiveBatchSize = 8;
+static const size_t kMaxDatagramSize = 65536;
+
+// Room for the TOS/traffic class and the SO_RXQ_OVFL drop count.
+static const size_t kReceiveControlSize =
+        CMSG_SPACE(sizeof(struct cmsghdr) + sizeof(uint8_t)) + CMSG_SPACE(sizeof(uint32_t));
+
 static uint16_t u16at(const uint8_t *data) {
     return data[0] << 8 | data[1];
 }
@@ -61,8 +72,9 @@ static uint64_t u64at(const uint8_t *data) {
 }
 
 // static
-const int64_t ARTPConnection::kSelectTimeoutUs = 1000LL;
+const int64_t ARTPConnection::kPollTimeoutUs = 1000LL;
 const int64_t ARTPConnection::kMinOneSecondNotifyDelayUs = 100000ll;
+const int64_t ARTPConnection::kStatsReportIntervalUs = 10000000ll;
 
 struct ARTPConnection::StreamInfo {
     bool isIPv6;
@@ -75,6 +87,17 @@ struct ARTPConnection::StreamInfo {
 
     int64_t mNumRTCPPacketsReceived;
     int64_t mNumRTPPacketsReceived;
+
+    // Datagrams received on either socket, those that could not be parsed,
+    // and those the sockets dropped because their receive queue was full.
+    int64_t mNumDatagramsReceived;
+    int64_t mNumDatagramsMalformed;
+    uint32_t mNumRTPSocketDrops;
+    uint32_t mNumRTCPSocketDrops;
+    // The same counters at the last stats report.
+    int64_t mLastReportNumDatagramsReceived;
+    uint32_t mLastReportNumSocketDrops;
+
     struct sockaddr_in mRemoteRTCPAddr;
     struct sockaddr_in6 mRemoteRTCPAddr6;
 
@@ -95,10 +118,15 @@ ARTPConnection::ARTPConnection(uint32_t flags)
       mTargetBitrate(-1),
       mRtpSockOptEcn(0),
       mIsIPv6(false),
-      mStaticJitterTimeMs(kStaticJitterTimeMs) {
+      mStaticJitterTimeMs(kStaticJitterTimeMs),
+      mLastStatsReportTimeUs(-1) {
+    mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+    CHECK_GE(mEpollFd, 0);
 }
 
 ARTPConnection::~ARTPConnection() {
+    close(mEpollFd);
+    mEpollFd = -1;
 }
 
 void ARTPConnection::addStream(
@@ -381,6 +409,12 @@ void ARTPConnection::onAddStream(const sp<AMessage> &msg) {
 
     info->mNumRTCPPacketsReceived = 0;
     info->mNumRTPPacketsReceived = 0;
+    info->mNumDatagramsReceived = 0;
+    info->mNumDatagramsMalformed = 0;
+    info->mNumRTPSocketDrops = 0;
+    info->mNumRTCPSocketDrops = 0;
+    info->mLastReportNumDatagramsReceived = 0;
+    info->mLastReportNumSocketDrops = 0;
     memset(&info->mRemoteRTCPAddr, 0, sizeof(info->mRemoteRTCPAddr));
     memset(&info->mRemoteRTCPAddr6, 0, sizeof(info->mRemoteRTCPAddr6));
 
@@ -397,6 +431,7 @@ void ARTPConnection::onAddStream(const sp<AMessage> &msg) {
     }
 
     if (!injected) {
+        addPolledSockets(info);
         postPollEvent();
     }
 }
@@ -428,9 +463,38 @@ void ARTPConnection::onRemoveStream(const sp<AMessage> &msg) {
         return;
     }
 
+    if (!it->mIsInjected) {
+        removePolledSockets(&*it);
+    }
     mStreams.erase(it);
 }
 
+void ARTPConnection::addPolledSockets(const StreamInfo *info) {
+    int sockets[] = { info->mRTPSocket, info->mRTCPSocket };
+    for (int s : sockets) {
+        // Have the kernel report the datagrams dropped by a full receive queue.
+        int enable = 1;
+        if (setsockopt(s, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable)) < 0) {
+            ALOGV("failed to enable SO_RXQ_OVFL (%s)", strerror(errno));
+        }
+
+        struct epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = s;
+        if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, s, &event) < 0
+                && (errno != EEXIST || epoll_ctl(mEpollFd, EPOLL_CTL_MOD, s, &event) < 0)) {
+            ALOGE("failed to poll socket %d (%s)", s, strerror(errno));
+        }
+    }
+}
+
+void ARTPConnection::removePolledSockets(const StreamInfo *info) {
+    // This fails harmlessly if the owner already closed the sockets,
+    // which removes them from the epoll set as well.
+    epoll_ctl(mEpollFd, EPOLL_CTL_DEL, info->mRTPSocket, NULL);
+    epoll_ctl(mEpollFd, EPOLL_CTL_DEL, info->mRTCPSocket, NULL);
+}
+
 void ARTPConnection::postPollEvent() {
     if (mPollEventPending) {
         return;
@@ -449,37 +513,35 @@ void ARTPConnection::onPollStreams() {
         return;
     }
 
-    struct timeval tv;
-    tv.tv_sec = 0;
-    tv.tv_usec = kSelectTimeoutUs;
-
-    fd_set rs;
-    FD_ZERO(&rs);
-
-    int maxSocket = -1;
+    size_t numPolledStreams = 0;
     for (List<StreamInfo>::iterator it = mStreams.begin();
          it != mStreams.end(); ++it) {
-        if ((*it).mIsInjected) {
-            continue;
-        }
-
-        FD_SET(it->mRTPSocket, &rs);
-        FD_SET(it->mRTCPSocket, &rs);
-
-        if (it->mRTPSocket > maxSocket) {
-            maxSocket = it->mRTPSocket;
-        }
-        if (it->mRTCPSocket > maxSocket) {
-            maxSocket = it->mRTCPSocket;
+        if (!(*it).mIsInjected) {
+            ++numPolledStreams;
         }
     }
 
-    if (maxSocket == -1) {
+    if (numPolledStreams == 0) {
         return;
     }
 
+    // Two sockets per stream; whatever doesn't fit is reported next time.
+    struct epoll_event events[16];
     int64_t nowUs = ALooper::GetNowUs();
-    int res = select(maxSocket + 1, &rs, NULL, NULL, &tv);
+    int res;
+    do {
+        res = epoll_wait(mEpollFd, events, sizeof(events) / sizeof(events[0]),
+                kPollTimeoutUs / 1000);
+    } while (res < 0 && errno == EINTR);
+
+    auto isReady = [&events, res](int s) {
+        for (int i = 0; i < res; ++i) {
+            if (events[i].data.fd == s) {
+                return true;
+            }
+        }
+        return false;
+    };
 
     if (res > 0) {
         List<StreamInfo>::iterator it = mStreams.begin();
@@ -491,10 +553,10 @@ void ARTPConnection::onPollStreams() {
             it->mLastPollTimeUs = nowUs;
 
             status_t err = OK;
-            if (FD_ISSET(it->mRTPSocket, &rs)) {
+            if (isReady(it->mRTPSocket)) {
                 err = receive(&*it, true);
             }
-            if (err == OK && FD_ISSET(it->mRTCPSocket, &rs)) {
+            if (err == OK && isReady(it->mRTCPSocket)) {
                 err = receive(&*it, false);
             }
 
@@ -510,6 +572,7 @@ void ARTPConnection::onPollStreams() {
 
                     ALOGW("failed to receive RTP/RTCP datagram.");
                 }
+                removePolledSockets(&*it);
                 it = mStreams.erase(it);
                 continue;
             }
@@ -551,6 +614,7 @@ void ARTPConnection::onPollStreams() {
     }
 
     checkRxBitrate(nowUs);
+    reportStreamStats(nowUs);
 
     if (mLastReceiverReportTimeUs <= 0
             || mLastReceiverReportTimeUs + 5000000LL <= nowUs) {
@@ -619,31 +683,42 @@ status_t ARTPConnection::receive(StreamInfo *s, bool receiveRTP) {
 
     CHECK(!s->mIsInjected);
 
-    sp<ABuffer> buffer = new ABuffer(65536);
-
-    struct msghdr sMsg = {};
-    struct iovec sIov[1] = {};
-
-    sIov[0].iov_base = (char *) buffer->data();
-    sIov[0].iov_len = buffer->capacity();
-
-    sMsg.msg_iov = sIov;
-    sMsg.msg_iovlen = 1;
+    if (mReceiveBuffers.empty()) {
+        for (size_t i = 0; i < kReceiveBatchSize; ++i) {
+            mReceiveBuffers.push(new ABuffer(kMaxDatagramSize));
+        }
+    }
 
-    int cMsgSize = sizeof(struct cmsghdr) + sizeof(uint8_t);
-    char buf[CMSG_SPACE(cMsgSize)];
-    sMsg.msg_control = buf;
-    sMsg.msg_controllen = sizeof(buf);
-    sMsg.msg_flags = 0;
+    struct mmsghdr sMsgs[kReceiveBatchSize] = {};
+    struct iovec sIovs[kReceiveBatchSize] = {};
+    alignas(struct cmsghdr) char control[kReceiveBatchSize][kReceiveControlSize];
+
+    for (size_t i = 0; i < kReceiveBatchSize; ++i) {
+        sIovs[i].iov_base = (char *) mReceiveBuffers[i]->data();
+        sIovs[i].iov_len = mReceiveBuffers[i]->capacity();
+
+        struct msghdr *sMsg = &sMsgs[i].msg_hdr;
+        sMsg->msg_iov = &sIovs[i];
+        sMsg->msg_iovlen = 1;
+        // Used to get the TOS header of incoming packets
+        sMsg->msg_control = control[i];
+        sMsg->msg_controllen = sizeof(control[i]);
+        sMsg->msg_flags = 0;
+    }
 
-    ssize_t nbytes;
+    int numMsgs;
     do {
-        // Used recvmsg to get the TOS header of incoming packet
-        nbytes = recvmsg(receiveRTP ? s->mRTPSocket : s->mRTCPSocket, &sMsg, 0);
-        mCumulativeBytes += nbytes;
-    } while (nbytes < 0 && errno == EINTR);
+        // Only takes what is already queued, so that a busy stream doesn't
+        // hold up the others; the rest is picked up at the next poll.
+        numMsgs = recvmmsg(receiveRTP ? s->mRTPSocket : s->mRTCPSocket,
+                sMsgs, kReceiveBatchSize, MSG_DONTWAIT, NULL);
+    } while (numMsgs < 0 && errno == EINTR);
+
+    if (numMsgs < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return OK;
+    }
 
-    if (nbytes <= 0) {
+    if (numMsgs <= 0) {
         ALOGW("failed to recv rtp packet. cause=%s", strerror(errno));
         // ECONNREFUSED may happen in next recvfrom() calling if one of
         // outgoing packet can not be delivered to remote by using sendto()
@@ -654,22 +729,51 @@ status_t ARTPConnection::receive(StreamInfo *s, bool receiveRTP) {
         }
     }
 
-    if (nbytes > 0) {
+    for (int i = 0; i < numMsgs; ++i) {
+        struct msghdr &sMsg = sMsgs[i].msg_hdr;
+        size_t nbytes = sMsgs[i].msg_len;
+        mCumulativeBytes += nbytes;
+        ++s->mNumDatagramsReceived;
+
+        for (struct cmsghdr *cMsg = CMSG_FIRSTHDR(&sMsg); cMsg != NULL;
+                cMsg = CMSG_NXTHDR(&sMsg, cMsg)) {
+            if (cMsg->cmsg_level == SOL_SOCKET && cMsg->cmsg_type == SO_RXQ_OVFL) {
+                uint32_t drops = *((uint32_t *) CMSG_DATA(cMsg));
+                if (receiveRTP) {
+                    s->mNumRTPSocketDrops = drops;
+                } else {
+                    s->mNumRTCPSocketDrops = drops;
+                }
+            }
+        }
+
+        if (nbytes == 0 || (sMsg.msg_flags & MSG_TRUNC)) {
+            ++s->mNumDatagramsMalformed;
+            continue;
+        }
+
         handleIpHeadersIfReceived(s, sMsg);
-    }
 
-    buffer->setRange(0, nbytes);
+        // The receive buffers are reused, and the packet may be queued for a
+        // while by its source, so it gets a buffer of its own size.
+        sp<ABuffer> buffer = new ABuffer(nbytes);
+        memcpy(buffer->data(), mReceiveBuffers[i]->data(), nbytes);
 
-    // ALOGI("received %d bytes.", buffer->size());
+        // ALOGI("received %d bytes.", buffer->size());
 
-    status_t err;
-    if (receiveRTP) {
-        err = parseRTP(s, buffer);
-    } else {
-        err = parseRTCP(s, buffer);
+        status_t err;
+        if (receiveRTP) {
+            err = parseRTP(s, buffer);
+        } else {
+            err = parseRTCP(s, buffer);
+        }
+
+        if (err != OK) {
+            ++s->mNumDatagramsMalformed;
+        }
     }
 
-    return err;
+    return OK;
 }
 
 /* This function will check if TOS is present or not in received IP packet.
@@ -1363,6 +1467,46 @@ void ARTPConnection::checkRxBitrate(int64_t nowUs) {
         mLastEarlyNotifyTimeUs = nowUs;
     }
 }
+
+void ARTPConnection::reportStreamStats(int64_t nowUs) {
+    if (mLastStatsReportTimeUs <= 0) {
+        mLastStatsReportTimeUs = nowUs;
+        return;
+    }
+    if (mLastStatsReportTimeUs + kStatsReportIntervalUs > nowUs) {
+        return;
+    }
+
+    int64_t elapsedUs = nowUs - mLastStatsReportTimeUs;
+    mLastStatsReportTimeUs = nowUs;
+
+    for (List<StreamInfo>::iterator it = mStreams.begin(); it != mStreams.end(); ++it) {
+        StreamInfo *s = &*it;
+        if (s->mIsInjected) {
+            continue;
+        }
+
+        int64_t numReceived = s->mNumDatagramsReceived - s->mLastReportNumDatagramsReceived;
+        uint32_t numSocketDrops = s->mNumRTPSocketDrops + s->mNumRTCPSocketDrops;
+        bool dropped = numSocketDrops != s->mLastReportNumSocketDrops;
+
+        // Only worth a log by default when the sockets couldn't keep up.
+        if (dropped) {
+            ALOGI("stream %zu: %.1f packets/sec, %" PRId64 " received, %" PRId64 " malformed, "
+                    "%u dropped by the sockets (%u since last report)",
+                    s->mIndex, numReceived * 1E6 / elapsedUs, s->mNumDatagramsReceived,
+                    s->mNumDatagramsMalformed, numSocketDrops,
+                    numSocketDrops - s->mLastReportNumSocketDrops);
+        } else {
+            ALOGV("stream %zu: %.1f packets/sec, %" PRId64 " received, %" PRId64 " malformed",
+                    s->mIndex, numReceived * 1E6 / elapsedUs, s->mNumDatagramsReceived,
+                    s->mNumDatagramsMalformed);
+        }
+
+        s->mLastReportNumDatagramsReceived = s->mNumDatagramsReceived;
+        s->mLastReportNumSocketDrops = numSocketDrops;
+    }
+}
 void ARTPConnection::onInjectPacket(const sp<AMessage> &msg) {
     int32_t index;
     CHECK(msg->findInt32("index", &index));
@@ -340,9 +340,16 @@ bool ARTPSource::queuePacket(const sp<ABuffer> &buffer) {
 
     buffer->setInt32Data(seqNum);
 
-    List<sp<ABuffer> >::iterator it = mQueue.begin();
-    while (it != mQueue.end() && (uint32_t)(*it)->int32Data() < seqNum) {
-        ++it;
+    // Packets mostly arrive in order, so look for the insertion point from
+    // the back of the queue rather than walking all the packets queued for
+    // the jitter buffer.
+    List<sp<ABuffer> >::iterator it = mQueue.end();
+    while (it != mQueue.begin()) {
+        List<sp<ABuffer> >::iterator prev = it;
+        if ((uint32_t)(*--prev)->int32Data() < seqNum) {
+            break;
+        }
+        it = prev;
     }
 
     if (it != mQueue.end() && (uint32_t)(*it)->int32Data() == seqNum) {
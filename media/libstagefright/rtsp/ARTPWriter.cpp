@@ -31,8 +31,11 @@
 #include <utils/ByteOrder.h>
 
 #include <fcntl.h>
+#include <inttypes.h>
 #include <strings.h>
 
+#include <algorithm>
+
 #define PT      97
 #define PT_STR  "97"
 
@@ -68,6 +71,18 @@ static char kCNAME[255] = "someone@somewhere";
 static const size_t kTrafficRecorderMaxEntries = 128;
 static const size_t kTrafficRecorderMaxTimeSpanMs = 2000;
 
+// RTP packets sent per sendmmsg() call.
+static const size_t kSendBatchSize = 16;
+// Packets are paced at this multiple of the bitrate of the last TMMBN, so that
+// a large frame goes out in short bursts instead of flooding the link queues.
+static const double kPacingFactor = 2.5;
+// Depth of the pacer's token bucket, in time at the pacing rate.
+static const int64_t kPacingBurstUs = 5000ll;
+// Pacing never holds a frame back longer than this, so that a bitrate set too
+// low can't make the writer fall behind the encoder.
+static const int64_t kMaxPacingDelayUs = 20000ll;
+static const int64_t kSendStatsIntervalUs = 10000000ll;
+
 static int UniformRand(int limit) {
     return ((double)rand() * limit) / RAND_MAX;
 }
@@ -109,6 +124,8 @@ ARTPWriter::ARTPWriter(int fd)
     mSPSBuf = NULL;
     mPPSBuf = NULL;
 
+    initSendQueue();
+
 #if LOG_TO_FILES
     mRTPFd = open(
             "/data/misc/rtpout.bin",
@@ -144,6 +161,8 @@ ARTPWriter::ARTPWriter(int fd, String8& localIp, int localPort, String8& remoteI
     mSPSBuf = NULL;
     mPPSBuf = NULL;
 
+    initSendQueue();
+
     initState();
     mSeqNo = seqNo;     // Must use explicit # of seq for RTP continuity
 
@@ -196,6 +215,27 @@ ARTPWriter::~ARTPWriter() {
     mFd = -1;
 }
 
+void ARTPWriter::initSendQueue() {
+    for (size_t i = 0; i < kSendBatchSize; ++i) {
+        mRTPQueue.push(new ABuffer(kMaxPacketSize));
+        mRTPQueueTimesUs.push(0);
+    }
+    mNumQueuedRTP = 0;
+
+    mPacingEnabled = false;
+    mPacingTokens = 0;
+    mLastPacingTimeUs = -1;
+    mFramePacingDelayUs = 0;
+
+    mLastSendStatsTimeUs = -1;
+    mNumRTPBatchesSent = 0;
+    mNumRTPPacketsSent = 0;
+    mTotalSendLatencyUs = 0;
+    mMaxSendLatencyUs = 0;
+    mTotalSendCallUs = 0;
+    mTotalPacingDelayUs = 0;
+}
+
 void ARTPWriter::initState() {
     if (mSourceID == 0)
         mSourceID = rand();
@@ -564,6 +604,7 @@ void ARTPWriter::onMessageReceived(const sp<AMessage> &msg) {
 void ARTPWriter::setTMMBNInfo(uint32_t opponentID, uint32_t bitrate) {
     mOpponentID = opponentID;
     mBitrate = bitrate;
+    mPacingEnabled = bitrate > 0;
 
     sp<ABuffer> buffer = new ABuffer(65536);
     buffer->setRange(0, 0);
@@ -605,6 +646,8 @@ void ARTPWriter::onRead(const sp<AMessage> &msg) {
         } else if (mMode == AMR_NB || mMode == AMR_WB) {
             sendAMRData(mediaBuf);
         }
+
+        flushRTP(true /* endOfFrame */);
     }
 
     mediaBuf->release();
@@ -626,23 +669,53 @@ void ARTPWriter::onSendSR(const sp<AMessage> &msg) {
     msg->post(3000000);
 }
 
-void ARTPWriter::send(const sp<ABuffer> &buffer, bool isRTCP) {
-    int sizeSockSt;
-    struct sockaddr *remAddr;
-
+struct sockaddr *ARTPWriter::getRemoteAddr(bool isRTCP, int *sizeSockSt) {
     if (mIsIPv6) {
-        sizeSockSt = sizeof(struct sockaddr_in6);
+        *sizeSockSt = sizeof(struct sockaddr_in6);
         if (isRTCP)
-            remAddr = (struct sockaddr *)&mRTCPAddr6;
+            return (struct sockaddr *)&mRTCPAddr6;
         else
-            remAddr = (struct sockaddr *)&mRTPAddr6;
+            return (struct sockaddr *)&mRTPAddr6;
     } else {
-        sizeSockSt = sizeof(struct sockaddr_in);
+        *sizeSockSt = sizeof(struct sockaddr_in);
         if (isRTCP)
-            remAddr = (struct sockaddr *)&mRTCPAddr;
+            return (struct sockaddr *)&mRTCPAddr;
         else
-            remAddr = (struct sockaddr *)&mRTPAddr;
+            return (struct sockaddr *)&mRTPAddr;
     }
+}
+
+void ARTPWriter::send(const sp<ABuffer> &buffer, bool isRTCP) {
+#if LOG_TO_FILES
+    int fd = isRTCP ? mRTCPFd : mRTPFd;
+
+    uint32_t ms = tolel(ALooper::GetNowUs() / 1000ll);
+    uint32_t length = tolel(buffer->size());
+    write(fd, &ms, sizeof(ms));
+    write(fd, &length, sizeof(length));
+    write(fd, buffer->data(), buffer->size());
+#endif
+
+    if (!isRTCP && buffer->size() <= kMaxPacketSize) {
+        // The packetizers reuse |buffer| for the next packet, keep a copy.
+        const sp<ABuffer> &queued = mRTPQueue[mNumQueuedRTP];
+        memcpy(queued->data(), buffer->data(), buffer->size());
+        queued->setRange(0, buffer->size());
+        mRTPQueueTimesUs.editItemAt(mNumQueuedRTP) = ALooper::GetNowUs();
+
+        if (++mNumQueuedRTP == kSendBatchSize) {
+            flushRTP(false /* endOfFrame */);
+        }
+        return;
+    }
+
+    if (!isRTCP) {
+        // Keep the packets in order.
+        flushRTP(false /* endOfFrame */);
+    }
+
+    int sizeSockSt;
+    struct sockaddr *remAddr = getRemoteAddr(isRTCP, &sizeSockSt);
 
     // Unseal code if moderator is needed (prevent overflow of instant bandwidth)
     // Set limit bits per period through the moderator.
@@ -660,16 +733,127 @@ void ARTPWriter::send(const sp<ABuffer> &buffer, bool isRTCP) {
                 (mIsIPv6 ? TCPIPV6_HEADER_SIZE : TCPIPV4_HEADER_SIZE));
         mTrafficRec->printAccuBitsForLastPeriod(1000, 1000);
     }
+}
 
-#if LOG_TO_FILES
-    int fd = isRTCP ? mRTCPFd : mRTPFd;
+void ARTPWriter::flushRTP(bool endOfFrame) {
+    if (mNumQueuedRTP > 0) {
+        int sizeSockSt;
+        struct sockaddr *remAddr = getRemoteAddr(false /* isRTCP */, &sizeSockSt);
+
+        struct mmsghdr msgs[kSendBatchSize] = {};
+        struct iovec iovs[kSendBatchSize];
+        size_t bytes = 0;
+        for (size_t i = 0; i < mNumQueuedRTP; ++i) {
+            iovs[i].iov_base = mRTPQueue[i]->data();
+            iovs[i].iov_len = mRTPQueue[i]->size();
+            msgs[i].msg_hdr.msg_name = remAddr;
+            msgs[i].msg_hdr.msg_namelen = sizeSockSt;
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            bytes += mRTPQueue[i]->size();
+        }
 
-    uint32_t ms = tolel(ALooper::GetNowUs() / 1000ll);
-    uint32_t length = tolel(buffer->size());
-    write(fd, &ms, sizeof(ms));
-    write(fd, &length, sizeof(length));
-    write(fd, buffer->data(), buffer->size());
-#endif
+        waitForPacingTokens(bytes);
+
+        size_t numSent = 0;
+        while (numSent < mNumQueuedRTP) {
+            int64_t startUs = ALooper::GetNowUs();
+            int n = sendmmsg(mRTPSocket, &msgs[numSent], mNumQueuedRTP - numSent, 0);
+            int64_t nowUs = ALooper::GetNowUs();
+            if (n <= 0) {
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                ALOGW("packets can not be sent. ret=%d, cause=%s, %zu packets dropped",
+                        n, strerror(errno), mNumQueuedRTP - numSent);
+                break;
+            }
+
+            ++mNumRTPBatchesSent;
+            mTotalSendCallUs += nowUs - startUs;
+            for (int i = 0; i < n; ++i, ++numSent) {
+                // Record current traffic & Print bits while last 1sec (1000ms)
+                mTrafficRec->writeBytes(mRTPQueue[numSent]->size() +
+                        (mIsIPv6 ? TCPIPV6_HEADER_SIZE : TCPIPV4_HEADER_SIZE));
+
+                int64_t latencyUs = nowUs - mRTPQueueTimesUs[numSent];
+                mTotalSendLatencyUs += latencyUs;
+                if (latencyUs > mMaxSendLatencyUs) {
+                    mMaxSendLatencyUs = latencyUs;
+                }
+                ++mNumRTPPacketsSent;
+            }
+        }
+        mTrafficRec->printAccuBitsForLastPeriod(1000, 1000);
+        mNumQueuedRTP = 0;
+    }
+
+    if (endOfFrame) {
+        mFramePacingDelayUs = 0;
+        reportSendStats(ALooper::GetNowUs());
+    }
+}
+
+void ARTPWriter::waitForPacingTokens(size_t bytes) {
+    int64_t bytesPerSec = mBitrate * kPacingFactor / 8;
+    if (!mPacingEnabled || bytesPerSec <= 0) {
+        return;
+    }
+
+    // Deep enough for a full batch, or it would never be sent without delay.
+    int64_t depth = std::max<int64_t>(bytesPerSec * kPacingBurstUs / 1000000ll,
+            (int64_t)(kSendBatchSize * kMaxPacketSize));
+
+    int64_t nowUs = ALooper::GetNowUs();
+    if (mLastPacingTimeUs < 0) {
+        mPacingTokens = depth;
+    } else {
+        mPacingTokens = std::min<int64_t>(depth,
+                mPacingTokens + (nowUs - mLastPacingTimeUs) * bytesPerSec / 1000000ll);
+    }
+    mLastPacingTimeUs = nowUs;
+
+    if (mPacingTokens < (int64_t)bytes && mFramePacingDelayUs < kMaxPacingDelayUs) {
+        int64_t delayUs = std::min<int64_t>(
+                ((int64_t)bytes - mPacingTokens) * 1000000ll / bytesPerSec + 1,
+                kMaxPacingDelayUs - mFramePacingDelayUs);
+        usleep(delayUs);
+
+        nowUs = ALooper::GetNowUs();
+        mPacingTokens = std::min<int64_t>(depth,
+                mPacingTokens + (nowUs - mLastPacingTimeUs) * bytesPerSec / 1000000ll);
+        mLastPacingTimeUs = nowUs;
+        mFramePacingDelayUs += delayUs;
+        mTotalPacingDelayUs += delayUs;
+    }
+
+    // Goes into debt when pacing gave up on a frame, but not for long.
+    mPacingTokens = std::max<int64_t>(mPacingTokens - (int64_t)bytes, -depth);
+}
+
+void ARTPWriter::reportSendStats(int64_t nowUs) {
+    if (mLastSendStatsTimeUs < 0) {
+        mLastSendStatsTimeUs = nowUs;
+        return;
+    }
+    if (mLastSendStatsTimeUs + kSendStatsIntervalUs > nowUs || mNumRTPPacketsSent == 0) {
+        return;
+    }
+
+    ALOGD("sent %u RTP packets in %u batches: latency avg %" PRId64 " us, max %" PRId64 " us, "
+            "avg %" PRId64 " us per batch, paced for %" PRId64 " ms",
+            mNumRTPPacketsSent, mNumRTPBatchesSent,
+            mTotalSendLatencyUs / mNumRTPPacketsSent, mMaxSendLatencyUs,
+            mTotalSendCallUs / std::max(mNumRTPBatchesSent, 1u),
+            mTotalPacingDelayUs / 1000);
+
+    mLastSendStatsTimeUs = nowUs;
+    mNumRTPBatchesSent = 0;
+    mNumRTPPacketsSent = 0;
+    mTotalSendLatencyUs = 0;
+    mMaxSendLatencyUs = 0;
+    mTotalSendCallUs = 0;
+    mTotalPacingDelayUs = 0;
 }
 
 void ARTPWriter::addSR(const sp<ABuffer> &buffer) {
@@ -59,7 +59,10 @@ private:
     void checkIFrameProvided(const sp<ABuffer> &buffer);
     bool dropFramesUntilIframe(const sp<ABuffer> &buffer);
     AssemblyStatus addNALUnit(const sp<ARTPSource> &source);
-    void addSingleNALUnit(const sp<ABuffer> &buffer);
+    // |fragments| are the rest of |buffer|'s NAL unit, without start codes.
+    void addSingleNALUnit(
+            const sp<ABuffer> &buffer,
+            const List<sp<ABuffer> > &fragments = List<sp<ABuffer> >());
     AssemblyStatus addFragmentedNALUnit(List<sp<ABuffer> > *queue);
     bool addSingleTimeAggregationPacket(const sp<ABuffer> &buffer);
 
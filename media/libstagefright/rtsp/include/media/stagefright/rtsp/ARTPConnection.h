@@ -20,6 +20,7 @@
 
 #include <media/stagefright/foundation/AHandler.h>
 #include <utils/List.h>
+#include <utils/Vector.h>
 #include <sys/socket.h>
 
 namespace android {
@@ -80,8 +81,9 @@ private:
         kWhatAlarmStream,
     };
 
-    static const int64_t kSelectTimeoutUs;
+    static const int64_t kPollTimeoutUs;
     static const int64_t kMinOneSecondNotifyDelayUs;
+    static const int64_t kStatsReportIntervalUs;
 
     uint32_t mFlags;
 
@@ -103,6 +105,16 @@ private:
 
     int32_t mCumulativeBytes;
 
+    // All RTP and RTCP sockets of the non-injected streams are registered
+    // with this epoll instance.
+    int mEpollFd;
+
+    // Datagrams are received into these, up to one per buffer per
+    // recvmmsg() call, then copied out in buffers of their actual size.
+    Vector<sp<ABuffer> > mReceiveBuffers;
+
+    int64_t mLastStatsReportTimeUs;
+
     void onAddStream(const sp<AMessage> &msg);
     void onSeekStream(const sp<AMessage> &msg);
     void onRemoveStream(const sp<AMessage> &msg);
@@ -111,6 +123,7 @@ private:
     void onInjectPacket(const sp<AMessage> &msg);
     void onSendReceiverReports();
     void checkRxBitrate(int64_t nowUs);
+    void reportStreamStats(int64_t nowUs);
     void notifyCongestionToUpperLayerIfNeeded(StreamInfo *s);
     void handleIpHeadersIfReceived(StreamInfo *s, struct msghdr sMsg);
 
@@ -130,6 +143,8 @@ private:
 
     sp<ARTPSource> findSource(StreamInfo *info, uint32_t id);
 
+    void addPolledSockets(const StreamInfo *info);
+    void removePolledSockets(const StreamInfo *info);
     void postPollEvent();
 
     DISALLOW_EVIL_CONSTRUCTORS(ARTPConnection);
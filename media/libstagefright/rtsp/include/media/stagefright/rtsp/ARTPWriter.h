@@ -23,6 +23,7 @@
 #include <media/stagefright/foundation/AString.h>
 #include <media/stagefright/foundation/base64.h>
 #include <media/stagefright/MediaWriter.h>
+#include <utils/Vector.h>
 
 #include <arpa/inet.h>
 #include <sys/socket.h>
@@ -122,6 +123,25 @@ private:
     typedef uint64_t Bytes;
     sp<TrafficRecorder<uint32_t /* Time */, Bytes> > mTrafficRec;
 
+    // RTP packets are queued here by send(), and go out in batches paced to
+    // a multiple of mBitrate once it was set through setTMMBNInfo().
+    Vector<sp<ABuffer> > mRTPQueue;
+    Vector<int64_t> mRTPQueueTimesUs;
+    size_t mNumQueuedRTP;
+    bool mPacingEnabled;
+    int64_t mPacingTokens;
+    int64_t mLastPacingTimeUs;
+    int64_t mFramePacingDelayUs;
+
+    // Send statistics since the last report.
+    int64_t mLastSendStatsTimeUs;
+    uint32_t mNumRTPBatchesSent;
+    uint32_t mNumRTPPacketsSent;
+    int64_t mTotalSendLatencyUs;
+    int64_t mMaxSendLatencyUs;
+    int64_t mTotalSendCallUs;
+    int64_t mTotalPacingDelayUs;
+
     int32_t mNumSRsSent;
     int32_t mRTPCVOExtMap;
     int32_t mRTPCVODegrees;
@@ -139,6 +159,7 @@ private:
     uint32_t getRtpTime(int64_t timeUs);
 
     void initState();
+    void initSendQueue();
     void onRead(const sp<AMessage> &msg);
     void onSendSR(const sp<AMessage> &msg);
 
@@ -158,6 +179,10 @@ private:
     void sendAMRData(MediaBufferBase *mediaBuf);
 
     void send(const sp<ABuffer> &buffer, bool isRTCP);
+    void flushRTP(bool endOfFrame);
+    void waitForPacingTokens(size_t bytes);
+    void reportSendStats(int64_t nowUs);
+    struct sockaddr *getRemoteAddr(bool isRTCP, int *sizeSockSt);
     void makeSocketPairAndBind(String8& localIp, int localPort, String8& remoteIp, int remotePort);
 
     void ModerateInstantTraffic(uint32_t samplePeriod, uint32_t limitBytes);
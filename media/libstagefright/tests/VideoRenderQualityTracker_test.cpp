@@ -69,6 +69,17 @@ public:
         }
     }
 
+    void renderWithLatency(int numFrames, float latencyMs) {
+        for (int i = 0; i < numFrames; ++i) {
+            int64_t renderTimeNs = mClockTimeNs + int64_t(latencyMs * 1000 * 1000);
+            mVideoRenderQualityTracker.onFrameReleased(mMediaTimeUs, mClockTimeNs);
+            mVideoRenderQualityTracker.onFrameRendered(mMediaTimeUs, renderTimeNs, &mFreezeEvent,
+                                                       &mJudderEvent);
+            mMediaTimeUs += mContentFrameDurationUs;
+            mClockTimeNs += mContentFrameDurationUs * 1000;
+        }
+    }
+
     void skip(int numFrames) {
         for (int i = 0; i < numFrames; ++i) {
             mVideoRenderQualityTracker.onFrameSkipped(mMediaTimeUs);
@@ -153,6 +164,7 @@ TEST_F(VideoRenderQualityTrackerTest, getFromServerConfigurableFlags_withDefault
     EXPECT_EQ(c.judderEventMax, d.judderEventMax);
     EXPECT_EQ(c.judderEventDetailsMax, d.judderEventDetailsMax);
     EXPECT_EQ(c.judderEventDistanceToleranceMs, d.judderEventDistanceToleranceMs);
+    EXPECT_EQ(c.lateFrameToleranceUs, d.lateFrameToleranceUs);
     EXPECT_EQ(c.traceTriggerEnabled, d.traceTriggerEnabled);
     EXPECT_EQ(c.traceTriggerThrottleMs, d.traceTriggerThrottleMs);
     EXPECT_EQ(c.traceMinFreezeDurationMs, d.traceMinFreezeDurationMs);
@@ -184,6 +196,7 @@ TEST_F(VideoRenderQualityTrackerTest, getFromServerConfigurableFlags_withEmpty)
     EXPECT_EQ(c.judderEventMax, d.judderEventMax);
     EXPECT_EQ(c.judderEventDetailsMax, d.judderEventDetailsMax);
     EXPECT_EQ(c.judderEventDistanceToleranceMs, d.judderEventDistanceToleranceMs);
+    EXPECT_EQ(c.lateFrameToleranceUs, d.lateFrameToleranceUs);
     EXPECT_EQ(c.traceTriggerEnabled, d.traceTriggerEnabled);
     EXPECT_EQ(c.traceTriggerThrottleMs, d.traceTriggerThrottleMs);
     EXPECT_EQ(c.traceMinFreezeDurationMs, d.traceMinFreezeDurationMs);
@@ -215,6 +228,7 @@ TEST_F(VideoRenderQualityTrackerTest, getFromServerConfigurableFlags_withInvalid
     EXPECT_EQ(c.judderEventMax, d.judderEventMax);
     EXPECT_EQ(c.judderEventDetailsMax, d.judderEventDetailsMax);
     EXPECT_EQ(c.judderEventDistanceToleranceMs, d.judderEventDistanceToleranceMs);
+    EXPECT_EQ(c.lateFrameToleranceUs, d.lateFrameToleranceUs);
     EXPECT_EQ(c.traceTriggerEnabled, d.traceTriggerEnabled);
     EXPECT_EQ(c.traceTriggerThrottleMs, d.traceTriggerThrottleMs);
     EXPECT_EQ(c.traceMinFreezeDurationMs, d.traceMinFreezeDurationMs);
@@ -259,6 +273,8 @@ TEST_F(VideoRenderQualityTrackerTest, getFromServerConfigurableFlags_withAlmostV
                 return "10*10";
             } else if (flag == "render_metrics_judder_event_distance_tolerance_ms") {
                 return "140-a";
+            } else if (flag == "render_metrics_late_frame_tolerance_us") {
+                return "1e4";
             } else if (flag == "render_metrics_trace_trigger_enabled") {
                 return "fals";
             } else if (flag == "render_metrics_trace_trigger_throttle_ms") {
@@ -291,6 +307,7 @@ TEST_F(VideoRenderQualityTrackerTest, getFromServerConfigurableFlags_withAlmostV
     EXPECT_EQ(c.judderEventMax, d.judderEventMax);
     EXPECT_EQ(c.judderEventDetailsMax, d.judderEventDetailsMax);
     EXPECT_EQ(c.judderEventDistanceToleranceMs, d.judderEventDistanceToleranceMs);
+    EXPECT_EQ(c.lateFrameToleranceUs, d.lateFrameToleranceUs);
     EXPECT_EQ(c.traceTriggerEnabled, d.traceTriggerEnabled);
     EXPECT_EQ(c.traceTriggerThrottleMs, d.traceTriggerThrottleMs);
     EXPECT_EQ(c.traceMinFreezeDurationMs, d.traceMinFreezeDurationMs);
@@ -335,6 +352,8 @@ TEST_F(VideoRenderQualityTrackerTest, getFromServerConfigurableFlags_withValid)
                 return "10000";
             } else if (flag == "render_metrics_judder_event_distance_tolerance_ms") {
                 return "11000";
+            } else if (flag == "render_metrics_late_frame_tolerance_us") {
+                return "12000";
             } else if (flag == "render_metrics_trace_trigger_enabled") {
                 return "true";
             } else if (flag == "render_metrics_trace_trigger_throttle_ms") {
@@ -404,6 +423,8 @@ TEST_F(VideoRenderQualityTrackerTest, getFromServerConfigurableFlags_withValid)
     EXPECT_NE(c.judderEventDetailsMax, d.judderEventDetailsMax);
     EXPECT_EQ(c.judderEventDistanceToleranceMs, 11000);
     EXPECT_NE(c.judderEventDistanceToleranceMs, d.judderEventDistanceToleranceMs);
+    EXPECT_EQ(c.lateFrameToleranceUs, 12000);
+    EXPECT_NE(c.lateFrameToleranceUs, d.lateFrameToleranceUs);
 
     EXPECT_EQ(c.traceTriggerEnabled, true);
     EXPECT_EQ(c.traceTriggerThrottleMs, 50000);
@@ -483,6 +504,17 @@ TEST_F(VideoRenderQualityTrackerTest, countsRenderedFrames) {
     EXPECT_EQ(7, h.getMetrics().frameRenderedCount);
 }
 
+TEST_F(VideoRenderQualityTrackerTest, countsLateFrames) {
+    Configuration c;
+    c.enabled = true;
+    c.lateFrameToleranceUs = 10000;
+    Helper h(8.33, c);
+    h.renderWithLatency(10, 4.16); // half a refresh after the desired time at 120Hz is on time
+    h.renderWithLatency(3, 12.5); // one refresh later is late
+    h.renderWithLatency(10, 4.16);
+    EXPECT_EQ(3, h.getMetrics().frameLateCount);
+}
+
 TEST_F(VideoRenderQualityTrackerTest, detectsFrameRate) {
     Configuration c;
     c.enabled = true;
@@ -896,6 +896,87 @@ TEST_P(WriteFunctionalityTest, Mpeg4WriterTest) {
     close(fd);
 }
 
+// Writes the input as movie fragments and checks the extractor reads it back intact
+TEST_P(WriteFunctionalityTest, Mpeg4FragmentedWriterTest) {
+    if (mDisableTest) return;
+    if (mWriterName != standardWriters::MPEG4) return;
+    ALOGV("Validates MPEG4 writer in movie fragment mode");
+
+    inputId inpId = get<1>(GetParam());
+    string outputFile = OUTPUT_FILE_NAME;
+    int32_t fd =
+            open(outputFile.c_str(), O_CREAT | O_LARGEFILE | O_TRUNC | O_RDWR, S_IRUSR | S_IWUSR);
+    ASSERT_GE(fd, 0) << "Failed to open output file to dump writer's data";
+
+    int32_t status = createWriter(fd);
+    ASSERT_EQ(status, (status_t)OK) << "Failed to create writer for mpeg4 output format";
+
+    string inputFile = gEnv->getRes();
+    string inputInfo = gEnv->getRes();
+    configFormat param;
+    bool isAudio;
+    ASSERT_NE(inpId, UNUSED_ID) << "Test expects first inputId to be a valid id";
+
+    getFileDetails(inputFile, inputInfo, param, isAudio, inpId);
+    ASSERT_NE(inputFile.compare(gEnv->getRes()), 0) << "No input file specified";
+
+    struct stat buf;
+    status = stat(inputFile.c_str(), &buf);
+    ASSERT_EQ(status, 0) << "Failed to get properties of input file:" << inputFile;
+    size_t fileSize = buf.st_size;
+
+    ASSERT_NO_FATAL_FAILURE(getInputBufferInfo(inputFile, inputInfo));
+    status = addWriterSource(isAudio, param);
+    ASSERT_EQ((status_t)OK, status) << "Failed to add source for mpeg4 Writer";
+
+    mFileMeta->setInt64(kKeyMovieFragmentDurationUs, kDefaultFragmentDurationUs);
+    status = mWriter->start(mFileMeta.get());
+    ASSERT_EQ((status_t)OK, status) << "Could not start the writer";
+
+    status = sendBuffersToWriter(mInputStream[0], mBufferInfo[0], mInputFrameId[0],
+                                 mCurrentTrack[0], 0, mBufferInfo[0].size());
+    ASSERT_EQ((status_t)OK, status) << "mpeg4 writer failed";
+
+    status = mCurrentTrack[0]->stop();
+    ASSERT_EQ((status_t)OK, status) << "Failed to stop the track";
+
+    status = mWriter->stop();
+    ASSERT_EQ((status_t)OK, status) << "Failed to stop the writer";
+    close(fd);
+
+    configFormat extractorParams;
+    vector<BufferInfo> extractorBufferInfo;
+    int32_t trackCount = -1;
+
+    AMediaExtractor *extractor = AMediaExtractor_new();
+    ASSERT_NE(extractor, nullptr) << "Failed to create extractor";
+    ASSERT_NO_FATAL_FAILURE(setupExtractor(extractor, outputFile, trackCount));
+    ASSERT_EQ(trackCount, 1) << "Tracks reported by extractor does not match with input";
+
+    char *inputBuffer = (char *)malloc(fileSize);
+    ASSERT_NE(inputBuffer, nullptr) << "Failed to allocate the buffer of size " << fileSize;
+    mInputStream[0].seekg(0, mInputStream[0].beg);
+    mInputStream[0].read(inputBuffer, fileSize);
+    ASSERT_EQ(mInputStream[0].gcount(), fileSize);
+
+    uint8_t *extractedBuffer = (uint8_t *)malloc(fileSize);
+    ASSERT_NE(extractedBuffer, nullptr) << "Failed to allocate the buffer of size " << fileSize;
+    size_t bytesExtracted = 0;
+
+    ASSERT_NO_FATAL_FAILURE(extract(extractor, extractorParams, extractorBufferInfo,
+                                    extractedBuffer, fileSize, &bytesExtracted, 0));
+    ASSERT_GT(bytesExtracted, 0) << "Total bytes extracted by extractor cannot be zero";
+
+    ASSERT_NO_FATAL_FAILURE(compareParams(param, extractorParams, extractorBufferInfo, 0));
+
+    ASSERT_EQ(memcmp(extractedBuffer, (uint8_t *)inputBuffer, bytesExtracted), 0)
+            << "Extracted bit stream does not match with input bit stream";
+
+    free(inputBuffer);
+    free(extractedBuffer);
+    AMediaExtractor_delete(extractor);
+}
+
 class ListenerTest
     : public WriterTest,
       public ::testing::TestWithParam<tuple<
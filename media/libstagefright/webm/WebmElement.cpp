@@ -126,8 +126,9 @@ int WebmElement::write(int fd, uint64_t& size) {
         ALOGE("fd %d; flags: %o", fd, ::fcntl(fd, F_GETFL, 0));
         return errno;
     } else {
+        // No msync(): the pages are written back asynchronously like those of a write(), and
+        // WebmWriter::reset() syncs the file once instead of once per element.
         serializeInto((uint8_t*) dst + pageOff);
-        ::msync(dst, mapSize, MS_SYNC);
         return ::munmap(dst, mapSize);
     }
 }
@@ -24,8 +24,11 @@
 #include <media/stagefright/foundation/ADebug.h>
 
 #include <utils/Log.h>
+#include <utils/Timers.h>
 #include <inttypes.h>
 
+#include <algorithm>
+
 using namespace webm;
 
 namespace android {
@@ -79,6 +82,9 @@ WebmFrameSinkThread::WebmFrameSinkThread(
       mAudioFrames(audioThread->mSink),
       mCues(cues),
       mStartOffsetTimecode(UINT64_MAX),
+      mNumClusters(0),
+      mNumWriteStalls(0),
+      mLongestWriteUs(0),
       mDone(true) {
 }
 
@@ -94,6 +100,9 @@ WebmFrameSinkThread::WebmFrameSinkThread(
       mAudioFrames(audioSource),
       mCues(cues),
       mStartOffsetTimecode(UINT64_MAX),
+      mNumClusters(0),
+      mNumWriteStalls(0),
+      mLongestWriteUs(0),
       mDone(true) {
 }
 
@@ -130,8 +139,19 @@ void WebmFrameSinkThread::writeCluster(List<sp<WebmElement> >& children) {
 
     uint64_t size;
     sp<WebmElement> cluster = new WebmMaster(kMkvCluster, children);
+    int64_t startUs = systemTime() / 1000;
     cluster->write(mFd, size);
+    int64_t writeUs = systemTime() / 1000 - startUs;
     children.clear();
+
+    // The source threads keep queueing frames while a cluster is written, so a slow write
+    // only shows up as a longer queue; keep track of them.
+    ++mNumClusters;
+    mLongestWriteUs = std::max(mLongestWriteUs, writeUs);
+    if (writeUs >= kWriteStallThresholdUs) {
+        ++mNumWriteStalls;
+        ALOGW("writing a cluster of %" PRIu64 " bytes took %" PRId64 " us", size, writeUs);
+    }
 }
 
 // Write out (possibly multiple) webm cluster(s) from frames split on video key frames.
@@ -244,6 +264,8 @@ void WebmFrameSinkThread::run() {
     }
     ALOGV("flushing last cluster (size %zu)", outstandingFrames.size());
     flushFrames(outstandingFrames, /* last = */ true);
+    ALOGD("%" PRIu64 " clusters written, %" PRIu64 " write stalls, longest write %" PRId64 " us",
+            mNumClusters, mNumWriteStalls, mLongestWriteUs);
     mDone = true;
 }
 
@@ -32,6 +32,7 @@
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <inttypes.h>
+#include <string.h>
 
 using namespace webm;
 
@@ -451,6 +452,10 @@ status_t WebmWriter::reset() {
     sp<WebmElement> space = new EbmlVoid(kMaxMetaSeekSize - metaSeekSize);
     space->write(mFd, spaceSize);
 
+    if (fsync(mFd) != 0) {
+        ALOGW("(ignored)fsync err:%s(%d)", strerror(errno), errno);
+    }
+
     release();
     return err;
 }
@@ -85,6 +85,12 @@ private:
     List<sp<WebmElement> >& mCues;
     uint64_t mStartOffsetTimecode;
 
+    // Cluster write statistics, logged at the end of the session.
+    static const int64_t kWriteStallThresholdUs = 100000LL;
+    uint64_t mNumClusters;
+    uint64_t mNumWriteStalls;
+    int64_t mLongestWriteUs;
+
     volatile bool mDone;
 
     static void initCluster(
@@ -147,6 +147,14 @@ Return<void> Accessor::connect(
     return Void();
 }
 
+Return<void> Accessor::debug(
+        const hidl_handle& fd, const hidl_vec<hidl_string>& /* args */) {
+    if (mImpl && fd.getNativeHandle() != nullptr && fd->numFds > 0) {
+        mImpl->dump(fd->data[0]);
+    }
+    return Void();
+}
+
 Accessor::Accessor(const std::shared_ptr<BufferPoolAllocator> &allocator)
     : mImpl(new Impl(allocator)) {}
 
@@ -175,6 +183,14 @@ ResultStatus Accessor::allocate(
     return ResultStatus::CRITICAL_ERROR;
 }
 
+ResultStatus Accessor::prefetch(const std::vector<uint8_t> &params, size_t count) {
+    if (mImpl) {
+        mImpl->prefetch(params, count);
+        return ResultStatus::OK;
+    }
+    return ResultStatus::CRITICAL_ERROR;
+}
+
 ResultStatus Accessor::fetch(
         ConnectionId connectionId, TransactionId transactionId,
         BufferId bufferId, const native_handle_t** handle) {
@@ -34,6 +34,7 @@ namespace V2_0 {
 namespace implementation {
 
 using ::android::hardware::hidl_array;
+using ::android::hardware::hidl_handle;
 using ::android::hardware::hidl_memory;
 using ::android::hardware::hidl_string;
 using ::android::hardware::hidl_vec;
@@ -82,6 +83,13 @@ struct Accessor : public IAccessor {
     // Methods from ::android::hardware::media::bufferpool::V2_0::IAccessor follow.
     Return<void> connect(const sp<::android::hardware::media::bufferpool::V2_0::IObserver>& observer, connect_cb _hidl_cb) override;
 
+    // Methods from ::android::hidl::base::V1_0::IBase follow.
+    /**
+     * Writes the buffer pool statistics and the buffer status message counters
+     * (throughput and pending messages) of the connections.
+     */
+    Return<void> debug(const hidl_handle& fd, const hidl_vec<hidl_string>& args) override;
+
     /**
      * Creates a buffer pool accessor which uses the specified allocator.
      *
@@ -127,6 +135,18 @@ struct Accessor : public IAccessor {
      *         NO_MEMORY when there is no memory.
      *         CRITICAL_ERROR otherwise.
      */
+    /**
+     * Allocates buffers in the background until |count| buffers with the
+     * specified parameters are free to be recycled.
+     *
+     * @param params    the allocation parameters.
+     * @param count     the number of buffers expected to be allocated.
+     *
+     * @return OK when the buffers are being allocated.
+     *         CRITICAL_ERROR otherwise.
+     */
+    ResultStatus prefetch(const std::vector<uint8_t>& params, size_t count);
+
     ResultStatus fetch(
             ConnectionId connectionId,
             TransactionId transactionId,
@@ -21,9 +21,11 @@
 
 #include <sys/types.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <time.h>
 #include <unistd.h>
 #include <utils/Log.h>
+#include <algorithm>
 #include <thread>
 #include "AccessorImpl.h"
 #include "Connection.h"
@@ -44,6 +46,11 @@ namespace {
     static constexpr size_t kMaxUnusedBufferCount = 64;
     static constexpr size_t kUnusedBufferCountTarget = kMaxUnusedBufferCount - 16;
 
+    // max # of buffers allocated by a prefetch request. This stays below
+    // kUnusedBufferCountTarget, so that prefetched buffers are not evicted
+    // before they are requested.
+    static constexpr size_t kMaxPrefetchCount = 16;
+
     static constexpr nsecs_t kEvictGranularityNs = 1000000000; // 1 sec
     static constexpr nsecs_t kEvictDurationNs = 5000000000; // 5 secs
 }
@@ -104,10 +111,10 @@ struct TransactionStatus {
 
 // Helper template methods for handling map of set.
 template<class T, class U>
-bool insert(std::map<T, std::set<U>> *mapOfSet, T key, U value) {
+bool insert(std::unordered_map<T, std::unordered_set<U>> *mapOfSet, T key, U value) {
     auto iter = mapOfSet->find(key);
     if (iter == mapOfSet->end()) {
-        std::set<U> valueSet{value};
+        std::unordered_set<U> valueSet{value};
         mapOfSet->insert(std::make_pair(key, valueSet));
         return true;
     } else if (iter->second.find(value)  == iter->second.end()) {
@@ -118,7 +125,7 @@ bool insert(std::map<T, std::set<U>> *mapOfSet, T key, U value) {
 }
 
 template<class T, class U>
-bool erase(std::map<T, std::set<U>> *mapOfSet, T key, U value) {
+bool erase(std::unordered_map<T, std::unordered_set<U>> *mapOfSet, T key, U value) {
     bool ret = false;
     auto iter = mapOfSet->find(key);
     if (iter != mapOfSet->end()) {
@@ -133,7 +140,7 @@ bool erase(std::map<T, std::set<U>> *mapOfSet, T key, U value) {
 }
 
 template<class T, class U>
-bool contains(std::map<T, std::set<U>> *mapOfSet, T key, U value) {
+bool contains(std::unordered_map<T, std::unordered_set<U>> *mapOfSet, T key, U value) {
     auto iter = mapOfSet->find(key);
     if (iter != mapOfSet->end()) {
         auto setIter = iter->second.find(value);
@@ -251,6 +258,40 @@ ResultStatus Accessor::Impl::allocate(
     return status;
 }
 
+void Accessor::Impl::prefetch(const std::vector<uint8_t> &params, size_t count) {
+    count = std::min(count, kMaxPrefetchCount);
+    if (count == 0) {
+        return;
+    }
+    const std::weak_ptr<Accessor::Impl> weakImpl = shared_from_this();
+    std::thread([weakImpl, params, count] {
+        for (size_t i = 0; i < count; ++i) {
+            const std::shared_ptr<Accessor::Impl> impl = weakImpl.lock();
+            if (!impl || !impl->prefetchBuffer(params, count)) {
+                break;
+            }
+        }
+    }).detach();
+}
+
+bool Accessor::Impl::prefetchBuffer(const std::vector<uint8_t> &params, size_t count) {
+    {
+        std::lock_guard<std::mutex> lock(mBufferPool.mMutex);
+        mBufferPool.processStatusMessages();
+        if (mBufferPool.getNumFreeBuffers(mAllocator, params) >= count) {
+            return false;
+        }
+    }
+    // Do not hold lock for allocation, as allocate() does.
+    std::shared_ptr<BufferPoolAllocation> alloc;
+    size_t allocSize;
+    if (mAllocator->allocate(params, &alloc, &allocSize) != ResultStatus::OK) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mBufferPool.mMutex);
+    return mBufferPool.addPrefetchedBuffer(alloc, allocSize, params) == ResultStatus::OK;
+}
+
 ResultStatus Accessor::Impl::fetch(
         ConnectionId connectionId, TransactionId transactionId,
         BufferId bufferId, const native_handle_t** handle) {
@@ -318,6 +359,12 @@ bool Accessor::Impl::isValid() {
     return mBufferPool.isValid();
 }
 
+void Accessor::Impl::dump(int fd) {
+    std::lock_guard<std::mutex> lock(mBufferPool.mMutex);
+    mBufferPool.processStatusMessages();
+    mBufferPool.dump(fd);
+}
+
 Accessor::Impl::Impl::BufferPool::BufferPool()
     : mTimestampUs(getTimestampNow()),
       mLastCleanUpUs(mTimestampUs),
@@ -586,9 +633,12 @@ bool Accessor::Impl::BufferPool::handleTransferResult(const BufferStatusMessage
 }
 
 void Accessor::Impl::BufferPool::processStatusMessages() {
-    std::vector<BufferStatusMessage> messages;
+    std::vector<BufferStatusMessage> &messages = mMessages;
     mObserver.getBufferStatusChanges(messages);
     mTimestampUs = getTimestampNow();
+    if (!messages.empty()) {
+        mStats.onMessagesProcessed(messages.size());
+    }
     for (BufferStatusMessage& message: messages) {
         bool ret = false;
         switch (message.newStatus) {
@@ -741,6 +791,43 @@ ResultStatus Accessor::Impl::BufferPool::addNewBuffer(
     return ResultStatus::NO_MEMORY;
 }
 
+size_t Accessor::Impl::BufferPool::getNumFreeBuffers(
+        const std::shared_ptr<BufferPoolAllocator> &allocator,
+        const std::vector<uint8_t> &params) {
+    size_t numFreeBuffers = 0;
+    for (const BufferId &bufferId : mFreeBuffers) {
+        auto it = mBuffers.find(bufferId);
+        if (it != mBuffers.end() && allocator->compatible(params, it->second->mConfig)) {
+            ++numFreeBuffers;
+        }
+    }
+    return numFreeBuffers;
+}
+
+ResultStatus Accessor::Impl::BufferPool::addPrefetchedBuffer(
+        const std::shared_ptr<BufferPoolAllocation> &alloc,
+        const size_t allocSize,
+        const std::vector<uint8_t> &params) {
+    BufferId bufferId = mSeq++;
+    if (mSeq == Connection::SYNC_BUFFERID) {
+        mSeq = 0;
+    }
+    std::unique_ptr<InternalBuffer> buffer =
+            std::make_unique<InternalBuffer>(
+                    bufferId, alloc, allocSize, params);
+    if (buffer) {
+        auto res = mBuffers.insert(std::make_pair(
+                bufferId, std::move(buffer)));
+        if (res.second) {
+            mStats.onBufferPrefetched(allocSize);
+            mFreeBuffers.insert(bufferId);
+            ALOGV("prefetched a buffer %u", bufferId);
+            return ResultStatus::OK;
+        }
+    }
+    return ResultStatus::NO_MEMORY;
+}
+
 void Accessor::Impl::BufferPool::cleanUp(bool clearCache) {
     if (clearCache || mTimestampUs > mLastCleanUpUs + kCleanUpDurationUs ||
             mStats.buffersNotInUse() > kMaxUnusedBufferCount) {
@@ -750,11 +837,12 @@ void Accessor::Impl::BufferPool::cleanUp(bool clearCache) {
             mLastLogUs = mTimestampUs;
             ALOGD("bufferpool2 %p : %zu(%zu size) total buffers - "
                   "%zu(%zu size) used buffers - %zu/%zu (recycle/alloc) - "
-                  "%zu/%zu (fetch/transfer)",
+                  "%zu/%zu (fetch/transfer) - %zu/%zu (messages/batches)",
                   this, mStats.mBuffersCached, mStats.mSizeCached,
                   mStats.mBuffersInUse, mStats.mSizeInUse,
                   mStats.mTotalRecycles, mStats.mTotalAllocations,
-                  mStats.mTotalFetches, mStats.mTotalTransfers);
+                  mStats.mTotalFetches, mStats.mTotalTransfers,
+                  mStats.mTotalMessages, mStats.mTotalMessageBatches);
         }
         for (auto freeIt = mFreeBuffers.begin(); freeIt != mFreeBuffers.end();) {
             if (!clearCache && mStats.buffersNotInUse() <= kUnusedBufferCountTarget &&
@@ -805,6 +893,20 @@ void Accessor::Impl::BufferPool::invalidate(
     mInvalidation.onInvalidationRequest(needsAck, from, to, left, mInvalidationChannel, impl);
 }
 
+void Accessor::Impl::BufferPool::dump(int fd) {
+    dprintf(fd, "bufferpool2 %p: %zu(%zu size) total buffers - "
+            "%zu(%zu size) used buffers - %zu/%zu (recycle/alloc) - "
+            "%zu/%zu (fetch/transfer) - %zu/%zu (messages/batches) - "
+            "%zu prefetched - %zu pending transactions\n",
+            this, mStats.mBuffersCached, mStats.mSizeCached,
+            mStats.mBuffersInUse, mStats.mSizeInUse,
+            mStats.mTotalRecycles, mStats.mTotalAllocations,
+            mStats.mTotalFetches, mStats.mTotalTransfers,
+            mStats.mTotalMessages, mStats.mTotalMessageBatches,
+            mStats.mTotalPrefetches, mTransactions.size());
+    mObserver.dump(fd, mTimestampUs);
+}
+
 void Accessor::Impl::BufferPool::flush(const std::shared_ptr<Accessor::Impl> &impl) {
     BufferId from = mStartSeq;
     BufferId to = mSeq;
@@ -19,6 +19,8 @@
 
 #include <map>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <condition_variable>
 #include <utils/Timers.h>
 #include "Accessor.h"
@@ -57,6 +59,8 @@ public:
                           BufferId *bufferId,
                           const native_handle_t** handle);
 
+    void prefetch(const std::vector<uint8_t>& params, size_t count);
+
     ResultStatus fetch(ConnectionId connectionId,
                        TransactionId transactionId,
                        BufferId bufferId,
@@ -70,6 +74,8 @@ public:
 
     void handleInvalidateAck();
 
+    void dump(int fd);
+
     static void createInvalidator();
 
     static void createEvictor();
@@ -108,21 +114,25 @@ private:
         BufferStatusObserver mObserver;
         BufferInvalidationChannel mInvalidationChannel;
 
-        std::map<ConnectionId, std::set<BufferId>> mUsingBuffers;
-        std::map<BufferId, std::set<ConnectionId>> mUsingConnections;
+        // The ownership and transaction tables are looked up for every status
+        // message, and are hashed rather than ordered.
+        std::unordered_map<ConnectionId, std::unordered_set<BufferId>> mUsingBuffers;
+        std::unordered_map<BufferId, std::unordered_set<ConnectionId>> mUsingConnections;
 
-        std::map<ConnectionId, std::set<TransactionId>> mPendingTransactions;
+        std::unordered_map<ConnectionId, std::unordered_set<TransactionId>> mPendingTransactions;
         // Transactions completed before TRANSFER_TO message arrival.
         // Fetch does not occur for the transactions.
         // Only transaction id is kept for the transactions in short duration.
-        std::set<TransactionId> mCompletedTransactions;
+        std::unordered_set<TransactionId> mCompletedTransactions;
         // Currently active(pending) transations' status & information.
-        std::map<TransactionId, std::unique_ptr<TransactionStatus>>
+        std::unordered_map<TransactionId, std::unique_ptr<TransactionStatus>>
                 mTransactions;
 
-        std::map<BufferId, std::unique_ptr<InternalBuffer>> mBuffers;
+        std::unordered_map<BufferId, std::unique_ptr<InternalBuffer>> mBuffers;
         std::set<BufferId> mFreeBuffers;
         std::set<ConnectionId> mConnectionIds;
+        // Reused by processStatusMessages() to avoid an allocation per call.
+        std::vector<BufferStatusMessage> mMessages;
 
         struct Invalidation {
             static std::atomic<std::uint32_t> sInvSeqId;
@@ -195,10 +205,17 @@ private:
             size_t mTotalTransfers;
             /// # of transfers that had to be fetched.
             size_t mTotalFetches;
+            /// # of buffers allocated ahead of allocation requests.
+            size_t mTotalPrefetches;
+            /// # of buffer status messages processed.
+            size_t mTotalMessages;
+            /// # of status message batches which had at least one message.
+            size_t mTotalMessageBatches;
 
             Stats()
                 : mSizeCached(0), mBuffersCached(0), mSizeInUse(0), mBuffersInUse(0),
-                  mTotalAllocations(0), mTotalRecycles(0), mTotalTransfers(0), mTotalFetches(0) {}
+                  mTotalAllocations(0), mTotalRecycles(0), mTotalTransfers(0), mTotalFetches(0),
+                  mTotalPrefetches(0), mTotalMessages(0), mTotalMessageBatches(0) {}
 
             /// # of currently unused buffers
             size_t buffersNotInUse() const {
@@ -238,6 +255,14 @@ private:
                 mBuffersInUse--;
             }
 
+            /// A new buffer is allocated ahead of allocation requests.
+            void onBufferPrefetched(size_t allocSize) {
+                mSizeCached += allocSize;
+                mBuffersCached++;
+
+                mTotalPrefetches++;
+            }
+
             /// A buffer transfer is initiated.
             void onBufferSent() {
                 mTotalTransfers++;
@@ -247,6 +272,12 @@ private:
             void onBufferFetched() {
                 mTotalFetches++;
             }
+
+            /// A batch of buffer status messages is processed.
+            void onMessagesProcessed(size_t count) {
+                mTotalMessages += count;
+                mTotalMessageBatches++;
+            }
         } mStats;
 
         bool isValid() {
@@ -371,6 +402,30 @@ private:
                 BufferId *pId,
                 const native_handle_t **handle);
 
+        /**
+         * Returns the number of free buffers which can be recycled for the
+         * specified allocation parameters.
+         */
+        size_t getNumFreeBuffers(
+                const std::shared_ptr<BufferPoolAllocator> &allocator,
+                const std::vector<uint8_t> &params);
+
+        /**
+         * Adds a buffer allocated ahead of allocation requests to bufferpool,
+         * ready to be recycled.
+         *
+         * @param alloc     the newly allocated buffer.
+         * @param allocSize the size of the newly allocated buffer.
+         * @param params    the allocation parameters.
+         *
+         * @return OK when the buffer is added.
+         *         NO_MEMORY otherwise.
+         */
+        ResultStatus addPrefetchedBuffer(
+                const std::shared_ptr<BufferPoolAllocation> &alloc,
+                const size_t allocSize,
+                const std::vector<uint8_t> &params);
+
         /**
          * Processes pending buffer status messages and performs periodic cache
          * cleaning.
@@ -386,6 +441,12 @@ private:
          */
         void flush(const std::shared_ptr<Accessor::Impl> &impl);
 
+        /**
+         * Writes the buffer pool statistics and the status message counters of
+         * the connections to a file descriptor.
+         */
+        void dump(int fd);
+
         friend class Accessor::Impl;
     } mBufferPool;
 
@@ -426,6 +487,10 @@ private:
 
     void scheduleEvictIfNeeded();
 
+    // Allocates a buffer for prefetch() unless |count| compatible buffers are
+    // already free. Returns false when no buffer was added.
+    bool prefetchBuffer(const std::vector<uint8_t> &params, size_t count);
+
 };
 
 }  // namespace implementation
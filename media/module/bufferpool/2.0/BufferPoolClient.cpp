@@ -68,6 +68,8 @@ public:
                           native_handle_t **handle,
                           std::shared_ptr<BufferPoolData> *buffer);
 
+    ResultStatus prefetch(const std::vector<uint8_t> &params, size_t count);
+
     ResultStatus receive(
             TransactionId transactionId, BufferId bufferId,
             int64_t timestampUs,
@@ -398,6 +400,14 @@ ResultStatus BufferPoolClient::Impl::allocate(
     return status;
 }
 
+ResultStatus BufferPoolClient::Impl::prefetch(
+        const std::vector<uint8_t> &params, size_t count) {
+    if (!mLocal || !mLocalConnection || !mValid) {
+        return ResultStatus::CRITICAL_ERROR;
+    }
+    return mLocalConnection->prefetch(params, count);
+}
+
 ResultStatus BufferPoolClient::Impl::receive(
         TransactionId transactionId, BufferId bufferId, int64_t timestampUs,
         native_handle_t **pHandle,
@@ -846,6 +856,14 @@ ResultStatus BufferPoolClient::allocate(
     return ResultStatus::CRITICAL_ERROR;
 }
 
+ResultStatus BufferPoolClient::prefetch(
+        const std::vector<uint8_t> &params, size_t count) {
+    if (isValid()) {
+        return mImpl->prefetch(params, count);
+    }
+    return ResultStatus::CRITICAL_ERROR;
+}
+
 ResultStatus BufferPoolClient::receive(
         TransactionId transactionId, BufferId bufferId, int64_t timestampUs,
         native_handle_t **handle, std::shared_ptr<BufferPoolData> *buffer) {
@@ -83,6 +83,8 @@ private:
                           native_handle_t **handle,
                           std::shared_ptr<BufferPoolData> *buffer);
 
+    ResultStatus prefetch(const std::vector<uint8_t> &params, size_t count);
+
     ResultStatus receive(TransactionId transactionId,
                          BufferId bufferId,
                          int64_t timestampUs,
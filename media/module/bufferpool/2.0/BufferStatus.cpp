@@ -17,6 +17,9 @@
 #define LOG_TAG "BufferPoolStatus"
 //#define LOG_NDEBUG 0
 
+#include <algorithm>
+#include <inttypes.h>
+#include <stdio.h>
 #include <thread>
 #include <time.h>
 #include "BufferStatus.h"
@@ -67,8 +70,8 @@ ResultStatus BufferStatusObserver::open(
     } else {
         *fmqDescPtr = queue->getDesc();
     }
-    auto result = mBufferStatusQueues.insert(
-            std::make_pair(id, std::move(queue)));
+    auto result = mBufferStatusQueues.insert(std::make_pair(
+            id, QueueEntry{std::move(queue), ConnectionStats(getTimestampNow())}));
     if (!result.second) {
         *fmqDescPtr = nullptr;
         return ResultStatus::NO_MEMORY;
@@ -86,20 +89,42 @@ ResultStatus BufferStatusObserver::close(ConnectionId id) {
 
 void BufferStatusObserver::getBufferStatusChanges(std::vector<BufferStatusMessage> &messages) {
     for (auto it = mBufferStatusQueues.begin(); it != mBufferStatusQueues.end(); ++it) {
-        BufferStatusMessage message;
-        size_t avail = it->second->availableToRead();
-        while (avail > 0) {
-            if (!it->second->read(&message, 1)) {
-                // Since avaliable # of reads are already confirmed,
-                // this should not happen.
-                // TODO: error handling (spurious client?)
-                ALOGW("FMQ message cannot be read from %lld", (long long)it->first);
-                return;
-            }
-            message.connectionId = it->first;
-            messages.push_back(message);
-            --avail;
+        BufferStatusQueue *queue = it->second.mQueue.get();
+        ConnectionStats &stats = it->second.mStats;
+        size_t avail = queue->availableToRead();
+        stats.mLastPending = avail;
+        if (avail == 0) {
+            continue;
+        }
+        // Read all pending messages at once, instead of paying for the FMQ
+        // read pointer synchronization on every message.
+        size_t start = messages.size();
+        messages.resize(start + avail);
+        if (!queue->read(&messages[start], avail)) {
+            // Since avaliable # of reads are already confirmed,
+            // this should not happen.
+            // TODO: error handling (spurious client?)
+            ALOGW("FMQ message cannot be read from %lld", (long long)it->first);
+            messages.resize(start);
+            return;
         }
+        for (size_t i = start; i < messages.size(); ++i) {
+            messages[i].connectionId = it->first;
+        }
+        stats.mMessages += avail;
+        stats.mDrains++;
+        stats.mMaxPending = std::max(stats.mMaxPending, avail);
+    }
+}
+
+void BufferStatusObserver::dump(int fd, int64_t nowUs) const {
+    for (auto it = mBufferStatusQueues.begin(); it != mBufferStatusQueues.end(); ++it) {
+        const ConnectionStats &stats = it->second.mStats;
+        int64_t durationUs = std::max(nowUs - stats.mOpenedUs, (int64_t)1);
+        dprintf(fd, "  connection %lld: %" PRIu64 " messages (%.1f/s), "
+                "%" PRIu64 " drains, pending %zu (max %zu) of %d\n",
+                (long long)it->first, stats.mMessages, stats.mMessages * 1e6 / durationUs,
+                stats.mDrains, stats.mLastPending, stats.mMaxPending, kNumElementsInQueue);
     }
 }
 
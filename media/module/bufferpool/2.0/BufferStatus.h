@@ -46,9 +46,30 @@ bool isBufferInRange(BufferId from, BufferId to, BufferId bufferId);
  * ownership/status change messages are sent via the FMQs from the clients.
  */
 class BufferStatusObserver {
+public:
+    /** Buffer status message counters of a connection. */
+    struct ConnectionStats {
+        /// Timestamp of the connection creation. (Us)
+        int64_t mOpenedUs;
+        /// # of messages received.
+        uint64_t mMessages;
+        /// # of times messages were pending when the FMQ was drained.
+        uint64_t mDrains;
+        /// Max # of messages pending when the FMQ was drained.
+        size_t mMaxPending;
+        /// # of messages pending when the FMQ was last drained.
+        size_t mLastPending;
+
+        explicit ConnectionStats(int64_t openedUs)
+            : mOpenedUs(openedUs), mMessages(0), mDrains(0), mMaxPending(0), mLastPending(0) {}
+    };
+
 private:
-    std::map<ConnectionId, std::unique_ptr<BufferStatusQueue>>
-            mBufferStatusQueues;
+    struct QueueEntry {
+        std::unique_ptr<BufferStatusQueue> mQueue;
+        ConnectionStats mStats;
+    };
+    std::map<ConnectionId, QueueEntry> mBufferStatusQueues;
 
 public:
     /** Creates a buffer status message FMQ for the specified
@@ -75,9 +96,17 @@ public:
 
     /** Retrieves all pending FMQ buffer status messages from clients.
      *
-     * @param messages  retrieved pending messages.
+     * @param messages  retrieved pending messages. Messages are appended in
+     *                  the order they were sent for each connection.
      */
     void getBufferStatusChanges(std::vector<BufferStatusMessage> &messages);
+
+    /** Writes the message counters of all connections to a file descriptor.
+     *
+     * @param fd        the file descriptor to write to.
+     * @param nowUs     the current timestamp. (Us)
+     */
+    void dump(int fd, int64_t nowUs) const;
 };
 
 /**
@@ -115,6 +115,10 @@ public:
                           native_handle_t **handle,
                           std::shared_ptr<BufferPoolData> *buffer);
 
+    ResultStatus prefetch(ConnectionId connectionId,
+                          const std::vector<uint8_t> &params,
+                          size_t count);
+
     ResultStatus receive(ConnectionId connectionId,
                          TransactionId transactionId,
                          BufferId bufferId,
@@ -368,6 +372,20 @@ ResultStatus ClientManager::Impl::allocate(
 #endif
 }
 
+ResultStatus ClientManager::Impl::prefetch(
+        ConnectionId connectionId, const std::vector<uint8_t> &params, size_t count) {
+    std::shared_ptr<BufferPoolClient> client;
+    {
+        std::lock_guard<std::mutex> lock(mActive.mMutex);
+        auto it = mActive.mClients.find(connectionId);
+        if (it == mActive.mClients.end()) {
+            return ResultStatus::NOT_FOUND;
+        }
+        client = it->second;
+    }
+    return client->prefetch(params, count);
+}
+
 ResultStatus ClientManager::Impl::receive(
         ConnectionId connectionId, TransactionId transactionId,
         BufferId bufferId, int64_t timestampUs,
@@ -535,6 +553,14 @@ ResultStatus ClientManager::allocate(
     return ResultStatus::CRITICAL_ERROR;
 }
 
+ResultStatus ClientManager::prefetch(
+        ConnectionId connectionId, const std::vector<uint8_t> &params, size_t count) {
+    if (mImpl) {
+        return mImpl->prefetch(connectionId, params, count);
+    }
+    return ResultStatus::CRITICAL_ERROR;
+}
+
 ResultStatus ClientManager::receive(
         ConnectionId connectionId, TransactionId transactionId,
         BufferId bufferId, int64_t timestampUs,
@@ -84,6 +84,13 @@ ResultStatus Connection::allocate(
     return ResultStatus::CRITICAL_ERROR;
 }
 
+ResultStatus Connection::prefetch(const std::vector<uint8_t> &params, size_t count) {
+    if (mInitialized && mAccessor) {
+        return mAccessor->prefetch(params, count);
+    }
+    return ResultStatus::CRITICAL_ERROR;
+}
+
 void Connection::cleanUp(bool clearCache) {
     if (mInitialized && mAccessor) {
         mAccessor->cleanUp(clearCache);
@@ -64,6 +64,18 @@ struct Connection : public IConnection {
     ResultStatus allocate(const std::vector<uint8_t> &params,
                           BufferId *bufferId, const native_handle_t **handle);
 
+    /**
+     * Allocates buffers using the specified parameters in the background
+     * until |count| of them are free to be recycled.
+     *
+     * @param params    allocation parameters.
+     * @param count     the number of buffers expected to be allocated.
+     *
+     * @return OK if the buffers are being allocated.
+     *         CRITICAL_ERROR otherwise.
+     */
+    ResultStatus prefetch(const std::vector<uint8_t> &params, size_t count);
+
     /**
      * Processes pending buffer status messages and performs periodic cache cleaning
      * from bufferpool.
@@ -124,6 +124,24 @@ struct ClientManager : public IClientManager {
                           native_handle_t **handle,
                           std::shared_ptr<BufferPoolData> *buffer);
 
+    /**
+     * Hints that buffers with the specified allocation parameters will be
+     * allocated from the connection soon. The buffer pool allocates buffers in
+     * the background until |count| free buffers with the parameters are
+     * available, so that subsequent allocate() calls can recycle them.
+     *
+     * @param connectionId  The id of the connection.
+     * @param params        The allocation parameters.
+     * @param count         The number of buffers expected to be allocated.
+     *
+     * @return OK when the buffers are being allocated.
+     *         NOT_FOUND when the specified connection was not found.
+     *         CRITICAL_ERROR otherwise, e.g. when the buffer pool is remote.
+     */
+    ResultStatus prefetch(ConnectionId connectionId,
+                          const std::vector<uint8_t> &params,
+                          size_t count);
+
     /**
      * Receives a buffer for the transaction. The output parameter handle is
      * cloned from the internal handle. So it is safe to use directly, and it
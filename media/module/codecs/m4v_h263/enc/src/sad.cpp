@@ -20,6 +20,11 @@
 
 #include "sad_inline.h"
 
+#if defined(__aarch64__)
+#define M4VENC_NEON
+#include <arm_neon.h>
+#endif
+
 #define Cached_lx 176
 
 #ifdef _SAD_STAT
@@ -63,6 +68,44 @@ extern "C"
 
     Int SAD_MB_PAD1(UChar *ref, UChar *cur, Int dmin, Int lx, Int *rep);
 
+#ifdef M4VENC_NEON
+    /* Same result as simd_sad_mb(): the SAD is checked against dmin after each row,
+       and the partial SAD returned as soon as it is larger. */
+    static inline Int sad_mb_neon(UChar *ref, UChar *blk, Int dmin, Int lx)
+    {
+        uint32 sad = 0;
+
+        for (Int i = 0; i < 16; i++)
+        {
+            sad += vaddlvq_u8(vabdq_u8(vld1q_u8(ref), vld1q_u8(blk)));
+            if (sad > (uint32)dmin)
+            {
+                break;
+            }
+            ref += lx;
+            blk += 16;
+        }
+
+        return sad;
+    }
+
+#ifdef HTFM
+    /* SAD of p1[0], p1[4], p1[8] and p1[12] of 4 rows lx4 apart, against the
+       next 16 pixels of the block reordered by HTFMPrepareCurMB() */
+    static inline Int sad_htfm_16pixel(UChar *p1, UChar *blk, Int lx4)
+    {
+        uint8x16_t row0 = vld1q_u8(p1);
+        uint8x16_t row1 = vld1q_u8(p1 + lx4);
+        uint8x16_t row2 = vld1q_u8(p1 + 2 * lx4);
+        uint8x16_t row3 = vld1q_u8(p1 + 3 * lx4);
+        /* keep every 4th pixel, row by row */
+        uint8x16_t sub = vuzp1q_u8(vuzp1q_u8(row0, row1), vuzp1q_u8(row2, row3));
+
+        return vaddlvq_u8(vabdq_u8(sub, vld1q_u8(blk)));
+    }
+#endif
+#endif
+
 
     /*==================================================================
         Function:   SAD_Macroblock
@@ -85,7 +128,11 @@ extern "C"
 
         NUM_SAD_MB_CALL();
 
+#ifdef M4VENC_NEON
+        x10 = sad_mb_neon(ref, blk, dmin, lx);
+#else
         x10 = simd_sad_mb(ref, blk, dmin, lx);
+#endif
 
         return x10;
     }
@@ -123,6 +170,10 @@ extern "C"
         for (i = 0; i < 16; i++)
         {
             p1 = ref + offsetRef[i];
+#ifdef M4VENC_NEON
+            sad += sad_htfm_16pixel(p1, blk + 4, lx4);
+            blk += 16;
+#else
             cur_word = *((ULong*)(blk += 4));
             tmp = p1[12];
             tmp2 = (cur_word >> 24) & 0xFF;
@@ -182,6 +233,7 @@ extern "C"
             p1 += lx4;
             tmp2 = (cur_word & 0xFF);
             sad = SUB_SAD(sad, tmp, tmp2);
+#endif
 
             NUM_SAD_MB();
 
@@ -226,6 +278,10 @@ extern "C"
         for (i = 0; i < 16; i++)
         {
             p1 = ref + offsetRef[i];
+#ifdef M4VENC_NEON
+            sad += sad_htfm_16pixel(p1, blk + 4, lx4);
+            blk += 16;
+#else
             cur_word = *((ULong*)(blk += 4));
             tmp = p1[12];
             tmp2 = (cur_word >> 24) & 0xFF;
@@ -285,6 +341,7 @@ extern "C"
             p1 += lx4;
             tmp2 = (cur_word & 0xFF);
             sad = SUB_SAD(sad, tmp, tmp2);
+#endif
 
             NUM_SAD_MB();
 
@@ -76,6 +76,11 @@ Input
 #include "pvmp3_dec_defs.h"
 #include "pvmp3_tables.h"
 
+#if defined(__aarch64__) && !defined(PV_MP3DEC_NO_NEON)
+#define PV_MP3DEC_NEON
+#include <arm_neon.h>
+#endif
+
 /*----------------------------------------------------------------------------
 ; MACROS
 ; Define module1 specific macros here
@@ -94,6 +99,100 @@ Input
 ; Function Prototype declaration
 ----------------------------------------------------------------------------*/
 
+#ifdef PV_MP3DEC_NEON
+
+/*
+ *  Lane-wise fxp_mul32_Q32(): the high 32 bits of the 64-bit products,
+ *  truncated, so that the results are bit-exact with the C version.
+ */
+static inline int32x4_t fxp_mul32_Q32_x4(int32x4_t a, int32x4_t b)
+{
+    int64x2_t lo = vmull_s32(vget_low_s32(a), vget_low_s32(b));
+    int64x2_t hi = vmull_high_s32(a, b);
+    return vuzp2q_s32(vreinterpretq_s32_s64(lo), vreinterpretq_s32_s64(hi));
+}
+
+/*
+ *  Loads synth_buffer[base - j] for the 4 consecutive j starting at the lane 0 one
+ */
+static inline int32x4_t load_reversed_x4(const int32 *base)
+{
+    int32x4_t v = vld1q_s32(base - 3);
+    v = vrev64q_s32(v);
+    return vextq_s32(v, v, 2);
+}
+
+/*
+ *  4x4 transpose of the window coefficients rows[0..3][0..3], so that w[m]
+ *  holds coefficient m of the 4 rows
+ */
+static inline void transpose_x4(const int32 *rows, int32x4_t w[4])
+{
+    int32x4_t r0 = vld1q_s32(rows);
+    int32x4_t r1 = vld1q_s32(rows + 16);
+    int32x4_t r2 = vld1q_s32(rows + 32);
+    int32x4_t r3 = vld1q_s32(rows + 48);
+    int64x2_t t0 = vreinterpretq_s64_s32(vtrn1q_s32(r0, r1));
+    int64x2_t t1 = vreinterpretq_s64_s32(vtrn2q_s32(r0, r1));
+    int64x2_t t2 = vreinterpretq_s64_s32(vtrn1q_s32(r2, r3));
+    int64x2_t t3 = vreinterpretq_s64_s32(vtrn2q_s32(r2, r3));
+    w[0] = vreinterpretq_s32_s64(vtrn1q_s64(t0, t2));
+    w[1] = vreinterpretq_s32_s64(vtrn1q_s64(t1, t3));
+    w[2] = vreinterpretq_s32_s64(vtrn2q_s64(t0, t2));
+    w[3] = vreinterpretq_s32_s64(vtrn2q_s64(t1, t3));
+}
+
+/*
+ *  Same as the j loop of pvmp3_polyphase_filter_window() for 4 consecutive
+ *  values of j starting at j0, one per lane. winPtr points to the window
+ *  coefficients of j0, those of the following j are every 16 coefficients.
+ */
+static void polyphase_filter_window_x4(int32 *synth_buffer,
+                                       int16 *outPcm,
+                                       int32 numChannels,
+                                       int32 j0,
+                                       const int32 *winPtr)
+{
+    const int32 *pt_1 = &synth_buffer[(SUBBANDS_NUMBER >> 1) + j0];
+    const int32 *pt_2 = &synth_buffer[(SUBBANDS_NUMBER >> 1) - j0];
+
+    int32x4_t sum1 = vdupq_n_s32(0x00000020);
+    int32x4_t sum2 = vdupq_n_s32(0x00000020);
+
+    for (int32 g = 0; g < 4; g++)
+    {
+        int32x4_t w[4];
+        transpose_x4(&winPtr[g << 2], w);
+
+        int32x4_t temp1 = vld1q_s32(&pt_1[SUBBANDS_NUMBER * (2 * g)]);
+        int32x4_t temp3 = load_reversed_x4(&pt_2[SUBBANDS_NUMBER * (15 - 2 * g)]);
+        int32x4_t temp2 = load_reversed_x4(&pt_2[SUBBANDS_NUMBER * (2 * g + 1)]);
+        int32x4_t temp4 = vld1q_s32(&pt_1[SUBBANDS_NUMBER * (14 - 2 * g)]);
+
+        sum1 = vaddq_s32(sum1, fxp_mul32_Q32_x4(temp1, w[0]));
+        sum2 = vaddq_s32(sum2, fxp_mul32_Q32_x4(temp3, w[0]));
+        sum2 = vaddq_s32(sum2, fxp_mul32_Q32_x4(temp1, w[1]));
+        sum1 = vsubq_s32(sum1, fxp_mul32_Q32_x4(temp3, w[1]));
+        sum1 = vaddq_s32(sum1, fxp_mul32_Q32_x4(temp2, w[2]));
+        sum2 = vsubq_s32(sum2, fxp_mul32_Q32_x4(temp4, w[2]));
+        sum2 = vaddq_s32(sum2, fxp_mul32_Q32_x4(temp2, w[3]));
+        sum1 = vaddq_s32(sum1, fxp_mul32_Q32_x4(temp4, w[3]));
+    }
+
+    int16 out1[4];
+    int16 out2[4];
+    vst1_s16(out1, vqmovn_s32(vshrq_n_s32(sum1, 6)));   /* saturate16(sum >> 6) */
+    vst1_s16(out2, vqmovn_s32(vshrq_n_s32(sum2, 6)));
+    for (int32 n = 0; n < 4; n++)
+    {
+        int32 k = (j0 + n) << (numChannels - 1);
+        outPcm[k] = out1[n];
+        outPcm[(numChannels<<5) - k] = out2[n];
+    }
+}
+
+#endif
+
 /*----------------------------------------------------------------------------
 ; LOCAL STORE/BUFFER/POINTER DEFINITIONS
 ; Variable declaration - defined here and used outside this module1
@@ -120,9 +219,20 @@ void pvmp3_polyphase_filter_window(int32 *synth_buffer,
     int32 sum2;
     const int32 *winPtr = pqmfSynthWin;
     int32 i;
+    int16 j = 1;
 
+#ifdef PV_MP3DEC_NEON
+    /*
+     *  j = 1 to 12 four at a time, the remaining 3 by the loop below
+     */
+    for (; j + 4 <= SUBBANDS_NUMBER / 2; j += 4)
+    {
+        polyphase_filter_window_x4(synth_buffer, outPcm, numChannels, j, winPtr);
+        winPtr += 16 * 4;
+    }
+#endif
 
-    for (int16 j = 1; j < SUBBANDS_NUMBER / 2; j++)
+    for (; j < SUBBANDS_NUMBER / 2; j++)
     {
         sum1 = 0x00000020;
         sum2 = 0x00000020;
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "Mp3PolyphaseFilterWindowTest"
+
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "pvmp3_dec_defs.h"
+#include "pvmp3_polyphase_filter_window.h"
+
+extern "C" void pvmp3_polyphase_filter_window_reference(int32* synth_buffer, int16* outPcm,
+                                                        int32 numChannels);
+
+// The library version of pvmp3_polyphase_filter_window() may be vectorized, it must
+// output the same samples as the C version.
+class Mp3PolyphaseFilterWindowTest : public ::testing::TestWithParam<int32> {};
+
+TEST_P(Mp3PolyphaseFilterWindowTest, BitExact) {
+    const int32 numChannels = GetParam();
+    constexpr int kIterations = 10000;
+    constexpr size_t kOutPcmSize = 2 * SUBBANDS_NUMBER;
+    std::mt19937 generator(numChannels);
+
+    for (int i = 0; i < kIterations; i++) {
+        int32 synthBuffer[HAN_SIZE];
+        // Vary the amplitude from full scale, where every sample saturates, to silence.
+        const int shift = i % 32;
+        for (int32& sample : synthBuffer) {
+            sample = static_cast<int32>(generator()) >> shift;
+        }
+
+        int16 outPcm[kOutPcmSize] = {};
+        int16 expectedOutPcm[kOutPcmSize] = {};
+        pvmp3_polyphase_filter_window(synthBuffer, outPcm, numChannels);
+        pvmp3_polyphase_filter_window_reference(synthBuffer, expectedOutPcm, numChannels);
+        for (size_t j = 0; j < kOutPcmSize; j++) {
+            ASSERT_EQ(expectedOutPcm[j], outPcm[j]) << "iteration " << i << " sample " << j;
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Mp3PolyphaseFilterWindowTestAll, Mp3PolyphaseFilterWindowTest,
+                         ::testing::Values(1, 2));
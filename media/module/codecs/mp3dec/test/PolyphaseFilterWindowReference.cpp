@@ -0,0 +1,21 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// The C version of pvmp3_polyphase_filter_window(), under another name, which
+// Mp3PolyphaseFilterWindowTest compares the library version with.
+#define PV_MP3DEC_NO_NEON
+#define pvmp3_polyphase_filter_window pvmp3_polyphase_filter_window_reference
+#include "pvmp3_polyphase_filter_window.cpp"
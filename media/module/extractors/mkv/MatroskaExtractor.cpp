@@ -389,6 +389,12 @@ void BlockIterator::advance_l() {
 
             mCluster = nextCluster;
 
+            // Without Cues, keep the loaded clusters in step with playback so that
+            // seeking within played content does not scan for clusters again.
+            if (mExtractor->mSegment->GetCues() == NULL) {
+                mExtractor->loadClustersUntil_l(mCluster->GetTime());
+            }
+
             res = mCluster->Parse(pos, len);
             ALOGV("Parse (2) returned %ld", res);
 
@@ -584,6 +590,7 @@ int64_t BlockIterator::blockTimeUs() const {
 }
 
 void BlockIterator::seekwithoutcue_l(int64_t seekTimeUs, int64_t *actualFrameTimeUs) {
+    mExtractor->loadClustersUntil_l(seekTimeUs * 1000ll);
     mCluster = mExtractor->mSegment->FindCluster(seekTimeUs * 1000ll);
     const long status = mCluster->GetFirst(mBlockEntry);
     if (status < 0) {  // error
@@ -778,6 +785,10 @@ status_t MatroskaSource::setWebmBlockCryptoInfo(MediaBufferHelper *mbuf) {
     return OK;
 }
 
+// Room reserved in front of AVC/HEVC frames with short NAL length prefixes, for
+// converting them to start codes in place. That is 64 NALs with 1-byte prefixes.
+static const size_t kNALGrowthReserve = 192;
+
 media_status_t MatroskaSource::readBlock() {
     CHECK(mPendingFrames.empty());
 
@@ -799,15 +810,31 @@ media_status_t MatroskaSource::readBlock() {
         }
 
         len += trackInfo->mHeaderLen;
+
+        // NAL length prefixes shorter than a start code make the frame grow when
+        // read() converts it. Read such frames at the end of the buffer, so that
+        // the conversion can be done in place, towards the start of the buffer.
+        size_t reserve = 0;
+        if ((mType == AVC || mType == HEVC)
+                && mNALSizeLen > 0 && mNALSizeLen < 4
+                && !trackInfo->mEncrypted
+                && SIZE_MAX - len >= kNALGrowthReserve) {
+            reserve = kNALGrowthReserve;
+        }
+
         MediaBufferHelper *mbuf = nullptr;
         err = mBufferGroup->acquire_buffer(&mbuf, false /* nonblocking */,
-                                           len /* requested size */);
+                                           len + reserve /* requested size */);
         if (err != OK || mbuf == nullptr) {
             ALOGE("readBlock: no buffer");
             return AMEDIA_ERROR_UNKNOWN;
         }
-        mbuf->set_range(0, len);
-        uint8_t *data = static_cast<uint8_t *>(mbuf->data());
+        size_t offset = 0;
+        if (reserve > 0 && mbuf->size() >= len) {
+            offset = mbuf->size() - len;
+        }
+        mbuf->set_range(offset, len);
+        uint8_t *data = static_cast<uint8_t *>(mbuf->data()) + offset;
         if (trackInfo->mHeader) {
             memcpy(data, trackInfo->mHeader, trackInfo->mHeaderLen);
         }
@@ -1169,6 +1196,12 @@ media_status_t MatroskaSource::read(
                     memcpy(&dstPtr[dstOffset + 4],
                            &srcPtr[srcOffset + mNALSizeLen],
                            NALsize);
+                } else if (dstPtr + dstOffset + 4 != srcPtr + srcOffset + mNALSizeLen) {
+                    // Converting in place: the output never overtakes the input,
+                    // but the two may overlap.
+                    memmove(&dstPtr[dstOffset + 4],
+                            &srcPtr[srcOffset + mNALSizeLen],
+                            NALsize);
                 }
             }
 
@@ -1191,10 +1224,13 @@ media_status_t MatroskaSource::read(
         if (pass == 0) {
             dstSize = dstOffset;
 
-            if (dstSize == srcSize && mNALSizeLen == 4) {
-                // In this special case we can re-use the input buffer by substituting
-                // each 4-byte nal size with a 4-byte start code
+            // The output is at least as large as the input. If there is room before
+            // the input for the extra bytes (always the case for 4-byte NAL sizes),
+            // re-use the input buffer by substituting each nal size with a start code.
+            const size_t growth = dstSize - srcSize;
+            if (growth <= frame->range_offset()) {
                 buffer = frame;
+                buffer->set_range(frame->range_offset() - growth, dstSize);
             } else {
                 mBufferGroup->acquire_buffer(
                         &buffer, false /* nonblocking */, dstSize /* requested size */);
@@ -1211,7 +1247,7 @@ media_status_t MatroskaSource::read(
             AMediaFormat_setInt64(bufMeta, AMEDIAFORMAT_KEY_TIME_US, timeUs);
             AMediaFormat_setInt32(bufMeta, AMEDIAFORMAT_KEY_IS_SYNC_FRAME, isSync);
 
-            dstPtr = (uint8_t *)buffer->data();
+            dstPtr = (uint8_t *)buffer->data() + buffer->range_offset();
         }
     }
 
@@ -1336,7 +1372,8 @@ MatroskaExtractor::MatroskaExtractor(DataSourceHelper *source)
       mSegment(NULL),
       mExtractedThumbnails(false),
       mIsWebm(false),
-      mSeekPreRollNs(0) {
+      mSeekPreRollNs(0),
+      mAllClustersLoaded(false) {
     off64_t size;
     mIsLiveStreaming =
         (mDataSource->flags()
@@ -1401,14 +1438,21 @@ MatroskaExtractor::MatroskaExtractor(DataSourceHelper *source)
                 }
             }
 
-            if (mCues) {
-                long len;
-                ret = mSegment->LoadCluster(pos, len);
-                ALOGV("has Cue data, Cluster num=%ld", mSegment->GetCount());
-            } else  {
-                long status_Load = mSegment->Load();
-                ALOGW("no Cue data,Segment Load status:%ld",status_Load);
+            // Without Cues, the remaining clusters are loaded on demand by
+            // loadClustersUntil_l() rather than all at once here.
+            long len;
+            ret = mSegment->LoadCluster(pos, len);
+            if (ret >= 1) {
+                // no more clusters
+                mAllClustersLoaded = true;
+                ret = 0;
+            } else if (ret < 0 && !mCues) {
+                // As with Segment::Load(), play whatever clusters could be parsed.
+                ALOGW("no Cue data, LoadCluster status:%lld", ret);
+                mAllClustersLoaded = true;
+                ret = 0;
             }
+            ALOGV("%s Cue data, Cluster num=%ld", mCues ? "has" : "no", mSegment->GetCount());
         } else if (ret > 0) {
             ret = mkvparser::E_BUFFER_NOT_FULL;
         }
@@ -1485,6 +1529,29 @@ bool MatroskaExtractor::isLiveStreaming() const {
     return mIsLiveStreaming;
 }
 
+void MatroskaExtractor::loadClustersUntil_l(long long timeNs) {
+    // Live streams cannot seek, and reading ahead would block on the network.
+    while (!mAllClustersLoaded && !mIsLiveStreaming) {
+        const mkvparser::Cluster *last = mSegment->GetLast();
+        if (last != NULL && !last->EOS() && last->GetTime() > timeNs) {
+            break;
+        }
+
+        // LoadCluster() only reads the cluster headers; the blocks are parsed
+        // when they are played.
+        long long pos;
+        long len;
+        long res = mSegment->LoadCluster(pos, len);
+        if (res != 0) {
+            // No more clusters, or an I/O error: FindCluster() makes do with
+            // the clusters loaded so far.
+            ALOGV_IF(res < 0, "LoadCluster returned %ld", res);
+            mAllClustersLoaded = true;
+            break;
+        }
+    }
+}
+
 static int bytesForSize(size_t size) {
     // use at most 28 bits (4 times 7)
     CHECK(size <= 0xfffffff);
@@ -92,6 +92,10 @@ private:
     bool mIsWebm;
     int64_t mSeekPreRollNs;
 
+    // Clusters are loaded lazily. Set once LoadCluster() has reached the end of
+    // the segment (or failed), after which the cluster list is final.
+    bool mAllClustersLoaded;
+
     status_t synthesizeAVCC(TrackInfo *trackInfo, size_t index);
     status_t synthesizeMPEG2(TrackInfo *trackInfo, size_t index);
     status_t synthesizeMPEG4(TrackInfo *trackInfo, size_t index);
@@ -107,6 +111,10 @@ private:
             AMediaFormat *meta);
     bool isLiveStreaming() const;
 
+    // Loads cluster headers until the segment has a cluster starting after
+    // |timeNs|, so that Segment::FindCluster() can locate the one containing it.
+    void loadClustersUntil_l(long long timeNs);
+
     MatroskaExtractor(const MatroskaExtractor &);
     MatroskaExtractor &operator=(const MatroskaExtractor &);
 };
@@ -55,6 +55,13 @@
 
 #include <byteswap.h>
 
+#include <list>
+#include <vector>
+
+#ifdef __ANDROID__
+#include <sys/system_properties.h>
+#endif
+
 #ifndef UINT32_MAX
 #define UINT32_MAX       (4294967295U)
 #endif
@@ -222,6 +229,19 @@ private:
     Vector<Sample> mCurrentSamples;
     std::map<off64_t, uint32_t> mDrmOffsets;
 
+    // Start of each movie fragment found so far, in file order. Without a
+    // sidx, seeks look up their fragment here and only parse the fragments
+    // that have not been reached yet.
+    struct FragmentInfo {
+        off64_t mMoofOffset;
+        uint64_t mStartTime; // in media timescale ticks
+    };
+    Vector<FragmentInfo> mFragments;
+    bool mFragmentsComplete;
+
+    void addFragment(off64_t moofOffset, uint64_t startTime);
+    size_t findFragment(uint64_t time, ReadOptions::SeekMode mode);
+
     MPEG4Source(const MPEG4Source &);
     MPEG4Source &operator=(const MPEG4Source &);
 };
@@ -244,6 +264,9 @@ public:
 
     status_t setCachedRange(off64_t offset, size_t size, bool assumeSourceOwnershipOnSuccess);
 
+    // Serves the range starting at |offset| from |data| instead of reading it.
+    // Always assumes ownership of the wrapped source.
+    void setSharedRange(off64_t offset, const std::shared_ptr<const std::vector<uint8_t>> &data);
 
 private:
     Mutex mLock;
@@ -253,6 +276,7 @@ private:
     off64_t mCachedOffset;
     size_t mCachedSize;
     uint8_t *mCache;
+    std::shared_ptr<const std::vector<uint8_t>> mSharedCache;
 
     void clearCache();
 
@@ -281,6 +305,7 @@ void CachedRangedDataSource::clearCache() {
         free(mCache);
         mCache = NULL;
     }
+    mSharedCache.reset();
 
     mCachedOffset = 0;
     mCachedSize = 0;
@@ -290,7 +315,8 @@ ssize_t CachedRangedDataSource::readAt(off64_t offset, void *data, size_t size)
     Mutex::Autolock autoLock(mLock);
 
     if (isInRange(mCachedOffset, mCachedSize, offset, size)) {
-        memcpy(data, &mCache[offset - mCachedOffset], size);
+        const uint8_t *cache = mSharedCache ? mSharedCache->data() : mCache;
+        memcpy(data, &cache[offset - mCachedOffset], size);
         return size;
     }
 
@@ -332,6 +358,112 @@ status_t CachedRangedDataSource::setCachedRange(off64_t offset,
     return OK;
 }
 
+void CachedRangedDataSource::setSharedRange(
+        off64_t offset, const std::shared_ptr<const std::vector<uint8_t>> &data) {
+    Mutex::Autolock autoLock(mLock);
+
+    clearCache();
+
+    mSharedCache = data;
+    mCachedOffset = offset;
+    mCachedSize = data->size();
+    mOwnsDataSource = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Process-wide cache of top-level metadata boxes ('moov' and 'sidx'), so that
+// reopening the same file does not read its metadata piece by piece again.
+// It is disabled unless media.stagefright.mp4.box_cache_kb is set.
+//
+// Entries are validated against the file size, a hash of the start of the
+// file, the box position and size, and a hash of both ends of the box.
+// The data source does not expose modification times, and mvhd/mfhd near
+// the start of the box change whenever the file is rewritten.
+class MetadataBoxCache {
+public:
+    struct Key {
+        off64_t fileSize;
+        uint64_t fileHash;
+        off64_t offset;
+        uint64_t size;
+        uint64_t boxHash;
+
+        bool operator==(const Key &other) const {
+            return fileSize == other.fileSize && fileHash == other.fileHash
+                    && offset == other.offset && size == other.size
+                    && boxHash == other.boxHash;
+        }
+    };
+
+    // Number of bytes hashed at the start of the file and at each end of a box.
+    static const size_t kHashSize = 4096;
+
+    static MetadataBoxCache &Get() {
+        static MetadataBoxCache *sCache = new MetadataBoxCache;
+        return *sCache;
+    }
+
+    size_t capacity() const {
+        return mCapacity;
+    }
+
+    std::shared_ptr<const std::vector<uint8_t>> lookup(const Key &key) {
+        Mutex::Autolock autoLock(mLock);
+        for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+            if (it->first == key) {
+                mEntries.splice(mEntries.begin(), mEntries, it);
+                return it->second;
+            }
+        }
+        return nullptr;
+    }
+
+    void insert(const Key &key, const std::shared_ptr<const std::vector<uint8_t>> &data) {
+        Mutex::Autolock autoLock(mLock);
+        if (data->size() > mCapacity) {
+            return;
+        }
+        for (const auto &entry : mEntries) {
+            if (entry.first == key) {
+                return;
+            }
+        }
+        mEntries.emplace_front(key, data);
+        mSize += data->size();
+        while (mSize > mCapacity) {
+            mSize -= mEntries.back().second->size();
+            mEntries.pop_back();
+        }
+    }
+
+    static uint64_t Hash(uint64_t hash, const uint8_t *data, size_t size) {
+        // FNV-1a. The multiplication is meant to wrap; go through the builtin so
+        // that the unsigned-integer-overflow sanitizer does not trap on it.
+        for (size_t i = 0; i < size; ++i) {
+            (void)__builtin_mul_overflow(hash ^ data[i], 0x100000001b3ull, &hash);
+        }
+        return hash;
+    }
+
+    static const uint64_t kHashSeed = 0xcbf29ce484222325ull;
+
+private:
+    MetadataBoxCache() : mCapacity(0), mSize(0) {
+#ifdef __ANDROID__
+        char value[PROP_VALUE_MAX];
+        if (__system_property_get("media.stagefright.mp4.box_cache_kb", value) > 0) {
+            mCapacity = strtoul(value, NULL, 10) * 1024;
+        }
+#endif
+    }
+
+    Mutex mLock;
+    size_t mCapacity;
+    size_t mSize;
+    std::list<std::pair<Key, std::shared_ptr<const std::vector<uint8_t>>>> mEntries;
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 
 static const bool kUseHexDump = false;
@@ -442,6 +574,10 @@ MPEG4Extractor::MPEG4Extractor(DataSourceHelper *source, const char *mime)
       mHasMoovBox(false),
       mPreferHeif(mime != NULL && !strcasecmp(mime, MEDIA_MIMETYPE_CONTAINER_HEIF)),
       mIsAvif(false),
+      mFileHashState(0),
+      mFileSize(0),
+      mFileHash(0),
+      mMoovInMemory(false),
       mFirstTrack(NULL),
       mLastTrack(NULL) {
     ALOGV("mime=%s, mPreferHeif=%d", mime, mPreferHeif);
@@ -669,6 +805,73 @@ media_status_t MPEG4Extractor::getTrackMetaData(
     return AMediaFormat_copy(meta, track->meta);
 }
 
+// Hashes the start of the file once, as part of the key of cached boxes.
+bool MPEG4Extractor::getFileHash(off64_t *fileSize, uint64_t *fileHash) {
+    if (mFileHashState == 0) {
+        mFileHashState = -1;
+        uint8_t buffer[MetadataBoxCache::kHashSize];
+        off64_t size;
+        if (mDataSource->getSize(&size) == OK && size > 0) {
+            size_t n = std::min((off64_t)sizeof(buffer), size);
+            if (mDataSource->readAt(0, buffer, n) == (ssize_t)n) {
+                mFileSize = size;
+                mFileHash = MetadataBoxCache::Hash(MetadataBoxCache::kHashSeed, buffer, n);
+                mFileHashState = 1;
+            }
+        }
+    }
+    *fileSize = mFileSize;
+    *fileHash = mFileHash;
+    return mFileHashState > 0;
+}
+
+// Makes the top-level box at |offset| readable from memory, reusing the data
+// from an earlier open of the same file if possible. Returns true if the box
+// is now served from memory.
+bool MPEG4Extractor::useCachedMetadataBox(off64_t offset, uint64_t size) {
+    MetadataBoxCache &cache = MetadataBoxCache::Get();
+    if (size > cache.capacity()) {
+        return false;
+    }
+
+    MetadataBoxCache::Key key;
+    if (!getFileHash(&key.fileSize, &key.fileHash)) {
+        return false;
+    }
+    key.offset = offset;
+    key.size = size;
+
+    // Hash both ends of the box. Reading it whole is only worth it on a miss.
+    uint8_t buffer[MetadataBoxCache::kHashSize];
+    size_t n = std::min((uint64_t)sizeof(buffer), size);
+    if (mDataSource->readAt(offset, buffer, n) != (ssize_t)n) {
+        return false;
+    }
+    key.boxHash = MetadataBoxCache::Hash(MetadataBoxCache::kHashSeed, buffer, n);
+    if (mDataSource->readAt(offset + size - n, buffer, n) != (ssize_t)n) {
+        return false;
+    }
+    key.boxHash = MetadataBoxCache::Hash(key.boxHash, buffer, n);
+
+    std::shared_ptr<const std::vector<uint8_t>> data = cache.lookup(key);
+    if (data == nullptr) {
+        std::shared_ptr<std::vector<uint8_t>> box = std::make_shared<std::vector<uint8_t>>();
+        box->resize(size);
+        if (mDataSource->readAt(offset, box->data(), size) != (ssize_t)size) {
+            return false;
+        }
+        data = box;
+        cache.insert(key, data);
+    } else {
+        ALOGV("using cached box @ %lld, %" PRIu64 " bytes", (long long)offset, size);
+    }
+
+    CachedRangedDataSource *cachedSource = new CachedRangedDataSource(mDataSource);
+    cachedSource->setSharedRange(offset, data);
+    mDataSource = cachedSource;
+    return true;
+}
+
 status_t MPEG4Extractor::readMetaData() {
     if (mInitCheck != NO_INIT) {
         return mInitCheck;
@@ -945,6 +1148,12 @@ status_t MPEG4Extractor::parseChunk(off64_t *offset, int depth) {
         return ERROR_MALFORMED;
     }
 
+    if (depth == 0 && (chunk_type == FOURCC("moov") || chunk_type == FOURCC("sidx"))
+            && useCachedMetadataBox(*offset, chunk_size)
+            && chunk_type == FOURCC("moov")) {
+        mMoovInMemory = true;
+    }
+
     if (chunk_type != FOURCC("cprt")
             && chunk_type != FOURCC("covr")
             && mPath.size() == 5 && underMetaDataPath(mPath)) {
@@ -1001,7 +1210,7 @@ status_t MPEG4Extractor::parseChunk(off64_t *offset, int depth) {
             if (chunk_type == FOURCC("stbl")) {
                 ALOGV("sampleTable chunk is %" PRIu64 " bytes long.", chunk_size);
 
-                if (mDataSource->flags()
+                if (!mMoovInMemory && mDataSource->flags()
                         & (DataSourceBase::kWantsPrefetching
                             | DataSourceBase::kIsCachingDataSource)) {
                     CachedRangedDataSource *cachedSource =
@@ -5100,6 +5309,7 @@ MPEG4Source::MPEG4Source(
       mCurrentMoofSize(0),
       mNextMoofOffset(-1),
       mCurrentTime(0),
+      mFragmentsComplete(false),
       mDefaultEncryptedByteBlock(0),
       mDefaultSkipByteBlock(0),
       mCurrentSampleInfoAllocSize(0),
@@ -5238,12 +5448,76 @@ MPEG4Source::MPEG4Source(
 
 status_t MPEG4Source::init() {
     if (mFirstMoofOffset != 0) {
+        addFragment(mFirstMoofOffset, 0);
         off64_t offset = mFirstMoofOffset;
         return parseChunk(&offset);
     }
     return OK;
 }
 
+// Records the fragment at |moofOffset| if it directly follows the last one
+// indexed so far.
+void MPEG4Source::addFragment(off64_t moofOffset, uint64_t startTime) {
+    if (mFragmentsComplete) {
+        return;
+    }
+    if (!mFragments.empty() && moofOffset <= mFragments.top().mMoofOffset) {
+        return;
+    }
+    FragmentInfo info;
+    info.mMoofOffset = moofOffset;
+    info.mStartTime = startTime;
+    mFragments.push_back(info);
+}
+
+// Returns the index of the fragment to seek to for |time|, indexing more
+// fragments first if |time| is past the last one indexed so far.
+size_t MPEG4Source::findFragment(uint64_t time, ReadOptions::SeekMode mode) {
+    // Parse forward from the last indexed fragment. This leaves the current
+    // fragment state stale; the caller parses the chosen fragment again.
+    while (!mFragmentsComplete && mFragments.top().mStartTime <= time) {
+        const FragmentInfo &last = mFragments.top();
+        off64_t offset = last.mMoofOffset;
+        mCurrentMoofOffset = offset;
+        mNextMoofOffset = -1;
+        mCurrentSamples.clear();
+        mCurrentSampleIndex = 0;
+        if (parseChunk(&offset) != OK || mNextMoofOffset <= mCurrentMoofOffset) {
+            mFragmentsComplete = true;
+            break;
+        }
+        uint64_t duration = 0;
+        for (size_t i = 0; i < mCurrentSamples.size(); ++i) {
+            duration += mCurrentSamples[i].duration;
+        }
+        addFragment(mNextMoofOffset, last.mStartTime + duration);
+    }
+
+    size_t left = 0;
+    size_t right_plus_one = mFragments.size();
+    while (left < right_plus_one) {
+        size_t center = left + (right_plus_one - left) / 2;
+        if (time < mFragments[center].mStartTime) {
+            right_plus_one = center;
+        } else {
+            left = center + 1;
+        }
+    }
+    size_t index = left > 0 ? left - 1 : 0;
+
+    // Fragments start with a sync sample, like sidx segments.
+    if (index + 1 < mFragments.size()) {
+        uint64_t startTime = mFragments[index].mStartTime;
+        uint64_t endTime = mFragments[index + 1].mStartTime;
+        if ((mode == ReadOptions::SEEK_NEXT_SYNC && time > startTime) ||
+            (mode == ReadOptions::SEEK_CLOSEST_SYNC &&
+            time > startTime && time - startTime > endTime - time)) {
+            ++index;
+        }
+    }
+    return index;
+}
+
 MPEG4Source::~MPEG4Source() {
     if (mStarted) {
         stop();
@@ -6698,6 +6972,20 @@ media_status_t MPEG4Source::fragmentedRead(
                 return AMEDIA_ERROR_UNKNOWN;
             }
             mCurrentTime = totalTime * mTimescale / 1000000ll;
+        } else if (!mFragments.empty()) {
+            // without sidx boxes, use the fragments indexed so far
+            uint64_t seekTime = seekTimeUs > 0 ? seekTimeUs * mTimescale / 1000000ll : 0;
+            const FragmentInfo &fragment = mFragments[findFragment(seekTime, mode)];
+            mCurrentMoofOffset = fragment.mMoofOffset;
+            mNextMoofOffset = -1;
+            mCurrentSamples.clear();
+            mCurrentSampleIndex = 0;
+            off64_t tmp = mCurrentMoofOffset;
+            status_t err = parseChunk(&tmp);
+            if (err != OK) {
+                return AMEDIA_ERROR_UNKNOWN;
+            }
+            mCurrentTime = fragment.mStartTime;
         } else {
             // without sidx boxes, we can only seek to 0
             mCurrentMoofOffset = mFirstMoofOffset;
@@ -6734,9 +7022,21 @@ media_status_t MPEG4Source::fragmentedRead(
         }
         if (mCurrentSampleIndex >= mCurrentSamples.size()) {
             // move to next fragment if there is one
+            bool isLastIndexed = mSegments.empty() && !mFragments.empty()
+                    && mFragments.top().mMoofOffset == mCurrentMoofOffset;
             if (mNextMoofOffset <= mCurrentMoofOffset) {
+                if (isLastIndexed) {
+                    mFragmentsComplete = true;
+                }
                 return AMEDIA_ERROR_END_OF_STREAM;
             }
+            if (isLastIndexed) {
+                uint64_t duration = 0;
+                for (size_t i = 0; i < mCurrentSamples.size(); ++i) {
+                    duration += mCurrentSamples[i].duration;
+                }
+                addFragment(mNextMoofOffset, mFragments.top().mStartTime + duration);
+            }
             off64_t nextMoof = mNextMoofOffset;
             mCurrentMoofOffset = nextMoof;
             mCurrentSamples.clear();
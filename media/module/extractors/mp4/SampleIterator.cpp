@@ -22,6 +22,8 @@
 
 #include <arpa/inet.h>
 
+#include <algorithm>
+
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/ByteUtils.h>
 
@@ -32,6 +34,10 @@ namespace android {
 SampleIterator::SampleIterator(SampleTable *table)
     : mTable(table),
       mInitialized(false),
+      mPartialSumSampleIndex(0),
+      mPartialSumOffset(0),
+      mChunkOffsetCacheStart(0),
+      mChunkOffsetCacheCount(0),
       mTimeToSampleIndex(0),
       mTTSSampleIndex(0),
       mTTSSampleTime(0),
@@ -99,41 +105,33 @@ status_t SampleIterator::seekTo(uint32_t sampleIndex) {
             return err;
         }
 
-        mCurrentChunkSampleSizes.clear();
-
         uint32_t firstChunkSampleIndex =
             mFirstChunkSampleIndex
                 + mSamplesPerChunk * (chunk - mFirstChunk);
 
-        for (uint32_t i = 0; i < mSamplesPerChunk; ++i) {
-            size_t sampleSize;
-            if ((err = getSampleSizeDirect(
-                            firstChunkSampleIndex + i, &sampleSize)) != OK) {
-                ALOGE("getSampleSizeDirect return error");
-                // stsc sample count is not sync with stsz sample count
-                if (err == ERROR_OUT_OF_RANGE) {
-                    ALOGW("stsc samples(%d) not sync with stsz samples(%d)", mSamplesPerChunk, i);
-                    mSamplesPerChunk = i;
-                    break;
-                } else{
-                    mCurrentChunkSampleSizes.clear();
-                    return err;
-                }
-            }
-
-            mCurrentChunkSampleSizes.push(sampleSize);
+        if ((err = getChunkSampleSizes(firstChunkSampleIndex, mSamplesPerChunk)) != OK) {
+            ALOGE("getChunkSampleSizes return error");
+            mInitialized = false;
+            return err;
         }
 
         mCurrentChunkIndex = chunk;
+        mPartialSumSampleIndex = 0;
+        mPartialSumOffset = mCurrentChunkOffset;
     }
 
     uint32_t chunkRelativeSampleIndex =
         (sampleIndex - mFirstChunkSampleIndex) % mSamplesPerChunk;
 
-    mCurrentSampleOffset = mCurrentChunkOffset;
-    for (uint32_t i = 0; i < chunkRelativeSampleIndex; ++i) {
-        mCurrentSampleOffset += mCurrentChunkSampleSizes[i];
+    // Sequential access continues from the last sample's offset.
+    if (chunkRelativeSampleIndex < mPartialSumSampleIndex) {
+        mPartialSumSampleIndex = 0;
+        mPartialSumOffset = mCurrentChunkOffset;
     }
+    for (; mPartialSumSampleIndex < chunkRelativeSampleIndex; ++mPartialSumSampleIndex) {
+        mPartialSumOffset += mCurrentChunkSampleSizes[mPartialSumSampleIndex];
+    }
+    mCurrentSampleOffset = mPartialSumOffset;
 
     mCurrentSampleSize = mCurrentChunkSampleSizes[chunkRelativeSampleIndex];
     if (sampleIndex < mTTSSampleIndex) {
@@ -206,29 +204,148 @@ status_t SampleIterator::getChunkOffset(uint32_t chunk, off64_t *offset) {
         return ERROR_OUT_OF_RANGE;
     }
 
+    if (chunk >= mChunkOffsetCacheStart
+            && chunk - mChunkOffsetCacheStart < mChunkOffsetCacheCount) {
+        *offset = mChunkOffsetCache[chunk - mChunkOffsetCacheStart];
+        return OK;
+    }
+
+    mChunkOffsetCacheStart = chunk;
+    mChunkOffsetCacheCount = 0;
+
+    uint32_t count = mTable->mNumChunkOffsets - chunk;
+    if (count > kChunkOffsetCacheSize) {
+        count = kChunkOffsetCacheSize;
+    }
     if (mTable->mChunkOffsetType == SampleTable::kChunkOffsetType32) {
-        uint32_t offset32;
+        uint32_t offsets32[kChunkOffsetCacheSize];
 
-        if (mTable->mDataSource->readAt(
-                    mTable->mChunkOffsetOffset + 8 + 4 * chunk,
-                    &offset32,
-                    sizeof(offset32)) < (ssize_t)sizeof(offset32)) {
+        ssize_t n = mTable->mDataSource->readAt(
+                mTable->mChunkOffsetOffset + 8 + 4 * (off64_t)chunk,
+                offsets32,
+                count * sizeof(uint32_t));
+        if (n < (ssize_t)sizeof(uint32_t)) {
             return ERROR_IO;
         }
 
-        *offset = ntohl(offset32);
+        count = std::min(count, (uint32_t)(n / sizeof(uint32_t)));
+        for (uint32_t i = 0; i < count; ++i) {
+            mChunkOffsetCache[i] = ntohl(offsets32[i]);
+        }
     } else {
         CHECK_EQ(mTable->mChunkOffsetType, SampleTable::kChunkOffsetType64);
 
-        uint64_t offset64;
-        if (mTable->mDataSource->readAt(
-                    mTable->mChunkOffsetOffset + 8 + 8 * chunk,
-                    &offset64,
-                    sizeof(offset64)) < (ssize_t)sizeof(offset64)) {
+        uint64_t offsets64[kChunkOffsetCacheSize];
+        ssize_t n = mTable->mDataSource->readAt(
+                mTable->mChunkOffsetOffset + 8 + 8 * (off64_t)chunk,
+                offsets64,
+                count * sizeof(uint64_t));
+        if (n < (ssize_t)sizeof(uint64_t)) {
             return ERROR_IO;
         }
 
-        *offset = ntoh64(offset64);
+        count = std::min(count, (uint32_t)(n / sizeof(uint64_t)));
+        for (uint32_t i = 0; i < count; ++i) {
+            mChunkOffsetCache[i] = ntoh64(offsets64[i]);
+        }
+    }
+    mChunkOffsetCacheCount = count;
+
+    *offset = mChunkOffsetCache[0];
+    return OK;
+}
+
+// Reads the sizes of |count| samples starting at |firstSampleIndex| into
+// mCurrentChunkSampleSizes with as few reads as possible. If the sample size
+// table ends first, mSamplesPerChunk is truncated to the samples it covers.
+status_t SampleIterator::getChunkSampleSizes(uint32_t firstSampleIndex, uint32_t count) {
+    mCurrentChunkSampleSizes.clear();
+
+    if (firstSampleIndex >= mTable->mNumSampleSizes) {
+        return ERROR_OUT_OF_RANGE;
+    }
+    if (count > mTable->mNumSampleSizes - firstSampleIndex) {
+        // stsc sample count is not sync with stsz sample count
+        ALOGW("stsc samples(%d) not sync with stsz samples(%d)",
+                count, mTable->mNumSampleSizes - firstSampleIndex);
+        count = mTable->mNumSampleSizes - firstSampleIndex;
+        mSamplesPerChunk = count;
+    }
+
+    if (mTable->mDefaultSampleSize > 0) {
+        mCurrentChunkSampleSizes.insertAt(mTable->mDefaultSampleSize, 0, count);
+        return OK;
+    }
+
+    mCurrentChunkSampleSizes.insertAt(0, 0, count);
+    uint32_t *sizes = mCurrentChunkSampleSizes.editArray();
+
+    // Entries are read in blocks and byte-swapped in tight loops that the
+    // compiler vectorizes.
+    static const size_t kBlockSize = 4096;
+    union {
+        uint32_t u32[kBlockSize / 4];
+        uint16_t u16[kBlockSize / 2];
+        uint8_t u8[kBlockSize];
+    } block;
+
+    const uint32_t fieldSize = mTable->mSampleSizeFieldSize;
+    const uint32_t entriesPerBlock = kBlockSize * 8 / fieldSize;
+    uint32_t done = 0;
+    while (done < count) {
+        uint32_t sampleIndex = firstSampleIndex + done;
+        uint32_t n = std::min(count - done, entriesPerBlock);
+        off64_t offset;
+        size_t size;
+        if (fieldSize == 4) {
+            // Keep whole bytes: start at an even sample and read one more if needed.
+            uint32_t first = sampleIndex & ~1u;
+            offset = mTable->mSampleSizeOffset + 12 + first / 2;
+            size = (sampleIndex + n - first + 1) / 2;
+            if (size > kBlockSize) {
+                n -= 2;
+                size = (sampleIndex + n - first + 1) / 2;
+            }
+        } else {
+            offset = mTable->mSampleSizeOffset + 12 + (off64_t)sampleIndex * (fieldSize / 8);
+            size = (size_t)n * (fieldSize / 8);
+        }
+
+        if (mTable->mDataSource->readAt(offset, block.u8, size) < (ssize_t)size) {
+            mCurrentChunkSampleSizes.clear();
+            return ERROR_IO;
+        }
+
+        uint32_t *out = sizes + done;
+        switch (fieldSize) {
+            case 32:
+                for (uint32_t i = 0; i < n; ++i) {
+                    out[i] = ntohl(block.u32[i]);
+                }
+                break;
+            case 16:
+                for (uint32_t i = 0; i < n; ++i) {
+                    out[i] = ntohs(block.u16[i]);
+                }
+                break;
+            case 8:
+                for (uint32_t i = 0; i < n; ++i) {
+                    out[i] = block.u8[i];
+                }
+                break;
+            default:
+            {
+                CHECK_EQ(fieldSize, 4u);
+                uint32_t skip = sampleIndex & 1;
+                for (uint32_t i = 0; i < n; ++i) {
+                    uint32_t j = i + skip;
+                    uint8_t x = block.u8[j / 2];
+                    out[i] = (j & 1) ? x & 0x0f : x >> 4;
+                }
+                break;
+            }
+        }
+        done += n;
     }
 
     return OK;
@@ -18,7 +18,9 @@
 //#define LOG_NDEBUG 0
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <limits>
+#include <vector>
 
 #include "SampleTable.h"
 #include "SampleIterator.h"
@@ -129,6 +131,10 @@ SampleTable::SampleTable(DataSourceHelper *source)
       mTimeToSampleCount(0),
       mTimeToSample(NULL),
       mSampleTimeEntries(NULL),
+      mSegments(NULL),
+      mNumSegments(0),
+      mMaxSegmentSize(0),
+      mLastCachedSegment(0),
       mCompositionTimeDeltaEntries(NULL),
       mNumCompositionTimeDeltaEntries(0),
       mCompositionDeltaLookup(new CompositionDeltaLookup),
@@ -138,6 +144,10 @@ SampleTable::SampleTable(DataSourceHelper *source)
       mLastSyncSampleIndex(0),
       mSampleToChunkEntries(NULL),
       mTotalSize(0) {
+    for (size_t i = 0; i < kNumCachedSegments; ++i) {
+        mCachedSegments[i].mSegment = UINT32_MAX;
+        mCachedSegments[i].mEntries = NULL;
+    }
     mSampleIterator = new SampleIterator(this);
 }
 
@@ -160,6 +170,14 @@ SampleTable::~SampleTable() {
     delete[] mSampleTimeEntries;
     mSampleTimeEntries = NULL;
 
+    delete[] mSegments;
+    mSegments = NULL;
+
+    for (size_t i = 0; i < kNumCachedSegments; ++i) {
+        delete[] mCachedSegments[i].mEntries;
+        mCachedSegments[i].mEntries = NULL;
+    }
+
     delete mSampleIterator;
     mSampleIterator = NULL;
 }
@@ -615,6 +633,42 @@ uint32_t abs_difference(uint64_t time1, uint64_t time2) {
     return time1 > time2 ? time1 - time2 : time2 - time1;
 }
 
+// Returns the composition time of a sample decoded at |*sampleTime|. On
+// overflow the decode time itself is clamped, and later samples follow it.
+static uint64_t applyCompositionOffset(uint64_t *sampleTime, int32_t compTimeDelta) {
+    if ((compTimeDelta < 0 && *sampleTime <
+            (compTimeDelta == INT32_MIN ?
+                    INT32_MAX : uint32_t(-compTimeDelta)))
+            || (compTimeDelta > 0 &&
+                    *sampleTime > UINT64_MAX - compTimeDelta)) {
+        ALOGE("%llu + %d would overflow, clamping",
+                (unsigned long long) *sampleTime, compTimeDelta);
+        if (compTimeDelta < 0) {
+            *sampleTime = 0;
+        } else {
+            *sampleTime = UINT64_MAX;
+        }
+        compTimeDelta = 0;
+    }
+
+    return compTimeDelta > 0 ? *sampleTime + compTimeDelta:
+            *sampleTime - (-compTimeDelta);
+}
+
+static void advanceSampleTime(uint64_t *sampleTime, uint32_t delta) {
+    if (*sampleTime > UINT64_MAX - delta) {
+        ALOGE("%llu + %u would overflow, clamping",
+            (unsigned long long) *sampleTime, delta);
+        *sampleTime = UINT64_MAX;
+    } else {
+        *sampleTime += delta;
+    }
+}
+
+static uint64_t scaleTime(uint64_t time, uint64_t scale_num, uint64_t scale_den) {
+    return scale_den != 0 ? (time * scale_num) / scale_den : 0;
+}
+
 // static
 int SampleTable::CompareIncreasingTime(const void *_a, const void *_b) {
     const SampleTimeEntry *a = (const SampleTimeEntry *)_a;
@@ -629,16 +683,218 @@ int SampleTable::CompareIncreasingTime(const void *_a, const void *_b) {
     return 0;
 }
 
+// Returns the composition time of the sample at |cursor| and moves the cursor
+// to the next sample. The time-to-sample table must cover that sample.
+uint64_t SampleTable::nextCompositionTime(SampleTimeCursor *cursor) const {
+    while (cursor->mTimeToSampleOffset >= mTimeToSample[2 * cursor->mTimeToSampleEntry]) {
+        ++cursor->mTimeToSampleEntry;
+        cursor->mTimeToSampleOffset = 0;
+    }
+
+    // Same as CompositionDeltaLookup, but resumable from any cursor.
+    int32_t compTimeDelta = 0;
+    while (mCompositionTimeDeltaEntries != NULL
+            && cursor->mCompositionDeltaEntry < mNumCompositionTimeDeltaEntries) {
+        uint32_t sampleCount =
+            mCompositionTimeDeltaEntries[2 * cursor->mCompositionDeltaEntry];
+        if (cursor->mSampleIndex < cursor->mCompositionDeltaSampleIndex + sampleCount) {
+            compTimeDelta =
+                mCompositionTimeDeltaEntries[2 * cursor->mCompositionDeltaEntry + 1];
+            break;
+        }
+        cursor->mCompositionDeltaSampleIndex += sampleCount;
+        ++cursor->mCompositionDeltaEntry;
+    }
+
+    uint64_t compositionTime =
+        applyCompositionOffset(&cursor->mSampleTime, compTimeDelta);
+
+    advanceSampleTime(
+            &cursor->mSampleTime, mTimeToSample[2 * cursor->mTimeToSampleEntry + 1]);
+    ++cursor->mTimeToSampleOffset;
+    ++cursor->mSampleIndex;
+
+    return compositionTime;
+}
+
+// Splits the samples into segments that each sort into their own range of the
+// composition-ordered table, so that only the segments being searched have
+// to be expanded and sorted. Returns false if the track does not split well,
+// in which case the full table should be built instead.
+bool SampleTable::buildSampleSegments_l() {
+    uint64_t numTimedSamples = 0;
+    for (uint32_t i = 0; i < mTimeToSampleCount; ++i) {
+        numTimedSamples += mTimeToSample[2 * i];
+    }
+    if (numTimedSamples < mNumSampleSizes) {
+        // Leave malformed tables to buildSampleEntriesTable().
+        return false;
+    }
+
+    // Every kSegmentCutStride samples, propose a cut. A cut is valid if no
+    // later sample has an earlier composition time than any sample before
+    // it. Composition times of later samples only ever invalidate the most
+    // recent proposals, so the pending cuts form a stack, each entry
+    // tracking the smallest composition time up to the next entry.
+    struct Cut {
+        SampleSegment mSegment;
+        uint64_t mMaxPrecedingTime;
+    };
+    std::vector<Cut> cuts;
+    cuts.reserve(mNumSampleSizes / kSegmentCutStride + 1);
+
+    SampleTimeCursor cursor;
+    memset(&cursor, 0, sizeof(cursor));
+    uint64_t maxTime = 0;
+    for (uint32_t i = 0; i < mNumSampleSizes; ++i) {
+        if (i % kSegmentCutStride == 0) {
+            Cut cut;
+            cut.mSegment.mStart = cursor;
+            cut.mSegment.mMinCompositionTime = UINT64_MAX;
+            cut.mMaxPrecedingTime = maxTime;
+            cuts.push_back(cut);
+        }
+
+        uint64_t compositionTime = nextCompositionTime(&cursor);
+        while (cuts.size() > 1 && cuts.back().mMaxPrecedingTime > compositionTime) {
+            uint64_t minTime = cuts.back().mSegment.mMinCompositionTime;
+            cuts.pop_back();
+            if (minTime < cuts.back().mSegment.mMinCompositionTime) {
+                cuts.back().mSegment.mMinCompositionTime = minTime;
+            }
+        }
+        if (compositionTime < cuts.back().mSegment.mMinCompositionTime) {
+            cuts.back().mSegment.mMinCompositionTime = compositionTime;
+        }
+        if (compositionTime > maxTime) {
+            maxTime = compositionTime;
+        }
+    }
+
+    // Merge the remaining cuts into segments of at least kMinSegmentSamples.
+    std::vector<SampleSegment> segments;
+    for (size_t i = 0; i < cuts.size(); ++i) {
+        const SampleSegment &segment = cuts[i].mSegment;
+        if (segments.empty() || segment.mStart.mSampleIndex
+                - segments.back().mStart.mSampleIndex >= kMinSegmentSamples) {
+            segments.push_back(segment);
+        } else if (segment.mMinCompositionTime < segments.back().mMinCompositionTime) {
+            segments.back().mMinCompositionTime = segment.mMinCompositionTime;
+        }
+    }
+
+    uint32_t maxSegmentSize = 0;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        uint32_t end = i + 1 < segments.size()
+                ? segments[i + 1].mStart.mSampleIndex : mNumSampleSizes;
+        uint32_t size = end - segments[i].mStart.mSampleIndex;
+        if (size > maxSegmentSize) {
+            maxSegmentSize = size;
+        }
+    }
+    if (maxSegmentSize > kMaxSegmentSamples) {
+        ALOGV("composition order does not split into segments (%u samples)",
+                maxSegmentSize);
+        return false;
+    }
+
+    uint64_t allocSize = (uint64_t)segments.size() * sizeof(SampleSegment)
+            + (uint64_t)kNumCachedSegments * maxSegmentSize * sizeof(SampleTimeEntry);
+    if (mTotalSize + allocSize > kMaxTotalSize) {
+        return false;
+    }
+
+    mSegments = new (std::nothrow) SampleSegment[segments.size()];
+    if (!mSegments) {
+        return false;
+    }
+    for (size_t i = 0; i < kNumCachedSegments; ++i) {
+        mCachedSegments[i].mEntries = new (std::nothrow) SampleTimeEntry[maxSegmentSize];
+        if (!mCachedSegments[i].mEntries) {
+            for (size_t j = 0; j < i; ++j) {
+                delete[] mCachedSegments[j].mEntries;
+                mCachedSegments[j].mEntries = NULL;
+            }
+            delete[] mSegments;
+            mSegments = NULL;
+            return false;
+        }
+    }
+
+    std::copy(segments.begin(), segments.end(), mSegments);
+    mNumSegments = segments.size();
+    mMaxSegmentSize = maxSegmentSize;
+    mTotalSize += allocSize;
+
+    ALOGV("split %u samples into %u segments of up to %u samples",
+            mNumSampleSizes, mNumSegments, mMaxSegmentSize);
+    return true;
+}
+
+uint32_t SampleTable::getSegmentSize(uint32_t segment) const {
+    uint32_t end = segment + 1 < mNumSegments
+            ? mSegments[segment + 1].mStart.mSampleIndex : mNumSampleSizes;
+    return end - mSegments[segment].mStart.mSampleIndex;
+}
+
+// Returns the entries of |segment| in composition order, expanding them from
+// the time-to-sample and composition offset tables if not already cached.
+const SampleTable::SampleTimeEntry *SampleTable::getSegmentEntries_l(uint32_t segment) {
+    for (size_t i = 0; i < kNumCachedSegments; ++i) {
+        if (mCachedSegments[i].mSegment == segment) {
+            mLastCachedSegment = i;
+            return mCachedSegments[i].mEntries;
+        }
+    }
+
+    // Replace the least recently used segment.
+    mLastCachedSegment = (mLastCachedSegment + 1) % kNumCachedSegments;
+    CachedSegment *cached = &mCachedSegments[mLastCachedSegment];
+
+    SampleTimeCursor cursor = mSegments[segment].mStart;
+    uint32_t size = getSegmentSize(segment);
+    for (uint32_t i = 0; i < size; ++i) {
+        cached->mEntries[i].mSampleIndex = cursor.mSampleIndex;
+        cached->mEntries[i].mCompositionTime = nextCompositionTime(&cursor);
+    }
+    qsort(cached->mEntries, size, sizeof(SampleTimeEntry), CompareIncreasingTime);
+    cached->mSegment = segment;
+
+    return cached->mEntries;
+}
+
+// Returns the |index|-th sample entry in composition order.
+const SampleTable::SampleTimeEntry &SampleTable::getSortedSampleEntry_l(uint32_t index) {
+    uint32_t left = 0;
+    uint32_t right_plus_one = mNumSegments;
+    while (left < right_plus_one) {
+        uint32_t center = left + (right_plus_one - left) / 2;
+        if (index < mSegments[center].mStart.mSampleIndex) {
+            right_plus_one = center;
+        } else {
+            left = center + 1;
+        }
+    }
+
+    // The first segment starts at sample 0, so left > 0.
+    uint32_t segment = left - 1;
+    return getSegmentEntries_l(segment)[index - mSegments[segment].mStart.mSampleIndex];
+}
+
 void SampleTable::buildSampleEntriesTable() {
     Mutex::Autolock autoLock(mLock);
 
-    if (mSampleTimeEntries != NULL || mNumSampleSizes == 0) {
+    if (mSampleTimeEntries != NULL || mSegments != NULL || mNumSampleSizes == 0) {
         if (mNumSampleSizes == 0) {
             ALOGE("b/23247055, mNumSampleSizes(%u)", mNumSampleSizes);
         }
         return;
     }
 
+    if (mNumSampleSizes > kSegmentedSampleThreshold && buildSampleSegments_l()) {
+        return;
+    }
+
     mTotalSize += (uint64_t)mNumSampleSizes * sizeof(SampleTimeEntry);
     if (mTotalSize > kMaxTotalSize) {
         ALOGE("Sample entry table size would make sample table too large.\n"
@@ -679,34 +935,12 @@ void SampleTable::buildSampleEntriesTable() {
                     mCompositionDeltaLookup->getCompositionTimeOffset(
                             sampleIndex);
 
-                if ((compTimeDelta < 0 && sampleTime <
-                        (compTimeDelta == INT32_MIN ?
-                                INT32_MAX : uint32_t(-compTimeDelta)))
-                        || (compTimeDelta > 0 &&
-                                sampleTime > UINT64_MAX - compTimeDelta)) {
-                    ALOGE("%llu + %d would overflow, clamping",
-                            (unsigned long long) sampleTime, compTimeDelta);
-                    if (compTimeDelta < 0) {
-                        sampleTime = 0;
-                    } else {
-                        sampleTime = UINT64_MAX;
-                    }
-                    compTimeDelta = 0;
-                }
-
                 mSampleTimeEntries[sampleIndex].mCompositionTime =
-                        compTimeDelta > 0 ? sampleTime + compTimeDelta:
-                                sampleTime - (-compTimeDelta);
+                        applyCompositionOffset(&sampleTime, compTimeDelta);
             }
 
             ++sampleIndex;
-            if (sampleTime > UINT64_MAX - delta) {
-                ALOGE("%llu + %u would overflow, clamping",
-                    (unsigned long long) sampleTime, delta);
-                sampleTime = UINT64_MAX;
-            } else {
-                sampleTime += delta;
-            }
+            advanceSampleTime(&sampleTime, delta);
         }
     }
 
@@ -719,6 +953,12 @@ status_t SampleTable::findSampleAtTime(
         uint32_t *sample_index, uint32_t flags) {
     buildSampleEntriesTable();
 
+    if (mSegments != NULL) {
+        Mutex::Autolock autoLock(mLock);
+        return findSampleAtTimeInSegments_l(
+                req_time, scale_num, scale_den, sample_index, flags);
+    }
+
     if (mSampleTimeEntries == NULL) {
         return ERROR_OUT_OF_RANGE;
     }
@@ -796,6 +1036,96 @@ status_t SampleTable::findSampleAtTime(
     return OK;
 }
 
+// Same as the search in findSampleAtTime(), but only expands the segments
+// adjacent to |req_time|.
+status_t SampleTable::findSampleAtTimeInSegments_l(
+        uint64_t req_time, uint64_t scale_num, uint64_t scale_den,
+        uint32_t *sample_index, uint32_t flags) {
+    if (flags == kFlagFrameIndex) {
+        if (req_time >= mNumSampleSizes) {
+            return ERROR_OUT_OF_RANGE;
+        }
+        *sample_index = getSortedSampleEntry_l(req_time).mSampleIndex;
+        return OK;
+    }
+
+    // Find the last segment that starts at or before req_time.
+    uint32_t left = 0;
+    uint32_t right_plus_one = mNumSegments;
+    while (left < right_plus_one) {
+        uint32_t center = left + (right_plus_one - left) / 2;
+        if (req_time < scaleTime(
+                mSegments[center].mMinCompositionTime, scale_num, scale_den)) {
+            right_plus_one = center;
+        } else {
+            left = center + 1;
+        }
+    }
+    uint32_t segment = left > 0 ? left - 1 : 0;
+
+    const SampleTimeEntry *entries = getSegmentEntries_l(segment);
+    left = 0;
+    right_plus_one = getSegmentSize(segment);
+    while (left < right_plus_one) {
+        uint32_t center = left + (right_plus_one - left) / 2;
+        uint64_t centerTime =
+            scaleTime(entries[center].mCompositionTime, scale_num, scale_den);
+
+        if (req_time < centerTime) {
+            right_plus_one = center;
+        } else if (req_time > centerTime) {
+            left = center + 1;
+        } else {
+            *sample_index = entries[center].mSampleIndex;
+            return OK;
+        }
+    }
+
+    uint32_t closestIndex = mSegments[segment].mStart.mSampleIndex + left;
+
+    if (closestIndex == mNumSampleSizes) {
+        if (flags == kFlagAfter) {
+            return ERROR_OUT_OF_RANGE;
+        }
+        flags = kFlagBefore;
+    } else if (closestIndex == 0) {
+        flags = kFlagAfter;
+    }
+
+    switch (flags) {
+        case kFlagBefore:
+        {
+            --closestIndex;
+            break;
+        }
+
+        case kFlagAfter:
+        {
+            // nothing to do
+            break;
+        }
+
+        default:
+        {
+            CHECK(flags == kFlagClosest);
+            uint64_t afterTime = scaleTime(
+                    getSortedSampleEntry_l(closestIndex).mCompositionTime,
+                    scale_num, scale_den);
+            uint64_t beforeTime = scaleTime(
+                    getSortedSampleEntry_l(closestIndex - 1).mCompositionTime,
+                    scale_num, scale_den);
+            if (abs_difference(afterTime, req_time) >
+                abs_difference(req_time, beforeTime)) {
+                --closestIndex;
+            }
+            break;
+        }
+    }
+
+    *sample_index = getSortedSampleEntry_l(closestIndex).mSampleIndex;
+    return OK;
+}
+
 status_t SampleTable::findSyncSampleNear(
         uint32_t start_sample_index, uint32_t *sample_index, uint32_t flags) {
     Mutex::Autolock autoLock(mLock);
@@ -146,6 +146,13 @@ private:
     bool mPreferHeif;
     bool mIsAvif;
 
+    // Identifies the file in the metadata box cache. mFileHashState is 0
+    // until computed, 1 once valid and -1 if the file cannot be cached.
+    int mFileHashState;
+    off64_t mFileSize;
+    uint64_t mFileHash;
+    bool mMoovInMemory;
+
     Track *mFirstTrack, *mLastTrack;
 
     AMediaFormat *mFileMetaData;
@@ -158,6 +165,8 @@ private:
     KeyedVector<uint32_t, AString> mMetaKeyMap;
 
     status_t readMetaData();
+    bool getFileHash(off64_t *fileSize, uint64_t *fileHash);
+    bool useCachedMetadataBox(off64_t offset, uint64_t size);
     status_t parseChunk(off64_t *offset, int depth);
     status_t parseITunesMetaData(off64_t offset, size_t size);
     status_t parseColorInfo(off64_t offset, size_t size);
@@ -59,7 +59,16 @@ private:
 
     uint32_t mCurrentChunkIndex;
     off64_t mCurrentChunkOffset;
-    Vector<size_t> mCurrentChunkSampleSizes;
+    Vector<uint32_t> mCurrentChunkSampleSizes;
+    // Offset of sample mPartialSumSampleIndex of the current chunk.
+    uint32_t mPartialSumSampleIndex;
+    off64_t mPartialSumOffset;
+
+    // Chunk offsets are decoded kChunkOffsetCacheSize at a time.
+    static const uint32_t kChunkOffsetCacheSize = 64;
+    uint32_t mChunkOffsetCacheStart;
+    uint32_t mChunkOffsetCacheCount;
+    off64_t mChunkOffsetCache[kChunkOffsetCacheSize];
 
     uint32_t mTimeToSampleIndex;
     uint32_t mTTSSampleIndex;
@@ -76,6 +85,7 @@ private:
     void reset();
     status_t findChunkRange(uint32_t sampleIndex);
     status_t getChunkOffset(uint32_t chunk, off64_t *offset);
+    status_t getChunkSampleSizes(uint32_t firstSampleIndex, uint32_t count);
     status_t findSampleTimeAndDuration(uint32_t sampleIndex, uint64_t *time, uint64_t *duration);
 
     SampleIterator(const SampleIterator &);
@@ -107,6 +107,15 @@ private:
     // Limit the total size of all internal tables to 200MiB.
     static const size_t kMaxTotalSize = 200 * (1 << 20);
 
+    // Tracks with more samples than this build the composition-ordered
+    // sample table one segment at a time instead of all at once.
+    static const uint32_t kSegmentedSampleThreshold = 1 << 18;
+    static const uint32_t kMinSegmentSamples = 4096;
+    static const uint32_t kMaxSegmentSamples = 16 * kMinSegmentSamples;
+    // Segment boundaries are only considered every this many samples.
+    static const uint32_t kSegmentCutStride = 256;
+    static const size_t kNumCachedSegments = 2;
+
     DataSourceHelper *mDataSource;
     Mutex mLock;
 
@@ -132,6 +141,33 @@ private:
     };
     SampleTimeEntry *mSampleTimeEntries;
 
+    // Position in the time-to-sample and composition offset tables.
+    struct SampleTimeCursor {
+        uint32_t mSampleIndex;
+        uint32_t mTimeToSampleEntry;
+        uint32_t mTimeToSampleOffset;
+        uint64_t mSampleTime;
+        size_t mCompositionDeltaEntry;
+        uint64_t mCompositionDeltaSampleIndex;
+    };
+
+    // A run of samples in decode order that occupies the same range of the
+    // composition-ordered table, i.e. no sample outside of it sorts in between.
+    struct SampleSegment {
+        SampleTimeCursor mStart;
+        uint64_t mMinCompositionTime;
+    };
+    SampleSegment *mSegments;
+    uint32_t mNumSegments;
+    uint32_t mMaxSegmentSize;
+
+    struct CachedSegment {
+        uint32_t mSegment;
+        SampleTimeEntry *mEntries;
+    };
+    CachedSegment mCachedSegments[kNumCachedSegments];
+    size_t mLastCachedSegment;
+
     int32_t *mCompositionTimeDeltaEntries;
     size_t mNumCompositionTimeDeltaEntries;
     CompositionDeltaLookup *mCompositionDeltaLookup;
@@ -170,6 +206,15 @@ private:
 
     void buildSampleEntriesTable();
 
+    uint64_t nextCompositionTime(SampleTimeCursor *cursor) const;
+    bool buildSampleSegments_l();
+    uint32_t getSegmentSize(uint32_t segment) const;
+    const SampleTimeEntry *getSegmentEntries_l(uint32_t segment);
+    const SampleTimeEntry &getSortedSampleEntry_l(uint32_t index);
+    status_t findSampleAtTimeInSegments_l(
+            uint64_t req_time, uint64_t scale_num, uint64_t scale_den,
+            uint32_t *sample_index, uint32_t flags);
+
     SampleTable(const SampleTable &);
     SampleTable &operator=(const SampleTable &);
 };
@@ -0,0 +1,191 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <SampleTable.h>
+#include <media/stagefright/foundation/ByteUtils.h>
+
+// Walks the sample table of a synthetic track the way MPEG4Source reads it, for
+// the table layouts of long audio recordings (many small samples per chunk).
+//
+// The first argument is the number of samples per chunk, the second the size
+// of the stsz/stz2 fields in bits. The "reads" counter is the number of data
+// source reads per sample, each of which is a binder call for most sources.
+//
+// To run:
+//   adb shell /data/benchmarktest64/SampleIteratorBenchmark/SampleIteratorBenchmark
+
+using namespace android;
+
+namespace {
+
+constexpr uint32_t kNumSamples = 200000;
+
+struct MemorySource {
+    std::vector<uint8_t> data;
+    size_t numReads = 0;
+
+    static ssize_t ReadAt(void *handle, off64_t offset, void *buffer, size_t size) {
+        MemorySource *source = static_cast<MemorySource *>(handle);
+        ++source->numReads;
+        if (offset < 0 || (size_t)offset >= source->data.size()) {
+            return 0;
+        }
+        size = std::min(size, source->data.size() - offset);
+        memcpy(buffer, source->data.data() + offset, size);
+        return size;
+    }
+
+    static status_t GetSize(void *handle, off64_t *size) {
+        *size = static_cast<MemorySource *>(handle)->data.size();
+        return OK;
+    }
+
+    static uint32_t Flags(void *) {
+        return 0;
+    }
+
+    static bool GetUri(void *, char *, size_t) {
+        return false;
+    }
+
+    void put32(uint32_t x) {
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            data.push_back(x >> shift);
+        }
+    }
+};
+
+struct Track {
+    MemorySource source;
+    CDataSource csource;
+    DataSourceHelper *helper;
+    sp<SampleTable> table;
+
+    Track(uint32_t samplesPerChunk, uint32_t fieldSize) {
+        const uint32_t numChunks = (kNumSamples + samplesPerChunk - 1) / samplesPerChunk;
+
+        off64_t stszOffset = source.data.size();
+        source.put32(0);
+        source.put32(fieldSize == 32 ? 0 : fieldSize);
+        source.put32(kNumSamples);
+        for (uint32_t i = 0; i < kNumSamples; ++i) {
+            uint32_t size = 200 + i % 50;
+            if (fieldSize == 32) {
+                source.put32(size);
+            } else if (fieldSize == 16) {
+                source.data.push_back(size >> 8);
+                source.data.push_back(size);
+            } else {
+                source.data.push_back(size);
+            }
+        }
+        size_t stszSize = source.data.size() - stszOffset;
+
+        off64_t stscOffset = source.data.size();
+        source.put32(0);
+        source.put32(1);
+        source.put32(1);
+        source.put32(samplesPerChunk);
+        source.put32(1);
+        size_t stscSize = source.data.size() - stscOffset;
+
+        off64_t stcoOffset = source.data.size();
+        source.put32(0);
+        source.put32(numChunks);
+        for (uint32_t i = 0; i < numChunks; ++i) {
+            source.put32(0x100000 + i * samplesPerChunk * 256);
+        }
+        size_t stcoSize = source.data.size() - stcoOffset;
+
+        off64_t sttsOffset = source.data.size();
+        source.put32(0);
+        source.put32(1);
+        source.put32(kNumSamples);
+        source.put32(1024);
+        size_t sttsSize = source.data.size() - sttsOffset;
+
+        csource.readAt = MemorySource::ReadAt;
+        csource.getSize = MemorySource::GetSize;
+        csource.flags = MemorySource::Flags;
+        csource.getUri = MemorySource::GetUri;
+        csource.handle = &source;
+        helper = new DataSourceHelper(&csource);
+
+        table = new SampleTable(helper);
+        table->setSampleSizeParams(
+                fieldSize == 32 ? FOURCC("stsz") : FOURCC("stz2"), stszOffset, stszSize);
+        table->setSampleToChunkParams(stscOffset, stscSize);
+        table->setChunkOffsetParams(FOURCC("stco"), stcoOffset, stcoSize);
+        table->setTimeToSampleParams(sttsOffset, sttsSize);
+    }
+
+    ~Track() {
+        table.clear();
+        delete helper;
+    }
+};
+
+void BM_SequentialRead(benchmark::State &state) {
+    Track track(state.range(0), state.range(1));
+    track.source.numReads = 0;
+    for (auto _ : state) {
+        for (uint32_t i = 0; i < kNumSamples; ++i) {
+            off64_t offset;
+            size_t size;
+            uint64_t time;
+            benchmark::DoNotOptimize(track.table->getMetaDataForSample(i, &offset, &size, &time));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kNumSamples);
+    state.counters["reads"] = (double)track.source.numReads / (state.iterations() * kNumSamples);
+}
+
+void BM_RandomSeek(benchmark::State &state) {
+    Track track(state.range(0), state.range(1));
+    uint32_t sample = 0;
+    for (auto _ : state) {
+        // Jump around the table, and read a few samples at each position.
+        sample = (sample + 7919 * 13) % kNumSamples;
+        for (uint32_t i = sample; i < sample + 8 && i < kNumSamples; ++i) {
+            off64_t offset;
+            size_t size;
+            uint64_t time;
+            benchmark::DoNotOptimize(track.table->getMetaDataForSample(i, &offset, &size, &time));
+        }
+    }
+}
+
+void TableLayouts(benchmark::internal::Benchmark *b) {
+    for (int samplesPerChunk : {1, 16, 64, 512}) {
+        for (int fieldSize : {8, 16, 32}) {
+            b->Args({samplesPerChunk, fieldSize});
+        }
+    }
+}
+
+}  // namespace
+
+BENCHMARK(BM_SequentialRead)->Apply(TableLayouts);
+BENCHMARK(BM_RandomSeek)->Apply(TableLayouts);
+
+BENCHMARK_MAIN();
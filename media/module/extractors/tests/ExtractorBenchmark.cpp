@@ -0,0 +1,314 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <datasource/FileSource.h>
+#include <media/stagefright/MediaBufferGroup.h>
+
+#include <AACExtractor.h>
+#include <FLACExtractor.h>
+#include <MatroskaExtractor.h>
+#include <MP3Extractor.h>
+#include <MPEG2TSExtractor.h>
+#include <MPEG4Extractor.h>
+#include <OggExtractor.h>
+#include <WAVExtractor.h>
+
+// Measures how fast the extractors open, demux and seek the clips of the
+// ExtractorUnitTest corpus. Besides time, each benchmark reports the number
+// of readAt() calls and bytes read from the data source, which is what
+// regresses first when an extractor starts re-reading its input.
+//
+// To run:
+//   adb push extractor-1.5 /data/local/tmp/
+//   adb shell /data/benchmarktest64/ExtractorBenchmark/ExtractorBenchmark \
+//           -P /data/local/tmp/extractor-1.5/
+
+using namespace android;
+
+namespace {
+
+std::string gRes = "/data/local/tmp/";
+
+enum Container {
+    AAC,
+    FLAC,
+    MKV,
+    MP3,
+    MPEG2TS,
+    MPEG4,
+    OGG,
+    WAV,
+};
+
+const struct Clip {
+    const char *name;
+    Container container;
+    const char *file;
+    bool seekable;
+} kClips[] = {
+        {"aac", AAC, "loudsoftaac.aac", true},
+        {"flac", FLAC, "sinesweepflac.flac", true},
+        {"mkv", MKV, "swirl_144x136_avc.mkv", true},
+        {"mkv_nocues", MKV, "withoutcues.mkv", true},
+        {"mp3", MP3, "sinesweepmp3lame.mp3", true},
+        {"mpeg2ts", MPEG2TS, "segment000001.ts", false},
+        {"mp4_audio", MPEG4, "sinesweepm4a.m4a", true},
+        {"mp4_av", MPEG4,
+         "video_480x360_mp4_hevc_650kbps_30fps_aac_stereo_128kbps_48000hz.mp4", true},
+        {"ogg", OGG, "john_cage.ogg", true},
+        {"wav", WAV, "loudsoftwav.wav", true},
+};
+
+// Counts what the extractor asks of the data source.
+class CountingSource : public DataSource {
+public:
+    explicit CountingSource(const sp<DataSource> &source) : mSource(source) {}
+
+    status_t initCheck() const override {
+        return mSource->initCheck();
+    }
+
+    ssize_t readAt(off64_t offset, void *data, size_t size) override {
+        ++mNumReads;
+        ssize_t n = mSource->readAt(offset, data, size);
+        if (n > 0) {
+            mNumBytes += n;
+        }
+        return n;
+    }
+
+    status_t getSize(off64_t *size) override {
+        return mSource->getSize(size);
+    }
+
+    uint32_t flags() override {
+        return mSource->flags();
+    }
+
+    size_t mNumReads = 0;
+    size_t mNumBytes = 0;
+
+private:
+    sp<DataSource> mSource;
+};
+
+MediaExtractorPluginHelper *createExtractor(Container container, const sp<DataSource> &source) {
+    switch (container) {
+        case AAC:
+            return new AACExtractor(new DataSourceHelper(source->wrap()), 0);
+        case FLAC:
+            return new FLACExtractor(new DataSourceHelper(source->wrap()));
+        case MKV:
+            return new MatroskaExtractor(new DataSourceHelper(source->wrap()));
+        case MP3:
+            return new MP3Extractor(new DataSourceHelper(source->wrap()), nullptr);
+        case MPEG2TS:
+            return new MPEG2TSExtractor(new DataSourceHelper(source->wrap()));
+        case MPEG4:
+            return new MPEG4Extractor(new DataSourceHelper(source->wrap()));
+        case OGG:
+            return new OggExtractor(new DataSourceHelper(source->wrap()));
+        case WAV:
+            return new WAVExtractor(new DataSourceHelper(source->wrap()));
+    }
+    return nullptr;
+}
+
+struct Session {
+    sp<CountingSource> source;
+    MediaExtractorPluginHelper *extractor = nullptr;
+
+    explicit Session(const Clip &clip) {
+        sp<DataSource> file = new FileSource((gRes + clip.file).c_str());
+        if (file->initCheck() != OK) {
+            return;
+        }
+        source = new CountingSource(file);
+        extractor = createExtractor(clip.container, source);
+    }
+
+    ~Session() {
+        delete extractor;
+    }
+};
+
+// A started track, stopped and freed when it goes out of scope.
+struct StartedTrack {
+    MediaTrackHelper *track;
+    CMediaTrack *wrapper;
+    MediaBufferGroup *bufferGroup;
+
+    StartedTrack(MediaExtractorPluginHelper *extractor, size_t index)
+        : track(extractor->getTrack(index)),
+          wrapper(wrap(track)),
+          bufferGroup(new MediaBufferGroup) {
+        if (wrapper != nullptr && wrapper->start(track, bufferGroup->wrap()) != AMEDIA_OK) {
+            free(wrapper);
+            wrapper = nullptr;
+        }
+    }
+
+    ~StartedTrack() {
+        if (wrapper != nullptr) {
+            wrapper->stop(track);
+            free(wrapper);
+        }
+        delete track;
+        delete bufferGroup;
+    }
+
+    bool ok() const {
+        return wrapper != nullptr;
+    }
+};
+
+void reportSourceCounters(benchmark::State &state, const CountingSource &source) {
+    state.counters["reads"] = benchmark::Counter(
+            source.mNumReads, benchmark::Counter::kAvgIterations);
+    state.counters["bytes_read"] = benchmark::Counter(
+            source.mNumBytes, benchmark::Counter::kAvgIterations);
+}
+
+// Open latency: from data source to the metadata of every track.
+void BM_Open(benchmark::State &state, const Clip &clip) {
+    size_t numReads = 0;
+    size_t numBytes = 0;
+    for (auto _ : state) {
+        Session session(clip);
+        if (session.extractor == nullptr) {
+            state.SkipWithError("cannot open clip, pass the corpus location with -P");
+            return;
+        }
+        AMediaFormat *format = AMediaFormat_new();
+        for (size_t i = 0; i < session.extractor->countTracks(); ++i) {
+            session.extractor->getTrackMetaData(format, i, 0);
+        }
+        AMediaFormat_delete(format);
+        numReads += session.source->mNumReads;
+        numBytes += session.source->mNumBytes;
+    }
+    state.counters["reads"] = benchmark::Counter(numReads, benchmark::Counter::kAvgIterations);
+    state.counters["bytes_read"] =
+            benchmark::Counter(numBytes, benchmark::Counter::kAvgIterations);
+}
+
+// Demux throughput: reads every sample of every track, one track at a time.
+void BM_Demux(benchmark::State &state, const Clip &clip) {
+    Session session(clip);
+    if (session.extractor == nullptr) {
+        state.SkipWithError("cannot open clip, pass the corpus location with -P");
+        return;
+    }
+    session.source->mNumReads = 0;
+    session.source->mNumBytes = 0;
+
+    size_t numSamples = 0;
+    for (auto _ : state) {
+        for (size_t i = 0; i < session.extractor->countTracks(); ++i) {
+            StartedTrack track(session.extractor, i);
+            if (!track.ok()) {
+                state.SkipWithError("cannot start track");
+                return;
+            }
+            MediaBufferHelper *buffer = nullptr;
+            while (track.track->read(&buffer) == AMEDIA_OK) {
+                if (buffer != nullptr) {
+                    benchmark::DoNotOptimize(buffer->data());
+                    buffer->release();
+                    buffer = nullptr;
+                }
+                ++numSamples;
+            }
+        }
+    }
+    state.SetItemsProcessed(numSamples);
+    reportSourceCounters(state, *session.source);
+}
+
+// Seek latency: a seek to a pseudo-random time and the read of the sample
+// there, on the first track.
+void BM_Seek(benchmark::State &state, const Clip &clip) {
+    Session session(clip);
+    if (session.extractor == nullptr) {
+        state.SkipWithError("cannot open clip, pass the corpus location with -P");
+        return;
+    }
+
+    int64_t durationUs = 0;
+    AMediaFormat *format = AMediaFormat_new();
+    session.extractor->getTrackMetaData(format, 0, 0);
+    AMediaFormat_getInt64(format, AMEDIAFORMAT_KEY_DURATION, &durationUs);
+    AMediaFormat_delete(format);
+    if (durationUs <= 0) {
+        state.SkipWithError("clip has no duration");
+        return;
+    }
+
+    StartedTrack track(session.extractor, 0);
+    if (!track.ok()) {
+        state.SkipWithError("cannot start track");
+        return;
+    }
+    session.source->mNumReads = 0;
+    session.source->mNumBytes = 0;
+
+    srand(700);
+    for (auto _ : state) {
+        int64_t seekTimeUs = (double)rand() / RAND_MAX * durationUs;
+        MediaTrackHelper::ReadOptions options(
+                CMediaTrackReadOptions::SEEK_CLOSEST_SYNC | CMediaTrackReadOptions::SEEK,
+                seekTimeUs);
+        MediaBufferHelper *buffer = nullptr;
+        if (track.track->read(&buffer, &options) == AMEDIA_OK && buffer != nullptr) {
+            buffer->release();
+        }
+    }
+    reportSourceCounters(state, *session.source);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    benchmark::Initialize(&argc, argv);
+    for (int i = 1; i < argc; ++i) {
+        if ((!strcmp(argv[i], "-P") || !strcmp(argv[i], "--res")) && i + 1 < argc) {
+            gRes = argv[++i];
+        }
+    }
+
+    for (const Clip &clip : kClips) {
+        benchmark::RegisterBenchmark(
+                (std::string("BM_Open/") + clip.name).c_str(), BM_Open, clip);
+        benchmark::RegisterBenchmark(
+                (std::string("BM_Demux/") + clip.name).c_str(), BM_Demux, clip)
+                ->Unit(benchmark::kMillisecond);
+        if (clip.seekable) {
+            benchmark::RegisterBenchmark(
+                    (std::string("BM_Seek/") + clip.name).c_str(), BM_Seek, clip);
+        }
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
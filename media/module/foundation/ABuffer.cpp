@@ -19,6 +19,7 @@
 #include "ADebug.h"
 #include "ALooper.h"
 #include "AMessage.h"
+#include "AObjectPool.h"
 
 namespace android {
 
@@ -45,6 +46,24 @@ ABuffer::ABuffer(void *data, size_t capacity)
       mOwnsData(false) {
 }
 
+// static
+void *ABuffer::operator new(size_t size) {
+    // subclasses have a different size
+    if (size != sizeof(ABuffer)) {
+        return ::operator new(size);
+    }
+    return AObjectPool::Allocate(AObjectPool::kKindBuffer, size);
+}
+
+// static
+void ABuffer::operator delete(void *ptr, size_t size) {
+    if (size != sizeof(ABuffer)) {
+        ::operator delete(ptr);
+        return;
+    }
+    AObjectPool::Free(AObjectPool::kKindBuffer, ptr, size);
+}
+
 // static
 sp<ABuffer> ABuffer::CreateAsCopy(const void *data, size_t capacity)
 {
@@ -24,8 +24,10 @@
 namespace android {
 
 void AHandler::deliverMessage(const sp<AMessage> &msg) {
-    setDeliveryStatus(true, msg->what(), ALooper::GetNowUs());
+    int64_t startUs = ALooper::GetNowUs();
+    setDeliveryStatus(true, msg->what(), startUs);
     onMessageReceived(msg);
+    mExecutionTimeUs.add(ALooper::GetNowUs() - startUs);
     mMessageCounter++;
     setDeliveryStatus(false, 0, 0);
 
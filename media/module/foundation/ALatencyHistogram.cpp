@@ -0,0 +1,86 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ALatencyHistogram.h"
+
+#include <inttypes.h>
+
+namespace android {
+
+// static
+const int64_t ALatencyHistogram::kBucketLimitsUs[kNumBuckets - 1] = {
+    100, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000,
+};
+
+ALatencyHistogram::ALatencyHistogram() {
+    clear();
+}
+
+void ALatencyHistogram::add(int64_t durationUs) {
+    size_t bucket = 0;
+    while (bucket < kNumBuckets - 1 && durationUs >= kBucketLimitsUs[bucket]) {
+        ++bucket;
+    }
+    mCounts[bucket].fetch_add(1, std::memory_order_relaxed);
+    if (durationUs > mMaxUs.load(std::memory_order_relaxed)) {
+        mMaxUs.store(durationUs, std::memory_order_relaxed);
+    }
+}
+
+void ALatencyHistogram::clear() {
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+        mCounts[i].store(0, std::memory_order_relaxed);
+    }
+    mMaxUs.store(0, std::memory_order_relaxed);
+}
+
+uint64_t ALatencyHistogram::count() const {
+    uint64_t count = 0;
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+        count += mCounts[i].load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+static AString formatLimit(int64_t us) {
+    return us < 1000 ? AStringPrintf("%" PRId64 "us", us)
+                     : AStringPrintf("%" PRId64 "ms", us / 1000);
+}
+
+AString ALatencyHistogram::toString() const {
+    AString buckets;
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+        uint64_t count = mCounts[i].load(std::memory_order_relaxed);
+        if (count == 0) {
+            continue;
+        }
+        if (!buckets.empty()) {
+            buckets.append(" ");
+        }
+        if (i < kNumBuckets - 1) {
+            buckets.append("<");
+            buckets.append(formatLimit(kBucketLimitsUs[i]));
+        } else {
+            buckets.append(">=");
+            buckets.append(formatLimit(kBucketLimitsUs[kNumBuckets - 2]));
+        }
+        buckets.append(AStringPrintf(":%" PRIu64, count));
+    }
+    return AStringPrintf("n=%" PRIu64 " max=%" PRId64 "us [%s]",
+            count(), mMaxUs.load(std::memory_order_relaxed), buckets.c_str());
+}
+
+}  // namespace android
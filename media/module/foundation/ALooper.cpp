@@ -42,6 +42,7 @@ struct ALooper::LooperThread : public Thread {
 
     virtual status_t readyToRun() {
         mThreadId = androidGetThreadId();
+        mLooper->setPoolStats(AObjectPool::ThreadStats());
 
         return Thread::readyToRun();
     }
@@ -74,7 +75,8 @@ int64_t ALooper::getNowUs() {
 }
 
 ALooper::ALooper()
-    : mRunningLocally(false) {
+    : mNumPrioritizedEvents(0),
+      mRunningLocally(false) {
     // clean up stale AHandlers. Doing it here instead of in the destructor avoids
     // the side effect of objects being deleted from the unregister function recursively.
     gLooperRoster.unregisterStaleHandlers();
@@ -89,6 +91,16 @@ void ALooper::setName(const char *name) {
     mName = name;
 }
 
+void ALooper::setPoolStats(const std::shared_ptr<const AObjectPool::Stats> &stats) {
+    Mutex::Autolock autoLock(mLock);
+    mPoolStats = stats;
+}
+
+std::shared_ptr<const AObjectPool::Stats> ALooper::getPoolStats() {
+    Mutex::Autolock autoLock(mLock);
+    return mPoolStats;
+}
+
 ALooper::handler_id ALooper::registerHandler(const sp<AHandler> &handler) {
     return gLooperRoster.registerHandler(this, handler);
 }
@@ -109,6 +121,7 @@ status_t ALooper::start(
 
             mRunningLocally = true;
         }
+        setPoolStats(AObjectPool::ThreadStats());
 
         do {
         } while (loop());
@@ -188,6 +201,7 @@ void ALooper::post(const sp<AMessage> &msg, int64_t delayUs) {
 
     Event event;
     event.mWhenUs = whenUs;
+    event.mPriority = msg->priority();
     event.mMessage = msg;
     event.mToken = nullptr;
 
@@ -195,6 +209,9 @@ void ALooper::post(const sp<AMessage> &msg, int64_t delayUs) {
         mQueueChangedCondition.signal();
     }
 
+    if (event.mPriority != 0) {
+        ++mNumPrioritizedEvents;
+    }
     mEventQueue.insert(it, event);
 }
 
@@ -220,6 +237,9 @@ status_t ALooper::postUnique(const sp<AMessage> &msg, const sp<RefBase> &token,
     // Erase any previously-posted event with this token.
     for (auto i = mEventQueue.begin(); i != mEventQueue.end();) {
         if (i->mToken == token) {
+            if (i->mPriority != 0) {
+                --mNumPrioritizedEvents;
+            }
             i = mEventQueue.erase(i);
         } else {
             ++i;
@@ -234,8 +254,12 @@ status_t ALooper::postUnique(const sp<AMessage> &msg, const sp<RefBase> &token,
 
     Event event;
     event.mWhenUs = whenUs;
+    event.mPriority = msg->priority();
     event.mMessage = msg;
     event.mToken = token;
+    if (event.mPriority != 0) {
+        ++mNumPrioritizedEvents;
+    }
     mEventQueue.insert(i, event);
 
     // If we rescheduled the event to be earlier than the first event, then we need to wake up the
@@ -273,8 +297,22 @@ bool ALooper::loop() {
             return true;
         }
 
-        event = *mEventQueue.begin();
-        mEventQueue.erase(mEventQueue.begin());
+        List<Event>::iterator next = mEventQueue.begin();
+        if (mNumPrioritizedEvents > 0) {
+            // deliver the first of the due events with the highest priority
+            for (List<Event>::iterator it = next;
+                    it != mEventQueue.end() && it->mWhenUs <= nowUs; ++it) {
+                if (it->mPriority > next->mPriority) {
+                    next = it;
+                }
+            }
+            if (next->mPriority != 0) {
+                --mNumPrioritizedEvents;
+            }
+        }
+        event = *next;
+        mEventQueue.erase(next);
+        mQueueWaitUs.add(nowUs - event.mWhenUs);
     }
 
     event.mMessage->deliver();
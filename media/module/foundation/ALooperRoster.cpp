@@ -141,6 +141,15 @@ void ALooperRoster::dump(int fd, const Vector<String16>& args) {
         sp<ALooper> looper = info.mLooper.promote();
         if (looper != NULL) {
             s.append(looper->getName());
+            std::shared_ptr<const AObjectPool::Stats> poolStats = looper->getPoolStats();
+            if (poolStats != nullptr) {
+                s.appendFormat(" (reused %" PRIu64 "/%" PRIu64 " messages, "
+                               "%" PRIu64 "/%" PRIu64 " buffers)",
+                               poolStats->mReused[AObjectPool::kKindMessage].load(),
+                               poolStats->mAllocated[AObjectPool::kKindMessage].load(),
+                               poolStats->mReused[AObjectPool::kKindBuffer].load(),
+                               poolStats->mAllocated[AObjectPool::kKindBuffer].load());
+            }
             sp<AHandler> handler = info.mHandler.promote();
             if (handler != NULL) {
                 bool deliveringMessages;
@@ -168,9 +177,14 @@ void ALooperRoster::dump(int fd, const Vector<String16>& args) {
                 } else {
                     handler->mMessages.clear();
                 }
+                s.appendFormat("\n    queue wait: %s\n    execution: %s",
+                               looper->mQueueWaitUs.toString().c_str(),
+                               handler->mExecutionTimeUs.toString().c_str());
                 if (clear || (verboseStats && !oldVerbose)) {
                     handler->mMessageCounter = 0;
                     handler->mMessages.clear();
+                    handler->mExecutionTimeUs.clear();
+                    looper->mQueueWaitUs.clear();
                 }
             } else {
                 s.append(": <stale handler>");
@@ -20,8 +20,11 @@
 
 #include <ctype.h>
 
+#include <atomic>
+
 #include "AMessage.h"
 
+#include <cutils/properties.h>
 #include <log/log.h>
 
 #include "AAtomizer.h"
@@ -29,6 +32,7 @@
 #include "ADebug.h"
 #include "ALooperRoster.h"
 #include "AHandler.h"
+#include "AObjectPool.h"
 #include "AString.h"
 
 #include <media/stagefright/foundation/hexdump.h>
@@ -52,13 +56,28 @@ status_t AReplyToken::setReply(const sp<AMessage> &reply) {
     return OK;
 }
 
+static std::atomic<bool> &internKeysSetting() {
+    static std::atomic<bool> sInternKeys(
+            property_get_bool("debug.stagefright.amessage-intern-keys", false));
+    return sInternKeys;
+}
+
+// static
+void AMessage::SetInternKeys(bool enable) {
+    internKeysSetting().store(enable, std::memory_order_relaxed);
+}
+
 AMessage::AMessage(void)
     : mWhat(0),
-      mTarget(0) {
+      mPriority(0),
+      mTarget(0),
+      mInternKeys(internKeysSetting().load(std::memory_order_relaxed)) {
 }
 
 AMessage::AMessage(uint32_t what, const sp<const AHandler> &handler)
-    : mWhat(what) {
+    : mWhat(what),
+      mPriority(0),
+      mInternKeys(internKeysSetting().load(std::memory_order_relaxed)) {
     setTarget(handler);
 }
 
@@ -66,6 +85,24 @@ AMessage::~AMessage() {
     clear();
 }
 
+// static
+void *AMessage::operator new(size_t size) {
+    // subclasses have a different size
+    if (size != sizeof(AMessage)) {
+        return ::operator new(size);
+    }
+    return AObjectPool::Allocate(AObjectPool::kKindMessage, size);
+}
+
+// static
+void AMessage::operator delete(void *ptr, size_t size) {
+    if (size != sizeof(AMessage)) {
+        ::operator delete(ptr);
+        return;
+    }
+    AObjectPool::Free(AObjectPool::kKindMessage, ptr, size);
+}
+
 void AMessage::setWhat(uint32_t what) {
     mWhat = what;
 }
@@ -74,6 +111,14 @@ uint32_t AMessage::what() const {
     return mWhat;
 }
 
+void AMessage::setPriority(int32_t priority) {
+    mPriority = priority;
+}
+
+int32_t AMessage::priority() const {
+    return mPriority;
+}
+
 void AMessage::setTarget(const sp<const AHandler> &handler) {
     if (handler == NULL) {
         mTarget = 0;
@@ -89,11 +134,11 @@ void AMessage::setTarget(const sp<const AHandler> &handler) {
 void AMessage::clear() {
     // Item needs to be handled delicately
     for (Item &item : mItems) {
-        delete[] item.mName;
-        item.mName = NULL;
+        item.freeName();
         freeItemValue(&item);
     }
     mItems.clear();
+    mIndex.clear();
 }
 
 void AMessage::freeItemValue(Item *item) {
@@ -151,6 +196,9 @@ static void reportStats() {
 #endif
 
 inline size_t AMessage::findItemIndex(const char *name, size_t len) const {
+    if (!mIndex.empty()) {
+        return findIndexedItem(name, len, hashName(name, len));
+    }
 #ifdef DUMP_STATS
     size_t memchecks = 0;
 #endif
@@ -179,22 +227,100 @@ inline size_t AMessage::findItemIndex(const char *name, size_t len) const {
     return i;
 }
 
+// FNV-1a
+static inline uint32_t hashName(const char *name, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+size_t AMessage::findIndexedItem(const char *name, size_t len, uint32_t hash) const {
+    const size_t mask = mIndex.size() - 1;
+    for (size_t slot = hash & mask; mIndex[slot] != 0; slot = (slot + 1) & mask) {
+        const Item &item = mItems[mIndex[slot] - 1];
+        if (item.mName == name
+                || (item.mNameHash == hash && item.mNameLength == len
+                        && !memcmp(item.mName, name, len))) {
+            return mIndex[slot] - 1;
+        }
+    }
+    return mItems.size();
+}
+
+void AMessage::indexItem(size_t i) {
+    if (mItems.size() < kMinIndexedItems) {
+        return;
+    }
+    // keep the load factor at or below 1/2
+    if (mIndex.size() < 2 * mItems.size()) {
+        rebuildIndex();
+        return;
+    }
+    const size_t mask = mIndex.size() - 1;
+    size_t slot = mItems[i].mNameHash & mask;
+    while (mIndex[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    mIndex[slot] = i + 1;
+}
+
+void AMessage::rebuildIndex() {
+    mIndex.clear();
+    if (!mInternKeys || mItems.size() < kMinIndexedItems) {
+        return;
+    }
+    size_t size = 4 * kMinIndexedItems;
+    while (size < 2 * mItems.size()) {
+        size <<= 1;
+    }
+    mIndex.resize(size, 0);
+    const size_t mask = size - 1;
+    for (size_t i = 0; i < mItems.size(); ++i) {
+        size_t slot = mItems[i].mNameHash & mask;
+        while (mIndex[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        mIndex[slot] = i + 1;
+    }
+}
+
 // assumes item's name was uninitialized or NULL
 void AMessage::Item::setName(const char *name, size_t len) {
     mNameLength = len;
     mName = new char[len + 1];
+    mNameInterned = false;
     memcpy((void*)mName, name, len + 1);
 }
 
+// assumes item's name was uninitialized or NULL
+void AMessage::Item::setInternedName(const char *name, size_t len, uint32_t hash) {
+    mNameLength = len;
+    mName = AAtomizer::Atomize(name);
+    mNameHash = hash;
+    mNameInterned = true;
+}
+
+void AMessage::Item::freeName() {
+    if (!mNameInterned) {
+        delete[] mName;
+    }
+    mName = nullptr;
+    mNameInterned = false;
+}
+
 AMessage::Item::Item(const char *name, size_t len)
-    : mType(kTypeInt32) {
-    // mName and mNameLength are initialized by setName
+    : mType(kTypeInt32),
+      mNameHash(0) {
+    // mName, mNameLength and mNameInterned are initialized by setName
     setName(name, len);
 }
 
 AMessage::Item *AMessage::allocateItem(const char *name) {
     size_t len = strlen(name);
-    size_t i = findItemIndex(name, len);
+    uint32_t hash = mInternKeys ? hashName(name, len) : 0;
+    size_t i = mIndex.empty() ? findItemIndex(name, len) : findIndexedItem(name, len, hash);
     Item *item;
 
     if (i < mItems.size()) {
@@ -204,7 +330,13 @@ AMessage::Item *AMessage::allocateItem(const char *name) {
         CHECK(mItems.size() < kMaxNumItems);
         i = mItems.size();
         // place a 'blank' item at the end - this is of type kTypeInt32
-        mItems.emplace_back(name, len);
+        if (mInternKeys) {
+            mItems.emplace_back();
+            mItems[i].setInternedName(name, len, hash);
+            indexItem(i);
+        } else {
+            mItems.emplace_back(name, len);
+        }
         item = &mItems[i];
     }
 
@@ -490,7 +622,11 @@ bool AMessage::senderAwaitsResponse(sp<AReplyToken> *replyToken) {
 
 sp<AMessage> AMessage::dup() const {
     sp<AMessage> msg = new AMessage(mWhat, mHandler.promote());
+    msg->mPriority = mPriority;
     msg->mItems = mItems;
+    // the index refers to items by position, so it is valid for the copy as well
+    msg->mInternKeys = mInternKeys;
+    msg->mIndex = mIndex;
 
 #ifdef DUMP_STATS
     {
@@ -505,7 +641,9 @@ sp<AMessage> AMessage::dup() const {
         const Item *from = &mItems[i];
         Item *to = &msg->mItems[i];
 
-        to->setName(from->mName, from->mNameLength);
+        if (!from->mNameInterned) {
+            to->setName(from->mName, from->mNameLength);
+        }
         to->mType = from->mType;
 
         switch (from->mType) {
@@ -772,7 +910,13 @@ sp<AMessage> AMessage::FromParcel(const Parcel &parcel, size_t maxNestingLevel)
         }
 
         item->setName(name, strlen(name));
+        if (msg->mInternKeys) {
+            // names from a parcel are not trusted to come from a bounded set; index them
+            // without interning
+            item->mNameHash = hashName(item->mName, item->mNameLength);
+        }
     }
+    msg->rebuildIndex();
 
     return msg;
 }
@@ -1026,9 +1170,13 @@ status_t AMessage::setEntryNameAt(size_t index, const char *name) {
     if (findItemIndex(name, len) < mItems.size()) {
         return ALREADY_EXISTS;
     }
-    delete[] mItems[index].mName;
-    mItems[index].mName = nullptr;
-    mItems[index].setName(name, len);
+    mItems[index].freeName();
+    if (mInternKeys) {
+        mItems[index].setInternedName(name, len, hashName(name, len));
+        rebuildIndex();
+    } else {
+        mItems[index].setName(name, len);
+    }
     return OK;
 }
 
@@ -1091,8 +1239,7 @@ status_t AMessage::removeEntryAt(size_t index) {
         return BAD_INDEX;
     }
     // delete entry data and objects
-    delete[] mItems[index].mName;
-    mItems[index].mName = nullptr;
+    mItems[index].freeName();
     freeItemValue(&mItems[index]);
 
     // swap entry with last entry and clear last entry's data
@@ -1100,9 +1247,13 @@ status_t AMessage::removeEntryAt(size_t index) {
     if (index < lastIndex) {
         mItems[index] = mItems[lastIndex];
         mItems[lastIndex].mName = nullptr;
+        mItems[lastIndex].mNameInterned = false;
         mItems[lastIndex].mType = kTypeInt32;
     }
     mItems.pop_back();
+    if (!mIndex.empty()) {
+        rebuildIndex();
+    }
     return OK;
 }
 
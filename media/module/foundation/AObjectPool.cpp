@@ -0,0 +1,150 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "AObjectPool"
+
+#include "AObjectPool.h"
+
+#include <pthread.h>
+
+#include <new>
+
+#include <cutils/properties.h>
+#include <utils/Log.h>
+
+namespace android {
+
+namespace {
+
+std::atomic<bool> &enabledSetting() {
+    static std::atomic<bool> sEnabled(
+            property_get_bool("debug.stagefright.pool-looper-objects", false));
+    return sEnabled;
+}
+
+struct FreeObject {
+    FreeObject *mNext;
+};
+
+struct ThreadCache {
+    FreeObject *mFree[AObjectPool::kNumKinds] = {};
+    size_t mNumFree[AObjectPool::kNumKinds] = {};
+    std::shared_ptr<AObjectPool::Stats> mStats = std::make_shared<AObjectPool::Stats>();
+
+    ~ThreadCache() {
+        for (size_t kind = 0; kind < AObjectPool::kNumKinds; ++kind) {
+            while (mFree[kind] != nullptr) {
+                FreeObject *obj = mFree[kind];
+                mFree[kind] = obj->mNext;
+                ::operator delete(obj);
+            }
+        }
+    }
+};
+
+// A thread_local pointer is used instead of a thread_local object so that objects released
+// by other thread-exit destructors after the cache is gone go back to the heap.
+ThreadCache * const kDestroyedCache = reinterpret_cast<ThreadCache *>(1);
+thread_local ThreadCache *tCache = nullptr;
+
+pthread_key_t cacheKey() {
+    static pthread_key_t sKey = [] {
+        pthread_key_t key;
+        int err = pthread_key_create(&key, [](void *cache) {
+            delete static_cast<ThreadCache *>(cache);
+            tCache = kDestroyedCache;
+        });
+        LOG_ALWAYS_FATAL_IF(err != 0, "failed to create thread cache key: %d", err);
+        return key;
+    }();
+    return sKey;
+}
+
+ThreadCache *threadCache() {
+    ThreadCache *cache = tCache;
+    if (cache == nullptr) {
+        cache = new ThreadCache;
+        pthread_setspecific(cacheKey(), cache);
+        tCache = cache;
+    }
+    return cache == kDestroyedCache ? nullptr : cache;
+}
+
+}  // namespace
+
+AObjectPool::Stats::Stats() {
+    for (size_t kind = 0; kind < kNumKinds; ++kind) {
+        mAllocated[kind] = 0;
+        mReused[kind] = 0;
+    }
+}
+
+// static
+void *AObjectPool::Allocate(Kind kind, size_t size) {
+    ThreadCache *cache;
+    if (!enabledSetting().load(std::memory_order_relaxed)
+            || (cache = threadCache()) == nullptr) {
+        return ::operator new(size);
+    }
+    Stats *stats = cache->mStats.get();
+    stats->mAllocated[kind].store(
+            stats->mAllocated[kind].load(std::memory_order_relaxed) + 1,
+            std::memory_order_relaxed);
+    FreeObject *obj = cache->mFree[kind];
+    if (obj == nullptr) {
+        return ::operator new(size);
+    }
+    cache->mFree[kind] = obj->mNext;
+    --cache->mNumFree[kind];
+    stats->mReused[kind].store(
+            stats->mReused[kind].load(std::memory_order_relaxed) + 1,
+            std::memory_order_relaxed);
+    return obj;
+}
+
+// static
+void AObjectPool::Free(Kind kind, void *ptr, size_t size) {
+    ThreadCache *cache;
+    if (ptr == nullptr
+            || size < sizeof(FreeObject)
+            || !enabledSetting().load(std::memory_order_relaxed)
+            || (cache = threadCache()) == nullptr
+            || cache->mNumFree[kind] >= kMaxCachedObjects) {
+        ::operator delete(ptr);
+        return;
+    }
+    FreeObject *obj = static_cast<FreeObject *>(ptr);
+    obj->mNext = cache->mFree[kind];
+    cache->mFree[kind] = obj;
+    ++cache->mNumFree[kind];
+}
+
+// static
+std::shared_ptr<const AObjectPool::Stats> AObjectPool::ThreadStats() {
+    if (!enabledSetting().load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    ThreadCache *cache = threadCache();
+    return cache == nullptr ? nullptr : cache->mStats;
+}
+
+// static
+void AObjectPool::SetEnabled(bool enabled) {
+    enabledSetting().store(enabled, std::memory_order_relaxed);
+}
+
+}  // namespace android
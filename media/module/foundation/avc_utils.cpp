@@ -288,6 +288,27 @@ void FindAVCDimensions(
     }
 }
 
+size_t findNextStartCode(const uint8_t *data, size_t size) {
+    // The 0x01 that ends a start code is rare in coded data, so let memchr(),
+    // which the C library vectorizes, skip to the candidates, and only then
+    // check for the two leading zero bytes.
+    size_t offset = 2;
+    while (offset < size) {
+        const uint8_t *one = (const uint8_t *)memchr(&data[offset], 0x01, size - offset);
+        if (one == NULL) {
+            break;
+        }
+        offset = one - data;
+        if (one[-1] == 0x00 && one[-2] == 0x00) {
+            return offset - 2;
+        }
+        // The 0x01 at |offset| cannot be one of the two zero bytes of the next
+        // start code, so that one ends at offset + 3 at the earliest.
+        offset += 3;
+    }
+    return size;
+}
+
 status_t getNextNALUnit(
         const uint8_t **_data, size_t *_size,
         const uint8_t **nalStart, size_t *nalSize,
@@ -302,17 +323,10 @@ status_t getNextNALUnit(
         return -EAGAIN;
     }
 
-    size_t offset = 0;
-
     // A valid startcode consists of at least two 0x00 bytes followed by 0x01.
-    for (; offset + 2 < size; ++offset) {
-        if (data[offset + 2] == 0x01 && data[offset] == 0x00
-                && data[offset + 1] == 0x00) {
-            break;
-        }
-    }
-    if (offset + 2 >= size) {
-        *_data = &data[offset];
+    size_t offset = findNextStartCode(data, size);
+    if (offset == size) {
+        *_data = &data[size - 2];
         *_size = 2;
         return -EAGAIN;
     }
@@ -320,25 +334,15 @@ status_t getNextNALUnit(
 
     size_t startOffset = offset;
 
-    for (;;) {
-        while (offset < size && data[offset] != 0x01) {
-            ++offset;
-        }
-
-        if (offset == size) {
-            if (startCodeFollows) {
-                offset = size + 2;
-                break;
-            }
-
+    // |offset| is that of the 0x01 of the next start code.
+    offset = findNextStartCode(&data[startOffset], size - startOffset);
+    if (offset == size - startOffset) {
+        if (!startCodeFollows) {
             return -EAGAIN;
         }
-
-        if (data[offset - 1] == 0x00 && data[offset - 2] == 0x00) {
-            break;
-        }
-
-        ++offset;
+        offset = size + 2;
+    } else {
+        offset += startOffset + 2;
     }
 
     size_t endOffset = offset - 2;
@@ -32,6 +32,10 @@ struct ABuffer : public RefBase {
     explicit ABuffer(size_t capacity);
     ABuffer(void *data, size_t capacity);
 
+    // ABuffer objects are allocated through AObjectPool. This does not cover their data.
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
     uint8_t *base() { return (uint8_t *)mData; }
     uint8_t *data() { return (uint8_t *)mData + mRangeOffset; }
     size_t capacity() const { return mCapacity; }
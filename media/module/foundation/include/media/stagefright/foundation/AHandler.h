@@ -72,6 +72,9 @@ private:
     uint64_t mMessageCounter;
     KeyedVector<uint32_t, uint32_t> mMessages;
 
+    // time spent in onMessageReceived()
+    ALatencyHistogram mExecutionTimeUs;
+
     Mutex mLock;
     bool mDeliveringMessage;
     uint32_t  mCurrentMessageWhat;
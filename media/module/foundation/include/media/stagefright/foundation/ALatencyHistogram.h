@@ -0,0 +1,61 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef A_LATENCY_HISTOGRAM_H_
+
+#define A_LATENCY_HISTOGRAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include <media/stagefright/foundation/ABase.h>
+#include <media/stagefright/foundation/AString.h>
+
+namespace android {
+
+/**
+ * Histogram of durations with fixed buckets from 100us to 100ms, used for looper statistics.
+ *
+ * add() may be called on one thread while toString() or clear() are called on others; the
+ * result is then only approximately consistent.
+ */
+struct ALatencyHistogram {
+    ALatencyHistogram();
+
+    void add(int64_t durationUs);
+    void clear();
+
+    uint64_t count() const;
+
+    /** e.g. "n=12 max=1530us [<100us:9 <500us:2 <2ms:1]"; empty buckets are omitted. */
+    AString toString() const;
+
+private:
+    static constexpr size_t kNumBuckets = 10;
+    // upper bounds of all but the last bucket
+    static const int64_t kBucketLimitsUs[kNumBuckets - 1];
+
+    std::atomic<uint64_t> mCounts[kNumBuckets];
+    std::atomic<int64_t> mMaxUs;
+
+    DISALLOW_EVIL_CONSTRUCTORS(ALatencyHistogram);
+};
+
+}  // namespace android
+
+#endif  // A_LATENCY_HISTOGRAM_H_
@@ -19,6 +19,8 @@
 #define A_LOOPER_H_
 
 #include <media/stagefright/foundation/ABase.h>
+#include <media/stagefright/foundation/ALatencyHistogram.h>
+#include <media/stagefright/foundation/AObjectPool.h>
 #include <media/stagefright/foundation/AString.h>
 #include <utils/Errors.h>
 #include <utils/KeyedVector.h>
@@ -66,9 +68,11 @@ protected:
 
 private:
     friend struct AMessage;       // post()
+    friend struct ALooperRoster;  // getPoolStats(), mQueueWaitUs
 
     struct Event {
         int64_t mWhenUs;
+        int32_t mPriority;
         sp<AMessage> mMessage;
         sp<RefBase> mToken;
     };
@@ -79,11 +83,19 @@ private:
     AString mName;
 
     List<Event> mEventQueue;
+    // number of events in mEventQueue with a non-default priority
+    size_t mNumPrioritizedEvents;
+
+    // time from when events are due until they are delivered
+    ALatencyHistogram mQueueWaitUs;
 
     struct LooperThread;
     sp<LooperThread> mThread;
     bool mRunningLocally;
 
+    // object pool statistics of the looper thread, if pooling is enabled
+    std::shared_ptr<const AObjectPool::Stats> mPoolStats;
+
     // use a separate lock for reply handling, as it is always on another thread
     // use a central lock, however, to avoid creating a mutex for each reply
     Mutex mRepliesLock;
@@ -112,6 +124,10 @@ private:
 
     bool loop();
 
+    // Called on the looper thread before it starts looping.
+    void setPoolStats(const std::shared_ptr<const AObjectPool::Stats> &stats);
+    std::shared_ptr<const AObjectPool::Stats> getPoolStats();
+
     DISALLOW_EVIL_CONSTRUCTORS(ALooper);
 };
 
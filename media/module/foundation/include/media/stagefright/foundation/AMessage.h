@@ -65,6 +65,10 @@ struct AMessage : public RefBase {
     AMessage();
     AMessage(uint32_t what, const sp<const AHandler> &handler);
 
+    // AMessage objects are allocated through AObjectPool.
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
 #if !defined(__ANDROID_VNDK__) && !defined(__ANDROID_APEX__)
     // Construct an AMessage from a parcel.
     // nestingAllowed determines how many levels AMessage can be nested inside
@@ -97,6 +101,12 @@ struct AMessage : public RefBase {
 
     void setTarget(const sp<const AHandler> &handler);
 
+    // Among the messages that are due on a looper, the ones with the highest priority are
+    // delivered first, in the order they became due. Defaults to 0. Takes effect in a
+    // subsequent call to post().
+    void setPriority(int32_t priority);
+    int32_t priority() const;
+
     // removes all items
     void clear();
 
@@ -200,6 +210,19 @@ struct AMessage : public RefBase {
 
     size_t countEntries() const;
     static size_t maxAllowedEntries();
+
+    /**
+     * Selects whether messages constructed from now on intern their keys.
+     *
+     * Interned keys are shared through AAtomizer instead of being copied into every message (and
+     * every dup()), and messages with many items look them up through a small hash index instead
+     * of scanning all of them. Atoms are never freed, so only enable this in processes whose keys
+     * come from a bounded set. Keys read from a parcel are never interned.
+     *
+     * Defaults to the debug.stagefright.amessage-intern-keys property. Existing messages keep the
+     * mode they were constructed with.
+     */
+    static void SetInternKeys(bool enable);
     const char *getEntryNameAt(size_t index, Type *type) const;
 
     /**
@@ -288,6 +311,7 @@ private:
     friend struct ALooper; // deliver()
 
     uint32_t mWhat;
+    int32_t mPriority;
 
     // used only for debugging
     ALooper::handler_id mTarget;
@@ -310,16 +334,28 @@ private:
         const char *mName;
         size_t      mNameLength;
         Type mType;
+        uint32_t    mNameHash;      // only maintained when mInternKeys is set
+        bool        mNameInterned;  // mName is owned by AAtomizer
         void setName(const char *name, size_t len);
-        Item() : mName(nullptr), mNameLength(0), mType(kTypeInt32) { }
+        void setInternedName(const char *name, size_t len, uint32_t hash);
+        void freeName();
+        Item() : mName(nullptr), mNameLength(0), mType(kTypeInt32), mNameHash(0),
+                 mNameInterned(false) { }
         Item(const char *name, size_t length);
     };
 
     enum {
-        kMaxNumItems = 256
+        kMaxNumItems = 256,
+        // messages with fewer items are scanned linearly even when keys are interned
+        kMinIndexedItems = 8,
     };
     std::vector<Item> mItems;
 
+    bool mInternKeys;
+    // Open-addressed index of mItems keyed by mNameHash. Each slot holds an item index + 1, or 0
+    // if empty. Only used when mInternKeys is set and there are at least kMinIndexedItems items.
+    std::vector<uint16_t> mIndex;
+
     /**
      * Allocates an item with the given key |name|. If the key already exists, the corresponding
      * item value is freed. Otherwise a new item is added.
@@ -350,6 +386,13 @@ private:
             const char *name, const sp<RefBase> &obj, Type type);
 
     size_t findItemIndex(const char *name, size_t len) const;
+    size_t findIndexedItem(const char *name, size_t len, uint32_t hash) const;
+
+    /** Adds mItems[i] to the index, growing it if needed. */
+    void indexItem(size_t i);
+
+    /** Rebuilds the index from mItems after items were renamed or moved. */
+    void rebuildIndex();
 
     void deliver();
 
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef A_OBJECT_POOL_H_
+
+#define A_OBJECT_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+
+namespace android {
+
+/**
+ * Per-thread free lists for the small objects that are allocated for every looper message, i.e.
+ * AMessage and ABuffer objects (not the data of the buffers).
+ *
+ * Each thread keeps up to kMaxCachedObjects freed objects of each kind and hands them out again
+ * to the next allocation of the same kind on that thread. As looper threads both create and
+ * release most of these objects, this removes most of the malloc/free traffic of busy loopers.
+ *
+ * Pooling is off unless the debug.stagefright.pool-looper-objects property is set; pooled
+ * objects hide use-after-free errors from the allocator.
+ */
+struct AObjectPool {
+    enum Kind : uint32_t {
+        kKindMessage,
+        kKindBuffer,
+        kNumKinds,
+    };
+
+    static constexpr size_t kMaxCachedObjects = 64;
+
+    struct Stats {
+        // number of objects allocated by the thread
+        std::atomic<uint64_t> mAllocated[kNumKinds];
+        // number of those that were taken from the thread's free list
+        std::atomic<uint64_t> mReused[kNumKinds];
+
+        Stats();
+    };
+
+    /**
+     * Allocates |size| bytes for an object of |kind|. All objects of one kind must have the
+     * same size.
+     */
+    static void *Allocate(Kind kind, size_t size);
+
+    /** Releases an object allocated by Allocate(), possibly on another thread. */
+    static void Free(Kind kind, void *ptr, size_t size);
+
+    /** Returns the statistics of the calling thread, or nullptr if pooling is disabled. */
+    static std::shared_ptr<const Stats> ThreadStats();
+
+    /** Overrides the property, e.g. for testing. */
+    static void SetEnabled(bool enabled);
+};
+
+}  // namespace android
+
+#endif  // A_OBJECT_POOL_H_
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include <media/stagefright/foundation/AMessage.h>
+
+// Compares AMessage with copied keys and linear lookups against interned keys with the hash
+// index (see AMessage::SetInternKeys()), for messages of the sizes MediaCodec and CCodec send
+// around for each buffer.
+//
+// The first argument is the number of items, the second is 1 for interned keys.
+//
+// To run:
+//   adb shell /data/benchmarktest64/sf_foundation_amessage_benchmark/sf_foundation_amessage_benchmark
+
+using namespace android;
+
+namespace {
+
+std::vector<std::string> makeKeys(size_t count) {
+    // key names similar to the ones used for media formats
+    static const char *kPrefixes[] = {"csd-", "color-", "max-", "vendor.ext-", "ts-"};
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < count; ++i) {
+        keys.push_back(kPrefixes[i % 5] + std::to_string(i));
+    }
+    return keys;
+}
+
+sp<AMessage> makeMessage(const std::vector<std::string> &keys) {
+    sp<AMessage> msg = new AMessage;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        msg->setInt64(keys[i].c_str(), i);
+    }
+    return msg;
+}
+
+class InternKeys {
+public:
+    explicit InternKeys(bool enable) { AMessage::SetInternKeys(enable); }
+    ~InternKeys() { AMessage::SetInternKeys(false); }
+};
+
+void BM_Build(benchmark::State &state) {
+    InternKeys intern(state.range(1));
+    const std::vector<std::string> keys = makeKeys(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(makeMessage(keys));
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+void BM_Find(benchmark::State &state) {
+    InternKeys intern(state.range(1));
+    const std::vector<std::string> keys = makeKeys(state.range(0));
+    sp<AMessage> msg = makeMessage(keys);
+    for (auto _ : state) {
+        for (const std::string &key : keys) {
+            int64_t value;
+            benchmark::DoNotOptimize(msg->findInt64(key.c_str(), &value));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+void BM_Set(benchmark::State &state) {
+    InternKeys intern(state.range(1));
+    const std::vector<std::string> keys = makeKeys(state.range(0));
+    sp<AMessage> msg = makeMessage(keys);
+    int64_t value = 0;
+    for (auto _ : state) {
+        for (const std::string &key : keys) {
+            msg->setInt64(key.c_str(), ++value);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+void BM_Dup(benchmark::State &state) {
+    InternKeys intern(state.range(1));
+    sp<AMessage> msg = makeMessage(makeKeys(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(msg->dup());
+    }
+}
+
+void MessageSizes(benchmark::internal::Benchmark *b) {
+    for (int items : {4, 8, 20, 40, 60}) {
+        b->Args({items, 0});
+        b->Args({items, 1});
+    }
+}
+
+}  // namespace
+
+BENCHMARK(BM_Build)->Apply(MessageSizes);
+BENCHMARK(BM_Find)->Apply(MessageSizes);
+BENCHMARK(BM_Set)->Apply(MessageSizes);
+BENCHMARK(BM_Dup)->Apply(MessageSizes);
+
+BENCHMARK_MAIN();
@@ -24,6 +24,8 @@
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/foundation/AHandler.h>
 #include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AObjectPool.h>
+#include <media/stagefright/foundation/AString.h>
 
 using namespace android;
 
@@ -169,6 +171,89 @@ TEST(AMessage_tests, settersAndGetters) {
   EXPECT_NE(OK, m1->removeEntryByName("notpresent"));
 }
 
+TEST(AMessage_tests, pooledAllocation) {
+  AObjectPool::SetEnabled(true);
+  std::shared_ptr<const AObjectPool::Stats> stats = AObjectPool::ThreadStats();
+  ASSERT_NE(nullptr, stats);
+  uint64_t allocated = stats->mAllocated[AObjectPool::kKindMessage];
+  uint64_t reused = stats->mReused[AObjectPool::kKindMessage];
+
+  sp<AMessage> m1 = new AMessage();
+  m1->setInt32("value", 1);
+  AMessage *first = m1.get();
+  m1.clear();
+
+  // the freed message is handed out again
+  m1 = new AMessage();
+  EXPECT_EQ(first, m1.get());
+  EXPECT_FALSE(m1->contains("value"));
+  EXPECT_EQ(allocated + 2, stats->mAllocated[AObjectPool::kKindMessage]);
+  EXPECT_EQ(reused + 1, stats->mReused[AObjectPool::kKindMessage]);
+
+  AObjectPool::SetEnabled(false);
+  EXPECT_EQ(nullptr, AObjectPool::ThreadStats());
+  // objects allocated from the pool can be released after it is disabled
+  m1.clear();
+}
+
+TEST(AMessage_tests, internedKeys) {
+  AMessage::SetInternKeys(true);
+  sp<AMessage> m1 = new AMessage();
+  AMessage::SetInternKeys(false);
+
+  // enough items to use the index
+  constexpr int32_t kNumItems = 40;
+  for (int32_t i = 0; i < kNumItems; ++i) {
+    m1->setInt32(AStringPrintf("key-%d", i).c_str(), i);
+  }
+  m1->setInt32("key-7", 70);
+  EXPECT_EQ(kNumItems, m1->countEntries());
+
+  int32_t i32;
+  for (int32_t i = 0; i < kNumItems; ++i) {
+    EXPECT_TRUE(m1->findInt32(AStringPrintf("key-%d", i).c_str(), &i32));
+    EXPECT_EQ(i == 7 ? 70 : i, i32);
+  }
+  EXPECT_FALSE(m1->contains("key-40"));
+
+  // removal moves the last item, renaming changes its hash
+  EXPECT_EQ(OK, m1->removeEntryByName("key-3"));
+  EXPECT_FALSE(m1->contains("key-3"));
+  EXPECT_TRUE(m1->findInt32("key-39", &i32));
+  EXPECT_EQ(39, i32);
+  size_t index = m1->findEntryByName("key-39");
+  EXPECT_EQ(ALREADY_EXISTS, m1->setEntryNameAt(index, "key-38"));
+  EXPECT_EQ(OK, m1->setEntryNameAt(index, "renamed"));
+  EXPECT_FALSE(m1->contains("key-39"));
+  EXPECT_TRUE(m1->findInt32("renamed", &i32));
+  EXPECT_EQ(39, i32);
+
+  // copies share the keys and remain independent
+  sp<AMessage> m2 = m1->dup();
+  m2->setInt32("key-5", 50);
+  EXPECT_TRUE(m1->findInt32("key-5", &i32));
+  EXPECT_EQ(5, i32);
+  EXPECT_TRUE(m2->findInt32("key-5", &i32));
+  EXPECT_EQ(50, i32);
+  EXPECT_TRUE(m2->findInt32("renamed", &i32));
+  EXPECT_EQ(39, i32);
+
+  // messages without interned keys can be mixed with ones that have them
+  sp<AMessage> m3 = new AMessage();
+  m3->setInt32("key-5", 55);
+  m3->extend(m1);
+  EXPECT_EQ(m1->countEntries(), m3->countEntries());
+  EXPECT_TRUE(m3->findInt32("key-5", &i32));
+  EXPECT_EQ(5, i32);
+
+  m1->clear();
+  EXPECT_EQ(0, m1->countEntries());
+  EXPECT_FALSE(m1->contains("key-5"));
+  m1->setInt32("key-5", 1);
+  EXPECT_TRUE(m1->findInt32("key-5", &i32));
+  EXPECT_EQ(1, i32);
+}
+
 TEST(AMessage_tests, deliversMultipleMessagesInOrderImmediately) {
   sp<NiceMock<MockHandler>> mockHandler = new NiceMock<MockHandler>;
   sp<LooperWithSettableClock> looper = new LooperWithSettableClock();
@@ -234,6 +319,41 @@ TEST(AMessage_tests, deliversDelayedMessagesInSequence) {
   nanosleep(&millis100, nullptr); // just enough time for the looper thread to run
 }
 
+TEST(AMessage_tests, deliversDueMessagesByPriority) {
+  sp<NiceMock<MockHandler>> mockHandler = new NiceMock<MockHandler>;
+  sp<LooperWithSettableClock> looper = new LooperWithSettableClock();
+  looper->registerHandler(mockHandler);
+
+  sp<AMessage> msgNow = new AMessage(0, mockHandler);
+  msgNow->post();
+  sp<AMessage> msgIn100 = new AMessage(0, mockHandler);
+  msgIn100->post(100);
+  sp<AMessage> msgUrgentIn200 = new AMessage(0, mockHandler);
+  msgUrgentIn200->setPriority(1);
+  msgUrgentIn200->post(200);
+  sp<AMessage> msgUrgentIn100 = new AMessage(0, mockHandler);
+  msgUrgentIn100->setPriority(1);
+  msgUrgentIn100->post(100);
+  // not due yet, so it does not go ahead of the others
+  sp<AMessage> msgUrgentIn1000 = new AMessage(0, mockHandler);
+  msgUrgentIn1000->setPriority(1);
+  msgUrgentIn1000->post(1000);
+
+  looper->setClockUs(500);
+  {
+    InSequence inSequence;
+
+    EXPECT_CALL(*mockHandler, onMessageReceived(msgUrgentIn100)).Times(1);
+    EXPECT_CALL(*mockHandler, onMessageReceived(msgUrgentIn200)).Times(1);
+    EXPECT_CALL(*mockHandler, onMessageReceived(msgNow)).Times(1);
+    EXPECT_CALL(*mockHandler, onMessageReceived(msgIn100)).Times(1);
+  }
+  // note: never called
+  EXPECT_CALL(*mockHandler, onMessageReceived(msgUrgentIn1000)).Times(0);
+  looper->start();
+  nanosleep(&millis100, nullptr); // just enough time for the looper thread to run
+}
+
 TEST(AMessage_tests, deliversDelayedUniqueMessage) {
   sp<NiceMock<MockHandler>> mockHandler = new NiceMock<MockHandler>;
   sp<LooperWithSettableClock> looper = new LooperWithSettableClock();
@@ -349,6 +349,21 @@ TEST_P(AVCFrameTest, FrameTest) {
     }
 }
 
+TEST(StartCodeTest, FindNextStartCode) {
+    const uint8_t kNoStartCode[] = {0x00, 0x01, 0x00, 0x00, 0x02, 0x01, 0x00, 0x00};
+    ASSERT_EQ(findNextStartCode(kNoStartCode, sizeof(kNoStartCode)), sizeof(kNoStartCode));
+    ASSERT_EQ(findNextStartCode(kNoStartCode, 0), 0u);
+
+    const uint8_t kStartCodes[] = {0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x65,
+                                   0x88, 0x01, 0x00, 0x00, 0x01};
+    ASSERT_EQ(findNextStartCode(kStartCodes, sizeof(kStartCodes)), 4u);
+    ASSERT_EQ(findNextStartCode(kStartCodes + 4, sizeof(kStartCodes) - 4), 0u);
+    ASSERT_EQ(findNextStartCode(kStartCodes + 6, sizeof(kStartCodes) - 6), 4u);
+    // The start code must be complete.
+    ASSERT_EQ(findNextStartCode(kStartCodes + 6, sizeof(kStartCodes) - 7),
+              sizeof(kStartCodes) - 7);
+}
+
 INSTANTIATE_TEST_SUITE_P(AVCUtilsTestAll, MpegAudioUnitTest,
                          ::testing::Values(make_tuple(0xFFFB9204, 418, 44100, 2, 128, 1152),
                                            make_tuple(0xFFFB7604, 289, 48000, 2, 96, 1152),
@@ -18,6 +18,7 @@
 #define LOG_TAG "CodecProperties"
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <string>
 #include <stdlib.h>
 
@@ -38,11 +39,11 @@ CodecProperties::CodecProperties(std::string name, std::string mediaType) {
     mMediaType = mediaType;
 }
 
-std::string CodecProperties::getName(){
+const std::string& CodecProperties::getName(){
     return mName;
 }
 
-std::string CodecProperties::getMediaType(){
+const std::string& CodecProperties::getMediaType(){
     return mMediaType;
 }
 
@@ -270,10 +271,15 @@ bool CodecProperties::bppPoint(std::string resolution, std::string value) {
 }
 
 double CodecProperties::getBpp(int32_t width, int32_t height) {
-    // look in the per-resolution list
-
     int32_t pixels = width * height;
 
+    const shaping_entry *entry = findShaping(pixels);
+    if (entry != nullptr) {
+        ALOGV("getBpp(w=%d,h=%d) returns %f from shaping table", width, height, entry->bpp);
+        return entry->bpp;
+    }
+
+    // look in the per-resolution list
     if (mBppPoints) {
         struct bpp_point *point = mBppPoints;
         while (point && point->pixels < pixels) {
@@ -388,10 +394,16 @@ bool CodecProperties::qpMaxPoint(std::string resolution, std::string value) {
 }
 
 int CodecProperties::targetQpMax(int32_t width, int32_t height) {
-    // look in the per-resolution list
-
     int32_t pixels = width * height;
 
+    const shaping_entry *entry = findShaping(pixels);
+    if (entry != nullptr) {
+        ALOGV("targetQpMax(w=%d,h=%d) returns %d from shaping table",
+              width, height, entry->qpMax);
+        return entry->qpMax;
+    }
+
+    // look in the per-resolution list
     if (mQpMaxPoints) {
         struct qpmax_point *point = mQpMaxPoints;
         while (point && point->pixels < pixels) {
@@ -408,6 +420,58 @@ int CodecProperties::targetQpMax(int32_t width, int32_t height) {
     return mTargetQpMax;
 }
 
+void CodecProperties::buildShapingTable() {
+    std::vector<int32_t> limits;
+    for (struct bpp_point *point = mBppPoints; point; point = point->next) {
+        limits.push_back(point->pixels);
+    }
+    for (struct qpmax_point *point = mQpMaxPoints; point; point = point->next) {
+        limits.push_back(point->pixels);
+    }
+    std::sort(limits.begin(), limits.end());
+    limits.erase(std::unique(limits.begin(), limits.end()), limits.end());
+
+    // same selection as the list walks in getBpp() and targetQpMax():
+    // the first point with at least as many pixels, else the default.
+    mShapingTable.clear();
+    for (int32_t pixels : limits) {
+        shaping_entry entry = { .pixels = pixels, .bpp = mBpp, .qpMax = mTargetQpMax };
+        struct bpp_point *bpp = mBppPoints;
+        while (bpp && bpp->pixels < pixels) {
+            bpp = bpp->next;
+        }
+        if (bpp) {
+            entry.bpp = bpp->bpp;
+        }
+        struct qpmax_point *qp = mQpMaxPoints;
+        while (qp && qp->pixels < pixels) {
+            qp = qp->next;
+        }
+        if (qp) {
+            entry.qpMax = qp->qpMax;
+        }
+        mShapingTable.push_back(entry);
+    }
+    mShapingTable.push_back({ .pixels = INT32_MAX, .bpp = mBpp, .qpMax = mTargetQpMax });
+
+    int32_t vqEligible = 0;
+    (void) getFeatureValue("_vq_eligible.device", &vqEligible);
+    mVqEligible = vqEligible != 0;
+    (void) getFeatureValue("_quality.target", &mQualityTarget);
+
+    ALOGV("buildShapingTable: codec %s, %zu entries", mName.c_str(), mShapingTable.size());
+}
+
+const CodecProperties::shaping_entry *CodecProperties::findShaping(int32_t pixels) {
+    if (mShapingTable.empty()) {
+        return nullptr;
+    }
+    // the last entry covers everything
+    auto entry = std::lower_bound(mShapingTable.begin(), mShapingTable.end() - 1, pixels,
+            [](const shaping_entry &e, int32_t p) { return e.pixels < p; });
+    return &*entry;
+}
+
 void CodecProperties::setTargetQpMax(int qpMax) {
     // convert to our internal 'unspecified' notation
     if (qpMax == -1)
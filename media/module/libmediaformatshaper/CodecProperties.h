@@ -20,6 +20,7 @@
 #include <map>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include <inttypes.h>
 
@@ -39,8 +40,8 @@ class CodecProperties {
     void Seed();
     void Finish();
 
-    std::string getName();
-    std::string getMediaType();
+    const std::string& getName();
+    const std::string& getMediaType();
 
     // establish a mapping from standard 'key' to non-standard 'value' in the namespace 'kind'
     void setMapping(std::string kind, std::string key, std::string value);
@@ -97,6 +98,11 @@ class CodecProperties {
     bool isRegistered() { return mIsRegistered;}
     void setRegistered(bool registered) { mIsRegistered = registered;}
 
+    // the "_vq_eligible.device" and "_quality.target" features, which MediaCodec
+    // sets before registering; cached by Finish()
+    bool isVqEligible() { return mVqEligible; }
+    int32_t qualityTarget() { return mQualityTarget; }
+
   private:
     std::string mName;
     std::string mMediaType;
@@ -136,6 +142,22 @@ class CodecProperties {
     struct qpmax_point *mQpMaxPoints = nullptr;
     bool qpMaxPoint(std::string resolution, std::string value);
 
+    // the bpp and qpmax points merged into one table sorted by pixels, built by
+    // Finish() once the codec is fully configured, so that shaping a format
+    // is a binary search instead of walking both lists.
+    // each entry applies to resolutions of up to 'pixels', the last one to all others.
+    struct shaping_entry {
+        int32_t pixels;
+        double bpp;
+        int qpMax;
+    };
+    std::vector<shaping_entry> mShapingTable;
+    void buildShapingTable();
+    const shaping_entry *findShaping(int32_t pixels);
+
+    bool mVqEligible = false;
+    int32_t mQualityTarget = 1;     // S_HANDHELD
+
     std::mutex mMappingLock;
     // XXX figure out why I'm having problems getting compiler to like GUARDED_BY
     std::map<std::string, std::string> mMappings /*GUARDED_BY(mMappingLock)*/ ;
@@ -157,6 +157,7 @@ void CodecProperties::Seed() {
 void CodecProperties::Finish() {
     ALOGV("Finish: for codec %s, mediatype %s", mName.c_str(), mMediaType.c_str());
     addMediaDefaults(false);
+    buildShapingTable();
 }
 
 } // namespace mediaformatshaper
@@ -52,7 +52,7 @@ int shapeFormat(shaperHandle_t shaper, AMediaFormat* inFormat, int flags) {
     // run through the list of possible transformations
     //
 
-    std::string mediaType = codec->getMediaType();
+    const std::string& mediaType = codec->getMediaType();
     if (strncmp(mediaType.c_str(), "video/", 6) == 0) {
         // video specific shaping
         (void) videoShaper(codec, inFormat, flags);
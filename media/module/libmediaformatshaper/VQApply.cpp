@@ -69,9 +69,7 @@ int VQApply(CodecProperties *codec, vqOps_t *info, AMediaFormat* inFormat, int f
     //
     // TODO: make a #define for ' _vq_eligible.device' here and in MediaCodec.cpp
     //
-    int32_t isVQEligible = 0;
-    (void) codec->getFeatureValue("_vq_eligible.device", &isVQEligible);
-    if (!isVQEligible) {
+    if (!codec->isVqEligible()) {
         ALOGD("minquality: not an eligible device class");
         return 0;
     }
@@ -110,9 +108,8 @@ int VQApply(CodecProperties *codec, vqOps_t *info, AMediaFormat* inFormat, int f
 
         // tell the underlying codec to do its thing; we won't try to second guess.
         // default to 1, aka S_HANDHELD;
-        int32_t qualityTarget = 1;
-        (void) codec->getFeatureValue("_quality.target", &qualityTarget);
-        AMediaFormat_setInt32(inFormat, "android._encoding-quality-level", qualityTarget);
+        AMediaFormat_setInt32(inFormat, "android._encoding-quality-level",
+                              codec->qualityTarget());
         return 0;
     }
 
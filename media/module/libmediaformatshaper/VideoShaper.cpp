@@ -66,7 +66,7 @@ int videoShaper(CodecProperties *codec, AMediaFormat* inFormat, int flags) {
 
     int ix;
 
-    std::string mediaType = codec->getMediaType();
+    const std::string& mediaType = codec->getMediaType();
     // we should always come out of this with a selection, because the final entry
     // is deliberaly a NULL -- so that it will act as a default
     for(ix = 0; mediaInfo[ix].mediaType != NULL; ix++) {
@@ -26,6 +26,7 @@
 #include <utils/AndroidThreads.h>
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <thread>
 #include <utility>
 
@@ -71,27 +72,24 @@ struct TranscodingSessionController::Watchdog {
     // Starts monitoring the session.
     void start(const SessionKeyType& key);
     // Stops monitoring the session.
-    void stop();
+    void stop(const SessionKeyType& key);
     // Signals that the session is still alive. Must be sent at least every mTimeoutUs.
     // (Timeout will happen if no ping in mTimeoutUs since the last ping.)
-    void keepAlive();
+    void keepAlive(const SessionKeyType& key);
 
 private:
     void threadLoop();
-    void updateTimer_l();
+    void updateTimer_l(const SessionKeyType& key);
 
     TranscodingSessionController* mOwner;
     const int64_t mTimeoutUs;
     mutable std::mutex mLock;
     std::condition_variable mCondition GUARDED_BY(mLock);
-    // Whether watchdog is monitoring a session for timeout.
-    bool mActive GUARDED_BY(mLock);
     // Whether watchdog is aborted and the monitoring thread should exit.
     bool mAbort GUARDED_BY(mLock);
-    // When watchdog is active, the next timeout time point.
-    std::chrono::steady_clock::time_point mNextTimeoutTime GUARDED_BY(mLock);
-    // When watchdog is active, the session being watched.
-    SessionKeyType mSessionToWatch GUARDED_BY(mLock);
+    // The sessions being watched, and the next timeout time point of each.
+    std::map<SessionKeyType, std::chrono::steady_clock::time_point> mTimeoutTimes
+            GUARDED_BY(mLock);
     std::thread mThread;
 };
 
@@ -99,7 +97,6 @@ TranscodingSessionController::Watchdog::Watchdog(TranscodingSessionController* o
                                                  int64_t timeoutUs)
       : mOwner(owner),
         mTimeoutUs(timeoutUs),
-        mActive(false),
         mAbort(false),
         mThread(&Watchdog::threadLoop, this) {
     ALOGV("Watchdog CTOR: %p", this);
@@ -123,42 +120,40 @@ TranscodingSessionController::Watchdog::~Watchdog() {
 void TranscodingSessionController::Watchdog::start(const SessionKeyType& key) {
     std::scoped_lock lock{mLock};
 
-    if (!mActive) {
+    if (mTimeoutTimes.count(key) == 0) {
         ALOGI("Watchdog start: %s", sessionToString(key).c_str());
 
-        mActive = true;
-        mSessionToWatch = key;
-        updateTimer_l();
+        updateTimer_l(key);
         mCondition.notify_one();
     }
 }
 
-void TranscodingSessionController::Watchdog::stop() {
+void TranscodingSessionController::Watchdog::stop(const SessionKeyType& key) {
     std::scoped_lock lock{mLock};
 
-    if (mActive) {
-        ALOGI("Watchdog stop: %s", sessionToString(mSessionToWatch).c_str());
+    if (mTimeoutTimes.erase(key) > 0) {
+        ALOGI("Watchdog stop: %s", sessionToString(key).c_str());
 
-        mActive = false;
         mCondition.notify_one();
     }
 }
 
-void TranscodingSessionController::Watchdog::keepAlive() {
+void TranscodingSessionController::Watchdog::keepAlive(const SessionKeyType& key) {
     std::scoped_lock lock{mLock};
 
-    if (mActive) {
-        ALOGI("Watchdog keepAlive: %s", sessionToString(mSessionToWatch).c_str());
+    if (mTimeoutTimes.count(key) > 0) {
+        ALOGI("Watchdog keepAlive: %s", sessionToString(key).c_str());
 
-        updateTimer_l();
+        updateTimer_l(key);
         mCondition.notify_one();
     }
 }
 
 // updateTimer_l() is only called with lock held.
-void TranscodingSessionController::Watchdog::updateTimer_l() NO_THREAD_SAFETY_ANALYSIS {
+void TranscodingSessionController::Watchdog::updateTimer_l(const SessionKeyType& key)
+        NO_THREAD_SAFETY_ANALYSIS {
     std::chrono::microseconds timeout(mTimeoutUs);
-    mNextTimeoutTime = std::chrono::steady_clock::now() + timeout;
+    mTimeoutTimes[key] = std::chrono::steady_clock::now() + timeout;
 }
 
 // Unfortunately std::unique_lock is incompatible with -Wthread-safety.
@@ -167,24 +162,29 @@ void TranscodingSessionController::Watchdog::threadLoop() NO_THREAD_SAFETY_ANALY
     std::unique_lock<std::mutex> lock{mLock};
 
     while (!mAbort) {
-        if (!mActive) {
+        if (mTimeoutTimes.empty()) {
             mCondition.wait(lock);
             continue;
         }
-        // Watchdog active, wait till next timeout time.
-        if (mCondition.wait_until(lock, mNextTimeoutTime) == std::cv_status::timeout) {
-            // If timeout happens, report timeout and deactivate watchdog.
-            mActive = false;
-            // Make a copy of session key, as once we unlock, it could be unprotected.
-            SessionKeyType sessionKey = mSessionToWatch;
-
-            ALOGE("Watchdog timeout: %s", sessionToString(sessionKey).c_str());
-
-            lock.unlock();
-            mOwner->onError(sessionKey.first, sessionKey.second,
-                            TranscodingErrorCode::kWatchdogTimeout);
-            lock.lock();
+        // Watchdog active, wait till the earliest timeout time.
+        auto next = std::min_element(
+                mTimeoutTimes.begin(), mTimeoutTimes.end(),
+                [](const auto& a, const auto& b) { return a.second < b.second; });
+        if (std::chrono::steady_clock::now() < next->second) {
+            mCondition.wait_until(lock, next->second);
+            continue;
         }
+        // If timeout happens, report timeout and stop watching the session.
+        // Make a copy of session key, as once we unlock, it could be unprotected.
+        SessionKeyType sessionKey = next->first;
+        mTimeoutTimes.erase(next);
+
+        ALOGE("Watchdog timeout: %s", sessionToString(sessionKey).c_str());
+
+        lock.unlock();
+        mOwner->onError(sessionKey.first, sessionKey.second,
+                        TranscodingErrorCode::kWatchdogTimeout);
+        lock.lock();
     }
 }
 ///////////////////////////////////////////////////////////////////////////////
@@ -335,7 +335,6 @@ TranscodingSessionController::TranscodingSessionController(
         mUidPolicy(uidPolicy),
         mResourcePolicy(resourcePolicy),
         mThermalPolicy(thermalPolicy),
-        mCurrentSession(nullptr),
         mResourceLost(false) {
     // Only push empty offline queue initially. Realtime queues are added when requests come in.
     mUidSortedList.push_back(OFFLINE_UID);
@@ -346,10 +345,15 @@ TranscodingSessionController::TranscodingSessionController(
     if (config != nullptr) {
         mConfig = *config;
     }
+    mConfig.maxConcurrentSessions = std::max(mConfig.maxConcurrentSessions, 1);
+    mConcurrencyLimit = mConfig.maxConcurrentSessions;
+    mTranscoders.resize(mConfig.maxConcurrentSessions);
     mPacer.reset(new Pacer(mConfig));
-    ALOGD("@@@ watchdog %lld, burst count %d, burst time %d, burst threshold %d",
+    ALOGD("@@@ watchdog %lld, burst count %d, burst time %d, burst threshold %d, "
+          "concurrent sessions %d",
           (long long)mConfig.watchdogTimeoutUs, mConfig.pacerBurstCountQuota,
-          mConfig.pacerBurstTimeQuotaSeconds, mConfig.pacerBurstThresholdMs);
+          mConfig.pacerBurstTimeQuotaSeconds, mConfig.pacerBurstThresholdMs,
+          mConfig.maxConcurrentSessions);
 }
 
 TranscodingSessionController::~TranscodingSessionController() {}
@@ -389,6 +393,9 @@ void TranscodingSessionController::dumpAllSessions(int fd, const Vector<String16
     result.append(buffer);
     snprintf(buffer, SIZE, "  Total num of Sessions: %zu\n", mSessionMap.size());
     result.append(buffer);
+    snprintf(buffer, SIZE, "  Running sessions: %zu, allowed: %d (max %d)\n",
+             countRunningSessions_l(), mConcurrencyLimit, mConfig.maxConcurrentSessions);
+    result.append(buffer);
 
     std::vector<int32_t> uids(mUidSortedList.begin(), mUidSortedList.end());
 
@@ -425,31 +432,84 @@ void TranscodingSessionController::dumpAllSessions(int fd, const Vector<String16
 }
 
 /*
- * Returns nullptr if there is no session, or we're paused globally (due to resource lost,
- * thermal throttling, etc.). Otherwise, return the session that should be run next.
+ * Returns an empty list if there is no session, or we're paused globally (due to resource lost,
+ * thermal throttling, etc.). Otherwise, returns the sessions that should be running, up to
+ * mConcurrencyLimit of them in priority order, each paired with the index of the transcoder
+ * to run it on.
  */
-TranscodingSessionController::Session* TranscodingSessionController::getTopSession_l() {
+std::vector<std::pair<TranscodingSessionController::Session*, int32_t>>
+TranscodingSessionController::getTopSessions_l() {
+    std::vector<std::pair<Session*, int32_t>> topSessions;
     if (mSessionMap.empty()) {
-        return nullptr;
+        return topSessions;
     }
 
-    // Return nullptr if we're paused globally due to resource lost or thermal throttling.
+    // Return nothing if we're paused globally due to resource lost or thermal throttling.
     if (((mResourcePolicy != nullptr && mResourceLost) ||
          (mThermalPolicy != nullptr && mThermalThrottling))) {
-        return nullptr;
+        return topSessions;
+    }
+
+    std::vector<bool> transcoderTaken(mTranscoders.size(), false);
+    auto pick = [&](Session* session) {
+        for (const auto& entry : topSessions) {
+            if (entry.first == session) {
+                return;
+            }
+        }
+        int32_t index = session->transcoderIndex;
+        if (index < 0) {
+            // Never started, any free transcoder will do.
+            auto it = std::find(transcoderTaken.begin(), transcoderTaken.end(), false);
+            if (it == transcoderTaken.end()) {
+                return;
+            }
+            index = it - transcoderTaken.begin();
+        } else if (transcoderTaken[index]) {
+            // Holds its paused state in a transcoder that a more important session uses.
+            return;
+        }
+        transcoderTaken[index] = true;
+        topSessions.emplace_back(session, index);
+    };
+
+    // Walk the uids from the most-recently-top one. Within a uid's queue, sessions that are
+    // already running come first, so that they continue to run even if they're not the earliest
+    // in that queue. For example, uid(B) is added to a session while it's pending in uid(A)'s
+    // queue, then B is brought to front which caused the session to run, then user switches
+    // back to A.
+    for (uid_t uid : mUidSortedList) {
+        for (bool running : {true, false}) {
+            for (const SessionKeyType& sessionKey : mSessionQueues[uid]) {
+                Session* session = &mSessionMap[sessionKey];
+                if (session->isRunning() == running) {
+                    pick(session);
+                }
+                if (topSessions.size() >= (size_t)mConcurrencyLimit) {
+                    return topSessions;
+                }
+            }
+        }
+    }
+    return topSessions;
+}
+
+const std::shared_ptr<TranscoderInterface>& TranscodingSessionController::getTranscoder_l(
+        int32_t index) {
+    if (mTranscoders[index] == nullptr) {
+        mTranscoders[index] = mTranscoderFactory(shared_from_this());
     }
+    return mTranscoders[index];
+}
 
-    uid_t topUid = *mUidSortedList.begin();
-    // If the current session is running, and it's in the topUid's queue, let it continue
-    // to run even if it's not the earliest in that uid's queue.
-    // For example, uid(B) is added to a session while it's pending in uid(A)'s queue, then
-    // B is brought to front which caused the session to run, then user switches back to A.
-    if (mCurrentSession != nullptr && mCurrentSession->getState() == Session::RUNNING &&
-        mCurrentSession->allClientUids.count(topUid) > 0) {
-        return mCurrentSession;
+size_t TranscodingSessionController::countRunningSessions_l() const {
+    size_t count = 0;
+    for (const auto& entry : mSessionMap) {
+        if (entry.second.getState() == Session::RUNNING) {
+            ++count;
+        }
     }
-    SessionKeyType topSessionKey = *mSessionQueues[topUid].begin();
-    return &mSessionMap[topSessionKey];
+    return count;
 }
 
 void TranscodingSessionController::setSessionState_l(Session* session, Session::State state) {
@@ -461,14 +521,11 @@ void TranscodingSessionController::setSessionState_l(Session* session, Session::
         return;
     }
 
-    // Currently we only have 1 running session, and we always put the previous
-    // session in non-running state before we run the new session, so it's okay
-    // to start/stop the watchdog here. If this assumption changes, we need to
-    // track the number of running sessions and start/stop watchdog based on that.
+    // The watchdog monitors every running session separately.
     if (isRunning) {
         mWatchdog->start(session->key);
     } else {
-        mWatchdog->stop();
+        mWatchdog->stop(session->key);
     }
 }
 
@@ -501,72 +558,78 @@ void TranscodingSessionController::Session::setState(Session::State newState) {
     state = newState;
 }
 
-void TranscodingSessionController::updateCurrentSession_l() {
-    Session* curSession = mCurrentSession;
-    Session* topSession = nullptr;
-
-    // Delayed init of transcoder and watchdog.
-    if (mTranscoder == nullptr) {
-        mTranscoder = mTranscoderFactory(shared_from_this());
+void TranscodingSessionController::updateRunningSessions_l() {
+    // Delayed init of watchdog. Transcoders are created when first used.
+    if (mWatchdog == nullptr) {
         mWatchdog = std::make_shared<Watchdog>(this, mConfig.watchdogTimeoutUs);
     }
 
-    // If we found a different top session, or the top session's running state is not
-    // correct. Take some actions to ensure it's correct.
-    while ((topSession = getTopSession_l()) != curSession ||
-           (topSession != nullptr && !topSession->isRunning())) {
-        ALOGV("updateCurrentSession_l: topSession is %s, curSession is %s",
-              topSession == nullptr ? "null" : sessionToString(topSession->key).c_str(),
-              curSession == nullptr ? "null" : sessionToString(curSession->key).c_str());
-
-        // If current session is running, pause it first. Note this is needed for either
-        // cases: 1) Top session is changing to another session, or 2) Top session is
-        // changing to null (which means we should be globally paused).
-        if (curSession != nullptr && curSession->getState() == Session::RUNNING) {
-            mTranscoder->pause(curSession->key.first, curSession->key.second);
-            setSessionState_l(curSession, Session::PAUSED);
-        }
-
-        if (topSession == nullptr) {
-            // Nothing more to run (either no session or globally paused).
-            break;
+    bool sessionDropped;
+    do {
+        sessionDropped = false;
+        std::vector<std::pair<Session*, int32_t>> topSessions = getTopSessions_l();
+
+        // Pause the running sessions that are no longer among the top sessions first. This
+        // is needed for either cases: 1) Top sessions are changing to other sessions, or
+        // 2) Top sessions are changing to none (which means we should be globally paused).
+        for (auto& entry : mSessionMap) {
+            Session* session = &entry.second;
+            if (session->getState() != Session::RUNNING ||
+                std::find_if(topSessions.begin(), topSessions.end(), [session](const auto& top) {
+                    return top.first == session;
+                }) != topSessions.end()) {
+                continue;
+            }
+            ALOGV("updateRunningSessions_l: pausing %s", sessionToString(session->key).c_str());
+            getTranscoder_l(session->transcoderIndex)->pause(session->key.first,
+                                                             session->key.second);
+            setSessionState_l(session, Session::PAUSED);
         }
 
-        // Otherwise, ensure topSession is running.
-        if (topSession->getState() == Session::NOT_STARTED) {
-            // Check if at least one client has quota to start the session.
-            bool keepForClient = false;
-            for (uid_t uid : topSession->allClientUids) {
-                if (mPacer->onSessionStarted(uid, topSession->callingUid)) {
-                    keepForClient = true;
-                    // DO NOT break here, because book-keeping still needs to happen
-                    // for the other uids.
+        // Then ensure the top sessions are running.
+        for (auto& [topSession, index] : topSessions) {
+            if (topSession->getState() == Session::NOT_STARTED) {
+                // Check if at least one client has quota to start the session.
+                bool keepForClient = false;
+                for (uid_t uid : topSession->allClientUids) {
+                    if (mPacer->onSessionStarted(uid, topSession->callingUid)) {
+                        keepForClient = true;
+                        // DO NOT break here, because book-keeping still needs to happen
+                        // for the other uids.
+                    }
                 }
-            }
-            if (!keepForClient) {
-                // Unfortunately all uids requesting this session are out of quota.
-                // Drop this session and try the next one.
-                {
-                    auto clientCallback = mSessionMap[topSession->key].callback.lock();
-                    if (clientCallback != nullptr) {
-                        clientCallback->onTranscodingFailed(
-                                topSession->key.second, TranscodingErrorCode::kDroppedByService);
+                if (!keepForClient) {
+                    // Unfortunately all uids requesting this session are out of quota.
+                    // Drop this session and try the next one.
+                    {
+                        auto clientCallback = mSessionMap[topSession->key].callback.lock();
+                        if (clientCallback != nullptr) {
+                            clientCallback->onTranscodingFailed(
+                                    topSession->key.second,
+                                    TranscodingErrorCode::kDroppedByService);
+                        }
                     }
+                    removeSession_l(topSession->key, Session::DROPPED_BY_PACER);
+                    sessionDropped = true;
+                    break;
                 }
-                removeSession_l(topSession->key, Session::DROPPED_BY_PACER);
-                continue;
+                ALOGV("updateRunningSessions_l: starting %s on transcoder %d",
+                      sessionToString(topSession->key).c_str(), index);
+                topSession->transcoderIndex = index;
+                getTranscoder_l(index)->start(topSession->key.first, topSession->key.second,
+                                              topSession->request, topSession->callingUid,
+                                              topSession->callback.lock());
+                setSessionState_l(topSession, Session::RUNNING);
+            } else if (topSession->getState() == Session::PAUSED) {
+                ALOGV("updateRunningSessions_l: resuming %s on transcoder %d",
+                      sessionToString(topSession->key).c_str(), index);
+                getTranscoder_l(index)->resume(topSession->key.first, topSession->key.second,
+                                               topSession->request, topSession->callingUid,
+                                               topSession->callback.lock());
+                setSessionState_l(topSession, Session::RUNNING);
             }
-            mTranscoder->start(topSession->key.first, topSession->key.second, topSession->request,
-                               topSession->callingUid, topSession->callback.lock());
-            setSessionState_l(topSession, Session::RUNNING);
-        } else if (topSession->getState() == Session::PAUSED) {
-            mTranscoder->resume(topSession->key.first, topSession->key.second, topSession->request,
-                                topSession->callingUid, topSession->callback.lock());
-            setSessionState_l(topSession, Session::RUNNING);
         }
-        break;
-    }
-    mCurrentSession = topSession;
+    } while (sessionDropped);
 }
 
 void TranscodingSessionController::addUidToSession_l(uid_t clientUid,
@@ -648,11 +711,6 @@ void TranscodingSessionController::removeSession_l(
         return;
     }
 
-    // Clear current session.
-    if (mCurrentSession == &mSessionMap[sessionKey]) {
-        mCurrentSession = nullptr;
-    }
-
     setSessionState_l(&mSessionMap[sessionKey], finalState);
 
     // We can use onSessionCompleted() even for CANCELLED, because runningTime is
@@ -760,7 +818,7 @@ bool TranscodingSessionController::submit(
 
     addUidToSession_l(clientUid, sessionKey);
 
-    updateCurrentSession_l();
+    updateRunningSessions_l();
 
     validateState_l();
     return true;
@@ -801,7 +859,7 @@ bool TranscodingSessionController::cancel(ClientIdType clientId, SessionIdType s
         // the transcoder to discard any states for the session, otherwise the states may
         // never be discarded.
         if (mSessionMap[*it].getState() != Session::NOT_STARTED) {
-            mTranscoder->stop(it->first, it->second);
+            getTranscoder_l(mSessionMap[*it].transcoderIndex)->stop(it->first, it->second);
         }
 
         // Remove the session.
@@ -815,7 +873,7 @@ bool TranscodingSessionController::cancel(ClientIdType clientId, SessionIdType s
     }
 
     // Start next session.
-    updateCurrentSession_l();
+    updateRunningSessions_l();
 
     validateState_l();
     return true;
@@ -840,7 +898,7 @@ bool TranscodingSessionController::addClientUid(ClientIdType clientId, SessionId
     mSessionMap[sessionKey].allClientUids.insert(clientUid);
     addUidToSession_l(clientUid, sessionKey);
 
-    updateCurrentSession_l();
+    updateRunningSessions_l();
 
     validateState_l();
     return true;
@@ -949,7 +1007,7 @@ void TranscodingSessionController::onFinish(ClientIdType clientId, SessionIdType
         removeSession_l(sessionKey, Session::FINISHED);
 
         // Start next session.
-        updateCurrentSession_l();
+        updateRunningSessions_l();
 
         validateState_l();
     });
@@ -961,10 +1019,12 @@ void TranscodingSessionController::onError(ClientIdType clientId, SessionIdType
         if (err == TranscodingErrorCode::kWatchdogTimeout) {
             // Abandon the transcoder, as its handler thread might be stuck in some call to
             // MediaTranscoder altogether, and may not be able to handle any new tasks.
-            mTranscoder->stop(clientId, sessionId, true /*abandon*/);
+            // Transcoders running other sessions are not affected.
+            int32_t index = mSessionMap[sessionKey].transcoderIndex;
+            mTranscoders[index]->stop(clientId, sessionId, true /*abandon*/);
             // Clear the last ref count before we create new transcoder.
-            mTranscoder = nullptr;
-            mTranscoder = mTranscoderFactory(shared_from_this());
+            mTranscoders[index] = nullptr;
+            mTranscoders[index] = mTranscoderFactory(shared_from_this());
         }
 
         {
@@ -978,7 +1038,7 @@ void TranscodingSessionController::onError(ClientIdType clientId, SessionIdType
         removeSession_l(sessionKey, Session::ERROR);
 
         // Start next session.
-        updateCurrentSession_l();
+        updateRunningSessions_l();
 
         validateState_l();
     });
@@ -997,7 +1057,7 @@ void TranscodingSessionController::onProgressUpdate(ClientIdType clientId, Sessi
 
 void TranscodingSessionController::onHeartBeat(ClientIdType clientId, SessionIdType sessionId) {
     notifyClient(clientId, sessionId, "heart-beat",
-                 [=](const SessionKeyType& /*sessionKey*/) { mWatchdog->keepAlive(); });
+                 [=](const SessionKeyType& sessionKey) { mWatchdog->keepAlive(sessionKey); });
 }
 
 void TranscodingSessionController::onResourceLost(ClientIdType clientId, SessionIdType sessionId) {
@@ -1026,7 +1086,19 @@ void TranscodingSessionController::onResourceLost(ClientIdType clientId, Session
         if (mResourcePolicy != nullptr) {
             mResourcePolicy->setPidResourceLost(resourceLostSession->request.clientPid);
         }
-        mResourceLost = true;
+
+        int32_t stillRunning = countRunningSessions_l();
+        if (stillRunning == 0) {
+            mResourceLost = true;
+        } else {
+            // The other running sessions are holding the codecs this one needs, so the device
+            // can't take as many sessions at once. Admit only as many as are still running
+            // until resources become available, and let the more important sessions have them.
+            ALOGI("%s: lowering concurrency limit from %d to %d", __FUNCTION__, mConcurrencyLimit,
+                  stillRunning);
+            mConcurrencyLimit = stillRunning;
+            updateRunningSessions_l();
+        }
 
         validateState_l();
     });
@@ -1052,7 +1124,7 @@ void TranscodingSessionController::onTopUidsChanged(const std::unordered_set<uid
 
     moveUidsToTop_l(uids, true /*preserveTopUid*/);
 
-    updateCurrentSession_l();
+    updateRunningSessions_l();
 
     validateState_l();
 }
@@ -1082,7 +1154,7 @@ void TranscodingSessionController::onUidGone(uid_t goneUid) {
         // the transcoder to discard any states for the session, otherwise the states may
         // never be discarded.
         if (mSessionMap[*it].getState() != Session::NOT_STARTED) {
-            mTranscoder->stop(it->first, it->second);
+            getTranscoder_l(mSessionMap[*it].transcoderIndex)->stop(it->first, it->second);
         }
 
         {
@@ -1104,7 +1176,7 @@ void TranscodingSessionController::onUidGone(uid_t goneUid) {
     }
 
     // Start next session.
-    updateCurrentSession_l();
+    updateRunningSessions_l();
 
     validateState_l();
 }
@@ -1112,14 +1184,15 @@ void TranscodingSessionController::onUidGone(uid_t goneUid) {
 void TranscodingSessionController::onResourceAvailable() {
     std::scoped_lock lock{mLock};
 
-    if (!mResourceLost) {
+    if (!mResourceLost && mConcurrencyLimit == mConfig.maxConcurrentSessions) {
         return;
     }
 
     ALOGI("%s", __FUNCTION__);
 
     mResourceLost = false;
-    updateCurrentSession_l();
+    mConcurrencyLimit = mConfig.maxConcurrentSessions;
+    updateRunningSessions_l();
 
     validateState_l();
 }
@@ -1134,7 +1207,7 @@ void TranscodingSessionController::onThrottlingStarted() {
     ALOGI("%s", __FUNCTION__);
 
     mThermalThrottling = true;
-    updateCurrentSession_l();
+    updateRunningSessions_l();
 
     validateState_l();
 }
@@ -1149,7 +1222,7 @@ void TranscodingSessionController::onThrottlingStopped() {
     ALOGI("%s", __FUNCTION__);
 
     mThermalThrottling = false;
-    updateCurrentSession_l();
+    updateRunningSessions_l();
 
     validateState_l();
 }
@@ -1184,6 +1257,9 @@ void TranscodingSessionController::validateState_l() {
                         "session count (including dup) from mSessionQueues doesn't match that from "
                         "mSessionMap, %d vs %d",
                         totalSessions, totalSessionsAlternative);
+    LOG_ALWAYS_FATAL_IF(countRunningSessions_l() > (size_t)mConcurrencyLimit,
+                        "%zu sessions running, more than the limit of %d",
+                        countRunningSessions_l(), mConcurrencyLimit);
 #endif  // VALIDATE_STATE
 }
 
@@ -32,6 +32,7 @@
 #include <list>
 #include <map>
 #include <mutex>
+#include <vector>
 
 namespace android {
 using ::aidl::android::media::TranscodingResultParcel;
@@ -108,6 +109,9 @@ private:
         int32_t pacerBurstCountQuota = 10;
         // Maximum allowed back-to-back running time.
         int32_t pacerBurstTimeQuotaSeconds = 120;  // 2-min
+        // Maximum number of sessions allowed to run at the same time, each on its own
+        // transcoder. The limit is lowered at runtime if codec resources run out.
+        int32_t maxConcurrentSessions = 1;
     };
 
     struct Session {
@@ -128,6 +132,9 @@ private:
         std::unordered_set<uid_t> allClientUids;
         int32_t lastProgress = 0;
         int32_t pauseCount = 0;
+        // Index of the transcoder the session was started on, -1 if never started.
+        // A paused session can only be resumed on the same transcoder.
+        int32_t transcoderIndex = -1;
         std::chrono::time_point<std::chrono::steady_clock> stateEnterTime;
         std::chrono::microseconds waitingTime{0};
         std::chrono::microseconds runningTime{0};
@@ -166,12 +173,14 @@ private:
     std::map<uid_t, std::string> mUidPackageNames;
 
     TranscoderFactoryType mTranscoderFactory;
-    std::shared_ptr<TranscoderInterface> mTranscoder;
+    // One transcoder per concurrently running session, created on first use.
+    std::vector<std::shared_ptr<TranscoderInterface>> mTranscoders;
     std::shared_ptr<UidPolicyInterface> mUidPolicy;
     std::shared_ptr<ResourcePolicyInterface> mResourcePolicy;
     std::shared_ptr<ThermalPolicyInterface> mThermalPolicy;
 
-    Session* mCurrentSession;
+    // Number of sessions currently allowed to run at the same time.
+    int32_t mConcurrencyLimit;
     bool mResourceLost;
     bool mThermalThrottling;
     std::list<Session> mSessionHistory;
@@ -186,8 +195,10 @@ private:
                                  const ControllerConfig* config = nullptr);
 
     void dumpSession_l(const Session& session, String8& result, bool closedSession = false);
-    Session* getTopSession_l();
-    void updateCurrentSession_l();
+    std::vector<std::pair<Session*, int32_t>> getTopSessions_l();
+    void updateRunningSessions_l();
+    const std::shared_ptr<TranscoderInterface>& getTranscoder_l(int32_t index);
+    size_t countRunningSessions_l() const;
     void addUidToSession_l(uid_t uid, const SessionKeyType& sessionKey);
     void removeSession_l(const SessionKeyType& sessionKey, Session::State finalState,
                          const std::shared_ptr<std::function<bool(uid_t uid)>>& keepUid = nullptr);
@@ -20,6 +20,8 @@
 #include <android-base/logging.h>
 #include <media/MediaSampleReaderNDK.h>
 
+#include <string.h>
+
 #include <algorithm>
 #include <cmath>
 
@@ -63,18 +65,40 @@ MediaSampleReaderNDK::~MediaSampleReaderNDK() {
 }
 
 void MediaSampleReaderNDK::advanceTrack_l(int trackIndex) {
+    SampleCursor& cursor = mTrackCursors[trackIndex];
+    const PrefetchedSample* prefetchedNext = nullptr;
+
     if (!mEnforceSequentialAccess) {
+        // The sample after the current one is known without moving the extractor if it has
+        // already been prefetched.
+        if (findPrefetchedSample_l(trackIndex) != nullptr) {
+            const std::deque<PrefetchedSample>& samples = mPrefetchBuffers[trackIndex].samples;
+            if (samples.size() > 1) {
+                prefetchedNext = &samples[1];
+            }
+        }
+
         // Note: Positioning the extractor before advancing the track is needed for two reasons:
         // 1. To enable multiple advances without explicitly letting the extractor catch up.
         // 2. To prevent the extractor from being farther than "next".
-        (void)moveToTrack_l(trackIndex);
+        if (!cursor.next.isSet && prefetchedNext == nullptr) {
+            (void)moveToTrack_l(trackIndex);
+        }
     }
 
-    SampleCursor& cursor = mTrackCursors[trackIndex];
     cursor.previous = cursor.current;
     cursor.current = cursor.next;
     cursor.next.reset();
 
+    if (!mEnforceSequentialAccess) {
+        if (!cursor.current.isSet && prefetchedNext != nullptr) {
+            cursor.current.set(prefetchedNext->index, prefetchedNext->info.presentationTimeUs);
+        }
+        if (cursor.previous.isSet) {
+            dropPrefetchedSamples_l(trackIndex, cursor.previous.index);
+        }
+    }
+
     if (mEnforceSequentialAccess && trackIndex == mExtractorTrackIndex) {
         while (advanceExtractor_l()) {
             SampleCursor& cursor = mTrackCursors[mExtractorTrackIndex];
@@ -163,16 +187,100 @@ media_status_t MediaSampleReaderNDK::moveToSample_l(SamplePosition& pos, int tra
         if (status != AMEDIA_OK) return status;
     }
 
-    // Advance until extractor points to the sample.
+    // Advance until extractor points to the sample, keeping what other tracks will need.
     while (!(pos.isSet && pos.index == mExtractorSampleIndex)) {
         if (!advanceExtractor_l()) {
             return AMEDIA_ERROR_END_OF_STREAM;
         }
+        prefetchSample_l(trackIndex);
     }
 
     return AMEDIA_OK;
 }
 
+void MediaSampleReaderNDK::prefetchSample_l(int trackIndex) {
+    if (mEnforceSequentialAccess || mExtractorTrackIndex == trackIndex) {
+        return;
+    }
+
+    auto it = mPrefetchBuffers.find(mExtractorTrackIndex);
+    if (it == mPrefetchBuffers.end() || !it->second.open) {
+        return;
+    }
+    PrefetchBuffer& buffer = it->second;
+
+    // Only extend the run of samples the track has not read yet.
+    const SampleCursor& cursor = mTrackCursors[mExtractorTrackIndex];
+    if (buffer.samples.empty()) {
+        if (!(cursor.current.isSet && cursor.current.index == mExtractorSampleIndex) &&
+            !(cursor.next.isSet && cursor.next.index == mExtractorSampleIndex)) {
+            return;
+        }
+    } else if (mExtractorSampleIndex <= buffer.samples.back().index) {
+        return;
+    }
+
+    ssize_t sampleSize = AMediaExtractor_getSampleSize(mExtractor);
+    if (sampleSize < 0 || (size_t)sampleSize > kPrefetchBudgetBytes - mPrefetchedBytes) {
+        buffer.open = false;
+        return;
+    }
+
+    PrefetchedSample sample;
+    sample.index = mExtractorSampleIndex;
+    sample.info.presentationTimeUs = AMediaExtractor_getSampleTime(mExtractor);
+    sample.info.flags = AMediaExtractor_getSampleFlags(mExtractor);
+    sample.info.size = sampleSize;
+    sample.data.resize(sampleSize);
+    if (AMediaExtractor_readSampleData(mExtractor, sample.data.data(), sampleSize) < sampleSize) {
+        buffer.open = false;
+        return;
+    }
+
+    mPrefetchedBytes += sampleSize;
+    buffer.samples.push_back(std::move(sample));
+}
+
+const MediaSampleReaderNDK::PrefetchedSample* MediaSampleReaderNDK::findPrefetchedSample_l(
+        int trackIndex) {
+    const SamplePosition& current = mTrackCursors[trackIndex].current;
+    if (!current.isSet) {
+        return nullptr;
+    }
+
+    auto it = mPrefetchBuffers.find(trackIndex);
+    if (it == mPrefetchBuffers.end() || it->second.samples.empty()) {
+        return nullptr;
+    }
+
+    const PrefetchedSample& sample = it->second.samples.front();
+    return sample.index == current.index ? &sample : nullptr;
+}
+
+void MediaSampleReaderNDK::dropPrefetchedSamples_l(int trackIndex, uint64_t sampleIndex) {
+    auto it = mPrefetchBuffers.find(trackIndex);
+    if (it == mPrefetchBuffers.end()) {
+        return;
+    }
+
+    PrefetchBuffer& buffer = it->second;
+    while (!buffer.samples.empty() && buffer.samples.front().index <= sampleIndex) {
+        mPrefetchedBytes -= buffer.samples.front().data.size();
+        buffer.samples.pop_front();
+    }
+    if (buffer.samples.empty()) {
+        buffer.open = true;
+    }
+}
+
+void MediaSampleReaderNDK::clearPrefetchedSamples_l() {
+    for (auto& entry : mPrefetchBuffers) {
+        entry.second.samples.clear();
+        entry.second.open = true;
+    }
+    mPrefetchedBytes = 0;
+}
+
 media_status_t MediaSampleReaderNDK::moveToTrack_l(int trackIndex) {
     return moveToSample_l(mTrackCursors[trackIndex].current, trackIndex);
 }
@@ -234,6 +342,7 @@ media_status_t MediaSampleReaderNDK::selectTrack(int trackIndex) {
 
     mTrackSignals.emplace(std::piecewise_construct, std::forward_as_tuple(trackIndex),
                           std::forward_as_tuple());
+    mPrefetchBuffers.emplace(trackIndex, PrefetchBuffer());
     return AMEDIA_OK;
 }
 
@@ -254,6 +363,7 @@ media_status_t MediaSampleReaderNDK::unselectTrack(int trackIndex) {
         return AMEDIA_ERROR_INVALID_PARAMETER;
     }
     mTrackSignals.erase(it);
+    mPrefetchBuffers.erase(trackIndex);
 
     media_status_t status = AMediaExtractor_unselectTrack(mExtractor, trackIndex);
     if (status != AMEDIA_OK) {
@@ -276,6 +386,9 @@ media_status_t MediaSampleReaderNDK::setEnforceSequentialAccess(bool enforce) {
             it->second.notify_all();
         }
     } else if (!mEnforceSequentialAccess && enforce && mExtractorTrackIndex >= 0) {
+        // Sequential access reads every sample from the extractor again.
+        clearPrefetchedSamples_l();
+
         // If switching from not enforcing to enforcing sequential access the extractor needs to be
         // positioned for the track farthest behind so that it won't get stuck waiting.
         struct {
@@ -399,6 +512,13 @@ media_status_t MediaSampleReaderNDK::getSampleInfoForTrack(int trackIndex, Media
         return AMEDIA_ERROR_INVALID_PARAMETER;
     }
 
+    if (!mEnforceSequentialAccess) {
+        if (const PrefetchedSample* sample = findPrefetchedSample_l(trackIndex)) {
+            *info = sample->info;
+            return AMEDIA_OK;
+        }
+    }
+
     media_status_t status = primeExtractorForTrack_l(trackIndex, lock);
     if (status == AMEDIA_OK) {
         info->presentationTimeUs = AMediaExtractor_getSampleTime(mExtractor);
@@ -428,6 +548,19 @@ media_status_t MediaSampleReaderNDK::readSampleDataForTrack(int trackIndex, uint
         return AMEDIA_ERROR_INVALID_PARAMETER;
     }
 
+    if (!mEnforceSequentialAccess) {
+        if (const PrefetchedSample* sample = findPrefetchedSample_l(trackIndex)) {
+            if (bufferSize < sample->data.size()) {
+                LOG(ERROR) << "Buffer is too small for sample, " << bufferSize << " vs "
+                           << sample->data.size();
+                return AMEDIA_ERROR_INVALID_PARAMETER;
+            }
+            memcpy(buffer, sample->data.data(), sample->data.size());
+            advanceTrack_l(trackIndex);
+            return AMEDIA_OK;
+        }
+    }
+
     media_status_t status = primeExtractorForTrack_l(trackIndex, lock);
     if (status != AMEDIA_OK) {
         return status;
@@ -23,6 +23,8 @@
 #include <media/VideoTrackTranscoder.h>
 #include <sys/prctl.h>
 
+#include <thread>
+
 using namespace AMediaFormatUtils;
 
 namespace android {
@@ -121,8 +123,7 @@ struct AsyncCodecCallbackDispatch {
                 static_cast<VideoTrackTranscoder::CodecWrapper*>(userdata);
         if (auto transcoder = wrapper->getTranscoder()) {
             if (codec == transcoder->mDecoder) {
-                transcoder->mCodecMessageQueue.push(
-                        [transcoder, index] { transcoder->enqueueInputSample(index); });
+                transcoder->mInputBufferQueue.push(index);
             }
         }
     }
@@ -397,40 +398,76 @@ media_status_t VideoTrackTranscoder::configureDestinationFormat(
     return AMEDIA_OK;
 }
 
-void VideoTrackTranscoder::enqueueInputSample(int32_t bufferIndex) {
+void VideoTrackTranscoder::runInputLoop() {
+    prctl(PR_SET_NAME, (unsigned long)"VideTranscodInp", 0, 0, 0);
+
+    using std::chrono::steady_clock;
+    steady_clock::duration readingTime{0};
+    steady_clock::duration waitingTime{0};
+
+    while (true) {
+        const steady_clock::time_point waitStart = steady_clock::now();
+        const int32_t bufferIndex = mInputBufferQueue.pop();
+        const steady_clock::time_point readStart = steady_clock::now();
+        waitingTime += readStart - waitStart;
+        if (bufferIndex == kStopInputLoop) {
+            break;
+        }
+
+        media_status_t status = enqueueInputSample(bufferIndex);
+        readingTime += steady_clock::now() - readStart;
+        if (status != AMEDIA_OK) {
+            mCodecMessageQueue.push([this, status] { mStatus = status; }, true /* front */);
+            break;
+        }
+    }
+
+    // Time spent reading samples is the time the decoder may have been starved by the source,
+    // time spent waiting is the time the decoder was still busy with earlier input.
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+    LOG(INFO) << "Video input: " << mInputFrameCount << " frames, reading "
+              << duration_cast<milliseconds>(readingTime).count() << " ms, waiting for decoder "
+              << duration_cast<milliseconds>(waitingTime).count() << " ms";
+}
+
+media_status_t VideoTrackTranscoder::enqueueInputSample(int32_t bufferIndex) {
     media_status_t status = AMEDIA_OK;
 
     if (mEosFromSource) {
-        return;
+        return AMEDIA_OK;
     }
 
+    // This may wait for other tracks to read their samples first, so do it before taking the
+    // input lock.
     status = mMediaSampleReader->getSampleInfoForTrack(mTrackIndex, &mSampleInfo);
     if (status != AMEDIA_OK && status != AMEDIA_ERROR_END_OF_STREAM) {
         LOG(ERROR) << "Error getting next sample info: " << status;
-        mStatus = status;
-        return;
+        return status;
     }
     const bool endOfStream = (status == AMEDIA_ERROR_END_OF_STREAM);
 
+    std::scoped_lock lock(mInputMutex);
+    if (mInputStopped) {
+        return AMEDIA_OK;
+    }
+
     if (!endOfStream) {
         size_t bufferSize = 0;
         uint8_t* sourceBuffer = AMediaCodec_getInputBuffer(mDecoder, bufferIndex, &bufferSize);
         if (sourceBuffer == nullptr) {
             LOG(ERROR) << "Decoder returned a NULL input buffer.";
-            mStatus = AMEDIA_ERROR_UNKNOWN;
-            return;
+            return AMEDIA_ERROR_UNKNOWN;
         } else if (bufferSize < mSampleInfo.size) {
             LOG(ERROR) << "Decoder returned an input buffer that is smaller than the sample.";
-            mStatus = AMEDIA_ERROR_UNKNOWN;
-            return;
+            return AMEDIA_ERROR_UNKNOWN;
         }
 
         status = mMediaSampleReader->readSampleDataForTrack(mTrackIndex, sourceBuffer,
                                                             mSampleInfo.size);
         if (status != AMEDIA_OK) {
             LOG(ERROR) << "Unable to read next sample data. Aborting transcode.";
-            mStatus = status;
-            return;
+            return status;
         }
 
         if (mSampleInfo.size) {
@@ -445,9 +482,9 @@ void VideoTrackTranscoder::enqueueInputSample(int32_t bufferIndex) {
                                           mSampleInfo.presentationTimeUs, mSampleInfo.flags);
     if (status != AMEDIA_OK) {
         LOG(ERROR) << "Unable to queue input buffer for decode: " << status;
-        mStatus = status;
-        return;
+        return status;
     }
+    return AMEDIA_OK;
 }
 
 void VideoTrackTranscoder::transferBuffer(int32_t bufferIndex, AMediaCodecBufferInfo bufferInfo) {
@@ -617,10 +654,19 @@ media_status_t VideoTrackTranscoder::runTranscodeLoop(bool* stopped) {
         mEncoder->setStarted();
     });
 
+    // The input thread keeps the transcoder alive until it has seen kStopInputLoop, even if it
+    // is still waiting for the sample reader when the transcode loop ends.
+    std::thread([self = shared_from_this()] { self->runInputLoop(); }).detach();
+
     // Process codec events until EOS is reached, transcoding is stopped or an error occurs.
+    using std::chrono::steady_clock;
+    const steady_clock::time_point loopStart = steady_clock::now();
+    steady_clock::duration busyTime{0};
     while (mStopRequest != STOP_NOW && !mEosFromEncoder && mStatus == AMEDIA_OK) {
         std::function<void()> message = mCodecMessageQueue.pop();
+        const steady_clock::time_point messageStart = steady_clock::now();
         message();
+        busyTime += steady_clock::now() - messageStart;
 
         if (mStopRequest == STOP_ON_SYNC && mLastSampleWasSync) {
             break;
@@ -628,8 +674,19 @@ media_status_t VideoTrackTranscoder::runTranscodeLoop(bool* stopped) {
     }
 
     mCodecMessageQueue.abort();
+    {
+        std::scoped_lock lock(mInputMutex);
+        mInputStopped = true;
+    }
+    mInputBufferQueue.push(kStopInputLoop, true /* front */);
     AMediaCodec_stop(mDecoder);
 
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+    LOG(INFO) << "Video codec loop: " << mOutputFrameCount << " frames in "
+              << duration_cast<milliseconds>(steady_clock::now() - loopStart).count()
+              << " ms, busy " << duration_cast<milliseconds>(busyTime).count() << " ms";
+
     // Signal if transcoding was stopped before it finished.
     if (mStopRequest != NONE && !mEosFromEncoder && mStatus == AMEDIA_OK) {
         *stopped = true;
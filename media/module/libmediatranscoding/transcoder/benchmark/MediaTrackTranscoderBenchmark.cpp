@@ -27,6 +27,10 @@
  *
  * 3. Run:
  *      $ adb shell /data/nativetest64/MediaTrackTranscoderBenchmark/MediaTrackTranscoderBenchmark
+ *
+ * Besides the frame rate, each benchmark reports the distribution of the time between output
+ * frames, the CPU time per pipeline stage, the peak memory, and the energy use and temperature
+ * rise where the device exposes them (see TranscoderMetrics.h).
  */
 
 // #define LOG_NDEBUG 0
@@ -45,6 +49,7 @@
 #include <media/VideoTrackTranscoder.h>
 
 #include "BenchmarkCommon.h"
+#include "TranscoderMetrics.h"
 
 using namespace android;
 
@@ -275,15 +280,18 @@ static std::shared_ptr<MediaSampleReader> GetSampleReader(const std::string& src
 
 /**
  * Configures a MediaTrackTranscoder with an empty sample consumer so that the samples are returned
- * to the transcoder immediately.
+ * to the transcoder immediately. The arrival of each sample is recorded in |frameLatency|.
  */
 static void ConfigureEmptySampleConsumer(const std::shared_ptr<MediaTrackTranscoder>& transcoder,
-                                         uint32_t& sampleCount) {
-    transcoder->setSampleConsumer([&sampleCount](const std::shared_ptr<MediaSample>& sample) {
-        if (!(sample->info.flags & SAMPLE_FLAG_CODEC_CONFIG) && sample->info.size > 0) {
-            ++sampleCount;
-        }
-    });
+                                         uint32_t& sampleCount,
+                                         FrameLatencyRecorder& frameLatency) {
+    transcoder->setSampleConsumer(
+            [&sampleCount, &frameLatency](const std::shared_ptr<MediaSample>& sample) {
+                if (!(sample->info.flags & SAMPLE_FLAG_CODEC_CONFIG) && sample->info.size > 0) {
+                    ++sampleCount;
+                    frameLatency.onFrame();
+                }
+            });
 }
 
 /**
@@ -348,6 +356,9 @@ static void BenchmarkTranscoder(benchmark::State& state, const std::string& srcF
     static pthread_once_t once = PTHREAD_ONCE_INIT;
     pthread_once(&once, ABinderProcess_startThreadPool);
 
+    ResourceSampler resourceSampler;
+    FrameLatencyRecorder frameLatency;
+
     for (auto _ : state) {
         std::shared_ptr<TrackTranscoderCallbacks> callbacks =
                 std::make_shared<TrackTranscoderCallbacks>();
@@ -371,8 +382,10 @@ static void BenchmarkTranscoder(benchmark::State& state, const std::string& srcF
         }
 
         uint32_t sampleCount = 0;
-        ConfigureEmptySampleConsumer(transcoder, sampleCount);
+        ConfigureEmptySampleConsumer(transcoder, sampleCount, frameLatency);
 
+        resourceSampler.start();
+        frameLatency.start();
         if (!transcoder->start()) {
             state.SkipWithError("Unable to start the transcoder");
             return;
@@ -380,6 +393,7 @@ static void BenchmarkTranscoder(benchmark::State& state, const std::string& srcF
 
         callbacks->waitForTranscodingFinished();
         transcoder->stop();
+        resourceSampler.stop();
 
         if (callbacks->mStatus != AMEDIA_OK) {
             state.SkipWithError("Transcoder failed with error");
@@ -389,6 +403,9 @@ static void BenchmarkTranscoder(benchmark::State& state, const std::string& srcF
         LOG(DEBUG) << "Number of samples received: " << sampleCount;
         state.counters["FrameRate"] = benchmark::Counter(sampleCount, benchmark::Counter::kIsRate);
     }
+
+    resourceSampler.report(state);
+    frameLatency.report(state);
 }
 
 static void BenchmarkTranscoderWithOperatingRate(benchmark::State& state,
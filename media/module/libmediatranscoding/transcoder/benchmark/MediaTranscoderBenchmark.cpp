@@ -27,6 +27,10 @@
  *
  * 3. Run:
  *      $ adb shell /data/nativetest64/MediaTranscoderBenchmark/MediaTranscoderBenchmark
+ *
+ * Besides the transcoding time, each benchmark reports the CPU time per pipeline stage, the peak
+ * memory, and the energy use and temperature rise where the device exposes them (see
+ * TranscoderMetrics.h). For energy readings, run with the device unplugged, e.g. over wireless adb.
  */
 
 #include <benchmark/benchmark.h>
@@ -38,6 +42,7 @@
 #include <iostream>
 
 #include "BenchmarkCommon.h"
+#include "TranscoderMetrics.h"
 
 using namespace android;
 
@@ -130,6 +135,7 @@ static void TranscodeMediaFile(benchmark::State& state, const std::string& srcFi
     std::string dstPath = kAssetDirectory + dstFileName;
 
     media_status_t status = AMEDIA_OK;
+    ResourceSampler resourceSampler;
 
     if ((srcFd = open(srcPath.c_str(), O_RDONLY)) < 0) {
         state.SkipWithError("Unable to open source file: " + srcPath);
@@ -208,13 +214,16 @@ static void TranscodeMediaFile(benchmark::State& state, const std::string& srcFi
             }
         }
 
+        resourceSampler.start();
         status = transcoder->start();
         if (status != AMEDIA_OK) {
             state.SkipWithError("Unable to start transcoder");
             goto exit;
         }
 
-        if (!callbacks->waitForTranscodingFinished()) {
+        bool finished = callbacks->waitForTranscodingFinished();
+        resourceSampler.stop();
+        if (!finished) {
             transcoder->cancel();
             state.SkipWithError("Transcoder timed out");
             goto exit;
@@ -225,6 +234,8 @@ static void TranscodeMediaFile(benchmark::State& state, const std::string& srcFi
         }
     }
 
+    resourceSampler.report(state);
+
     // Set transcoding configuration params in benchmark label
     state.SetLabel(srcFileName + "," +
                    std::to_string(width) + "x" + std::to_string(height) + "," +
@@ -587,7 +598,12 @@ private:
     std::vector<std::string> mHeaders = {
         "File",          "Resolution",     "SourceMime", "VideoTrackDuration(ms)",
         "IncludeAudio",  "TranscodeVideo", "TargetMime", "TargetBirate(bps)",
-        "real_time(ms)", "cpu_time(ms)",   PARAM_VIDEO_FRAME_RATE
+        "real_time(ms)", "cpu_time(ms)",   PARAM_VIDEO_FRAME_RATE,
+    };
+    // Counters from ResourceSampler, "NA" when the device doesn't expose them.
+    std::vector<std::string> mResourceCounters = {
+        "cpu_extractor(ms)", "cpu_codec(ms)", "cpu_writer(ms)", "cpu_other(ms)",
+        "cpu_codec_service(ms)", "peak_rss(KB)", "energy(mJ)", "power(mW)", "thermal_rise(C)",
     };
 };
 
@@ -600,9 +616,12 @@ void CustomCsvReporter::ReportRuns(const std::vector<Run>& reports) {
 
     if (!mPrintedHeader) {
         // print the header
-        for (auto header = mHeaders.begin(); header != mHeaders.end();) {
+        for (const std::string& header : mHeaders) {
+            Out << header << ",";
+        }
+        for (auto header = mResourceCounters.begin(); header != mResourceCounters.end();) {
             Out << *header++;
-            if (header != mHeaders.end()) Out << ",";
+            if (header != mResourceCounters.end()) Out << ",";
         }
         Out << "\n";
         mPrintedHeader = true;
@@ -630,6 +649,15 @@ void CustomCsvReporter::PrintRunData(const Run& run) {
     } else {
         Out << frameRate->second << ",";
     }
+    for (const std::string& name : mResourceCounters) {
+        auto counter = run.counters.find(name);
+        if (counter == run.counters.end()) {
+            Out << "NA";
+        } else {
+            Out << counter->second;
+        }
+        Out << (&name != &mResourceCounters.back() ? "," : "");
+    }
     Out << '\n';
 }
 
@@ -0,0 +1,360 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TRANSCODER_METRICS_H__
+#define __TRANSCODER_METRICS_H__
+
+#include <benchmark/benchmark.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace android {
+
+/**
+ * Samples the resources used while a benchmark iteration runs, between start() and stop(), and
+ * reports them as benchmark counters:
+ *  - cpu_<stage>(ms): CPU time of the transcoder threads per pipeline stage, see StageOf().
+ *    The codecs themselves run in the codec services, whose CPU time over the iteration is
+ *    reported as cpu_codec_service(ms) when their /proc entries are readable.
+ *  - peak_rss(KB): peak resident set size of the benchmark process.
+ *  - energy(mJ) and power(mW): integrated from the battery fuel gauge, when there is one. Only
+ *    meaningful while the device runs on battery, e.g. over wireless adb.
+ *  - thermal_rise(C): the largest temperature rise of any thermal zone.
+ * Times and energy are averaged over the iterations.
+ */
+class ResourceSampler {
+public:
+    static constexpr const char* kStages[] = {"extractor", "codec", "writer", "other"};
+
+    ResourceSampler() = default;
+    ~ResourceSampler() { stop(); }
+
+    void start() {
+        if (mThread.joinable()) return;
+
+        // Reset the peak RSS of the process, so VmHWM covers this iteration only.
+        std::ofstream("/proc/self/clear_refs") << "5";
+
+        mStartThreads.clear();
+        mLastThreads.clear();
+        ReadThreads(&mStartThreads);
+        mLastThreads = mStartThreads;
+        mStartServices.clear();
+        ReadCodecServices(&mStartServices);
+        mStartTemps.clear();
+        ReadTemperatures(&mStartTemps);
+        mMaxTemps = mStartTemps;
+        mStartTime = std::chrono::steady_clock::now();
+        mLastPowerTime = mStartTime;
+
+        {
+            std::scoped_lock lock{mLock};
+            mStopping = false;
+        }
+        mThread = std::thread([this] { samplerLoop(); });
+    }
+
+    void stop() {
+        if (!mThread.joinable()) return;
+        {
+            std::scoped_lock lock{mLock};
+            mStopping = true;
+            mCondition.notify_one();
+        }
+        mThread.join();
+        sample();
+
+        for (const auto& entry : mLastThreads) {
+            auto base = mStartThreads.find(entry.first);
+            int64_t baseUs = base != mStartThreads.end() ? base->second.second : 0;
+            mStageCpuUs[StageOf(entry.second.first)] += entry.second.second - baseUs;
+        }
+
+        std::map<pid_t, int64_t> services;
+        ReadCodecServices(&services);
+        for (const auto& entry : services) {
+            auto base = mStartServices.find(entry.first);
+            if (base != mStartServices.end()) {
+                mCodecServiceCpuUs += entry.second - base->second;
+                mHaveCodecServices = true;
+            }
+        }
+
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.compare(0, 6, "VmHWM:") == 0) {
+                mPeakRssKb = std::max(mPeakRssKb, std::atoll(line.c_str() + 6));
+            }
+        }
+
+        for (const auto& entry : mMaxTemps) {
+            mThermalRiseMc = std::max(mThermalRiseMc, entry.second - mStartTemps[entry.first]);
+        }
+
+        mDurationUs += std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::chrono::steady_clock::now() - mStartTime)
+                               .count();
+    }
+
+    void report(benchmark::State& state) const {
+        for (const char* stage : kStages) {
+            auto it = mStageCpuUs.find(stage);
+            double cpuMs = it != mStageCpuUs.end() ? it->second / 1000.0 : 0;
+            state.counters[std::string("cpu_") + stage + "(ms)"] =
+                    benchmark::Counter(cpuMs, benchmark::Counter::kAvgIterations);
+        }
+        if (mHaveCodecServices) {
+            state.counters["cpu_codec_service(ms)"] = benchmark::Counter(
+                    mCodecServiceCpuUs / 1000.0, benchmark::Counter::kAvgIterations);
+        }
+        state.counters["peak_rss(KB)"] = mPeakRssKb;
+        if (mHavePower && mDurationUs > 0) {
+            state.counters["energy(mJ)"] =
+                    benchmark::Counter(mEnergyUj / 1000.0, benchmark::Counter::kAvgIterations);
+            state.counters["power(mW)"] = mEnergyUj / mDurationUs * 1000.0;
+        }
+        if (!mStartTemps.empty()) {
+            state.counters["thermal_rise(C)"] = mThermalRiseMc / 1000.0;
+        }
+    }
+
+private:
+    static constexpr std::chrono::milliseconds kSamplePeriod{50};
+
+    // Maps the transcoder thread names to the pipeline stage they run.
+    static const char* StageOf(const std::string& threadName) {
+        // Reads samples and queues codec input (VideoTrackTranscoder), or reads and forwards
+        // samples for passthrough tracks.
+        if (threadName == "VideTranscodInp" || threadName == "PassthruThread") return "extractor";
+        // Handles the decoder and the encoder callbacks.
+        if (threadName == "VideTranscodTrd") return "codec";
+        if (threadName == "SampleWriterTrd") return "writer";
+        return "other";
+    }
+
+    // Returns utime + stime of a /proc/.../stat file in us, and the thread name in |name|.
+    static bool ReadStat(const std::string& path, std::string* name, int64_t* cpuUs) {
+        std::ifstream file(path);
+        std::string line;
+        if (!std::getline(file, line)) return false;
+        size_t open = line.find('(');
+        size_t close = line.rfind(')');
+        if (open == std::string::npos || close == std::string::npos || close < open) {
+            return false;
+        }
+        if (name != nullptr) *name = line.substr(open + 1, close - open - 1);
+
+        // Fields after the name start at field 3 (state); utime and stime are fields 14, 15.
+        std::istringstream fields(line.substr(close + 2));
+        std::string field;
+        int64_t ticks = 0;
+        for (int i = 3; i <= 15 && fields >> field; ++i) {
+            if (i >= 14) ticks += std::atoll(field.c_str());
+        }
+        *cpuUs = ticks * 1000000 / sysconf(_SC_CLK_TCK);
+        return true;
+    }
+
+    template <typename Func>
+    static void ForEachNumericEntry(const char* dirPath, Func func) {
+        DIR* dir = opendir(dirPath);
+        if (dir == nullptr) return;
+        while (struct dirent* entry = readdir(dir)) {
+            char* end;
+            long value = strtol(entry->d_name, &end, 10);
+            if (end != entry->d_name && *end == '\0') func(value);
+        }
+        closedir(dir);
+    }
+
+    static void ReadThreads(std::map<pid_t, std::pair<std::string, int64_t>>* threads) {
+        ForEachNumericEntry("/proc/self/task", [&](long tid) {
+            std::string name;
+            int64_t cpuUs;
+            if (ReadStat("/proc/self/task/" + std::to_string(tid) + "/stat", &name, &cpuUs)) {
+                (*threads)[tid] = {name, cpuUs};
+            }
+        });
+    }
+
+    static void ReadCodecServices(std::map<pid_t, int64_t>* services) {
+        ForEachNumericEntry("/proc", [&](long pid) {
+            std::string proc = "/proc/" + std::to_string(pid);
+            std::string cmdline;
+            std::getline(std::ifstream(proc + "/cmdline"), cmdline, '\0');
+            if (cmdline.find("media.swcodec") == std::string::npos &&
+                cmdline.find("media.codec") == std::string::npos &&
+                cmdline.find("media.c2") == std::string::npos) {
+                return;
+            }
+            int64_t cpuUs;
+            if (ReadStat(proc + "/stat", nullptr, &cpuUs)) {
+                (*services)[pid] = cpuUs;
+            }
+        });
+    }
+
+    static bool ReadValue(const std::string& path, int64_t* value) {
+        std::ifstream file(path);
+        return static_cast<bool>(file >> *value);
+    }
+
+    static void ReadTemperatures(std::map<std::string, int64_t>* temps) {
+        DIR* dir = opendir("/sys/class/thermal");
+        if (dir == nullptr) return;
+        while (struct dirent* entry = readdir(dir)) {
+            std::string zone = entry->d_name;
+            int64_t milliCelsius;
+            if (zone.compare(0, 12, "thermal_zone") == 0 &&
+                ReadValue("/sys/class/thermal/" + zone + "/temp", &milliCelsius)) {
+                (*temps)[zone] = milliCelsius;
+            }
+        }
+        closedir(dir);
+    }
+
+    void sample() {
+        std::map<pid_t, std::pair<std::string, int64_t>> threads;
+        ReadThreads(&threads);
+        // Threads exit when the transcoding ends, keep the last reading of each one.
+        for (auto& entry : threads) {
+            mLastThreads[entry.first] = entry.second;
+        }
+
+        std::map<std::string, int64_t> temps;
+        ReadTemperatures(&temps);
+        for (const auto& entry : temps) {
+            if (mMaxTemps.count(entry.first) > 0) {
+                mMaxTemps[entry.first] = std::max(mMaxTemps[entry.first], entry.second);
+            }
+        }
+
+        int64_t currentUa, voltageUv;
+        auto now = std::chrono::steady_clock::now();
+        if (ReadValue("/sys/class/power_supply/battery/current_now", &currentUa) &&
+            ReadValue("/sys/class/power_supply/battery/voltage_now", &voltageUv)) {
+            // The sign of current_now differs between fuel gauges.
+            double powerUw = std::abs((double)currentUa) * voltageUv / 1e6;
+            double elapsedS = std::chrono::duration<double>(now - mLastPowerTime).count();
+            mEnergyUj += powerUw * elapsedS;
+            mHavePower = true;
+        }
+        mLastPowerTime = now;
+    }
+
+    void samplerLoop() {
+        std::unique_lock lock{mLock};
+        while (!mStopping) {
+            mCondition.wait_for(lock, kSamplePeriod);
+            if (mStopping) break;
+            lock.unlock();
+            sample();
+            lock.lock();
+        }
+    }
+
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    bool mStopping = false;
+    std::thread mThread;
+
+    // Per iteration.
+    std::map<pid_t, std::pair<std::string, int64_t>> mStartThreads;
+    std::map<pid_t, std::pair<std::string, int64_t>> mLastThreads;
+    std::map<pid_t, int64_t> mStartServices;
+    std::map<std::string, int64_t> mStartTemps;
+    std::map<std::string, int64_t> mMaxTemps;
+    std::chrono::steady_clock::time_point mStartTime;
+    std::chrono::steady_clock::time_point mLastPowerTime;
+
+    // Accumulated over the iterations.
+    std::map<std::string, int64_t> mStageCpuUs;
+    int64_t mCodecServiceCpuUs = 0;
+    bool mHaveCodecServices = false;
+    long long mPeakRssKb = 0;
+    double mEnergyUj = 0;
+    bool mHavePower = false;
+    int64_t mThermalRiseMc = 0;
+    int64_t mDurationUs = 0;
+};
+
+/**
+ * Records when the transcoder outputs each frame, and reports the distribution of the time
+ * between consecutive frames as frame_p50(ms), frame_p90(ms), frame_p99(ms) and frame_max(ms),
+ * plus the average time from start to the first frame as first_frame(ms).
+ */
+class FrameLatencyRecorder {
+public:
+    // Call when the transcoder starts.
+    void start() {
+        mLastTime = std::chrono::steady_clock::now();
+        mFirstFrame = true;
+    }
+
+    // Call for every output frame, from one thread.
+    void onFrame() {
+        auto now = std::chrono::steady_clock::now();
+        double intervalMs = std::chrono::duration<double, std::milli>(now - mLastTime).count();
+        mLastTime = now;
+        if (mFirstFrame) {
+            mFirstFrameMs += intervalMs;
+            ++mNumStarts;
+            mFirstFrame = false;
+        } else {
+            mIntervalsMs.push_back(intervalMs);
+        }
+    }
+
+    void report(benchmark::State& state) {
+        if (mNumStarts > 0) {
+            state.counters["first_frame(ms)"] = mFirstFrameMs / mNumStarts;
+        }
+        if (mIntervalsMs.empty()) return;
+        std::sort(mIntervalsMs.begin(), mIntervalsMs.end());
+        auto percentile = [this](double p) {
+            return mIntervalsMs[std::min(mIntervalsMs.size() - 1,
+                                         (size_t)(p * mIntervalsMs.size()))];
+        };
+        state.counters["frame_p50(ms)"] = percentile(0.5);
+        state.counters["frame_p90(ms)"] = percentile(0.9);
+        state.counters["frame_p99(ms)"] = percentile(0.99);
+        state.counters["frame_max(ms)"] = mIntervalsMs.back();
+    }
+
+private:
+    std::chrono::steady_clock::time_point mLastTime;
+    bool mFirstFrame = true;
+    double mFirstFrameMs = 0;
+    int mNumStarts = 0;
+    std::vector<double> mIntervalsMs;
+};
+
+}  // namespace android
+#endif  // __TRANSCODER_METRICS_H__
@@ -20,6 +20,7 @@
 #include <media/MediaSampleReader.h>
 #include <media/NdkMediaExtractor.h>
 
+#include <deque>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -89,6 +90,29 @@ private:
         SamplePosition next;
     };
 
+    /**
+     * PrefetchedSample holds a sample that the extractor read while moving over it on behalf of
+     * another track, so that the sample can later be served without seeking back.
+     */
+    struct PrefetchedSample {
+        uint64_t index;
+        MediaSampleInfo info;
+        std::vector<uint8_t> data;
+    };
+
+    /**
+     * PrefetchBuffer holds an unbroken run of a track's samples, starting at or after the
+     * track's current sample. Once a sample could not be kept, the buffer stays closed until it
+     * has been drained, so that it never skips over a sample.
+     */
+    struct PrefetchBuffer {
+        std::deque<PrefetchedSample> samples;
+        bool open = true;
+    };
+
+    /** Upper bound of the memory held by prefetched samples of all tracks. */
+    static constexpr size_t kPrefetchBudgetBytes = 8 * 1024 * 1024;
+
     /**
      * Creates a new MediaSampleReaderNDK object from an AMediaExtractor. The extractor needs to be
      * initialized with a valid data source before attempting to create a MediaSampleReaderNDK.
@@ -109,6 +133,21 @@ private:
     /** Moves the extractor to the specified sample. */
     media_status_t moveToSample_l(SamplePosition& pos, int trackIndex);
 
+    /**
+     * In parallel mode, keeps a copy of the sample the extractor points to if it belongs to a
+     * selected track other than |trackIndex| and still has to be read.
+     */
+    void prefetchSample_l(int trackIndex);
+
+    /** Returns the prefetched copy of the current sample of the track, or nullptr. */
+    const PrefetchedSample* findPrefetchedSample_l(int trackIndex);
+
+    /** Drops the prefetched samples of the track up to and including |sampleIndex|. */
+    void dropPrefetchedSamples_l(int trackIndex, uint64_t sampleIndex);
+
+    /** Drops all prefetched samples. */
+    void clearPrefetchedSamples_l();
+
     /** Moves the extractor to the next sample of the specified track. */
     media_status_t moveToTrack_l(int trackIndex);
 
@@ -135,6 +174,10 @@ private:
 
     // Samples cursor for each track in the file.
     std::vector<SampleCursor> mTrackCursors;
+
+    // Samples read ahead for each selected track, in sample index order.
+    std::map<int, PrefetchBuffer> mPrefetchBuffers;
+    size_t mPrefetchedBytes = 0;
 };
 
 }  // namespace android
@@ -22,6 +22,8 @@
 #include <media/NdkMediaCodecPlatform.h>
 #include <media/NdkMediaFormat.h>
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <deque>
 #include <mutex>
@@ -32,7 +34,9 @@ namespace android {
  * Track transcoder for video tracks. VideoTrackTranscoder uses AMediaCodec from the Media NDK
  * internally. The two media codecs are run in asynchronous mode and shares uncompressed buffers
  * using a native surface (ANativeWindow). Codec callback events are placed on a message queue and
- * serviced in order on the transcoding thread managed by MediaTrackTranscoder.
+ * serviced in order on the transcoding thread managed by MediaTrackTranscoder. Decoder input
+ * buffers are filled with source samples on a separate input thread, so that waiting for the sample
+ * reader does not hold up the decoder output and encoder output handling.
  */
 class VideoTrackTranscoder : public std::enable_shared_from_this<VideoTrackTranscoder>,
                              public MediaTrackTranscoder {
@@ -75,8 +79,12 @@ private:
     std::shared_ptr<AMediaFormat> getOutputFormat() const override;
     // ~MediaTrackTranscoder
 
+    // Fills decoder input buffers until kStopInputLoop is popped from mInputBufferQueue. Runs on
+    // the input thread.
+    void runInputLoop();
+
     // Enqueues an input sample with the decoder.
-    void enqueueInputSample(int32_t bufferIndex);
+    media_status_t enqueueInputSample(int32_t bufferIndex);
 
     // Moves a decoded buffer from the decoder's output to the encoder's input.
     void transferBuffer(int32_t bufferIndex, AMediaCodecBufferInfo bufferInfo);
@@ -96,11 +104,19 @@ private:
     media_status_t mStatus = AMEDIA_OK;
     MediaSampleInfo mSampleInfo;
     BlockingQueue<std::function<void()>> mCodecMessageQueue;
+
+    // Decoder input buffer indices waiting for a sample, serviced by the input thread.
+    static constexpr int32_t kStopInputLoop = -1;
+    BlockingQueue<int32_t> mInputBufferQueue;
+    // Held by the input thread while it uses a decoder input buffer, so that the decoder is not
+    // stopped underneath it.
+    std::mutex mInputMutex;
+    bool mInputStopped = false;
     std::shared_ptr<AMediaFormat> mDestinationFormat;
     std::shared_ptr<AMediaFormat> mActualOutputFormat;
     pid_t mPid;
     uid_t mUid;
-    uint64_t mInputFrameCount = 0;
+    std::atomic<uint64_t> mInputFrameCount{0};
     uint64_t mOutputFrameCount = 0;
     int32_t mConfiguredBitrate = 0;
 };
@@ -1052,6 +1052,10 @@ ATSParser::Stream::Stream(
 }
 
 ATSParser::Stream::~Stream() {
+    if (mQueue != NULL) {
+        ALOGV("PID 0x%04x: peak elementary stream queue size %zu bytes",
+                mElementaryPID, mQueue->peakBufferSize());
+    }
     delete mQueue;
     mQueue = NULL;
 }
@@ -2003,8 +2007,22 @@ status_t ATSParser::feedTSPacket(const void *data, size_t size,
         return BAD_VALUE;
     }
 
-    ABitReader br((const uint8_t *)data, kTSPacketSize);
-    return parseTS(&br, event);
+    return parseTS((const uint8_t *)data, event);
+}
+
+status_t ATSParser::feedTSPackets(const void *data, size_t size, size_t *consumed) {
+    const uint8_t *packets = (const uint8_t *)data;
+    size_t offset = 0;
+    status_t err = OK;
+    while (size - offset >= kTSPacketSize) {
+        err = parseTS(packets + offset, NULL);
+        if (err != OK) {
+            break;
+        }
+        offset += kTSPacketSize;
+    }
+    *consumed = offset;
+    return err;
 }
 
 status_t ATSParser::setMediaCas(const sp<ICas> &cas) {
@@ -2015,6 +2033,7 @@ status_t ATSParser::setMediaCas(const sp<ICas> &cas) {
     for (size_t i = 0; i < mPrograms.size(); ++i) {
         mPrograms.editItemAt(i)->updateCasSessions();
     }
+    mUnhandledPIDs.reset();
     return OK;
 }
 
@@ -2209,6 +2228,10 @@ status_t ATSParser::parsePID(
         if (!section->isCRCOkay()) {
             return BAD_VALUE;
         }
+
+        // Programs, streams and CA PIDs are only added or removed by PSI sections.
+        mUnhandledPIDs.reset();
+
         ABitReader sectionBits(section->data(), section->size());
 
         if (PID == 0) {
@@ -2267,6 +2290,7 @@ status_t ATSParser::parsePID(
 
     if (!handled) {
         ALOGV("PID 0x%04x not handled.", PID);
+        mUnhandledPIDs.set(PID);
     }
 
     return OK;
@@ -2346,52 +2370,51 @@ status_t ATSParser::parseAdaptationField(
     return OK;
 }
 
-status_t ATSParser::parseTS(ABitReader *br, SyncEvent *event) {
+status_t ATSParser::parseTS(const uint8_t *packet, SyncEvent *event) {
     ALOGV("---");
 
-    if (br->numBitsLeft() < 32) {
-        ALOGE("Not enough data left in bitreader!");
-        return ERROR_MALFORMED;
-    }
-    unsigned sync_byte = br->getBits(8);
+    // The packet header is decoded straight from the bytes, as this runs for
+    // every packet of the stream.
+    unsigned sync_byte = packet[0];
     if (sync_byte != 0x47u) {
         ALOGE("[error] parseTS: return error as sync_byte=0x%x", sync_byte);
         return BAD_VALUE;
     }
 
-    if (br->getBits(1)) {  // transport_error_indicator
+    if (packet[1] & 0x80) {  // transport_error_indicator
         // silently ignore.
         return OK;
     }
 
-    unsigned payload_unit_start_indicator = br->getBits(1);
+    unsigned payload_unit_start_indicator = (packet[1] >> 6) & 1;
     ALOGV("payload_unit_start_indicator = %u", payload_unit_start_indicator);
 
-    MY_LOGV("transport_priority = %u", br->getBits(1));
+    MY_LOGV("transport_priority = %u", (packet[1] >> 5) & 1);
 
-    unsigned PID = br->getBits(13);
+    unsigned PID = ((packet[1] & 0x1f) << 8) | packet[2];
     ALOGV("PID = 0x%04x", PID);
 
-    unsigned transport_scrambling_control = br->getBits(2);
+    unsigned transport_scrambling_control = packet[3] >> 6;
     ALOGV("transport_scrambling_control = %u", transport_scrambling_control);
 
-    unsigned adaptation_field_control = br->getBits(2);
+    unsigned adaptation_field_control = (packet[3] >> 4) & 3;
     ALOGV("adaptation_field_control = %u", adaptation_field_control);
 
-    unsigned continuity_counter = br->getBits(4);
+    unsigned continuity_counter = packet[3] & 0x0f;
     ALOGV("PID = 0x%04x, continuity_counter = %u", PID, continuity_counter);
 
     // ALOGI("PID = 0x%04x, continuity_counter = %u", PID, continuity_counter);
 
+    ABitReader br(packet + 4, kTSPacketSize - 4);
     status_t err = OK;
 
     unsigned random_access_indicator = 0;
     if (adaptation_field_control == 2 || adaptation_field_control == 3) {
-        err = parseAdaptationField(br, PID, &random_access_indicator);
+        err = parseAdaptationField(&br, PID, &random_access_indicator);
     }
-    if (err == OK) {
+    if (err == OK && !mUnhandledPIDs.test(PID)) {
         if (adaptation_field_control == 1 || adaptation_field_control == 3) {
-            err = parsePID(br, PID, continuity_counter,
+            err = parsePID(&br, PID, continuity_counter,
                     payload_unit_start_indicator,
                     transport_scrambling_control,
                     random_access_indicator,
@@ -27,6 +27,7 @@
 #include <utils/KeyedVector.h>
 #include <utils/Vector.h>
 #include <utils/RefBase.h>
+#include <bitset>
 #include <vector>
 
 namespace android {
@@ -122,6 +123,12 @@ struct ATSParser : public RefBase {
     status_t feedTSPacket(
             const void *data, size_t size, SyncEvent *event = NULL);
 
+    // Feed a run of back-to-back TS packets into the parser, stopping at the
+    // first one that fails to parse. Trailing bytes that do not make up a whole
+    // packet are left alone. On return, |consumed| is the number of bytes fed,
+    // i.e. the offset of the failing packet if the result is not OK.
+    status_t feedTSPackets(const void *data, size_t size, size_t *consumed);
+
     void signalDiscontinuity(
             DiscontinuityType type, const sp<AMessage> &extra);
 
@@ -215,6 +222,12 @@ private:
     // Keyed by PID
     KeyedVector<unsigned, sp<PSISection> > mPSISections;
 
+    // PIDs that neither a PSI section, a program nor the CAS manager claimed,
+    // e.g. null packets or programs we do not play. Their payload is skipped
+    // without looking them up. Cleared whenever a PSI section is parsed, as
+    // that may change which PIDs are handled.
+    std::bitset<8192> mUnhandledPIDs;
+
     int64_t mAbsoluteTimeAnchorUs;
 
     bool mTimeOffsetValid;
@@ -248,8 +261,8 @@ private:
     status_t parseAdaptationField(
             ABitReader *br, unsigned PID, unsigned *random_access_indicator);
 
-    // see feedTSPacket().
-    status_t parseTS(ABitReader *br, SyncEvent *event);
+    // see feedTSPacket(). |packet| holds kTSPacketSize bytes.
+    status_t parseTS(const uint8_t *packet, SyncEvent *event);
 
     void updatePCR(unsigned PID, uint64_t PCR, uint64_t byteOffsetFromStart);
 
@@ -81,6 +81,9 @@ struct ElementaryStreamQueue {
 
     void signalNewSampleAesKey(const sp<AMessage> &keyItem);
 
+    // The largest amount of data held while waiting for complete access units.
+    size_t peakBufferSize() const { return mPeakBufferSize; }
+
 private:
     struct RangeInfo {
         int64_t mTimestampUs;
@@ -102,8 +105,11 @@ private:
     uint32_t mFlags;
     bool mEOSReached;
 
+    // Pending data starts at mBuffer->data(). Dequeued access units are dropped from
+    // the front by consumeBuffer(), without moving the rest of the data.
     sp<ABuffer> mBuffer;
     List<RangeInfo> mRangeInfos;
+    size_t mPeakBufferSize;
 
     sp<ABuffer> mScrambledBuffer;
     List<ScrambledRangeInfo> mScrambledRangeInfos;
@@ -131,6 +137,10 @@ private:
     sp<ABuffer> dequeueAccessUnitDTSOrDTSHD();
     sp<ABuffer> dequeueAccessUnitDTSUHD();
 
+    // drops the first "size" bytes of mBuffer. The remaining data is only moved
+    // back to the start of the buffer by appendData(), once it runs out of room.
+    void consumeBuffer(size_t size);
+
     // consume a logical (compressed) access unit of size "size",
     // returns its timestamp in us (or -1 if no time information).
     int64_t fetchTimestamp(size_t size,
@@ -0,0 +1,201 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <mpeg2ts/ATSParser.h>
+
+// Measures the TS demux throughput of ATSParser on a synthetic stream holding
+// one MPEG audio program, with a given percentage of null packets mixed in.
+//
+// To run:
+//   adb shell /data/benchmarktest64/ATSParserBenchmark/ATSParserBenchmark
+
+using namespace android;
+
+namespace {
+
+constexpr size_t kTSPacketSize = 188;
+constexpr unsigned kPMTPID = 0x100;
+constexpr unsigned kAudioPID = 0x101;
+constexpr unsigned kNullPID = 0x1fff;
+constexpr size_t kNumPackets = 20000;
+
+// MPEG-1 layer III, 128 kbps, 44.1 kHz: 417 bytes per frame.
+constexpr uint8_t kMPEGAudioHeader[] = { 0xff, 0xfb, 0x90, 0x44 };
+constexpr size_t kMPEGAudioFrameSize = 417;
+constexpr size_t kFramesPerPES = 4;
+
+uint32_t crc32(const uint8_t *data, size_t size) {
+    uint32_t crc = 0xffffffff;
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= (uint32_t)data[i] << 24;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+class StreamBuilder {
+public:
+    explicit StreamBuilder(int nullPercent) : mNullPercent(nullPercent) {
+        memset(mCounters, 0, sizeof(mCounters));
+    }
+
+    void addSection(unsigned pid, std::vector<uint8_t> section) {
+        uint32_t crc = crc32(section.data(), section.size());
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            section.push_back(crc >> shift);
+        }
+        section.insert(section.begin(), 0);  // pointer_field
+        addPayload(pid, section.data(), section.size());
+    }
+
+    void addPES(unsigned pid, uint64_t pts, const std::vector<uint8_t> &payload) {
+        std::vector<uint8_t> pes = {
+            0x00, 0x00, 0x01, 0xc0,
+            (uint8_t)((payload.size() + 8) >> 8), (uint8_t)(payload.size() + 8),
+            0x80, 0x80, 0x05,  // PTS only
+            (uint8_t)(0x21 | ((pts >> 29) & 0x0e)),
+            (uint8_t)(pts >> 22), (uint8_t)(((pts >> 14) & 0xfe) | 1),
+            (uint8_t)(pts >> 7), (uint8_t)(((pts << 1) & 0xfe) | 1),
+        };
+        pes.insert(pes.end(), payload.begin(), payload.end());
+        addPayload(pid, pes.data(), pes.size());
+    }
+
+    size_t numPackets() const {
+        return mData.size() / kTSPacketSize;
+    }
+
+    const std::vector<uint8_t> &data() const {
+        return mData;
+    }
+
+private:
+    size_t mNullPercent;
+    unsigned mCounters[8192];
+    size_t mNumNullPackets = 0;
+    std::vector<uint8_t> mData;
+
+    // Splits |data| into packets of |pid|, stuffing the last one through
+    // an adaptation field.
+    void addPayload(unsigned pid, const uint8_t *data, size_t size) {
+        bool start = true;
+        while (size > 0) {
+            maybeAddNullPacket();
+
+            size_t chunk = std::min(size, kTSPacketSize - 4);
+            size_t stuffing = kTSPacketSize - 4 - chunk;
+            mData.push_back(0x47);
+            mData.push_back((start ? 0x40 : 0x00) | (pid >> 8));
+            mData.push_back(pid & 0xff);
+            mData.push_back((stuffing > 0 ? 0x30 : 0x10) | (mCounters[pid]++ & 0x0f));
+            if (stuffing > 0) {
+                mData.push_back(stuffing - 1);  // adaptation_field_length
+                if (stuffing > 1) {
+                    mData.push_back(0x00);  // no flags
+                    mData.insert(mData.end(), stuffing - 2, 0xff);
+                }
+            }
+            mData.insert(mData.end(), data, data + chunk);
+            data += chunk;
+            size -= chunk;
+            start = false;
+        }
+    }
+
+    // Keeps the share of null packets at |mNullPercent|, spread evenly.
+    void maybeAddNullPacket() {
+        while (mNumNullPackets * 100 < (numPackets() + 1) * mNullPercent) {
+            mData.push_back(0x47);
+            mData.push_back(kNullPID >> 8);
+            mData.push_back(kNullPID & 0xff);
+            mData.push_back(0x10);
+            mData.insert(mData.end(), kTSPacketSize - 4, 0xff);
+            ++mNumNullPackets;
+        }
+    }
+};
+
+std::vector<uint8_t> makeStream(int nullPercent) {
+    StreamBuilder builder(nullPercent);
+
+    std::vector<uint8_t> pat = {
+        0x00, 0xb0, 0x0d, 0x00, 0x01, 0xc1, 0x00, 0x00,
+        0x00, 0x01, (uint8_t)(0xe0 | (kPMTPID >> 8)), (uint8_t)kPMTPID,
+    };
+    std::vector<uint8_t> pmt = {
+        0x02, 0xb0, 0x12, 0x00, 0x01, 0xc1, 0x00, 0x00,
+        (uint8_t)(0xe0 | (kAudioPID >> 8)), (uint8_t)kAudioPID, 0xf0, 0x00,
+        ATSParser::STREAMTYPE_MPEG1_AUDIO,
+        (uint8_t)(0xe0 | (kAudioPID >> 8)), (uint8_t)kAudioPID, 0xf0, 0x00,
+    };
+
+    std::vector<uint8_t> frames(kMPEGAudioFrameSize * kFramesPerPES);
+    for (size_t i = 0; i < kFramesPerPES; ++i) {
+        memcpy(&frames[i * kMPEGAudioFrameSize], kMPEGAudioHeader, sizeof(kMPEGAudioHeader));
+    }
+
+    uint64_t pts = 90000;
+    while (builder.numPackets() < kNumPackets) {
+        builder.addSection(0, pat);
+        builder.addSection(kPMTPID, pmt);
+        for (int i = 0; i < 16; ++i) {
+            builder.addPES(kAudioPID, pts, frames);
+            pts += 1152 * kFramesPerPES * 90000 / 44100;
+        }
+    }
+    return builder.data();
+}
+
+// Argument: percentage of null packets.
+void BM_FeedTSPacket(benchmark::State &state) {
+    const std::vector<uint8_t> stream = makeStream(state.range(0));
+    for (auto _ : state) {
+        sp<ATSParser> parser = new ATSParser;
+        for (size_t offset = 0; offset + kTSPacketSize <= stream.size();
+                offset += kTSPacketSize) {
+            parser->feedTSPacket(stream.data() + offset, kTSPacketSize);
+        }
+        benchmark::DoNotOptimize(parser->hasSource(ATSParser::AUDIO));
+    }
+    state.SetBytesProcessed(state.iterations() * stream.size());
+}
+
+void BM_FeedTSPackets(benchmark::State &state) {
+    const std::vector<uint8_t> stream = makeStream(state.range(0));
+    for (auto _ : state) {
+        sp<ATSParser> parser = new ATSParser;
+        size_t consumed;
+        parser->feedTSPackets(stream.data(), stream.size(), &consumed);
+        benchmark::DoNotOptimize(parser->hasSource(ATSParser::AUDIO));
+    }
+    state.SetBytesProcessed(state.iterations() * stream.size());
+}
+
+}  // namespace
+
+BENCHMARK(BM_FeedTSPacket)->Arg(0)->Arg(25);
+BENCHMARK(BM_FeedTSPackets)->Arg(0)->Arg(25);
+
+BENCHMARK_MAIN();
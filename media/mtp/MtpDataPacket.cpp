@@ -355,6 +355,14 @@ void MtpDataPacket::putAInt8(const int8_t* values, int count) {
         putInt8(*values++);
 }
 
+void MtpDataPacket::putData(const void* data, size_t length) {
+    allocate(mOffset + length);
+    memcpy(mBuffer + mOffset, data, length);
+    mOffset += length;
+    if (mPacketSize < mOffset)
+        mPacketSize = mOffset;
+}
+
 void MtpDataPacket::putAUInt8(const uint8_t* values, int count) {
     putUInt32(count);
     for (int i = 0; i < count; i++)
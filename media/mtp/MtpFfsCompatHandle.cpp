@@ -113,7 +113,8 @@ int MtpFfsCompatHandle::start(bool ptp) {
     if (!openEndpoints(ptp))
         return -1;
 
-    for (unsigned i = 0; i < NUM_IO_BUFS; i++) {
+    // The compat transfers alternate between the first two buffers only.
+    for (unsigned i = 0; i < 2; i++) {
         mIobuf[i].bufs.resize(MAX_FILE_CHUNK_SIZE);
         posix_madvise(mIobuf[i].bufs.data(), MAX_FILE_CHUNK_SIZE,
                 POSIX_MADV_SEQUENTIAL | POSIX_MADV_WILLNEED);
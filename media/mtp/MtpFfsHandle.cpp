@@ -17,6 +17,7 @@
 #include <android-base/logging.h>
 #include <android-base/properties.h>
 #include <asyncio/AsyncIO.h>
+#include <chrono>
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
@@ -53,6 +54,43 @@ constexpr int32_t POLL_TIMEOUT_MS = 500;
 
 struct timespec ZERO_TIMEOUT = { 0, 0 };
 
+// Throughput of a file transfer, and how long it waited for the usb and for the disk.
+class TransferStats {
+public:
+    template <typename F>
+    auto timeUsb(F f) { return time(&mUsbWait, f); }
+
+    template <typename F>
+    auto timeDisk(F f) { return time(&mDiskWait, f); }
+
+    void log(const char *what, uint64_t bytes) const {
+        using namespace std::chrono;
+        const auto elapsed = steady_clock::now() - mStart;
+        const double seconds = duration<double>(elapsed).count();
+        LOG(DEBUG) << "Mtp " << what << " " << bytes << " bytes in "
+                << duration_cast<milliseconds>(elapsed).count() << " ms ("
+                << (seconds > 0 ? bytes / seconds / (1024 * 1024) : 0) << " MiB/s), waited "
+                << duration_cast<milliseconds>(mUsbWait).count() << " ms for usb, "
+                << duration_cast<milliseconds>(mDiskWait).count() << " ms for disk";
+    }
+
+private:
+    template <typename F>
+    static auto time(std::chrono::steady_clock::duration *total, F f) {
+        const auto start = std::chrono::steady_clock::now();
+        struct Accumulate {
+            ~Accumulate() { *total += std::chrono::steady_clock::now() - start; }
+            std::chrono::steady_clock::duration *total;
+            std::chrono::steady_clock::time_point start;
+        } accumulate{total, start};
+        return f();
+    }
+
+    const std::chrono::steady_clock::time_point mStart = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::duration mUsbWait{0};
+    std::chrono::steady_clock::duration mDiskWait{0};
+};
+
 struct mtp_device_status {
     uint16_t  wLength;
     uint16_t  wCode;
@@ -450,24 +488,49 @@ int MtpFfsHandle::receiveFile(mtp_file_range mfr, bool zero_packet) {
     uint32_t file_length = mfr.length;
     uint64_t offset = mfr.offset;
 
-    struct aiocb aio;
-    aio.aio_fildes = mfr.fd;
-    aio.aio_buf = nullptr;
-    struct aiocb *aiol[] = {&aio};
+    // The disk writes of up to NUM_IO_BUFS - 1 buffers are queued behind the usb read,
+    // so that the usb doesn't wait for a slow write as long as the others keep up.
+    struct aiocb aio[NUM_IO_BUFS];
+    for (struct aiocb &a : aio) {
+        a.aio_fildes = mfr.fd;
+        a.aio_buf = nullptr;
+    }
+    unsigned first_write = 0;
+    unsigned num_writes = 0;
 
     int ret = -1;
     unsigned i = 0;
     size_t length;
     struct io_event ioevs[AIO_BUFS_MAX];
-    bool has_write = false;
     bool error = false;
     bool write_error = false;
     int packet_size = getPacketSize(mBulkOut);
     bool short_packet = false;
+    TransferStats stats;
     advise(mfr.fd);
 
+    // Waits for the oldest write to disk.
+    auto completeWrite = [&]() {
+        struct aiocb *aiol[] = {&aio[first_write]};
+        stats.timeDisk([&] { aio_suspend(aiol, 1, nullptr); });
+        int written = aio_return(aiol[0]);
+        if (static_cast<size_t>(written) < aiol[0]->aio_nbytes) {
+            errno = written == -1 ? aio_error(aiol[0]) : EIO;
+            PLOG(ERROR) << "Mtp error writing to disk";
+            write_error = true;
+        }
+        first_write = (first_write + 1) % NUM_IO_BUFS;
+        num_writes--;
+    };
+    // All the queued writes must complete before the buffers are reused or released.
+    auto completeWrites = [&]() {
+        while (num_writes > 0) {
+            completeWrite();
+        }
+    };
+
     // Break down the file into pieces that fit in buffers
-    while (file_length > 0 || has_write) {
+    while (file_length > 0 || num_writes > 0) {
         // Queue an asynchronous read from USB.
         if (file_length > 0) {
             length = std::min(static_cast<uint32_t>(MAX_FILE_CHUNK_SIZE), file_length);
@@ -475,19 +538,14 @@ int MtpFfsHandle::receiveFile(mtp_file_range mfr, bool zero_packet) {
                 error = true;
         }
 
-        // Get the return status of the last write request.
-        if (has_write) {
-            aio_suspend(aiol, 1, nullptr);
-            int written = aio_return(&aio);
-            if (static_cast<size_t>(written) < aio.aio_nbytes) {
-                errno = written == -1 ? aio_error(&aio) : EIO;
-                PLOG(ERROR) << "Mtp error writing to disk";
-                write_error = true;
-            }
-            has_write = false;
+        // Get the return status of the oldest write request, if the ring is full
+        // or there is nothing left to read.
+        if (num_writes == NUM_IO_BUFS - 1 || (file_length == 0 && num_writes > 0)) {
+            completeWrite();
         }
 
         if (error) {
+            completeWrites();
             return -1;
         }
 
@@ -500,12 +558,15 @@ int MtpFfsHandle::receiveFile(mtp_file_range mfr, bool zero_packet) {
                 // Get all events up to the short read, if there is one.
                 // We must wait for each event since data transfer could end at any time.
                 int this_events = 0;
-                int event_ret = waitEvents(&mIobuf[i], 1, ioevs, &this_events);
+                int event_ret = stats.timeUsb([&] {
+                    return waitEvents(&mIobuf[i], 1, ioevs, &this_events);
+                });
                 num_events += this_events;
 
                 if (event_ret == -1) {
                     cancelEvents(mIobuf[i].iocb.data(), ioevs, num_events, mIobuf[i].actual,
                             mBatchCancel);
+                    completeWrites();
                     return -1;
                 }
                 ret += event_ret;
@@ -536,6 +597,7 @@ int MtpFfsHandle::receiveFile(mtp_file_range mfr, bool zero_packet) {
                 // If file is less than 4G and we get a short packet, it's an error.
                 errno = EIO;
                 LOG(ERROR) << "Mtp got unexpected short packet";
+                completeWrites();
                 return -1;
             } else {
                 file_length -= ret;
@@ -543,16 +605,17 @@ int MtpFfsHandle::receiveFile(mtp_file_range mfr, bool zero_packet) {
 
             if (write_error) {
                 cancelTransaction();
+                completeWrites();
                 return -1;
             }
 
             // Enqueue a new write request
-            aio_prepare(&aio, mIobuf[i].bufs.data(), ret, offset);
-            aio_write(&aio);
+            aio_prepare(&aio[i], mIobuf[i].bufs.data(), ret, offset);
+            aio_write(&aio[i]);
 
             offset += ret;
             i = (i + 1) % NUM_IO_BUFS;
-            has_write = true;
+            num_writes++;
         }
     }
     if ((ret % packet_size == 0 && !short_packet) || zero_packet) {
@@ -562,6 +625,11 @@ int MtpFfsHandle::receiveFile(mtp_file_range mfr, bool zero_packet) {
             return -1;
         }
     }
+    // The last writes to disk complete after the whole file was received.
+    if (write_error) {
+        return -1;
+    }
+    stats.log("received", offset - mfr.offset);
     return 0;
 }
 
@@ -579,15 +647,21 @@ int MtpFfsHandle::sendFile(mtp_file_range mfr) {
 
     advise(mfr.fd);
 
-    struct aiocb aio;
-    aio.aio_fildes = mfr.fd;
-    struct aiocb *aiol[] = {&aio};
+    // The disk reads are queued ahead into the buffers which are not being written to usb,
+    // so that the usb doesn't wait for a slow read as long as the others keep up.
+    struct aiocb aio[NUM_IO_BUFS];
+    for (struct aiocb &a : aio) {
+        a.aio_fildes = mfr.fd;
+    }
+    unsigned first_read = 0;
+    unsigned num_reads = 0;
     int ret = 0;
     int length, num_read;
-    unsigned i = 0;
+    unsigned write_i = 0;
     struct io_event ioevs[AIO_BUFS_MAX];
     bool error = false;
     bool has_write = false;
+    TransferStats stats;
 
     // Send the header data
     mtp_data_header *header = reinterpret_cast<mtp_data_header*>(mIobuf[0].bufs.data());
@@ -611,35 +685,66 @@ int MtpFfsHandle::sendFile(mtp_file_range mfr) {
     offset += init_read_len;
     ret = init_read_len + sizeof(mtp_data_header);
 
+    uint64_t read_length = file_length;
+    uint64_t read_offset = offset;
+    // Queues reads from disk into all the free buffers.
+    auto queueReads = [&]() {
+        while (read_length > 0 && num_reads + (has_write ? 1 : 0) < NUM_IO_BUFS) {
+            unsigned j = (first_read + num_reads) % NUM_IO_BUFS;
+            length = std::min(static_cast<uint64_t>(MAX_FILE_CHUNK_SIZE), read_length);
+            aio_prepare(&aio[j], mIobuf[j].bufs.data(), length, read_offset);
+            aio_read(&aio[j]);
+            read_length -= length;
+            read_offset += length;
+            num_reads++;
+        }
+    };
+    // All the queued reads must complete before the buffers are reused or released.
+    auto completeReads = [&]() {
+        while (num_reads > 0) {
+            struct aiocb *aiol[] = {&aio[first_read]};
+            aio_suspend(aiol, 1, nullptr);
+            first_read = (first_read + 1) % NUM_IO_BUFS;
+            num_reads--;
+        }
+    };
+
     // Break down the file into pieces that fit in buffers
     while(file_length > 0 || has_write) {
-        if (file_length > 0) {
-            // Queue up a read from disk.
-            length = std::min(static_cast<uint64_t>(MAX_FILE_CHUNK_SIZE), file_length);
-            aio_prepare(&aio, mIobuf[i].bufs.data(), length, offset);
-            aio_read(&aio);
-        }
+        queueReads();
 
         if (has_write) {
             // Wait for usb write. Cancel unwritten portion if there's an error.
             int num_events = 0;
-            if (waitEvents(&mIobuf[(i-1)%NUM_IO_BUFS], mIobuf[(i-1)%NUM_IO_BUFS].actual, ioevs,
-                        &num_events) != ret) {
+            if (stats.timeUsb([&] {
+                    return waitEvents(&mIobuf[write_i], mIobuf[write_i].actual, ioevs,
+                            &num_events);
+                }) != ret) {
                 error = true;
-                cancelEvents(mIobuf[(i-1)%NUM_IO_BUFS].iocb.data(), ioevs, num_events,
-                        mIobuf[(i-1)%NUM_IO_BUFS].actual, false);
+                cancelEvents(mIobuf[write_i].iocb.data(), ioevs, num_events,
+                        mIobuf[write_i].actual, false);
             }
             has_write = false;
         }
 
         if (file_length > 0) {
-            // Wait for the previous read to finish
-            aio_suspend(aiol, 1, nullptr);
-            num_read = aio_return(&aio);
-            if (static_cast<size_t>(num_read) < aio.aio_nbytes) {
-                errno = num_read == -1 ? aio_error(&aio) : EIO;
+            if (!error) {
+                // The buffer written to usb is free again.
+                queueReads();
+            }
+
+            // Wait for the oldest read to finish
+            struct aiocb *aiol[] = {&aio[first_read]};
+            stats.timeDisk([&] { aio_suspend(aiol, 1, nullptr); });
+            num_read = aio_return(aiol[0]);
+            const unsigned read_i = first_read;
+            first_read = (first_read + 1) % NUM_IO_BUFS;
+            num_reads--;
+            if (static_cast<size_t>(num_read) < aiol[0]->aio_nbytes) {
+                errno = num_read == -1 ? aio_error(aiol[0]) : EIO;
                 PLOG(ERROR) << "Mtp error reading from disk";
                 cancelTransaction();
+                completeReads();
                 return -1;
             }
 
@@ -647,19 +752,21 @@ int MtpFfsHandle::sendFile(mtp_file_range mfr) {
             offset += num_read;
 
             if (error) {
+                completeReads();
                 return -1;
             }
 
             // Queue up a write to usb.
-            if (iobufSubmit(&mIobuf[i], mBulkIn, num_read, false) == -1) {
+            if (iobufSubmit(&mIobuf[read_i], mBulkIn, num_read, false) == -1) {
+                completeReads();
                 return -1;
             }
+            write_i = read_i;
             has_write = true;
             ret = num_read;
         }
-
-        i = (i + 1) % NUM_IO_BUFS;
     }
+    stats.log("sent", offset - mfr.offset);
 
     if (ret % packet_size == 0) {
         // If the last packet wasn't short, send a final empty packet
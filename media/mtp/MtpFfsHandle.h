@@ -30,7 +30,9 @@
 
 namespace android {
 
-constexpr int NUM_IO_BUFS = 2;
+// File transfers go through a ring of buffers: while one is transferred over usb, the disk
+// reads or writes of the others are queued.
+constexpr int NUM_IO_BUFS = 4;
 
 struct io_buffer {
     std::vector<struct iocb> iocbs;     // Holds memory for all iocbs. Not used directly.
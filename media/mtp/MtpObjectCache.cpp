@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "MtpObjectCache"
+
+#include "MtpDataPacket.h"
+#include "MtpDebug.h"
+#include "MtpObjectCache.h"
+
+#include <stdlib.h>
+
+namespace android {
+
+// Bounds the memory of the cached property lists, a list of all the objects can be large.
+static const size_t kMaxPropertyListBytes = 16 * 1024 * 1024;
+static const size_t kMaxObjectLists = 256;
+
+MtpObjectCache::MtpObjectCache()
+    :   mGeneration(0),
+        mPropertyListBytes(0)
+{
+}
+
+uint32_t MtpObjectCache::getGeneration() {
+    std::lock_guard<std::mutex> lg(mMutex);
+    return mGeneration;
+}
+
+bool MtpObjectCache::getObjectList(MtpStorageID storageID, MtpObjectFormat format,
+        MtpObjectHandle parent, MtpObjectHandleList& handles) {
+    std::lock_guard<std::mutex> lg(mMutex);
+    auto iter = mObjectLists.find(ObjectListKey(storageID, format, parent));
+    if (iter == mObjectLists.end())
+        return false;
+    handles = iter->second;
+    return true;
+}
+
+void MtpObjectCache::putObjectList(MtpStorageID storageID, MtpObjectFormat format,
+        MtpObjectHandle parent, const MtpObjectHandleList& handles, uint32_t generation) {
+    std::lock_guard<std::mutex> lg(mMutex);
+    if (generation != mGeneration)
+        return;
+    if (mObjectLists.size() >= kMaxObjectLists)
+        mObjectLists.clear();
+    mObjectLists[ObjectListKey(storageID, format, parent)] = handles;
+}
+
+bool MtpObjectCache::getObjectPropertyList(MtpObjectHandle handle, uint32_t format,
+        uint32_t property, int groupCode, int depth, MtpDataPacket& packet) {
+    std::lock_guard<std::mutex> lg(mMutex);
+    auto iter = mPropertyLists.find(PropertyListKey(handle, format, property, groupCode, depth));
+    if (iter == mPropertyLists.end())
+        return false;
+    packet.putData(iter->second.data(), iter->second.size());
+    return true;
+}
+
+void MtpObjectCache::putObjectPropertyList(MtpObjectHandle handle, uint32_t format,
+        uint32_t property, int groupCode, int depth, const MtpDataPacket& packet,
+        uint32_t generation) {
+    int length;
+    uint8_t* data = static_cast<uint8_t*>(packet.getData(&length));
+    if (data == NULL)
+        return;
+    std::vector<uint8_t> propertyList(data, data + length);
+    free(data);
+
+    std::lock_guard<std::mutex> lg(mMutex);
+    if (generation != mGeneration || propertyList.size() > kMaxPropertyListBytes)
+        return;
+    if (mPropertyListBytes + propertyList.size() > kMaxPropertyListBytes) {
+        mPropertyLists.clear();
+        mPropertyListBytes = 0;
+    }
+    auto& entry = mPropertyLists[PropertyListKey(handle, format, property, groupCode, depth)];
+    mPropertyListBytes += propertyList.size() - entry.size();
+    entry = std::move(propertyList);
+}
+
+void MtpObjectCache::invalidate() {
+    std::lock_guard<std::mutex> lg(mMutex);
+    mGeneration++;
+    mObjectLists.clear();
+    mPropertyLists.clear();
+    mPropertyListBytes = 0;
+}
+
+}  // namespace android
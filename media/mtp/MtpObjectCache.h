@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MTP_OBJECT_CACHE_H
+#define _MTP_OBJECT_CACHE_H
+
+#include "MtpTypes.h"
+
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+namespace android {
+
+class MtpDataPacket;
+
+// Caches the object handle lists and the object property lists returned by the database,
+// so that a host browsing a large folder again, or asking for the same properties again,
+// doesn't go through the database and its JNI calls each time.
+// Any change of the objects drops the whole cache.
+class MtpObjectCache {
+
+private:
+    typedef std::tuple<MtpStorageID, MtpObjectFormat, MtpObjectHandle> ObjectListKey;
+    typedef std::tuple<MtpObjectHandle, uint32_t, uint32_t, int, int> PropertyListKey;
+
+    std::mutex              mMutex;
+    // Incremented by invalidate(), results fetched before are not stored.
+    uint32_t                mGeneration;
+    size_t                  mPropertyListBytes;
+    std::map<ObjectListKey, MtpObjectHandleList>            mObjectLists;
+    std::map<PropertyListKey, std::vector<uint8_t>>         mPropertyLists;
+
+public:
+                            MtpObjectCache();
+
+    // Returns the generation to pass to the put methods, called before querying the database.
+    uint32_t                getGeneration();
+
+    bool                    getObjectList(MtpStorageID storageID, MtpObjectFormat format,
+                                    MtpObjectHandle parent, MtpObjectHandleList& handles);
+    void                    putObjectList(MtpStorageID storageID, MtpObjectFormat format,
+                                    MtpObjectHandle parent, const MtpObjectHandleList& handles,
+                                    uint32_t generation);
+
+    // The property list is the payload of the data packet.
+    bool                    getObjectPropertyList(MtpObjectHandle handle, uint32_t format,
+                                    uint32_t property, int groupCode, int depth,
+                                    MtpDataPacket& packet);
+    void                    putObjectPropertyList(MtpObjectHandle handle, uint32_t format,
+                                    uint32_t property, int groupCode, int depth,
+                                    const MtpDataPacket& packet, uint32_t generation);
+
+    void                    invalidate();
+};
+
+}; // namespace android
+
+#endif // _MTP_OBJECT_CACHE_H
@@ -142,6 +142,7 @@ void MtpServer::addStorage(MtpStorage* storage) {
     std::lock_guard<std::mutex> lg(mMutex);
 
     mStorages.push_back(storage);
+    mObjectCache.invalidate();
     sendStoreAdded(storage->getStorageID());
 }
 
@@ -151,6 +152,7 @@ void MtpServer::removeStorage(MtpStorage* storage) {
     if (iter != mStorages.end()) {
         sendStoreRemoved(storage->getStorageID());
         mStorages.erase(iter);
+        mObjectCache.invalidate();
     }
 }
 
@@ -258,16 +260,19 @@ void MtpServer::run() {
 
 void MtpServer::sendObjectAdded(MtpObjectHandle handle) {
     ALOGV("sendObjectAdded %d\n", handle);
+    mObjectCache.invalidate();
     sendEvent(MTP_EVENT_OBJECT_ADDED, handle);
 }
 
 void MtpServer::sendObjectRemoved(MtpObjectHandle handle) {
     ALOGV("sendObjectRemoved %d\n", handle);
+    mObjectCache.invalidate();
     sendEvent(MTP_EVENT_OBJECT_REMOVED, handle);
 }
 
 void MtpServer::sendObjectInfoChanged(MtpObjectHandle handle) {
     ALOGV("sendObjectInfoChanged %d\n", handle);
+    mObjectCache.invalidate();
     sendEvent(MTP_EVENT_OBJECT_INFO_CHANGED, handle);
 }
 
@@ -454,6 +459,11 @@ bool MtpServer::handleRequest() {
             break;
     }
 
+    if (!isReadOnlyOperation(operation)) {
+        // The objects may have changed, the database notifies the other changes.
+        mObjectCache.invalidate();
+    }
+
     if (response != MTP_RESPONSE_OK)
       ALOGW("[MTP] got response 0x%X in command %s (%x)", response,
             MtpDebug::getOperationCodeName(operation), operation);
@@ -463,6 +473,31 @@ bool MtpServer::handleRequest() {
     return true;
 }
 
+bool MtpServer::isReadOnlyOperation(MtpOperationCode operation) {
+    switch (operation) {
+        case MTP_OPERATION_GET_DEVICE_INFO:
+        case MTP_OPERATION_GET_STORAGE_IDS:
+        case MTP_OPERATION_GET_STORAGE_INFO:
+        case MTP_OPERATION_GET_OBJECT_PROPS_SUPPORTED:
+        case MTP_OPERATION_GET_OBJECT_HANDLES:
+        case MTP_OPERATION_GET_NUM_OBJECTS:
+        case MTP_OPERATION_GET_OBJECT_REFERENCES:
+        case MTP_OPERATION_GET_OBJECT_PROP_VALUE:
+        case MTP_OPERATION_GET_DEVICE_PROP_VALUE:
+        case MTP_OPERATION_GET_OBJECT_PROP_LIST:
+        case MTP_OPERATION_GET_OBJECT_INFO:
+        case MTP_OPERATION_GET_OBJECT:
+        case MTP_OPERATION_GET_THUMB:
+        case MTP_OPERATION_GET_PARTIAL_OBJECT:
+        case MTP_OPERATION_GET_PARTIAL_OBJECT_64:
+        case MTP_OPERATION_GET_OBJECT_PROP_DESC:
+        case MTP_OPERATION_GET_DEVICE_PROP_DESC:
+            return true;
+        default:
+            return false;
+    }
+}
+
 MtpResponseCode MtpServer::doGetDeviceInfo() {
     MtpStringBuffer   string;
 
@@ -593,10 +628,17 @@ MtpResponseCode MtpServer::doGetObjectHandles() {
     if (!hasStorage(storageID))
         return MTP_RESPONSE_INVALID_STORAGE_ID;
 
+    MtpObjectHandleList cachedHandles;
+    if (mObjectCache.getObjectList(storageID, format, parent, cachedHandles)) {
+        mData.putAUInt32(&cachedHandles);
+        return MTP_RESPONSE_OK;
+    }
+    uint32_t generation = mObjectCache.getGeneration();
     MtpObjectHandleList* handles = mDatabase->getObjectList(storageID, format, parent);
     if (handles == NULL)
         return MTP_RESPONSE_INVALID_OBJECT_HANDLE;
     mData.putAUInt32(handles);
+    mObjectCache.putObjectList(storageID, format, parent, *handles, generation);
     delete handles;
     return MTP_RESPONSE_OK;
 }
@@ -613,7 +655,9 @@ MtpResponseCode MtpServer::doGetNumObjects() {
     if (!hasStorage(storageID))
         return MTP_RESPONSE_INVALID_STORAGE_ID;
 
-    int count = mDatabase->getNumObjects(storageID, format, parent);
+    MtpObjectHandleList cachedHandles;
+    int count = mObjectCache.getObjectList(storageID, format, parent, cachedHandles)
+            ? cachedHandles.size() : mDatabase->getNumObjects(storageID, format, parent);
     if (count >= 0) {
         mResponse.setParameter(1, count);
         return MTP_RESPONSE_OK;
@@ -732,7 +776,16 @@ MtpResponseCode MtpServer::doGetObjectPropList() {
             handle, MtpDebug::getFormatCodeName(format),
             MtpDebug::getObjectPropCodeName(property), groupCode, depth);
 
-    return mDatabase->getObjectPropertyList(handle, format, property, groupCode, depth, mData);
+    if (mObjectCache.getObjectPropertyList(handle, format, property, groupCode, depth, mData))
+        return MTP_RESPONSE_OK;
+    uint32_t generation = mObjectCache.getGeneration();
+    MtpResponseCode result = mDatabase->getObjectPropertyList(handle, format, property,
+            groupCode, depth, mData);
+    if (result == MTP_RESPONSE_OK) {
+        mObjectCache.putObjectPropertyList(handle, format, property, groupCode, depth, mData,
+                generation);
+    }
+    return result;
 }
 
 MtpResponseCode MtpServer::doGetObjectInfo() {
@@ -21,6 +21,7 @@
 #include "MtpDataPacket.h"
 #include "MtpResponsePacket.h"
 #include "MtpEventPacket.h"
+#include "MtpObjectCache.h"
 #include "MtpStringBuffer.h"
 #include "mtp.h"
 #include "MtpUtils.h"
@@ -79,6 +80,9 @@ private:
 
     std::mutex          mMutex;
 
+    // responses of the database to the object enumeration requests
+    MtpObjectCache      mObjectCache;
+
     // represents an MTP object that is being edited using the android extensions
     // for direct editing (BeginEditObject, SendPartialObject, TruncateObject and EndEditObject)
     class ObjectEdit {
@@ -133,6 +137,7 @@ private:
     void                commitEdit(ObjectEdit* edit);
 
     bool                handleRequest();
+    static bool         isReadOnlyOperation(MtpOperationCode operation);
 
     MtpResponseCode     doGetDeviceInfo();
     MtpResponseCode     doOpenSession();
@@ -16,6 +16,7 @@
 
 #define LOG_TAG "TimerThread"
 
+#include <algorithm>
 #include <optional>
 #include <sstream>
 #include <unistd.h>
@@ -276,21 +277,27 @@ std::string TimerThread::Request::toString() const {
 }
 
 void TimerThread::RequestQueue::add(std::shared_ptr<const Request> request) {
-    std::lock_guard lg(mRQMutex);
-    mRequestQueue.emplace_back(std::chrono::system_clock::now(), std::move(request));
-    if (mRequestQueue.size() > mRequestQueueMax) {
-        mRequestQueue.pop_front();
+    if (mRequestQueue.empty()) return;
+    {
+        std::lock_guard lg(mRQMutex);
+        // the oldest request (if full) is swapped out, and released outside of lock.
+        std::swap(mRequestQueue[mNext], request);
+        mNext = (mNext + 1) % mRequestQueue.size();
+        if (mSize < mRequestQueue.size()) ++mSize;
     }
 }
 
 void TimerThread::RequestQueue::copyRequests(
         std::vector<std::shared_ptr<const Request>>& requests, size_t n) const {
     std::lock_guard lg(mRQMutex);
-    const size_t size = mRequestQueue.size();
-    size_t i = n >=  size ? 0 : size - n;
-    for (; i < size; ++i) {
-        const auto &[time, request] = mRequestQueue[i];
-        requests.emplace_back(request);
+    const size_t capacity = mRequestQueue.size();
+    const size_t count = std::min(n, mSize);
+    if (count == 0) return;
+    // the oldest of the last "count" requests.
+    size_t i = (mNext + capacity - count) % capacity;
+    for (size_t j = 0; j < count; ++j) {
+        requests.emplace_back(mRequestQueue[i]);
+        if (++i == capacity) i = 0;
     }
 }
 
@@ -412,10 +419,13 @@ void TimerThread::MonitorThread::threadFunc() {
             }
         }
         if (nextDeadline != INVALID_HANDLE) {
+            mWaitDeadline = nextDeadline;
             mCond.wait_until(_l, nextDeadline);
         } else {
+            mWaitDeadline = Handle::max();
             mCond.wait(_l);
         }
+        mWaitDeadline = INVALID_HANDLE;
     }
 }
 
@@ -425,7 +435,12 @@ TimerThread::Handle TimerThread::MonitorThread::add(
     const Handle handle = getUniqueHandle_l(timeout);
     mMonitorRequests.emplace_hint(mMonitorRequests.end(),
             handle, std::make_pair(std::move(request), std::move(func)));
-    mCond.notify_all();
+    // The monitor thread only needs to be woken if it would otherwise wake
+    // after this deadline.  This is uncommon, as cancelled requests don't
+    // wake it, and most requests have the same timeout.
+    if (handle < mWaitDeadline) {
+        mCond.notify_all();
+    }
     return handle;
 }
 
@@ -16,6 +16,10 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
 #include <map>
 #include <mutex>
 #include <string>
@@ -42,6 +46,37 @@ public:
     using FloatType = float;
     using StatsType = audio_utils::Statistics<FloatType>;
 
+    /**
+     * Latency histogram of a method.
+     *
+     * Bin 0 counts the events under kHistogramMinMs, bin i > 0 those from
+     * kHistogramMinMs * 2^(i - 1) ms, so the last bin counts those from 2048 ms.
+     */
+    static constexpr size_t kHistogramBins = 16;
+    static constexpr int64_t kDefaultExportIntervalNs = 3600'000'000'000;  // 1 hour
+    static constexpr FloatType kHistogramMinMs = 0.125f;
+    using HistogramType = std::array<uint32_t, kHistogramBins>;
+
+    static size_t getHistogramBin(FloatType executeMs) {
+        if (!(executeMs >= kHistogramMinMs)) return 0;  // also NaN
+        return std::min(kHistogramBins - 1,
+                size_t(1 + std::ilogb(executeMs / kHistogramMinMs)));
+    }
+
+    /**
+     * Returns the histogram as comma separated counts, without the trailing zeros.
+     */
+    static std::string histogramToString(const HistogramType& histogram) {
+        size_t size = histogram.size();
+        while (size > 0 && histogram[size - 1] == 0) --size;
+        std::string s;
+        for (size_t i = 0; i < size; ++i) {
+            if (i > 0) s.append(",");
+            s.append(std::to_string(histogram[i]));
+        }
+        return s;
+    }
+
     /**
      * Method statistics.
      *
@@ -57,6 +92,7 @@ public:
      */
     template <typename C>
     void event(C&& code, FloatType executeMs) {
+        const size_t bin = getHistogramBin(executeMs);
         std::lock_guard lg(mLock);
         auto it = mStatisticsMap.lower_bound(code);
         if (it != mStatisticsMap.end() && it->first == static_cast<Code>(code)) {
@@ -64,8 +100,9 @@ public:
         } else {
             // StatsType ctor takes an optional array of data for initialization.
             FloatType dataArray[1] = { executeMs };
-            mStatisticsMap.emplace_hint(it, std::forward<C>(code), dataArray);
+            it = mStatisticsMap.emplace_hint(it, std::forward<C>(code), dataArray);
         }
+        ++mHistogramMap[it->first][bin];
     }
 
     /**
@@ -94,6 +131,51 @@ public:
         return it == mStatisticsMap.end() ? StatsType{} : it->second;
     }
 
+    /**
+     * Returns the latency histogram for the method, since the last exportHistograms().
+     */
+    HistogramType getHistogram(const Code& code) const {
+        std::lock_guard lg(mLock);
+        auto it = mHistogramMap.find(code);
+        return it == mHistogramMap.end() ? HistogramType{} : it->second;
+    }
+
+    /**
+     * Returns true at most once every intervalNs, for a periodic export.
+     * The first call starts the interval and returns false.
+     */
+    bool isExportDue(int64_t nowNs, int64_t intervalNs) {
+        int64_t lastExportNs = mLastExportNs.load(std::memory_order_relaxed);
+        if (lastExportNs == 0) {
+            mLastExportNs.compare_exchange_strong(lastExportNs, nowNs);
+            return false;
+        }
+        return nowNs - lastExportNs >= intervalNs
+                && mLastExportNs.compare_exchange_strong(lastExportNs, nowNs);
+    }
+
+    /**
+     * Calls f(methodName, histogram) for each method invoked since the
+     * last call, with the histogram of the events since then.
+     *
+     * There should be a single caller, as each call restarts the histograms.
+     */
+    template <typename F>
+    void exportHistograms(F&& f) {
+        std::map<Code, HistogramType, std::less<>> histograms;
+        {
+            std::lock_guard lg(mLock);
+            mHistogramMap.swap(histograms);
+        }
+        for (const auto &[code, histogram] : histograms) {
+            if constexpr (std::is_same_v<Code, std::string>) {
+                f(code, histogram);
+            } else /* constexpr */ {
+                f(getMethodForCode(code), histogram);
+            }
+        }
+    }
+
     /**
      * Dumps the current method statistics.
      */
@@ -119,6 +201,9 @@ private:
     const std::map<Code, std::string, std::less<>> mMethodMap;
     mutable std::mutex mLock;
     std::map<Code, StatsType, std::less<>> mStatisticsMap GUARDED_BY(mLock);
+    // Histograms since the last exportHistograms().
+    std::map<Code, HistogramType, std::less<>> mHistogramMap GUARDED_BY(mLock);
+    std::atomic<int64_t> mLastExportNs{};
 };
 
 // Managed Statistics support.
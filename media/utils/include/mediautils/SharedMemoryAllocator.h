@@ -22,11 +22,13 @@
 
 #include <iomanip>
 #include <limits>
+#include <map>
 #include <mutex>
 #include <sstream>
 #include <string>
 #include <type_traits>
 #include <unordered_map>
+#include <vector>
 
 #include <binder/MemoryBase.h>
 #include <binder/MemoryHeapBase.h>
@@ -452,6 +454,125 @@ class IndirectAllocator {
     const std::shared_ptr<Allocator> mAllocator;
 };
 
+// An allocator which rounds requests up to power of two size classes (of at least
+// alignment()), and keeps the deallocated blocks of each class on a free list, to
+// satisfy later requests of the same class without a new allocation (and mapping)
+// from the underlying allocator.
+// At most MaxCachedBytes are kept, and requests larger than MaxBlockSize are passed
+// through unchanged and never cached. A reused block is not cleared.
+// If the underlying allocator fails, the cached blocks are released and the request
+// is retried, as they may count against the same pool.
+template <typename Allocator, size_t MaxCachedBytes, size_t MaxBlockSize = MaxCachedBytes>
+class SizeClassAllocator {
+  public:
+    static size_t alignment() { return Allocator::alignment(); }
+
+    explicit SizeClassAllocator(Allocator allocator) : mAllocator(std::move(allocator)) {}
+
+    // Default construct allocator
+    SizeClassAllocator() = default;
+
+    // Not copyable, as the cached blocks are owned.
+    SizeClassAllocator(const SizeClassAllocator&) = delete;
+    SizeClassAllocator& operator=(const SizeClassAllocator&) = delete;
+
+    ~SizeClassAllocator() { releaseCached(); }
+
+    template <typename T>
+    AllocationType allocate(T&& request) {
+        static_assert(std::is_base_of_v<BasicAllocRequest, std::decay_t<T>>);
+        const size_t classSize = sizeClass(request.size);
+        if (classSize != 0) {
+            auto it = mFreeLists.find(classSize);
+            if (it != mFreeLists.end() && !it->second.empty()) {
+                AllocationType allocation = std::move(it->second.back());
+                it->second.pop_back();
+                mCachedBytes -= classSize;
+                mReusedCount++;
+                return allocation;
+            }
+            request.size = classSize;
+        }
+        AllocationType allocation = mAllocator.allocate(request);
+        if (!allocation && mCachedBytes > 0) {
+            releaseCached();
+            allocation = mAllocator.allocate(request);
+        }
+        if (allocation) mAllocatedCount++;
+        return allocation;
+    }
+
+    void deallocate(const AllocationType& allocation) {
+        if (!allocation) return;
+        const size_t size = allocation->size();
+        if (size <= MaxBlockSize && mCachedBytes + size <= MaxCachedBytes
+                && sizeClass(size) == size) {
+            mFreeLists[size].push_back(allocation);
+            mCachedBytes += size;
+            return;
+        }
+        mAllocator.deallocate(allocation);
+    }
+
+    template <typename Enable = void>
+    auto deallocate_all()
+            -> std::enable_if_t<shared_allocator_impl::has_deallocate_all<Allocator>, Enable> {
+        mFreeLists.clear();
+        mCachedBytes = 0;
+        mAllocator.deallocate_all();
+    }
+
+    template <typename Enable = bool>
+    auto owns(const AllocationType& allocation) const
+            -> std::enable_if_t<shared_allocator_impl::has_owns<Allocator>, Enable> {
+        return mAllocator.owns(allocation);
+    }
+
+    std::string dump() const {
+        std::ostringstream dump;
+        dump << "Size Class Allocator: allocated " << mAllocatedCount << " reused "
+             << mReusedCount << " cached " << mCachedBytes << " bytes\n";
+        for (const auto& [size, freeList] : mFreeLists) {
+            if (freeList.empty()) continue;
+            dump << std::setw(10) << size << " x " << freeList.size() << "\n";
+        }
+        if constexpr (shared_allocator_impl::has_dump<Allocator>) {
+            dump << mAllocator.dump();
+        }
+        return dump.str();
+    }
+
+    size_t getAllocatedCount() const { return mAllocatedCount; }
+    size_t getReusedCount() const { return mReusedCount; }
+    size_t getCachedBytes() const { return mCachedBytes; }
+
+  private:
+    // Returns the size class of a request, or 0 if the request is not cached.
+    static size_t sizeClass(size_t size) {
+        if (size > MaxBlockSize) return 0;
+        size_t classSize = alignment();
+        while (classSize < size) classSize <<= 1;
+        return classSize <= MaxBlockSize ? classSize : 0;
+    }
+
+    void releaseCached() {
+        for (auto& [size, freeList] : mFreeLists) {
+            for (const auto& allocation : freeList) {
+                mAllocator.deallocate(allocation);
+            }
+        }
+        mFreeLists.clear();
+        mCachedBytes = 0;
+    }
+
+    [[no_unique_address]] Allocator mAllocator;
+    std::map<size_t, std::vector<AllocationType>> mFreeLists;
+    size_t mCachedBytes = 0;
+    // For debugging purposes, monotonic
+    size_t mAllocatedCount = 0;
+    size_t mReusedCount = 0;
+};
+
 // Stateless. This allocator allocates full page-aligned MemoryHeapBases (backed by
 // a shared memory mapped anonymous file) as allocations.
 class MemoryHeapBaseAllocator {
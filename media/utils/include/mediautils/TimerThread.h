@@ -18,7 +18,6 @@
 
 #include <atomic>
 #include <condition_variable>
-#include <deque>
 #include <functional>
 #include <map>
 #include <memory>
@@ -278,12 +277,13 @@ class TimerThread {
     };
 
   private:
-    // Deque of requests, in order of add().
+    // Ring buffer of the last requests, in order of add().
+    // It is allocated once, so that add() doesn't allocate.
     // This class is thread-safe.
     class RequestQueue {
       public:
         explicit RequestQueue(size_t maxSize)
-            : mRequestQueueMax(maxSize) {}
+            : mRequestQueue(maxSize) {}
 
         void add(std::shared_ptr<const Request>);
 
@@ -292,11 +292,10 @@ class TimerThread {
             size_t n = SIZE_MAX) const;
 
       private:
-        const size_t mRequestQueueMax;
         mutable std::mutex mRQMutex;
-        std::deque<std::pair<std::chrono::system_clock::time_point,
-                             std::shared_ptr<const Request>>>
-                mRequestQueue GUARDED_BY(mRQMutex);
+        std::vector<std::shared_ptr<const Request>> mRequestQueue GUARDED_BY(mRQMutex);
+        size_t mNext GUARDED_BY(mRQMutex) = 0;  // index of the next add()
+        size_t mSize GUARDED_BY(mRQMutex) = 0;
     };
 
     // A storage map of tasks without timeouts.  There is no TimerCallback
@@ -348,6 +347,10 @@ class TimerThread {
         // Worker thread variables
         bool mShouldExit GUARDED_BY(mMutex) = false;
 
+        // When the worker thread will wake up if not notified,
+        // INVALID_HANDLE if it isn't waiting.
+        Handle mWaitDeadline GUARDED_BY(mMutex) = INVALID_HANDLE;
+
         // To avoid race with initialization,
         // mThread should be initialized last as the thread is launched immediately.
         std::thread mThread;
@@ -70,3 +70,44 @@ TEST(methodstatistics_tests, events) {
     ASSERT_EQ(0.f, unsetStats.getMean());
     ASSERT_EQ(0U, methodStatistics.getMethodCount(UNKNOWN_CODE));
 }
+
+TEST(methodstatistics_tests, histograms) {
+    using Stats = MethodStatistics<CodeType>;
+    Stats methodStatistics{
+            {HELLO_CODE, HELLO_NAME},
+            {WORLD_CODE, WORLD_NAME},
+    };
+
+    ASSERT_EQ(0U, Stats::getHistogramBin(0.f));
+    ASSERT_EQ(0U, Stats::getHistogramBin(Stats::kHistogramMinMs / 2));
+    ASSERT_EQ(1U, Stats::getHistogramBin(Stats::kHistogramMinMs));
+    ASSERT_EQ(4U, Stats::getHistogramBin(1.f));
+    ASSERT_EQ(4U, Stats::getHistogramBin(1.9f));
+    ASSERT_EQ(Stats::kHistogramBins - 1, Stats::getHistogramBin(1e9f));
+
+    for (const auto event : HELLO_EVENTS) {
+        methodStatistics.event(HELLO_CODE, event);
+    }
+    const Stats::HistogramType expected{0, 0, 0, 0, 1, 1};
+    ASSERT_EQ(expected, methodStatistics.getHistogram(HELLO_CODE));
+    ASSERT_EQ("0,0,0,0,1,1", Stats::histogramToString(expected));
+    ASSERT_EQ(Stats::HistogramType{}, methodStatistics.getHistogram(WORLD_CODE));
+
+    size_t exported = 0;
+    methodStatistics.exportHistograms(
+            [&](const std::string& method, const Stats::HistogramType& histogram) {
+        ASSERT_EQ(HELLO_NAME, method);
+        ASSERT_EQ(expected, histogram);
+        ++exported;
+    });
+    ASSERT_EQ(1U, exported);
+
+    // the histograms restart from the export, the statistics don't.
+    ASSERT_EQ(Stats::HistogramType{}, methodStatistics.getHistogram(HELLO_CODE));
+    ASSERT_EQ(std::size(HELLO_EVENTS), methodStatistics.getMethodCount(HELLO_CODE));
+
+    ASSERT_FALSE(methodStatistics.isExportDue(1000, 100));  // starts the interval
+    ASSERT_FALSE(methodStatistics.isExportDue(1050, 100));
+    ASSERT_TRUE(methodStatistics.isExportDue(1100, 100));
+    ASSERT_FALSE(methodStatistics.isExportDue(1150, 100));
+}
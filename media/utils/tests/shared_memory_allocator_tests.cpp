@@ -356,3 +356,94 @@ TEST(shared_memory_allocator_tests, scoped_allocator) {
     ScopedAllocator<ValidateForwarding<0>> forwarding{};
     EXPECT_EQ(forwarding.dump(), ValidateForwarding<0>::dump_string);
 }
+
+TEST(shared_memory_allocator_tests, size_class_allocator) {
+    const auto underlying_allocator =
+            std::make_shared<SnoopingAllocator<MemoryHeapBaseAllocator>>("Allocator");
+    SizeClassAllocator<IndirectAllocator<SnoopingAllocator<MemoryHeapBaseAllocator>>,
+                       kMaxPageSize * 4, kMaxPageSize * 2>
+            allocator{IndirectAllocator{underlying_allocator}};
+    ASSERT_EQ(decltype(allocator)::alignment(), kPageSize);
+    const auto& allocations = underlying_allocator->getAllocations();
+
+    // Requests are rounded up to a power of two multiple of the alignment.
+    const auto memory = allocator.allocate(NamedAllocRequest{{kPageSize + 1}, "allocation_1"});
+    validate_block(memory);
+    EXPECT_EQ(memory->size(), kPageSize * 2);
+    const int heapId = memory->getMemory()->getHeapID();
+    allocator.deallocate(memory);
+    // The block is cached, not deallocated.
+    EXPECT_EQ(allocations.size(), 1ul);
+    EXPECT_EQ(allocator.getCachedBytes(), kPageSize * 2);
+
+    // A request of the same class reuses the block.
+    const auto memory2 = allocator.allocate(NamedAllocRequest{{kPageSize * 2}, "allocation_2"});
+    validate_block(memory2);
+    EXPECT_EQ(memory2->getMemory()->getHeapID(), heapId);
+    EXPECT_EQ(allocator.getReusedCount(), 1ul);
+    EXPECT_EQ(allocator.getAllocatedCount(), 1ul);
+    EXPECT_EQ(allocator.getCachedBytes(), 0ul);
+
+    // A request of another class does not.
+    const auto memory3 = allocator.allocate(NamedAllocRequest{{kPageSize}, "allocation_3"});
+    validate_block(memory3);
+    EXPECT_EQ(memory3->size(), kPageSize);
+    EXPECT_EQ(allocations.size(), 2ul);
+
+    // Requests larger than the maximum block size are passed through and not cached.
+    const auto large = allocator.allocate(NamedAllocRequest{{kMaxPageSize * 3}, "large"});
+    validate_block(large);
+    EXPECT_EQ(allocations.size(), 3ul);
+    allocator.deallocate(large);
+    EXPECT_EQ(allocations.size(), 2ul);
+    EXPECT_EQ(allocator.getCachedBytes(), 0ul);
+
+    allocator.deallocate(memory2);
+    allocator.deallocate(memory3);
+    EXPECT_EQ(allocations.size(), 2ul);
+    EXPECT_EQ(allocator.getCachedBytes(), kPageSize * 3);
+    EXPECT_TRUE(allocator.dump().find("reused 1") != std::string::npos);
+}
+
+TEST(shared_memory_allocator_tests, size_class_allocator_release) {
+    const auto underlying_allocator =
+            std::make_shared<SnoopingAllocator<MemoryHeapBaseAllocator>>("Allocator");
+    const auto& allocations = underlying_allocator->getAllocations();
+    {
+        SizeClassAllocator<IndirectAllocator<SnoopingAllocator<MemoryHeapBaseAllocator>>,
+                           kMaxPageSize>
+                allocator{IndirectAllocator{underlying_allocator}};
+        allocator.deallocate(allocator.allocate(NamedAllocRequest{{kPageSize}, "allocation"}));
+        EXPECT_EQ(allocations.size(), 1ul);
+    }
+    // The cache is released with the allocator.
+    EXPECT_EQ(allocations.size(), 0ul);
+}
+
+TEST(shared_memory_allocator_tests, size_class_allocator_cache_limit) {
+    using Allocator = PolicyAllocator<SnoopingAllocator<MemoryHeapBaseAllocator>,
+                                      SizePolicy<kMaxPageSize * 2>>;
+    SizeClassAllocator<Allocator, kMaxPageSize, kMaxPageSize> allocator;
+    const auto first = allocator.allocate(NamedAllocRequest{{kMaxPageSize}, "first"});
+    const auto second = allocator.allocate(NamedAllocRequest{{kMaxPageSize}, "second"});
+    ASSERT_TRUE(first && second);
+    allocator.deallocate(first);
+    // The cache is full, the second block is deallocated.
+    allocator.deallocate(second);
+    EXPECT_EQ(allocator.getCachedBytes(), kMaxPageSize);
+    EXPECT_EQ(second->unsecurePointer(), nullptr);
+
+    // The pool is exhausted by the cached block and a new one, so the cache is
+    // released to satisfy a request of another class.
+    const auto third = allocator.allocate(NamedAllocRequest{{kMaxPageSize}, "third"});
+    ASSERT_TRUE(third);
+    const auto fourth = allocator.allocate(NamedAllocRequest{{kMaxPageSize}, "fourth"});
+    ASSERT_TRUE(fourth);
+    allocator.deallocate(third);
+    EXPECT_EQ(allocator.getCachedBytes(), kMaxPageSize);
+    if (kPageSize == kMaxPageSize) return;  // there is no smaller class
+    const auto small = allocator.allocate(NamedAllocRequest{{kPageSize}, "small"});
+    EXPECT_TRUE(small);
+    EXPECT_EQ(allocator.getCachedBytes(), 0ul);
+    EXPECT_EQ(third->unsecurePointer(), nullptr);
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+
+#include <benchmark/benchmark.h>
+#include <mediautils/TimerThread.h>
+
+using namespace std::chrono_literals;
+using namespace android::mediautils;
+
+// Measures the cost of a TimerThread task that is cancelled before its timeout,
+// which is what a TimeCheck costs every binder call it covers.
+
+namespace {
+
+TimerThread gTimerThread;
+
+// Every task has the same timeout, like the TimeChecks of an interface.
+void BM_ScheduleCancel(benchmark::State& state) {
+    for (auto _ : state) {
+        const auto handle = gTimerThread.scheduleTask(
+                "BM_ScheduleCancel", [](TimerThread::Handle) {}, 10s, 10s);
+        benchmark::DoNotOptimize(gTimerThread.cancelTask(handle));
+    }
+}
+
+// Every task timeout is shorter than the previous one, so each one
+// is the earliest and wakes the monitor thread.
+void BM_ScheduleCancelDecreasingTimeout(benchmark::State& state) {
+    TimerThread::Duration timeout = 1000s;
+    for (auto _ : state) {
+        const auto handle = gTimerThread.scheduleTask(
+                "BM_ScheduleCancelDecreasingTimeout", [](TimerThread::Handle) {},
+                timeout, 10s);
+        benchmark::DoNotOptimize(gTimerThread.cancelTask(handle));
+        timeout = timeout > 10s ? timeout - 1ms : 1000s;
+    }
+}
+
+void BM_TrackCancel(benchmark::State& state) {
+    for (auto _ : state) {
+        const auto handle = gTimerThread.trackTask("BM_TrackCancel");
+        benchmark::DoNotOptimize(gTimerThread.cancelTask(handle));
+    }
+}
+
+}  // namespace
+
+BENCHMARK(BM_ScheduleCancel)->ThreadRange(1, 8);
+BENCHMARK(BM_ScheduleCancelDecreasingTimeout);
+BENCHMARK(BM_TrackCancel)->ThreadRange(1, 8);
+
+BENCHMARK_MAIN();
@@ -58,10 +58,13 @@
 #include <system/audio_effects/effect_spatializer.h>
 #include <system/audio_effects/effect_visualizer.h>
 #include <utils/Log.h>
+#include <utils/Timers.h>
 
 // not needed with the includes above, added to prevent transitive include dependency.
 #include <chrono>
+#include <future>
 #include <thread>
+#include <tuple>
 
 // ----------------------------------------------------------------------------
 
@@ -209,6 +212,60 @@ static auto& getIAudioFlingerStatistics() {
     return methodStatistics;
 }
 
+// Phases of AudioFlinger::createTrack(), to locate the latency of track creation bursts.
+enum CreateTrackPhase {
+    CREATE_TRACK_PHASE_POLICY,  // AudioSystem::getOutputForAttr()
+    CREATE_TRACK_PHASE_LOCK,    // waiting for AudioFlinger::mutex()
+    CREATE_TRACK_PHASE_CREATE,  // createTrack_l(), including the shared memory allocation
+    CREATE_TRACK_PHASE_ATTACH,  // secondary outputs and effects, with the thread mutex() held
+};
+
+// singleton for the createTrack() phase statistics, in ms.
+static auto& getCreateTrackStatistics() {
+    static mediautils::MethodStatistics<int> methodStatistics{
+        {CREATE_TRACK_PHASE_POLICY, "getOutputForAttr"},
+        {CREATE_TRACK_PHASE_LOCK, "lockAudioFlinger"},
+        {CREATE_TRACK_PHASE_CREATE, "createTrack_l"},
+        {CREATE_TRACK_PHASE_ATTACH, "attachTrack"},
+    };
+    return methodStatistics;
+}
+
+// Logs the method latency histograms since the last export, one item per interface.
+template <typename Code>
+static void exportMethodStatistics(
+        std::string_view interfaceName, mediautils::MethodStatistics<Code>& statistics) {
+    using Stats = mediautils::MethodStatistics<Code>;
+    mediametrics::LogItem item(
+            std::string(AMEDIAMETRICS_KEY_PREFIX_AUDIO_METHOD_STATISTICS).append(interfaceName));
+    bool empty = true;
+    statistics.exportHistograms([&](const std::string& method,
+            const typename Stats::HistogramType& histogram) {
+        item.set(method.c_str(), Stats::histogramToString(histogram).c_str());
+        empty = false;
+    });
+    if (!empty) item.record();
+}
+
+// Periodically called from the IAudioFlinger binder calls.
+static void exportAllMethodStatistics() {
+    exportMethodStatistics("IAudioFlinger", getIAudioFlingerStatistics());
+    extern mediautils::MethodStatistics<int>& getIEffectStatistics();
+    exportMethodStatistics("IEffect", getIEffectStatistics());
+    // Only the classes of the HAL in use have events.
+    for (const auto halType :
+            {METHOD_STATISTICS_MODULE_NAME_AUDIO_HIDL, METHOD_STATISTICS_MODULE_NAME_AUDIO_AIDL}) {
+        const std::shared_ptr<std::vector<std::string>> halClassNames =
+                mediautils::getStatisticsClassesForModule(halType);
+        if (!halClassNames) continue;
+        for (const auto& className : *halClassNames) {
+            if (auto stats = mediautils::getStatisticsForClass(className)) {
+                exportMethodStatistics(className, *stats);
+            }
+        }
+    }
+}
+
 namespace base {
 template <typename T>
 struct OkOrFail<std::optional<T>> {
@@ -867,6 +924,10 @@ NO_THREAD_SAFETY_ANALYSIS  // conditional try lock
             dprintf(fd, "\nIAudioFlinger binder call profile:\n");
             write(fd, timeCheckStats.c_str(), timeCheckStats.size());
 
+            timeCheckStats = getCreateTrackStatistics().dump();
+            dprintf(fd, "\nIAudioFlinger createTrack phase profile:\n");
+            write(fd, timeCheckStats.c_str(), timeCheckStats.size());
+
             extern mediautils::MethodStatistics<int>& getIEffectStatistics();
             timeCheckStats = getIEffectStatistics().dump();
             dprintf(fd, "\nIEffect binder call profile:\n");
@@ -992,6 +1053,12 @@ status_t AudioFlinger::createTrack(const media::CreateTrackRequest& _input,
     std::vector<audio_io_handle_t> secondaryOutputs;
     bool isSpatialized = false;
     bool isBitPerfect = false;
+    nsecs_t phaseStartNs = 0;
+    const auto endPhase = [&phaseStartNs](CreateTrackPhase phase) {
+        const nsecs_t nowNs = systemTime();
+        getCreateTrackStatistics().event(phase, (nowNs - phaseStartNs) * 1e-6f);
+        phaseStartNs = nowNs;
+    };
 
     // TODO b/182392553: refactor or make clearer
     pid_t clientPid =
@@ -1035,10 +1102,12 @@ status_t AudioFlinger::createTrack(const media::CreateTrackRequest& _input,
     output.sessionId = sessionId;
     output.outputId = AUDIO_IO_HANDLE_NONE;
     output.selectedDeviceId = input.selectedDeviceId;
+    phaseStartNs = systemTime();
     lStatus = AudioSystem::getOutputForAttr(&localAttr, &output.outputId, sessionId, &streamType,
                                             adjAttributionSource, &input.config, input.flags,
                                             &output.selectedDeviceId, &portId, &secondaryOutputs,
                                             &isSpatialized, &isBitPerfect);
+    endPhase(CREATE_TRACK_PHASE_POLICY);
 
     if (lStatus != NO_ERROR || output.outputId == AUDIO_IO_HANDLE_NONE) {
         ALOGE("createTrack() getOutputForAttr() return error %d or invalid output handle", lStatus);
@@ -1068,6 +1137,7 @@ status_t AudioFlinger::createTrack(const media::CreateTrackRequest& _input,
 
     {
         audio_utils::lock_guard _l(mutex());
+        endPhase(CREATE_TRACK_PHASE_LOCK);
         IAfPlaybackThread* thread = checkPlaybackThread_l(output.outputId);
         if (thread == NULL) {
             ALOGE("no playback thread found for output handle %d", output.outputId);
@@ -1111,6 +1181,7 @@ status_t AudioFlinger::createTrack(const media::CreateTrackRequest& _input,
                                       callingPid, adjAttributionSource, input.clientInfo.clientTid,
                                       &lStatus, portId, input.audioTrackCallback, isSpatialized,
                                       isBitPerfect, &output.afTrackFlags);
+        endPhase(CREATE_TRACK_PHASE_CREATE);
         LOG_ALWAYS_FATAL_IF((lStatus == NO_ERROR) && (track == 0));
         // we don't abort yet if lStatus != NO_ERROR; there is still work to be done regardless
 
@@ -1155,6 +1226,7 @@ status_t AudioFlinger::createTrack(const media::CreateTrackRequest& _input,
                     effectIds = thread->getEffectIds_l(sessionId);
                 }
             }
+            endPhase(CREATE_TRACK_PHASE_ATTACH);
         }
 
         // Look for sync events awaiting for a session to be used.
@@ -2463,7 +2535,8 @@ status_t AudioFlinger::createRecord(const media::CreateRecordRequest& _input,
                                                   &output.notificationFrameCount,
                                                   callingPid, adjAttributionSource, &output.flags,
                                                   input.clientInfo.clientTid,
-                                                  &lStatus, portId, input.maxSharedAudioHistoryMs);
+                                                  &lStatus, portId, input.maxSharedAudioHistoryMs,
+                                                  input.startTimeNs);
         LOG_ALWAYS_FATAL_IF((lStatus == NO_ERROR) && (recordTrack == 0));
 
         // lStatus == BAD_TYPE means FAST flag was rejected: request a new input from
@@ -2551,6 +2624,8 @@ status_t AudioFlinger::getAudioPolicyConfig(media::AudioPolicyConfig *config)
     RETURN_STATUS_IF_ERROR(mDevicesFactoryHal->getEngineConfig(&config->engineConfig));
     std::vector<std::string> hwModuleNames;
     RETURN_STATUS_IF_ERROR(mDevicesFactoryHal->getDeviceNames(&hwModuleNames));
+    const nsecs_t startNs = systemTime();
+    openHwDevices_ll(hwModuleNames);
     std::set<AudioMode> allSupportedModes;
     for (const auto& name : hwModuleNames) {
         AudioHwDevice* module = loadHwModule_ll(name.c_str());
@@ -2577,6 +2652,8 @@ status_t AudioFlinger::getAudioPolicyConfig(media::AudioPolicyConfig *config)
             media::audio::common::AudioMode::IN_CALL,
             media::audio::common::AudioMode::IN_COMMUNICATION };
     }
+    ALOGI("%s: loaded %zu HW modules in %lld ms", __func__, config->modules.size(),
+            (long long)ns2ms(systemTime() - startNs));
     return OK;
 }
 
@@ -2607,7 +2684,13 @@ AudioHwDevice* AudioFlinger::loadHwModule_ll(const char *name)
 
     sp<DeviceHalInterface> dev;
 
-    int rc = mDevicesFactoryHal->openDevice(name, &dev);
+    int rc;
+    if (auto it = mOpenedHwDevices.find(name); it != mOpenedHwDevices.end()) {
+        std::tie(rc, dev) = it->second;
+        mOpenedHwDevices.erase(it);
+    } else {
+        rc = mDevicesFactoryHal->openDevice(name, &dev);
+    }
     if (rc) {
         ALOGE("loadHwModule() error %d loading module %s", rc, name);
         return nullptr;
@@ -2702,6 +2785,35 @@ AudioHwDevice* AudioFlinger::loadHwModule_ll(const char *name)
     return audioDevice;
 }
 
+void AudioFlinger::openHwDevices_ll(const std::vector<std::string>& names)
+{
+    // Opening a device ends up in the HAL process, which can take a while
+    // for each module. Modules may share state in the HAL, so they are only
+    // opened concurrently if the device says so.
+    if (names.size() < 2 || !property_get_bool("ro.audio.hal.parallel_module_open", false)) {
+        return;
+    }
+    std::vector<std::pair<std::string, std::future<std::pair<status_t, sp<DeviceHalInterface>>>>>
+            openings;
+    for (const auto& name : names) {
+        bool loaded = mOpenedHwDevices.count(name) != 0;
+        for (size_t i = 0; !loaded && i < mAudioHwDevs.size(); i++) {
+            loaded = strncmp(mAudioHwDevs.valueAt(i)->moduleName(), name.c_str(),
+                    name.size()) == 0;
+        }
+        if (loaded) continue;
+        openings.emplace_back(name, std::async(std::launch::async,
+                [factory = mDevicesFactoryHal, name]() {
+                    sp<DeviceHalInterface> dev;
+                    const status_t status = factory->openDevice(name.c_str(), &dev);
+                    return std::make_pair(status, dev);
+                }));
+    }
+    for (auto& [name, opening] : openings) {
+        mOpenedHwDevices[name] = opening.get();
+    }
+}
+
 // Sort AudioHwDevice to be traversed in the getInputBufferSize call in the following order:
 // Primary, Usb, Bluetooth, A2DP, other modules, remote submix.
 /* static */
@@ -5186,7 +5298,11 @@ status_t AudioFlinger::onTransactWrapper(TransactionCode code,
                 .set(AMEDIAMETRICS_PROP_METHODNAME, methodName.c_str())
                 .record();
         } else {
-            getIAudioFlingerStatistics().event(code, elapsedMs);
+            auto& statistics = getIAudioFlingerStatistics();
+            statistics.event(code, elapsedMs);
+            if (statistics.isExportDue(systemTime(), statistics.kDefaultExportIntervalNs)) {
+                exportAllMethodStatistics();
+            }
         }
     }, mediautils::TimeCheck::kDefaultTimeoutDuration,
     mediautils::TimeCheck::kDefaultSecondChanceDuration,
@@ -658,6 +658,10 @@ private:
     std::set<AudioHwDevice*, decltype(&inputBufferSizeDevsCmp)>
             mInputBufferSizeOrderedDevs GUARDED_BY(hardwareMutex()) {inputBufferSizeDevsCmp};
 
+    // Devices opened by openHwDevices_ll(), with the status of their opening.
+    std::map<std::string, std::pair<status_t, sp<DeviceHalInterface>>> mOpenedHwDevices
+            GUARDED_BY(hardwareMutex());
+
      const sp<DevicesFactoryHalInterface> mDevicesFactoryHal =
              DevicesFactoryHalInterface::create();
      /* const */ sp<DevicesFactoryHalCallback> mDevicesFactoryHalCallback;  // set onFirstRef().
@@ -713,6 +717,10 @@ private:
     Vector<AudioSessionRef*> mAudioSessionRefs GUARDED_BY(mutex());
 
     AudioHwDevice* loadHwModule_ll(const char *name) REQUIRES(mutex(), hardwareMutex());
+    // Opens concurrently the HAL devices of the modules which are not loaded yet, for
+    // loadHwModule_ll() to pick them up. Only done when the HAL allows it.
+    void openHwDevices_ll(const std::vector<std::string>& names)
+            REQUIRES(mutex(), hardwareMutex());
 
                 // sync events awaiting for a session to be created.
     std::list<sp<audioflinger::SyncEvent>> mPendingSyncEvents GUARDED_BY(mutex());
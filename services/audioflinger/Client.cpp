@@ -34,4 +34,33 @@ AllocatorFactory::ClientAllocator& Client::allocator()
     return mClientAllocator;
 }
 
+void Client::preallocateCblk(size_t size)
+{
+    sp<IMemory> memory = mClientAllocator.allocate(mediautils::NamedAllocRequest{{size},
+            std::string("Preallocated Track")});
+    if (memory == nullptr) return;  // the track will retry and report the failure.
+    sp<IMemory> released;  // released after the lock
+    std::lock_guard l(mPreallocatedMutex);
+    if (mPreallocatedCblks.size() >= kMaxPreallocatedCblks) {
+        released = std::move(mPreallocatedCblks.front().second);
+        mPreallocatedCblks.pop_front();
+    }
+    mPreallocatedCblks.emplace_back(size, std::move(memory));
+}
+
+sp<IMemory> Client::allocateCblk(size_t size, const std::string& name)
+{
+    {
+        std::lock_guard l(mPreallocatedMutex);
+        for (auto it = mPreallocatedCblks.begin(); it != mPreallocatedCblks.end(); ++it) {
+            if (it->first == size) {
+                sp<IMemory> memory = std::move(it->second);
+                mPreallocatedCblks.erase(it);
+                return memory;
+            }
+        }
+    }
+    return mClientAllocator.allocate(mediautils::NamedAllocRequest{{size}, name});
+}
+
 }   // namespace android
\ No newline at end of file
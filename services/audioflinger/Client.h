@@ -19,8 +19,15 @@
 #include <afutils/AllocatorFactory.h>
 #include <audio_utils/mutex.h>
 #include <android-base/macros.h>  // DISALLOW_COPY_AND_ASSIGN
+#include <android-base/thread_annotations.h>
+#include <binder/IMemory.h>
 #include <utils/RefBase.h>        // avoid transitive dependency
 
+#include <deque>
+#include <mutex>
+#include <string>
+#include <utility>
+
 // TODO(b/291318727) Move to nested namespace
 namespace android {
 
@@ -49,6 +56,18 @@ public:
     ~Client() override;
     AllocatorFactory::ClientAllocator& allocator();
     pid_t pid() const { return mPid; }
+
+    // Allocates the shared memory of a track of the given size ahead of its creation,
+    // so that the allocation is not done with a thread mutex() held.
+    // The allocation is kept until taken by allocateCblk(), at most kMaxPreallocatedCblks
+    // allocations are kept, the oldest one is released first.
+    void preallocateCblk(size_t size) EXCLUDES(mPreallocatedMutex);
+
+    // Returns a preallocated shared memory of exactly the given size if any,
+    // otherwise allocates it from allocator().
+    sp<IMemory> allocateCblk(size_t size, const std::string& name) EXCLUDES(mPreallocatedMutex);
+
+    static constexpr size_t kMaxPreallocatedCblks = 2;
     const auto& afClientCallback() const { return mAfClientCallback; }
 
 private:
@@ -57,6 +76,12 @@ private:
     const sp<IAfClientCallback> mAfClientCallback;
     const pid_t mPid;
     AllocatorFactory::ClientAllocator mClientAllocator;
+
+    // leaf lock, the allocator is never called with it held.
+    std::mutex mPreallocatedMutex;
+    // requested size and allocation, which may be rounded up by the allocator.
+    std::deque<std::pair<size_t, sp<IMemory>>> mPreallocatedCblks
+            GUARDED_BY(mPreallocatedMutex);
 };
 
 } // namespace android
@@ -725,6 +725,10 @@ void EffectModule::process()
                             mConfig.inputCfg.buffer.frameCount);
                 }
             }
+            if (mNeutral && !auxType) {
+                // the effect is the identity, skip the processing and the conversions.
+                goto data_bypass;
+            }
             sp<EffectBufferHalInterface> inBuffer = mInBuffer;
             sp<EffectBufferHalInterface> outBuffer = mOutBuffer;
 
@@ -1005,6 +1009,10 @@ status_t EffectModule::configure_l()
         }
     }
 
+    if (status == NO_ERROR) {
+        updateNeutral_l();
+    }
+
     // mConfig.outputCfg.buffer.frameCount cannot be zero.
     mMaxDisableWaitCnt = (uint32_t)std::max(
             (uint64_t)1, // mMaxDisableWaitCnt must be greater than zero.
@@ -1085,6 +1093,7 @@ status_t EffectModule::start_ll()
     }
     if (status == 0) {
         addEffectToHal_l();
+        updateNeutral_l();
     }
     return status;
 }
@@ -1232,6 +1241,7 @@ status_t EffectModule::command(int32_t cmdCode,
                                                 reply->data());
     reply->resize(status == NO_ERROR ? replySize : 0);
     if (cmdCode != EFFECT_CMD_GET_PARAM && status == NO_ERROR) {
+        updateNeutral_l();
         for (size_t i = 1; i < mHandles.size(); i++) {
             IAfEffectHandle *h = mHandles[i];
             if (h != NULL && !h->disconnected()) {
@@ -1242,6 +1252,38 @@ status_t EffectModule::command(int32_t cmdCode,
     return status;
 }
 
+void EffectModule::updateNeutral_l()
+{
+    bool neutral = false;
+    // volume control effects apply the volume, which must not be bypassed.
+    if (mEffectInterface != 0 && !isVolumeControl() && isProcessImplemented()
+            && (mDescriptor.flags & EFFECT_FLAG_TYPE_MASK) == EFFECT_FLAG_TYPE_INSERT) {
+        uint32_t buf32[sizeof(effect_param_t) / sizeof(uint32_t) + 2];
+        effect_param_t *p = (effect_param_t *)buf32;
+
+        p->psize = sizeof(int32_t);
+        p->vsize = sizeof(int32_t);
+        *(int32_t *)p->data = kParamNeutral;
+        uint32_t replySize = sizeof(buf32);
+        const status_t status = mEffectInterface->command(EFFECT_CMD_GET_PARAM,
+                sizeof(effect_param_t) + sizeof(int32_t), buf32, &replySize, buf32);
+        // only an exact reply is trusted, effects may not check unknown parameters.
+        neutral = status == NO_ERROR && replySize == sizeof(buf32)
+                && p->status == 0 && p->vsize == sizeof(int32_t)
+                && *((int32_t *)p->data + 1) == 1;
+    }
+    if (neutral != mNeutral) {
+        ALOGV("%s: effect %s %s neutral", __func__, mDescriptor.name, neutral ? "is" : "is not");
+        if (!neutral && mEffectInterface != 0) {
+            // the state of the effect is stale after being bypassed.
+            int reply = 0;
+            uint32_t replySize = sizeof(reply);
+            mEffectInterface->command(EFFECT_CMD_RESET, 0, NULL, &replySize, &reply);
+        }
+        mNeutral = neutral;
+    }
+}
+
 bool EffectModule::isProcessEnabled() const
 {
     if (mStatus != NO_ERROR) {
@@ -1683,6 +1725,9 @@ NO_THREAD_SAFETY_ANALYSIS  // conditional try lock
             mStatus, mEffectInterface.get());
 
     result.appendFormat("\t\t- data: %s\n", mSupportsFloat ? "float" : "int16");
+    if (mNeutral) {
+        result.append("\t\t- neutral: bypassed\n");
+    }
 
     result.append("\t\t- Input configuration:\n");
     result.append("\t\t\tBuffer     Frames  Smp rate Channels Format\n");
@@ -2270,6 +2315,11 @@ void EffectChain::clearInputBuffer_l()
 
 // Must be called with EffectChain::mutex() locked
 void EffectChain::process_l() {
+    processAudio_l();
+    updateEffectsState_l();
+}
+
+void EffectChain::processAudio_l() {
     // never process effects when:
     // - on an OFFLOAD thread
     // - no more tracks are on the session and the effect tail has been rendered
@@ -2310,6 +2360,10 @@ void EffectChain::process_l() {
             mOutBuffer->commit();
         }
     }
+}
+
+void EffectChain::updateEffectsState_l() {
+    const size_t size = mEffects.size();
     bool doResetVolume = false;
     for (size_t i = 0; i < size; i++) {
         // reset volume when any effect just started or stopped.
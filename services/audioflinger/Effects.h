@@ -24,6 +24,7 @@
 #include <mediautils/Synchronization.h>
 #include <private/media/AudioEffectShared.h>
 
+#include <atomic>
 #include <map>  // avoid transitive dependency
 #include <optional>
 #include <vector>
@@ -199,6 +200,7 @@ public:
         return mStatus;
     }
     bool isProcessEnabled() const final;
+    bool isNeutral() const final { return mNeutral; }
     bool isOffloadedOrDirect_l() const final REQUIRES(audio_utils::EffectChain_Mutex);
     bool isVolumeControlEnabled_l() const final REQUIRES(audio_utils::EffectChain_Mutex);
     void setInBuffer(const sp<EffectBufferHalInterface>& buffer) final;
@@ -284,6 +286,11 @@ private:
     bool     mIsOutput;             // direction of the AF thread
 
     bool    mSupportsFloat;         // effect supports float processing
+    // effect reported kParamNeutral, process() is bypassed.
+    std::atomic_bool mNeutral = false;
+    // queries kParamNeutral from the effect after a command or configuration,
+    // called with either the EffectChain or the EffectBase mutex held.
+    void updateNeutral_l();
     sp<EffectBufferHalInterface> mInConversionBuffer;  // Buffers for HAL conversion if needed.
     sp<EffectBufferHalInterface> mOutConversionBuffer;
     uint32_t mInChannelCountRequested;
@@ -428,6 +435,8 @@ public:
                 const sp<IAfThreadCallback>& afThreadCallback);
 
     void process_l() final REQUIRES(audio_utils::EffectChain_Mutex);
+    void processAudio_l() final REQUIRES(audio_utils::EffectChain_Mutex);
+    void updateEffectsState_l() final REQUIRES(audio_utils::EffectChain_Mutex);
 
     audio_utils::mutex& mutex() const final RETURN_CAPABILITY(audio_utils::EffectChain_Mutex) {
         return mMutex;
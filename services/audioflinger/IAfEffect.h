@@ -194,6 +194,14 @@ public:
     virtual bool updateState_l()
             REQUIRES(audio_utils::EffectChain_Mutex) EXCLUDES_EffectBase_Mutex = 0;
 
+    // Parameter an insert effect may support with EFFECT_CMD_GET_PARAM to report, as an
+    // int32_t value of 1, that its processing currently is the identity (e.g. an equalizer
+    // with all bands at 0 dB). The effect is then bypassed without calling process()
+    // until a command or a new configuration changes it.
+    static constexpr int32_t kParamNeutral = 0x7FFF0001;
+    // true if the effect is bypassed because it reported kParamNeutral.
+    virtual bool isNeutral() const = 0;
+
 private:
     virtual void process() = 0;
     virtual void reset_l() REQUIRES(audio_utils::EffectChain_Mutex) = 0;
@@ -235,6 +243,13 @@ public:
 
     virtual void process_l() REQUIRES(audio_utils::EffectChain_Mutex) = 0;
 
+    // process_l() is equivalent to processAudio_l() followed by updateEffectsState_l().
+    // processAudio_l() only touches the chain and its buffers: it can be called
+    // concurrently for chains which do not share an output buffer.
+    // updateEffectsState_l() must be called afterwards by the thread owning the chain.
+    virtual void processAudio_l() REQUIRES(audio_utils::EffectChain_Mutex) = 0;
+    virtual void updateEffectsState_l() REQUIRES(audio_utils::EffectChain_Mutex) = 0;
+
     virtual audio_utils::mutex& mutex() const RETURN_CAPABILITY(audio_utils::EffectChain_Mutex) = 0;
 
     virtual status_t createEffect(sp<IAfEffectModule>& effect, effect_descriptor_t* desc, int id,
@@ -55,6 +55,7 @@
 #include <fastpath/AutoPark.h>
 #include <media/AudioContainers.h>
 #include <media/AudioDeviceTypeAddr.h>
+#include <media/AudioMixer.h>
 #include <media/AudioParameter.h>
 #include <media/AudioResamplerPublic.h>
 #ifdef ADD_BATTERY_DATA
@@ -123,6 +124,7 @@ static inline T min(const T& a, const T& b)
 
 namespace android {
 
+using audioflinger::StageTimes;
 using audioflinger::SyncEvent;
 using media::IEffectClient;
 using content::AttributionSourceState;
@@ -130,6 +132,16 @@ using content::AttributionSourceState;
 // Keep in sync with java definition in media/java/android/media/AudioRecord.java
 static constexpr int32_t kMaxSharedAudioHistoryMs = 5000;
 
+// Capture history kept by every RecordThread so that record tracks can be created with a
+// start time in the past, see RecordThread::createRecordTrack_l(). 0 disables the history.
+static int32_t getRecordHistoryMs()
+{
+    static const int32_t historyMs = std::clamp(
+            property_get_int32("af.record_history_ms", 0 /* default_value */),
+            0, kMaxSharedAudioHistoryMs);
+    return historyMs;
+}
+
 // retry counts for buffer fill timeout
 // 50 * ~20msecs = 1 second
 static const int8_t kMaxTrackRetries = 50;
@@ -634,6 +646,8 @@ ThreadBase::ThreadBase(const sp<IAfThreadCallback>& afThreadCallback, audio_io_h
         mThreadMetrics(std::string(AMEDIAMETRICS_KEY_PREFIX_AUDIO_THREAD) + std::to_string(id),
                isOut),
         mIsOut(isOut),
+        mCpuStatsPeriodNs(property_get_int32("af.thread.cpu_stats_period_sec",
+                0 /* default_value */) * NANOS_PER_SECOND),
         // mSampleRate, mFrameCount, mChannelMask, mChannelCount, mFrameSize, mFormat, mBufferSize
         // are set by PlaybackThread::readOutputParameters_l() or
         // RecordThread::readInputParameters_l()
@@ -2093,9 +2107,38 @@ NO_THREAD_SAFETY_ANALYSIS
                         mMonopipePipeDepthStats.getStdDev());
     }
 
+    addStatistics(item.get());
     item->selfrecord();
 }
 
+void ThreadBase::sampleCpuStats()
+{
+    if (mCpuStatsPeriodNs <= 0) {
+        return;
+    }
+    mThreadCpuStats.sample();
+    // elapsed() is expensive, so don't call it every loop
+    if ((mThreadCpuStats.samples() & 127) != 0) {
+        return;
+    }
+    const int64_t elapsedNs = mThreadCpuStats.elapsed();
+    if (elapsedNs < mCpuStatsPeriodNs) {
+        return;
+    }
+    const int64_t cpuNs = mThreadCpuStats.cpuNs();
+    std::string residency;
+    for (int cpu = 0; cpu < ThreadCpuStats::MAX_CPU && cpuNs > 0; ++cpu) {
+        const int64_t ns = mThreadCpuStats.cpuNs(cpu);
+        if (ns == 0) continue;
+        if (!residency.empty()) residency.append("|");
+        residency.append(std::to_string(cpu)).append(":")
+                .append(std::to_string(ns * 100 / cpuNs));
+    }
+    mThreadMetrics.logCpuStats(elapsedNs, cpuNs, mThreadCpuStats.migrations(),
+            mThreadCpuStats.meanMHz(), residency);
+    mThreadCpuStats.reset();
+}
+
 product_strategy_t ThreadBase::getStrategyForStream(audio_stream_type_t stream) const
 {
     if (!mAfThreadCallback->isAudioPolicyReady()) {
@@ -2193,6 +2236,14 @@ PlaybackThread::PlaybackThread(const sp<IAfThreadCallback>& afThreadCallback,
         mMixerChannelMask = mixerConfig->channel_mask;
     }
 
+    if (type == MIXER || type == SPATIALIZER) {
+        // Number of worker threads processing the effect chains of different sessions
+        // concurrently with the thread loop, 0 to process all effect chains serially.
+        mParallelEffectWorkers = (size_t)std::clamp(
+                property_get_int32("af.effect.parallel_workers", 0 /* default_value */),
+                0, (int32_t)kMaxParallelEffectWorkers);
+    }
+
     readOutputParameters_l();
 
     if (mType != SPATIALIZER
@@ -2350,6 +2401,10 @@ void PlaybackThread::dumpInternals_l(int fd, const Vector<String16>& args)
     dprintf(fd, "  Suspend count: %d\n", (int32_t)mSuspended);
     dprintf(fd, "  Fast track availMask=%#x\n", mFastTrackAvailMask);
     dprintf(fd, "  Standby delay ns=%lld\n", (long long)mStandbyDelayNs);
+    if (mParallelEffectWorkers > 0) {
+        dprintf(fd, "  Parallel effect workers: %zu, parallel sessions: %zu\n",
+                mParallelEffectWorkers, mParallelEffectOutputs.size());
+    }
     AudioStreamOut *output = mOutput;
     audio_output_flags_t flags = output != NULL ? output->flags : AUDIO_OUTPUT_FLAG_NONE;
     dprintf(fd, "  AudioStreamOut: %p flags %#x (%s)\n",
@@ -2359,12 +2414,31 @@ void PlaybackThread::dumpInternals_l(int fd, const Vector<String16>& args)
     if (mPipeSink.get() != nullptr) {
         dprintf(fd, "  PipeSink frames written: %lld\n", (long long)mPipeSink->framesWritten());
     }
+    const std::string stageTimes = mStageTimes.toString("    ");
+    if (!stageTimes.empty()) {
+        dprintf(fd, "  Thread loop stage times (last %zu cycles):\n%s",
+                StageTimes::kSamples, stageTimes.c_str());
+    }
     if (output != nullptr) {
         dprintf(fd, "  Hal stream dump:\n");
         (void)output->stream->dump(fd, args);
     }
 }
 
+void PlaybackThread::addStatistics(mediametrics::Item* item)
+{
+    for (size_t i = 0; i < StageTimes::STAGE_COUNT; ++i) {
+        const auto stage = (StageTimes::Stage)i;
+        const StageTimes::Percentiles p = mStageTimes.getPercentiles(stage);
+        if (p.count == 0) continue;
+        const std::string key = std::string(MM_PREFIX "stageTimeMs.")
+                + StageTimes::stageToString(stage);
+        item->setDouble((key + ".p50").c_str(), p.p50Ns * 1e-6);
+        item->setDouble((key + ".p99").c_str(), p.p99Ns * 1e-6);
+        item->setDouble((key + ".max").c_str(), p.maxNs * 1e-6);
+    }
+}
+
 // PlaybackThread::createTrack_l() must be called with AudioFlinger::mutex() held
 sp<IAfTrack> PlaybackThread::createTrack_l(
         const sp<Client>& client,
@@ -2678,6 +2752,19 @@ sp<IAfTrack> PlaybackThread::createTrack_l(
         goto Exit;
     }
 
+    if (client != nullptr && audio_has_proportional_frames(format)) {
+        // Allocate the shared memory of the track (see TrackBase) before mutex() is taken,
+        // as the allocation may be slow and must not block the threadLoop.
+        const size_t frameSize = audio_bytes_per_frame(
+                audio_channel_count_from_out_mask(channelMask), format);
+        // roundup() rounds down for values above UINT_MAX / 2, the track then fails anyway.
+        const size_t bufferFrames = sharedBuffer == 0 ? roundup(frameCount) : 0;
+        if (frameSize != 0 && (sharedBuffer != 0 || bufferFrames >= frameCount)
+                && bufferFrames <= (SIZE_MAX - sizeof(audio_track_cblk_t)) / frameSize) {
+            client->preallocateCblk(sizeof(audio_track_cblk_t) + bufferFrames * frameSize);
+        }
+    }
+
     { // scope for mutex()
         audio_utils::lock_guard _l(mutex());
 
@@ -3801,6 +3888,9 @@ status_t PlaybackThread::addEffectChain_l(const sp<IAfEffectChain>& chain)
     audio_session_t session = chain->sessionId();
     sp<EffectBufferHalInterface> halInBuffer, halOutBuffer;
     float *buffer = nullptr; // only used for non global sessions
+    // the buffer the session chain accumulates into, if it can be processed in parallel.
+    void *parallelTarget = nullptr;
+    size_t parallelTargetSize = 0;
 
     if (mType == SPATIALIZER) {
         if (!audio_is_global_session(session)) {
@@ -3829,6 +3919,9 @@ status_t PlaybackThread::addEffectChain_l(const sp<IAfEffectChain>& chain)
             if (result != OK) return result;
 
             buffer = halInBuffer ? halInBuffer->audioBuffer()->f32 : buffer;
+            parallelTarget = isSessionSpatialized ? mEffectBuffer : mPostSpatializerBuffer;
+            parallelTargetSize =
+                    isSessionSpatialized ? mEffectBufferSize : mPostSpatializerBufferSize;
 
             ALOGV("addEffectChain_l() creating new input buffer %p session %d",
                     buffer, session);
@@ -3874,10 +3967,31 @@ status_t PlaybackThread::addEffectChain_l(const sp<IAfEffectChain>& chain)
                 buffer = halInBuffer ? halInBuffer->audioBuffer()->f32 : buffer;
                 ALOGV("addEffectChain_l() creating new input buffer %p session %d",
                         buffer, session);
+                if (mEffectBufferEnabled) {
+                    parallelTarget = mEffectBuffer;
+                    parallelTargetSize = mEffectBufferSize;
+                }
             }
         }
     }
 
+    // When effect chains are processed in parallel, a session chain accumulates into a
+    // private buffer instead of the shared one, and the thread loop accumulates the private
+    // buffers into the shared buffer after all chains have been processed.
+    mParallelEffectOutputs.erase(session);
+    if (mParallelEffectWorkers > 0 && parallelTarget != nullptr) {
+        sp<EffectBufferHalInterface> privateBuffer;
+        if (mAfThreadCallback->getEffectsFactoryHal()->allocateBuffer(
+                parallelTargetSize, &privateBuffer) == OK && privateBuffer != nullptr) {
+            memset(privateBuffer->audioBuffer()->raw, 0, parallelTargetSize);
+            mParallelEffectOutputs[session] = {privateBuffer, parallelTarget, parallelTargetSize};
+            halOutBuffer = privateBuffer;
+        } else {
+            ALOGW("%s: cannot allocate parallel output buffer, session %d processed serially",
+                    __func__, session);
+        }
+    }
+
     if (!audio_is_global_session(session)) {
         // Attach all tracks with same session ID to this chain.
         for (size_t i = 0; i < mTracks.size(); ++i) {
@@ -3933,6 +4047,24 @@ status_t PlaybackThread::addEffectChain_l(const sp<IAfEffectChain>& chain)
     return NO_ERROR;
 }
 
+void PlaybackThread::processParallelEffectChains(
+        const Vector<sp<IAfEffectChain>>& effectChains)
+NO_THREAD_SAFETY_ANALYSIS  // effect chains are locked by threadLoop()
+{
+    if (mParallelEffectChains.empty()) return;
+    const auto processAudio = [&](size_t i) NO_THREAD_SAFETY_ANALYSIS {
+        effectChains[mParallelEffectChains[i].mIndex]->processAudio_l();
+    };
+    if (mEffectWorkers == nullptr) {
+        for (size_t i = 0; i < mParallelEffectChains.size(); ++i) {
+            processAudio(i);
+        }
+        return;
+    }
+    // returns when all chains have been processed (join).
+    mEffectWorkers->run(mParallelEffectChains.size(), processAudio);
+}
+
 size_t PlaybackThread::removeEffectChain_l(const sp<IAfEffectChain>& chain)
 {
     audio_session_t session = chain->sessionId();
@@ -3942,6 +4074,7 @@ size_t PlaybackThread::removeEffectChain_l(const sp<IAfEffectChain>& chain)
     for (size_t i = 0; i < mEffectChains.size(); i++) {
         if (chain == mEffectChains[i]) {
             mEffectChains.removeAt(i);
+            mParallelEffectOutputs.erase(session);
             // detach all active tracks from the chain
             for (const sp<IAfTrack>& track : mActiveTracks) {
                 if (session == track->sessionId()) {
@@ -4005,6 +4138,33 @@ void PlaybackThread::detachAuxEffect_l(int effectId)
     }
 }
 
+bool PlaybackThread::finalizeSinkBuffer(const void* buffer, audio_format_t format)
+{
+    if (format != AUDIO_FORMAT_PCM_FLOAT || mChannelCount != FCC_2 || mHapticChannelCount > 0) {
+        return false;
+    }
+    // Balance is applied here if there is no FastMixer, see mBalance.
+    float target[FCC_2] = {1.f, 1.f};
+    if (!hasFastMixer()) {
+        const float balance = mMasterBalance.load();
+        mBalance.setBalance(balance);  // for dump
+        mBalance.computeStereoBalance(balance, &target[0], &target[1]);
+    }
+    const float gainInc[FCC_2] = {
+        (target[0] - mFinalizeGain[0]) / mNormalFrameCount,
+        (target[1] - mFinalizeGain[1]) / mNormalFrameCount,
+    };
+    if (!AudioMixer::finalizeStereo(mSinkBuffer, mFormat, static_cast<const float*>(buffer),
+            mNormalFrameCount, requireMonoBlend(), mFinalizeGain, gainInc,
+            HAL_FLOAT_SAMPLE_LIMIT)) {
+        return false;
+    }
+    // set exactly, the ramp may have accumulated rounding.
+    mFinalizeGain[0] = target[0];
+    mFinalizeGain[1] = target[1];
+    return true;
+}
+
 bool PlaybackThread::threadLoop()
 NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
 {
@@ -4090,6 +4250,12 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
 
     sendCheckOutputStageEffectsEvent();
 
+    // The effect workers are created here to inherit the scheduling priority of this thread.
+    if (mParallelEffectWorkers > 0 && mEffectWorkers == nullptr) {
+        mEffectWorkers = std::make_unique<afutils::ParallelWorkers>(
+                mParallelEffectWorkers, "AudioFx" + std::to_string(mId) + "_");
+    }
+
     // loopCount is used for statistics and diagnostics.
     for (int64_t loopCount = 0; !exitPending(); ++loopCount)
     {
@@ -4098,6 +4264,7 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
         mAfThreadCallback->requestLogMerge();
 
         cpuStats.sample(myName);
+        sampleCpuStats();
 
         Vector<sp<IAfEffectChain>> effectChains;
         audio_session_t activeHapticSessionId = AUDIO_SESSION_NONE;
@@ -4250,6 +4417,7 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                 }
             }
             // mMixerStatusIgnoringFastTracks is also updated internally
+            const int64_t prepareBeginNs = systemTime();
             mMixerStatus = prepareTracks_l(&tracksToRemove);
 
             mActiveTracks.updatePowerState_l(this);
@@ -4307,8 +4475,22 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                     }
                 }
             }
+
+            // Select the session chains which are processed in parallel,
+            // i.e. those which accumulate into a private output buffer.
+            mParallelEffectChains.clear();
+            if (!mParallelEffectOutputs.empty()) {
+                for (size_t i = 0; i < effectChains.size(); ++i) {
+                    const auto it = mParallelEffectOutputs.find(effectChains[i]->sessionId());
+                    if (it != mParallelEffectOutputs.end()) {
+                        mParallelEffectChains.push_back({i, it->second});
+                    }
+                }
+            }
+            mStageTimes.record(StageTimes::STAGE_PREPARE, systemTime() - prepareBeginNs);
         } // mutex() scope ends
 
+        int64_t stageBeginNs = systemTime();
         if (mBytesRemaining == 0) {
             mCurrentWriteLength = 0;
             if (mMixerStatus == MIXER_TRACKS_READY) {
@@ -4356,7 +4538,10 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
 
                 // Apply mono blending and balancing if the effect buffer is not valid. Otherwise,
                 // do these processes after effects are applied.
-                if (!mEffectBufferValid) {
+                // In the common stereo case these are done with the conversion in one pass.
+                const bool finalized = !mEffectBufferValid
+                        && finalizeSinkBuffer_l(mMixerBuffer, mMixerBufferFormat);
+                if (!mEffectBufferValid && !finalized) {
                     // mono blend occurs for mixer threads only (not direct or offloaded)
                     // and is handled here if we're going directly to the sink.
                     if (requireMonoBlend()) {
@@ -4374,8 +4559,10 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                     }
                 }
 
-                memcpy_by_audio_format(buffer, format, mMixerBuffer, mMixerBufferFormat,
-                        mNormalFrameCount * (mixerChannelCount + mHapticChannelCount));
+                if (!finalized) {
+                    memcpy_by_audio_format(buffer, format, mMixerBuffer, mMixerBufferFormat,
+                            mNormalFrameCount * (mixerChannelCount + mHapticChannelCount));
+                }
 
                 // If we're going directly to the sink and there are haptic channels,
                 // we should adjust channels as the sample data is partially interleaved
@@ -4399,10 +4586,22 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                 mBytesRemaining = 0;
             }
 
+            const int64_t mixEndNs = systemTime();
+            mStageTimes.record(StageTimes::STAGE_MIX, mixEndNs - stageBeginNs);
+            stageBeginNs = mixEndNs;
+
             // only process effects if we're going to write
             if (mSleepTimeUs == 0 && mType != OFFLOAD) {
-                for (size_t i = 0; i < effectChains.size(); i ++) {
-                    effectChains[i]->process_l();
+                processParallelEffectChains(effectChains);
+                for (size_t i = 0, j = 0; i < effectChains.size(); i ++) {
+                    // the audio of a parallel chain was processed by processParallelEffectChains()
+                    const bool parallel = j < mParallelEffectChains.size()
+                            && mParallelEffectChains[j].mIndex == i;
+                    if (parallel) {
+                        effectChains[i]->updateEffectsState_l();
+                    } else {
+                        effectChains[i]->process_l();
+                    }
                     // TODO: Write haptic data directly to sink buffer when mixing.
                     if (activeHapticSessionId != AUDIO_SESSION_NONE
                             && activeHapticSessionId == effectChains[i]->sessionId()) {
@@ -4424,6 +4623,15 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                                 (const uint8_t*)effectChains[i]->inBuffer() + audioBufferSize,
                                 AUDIO_FORMAT_PCM_FLOAT, mNormalFrameCount * mHapticChannelCount);
                     }
+                    if (parallel) {
+                        // accumulate the private output to the shared buffer in chain order,
+                        // before the global session chains which are processed last.
+                        const ParallelEffectOutput& output = mParallelEffectChains[j++].mOutput;
+                        float* const privateBuffer = output.mBuffer->audioBuffer()->f32;
+                        accumulate_float(static_cast<float*>(output.mTarget), privateBuffer,
+                                output.mSize / sizeof(float));
+                        memset(privateBuffer, 0, output.mSize);
+                    }
                 }
             }
         }
@@ -4444,12 +4652,15 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
         if (mEffectBufferValid && !mHasDataCopiedToSinkBuffer) {
             //ALOGV("writing effect buffer to sink buffer format %#x", mFormat);
             void *effectBuffer = (mType == SPATIALIZER) ? mPostSpatializerBuffer : mEffectBuffer;
-            if (requireMonoBlend()) {
+            // In the common stereo case mono blend, balance and the conversion to the sink
+            // format are done in one pass.
+            const bool finalized = finalizeSinkBuffer_l(effectBuffer, mEffectBufferFormat);
+            if (!finalized && requireMonoBlend()) {
                 mono_blend(effectBuffer, mEffectBufferFormat, mChannelCount, mNormalFrameCount,
                            true /*limit*/);
             }
 
-            if (!hasFastMixer()) {
+            if (!finalized && !hasFastMixer()) {
                 // Balance must take effect after mono conversion.
                 // We do it here if there is no FastMixer.
                 // mBalance detects zero balance within the class for speed (not needed here).
@@ -4475,11 +4686,10 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                                        mNormalFrameCount * mHapticChannelCount);
             }
             const size_t framesToCopy = mNormalFrameCount * (mChannelCount + mHapticChannelCount);
-            if (mFormat == AUDIO_FORMAT_PCM_FLOAT &&
+            if (finalized) {
+                ; // already in mSinkBuffer
+            } else if (mFormat == AUDIO_FORMAT_PCM_FLOAT &&
                     mEffectBufferFormat == AUDIO_FORMAT_PCM_FLOAT) {
-                // Clamp PCM float values more than this distance from 0 to insulate
-                // a HAL which doesn't handle NaN correctly.
-                static constexpr float HAL_FLOAT_SAMPLE_LIMIT = 2.0f;
                 memcpy_to_float_from_float_with_clamping(static_cast<float*>(mSinkBuffer),
                         static_cast<const float*>(effectBuffer),
                         framesToCopy, HAL_FLOAT_SAMPLE_LIMIT /* absMax */);
@@ -4499,6 +4709,9 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
 
         // enable changes in effect chain
         unlockEffectChains(effectChains);
+        if (!effectChains.isEmpty()) {
+            mStageTimes.record(StageTimes::STAGE_EFFECTS, systemTime() - stageBeginNs);
+        }
 
         if (!metadataUpdate.playbackMetadataUpdate.empty()) {
             mAfThreadCallback->getMelReporter()->updateMetadataForCsd(id(),
@@ -4516,6 +4729,7 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                     const int64_t lastIoBeginNs = systemTime();
                     ret = threadLoop_write();
                     const int64_t lastIoEndNs = systemTime();
+                    mStageTimes.record(StageTimes::STAGE_WRITE, lastIoEndNs - lastIoBeginNs);
                     if (ret < 0) {
                         mBytesRemaining = 0;
                     } else if (ret > 0) {
@@ -4610,7 +4824,10 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                         if ((signed)mHalfBufferMs >= throttleMs && throttleMs > 0) {
                             mThreadMetrics.logThrottleMs((double)throttleMs);
 
+                            const int64_t throttleBeginNs = systemTime();
                             usleep(throttleMs * 1000);
+                            mStageTimes.record(StageTimes::STAGE_SLEEP,
+                                    systemTime() - throttleBeginNs);
                             // notify of throttle start on verbose log
                             ALOGV_IF(mThreadThrottleEndMs == mThreadThrottleTimeMs,
                                     "mixer(%p) throttle begin:"
@@ -4640,6 +4857,7 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
 
             } else {
                 ATRACE_BEGIN("sleep");
+                const int64_t sleepBeginNs = systemTime();
                 audio_utils::unique_lock _l(mutex());
                 // suspended requires accurate metering of sleep time.
                 if (isSuspended()) {
@@ -4667,6 +4885,7 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                 if (!mSignalPending && mConfigEvents.isEmpty() && !exitPending()) {
                     mWaitWorkCV.wait_for(_l, std::chrono::microseconds(mSleepTimeUs));
                 }
+                mStageTimes.record(StageTimes::STAGE_SLEEP, systemTime() - sleepBeginNs);
                 ATRACE_END();
             }
         }
@@ -5126,7 +5345,9 @@ MixerThread::MixerThread(const sp<IAfThreadCallback>& afThreadCallback, AudioStr
         // mFastMixer below
         mBluetoothLatencyModesEnabled(false),
         mFastMixerFutex(0),
-        mMasterMono(false)
+        mMasterMono(false),
+        mPipelinedWrite(type == MIXER
+                && property_get_bool("af.mixer.pipelined_write", false /* default_value */))
         // mOutputSink below
         // mPipeSink below
         // mNormalSink below
@@ -5258,6 +5479,8 @@ MixerThread::MixerThread(const sp<IAfThreadCallback>& afThreadCallback, AudioStr
         state->mColdFutexAddr = &mFastMixerFutex;
         state->mColdGen++;
         state->mDumpState = &mFastMixerDumpState;
+        state->mAdaptiveScheduling =
+                property_get_bool("af.fast_mixer.adaptive_scheduling", false /* default_value */);
         mFastMixerNBLogWriter = afThreadCallback->newWriter_l(kFastMixerLogSize, "FastMixer");
         state->mNBLogWriter = mFastMixerNBLogWriter.get();
         sq->end();
@@ -5362,10 +5585,21 @@ uint32_t MixerThread::correctLatency_l(uint32_t latency) const
     if (mFastMixer != 0) {
         MonoPipe *pipe = (MonoPipe *)mPipeSink.get();
         latency += (pipe->getAvgFrames() * 1000) / mSampleRate;
+    } else if (mPipelinedSink != nullptr) {
+        // one mix buffer may be in flight in the writer thread.
+        latency += (mNormalFrameCount * 1000) / mSampleRate;
     }
     return latency;
 }
 
+void MixerThread::waitPipelinedWrite()
+{
+    if (mPipelinedSink != nullptr) {
+        const status_t status = mPipelinedSink->waitIdle();
+        ALOGW_IF(status != OK, "%s: pipelined write failed: %d", __func__, status);
+    }
+}
+
 ssize_t MixerThread::threadLoop_write()
 {
     // FIXME we should only do one push per cycle; confirm this is true
@@ -5405,12 +5639,22 @@ ssize_t MixerThread::threadLoop_write()
         } else {
             sq->end(false /*didModify*/);
         }
+    } else if (mPipelinedWrite && mNormalSink != 0 && mNormalSink == mOutputSink) {
+        if (mPipelinedSink == nullptr) {
+            // Created by the threadLoop so that the writer thread inherits its priority.
+            mPipelinedSink = sp<afutils::PipelinedSink>::make(mOutputSink,
+                    mNormalFrameCount, "AudioOut" + std::to_string(mId) + "W");
+        }
+        mNormalSink = mPipelinedSink;
     }
     return PlaybackThread::threadLoop_write();
 }
 
 void MixerThread::threadLoop_standby()
 {
+    // the stream must not be written while it is put in standby.
+    waitPipelinedWrite();
+
     // Idle the fast mixer if it's currently running
     if (mFastMixer != 0) {
         FastMixerStateQueue *sq = mFastMixer->sq();
@@ -5516,6 +5760,13 @@ void MixerThread::threadLoop_mix()
 
 }
 
+void MixerThread::threadLoop_exit()
+{
+    // the stream may be closed once the threadLoop has exited.
+    waitPipelinedWrite();
+    PlaybackThread::threadLoop_exit();
+}
+
 void MixerThread::threadLoop_sleepTime()
 {
     // If no tracks are ready, sleep once for the duration of an output
@@ -5590,6 +5841,7 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
     // counts only _active_ fast tracks
     size_t fastTracks = 0;
     uint32_t resetMask = 0; // bit mask of fast tracks that need to be reset
+    uint32_t hapticDeltaMask = 0; // bit mask of active fast tracks with new haptic parameters
 
     float masterVolume = mMasterVolume;
     bool masterMute = mMasterMute;
@@ -5873,9 +6125,21 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
                 // Avoids a misleading display in dumpsys
                 track->fastTrackUnderruns().mBitFields.mMostRecent = UNDERRUN_FULL;
             }
-            if (fastTrack->mHapticPlaybackEnabled != track->getHapticPlaybackEnabled()) {
+            const float hapticMaxAmplitude = track->getHapticMaxAmplitude();
+            if (fastTrack->mHapticPlaybackEnabled != track->getHapticPlaybackEnabled()
+                    || fastTrack->mHapticScale != track->getHapticScale()
+                    || (fastTrack->mHapticMaxAmplitude != hapticMaxAmplitude
+                            && !(isnan(fastTrack->mHapticMaxAmplitude)
+                                    && isnan(hapticMaxAmplitude)))) {
                 fastTrack->mHapticPlaybackEnabled = track->getHapticPlaybackEnabled();
-                didModify = true;
+                fastTrack->mHapticScale = track->getHapticScale();
+                fastTrack->mHapticMaxAmplitude = hapticMaxAmplitude;
+                if (isActive) {
+                    // sent to the FastMixer below, as a delta if possible.
+                    hapticDeltaMask |= 1 << j;
+                } else {
+                    didModify = true;
+                }
             }
             continue;
         }
@@ -6272,6 +6536,36 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
         }
     }
 
+    // Send the new haptic parameters of active fast tracks as deltas, which avoids pushing
+    // a complete FastMixer state.  This is only possible if the FastMixer has acknowledged
+    // the latest state, otherwise it may not have configured the track generation yet.
+    while (hapticDeltaMask != 0) {
+        const int j = __builtin_ctz(hapticDeltaMask);
+        hapticDeltaMask &= ~(1 << j);
+        FastTrack *fastTrack = &state->mFastTracks[j];
+        if (!didModify && !sq->isDirty() && sq->isAcked()) {
+            const FastTrackDelta delta{
+                .mIndex = (unsigned)j,
+                .mGeneration = fastTrack->mGeneration,
+                .mHapticPlaybackEnabled = fastTrack->mHapticPlaybackEnabled,
+                .mHapticScale = fastTrack->mHapticScale,
+                .mHapticMaxAmplitude = fastTrack->mHapticMaxAmplitude,
+            };
+            if (mFastMixer->dq()->enqueue(delta)) {
+#ifdef STATE_QUEUE_DUMP
+                mStateQueueMutatorDump.mDeltas++;
+#endif
+                continue;
+            }
+#ifdef STATE_QUEUE_DUMP
+            mStateQueueMutatorDump.mDeltaOverflows++;
+#endif
+        }
+        // The FastMixer reconfigures a modified track only if its generation has changed.
+        fastTrack->mGeneration++;
+        didModify = true;
+    }
+
     // Push the new FastMixer state if necessary
     [[maybe_unused]] bool pauseAudioWatchdog = false;
     if (didModify) {
@@ -6451,6 +6745,7 @@ bool MixerThread::checkForNewParameter_l(const String8& keyValuePair,
     status = NO_ERROR;
 
     AutoPark<FastMixer> park(mFastMixer);
+    waitPipelinedWrite();
 
     AudioParameter param = AudioParameter(keyValuePair);
     int value;
@@ -6501,6 +6796,11 @@ bool MixerThread::checkForNewParameter_l(const String8& keyValuePair,
         }
         if (status == NO_ERROR && reconfig) {
             readOutputParameters_l();
+            if (mPipelinedSink != nullptr) {
+                // recreated on the next write with the new buffer size.
+                mNormalSink = mOutputSink;
+                mPipelinedSink.clear();
+            }
             delete mAudioMixer;
             mAudioMixer = new AudioMixer(mNormalFrameCount, mSampleRate);
             for (const auto &track : mTracks) {
@@ -6523,6 +6823,20 @@ bool MixerThread::checkForNewParameter_l(const String8& keyValuePair,
     return reconfig;
 }
 
+void MixerThread::addStatistics(mediametrics::Item* item)
+{
+    PlaybackThread::addStatistics(item);
+    if (!hasFastMixer()) {
+        return;
+    }
+    // The fast mixer dump state may be updated concurrently; each field is read once,
+    // and a slightly stale or inconsistent snapshot is acceptable for statistics.
+    item->setInt32(MM_PREFIX "fastMixer.deadlineMisses",
+            (int32_t)mFastMixerDumpState.mDeadlineMisses);
+    item->setInt32(MM_PREFIX "fastMixer.underruns", (int32_t)mFastMixerDumpState.mUnderruns);
+    item->setDouble(MM_PREFIX "fastMixer.cycleJitterMs",
+            mFastMixerDumpState.mCycleJitterNs * 1e-6);
+}
 
 void MixerThread::dumpInternals_l(int fd, const Vector<String16>& args)
 {
@@ -6563,6 +6877,11 @@ void MixerThread::dumpInternals_l(int fd, const Vector<String16>& args)
     } else {
         dprintf(fd, "  No FastMixer\n");
     }
+    if (mPipelinedSink != nullptr) {
+        dprintf(fd, "  Pipelined write thread tid=%d\n", mPipelinedSink->getTid());
+    } else {
+        dprintf(fd, "  Pipelined write: %s\n", mPipelinedWrite ? "enabled, idle" : "disabled");
+    }
 
      dprintf(fd, "Bluetooth latency modes are %senabled\n",
             mBluetoothLatencyModesEnabled ? "" : "not ");
@@ -8261,6 +8580,8 @@ RecordThread::RecordThread(const sp<IAfThreadCallback>& afThreadCallback,
 #endif
 
         mFastTrackAvail = true;
+        mFastCaptureConversionEnabled =
+                property_get_bool("af.fast_capture_conversion", false /* default_value */);
     }
 #ifdef TEE_SINK
     mTee.set(mInputSource->format(), NBAIO_Tee::TEE_FLAG_INPUT_THREAD);
@@ -8332,6 +8653,8 @@ reacquire_wakelock:
 
     // loop while there is work to do
     for (int64_t loopCount = 0;; ++loopCount) {  // loopCount used for statistics tracking
+        sampleCpuStats();
+
         // Note: these sp<> are released at the end of the for loop outside of the mutex() lock.
         sp<IAfRecordTrack> activeTrack;
         std::vector<sp<IAfRecordTrack>> oldActiveTracks;
@@ -8519,8 +8842,19 @@ reacquire_wakelock:
             effectChains[i]->process_l();
         }
 
+        // Let fast capture convert the input for the only normal active track,
+        // so that its latency does not depend on the scheduling of this thread.
+        sp<IAfRecordTrack> convertedTrack;
+        if (mFastCaptureConversionEnabled && activeTracks.size() == 1
+                && canConvertInFastCapture(activeTracks[0])) {
+            convertedTrack = activeTracks[0];
+        }
+
         // Push a new fast capture state if fast capture is not already running, or cblk change
         if (mFastCapture != 0) {
+            // released after the state is pushed
+            std::unique_ptr<RecordBufferConverter> oldConverter;
+            sp<NBAIO_Sink> oldConvertedSink;
             FastCaptureStateQueue *sq = mFastCapture->sq();
             FastCaptureState *state = sq->begin();
             bool didModify = false;
@@ -8563,6 +8897,17 @@ reacquire_wakelock:
                 state->mSilenceCapture = silenceFastCapture;
                 didModify = true;
             }
+            if (convertedTrack != mFastCaptureConvertedTrack) {
+                setFastCaptureConversion(convertedTrack, &oldConverter, &oldConvertedSink);
+                state->mConverter = mFastCaptureConverter.get();
+                state->mConvertedSink = mConvertedPipeSink.get();
+                state->mConverterGen++;
+                // block until acked if fast capture may be using the previous converter
+                if (oldConverter != nullptr) {
+                    block = FastCaptureStateQueue::BLOCK_UNTIL_ACKED;
+                }
+                didModify = true;
+            }
             sq->end(didModify);
             if (didModify) {
                 sq->push(block);
@@ -8722,7 +9067,16 @@ reacquire_wakelock:
         }
         mRsmpInRear = audio_utils::safe_add_overflow(mRsmpInRear, (int32_t)framesRead);
 
+        if (getRecordHistoryMs() != 0) {
+            audio_utils::lock_guard _l(mutex());
+            if (mFrameTimeIndex != nullptr) {
+                mFrameTimeIndex->add(mFramesRead, lastIoEndNs);
+                mFrameTimeIndexRear = mRsmpInRear;
+            }
+        }
+
         size = activeTracks.size();
+        mSharedConversionCount = 0;
 
         // loop over each active track
         for (size_t i = 0; i < size; i++) {
@@ -8733,6 +9087,10 @@ reacquire_wakelock:
                 continue;
             }
 
+            // the input of this track was already converted by FastCapture
+            const bool convertedByFastCapture = activeTrack == mFastCaptureConvertedTrack
+                    && mConvertedPipeSource != 0;
+
             // TODO: This code probably should be moved to RecordTrack.
             // TODO: Update the activeTrack buffer converter in case of reconfigure.
 
@@ -8755,6 +9113,14 @@ reacquire_wakelock:
                 bool hasOverrun;
                 size_t framesIn;
                 activeTrack->resamplerBufferProvider()->sync(&framesIn, &hasOverrun);
+                if (convertedByFastCapture) {
+                    // The input is not used: skip it, and use the converted frames instead.
+                    // A full pipe means fast capture dropped frames the client did not read.
+                    activeTrack->resamplerBufferProvider()->setFront(mRsmpInRear);
+                    const ssize_t availableToRead = mConvertedPipeSource->availableToRead();
+                    framesIn = availableToRead > 0 ? availableToRead : 0;
+                    hasOverrun = framesIn >= mConvertedPipeFramesP2;
+                }
                 if (hasOverrun) {
                     overrun = OVERRUN_TRUE;
                 }
@@ -8766,13 +9132,19 @@ reacquire_wakelock:
                 // from framesIn.
                 // This isn't strictly necessary but helps limit buffer resizing in
                 // RecordBufferConverter.  TODO: remove when no longer needed.
-                if (audio_is_linear_pcm(activeTrack->format())) {
+                if (convertedByFastCapture) {
+                    framesOut = min(framesOut, framesIn);
+                } else if (audio_is_linear_pcm(activeTrack->format())) {
                     framesOut = min(framesOut,
                             destinationFramesPossible(
                                     framesIn, mSampleRate, activeTrack->sampleRate()));
                 }
 
-                if (activeTrack->isDirect()) {
+                if (convertedByFastCapture) {
+                    const ssize_t framesRead =
+                            mConvertedPipeSource->read(activeTrack->sinkBuffer().raw, framesOut);
+                    framesOut = framesRead > 0 ? framesRead : 0;
+                } else if (activeTrack->isDirect()) {
                     // No RecordBufferConverter used for direct streams. Pass
                     // straight from RecordThread buffer to RecordTrack buffer.
                     AudioBufferProvider::Buffer buffer;
@@ -8795,10 +9167,7 @@ reacquire_wakelock:
                 } else {
                     // process frames from the RecordThread buffer provider to the RecordTrack
                     // buffer
-                    framesOut = activeTrack->recordBufferConverter()->convert(
-                            activeTrack->sinkBuffer().raw,
-                            activeTrack->resamplerBufferProvider(),
-                            framesOut);
+                    framesOut = convertTrackBuffer(activeTracks, i, framesOut);
                 }
 
                 if (framesOut > 0 && (overrun == OVERRUN_UNKNOWN)) {
@@ -8914,6 +9283,15 @@ void RecordThread::inputStandBy()
             state->mColdFutexAddr = &mFastCaptureFutex;
             state->mColdGen++;
             mFastCaptureFutex = 0;
+            // the conversion is set up again for the active track when leaving standby
+            std::unique_ptr<RecordBufferConverter> oldConverter;
+            sp<NBAIO_Sink> oldConvertedSink;
+            if (mFastCaptureConvertedTrack != 0) {
+                setFastCaptureConversion(nullptr, &oldConverter, &oldConvertedSink);
+                state->mConverter = nullptr;
+                state->mConvertedSink = nullptr;
+                state->mConverterGen++;
+            }
             sq->end();
             // BLOCK_UNTIL_PUSHED would be insufficient, as we need it to stop doing I/O now
             sq->push(FastCaptureStateQueue::BLOCK_UNTIL_ACKED);
@@ -8959,7 +9337,8 @@ sp<IAfRecordTrack> RecordThread::createRecordTrack_l(
         pid_t tid,
         status_t *status,
         audio_port_handle_t portId,
-        int32_t maxSharedAudioHistoryMs)
+        int32_t maxSharedAudioHistoryMs,
+        int64_t startTimeNs)
 {
     size_t frameCount = *pFrameCount;
     size_t notificationFrameCount = *pNotificationFrameCount;
@@ -8992,6 +9371,11 @@ sp<IAfRecordTrack> RecordThread::createRecordTrack_l(
             goto Exit;
         }
     }
+    // like shared audio history, reading past audio requires the hotword permission
+    if (startTimeNs != 0 && !captureHotwordAllowed(attributionSource)) {
+        lStatus = PERMISSION_DENIED;
+        goto Exit;
+    }
     if (*pSampleRate == 0) {
         *pSampleRate = mSampleRate;
     }
@@ -9013,7 +9397,7 @@ sp<IAfRecordTrack> RecordThread::createRecordTrack_l(
 
     // client expresses a preference for FAST and no access to audio history,
     // but we get the final say
-    if (*flags & AUDIO_INPUT_FLAG_FAST && maxSharedAudioHistoryMs == 0) {
+    if (*flags & AUDIO_INPUT_FLAG_FAST && maxSharedAudioHistoryMs == 0 && startTimeNs == 0) {
       if (
             // we formerly checked for a callback handler (non-0 tid),
             // but that is no longer required for TRANSFER_OBTAIN mode
@@ -9107,6 +9491,8 @@ sp<IAfRecordTrack> RecordThread::createRecordTrack_l(
                 && mSharedAudioSessionId == sessionId
                 && captureHotwordAllowed(attributionSource)) {
             startFrames = mSharedAudioStartFrames;
+        } else if (startTimeNs != 0) {
+            startFrames = getHistoryStartFrames_l(startTimeNs);
         }
 
         track = IAfRecordTrack::create(this, client, attr, sampleRate,
@@ -9992,6 +10378,120 @@ void RecordThread::updateOutDevices(const DeviceDescriptorBaseVector& outDevices
     }
 }
 
+size_t RecordThread::convertTrackBuffer(
+        const Vector<sp<IAfRecordTrack>>& activeTracks, size_t index, size_t frames)
+{
+    const sp<IAfRecordTrack>& track = activeTracks[index];
+    RecordBufferConverter* const converter = track->recordBufferConverter();
+    ResamplerBufferProvider* const provider = track->resamplerBufferProvider();
+    void* const dst = track->sinkBuffer().raw;
+    const int32_t front = provider->getFront();
+
+    // A previous track with the same conversion read from the same position: its output
+    // is what this track would produce, so just copy it and skip the same input.
+    for (size_t i = 0; i < mSharedConversionCount; ++i) {
+        const SharedConversion& shared = mSharedConversions[i];
+        if (shared.frontBefore == front && shared.frames <= frames
+                && shared.converter->hasSameConversion(*converter)) {
+            memcpy(dst, shared.buffer.data(), shared.frames * track->frameSize());
+            provider->setFront(shared.frontAfter);
+            converter->bypass();
+            return shared.frames;
+        }
+    }
+
+    // Keep the output only if a following track may reuse it.
+    bool reusable = false;
+    for (size_t i = index + 1; i < activeTracks.size() && !reusable; ++i) {
+        const sp<IAfRecordTrack>& other = activeTracks[i];
+        reusable = !other->isFastTrack() && !other->isDirect()
+                && other->recordBufferConverter() != nullptr
+                && other->recordBufferConverter()->hasSameConversion(*converter);
+    }
+    if (!reusable) {
+        return converter->convert(dst, provider, frames);
+    }
+
+    // Convert to a buffer of the thread rather than reusing the sink buffer,
+    // which is shared with the client of the track.
+    if (mSharedConversionCount == mSharedConversions.size()) {
+        mSharedConversions.emplace_back();
+    }
+    SharedConversion& shared = mSharedConversions[mSharedConversionCount++];
+    const size_t bytes = frames * track->frameSize();
+    if (shared.buffer.size() < bytes) {
+        shared.buffer.resize(bytes);
+    }
+    shared.converter = converter;
+    shared.frontBefore = front;
+    shared.frames = converter->convert(shared.buffer.data(), provider, frames);
+    shared.frontAfter = provider->getFront();
+    memcpy(dst, shared.buffer.data(), shared.frames * track->frameSize());
+    return shared.frames;
+}
+
+bool RecordThread::canConvertInFastCapture(const sp<IAfRecordTrack>& track) const
+{
+    // Format and channel conversions are cheap, only resampling is worth moving to fast capture.
+    return mFastCapture != 0
+            && !track->isFastTrack()
+            && !track->isDirect()
+            && !track->isPatchTrack()
+            && track->recordBufferConverter() != nullptr
+            && audio_is_linear_pcm(mFormat)
+            && audio_is_linear_pcm(track->format())
+            && track->sampleRate() != mSampleRate
+            && mMaxSharedAudioHistoryMs == 0;
+}
+
+void RecordThread::setFastCaptureConversion(const sp<IAfRecordTrack>& track,
+        std::unique_ptr<RecordBufferConverter>* oldConverter, sp<NBAIO_Sink>* oldSink)
+{
+    *oldConverter = std::move(mFastCaptureConverter);
+    *oldSink = std::move(mConvertedPipeSink);
+    mConvertedPipeSource.clear();
+    mConvertedPipeFramesP2 = 0;
+    mFastCaptureConvertedTrack.clear();
+    if (track == 0) {
+        return;
+    }
+
+    auto converter = std::make_unique<RecordBufferConverter>(
+            mChannelMask, mFormat, mSampleRate,
+            track->channelMask(), track->format(), track->sampleRate());
+    if (converter->initCheck() != NO_ERROR) {
+        ALOGW("%s: cannot convert for track %d in fast capture", __func__, track->id());
+        mFastCaptureConvertedTrack = track;  // don't retry, the track converts its input
+        return;
+    }
+    // Same depth as the fast capture pipe, which is read by this thread at the same rate.
+    const NBAIO_Format format = Format_from_SR_C(track->sampleRate(),
+            audio_channel_count_from_in_mask(track->channelMask()), track->format());
+    MonoPipe *pipe = new MonoPipe(
+            4 * FMS_20 * track->sampleRate() / 1000, format, false /*writeCanBlock*/);
+    const NBAIO_Format offers[1] = {format};
+    size_t numCounterOffers = 0;
+    [[maybe_unused]] ssize_t index = pipe->negotiate(offers, std::size(offers),
+            nullptr /* counterOffers */, numCounterOffers);
+    ALOG_ASSERT(index == 0);
+    MonoPipeReader *pipeReader = new MonoPipeReader(pipe);
+    numCounterOffers = 0;
+    index = pipeReader->negotiate(offers, std::size(offers),
+            nullptr /* counterOffers */, numCounterOffers);
+    ALOG_ASSERT(index == 0);
+
+    // The track now reads the converted frames from the pipe; start them from the current input,
+    // and reset its own converter for when it stops reading from the pipe.
+    track->resamplerBufferProvider()->setFront(mRsmpInRear);
+    track->recordBufferConverter()->bypass();
+
+    mFastCaptureConverter = std::move(converter);
+    mConvertedPipeSink = pipe;
+    mConvertedPipeSource = pipeReader;
+    mConvertedPipeFramesP2 = pipe->maxFrames();
+    mFastCaptureConvertedTrack = track;
+}
+
 int32_t RecordThread::getOldestFront_l()
 {
     if (mTracks.size() == 0) {
@@ -10037,6 +10537,8 @@ void RecordThread::resizeInputBuffer_l(int32_t maxSharedAudioHistoryMs)
     //
     // Note this is independent of the maximum downsampling ratio permitted for capture.
     size_t minRsmpInFrames = mFrameCount * 7;
+    // Also keep the capture history configured for the device, if any.
+    minRsmpInFrames = max(minRsmpInFrames, (size_t)getRecordHistoryMs() * mSampleRate / 1000);
 
     // maxSharedAudioHistoryMs != 0 indicates a request to possibly make some part of the audio
     // capture history available to another client using the same session ID:
@@ -10117,6 +10619,31 @@ void RecordThread::resizeInputBuffer_l(int32_t maxSharedAudioHistoryMs)
     }
     free(mRsmpInBuffer);
     mRsmpInBuffer = rsmpInBuffer;
+
+    // Positions of the previous buffer do not map to the new one: restart the history.
+    if (getRecordHistoryMs() != 0) {
+        // HAL reads are at least half a HAL buffer, except for the rare short read.
+        mFrameTimeIndex = std::make_unique<audioflinger::FrameTimeIndex>(
+                2 * mRsmpInFrames / mFrameCount + 1);
+        mFrameTimeIndexRear = mRsmpInRear;
+    }
+}
+
+int32_t RecordThread::getHistoryStartFrames_l(int64_t startTimeNs) const
+{
+    if (mFrameTimeIndex == nullptr) {
+        return -1;
+    }
+    const int64_t startFrame = mFrameTimeIndex->getFrameAt(startTimeNs, mSampleRate);
+    if (startFrame < 0) {
+        return -1;
+    }
+    // ResamplerBufferProvider::reset() limits the start to the frames kept in mRsmpInBuffer.
+    const int64_t delta = std::min(mFrameTimeIndex->getLastFrame() - startFrame,
+            (int64_t)mRsmpInFrames);
+    ALOGV("%s startTimeNs %lld starts %lld frames in the past",
+            __func__, (long long)startTimeNs, (long long)delta);
+    return audio_utils::safe_sub_overflow(mFrameTimeIndexRear, (int32_t)delta);
 }
 
 void RecordThread::addPatchTrack(const sp<IAfPatchRecord>& record)
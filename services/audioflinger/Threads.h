@@ -26,18 +26,27 @@
 #include <android/os/IPowerManager.h>
 #include <afutils/AudioWatchdog.h>
 #include <afutils/NBAIO_Tee.h>
+#include <afutils/ParallelWorkers.h>
+#include <afutils/PipelinedSink.h>
 #include <audio_utils/Balance.h>
 #include <audio_utils/SimpleLog.h>
+#include <cpustats/ThreadCpuStats.h>
 #include <datapath/ThreadMetrics.h>
 #include <fastpath/FastCapture.h>
 #include <fastpath/FastMixer.h>
 #include <mediautils/Synchronization.h>
 #include <mediautils/ThreadSnapshot.h>
+#include <timing/FrameTimeIndex.h>
 #include <timing/MonotonicFrameCounter.h>
+#include <timing/StageTimes.h>
 #include <utils/Log.h>
 
 namespace android {
 
+namespace mediametrics {
+class Item;
+}
+
 class AsyncCallbackThread;
 
 class ThreadBase : public virtual IAfThreadBase, public Thread {
@@ -537,6 +546,10 @@ public:
     void sendStatistics(bool force) final
             REQUIRES(ThreadBase_ThreadLoop) EXCLUDES_ThreadBase_Mutex;
 
+                // called once per loop by the threadLoop to sample the thread CPU usage,
+                // and to deliver a summary to mediametrics every mCpuStatsPeriodNs.
+                void sampleCpuStats() REQUIRES(ThreadBase_ThreadLoop) EXCLUDES_ThreadBase_Mutex;
+
     audio_utils::mutex& mutex() const final RETURN_CAPABILITY(audio_utils::ThreadBase_Mutex) {
         return mMutex;
     }
@@ -573,6 +586,10 @@ public:
 
 protected:
 
+                // add thread specific statistics to the item delivered by sendStatistics().
+    virtual void addStatistics(mediametrics::Item* /* item */)
+            REQUIRES(ThreadBase_ThreadLoop) {}
+
                 // entry describing an effect being suspended in mSuspendedSessions keyed vector
                 class SuspendedSessionDesc : public RefBase {
                 public:
@@ -672,6 +689,11 @@ protected:
                 ThreadMetrics           mThreadMetrics;
                 const bool              mIsOut;
 
+                // CPU time, CPU residency and CPU migrations of the threadLoop over the
+                // af.thread.cpu_stats_period_sec period, 0 (the default) disables sampling.
+                const int64_t           mCpuStatsPeriodNs;
+                ThreadCpuStats          mThreadCpuStats;  // only accessed by the threadLoop
+
     // mThreadBusy is checked under the ThreadBase_Mutex to ensure that
     // TrackHandle operations do not proceed while the ThreadBase is busy
     // with the track.  mThreadBusy is only true if the track is active.
@@ -949,6 +971,13 @@ protected:
     void removeTracks_l(const Vector<sp<IAfTrack>>& tracksToRemove) REQUIRES(mutex());
     status_t handleVoipVolume_l(float *volume) REQUIRES(mutex());
 
+    // Writes the stereo float mix or effect output to mSinkBuffer, applying mono blend
+    // and balance in the same pass as the clamping or conversion to the sink format.
+    // Returns false, without processing, if the configuration is not supported
+    // (channel count, haptic channels or format), then the separate passes are used.
+    bool finalizeSinkBuffer(const void* buffer, audio_format_t format)
+            REQUIRES(ThreadBase_ThreadLoop);
+
     // StreamOutHalInterfaceCallback implementation
     virtual     void        onWriteReady();
     virtual     void        onDrainReady();
@@ -985,6 +1014,10 @@ protected:
 
 
     void dumpInternals_l(int fd, const Vector<String16>& args) override REQUIRES(mutex());
+    void addStatistics(mediametrics::Item* item) override REQUIRES(ThreadBase_ThreadLoop);
+    // processes the audio of mParallelEffectChains concurrently, returns when all are done.
+    void processParallelEffectChains(const Vector<sp<IAfEffectChain>>& effectChains)
+            REQUIRES(ThreadBase_ThreadLoop);
     void dumpTracks_l(int fd, const Vector<String16>& args) final REQUIRES(mutex());
 
 public:
@@ -1451,10 +1484,38 @@ protected:
     float                           mMasterVolume;
     std::atomic<float>              mMasterBalance{};
     audio_utils::Balance            mBalance;
+    // Stereo balance gains of finalizeSinkBuffer(), ramped to the new balance
+    // over one buffer when it changes.
+    float                           mFinalizeGain[FCC_2] = {1.f, 1.f};
+
+    // Clamp PCM float values more than this distance from 0 to insulate
+    // a HAL which doesn't handle NaN correctly.
+    static constexpr float HAL_FLOAT_SAMPLE_LIMIT = 2.0f;
     int                             mNumWrites;
     int                             mNumDelayedWrites;
     bool                            mInWrite;
 
+    // durations of the threadLoop stages, written by threadLoop and read by dump.
+    audioflinger::StageTimes        mStageTimes;
+
+    // Parallel processing of the effect chains of different sessions,
+    // enabled by property af.effect.parallel_workers.
+    static constexpr size_t kMaxParallelEffectWorkers = 4;
+    struct ParallelEffectOutput {
+        sp<EffectBufferHalInterface> mBuffer;   // private output buffer of the session chain
+        void*                        mTarget = nullptr; // shared buffer it accumulates to
+        size_t                       mSize = 0; // in bytes, of mBuffer and mTarget
+    };
+    struct ParallelEffectChain {
+        size_t                       mIndex;    // in the effect chains of the current cycle
+        ParallelEffectOutput         mOutput;
+    };
+    size_t                          mParallelEffectWorkers = 0; // 0 if disabled
+    std::unique_ptr<afutils::ParallelWorkers> mEffectWorkers;   // created by threadLoop
+    std::map<audio_session_t, ParallelEffectOutput> mParallelEffectOutputs GUARDED_BY(mutex());
+    // session chains processed in parallel in the current cycle, only used by threadLoop
+    std::vector<ParallelEffectChain> mParallelEffectChains;
+
     // FIXME rename these former local variables of threadLoop to standard "m" names
     nsecs_t                         mStandbyTimeNs;
     size_t                          mSinkBufferSize;
@@ -1630,12 +1691,14 @@ protected:
     }
 
     void dumpInternals_l(int fd, const Vector<String16>& args) override REQUIRES(mutex());
+    void addStatistics(mediametrics::Item* item) override REQUIRES(ThreadBase_ThreadLoop);
 
     // threadLoop snippets
     ssize_t threadLoop_write() override REQUIRES(ThreadBase_ThreadLoop);
     void threadLoop_standby() override REQUIRES(ThreadBase_ThreadLoop);
     void threadLoop_mix() override REQUIRES(ThreadBase_ThreadLoop);
     void threadLoop_sleepTime() override REQUIRES(ThreadBase_ThreadLoop);
+    void threadLoop_exit() override REQUIRES(ThreadBase_ThreadLoop);
     uint32_t correctLatency_l(uint32_t latency) const final REQUIRES(mutex());
 
     status_t createAudioPatch_l(
@@ -1673,6 +1736,14 @@ private:
     int32_t mFastMixerFutex GUARDED_BY(ThreadBase_ThreadLoop);  // for cold idle
 
                 std::atomic_bool mMasterMono;
+
+    // If true, the HAL write of a mix buffer proceeds on a writer thread while the
+    // next buffer is mixed. Only used by MIXER threads without a FastMixer.
+    const bool mPipelinedWrite;
+    // created by the threadLoop on its first write, mNormalSink when not null.
+    sp<afutils::PipelinedSink> mPipelinedSink;
+    // waits for the write in flight to complete, e.g. before standby or reconfiguration.
+    void waitPipelinedWrite();
 public:
     virtual     bool        hasFastMixer() const { return mFastMixer != 0; }
     virtual     FastTrackUnderruns getFastTrackUnderruns(size_t fastIndex) const {
@@ -2008,7 +2079,8 @@ public:
                     pid_t tid,
                     status_t *status /*non-NULL*/,
                     audio_port_handle_t portId,
-                    int32_t maxSharedAudioHistoryMs) final
+                    int32_t maxSharedAudioHistoryMs,
+                    int64_t startTimeNs) final
             REQUIRES(audio_utils::AudioFlinger_Mutex) EXCLUDES_ThreadBase_Mutex;
 
             status_t start(IAfRecordTrack* recordTrack,
@@ -2128,6 +2200,25 @@ private:
 
     int32_t getOldestFront_l() REQUIRES(mutex());
     void updateFronts_l(int32_t offset) REQUIRES(mutex());
+    // Returns the position in mRsmpInBuffer of the frame captured at startTimeNs,
+    // or -1 if there is no capture history.
+    int32_t getHistoryStartFrames_l(int64_t startTimeNs) const REQUIRES(mutex());
+
+    // Converts frames of the thread input to the sink buffer of activeTracks[index],
+    // reusing the output of a previous track of this period with the same conversion
+    // and the same read position if there is one. Only called from threadLoop().
+    size_t convertTrackBuffer(
+            const Vector<sp<IAfRecordTrack>>& activeTracks, size_t index, size_t frames);
+
+    // Returns true if FastCapture may convert the input for track, the only normal
+    // active track. Only called from threadLoop().
+    bool canConvertInFastCapture(const sp<IAfRecordTrack>& track) const;
+
+    // Sets mFastCaptureConvertedTrack, and creates the converter and the pipe that FastCapture
+    // will use for it. The previous converter and pipe are returned in the parameters, they
+    // must be kept until FastCapture acknowledges the change. Only called from threadLoop().
+    void setFastCaptureConversion(const sp<IAfRecordTrack>& track,
+            std::unique_ptr<RecordBufferConverter>* oldConverter, sp<NBAIO_Sink>* oldSink);
 
             AudioStreamIn                       *mInput;
             Source                              *mSource;
@@ -2147,6 +2238,18 @@ private:
             // rolling index that is never cleared
             int32_t                             mRsmpInRear;    // last filled frame + 1
 
+            // Conversions of the current threadLoop() period that may be reused by the
+            // following tracks, accessible only within the threadLoop(), no locks required.
+            struct SharedConversion {
+                const RecordBufferConverter*    converter;   // of the track that converted
+                int32_t                         frontBefore; // read position of the track
+                int32_t                         frontAfter;  // before and after converting
+                size_t                          frames;      // frames converted to buffer
+                std::vector<uint8_t>            buffer;
+            };
+            std::vector<SharedConversion>       mSharedConversions; // buffers kept across periods
+            size_t                              mSharedConversionCount = 0; // used this period
+
             // For dumpsys
             const sp<MemoryDealer>              mReadOnlyHeap;
 
@@ -2183,6 +2286,17 @@ private:
             // If a fast capture is present, the Pipe as IMemory, otherwise clear
             sp<IMemory>                         mPipeMemory;
 
+            // If enabled by property af.fast_capture_conversion, FastCapture converts the input
+            // for the only normal active track, which then reads from a pipe in its own format.
+            // Accessible only within the threadLoop(), no locks required.
+            bool                                mFastCaptureConversionEnabled = false;
+            sp<IAfRecordTrack>                  mFastCaptureConvertedTrack;
+            std::unique_ptr<RecordBufferConverter> mFastCaptureConverter;
+            // non-blocking pipe written by fast capture in the format of the converted track
+            sp<NBAIO_Sink>                      mConvertedPipeSink;
+            sp<NBAIO_Source>                    mConvertedPipeSource;
+            size_t                              mConvertedPipeFramesP2 = 0;
+
             // TODO: add comment and adjust size as needed
             static const size_t                 kFastCaptureLogSize = 4 * 1024;
             sp<NBLog::Writer>                   mFastCaptureNBLogWriter;
@@ -2199,6 +2313,12 @@ private:
             std::string                         mSharedAudioPackageName = {};
             int32_t                             mSharedAudioStartFrames = -1;
             audio_session_t                     mSharedAudioSessionId = AUDIO_SESSION_NONE;
+
+            // Capture time of the frames kept in mRsmpInBuffer, allocated if the device keeps
+            // a capture history (af.record_history_ms), so that tracks can start in the past.
+            std::unique_ptr<audioflinger::FrameTimeIndex> mFrameTimeIndex GUARDED_BY(mutex());
+            // mRsmpInRear when the last position was added to mFrameTimeIndex
+            int32_t                             mFrameTimeIndexRear GUARDED_BY(mutex()) = 0;
 };
 
 class MmapThread : public ThreadBase, public virtual IAfMmapThread
@@ -167,8 +167,9 @@ TrackBase::TrackBase(
     }
 
     if (client != 0) {
-        mCblkMemory = client->allocator().allocate(mediautils::NamedAllocRequest{{size},
-                std::string("Track ID: ").append(std::to_string(mId))});
+        // usually preallocated by the thread before its mutex() was taken.
+        mCblkMemory = client->allocateCblk(size,
+                std::string("Track ID: ").append(std::to_string(mId)));
         if (mCblkMemory == 0 ||
                 (mCblk = static_cast<audio_track_cblk_t *>(mCblkMemory->unsecurePointer())) == NULL) {
             ALOGE("%s(%d): not enough memory for AudioTrack size=%zu", __func__, mId, size);
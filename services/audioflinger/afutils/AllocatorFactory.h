@@ -66,6 +66,11 @@ inline auto wrapWithPolicySnooping(Allocator allocator, std::string_view name) {
 constexpr inline size_t CLIENT_BOUND = 32;
 // Maximum amount of shared pools a single client can take (50%).
 constexpr inline size_t ADV_THRESHOLD_INV = 2;
+// Deallocated track memory kept per client for reuse by its next tracks, so that
+// short lived tracks do not map and unmap a new heap each time.
+constexpr inline size_t CLIENT_CACHE_SIZE = 1024 * 256;                       // 256 KiB
+// Largest allocation kept for reuse, larger ones are typically static tracks.
+constexpr inline size_t CLIENT_CACHE_MAX_BLOCK = 1024 * 128;                  // 128 KiB
 
 inline auto getClientAllocator() {
     using namespace mediautils;
@@ -83,10 +88,12 @@ inline auto getClientAllocator() {
                 getSharedSmall(), "Small Shared");
     };
 
-    return ScopedAllocator{std::make_shared<
+    using ClientPools =
             FallbackAllocator<decltype(makeDedPool()),
-                              decltype(FallbackAllocator(makeLargeShared(), makeSmallShared()))>>(
-            makeDedPool(), FallbackAllocator{makeLargeShared(), makeSmallShared()})};
+                              decltype(FallbackAllocator(makeLargeShared(), makeSmallShared()))>;
+    return ScopedAllocator{std::make_shared<
+            SizeClassAllocator<ClientPools, CLIENT_CACHE_SIZE, CLIENT_CACHE_MAX_BLOCK>>(
+            ClientPools{makeDedPool(), FallbackAllocator{makeLargeShared(), makeSmallShared()}})};
 }
 
 using ClientAllocator = decltype(getClientAllocator());
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "AudioFlinger::ParallelWorkers"
+//#define LOG_NDEBUG 0
+
+#include "ParallelWorkers.h"
+
+#include <algorithm>
+
+#include <pthread.h>
+#include <unistd.h>
+#include <utils/Log.h>
+
+namespace android::afutils {
+
+ParallelWorkers::ParallelWorkers(size_t workerCount, const std::string& name)
+{
+    mThreads.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        mThreads.emplace_back([this, i, name] {
+            // thread names are limited to 16 characters including the terminator.
+            const std::string threadName = (name + std::to_string(i)).substr(0, 15);
+            pthread_setname_np(pthread_self(), threadName.c_str());
+            workerLoop(i);
+        });
+    }
+    // wait until all the workers have registered, so that getTids() is complete.
+    std::unique_lock l(mMutex);
+    mDoneCv.wait(l, [&]() REQUIRES(mMutex) { return mTids.size() == workerCount; });
+}
+
+ParallelWorkers::~ParallelWorkers()
+{
+    {
+        std::lock_guard l(mMutex);
+        mExit = true;
+    }
+    mWorkCv.notify_all();
+    for (auto& thread : mThreads) {
+        thread.join();
+    }
+}
+
+std::vector<pid_t> ParallelWorkers::getTids() const
+{
+    std::lock_guard l(mMutex);
+    return mTids;
+}
+
+void ParallelWorkers::runTasks()
+{
+    for (size_t i = mNext.fetch_add(1, std::memory_order_relaxed); i < mCount;
+            i = mNext.fetch_add(1, std::memory_order_relaxed)) {
+        (*mTask)(i);
+    }
+}
+
+void ParallelWorkers::run(size_t count, const std::function<void(size_t)>& task)
+{
+    if (count == 0) return;
+    if (count == 1 || mThreads.empty()) {
+        for (size_t i = 0; i < count; ++i) {
+            task(i);
+        }
+        return;
+    }
+    // only wake the number of workers that can have a task, the caller runs one.
+    const size_t needed = std::min(mThreads.size(), count - 1);
+    {
+        std::lock_guard l(mMutex);
+        mTask = &task;
+        mCount = count;
+        mNext.store(0, std::memory_order_relaxed);
+        mUnclaimed = needed;
+        mBusyWorkers = 0;
+        ++mGeneration;
+    }
+    if (needed == mThreads.size()) {
+        mWorkCv.notify_all();
+    } else {
+        for (size_t i = 0; i < needed; ++i) {
+            mWorkCv.notify_one();
+        }
+    }
+    runTasks();
+    std::unique_lock l(mMutex);
+    // all tasks have been handed out, workers that have not woken up yet are not needed.
+    mUnclaimed = 0;
+    mDoneCv.wait(l, [&]() REQUIRES(mMutex) { return mBusyWorkers == 0; });
+    mTask = nullptr;
+}
+
+void ParallelWorkers::workerLoop(size_t index)
+{
+    ALOGV("%s: worker %zu started", __func__, index);
+    std::unique_lock l(mMutex);
+    mTids.push_back(gettid());
+    mDoneCv.notify_all();
+    uint64_t generation = mGeneration;
+    while (true) {
+        mWorkCv.wait(l, [&]() REQUIRES(mMutex) {
+            return mExit || (mGeneration != generation && mUnclaimed > 0);
+        });
+        if (mExit) break;
+        generation = mGeneration;
+        --mUnclaimed;
+        ++mBusyWorkers;
+        l.unlock();
+        runTasks();
+        l.lock();
+        if (--mBusyWorkers == 0) {
+            mDoneCv.notify_one();
+        }
+    }
+    ALOGV("%s: worker %zu exiting", __func__, index);
+}
+
+} // namespace android::afutils
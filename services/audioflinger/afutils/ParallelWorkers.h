@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <android-base/thread_annotations.h>
+
+namespace android::afutils {
+
+/**
+ * ParallelWorkers is a small fixed pool of threads used by an audio thread to
+ * spread independent pieces of work of one cycle (e.g. effect chains of different
+ * sessions) over several cores.
+ *
+ * run() hands out the task indices to the workers and to the calling thread,
+ * and returns only once every task has completed, so that the caller can use
+ * the results (join) before writing to the sink.
+ *
+ * The worker threads inherit the scheduling policy and priority of the thread which
+ * constructs the pool; they are otherwise idle waiting for the next run().
+ *
+ * run() must be called from a single thread at a time.
+ */
+class ParallelWorkers {
+public:
+    ParallelWorkers(size_t workerCount, const std::string& name);
+    ~ParallelWorkers();
+
+    ParallelWorkers(const ParallelWorkers&) = delete;
+    ParallelWorkers& operator=(const ParallelWorkers&) = delete;
+
+    // Runs task(i) for each i in [0, count) and returns when all have completed.
+    // The task must be safe to call concurrently for different indices.
+    void run(size_t count, const std::function<void(size_t)>& task);
+
+    size_t workerCount() const { return mThreads.size(); }
+
+    // Returns the tids of the worker threads, e.g. to raise their priority.
+    std::vector<pid_t> getTids() const;
+
+private:
+    void workerLoop(size_t index);
+    void runTasks();
+
+    mutable std::mutex mMutex;
+    std::condition_variable mWorkCv;  // signaled on a new run() or on exit
+    std::condition_variable mDoneCv;  // signaled when the last busy worker completes
+    uint64_t mGeneration GUARDED_BY(mMutex) = 0;  // incremented for each run()
+    size_t mUnclaimed GUARDED_BY(mMutex) = 0;     // workers needed but not yet woken up
+    size_t mBusyWorkers GUARDED_BY(mMutex) = 0;   // workers claimed and not yet completed
+    bool mExit GUARDED_BY(mMutex) = false;
+
+    // The current run, valid while mBusyWorkers > 0 or the caller is in run().
+    const std::function<void(size_t)>* mTask = nullptr;
+    size_t mCount = 0;
+    std::atomic<size_t> mNext{};      // next task index to hand out
+
+    std::vector<pid_t> mTids GUARDED_BY(mMutex);
+    std::vector<std::thread> mThreads;
+};
+
+} // namespace android::afutils
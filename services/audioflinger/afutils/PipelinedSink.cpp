@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "AudioFlinger::PipelinedSink"
+//#define LOG_NDEBUG 0
+
+#include "PipelinedSink.h"
+
+#include <string.h>
+
+#include <pthread.h>
+#include <unistd.h>
+#include <utils/Log.h>
+
+namespace android::afutils {
+
+PipelinedSink::PipelinedSink(const sp<NBAIO_Sink>& sink, size_t maxFrames,
+        const std::string& name)
+    : NBAIO_Sink(sink->format()),
+      mSink(sink)
+{
+    // the sink has already been negotiated by the owner.
+    mNegotiated = Format_isValid(mFormat);
+    for (auto& buffer : mBuffers) {
+        buffer.resize(maxFrames * mFrameSize);
+    }
+    mThread = std::thread([this, name] {
+        // thread names are limited to 16 characters including the terminator.
+        pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+        writerLoop();
+    });
+}
+
+PipelinedSink::~PipelinedSink()
+{
+    {
+        std::lock_guard l(mMutex);
+        mExit = true;
+    }
+    mCv.notify_all();
+    mThread.join();
+}
+
+pid_t PipelinedSink::getTid() const
+{
+    std::unique_lock l(mMutex);
+    mCv.wait(l, [&]() REQUIRES(mMutex) { return mTid != 0; });
+    return mTid;
+}
+
+ssize_t PipelinedSink::write(const void* buffer, size_t count)
+{
+    if (!mNegotiated) {
+        return NEGOTIATE;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    // fill the buffer which is not in flight while the previous write proceeds.
+    std::vector<uint8_t>& next = mBuffers[mNext];
+    const size_t bytes = count * mFrameSize;
+    if (next.size() < bytes) {
+        ALOGD("%s: growing buffer from %zu to %zu bytes", __func__, next.size(), bytes);
+        next.resize(bytes);
+    }
+    memcpy(next.data(), buffer, bytes);
+
+    std::unique_lock l(mMutex);
+    mCv.wait(l, [&]() REQUIRES(mMutex) { return mPendingFrames == 0; });
+    if (mStatus != OK) {
+        // report the error of the previous write, this buffer is discarded.
+        const status_t status = mStatus;
+        mStatus = OK;
+        return status;
+    }
+    mPendingData = next.data();
+    mPendingFrames = count;
+    mNext ^= 1;
+    mFramesWritten += count;
+    l.unlock();
+    mCv.notify_all();
+    return count;
+}
+
+status_t PipelinedSink::waitIdle()
+{
+    std::unique_lock l(mMutex);
+    mCv.wait(l, [&]() REQUIRES(mMutex) { return mPendingFrames == 0; });
+    const status_t status = mStatus;
+    mStatus = OK;
+    return status;
+}
+
+void PipelinedSink::writerLoop()
+{
+    std::unique_lock l(mMutex);
+    mTid = gettid();
+    mCv.notify_all();
+    ALOGV("%s: writer thread %d started", __func__, mTid);
+    while (true) {
+        mCv.wait(l, [&]() REQUIRES(mMutex) { return mExit || mPendingFrames > 0; });
+        if (mExit) break;
+        const uint8_t* data = mPendingData;
+        size_t frames = mPendingFrames;
+        l.unlock();
+
+        // the sink may accept fewer frames than requested, write until all are consumed.
+        status_t status = OK;
+        while (frames > 0) {
+            const ssize_t written = mSink->write(data, frames);
+            if (written <= 0) {
+                status = written < 0 ? (status_t)written : (status_t)NOT_ENOUGH_DATA;
+                ALOGW("%s: sink write returned %zd, dropping %zu frames",
+                        __func__, written, frames);
+                break;
+            }
+            data += written * mFrameSize;
+            frames -= written;
+        }
+
+        l.lock();
+        if (status != OK) {
+            mStatus = status;
+        }
+        mPendingData = nullptr;
+        mPendingFrames = 0;
+        mCv.notify_all();
+    }
+    ALOGV("%s: writer thread %d exiting", __func__, mTid);
+}
+
+} // namespace android::afutils
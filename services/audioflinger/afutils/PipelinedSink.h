@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <android-base/thread_annotations.h>
+#include <media/nbaio/NBAIO.h>
+
+namespace android::afutils {
+
+/**
+ * PipelinedSink is an NBAIO_Sink which writes to another (blocking) sink,
+ * typically an AudioStreamOutSink, on its own writer thread.
+ *
+ * write() copies the data into one of two buffers, waits for the write of the
+ * previous buffer to complete, and hands the new buffer to the writer thread.
+ * So at most one buffer is in flight: the caller mixes period N+1 while the
+ * HAL write of period N is in progress, and is still paced by the HAL.
+ *
+ * An error of the sink is returned by the next write(), or by waitIdle().
+ *
+ * The writer thread inherits the scheduling policy and priority of the thread
+ * which constructs the sink.  write() and waitIdle() must be called from a single
+ * thread; getTimestamp() is forwarded to the sink and may be called concurrently
+ * if the sink allows it.
+ */
+class PipelinedSink : public NBAIO_Sink {
+public:
+    // maxFrames is the expected maximum frame count of a write(), to preallocate the
+    // buffers. Larger writes are accepted but reallocate.
+    PipelinedSink(const sp<NBAIO_Sink>& sink, size_t maxFrames, const std::string& name);
+    ~PipelinedSink() override;
+
+    PipelinedSink(const PipelinedSink&) = delete;
+    PipelinedSink& operator=(const PipelinedSink&) = delete;
+
+    // NBAIO_Sink
+    ssize_t write(const void* buffer, size_t count) override;
+    status_t getTimestamp(ExtendedTimestamp& timestamp) override {
+        return mSink->getTimestamp(timestamp);
+    }
+
+    // Waits until the buffer in flight has been written to the sink, e.g. before
+    // standby or a reconfiguration of the stream.
+    // Returns OK, or the error of the last write to the sink.
+    status_t waitIdle();
+
+    // Returns the tid of the writer thread, e.g. to adjust its priority.
+    pid_t getTid() const;
+
+private:
+    void writerLoop();
+
+    const sp<NBAIO_Sink> mSink;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mCv;  // signaled when a buffer is handed over or completes
+    std::vector<uint8_t> mBuffers[2];
+    size_t mNext = 0;  // index of the buffer filled by the next write(), only used by the caller
+    const uint8_t* mPendingData GUARDED_BY(mMutex) = nullptr;
+    size_t mPendingFrames GUARDED_BY(mMutex) = 0;  // non-zero while a buffer is in flight
+    status_t mStatus GUARDED_BY(mMutex) = OK;      // last error of the sink, cleared when reported
+    bool mExit GUARDED_BY(mMutex) = false;
+    pid_t mTid GUARDED_BY(mMutex) = 0;
+
+    std::thread mThread;  // last member, started once the other members are constructed
+};
+
+} // namespace android::afutils
@@ -112,6 +112,21 @@ public:
             .record();
     }
 
+    // Called periodically by the threadLoop with the CPU statistics since the previous call.
+    void logCpuStats(int64_t durationNs, int64_t cpuTimeNs, int32_t migrations,
+            double meanMHz, const std::string& residency) const {
+        mediametrics::LogItem item(mMetricsId);
+        item.set(AMEDIAMETRICS_PROP_EVENT, AMEDIAMETRICS_PROP_EVENT_VALUE_CPUSTATS)
+            .set(AMEDIAMETRICS_PROP_DURATIONNS, durationNs)
+            .set(AMEDIAMETRICS_PROP_CPUTIMENS, cpuTimeNs)
+            .set(AMEDIAMETRICS_PROP_CPUMIGRATIONS, migrations)
+            .set(AMEDIAMETRICS_PROP_CPURESIDENCY, residency);
+        if (meanMHz > 0.) {
+            item.set(AMEDIAMETRICS_PROP_CPUMEANMHZ, meanMHz);
+        }
+        item.record();
+    }
+
     void logLatency(double latencyMs) {
         mediametrics::LogItem(mMetricsId)
             .set(AMEDIAMETRICS_PROP_LATENCYMS, latencyMs)
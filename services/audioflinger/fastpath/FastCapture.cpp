@@ -20,10 +20,13 @@
 #define ATRACE_TAG ATRACE_TAG_AUDIO
 
 #include "Configuration.h"
+#include <algorithm>
 #include <audio_utils/format.h>
+#include <audio_utils/roundup.h>
 #include <linux/futex.h>
 #include <sys/syscall.h>
 #include <media/AudioBufferProvider.h>
+#include <media/AudioResamplerPublic.h>
 #include <utils/Log.h>
 #include <utils/Trace.h>
 #include "FastCapture.h"
@@ -63,6 +66,7 @@ void FastCapture::onIdle()
 void FastCapture::onExit()
 {
     free(mReadBuffer);
+    free(mConvertBuffer);
 }
 
 bool FastCapture::isSubClassCommand(FastThreadState::Command command)
@@ -118,7 +122,9 @@ void FastCapture::onStateChange()
         ALOG_ASSERT(Format_isEqual(mFormat, mPipeSink->format()));
     }
 
-    if ((!Format_isEqual(mFormat, previousFormat)) || (frameCount != previous->mFrameCount)) {
+    const bool readBufferChanged =
+            !Format_isEqual(mFormat, previousFormat) || frameCount != previous->mFrameCount;
+    if (readBufferChanged) {
         // FIXME to avoid priority inversion, don't free here
         free(mReadBuffer);
         mReadBuffer = nullptr;
@@ -133,6 +139,7 @@ void FastCapture::onStateChange()
             mUnderrunNs = (frameCount * 1750000000LL) / mSampleRate;    // 1.75
             mOverrunNs = (frameCount * 500000000LL) / mSampleRate;      // 0.50
             mForceNs = (frameCount * 950000000LL) / mSampleRate;        // 0.95
+            mAdaptiveForceNs = mForceNs;
             mWarmupNsMin = (frameCount * 750000000LL) / mSampleRate;    // 0.75
             mWarmupNsMax = (frameCount * 1250000000LL) / mSampleRate;   // 1.25
         } else {
@@ -140,15 +147,119 @@ void FastCapture::onStateChange()
             mUnderrunNs = 0;
             mOverrunNs = 0;
             mForceNs = 0;
+            mAdaptiveForceNs = 0;
             mWarmupNsMin = 0;
             mWarmupNsMax = LONG_MAX;
         }
         mReadBufferState = -1;
         dumpState->mFrameCount = frameCount;
     }
+
+    // check for change in converter, which depends on the input configuration
+    const bool converterChanged = current->mConverterGen != mConverterGen;
+    if (converterChanged) {
+        mConverter = current->mConverter;
+        mConvertedSink = current->mConvertedSink;
+        mConverterGen = current->mConverterGen;
+    }
+    if (converterChanged || readBufferChanged) {
+        // FIXME to avoid priority inversion, don't free or allocate here, see mReadBuffer above
+        free(mConvertBuffer);
+        mConvertBuffer = nullptr;
+        mConvertBufferFrames = 0;
+        if (mConverter != nullptr && mConvertedSink != nullptr && mReadBuffer != nullptr) {
+            const NBAIO_Format convertedFormat = mConvertedSink->format();
+            mConvertedFrameSize = Format_frameSize(convertedFormat);
+            mConvertedSampleRate = Format_sampleRate(convertedFormat);
+            // room for the frames of a read, and for those not yet consumed by the resampler
+            const size_t providerFramesP2 = roundup(2 * frameCount);
+            mConverterProvider.configure(Format_frameSize(mFormat), providerFramesP2);
+            mConvertBufferFrames = destinationFramesPossible(
+                    providerFramesP2, mSampleRate, mConvertedSampleRate);
+            (void)posix_memalign(&mConvertBuffer, 32, mConvertBufferFrames * mConvertedFrameSize);
+        } else {
+            mConverterProvider.configure(0 /*frameSize*/, 0 /*framesP2*/);
+        }
+        dumpState->mConverting = mConvertBuffer != nullptr;
+    }
     dumpState->mSilenced = current->mSilenceCapture;
 }
 
+void FastCapture::convert(const void *buffer, size_t frames)
+{
+    FastCaptureDumpState * const dumpState = (FastCaptureDumpState *) mDumpState;
+    if (mConverterProvider.write(buffer, frames) < frames) {
+        // should not happen as the converter consumes all it can at each cycle
+        dumpState->mConvertOverruns++;
+    }
+    // Like RecordThread, don't ask for more than can be produced from the available input.
+    const size_t framesOut = std::min(mConvertBufferFrames, destinationFramesPossible(
+            mConverterProvider.availableFrames(), mSampleRate, mConvertedSampleRate));
+    if (framesOut == 0) {
+        return;
+    }
+    ATRACE_BEGIN("convert");
+    const size_t framesConverted = mConverter->convert(
+            mConvertBuffer, &mConverterProvider, framesOut);
+    ATRACE_END();
+    if (framesConverted > 0) {
+        // the converted sink does not block: frames that the client did not make room for
+        // are dropped, as they would be by RecordThread
+        const ssize_t framesWritten = mConvertedSink->write(mConvertBuffer, framesConverted);
+        if (framesWritten > 0) {
+            dumpState->mFramesConverted += framesWritten;
+        }
+    }
+}
+
+void FastCapture::ConverterBufferProvider::configure(size_t frameSize, size_t framesP2)
+{
+    free(mBuffer);
+    mBuffer = nullptr;
+    mFrameSize = frameSize;
+    mFramesP2 = framesP2;
+    if (framesP2 > 0) {
+        (void)posix_memalign(&mBuffer, 32, framesP2 * frameSize);
+    }
+    reset();
+}
+
+size_t FastCapture::ConverterBufferProvider::write(const void *buffer, size_t frames)
+{
+    frames = std::min(frames, mFramesP2 - availableFrames());
+    const size_t index = mRear & (mFramesP2 - 1);
+    const size_t part1 = std::min(frames, mFramesP2 - index);
+    memcpy((uint8_t *) mBuffer + index * mFrameSize, buffer, part1 * mFrameSize);
+    if (part1 < frames) {
+        memcpy(mBuffer, (const uint8_t *) buffer + part1 * mFrameSize,
+                (frames - part1) * mFrameSize);
+    }
+    mRear += frames;
+    return frames;
+}
+
+status_t FastCapture::ConverterBufferProvider::getNextBuffer(Buffer *buffer)
+{
+    const size_t index = mFront & (mFramesP2 - 1);
+    const size_t frames = std::min({buffer->frameCount, availableFrames(), mFramesP2 - index});
+    if (frames == 0) {
+        // out of data is fine since the resampler will return a short-count.
+        buffer->raw = nullptr;
+        buffer->frameCount = 0;
+        return NOT_ENOUGH_DATA;
+    }
+    buffer->raw = (uint8_t *) mBuffer + index * mFrameSize;
+    buffer->frameCount = frames;
+    return NO_ERROR;
+}
+
+void FastCapture::ConverterBufferProvider::releaseBuffer(Buffer *buffer)
+{
+    mFront += buffer->frameCount;
+    buffer->raw = nullptr;
+    buffer->frameCount = 0;
+}
+
 void FastCapture::onWork()
 {
     const FastCaptureState * const current = (const FastCaptureState *) mCurrent;
@@ -204,6 +315,9 @@ void FastCapture::onWork()
                 memset(mReadBuffer, 0, mReadBufferState * Format_frameSize(mFormat));
             }
             const ssize_t framesWritten = mPipeSink->write(mReadBuffer, mReadBufferState);
+            if (mConvertBuffer != nullptr) {
+                convert(mReadBuffer, mReadBufferState);
+            }
             audio_track_cblk_t* cblk = current->mCblk;
             if (fastPatchRecordBufferProvider != nullptr) {
                 // This indicates the fast track is a patch record, update the cblk by
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <stdlib.h>
+
 #include "FastThread.h"
 #include "StateQueue.h"
 #include "FastCaptureState.h"
@@ -44,6 +46,36 @@ private:
     void onStateChange() override;
     void onWork() override;
 
+    // Converts frames read from the input source and writes them to mConvertedSink.
+    void convert(const void *buffer, size_t frames);
+
+    // Buffer provider for mConverter over the last frames read from the input source.
+    // The converter may keep a buffer across calls to convert(), so unlike mReadBuffer,
+    // frames are not overwritten until they are released.
+    class ConverterBufferProvider : public AudioBufferProvider {
+    public:
+        ~ConverterBufferProvider() override { free(mBuffer); }
+
+        // (Re)allocates the buffer for framesP2 frames, a power of 2, and discards the data.
+        void configure(size_t frameSize, size_t framesP2);
+        // Discards the data.
+        void reset() { mFront = mRear = 0; }
+        // Returns the number of frames copied, less than frames if there is not enough room.
+        size_t write(const void *buffer, size_t frames);
+        size_t availableFrames() const { return mRear - mFront; }
+
+        // AudioBufferProvider interface
+        status_t getNextBuffer(Buffer *buffer) override;
+        void releaseBuffer(Buffer *buffer) override;
+
+    private:
+        void*   mBuffer = nullptr;
+        size_t  mFrameSize = 0;
+        size_t  mFramesP2 = 0;
+        size_t  mFront = 0;     // rolling indices
+        size_t  mRear = 0;
+    };
+
     static const FastCaptureState sInitial;
 
     FastCaptureState    mPreIdle;   // copy of state before we went into idle
@@ -60,6 +92,15 @@ private:
     FastCaptureDumpState mDummyFastCaptureDumpState;
     uint32_t            mTotalNativeFramesRead = 0; // copied to dumpState->mFramesRead
 
+    RecordBufferConverter* mConverter = nullptr;
+    NBAIO_Sink*         mConvertedSink = nullptr;
+    int                 mConverterGen = 0;
+    ConverterBufferProvider mConverterProvider;
+    void*               mConvertBuffer = nullptr;   // converted frames, to mConvertedSink
+    size_t              mConvertBufferFrames = 0;
+    size_t              mConvertedFrameSize = 0;    // frame size of mConvertedSink
+    unsigned            mConvertedSampleRate = 0;   // sample rate of mConvertedSink
+
 };  // class FastCapture
 
 }   // namespace android
@@ -36,10 +36,12 @@ void FastCaptureDumpState::dump(int fd) const
     dprintf(fd, "  FastCapture command=%s readSequence=%u framesRead=%u\n"
                 "              readErrors=%u sampleRate=%u frameCount=%zu\n"
                 "              measuredWarmup=%.3g ms, warmupCycles=%u period=%.2f ms\n"
-                "              silenced: %s\n",
+                "              silenced: %s\n"
+                "              converting: %s framesConverted=%u convertOverruns=%u\n",
                 FastCaptureState::commandToString(mCommand), mReadSequence, mFramesRead,
                 mReadErrors, mSampleRate, mFrameCount, measuredWarmupMs, mWarmupCycles,
-                periodSec * 1e3, mSilenced ? "true" : "false");
+                periodSec * 1e3, mSilenced ? "true" : "false",
+                mConverting ? "true" : "false", mFramesConverted, mConvertOverruns);
 }
 
 }  // namespace android
@@ -33,6 +33,9 @@ struct FastCaptureDumpState : FastThreadDumpState {
     uint32_t mSampleRate = 0;
     size_t   mFrameCount = 0;
     bool     mSilenced = false; // capture is silenced
+    bool     mConverting = false;       // a converter is configured
+    uint32_t mFramesConverted = 0;      // total number of frames written to the converted sink
+    uint32_t mConvertOverruns = 0;      // number of reads that did not fit the converter input
 };
 
 // No virtuals
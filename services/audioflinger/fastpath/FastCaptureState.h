@@ -19,6 +19,7 @@
 #include <type_traits>
 #include <media/nbaio/NBAIO.h>
 #include <media/AudioBufferProvider.h>
+#include <media/RecordBufferConverter.h>
 #include "FastThreadState.h"
 #include <private/media/AudioTrackShared.h>
 
@@ -42,6 +43,14 @@ struct FastCaptureState : FastThreadState {
     bool            mSilenceCapture = false;    // request to silence capture for fast track.
                                                 // note: this also silences the normal mixer pipe
 
+    // Optional conversion of the captured data for a single normal client, so that the client
+    // does not depend on the scheduling of the normal capture thread for the conversion.
+    RecordBufferConverter* mConverter = nullptr;  // converts from the input source format
+                                                  // to the format of mConvertedSink
+    NBAIO_Sink*     mConvertedSink = nullptr;   // after converting, write to this sink
+    int             mConverterGen = 0;          // increment when mConverter or
+                                                // mConvertedSink is assigned
+
     // Extends FastThreadState::Command
     static const Command
         // The following commands also process configuration changes, and can be "or"ed:
@@ -85,6 +85,11 @@ FastMixerStateQueue* FastMixer::sq()
     return &mSQ;
 }
 
+FastMixerDeltaQueue* FastMixer::dq()
+{
+    return &mDQ;
+}
+
 const FastThreadState *FastMixer::poll()
 {
     return mSQ.poll();
@@ -190,6 +195,27 @@ void FastMixer::updateMixerTrack(int index, Reason reason) {
     }
 }
 
+void FastMixer::applyDeltas()
+{
+    const FastMixerState * const current = (const FastMixerState *) mCurrent;
+    mDQ.drain([this, current](const FastTrackDelta& delta) {
+        const unsigned index = delta.mIndex;
+        // Discard deltas for a track we haven't configured, or for another generation of it;
+        // in both cases the delta is superseded by a pushed state.
+        if (mMixer == nullptr || index >= FastMixerState::kMaxFastTracks
+                || (current->mTrackMask & (1 << index)) == 0
+                || mGenerations[index] != delta.mGeneration) {
+            return;
+        }
+        mMixer->setParameter(index, AudioMixer::TRACK, AudioMixer::HAPTIC_ENABLED,
+                (void *)(uintptr_t)delta.mHapticPlaybackEnabled);
+        mMixer->setParameter(index, AudioMixer::TRACK, AudioMixer::HAPTIC_SCALE,
+                (void *)(&delta.mHapticScale));
+        mMixer->setParameter(index, AudioMixer::TRACK, AudioMixer::HAPTIC_MAX_AMPLITUDE,
+                (void *)(&delta.mHapticMaxAmplitude));
+    });
+}
+
 void FastMixer::onStateChange()
 {
     const FastMixerState * const current = (const FastMixerState *) mCurrent;
@@ -265,6 +291,7 @@ void FastMixer::onStateChange()
             mUnderrunNs = (frameCount * 1750000000LL) / mSampleRate;  // 1.75
             mOverrunNs = (frameCount * 500000000LL) / mSampleRate;    // 0.50
             mForceNs = (frameCount * 950000000LL) / mSampleRate;      // 0.95
+            mAdaptiveForceNs = mForceNs;
             mWarmupNsMin = (frameCount * 750000000LL) / mSampleRate;  // 0.75
             mWarmupNsMax = (frameCount * 1250000000LL) / mSampleRate; // 1.25
         } else {
@@ -272,6 +299,7 @@ void FastMixer::onStateChange()
             mUnderrunNs = 0;
             mOverrunNs = 0;
             mForceNs = 0;
+            mAdaptiveForceNs = 0;
             mWarmupNsMin = 0;
             mWarmupNsMax = LONG_MAX;
         }
@@ -350,6 +378,8 @@ void FastMixer::onWork()
     const FastMixerState::Command command = mCommand;
     const size_t frameCount = current->mFrameCount;
 
+    applyDeltas();
+
     if ((command & FastMixerState::MIX) && (mMixer != nullptr) && mIsWarm) {
         ALOG_ASSERT(mMixerBuffer != nullptr);
 
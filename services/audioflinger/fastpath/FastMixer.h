@@ -29,6 +29,8 @@ namespace android {
 class AudioMixer;
 
 using FastMixerStateQueue = StateQueue<FastMixerState>;
+using FastMixerDeltaQueue = StateDeltaQueue<FastTrackDelta,
+        FastMixerState::kMaxFastTracks>;
 
 class FastMixer : public FastThread {
 
@@ -38,6 +40,7 @@ public:
     explicit FastMixer(audio_io_handle_t threadIoHandle);
 
             FastMixerStateQueue* sq();
+            FastMixerDeltaQueue* dq();
 
     virtual void setMasterMono(bool mono) { mMasterMono.store(mono); /* memory_order_seq_cst */ }
     virtual void setMasterBalance(float balance) { mMasterBalance.store(balance); }
@@ -47,6 +50,7 @@ public:
     }
 private:
             FastMixerStateQueue mSQ;
+            FastMixerDeltaQueue mDQ;
 
     // callouts
     const FastThreadState *poll() override;
@@ -64,6 +68,8 @@ private:
     };
     // called when a fast track of index has been removed, added, or modified
     void updateMixerTrack(int index, Reason reason);
+    // called at the start of each work cycle to apply the deltas sent through mDQ
+    void applyDeltas();
 
     // FIXME these former local variables need comments
     static const FastMixerState sInitial;
@@ -55,11 +55,13 @@ void FastMixerDumpState::dump(int fd) const
     dprintf(fd, "  FastMixer command=%s writeSequence=%u framesWritten=%u\n"
                 "            numTracks=%u writeErrors=%u underruns=%u overruns=%u\n"
                 "            sampleRate=%u frameCount=%zu measuredWarmup=%.3g ms, warmupCycles=%u\n"
-                "            mixPeriod=%.2f ms latency=%.2f ms\n",
+                "            mixPeriod=%.2f ms latency=%.2f ms\n"
+                "            deadlineMisses=%u cycleJitter=%.3f ms forcedCycle=%.3f ms\n",
                 FastMixerState::commandToString(mCommand), mWriteSequence, mFramesWritten,
                 mNumTracks, mWriteErrors, mUnderruns, mOverruns,
                 mSampleRate, mFrameCount, measuredWarmupMs, mWarmupCycles,
-                mixPeriodSec * 1e3, mLatencyMs);
+                mixPeriodSec * 1e3, mLatencyMs,
+                mDeadlineMisses, mCycleJitterNs * 1e-6, mForceNs * 1e-6);
     dprintf(fd, "  FastMixer Timestamp stats: %s\n", mTimestampVerifier.toString().c_str());
 #ifdef FAST_THREAD_STATISTICS
     // find the interval of valid samples
@@ -61,6 +61,16 @@ struct FastTrack {
 // No virtuals.
 static_assert(!std::is_polymorphic_v<FastTrack>);
 
+// Represents an incremental change to the haptic parameters of an active fast track,
+// sent through a FastMixerDeltaQueue instead of pushing a complete FastMixerState.
+struct FastTrackDelta {
+    unsigned                mIndex = 0;          // index in FastMixerState::mFastTracks
+    int                     mGeneration = 0;     // FastTrack::mGeneration this delta applies to
+    bool                    mHapticPlaybackEnabled = false;
+    os::HapticScale mHapticScale = os::HapticScale::mute();
+    float                   mHapticMaxAmplitude = NAN;
+};
+
 // Represents a single state of the fast mixer
 struct FastMixerState : FastThreadState {
     FastMixerState();
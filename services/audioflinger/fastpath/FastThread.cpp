@@ -20,6 +20,7 @@
 #define ATRACE_TAG ATRACE_TAG_AUDIO
 
 #include "Configuration.h"
+#include <algorithm>
 #include <linux/futex.h>
 #include <sys/syscall.h>
 #include <audio_utils/clock.h>
@@ -35,6 +36,10 @@
 #define MIN_WARMUP_CYCLES          2    // minimum number of consecutive in-range loop cycles
                                         // to wait for warmup
 #define MAX_WARMUP_CYCLES         10    // maximum number of loop cycles to wait for warmup
+#define JITTER_SMOOTHING_SHIFT     4    // cycle jitter is smoothed with a weight of 1/16
+#define BIAS_INCREMENT_SHIFT       4    // on deadline miss, wake up earlier by period/16
+#define BIAS_DECREMENT_SHIFT      10    // on time, wake up later by period/1024
+#define BIAS_MAX_SHIFT             2    // and never wake up earlier than by period/4
 
 namespace android {
 
@@ -44,6 +49,40 @@ FastThread::FastThread(const char *cycleMs, const char *loadUs) : Thread(false /
     strlcpy(mLoadUs, loadUs, sizeof(mLoadUs));
 }
 
+void FastThread::updateSchedule(time_t sec, int64_t nsec)
+{
+    const int64_t cycleNs = sec > 0 ? INT64_MAX / 2 : nsec;
+    const int64_t deadlineNs = mPeriodNs + (mPeriodNs >> 2);
+    const bool deadlineMissed = cycleNs > deadlineNs;
+    if (deadlineMissed) {
+        // a long cycle would dominate the jitter, so it is only counted as a deadline miss
+        mDumpState->mDeadlineMisses++;
+    } else {
+        const int64_t deviationNs = cycleNs > mPeriodNs ? cycleNs - mPeriodNs : mPeriodNs - cycleNs;
+        mCycleJitterNs += (deviationNs - mCycleJitterNs) >> JITTER_SMOOTHING_SHIFT;
+        mDumpState->mCycleJitterNs = mCycleJitterNs;
+    }
+
+    if (!mCurrent->mAdaptiveScheduling) {
+        mAdaptiveForceNs = mForceNs;
+    } else {
+        // After a deadline miss, wake up earlier; the bias decays slowly while on time,
+        // so that we converge to just enough margin, and don't wake up too early.
+        if (deadlineMissed) {
+            mAdaptiveBiasNs = std::min(mAdaptiveBiasNs + (mPeriodNs >> BIAS_INCREMENT_SHIFT),
+                    mPeriodNs >> BIAS_MAX_SHIFT);
+        } else {
+            mAdaptiveBiasNs = std::max(mAdaptiveBiasNs - (mPeriodNs >> BIAS_DECREMENT_SHIFT),
+                    (int64_t)0);
+        }
+        // Keep a margin of twice the jitter before the nominal period,
+        // but never less than the overrun threshold, or more than the default forced time.
+        mAdaptiveForceNs = std::clamp(mPeriodNs - 2 * mCycleJitterNs - mAdaptiveBiasNs,
+                mOverrunNs, mForceNs);
+    }
+    mDumpState->mForceNs = mAdaptiveForceNs;
+}
+
 bool FastThread::threadLoop()
 {
     // LOGT now works even if tlNBLogWriter is nullptr, but we're considering changing that,
@@ -139,6 +178,8 @@ bool FastThread::threadLoop()
                 // This may be overly conservative; there could be times that the normal mixer
                 // requests such a brief cold idle that it doesn't require resetting this flag.
                 mIsWarm = false;
+                mCycleJitterNs = 0;
+                mAdaptiveBiasNs = 0;
                 mMeasuredWarmupTs.tv_sec = 0;
                 mMeasuredWarmupTs.tv_nsec = 0;
                 mWarmupCycles = 0;
@@ -226,6 +267,7 @@ bool FastThread::threadLoop()
                 }
                 mSleepNs = -1;
                 if (mIsWarm) {
+                    updateSchedule(sec, nsec);
                     if (sec > 0 || nsec > mUnderrunNs) {
                         ATRACE_NAME("underrun");   // NOLINT(misc-const-correctness)
                         // FIXME only log occasionally
@@ -250,7 +292,7 @@ bool FastThread::threadLoop()
                         //    rate < than mOverrunNs per buffer.
                         //  - recovers from overrun immediately after underrun
                         // It doesn't work with a non-blocking audio HAL.
-                        mSleepNs = mForceNs - nsec;
+                        mSleepNs = mAdaptiveForceNs - nsec;
                     } else {
                         mIgnoreNextOverrun = false;
                     }
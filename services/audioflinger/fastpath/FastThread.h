@@ -35,6 +35,10 @@ private:
     // implement Thread::threadLoop()
     bool threadLoop() override;
 
+    // Update the cycle jitter and deadline miss statistics with the last cycle time,
+    // and if adaptive scheduling is enabled, adjust mAdaptiveForceNs.
+    void updateSchedule(time_t sec, int64_t nsec);
+
 protected:
     // callouts to subclass in same lexical order as they were in original FastMixer.cpp
     // FIXME need comments
@@ -59,6 +63,9 @@ protected:
     int64_t         mOverrunNs = 0;    // overrun likely when write cycle is less than this value
     int64_t         mForceNs = 0;      // if overrun detected,
                                        // force the write cycle to take this much time
+    int64_t         mAdaptiveForceNs = 0;  // mForceNs adjusted for adaptive scheduling
+    int64_t         mAdaptiveBiasNs = 0;   // how much earlier to wake up due to deadline misses
+    int64_t         mCycleJitterNs = 0;    // smoothed absolute deviation of cycle time
     int64_t         mWarmupNsMin = 0;  // warmup complete when write cycle is greater
                                        //  than or equal to this value
     int64_t         mWarmupNsMax = INT64_MAX;  // and less than or equal to this value
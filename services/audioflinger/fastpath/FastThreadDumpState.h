@@ -37,6 +37,11 @@ struct FastThreadDumpState {
     uint32_t mOverruns = 0;         // total number of overruns
     struct timespec mMeasuredWarmupTs{};  // measured warmup time
     uint32_t mWarmupCycles = 0;     // number of loop cycles required to warmup
+    uint32_t mDeadlineMisses = 0;   // total number of cycles longer than the deadline,
+                                    // which is 1.25 times the period
+    uint32_t mCycleJitterNs = 0;    // smoothed absolute deviation of cycle time from period
+    uint32_t mForceNs = 0;          // current forced cycle time after an overrun, which
+                                    // is adjusted if adaptive scheduling is enabled
 
 #ifdef FAST_THREAD_STATISTICS
     // Recently collected samples of per-cycle monotonic time, thread CPU time, and CPU frequency.
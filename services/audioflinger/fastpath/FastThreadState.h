@@ -44,6 +44,10 @@ struct FastThreadState {
     FastThreadDumpState* mDumpState = nullptr; // if non-NULL, then update dump state periodically
     NBLog::Writer* mNBLogWriter = nullptr; // non-blocking logger
 
+    // If true, the forced cycle time after an overrun adapts to the measured cycle jitter
+    // and deadline misses, instead of being a fixed fraction of the period.
+    bool        mAdaptiveScheduling = false;
+
     // returns NULL if command belongs to a subclass
     static const char *commandToString(Command command);
 };  // struct FastThreadState
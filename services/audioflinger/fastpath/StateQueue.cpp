@@ -33,8 +33,9 @@ void StateQueueObserverDump::dump(int fd)
 
 void StateQueueMutatorDump::dump(int fd)
 {
-    dprintf(fd, "State queue mutator: pushDirty=%u pushAck=%u blockedSequence=%u\n",
-            mPushDirty, mPushAck, mBlockedSequence);
+    dprintf(fd, "State queue mutator: pushDirty=%u pushAck=%u blockedSequence=%u"
+            " deltas=%u deltaOverflows=%u\n",
+            mPushDirty, mPushAck, mBlockedSequence, mDeltas, mDeltaOverflows);
 }
 #endif
 
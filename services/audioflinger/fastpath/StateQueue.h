@@ -16,7 +16,10 @@
 
 #pragma once
 
+#include <atomic>
 #include <stdatomic.h>
+#include <stdint.h>
+#include <type_traits>
 
 // The state queue template class was originally driven by this use case / requirements:
 //  There are two threads: a fast mixer, and a normal mixer, and they share state.
@@ -118,6 +121,8 @@ struct StateQueueMutatorDump {
     unsigned    mBlockedSequence; // incremented before and after each time that push()
                                   // blocks for more than one PUSH_BLOCK_ACK_NS;
                                   // if odd, then mutator is currently blocked inside push()
+    unsigned    mDeltas = 0;      // incremented each time a delta is sent instead of a push
+    unsigned    mDeltaOverflows = 0; // incremented each time a delta queue was full
     void        dump(int fd);
 };
 #endif
@@ -170,6 +175,12 @@ public:
     // Return whether the current state is dirty (modified and not pushed).
     bool    isDirty() const { return mIsDirty; }
 
+    // Return whether the most recent push, if any, has been acknowledged by the observer.
+    // When true and the state is not dirty, the observer has the latest state,
+    // so it is safe to describe further changes with a StateDeltaQueue.
+    bool    isAcked() const
+            { return mExpecting == nullptr || (const T *) mAck == mExpecting; }
+
 #ifdef STATE_QUEUE_DUMP
     // Register location of observer dump area
     void    setObserverDump(StateQueueObserverDump *dump)
@@ -210,4 +221,89 @@ private:
 
 };  // class StateQueue
 
+// Manages a bounded FIFO queue of deltas, which are small incremental changes to a state.
+// This supplements a StateQueue for changes that are frequent, but too small to justify
+// pushing (and copying) a complete state, for example a parameter of a single fast track.
+//  - Each delta is of type <D>, and should contain only POD; it is copied by value.
+//  - Any number of mutators may enqueue() concurrently; enqueue() is lock-free and never blocks.
+//    If the queue is full, enqueue() fails and the mutator should push a complete state instead.
+//  - The single observer drain()s all pending deltas in FIFO order, typically at the start of
+//    its cycle, and it also must never block.
+//  - The mutator must also apply the change to the mutating state, so that the states in
+//    the StateQueue remain authoritative.  The observer must discard deltas that do not apply
+//    to its current state, e.g. by comparing a generation count.
+// The queue is based on the bounded MPMC queue by Dmitry Vyukov, restricted to one consumer.
+template<typename D, size_t kCapacity = 16> class StateDeltaQueue final {
+    static_assert(std::is_trivially_copyable_v<D>, "deltas must be POD");
+    static_assert(kCapacity >= 2 && (kCapacity & (kCapacity - 1)) == 0,
+            "capacity must be a power of 2");
+
+public:
+    StateDeltaQueue() {
+        for (size_t i = 0; i < kCapacity; ++i) {
+            mSlots[i].mSequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Mutator APIs
+
+    // Enqueue a delta for the observer.  Returns false if the queue is full.
+    bool    enqueue(const D& delta) {
+        size_t position = mRear.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = mSlots[position & (kCapacity - 1)];
+            const size_t sequence = slot.mSequence.load(std::memory_order_acquire);
+            const intptr_t diff = (intptr_t) sequence - (intptr_t) position;
+            if (diff == 0) {
+                // the slot is free, try to claim it
+                if (mRear.compare_exchange_weak(
+                        position, position + 1, std::memory_order_relaxed)) {
+                    slot.mDelta = delta;
+                    slot.mSequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+                // on failure position is updated to the current rear, retry
+            } else if (diff < 0) {
+                return false;   // the observer has not yet drained this slot
+            } else {
+                position = mRear.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Observer APIs
+
+    // Call apply(const D&) for each pending delta in FIFO order, and return the number applied.
+    template<typename F>
+    size_t  drain(F apply) {
+        size_t count = 0;
+        for (;;) {
+            Slot& slot = mSlots[mFront & (kCapacity - 1)];
+            if (slot.mSequence.load(std::memory_order_acquire) != mFront + 1) {
+                break;          // empty, or a mutator has not completed its enqueue() yet
+            }
+            const D delta = slot.mDelta;
+            // release the slot before applying, so mutators can reuse it as soon as possible
+            slot.mSequence.store(mFront + kCapacity, std::memory_order_release);
+            ++mFront;
+            apply(delta);
+            ++count;
+        }
+        return count;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> mSequence;
+        D                   mDelta;
+    };
+    Slot                mSlots[kCapacity];
+
+    // written by mutators, on a separate cache line from the observer data
+    alignas(64) std::atomic<size_t> mRear{0};
+    // only used by observer
+    alignas(64) size_t  mFront = 0;
+
+};  // class StateDeltaQueue
+
 }   // namespace android
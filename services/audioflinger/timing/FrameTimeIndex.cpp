@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "FrameTimeIndex"
+
+#include <algorithm>
+
+#include <utils/Log.h>
+#include "FrameTimeIndex.h"
+
+namespace android::audioflinger {
+
+FrameTimeIndex::FrameTimeIndex(size_t capacity)
+    : mEntries(std::max(capacity, (size_t)1)) {
+}
+
+void FrameTimeIndex::add(int64_t frames, int64_t timeNs) {
+    if (mSize > 0 && timeNs <= at(mSize - 1).timeNs) {
+        ALOGV("%s: ignoring retrograde time %lld", __func__, (long long)timeNs);
+        return;
+    }
+    const int64_t monotonicFrames =
+            mFrameCounter.updateAndGetMonotonicFrameCount(frames, timeNs);
+    if (mSize == mEntries.size()) {
+        mOldest = (mOldest + 1) % mEntries.size();
+        --mSize;
+    }
+    mEntries[(mOldest + mSize) % mEntries.size()] = {monotonicFrames, timeNs};
+    ++mSize;
+}
+
+int64_t FrameTimeIndex::getFrameAt(int64_t timeNs, uint32_t sampleRate) const {
+    if (mSize == 0) {
+        return -1;
+    }
+    // Binary search for the first entry not before timeNs; times are increasing.
+    size_t low = 0;
+    size_t high = mSize;
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        if (at(mid).timeNs < timeNs) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low == mSize) {
+        return at(mSize - 1).frames;
+    }
+    const Entry& next = at(low);
+    if (low == 0) {
+        return next.frames;
+    }
+    const Entry& previous = at(low - 1);
+    const int64_t frames =
+            next.frames - (next.timeNs - timeNs) * (int64_t)sampleRate / 1'000'000'000;
+    return std::max(frames, previous.frames);
+}
+
+int64_t FrameTimeIndex::getLastFrame() const {
+    return mSize == 0 ? -1 : at(mSize - 1).frames;
+}
+
+void FrameTimeIndex::clear() {
+    mOldest = 0;
+    mSize = 0;
+}
+
+} // namespace android::audioflinger
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MonotonicFrameCounter.h"
+
+namespace android::audioflinger {
+
+/**
+ * FrameTimeIndex
+ *
+ * Keeps the times of the most recent frames of a capture, so that a time in the past
+ * can be converted to a frame position in the capture history.
+ *
+ * Timestamp pairs (frames, time) are added after each read, where frames is the count
+ * of frames read so far and time the CLOCK_MONOTONIC time of the frame that follows.
+ * The frame count is made monotonic with a MonotonicFrameCounter.
+ * Only the last capacity pairs are kept, which bounds the history that can be indexed.
+ *
+ * This class is not thread safe.
+ */
+class FrameTimeIndex {
+public:
+    /**
+     * \param capacity the maximum number of timestamp pairs kept, must be > 0.
+     */
+    explicit FrameTimeIndex(size_t capacity);
+
+    /**
+     * Adds a timestamp pair. Pairs whose time is not after that of the previous pair are ignored.
+     *
+     * \param frames the count of frames read.
+     * \param timeNs the time of the frame following the last frame read.
+     */
+    void add(int64_t frames, int64_t timeNs);
+
+    /**
+     * Returns the monotonic frame count of the frame captured at timeNs, or -1 if the index
+     * is empty.
+     *
+     * The frame is extrapolated backwards from the first pair after timeNs at sampleRate,
+     * but never before the previous pair, so a time during a gap in the capture returns
+     * the first frame after the gap.
+     * A time before the oldest pair returns the frame of the oldest pair, and a time
+     * after the last pair returns the frame of the last pair.
+     */
+    [[nodiscard]] int64_t getFrameAt(int64_t timeNs, uint32_t sampleRate) const;
+
+    /**
+     * Returns the last monotonic frame count added, or -1 if the index is empty.
+     */
+    [[nodiscard]] int64_t getLastFrame() const;
+
+    /**
+     * Discards all pairs, e.g. when the capture history is discarded.
+     * The monotonic frame count continues from its last value.
+     */
+    void clear();
+
+    [[nodiscard]] size_t size() const { return mSize; }
+
+private:
+    struct Entry {
+        int64_t frames;
+        int64_t timeNs;
+    };
+
+    // Returns the entry at index i from the oldest, i < mSize.
+    const Entry& at(size_t i) const { return mEntries[(mOldest + i) % mEntries.size()]; }
+
+    MonotonicFrameCounter mFrameCounter;
+    std::vector<Entry> mEntries;
+    size_t mOldest = 0;
+    size_t mSize = 0;
+};
+
+} // namespace android::audioflinger
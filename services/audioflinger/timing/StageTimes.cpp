@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "StageTimes.h"
+
+#include <algorithm>
+
+#include <android-base/stringprintf.h>
+
+namespace android::audioflinger {
+
+// static
+const char* StageTimes::stageToString(Stage stage) {
+    switch (stage) {
+        case STAGE_PREPARE: return "prepare";
+        case STAGE_MIX: return "mix";
+        case STAGE_EFFECTS: return "effects";
+        case STAGE_WRITE: return "write";
+        case STAGE_SLEEP: return "sleep";
+        default: return "unknown";
+    }
+}
+
+StageTimes::Percentiles StageTimes::getPercentiles(Stage stage) const {
+    Percentiles percentiles;
+    if (stage >= STAGE_COUNT) return percentiles;
+    const Ring& ring = mRings[stage];
+    const uint32_t position = ring.mPosition.load(std::memory_order_acquire);
+    const size_t count = std::min((size_t)position, kSamples);
+    if (count == 0) return percentiles;
+
+    std::array<uint32_t, kSamples> samples;
+    for (size_t i = 0; i < count; ++i) {
+        samples[i] = ring.mSamples[(position - 1 - i) & (kSamples - 1)].load(
+                std::memory_order_relaxed);
+    }
+    std::sort(samples.begin(), samples.begin() + count);
+    const auto at = [&](size_t permille) {
+        return (int64_t)samples[std::min(count * permille / 1000, count - 1)];
+    };
+    percentiles.count = count;
+    percentiles.p50Ns = at(500);
+    percentiles.p90Ns = at(900);
+    percentiles.p99Ns = at(990);
+    percentiles.maxNs = samples[count - 1];
+    return percentiles;
+}
+
+std::string StageTimes::toString(const std::string& prefix) const {
+    std::string result;
+    for (size_t i = 0; i < STAGE_COUNT; ++i) {
+        const auto stage = (Stage)i;
+        const Percentiles p = getPercentiles(stage);
+        if (p.count == 0) continue;
+        base::StringAppendF(&result,
+                "%s%-8s n=%-4zu p50=%.3f p90=%.3f p99=%.3f max=%.3f ms\n",
+                prefix.c_str(), stageToString(stage), p.count,
+                p.p50Ns * 1e-6, p.p90Ns * 1e-6, p.p99Ns * 1e-6, p.maxNs * 1e-6);
+    }
+    return result;
+}
+
+}  // namespace android::audioflinger
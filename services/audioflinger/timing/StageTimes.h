@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace android::audioflinger {
+
+/**
+ * StageTimes
+ *
+ * Keeps the most recent durations of each stage of a PlaybackThread loop cycle
+ * (prepare, mix, effect chains, sink write, sleep), so that the distribution of each
+ * stage can be reported in dumpsys and mediametrics.
+ *
+ * Durations are written by a single thread (the thread loop) with record(),
+ * which is lock-free and wait-free: it stores the sample in a ring and publishes
+ * the ring position.  Any thread may call getPercentiles() and toString()
+ * concurrently; those take a copy of the ring and may therefore observe
+ * a sample that is being overwritten, which is acceptable for statistics.
+ */
+class StageTimes {
+public:
+    enum Stage : size_t {
+        STAGE_PREPARE,  // prepareTracks_l() and related updates under the thread mutex
+        STAGE_MIX,      // threadLoop_mix() or threadLoop_sleepTime(), and mixer buffer copy
+        STAGE_EFFECTS,  // effect chains process_l() and effect buffer copy
+        STAGE_WRITE,    // threadLoop_write() to the sink
+        STAGE_SLEEP,    // waiting for the next cycle, including throttling
+        STAGE_COUNT,
+    };
+
+    // Number of recent samples retained per stage, must be a power of 2.
+    static constexpr size_t kSamples = 256;
+    static_assert((kSamples & (kSamples - 1)) == 0);
+
+    struct Percentiles {
+        size_t count = 0;     // number of samples the percentiles are computed from
+        int64_t p50Ns = 0;
+        int64_t p90Ns = 0;
+        int64_t p99Ns = 0;
+        int64_t maxNs = 0;
+    };
+
+    [[nodiscard]] static const char* stageToString(Stage stage);
+
+    // Called by the thread loop only.
+    void record(Stage stage, int64_t durationNs) {
+        if (stage >= STAGE_COUNT) return;
+        Ring& ring = mRings[stage];
+        const uint32_t position = ring.mPosition.load(std::memory_order_relaxed);
+        // durations above ~4 seconds saturate, and a backward clock counts as 0.
+        const uint32_t sample = durationNs <= 0 ? 0
+                : durationNs >= UINT32_MAX ? UINT32_MAX : (uint32_t)durationNs;
+        ring.mSamples[position & (kSamples - 1)].store(sample, std::memory_order_relaxed);
+        ring.mPosition.store(position + 1, std::memory_order_release);
+    }
+
+    // Returns the percentiles of the last kSamples durations of the stage.
+    [[nodiscard]] Percentiles getPercentiles(Stage stage) const;
+
+    // Returns one line per stage with the count and percentiles in milliseconds.
+    [[nodiscard]] std::string toString(const std::string& prefix = {}) const;
+
+private:
+    struct Ring {
+        std::atomic<uint32_t> mPosition{}; // total number of samples recorded, wraps
+        std::array<std::atomic<uint32_t>, kSamples> mSamples{};
+    };
+    std::array<Ring, STAGE_COUNT> mRings;
+};
+
+}  // namespace android::audioflinger
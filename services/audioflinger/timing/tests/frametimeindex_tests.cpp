@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "frametimeindex_tests"
+
+#include "../FrameTimeIndex.h"
+
+#include <gtest/gtest.h>
+
+using namespace android::audioflinger;
+
+namespace {
+
+constexpr uint32_t kSampleRate = 48000;
+constexpr int64_t kFramesPerRead = 480;          // 10 ms
+constexpr int64_t kNsPerRead = 10'000'000;
+
+TEST(FrameTimeIndexTest, Empty) {
+    FrameTimeIndex index(4 /* capacity */);
+    ASSERT_EQ(0U, index.size());
+    ASSERT_EQ(-1, index.getFrameAt(0, kSampleRate));
+    ASSERT_EQ(-1, index.getLastFrame());
+}
+
+TEST(FrameTimeIndexTest, Interpolation) {
+    FrameTimeIndex index(8 /* capacity */);
+    for (int64_t i = 1; i <= 4; ++i) {
+        index.add(i * kFramesPerRead, i * kNsPerRead);
+    }
+    ASSERT_EQ(4 * kFramesPerRead, index.getLastFrame());
+    // exact pairs
+    ASSERT_EQ(2 * kFramesPerRead, index.getFrameAt(2 * kNsPerRead, kSampleRate));
+    // 5 ms before the third pair
+    ASSERT_EQ(3 * kFramesPerRead - kFramesPerRead / 2,
+            index.getFrameAt(3 * kNsPerRead - kNsPerRead / 2, kSampleRate));
+    // before the oldest pair, and after the last pair
+    ASSERT_EQ(kFramesPerRead, index.getFrameAt(0, kSampleRate));
+    ASSERT_EQ(4 * kFramesPerRead, index.getFrameAt(10 * kNsPerRead, kSampleRate));
+}
+
+TEST(FrameTimeIndexTest, Gap) {
+    FrameTimeIndex index(8 /* capacity */);
+    index.add(kFramesPerRead, kNsPerRead);
+    // capture stopped for 1 second, then one read
+    index.add(2 * kFramesPerRead, 102 * kNsPerRead);
+    // during the gap, the first frame after the gap
+    ASSERT_EQ(kFramesPerRead, index.getFrameAt(50 * kNsPerRead, kSampleRate));
+    ASSERT_EQ(kFramesPerRead + kFramesPerRead / 2,
+            index.getFrameAt(102 * kNsPerRead - kNsPerRead / 2, kSampleRate));
+}
+
+TEST(FrameTimeIndexTest, Capacity) {
+    FrameTimeIndex index(4 /* capacity */);
+    for (int64_t i = 1; i <= 10; ++i) {
+        index.add(i * kFramesPerRead, i * kNsPerRead);
+    }
+    ASSERT_EQ(4U, index.size());
+    // only the last 4 pairs are kept
+    ASSERT_EQ(7 * kFramesPerRead, index.getFrameAt(0, kSampleRate));
+    ASSERT_EQ(10 * kFramesPerRead, index.getLastFrame());
+}
+
+TEST(FrameTimeIndexTest, InvalidData) {
+    FrameTimeIndex index(4 /* capacity */);
+    index.add(kFramesPerRead, 2 * kNsPerRead);
+    index.add(2 * kFramesPerRead, kNsPerRead);      // retrograde time, ignored
+    ASSERT_EQ(1U, index.size());
+    index.add(kFramesPerRead / 2, 3 * kNsPerRead);  // retrograde frames, stays monotonic
+    ASSERT_EQ(kFramesPerRead, index.getLastFrame());
+}
+
+TEST(FrameTimeIndexTest, Clear) {
+    FrameTimeIndex index(4 /* capacity */);
+    index.add(kFramesPerRead, kNsPerRead);
+    index.clear();
+    ASSERT_EQ(0U, index.size());
+    ASSERT_EQ(-1, index.getFrameAt(kNsPerRead, kSampleRate));
+    index.add(2 * kFramesPerRead, 2 * kNsPerRead);
+    ASSERT_EQ(2 * kFramesPerRead, index.getLastFrame());
+}
+
+} // namespace
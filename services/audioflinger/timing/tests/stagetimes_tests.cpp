@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "stagetimes_tests"
+
+#include "../StageTimes.h"
+
+#include <atomic>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using namespace android::audioflinger;
+
+namespace {
+
+TEST(StageTimesTest, Empty) {
+    StageTimes stageTimes;
+    for (size_t i = 0; i < StageTimes::STAGE_COUNT; ++i) {
+        const auto p = stageTimes.getPercentiles((StageTimes::Stage)i);
+        ASSERT_EQ(0U, p.count);
+        ASSERT_EQ(0, p.maxNs);
+    }
+    ASSERT_TRUE(stageTimes.toString().empty());
+}
+
+TEST(StageTimesTest, Percentiles) {
+    StageTimes stageTimes;
+    // record 1..100 in reverse order.
+    for (int64_t i = 100; i > 0; --i) {
+        stageTimes.record(StageTimes::STAGE_MIX, i * 1000);
+    }
+    const auto p = stageTimes.getPercentiles(StageTimes::STAGE_MIX);
+    ASSERT_EQ(100U, p.count);
+    ASSERT_EQ(51'000, p.p50Ns);
+    ASSERT_EQ(91'000, p.p90Ns);
+    ASSERT_EQ(100'000, p.p99Ns);
+    ASSERT_EQ(100'000, p.maxNs);
+
+    // other stages are unaffected.
+    ASSERT_EQ(0U, stageTimes.getPercentiles(StageTimes::STAGE_WRITE).count);
+    const std::string s = stageTimes.toString("  ");
+    ASSERT_NE(std::string::npos, s.find("mix"));
+    ASSERT_EQ(std::string::npos, s.find("write"));
+}
+
+TEST(StageTimesTest, Wraparound) {
+    StageTimes stageTimes;
+    // old large samples are overwritten by the most recent kSamples.
+    for (size_t i = 0; i < StageTimes::kSamples; ++i) {
+        stageTimes.record(StageTimes::STAGE_WRITE, 1'000'000'000);
+    }
+    for (size_t i = 0; i < StageTimes::kSamples; ++i) {
+        stageTimes.record(StageTimes::STAGE_WRITE, 10);
+    }
+    const auto p = stageTimes.getPercentiles(StageTimes::STAGE_WRITE);
+    ASSERT_EQ(StageTimes::kSamples, p.count);
+    ASSERT_EQ(10, p.maxNs);
+}
+
+TEST(StageTimesTest, Saturation) {
+    StageTimes stageTimes;
+    stageTimes.record(StageTimes::STAGE_SLEEP, -5);
+    stageTimes.record(StageTimes::STAGE_SLEEP, INT64_MAX);
+    const auto p = stageTimes.getPercentiles(StageTimes::STAGE_SLEEP);
+    ASSERT_EQ(2U, p.count);
+    ASSERT_EQ((int64_t)UINT32_MAX, p.maxNs);
+    ASSERT_EQ((int64_t)UINT32_MAX, p.p50Ns);
+    ASSERT_EQ((int64_t)UINT32_MAX, p.p99Ns);
+}
+
+TEST(StageTimesTest, ConcurrentReader) {
+    StageTimes stageTimes;
+    std::atomic_bool done = false;
+    std::thread reader([&] {
+        while (!done) {
+            const auto p = stageTimes.getPercentiles(StageTimes::STAGE_EFFECTS);
+            // all samples are in [1, 1000].
+            if (p.count > 0) {
+                ASSERT_LE(p.p50Ns, p.maxNs);
+                ASSERT_LE(p.maxNs, 1000);
+                ASSERT_GE(p.p50Ns, 1);
+            }
+        }
+    });
+    for (int64_t i = 0; i < 100'000; ++i) {
+        stageTimes.record(StageTimes::STAGE_EFFECTS, i % 1000 + 1);
+    }
+    done = true;
+    reader.join();
+    ASSERT_EQ(StageTimes::kSamples, stageTimes.getPercentiles(StageTimes::STAGE_EFFECTS).count);
+}
+
+} // namespace
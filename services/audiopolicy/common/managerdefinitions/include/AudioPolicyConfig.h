@@ -49,6 +49,9 @@ public:
     static const constexpr char* const kDefaultConfigSource = "AudioPolicyConfig::setDefault";
     // The suffix of the "engine default" implementation shared library name.
     static const constexpr char* const kDefaultEngineLibraryNameSuffix = "default";
+    // Where the configuration loaded from the XML file is cached for the next audioserver start.
+    static const constexpr char* const kDefaultXmlCacheFilePath =
+            "/data/misc/audioserver/audio_policy_configuration.cache";
 
     // Creates the default (fallback) configuration.
     static sp<const AudioPolicyConfig> createDefault();
@@ -57,13 +60,18 @@ public:
             const media::AudioPolicyConfig& aidl);
     // Attempts to load the configuration from the XML file, falls back to default on failure.
     // If the XML file path is not provided, uses `audio_get_audio_policy_config_file` function.
+    // The XML file is only parsed if the cache file does not hold a configuration loaded from
+    // the same files by the same build, and then the cache file is rewritten. An empty cache
+    // file path disables the cache.
     static sp<const AudioPolicyConfig> loadFromApmXmlConfigWithFallback(
-            const std::string& xmlFilePath = "");
+            const std::string& xmlFilePath = "",
+            const std::string& cacheFilePath = kDefaultXmlCacheFilePath);
     // The factory method to use in APM tests which craft the configuration manually.
     static sp<AudioPolicyConfig> createWritableForTests();
-    // The factory method to use in APM tests which use a custom XML file.
+    // The factory method to use in APM tests which use a custom XML file. The cache file is
+    // used as in loadFromApmXmlConfigWithFallback.
     static error::Result<sp<AudioPolicyConfig>> loadFromCustomXmlConfigForTests(
-            const std::string& xmlFilePath);
+            const std::string& xmlFilePath, const std::string& cacheFilePath = "");
     // The factory method to use in VTS tests. If the 'configPath' is empty,
     // it is determined automatically from the list of known config paths.
     static error::Result<sp<AudioPolicyConfig>> loadFromCustomXmlConfigForVtsTests(
@@ -147,7 +155,11 @@ private:
 
     void augmentData();
     status_t loadFromAidl(const media::AudioPolicyConfig& aidl);
-    status_t loadFromXml(const std::string& xmlFilePath, bool forVts);
+    status_t loadFromXml(const std::string& xmlFilePath, bool forVts,
+            const std::string& cacheFilePath = "");
+    status_t loadFromXmlCache(const std::string& xmlFilePath, const std::string& cacheFilePath);
+    status_t writeXmlCache(const std::vector<std::string>& sourceFiles,
+            const std::string& cacheFilePath) const;
 
     std::string mSource;  // Not kDefaultConfigSource. Empty source means an empty config.
     std::string mEngineLibraryNameSuffix = kDefaultEngineLibraryNameSuffix;
@@ -16,9 +16,17 @@
 
 #define LOG_TAG "APM_Config"
 
+#include <stdio.h>
+#include <unistd.h>
+
+#include <map>
+
 #include <AudioPolicyConfig.h>
 #include <IOProfile.h>
 #include <Serializer.h>
+#include <android-base/file.h>
+#include <android-base/properties.h>
+#include <binder/Parcel.h>
 #include <hardware/audio.h>
 #include <media/AidlConversion.h>
 #include <media/AidlConversionUtil.h>
@@ -175,6 +183,72 @@ aidl2legacy_SurroundSoundConfig_SurroundFormats(const media::SurroundSoundConfig
             aidl2legacy_SurroundFormatFamily);
 };
 
+// The XML cache starts with these, the build fingerprint, and the files the configuration
+// was read from with a hash of their content. Bump the version on any change in the layout
+// of the cache, or in what the XML deserializer builds from a given file.
+constexpr int32_t kXmlCacheMagic = 0x41504343;  // 'APCC'
+constexpr int32_t kXmlCacheVersion = 1;
+
+// FNV-1a, which unlike std::hash does not depend on the C++ library version.
+int64_t hashXmlCacheSource(const std::string& content) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : content) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return static_cast<int64_t>(hash);
+}
+
+status_t writeXmlCacheHeader(Parcel* parcel, const std::vector<std::string>& sourceFiles) {
+    RETURN_STATUS_IF_ERROR(parcel->writeInt32(kXmlCacheMagic));
+    RETURN_STATUS_IF_ERROR(parcel->writeInt32(kXmlCacheVersion));
+    RETURN_STATUS_IF_ERROR(parcel->writeUtf8AsUtf16(
+            base::GetProperty("ro.build.fingerprint", "")));
+    RETURN_STATUS_IF_ERROR(parcel->writeInt32(sourceFiles.size()));
+    for (const auto& path : sourceFiles) {
+        std::string content;
+        if (!base::ReadFileToString(path, &content)) {
+            ALOGW("%s: could not read \"%s\"", __func__, path.c_str());
+            return BAD_VALUE;
+        }
+        RETURN_STATUS_IF_ERROR(parcel->writeUtf8AsUtf16(path));
+        RETURN_STATUS_IF_ERROR(parcel->writeInt64(hashXmlCacheSource(content)));
+    }
+    return OK;
+}
+
+// Fails unless the cache was written by this build from the current content of 'xmlFilePath'
+// and the files it includes.
+status_t checkXmlCacheHeader(const Parcel& parcel, const std::string& xmlFilePath) {
+    int32_t magic, version;
+    RETURN_STATUS_IF_ERROR(parcel.readInt32(&magic));
+    RETURN_STATUS_IF_ERROR(parcel.readInt32(&version));
+    if (magic != kXmlCacheMagic || version != kXmlCacheVersion) {
+        return BAD_VALUE;
+    }
+    std::string fingerprint;
+    RETURN_STATUS_IF_ERROR(parcel.readUtf8FromUtf16(&fingerprint));
+    if (fingerprint != base::GetProperty("ro.build.fingerprint", "")) {
+        return BAD_VALUE;
+    }
+    int32_t fileCount;
+    RETURN_STATUS_IF_ERROR(parcel.readInt32(&fileCount));
+    if (fileCount <= 0) {
+        return BAD_VALUE;
+    }
+    for (int32_t i = 0; i < fileCount; ++i) {
+        std::string path, content;
+        int64_t hash;
+        RETURN_STATUS_IF_ERROR(parcel.readUtf8FromUtf16(&path));
+        RETURN_STATUS_IF_ERROR(parcel.readInt64(&hash));
+        if ((i == 0 && path != xmlFilePath) || !base::ReadFileToString(path, &content)
+                || hashXmlCacheSource(content) != hash) {
+            return BAD_VALUE;
+        }
+    }
+    return OK;
+}
+
 }  // namespace
 
 // static
@@ -196,11 +270,12 @@ sp<const AudioPolicyConfig> AudioPolicyConfig::loadFromApmAidlConfigWithFallback
 
 // static
 sp<const AudioPolicyConfig> AudioPolicyConfig::loadFromApmXmlConfigWithFallback(
-        const std::string& xmlFilePath) {
+        const std::string& xmlFilePath, const std::string& cacheFilePath) {
     const std::string filePath =
             xmlFilePath.empty() ? audio_get_audio_policy_config_file() : xmlFilePath;
     auto config = sp<AudioPolicyConfig>::make();
-    if (status_t status = config->loadFromXml(filePath, false /*forVts*/); status == NO_ERROR) {
+    if (status_t status = config->loadFromXml(filePath, false /*forVts*/, cacheFilePath);
+            status == NO_ERROR) {
         return config;
     }
     return createDefault();
@@ -213,9 +288,10 @@ sp<AudioPolicyConfig> AudioPolicyConfig::createWritableForTests() {
 
 // static
 error::Result<sp<AudioPolicyConfig>> AudioPolicyConfig::loadFromCustomXmlConfigForTests(
-        const std::string& xmlFilePath) {
+        const std::string& xmlFilePath, const std::string& cacheFilePath) {
     auto config = sp<AudioPolicyConfig>::make();
-    if (status_t status = config->loadFromXml(xmlFilePath, false /*forVts*/); status == NO_ERROR) {
+    if (status_t status = config->loadFromXml(xmlFilePath, false /*forVts*/, cacheFilePath);
+            status == NO_ERROR) {
         return config;
     } else {
         return base::unexpected(status);
@@ -273,14 +349,33 @@ status_t AudioPolicyConfig::loadFromAidl(const media::AudioPolicyConfig& aidl) {
     return NO_ERROR;
 }
 
-status_t AudioPolicyConfig::loadFromXml(const std::string& xmlFilePath, bool forVts) {
+status_t AudioPolicyConfig::loadFromXml(const std::string& xmlFilePath, bool forVts,
+        const std::string& cacheFilePath) {
     if (xmlFilePath.empty()) {
         ALOGE("Audio policy configuration file name is empty");
         return BAD_VALUE;
     }
+    const bool useCache = !forVts && !cacheFilePath.empty();
+    if (useCache && loadFromXmlCache(xmlFilePath, cacheFilePath) == NO_ERROR) {
+        ALOGI("Loaded audio policy configuration \"%s\" from \"%s\"",
+                xmlFilePath.c_str(), cacheFilePath.c_str());
+        mSource = xmlFilePath;
+        augmentData();
+        return NO_ERROR;
+    }
+    std::vector<std::string> sourceFiles;
     status_t status = forVts ? deserializeAudioPolicyFileForVts(xmlFilePath.c_str(), this)
-            : deserializeAudioPolicyFile(xmlFilePath.c_str(), this);
+            : deserializeAudioPolicyFile(xmlFilePath.c_str(), this,
+                    useCache ? &sourceFiles : nullptr);
     if (status == NO_ERROR) {
+        // Before augmentData(), which is applied again after reading the cache.
+        if (useCache) {
+            if (status_t cacheStatus = writeXmlCache(sourceFiles, cacheFilePath);
+                    cacheStatus != NO_ERROR) {
+                ALOGW("Could not write the audio policy configuration cache \"%s\": %d",
+                        cacheFilePath.c_str(), cacheStatus);
+            }
+        }
         mSource = xmlFilePath;
         augmentData();
     } else {
@@ -290,6 +385,260 @@ status_t AudioPolicyConfig::loadFromXml(const std::string& xmlFilePath, bool for
     return status;
 }
 
+status_t AudioPolicyConfig::loadFromXmlCache(
+        const std::string& xmlFilePath, const std::string& cacheFilePath) {
+    std::string data;
+    if (!base::ReadFileToString(cacheFilePath, &data)) {
+        return NAME_NOT_FOUND;
+    }
+    Parcel parcel;
+    RETURN_STATUS_IF_ERROR(parcel.setData(
+            reinterpret_cast<const uint8_t*>(data.data()), data.size()));
+    if (status_t status = checkXmlCacheHeader(parcel, xmlFilePath); status != OK) {
+        ALOGI("%s: \"%s\" is stale or invalid", __func__, cacheFilePath.c_str());
+        return status;
+    }
+
+    // Nothing is set until the whole cache is read, so that the XML file can be loaded instead.
+    std::string engineLibraryNameSuffix;
+    bool isCallScreenModeSupported;
+    RETURN_STATUS_IF_ERROR(parcel.readUtf8FromUtf16(&engineLibraryNameSuffix));
+    RETURN_STATUS_IF_ERROR(parcel.readBool(&isCallScreenModeSupported));
+    SurroundFormats surroundFormats;
+    int32_t surroundFormatCount;
+    RETURN_STATUS_IF_ERROR(parcel.readInt32(&surroundFormatCount));
+    for (int32_t i = 0; i < surroundFormatCount; ++i) {
+        uint32_t format;
+        int32_t subFormatCount;
+        RETURN_STATUS_IF_ERROR(parcel.readUint32(&format));
+        RETURN_STATUS_IF_ERROR(parcel.readInt32(&subFormatCount));
+        auto& subFormats = surroundFormats[static_cast<audio_format_t>(format)];
+        for (int32_t j = 0; j < subFormatCount; ++j) {
+            uint32_t subFormat;
+            RETURN_STATUS_IF_ERROR(parcel.readUint32(&subFormat));
+            subFormats.insert(static_cast<audio_format_t>(subFormat));
+        }
+    }
+
+    HwModuleCollection hwModules;
+    // The ports of each module in the order they were written, mix ports first.
+    std::vector<std::vector<sp<PolicyAudioPort>>> modulePorts;
+    std::vector<std::vector<sp<DeviceDescriptor>>> moduleDevices;
+    int32_t moduleCount;
+    RETURN_STATUS_IF_ERROR(parcel.readInt32(&moduleCount));
+    for (int32_t m = 0; m < moduleCount; ++m) {
+        std::string name;
+        uint32_t versionMajor, versionMinor;
+        RETURN_STATUS_IF_ERROR(parcel.readUtf8FromUtf16(&name));
+        RETURN_STATUS_IF_ERROR(parcel.readUint32(&versionMajor));
+        RETURN_STATUS_IF_ERROR(parcel.readUint32(&versionMinor));
+        auto module = sp<HwModule>::make(name.c_str(), versionMajor, versionMinor);
+        auto& ports = modulePorts.emplace_back();
+        auto& devices = moduleDevices.emplace_back();
+
+        IOProfileCollection mixPorts;
+        int32_t mixPortCount;
+        RETURN_STATUS_IF_ERROR(parcel.readInt32(&mixPortCount));
+        for (int32_t i = 0; i < mixPortCount; ++i) {
+            media::AudioPortFw fwPort;
+            RETURN_STATUS_IF_ERROR(parcel.readParcelable(&fwPort));
+            auto mixPort = sp<IOProfile>::make("", AUDIO_PORT_ROLE_NONE);
+            RETURN_STATUS_IF_ERROR(mixPort->readFromParcelable(fwPort));
+            mixPorts.add(mixPort);
+            ports.push_back(mixPort);
+        }
+        module->setProfiles(mixPorts);
+
+        DeviceVector devicePorts;
+        int32_t devicePortCount;
+        RETURN_STATUS_IF_ERROR(parcel.readInt32(&devicePortCount));
+        for (int32_t i = 0; i < devicePortCount; ++i) {
+            std::string tagName;
+            media::AudioPortFw fwPort;
+            RETURN_STATUS_IF_ERROR(parcel.readUtf8FromUtf16(&tagName));
+            RETURN_STATUS_IF_ERROR(parcel.readParcelable(&fwPort));
+            auto devicePort = sp<DeviceDescriptor>::make(AUDIO_DEVICE_NONE, tagName);
+            RETURN_STATUS_IF_ERROR(devicePort->readFromParcelable(fwPort));
+            devicePorts.add(devicePort);
+            devices.push_back(devicePort);
+            ports.push_back(devicePort);
+        }
+        module->setDeclaredDevices(devicePorts);
+
+        auto readPort = [&parcel, &ports](sp<PolicyAudioPort>* port) -> status_t {
+            int32_t index;
+            RETURN_STATUS_IF_ERROR(parcel.readInt32(&index));
+            if (index < 0 || static_cast<size_t>(index) >= ports.size()) {
+                return BAD_VALUE;
+            }
+            *port = ports[index];
+            return OK;
+        };
+        AudioRouteVector routes;
+        int32_t routeCount;
+        RETURN_STATUS_IF_ERROR(parcel.readInt32(&routeCount));
+        for (int32_t i = 0; i < routeCount; ++i) {
+            int32_t type, sourceCount;
+            sp<PolicyAudioPort> sink;
+            RETURN_STATUS_IF_ERROR(parcel.readInt32(&type));
+            RETURN_STATUS_IF_ERROR(readPort(&sink));
+            RETURN_STATUS_IF_ERROR(parcel.readInt32(&sourceCount));
+            PolicyAudioPortVector sources;
+            for (int32_t j = 0; j < sourceCount; ++j) {
+                sp<PolicyAudioPort> source;
+                RETURN_STATUS_IF_ERROR(readPort(&source));
+                sources.add(source);
+            }
+            // Same as the XML deserializer.
+            auto route = sp<AudioRoute>::make(static_cast<audio_route_type_t>(type));
+            route->setSink(sink);
+            sink->addRoute(route);
+            for (const auto& source : sources) {
+                source->addRoute(route);
+            }
+            route->setSources(sources);
+            routes.add(route);
+        }
+        module->setRoutes(routes);
+        hwModules.add(module);
+    }
+
+    auto readDevice = [&parcel, &moduleDevices](sp<DeviceDescriptor>* device) -> status_t {
+        int32_t module, index;
+        RETURN_STATUS_IF_ERROR(parcel.readInt32(&module));
+        RETURN_STATUS_IF_ERROR(parcel.readInt32(&index));
+        if (module < 0 || static_cast<size_t>(module) >= moduleDevices.size()
+                || index < 0 || static_cast<size_t>(index) >= moduleDevices[module].size()) {
+            return BAD_VALUE;
+        }
+        *device = moduleDevices[module][index];
+        return OK;
+    };
+    DeviceVector attachedDevices;
+    int32_t attachedDeviceCount;
+    RETURN_STATUS_IF_ERROR(parcel.readInt32(&attachedDeviceCount));
+    for (int32_t i = 0; i < attachedDeviceCount; ++i) {
+        sp<DeviceDescriptor> device;
+        RETURN_STATUS_IF_ERROR(readDevice(&device));
+        attachedDevices.add(device);
+    }
+    bool hasDefaultOutputDevice;
+    sp<DeviceDescriptor> defaultOutputDevice;
+    RETURN_STATUS_IF_ERROR(parcel.readBool(&hasDefaultOutputDevice));
+    if (hasDefaultOutputDevice) {
+        RETURN_STATUS_IF_ERROR(readDevice(&defaultOutputDevice));
+    }
+
+    mEngineLibraryNameSuffix = engineLibraryNameSuffix;
+    mIsCallScreenModeSupported = isCallScreenModeSupported;
+    mSurroundFormats = std::move(surroundFormats);
+    mHwModules = hwModules;
+    for (const auto& device : attachedDevices) {
+        addDevice(device);
+    }
+    mDefaultOutputDevice = defaultOutputDevice;
+    return NO_ERROR;
+}
+
+status_t AudioPolicyConfig::writeXmlCache(const std::vector<std::string>& sourceFiles,
+        const std::string& cacheFilePath) const {
+    Parcel parcel;
+    RETURN_STATUS_IF_ERROR(writeXmlCacheHeader(&parcel, sourceFiles));
+
+    RETURN_STATUS_IF_ERROR(parcel.writeUtf8AsUtf16(mEngineLibraryNameSuffix));
+    RETURN_STATUS_IF_ERROR(parcel.writeBool(mIsCallScreenModeSupported));
+    RETURN_STATUS_IF_ERROR(parcel.writeInt32(mSurroundFormats.size()));
+    for (const auto& [format, subFormats] : mSurroundFormats) {
+        RETURN_STATUS_IF_ERROR(parcel.writeUint32(format));
+        RETURN_STATUS_IF_ERROR(parcel.writeInt32(subFormats.size()));
+        for (audio_format_t subFormat : subFormats) {
+            RETURN_STATUS_IF_ERROR(parcel.writeUint32(subFormat));
+        }
+    }
+
+    // Ports are written as their index in the module, mix ports first, and devices outside
+    // of a module as their module index and index among the module device ports.
+    std::map<const DeviceDescriptor*, std::pair<int32_t, int32_t>> deviceIndexes;
+    RETURN_STATUS_IF_ERROR(parcel.writeInt32(mHwModules.size()));
+    for (size_t m = 0; m < mHwModules.size(); ++m) {
+        const sp<HwModule>& module = mHwModules[m];
+        RETURN_STATUS_IF_ERROR(parcel.writeUtf8AsUtf16(std::string(module->getName())));
+        RETURN_STATUS_IF_ERROR(parcel.writeUint32(module->getHalVersionMajor()));
+        RETURN_STATUS_IF_ERROR(parcel.writeUint32(module->getHalVersionMinor()));
+        std::map<const PolicyAudioPort*, int32_t> portIndexes;
+
+        IOProfileCollection mixPorts = module->getOutputProfiles();
+        mixPorts.appendVector(module->getInputProfiles());
+        RETURN_STATUS_IF_ERROR(parcel.writeInt32(mixPorts.size()));
+        for (const auto& mixPort : mixPorts) {
+            media::AudioPortFw fwPort;
+            RETURN_STATUS_IF_ERROR(mixPort->writeToParcelable(&fwPort));
+            RETURN_STATUS_IF_ERROR(parcel.writeParcelable(fwPort));
+            portIndexes.emplace(mixPort.get(), portIndexes.size());
+        }
+
+        const DeviceVector& devicePorts = module->getDeclaredDevices();
+        RETURN_STATUS_IF_ERROR(parcel.writeInt32(devicePorts.size()));
+        for (size_t i = 0; i < devicePorts.size(); ++i) {
+            const sp<DeviceDescriptor>& devicePort = devicePorts[i];
+            media::AudioPortFw fwPort;
+            RETURN_STATUS_IF_ERROR(devicePort->writeToParcelable(&fwPort));
+            RETURN_STATUS_IF_ERROR(parcel.writeUtf8AsUtf16(devicePort->getTagName()));
+            RETURN_STATUS_IF_ERROR(parcel.writeParcelable(fwPort));
+            portIndexes.emplace(devicePort.get(), portIndexes.size());
+            deviceIndexes.emplace(devicePort.get(), std::make_pair(m, i));
+        }
+
+        auto writePort = [&parcel, &portIndexes](const sp<PolicyAudioPort>& port) -> status_t {
+            auto it = portIndexes.find(port.get());
+            return it != portIndexes.end() ? parcel.writeInt32(it->second) : BAD_VALUE;
+        };
+        const AudioRouteVector& routes = module->getRoutes();
+        RETURN_STATUS_IF_ERROR(parcel.writeInt32(routes.size()));
+        for (const auto& route : routes) {
+            RETURN_STATUS_IF_ERROR(parcel.writeInt32(route->getType()));
+            RETURN_STATUS_IF_ERROR(writePort(route->getSink()));
+            RETURN_STATUS_IF_ERROR(parcel.writeInt32(route->getSources().size()));
+            for (const auto& source : route->getSources()) {
+                RETURN_STATUS_IF_ERROR(writePort(source));
+            }
+        }
+    }
+
+    auto writeDevice = [&parcel, &deviceIndexes](
+            const sp<DeviceDescriptor>& device) -> status_t {
+        auto it = deviceIndexes.find(device.get());
+        if (it == deviceIndexes.end()) {
+            return BAD_VALUE;
+        }
+        RETURN_STATUS_IF_ERROR(parcel.writeInt32(it->second.first));
+        return parcel.writeInt32(it->second.second);
+    };
+    RETURN_STATUS_IF_ERROR(parcel.writeInt32(mInputDevices.size() + mOutputDevices.size()));
+    for (const DeviceVector* devices : {&mInputDevices, &mOutputDevices}) {
+        for (const auto& device : *devices) {
+            RETURN_STATUS_IF_ERROR(writeDevice(device));
+        }
+    }
+    RETURN_STATUS_IF_ERROR(parcel.writeBool(mDefaultOutputDevice != nullptr));
+    if (mDefaultOutputDevice != nullptr) {
+        RETURN_STATUS_IF_ERROR(writeDevice(mDefaultOutputDevice));
+    }
+
+    // Written aside and renamed, so that a crash never leaves a partial cache.
+    const std::string tmpFilePath = cacheFilePath + ".tmp";
+    if (!base::WriteStringToFile(std::string(
+                    reinterpret_cast<const char*>(parcel.data()), parcel.dataSize()),
+                    tmpFilePath)) {
+        return INVALID_OPERATION;
+    }
+    if (rename(tmpFilePath.c_str(), cacheFilePath.c_str()) != 0) {
+        unlink(tmpFilePath.c_str());
+        return INVALID_OPERATION;
+    }
+    return NO_ERROR;
+}
+
 void AudioPolicyConfig::setDefault() {
     mSource = kDefaultConfigSource;
     mEngineLibraryNameSuffix = kDefaultEngineLibraryNameSuffix;
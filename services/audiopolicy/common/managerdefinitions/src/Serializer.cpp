@@ -24,6 +24,7 @@
 
 #include <libxml/parser.h>
 #include <libxml/xinclude.h>
+#include <libxml/uri.h>
 #include <media/convert.h>
 #include <utils/Log.h>
 #include <utils/StrongPointer.h>
@@ -230,7 +231,8 @@ class PolicySerializer
 {
 public:
     status_t deserialize(const char *configFile, AudioPolicyConfig *config,
-            bool ignoreVendorExtensions = false);
+            bool ignoreVendorExtensions = false,
+            std::vector<std::string> *sourceFiles = nullptr);
 
     template <class Trait>
     status_t deserializeCollection(const xmlNode *cur,
@@ -291,6 +293,29 @@ std::string getXmlAttribute(const xmlNode *cur, const char *attribute)
     return value;
 }
 
+// Appends the files included by XInclude nodes under 'cur', as resolved by
+// xmlXIncludeProcess(), which keeps the include element as an XML_XINCLUDE_START node.
+void collectIncludedFiles(const xmlNode *cur, std::vector<std::string> *files)
+{
+    for (; cur != NULL; cur = cur->next) {
+        if (cur->type == XML_XINCLUDE_START) {
+            // This is not an element node anymore, xmlGetProp() would not find the attribute.
+            for (const xmlAttr *attr = cur->properties; attr != NULL; attr = attr->next) {
+                if (xmlStrcmp(attr->name, reinterpret_cast<const xmlChar*>("href"))) {
+                    continue;
+                }
+                auto href = make_xmlUnique(xmlNodeListGetString(cur->doc, attr->children, 1));
+                auto base = make_xmlUnique(xmlNodeGetBase(cur->doc, cur));
+                auto uri = make_xmlUnique(xmlBuildURI(href.get(), base.get()));
+                if (uri != nullptr) {
+                    files->push_back(reinterpret_cast<const char*>(uri.get()));
+                }
+            }
+        }
+        collectIncludedFiles(cur->children, files);
+    }
+}
+
 template <class Trait>
 const xmlNode* getReference(const xmlNode *cur, const std::string &refName)
 {
@@ -853,7 +878,8 @@ PolicySerializer::deserialize<SurroundSoundFormatTraits>(
 }
 
 status_t PolicySerializer::deserialize(const char *configFile, AudioPolicyConfig *config,
-                                       bool ignoreVendorExtensions)
+                                       bool ignoreVendorExtensions,
+                                       std::vector<std::string> *sourceFiles)
 {
     mIgnoreVendorExtensions = ignoreVendorExtensions;
     auto doc = make_xmlUnique(xmlParseFile(configFile));
@@ -869,6 +895,10 @@ status_t PolicySerializer::deserialize(const char *configFile, AudioPolicyConfig
     if (xmlXIncludeProcess(doc.get()) < 0) {
         ALOGE("%s: libxml failed to resolve XIncludes on %s document.", __func__, configFile);
     }
+    if (sourceFiles != nullptr) {
+        sourceFiles->push_back(configFile);
+        collectIncludedFiles(root, sourceFiles);
+    }
 
     if (xmlStrcmp(root->name, reinterpret_cast<const xmlChar*>(rootName)))  {
         ALOGE("%s: No %s root element found in xml data %s.", __func__, rootName,
@@ -908,10 +938,12 @@ status_t PolicySerializer::deserialize(const char *configFile, AudioPolicyConfig
 
 }  // namespace
 
-status_t deserializeAudioPolicyFile(const char *fileName, AudioPolicyConfig *config)
+status_t deserializeAudioPolicyFile(const char *fileName, AudioPolicyConfig *config,
+        std::vector<std::string> *sourceFiles)
 {
     PolicySerializer serializer;
-    status_t status = serializer.deserialize(fileName, config);
+    status_t status = serializer.deserialize(
+            fileName, config, false /*ignoreVendorExtensions*/, sourceFiles);
     return status;
 }
 
@@ -19,6 +19,7 @@
 #include "VolumeGroup.h"
 
 #include <map>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -166,7 +167,50 @@ private:
     VolumeGroupAttributes getVolumeGroupAttributesForAttributes(
             const audio_attributes_t &attr, bool fallbackOnDefault = true) const;
 
+    /**
+     * Best matching product strategy and volume group attributes for some audio attributes,
+     * along with their match score, before falling back on default.
+     */
+    struct AttributesMatch {
+        audio_attributes_t attributes;
+        product_strategy_t strategy;
+        int strategyScore;
+        VolumeGroupAttributes volumeGroupAttributes;
+        int volumeGroupScore;
+    };
+
+    /**
+     * @brief getAttributesMatch looks the attributes up in the cache, matching them against all
+     *        product strategies on a miss.
+     * The same few attributes are resolved for each track created and for each routing and
+     * volume decision, and product strategies don't change after initialize(), so the last
+     * resolved attributes are kept.
+     */
+    AttributesMatch getAttributesMatch(const audio_attributes_t &attr) const;
+
+    class AttributesMatchCache {
+    public:
+        AttributesMatchCache() = default;
+        // A copy of the map starts with an empty cache
+        AttributesMatchCache(const AttributesMatchCache &) {}
+        AttributesMatchCache &operator=(const AttributesMatchCache &) { clear(); return *this; }
+
+        bool find(const audio_attributes_t &attr, AttributesMatch *match);
+        void add(const AttributesMatch &match);
+        void clear();
+        void dump(String8 *dst, int spaces) const;
+
+    private:
+        static constexpr size_t kMaxEntries = 16;
+        mutable std::mutex mMutex;
+        std::vector<AttributesMatch> mEntries;
+        size_t mNextEntry = 0; // next one replaced once full
+        uint64_t mHits = 0;
+        uint64_t mMisses = 0;
+    };
+
     product_strategy_t mDefaultStrategy = PRODUCT_STRATEGY_NONE;
+    mutable AttributesMatchCache mAttributesMatchCache;
 };
 
 using ProductStrategyDevicesRoleMap =
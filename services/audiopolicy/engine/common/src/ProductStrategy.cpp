@@ -23,6 +23,7 @@
 #include <media/TypeConverter.h>
 #include <utils/String8.h>
 #include <cstdint>
+#include <inttypes.h>
 #include <string>
 
 #include <log/log.h>
@@ -147,20 +148,99 @@ void ProductStrategy::dump(String8 *dst, int spaces) const
 product_strategy_t ProductStrategyMap::getProductStrategyForAttributes(
         const audio_attributes_t &attributes, bool fallbackOnDefault) const
 {
-    product_strategy_t bestStrategyOrdefault = PRODUCT_STRATEGY_NONE;
-    int matchScore = AudioProductStrategy::NO_MATCH;
+    const AttributesMatch match = getAttributesMatch(attributes);
+    return (match.strategyScore != AudioProductStrategy::MATCH_ON_DEFAULT_SCORE ||
+            fallbackOnDefault) ? match.strategy : PRODUCT_STRATEGY_NONE;
+}
+
+ProductStrategyMap::AttributesMatch ProductStrategyMap::getAttributesMatch(
+        const audio_attributes_t &attr) const
+{
+    // Only the flags affecting strategy selection are used for matching
+    audio_attributes_t attributes = attr;
+    attributes.flags = static_cast<audio_flags_mask_t>(
+            attributes.flags & AUDIO_FLAGS_AFFECT_STRATEGY_SELECTION);
+
+    AttributesMatch match;
+    if (mAttributesMatchCache.find(attributes, &match)) {
+        return match;
+    }
+
+    match.attributes = attributes;
+    match.strategy = PRODUCT_STRATEGY_NONE;
+    match.strategyScore = AudioProductStrategy::NO_MATCH;
     for (const auto &iter : *this) {
         int score = iter.second->matchesScore(attributes);
+        if (score > match.strategyScore) {
+            match.strategy = iter.second->getId();
+            match.strategyScore = score;
+        }
         if (score == AudioProductStrategy::MATCH_EQUALS) {
-            return iter.second->getId();
+            break;
+        }
+    }
+
+    match.volumeGroupScore = AudioProductStrategy::NO_MATCH;
+    bool volumeGroupAttributesMatched = false;
+    for (const auto &iter : *this) {
+        for (const auto &volGroupAttr : iter.second->getVolumeGroupAttributes()) {
+            int score = volGroupAttr.matchesScore(attributes);
+            if (score > match.volumeGroupScore) {
+                match.volumeGroupScore = score;
+                match.volumeGroupAttributes = volGroupAttr;
+            }
+            if (score == AudioProductStrategy::MATCH_EQUALS) {
+                volumeGroupAttributesMatched = true;
+                break;
+            }
         }
-        if (score > matchScore) {
-            bestStrategyOrdefault = iter.second->getId();
-            matchScore = score;
+        if (volumeGroupAttributesMatched) {
+            break;
         }
     }
-    return (matchScore != AudioProductStrategy::MATCH_ON_DEFAULT_SCORE || fallbackOnDefault) ?
-            bestStrategyOrdefault : PRODUCT_STRATEGY_NONE;
+
+    mAttributesMatchCache.add(match);
+    return match;
+}
+
+bool ProductStrategyMap::AttributesMatchCache::find(const audio_attributes_t &attr,
+                                                     AttributesMatch *match)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (const auto &entry : mEntries) {
+        if (entry.attributes == attr) {
+            *match = entry;
+            mHits++;
+            return true;
+        }
+    }
+    mMisses++;
+    return false;
+}
+
+void ProductStrategyMap::AttributesMatchCache::add(const AttributesMatch &match)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mEntries.size() < kMaxEntries) {
+        mEntries.push_back(match);
+        return;
+    }
+    mEntries[mNextEntry] = match;
+    mNextEntry = (mNextEntry + 1) % kMaxEntries;
+}
+
+void ProductStrategyMap::AttributesMatchCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEntries.clear();
+    mNextEntry = 0;
+}
+
+void ProductStrategyMap::AttributesMatchCache::dump(String8 *dst, int spaces) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    dst->appendFormat("\n%*sAttributes match cache: %zu entries, %" PRIu64 " hits, %" PRIu64
+            " misses\n", spaces, "", mEntries.size(), mHits, mMisses);
 }
 
 audio_attributes_t ProductStrategyMap::getAttributesForStreamType(audio_stream_type_t stream) const
@@ -243,22 +323,9 @@ std::string ProductStrategyMap::getDeviceAddressForProductStrategy(product_strat
 VolumeGroupAttributes ProductStrategyMap::getVolumeGroupAttributesForAttributes(
         const audio_attributes_t &attr, bool fallbackOnDefault) const
 {
-    int matchScore = AudioProductStrategy::NO_MATCH;
-    VolumeGroupAttributes bestVolumeGroupAttributes = {};
-    for (const auto &iter : *this) {
-        for (const auto &volGroupAttr : iter.second->getVolumeGroupAttributes()) {
-            int score = volGroupAttr.matchesScore(attr);
-            if (score == AudioProductStrategy::MATCH_EQUALS) {
-                return volGroupAttr;
-            }
-            if (score > matchScore) {
-                matchScore = score;
-                bestVolumeGroupAttributes = volGroupAttr;
-            }
-        }
-    }
-    return (matchScore != AudioProductStrategy::MATCH_ON_DEFAULT_SCORE || fallbackOnDefault) ?
-            bestVolumeGroupAttributes : VolumeGroupAttributes();
+    const AttributesMatch match = getAttributesMatch(attr);
+    return (match.volumeGroupScore != AudioProductStrategy::MATCH_ON_DEFAULT_SCORE ||
+            fallbackOnDefault) ? match.volumeGroupAttributes : VolumeGroupAttributes();
 }
 
 audio_stream_type_t ProductStrategyMap::getStreamTypeForAttributes(
@@ -299,6 +366,7 @@ volume_group_t ProductStrategyMap::getDefaultVolumeGroup() const
 
 void ProductStrategyMap::initialize()
 {
+    mAttributesMatchCache.clear();
     mDefaultStrategy = getDefault();
     ALOG_ASSERT(mDefaultStrategy != PRODUCT_STRATEGY_NONE, "No default product strategy found");
 }
@@ -309,6 +377,7 @@ void ProductStrategyMap::dump(String8 *dst, int spaces) const
     for (const auto &iter : *this) {
         iter.second->dump(dst, spaces + 2);
     }
+    mAttributesMatchCache.dump(dst, spaces + 2);
 }
 
 void dumpProductStrategyDevicesRoleMap(
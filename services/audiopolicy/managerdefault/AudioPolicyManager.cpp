@@ -195,6 +195,11 @@ status_t AudioPolicyManager::setDeviceConnectionStateInt(const sp<DeviceDescript
 
         bool wasLeUnicastActive = isLeUnicastActive();
 
+        DeviceConnectionTimes times;
+        times.device = device->toString();
+        times.state = state;
+        nsecs_t phaseStartNs = systemTime();
+
         switch (state)
         {
         // handle output device connection
@@ -275,6 +280,10 @@ status_t AudioPolicyManager::setDeviceConnectionStateInt(const sp<DeviceDescript
         // Propagate device availability to Engine
         setEngineDeviceConnectionState(device, state);
 
+        nsecs_t now = systemTime();
+        times.checkOutputsNs = now - phaseStartNs;
+        phaseStartNs = now;
+
         // No need to evaluate playback routing when connecting a remote submix
         // output device used by a dynamic policy of type recorder as no
         // playback use case is affected.
@@ -317,10 +326,20 @@ status_t AudioPolicyManager::setDeviceConnectionStateInt(const sp<DeviceDescript
 
         if (doCheckForDeviceAndOutputChanges) {
             checkForDeviceAndOutputChanges(checkCloseOutputs);
+            times.checkedStrategies = mLastCheckedStrategies;
+            times.changedStrategies = mLastChangedStrategies;
         } else {
             checkCloseOutputs();
         }
+        now = systemTime();
+        times.checkRoutingNs = now - phaseStartNs;
+        phaseStartNs = now;
+
         (void)updateCallRouting(false /*fromCache*/);
+        now = systemTime();
+        times.callRoutingNs = now - phaseStartNs;
+        phaseStartNs = now;
+
         const DeviceVector msdOutDevices = getMsdAudioOutDevices();
         const DeviceVector activeMediaDevices =
                 mEngine->getActiveMediaDevices(mAvailableOutputDevices);
@@ -366,6 +385,14 @@ status_t AudioPolicyManager::setDeviceConnectionStateInt(const sp<DeviceDescript
             }
         }
         reopenOutputsWithDevices(outputsToReopenWithDevices);
+        times.outputDevicesNs = systemTime() - phaseStartNs;
+
+        ALOGV("%s() %s took %" PRId64 " ms", __func__, times.device.c_str(),
+                ns2ms(times.totalNs()));
+        if (times.totalNs() >= mSlowestDeviceConnectionTimes.totalNs()) {
+            mSlowestDeviceConnectionTimes = times;
+        }
+        mLastDeviceConnectionTimes = std::move(times);
 
         if (state == AUDIO_POLICY_DEVICE_STATE_UNAVAILABLE) {
             cleanUpForDevice(device);
@@ -4488,6 +4515,8 @@ void AudioPolicyManager::dump(String8 *dst) const
     dst->appendFormat(" Master mono: %s\n", mMasterMono ? "on" : "off");
     dst->appendFormat(" Communication Strategy id: %d\n", mCommunnicationStrategy);
     dst->appendFormat(" Config source: %s\n", mConfig->getSource().c_str());
+    mLastDeviceConnectionTimes.dump(dst, "Last output device connection change");
+    mSlowestDeviceConnectionTimes.dump(dst, "Slowest output device connection change");
 
     dst->append("\n");
     mAvailableOutputDevices.dump(dst, String8("Available output"), 1);
@@ -4526,6 +4555,20 @@ void AudioPolicyManager::dump(String8 *dst) const
     }
 }
 
+void AudioPolicyManager::DeviceConnectionTimes::dump(String8 *dst, const char *name) const
+{
+    if (device.empty()) {
+        return;
+    }
+    dst->appendFormat(" %s: %s %s in %.2f ms\n", name, device.c_str(),
+            state == AUDIO_POLICY_DEVICE_STATE_AVAILABLE ? "connected" : "disconnected",
+            totalNs() / 1e6);
+    dst->appendFormat("   check outputs %.2f ms, routing %.2f ms (%zu of %zu strategies changed),"
+            " call routing %.2f ms, output devices %.2f ms\n", checkOutputsNs / 1e6,
+            checkRoutingNs / 1e6, changedStrategies, checkedStrategies, callRoutingNs / 1e6,
+            outputDevicesNs / 1e6);
+}
+
 status_t AudioPolicyManager::dump(int fd)
 {
     String8 result;
@@ -6476,7 +6519,10 @@ status_t AudioPolicyManager::initialize() {
 
     // after parsing the config, mConfig contain all known devices;
     // open all output streams needed to access attached devices
+    const nsecs_t startNs = systemTime();
     onNewAudioModulesAvailableInt(nullptr /*newDevices*/);
+    ALOGI("%s: loaded %zu HW modules and opened their I/Os in %" PRId64 " ms",
+            __func__, mHwModules.size(), ns2ms(systemTime() - startNs));
 
     // make sure default device is reachable
     if (const auto defaultOutputDevice = mConfig->getDefaultOutputDevice();
@@ -7212,15 +7258,46 @@ void AudioPolicyManager::clearAudioSourcesForOutput(audio_io_handle_t output)
     }
 }
 
-void AudioPolicyManager::checkOutputForAttributes(const audio_attributes_t &attr)
+SortedVector<audio_io_handle_t> AudioPolicyManager::getOutputsForDevicesCached(
+        const DeviceVector &devices, const SwAudioOutputCollection& openOutputs,
+        OutputsForDevicesCache::Outputs *cache)
+{
+    if (cache == nullptr) {
+        return getOutputsForDevices(devices, openOutputs);
+    }
+    // Drop the entries if outputs were opened or closed since they were added
+    bool sameOutputs = cache->openOutputs.size() == openOutputs.size();
+    for (size_t i = 0; sameOutputs && i < openOutputs.size(); i++) {
+        sameOutputs = cache->openOutputs[i] == openOutputs.keyAt(i);
+    }
+    if (!sameOutputs) {
+        cache->entries.clear();
+        cache->openOutputs.clear();
+        for (size_t i = 0; i < openOutputs.size(); i++) {
+            cache->openOutputs.push_back(openOutputs.keyAt(i));
+        }
+    }
+    for (const auto &entry : cache->entries) {
+        if (entry.first == devices) {
+            return entry.second;
+        }
+    }
+    cache->entries.emplace_back(devices, getOutputsForDevices(devices, openOutputs));
+    return cache->entries.back().second;
+}
+
+bool AudioPolicyManager::checkOutputForAttributes(const audio_attributes_t &attr,
+                                                  OutputsForDevicesCache *outputsCache)
 {
     auto psId = mEngine->getProductStrategyForAttributes(attr);
 
     DeviceVector oldDevices = mEngine->getOutputDevicesForAttributes(attr, 0, true /*fromCache*/);
     DeviceVector newDevices = mEngine->getOutputDevicesForAttributes(attr, 0, false /*fromCache*/);
 
-    SortedVector<audio_io_handle_t> srcOutputs = getOutputsForDevices(oldDevices, mPreviousOutputs);
-    SortedVector<audio_io_handle_t> dstOutputs = getOutputsForDevices(newDevices, mOutputs);
+    SortedVector<audio_io_handle_t> srcOutputs = getOutputsForDevicesCached(oldDevices,
+            mPreviousOutputs, outputsCache != nullptr ? &outputsCache->previous : nullptr);
+    SortedVector<audio_io_handle_t> dstOutputs = getOutputsForDevicesCached(newDevices,
+            mOutputs, outputsCache != nullptr ? &outputsCache->current : nullptr);
 
     uint32_t maxLatency = 0;
     bool unneededUsePrimaryOutputFromPolicyMixes = false;
@@ -7233,6 +7310,12 @@ void AudioPolicyManager::checkOutputForAttributes(const audio_attributes_t &attr
             continue;
         }
         for (const sp<TrackClientDescriptor>& client : desc->getClientIterable()) {
+            // Without policy mixes, only clients that had one need to be invalidated. Check
+            // that before the strategy lookup, which is done for each strategy and client.
+            if (mPolicyMixes.isEmpty() && client->getPrimaryMix() == nullptr &&
+                    !client->hasLostPrimaryMix()) {
+                continue;
+            }
             if (mEngine->getProductStrategyForAttributes(client->attributes()) != psId) {
                 continue;
             }
@@ -7323,14 +7406,23 @@ void AudioPolicyManager::checkOutputForAttributes(const audio_attributes_t &attr
                 desc->setTracksInvalidatedStatusByStrategy(psId);
             }
         }
+        return true;
     }
+    return false;
 }
 
 void AudioPolicyManager::checkOutputForAllStrategies()
 {
+    // Strategies mostly share a few device combinations, look their outputs up once
+    OutputsForDevicesCache outputsCache;
+    mLastCheckedStrategies = 0;
+    mLastChangedStrategies = 0;
     for (const auto &strategy : mEngine->getOrderedProductStrategies()) {
         auto attributes = mEngine->getAllAttributesForProductStrategy(strategy).front();
-        checkOutputForAttributes(attributes);
+        if (checkOutputForAttributes(attributes, &outputsCache)) {
+            mLastChangedStrategies++;
+        }
+        mLastCheckedStrategies++;
         checkAudioSourceForAttributes(attributes);
     }
 }
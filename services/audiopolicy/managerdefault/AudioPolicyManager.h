@@ -19,7 +19,10 @@
 #include <atomic>
 #include <functional>
 #include <memory>
+#include <string>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include <stdint.h>
 #include <sys/types.h>
@@ -723,6 +726,24 @@ protected:
          */
         void updateInputRouting();
 
+        /**
+         * getOutputsForDevices() results for the previous and current outputs, shared by the
+         * product strategies routed to the same devices while checking them all. Entries are
+         * dropped when outputs are opened or closed.
+         */
+        struct OutputsForDevicesCache {
+            struct Outputs {
+                std::vector<audio_io_handle_t> openOutputs;
+                std::vector<std::pair<DeviceVector, SortedVector<audio_io_handle_t>>> entries;
+            };
+            Outputs previous;
+            Outputs current;
+        };
+
+        SortedVector<audio_io_handle_t> getOutputsForDevicesCached(
+                const DeviceVector &devices, const SwAudioOutputCollection& openOutputs,
+                OutputsForDevicesCache::Outputs *cache);
+
         /**
          * @brief checkOutputForAttributes checks and if necessary changes outputs used for the
          * given audio attributes.
@@ -730,8 +751,12 @@ protected:
          * attributes changes: connected device, phone state, force use...
          * Must be called before updateDevicesAndOutputs()
          * @param attr to be considered
+         * @param outputsCache optional cache of the outputs for devices, see
+         *        OutputsForDevicesCache
+         * @return true if the strategy moved to other outputs or had tracks invalidated
          */
-        void checkOutputForAttributes(const audio_attributes_t &attr);
+        bool checkOutputForAttributes(const audio_attributes_t &attr,
+                                      OutputsForDevicesCache *outputsCache = nullptr);
 
         /**
          * @brief checkAudioSourceForAttributes checks if any AudioSource following the same routing
@@ -1401,6 +1426,28 @@ private:
         // Contains for devices that support absolute volume the audio attributes
         // corresponding to the streams that are driving the volume changes
         std::unordered_map<audio_devices_t, audio_attributes_t> mAbsoluteVolumeDrivingStreams;
+
+        // Time spent in each phase of an output device connection change, under the policy lock
+        struct DeviceConnectionTimes {
+            std::string device;
+            audio_policy_dev_state_t state = AUDIO_POLICY_DEVICE_STATE_UNAVAILABLE;
+            nsecs_t checkOutputsNs = 0;     // checkOutputsForDevice()
+            nsecs_t checkRoutingNs = 0;     // checkForDeviceAndOutputChanges()
+            nsecs_t callRoutingNs = 0;      // updateCallRouting()
+            nsecs_t outputDevicesNs = 0;    // new devices of active outputs
+            size_t checkedStrategies = 0;
+            size_t changedStrategies = 0;
+
+            nsecs_t totalNs() const {
+                return checkOutputsNs + checkRoutingNs + callRoutingNs + outputDevicesNs;
+            }
+            void dump(String8 *dst, const char *name) const;
+        };
+        DeviceConnectionTimes mLastDeviceConnectionTimes;
+        DeviceConnectionTimes mSlowestDeviceConnectionTimes;
+        // Strategies checked and changed by the last checkOutputForAllStrategies()
+        size_t mLastCheckedStrategies = 0;
+        size_t mLastChangedStrategies = 0;
 };
 
 };
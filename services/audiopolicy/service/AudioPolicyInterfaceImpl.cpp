@@ -120,7 +120,7 @@ status_t AudioPolicyService::validateUsage(const audio_attributes_t& attr,
 void AudioPolicyService::doOnNewAudioModulesAvailable()
 {
     if (mAudioPolicyManager == NULL) return;
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     mAudioPolicyManager->onNewAudioModulesAvailable();
 }
@@ -146,7 +146,7 @@ Status AudioPolicyService::setDeviceConnectionState(
     }
 
     ALOGV("setDeviceConnectionState()");
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     status_t status = mAudioPolicyManager->setDeviceConnectionState(
             state, port, encodedFormat);
@@ -168,7 +168,7 @@ Status AudioPolicyService::getDeviceConnectionState(const AudioDevice& deviceAid
                         AUDIO_POLICY_DEVICE_STATE_UNAVAILABLE));
         return Status::ok();
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     *_aidl_return = VALUE_OR_RETURN_BINDER_STATUS(
             legacy2aidl_audio_policy_dev_state_t_AudioPolicyDeviceState(
@@ -196,7 +196,7 @@ Status AudioPolicyService::handleDeviceConfigChange(
     }
 
     ALOGV("handleDeviceConfigChange()");
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     status_t status =  mAudioPolicyManager->handleDeviceConfigChange(
             device, address.c_str(), deviceNameAidl.c_str(), encodedFormat);
@@ -227,7 +227,7 @@ Status AudioPolicyService::setPhoneState(AudioMode stateAidl, int32_t uidAidl)
     // acquire lock before calling setMode() so that setMode() + setPhoneState() are an atomic
     // operation from policy manager standpoint (no other operation (e.g track start or stop)
     // can be interleaved).
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     // TODO: check if it is more appropriate to do it in platform specific policy manager
 
     // Audio HAL mode conversion for call redirect modes
@@ -248,7 +248,7 @@ Status AudioPolicyService::setPhoneState(AudioMode stateAidl, int32_t uidAidl)
 }
 
 Status AudioPolicyService::getPhoneState(AudioMode* _aidl_return) {
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     *_aidl_return = VALUE_OR_RETURN_BINDER_STATUS(legacy2aidl_audio_mode_t_AudioMode(mPhoneState));
     return Status::ok();
 }
@@ -276,7 +276,7 @@ Status AudioPolicyService::setForceUse(media::AudioPolicyForceUse usageAidl,
         return binderStatusFromStatusT(BAD_VALUE);
     }
     ALOGV("setForceUse()");
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     mAudioPolicyManager->setForceUse(usage, config);
     onCheckSpatializer_l();
@@ -318,7 +318,7 @@ Status AudioPolicyService::getOutput(AudioStreamType streamAidl, int32_t* _aidl_
         return binderStatusFromStatusT(NO_INIT);
     }
     ALOGV("getOutput()");
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     *_aidl_return = VALUE_OR_RETURN_BINDER_STATUS(
             legacy2aidl_audio_io_handle_t_int32_t(mAudioPolicyManager->getOutput(stream)));
@@ -358,7 +358,7 @@ Status AudioPolicyService::getOutputForAttr(const media::audio::common::AudioAtt
     RETURN_IF_BINDER_ERROR(binderStatusFromStatusT(validateUsage(attr, attributionSource)));
 
     ALOGV("%s()", __func__);
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
 
     if (!mPackageManager.allowPlaybackCapture(VALUE_OR_RETURN_BINDER_STATUS(
         aidl2legacy_int32_t_uid_t(attributionSource.uid)))) {
@@ -464,7 +464,7 @@ void AudioPolicyService::getPlaybackClientAndEffects(audio_port_handle_t portId,
                                                      sp<AudioPolicyEffects>& effects,
                                                      const char *context)
 {
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     const ssize_t index = mAudioPlaybackClients.indexOfKey(portId);
     if (index < 0) {
         ALOGE("%s AudioTrack client not found for portId %d", context, portId);
@@ -495,7 +495,7 @@ Status AudioPolicyService::startOutput(int32_t portIdAidl)
             ALOGW("Failed to add effects on session %d", client->session);
         }
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     status_t status = mAudioPolicyManager->startOutput(portId);
     if (status == NO_ERROR) {
@@ -537,7 +537,7 @@ status_t  AudioPolicyService::doStopOutput(audio_port_handle_t portId)
             ALOGW("Failed to release effects on session %d", client->session);
         }
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     status_t status = mAudioPolicyManager->stopOutput(portId);
     if (status == NO_ERROR) {
@@ -573,7 +573,7 @@ void AudioPolicyService::doReleaseOutput(audio_port_handle_t portId)
         audioPolicyEffects->releaseOutputSessionEffects(
             client->io, client->stream, client->session);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     if (client != nullptr && client->active) {
         onUpdateActiveSpatializerTracks_l();
     }
@@ -700,7 +700,7 @@ Status AudioPolicyService::getInputForAttr(const media::audio::common::AudioAttr
         status_t status;
         AudioPolicyInterface::input_type_t inputType;
 
-        audio_utils::lock_guard _l(mMutex);
+        AutoTimedMutexLock _l(mMutex, __func__);
         {
             AutoCallerClear acc;
             // the audio_in_acoustics_t parameter is ignored by get_input()
@@ -813,7 +813,7 @@ Status AudioPolicyService::startInput(int32_t portIdAidl)
     }
     sp<AudioRecordClient> client;
     {
-        audio_utils::lock_guard _l(mMutex);
+        AutoTimedMutexLock _l(mMutex, __func__);
 
         ssize_t index = mAudioRecordClients.indexOfKey(portId);
         if (index < 0) {
@@ -837,7 +837,7 @@ Status AudioPolicyService::startInput(int32_t portIdAidl)
         return binderStatusFromStatusT(PERMISSION_DENIED);
     }
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
 
     ALOGW_IF(client->silenced, "startInput on silenced input for port %d, uid %d. Unsilencing.",
             portIdAidl,
@@ -959,7 +959,7 @@ Status AudioPolicyService::stopInput(int32_t portIdAidl)
         return binderStatusFromStatusT(NO_INIT);
     }
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
 
     ssize_t index = mAudioRecordClients.indexOfKey(portId);
     if (index < 0) {
@@ -989,7 +989,7 @@ Status AudioPolicyService::releaseInput(int32_t portIdAidl)
     sp<AudioPolicyEffects>audioPolicyEffects;
     sp<AudioRecordClient> client;
     {
-        audio_utils::lock_guard _l(mMutex);
+        AutoTimedMutexLock _l(mMutex, __func__);
         audioPolicyEffects = mAudioPolicyEffects;
         ssize_t index = mAudioRecordClients.indexOfKey(portId);
         if (index < 0) {
@@ -1017,7 +1017,7 @@ Status AudioPolicyService::releaseInput(int32_t portIdAidl)
         }
     }
     {
-        audio_utils::lock_guard _l(mMutex);
+        AutoTimedMutexLock _l(mMutex, __func__);
         AutoCallerClear acc;
         mAudioPolicyManager->releaseInput(portId);
     }
@@ -1043,7 +1043,7 @@ Status AudioPolicyService::setDeviceAbsoluteVolumeEnabled(const AudioDevice& dev
     if (uint32_t(streamToDriveAbs) >= AUDIO_STREAM_PUBLIC_CNT) {
         return binderStatusFromStatusT(BAD_VALUE);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     return binderStatusFromStatusT(
             mAudioPolicyManager->setDeviceAbsoluteVolumeEnabled(deviceType, address.c_str(),
@@ -1067,7 +1067,7 @@ Status AudioPolicyService::initStreamVolume(AudioStreamType streamAidl,
     if (uint32_t(stream) >= AUDIO_STREAM_PUBLIC_CNT) {
         return binderStatusFromStatusT(BAD_VALUE);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     mAudioPolicyManager->initStreamVolume(stream, indexMin, indexMax);
     return binderStatusFromStatusT(NO_ERROR);
@@ -1091,7 +1091,7 @@ Status AudioPolicyService::setStreamVolumeIndex(AudioStreamType streamAidl,
     if (uint32_t(stream) >= AUDIO_STREAM_PUBLIC_CNT) {
         return binderStatusFromStatusT(BAD_VALUE);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     return binderStatusFromStatusT(mAudioPolicyManager->setStreamVolumeIndex(stream,
                                                                              index,
@@ -1113,7 +1113,7 @@ Status AudioPolicyService::getStreamVolumeIndex(AudioStreamType streamAidl,
     if (uint32_t(stream) >= AUDIO_STREAM_PUBLIC_CNT) {
         return binderStatusFromStatusT(BAD_VALUE);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     RETURN_IF_BINDER_ERROR(binderStatusFromStatusT(
             mAudioPolicyManager->getStreamVolumeIndex(stream, &index, device)));
@@ -1138,7 +1138,7 @@ Status AudioPolicyService::setVolumeIndexForAttributes(
     if (!settingsAllowed()) {
         return binderStatusFromStatusT(PERMISSION_DENIED);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     return binderStatusFromStatusT(
             mAudioPolicyManager->setVolumeIndexForAttributes(attributes, index, device));
@@ -1158,7 +1158,7 @@ Status AudioPolicyService::getVolumeIndexForAttributes(
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     RETURN_IF_BINDER_ERROR(binderStatusFromStatusT(
             mAudioPolicyManager->getVolumeIndexForAttributes(attributes, index, device)));
@@ -1177,7 +1177,7 @@ Status AudioPolicyService::getMinVolumeIndexForAttributes(
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     RETURN_IF_BINDER_ERROR(binderStatusFromStatusT(
             mAudioPolicyManager->getMinVolumeIndexForAttributes(attributes, index)));
@@ -1196,7 +1196,7 @@ Status AudioPolicyService::getMaxVolumeIndexForAttributes(
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     RETURN_IF_BINDER_ERROR(binderStatusFromStatusT(
             mAudioPolicyManager->getMaxVolumeIndexForAttributes(attributes, index)));
@@ -1238,7 +1238,7 @@ Status AudioPolicyService::getDevicesForAttributes(
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     RETURN_IF_BINDER_ERROR(binderStatusFromStatusT(
             mAudioPolicyManager->getDevicesForAttributes(aa, &devices, forVolume)));
@@ -1258,7 +1258,7 @@ Status AudioPolicyService::getOutputForEffect(const media::EffectDescriptor& des
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     *_aidl_return = VALUE_OR_RETURN_BINDER_STATUS(
             legacy2aidl_audio_io_handle_t_int32_t(mAudioPolicyManager->getOutputForEffect(&desc)));
@@ -1283,7 +1283,7 @@ Status AudioPolicyService::registerEffect(const media::EffectDescriptor& descAid
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     return binderStatusFromStatusT(
             mAudioPolicyManager->registerEffect(&desc, io, strategy, session, id));
@@ -1295,7 +1295,7 @@ Status AudioPolicyService::unregisterEffect(int32_t idAidl)
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     return binderStatusFromStatusT(mAudioPolicyManager->unregisterEffect(id));
 }
@@ -1306,7 +1306,7 @@ Status AudioPolicyService::setEffectEnabled(int32_t idAidl, bool enabled)
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     return binderStatusFromStatusT(mAudioPolicyManager->setEffectEnabled(id, enabled));
 }
@@ -1325,7 +1325,7 @@ Status AudioPolicyService::moveEffectsToIo(const std::vector<int32_t>& idsAidl,
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     return binderStatusFromStatusT(mAudioPolicyManager->moveEffectsToIo(ids, io));
 }
@@ -1343,7 +1343,7 @@ Status AudioPolicyService::isStreamActive(AudioStreamType streamAidl, int32_t in
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     *_aidl_return = mAudioPolicyManager->isStreamActive(stream, inPastMs);
     return Status::ok();
@@ -1363,7 +1363,7 @@ Status AudioPolicyService::isStreamActiveRemotely(AudioStreamType streamAidl,
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     *_aidl_return = mAudioPolicyManager->isStreamActiveRemotely(stream, inPastMs);
     return Status::ok();
@@ -1375,7 +1375,7 @@ Status AudioPolicyService::isSourceActive(AudioSource sourceAidl, bool* _aidl_re
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     *_aidl_return = mAudioPolicyManager->isSourceActive(source);
     return Status::ok();
@@ -1387,7 +1387,7 @@ status_t AudioPolicyService::getAudioPolicyEffects(sp<AudioPolicyEffects>& audio
         return NO_INIT;
     }
     {
-        audio_utils::lock_guard _l(mMutex);
+        AutoTimedMutexLock _l(mMutex, __func__);
         audioPolicyEffects = mAudioPolicyEffects;
     }
     if (audioPolicyEffects == 0) {
@@ -1511,7 +1511,7 @@ Status AudioPolicyService::setSupportedSystemUsages(
             convertRange(systemUsagesAidl.begin(), systemUsagesAidl.begin() + size,
                          std::back_inserter(systemUsages), aidl2legacy_AudioUsage_audio_usage_t)));
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     if(!modifyAudioRoutingAllowed()) {
         return binderStatusFromStatusT(PERMISSION_DENIED);
     }
@@ -1531,7 +1531,7 @@ Status AudioPolicyService::setAllowedCapturePolicy(int32_t uidAidl, int32_t capt
     audio_flags_mask_t capturePolicy = VALUE_OR_RETURN_BINDER_STATUS(
             aidl2legacy_int32_t_audio_flags_mask_t_mask(capturePolicyAidl));
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     if (mAudioPolicyManager == NULL) {
         ALOGV("%s() mAudioPolicyManager == NULL", __func__);
         return binderStatusFromStatusT(NO_INIT);
@@ -1548,7 +1548,7 @@ Status AudioPolicyService::getOffloadSupport(const AudioOffloadInfo& infoAidl,
         ALOGV("mAudioPolicyManager == NULL");
         return binderStatusFromStatusT(AUDIO_OFFLOAD_NOT_SUPPORTED);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     *_aidl_return = VALUE_OR_RETURN_BINDER_STATUS(legacy2aidl_audio_offload_mode_t_AudioOffloadMode(
             mAudioPolicyManager->getOffloadSupport(info)));
@@ -1573,7 +1573,7 @@ Status AudioPolicyService::isDirectOutputSupported(
 
     RETURN_IF_BINDER_ERROR(binderStatusFromStatusT(validateUsage(attributes)));
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     *_aidl_return = mAudioPolicyManager->isDirectOutputSupported(config, attributes);
     return Status::ok();
 }
@@ -1596,7 +1596,7 @@ Status AudioPolicyService::listAudioPorts(media::AudioPortRole roleAidl,
     std::unique_ptr<audio_port_v7[]> ports(new audio_port_v7[num_ports]);
     unsigned int generation;
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
@@ -1614,7 +1614,7 @@ Status AudioPolicyService::listAudioPorts(media::AudioPortRole roleAidl,
 
 Status AudioPolicyService::listDeclaredDevicePorts(media::AudioPortRole role,
                                                     std::vector<media::AudioPortFw>* _aidl_return) {
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
@@ -1626,7 +1626,7 @@ Status AudioPolicyService::listDeclaredDevicePorts(media::AudioPortRole role,
 Status AudioPolicyService::getAudioPort(int portId,
                                         media::AudioPortFw* _aidl_return) {
     audio_port_v7 port{ .id = portId };
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
@@ -1645,7 +1645,7 @@ Status AudioPolicyService::createAudioPatch(const media::AudioPatchFw& patchAidl
             aidl2legacy_int32_t_audio_port_handle_t(handleAidl));
     RETURN_IF_BINDER_ERROR(binderStatusFromStatusT(AudioValidator::validateAudioPatch(patch)));
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     if(!modifyAudioRoutingAllowed()) {
         return binderStatusFromStatusT(PERMISSION_DENIED);
     }
@@ -1664,7 +1664,7 @@ Status AudioPolicyService::releaseAudioPatch(int32_t handleAidl)
 {
     audio_patch_handle_t handle = VALUE_OR_RETURN_BINDER_STATUS(
             aidl2legacy_int32_t_audio_patch_handle_t(handleAidl));
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     if(!modifyAudioRoutingAllowed()) {
         return binderStatusFromStatusT(PERMISSION_DENIED);
     }
@@ -1689,7 +1689,7 @@ Status AudioPolicyService::listAudioPatches(Int* count,
     std::unique_ptr<audio_patch[]> patches(new audio_patch[num_patches]);
     unsigned int generation;
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
@@ -1712,7 +1712,7 @@ Status AudioPolicyService::setAudioPortConfig(const media::AudioPortConfigFw& co
     RETURN_IF_BINDER_ERROR(
             binderStatusFromStatusT(AudioValidator::validateAudioPortConfig(config)));
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     if(!modifyAudioRoutingAllowed()) {
         return binderStatusFromStatusT(PERMISSION_DENIED);
     }
@@ -1730,7 +1730,7 @@ Status AudioPolicyService::acquireSoundTriggerSession(media::SoundTriggerSession
     audio_devices_t device;
 
     {
-        audio_utils::lock_guard _l(mMutex);
+        AutoTimedMutexLock _l(mMutex, __func__);
         if (mAudioPolicyManager == NULL) {
             return binderStatusFromStatusT(NO_INIT);
         }
@@ -1752,7 +1752,7 @@ Status AudioPolicyService::releaseSoundTriggerSession(int32_t sessionAidl)
 {
     audio_session_t session = VALUE_OR_RETURN_BINDER_STATUS(
             aidl2legacy_int32_t_audio_session_t(sessionAidl));
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
@@ -1771,7 +1771,7 @@ Status AudioPolicyService::registerPolicyMixes(const std::vector<media::AudioMix
             convertRange(mixesAidl.begin(), mixesAidl.begin() + size, std::back_inserter(mixes),
                          aidl2legacy_AudioMix)));
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
 
     // loopback|render only need a MediaProjection (checked in caller AudioService.java)
     bool needModifyAudioRouting = std::any_of(mixes.begin(), mixes.end(), [](auto& mix) {
@@ -1831,7 +1831,7 @@ AudioPolicyService::getRegisteredPolicyMixes(std::vector<::android::media::Audio
 
 Status AudioPolicyService::updatePolicyMixes(
         const ::std::vector<::android::media::AudioMixUpdate>& updates) {
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     for (const auto& update : updates) {
         AudioMix mix = VALUE_OR_RETURN_BINDER_STATUS(aidl2legacy_AudioMix(update.audioMix));
         std::vector<AudioMixMatchCriterion> newCriteria =
@@ -1853,7 +1853,7 @@ Status AudioPolicyService::setUidDeviceAffinities(
             convertContainer<AudioDeviceTypeAddrVector>(devicesAidl,
                                                         aidl2legacy_AudioDeviceTypeAddress));
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     if(!modifyAudioRoutingAllowed()) {
         return binderStatusFromStatusT(PERMISSION_DENIED);
     }
@@ -1867,7 +1867,7 @@ Status AudioPolicyService::setUidDeviceAffinities(
 Status AudioPolicyService::removeUidDeviceAffinities(int32_t uidAidl) {
     uid_t uid = VALUE_OR_RETURN_BINDER_STATUS(aidl2legacy_int32_t_uid_t(uidAidl));
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     if(!modifyAudioRoutingAllowed()) {
         return binderStatusFromStatusT(PERMISSION_DENIED);
     }
@@ -1886,7 +1886,7 @@ Status AudioPolicyService::setUserIdDeviceAffinities(
             convertContainer<AudioDeviceTypeAddrVector>(devicesAidl,
                                                         aidl2legacy_AudioDeviceTypeAddress));
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     if(!modifyAudioRoutingAllowed()) {
         return binderStatusFromStatusT(PERMISSION_DENIED);
     }
@@ -1900,7 +1900,7 @@ Status AudioPolicyService::setUserIdDeviceAffinities(
 Status AudioPolicyService::removeUserIdDeviceAffinities(int32_t userIdAidl) {
     int userId = VALUE_OR_RETURN_BINDER_STATUS(convertReinterpret<int>(userIdAidl));
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     if(!modifyAudioRoutingAllowed()) {
         return binderStatusFromStatusT(PERMISSION_DENIED);
     }
@@ -1924,7 +1924,7 @@ Status AudioPolicyService::startAudioSource(const media::AudioPortConfigFw& sour
     RETURN_IF_BINDER_ERROR(binderStatusFromStatusT(
             AudioValidator::validateAudioAttributes(attributes, "68953950")));
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
@@ -1945,7 +1945,7 @@ Status AudioPolicyService::stopAudioSource(int32_t portIdAidl)
     audio_port_handle_t portId = VALUE_OR_RETURN_BINDER_STATUS(
             aidl2legacy_int32_t_audio_port_handle_t(portIdAidl));
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
@@ -1961,9 +1961,13 @@ Status AudioPolicyService::setMasterMono(bool mono)
     if (!settingsAllowed()) {
         return binderStatusFromStatusT(PERMISSION_DENIED);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
-    return binderStatusFromStatusT(mAudioPolicyManager->setMasterMono(mono));
+    const status_t status = mAudioPolicyManager->setMasterMono(mono);
+    if (status == NO_ERROR) {
+        updatePolicySnapshot_l();
+    }
+    return binderStatusFromStatusT(status);
 }
 
 Status AudioPolicyService::getMasterMono(bool* _aidl_return)
@@ -1971,7 +1975,11 @@ Status AudioPolicyService::getMasterMono(bool* _aidl_return)
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    if (const auto snapshot = getPolicySnapshot(); snapshot != nullptr) {
+        *_aidl_return = snapshot->masterMono;
+        return Status::ok();
+    }
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     return binderStatusFromStatusT(mAudioPolicyManager->getMasterMono(_aidl_return));
 }
@@ -1989,7 +1997,7 @@ Status AudioPolicyService::getStreamVolumeDB(
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     *_aidl_return = mAudioPolicyManager->getStreamVolumeDB(stream, index, device);
     return Status::ok();
@@ -2010,7 +2018,7 @@ Status AudioPolicyService::getSurroundFormats(Int* count,
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     RETURN_IF_BINDER_ERROR(binderStatusFromStatusT(
             mAudioPolicyManager->getSurroundFormats(&numSurroundFormats, surroundFormats.get(),
@@ -2041,7 +2049,7 @@ Status AudioPolicyService::getReportedSurroundFormats(
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     RETURN_IF_BINDER_ERROR(binderStatusFromStatusT(
             mAudioPolicyManager->getReportedSurroundFormats(
@@ -2063,7 +2071,7 @@ Status AudioPolicyService::getHwOffloadFormatsSupportedForBluetoothMedia(
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     audio_devices_t device = VALUE_OR_RETURN_BINDER_STATUS(
             aidl2legacy_AudioDeviceDescription_audio_devices_t(deviceAidl));
@@ -2083,7 +2091,7 @@ Status AudioPolicyService::setSurroundFormatEnabled(
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     return binderStatusFromStatusT(
             mAudioPolicyManager->setSurroundFormatEnabled(audioFormat, enabled));
@@ -2106,7 +2114,7 @@ Status AudioPolicyService::setAssistantServicesUids(const std::vector<int32_t>&
     std::vector<uid_t> uids;
     RETURN_IF_BINDER_ERROR(convertInt32VectorToUidVectorWithLimit(uidsAidl, uids));
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     mUidPolicy->setAssistantUids(uids);
     return Status::ok();
 }
@@ -2116,7 +2124,7 @@ Status AudioPolicyService::setActiveAssistantServicesUids(
     std::vector<uid_t> activeUids;
     RETURN_IF_BINDER_ERROR(convertInt32VectorToUidVectorWithLimit(activeUidsAidl, activeUids));
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     mUidPolicy->setActiveAssistantUids(activeUids);
     return Status::ok();
 }
@@ -2126,7 +2134,7 @@ Status AudioPolicyService::setA11yServicesUids(const std::vector<int32_t>& uidsA
     std::vector<uid_t> uids;
     RETURN_IF_BINDER_ERROR(convertInt32VectorToUidVectorWithLimit(uidsAidl, uids));
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     mUidPolicy->setA11yUids(uids);
     return Status::ok();
 }
@@ -2134,7 +2142,7 @@ Status AudioPolicyService::setA11yServicesUids(const std::vector<int32_t>& uidsA
 Status AudioPolicyService::setCurrentImeUid(int32_t uidAidl)
 {
     uid_t uid = VALUE_OR_RETURN_BINDER_STATUS(aidl2legacy_int32_t_uid_t(uidAidl));
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     mUidPolicy->setCurrentImeUid(uid);
     return Status::ok();
 }
@@ -2144,7 +2152,7 @@ Status AudioPolicyService::isHapticPlaybackSupported(bool* _aidl_return)
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     *_aidl_return = mAudioPolicyManager->isHapticPlaybackSupported();
     return Status::ok();
@@ -2155,7 +2163,7 @@ Status AudioPolicyService::isUltrasoundSupported(bool* _aidl_return)
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     *_aidl_return = mAudioPolicyManager->isUltrasoundSupported();
     return Status::ok();
@@ -2166,7 +2174,7 @@ Status AudioPolicyService::isHotwordStreamSupported(bool lookbackAudio, bool* _a
     if (mAudioPolicyManager == nullptr) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     *_aidl_return = mAudioPolicyManager->isHotwordStreamSupported(lookbackAudio);
     return Status::ok();
@@ -2179,7 +2187,12 @@ Status AudioPolicyService::listAudioProductStrategies(
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    // Product strategies are set by the engine configuration and never change afterwards.
+    if (const auto snapshot = getPolicySnapshot(); snapshot != nullptr) {
+        *_aidl_return = snapshot->productStrategies;
+        return Status::ok();
+    }
+    AutoTimedMutexLock _l(mMutex, __func__);
     RETURN_IF_BINDER_ERROR(
             binderStatusFromStatusT(mAudioPolicyManager->listAudioProductStrategies(strategies)));
     *_aidl_return = VALUE_OR_RETURN_BINDER_STATUS(
@@ -2199,7 +2212,7 @@ Status AudioPolicyService::getProductStrategyFromAudioAttributes(
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     RETURN_IF_BINDER_ERROR(binderStatusFromStatusT(
             mAudioPolicyManager->getProductStrategyFromAudioAttributes(
                     aa, productStrategy, fallbackOnDefault)));
@@ -2214,7 +2227,12 @@ Status AudioPolicyService::listAudioVolumeGroups(std::vector<media::AudioVolumeG
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    // Same as product strategies, volume groups are fixed once the engine is configured.
+    if (const auto snapshot = getPolicySnapshot(); snapshot != nullptr) {
+        *_aidl_return = snapshot->volumeGroups;
+        return Status::ok();
+    }
+    AutoTimedMutexLock _l(mMutex, __func__);
     RETURN_IF_BINDER_ERROR(
             binderStatusFromStatusT(mAudioPolicyManager->listAudioVolumeGroups(groups)));
     *_aidl_return = VALUE_OR_RETURN_BINDER_STATUS(
@@ -2233,7 +2251,7 @@ Status AudioPolicyService::getVolumeGroupFromAudioAttributes(
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     RETURN_IF_BINDER_ERROR(
             binderStatusFromStatusT(
                     mAudioPolicyManager->getVolumeGroupFromAudioAttributes(
@@ -2244,7 +2262,7 @@ Status AudioPolicyService::getVolumeGroupFromAudioAttributes(
 
 Status AudioPolicyService::setRttEnabled(bool enabled)
 {
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     mUidPolicy->setRttEnabled(enabled);
     return Status::ok();
 }
@@ -2254,7 +2272,7 @@ Status AudioPolicyService::isCallScreenModeSupported(bool* _aidl_return)
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     AutoCallerClear acc;
     *_aidl_return = mAudioPolicyManager->isCallScreenModeSupported();
     return Status::ok();
@@ -2275,7 +2293,7 @@ Status AudioPolicyService::setDevicesRoleForStrategy(
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     status_t status = mAudioPolicyManager->setDevicesRoleForStrategy(strategy, role, devices);
     if (status == NO_ERROR) {
        onCheckSpatializer_l();
@@ -2298,7 +2316,7 @@ Status AudioPolicyService::removeDevicesRoleForStrategy(
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     status_t status = mAudioPolicyManager->removeDevicesRoleForStrategy(strategy, role, devices);
     if (status == NO_ERROR) {
        onCheckSpatializer_l();
@@ -2315,7 +2333,7 @@ Status AudioPolicyService::clearDevicesRoleForStrategy(int32_t strategyAidl,
    if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     status_t status = mAudioPolicyManager->clearDevicesRoleForStrategy(strategy, role);
     if (status == NO_ERROR) {
        onCheckSpatializer_l();
@@ -2336,7 +2354,7 @@ Status AudioPolicyService::getDevicesForRoleAndStrategy(
     if (mAudioPolicyManager == NULL) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     RETURN_IF_BINDER_ERROR(binderStatusFromStatusT(
             mAudioPolicyManager->getDevicesForRoleAndStrategy(strategy, role, devices)));
     *_aidl_return = VALUE_OR_RETURN_BINDER_STATUS(
@@ -2366,7 +2384,7 @@ Status AudioPolicyService::setDevicesRoleForCapturePreset(
     if (mAudioPolicyManager == nullptr) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     return binderStatusFromStatusT(
             mAudioPolicyManager->setDevicesRoleForCapturePreset(audioSource, role, devices));
 }
@@ -2386,7 +2404,7 @@ Status AudioPolicyService::addDevicesRoleForCapturePreset(
     if (mAudioPolicyManager == nullptr) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     return binderStatusFromStatusT(
             mAudioPolicyManager->addDevicesRoleForCapturePreset(audioSource, role, devices));
 }
@@ -2406,7 +2424,7 @@ Status AudioPolicyService::removeDevicesRoleForCapturePreset(
    if (mAudioPolicyManager == nullptr) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     return binderStatusFromStatusT(
             mAudioPolicyManager->removeDevicesRoleForCapturePreset(audioSource, role, devices));
 }
@@ -2421,7 +2439,7 @@ Status AudioPolicyService::clearDevicesRoleForCapturePreset(AudioSource audioSou
     if (mAudioPolicyManager == nullptr) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     return binderStatusFromStatusT(
             mAudioPolicyManager->clearDevicesRoleForCapturePreset(audioSource, role));
 }
@@ -2439,7 +2457,7 @@ Status AudioPolicyService::getDevicesForRoleAndCapturePreset(
     if (mAudioPolicyManager == nullptr) {
         return binderStatusFromStatusT(NO_INIT);
     }
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     RETURN_IF_BINDER_ERROR(binderStatusFromStatusT(
             mAudioPolicyManager->getDevicesForRoleAndCapturePreset(audioSource, role, devices)));
     *_aidl_return = VALUE_OR_RETURN_BINDER_STATUS(
@@ -2486,7 +2504,7 @@ Status AudioPolicyService::canBeSpatialized(
             convertContainer<AudioDeviceTypeAddrVector>(devicesAidl,
                                                         aidl2legacy_AudioDeviceTypeAddress));
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     *_aidl_return = mAudioPolicyManager->canBeSpatialized(&attr, &config, devices);
     return Status::ok();
 }
@@ -2505,7 +2523,7 @@ Status AudioPolicyService::getDirectPlaybackSupport(
             aidl2legacy_AudioAttributes_audio_attributes_t(attrAidl));
     audio_config_t config = VALUE_OR_RETURN_BINDER_STATUS(
             aidl2legacy_AudioConfig_audio_config_t(configAidl, false /*isInput*/));
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     *_aidl_return = static_cast<media::AudioDirectMode>(
             VALUE_OR_RETURN_BINDER_STATUS(legacy2aidl_audio_direct_mode_t_int32_t_mask(
                     mAudioPolicyManager->getDirectPlaybackSupport(&attr, &config))));
@@ -2522,7 +2540,7 @@ Status AudioPolicyService::getDirectProfilesForAttributes(
             aidl2legacy_AudioAttributes_audio_attributes_t(attrAidl));
     AudioProfileVector audioProfiles;
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     RETURN_IF_BINDER_ERROR(binderStatusFromStatusT(
             mAudioPolicyManager->getDirectProfilesForAttributes(&attr, audioProfiles)));
     *_aidl_return = VALUE_OR_RETURN_BINDER_STATUS(
@@ -2542,7 +2560,7 @@ Status AudioPolicyService::getSupportedMixerAttributes(
             aidl2legacy_int32_t_audio_port_handle_t(portIdAidl));
 
     std::vector<audio_mixer_attributes_t> mixerAttrs;
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     RETURN_IF_BINDER_ERROR(
             binderStatusFromStatusT(mAudioPolicyManager->getSupportedMixerAttributes(
                     portId, mixerAttrs)));
@@ -2570,7 +2588,7 @@ Status AudioPolicyService::setPreferredMixerAttributes(
     audio_port_handle_t portId = VALUE_OR_RETURN_BINDER_STATUS(
             aidl2legacy_int32_t_audio_port_handle_t(portIdAidl));
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     return binderStatusFromStatusT(
             mAudioPolicyManager->setPreferredMixerAttributes(&attr, portId, uid, &mixerAttr));
 }
@@ -2588,7 +2606,7 @@ Status AudioPolicyService::getPreferredMixerAttributes(
     audio_port_handle_t portId = VALUE_OR_RETURN_BINDER_STATUS(
             aidl2legacy_int32_t_audio_port_handle_t(portIdAidl));
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     audio_mixer_attributes_t mixerAttr = AUDIO_MIXER_ATTRIBUTES_INITIALIZER;
     RETURN_IF_BINDER_ERROR(
             binderStatusFromStatusT(mAudioPolicyManager->getPreferredMixerAttributes(
@@ -2612,7 +2630,7 @@ Status AudioPolicyService::clearPreferredMixerAttributes(
     audio_port_handle_t portId = VALUE_OR_RETURN_BINDER_STATUS(
             aidl2legacy_int32_t_audio_port_handle_t(portIdAidl));
 
-    audio_utils::lock_guard _l(mMutex);
+    AutoTimedMutexLock _l(mMutex, __func__);
     return binderStatusFromStatusT(
             mAudioPolicyManager->clearPreferredMixerAttributes(&attr, portId, uid));
 }
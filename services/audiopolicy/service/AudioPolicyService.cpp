@@ -185,6 +185,26 @@ static auto& getIAudioPolicyServiceStatistics() {
     return methodStatistics;
 }
 
+// Logs the IAudioPolicyService method latency histograms since the last export.
+static void exportMethodStatistics(mediautils::MethodStatistics<int>& statistics) {
+    using Stats = mediautils::MethodStatistics<int>;
+    mediametrics::LogItem item(
+            AMEDIAMETRICS_KEY_PREFIX_AUDIO_METHOD_STATISTICS "IAudioPolicyService");
+    bool empty = true;
+    statistics.exportHistograms([&](const std::string& method,
+            const Stats::HistogramType& histogram) {
+        item.set(method.c_str(), Stats::histogramToString(histogram).c_str());
+        empty = false;
+    });
+    if (!empty) item.record();
+}
+
+// singleton for the time IAudioPolicyService methods wait for AudioPolicyService::mMutex
+static auto& getIAudioPolicyServiceMutexWaitStatistics() {
+    static mediautils::MethodStatistics<std::string> methodStatistics;
+    return methodStatistics;
+}
+
 // ----------------------------------------------------------------------------
 
 static AudioPolicyInterface* createAudioPolicyManager(AudioPolicyClientInterface *clientInterface)
@@ -279,6 +299,7 @@ void AudioPolicyService::onFirstRef()
 
         loadAudioPolicyManager();
         mAudioPolicyManager = mCreateAudioPolicyManager(mAudioPolicyClient);
+        updatePolicySnapshot_l();
     }
 
     // load audio processing modules
@@ -317,6 +338,50 @@ void AudioPolicyService::onFirstRef()
     AudioSystem::audioPolicyReady();
 }
 
+AudioPolicyService::AutoTimedMutexLock::AutoTimedMutexLock(
+        audio_utils::mutex& mutex, const char* method) : mMutex(mutex) {
+    const nsecs_t beginNs = systemTime();
+    mMutex.lock();
+    getIAudioPolicyServiceMutexWaitStatistics().event(
+            method, (systemTime() - beginNs) * 1e-6f);
+}
+
+void AudioPolicyService::updatePolicySnapshot_l() {
+    std::shared_ptr<PolicySnapshot> snapshot;
+    if (mAudioPolicyManager != nullptr) {
+        snapshot = std::make_shared<PolicySnapshot>();
+        AudioProductStrategyVector strategies;
+        AudioVolumeGroupVector groups;
+        if (mAudioPolicyManager->getMasterMono(&snapshot->masterMono) != NO_ERROR
+                || mAudioPolicyManager->listAudioProductStrategies(strategies) != NO_ERROR
+                || mAudioPolicyManager->listAudioVolumeGroups(groups) != NO_ERROR) {
+            snapshot.reset();
+        } else {
+            auto aidlStrategies = convertContainer<std::vector<media::AudioProductStrategy>>(
+                    strategies, legacy2aidl_AudioProductStrategy);
+            auto aidlGroups = convertContainer<std::vector<media::AudioVolumeGroup>>(
+                    groups, legacy2aidl_AudioVolumeGroup);
+            if (!aidlStrategies.ok() || !aidlGroups.ok()) {
+                snapshot.reset();
+            } else {
+                snapshot->productStrategies = std::move(aidlStrategies.value());
+                snapshot->volumeGroups = std::move(aidlGroups.value());
+            }
+        }
+    }
+    if (snapshot == nullptr) {
+        ALOGW("%s: queries will be served under the service mutex", __func__);
+    }
+    std::lock_guard _l(mPolicySnapshotMutex);
+    mPolicySnapshot = std::move(snapshot);
+}
+
+std::shared_ptr<const AudioPolicyService::PolicySnapshot>
+AudioPolicyService::getPolicySnapshot() const {
+    std::lock_guard _l(mPolicySnapshotMutex);
+    return mPolicySnapshot;
+}
+
 const IPermissionProvider& AudioPolicyService::getPermissionProvider() const {
     return *mPermissionController;
 }
@@ -1279,6 +1344,12 @@ NO_THREAD_SAFETY_ANALYSIS  // update for trylock.
             dprintf(fd, "\nIAudioPolicyService binder call profile\n");
             write(fd, timeCheckStats.c_str(), timeCheckStats.size());
         }
+
+        {
+            std::string mutexWaitStats = getIAudioPolicyServiceMutexWaitStatistics().dump();
+            dprintf(fd, "\nIAudioPolicyService mutex wait profile\n");
+            write(fd, mutexWaitStats.c_str(), mutexWaitStats.size());
+        }
     }
     return NO_ERROR;
 }
@@ -1413,7 +1484,11 @@ status_t AudioPolicyService::onTransact(
                 .set(AMEDIAMETRICS_PROP_METHODNAME, methodName.c_str())
                 .record();
         } else {
-            getIAudioPolicyServiceStatistics().event(code, elapsedMs);
+            auto& statistics = getIAudioPolicyServiceStatistics();
+            statistics.event(code, elapsedMs);
+            if (statistics.isExportDue(systemTime(), statistics.kDefaultExportIntervalNs)) {
+                exportMethodStatistics(statistics);
+            }
         }
     }, mediautils::TimeCheck::kDefaultTimeoutDuration,
     mediautils::TimeCheck::kDefaultSecondChanceDuration,
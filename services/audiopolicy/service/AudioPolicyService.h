@@ -47,6 +47,8 @@
 #include <android/hardware/BnSensorPrivacyListener.h>
 #include <android/content/AttributionSourceState.h>
 
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 
 namespace android {
@@ -1007,6 +1009,33 @@ private:
         const   int64_t mToken;
     };
 
+    // Locks mMutex like audio_utils::lock_guard, and records how long the calling method
+    // waited for it in the mutex wait statistics dumped with the binder call profile.
+    class SCOPED_CAPABILITY AutoTimedMutexLock {
+    public:
+            AutoTimedMutexLock(audio_utils::mutex& mutex, const char* method) ACQUIRE(mutex);
+            ~AutoTimedMutexLock() RELEASE() { mMutex.unlock(); }
+
+    private:
+        audio_utils::mutex& mMutex;
+    };
+
+    // Immutable copy of policy state that does not change after the policy manager is
+    // initialized, or only on rare setter calls. Read-only queries served from it do not
+    // take mMutex, so they are not stuck behind a device connection or routing change.
+    struct PolicySnapshot {
+        bool masterMono = false;
+        std::vector<media::AudioProductStrategy> productStrategies;
+        std::vector<media::AudioVolumeGroup> volumeGroups;
+    };
+
+    // Rebuilds the snapshot from the policy manager. Must be called after any change to
+    // the state it holds.
+    void updatePolicySnapshot_l() REQUIRES(mMutex);
+    // Returns the current snapshot, or nullptr if none could be built.
+    std::shared_ptr<const PolicySnapshot> getPolicySnapshot() const
+            EXCLUDES(mPolicySnapshotMutex);
+
     // Internal dump utilities.
     status_t dumpPermissionDenial(int fd);
     void loadAudioPolicyManager();
@@ -1034,6 +1063,10 @@ private:
     AudioPolicyClient *mAudioPolicyClient;
     std::vector<audio_usage_t> mSupportedSystemUsages;
 
+    // Only held to swap or copy the snapshot pointer, never while calling out.
+    mutable std::mutex mPolicySnapshotMutex;
+    std::shared_ptr<const PolicySnapshot> mPolicySnapshot GUARDED_BY(mPolicySnapshotMutex);
+
     mutable audio_utils::mutex mNotificationClientsMutex{
             audio_utils::MutexOrder::kAudioPolicyService_NotificationClientsMutex};
     DefaultKeyedVector<int64_t, sp<NotificationClient>> mNotificationClients
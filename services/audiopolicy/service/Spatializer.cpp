@@ -168,16 +168,10 @@ public:
                     spatializer->calculateHeadPose();
                 }
                 } break;
-            case kWhatOnHeadToStagePose: {
-                std::vector<float> headToStage(sHeadPoseKeys.size());
-                for (size_t i = 0 ; i < sHeadPoseKeys.size(); i++) {
-                    if (!msg->findFloat(sHeadPoseKeys[i], &headToStage[i])) {
-                        ALOGE("%s: Cannot find kTranslation0Key!", __func__);
-                        return;
-                    }
-                }
-                spatializer->onHeadToStagePoseMsg(headToStage);
-                } break;
+            case kWhatOnHeadToStagePose:
+                // the pose is not in the message, see Spatializer::onHeadToStagePose()
+                spatializer->onHeadToStagePoseMsg();
+                break;
             case kWhatOnActualModeChange: {
                 int mode;
                 if (!msg->findInt32(kModeKey, &mode)) {
@@ -823,11 +817,18 @@ void Spatializer::onHeadToStagePose(const Pose3f& headToStage) {
     auto vec = headToStage.toVector();
     LOG_ALWAYS_FATAL_IF(vec.size() != sHeadPoseKeys.size(),
             "%s invalid head to stage vector size %zu", __func__, vec.size());
+    {
+        // Only keep the latest pose: if the engine is slow to apply a pose, the ones
+        // received meanwhile are replaced rather than queued and applied one by one.
+        std::lock_guard lock(mPendingHeadToStageMutex);
+        const bool messagePending = mPendingHeadToStage.has_value();
+        mPendingHeadToStage = std::move(vec);
+        if (messagePending) {
+            return;
+        }
+    }
     sp<AMessage> msg =
             new AMessage(EngineCallbackHandler::kWhatOnHeadToStagePose, mHandler);
-    for (size_t i = 0 ; i < sHeadPoseKeys.size(); i++) {
-        msg->setFloat(sHeadPoseKeys[i], vec[i]);
-    }
     msg->post();
 }
 
@@ -842,8 +843,17 @@ void Spatializer::resetEngineHeadPose_l() {
             std::vector<HeadTracking::Mode>{HeadTracking::Mode::DISABLED});
 }
 
-void Spatializer::onHeadToStagePoseMsg(const std::vector<float>& headToStage) {
+void Spatializer::onHeadToStagePoseMsg() {
     ALOGV("%s", __func__);
+    std::vector<float> headToStage;
+    {
+        std::lock_guard lock(mPendingHeadToStageMutex);
+        if (!mPendingHeadToStage.has_value()) {
+            return;
+        }
+        headToStage = std::move(*mPendingHeadToStage);
+        mPendingHeadToStage.reset();
+    }
     sp<media::ISpatializerHeadTrackingCallback> callback;
     {
         audio_utils::lock_guard lock(mMutex);
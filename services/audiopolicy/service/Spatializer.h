@@ -33,6 +33,8 @@
 #include <media/audiohal/EffectHalInterface.h>
 #include <media/stagefright/foundation/ALooper.h>
 #include <system/audio_effects/effect_spatializer.h>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <unordered_set>
 
@@ -237,7 +239,7 @@ private:
     void onHeadToStagePose(const media::Pose3f& headToStage) override;
     void onActualModeChange(media::HeadTrackingMode mode) override;
 
-    void onHeadToStagePoseMsg(const std::vector<float>& headToStage);
+    void onHeadToStagePoseMsg();
     void onActualModeChangeMsg(media::HeadTrackingMode mode);
 
     static constexpr int kMaxEffectParamValues = 10;
@@ -550,6 +552,14 @@ private:
     static const std::map<std::string, audio_latency_mode_t> sStringToLatencyModeMap;
     static const std::vector<const char*> sHeadPoseKeys;
 
+    /**
+     * Latest head to stage pose received from the pose controller and not yet sent to the
+     * engine. A kWhatOnHeadToStagePose message is only posted when this is empty.
+     * Guarded by mPendingHeadToStageMutex, which is never held while calling the engine.
+     */
+    std::mutex mPendingHeadToStageMutex;
+    std::optional<std::vector<float>> mPendingHeadToStage;
+
     // Local log for command messages.
     static constexpr int mMaxLocalLogLine = 10;
     SimpleLog mLocalLog{mMaxLocalLogLine};
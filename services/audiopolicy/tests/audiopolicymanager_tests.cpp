@@ -136,6 +136,96 @@ TEST(AudioPolicyConfigTest, LoadForTests) {
     }
 }
 
+namespace {
+
+// DeviceVector is sorted by pointer value, so devices are matched by their tag name.
+void expectSameDevices(const DeviceVector& expected, const DeviceVector& actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (const auto& device : expected) {
+        sp<DeviceDescriptor> other = actual.getDeviceFromTagName(device->getTagName());
+        ASSERT_NE(nullptr, other) << device->getTagName();
+        EXPECT_TRUE(device->equals(other)) << device->getTagName();
+        EXPECT_TRUE(device->AudioPort::equals(other)) << device->getTagName();
+    }
+}
+
+void expectSameConfigs(const sp<const AudioPolicyConfig>& expected,
+        const sp<const AudioPolicyConfig>& actual) {
+    EXPECT_EQ(expected->getSource(), actual->getSource());
+    EXPECT_EQ(expected->getEngineLibraryNameSuffix(), actual->getEngineLibraryNameSuffix());
+    EXPECT_EQ(expected->isCallScreenModeSupported(), actual->isCallScreenModeSupported());
+    EXPECT_EQ(expected->getSurroundFormats(), actual->getSurroundFormats());
+    expectSameDevices(expected->getInputDevices(), actual->getInputDevices());
+    expectSameDevices(expected->getOutputDevices(), actual->getOutputDevices());
+    ASSERT_NE(nullptr, actual->getDefaultOutputDevice());
+    EXPECT_EQ(expected->getDefaultOutputDevice()->getTagName(),
+            actual->getDefaultOutputDevice()->getTagName());
+
+    const HwModuleCollection& expectedModules = expected->getHwModules();
+    const HwModuleCollection& actualModules = actual->getHwModules();
+    ASSERT_EQ(expectedModules.size(), actualModules.size());
+    for (size_t i = 0; i < expectedModules.size(); ++i) {
+        const sp<HwModule>& module = expectedModules[i];
+        const sp<HwModule>& other = actualModules[i];
+        SCOPED_TRACE(module->getName());
+        EXPECT_STREQ(module->getName(), other->getName());
+        EXPECT_EQ(module->getHalVersionMajor(), other->getHalVersionMajor());
+        EXPECT_EQ(module->getHalVersionMinor(), other->getHalVersionMinor());
+        expectSameDevices(module->getDeclaredDevices(), other->getDeclaredDevices());
+        EXPECT_EQ(module->getRoutes().size(), other->getRoutes().size());
+        for (const auto& [profiles, otherProfiles] : {
+                std::make_pair(&module->getOutputProfiles(), &other->getOutputProfiles()),
+                std::make_pair(&module->getInputProfiles(), &other->getInputProfiles())}) {
+            ASSERT_EQ(profiles->size(), otherProfiles->size());
+            for (size_t j = 0; j < profiles->size(); ++j) {
+                const sp<IOProfile>& profile = profiles->itemAt(j);
+                const sp<IOProfile>& otherProfile = otherProfiles->itemAt(j);
+                EXPECT_TRUE(profile->AudioPort::equals(otherProfile)) << profile->getName();
+                EXPECT_EQ(profile->maxOpenCount, otherProfile->maxOpenCount);
+                EXPECT_EQ(profile->maxActiveCount, otherProfile->maxActiveCount);
+                expectSameDevices(profile->getSupportedDevices(),
+                        otherProfile->getSupportedDevices());
+            }
+        }
+    }
+}
+
+} // namespace
+
+TEST(AudioPolicyConfigTest, LoadFromXmlCache) {
+    TemporaryDir cacheDir;
+    const std::string cacheFile = std::string(cacheDir.path) + "/audio_policy_configuration.cache";
+    const std::string source =
+            base::GetExecutableDirectory() + "/test_audio_policy_configuration.xml";
+    auto parsed = AudioPolicyConfig::loadFromCustomXmlConfigForTests(source);
+    ASSERT_TRUE(parsed.ok());
+
+    auto cacheWritten = AudioPolicyConfig::loadFromCustomXmlConfigForTests(source, cacheFile);
+    ASSERT_TRUE(cacheWritten.ok());
+    ASSERT_EQ(0, access(cacheFile.c_str(), F_OK));
+    expectSameConfigs(parsed.value(), cacheWritten.value());
+
+    auto cacheRead = AudioPolicyConfig::loadFromCustomXmlConfigForTests(source, cacheFile);
+    ASSERT_TRUE(cacheRead.ok());
+    expectSameConfigs(parsed.value(), cacheRead.value());
+
+    // The cache of another file is not used.
+    const std::string otherSource =
+            base::GetExecutableDirectory() + "/test_audio_policy_primary_only_configuration.xml";
+    auto otherParsed = AudioPolicyConfig::loadFromCustomXmlConfigForTests(otherSource);
+    ASSERT_TRUE(otherParsed.ok());
+    auto otherCacheRead =
+            AudioPolicyConfig::loadFromCustomXmlConfigForTests(otherSource, cacheFile);
+    ASSERT_TRUE(otherCacheRead.ok());
+    expectSameConfigs(otherParsed.value(), otherCacheRead.value());
+
+    // Nor is a corrupted one.
+    ASSERT_TRUE(base::WriteStringToFile("not a cache", cacheFile));
+    auto corruptedCacheRead = AudioPolicyConfig::loadFromCustomXmlConfigForTests(source, cacheFile);
+    ASSERT_TRUE(corruptedCacheRead.ok());
+    expectSameConfigs(parsed.value(), corruptedCacheRead.value());
+}
+
 TEST(AudioPolicyManagerTestInit, EngineFailure) {
     AudioPolicyTestClient client;
     auto config = AudioPolicyConfig::createWritableForTests();
@@ -25,8 +25,10 @@
 #define ALOGVV(...) if (0) ALOGV(__VA_ARGS__)
 #endif
 
+#include <algorithm>
 #include <inttypes.h>
 
+#include <cutils/properties.h>
 #include <utils/Log.h>
 #include <utils/Trace.h>
 #include <gui/Surface.h>
@@ -174,6 +176,7 @@ ZslProcessor::ZslProcessor(
     // removed.
     mFrameListDepth = pipelineMaxDepth;
     mBufferQueueDepth = mFrameListDepth + 1;
+    mMaxBufferQueueDepth = mBufferQueueDepth;
 
     mZslQueue.insertAt(0, mBufferQueueDepth);
     mFrameList.resize(mFrameListDepth);
@@ -212,7 +215,18 @@ void ZslProcessor::onResultAvailable(const CaptureResult &result) {
     // Corresponding buffer has been cleared. No need to push into mFrameList
     if (timestamp <= mLatestClearedBufferTimestamp) return;
 
-    mFrameList[mFrameListHead] = result.mMetadata;
+    // Keep mCandidateFrames in sync with the slot being replaced, so that
+    // pushToReprocess doesn't need to look into all the frames
+    ZslFrame &slot = mFrameList[mFrameListHead];
+    if (slot.isCandidate) {
+        mCandidateFrames.erase(std::make_pair(slot.timestamp, mFrameListHead));
+    }
+    slot.metadata = result.mMetadata;
+    slot.timestamp = timestamp;
+    slot.isCandidate = isCandidateFrame(slot.metadata);
+    if (slot.isCandidate) {
+        mCandidateFrames.emplace(timestamp, mFrameListHead);
+    }
     mFrameListHead = (mFrameListHead + 1) % mFrameListDepth;
 }
 
@@ -251,6 +265,9 @@ status_t ZslProcessor::updateStream(const Parameters &params) {
         // Create stream for HAL production
         // TODO: Sort out better way to select resolution for ZSL
 
+        updateQueueDepthLocked(params.fastInfo.usedZslSize.width,
+                params.fastInfo.usedZslSize.height);
+
         sp<IGraphicBufferProducer> producer;
         sp<IGraphicBufferConsumer> consumer;
         BufferQueue::createBufferQueue(&producer, &consumer);
@@ -483,7 +500,7 @@ status_t ZslProcessor::pushToReprocess(int32_t requestId) {
     }
 
     {
-        CameraMetadata request = mFrameList[metadataIdx];
+        CameraMetadata request = mFrameList[metadataIdx].metadata;
 
         // Verify that the frame is reasonable for reprocessing
 
@@ -676,6 +693,29 @@ void ZslProcessor::clearZslResultQueueLocked() {
     mFrameList.clear();
     mFrameListHead = 0;
     mFrameList.resize(mFrameListDepth);
+    mCandidateFrames.clear();
+}
+
+void ZslProcessor::updateQueueDepthLocked(int32_t width, int32_t height) {
+    size_t depth = mMaxBufferQueueDepth;
+    int32_t budgetKb = property_get_int32("camera.zsl.memory_budget_kb", 0);
+    // ZSL buffers are YUV 4:2:0 in practice
+    int64_t bufferKb = static_cast<int64_t>(width) * height * 3 / 2 / 1024;
+    if (budgetKb > 0 && bufferKb > 0) {
+        depth = std::clamp(static_cast<size_t>(budgetKb / bufferKb), kMinBufferQueueDepth,
+                mMaxBufferQueueDepth);
+    }
+
+    ALOGV("%s: Camera %d: ZSL ring buffer depth %zu for %dx%d buffers, memory budget %d KB",
+            __FUNCTION__, mId, depth, width, height, budgetKb);
+    if (depth == mBufferQueueDepth) return;
+
+    // Same relation as in the constructor, see there
+    mBufferQueueDepth = depth;
+    mFrameListDepth = depth - 1;
+    mZslQueue.clear();
+    mZslQueue.insertAt(0, mBufferQueueDepth);
+    clearZslResultQueueLocked();
 }
 
 void ZslProcessor::dump(int fd, const Vector<String16>& /*args*/) const {
@@ -755,87 +795,80 @@ bool ZslProcessor::isFixedFocusMode(uint8_t afMode) const {
     }
 }
 
-nsecs_t ZslProcessor::getCandidateTimestampLocked(size_t* metadataIdx) const {
+bool ZslProcessor::isCandidateFrame(const CameraMetadata& frame) const {
     /**
-     * Find the smallest timestamp we know about so far
-     * - ensure that aeState is either converged or locked
+     * Ensure that aeState is either converged or locked, and that the frame
+     * is in focus
      */
+    camera_metadata_ro_entry_t entry;
+    entry = frame.find(ANDROID_CONTROL_AE_STATE);
 
-    size_t idx = 0;
-    nsecs_t minTimestamp = -1;
-
-    size_t emptyCount = mFrameList.size();
-
-    for (size_t j = 0; j < mFrameList.size(); j++) {
-        const CameraMetadata &frame = mFrameList[j];
-        if (!frame.isEmpty()) {
-
-            emptyCount--;
+    if (entry.count == 0) {
+        /**
+         * This is most likely a HAL bug. The aeState field is
+         * mandatory, so it should always be in a metadata packet.
+         */
+        ALOGW("%s: ZSL queue frame has no AE state field!",
+                __FUNCTION__);
+        return false;
+    }
+    if (entry.data.u8[0] != ANDROID_CONTROL_AE_STATE_CONVERGED &&
+            entry.data.u8[0] != ANDROID_CONTROL_AE_STATE_LOCKED) {
+        ALOGVV("%s: ZSL queue frame AE state is %d, need "
+               "full capture",  __FUNCTION__, entry.data.u8[0]);
+        return false;
+    }
 
-            camera_metadata_ro_entry_t entry;
-            entry = frame.find(ANDROID_SENSOR_TIMESTAMP);
+    entry = frame.find(ANDROID_CONTROL_AF_MODE);
+    if (entry.count == 0) {
+        ALOGW("%s: ZSL queue frame has no AF mode field!",
+                __FUNCTION__);
+        return false;
+    }
+    // Check AF state if device has focuser and focus mode isn't fixed
+    if (mHasFocuser) {
+        uint8_t afMode = entry.data.u8[0];
+        if (!isFixedFocusMode(afMode)) {
+            // Make sure the candidate frame has good focus.
+            entry = frame.find(ANDROID_CONTROL_AF_STATE);
             if (entry.count == 0) {
-                ALOGE("%s: Can't find timestamp in frame!",
+                ALOGW("%s: ZSL queue frame has no AF state field!",
                         __FUNCTION__);
-                continue;
+                return false;
             }
-            nsecs_t frameTimestamp = entry.data.i64[0];
-            if (minTimestamp > frameTimestamp || minTimestamp == -1) {
-
-                entry = frame.find(ANDROID_CONTROL_AE_STATE);
-
-                if (entry.count == 0) {
-                    /**
-                     * This is most likely a HAL bug. The aeState field is
-                     * mandatory, so it should always be in a metadata packet.
-                     */
-                    ALOGW("%s: ZSL queue frame has no AE state field!",
-                            __FUNCTION__);
-                    continue;
-                }
-                if (entry.data.u8[0] != ANDROID_CONTROL_AE_STATE_CONVERGED &&
-                        entry.data.u8[0] != ANDROID_CONTROL_AE_STATE_LOCKED) {
-                    ALOGVV("%s: ZSL queue frame AE state is %d, need "
-                           "full capture",  __FUNCTION__, entry.data.u8[0]);
-                    continue;
-                }
-
-                entry = frame.find(ANDROID_CONTROL_AF_MODE);
-                if (entry.count == 0) {
-                    ALOGW("%s: ZSL queue frame has no AF mode field!",
-                            __FUNCTION__);
-                    continue;
-                }
-                // Check AF state if device has focuser and focus mode isn't fixed
-                if (mHasFocuser) {
-                    uint8_t afMode = entry.data.u8[0];
-                    if (!isFixedFocusMode(afMode)) {
-                        // Make sure the candidate frame has good focus.
-                        entry = frame.find(ANDROID_CONTROL_AF_STATE);
-                        if (entry.count == 0) {
-                            ALOGW("%s: ZSL queue frame has no AF state field!",
-                                    __FUNCTION__);
-                            continue;
-                        }
-                        uint8_t afState = entry.data.u8[0];
-                        if (afState != ANDROID_CONTROL_AF_STATE_PASSIVE_FOCUSED &&
-                                afState != ANDROID_CONTROL_AF_STATE_FOCUSED_LOCKED &&
-                                afState != ANDROID_CONTROL_AF_STATE_NOT_FOCUSED_LOCKED) {
-                            ALOGVV("%s: ZSL queue frame AF state is %d is not good for capture,"
-                                    " skip it", __FUNCTION__, afState);
-                            continue;
-                        }
-                    }
-                }
-
-                minTimestamp = frameTimestamp;
-                idx = j;
+            uint8_t afState = entry.data.u8[0];
+            if (afState != ANDROID_CONTROL_AF_STATE_PASSIVE_FOCUSED &&
+                    afState != ANDROID_CONTROL_AF_STATE_FOCUSED_LOCKED &&
+                    afState != ANDROID_CONTROL_AF_STATE_NOT_FOCUSED_LOCKED) {
+                ALOGVV("%s: ZSL queue frame AF state is %d is not good for capture,"
+                        " skip it", __FUNCTION__, afState);
+                return false;
             }
-
-            ALOGVV("%s: Saw timestamp %" PRId64, __FUNCTION__, frameTimestamp);
         }
     }
 
+    return true;
+}
+
+nsecs_t ZslProcessor::getCandidateTimestampLocked(size_t* metadataIdx) const {
+    /**
+     * Find the smallest timestamp we know about so far among the frames
+     * good for reprocessing, checked by onResultAvailable
+     */
+
+    size_t idx = 0;
+    nsecs_t minTimestamp = -1;
+
+    size_t emptyCount = 0;
+    for (const ZslFrame &frame : mFrameList) {
+        if (frame.timestamp == -1) emptyCount++;
+    }
+
+    if (!mCandidateFrames.empty()) {
+        minTimestamp = mCandidateFrames.begin()->first;
+        idx = mCandidateFrames.begin()->second;
+    }
+
     if (emptyCount == mFrameList.size()) {
         /**
          * This could be mildly bad and means our ZSL was triggered before
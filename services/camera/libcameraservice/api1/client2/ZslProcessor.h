@@ -17,6 +17,9 @@
 #ifndef ANDROID_SERVERS_CAMERA_CAMERA2_ZSLPROCESSOR_H
 #define ANDROID_SERVERS_CAMERA_CAMERA2_ZSLPROCESSOR_H
 
+#include <set>
+#include <utility>
+
 #include <utils/Thread.h>
 #include <utils/String16.h>
 #include <utils/Vector.h>
@@ -122,11 +125,27 @@ class ZslProcessor :
         CameraMetadata frame;
     };
 
+    // A result in the frame list, with what candidate selection needs
+    // extracted from it when it arrives
+    struct ZslFrame {
+        CameraMetadata metadata;
+        // -1 for an empty slot
+        nsecs_t timestamp = -1;
+        // Whether AE and AF states make it good for reprocessing
+        bool isCandidate = false;
+    };
+
     static const int32_t kDefaultMaxPipelineDepth = 4;
+    // Smallest ring buffer depth the memory budget may bring it down to
+    static constexpr size_t kMinBufferQueueDepth = 2;
+    size_t mMaxBufferQueueDepth;
     size_t mBufferQueueDepth;
     size_t mFrameListDepth;
-    std::vector<CameraMetadata> mFrameList;
+    std::vector<ZslFrame> mFrameList;
     size_t mFrameListHead;
+    // Candidate frames in the frame list, ordered by timestamp, with their
+    // index in mFrameList
+    std::set<std::pair<nsecs_t, size_t>> mCandidateFrames;
 
     ZslPair mNextPair;
 
@@ -151,6 +170,13 @@ class ZslProcessor :
 
     void clearZslResultQueueLocked();
 
+    // Sets the ring buffer and frame list depths for ZSL buffers of the given
+    // size, within the camera.zsl.memory_budget_kb property if set
+    void updateQueueDepthLocked(int32_t width, int32_t height);
+
+    // Whether a result is good for reprocessing, checking AE and AF states
+    bool isCandidateFrame(const CameraMetadata& frame) const;
+
     void dumpZslQueue(int id) const;
 
     nsecs_t getCandidateTimestampLocked(size_t* metadataIdx) const;
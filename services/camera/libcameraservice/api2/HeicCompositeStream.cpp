@@ -19,6 +19,8 @@
 #define ALIGN(x, mask) ( ((x) + (mask) - 1) & ~((mask) - 1) )
 //#define LOG_NDEBUG 0
 
+#include <algorithm>
+
 #include <linux/memfd.h>
 #include <pthread.h>
 #include <sys/syscall.h>
@@ -69,7 +71,6 @@ HeicCompositeStream::HeicCompositeStream(sp<CameraDeviceBase> device,
         mYuvBufferAcquired(false),
         mProducerListener(new ProducerListener()),
         mDequeuedOutputBufferCnt(0),
-        mCodecOutputCounter(0),
         mQuality(-1),
         mGridTimestampUs(0),
         mStatusId(StatusTracker::NO_STATUS_ID) {
@@ -170,7 +171,7 @@ status_t HeicCompositeStream::createInternalStreams(const std::vector<sp<Surface
     }
 
     if (!mUseGrid) {
-        res = mCodec->createInputSurface(&producer);
+        res = mCodecs[0]->createInputSurface(&producer);
         if (res != OK) {
             ALOGE("%s: Failed to create input surface for Heic codec: %s (%d)",
                     __FUNCTION__, strerror(-res), res);
@@ -184,11 +185,13 @@ status_t HeicCompositeStream::createInternalStreams(const std::vector<sp<Surface
     }
     mMainImageSurface = new Surface(producer);
 
-    res = mCodec->start();
-    if (res != OK) {
-        ALOGE("%s: Failed to start codec: %s (%d)", __FUNCTION__,
-                strerror(-res), res);
-        return res;
+    for (auto& codec : mCodecs) {
+        res = codec->start();
+        if (res != OK) {
+            ALOGE("%s: Failed to start codec: %s (%d)", __FUNCTION__,
+                    strerror(-res), res);
+            return res;
+        }
     }
 
     std::vector<int> sourceSurfaceId;
@@ -281,7 +284,10 @@ void HeicCompositeStream::onBufferReleased(const BufferInfo& bufferInfo) {
 
     if (bufferInfo.mStreamId == mMainImageStreamId) {
         mMainImageFrameNumbers.push(bufferInfo.mFrameNumber);
-        mCodecOutputBufferFrameNumbers.push(bufferInfo.mFrameNumber);
+        for (auto& frameNumbers : mCodecOutputBufferFrameNumbers) {
+            frameNumbers.push(bufferInfo.mFrameNumber);
+        }
+        mMainImageReleaseTimes[bufferInfo.mFrameNumber] = systemTime();
         ALOGV("%s: [%" PRId64 "]: Adding main image frame number (%zu frame numbers in total)",
                 __FUNCTION__, bufferInfo.mFrameNumber, mMainImageFrameNumbers.size());
     } else if (bufferInfo.mStreamId == mAppSegmentStreamId) {
@@ -409,10 +415,16 @@ void HeicCompositeStream::onHeicOutputFrameAvailable(
         const CodecOutputBufferInfo& outputBufferInfo) {
     Mutex::Autolock l(mMutex);
 
-    ALOGV("%s: index %d, offset %d, size %d, time %" PRId64 ", flags 0x%x",
-            __FUNCTION__, outputBufferInfo.index, outputBufferInfo.offset,
-            outputBufferInfo.size, outputBufferInfo.timeUs, outputBufferInfo.flags);
+    ALOGV("%s: codec %zu, index %d, offset %d, size %d, time %" PRId64 ", flags 0x%x",
+            __FUNCTION__, outputBufferInfo.codecIndex, outputBufferInfo.index,
+            outputBufferInfo.offset, outputBufferInfo.size, outputBufferInfo.timeUs,
+            outputBufferInfo.flags);
 
+    if (outputBufferInfo.codecIndex >= mCodecs.size()) {
+        ALOGE("%s: Invalid codec index %zu", __FUNCTION__, outputBufferInfo.codecIndex);
+        return;
+    }
+    const sp<MediaCodec>& codec = mCodecs[outputBufferInfo.codecIndex];
     if (!mErrorState) {
         if ((outputBufferInfo.size > 0) &&
                 ((outputBufferInfo.flags & MediaCodec::BUFFER_FLAG_CODECCONFIG) == 0)) {
@@ -421,26 +433,30 @@ void HeicCompositeStream::onHeicOutputFrameAvailable(
         } else {
             ALOGV("%s: Releasing output buffer: size %d flags: 0x%x ", __FUNCTION__,
                 outputBufferInfo.size, outputBufferInfo.flags);
-            mCodec->releaseOutputBuffer(outputBufferInfo.index);
+            codec->releaseOutputBuffer(outputBufferInfo.index);
         }
     } else {
-        mCodec->releaseOutputBuffer(outputBufferInfo.index);
+        codec->releaseOutputBuffer(outputBufferInfo.index);
     }
 }
 
-void HeicCompositeStream::onHeicInputFrameAvailable(int32_t index) {
+void HeicCompositeStream::onHeicInputFrameAvailable(size_t codecIndex, int32_t index) {
     Mutex::Autolock l(mMutex);
 
     if (!mUseGrid) {
         ALOGE("%s: Codec YUV input mode must only be used for Hevc tiling mode", __FUNCTION__);
         return;
     }
+    if (codecIndex >= mCodecInputBuffers.size()) {
+        ALOGE("%s: Invalid codec index %zu", __FUNCTION__, codecIndex);
+        return;
+    }
 
-    mCodecInputBuffers.push_back(index);
+    mCodecInputBuffers[codecIndex].push_back(index);
     mInputReadyCondition.signal();
 }
 
-void HeicCompositeStream::onHeicFormatChanged(sp<AMessage>& newFormat) {
+void HeicCompositeStream::onHeicFormatChanged(size_t codecIndex, sp<AMessage>& newFormat) {
     if (newFormat == nullptr) {
         ALOGE("%s: newFormat must not be null!", __FUNCTION__);
         return;
@@ -448,6 +464,16 @@ void HeicCompositeStream::onHeicFormatChanged(sp<AMessage>& newFormat) {
 
     Mutex::Autolock l(mMutex);
 
+    if (codecIndex >= mCodecs.size()) {
+        ALOGE("%s: Invalid codec index %zu", __FUNCTION__, codecIndex);
+        return;
+    }
+    if (codecIndex > 0) {
+        mTileCodecFormats[codecIndex] = newFormat;
+        checkTileCodecFormatsLocked();
+        return;
+    }
+
     AString mime;
     AString mimeHeic(MIMETYPE_IMAGE_ANDROID_HEIC);
     newFormat->findString(KEY_MIME, &mime);
@@ -491,11 +517,40 @@ void HeicCompositeStream::onHeicFormatChanged(sp<AMessage>& newFormat) {
     }
 
     mFormat = newFormat;
+    checkTileCodecFormatsLocked();
 
     ALOGV("%s: mNumOutputTiles is %zu", __FUNCTION__, mNumOutputTiles);
     mInputReadyCondition.signal();
 }
 
+void HeicCompositeStream::checkTileCodecFormatsLocked() {
+    // The muxer track is created with the format of the first codec, so the tiles from the
+    // other codecs must use the same parameter sets.
+    sp<ABuffer> csd, tileCsd;
+    if (mFormat == nullptr || !mFormat->findBuffer("csd-0", &csd)) {
+        return;
+    }
+    for (size_t i = 1; i < mTileCodecFormats.size(); i++) {
+        if (mTileCodecFormats[i] == nullptr ||
+                !mTileCodecFormats[i]->findBuffer("csd-0", &tileCsd)) {
+            continue;
+        }
+        if (csd->size() != tileCsd->size() ||
+                memcmp(csd->data(), tileCsd->data(), csd->size()) != 0) {
+            ALOGE("%s: Codec %zu has different codec specific data than codec 0, tiles"
+                    " can't be encoded in parallel", __FUNCTION__, i);
+            mErrorState = true;
+            mInputReadyCondition.signal();
+            return;
+        }
+    }
+}
+
+size_t HeicCompositeStream::getNumTilesForCodec(size_t codecIndex) const {
+    size_t numCodecs = mCodecs.size();
+    return (mNumOutputTiles + numCodecs - 1 - codecIndex) / numCodecs;
+}
+
 void HeicCompositeStream::onHeicCodecError() {
     Mutex::Autolock l(mMutex);
     mErrorState = true;
@@ -635,6 +690,17 @@ void HeicCompositeStream::compilePendingInputLocked() {
         }
     }
 
+    auto releaseTime = mMainImageReleaseTimes.begin();
+    while (releaseTime != mMainImageReleaseTimes.end()) {
+        auto inputFrame = mPendingInputFrames.find(releaseTime->first);
+        if (inputFrame != mPendingInputFrames.end()) {
+            inputFrame->second.encodeStartTime = releaseTime->second;
+            releaseTime = mMainImageReleaseTimes.erase(releaseTime);
+        } else {
+            releaseTime++;
+        }
+    }
+
     while (!mInputAppSegmentBuffers.empty() && mAppSegmentFrameNumbers.size() > 0) {
         CpuConsumer::LockedBuffer imgBuffer;
         auto it = mInputAppSegmentBuffers.begin();
@@ -723,28 +789,39 @@ void HeicCompositeStream::compilePendingInputLocked() {
         mMainImageFrameNumbers.pop();
     }
 
-    while (!mCodecOutputBuffers.empty()) {
-        auto it = mCodecOutputBuffers.begin();
-        // Assume encoder input to output is FIFO, use a queue to look up
+    auto outputIt = mCodecOutputBuffers.begin();
+    while (outputIt != mCodecOutputBuffers.end()) {
+        // Assume encoder input to output is FIFO, use a queue for each codec to look up
         // frameNumber when handling codec outputs.
+        size_t codecIndex = outputIt->codecIndex;
+        auto& frameNumbers = mCodecOutputBufferFrameNumbers[codecIndex];
         int64_t bufferFrameNumber = -1;
-        if (mCodecOutputBufferFrameNumbers.empty()) {
+        if (frameNumbers.empty()) {
             ALOGV("%s: Failed to find buffer frameNumber for codec output buffer!", __FUNCTION__);
-            break;
+            outputIt++;
+            continue;
         } else {
             // Direct mapping between camera frame number and codec timestamp (in us).
-            bufferFrameNumber = mCodecOutputBufferFrameNumbers.front();
-            mCodecOutputCounter++;
-            if (mCodecOutputCounter == mNumOutputTiles) {
-                mCodecOutputBufferFrameNumbers.pop();
-                mCodecOutputCounter = 0;
+            bufferFrameNumber = frameNumbers.front();
+            size_t& outputCounter = mCodecOutputCounters[codecIndex];
+            outputIt->tileIndex = codecIndex + outputCounter * mCodecs.size();
+            outputCounter++;
+            if (outputCounter == getNumTilesForCodec(codecIndex)) {
+                frameNumbers.pop();
+                outputCounter = 0;
             }
 
-            mPendingInputFrames[bufferFrameNumber].codecOutputBuffers.push_back(*it);
+            // Keep the outputs of the frame in tile order, for the muxer.
+            auto& codecOutputBuffers = mPendingInputFrames[bufferFrameNumber].codecOutputBuffers;
+            auto position = std::upper_bound(codecOutputBuffers.begin(),
+                    codecOutputBuffers.end(), outputIt->tileIndex,
+                    [](size_t tileIndex, const CodecOutputBufferInfo& info) {
+                        return tileIndex < info.tileIndex; });
+            codecOutputBuffers.insert(position, *outputIt);
             ALOGV("%s: [%" PRId64 "]: Pushing codecOutputBuffers (frameNumber %" PRId64 ")",
-                    __FUNCTION__, bufferFrameNumber, it->timeUs);
+                    __FUNCTION__, bufferFrameNumber, outputIt->timeUs);
         }
-        mCodecOutputBuffers.erase(it);
+        outputIt = mCodecOutputBuffers.erase(outputIt);
     }
 
     while (!mCaptureResults.empty()) {
@@ -790,21 +867,24 @@ void HeicCompositeStream::compilePendingInputLocked() {
         it = mExifErrorFrameNumbers.erase(it);
     }
 
-    // Distribute codec input buffers to be filled out from YUV output
-    for (auto it = mPendingInputFrames.begin();
-            it != mPendingInputFrames.end() && mCodecInputBuffers.size() > 0; it++) {
+    // Distribute codec input buffers to be filled out from YUV output. Tiles go to the
+    // codecs in turn, so that each codec's outputs map back to tiles in order.
+    for (auto it = mPendingInputFrames.begin(); it != mPendingInputFrames.end(); it++) {
         InputFrame& inputFrame(it->second);
         if (inputFrame.codecInputCounter < mGridRows * mGridCols) {
             // Available input tiles that are required for the current input
             // image.
-            size_t newInputTiles = std::min(mCodecInputBuffers.size(),
-                    mGridRows * mGridCols - inputFrame.codecInputCounter);
-            for (size_t i = 0; i < newInputTiles; i++) {
-                CodecInputBufferInfo inputInfo =
-                        { mCodecInputBuffers[0], mGridTimestampUs++, inputFrame.codecInputCounter };
+            while (inputFrame.codecInputCounter < mGridRows * mGridCols) {
+                size_t codecIndex = inputFrame.codecInputCounter % mCodecs.size();
+                auto& codecInputBuffers = mCodecInputBuffers[codecIndex];
+                if (codecInputBuffers.empty()) {
+                    break;
+                }
+                CodecInputBufferInfo inputInfo = { codecInputBuffers[0], mGridTimestampUs++,
+                        inputFrame.codecInputCounter, codecIndex };
                 inputFrame.codecInputBuffers.push_back(inputInfo);
 
-                mCodecInputBuffers.erase(mCodecInputBuffers.begin());
+                codecInputBuffers.erase(codecInputBuffers.begin());
                 inputFrame.codecInputCounter++;
             }
             break;
@@ -830,7 +910,7 @@ bool HeicCompositeStream::getNextReadyInputLocked(int64_t *frameNumber /*out*/)
                 (it.second.appSegmentBuffer.data != nullptr || it.second.exifError) &&
                 !it.second.appSegmentWritten && it.second.result != nullptr &&
                 it.second.muxer != nullptr;
-        bool codecOutputReady = !it.second.codecOutputBuffers.empty();
+        bool codecOutputReady = it.second.isNextCodecOutputReady();
         bool codecInputReady = (it.second.yuvBuffer.data != nullptr) &&
                 (!it.second.codecInputBuffers.empty());
         bool hasOutputBuffer = it.second.muxer != nullptr ||
@@ -871,7 +951,7 @@ status_t HeicCompositeStream::processInputFrame(int64_t frameNumber,
             (inputFrame.appSegmentBuffer.data != nullptr || inputFrame.exifError) &&
             !inputFrame.appSegmentWritten && inputFrame.result != nullptr &&
             inputFrame.muxer != nullptr;
-    bool codecOutputReady = inputFrame.codecOutputBuffers.size() > 0;
+    bool codecOutputReady = inputFrame.isNextCodecOutputReady();
     bool codecInputReady = inputFrame.yuvBuffer.data != nullptr &&
             !inputFrame.codecInputBuffers.empty();
     bool hasOutputBuffer = inputFrame.muxer != nullptr ||
@@ -918,8 +998,8 @@ status_t HeicCompositeStream::processInputFrame(int64_t frameNumber,
         }
     }
 
-    // Write media codec bitstream buffers to muxer.
-    while (!inputFrame.codecOutputBuffers.empty()) {
+    // Write media codec bitstream buffers to muxer, in tile order.
+    while (inputFrame.isNextCodecOutputReady()) {
         res = processOneCodecOutputFrame(frameNumber, inputFrame);
         if (res != OK) {
             ALOGE("%s: Failed to process codec output frame: %s (%d)", __FUNCTION__,
@@ -1079,8 +1159,9 @@ status_t HeicCompositeStream::processAppSegment(int64_t frameNumber, InputFrame
 
 status_t HeicCompositeStream::processCodecInputFrame(InputFrame &inputFrame) {
     for (auto& inputBuffer : inputFrame.codecInputBuffers) {
+        const sp<MediaCodec>& codec = mCodecs[inputBuffer.codecIndex];
         sp<MediaCodecBuffer> buffer;
-        auto res = mCodec->getInputBuffer(inputBuffer.index, &buffer);
+        auto res = codec->getInputBuffer(inputBuffer.index, &buffer);
         if (res != OK) {
             ALOGE("%s: Error getting codec input buffer: %s (%d)", __FUNCTION__,
                     strerror(-res), res);
@@ -1107,7 +1188,7 @@ status_t HeicCompositeStream::processCodecInputFrame(InputFrame &inputFrame) {
             return res;
         }
 
-        res = mCodec->queueInputBuffer(inputBuffer.index, 0, buffer->capacity(),
+        res = codec->queueInputBuffer(inputBuffer.index, 0, buffer->capacity(),
                 inputBuffer.timeUs, 0, nullptr /*errorDetailMsg*/);
         if (res != OK) {
             ALOGE("%s: Failed to queueInputBuffer to Codec: %s (%d)",
@@ -1123,8 +1204,9 @@ status_t HeicCompositeStream::processCodecInputFrame(InputFrame &inputFrame) {
 status_t HeicCompositeStream::processOneCodecOutputFrame(int64_t frameNumber,
         InputFrame &inputFrame) {
     auto it = inputFrame.codecOutputBuffers.begin();
+    const sp<MediaCodec>& codec = mCodecs[it->codecIndex];
     sp<MediaCodecBuffer> buffer;
-    status_t res = mCodec->getOutputBuffer(it->index, &buffer);
+    status_t res = codec->getOutputBuffer(it->index, &buffer);
     if (res != OK) {
         ALOGE("%s: Error getting Heic codec output buffer at index %d: %s (%d)",
                 __FUNCTION__, it->index, strerror(-res), res);
@@ -1145,17 +1227,17 @@ status_t HeicCompositeStream::processOneCodecOutputFrame(int64_t frameNumber,
         return res;
     }
 
-    mCodec->releaseOutputBuffer(it->index);
+    codec->releaseOutputBuffer(it->index);
     if (inputFrame.pendingOutputTiles == 0) {
         ALOGW("%s: Codec generated more tiles than expected!", __FUNCTION__);
     } else {
         inputFrame.pendingOutputTiles--;
     }
+    inputFrame.codecOutputCounter++;
 
-    inputFrame.codecOutputBuffers.erase(inputFrame.codecOutputBuffers.begin());
-
-    ALOGV("%s: [%" PRId64 "]: Output buffer index %d",
-        __FUNCTION__, frameNumber, it->index);
+    ALOGV("%s: [%" PRId64 "]: Output buffer index %d of codec %zu",
+        __FUNCTION__, frameNumber, it->index, it->codecIndex);
+    inputFrame.codecOutputBuffers.erase(it);
     return OK;
 }
 
@@ -1217,6 +1299,13 @@ status_t HeicCompositeStream::processCompletedInputFrame(int64_t frameNumber,
     inputFrame.anb = nullptr;
     mDequeuedOutputBufferCnt--;
 
+    if (inputFrame.encodeStartTime > 0) {
+        nsecs_t encodeTime = systemTime() - inputFrame.encodeStartTime;
+        ALOGV("%s: [%" PRId64 "]: %zu tiles encoded with %zu codecs in %" PRId64 " us",
+                __FUNCTION__, frameNumber, mNumOutputTiles, mCodecs.size(), ns2us(encodeTime));
+        ATRACE_INT64("HEIC encode time us", ns2us(encodeTime));
+    }
+
     ALOGV("%s: [%" PRId64 "]", __FUNCTION__, frameNumber);
     ATRACE_ASYNC_END("HEIC capture", frameNumber);
     return OK;
@@ -1236,10 +1325,13 @@ void HeicCompositeStream::releaseInputFrameLocked(int64_t frameNumber,
 
     while (!inputFrame->codecOutputBuffers.empty()) {
         auto it = inputFrame->codecOutputBuffers.begin();
-        ALOGV("%s: releaseOutputBuffer index %d", __FUNCTION__, it->index);
-        mCodec->releaseOutputBuffer(it->index);
+        ALOGV("%s: releaseOutputBuffer index %d of codec %zu", __FUNCTION__, it->index,
+                it->codecIndex);
+        mCodecs[it->codecIndex]->releaseOutputBuffer(it->index);
         inputFrame->codecOutputBuffers.erase(it);
     }
+    mMainImageReleaseTimes.erase(mMainImageReleaseTimes.begin(),
+            mMainImageReleaseTimes.upper_bound(frameNumber));
 
     if (inputFrame->yuvBuffer.data != nullptr) {
         mMainImageConsumer->unlockBuffer(inputFrame->yuvBuffer);
@@ -1329,17 +1421,6 @@ status_t HeicCompositeStream::initializeCodec(uint32_t width, uint32_t height,
         return NO_INIT;
     }
 
-    // Create HEIC/HEVC codec.
-    if (mUseHeic) {
-        mCodec = MediaCodec::CreateByType(mCodecLooper, desiredMime, true /*encoder*/);
-    } else {
-        mCodec = MediaCodec::CreateByComponentName(mCodecLooper, hevcName);
-    }
-    if (mCodec == nullptr) {
-        ALOGE("%s: Failed to create codec for %s", __FUNCTION__, desiredMime);
-        return NO_INIT;
-    }
-
     // Create Looper and handler for Codec callback.
     mCodecCallbackHandler = new CodecCallbackHandler(this);
     if (mCodecCallbackHandler == nullptr) {
@@ -1359,15 +1440,7 @@ status_t HeicCompositeStream::initializeCodec(uint32_t width, uint32_t height,
     }
     mCallbackLooper->registerHandler(mCodecCallbackHandler);
 
-    mAsyncNotify = new AMessage(kWhatCallbackNotify, mCodecCallbackHandler);
-    res = mCodec->setCallback(mAsyncNotify);
-    if (res != OK) {
-        ALOGE("%s: Failed to set MediaCodec callback: %s (%d)", __FUNCTION__,
-                strerror(-res), res);
-        return res;
-    }
-
-    // Create output format and configure the Codec.
+    // Create output format.
     sp<AMessage> outputFormat = new AMessage();
     outputFormat->setString(KEY_MIME, desiredMime);
     outputFormat->setInt32(KEY_BITRATE_MODE, BITRATE_MODE_CQ);
@@ -1405,12 +1478,63 @@ status_t HeicCompositeStream::initializeCodec(uint32_t width, uint32_t height,
     // This only serves as a hint to encoder when encoding is not real-time.
     outputFormat->setInt32(KEY_OPERATING_RATE, useGrid ? kGridOpRate : kNoGridOpRate);
 
-    res = mCodec->configure(outputFormat, nullptr /*nativeWindow*/,
-            nullptr /*crypto*/, CONFIGURE_FLAG_ENCODE);
-    if (res != OK) {
-        ALOGE("%s: Failed to configure codec: %s (%d)", __FUNCTION__,
-                strerror(-res), res);
-        return res;
+    // With framework tiling, encode the tiles with as many HEVC codecs as supported. Only the
+    // first one is required.
+    size_t numCodecs = 1;
+    if (useGrid) {
+        numCodecs = std::min(
+                static_cast<size_t>(HeicEncoderInfoManager::getInstance().getMaxTileEncoders()),
+                static_cast<size_t>(gridRows * gridCols));
+    }
+    mCodecs.clear();
+    mAsyncNotifies.clear();
+    for (size_t i = 0; i < numCodecs; i++) {
+        // Create HEIC/HEVC codec.
+        sp<MediaCodec> codec;
+        if (mUseHeic) {
+            codec = MediaCodec::CreateByType(mCodecLooper, desiredMime, true /*encoder*/);
+        } else {
+            codec = MediaCodec::CreateByComponentName(mCodecLooper, hevcName);
+        }
+        if (codec == nullptr) {
+            ALOGE("%s: Failed to create codec %zu for %s", __FUNCTION__, i, desiredMime);
+            if (i > 0) break;
+            return NO_INIT;
+        }
+
+        sp<AMessage> asyncNotify = new AMessage(kWhatCallbackNotify, mCodecCallbackHandler);
+        asyncNotify->setSize("codecIndex", i);
+        res = codec->setCallback(asyncNotify);
+        if (res != OK) {
+            ALOGE("%s: Failed to set MediaCodec callback: %s (%d)", __FUNCTION__,
+                    strerror(-res), res);
+            codec->release();
+            if (i > 0) break;
+            return res;
+        }
+
+        res = codec->configure(outputFormat->dup(), nullptr /*nativeWindow*/,
+                nullptr /*crypto*/, CONFIGURE_FLAG_ENCODE);
+        if (res != OK) {
+            ALOGE("%s: Failed to configure codec %zu: %s (%d)", __FUNCTION__, i,
+                    strerror(-res), res);
+            codec->release();
+            if (i > 0) break;
+            return res;
+        }
+        mCodecs.push_back(codec);
+        mAsyncNotifies.push_back(asyncNotify);
+    }
+    ALOGV("%s: Encoding %d tiles with %zu codecs", __FUNCTION__, gridRows * gridCols,
+            mCodecs.size());
+    mCodecInputBuffers.assign(mCodecs.size(), std::vector<int32_t>());
+    mCodecOutputBufferFrameNumbers.assign(mCodecs.size(), std::queue<int64_t>());
+    mCodecOutputCounters.assign(mCodecs.size(), 0);
+    mTileCodecFormats.assign(mCodecs.size(), nullptr);
+    if (useGrid) {
+        // Known before the first codec reports its output format, and needed to map the
+        // outputs of the other codecs to tiles.
+        mNumOutputTiles = gridRows * gridCols;
     }
 
     mGridWidth = gridWidth;
@@ -1430,11 +1554,11 @@ status_t HeicCompositeStream::initializeCodec(uint32_t width, uint32_t height,
 
 void HeicCompositeStream::deinitCodec() {
     ALOGV("%s", __FUNCTION__);
-    if (mCodec != nullptr) {
-        mCodec->stop();
-        mCodec->release();
-        mCodec.clear();
+    for (auto& codec : mCodecs) {
+        codec->stop();
+        codec->release();
     }
+    mCodecs.clear();
 
     if (mCodecLooper != nullptr) {
         mCodecLooper->stop();
@@ -1446,8 +1570,9 @@ void HeicCompositeStream::deinitCodec() {
         mCallbackLooper.clear();
     }
 
-    mAsyncNotify.clear();
+    mAsyncNotifies.clear();
     mFormat.clear();
+    mTileCodecFormats.clear();
 }
 
 // Return the size of the complete list of app segment, 0 indicates failure
@@ -1679,11 +1804,16 @@ void HeicCompositeStream::updateCodecQualityLocked(int32_t quality) {
     if (quality != mQuality) {
         sp<AMessage> qualityParams = new AMessage;
         qualityParams->setInt32(PARAMETER_KEY_VIDEO_BITRATE, quality);
-        status_t res = mCodec->setParameters(qualityParams);
-        if (res != OK) {
-            ALOGE("%s: Failed to set codec quality: %s (%d)",
-                    __FUNCTION__, strerror(-res), res);
-        } else {
+        status_t res = OK;
+        for (auto& codec : mCodecs) {
+            res = codec->setParameters(qualityParams);
+            if (res != OK) {
+                ALOGE("%s: Failed to set codec quality: %s (%d)",
+                        __FUNCTION__, strerror(-res), res);
+                break;
+            }
+        }
+        if (res == OK) {
             mQuality = quality;
         }
     }
@@ -1845,7 +1975,9 @@ void HeicCompositeStream::CodecCallbackHandler::onMessageReceived(const sp<AMess
                  break;
              }
 
-             ALOGV("kWhatCallbackNotify: cbID = %d", cbID);
+             size_t codecIndex = 0;
+             msg->findSize("codecIndex", &codecIndex);
+             ALOGV("kWhatCallbackNotify: codec %zu cbID = %d", codecIndex, cbID);
 
              switch (cbID) {
                  case MediaCodec::CB_INPUT_AVAILABLE: {
@@ -1854,7 +1986,7 @@ void HeicCompositeStream::CodecCallbackHandler::onMessageReceived(const sp<AMess
                          ALOGE("CB_INPUT_AVAILABLE: index is expected.");
                          break;
                      }
-                     parent->onHeicInputFrameAvailable(index);
+                     parent->onHeicInputFrameAvailable(codecIndex, index);
                      break;
                  }
 
@@ -1891,7 +2023,8 @@ void HeicCompositeStream::CodecCallbackHandler::onMessageReceived(const sp<AMess
                          (int32_t)offset,
                          (int32_t)size,
                          timeUs,
-                         (uint32_t)flags};
+                         (uint32_t)flags,
+                         codecIndex};
 
                      parent->onHeicOutputFrameAvailable(bufferInfo);
                      break;
@@ -1909,7 +2042,7 @@ void HeicCompositeStream::CodecCallbackHandler::onMessageReceived(const sp<AMess
                      if (format != nullptr) {
                          formatCopy = format->dup();
                      }
-                     parent->onHeicFormatChanged(formatCopy);
+                     parent->onHeicFormatChanged(codecIndex, formatCopy);
                      break;
                  }
 
@@ -18,6 +18,7 @@
 #define ANDROID_SERVERS_CAMERA_CAMERA3_HEIC_COMPOSITE_STREAM_H
 
 #include <queue>
+#include <vector>
 
 #include <gui/IProducerListener.h>
 #include <gui/CpuConsumer.h>
@@ -99,12 +100,15 @@ private:
         int32_t size;
         int64_t timeUs;
         uint32_t flags;
+        size_t codecIndex = 0;
+        size_t tileIndex = 0;
     };
 
     struct CodecInputBufferInfo {
         int32_t index;
         int64_t timeUs;
         size_t tileIndex;
+        size_t codecIndex;
     };
 
     class CodecCallbackHandler : public AHandler {
@@ -122,11 +126,16 @@ private:
     };
 
     bool              mUseHeic;
-    sp<MediaCodec>    mCodec;
+    // With framework YUV tiling, the tiles of an image are spread across up to
+    // HeicEncoderInfoManager::getMaxTileEncoders() codec instances, tile i going to
+    // mCodecs[i % mCodecs.size()]. Otherwise, and for the output format, only mCodecs[0].
+    std::vector<sp<MediaCodec>> mCodecs;
     sp<ALooper>       mCodecLooper, mCallbackLooper;
     sp<CodecCallbackHandler> mCodecCallbackHandler;
-    sp<AMessage>      mAsyncNotify;
+    std::vector<sp<AMessage>> mAsyncNotifies;
     sp<AMessage>      mFormat;
+    // Output format of the other codecs, which must have the same codec specific data.
+    std::vector<sp<AMessage>> mTileCodecFormats;
     size_t            mNumOutputTiles;
 
     int32_t           mOutputWidth, mOutputHeight;
@@ -140,9 +149,14 @@ private:
     static const int32_t kGridOpRate = 120;
 
     void onHeicOutputFrameAvailable(const CodecOutputBufferInfo& bufferInfo);
-    void onHeicInputFrameAvailable(int32_t index);  // Only called for YUV input mode.
-    void onHeicFormatChanged(sp<AMessage>& newFormat);
+    // Only called for YUV input mode.
+    void onHeicInputFrameAvailable(size_t codecIndex, int32_t index);
+    void onHeicFormatChanged(size_t codecIndex, sp<AMessage>& newFormat);
     void onHeicCodecError();
+    // Enter error state if the codecs don't use the same parameter sets
+    void checkTileCodecFormatsLocked();
+    // Number of tiles of each image encoded by mCodecs[codecIndex]
+    size_t getNumTilesForCodec(size_t codecIndex) const;
 
     status_t initializeCodec(uint32_t width, uint32_t height,
             const sp<CameraDeviceBase>& cameraDevice);
@@ -178,11 +192,22 @@ private:
         bool                      appSegmentWritten;
         size_t                    pendingOutputTiles;
         size_t                    codecInputCounter;
+        // Tiles written to the muxer, which takes them in tile order
+        size_t                    codecOutputCounter;
+        // When the main image was released to the encoder side
+        nsecs_t                   encodeStartTime;
 
         InputFrame() : orientation(0), quality(kDefaultJpegQuality), error(false),
                        exifError(false), timestamp(-1), requestId(-1), fenceFd(-1),
                        fileFd(-1), trackIndex(-1), anb(nullptr), appSegmentWritten(false),
-                       pendingOutputTiles(0), codecInputCounter(0) { }
+                       pendingOutputTiles(0), codecInputCounter(0), codecOutputCounter(0),
+                       encodeStartTime(0) { }
+
+        // Whether the codec output of the next tile is ready to be written
+        bool isNextCodecOutputReady() const {
+            return !codecOutputBuffers.empty() &&
+                    codecOutputBuffers.front().tileIndex == codecOutputCounter;
+        }
     };
 
     void compilePendingInputLocked();
@@ -262,14 +287,19 @@ private:
 
     // Keep all incoming HEIC blob buffer pending further processing.
     std::vector<CodecOutputBufferInfo> mCodecOutputBuffers;
-    std::queue<int64_t> mCodecOutputBufferFrameNumbers;
-    size_t mCodecOutputCounter;
+    // Frame numbers and output counters, for each codec
+    std::vector<std::queue<int64_t>> mCodecOutputBufferFrameNumbers;
+    std::vector<size_t> mCodecOutputCounters;
     int32_t mQuality;
 
+    // Time each main image was released to the encoder side, by frame number
+    std::map<int64_t, nsecs_t> mMainImageReleaseTimes;
+
     // Keep all incoming Yuv buffer pending tiling and encoding (for HEVC YUV tiling only)
     std::vector<int64_t> mInputYuvBuffers;
-    // Keep all codec input buffers ready to be filled out (for HEVC YUV tiling only)
-    std::vector<int32_t> mCodecInputBuffers;
+    // Keep all codec input buffers ready to be filled out, for each codec (for HEVC YUV
+    // tiling only)
+    std::vector<std::vector<int32_t>> mCodecInputBuffers;
 
     // Artificial strictly incremental YUV grid timestamp to make encoder happy.
     int64_t mGridTimestampUs;
@@ -17,7 +17,9 @@
 #define LOG_TAG "HeicEncoderInfoManager"
 //#define LOG_NDEBUG 0
 
+#include <algorithm>
 #include <cstdint>
+#include <cstdlib>
 #include <regex>
 
 #include <cutils/properties.h>
@@ -39,6 +41,7 @@ HeicEncoderInfoManager::HeicEncoderInfoManager() :
         mMaxSizeHeic(INT32_MAX, INT32_MAX),
         mHasHEVC(false),
         mHasHEIC(false),
+        mMaxTileEncoders(1),
         mDisableGrid(false) {
     if (initialize() == OK) {
         mIsInited = true;
@@ -338,6 +341,17 @@ bool HeicEncoderInfoManager::getHevcCodecDetails(
         mMaxSizeHevc = maxSizeHevc;
         mHevcFrameRateMaps = hevcFrameRateMaps;
 
+        // Leave one instance to other clients, such as a video recording.
+        AString maxInstances;
+        if (details->findString("max-concurrent-instances", &maxInstances)) {
+            int32_t maxTileEncoders = property_get_int32("camera.heic.max_tile_encoders",
+                    kDefaultMaxTileEncoders);
+            mMaxTileEncoders = std::max(1,
+                    std::min(maxTileEncoders, atoi(maxInstances.c_str()) - 1));
+        }
+        ALOGV("%s: [%s] max tile encoders %d", __FUNCTION__, info->getCodecName(),
+                mMaxTileEncoders);
+
         found = true;
         break;
     }
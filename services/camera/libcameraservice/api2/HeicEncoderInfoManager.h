@@ -38,9 +38,15 @@ public:
     bool isSizeSupported(int32_t width, int32_t height,
             bool* useHeic, bool* useGrid, int64_t* stall, AString* hevcName) const;
 
+    // Max number of HEVC codec instances to encode the grid tiles of an image with, 1 if
+    // the HEVC codec doesn't report concurrent instances.
+    int32_t getMaxTileEncoders() const { return mMaxTileEncoders; }
+
     // kGridWidth and kGridHeight should be 2^n
     static const auto kGridWidth = 512;
     static const auto kGridHeight = 512;
+    // Can be overridden with camera.heic.max_tile_encoders
+    static const int32_t kDefaultMaxTileEncoders = 2;
 private:
     struct SizePairHash {
         std::size_t operator () (const std::pair<int32_t,int32_t> &p) const {
@@ -69,6 +75,7 @@ private:
     std::pair<int32_t, int32_t> mMinSizeHevc, mMaxSizeHevc;
     bool mHasHEVC, mHasHEIC;
     AString mHevcName;
+    int32_t mMaxTileEncoders;
     FrameRateMaps mHeicFrameRateMaps, mHevcFrameRateMaps;
     bool mDisableGrid;
 
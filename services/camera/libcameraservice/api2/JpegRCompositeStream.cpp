@@ -305,8 +305,10 @@ status_t JpegRCompositeStream::processInputFrame(nsecs_t ts, const InputFrame &i
     p010.luma_stride = inputFrame.p010Buffer.stride / 2;
     p010.chroma_stride = inputFrame.p010Buffer.chromaStride / 2;
 
+    // The encoder reads the locked input planes and writes into the locked output buffer
+    // directly, leaving room for the blob header at the end.
     jpegR.data = dstBuffer;
-    jpegR.maxLength = maxJpegRBufferSize;
+    jpegR.maxLength = maxJpegRBufferSize - sizeof(CameraBlob);
 
     ultrahdr::ultrahdr_transfer_function transferFunction;
     switch (mP010DynamicRange) {
@@ -360,6 +362,7 @@ status_t JpegRCompositeStream::processInputFrame(nsecs_t ts, const InputFrame &i
 
     if (res != OK) {
         ALOGE("%s: Error trying to encode JPEG/R: %s (%d)", __FUNCTION__, strerror(-res), res);
+        outputANW->cancelBuffer(mOutputSurface.get(), anb, /*fence*/ -1);
         return res;
     }
 
@@ -376,6 +379,7 @@ status_t JpegRCompositeStream::processInputFrame(nsecs_t ts, const InputFrame &i
     if (res != OK) {
         ALOGE("%s: Stream %d: Error setting timestamp: %s (%d)", __FUNCTION__,
                 getStreamId(), strerror(-res), res);
+        outputANW->cancelBuffer(mOutputSurface.get(), anb, /*fence*/ -1);
         return res;
     }
 
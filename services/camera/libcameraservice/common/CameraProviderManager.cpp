@@ -1000,14 +1000,46 @@ status_t CameraProviderManager::dump(int fd, const Vector<String16>& args) {
 
 void CameraProviderManager::ProviderInfo::initializeProviderInfoCommon(
         const std::vector<std::string> &devices) {
+    ATRACE_CALL();
+    // Initializing a device info queries the HAL for the device interface, resource
+    // cost and characteristics, which adds up for providers with many (physical or
+    // virtual) cameras. Do it for all devices in parallel, and then add them in the
+    // order the provider listed them.
+    struct NewDevice {
+        std::string name;
+        std::future<std::unique_ptr<DeviceInfo>> deviceInfo;
+    };
+    std::vector<NewDevice> newDevices;
+    std::set<std::pair<std::string, uint16_t>> newDeviceIds;
     for (auto& device : devices) {
+        ALOGI("Enumerating new camera device: %s", device.c_str());
+        uint16_t major, minor;
         std::string id;
-        status_t res = addDevice(device, CameraDeviceStatus::PRESENT, &id);
+        status_t res = checkNewDevice(device, &major, &minor, &id);
+        if (res == OK && !newDeviceIds.emplace(id, major).second) {
+            ALOGE("%s: Device %s: ID %s is already in use for device major version %d",
+                    __FUNCTION__, device.c_str(), id.c_str(), major);
+            res = BAD_VALUE;
+        }
         if (res != OK) {
             ALOGE("%s: Unable to enumerate camera device '%s': %s (%d)",
                     __FUNCTION__, device.c_str(), strerror(-res), res);
             continue;
         }
+        newDevices.push_back({device, std::async(std::launch::async,
+                [this, device, id, minor]() {
+                    return initializeDeviceInfo(device, mProviderTagid, id, minor);
+                })});
+    }
+
+    for (auto& newDevice : newDevices) {
+        std::unique_ptr<DeviceInfo> deviceInfo = newDevice.deviceInfo.get();
+        if (deviceInfo == nullptr) {
+            ALOGE("%s: Unable to enumerate camera device '%s': %s (%d)",
+                    __FUNCTION__, newDevice.name.c_str(), strerror(-BAD_VALUE), BAD_VALUE);
+            continue;
+        }
+        addDeviceInfo(std::move(deviceInfo), CameraDeviceStatus::PRESENT);
     }
 
     ALOGI("Camera provider %s ready with %zu camera devices",
@@ -2327,10 +2359,28 @@ status_t CameraProviderManager::ProviderInfo::addDevice(
     ALOGI("Enumerating new camera device: %s", name.c_str());
 
     uint16_t major, minor;
-    std::string type, id;
+    std::string id;
+    status_t res = checkNewDevice(name, &major, &minor, &id);
+    if (res != OK) {
+        return res;
+    }
+
+    std::unique_ptr<DeviceInfo> deviceInfo = initializeDeviceInfo(name, mProviderTagid, id, minor);
+    if (deviceInfo == nullptr) return BAD_VALUE;
+    addDeviceInfo(std::move(deviceInfo), initialStatus);
+
+    if (parsedId != nullptr) {
+        *parsedId = id;
+    }
+    return OK;
+}
+
+status_t CameraProviderManager::ProviderInfo::checkNewDevice(const std::string& name,
+        /*out*/ uint16_t* major, /*out*/ uint16_t* minor, /*out*/ std::string* id) {
+    std::string type;
     IPCTransport transport = getIPCTransport();
 
-    status_t res = parseDeviceName(name, &major, &minor, &type, &id);
+    status_t res = parseDeviceName(name, major, minor, &type, id);
     if (res != OK) {
         return res;
     }
@@ -2340,28 +2390,27 @@ status_t CameraProviderManager::ProviderInfo::addDevice(
                 type.c_str(), mType.c_str());
         return BAD_VALUE;
     }
-    if (mManager->isValidDeviceLocked(id, major, transport)) {
+    if (mManager->isValidDeviceLocked(*id, *major, transport)) {
         ALOGE("%s: Device %s: ID %s is already in use for device major version %d", __FUNCTION__,
-                name.c_str(), id.c_str(), major);
+                name.c_str(), id->c_str(), *major);
         return BAD_VALUE;
     }
 
-    std::unique_ptr<DeviceInfo> deviceInfo;
     switch (transport) {
         case IPCTransport::HIDL:
-            switch (major) {
+            switch (*major) {
                 case 3:
                     break;
                 default:
                     ALOGE("%s: Device %s: Unsupported HIDL device HAL major version %d:",
-                          __FUNCTION__,  name.c_str(), major);
+                          __FUNCTION__,  name.c_str(), *major);
                     return BAD_VALUE;
             }
             break;
         case IPCTransport::AIDL:
-            if (major != 1) {
+            if (*major != 1) {
                 ALOGE("%s: Device %s: Unsupported AIDL device HAL major version %d:", __FUNCTION__,
-                        name.c_str(), major);
+                        name.c_str(), *major);
                 return BAD_VALUE;
             }
             break;
@@ -2370,8 +2419,12 @@ status_t CameraProviderManager::ProviderInfo::addDevice(
             return BAD_VALUE;
     }
 
-    deviceInfo = initializeDeviceInfo(name, mProviderTagid, id, minor);
-    if (deviceInfo == nullptr) return BAD_VALUE;
+    return OK;
+}
+
+void CameraProviderManager::ProviderInfo::addDeviceInfo(std::unique_ptr<DeviceInfo> deviceInfo,
+        CameraDeviceStatus initialStatus) {
+    std::string id = deviceInfo->mId;
     deviceInfo->notifyDeviceStateChange(getDeviceState());
     deviceInfo->mStatus = initialStatus;
     bool isAPI1Compatible = deviceInfo->isAPI1Compatible();
@@ -2387,11 +2440,6 @@ status_t CameraProviderManager::ProviderInfo::addDevice(
             mUniqueAPI1CompatibleCameraIds.push_back(id);
         }
     }
-
-    if (parsedId != nullptr) {
-        *parsedId = id;
-    }
-    return OK;
 }
 
 void CameraProviderManager::ProviderInfo::removeDevice(const std::string &id) {
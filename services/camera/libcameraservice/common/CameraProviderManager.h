@@ -832,6 +832,13 @@ private:
                 const std::string& name, CameraDeviceStatus initialStatus,
                 /*out*/ std::string* parsedId);
 
+        // The steps of addDevice: check that a device name can be added, then
+        // initializeDeviceInfo, then add the resulting device info.
+        status_t checkNewDevice(const std::string& name, /*out*/ uint16_t* major,
+                /*out*/ uint16_t* minor, /*out*/ std::string* id);
+        void addDeviceInfo(std::unique_ptr<DeviceInfo> deviceInfo,
+                CameraDeviceStatus initialStatus);
+
         void cameraDeviceStatusChangeInternal(const std::string& cameraDeviceName,
                 CameraDeviceStatus newStatus);
 
@@ -34,11 +34,16 @@
 #include <jpeglib.h>
 #include <libexif/exif-data.h>
 #include <libexif/exif-system.h>
+#include <algorithm>
+#include <future>
+#include <inttypes.h>
 #include <math.h>
 #include <sstream>
+#include <thread>
 #include <utils/Errors.h>
 #include <utils/ExifUtils.h>
 #include <utils/Log.h>
+#include <utils/Timers.h>
 #include <xmpmeta/xmp_data.h>
 #include <xmpmeta/xmp_writer.h>
 
@@ -239,152 +244,171 @@ status_t encodeGrayscaleJpeg(size_t width, size_t height, uint8_t *in, void *out
     return ret;
 }
 
-inline void unpackDepth16(uint16_t value, std::vector<float> *points /*out*/,
-        std::vector<float> *confidence /*out*/, float *near /*out*/, float *far /*out*/) {
-    // Android densely packed depth map. The units for the range are in
-    // millimeters and need to be scaled to meters.
-    // The confidence value is encoded in the 3 most significant bits.
-    // The confidence data needs to be additionally normalized with
-    // values 1.0f, 0.0f representing maximum and minimum confidence
-    // respectively.
-    auto point = static_cast<float>(value & 0x1FFF) / 1000.f;
-    points->push_back(point);
-
-    auto conf = (value >> 13) & 0x7;
-    float normConfidence = (conf == 0) ? 1.f : (static_cast<float>(conf) - 1) / 7.f;
-    confidence->push_back(normConfidence);
-    if (normConfidence < CONFIDENCE_THRESHOLD) {
-        return;
-    }
+// Android densely packed depth map. The units for the range are in
+// millimeters and need to be scaled to meters.
+// The confidence value is encoded in the 3 most significant bits.
+// The confidence data needs to be additionally normalized with
+// values 1.0f, 0.0f representing maximum and minimum confidence
+// respectively.
+static const uint16_t DEPTH16_RANGE_MASK = 0x1FFF;
+static const int DEPTH16_CONFIDENCE_SHIFT = 13;
+
+inline float getDepth16Range(uint16_t value) {
+    return static_cast<float>(value & DEPTH16_RANGE_MASK) / 1000.f;
+}
 
-    if (*near > point) {
-        *near = point;
-    }
-    if (*far < point) {
-        *far = point;
+inline float getDepth16Confidence(uint16_t value) {
+    auto conf = (value >> DEPTH16_CONFIDENCE_SHIFT) & 0x7;
+    return (conf == 0) ? 1.f : (static_cast<float>(conf) - 1) / 7.f;
+}
+
+// Bit 'n' is set when the confidence value 'n' is at or above CONFIDENCE_THRESHOLD.
+static uint8_t getConfidentMask() {
+    uint8_t mask = 0;
+    for (uint16_t conf = 0; conf < 8; conf++) {
+        if (getDepth16Confidence(conf << DEPTH16_CONFIDENCE_SHIFT) >= CONFIDENCE_THRESHOLD) {
+            mask |= 1 << conf;
+        }
     }
+    return mask;
 }
 
 // Trivial case, read forward from top,left corner.
-void rotate0AndUnpack(DepthPhotoInputFrame inputFrame, std::vector<float> *points /*out*/,
-        std::vector<float> *confidence /*out*/, float *near /*out*/, float *far /*out*/) {
+void rotate0(DepthPhotoInputFrame inputFrame, uint16_t *out) {
     for (size_t i = 0; i < inputFrame.mDepthMapHeight; i++) {
-        for (size_t j = 0; j < inputFrame.mDepthMapWidth; j++) {
-            unpackDepth16(inputFrame.mDepthMapBuffer[i*inputFrame.mDepthMapStride + j], points,
-                    confidence, near, far);
-        }
+        memcpy(out + i*inputFrame.mDepthMapWidth,
+                inputFrame.mDepthMapBuffer + i*inputFrame.mDepthMapStride,
+                inputFrame.mDepthMapWidth * sizeof(uint16_t));
     }
 }
 
 // 90 degrees CW rotation can be applied by starting to read from bottom, left corner
 // transposing rows and columns.
-void rotate90AndUnpack(DepthPhotoInputFrame inputFrame, std::vector<float> *points /*out*/,
-        std::vector<float> *confidence /*out*/, float *near /*out*/, float *far /*out*/) {
+void rotate90(DepthPhotoInputFrame inputFrame, uint16_t *out) {
     for (size_t i = 0; i < inputFrame.mDepthMapWidth; i++) {
         for (ssize_t j = inputFrame.mDepthMapHeight-1; j >= 0; j--) {
-            unpackDepth16(inputFrame.mDepthMapBuffer[j*inputFrame.mDepthMapStride + i], points,
-                    confidence, near, far);
+            *out++ = inputFrame.mDepthMapBuffer[j*inputFrame.mDepthMapStride + i];
         }
     }
 }
 
 // 180 CW degrees rotation can be applied by starting to read backwards from bottom, right corner.
-void rotate180AndUnpack(DepthPhotoInputFrame inputFrame, std::vector<float> *points /*out*/,
-        std::vector<float> *confidence /*out*/, float *near /*out*/, float *far /*out*/) {
+void rotate180(DepthPhotoInputFrame inputFrame, uint16_t *out) {
     for (ssize_t i = inputFrame.mDepthMapHeight-1; i >= 0; i--) {
         for (ssize_t j = inputFrame.mDepthMapWidth-1; j >= 0; j--) {
-            unpackDepth16(inputFrame.mDepthMapBuffer[i*inputFrame.mDepthMapStride + j], points,
-                    confidence, near, far);
+            *out++ = inputFrame.mDepthMapBuffer[i*inputFrame.mDepthMapStride + j];
         }
     }
 }
 
 // 270 degrees CW rotation can be applied by starting to read from top, right corner
 // transposing rows and columns.
-void rotate270AndUnpack(DepthPhotoInputFrame inputFrame, std::vector<float> *points /*out*/,
-        std::vector<float> *confidence /*out*/, float *near /*out*/, float *far /*out*/) {
+void rotate270(DepthPhotoInputFrame inputFrame, uint16_t *out) {
     for (ssize_t i = inputFrame.mDepthMapWidth-1; i >= 0; i--) {
         for (size_t j = 0; j < inputFrame.mDepthMapHeight; j++) {
-            unpackDepth16(inputFrame.mDepthMapBuffer[j*inputFrame.mDepthMapStride + i], points,
-                    confidence, near, far);
+            *out++ = inputFrame.mDepthMapBuffer[j*inputFrame.mDepthMapStride + i];
         }
     }
 }
 
-bool rotateAndUnpack(DepthPhotoInputFrame inputFrame, std::vector<float> *points /*out*/,
-        std::vector<float> *confidence /*out*/, float *near /*out*/, float *far /*out*/) {
-    switch (inputFrame.mOrientation) {
+void rotate(DepthPhotoInputFrame inputFrame, DepthPhotoOrientation orientation,
+        uint16_t *out) {
+    switch (orientation) {
         case DepthPhotoOrientation::DEPTH_ORIENTATION_0_DEGREES:
-            rotate0AndUnpack(inputFrame, points, confidence, near, far);
-            return false;
+            rotate0(inputFrame, out);
+            break;
         case DepthPhotoOrientation::DEPTH_ORIENTATION_90_DEGREES:
-            rotate90AndUnpack(inputFrame, points, confidence, near, far);
-            return true;
+            rotate90(inputFrame, out);
+            break;
         case DepthPhotoOrientation::DEPTH_ORIENTATION_180_DEGREES:
-            rotate180AndUnpack(inputFrame, points, confidence, near, far);
-            return false;
+            rotate180(inputFrame, out);
+            break;
         case DepthPhotoOrientation::DEPTH_ORIENTATION_270_DEGREES:
-            rotate270AndUnpack(inputFrame, points, confidence, near, far);
-            return true;
+            rotate270(inputFrame, out);
+            break;
         default:
             ALOGE("%s: Unsupported depth photo rotation: %d, default to 0", __FUNCTION__,
-                    inputFrame.mOrientation);
-            rotate0AndUnpack(inputFrame, points, confidence, near, far);
+                    orientation);
+            rotate0(inputFrame, out);
+    }
+}
+
+bool switchesDimensions(DepthPhotoOrientation orientation) {
+    return (orientation == DepthPhotoOrientation::DEPTH_ORIENTATION_90_DEGREES) ||
+            (orientation == DepthPhotoOrientation::DEPTH_ORIENTATION_270_DEGREES);
+}
+
+// Finds the near and far range of the samples with sufficient confidence. The
+// loop only uses integer min/max so that it can be vectorized. Returns false
+// if no sample is confident enough.
+bool getDepth16NearFar(const uint16_t *samples, size_t count, float *near /*out*/,
+        float *far /*out*/) {
+    const uint8_t confidentMask = getConfidentMask();
+    uint16_t nearRange = DEPTH16_RANGE_MASK;
+    uint16_t farRange = 0;
+    bool confident = false;
+    for (size_t i = 0; i < count; i++) {
+        uint16_t range = samples[i] & DEPTH16_RANGE_MASK;
+        bool isConfident = (confidentMask >> (samples[i] >> DEPTH16_CONFIDENCE_SHIFT)) & 1;
+        nearRange = std::min(nearRange, isConfident ? range : DEPTH16_RANGE_MASK);
+        farRange = std::max(farRange, isConfident ? range : static_cast<uint16_t>(0));
+        confident |= isConfident;
     }
 
-    return false;
+    if (confident) {
+        *near = getDepth16Range(nearRange);
+        *far = getDepth16Range(farRange);
+    }
+    return confident;
+}
+
+// Applies the range inverse coding to the depth samples and quantizes their
+// confidence, both to 8 bits. Kept free of branches and calls so that the
+// compiler can vectorize it.
+void quantizeDepth16(const uint16_t *samples, size_t count, float near, float far,
+        uint8_t *points /*out*/, uint8_t *confidence /*out*/) {
+    for (size_t i = 0; i < count; i++) {
+        auto point = getDepth16Range(samples[i]);
+        auto conf = getDepth16Confidence(samples[i]);
+        if (conf < CONFIDENCE_THRESHOLD) {
+            point = std::clamp(point, near, far);
+        }
+        points[i] = floorf(((far * (point - near)) / (point * (far - near))) * 255.0f);
+        confidence[i] = floorf(conf * 255.0f);
+    }
 }
 
 std::unique_ptr<dynamic_depth::DepthMap> processDepthMapFrame(DepthPhotoInputFrame inputFrame,
-        ExifOrientation exifOrientation, std::vector<std::unique_ptr<Item>> *items /*out*/,
-        bool *switchDimensions /*out*/) {
-    if ((items == nullptr) || (switchDimensions == nullptr)) {
+        ExifOrientation exifOrientation, DepthPhotoOrientation depthOrientation,
+        std::vector<std::unique_ptr<Item>> *items /*out*/) {
+    if (items == nullptr) {
         return nullptr;
     }
 
-    std::vector<float> points, confidence;
-
+    nsecs_t startTime = systemTime();
     size_t pointCount = inputFrame.mDepthMapWidth * inputFrame.mDepthMapHeight;
-    points.reserve(pointCount);
-    confidence.reserve(pointCount);
-    float near = UINT16_MAX;
-    float far = .0f;
-    *switchDimensions = false;
-    // Physical rotation of depth and confidence maps may be needed in case
-    // the EXIF orientation is set to 0 degrees and the depth photo orientation
-    // (source color image) has some different value.
-    if (exifOrientation == ExifOrientation::ORIENTATION_0_DEGREES) {
-        *switchDimensions = rotateAndUnpack(inputFrame, &points, &confidence, &near, &far);
-    } else {
-        rotate0AndUnpack(inputFrame, &points, &confidence, &near, &far);
-    }
+    std::vector<uint16_t> samples(pointCount);
+    rotate(inputFrame, depthOrientation, samples.data());
 
     size_t width = inputFrame.mDepthMapWidth;
     size_t height = inputFrame.mDepthMapHeight;
-    if (*switchDimensions) {
+    if (switchesDimensions(depthOrientation)) {
         width = inputFrame.mDepthMapHeight;
         height = inputFrame.mDepthMapWidth;
     }
 
+    float near = UINT16_MAX;
+    float far = .0f;
+    getDepth16NearFar(samples.data(), pointCount, &near, &far);
     if (near == far) {
         ALOGE("%s: Near and far range values must not match!", __FUNCTION__);
         return nullptr;
     }
 
-    std::vector<uint8_t> pointsQuantized, confidenceQuantized;
-    pointsQuantized.reserve(pointCount); confidenceQuantized.reserve(pointCount);
-    auto pointIt = points.begin();
-    auto confidenceIt = confidence.begin();
-    while ((pointIt != points.end()) && (confidenceIt != confidence.end())) {
-        auto point = *pointIt;
-        if ((*confidenceIt) < CONFIDENCE_THRESHOLD) {
-            point = std::clamp(point, near, far);
-        }
-        pointsQuantized.push_back(floorf(((far * (point - near)) /
-                (point * (far - near))) * 255.0f));
-        confidenceQuantized.push_back(floorf(*confidenceIt * 255.0f));
-        confidenceIt++; pointIt++;
-    }
+    std::vector<uint8_t> pointsQuantized(pointCount), confidenceQuantized(pointCount);
+    quantizeDepth16(samples.data(), pointCount, near, far, pointsQuantized.data(),
+            confidenceQuantized.data());
+    nsecs_t conversionTime = systemTime();
 
     DepthMapParams depthParams(DepthFormat::kRangeInverse, near, far, DepthUnits::kMeters,
             "android/depthmap");
@@ -392,24 +416,42 @@ std::unique_ptr<dynamic_depth::DepthMap> processDepthMapFrame(DepthPhotoInputFra
     depthParams.mime = "image/jpeg";
     depthParams.depth_image_data.resize(inputFrame.mMaxJpegSize);
     depthParams.confidence_data.resize(inputFrame.mMaxJpegSize);
+
+    // The confidence map is encoded on a separate thread, alongside the depth map.
+    status_t confidenceRet = NO_ERROR;
+    size_t confidenceJpegSize = 0;
+    nsecs_t confidenceEncodeTime = 0;
+    std::thread confidenceThread([&]() {
+        nsecs_t confidenceStartTime = systemTime();
+        confidenceRet = encodeGrayscaleJpeg(width, height, confidenceQuantized.data(),
+                depthParams.confidence_data.data(), inputFrame.mMaxJpegSize,
+                inputFrame.mJpegQuality, exifOrientation, confidenceJpegSize);
+        confidenceEncodeTime = systemTime() - confidenceStartTime;
+    });
+
     size_t actualJpegSize;
     auto ret = encodeGrayscaleJpeg(width, height, pointsQuantized.data(),
             depthParams.depth_image_data.data(), inputFrame.mMaxJpegSize,
             inputFrame.mJpegQuality, exifOrientation, actualJpegSize);
+    nsecs_t depthEncodeTime = systemTime() - conversionTime;
+    confidenceThread.join();
+
+    ALOGV("%s: %zux%zu depth map conversion %" PRId64 " us, depth encode %" PRId64
+            " us, confidence encode %" PRId64 " us", __FUNCTION__, width, height,
+            ns2us(conversionTime - startTime), ns2us(depthEncodeTime),
+            ns2us(confidenceEncodeTime));
+
     if (ret != NO_ERROR) {
         ALOGE("%s: Depth map compression failed!", __FUNCTION__);
         return nullptr;
     }
     depthParams.depth_image_data.resize(actualJpegSize);
 
-    ret = encodeGrayscaleJpeg(width, height, confidenceQuantized.data(),
-            depthParams.confidence_data.data(), inputFrame.mMaxJpegSize,
-            inputFrame.mJpegQuality, exifOrientation, actualJpegSize);
-    if (ret != NO_ERROR) {
+    if (confidenceRet != NO_ERROR) {
         ALOGE("%s: Confidence map compression failed!", __FUNCTION__);
         return nullptr;
     }
-    depthParams.confidence_data.resize(actualJpegSize);
+    depthParams.confidence_data.resize(confidenceJpegSize);
 
     return DepthMap::FromData(depthParams, items);
 }
@@ -430,16 +472,23 @@ int processDepthPhotoFrame(DepthPhotoInputFrame inputFrame, size_t depthPhotoBuf
         return BAD_VALUE;
     }
 
+    nsecs_t startTime = systemTime();
     ExifOrientation exifOrientation = getExifOrientation(
             reinterpret_cast<const unsigned char*> (inputFrame.mMainJpegBuffer),
             inputFrame.mMainJpegSize);
-    bool switchDimensions;
-    cameraParams->depth_map = processDepthMapFrame(inputFrame, exifOrientation, &items,
-            &switchDimensions);
-    if (cameraParams->depth_map == nullptr) {
-        ALOGE("%s: Depth map processing failed!", __FUNCTION__);
-        return BAD_VALUE;
+    // Physical rotation of depth and confidence maps may be needed in case
+    // the EXIF orientation is set to 0 degrees and the depth photo orientation
+    // (source color image) has some different value.
+    DepthPhotoOrientation depthOrientation = DepthPhotoOrientation::DEPTH_ORIENTATION_0_DEGREES;
+    if (exifOrientation == ExifOrientation::ORIENTATION_0_DEGREES) {
+        depthOrientation = inputFrame.mOrientation;
     }
+    bool switchDimensions = switchesDimensions(depthOrientation);
+
+    // The depth and confidence maps are processed while the main image parameters
+    // are set up. 'items' must not be accessed until the depth map is ready.
+    std::future<std::unique_ptr<DepthMap>> depthMap = std::async(std::launch::async,
+            processDepthMapFrame, inputFrame, exifOrientation, depthOrientation, &items);
 
     // It is not possible to generate an imaging model without intrinsic calibration.
     if (inputFrame.mIsIntrinsicCalibrationValid) {
@@ -482,6 +531,13 @@ int processDepthPhotoFrame(DepthPhotoInputFrame inputFrame, size_t depthPhotoBuf
         cameraParams->trait = dynamic_depth::CameraTrait::PHYSICAL;
     }
 
+    cameraParams->depth_map = depthMap.get();
+    if (cameraParams->depth_map == nullptr) {
+        ALOGE("%s: Depth map processing failed!", __FUNCTION__);
+        return BAD_VALUE;
+    }
+    nsecs_t depthMapTime = systemTime();
+
     cameraList.emplace_back(Camera::FromData(std::move(cameraParams)));
 
     auto deviceParams = std::make_unique<DeviceParams> (Cameras::FromCameraArray(&cameraList));
@@ -511,6 +567,9 @@ int processDepthPhotoFrame(DepthPhotoInputFrame inputFrame, size_t depthPhotoBuf
     }
 
     memcpy(depthPhotoBuffer, outputJpegStream.str().c_str(), *depthPhotoActualSize);
+    ALOGV("%s: Depth photo of %zu bytes, depth map ready after %" PRId64 " us, container write %"
+            PRId64 " us", __FUNCTION__, *depthPhotoActualSize, ns2us(depthMapTime - startTime),
+            ns2us(systemTime() - depthMapTime));
 
     return 0;
 }
@@ -786,6 +786,13 @@ AidlProviderInfo::AidlDeviceInfo3::startDeviceInterface() {
 }
 
 status_t AidlProviderInfo::AidlDeviceInfo3::dumpState(int fd) {
+    {
+        std::lock_guard<std::mutex> l(mSessionConfigQueryLock);
+        dprintf(fd, "  Stream combination queries: %zu cached, %zu hits, %zu misses\n",
+                mSessionConfigQueries.size(), mSessionConfigQueryHits,
+                mSessionConfigQueryMisses);
+    }
+
     const std::shared_ptr<camera::device::ICameraDevice> interface = startDeviceInterface();
     if (interface == nullptr) {
         return DEAD_OBJECT;
@@ -826,6 +833,18 @@ status_t AidlProviderInfo::AidlDeviceInfo3::isSessionConfigurationSupported(
         return OK;
     }
 
+    // The answer for a stream combination can change with the device state,
+    // e.g. when a foldable is folded.
+    int64_t deviceState = 0;
+    sp<ProviderInfo> parentProvider = mParentProvider.promote();
+    if (parentProvider != nullptr) {
+        deviceState = parentProvider->getDeviceState();
+    }
+    if (getCachedSessionConfigQuery(streamConfiguration, checkSessionParams, deviceState,
+            status)) {
+        return OK;
+    }
+
     const std::shared_ptr<camera::device::ICameraDevice> interface =
             startDeviceInterface();
 
@@ -857,10 +876,42 @@ status_t AidlProviderInfo::AidlDeviceInfo3::isSessionConfigurationSupported(
         ALOGE("%s: Unexpected binder error: %s", __FUNCTION__, ret.getMessage());
         return mapToStatusT(ret);
     }
+    cacheSessionConfigQuery(streamConfiguration, checkSessionParams, deviceState, *status);
     return OK;
 
 }
 
+bool AidlProviderInfo::AidlDeviceInfo3::getCachedSessionConfigQuery(
+        const camera::device::StreamConfiguration& streamConfiguration,
+        bool checkSessionParams, int64_t deviceState, bool *isSupported /*out*/) {
+    std::lock_guard<std::mutex> l(mSessionConfigQueryLock);
+    for (auto it = mSessionConfigQueries.begin(); it != mSessionConfigQueries.end(); it++) {
+        if (it->checkSessionParams == checkSessionParams && it->deviceState == deviceState &&
+                it->streamConfiguration == streamConfiguration) {
+            *isSupported = it->isSupported;
+            mSessionConfigQueries.splice(mSessionConfigQueries.begin(), mSessionConfigQueries,
+                    it);
+            mSessionConfigQueryHits++;
+            ALOGV("%s: Camera %s: cached stream combination query, supported: %d",
+                    __FUNCTION__, mId.c_str(), *isSupported);
+            return true;
+        }
+    }
+    mSessionConfigQueryMisses++;
+    return false;
+}
+
+void AidlProviderInfo::AidlDeviceInfo3::cacheSessionConfigQuery(
+        const camera::device::StreamConfiguration& streamConfiguration,
+        bool checkSessionParams, int64_t deviceState, bool isSupported) {
+    std::lock_guard<std::mutex> l(mSessionConfigQueryLock);
+    mSessionConfigQueries.push_front(
+            {streamConfiguration, checkSessionParams, deviceState, isSupported});
+    if (mSessionConfigQueries.size() > kMaxSessionConfigQueries) {
+        mSessionConfigQueries.pop_back();
+    }
+}
+
 status_t AidlProviderInfo::AidlDeviceInfo3::createDefaultRequest(
         camera3::camera_request_template_t templateId, CameraMetadata* metadata) {
     const std::shared_ptr<camera::device::ICameraDevice> interface =
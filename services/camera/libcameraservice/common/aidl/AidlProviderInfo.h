@@ -17,6 +17,9 @@
 #ifndef ANDROID_SERVERS_CAMERA_CAMERAPROVIDER_AIDLPROVIDERINFOH
 #define ANDROID_SERVERS_CAMERA_CAMERAPROVIDER_AIDLPROVIDERINFOH
 
+#include <list>
+#include <mutex>
+
 #include "common/CameraProviderManager.h"
 
 #include <aidl/android/hardware/camera/common/Status.h>
@@ -142,6 +145,33 @@ struct AidlProviderInfo : public CameraProviderManager::ProviderInfo {
         std::shared_ptr<aidl::android::hardware::camera::device::ICameraDevice>
                 startDeviceInterface();
         std::vector<int32_t> mAdditionalKeysForFeatureQuery;
+
+      private:
+        // A stream combination query answered by the HAL. Apps probe many
+        // combinations when they start, mostly the same ones every time.
+        struct SessionConfigQuery {
+            aidl::android::hardware::camera::device::StreamConfiguration streamConfiguration;
+            bool checkSessionParams;
+            int64_t deviceState;
+            bool isSupported;
+        };
+
+        bool getCachedSessionConfigQuery(
+                const aidl::android::hardware::camera::device::StreamConfiguration&
+                        streamConfiguration,
+                bool checkSessionParams, int64_t deviceState, bool *isSupported /*out*/);
+        void cacheSessionConfigQuery(
+                const aidl::android::hardware::camera::device::StreamConfiguration&
+                        streamConfiguration,
+                bool checkSessionParams, int64_t deviceState, bool isSupported);
+
+        static const size_t kMaxSessionConfigQueries = 32;
+
+        std::mutex mSessionConfigQueryLock;
+        // Most recently used first
+        std::list<SessionConfigQuery> mSessionConfigQueries;
+        size_t mSessionConfigQueryHits = 0;
+        size_t mSessionConfigQueryMisses = 0;
     };
 
  private:
@@ -19,6 +19,7 @@
 #define ATRACE_TAG ATRACE_TAG_CAMERA
 
 #include <sstream>
+#include <unistd.h>
 
 #include <gui/ISurfaceComposer.h>
 #include <private/gui/ComposerService.h>
@@ -245,6 +246,85 @@ status_t Camera3BufferManager::checkAndFreeBufferOnOtherStreamsLocked(
     return OK;
 }
 
+bool Camera3BufferManager::takeCompatibleBufferLocked(int streamId, const StreamInfo& info,
+        GraphicBufferEntry* buffer) {
+    for (size_t i = 0; i < mStreamSetMap.size(); i++) {
+        const StreamSet& otherSet = mStreamSetMap[i];
+        for (size_t j = 0; j < otherSet.streamInfoMap.size(); j++) {
+            const StreamInfo& otherInfo = otherSet.streamInfoMap[j];
+            // The stream getting the buffer is locked by the caller, so it can't be detached
+            // from.
+            if (otherInfo.streamId == streamId || otherInfo.width != info.width ||
+                    otherInfo.height != info.height || otherInfo.format != info.format ||
+                    otherInfo.dataSpace != info.dataSpace ||
+                    otherInfo.combinedUsage != info.combinedUsage) {
+                continue;
+            }
+            // Leave the other stream one spare buffer, so that two streams taking turns
+            // don't keep moving the same buffer back and forth.
+            size_t otherBufferCount = otherSet.handoutBufferCountMap.valueFor(otherInfo.streamId);
+            size_t otherAttachedBufferCount =
+                    otherSet.attachedBufferCountMap.valueFor(otherInfo.streamId);
+            if (otherAttachedBufferCount <= otherBufferCount + 1) {
+                continue;
+            }
+            sp<Camera3OutputStream> stream = mStreamMap.valueFor(otherInfo.streamId).promote();
+            if (stream == nullptr) {
+                continue;
+            }
+
+            int otherStreamId = otherInfo.streamId;
+            StreamSetKey otherSetKey = mStreamSetMap.keyAt(i);
+            ALOGV("Stream %d: Taking buffer from stream %d: detach", streamId, otherStreamId);
+
+            // Need to unlock because the other stream may also be calling into the buffer
+            // manager in parallel, the same as in checkAndFreeBufferOnOtherStreamsLocked.
+            mLock.unlock();
+            sp<GraphicBuffer> graphicBuffer;
+            int detachedFenceFd = -1;
+            stream->detachBuffer(&graphicBuffer, &detachedFenceFd);
+            mLock.lock();
+            if (graphicBuffer == nullptr) {
+                return false;
+            }
+
+            if (checkIfStreamRegisteredLocked(otherStreamId, otherSetKey)) {
+                size_t& attachedBufferCount = mStreamSetMap.editValueFor(otherSetKey).
+                        attachedBufferCountMap.editValueFor(otherStreamId);
+                attachedBufferCount--;
+            }
+            // The other stream may have been reconfigured meanwhile.
+            if (graphicBuffer->getWidth() != info.width ||
+                    graphicBuffer->getHeight() != info.height ||
+                    static_cast<uint32_t>(graphicBuffer->getPixelFormat()) != info.format ||
+                    graphicBuffer->getUsage() != info.combinedUsage) {
+                if (detachedFenceFd >= 0) {
+                    close(detachedFenceFd);
+                }
+                return false;
+            }
+            buffer->graphicBuffer = graphicBuffer;
+            buffer->fenceFd = detachedFenceFd;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t Camera3BufferManager::countIdleBuffersLocked() const {
+    size_t idleBufferCount = 0;
+    for (size_t i = 0; i < mStreamSetMap.size(); i++) {
+        const StreamSet& streamSet = mStreamSetMap[i];
+        for (size_t j = 0; j < streamSet.attachedBufferCountMap.size(); j++) {
+            size_t handOutBufferCount = streamSet.handoutBufferCountMap[j];
+            if (streamSet.attachedBufferCountMap[j] > handOutBufferCount) {
+                idleBufferCount += streamSet.attachedBufferCountMap[j] - handOutBufferCount;
+            }
+        }
+    }
+    return idleBufferCount;
+}
+
 status_t Camera3BufferManager::getBufferForStream(int streamId, int streamSetId,
         bool isMultiRes, sp<GraphicBuffer>* gb, int* fenceFd, bool noFreeBufferAtConsumer) {
     ATRACE_CALL();
@@ -286,8 +366,36 @@ status_t Camera3BufferManager::getBufferForStream(int streamId, int streamSetId,
             streamId, streamSetId, isMultiRes);
 
     if (mGrallocVersion < HARDWARE_DEVICE_API_VERSION(1,0)) {
-        const StreamInfo& info = streamSet.streamInfoMap.valueFor(streamId);
+        // Copy, as mLock may be released while looking for a buffer on other streams.
+        const StreamInfo info = streamSet.streamInfoMap.valueFor(streamId);
         GraphicBufferEntry buffer;
+        if (takeCompatibleBufferLocked(streamId, info, &buffer)) {
+            if (!checkIfStreamRegisteredLocked(streamId, streamSetKey)) {
+                ALOGE("%s: stream %d was unregistered while getting a buffer",
+                        __FUNCTION__, streamId);
+                if (buffer.fenceFd >= 0) {
+                    close(buffer.fenceFd);
+                }
+                return BAD_VALUE;
+            }
+            mReusedBufferCount++;
+            ALOGV("%s: reusing graphic buffer (%dx%d, format 0x%x) %p from another stream",
+                    __FUNCTION__, info.width, info.height, info.format,
+                    buffer.graphicBuffer.get());
+
+            // No buffer was added, so there is no need to free one from the other streams.
+            StreamSet &currentSet = mStreamSetMap.editValueFor(streamSetKey);
+            size_t& currentBufferCount = currentSet.handoutBufferCountMap.editValueFor(streamId);
+            currentBufferCount++;
+            currentSet.attachedBufferCountMap.editValueFor(streamId)++;
+            if (currentBufferCount + 1 > currentSet.allocatedBufferWaterMark) {
+                currentSet.allocatedBufferWaterMark = currentBufferCount + 1;
+            }
+            *gb = buffer.graphicBuffer;
+            *fenceFd = buffer.fenceFd;
+            return OK;
+        }
+
         buffer.fenceFd = -1;
         buffer.graphicBuffer = new GraphicBuffer(
                 info.width, info.height, PixelFormat(info.format), info.combinedUsage,
@@ -304,6 +412,7 @@ status_t Camera3BufferManager::getBufferForStream(int streamId, int streamSetId,
             return res;
         }
         ALOGV("%s: allocation done", __FUNCTION__);
+        mAllocatedBufferCount++;
 
         // Increase the hand-out and attached buffer counts for tracking purposes.
         bufferCount++;
@@ -400,6 +509,11 @@ status_t Camera3BufferManager::onBufferReleased(
                 attachedBufferCount > bufferCount + BUFFER_FREE_THRESHOLD) {
             ALOGV("%s: free a buffer from stream %d", __FUNCTION__, streamId);
             *shouldFreeBuffer = true;
+        } else if (attachedBufferCount > bufferCount + 1 &&
+                countIdleBuffersLocked() > static_cast<size_t>(MAX_IDLE_BUFFER_COUNT)) {
+            ALOGV("%s: free a buffer from stream %d, too many idle buffers", __FUNCTION__,
+                    streamId);
+            *shouldFreeBuffer = true;
         }
     } else {
         // TODO: implement gralloc V1 support
@@ -485,6 +599,9 @@ void Camera3BufferManager::dump(int fd, [[maybe_unused]] const Vector<String16>&
                     streamId, bufferCount);
         }
     }
+    lines << fmt::sprintf("      Buffers allocated: %zu, taken from other streams: %zu,"
+            " idle now: %zu\n", mAllocatedBufferCount, mReusedBufferCount,
+            countIdleBuffersLocked());
     std::string linesStr = std::move(lines.str());
     write(fd, linesStr.c_str(), linesStr.size());
 }
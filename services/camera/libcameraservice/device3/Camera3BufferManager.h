@@ -198,6 +198,13 @@ private:
     // (BUFFER_FREE_THRESHOLD + steady state handout buffer count) buffers.
     static const int BUFFER_FREE_THRESHOLD = 3;
 
+    // onBufferReleased will also set shouldFreeBuffer when:
+    //   numIdleBuffersAllStreamSets > MAX_IDLE_BUFFER_COUNT AND
+    //   numAllocatedBuffersThisStream > numHandoutBuffersThisStream + 1
+    // where idle buffers are the ones allocated but not handed out. This caps the memory kept by
+    // the streams that are not (or no longer) streaming, across all stream sets.
+    static const int MAX_IDLE_BUFFER_COUNT = 2 * BUFFER_FREE_THRESHOLD;
+
     /**
      * Lock to synchronize the access to the methods of this class.
      */
@@ -324,6 +331,24 @@ private:
      * free one if so.
      */
     status_t checkAndFreeBufferOnOtherStreamsLocked(int streamId, StreamSetKey streamSetKey);
+
+    /**
+     * Take a spare buffer from another stream, in any stream set, whose buffers are the same
+     * size, format and usage as the ones of the given stream, so that it can be handed out
+     * instead of allocating a new one. Returns false if no stream has more than one spare
+     * buffer. mLock is released while the buffer is detached from the other stream.
+     */
+    bool takeCompatibleBufferLocked(int streamId, const StreamInfo& info,
+            GraphicBufferEntry* buffer);
+
+    /**
+     * Number of buffers allocated and not handed out, for all the stream sets.
+     */
+    size_t countIdleBuffersLocked() const;
+
+    // Buffers allocated, and taken from other streams instead, since creation
+    size_t mAllocatedBufferCount = 0;
+    size_t mReusedBufferCount = 0;
 };
 
 } // namespace camera3
@@ -73,6 +73,7 @@
 
 #include <algorithm>
 #include <optional>
+#include <thread>
 #include <tuple>
 
 using namespace android::camera3;
@@ -588,11 +589,12 @@ status_t Camera3Device::dump(int fd, [[maybe_unused]] const Vector<String16> &ar
 
     lines = "    In-flight requests:\n";
     if (mInFlightLock.try_lock()) {
+        lines += fmt::sprintf("      Lock: %s\n", mInFlightLock.getStatsLocked().c_str());
         if (mInFlightMap.size() == 0) {
             lines += "      None\n";
         } else {
             for (size_t i = 0; i < mInFlightMap.size(); i++) {
-                InFlightRequest r = mInFlightMap.valueAt(i);
+                const InFlightRequest& r = mInFlightMap.valueAt(i);
                 lines += fmt::sprintf("      Frame %d |  Timestamp: %" PRId64 ", metadata"
                         " arrived: %s, buffers left: %d\n", mInFlightMap.keyAt(i),
                         r.shutterTimestamp, r.haveResultMetadata ? "true" : "false",
@@ -608,6 +610,12 @@ status_t Camera3Device::dump(int fd, [[maybe_unused]] const Vector<String16> &ar
     if (mRequestThread != NULL) {
         mRequestThread->dumpCaptureRequestLatency(fd,
                 "    ProcessCaptureRequest latency histogram:");
+        mRequestThread->dumpSettingsStats(fd);
+    }
+    mResultMapperStats.dump(fd);
+    mSessionStatsBuilder.dump(fd);
+    if (mPreparerThread != nullptr) {
+        mPreparerThread->dump(fd);
     }
 
     {
@@ -2829,7 +2837,7 @@ status_t Camera3Device::registerInFlight(uint32_t frameNumber,
         const std::set<std::string>& cameraIdsWithZoom,
         const SurfaceMap& outputSurfaces, nsecs_t requestTimeNs) {
     ATRACE_CALL();
-    std::lock_guard<std::mutex> l(mInFlightLock);
+    std::lock_guard<InFlightLock> l(mInFlightLock);
 
     ssize_t res;
     res = mInFlightMap.add(frameNumber, InFlightRequest(numBuffers, resultExtras, hasInput,
@@ -2869,15 +2877,16 @@ void Camera3Device::checkInflightMapLengthLocked() {
     // Validation check - if we have too many in-flight frames with long total inflight duration,
     // something has likely gone wrong. This might still be legit only if application send in
     // a long burst of long exposure requests.
-    if (mExpectedInflightDuration > kMinWarnInflightDuration) {
+    nsecs_t expectedInflightDuration = mExpectedInflightDuration;
+    if (expectedInflightDuration > kMinWarnInflightDuration) {
         if (!mIsConstrainedHighSpeedConfiguration && mInFlightMap.size() > kInFlightWarnLimit) {
             CLOGW("In-flight list too large: %zu, total inflight duration %" PRIu64,
-                    mInFlightMap.size(), mExpectedInflightDuration);
+                    mInFlightMap.size(), expectedInflightDuration);
         } else if (mIsConstrainedHighSpeedConfiguration && mInFlightMap.size() >
                 kInFlightWarnLimitHighSpeed) {
             CLOGW("In-flight list too large for high speed configuration: %zu,"
                     "total inflight duration %" PRIu64,
-                    mInFlightMap.size(), mExpectedInflightDuration);
+                    mInFlightMap.size(), expectedInflightDuration);
         }
     }
 }
@@ -3521,6 +3530,76 @@ void Camera3Device::RequestThread::updateNextRequest(NextRequest& nextRequest) {
     cleanupPhysicalSettings(nextRequest.captureRequest, &halRequest);
 }
 
+// Whether two metadata buffers hold the same entries in the same order, which
+// is the case for equal settings once sorted.
+static bool isSameSortedMetadata(const camera_metadata_t* a, const camera_metadata_t* b) {
+    if (a == nullptr || b == nullptr) {
+        return a == b;
+    }
+    size_t entryCount = get_camera_metadata_entry_count(a);
+    if (entryCount != get_camera_metadata_entry_count(b)) {
+        return false;
+    }
+    for (size_t i = 0; i < entryCount; i++) {
+        camera_metadata_ro_entry_t entryA, entryB;
+        if (get_camera_metadata_ro_entry(a, i, &entryA) != OK ||
+                get_camera_metadata_ro_entry(b, i, &entryB) != OK) {
+            return false;
+        }
+        if (entryA.tag != entryB.tag || entryA.type != entryB.type ||
+                entryA.count != entryB.count ||
+                memcmp(entryA.data.u8, entryB.data.u8,
+                        entryA.count * camera_metadata_type_size[entryA.type]) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Camera3Device::RequestThread::isSameAsLatestRequest(const sp<CaptureRequest>& request) {
+    Mutex::Autolock al(mLatestRequestMutex);
+
+    if (request->mSettingsList.size() != mLatestPhysicalRequest.size() + 1) {
+        return false;
+    }
+
+    for (auto it = request->mSettingsList.begin(); it != request->mSettingsList.end(); it++) {
+        const CameraMetadata* latest = &mLatestRequest;
+        if (it != request->mSettingsList.begin()) {
+            auto physical = mLatestPhysicalRequest.find(it->cameraId);
+            if (physical == mLatestPhysicalRequest.end()) {
+                return false;
+            }
+            latest = &physical->second;
+        }
+
+        const camera_metadata_t* settings = it->metadata.getAndLock();
+        const camera_metadata_t* latestSettings = latest->getAndLock();
+        bool same = isSameSortedMetadata(settings, latestSettings);
+        latest->unlock(latestSettings);
+        it->metadata.unlock(settings);
+        if (!same) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Camera3Device::RequestThread::dumpSettingsStats(int fd) const {
+    if (mSettingsStats.numRequests == 0) {
+        return;
+    }
+
+    std::string lines = fmt::sprintf("    Request settings: %" PRId64 " requests, "
+            "%" PRId64 " with settings (%" PRId64 " bytes avg), "
+            "%" PRId64 " reusing the settings of a different previous request\n",
+            mSettingsStats.numRequests, mSettingsStats.numSettingsSent,
+            mSettingsStats.numSettingsSent > 0 ?
+                    mSettingsStats.bytesSent / mSettingsStats.numSettingsSent : 0,
+            mSettingsStats.numSettingsDeduplicated);
+    write(fd, lines.c_str(), lines.size());
+}
+
 bool Camera3Device::RequestThread::updateSessionParameters(const CameraMetadata& settings) {
     ATRACE_CALL();
     bool updatesDetected = false;
@@ -3773,17 +3852,21 @@ status_t Camera3Device::RequestThread::prepareHalRequests() {
 
         bool settingsOverrideChanged = overrideSettingsOverride(captureRequest);
 
+        // Whether anything but the request itself changed the settings
+        bool settingsForced = triggersMixedIn ||
+                captureRequest->mRotateAndCropChanged ||
+                captureRequest->mAutoframingChanged ||
+                captureRequest->mTestPatternChanged || settingsOverrideChanged ||
+                (flags::inject_session_params() && mForceNewRequestAfterReconfigure);
+
         // If the request is the same as last, or we had triggers now or last time or
         // changing overrides this time
         bool newRequest =
-                (mPrevRequest != captureRequest || triggersMixedIn ||
-                         captureRequest->mRotateAndCropChanged ||
-                         captureRequest->mAutoframingChanged ||
-                         captureRequest->mTestPatternChanged || settingsOverrideChanged ||
-                         (flags::inject_session_params() && mForceNewRequestAfterReconfigure)) &&
+                (mPrevRequest != captureRequest || settingsForced) &&
                 // Request settings are all the same within one batch, so only treat the first
                 // request in a batch as new
                 !(batchedRequest && i > 0);
+        bool settingsDeduplicated = false;
 
         if (newRequest) {
             std::set<std::string> cameraIdsWithZoom;
@@ -3930,10 +4013,26 @@ status_t Camera3Device::RequestThread::prepareHalRequests() {
              * The request should be presorted so accesses in HAL
              *   are O(logn). Sidenote, sorting a sorted metadata is nop.
              */
-            captureRequest->mSettingsList.begin()->metadata.sort();
-            halRequest->settings = captureRequest->mSettingsList.begin()->metadata.getAndLock();
+            for (auto& settings : captureRequest->mSettingsList) {
+                settings.metadata.sort();
+            }
+
+            // A different request, e.g. a repeating request set again, often ends
+            // up with the same settings as the last ones sent. The HAL can reuse
+            // those as well, which saves it from parsing them again and the
+            // transfer when they go through the FMQ or binder.
+            if (mPrevRequest != nullptr && !settingsForced &&
+                    isSameAsLatestRequest(captureRequest)) {
+                newRequest = false;
+                settingsDeduplicated = true;
+            }
+
             mPrevRequest = captureRequest;
             mPrevCameraIdsWithZoom = cameraIdsWithZoom;
+        }
+
+        if (newRequest) {
+            halRequest->settings = captureRequest->mSettingsList.begin()->metadata.getAndLock();
             ALOGVV("%s: Request settings are NEW", __FUNCTION__);
 
             IF_ALOGV() {
@@ -3952,8 +4051,8 @@ status_t Camera3Device::RequestThread::prepareHalRequests() {
             }
         } else {
             // leave request.settings NULL to indicate 'reuse latest given'
-            ALOGVV("%s: Request settings are REUSED",
-                   __FUNCTION__);
+            ALOGVV("%s: Request settings are %s",
+                   __FUNCTION__, settingsDeduplicated ? "UNCHANGED" : "REUSED");
         }
 
         if (captureRequest->mSettingsList.size() > 1) {
@@ -3976,6 +4075,18 @@ status_t Camera3Device::RequestThread::prepareHalRequests() {
             }
         }
 
+        mSettingsStats.numRequests++;
+        if (newRequest) {
+            mSettingsStats.numSettingsSent++;
+            mSettingsStats.bytesSent += get_camera_metadata_size(halRequest->settings);
+            for (size_t j = 0; j < halRequest->num_physcam_settings; j++) {
+                mSettingsStats.bytesSent +=
+                        get_camera_metadata_size(halRequest->physcam_settings[j]);
+            }
+        } else if (settingsDeduplicated) {
+            mSettingsStats.numSettingsDeduplicated++;
+        }
+
         uint32_t totalNumBuffers = 0;
 
         // Fill in buffers
@@ -4319,9 +4430,9 @@ status_t Camera3Device::RequestThread::setZoomOverride(int32_t zoomOverride) {
 
 nsecs_t Camera3Device::getExpectedInFlightDuration() {
     ATRACE_CALL();
-    std::lock_guard<std::mutex> l(mInFlightLock);
-    return mExpectedInflightDuration > kMinInflightDuration ?
-            mExpectedInflightDuration : kMinInflightDuration;
+    nsecs_t expectedInflightDuration = mExpectedInflightDuration;
+    return expectedInflightDuration > kMinInflightDuration ?
+            expectedInflightDuration : kMinInflightDuration;
 }
 
 void Camera3Device::RequestThread::cleanupPhysicalSettings(sp<CaptureRequest> request,
@@ -4443,7 +4554,7 @@ void Camera3Device::RequestThread::cleanUpFailedRequests(bool sendRequestError)
         {
           sp<Camera3Device> parent = mParent.promote();
           if (parent != NULL) {
-              std::lock_guard<std::mutex> l(parent->mInFlightLock);
+              std::lock_guard<InFlightLock> l(parent->mInFlightLock);
               ssize_t idx = parent->mInFlightMap.indexOfKey(captureRequest->mResultExtras.frameNumber);
               if (idx >= 0) {
                   ALOGV("%s: Remove inflight request from queue: frameNumber %" PRId64,
@@ -5118,19 +5229,41 @@ void  Camera3Device::RequestThread::wakeupLatestRequest(
 
 Camera3Device::PreparerThread::PreparerThread() :
         Thread(/*canCallJava*/false), mListener(nullptr),
-        mActive(false), mCancelNow(false), mCurrentMaxCount(0), mCurrentPrepareComplete(false) {
+        mActive(false), mCancelNow(false) {
 }
 
 Camera3Device::PreparerThread::~PreparerThread() {
     Thread::requestExitAndWait();
-    if (mCurrentStream != nullptr) {
-        mCurrentStream->cancelPrepare();
-        ATRACE_ASYNC_END("stream prepare", mCurrentStream->getId());
-        mCurrentStream.clear();
+    for (const auto& current : mCurrentStreams) {
+        current.stream->cancelPrepare();
+        ATRACE_ASYNC_END("stream prepare", current.stream->getId());
     }
+    mCurrentStreams.clear();
     clear();
 }
 
+bool Camera3Device::PreparerThread::isPreviewStream(
+        const sp<camera3::Camera3StreamInterface>& stream) {
+    camera_stream_t* halStream = stream->asHalStream();
+    if (halStream == nullptr) {
+        return false;
+    }
+    return halStream->use_case == ANDROID_SCALER_AVAILABLE_STREAM_USE_CASES_PREVIEW ||
+            (halStream->usage & (GraphicBuffer::USAGE_HW_COMPOSER |
+                    GraphicBuffer::USAGE_HW_TEXTURE)) != 0;
+}
+
+void Camera3Device::PreparerThread::queueStreamLocked(int maxCount,
+        const sp<camera3::Camera3StreamInterface>& stream) {
+    auto it = mPendingStreams.end();
+    if (isPreviewStream(stream)) {
+        it = std::find_if(mPendingStreams.begin(), mPendingStreams.end(),
+                [](const auto& pending) { return !isPreviewStream(std::get<1>(pending)); });
+    }
+    mPendingStreams.insert(it,
+            std::tuple<int, sp<camera3::Camera3StreamInterface>>(maxCount, stream));
+}
+
 status_t Camera3Device::PreparerThread::prepare(int maxCount, sp<Camera3StreamInterface>& stream) {
     ATRACE_CALL();
     status_t res;
@@ -5169,8 +5302,7 @@ status_t Camera3Device::PreparerThread::prepare(int maxCount, sp<Camera3StreamIn
     }
 
     // queue up the work
-    mPendingStreams.push_back(
-            std::tuple<int, sp<camera3::Camera3StreamInterface>>(maxCount, stream));
+    queueStreamLocked(maxCount, stream);
     ALOGV("%s: Stream %d queued for preparing", __FUNCTION__, stream->getId());
 
     return OK;
@@ -5183,9 +5315,8 @@ void Camera3Device::PreparerThread::pause() {
 
     std::list<std::tuple<int, sp<camera3::Camera3StreamInterface>>> pendingStreams;
     pendingStreams.insert(pendingStreams.begin(), mPendingStreams.begin(), mPendingStreams.end());
-    sp<camera3::Camera3StreamInterface> currentStream = mCurrentStream;
-    int currentMaxCount = mCurrentMaxCount;
     mPendingStreams.clear();
+    mCancelledStreams.clear();
     mCancelNow = true;
     while (mActive) {
         auto res = mThreadActiveSignal.waitRelative(mLock, kActiveTimeout);
@@ -5198,14 +5329,12 @@ void Camera3Device::PreparerThread::pause() {
         }
     }
 
-    //Check whether the prepare thread was able to complete the current
-    //stream. In case work is still pending emplace it along with the rest
-    //of the streams in the pending list.
-    if (currentStream != nullptr) {
-        if (!mCurrentPrepareComplete) {
-            pendingStreams.push_back(std::tuple(currentMaxCount, currentStream));
-        }
-    }
+    //The streams the prepare thread was not able to complete were cancelled, in case
+    //work is still pending emplace them along with the rest of the streams in the
+    //pending list.
+    pendingStreams.insert(pendingStreams.end(), mCancelledStreams.begin(),
+            mCancelledStreams.end());
+    mCancelledStreams.clear();
 
     mPendingStreams.insert(mPendingStreams.begin(), pendingStreams.begin(), pendingStreams.end());
     for (const auto& it : mPendingStreams) {
@@ -5279,61 +5408,119 @@ void Camera3Device::PreparerThread::setNotificationListener(wp<NotificationListe
     mListener = listener;
 }
 
+void Camera3Device::PreparerThread::dump(int fd) {
+    Mutex::Autolock l(mLock);
+
+    std::string lines = "    Latest stream preparations:\n";
+    for (const auto& record : mPrepareRecords) {
+        lines += fmt::sprintf("      Stream %d%s: %zu buffers in %.3f ms, result %d\n",
+                record.streamId, record.isPreview ? " (preview)" : "", record.bufferCount,
+                record.duration / 1e6, record.result);
+    }
+    for (const auto& current : mCurrentStreams) {
+        lines += fmt::sprintf("      Stream %d: in progress, %zu buffers in %.3f ms\n",
+                current.stream->getId(), current.bufferCount,
+                (systemTime() - current.startTime) / 1e6);
+    }
+    lines += fmt::sprintf("      Streams waiting: %zu\n", mPendingStreams.size());
+    write(fd, lines.c_str(), lines.size());
+}
+
 bool Camera3Device::PreparerThread::threadLoop() {
-    status_t res;
+    std::vector<sp<camera3::Camera3StreamInterface>> streams;
     {
         Mutex::Autolock l(mLock);
-        if (mCurrentStream == nullptr) {
-            // End thread if done with work
-            if (mPendingStreams.empty()) {
-                ALOGV("%s: Preparer stream out of work", __FUNCTION__);
-                // threadLoop _must not_ re-acquire mLock after it sets mActive to false; would
-                // cause deadlock with prepare()'s requestExitAndWait triggered by !mActive.
-                mActive = false;
-                mThreadActiveSignal.signal();
-                return false;
+        if (mCancelNow) {
+            for (const auto& current : mCurrentStreams) {
+                current.stream->cancelPrepare();
+                ATRACE_ASYNC_END("stream prepare", current.stream->getId());
+                ALOGV("%s: Cancelling stream %d prepare", __FUNCTION__,
+                        current.stream->getId());
+                mCancelledStreams.push_back(std::tuple(current.maxCount, current.stream));
             }
+            mCurrentStreams.clear();
+            mCancelNow = false;
+            return true;
+        }
 
-            // Get next stream to prepare
+        // Get next streams to prepare
+        while (mCurrentStreams.size() < kMaxParallelPrepares && !mPendingStreams.empty()) {
             auto it = mPendingStreams.begin();
-            mCurrentMaxCount = std::get<0>(*it);
-            mCurrentStream = std::get<1>(*it);
-            mCurrentPrepareComplete = false;
+            CurrentStream current = {std::get<0>(*it), std::get<1>(*it), systemTime(), 0};
             mPendingStreams.erase(it);
-            ATRACE_ASYNC_BEGIN("stream prepare", mCurrentStream->getId());
-            ALOGV("%s: Preparing stream %d", __FUNCTION__, mCurrentStream->getId());
-        } else if (mCancelNow) {
-            mCurrentStream->cancelPrepare();
-            ATRACE_ASYNC_END("stream prepare", mCurrentStream->getId());
-            ALOGV("%s: Cancelling stream %d prepare", __FUNCTION__, mCurrentStream->getId());
-            mCurrentStream.clear();
-            mCancelNow = false;
-            return true;
+            ATRACE_ASYNC_BEGIN("stream prepare", current.stream->getId());
+            ALOGV("%s: Preparing stream %d", __FUNCTION__, current.stream->getId());
+            mCurrentStreams.push_back(current);
+        }
+
+        // End thread if done with work
+        if (mCurrentStreams.empty()) {
+            ALOGV("%s: Preparer stream out of work", __FUNCTION__);
+            // threadLoop _must not_ re-acquire mLock after it sets mActive to false; would
+            // cause deadlock with prepare()'s requestExitAndWait triggered by !mActive.
+            mActive = false;
+            mThreadActiveSignal.signal();
+            return false;
+        }
+
+        for (const auto& current : mCurrentStreams) {
+            streams.push_back(current.stream);
         }
     }
 
-    res = mCurrentStream->prepareNextBuffer();
-    if (res == NOT_ENOUGH_DATA) return true;
-    if (res != OK) {
-        // Something bad happened; try to recover by cancelling prepare and
-        // signalling listener anyway
-        ALOGE("%s: Stream %d returned error %d (%s) during prepare", __FUNCTION__,
-                mCurrentStream->getId(), res, strerror(-res));
-        mCurrentStream->cancelPrepare();
+    // Allocate the next buffer of each stream in parallel, so that the allocations of a
+    // session with many streams don't add up. The streams don't share locks.
+    std::vector<status_t> results(streams.size());
+    std::vector<std::thread> helpers;
+    for (size_t i = 1; i < streams.size(); i++) {
+        helpers.emplace_back([&streams, &results, i]() {
+            results[i] = streams[i]->prepareNextBuffer();
+        });
+    }
+    results[0] = streams[0]->prepareNextBuffer();
+    for (auto& helper : helpers) {
+        helper.join();
     }
 
-    // This stream has finished, notify listener
     Mutex::Autolock l(mLock);
     sp<NotificationListener> listener = mListener.promote();
-    if (listener != NULL) {
-        ALOGV("%s: Stream %d prepare done, signaling listener", __FUNCTION__,
-                mCurrentStream->getId());
-        listener->notifyPrepared(mCurrentStream->getId());
-    }
+    for (size_t i = 0; i < streams.size(); i++) {
+        auto current = std::find_if(mCurrentStreams.begin(), mCurrentStreams.end(),
+                [&streams, i](const auto& c) { return c.stream == streams[i]; });
+        if (current == mCurrentStreams.end()) {
+            continue;
+        }
+        if (results[i] == OK || results[i] == NOT_ENOUGH_DATA) {
+            current->bufferCount++;
+        }
+        if (results[i] == NOT_ENOUGH_DATA) continue;
+        if (results[i] != OK) {
+            // Something bad happened; try to recover by cancelling prepare and
+            // signalling listener anyway
+            ALOGE("%s: Stream %d returned error %d (%s) during prepare", __FUNCTION__,
+                    streams[i]->getId(), results[i], strerror(-results[i]));
+            streams[i]->cancelPrepare();
+        }
 
-    ATRACE_ASYNC_END("stream prepare", mCurrentStream->getId());
-    mCurrentStream.clear();
-    mCurrentPrepareComplete = true;
+        // This stream has finished, notify listener
+        nsecs_t duration = systemTime() - current->startTime;
+        ALOGV("%s: Stream %d prepared %zu buffers in %" PRId64 " ns", __FUNCTION__,
+                streams[i]->getId(), current->bufferCount, duration);
+        if (mPrepareRecords.size() >= kMaxPrepareRecords) {
+            mPrepareRecords.pop_front();
+        }
+        mPrepareRecords.push_back({streams[i]->getId(), isPreviewStream(streams[i]),
+                current->bufferCount, duration, results[i]});
+
+        if (listener != NULL) {
+            ALOGV("%s: Stream %d prepare done, signaling listener", __FUNCTION__,
+                    streams[i]->getId());
+            listener->notifyPrepared(streams[i]->getId());
+        }
+
+        ATRACE_ASYNC_END("stream prepare", streams[i]->getId());
+        mCurrentStreams.erase(current);
+    }
 
     return true;
 }
@@ -17,10 +17,13 @@
 #ifndef ANDROID_SERVERS_CAMERA3DEVICE_H
 #define ANDROID_SERVERS_CAMERA3DEVICE_H
 
+#include <atomic>
+#include <deque>
 #include <utility>
 #include <unordered_map>
 #include <set>
 #include <tuple>
+#include <vector>
 
 #include <utils/Condition.h>
 #include <utils/Errors.h>
@@ -1011,6 +1014,9 @@ class Camera3Device :
             mRequestLatency.dump(fd, name);
         }
 
+        // dump how many request settings were sent to the HAL
+        void dumpSettingsStats(int fd) const;
+
         void signalPipelineDrain(const std::vector<int>& streamIds);
         void resetPipelineDrain();
 
@@ -1145,6 +1151,10 @@ class Camera3Device :
         // Update next request sent to HAL
         void updateNextRequest(NextRequest& nextRequest);
 
+        // Whether the settings of the request, sorted, are those of the latest
+        // request sent to HAL
+        bool isSameAsLatestRequest(const sp<CaptureRequest>& request);
+
         wp<Camera3Device>  mParent;
         wp<camera3::StatusTracker>  mStatusTracker;
         sp<HalInterface>   mInterface;
@@ -1219,6 +1229,16 @@ class Camera3Device :
         static const int32_t kRequestLatencyBinSize = 40; // in ms
         CameraLatencyHistogram mRequestLatency;
 
+        // Settings passed to the HAL. Requests without settings either repeat
+        // the previous request, or had the same settings as the last ones sent.
+        struct SettingsStats {
+            int64_t numRequests = 0;
+            int64_t numSettingsSent = 0;
+            int64_t numSettingsDeduplicated = 0;
+            int64_t bytesSent = 0;
+        };
+        SettingsStats      mSettingsStats;
+
         Vector<int32_t>    mSessionParamKeys;
         CameraMetadata     mLatestSessionParams;
         CameraMetadata     mInjectedSessionParams;
@@ -1248,9 +1268,11 @@ class Camera3Device :
     /**
      * In-flight queue for tracking completion of capture requests.
      */
-    std::mutex                    mInFlightLock;
+    camera3::InFlightLock         mInFlightLock;
     camera3::InFlightRequestMap   mInFlightMap;
-    nsecs_t                       mExpectedInflightDuration = 0;
+    // Only written with mInFlightLock held, read without it by
+    // getExpectedInFlightDuration()
+    std::atomic<nsecs_t>          mExpectedInflightDuration = 0;
     int64_t                       mLastCompletedRegularFrameNumber = -1;
     int64_t                       mLastCompletedReprocessFrameNumber = -1;
     int64_t                       mLastCompletedZslFrameNumber = -1;
@@ -1290,7 +1312,9 @@ class Camera3Device :
 
         /**
          * Queue up a stream to be prepared. Streams are processed by a background thread in FIFO
-         * order.  Pre-allocate up to maxCount buffers for the stream, or the maximum number needed
+         * order, except that preview streams go ahead of the others. Up to kMaxParallelPrepares
+         * streams are prepared at the same time, their buffers allocated in parallel.
+         * Pre-allocate up to maxCount buffers for the stream, or the maximum number needed
          * for the pipeline if maxCount is ALLOCATE_PIPELINE_MAX.
          */
         status_t prepare(int maxCount, sp<camera3::Camera3StreamInterface>& stream);
@@ -1310,12 +1334,41 @@ class Camera3Device :
          */
         status_t resume();
 
+        /**
+         * Dump the time the latest stream preparations took
+         */
+        void dump(int fd);
+
       private:
+        // Number of streams prepared at the same time
+        static const size_t kMaxParallelPrepares = 3;
+        // Number of finished preparations kept for dump
+        static const size_t kMaxPrepareRecords = 16;
+
+        struct CurrentStream {
+            int maxCount;
+            sp<camera3::Camera3StreamInterface> stream;
+            nsecs_t startTime;
+            size_t bufferCount;
+        };
+
+        struct PrepareRecord {
+            int streamId;
+            bool isPreview;
+            size_t bufferCount;
+            nsecs_t duration;
+            status_t result;
+        };
+
         Mutex mLock;
         Condition mThreadActiveSignal;
 
         virtual bool threadLoop();
 
+        // Queue the stream behind the other pending streams of the same priority
+        void queueStreamLocked(int maxCount, const sp<camera3::Camera3StreamInterface>& stream);
+        static bool isPreviewStream(const sp<camera3::Camera3StreamInterface>& stream);
+
         // Guarded by mLock
 
         wp<NotificationListener> mListener;
@@ -1323,11 +1376,12 @@ class Camera3Device :
         bool mActive;
         bool mCancelNow;
 
-        // Only accessed by threadLoop and the destructor
+        // Streams being prepared by threadLoop, and the ones it cancelled because of pause()
+        // or clear(), which pause() queues up again
+        std::vector<CurrentStream> mCurrentStreams;
+        std::vector<std::tuple<int, sp<camera3::Camera3StreamInterface>>> mCancelledStreams;
 
-        sp<camera3::Camera3StreamInterface> mCurrentStream;
-        int mCurrentMaxCount;
-        bool mCurrentPrepareComplete;
+        std::deque<PrepareRecord> mPrepareRecords;
     };
     sp<PreparerThread> mPreparerThread;
 
@@ -1401,6 +1455,9 @@ class Camera3Device :
     // - dumpsys -m 3a is a shortcut for ae/af/awbMode, State, and Triggers
     TagMonitor mTagMonitor;
 
+    // Time spent in the result metadata mappers, for dumpsys
+    camera3::ResultMapperStats mResultMapperStats;
+
     void monitorMetadata(TagMonitor::eventSource source, int64_t frameNumber,
             nsecs_t timestamp, const CameraMetadata& metadata,
             const std::unordered_map<std::string, CameraMetadata>& physicalMetadata,
@@ -177,10 +177,11 @@ class Camera3OfflineSession :
     camera3::BufferRecords mBufferRecords;
     SessionStatsBuilder mSessionStatsBuilder;
 
-    std::mutex mOfflineReqsLock;
+    camera3::InFlightLock mOfflineReqsLock;
     camera3::InFlightRequestMap mOfflineReqs;
 
     TagMonitor mTagMonitor;
+    camera3::ResultMapperStats mResultMapperStats;
     const metadata_vendor_id_t mVendorTagId;
 
     const bool mUseHalBufManager;
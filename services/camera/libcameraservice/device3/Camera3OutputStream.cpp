@@ -477,6 +477,9 @@ void Camera3OutputStream::dump(int fd, [[maybe_unused]] const Vector<String16> &
 
     mDequeueBufferLatency.dump(fd,
         "      DequeueBuffer latency histogram:");
+    if (mPreviewFrameSpacer != nullptr) {
+        mPreviewFrameSpacer->dump(fd);
+    }
 }
 
 status_t Camera3OutputStream::setTransform(int transform, bool mayChangeMirror) {
@@ -31,6 +31,7 @@
     ##__VA_ARGS__)
 
 #include <inttypes.h>
+#include <unistd.h>
 
 #include <utils/Log.h>
 #include <utils/SortedVector.h>
@@ -297,6 +298,96 @@ void sendPartialCaptureResult(CaptureOutputStates& states,
     }
 }
 
+void ResultMapperStats::add(nsecs_t durationNs, size_t physicalResultCount) {
+    numResults++;
+    numPhysicalResults += physicalResultCount;
+    totalDurationNs += durationNs;
+    if (durationNs > maxDurationNs) {
+        maxDurationNs = durationNs;
+    }
+}
+
+void ResultMapperStats::dump(int fd) const {
+    int64_t count = numResults;
+    if (count == 0) {
+        return;
+    }
+    std::string lines = fmt::sprintf("    Result metadata mapping: %" PRId64 " results "
+            "(%" PRId64 " physical), %.1f us avg, %.1f us max\n",
+            count, numPhysicalResults.load(), totalDurationNs / (count * 1000.0),
+            maxDurationNs / 1000.0);
+    write(fd, lines.c_str(), lines.size());
+}
+
+// Runs the result metadata of one camera through the mappers and fixups.
+status_t mapResultMetadataLocked(CaptureOutputStates& states, const std::string& cameraId,
+        const CameraMetadata& deviceInfo, bool isLogical, bool rotateAndCropAuto,
+        const std::set<std::string>& cameraIdsWithZoom, uint32_t frameNumber,
+        CameraMetadata* metadata) {
+    const char* resultType = isLogical ? "" : "physical ";
+
+    // Fix up some result metadata to account for HAL-level distortion correction
+    status_t res = OK;
+    auto distortionMapper = states.distortionMappers.find(cameraId);
+    if (distortionMapper != states.distortionMappers.end()) {
+        res = distortionMapper->second.correctCaptureResult(metadata);
+        if (res != OK) {
+            SET_ERR("Unable to correct camera %s's %scapture result metadata for frame %d: "
+                    "%s (%d)", cameraId.c_str(), resultType, frameNumber, strerror(-res), res);
+            return res;
+        }
+    }
+
+    // Fix up result metadata to account for zoom ratio availabilities between
+    // HAL and app.
+    bool zoomRatioIs1 = cameraIdsWithZoom.find(cameraId) == cameraIdsWithZoom.end();
+    res = states.zoomRatioMappers[cameraId].updateCaptureResult(metadata, zoomRatioIs1);
+    if (res != OK) {
+        SET_ERR("Failed to update camera %s's %scapture result zoom ratio metadata for "
+                "frame %d: %s (%d)", cameraId.c_str(), resultType, frameNumber,
+                strerror(-res), res);
+        return res;
+    }
+
+    // Fix up result metadata to account for rotateAndCrop in AUTO mode
+    if (isLogical && rotateAndCropAuto) {
+        auto mapper = states.rotateAndCropMappers.find(cameraId);
+        if (mapper != states.rotateAndCropMappers.end()) {
+            res = mapper->second.updateCaptureResult(metadata);
+            if (res != OK) {
+                SET_ERR("Unable to correct capture result rotate-and-crop for frame %d: %s (%d)",
+                        frameNumber, strerror(-res), res);
+                return res;
+            }
+        }
+    }
+
+    // Fix up manual flash strength control metadata
+    res = fixupManualFlashStrengthControlTags(*metadata);
+    if (res != OK) {
+        SET_ERR("Failed to set flash strength level defaults in %sresult metadata: %s (%d)",
+                resultType, strerror(-res), res);
+        return res;
+    }
+
+    // Fix up autoframing metadata
+    res = fixupAutoframingTags(*metadata);
+    if (res != OK) {
+        SET_ERR("Failed to set autoframing defaults in %sresult metadata: %s (%d)",
+                resultType, strerror(-res), res);
+        return res;
+    }
+
+    // Fix up result metadata for monochrome camera.
+    res = fixupMonochromeTags(states, deviceInfo, *metadata);
+    if (res != OK) {
+        SET_ERR("Failed to override %sresult metadata: %s (%d)", resultType,
+                strerror(-res), res);
+        return res;
+    }
+    return OK;
+}
+
 void sendCaptureResult(
         CaptureOutputStates& states,
         CameraMetadata &pendingMetadata,
@@ -350,6 +441,9 @@ void sendCaptureResult(
     }
 
     captureResult.mMetadata.sort();
+    // The mappers and fixups below look up dozens of tags, and each entry they
+    // add leaves the buffer unsorted for the lookups after it.
+    captureResult.mMetadata.buildTagIndex();
 
     // Check that there's a timestamp in the result metadata
     camera_metadata_entry timestamp = captureResult.mMetadata.find(ANDROID_SENSOR_TIMESTAMP);
@@ -361,6 +455,7 @@ void sendCaptureResult(
     nsecs_t sensorTimestamp = timestamp.data.i64[0];
 
     for (auto& physicalMetadata : captureResult.mPhysicalMetadatas) {
+        physicalMetadata.mPhysicalCameraMetadata.buildTagIndex();
         camera_metadata_entry timestamp =
                 physicalMetadata.mPhysicalCameraMetadata.find(ANDROID_SENSOR_TIMESTAMP);
         if (timestamp.count == 0) {
@@ -370,114 +465,27 @@ void sendCaptureResult(
         }
     }
 
-    // Fix up some result metadata to account for HAL-level distortion correction
-    status_t res = OK;
-    auto iter = states.distortionMappers.find(states.cameraId);
-    if (iter != states.distortionMappers.end()) {
-        res = iter->second.correctCaptureResult(&captureResult.mMetadata);
-        if (res != OK) {
-            SET_ERR("Unable to correct capture result metadata for frame %d: %s (%d)",
-                    frameNumber, strerror(-res), res);
-            return;
-        }
-    }
-
-    // Fix up result metadata to account for zoom ratio availabilities between
-    // HAL and app.
-    bool zoomRatioIs1 = cameraIdsWithZoom.find(states.cameraId) == cameraIdsWithZoom.end();
-    res = states.zoomRatioMappers[states.cameraId].updateCaptureResult(
-            &captureResult.mMetadata, zoomRatioIs1);
-    if (res != OK) {
-        SET_ERR("Failed to update capture result zoom ratio metadata for frame %d: %s (%d)",
-                frameNumber, strerror(-res), res);
-        return;
-    }
-
-    // Fix up result metadata to account for rotateAndCrop in AUTO mode
-    if (rotateAndCropAuto) {
-        auto mapper = states.rotateAndCropMappers.find(states.cameraId);
-        if (mapper != states.rotateAndCropMappers.end()) {
-            res = mapper->second.updateCaptureResult(
-                    &captureResult.mMetadata);
-            if (res != OK) {
-                SET_ERR("Unable to correct capture result rotate-and-crop for frame %d: %s (%d)",
-                        frameNumber, strerror(-res), res);
-                return;
-            }
-        }
-    }
-
-    // Fix up manual flash strength control metadata
-    res = fixupManualFlashStrengthControlTags(captureResult.mMetadata);
+    // Fix up the result metadata of the logical camera, then of each
+    // physical camera: each buffer goes through all the mappers and fixups in
+    // a single pass, while it's hot in cache.
+    nsecs_t mapStartNs = systemTime();
+    status_t res = mapResultMetadataLocked(states, states.cameraId, states.deviceInfo,
+            /*isLogical*/true, rotateAndCropAuto, cameraIdsWithZoom, frameNumber,
+            &captureResult.mMetadata);
     if (res != OK) {
-        SET_ERR("Failed to set flash strength level defaults in result metadata: %s (%d)",
-                strerror(-res), res);
-        return;
-    }
-    for (auto& physicalMetadata : captureResult.mPhysicalMetadatas) {
-        res = fixupManualFlashStrengthControlTags(physicalMetadata.mPhysicalCameraMetadata);
-        if (res != OK) {
-            SET_ERR("Failed to set flash strength level defaults in physical result"
-                    " metadata: %s (%d)", strerror(-res), res);
-            return;
-        }
-    }
-
-    // Fix up autoframing metadata
-    res = fixupAutoframingTags(captureResult.mMetadata);
-    if (res != OK) {
-        SET_ERR("Failed to set autoframing defaults in result metadata: %s (%d)",
-                strerror(-res), res);
-        return;
-    }
-    for (auto& physicalMetadata : captureResult.mPhysicalMetadatas) {
-        res = fixupAutoframingTags(physicalMetadata.mPhysicalCameraMetadata);
-        if (res != OK) {
-            SET_ERR("Failed to set autoframing defaults in physical result metadata: %s (%d)",
-                    strerror(-res), res);
-            return;
-        }
-    }
-
-    for (auto& physicalMetadata : captureResult.mPhysicalMetadatas) {
-        const std::string cameraId = physicalMetadata.mPhysicalCameraId;
-        auto mapper = states.distortionMappers.find(cameraId);
-        if (mapper != states.distortionMappers.end()) {
-            res = mapper->second.correctCaptureResult(
-                    &physicalMetadata.mPhysicalCameraMetadata);
-            if (res != OK) {
-                SET_ERR("Unable to correct physical capture result metadata for frame %d: %s (%d)",
-                        frameNumber, strerror(-res), res);
-                return;
-            }
-        }
-
-        zoomRatioIs1 = cameraIdsWithZoom.find(cameraId) == cameraIdsWithZoom.end();
-        res = states.zoomRatioMappers[cameraId].updateCaptureResult(
-                &physicalMetadata.mPhysicalCameraMetadata, zoomRatioIs1);
-        if (res != OK) {
-            SET_ERR("Failed to update camera %s's physical zoom ratio metadata for "
-                    "frame %d: %s(%d)", cameraId.c_str(), frameNumber, strerror(-res), res);
-            return;
-        }
-    }
-
-    // Fix up result metadata for monochrome camera.
-    res = fixupMonochromeTags(states, states.deviceInfo, captureResult.mMetadata);
-    if (res != OK) {
-        SET_ERR("Failed to override result metadata: %s (%d)", strerror(-res), res);
         return;
     }
     for (auto& physicalMetadata : captureResult.mPhysicalMetadatas) {
         const std::string &cameraId = physicalMetadata.mPhysicalCameraId;
-        res = fixupMonochromeTags(states,
-                states.physicalDeviceInfoMap.at(cameraId),
-                physicalMetadata.mPhysicalCameraMetadata);
+        res = mapResultMetadataLocked(states, cameraId, states.physicalDeviceInfoMap.at(cameraId),
+                /*isLogical*/false, rotateAndCropAuto, cameraIdsWithZoom, frameNumber,
+                &physicalMetadata.mPhysicalCameraMetadata);
         if (res != OK) {
-            SET_ERR("Failed to override result metadata: %s (%d)", strerror(-res), res);
             return;
         }
     }
+    states.resultMapperStats.add(systemTime() - mapStartNs,
+            captureResult.mPhysicalMetadatas.size());
 
     std::unordered_map<std::string, CameraMetadata> monitoredPhysicalMetadata;
     for (auto& m : physicalMetadatas) {
@@ -559,7 +567,9 @@ void removeInFlightRequestIfReadyLocked(CaptureOutputStates& states, int idx,
             states.lastCompletedRegularFrameNumber = frameNumber;
         }
 
-        sessionStatsBuilder.incResultCounter(request.skipResultMetadata);
+        int32_t resultLatencyMs = (request.resultTimeNs > 0 && request.requestTimeNs > 0) ?
+                ns2ms(request.resultTimeNs - request.requestTimeNs) : -1;
+        sessionStatsBuilder.incResultCounter(request.skipResultMetadata, resultLatencyMs);
 
         removeInFlightMapEntryLocked(states, idx);
         ALOGVV("%s: removed frame %d from InFlightMap", __FUNCTION__, frameNumber);
@@ -643,7 +653,7 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
     std::vector<BufferToReturn> returnableBuffers{};
     nsecs_t shutterTimestamp = 0;
     {
-        std::lock_guard<std::mutex> l(states.inflightLock);
+        std::lock_guard<InFlightLock> l(states.inflightLock);
         ssize_t idx = states.inflightMap.indexOfKey(frameNumber);
         if (idx == NAME_NOT_FOUND) {
             SET_ERR("Unknown frame number for capture result: %d",
@@ -771,6 +781,7 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
                     request.collectedPartialResult);
             }
             request.haveResultMetadata = true;
+            request.resultTimeNs = systemTime();
             request.errorBufStrategy = ERROR_BUF_RETURN_NOTIFY;
         }
 
@@ -802,6 +813,8 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
         // buffers.
         request.pendingOutputBuffers.appendArray(result->output_buffers,
                 result->num_output_buffers);
+        request.pendingOutputBufferTimesNs.resize(request.pendingOutputBuffers.size(),
+                systemTime());
         if (shutterTimestamp != 0) {
             collectAndRemovePendingOutputBuffers(
                 states.useHalBufManager, states.halBufManagedStreamIds,
@@ -874,7 +887,8 @@ void collectReturnableOutputBuffers(
         /*out*/ std::vector<BufferToReturn> *returnableBuffers,
         bool timestampIncreasing, const SurfaceMap& outputSurfaces,
         const CaptureResultExtras &resultExtras,
-        ERROR_BUF_STRATEGY errorBufStrategy, int32_t transform) {
+        ERROR_BUF_STRATEGY errorBufStrategy, int32_t transform,
+        const nsecs_t *halBufferTimesNs) {
     for (size_t i = 0; i < numBuffers; i++)
     {
         Camera3StreamInterface *stream = Camera3Stream::cast(outputBuffers[i].stream);
@@ -914,16 +928,17 @@ void collectReturnableOutputBuffers(
         // buffer strategy is CACHE.
         if (outputBuffers[i].status != CAMERA_BUFFER_STATUS_ERROR ||
                 errorBufStrategy != ERROR_BUF_CACHE) {
+            nsecs_t halBufferTimeNs = halBufferTimesNs != nullptr ? halBufferTimesNs[i] : 0;
             if (it != outputSurfaces.end()) {
                 returnableBuffers->emplace_back(stream,
                         outputBuffers[i], timestamp, readoutTimestamp, timestampIncreasing,
                         it->second, resultExtras,
-                        transform, requested ? requestTimeNs : 0);
+                        transform, requested ? requestTimeNs : 0, halBufferTimeNs);
             } else {
                 returnableBuffers->emplace_back(stream,
                         outputBuffers[i], timestamp, readoutTimestamp, timestampIncreasing,
                         std::vector<size_t> (), resultExtras,
-                        transform, requested ? requestTimeNs : 0 );
+                        transform, requested ? requestTimeNs : 0, halBufferTimeNs);
             }
         }
     }
@@ -955,7 +970,10 @@ void finishReturningOutputBuffers(const std::vector<BufferToReturn> &returnableB
         if (b.requestTimeNs > 0) {
             nsecs_t bufferTimeNs = systemTime();
             int32_t captureLatencyMs = ns2ms(bufferTimeNs - b.requestTimeNs);
-            sessionStatsBuilder.incCounter(streamId, dropped, captureLatencyMs);
+            int32_t halToConsumerLatencyMs = (!dropped && b.halBufferTimeNs > 0) ?
+                    ns2ms(bufferTimeNs - b.halBufferTimeNs) : -1;
+            sessionStatsBuilder.incCounter(streamId, dropped, captureLatencyMs,
+                    halToConsumerLatencyMs);
         }
 
         // Long processing consumers can cause returnBuffer timeout for shared stream
@@ -998,16 +1016,21 @@ void collectAndRemovePendingOutputBuffers(bool useHalBufManager,
             /*out*/ returnableBuffers,
             timestampIncreasing,
             request.outputSurfaces, request.resultExtras,
-            request.errorBufStrategy, request.transform);
+            request.errorBufStrategy, request.transform,
+            request.pendingOutputBufferTimesNs.data());
 
     // Remove error buffers that are not cached.
+    size_t i = 0;
     for (auto iter = request.pendingOutputBuffers.begin();
             iter != request.pendingOutputBuffers.end(); ) {
         if (request.errorBufStrategy != ERROR_BUF_CACHE ||
                 iter->status != CAMERA_BUFFER_STATUS_ERROR) {
             iter = request.pendingOutputBuffers.erase(iter);
+            request.pendingOutputBufferTimesNs.erase(
+                    request.pendingOutputBufferTimesNs.begin() + i);
         } else {
             iter++;
+            i++;
         }
     }
 }
@@ -1022,7 +1045,7 @@ void notifyShutter(CaptureOutputStates& states, const camera_shutter_msg_t &msg)
     // Set timestamp for the request in the in-flight tracking
     // and get the request ID to send upstream
     {
-        std::lock_guard<std::mutex> l(states.inflightLock);
+        std::lock_guard<InFlightLock> l(states.inflightLock);
         InFlightRequestMap& inflightMap = states.inflightMap;
         idx = inflightMap.indexOfKey(msg.frame_number);
         if (idx >= 0) {
@@ -1177,7 +1200,7 @@ void notifyError(CaptureOutputStates& states, const camera_error_msg_t &msg) {
         {
             std::vector<BufferToReturn> returnableBuffers{};
             {
-                std::lock_guard<std::mutex> l(states.inflightLock);
+                std::lock_guard<InFlightLock> l(states.inflightLock);
                 ssize_t idx = states.inflightMap.indexOfKey(msg.frame_number);
                 if (idx >= 0) {
                     InFlightRequest &r = states.inflightMap.editValueAt(idx);
@@ -1272,7 +1295,7 @@ void flushInflightRequests(FlushInflightReqStates& states) {
     ATRACE_CALL();
     std::vector<BufferToReturn> returnableBuffers{};
     { // First return buffers cached in inFlightMap
-        std::lock_guard<std::mutex> l(states.inflightLock);
+        std::lock_guard<InFlightLock> l(states.inflightLock);
         for (size_t idx = 0; idx < states.inflightMap.size(); idx++) {
             const InFlightRequest &request = states.inflightMap.valueAt(idx);
             collectReturnableOutputBuffers(
@@ -17,6 +17,7 @@
 #ifndef ANDROID_SERVERS_CAMERA3_OUTPUT_UTILS_H
 #define ANDROID_SERVERS_CAMERA3_OUTPUT_UTILS_H
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 
@@ -54,13 +55,15 @@ namespace camera3 {
         const CaptureResultExtras resultExtras;
         int32_t transform;
         nsecs_t requestTimeNs;
+        // When the HAL returned the buffer, 0 if unknown
+        nsecs_t halBufferTimeNs;
 
         BufferToReturn(Camera3StreamInterface *stream,
                 camera_stream_buffer_t buffer,
                 nsecs_t timestamp, nsecs_t readoutTimestamp,
                 bool timestampIncreasing, std::vector<size_t> surfaceIds,
                 const CaptureResultExtras &resultExtras,
-                int32_t transform, nsecs_t requestTimeNs):
+                int32_t transform, nsecs_t requestTimeNs, nsecs_t halBufferTimeNs = 0):
             stream(stream),
             buffer(buffer),
             timestamp(timestamp),
@@ -69,7 +72,8 @@ namespace camera3 {
             surfaceIds(surfaceIds),
             resultExtras(resultExtras),
             transform(transform),
-            requestTimeNs(requestTimeNs) {}
+            requestTimeNs(requestTimeNs),
+            halBufferTimeNs(halBufferTimeNs) {}
     };
 
     // helper function to return the output buffers to output
@@ -93,7 +97,9 @@ namespace camera3 {
             // Used to send buffer error callback when failing to return buffer
             const CaptureResultExtras &resultExtras = CaptureResultExtras{},
             ERROR_BUF_STRATEGY errorBufStrategy = ERROR_BUF_RETURN,
-            int32_t transform = -1);
+            int32_t transform = -1,
+            // When the HAL returned each of outputBuffers, for the latency stats
+            const nsecs_t *halBufferTimesNs = nullptr);
 
     // helper function to collect the output buffers ready to be
     // returned to output streams, and to remove these buffers from
@@ -116,9 +122,22 @@ namespace camera3 {
 
     // Camera3Device/Camera3OfflineSession internal states used in notify/processCaptureResult
     // callbacks
+    // Time spent running capture results through the metadata mappers and
+    // fixups, on the HAL callback thread. Written by processCaptureResult and
+    // read by dump without a lock.
+    struct ResultMapperStats {
+        std::atomic<int64_t> numResults = 0;
+        std::atomic<int64_t> numPhysicalResults = 0;
+        std::atomic<nsecs_t> totalDurationNs = 0;
+        std::atomic<nsecs_t> maxDurationNs = 0;
+
+        void add(nsecs_t durationNs, size_t physicalResultCount);
+        void dump(int fd) const;
+    };
+
     struct CaptureOutputStates {
         const std::string& cameraId;
-        std::mutex& inflightLock;
+        InFlightLock& inflightLock;
         int64_t& lastCompletedRegularFrameNumber;
         int64_t& lastCompletedReprocessFrameNumber;
         int64_t& lastCompletedZslFrameNumber;
@@ -156,6 +175,7 @@ namespace camera3 {
         bool& isFixedFps;
         int rotationOverride;
         std::string &activePhysicalId;
+        ResultMapperStats& resultMapperStats;
     };
 
     void processCaptureResult(CaptureOutputStates& states, const camera_capture_result *result);
@@ -184,7 +204,7 @@ namespace camera3 {
 
     struct FlushInflightReqStates {
         const std::string& cameraId;
-        std::mutex& inflightLock;
+        InFlightLock& inflightLock;
         InFlightRequestMap& inflightMap; // end of inflightLock scope
         const bool useHalBufManager;
         const std::set<int32_t > &halBufManagedStreamIds;
@@ -114,6 +114,20 @@ void Camera3SharedOutputStream::setHalBufferManager(bool enabled) {
     }
 }
 
+void Camera3SharedOutputStream::dump(int fd, const Vector<String16> &args) {
+    Camera3OutputStream::dump(fd, args);
+
+    // Don't block dumpsys on a stuck stream
+    sp<Camera3StreamSplitter> splitter;
+    if (mLock.tryLock() == OK) {
+        splitter = mStreamSplitter;
+        mLock.unlock();
+    }
+    if (splitter != nullptr) {
+        splitter->dump(fd);
+    }
+}
+
 status_t Camera3SharedOutputStream::notifyBufferReleased(ANativeWindowBuffer *anwBuffer) {
     Mutex::Autolock l(mLock);
     status_t res = OK;
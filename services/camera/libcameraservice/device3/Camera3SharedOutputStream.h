@@ -53,6 +53,8 @@ public:
 
     void setHalBufferManager(bool enabled) override;
 
+    virtual void dump(int fd, const Vector<String16> &args) override;
+
     virtual status_t notifyBufferReleased(ANativeWindowBuffer *buffer);
 
     virtual bool isConsumerConfigurationDeferred(size_t surface_id) const;
@@ -34,6 +34,7 @@
 #include <utils/Trace.h>
 
 #include <cutils/atomic.h>
+#include <unistd.h>
 
 #include "Camera3Stream.h"
 
@@ -144,6 +145,7 @@ void Camera3StreamSplitter::disconnect() {
     mOutputSurfaces.clear();
     mOutputSlots.clear();
     mConsumerBufferCount.clear();
+    mOutputStats.clear();
 
     if (mConsumer.get() != nullptr) {
         mConsumer->consumerDisconnect();
@@ -189,6 +191,25 @@ void Camera3StreamSplitter::setHalBufferManager(bool enabled) {
     mUseHalBufManager = enabled;
 }
 
+void Camera3StreamSplitter::dump(int fd) {
+    Mutex::Autolock lock(mMutex);
+
+    std::string lines;
+    for (const auto& it : mOutputStats) {
+        const OutputStats& stats = it.second;
+        if (stats.numQueued == 0) {
+            continue;
+        }
+        lines += fmt::sprintf("      Splitter output %zu: %zu queued (%.1f us avg, "
+                "%.1f us max), held %.1f ms avg by the consumer, %zu held now\n",
+                it.first, stats.numQueued, stats.totalQueueNs / (stats.numQueued * 1000.0),
+                stats.maxQueueNs / 1000.0,
+                stats.numReturned > 0 ? stats.totalHoldNs / (stats.numReturned * 1e6) : 0.0,
+                stats.queueTimes.size());
+    }
+    write(fd, lines.c_str(), lines.size());
+}
+
 status_t Camera3StreamSplitter::addOutputLocked(size_t surfaceId, const sp<Surface>& outputQueue) {
     ATRACE_CALL();
     if (outputQueue == nullptr) {
@@ -330,6 +351,7 @@ status_t Camera3StreamSplitter::removeOutputLocked(size_t surfaceId) {
     mOutputs[surfaceId] = nullptr;
     mOutputSurfaces[surfaceId] = nullptr;
     mOutputSlots[gbp] = nullptr;
+    mOutputStats[surfaceId].queueTimes.clear();
     for (const auto &id : pendingBufferIds) {
         decrementBufRefCountLocked(id, surfaceId);
     }
@@ -353,62 +375,101 @@ status_t Camera3StreamSplitter::removeOutputLocked(size_t surfaceId) {
     return res;
 }
 
-status_t Camera3StreamSplitter::outputBufferLocked(const sp<IGraphicBufferProducer>& output,
-        const BufferItem& bufferItem, size_t surfaceId) {
+status_t Camera3StreamSplitter::outputBufferLocked(const BufferItem& bufferItem,
+        const std::vector<size_t>& surfaceIds) {
     ATRACE_CALL();
-    status_t res;
+    status_t res = OK;
     IGraphicBufferProducer::QueueBufferInput queueInput(
             bufferItem.mTimestamp, bufferItem.mIsAutoTimestamp,
             bufferItem.mDataSpace, bufferItem.mCrop,
             static_cast<int32_t>(bufferItem.mScalingMode),
             bufferItem.mTransform, bufferItem.mFence);
 
-    IGraphicBufferProducer::QueueBufferOutput queueOutput;
+    struct QueuedOutput {
+        size_t surfaceId;
+        sp<IGraphicBufferProducer> output;
+        int slot;
+        status_t res;
+        IGraphicBufferProducer::QueueBufferOutput queueOutput;
+        nsecs_t durationNs;
+    };
+    std::vector<QueuedOutput> queuedOutputs;
+    queuedOutputs.reserve(surfaceIds.size());
 
     uint64_t bufferId = bufferItem.mGraphicBuffer->getId();
     const BufferTracker& tracker = *(mBuffers[bufferId]);
-    int slot = getSlotForOutputLocked(output, tracker.getBuffer());
+    nsecs_t queueTimeNs = systemTime();
+    for (const auto surfaceId : surfaceIds) {
+        const sp<IGraphicBufferProducer>& output = mOutputs[surfaceId];
+        if (output == nullptr) {
+            //Output surface got likely removed by client.
+            continue;
+        }
 
-    if (mOutputSurfaces[surfaceId] != nullptr) {
-        sp<ANativeWindow> anw = mOutputSurfaces[surfaceId];
-        camera3::Camera3Stream::queueHDRMetadata(
-                bufferItem.mGraphicBuffer->getNativeBuffer()->handle, anw, mDynamicRangeProfile);
-    } else {
-        SP_LOGE("%s: Invalid surface id: %zu!", __FUNCTION__, surfaceId);
+        if (mOutputSurfaces[surfaceId] != nullptr) {
+            sp<ANativeWindow> anw = mOutputSurfaces[surfaceId];
+            camera3::Camera3Stream::queueHDRMetadata(
+                    bufferItem.mGraphicBuffer->getNativeBuffer()->handle, anw,
+                    mDynamicRangeProfile);
+        } else {
+            SP_LOGE("%s: Invalid surface id: %zu!", __FUNCTION__, surfaceId);
+        }
+
+        // Recorded before queueing, as the consumer may release the buffer
+        // before the splitter lock is taken again.
+        mOutputStats[surfaceId].queueTimes[bufferId] = queueTimeNs;
+        queuedOutputs.push_back({surfaceId, output, getSlotForOutputLocked(output,
+                tracker.getBuffer()), OK, {}, 0});
     }
 
     // In case the output BufferQueue has its own lock, if we hold splitter lock while calling
     // queueBuffer (which will try to acquire the output lock), the output could be holding its
     // own lock calling releaseBuffer (which  will try to acquire the splitter lock), running into
-    // circular lock situation.
+    // circular lock situation. The lock is released once for all of the outputs.
     mMutex.unlock();
-    res = output->queueBuffer(slot, queueInput, &queueOutput);
+    for (auto& queued : queuedOutputs) {
+        nsecs_t startNs = systemTime();
+        queued.res = queued.output->queueBuffer(queued.slot, queueInput, &queued.queueOutput);
+        queued.durationNs = systemTime() - startNs;
+    }
     mMutex.lock();
 
-    SP_LOGV("%s: Queuing buffer to buffer queue %p slot %d returns %d",
-            __FUNCTION__, output.get(), slot, res);
-    //During buffer queue 'mMutex' is not held which makes the removal of
-    //"output" possible. Check whether this is the case and return.
-    if (mOutputSlots[output] == nullptr) {
-        return res;
-    }
-    if (res != OK) {
-        if (res != NO_INIT && res != DEAD_OBJECT) {
-            SP_LOGE("Queuing buffer to output failed (%d)", res);
+    for (auto& queued : queuedOutputs) {
+        res = queued.res;
+        SP_LOGV("%s: Queuing buffer to buffer queue %p slot %d returns %d",
+                __FUNCTION__, queued.output.get(), queued.slot, res);
+        //During buffer queue 'mMutex' is not held which makes the removal of
+        //"output" possible. Check whether this is the case and move on.
+        if (mOutputSlots[queued.output] == nullptr) {
+            continue;
+        }
+        OutputStats& stats = mOutputStats[queued.surfaceId];
+        if (res != OK) {
+            if (res != NO_INIT && res != DEAD_OBJECT) {
+                SP_LOGE("Queuing buffer to output failed (%d)", res);
+            }
+            stats.queueTimes.erase(bufferId);
+            // If we just discovered that this output has been abandoned, note
+            // that, increment the release count so that we still release this
+            // buffer eventually, and move on to the next output
+            onAbandonedLocked();
+            decrementBufRefCountLocked(bufferId, queued.surfaceId);
+            SP_LOGE("%s: queueBuffer to surface %zu failed %d", __FUNCTION__,
+                    queued.surfaceId, res);
+            mOnFrameAvailableRes.store(res);
+            continue;
         }
-        // If we just discovered that this output has been abandoned, note
-        // that, increment the release count so that we still release this
-        // buffer eventually, and move on to the next output
-        onAbandonedLocked();
-        decrementBufRefCountLocked(bufferItem.mGraphicBuffer->getId(), surfaceId);
-        return res;
-    }
 
-    // If the queued buffer replaces a pending buffer in the async
-    // queue, no onBufferReleased is called by the buffer queue.
-    // Proactively trigger the callback to avoid buffer loss.
-    if (queueOutput.bufferReplaced) {
-        onBufferReplacedLocked(output, surfaceId);
+        stats.numQueued++;
+        stats.totalQueueNs += queued.durationNs;
+        stats.maxQueueNs = std::max(stats.maxQueueNs, queued.durationNs);
+
+        // If the queued buffer replaces a pending buffer in the async
+        // queue, no onBufferReleased is called by the buffer queue.
+        // Proactively trigger the callback to avoid buffer loss.
+        if (queued.queueOutput.bufferReplaced) {
+            onBufferReplacedLocked(queued.output, queued.surfaceId);
+        }
     }
 
     return res;
@@ -544,22 +605,9 @@ void Camera3StreamSplitter::onFrameAvailable(const BufferItem& /*item*/) {
 
     SP_LOGV("%s: BufferTracker for buffer %" PRId64 ", number of requests %zu",
            __FUNCTION__, bufferItem.mGraphicBuffer->getId(), tracker.requestedSurfaces().size());
-    for (const auto id : tracker.requestedSurfaces()) {
-
-        if (mOutputs[id] == nullptr) {
-            //Output surface got likely removed by client.
-            continue;
-        }
-
-        res = outputBufferLocked(mOutputs[id], bufferItem, id);
-        if (res != OK) {
-            SP_LOGE("%s: outputBufferLocked failed %d", __FUNCTION__, res);
-            mOnFrameAvailableRes.store(res);
-            // If we fail to send buffer to certain output, keep sending to
-            // other outputs.
-            continue;
-        }
-    }
+    // If we fail to send buffer to certain output, keep sending to other
+    // outputs.
+    res = outputBufferLocked(bufferItem, tracker.requestedSurfaces());
 
     mOnFrameAvailableRes.store(res);
 }
@@ -704,9 +752,20 @@ void Camera3StreamSplitter::returnOutputBufferLocked(const sp<Fence>& fence,
         return;
     }
 
-    auto outputSlots = *mOutputSlots[from];
+    auto& outputSlots = *mOutputSlots[from];
     buffer = outputSlots[slot];
     BufferTracker& tracker = *(mBuffers[buffer->getId()]);
+
+    auto stats = mOutputStats.find(surfaceId);
+    if (stats != mOutputStats.end()) {
+        auto queueTime = stats->second.queueTimes.find(buffer->getId());
+        if (queueTime != stats->second.queueTimes.end()) {
+            stats->second.numReturned++;
+            stats->second.totalHoldNs += systemTime() - queueTime->second;
+            stats->second.queueTimes.erase(queueTime);
+        }
+    }
+
     // Merge the release fence of the incoming buffer so that the fence we send
     // back to the input includes all of the outputs' fences
     if (fence != nullptr && fence->isValid()) {
@@ -805,6 +864,15 @@ Camera3StreamSplitter::BufferTracker::BufferTracker(
         mReferenceCount(requestedSurfaces.size()) {}
 
 void Camera3StreamSplitter::BufferTracker::mergeFence(const sp<Fence>& with) {
+    // Most outputs are done with the buffer by the time they release it; only
+    // merge (creating a new sync fence) when there are two fences to wait on.
+    if (with->getStatus() == Fence::Status::Signaled) {
+        return;
+    }
+    if (!mMergedFence->isValid() || mMergedFence->getStatus() == Fence::Status::Signaled) {
+        mMergedFence = with;
+        return;
+    }
     mMergedFence = Fence::merge(String8("Camera3StreamSplitter"), mMergedFence, with);
 }
 
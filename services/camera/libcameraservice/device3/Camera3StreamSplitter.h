@@ -96,6 +96,10 @@ public:
 
     void setHalBufferManager(bool enabled);
 
+    // Dump the latency of each output: how long queueBuffer takes, and how
+    // long its consumer holds the buffers.
+    void dump(int fd);
+
 private:
     // From IConsumerListener
     //
@@ -217,11 +221,11 @@ private:
 
     status_t removeOutputLocked(size_t surfaceId);
 
-    // Send a buffer to particular output, and increment the reference count
-    // of the buffer. If this output is abandoned, the buffer's reference count
-    // won't be incremented.
-    status_t outputBufferLocked(const sp<IGraphicBufferProducer>& output,
-            const BufferItem& bufferItem, size_t surfaceId);
+    // Send a buffer to the given outputs, releasing mMutex once around all of
+    // the queueBuffer calls. If an output is abandoned, the buffer's reference
+    // count is decremented for it. Returns the status of the last output.
+    status_t outputBufferLocked(const BufferItem& bufferItem,
+            const std::vector<size_t>& surfaceIds);
 
     // Get unique name for the buffer queue consumer
     std::string getUniqueConsumerName();
@@ -291,6 +295,20 @@ private:
     // Currently acquired input buffers
     size_t mAcquiredInputBuffers;
 
+    struct OutputStats {
+        size_t numQueued = 0;
+        nsecs_t totalQueueNs = 0;    // in queueBuffer
+        nsecs_t maxQueueNs = 0;
+        size_t numReturned = 0;
+        nsecs_t totalHoldNs = 0;     // from queueBuffer to the release by the consumer
+
+        // Buffer id -> time queued, for the buffers the consumer holds
+        std::unordered_map<uint64_t, nsecs_t> queueTimes;
+    };
+
+    // Map surface ids -> output latency
+    std::unordered_map<size_t, OutputStats> mOutputStats;
+
     std::string mConsumerName;
 
     bool mUseHalBufManager;
@@ -17,10 +17,18 @@
 #ifndef ANDROID_SERVERS_CAMERA3_INFLIGHT_REQUEST_H
 #define ANDROID_SERVERS_CAMERA3_INFLIGHT_REQUEST_H
 
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <set>
+#include <string>
+#include <vector>
 
 #include <camera/CaptureResult.h>
 #include <camera/CameraMetadata.h>
+#include <fmt/printf.h>
+#include <log/log.h>
 #include <utils/Timers.h>
 
 #include "common/CameraDeviceBase.h"
@@ -136,6 +144,8 @@ struct InFlightRequest {
     // event. They will be returned to the streams when framework receives
     // the shutter event.
     Vector<camera_stream_buffer_t> pendingOutputBuffers;
+    // Time (from systemTime) each of the pendingOutputBuffers was returned by HAL
+    std::vector<nsecs_t> pendingOutputBufferTimesNs;
 
     // Whether this inflight request's shutter and result callback are to be
     // called. The policy is that if the request is the last one in the constrained
@@ -192,6 +202,9 @@ struct InFlightRequest {
     // Time of capture request (from systemTime) in Ns
     nsecs_t requestTimeNs;
 
+    // Time the final result metadata was received (from systemTime) in Ns
+    nsecs_t resultTimeNs;
+
     // What shared surfaces an output should go to
     SurfaceMap outputSurfaces;
 
@@ -201,7 +214,7 @@ struct InFlightRequest {
     static const nsecs_t kDefaultMinExpectedDuration = 33333333; // 33 ms
     static const nsecs_t kDefaultMaxExpectedDuration = 100000000; // 100 ms
 
-    // Default constructor needed by KeyedVector
+    // Default constructor
     InFlightRequest() :
             shutterTimestamp(0),
             sensorTimestamp(0),
@@ -220,6 +233,7 @@ struct InFlightRequest {
             rotateAndCropAuto(false),
             autoframingAuto(false),
             requestTimeNs(0),
+            resultTimeNs(0),
             transform(-1) {
     }
 
@@ -249,13 +263,145 @@ struct InFlightRequest {
             autoframingAuto(autoframingAuto),
             cameraIdsWithZoom(idsWithZoom),
             requestTimeNs(requestNs),
+            resultTimeNs(0),
             outputSurfaces(outSurfaces),
             transform(-1) {
     }
 };
 
-// Map from frame number to the in-flight request state
-typedef KeyedVector<uint32_t, InFlightRequest> InFlightRequestMap;
+// Map from frame number to the in-flight request state, with the subset of the
+// KeyedVector interface used for it.
+//
+// Requests are registered in increasing frame number order and mostly complete
+// in that order, so the entries are kept sorted in a ring and a frame number is
+// found from its offset to the oldest entry, falling back to a binary search
+// after out of order removals. Entries are allocated separately so that adding
+// and removing them only moves pointers, and references to an entry stay valid
+// until it is removed.
+class InFlightRequestMap {
+  public:
+    InFlightRequestMap() = default;
+    InFlightRequestMap(const InFlightRequestMap& other) { *this = other; }
+    InFlightRequestMap& operator=(const InFlightRequestMap& other) {
+        if (this != &other) {
+            mEntries.clear();
+            for (const auto& entry : other.mEntries) {
+                mEntries.emplace_back(entry.first,
+                        std::make_unique<InFlightRequest>(*entry.second));
+            }
+        }
+        return *this;
+    }
+
+    size_t size() const { return mEntries.size(); }
+    bool isEmpty() const { return mEntries.empty(); }
+
+    // Returns the index of the entry for frameNumber, or NAME_NOT_FOUND
+    ssize_t indexOfKey(uint32_t frameNumber) const {
+        if (mEntries.empty()) {
+            return NAME_NOT_FOUND;
+        }
+        uint32_t offset = frameNumber - mEntries.front().first;
+        if (offset < mEntries.size() && mEntries[offset].first == frameNumber) {
+            return offset;
+        }
+        auto it = lowerBound(frameNumber);
+        if (it == mEntries.end() || it->first != frameNumber) {
+            return NAME_NOT_FOUND;
+        }
+        return it - mEntries.begin();
+    }
+
+    uint32_t keyAt(size_t idx) const { return mEntries[idx].first; }
+    const InFlightRequest& valueAt(size_t idx) const { return *mEntries[idx].second; }
+    InFlightRequest& editValueAt(size_t idx) { return *mEntries[idx].second; }
+
+    // The entry for frameNumber must exist
+    const InFlightRequest& valueFor(uint32_t frameNumber) const {
+        ssize_t idx = indexOfKey(frameNumber);
+        LOG_ALWAYS_FATAL_IF(idx < 0, "%s: No in-flight request for frame %u", __FUNCTION__,
+                frameNumber);
+        return valueAt(idx);
+    }
+
+    // Adds the entry for frameNumber, or replaces it if it exists already.
+    // Returns its index.
+    ssize_t add(uint32_t frameNumber, const InFlightRequest& request) {
+        auto value = std::make_unique<InFlightRequest>(request);
+        if (mEntries.empty() || mEntries.back().first < frameNumber) {
+            mEntries.emplace_back(frameNumber, std::move(value));
+            return mEntries.size() - 1;
+        }
+        auto it = lowerBound(frameNumber);
+        if (it->first == frameNumber) {
+            it->second = std::move(value);
+        } else {
+            it = mEntries.emplace(it, frameNumber, std::move(value));
+        }
+        return it - mEntries.begin();
+    }
+
+    void removeItemsAt(size_t idx, size_t count = 1) {
+        mEntries.erase(mEntries.begin() + idx, mEntries.begin() + idx + count);
+    }
+
+    void clear() { mEntries.clear(); }
+
+  private:
+    typedef std::pair<uint32_t, std::unique_ptr<InFlightRequest>> Entry;
+
+    std::deque<Entry>::const_iterator lowerBound(uint32_t frameNumber) const {
+        return std::lower_bound(mEntries.begin(), mEntries.end(), frameNumber,
+                [](const Entry& entry, uint32_t key) { return entry.first < key; });
+    }
+    std::deque<Entry>::iterator lowerBound(uint32_t frameNumber) {
+        return std::lower_bound(mEntries.begin(), mEntries.end(), frameNumber,
+                [](const Entry& entry, uint32_t key) { return entry.first < key; });
+    }
+
+    std::deque<Entry> mEntries;
+};
+
+// Lock protecting an InFlightRequestMap. Works like a std::mutex, and also
+// keeps track of how often and how long lock() had to wait for it, since it's
+// taken by the request thread and the HAL callbacks for every frame.
+class InFlightLock {
+  public:
+    void lock() {
+        if (mMutex.try_lock()) {
+            mLockCount++;
+            return;
+        }
+        nsecs_t startTime = systemTime();
+        mMutex.lock();
+        nsecs_t waitTime = systemTime() - startTime;
+        mLockCount++;
+        mContendedCount++;
+        mTotalWaitTime += waitTime;
+        mMaxWaitTime = std::max(mMaxWaitTime, waitTime);
+    }
+
+    // Not counted, only used to not block dumps
+    bool try_lock() { return mMutex.try_lock(); }
+
+    void unlock() { mMutex.unlock(); }
+
+    // Must be called with the lock held
+    std::string getStatsLocked() const {
+        return fmt::sprintf("%" PRIu64 " locks, %" PRIu64 " contended (%.1f%%),"
+                " wait total %" PRId64 " us, max %" PRId64 " us", mLockCount, mContendedCount,
+                mLockCount > 0 ? 100.0 * mContendedCount / mLockCount : 0.0,
+                ns2us(mTotalWaitTime), ns2us(mMaxWaitTime));
+    }
+
+  private:
+    std::mutex mMutex;
+    // Only updated with mMutex held
+    uint64_t mLockCount = 0;
+    uint64_t mContendedCount = 0;
+    nsecs_t mTotalWaitTime = 0;
+    nsecs_t mMaxWaitTime = 0;
+};
 
 } // namespace camera3
 
@@ -18,6 +18,7 @@
 #define ATRACE_TAG ATRACE_TAG_CAMERA
 //#define LOG_NDEBUG 0
 
+#include <fmt/printf.h>
 #include <utils/Log.h>
 
 #include "PreviewFrameSpacer.h"
@@ -72,7 +73,15 @@ bool PreviewFrameSpacer::threadLoop() {
     // Because the code between here and queueBuffer() takes time to execute, make sure the
     // presentationInterval is slightly shorter than readoutInterval.
     nsecs_t expectedQueueTime = mLastCameraPresentTime + readoutInterval - kFrameAdjustThreshold;
-    nsecs_t frameWaitTime = std::min(kMaxFrameWaitTime, expectedQueueTime - currentTime);
+    nsecs_t queueTime = expectedQueueTime;
+    if (expectedQueueTime > currentTime) {
+        queueTime = alignQueueTimeToVsyncLocked(expectedQueueTime, readoutInterval);
+        if (exitPending()) {
+            return false;
+        }
+        currentTime = systemTime();
+    }
+    nsecs_t frameWaitTime = std::min(kMaxFrameWaitTime, queueTime - currentTime);
     if (frameWaitTime > 0 && mPendingBuffers.size() < 2) {
         mBufferCond.waitRelative(mLock, frameWaitTime);
         if (exitPending()) {
@@ -81,13 +90,61 @@ bool PreviewFrameSpacer::threadLoop() {
         currentTime = systemTime();
     }
     ALOGV("%s: readoutInterval %" PRId64 ", waited for %" PRId64
-            ", timestamp %" PRId64, __FUNCTION__, readoutInterval,
-            mPendingBuffers.size() < 2 ? frameWaitTime : 0, buffer.timestamp);
+            ", timestamp %" PRId64 ", %" PRId64 " ns ahead of readout cadence", __FUNCTION__,
+            readoutInterval, mPendingBuffers.size() < 2 ? frameWaitTime : 0, buffer.timestamp,
+            expectedQueueTime - currentTime);
+
+    mQueuedCount++;
+    if (currentTime < queueTime - kFrameAdjustThreshold) {
+        mEarlyCount++;
+    } else if (currentTime > queueTime + kFrameAdjustThreshold) {
+        mLateCount++;
+    }
+    if (queueTime < expectedQueueTime) {
+        mVsyncAlignedCount++;
+        mVsyncAlignedTotalNs += std::max<nsecs_t>(0, expectedQueueTime - currentTime);
+    }
+
     mPendingBuffers.pop();
     queueBufferToClientLocked(buffer, currentTime);
     return true;
 }
 
+nsecs_t PreviewFrameSpacer::alignQueueTimeToVsyncLocked(nsecs_t expectedQueueTime,
+        nsecs_t readoutInterval) {
+    // Don't block queuePreviewBuffer on the call into the display service. Only
+    // this thread removes pending buffers, so the front one stays the same.
+    ParcelableVsyncEventData parcelableVsyncEventData;
+    mLock.unlock();
+    status_t res = mDisplayEventReceiver.getLatestVsyncEventData(&parcelableVsyncEventData);
+    mLock.lock();
+    if (res != OK) {
+        ALOGV("%s: Error getting latest vsync event data: %s (%d)", __FUNCTION__,
+                strerror(-res), res);
+        return expectedQueueTime;
+    }
+    const VsyncEventData& vsyncEventData = parcelableVsyncEventData.vsync;
+    nsecs_t frameInterval = vsyncEventData.frameInterval;
+    if (frameInterval <= 0 || vsyncEventData.frameTimelinesLength == 0) {
+        return expectedQueueTime;
+    }
+
+    // The consumer renders from the latest buffer once per vsync. Buffer
+    // deadlines are vsync aligned, so use them to find the refresh period of
+    // the previous buffer, and keep the same number of vsyncs between
+    // buffers as the readout interval spans.
+    nsecs_t reference = vsyncEventData.frameTimelines[0].deadlineTimestamp;
+    nsecs_t offset = (mLastCameraPresentTime - reference) % frameInterval;
+    if (offset < 0) offset += frameInterval;
+    nsecs_t lastPeriodStart = mLastCameraPresentTime - offset;
+    nsecs_t vsyncCount = std::max<nsecs_t>(1,
+            (readoutInterval + frameInterval / 2) / frameInterval);
+    nsecs_t alignedQueueTime = lastPeriodStart + vsyncCount * frameInterval +
+            kFrameAdjustThreshold;
+
+    return std::min(expectedQueueTime, alignedQueueTime);
+}
+
 void PreviewFrameSpacer::requestExit() {
     // Call parent to set up shutdown
     Thread::requestExit();
@@ -95,6 +152,15 @@ void PreviewFrameSpacer::requestExit() {
     mBufferCond.signal();
 }
 
+void PreviewFrameSpacer::dump(int fd) const {
+    Mutex::Autolock l(mLock);
+    std::string lines = fmt::sprintf("      Preview spacer: %" PRId64 " queued, %" PRId64
+            " early, %" PRId64 " late, %" PRId64 " aligned to vsync (%.2f ms earlier on"
+            " average)\n", mQueuedCount, mEarlyCount, mLateCount, mVsyncAlignedCount,
+            mVsyncAlignedCount > 0 ? mVsyncAlignedTotalNs / 1e6 / mVsyncAlignedCount : 0.0);
+    write(fd, lines.c_str(), lines.size());
+}
+
 void PreviewFrameSpacer::queueBufferToClientLocked(
         const BufferHolder& bufferHolder, nsecs_t currentTime) {
     sp<Camera3OutputStream> parent = mParent.promote();
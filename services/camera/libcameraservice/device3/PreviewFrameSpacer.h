@@ -19,6 +19,7 @@
 
 #include <queue>
 
+#include <gui/DisplayEventReceiver.h>
 #include <gui/Surface.h>
 #include <utils/Condition.h>
 #include <utils/Mutex.h>
@@ -46,6 +47,8 @@ class Camera3OutputStream;
  * - Queue frame buffers in the same cadence as the camera readout time.
  * - Maintain at most 1 queue-able buffer. If the 2nd preview buffer becomes
  *   available, queue the oldest cached buffer to the buffer queue.
+ * - Queue a buffer as early in its display refresh period as the cadence
+ *   allows, since the consumer only picks it up at the next vsync anyway.
  */
 class PreviewFrameSpacer : public Thread {
   public:
@@ -59,6 +62,8 @@ class PreviewFrameSpacer : public Thread {
     bool threadLoop() override;
     void requestExit() override;
 
+    void dump(int fd) const;
+
   private:
     // structure holding cached preview buffer info
     struct BufferHolder {
@@ -75,6 +80,11 @@ class PreviewFrameSpacer : public Thread {
 
     void queueBufferToClientLocked(const BufferHolder& bufferHolder, nsecs_t currentTime);
 
+    // Returns the earliest time to queue a buffer readoutInterval after the
+    // previous one that the consumer still latches on the same vsync as at
+    // expectedQueueTime. Drops mLock while getting the vsync timeline.
+    nsecs_t alignQueueTimeToVsyncLocked(nsecs_t expectedQueueTime, nsecs_t readoutInterval);
+
     wp<Camera3OutputStream> mParent;
     sp<ANativeWindow> mConsumer;
     mutable Mutex mLock;
@@ -83,6 +93,18 @@ class PreviewFrameSpacer : public Thread {
     std::queue<BufferHolder> mPendingBuffers;
     nsecs_t mLastCameraReadoutTime = 0;
     nsecs_t mLastCameraPresentTime = 0;
+
+    DisplayEventReceiver mDisplayEventReceiver;
+
+    // Queueing stats against the readout cadence, for dump
+    int64_t mQueuedCount = 0;
+    // Queued more than kFrameAdjustThreshold before or after the cadence
+    int64_t mEarlyCount = 0;
+    int64_t mLateCount = 0;
+    // Queued earlier thanks to the vsync timeline, and the total time gained
+    int64_t mVsyncAlignedCount = 0;
+    nsecs_t mVsyncAlignedTotalNs = 0;
+
     static constexpr nsecs_t kWaitDuration = 5000000LL; // 50ms
     static constexpr nsecs_t kFrameIntervalThreshold = 80000000LL; // 80ms
     static constexpr nsecs_t kMaxFrameWaitTime = 10000000LL; // 10ms
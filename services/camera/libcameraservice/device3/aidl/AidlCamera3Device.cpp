@@ -417,7 +417,7 @@ status_t AidlCamera3Device::initialize(sp<CameraProviderManager> manager,
         mDistortionMappers, mZoomRatioMappers, mRotateAndCropMappers,
         mTagMonitor, mInputStream, mOutputStreams, mSessionStatsBuilder, listener, *this,
         *this, *(mInterface), mLegacyClient, mMinExpectedDuration, mIsFixedFps,
-        mRotationOverride, mActivePhysicalId}, mResultMetadataQueue
+        mRotationOverride, mActivePhysicalId, mResultMapperStats}, mResultMetadataQueue
     };
 
     for (const auto& result : results) {
@@ -459,7 +459,7 @@ status_t AidlCamera3Device::initialize(sp<CameraProviderManager> manager,
         mDistortionMappers, mZoomRatioMappers, mRotateAndCropMappers,
         mTagMonitor, mInputStream, mOutputStreams, mSessionStatsBuilder, listener, *this,
         *this, *(mInterface), mLegacyClient, mMinExpectedDuration, mIsFixedFps,
-        mRotationOverride, mActivePhysicalId}, mResultMetadataQueue
+        mRotationOverride, mActivePhysicalId, mResultMapperStats}, mResultMetadataQueue
     };
     for (const auto& msg : msgs) {
         camera3::notify(states, msg, mSensorReadoutTimestampSupported);
@@ -587,7 +587,7 @@ status_t AidlCamera3Device::switchToOffline(
     InFlightRequestMap offlineReqs;
     // Verify inflight requests and their pending buffers
     {
-        std::lock_guard<std::mutex> l(mInFlightLock);
+        std::lock_guard<InFlightLock> l(mInFlightLock);
         for (auto offlineReq : offlineSessionInfo.offlineRequests) {
             int idx = mInFlightMap.indexOfKey(offlineReq.frameNumber);
             if (idx == NAME_NOT_FOUND) {
@@ -371,7 +371,7 @@ hardware::Return<void> HidlCamera3Device::processCaptureResult_3_4(
         mDistortionMappers, mZoomRatioMappers, mRotateAndCropMappers,
         mTagMonitor, mInputStream, mOutputStreams, mSessionStatsBuilder, listener, *this, *this,
         *mInterface, mLegacyClient, mMinExpectedDuration, mIsFixedFps, mRotationOverride,
-        mActivePhysicalId}, mResultMetadataQueue
+        mActivePhysicalId, mResultMapperStats}, mResultMetadataQueue
     };
 
     //HidlCaptureOutputStates hidlStates {
@@ -434,7 +434,7 @@ hardware::Return<void> HidlCamera3Device::processCaptureResult(
         mDistortionMappers, mZoomRatioMappers, mRotateAndCropMappers,
         mTagMonitor, mInputStream, mOutputStreams, mSessionStatsBuilder, listener, *this, *this,
         *mInterface, mLegacyClient, mMinExpectedDuration, mIsFixedFps, mRotationOverride,
-        mActivePhysicalId}, mResultMetadataQueue
+        mActivePhysicalId, mResultMapperStats}, mResultMetadataQueue
     };
 
     for (const auto& result : results) {
@@ -482,7 +482,7 @@ hardware::Return<void> HidlCamera3Device::notifyHelper(
         mDistortionMappers, mZoomRatioMappers, mRotateAndCropMappers,
         mTagMonitor, mInputStream, mOutputStreams, mSessionStatsBuilder, listener, *this, *this,
         *mInterface, mLegacyClient, mMinExpectedDuration, mIsFixedFps, mRotationOverride,
-        mActivePhysicalId}, mResultMetadataQueue
+        mActivePhysicalId, mResultMapperStats}, mResultMetadataQueue
     };
     for (const auto& msg : msgs) {
         camera3::notify(states, msg);
@@ -609,7 +609,7 @@ status_t HidlCamera3Device::switchToOffline(
     InFlightRequestMap offlineReqs;
     // Verify inflight requests and their pending buffers
     {
-        std::lock_guard<std::mutex> l(mInFlightLock);
+        std::lock_guard<InFlightLock> l(mInFlightLock);
         for (auto offlineReq : offlineSessionInfo.offlineRequests) {
             int idx = mInFlightMap.indexOfKey(offlineReq.frameNumber);
             if (idx == NAME_NOT_FOUND) {
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "InFlightRequestMapTest"
+
+#include <gtest/gtest.h>
+#include <utils/Errors.h>
+
+#include "../device3/InFlightRequest.h"
+
+using namespace android;
+using namespace android::camera3;
+
+static InFlightRequest makeRequest(int numBuffers) {
+    InFlightRequest request;
+    request.numBuffersLeft = numBuffers;
+    return request;
+}
+
+TEST(InFlightRequestMapTest, InOrder) {
+    InFlightRequestMap map;
+    EXPECT_TRUE(map.isEmpty());
+    EXPECT_EQ(map.indexOfKey(0), NAME_NOT_FOUND);
+
+    for (uint32_t frameNumber = 10; frameNumber < 20; frameNumber++) {
+        EXPECT_EQ(map.add(frameNumber, makeRequest(frameNumber)),
+                static_cast<ssize_t>(frameNumber - 10));
+    }
+    ASSERT_EQ(map.size(), 10u);
+    for (uint32_t frameNumber = 10; frameNumber < 20; frameNumber++) {
+        ssize_t idx = map.indexOfKey(frameNumber);
+        ASSERT_EQ(idx, static_cast<ssize_t>(frameNumber - 10));
+        EXPECT_EQ(map.keyAt(idx), frameNumber);
+        EXPECT_EQ(map.valueAt(idx).numBuffersLeft, static_cast<int>(frameNumber));
+    }
+    EXPECT_EQ(map.indexOfKey(9), NAME_NOT_FOUND);
+    EXPECT_EQ(map.indexOfKey(20), NAME_NOT_FOUND);
+
+    // Completing the oldest request first
+    map.removeItemsAt(0);
+    EXPECT_EQ(map.indexOfKey(10), NAME_NOT_FOUND);
+    EXPECT_EQ(map.indexOfKey(11), 0);
+    EXPECT_EQ(map.valueFor(19).numBuffersLeft, 19);
+
+    map.clear();
+    EXPECT_TRUE(map.isEmpty());
+}
+
+TEST(InFlightRequestMapTest, OutOfOrder) {
+    InFlightRequestMap map;
+    for (uint32_t frameNumber : {5, 1, 3, 7, 2}) {
+        map.add(frameNumber, makeRequest(frameNumber));
+    }
+    ASSERT_EQ(map.size(), 5u);
+    uint32_t expectedKeys[] = {1, 2, 3, 5, 7};
+    for (size_t i = 0; i < map.size(); i++) {
+        EXPECT_EQ(map.keyAt(i), expectedKeys[i]);
+        EXPECT_EQ(map.indexOfKey(expectedKeys[i]), static_cast<ssize_t>(i));
+    }
+    EXPECT_EQ(map.indexOfKey(4), NAME_NOT_FOUND);
+
+    // Replacing an entry keeps its position
+    EXPECT_EQ(map.add(3, makeRequest(30)), 2);
+    EXPECT_EQ(map.size(), 5u);
+    EXPECT_EQ(map.valueFor(3).numBuffersLeft, 30);
+
+    // References stay valid across other additions and removals
+    InFlightRequest& request = map.editValueAt(map.indexOfKey(7));
+    map.removeItemsAt(map.indexOfKey(2));
+    map.add(8, makeRequest(8));
+    request.numBuffersLeft = 70;
+    EXPECT_EQ(map.valueFor(7).numBuffersLeft, 70);
+    EXPECT_EQ(map.indexOfKey(8), 4);
+}
+
+TEST(InFlightRequestMapTest, Copy) {
+    InFlightRequestMap map;
+    map.add(1, makeRequest(1));
+    map.add(2, makeRequest(2));
+
+    InFlightRequestMap copy(map);
+    copy.editValueAt(0).numBuffersLeft = 10;
+    EXPECT_EQ(map.valueFor(1).numBuffersLeft, 1);
+    EXPECT_EQ(copy.valueFor(1).numBuffersLeft, 10);
+    EXPECT_EQ(copy.valueFor(2).numBuffersLeft, 2);
+}
@@ -18,6 +18,7 @@
 #define LOG_TAG "SessionStatsBuilderTest"
 
 #include <gtest/gtest.h>
+#include <numeric>
 #include <utils/Errors.h>
 
 #include "../utils/SessionStatsBuilder.h"
@@ -67,3 +68,36 @@ TEST(SessionStatsBuilderTest, FpsHistogramTest) {
     ASSERT_EQ(mostRequestedFpsRange, make_pair(2, 2)) << "Incorrect stats overflow behavior";
 
 }
+
+TEST(SessionStatsBuilderTest, HalToConsumerLatencyHistogramTest) {
+    SessionStatsBuilder b{};
+
+    int64_t requestCount, resultErrorCount;
+    bool deviceError;
+    pair<int32_t, int32_t> mostRequestedFpsRange;
+    map<int, StreamStats> streamStatsMap;
+
+    ASSERT_EQ(OK, b.addStream(0));
+    b.startCounter(0);
+    b.incCounter(0, /*dropped*/false, /*captureLatencyMs*/150, /*halToConsumerLatencyMs*/0);
+    b.incCounter(0, /*dropped*/false, /*captureLatencyMs*/150, /*halToConsumerLatencyMs*/5);
+    b.incCounter(0, /*dropped*/false, /*captureLatencyMs*/150, /*halToConsumerLatencyMs*/500);
+    // Unknown HAL to consumer latency
+    b.incCounter(0, /*dropped*/true, /*captureLatencyMs*/150);
+
+    b.buildAndReset(&requestCount, &resultErrorCount,
+        &deviceError, &mostRequestedFpsRange, &streamStatsMap);
+    const StreamStats& stats = streamStatsMap[0];
+    EXPECT_EQ(4, stats.mCaptureLatencyHistogram[1]);
+    EXPECT_EQ(1, stats.mHalToConsumerLatencyHistogram[0]);
+    EXPECT_EQ(1, stats.mHalToConsumerLatencyHistogram[3]);
+    EXPECT_EQ(1, stats.mHalToConsumerLatencyHistogram[StreamStats::LATENCY_BIN_COUNT - 1]);
+    EXPECT_EQ(3, accumulate(stats.mHalToConsumerLatencyHistogram.begin(),
+            stats.mHalToConsumerLatencyHistogram.end(), int64_t(0)));
+
+    // Verify the histogram is reset
+    b.buildAndReset(&requestCount, &resultErrorCount,
+        &deviceError, &mostRequestedFpsRange, &streamStatsMap);
+    EXPECT_EQ(0, accumulate(streamStatsMap[0].mHalToConsumerLatencyHistogram.begin(),
+            streamStatsMap[0].mHalToConsumerLatencyHistogram.end(), int64_t(0)));
+}
@@ -20,7 +20,9 @@
 
 #include <numeric>
 
+#include <android-base/stringprintf.h>
 #include <inttypes.h>
+#include <unistd.h>
 #include <utils/Log.h>
 
 #include "SessionStatsBuilder.h"
@@ -33,6 +35,12 @@ namespace android {
 const std::array<int32_t, StreamStats::LATENCY_BIN_COUNT-1> StreamStats::mCaptureLatencyBins {
         { 100, 200, 300, 400, 500, 700, 900, 1300, 2100 } };
 
+// Bins for HAL to consumer latency: [0, 1], [1, 2], [2, 4], ... [100, 200],
+// [200, inf]. Also in milliseconds.
+const std::array<int32_t, StreamStats::LATENCY_BIN_COUNT-1>
+        StreamStats::mHalToConsumerLatencyBins {
+        { 1, 2, 4, 8, 16, 33, 66, 100, 200 } };
+
 status_t SessionStatsBuilder::addStream(int id) {
     std::lock_guard<std::mutex> l(mLock);
     StreamStats stats;
@@ -76,6 +84,7 @@ void SessionStatsBuilder::buildAndReset(int64_t* requestCount,
     mDeviceError = false;
     mUserTag.clear();
     mRequestedFpsRangeHistogram.clear();
+    mResultLatencyHistogram.fill(0);
 
     for (auto& streamStats : mStatsMap) {
         StreamStats& streamStat = streamStats.second;
@@ -86,6 +95,7 @@ void SessionStatsBuilder::buildAndReset(int64_t* requestCount,
 
         std::fill(streamStat.mCaptureLatencyHistogram.begin(),
                 streamStat.mCaptureLatencyHistogram.end(), 0);
+        streamStat.mHalToConsumerLatencyHistogram.fill(0);
     }
 }
 
@@ -100,7 +110,8 @@ void SessionStatsBuilder::stopCounter(int id) {
     streamStat.mCounterStopped = true;
 }
 
-void SessionStatsBuilder::incCounter(int id, bool dropped, int32_t captureLatencyMs) {
+void SessionStatsBuilder::incCounter(int id, bool dropped, int32_t captureLatencyMs,
+        int32_t halToConsumerLatencyMs) {
     std::lock_guard<std::mutex> l(mLock);
 
     auto it = mStatsMap.find(id);
@@ -118,6 +129,10 @@ void SessionStatsBuilder::incCounter(int id, bool dropped, int32_t captureLatenc
     }
 
     streamStat.updateLatencyHistogram(captureLatencyMs);
+    if (halToConsumerLatencyMs >= 0) {
+        StreamStats::updateHistogram(StreamStats::mHalToConsumerLatencyBins,
+                &streamStat.mHalToConsumerLatencyHistogram, halToConsumerLatencyMs);
+    }
 }
 
 void SessionStatsBuilder::stopCounter() {
@@ -128,12 +143,55 @@ void SessionStatsBuilder::stopCounter() {
     }
 }
 
-void SessionStatsBuilder::incResultCounter(bool dropped) {
+void SessionStatsBuilder::incResultCounter(bool dropped, int32_t resultLatencyMs) {
     std::lock_guard<std::mutex> l(mLock);
     if (mCounterStopped) return;
 
     mRequestCount++;
     if (dropped) mErrorResultCount++;
+    if (resultLatencyMs >= 0) {
+        StreamStats::updateHistogram(StreamStats::mCaptureLatencyBins, &mResultLatencyHistogram,
+                resultLatencyMs);
+    }
+}
+
+static void appendHistogram(std::string* lines, const char* name,
+        const std::array<int32_t, StreamStats::LATENCY_BIN_COUNT-1>& bins,
+        const std::array<int64_t, StreamStats::LATENCY_BIN_COUNT>& histogram) {
+    int64_t totalCount = std::accumulate(histogram.begin(), histogram.end(), int64_t(0));
+    if (totalCount == 0) {
+        return;
+    }
+
+    std::string lineBins = "          ", lineBinCounts = "          ";
+    for (size_t i = 0; i < histogram.size(); i++) {
+        if (i == bins.size()) {
+            lineBins += "    inf (max ms)";
+        } else {
+            base::StringAppendF(&lineBins, "%7d", bins[i]);
+        }
+        base::StringAppendF(&lineBinCounts, "   %02.2f", 100.0 * histogram[i] / totalCount);
+    }
+    base::StringAppendF(lines, "        %s (%" PRId64 " samples):\n%s\n%s (%%)\n", name,
+            totalCount, lineBins.c_str(), lineBinCounts.c_str());
+}
+
+void SessionStatsBuilder::dump(int fd) {
+    std::lock_guard<std::mutex> l(mLock);
+    std::string lines = "    Session latency histograms:\n";
+    appendHistogram(&lines, "Request to result", StreamStats::mCaptureLatencyBins,
+            mResultLatencyHistogram);
+    for (const auto& streamStats : mStatsMap) {
+        const StreamStats& streamStat = streamStats.second;
+        base::StringAppendF(&lines, "      Stream %d: %" PRId64 " requested, %" PRId64
+                " dropped\n", streamStats.first, streamStat.mRequestedFrameCount,
+                streamStat.mDroppedFrameCount);
+        appendHistogram(&lines, "Request to buffer", StreamStats::mCaptureLatencyBins,
+                streamStat.mCaptureLatencyHistogram);
+        appendHistogram(&lines, "HAL to consumer", StreamStats::mHalToConsumerLatencyBins,
+                streamStat.mHalToConsumerLatencyHistogram);
+    }
+    write(fd, lines.c_str(), lines.size());
 }
 
 void SessionStatsBuilder::onDeviceError() {
@@ -167,16 +225,21 @@ void SessionStatsBuilder::incFpsRequestedCount(int32_t minFps, int32_t maxFps,
 }
 
 void StreamStats::updateLatencyHistogram(int32_t latencyMs) {
+    updateHistogram(mCaptureLatencyBins, &mCaptureLatencyHistogram, latencyMs);
+}
+
+void StreamStats::updateHistogram(const std::array<int32_t, LATENCY_BIN_COUNT-1>& bins,
+        std::array<int64_t, LATENCY_BIN_COUNT>* histogram, int32_t latencyMs) {
     size_t i;
-    for (i = 0; i < mCaptureLatencyBins.size(); i++) {
-        if (latencyMs < mCaptureLatencyBins[i]) {
-            mCaptureLatencyHistogram[i] ++;
+    for (i = 0; i < bins.size(); i++) {
+        if (latencyMs < bins[i]) {
+            (*histogram)[i] ++;
             break;
         }
     }
 
-    if (i == mCaptureLatencyBins.size()) {
-        mCaptureLatencyHistogram[i]++;
+    if (i == bins.size()) {
+        (*histogram)[i]++;
     }
 }
 
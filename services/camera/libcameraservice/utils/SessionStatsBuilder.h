@@ -22,6 +22,7 @@
 #include <array>
 #include <map>
 #include <mutex>
+#include <string>
 #include <unordered_map>
 #include <utility>
 
@@ -45,14 +46,24 @@ struct StreamStats {
     // Counter values for all histogram bins. One more entry than mCaptureLatencyBins.
     std::array<int64_t, LATENCY_BIN_COUNT> mCaptureLatencyHistogram;
 
+    // Fields for HAL to consumer latency: from the HAL returning a buffer to
+    // the buffer being queued to the consumer, including the wait for the
+    // shutter notification.
+    const static std::array<int32_t, LATENCY_BIN_COUNT-1> mHalToConsumerLatencyBins;
+    std::array<int64_t, LATENCY_BIN_COUNT> mHalToConsumerLatencyHistogram;
+
     StreamStats() : mRequestedFrameCount(0),
                      mDroppedFrameCount(0),
                      mCounterStopped(false),
                      mStartLatencyMs(0),
-                     mCaptureLatencyHistogram{}
+                     mCaptureLatencyHistogram{},
+                     mHalToConsumerLatencyHistogram{}
                   {}
 
     void updateLatencyHistogram(int32_t latencyMs);
+
+    static void updateHistogram(const std::array<int32_t, LATENCY_BIN_COUNT-1>& bins,
+            std::array<int64_t, LATENCY_BIN_COUNT>* histogram, int32_t latencyMs);
 };
 
 // Helper class to build session stats
@@ -72,13 +83,20 @@ public:
     // Stream specific counter
     void startCounter(int streamId);
     void stopCounter(int streamId);
-    void incCounter(int streamId, bool dropped, int32_t captureLatencyMs);
+    // A negative halToConsumerLatencyMs isn't added to the histogram
+    void incCounter(int streamId, bool dropped, int32_t captureLatencyMs,
+            int32_t halToConsumerLatencyMs = -1);
 
     // Session specific counter
     void stopCounter();
-    void incResultCounter(bool dropped);
+    // resultLatencyMs is the time from the request to its final result
+    // metadata, a negative value isn't added to the histogram
+    void incResultCounter(bool dropped, int32_t resultLatencyMs = -1);
     void onDeviceError();
 
+    // Dumps the latency histograms collected since the last buildAndReset
+    void dump(int fd);
+
     // Session specific statistics
 
     // Limit on size of FPS range histogram
@@ -96,6 +114,9 @@ private:
     bool mDeviceError;
     std::string mUserTag;
 
+    // Histogram of request to result latencies, same bins as the capture latency
+    std::array<int64_t, StreamStats::LATENCY_BIN_COUNT> mResultLatencyHistogram{};
+
     // Histogram of frame counts of requested target FPS ranges
     // (min_fps << 32 | max_fps) -> (# of frames with this fps, last seen framenumber)
     std::unordered_map<uint64_t, std::pair<int64_t, int64_t>> mRequestedFpsRangeHistogram;
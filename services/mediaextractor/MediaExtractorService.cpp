@@ -18,6 +18,11 @@
 //#define LOG_NDEBUG 0
 #include <utils/Log.h>
 
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <tuple>
+
 #include <utils/Vector.h>
 
 #include <datasource/DataSourceFactory.h>
@@ -29,6 +34,24 @@
 
 namespace android {
 
+// How long a parsed extractor is kept for the next open of the same file.
+static const nsecs_t kCachedExtractorTimeoutNs = s2ns(10);
+static const size_t kMaxCachedExtractors = 4;
+
+// Only extractors whose tracks don't share read state can be handed to
+// several clients: each MPEG4Extractor track is a new MPEG4Source over the
+// common sample table, while e.g. MPEG2TSExtractor tracks drain queues
+// shared by the whole extractor.
+static bool isShareable(const sp<IMediaExtractor> &extractor) {
+    return extractor->name() == "MPEG4Extractor";
+}
+
+bool MediaExtractorService::FileKey::operator==(const FileKey &other) const {
+    return std::tie(dev, ino, mtimeNs, size, offset, length)
+            == std::tie(other.dev, other.ino, other.mtimeNs, other.size, other.offset,
+                        other.length);
+}
+
 MediaExtractorService::MediaExtractorService() {
     MediaExtractorFactory::LoadExtractors();
 }
@@ -43,7 +66,43 @@ MediaExtractorService::~MediaExtractorService() {
         ::android::sp<::android::IMediaExtractor>* _aidl_return) {
     ALOGV("@@@ MediaExtractorService::makeExtractor for %s", mime ? mime->c_str() : nullptr);
 
-    sp<DataSource> localSource = CreateDataSourceFromIDataSource(remoteSource);
+    const std::string mimeString = mime ? *mime : "";
+    FileKey key = {};
+    sp<DataSource> localSource;
+    std::vector<CachedExtractor> expired;  // released once unlocked
+    {
+        Mutex::Autolock lock(mLock);
+        const nsecs_t now = systemTime();
+        for (auto it = mCachedExtractors.begin(); it != mCachedExtractors.end();) {
+            if (it->expireNs <= now) {
+                expired.push_back(std::move(*it));
+                it = mCachedExtractors.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (remoteSource != nullptr
+                && findFileDataSource_l(IInterface::asBinder(remoteSource), &key, &localSource)) {
+            for (CachedExtractor &cached : mCachedExtractors) {
+                if (cached.key == key && cached.mime == mimeString) {
+                    ALOGV("extractor service reusing %p (%s)",
+                            cached.extractor.get(), cached.extractor->name().c_str());
+                    cached.expireNs = now + kCachedExtractorTimeoutNs;
+                    registerMediaExtractor(cached.extractor, cached.source,
+                            mime ? mime->c_str() : nullptr);
+                    *_aidl_return = cached.extractor;
+                    return binder::Status::ok();
+                }
+            }
+        }
+    }
+
+    // A data source made by makeIDataSource() is read directly rather than
+    // through binder calls back into this process.
+    const bool fromFile = localSource != nullptr;
+    if (!fromFile) {
+        localSource = CreateDataSourceFromIDataSource(remoteSource);
+    }
 
     MediaBuffer::useSharedMemory();
     sp<IMediaExtractor> extractor = MediaExtractorFactory::CreateFromService(
@@ -56,6 +115,17 @@ MediaExtractorService::~MediaExtractorService() {
 
     if (extractor != nullptr) {
         registerMediaExtractor(extractor, localSource, mime ? mime->c_str() : nullptr);
+        if (fromFile && isShareable(extractor)) {
+            // Parse now, so that the clients sharing the extractor only read what it parsed.
+            extractor->countTracks();
+            Mutex::Autolock lock(mLock);
+            if (mCachedExtractors.size() >= kMaxCachedExtractors) {
+                expired.push_back(std::move(mCachedExtractors.front()));
+                mCachedExtractors.erase(mCachedExtractors.begin());
+            }
+            mCachedExtractors.push_back({key, mimeString, extractor, localSource,
+                    systemTime() + kCachedExtractorTimeoutNs});
+        }
     }
     *_aidl_return = extractor;
     return binder::Status::ok();
@@ -66,11 +136,35 @@ MediaExtractorService::~MediaExtractorService() {
         int64_t offset,
         int64_t length,
         ::android::sp<::android::IDataSource>* _aidl_return) {
+    struct stat st;
+    const bool haveStat = fstat(fd.get(), &st) == 0 && S_ISREG(st.st_mode);
     sp<DataSource> source = DataSourceFactory::getInstance()->CreateFromFd(fd.release(), offset, length);
     *_aidl_return = CreateIDataSourceFromDataSource(source);
+    if (haveStat && *_aidl_return != nullptr) {
+        const FileKey key = {st.st_dev, st.st_ino,
+                (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec,
+                st.st_size, offset, length};
+        Mutex::Autolock lock(mLock);
+        mFileDataSources.erase(std::remove_if(mFileDataSources.begin(), mFileDataSources.end(),
+                [](const FileDataSource &f) { return f.binder.promote() == nullptr; }),
+                mFileDataSources.end());
+        mFileDataSources.push_back({IInterface::asBinder(*_aidl_return), source, key});
+    }
     return binder::Status::ok();
 }
 
+bool MediaExtractorService::findFileDataSource_l(
+        const sp<IBinder> &binder, FileKey *key, sp<DataSource> *source) {
+    for (const FileDataSource &f : mFileDataSources) {
+        if (f.binder.promote() == binder) {
+            *source = f.source.promote();
+            *key = f.key;
+            return *source != nullptr;
+        }
+    }
+    return false;
+}
+
 ::android::binder::Status MediaExtractorService::getSupportedTypes(
         ::std::vector<::std::string>* _aidl_return) {
     *_aidl_return = MediaExtractorFactory::getSupportedTypes();
@@ -17,12 +17,18 @@
 #ifndef ANDROID_MEDIA_EXTRACTOR_SERVICE_H
 #define ANDROID_MEDIA_EXTRACTOR_SERVICE_H
 
+#include <string>
+#include <vector>
+
 #include <binder/BinderService.h>
 #include <android/BnMediaExtractorService.h>
 #include <android/IMediaExtractor.h>
+#include <utils/Timers.h>
 
 namespace android {
 
+class DataSource;
+
 class MediaExtractorService : public BinderService<MediaExtractorService>, public BnMediaExtractorService
 {
 public:
@@ -47,7 +53,42 @@ public:
     virtual status_t dump(int fd, const Vector<String16>& args);
 
 private:
+    // Identity of the file behind an fd, and the range of it a data source covers.
+    struct FileKey {
+        uint64_t dev;
+        uint64_t ino;
+        int64_t mtimeNs;
+        int64_t size;
+        int64_t offset;
+        int64_t length;
+
+        bool operator==(const FileKey &other) const;
+    };
+
+    // A data source made by makeIDataSource(), so that makeExtractor() knows
+    // which file it reads when it is handed back.
+    struct FileDataSource {
+        wp<IBinder> binder;
+        wp<DataSource> source;
+        FileKey key;
+    };
+
+    // An extractor kept for a while after it was made, so that the next
+    // open of the same file (e.g. playback after a thumbnail) reuses the
+    // track metadata and sample tables it already parsed.
+    struct CachedExtractor {
+        FileKey key;
+        std::string mime;
+        sp<IMediaExtractor> extractor;
+        sp<DataSource> source;
+        nsecs_t expireNs;
+    };
+
+    bool findFileDataSource_l(const sp<IBinder> &binder, FileKey *key, sp<DataSource> *source);
+
     Mutex               mLock;
+    std::vector<FileDataSource> mFileDataSources;
+    std::vector<CachedExtractor> mCachedExtractors;
 };
 
 }   // namespace android
@@ -14,7 +14,11 @@
  * limitations under the License.
  */
 
+#include <string>
+#include <vector>
+
 #include <media/MediaMetricsItem.h>
+#include <mediametricsservice/AnalyticsState.h>
 #include <benchmark/benchmark.h>
 
 class MyItem : public android::mediametrics::BaseItem {
@@ -44,4 +48,44 @@ static void BM_SubmitBuffer(benchmark::State& state)
 
 BENCHMARK(BM_SubmitBuffer)->Iterations(4000);   // Adjust magic number until test runs
 
+// Submits Items to an AnalyticsState shared by all threads, as the service binder threads do,
+// each thread on its own keys, with a property set on a key of another thread.
+static void BM_AnalyticsStateSubmit(benchmark::State& state)
+{
+    static android::mediametrics::AnalyticsState analyticsState;
+    constexpr size_t kKeys = 16;
+
+    if (state.thread_index() == 0) {
+        analyticsState.clear();
+    }
+    const std::string prefix = "audio.track." + std::to_string(state.thread_index()) + ".";
+    const std::string remote = "[audio.track." + std::to_string(state.threads() - 1 -
+            state.thread_index()) + ".0]remote";
+    std::vector<std::shared_ptr<android::mediametrics::Item>> items;
+    for (size_t i = 0; i < kKeys; ++i) {
+        items.push_back(std::make_shared<android::mediametrics::Item>(prefix + std::to_string(i)));
+        (*items.back()).set("i32", (int32_t)i)
+                .set("double", (double)i)
+                .set(remote.c_str(), (int32_t)i);
+    }
+
+    size_t i = 0;
+    for (auto _ : state) {
+        // Items are immutable once submitted, so submit a copy with a new timestamp.
+        auto item = std::make_shared<android::mediametrics::Item>(*items[i++ % kKeys]);
+        item->setTimestamp(systemTime(SYSTEM_TIME_REALTIME));
+        benchmark::DoNotOptimize(analyticsState.submit(item, true /* isTrusted */));
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    if (state.thread_index() == 0) {
+        state.counters["time_machine_contended"] =
+                analyticsState.timeMachine().getContentionCount();
+        state.counters["transaction_log_contended"] =
+                analyticsState.transactionLog().getContentionCount();
+    }
+}
+
+BENCHMARK(BM_AnalyticsStateSubmit)->ThreadRange(1, 8)->UseRealTime();
+
 BENCHMARK_MAIN();
@@ -93,7 +93,9 @@ public:
         int32_t ll = lines;
 
         if (ll > 0) {
-            ss << "TransactionLog: gc(" << mTransactionLog.getGarbageCollectionCount() << ")\n";
+            ss << "TransactionLog: gc(" << mTransactionLog.getGarbageCollectionCount()
+                    << ") puts(" << mTransactionLog.getPutCount()
+                    << ") contended(" << mTransactionLog.getContentionCount() << ")\n";
             --ll;
         }
         if (ll > 0) {
@@ -102,7 +104,9 @@ public:
             ll -= l;
         }
         if (ll > 0) {
-            ss << "TimeMachine: gc(" << mTimeMachine.getGarbageCollectionCount() << ")\n";
+            ss << "TimeMachine: gc(" << mTimeMachine.getGarbageCollectionCount()
+                    << ") puts(" << mTimeMachine.getPutCount()
+                    << ") contended(" << mTimeMachine.getContentionCount() << ")\n";
             --ll;
         }
         if (ll > 0) {
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <atomic>
+#include <cstring>
 #include <deque>
 #include <future>
 #include <mutex>
@@ -45,6 +46,11 @@ public:
         return binder::Status::fromStatusT(status);
     }
 
+    binder::Status submitBuffers(const std::vector<uint8_t>& buffers) override {
+        status_t status = submitBuffers((char *)buffers.data(), buffers.size());
+        return binder::Status::fromStatusT(status);
+    }
+
     /**
      * Submits the indicated record to the mediaanalytics service.
      *
@@ -62,6 +68,27 @@ public:
                 ?: submitInternal(item, true /* release */);
     }
 
+    /**
+     * Submits the records of buffers, each starting with its total size.
+     *
+     * \return the first record failure, or BAD_VALUE if the buffers are malformed,
+     *         in which case the records following the malformed one are dropped.
+     */
+    status_t submitBuffers(const char *buffers, size_t length) {
+        status_t status = NO_ERROR;
+        while (length > 0) {
+            uint32_t size;
+            if (length < sizeof(size)) return BAD_VALUE;
+            memcpy(&size, buffers, sizeof(size));
+            if (size < sizeof(size) || size > length) return BAD_VALUE;
+            const status_t itemStatus = submitBuffer(buffers, size);
+            if (status == NO_ERROR) status = itemStatus;
+            buffers += size;
+            length -= size;
+        }
+        return status;
+    }
+
     status_t dump(int fd, const Vector<String16>& args) override;
 
     static constexpr const char * const kServiceName = "media.metrics";
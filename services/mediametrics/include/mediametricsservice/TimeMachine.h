@@ -17,6 +17,7 @@
 #pragma once
 
 #include <any>
+#include <atomic>
 #include <map>
 #include <mutex>
 #include <sstream>
@@ -262,6 +263,8 @@ public:
             std::lock_guard lock2(other.mLock);
             mHistory = other.mHistory;
             mGarbageCollectionCount = other.mGarbageCollectionCount.load();
+            mPutCount = other.mPutCount.load();
+            mContentionCount = other.mContentionCount.load();
         }
 
         // Now that we safely have our own shared pointers, let's dup them
@@ -286,7 +289,8 @@ public:
         std::shared_ptr<KeyHistory> keyHistory;
         {
             std::vector<std::any> garbage;
-            std::lock_guard lock(mLock);
+            lockCounted(mLock);
+            std::lock_guard lock(mLock, std::adopt_lock);
 
             auto it = mHistory.find(key);
             if (it == mHistory.end()) {
@@ -311,7 +315,8 @@ public:
         std::vector<const mediametrics::Item::Prop *> deferred;
         {
             // handle local properties
-            std::lock_guard lock(getLockForKey(key));
+            lockCounted(getLockForKey(key));
+            std::lock_guard lock(getLockForKey(key), std::adopt_lock);
             if (!isTrusted) {
                 status_t status = keyHistory->checkPermission(item->getUid());
                 if (status != NO_ERROR) return status;
@@ -332,24 +337,38 @@ public:
         }
 
         // handle remote properties, if any
+        struct Remote {
+            std::string key;
+            std::string name;
+            const mediametrics::Item::Prop *prop;
+            std::shared_ptr<KeyHistory> keyHistory;
+        };
+        std::vector<Remote> remotes;
         for (const auto propptr : deferred) {
-            const auto &prop = *propptr;
-            const std::string &name = prop.getName();
+            const std::string &name = propptr->getName();
             size_t end = name.find_first_of(']'); // TODO: handle nested [] or escape?
             if (end == 0) continue;
             std::string remoteKey = name.substr(1, end - 1);
             std::string remoteName = name.substr(end + 1);
             if (remoteKey.size() == 0 || remoteName.size() == 0) continue;
-            std::shared_ptr<KeyHistory> remoteKeyHistory;
-            {
-                std::lock_guard lock(mLock);
-                auto it = mHistory.find(remoteKey);
-                if (it == mHistory.end()) continue;
-                remoteKeyHistory = it->second;
+            remotes.push_back({std::move(remoteKey), std::move(remoteName), propptr, {}});
+        }
+        if (!remotes.empty()) {
+            // look up all the remote keys under a single mLock.
+            lockCounted(mLock);
+            std::lock_guard lock(mLock, std::adopt_lock);
+            for (auto &remote : remotes) {
+                auto it = mHistory.find(remote.key);
+                if (it != mHistory.end()) remote.keyHistory = it->second;
             }
-            std::lock_guard lock(getLockForKey(remoteKey));
-            remoteKeyHistory->putProp(remoteName, prop, time);
         }
+        for (const auto &remote : remotes) {
+            if (remote.keyHistory == nullptr) continue;
+            lockCounted(getLockForKey(remote.key));
+            std::lock_guard lock(getLockForKey(remote.key), std::adopt_lock);
+            remote.keyHistory->putProp(remote.name, *remote.prop, time);
+        }
+        ++mPutCount;
         return NO_ERROR;
     }
 
@@ -428,6 +447,8 @@ public:
         std::lock_guard lock(mLock);
         mHistory.clear();
         mGarbageCollectionCount = 0;
+        mPutCount = 0;
+        mContentionCount = 0;
     }
 
     /**
@@ -465,8 +486,30 @@ public:
         return mGarbageCollectionCount;
     }
 
+    /**
+     * Returns the number of Items put in the Time Machine.
+     */
+    size_t getPutCount() const {
+        return mPutCount;
+    }
+
+    /**
+     * Returns the number of times an Item put had to wait for a lock held by another thread.
+     */
+    size_t getContentionCount() const {
+        return mContentionCount;
+    }
+
 private:
 
+    // Locks a mutex, counting whether we had to wait for another thread.
+    void lockCounted(std::mutex &mutex) const ACQUIRE(mutex) {
+        if (!mutex.try_lock()) {
+            ++mContentionCount;
+            mutex.lock();
+        }
+    }
+
     // Obtains the lock for a KeyHistory.
     std::mutex &getLockForKey(const std::string &key) const
             RETURN_CAPABILITY(mPseudoKeyHistoryLock) {
@@ -553,6 +596,8 @@ private:
     const size_t mKeyHighWaterMark = kKeyHighWaterMark;
 
     std::atomic<size_t> mGarbageCollectionCount{};
+    std::atomic<size_t> mPutCount{};
+    mutable std::atomic<size_t> mContentionCount{};
 
     /**
      * Locking Strategy
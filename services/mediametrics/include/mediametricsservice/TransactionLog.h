@@ -17,9 +17,13 @@
 #pragma once
 
 #include <any>
+#include <atomic>
 #include <map>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <tuple>
+#include <vector>
 
 #include <android-base/thread_annotations.h>
 #include <media/MediaMetricsItem.h>
@@ -35,6 +39,9 @@ namespace android::mediametrics {
  *
  * These Views have a cost in shared pointer storage, so they aren't quite free.
  *
+ * The time ordered view is under a single lock, the view by key is sharded
+ * by key hash so that puts of different keys only contend for the former.
+ *
  * The TransactionLog is NOT thread safe.
  */
 class TransactionLog final { // made final as we have copy constructor instead of dup() override.
@@ -74,12 +81,17 @@ public:
     TransactionLog& operator=(const TransactionLog &other) {
         std::lock_guard lock(mLock);
         mLog.clear();
-        mItemMap.clear();
 
         std::lock_guard lock2(other.mLock);
         mLog = other.mLog;
-        mItemMap = other.mItemMap;
+        for (size_t i = 0; i < kItemMapShards; ++i) {
+            std::lock_guard lock3(mItemMapShards[i].mLock);
+            std::lock_guard lock4(other.mItemMapShards[i].mLock);
+            mItemMapShards[i].mItemMap = other.mItemMapShards[i].mItemMap;
+        }
         mGarbageCollectionCount = other.mGarbageCollectionCount.load();
+        mPutCount = other.mPutCount.load();
+        mContentionCount = other.mContentionCount.load();
 
         return *this;
     }
@@ -92,11 +104,25 @@ public:
         const int64_t time = item->getTimestamp();
 
         std::vector<std::any> garbage;  // objects destroyed after lock.
-        std::lock_guard lock(mLock);
-
-        (void)gc(garbage);
-        mLog.emplace_hint(mLog.end(), time, item);
-        mItemMap[key].emplace_hint(mItemMap[key].end(), time, item);
+        int64_t timeToErase = INT64_MIN;
+        {
+            lockCounted(mLock);
+            std::lock_guard lock(mLock, std::adopt_lock);
+            (void)gc(garbage, &timeToErase);
+            mLog.emplace_hint(mLog.end(), time, item);
+        }
+        {
+            ItemMapShard& shard = mItemMapShards[getShardIndex(key)];
+            lockCounted(shard.mLock);
+            std::lock_guard lock(shard.mLock, std::adopt_lock);
+            MapTimeItem& keyHist = shard.mItemMap[key];
+            keyHist.emplace_hint(keyHist.end(), time, item);
+        }
+        // The view by key follows the gc of the time ordered view outside of mLock.
+        if (timeToErase != INT64_MIN) {
+            gcItemMaps(timeToErase, garbage);
+        }
+        ++mPutCount;
         return NO_ERROR;  // no errors for now.
     }
 
@@ -115,9 +141,10 @@ public:
     std::vector<std::shared_ptr<const mediametrics::Item>> get(
             const std::string& key,
             int64_t startTime = 0, int64_t endTime = INT64_MAX) const {
-        std::lock_guard lock(mLock);
-        auto mapIt = mItemMap.find(key);
-        if (mapIt == mItemMap.end()) return {};
+        const ItemMapShard& shard = mItemMapShards[getShardIndex(key)];
+        std::lock_guard lock(shard.mLock);
+        auto mapIt = shard.mItemMap.find(key);
+        if (mapIt == shard.mItemMap.end()) return {};
         return getItemsInRange(mapIt->second, startTime, endTime);
     }
 
@@ -136,14 +163,18 @@ public:
             int32_t lines, int64_t sinceNs, const char *prefix = nullptr) const {
         std::stringstream ss;
         int32_t ll = lines;
-        std::lock_guard lock(mLock);
 
         // All audio items in time order.
         if (ll > 0) {
             ss << "Consolidated:\n";
             --ll;
         }
-        auto [s, l] = dumpMapTimeItem(mLog, ll, sinceNs, prefix);
+        std::string s;
+        int32_t l;
+        {
+            std::lock_guard lock(mLock);
+            std::tie(s, l) = dumpMapTimeItem(mLog, ll, sinceNs, prefix);
+        }
         ss << s;
         ll -= l;
 
@@ -153,9 +184,22 @@ public:
             --ll;
         }
 
-        for (auto it = prefix != nullptr ? mItemMap.lower_bound(prefix) : mItemMap.begin();
-                it != mItemMap.end();
-                ++it) {
+        // Merge the shards to show the keys in order (shallow copy).
+        std::map<std::string /* item_key */, MapTimeItem> itemMap;
+        if (ll > 0) {
+            for (const auto& shard : mItemMapShards) {
+                std::lock_guard lock(shard.mLock);
+                for (auto it = prefix != nullptr
+                        ? shard.mItemMap.lower_bound(prefix) : shard.mItemMap.begin();
+                        it != shard.mItemMap.end();
+                        ++it) {
+                    if (prefix != nullptr && !startsWith(it->first, prefix)) break;
+                    itemMap.emplace(it->first, it->second);
+                }
+            }
+        }
+
+        for (auto it = itemMap.begin(); it != itemMap.end(); ++it) {
             if (ll <= 0) break;
             if (prefix != nullptr && !startsWith(it->first, prefix)) break;
             std::tie(s, l) = dumpMapTimeItem(it->second, ll - 1, sinceNs, prefix);
@@ -181,14 +225,33 @@ public:
     void clear() {
         std::lock_guard lock(mLock);
         mLog.clear();
-        mItemMap.clear();
+        for (auto& shard : mItemMapShards) {
+            std::lock_guard lock2(shard.mLock);
+            shard.mItemMap.clear();
+        }
         mGarbageCollectionCount = 0;
+        mPutCount = 0;
+        mContentionCount = 0;
     }
 
     size_t getGarbageCollectionCount() const {
         return mGarbageCollectionCount;
     }
 
+    /**
+     * Returns the number of Items put in the TransactionLog.
+     */
+    size_t getPutCount() const {
+        return mPutCount;
+    }
+
+    /**
+     * Returns the number of times a put had to wait for a lock held by another thread.
+     */
+    size_t getContentionCount() const {
+        return mContentionCount;
+    }
+
 private:
     using MapTimeItem =
             std::multimap<int64_t /* time */, std::shared_ptr<const mediametrics::Item>>;
@@ -211,15 +274,31 @@ private:
         return { ss.str(), lines - ll };
     }
 
+    // Locks a mutex, counting whether we had to wait for another thread.
+    void lockCounted(std::mutex& mutex) const ACQUIRE(mutex) {
+        if (!mutex.try_lock()) {
+            ++mContentionCount;
+            mutex.lock();
+        }
+    }
+
+    static size_t getShardIndex(const std::string& key) {
+        return std::hash<std::string>{}(key) % kItemMapShards;
+    }
+
     /**
      * Garbage collects if the TimeMachine size exceeds the high water mark.
      *
+     * Only the time ordered view is collected here, the view by key is
+     * collected afterwards by gcItemMaps() with the time returned.
+     *
      * \param garbage a type-erased vector of elements to be destroyed
      *        outside of lock.  Move large items to be destroyed here.
+     * \param timeToEraseOut set to the time before which items were removed.
      *
      * \return true if garbage collection was done.
      */
-    bool gc(std::vector<std::any>& garbage) REQUIRES(mLock) {
+    bool gc(std::vector<std::any>& garbage, int64_t* timeToEraseOut) REQUIRES(mLock) {
         if (mLog.size() < mHighWaterMark) return false;
 
         auto eraseEnd = mLog.begin();
@@ -247,30 +326,45 @@ private:
 
         mLog.erase(mLog.begin(), eraseEnd);  // O(ptr_diff)
 
+        garbage.emplace_back(std::move(stale));
+
+        ALOGD("%s(%zu, %zu): log size:%zu",
+                __func__, mLowWaterMark, mHighWaterMark, mLog.size());
+        ++mGarbageCollectionCount;
+        *timeToEraseOut = timeToErase;
+        return true;
+    }
+
+    /**
+     * Removes the items before timeToErase from the view by key, one shard at a time.
+     */
+    void gcItemMaps(int64_t timeToErase, std::vector<std::any>& garbage) {
+        std::vector<std::shared_ptr<const mediametrics::Item>> stale;
+        size_t itemMapSize = 0;
         size_t itemMapCount = 0;
-        for (auto it = mItemMap.begin(); it != mItemMap.end();) {
-            auto &keyHist = it->second;
-            auto it2 = keyHist.lower_bound(timeToErase);
-            if (it2 == keyHist.end()) {
-                garbage.emplace_back(std::move(keyHist)); // directly move keyhist to garbage
-                it = mItemMap.erase(it);
-            } else {
-                for (auto it3 = keyHist.begin(); it3 != it2; ++it3) {
-                    stale.emplace_back(std::move(it3->second));
+        for (auto& shard : mItemMapShards) {
+            std::lock_guard lock(shard.mLock);
+            for (auto it = shard.mItemMap.begin(); it != shard.mItemMap.end();) {
+                auto &keyHist = it->second;
+                auto it2 = keyHist.lower_bound(timeToErase);
+                if (it2 == keyHist.end()) {
+                    garbage.emplace_back(std::move(keyHist)); // directly move keyhist to garbage
+                    it = shard.mItemMap.erase(it);
+                } else {
+                    for (auto it3 = keyHist.begin(); it3 != it2; ++it3) {
+                        stale.emplace_back(std::move(it3->second));
+                    }
+                    keyHist.erase(keyHist.begin(), it2);
+                    itemMapCount += keyHist.size();
+                    ++it;
                 }
-                keyHist.erase(keyHist.begin(), it2);
-                itemMapCount += keyHist.size();
-                 ++it;
             }
+            itemMapSize += shard.mItemMap.size();
         }
-
         garbage.emplace_back(std::move(stale));
 
-        ALOGD("%s(%zu, %zu): log size:%zu item map size:%zu, item map items:%zu",
-                __func__, mLowWaterMark, mHighWaterMark,
-                mLog.size(), mItemMap.size(), itemMapCount);
-        ++mGarbageCollectionCount;
-        return true;
+        ALOGD("%s(%lld): item map size:%zu, item map items:%zu",
+                __func__, (long long)timeToErase, itemMapSize, itemMapCount);
     }
 
     static std::vector<std::shared_ptr<const mediametrics::Item>> getItemsInRange(
@@ -293,11 +387,21 @@ private:
     const size_t mHighWaterMark = kLogItemsHighWater;
 
     std::atomic<size_t> mGarbageCollectionCount{};
+    std::atomic<size_t> mPutCount{};
+    mutable std::atomic<size_t> mContentionCount{};
 
     mutable std::mutex mLock;
 
     MapTimeItem mLog GUARDED_BY(mLock);
-    std::map<std::string /* item_key */, MapTimeItem> mItemMap GUARDED_BY(mLock);
+
+    // The view by key, sharded by the hash of the key.
+    struct ItemMapShard {
+        mutable std::mutex mLock;
+        std::map<std::string /* item_key */, MapTimeItem> mItemMap GUARDED_BY(mLock);
+    };
+    // It need not be a power of 2, but faster that way.
+    static inline constexpr size_t kItemMapShards = 16;
+    ItemMapShard mItemMapShards[kItemMapShards];
 };
 
 } // namespace android::mediametrics
@@ -333,6 +333,23 @@ bool statsd_codec(const std::shared_ptr<const mediametrics::Item>& item,
     }
     AStatsEvent_writeInt64(event, latencyUnknown);
 
+    // Per-stage latency breakdown (input, codec, output, client, render). The atom has no
+    // fields for these yet, so they are only part of the statsd log below.
+    std::stringstream stageLatency;
+    for (const char *stage : {"input", "codec", "output", "client", "render"}) {
+        const std::string prefix = std::string("android.media.mediacodec.latency.") + stage;
+        int64_t stageMax = -1;
+        int64_t stageAvg = -1;
+        int64_t stageCount = -1;
+        if (item->getInt64((prefix + ".n").c_str(), &stageCount)) {
+            item->getInt64((prefix + ".max").c_str(), &stageMax);
+            item->getInt64((prefix + ".avg").c_str(), &stageAvg);
+            stageLatency << " latency_" << stage << "_max:" << stageMax
+                    << " latency_" << stage << "_avg:" << stageAvg
+                    << " latency_" << stage << "_count:" << stageCount;
+        }
+    }
+
     int32_t queueSecureInputBufferError = -1;
     if (item->getInt32("android.media.mediacodec.queueSecureInputBufferError",
             &queueSecureInputBufferError)) {
@@ -835,6 +852,7 @@ bool statsd_codec(const std::shared_ptr<const mediametrics::Item>& item,
             << " latency_avg:" << latencyAvg
             << " latency_count:" << latencyCount
             << " latency_unknown:" << latencyUnknown
+            << stageLatency.str()
             << " queue_input_buffer_error:" << queueInputBufferError
             << " queue_secure_input_buffer_error:" << queueSecureInputBufferError
             << " bitrate_mode:" << bitrateMode
@@ -268,6 +268,36 @@ TEST(mediametrics_tests, instantiate) {
   mediaMetrics->dump(fileno(stdout), {} /* args */);
 }
 
+TEST(mediametrics_tests, submit_buffers) {
+  sp mediaMetrics = new MediaMetricsService();
+
+  // buffers one after the other, as batched by the client.
+  std::vector<char> buffers;
+  for (const char *key : {"audiotrack", "audiorecord"}) {
+    mediametrics::Item item(key);
+    item.setInt32("foo", 10);
+    char *data;
+    size_t length;
+    ASSERT_EQ(NO_ERROR, item.writeToByteString(&data, &length));
+    buffers.insert(buffers.end(), data, data + length);
+    free(data);
+  }
+  ASSERT_EQ(NO_ERROR, mediaMetrics->submitBuffers(buffers.data(), buffers.size()));
+
+  // record failures and malformed buffers are reported.
+  std::unique_ptr<mediametrics::Item> random_key(mediametrics::Item::create("random_key"));
+  random_key->setInt32("foo", 10);
+  char *data;
+  size_t length;
+  ASSERT_EQ(NO_ERROR, random_key->writeToByteString(&data, &length));
+  std::vector<char> denied(data, data + length);
+  free(data);
+  denied.insert(denied.end(), buffers.begin(), buffers.end());
+  ASSERT_EQ(PERMISSION_DENIED, mediaMetrics->submitBuffers(denied.data(), denied.size()));
+  ASSERT_EQ(BAD_VALUE, mediaMetrics->submitBuffers(buffers.data(), buffers.size() - 1));
+  ASSERT_EQ(NO_ERROR, mediaMetrics->submitBuffers(buffers.data(), 0));
+}
+
 TEST(mediametrics_tests, package_installer_check) {
   ASSERT_EQ(false, MediaMetricsService::useUidForPackage(
       "abcd", "installer"));  // ok, package name has no dot.
@@ -469,6 +499,45 @@ TEST(mediametrics_tests, item_byteserialization) {
   free(data);
 }
 
+TEST(mediametrics_tests, item_byteserialization_dictionary) {
+  // property names in the dictionary are sent as their index.
+  ASSERT_LE(0, mediametrics::BaseItem::getDictionaryIndex(AMEDIAMETRICS_PROP_EVENT));
+  ASSERT_EQ(-1, mediametrics::BaseItem::getDictionaryIndex("notInDictionary"));
+
+  mediametrics::Item item("audio.track.1");
+  item.setCString(AMEDIAMETRICS_PROP_EVENT, AMEDIAMETRICS_PROP_EVENT_VALUE_CREATE)
+      .setInt32(AMEDIAMETRICS_PROP_SAMPLERATE, 48000)
+      .setInt32("notInDictionary", 1);
+
+  char *data;
+  size_t length;
+  ASSERT_EQ(0, item.writeToByteString(&data, &length));
+  mediametrics::Item item2;
+  ASSERT_EQ(NO_ERROR, item2.readFromByteString(data, length));
+  ASSERT_EQ(item, item2);
+
+  // the LogItem hot path as well.
+  mediametrics::LogItem logItem("audio.track.1");
+  logItem.set(AMEDIAMETRICS_PROP_EVENT, AMEDIAMETRICS_PROP_EVENT_VALUE_CREATE)
+      .set(AMEDIAMETRICS_PROP_SAMPLERATE, (int32_t)48000)
+      .set("notInDictionary", (int32_t)1)
+      .setPid(item.getPid())
+      .setUid(item.getUid())
+      .setTimestamp(item.getTimestamp());
+  ASSERT_TRUE(logItem.updateHeader());
+  ASSERT_EQ(length, logItem.getLength());
+  mediametrics::Item item3;
+  ASSERT_EQ(NO_ERROR, item3.readFromByteString(logItem.getBuffer(), logItem.getLength()));
+  ASSERT_EQ(item, item3);
+
+  // version 0 byte strings do not use the dictionary.
+  memset(data + 8, 0, sizeof(uint16_t));
+  mediametrics::Item item4;
+  ASSERT_NE(NO_ERROR, item4.readFromByteString(data, length));
+
+  free(data);
+}
+
 TEST(mediametrics_tests, item_iteration) {
   mediametrics::Item item;
   item.setInt32("i32", 1)
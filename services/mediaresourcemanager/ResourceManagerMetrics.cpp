@@ -815,11 +815,25 @@ static std::string getAppsCodecUsageMetrics(
 }
 
 
+void ResourceManagerMetrics::notifyReclaimDecision(int64_t durationNs) {
+    std::scoped_lock lock(mLock);
+    ++mReclaimDecisionCount;
+    mReclaimDecisionTotalNs += durationNs;
+    mReclaimDecisionMaxNs = std::max(mReclaimDecisionMaxNs, durationNs);
+}
+
 std::string ResourceManagerMetrics::dump() const {
     std::string metricsLog("  Metrics logs:\n");
     metricsLog += getConcurrentInstanceCount(mConcurrentResourceCountMap);
     metricsLog += getAppsPixelCount(mProcessPixelsMap);
     metricsLog += getAppsCodecUsageMetrics(mProcessConcurrentCodecsMap);
+    if (mReclaimDecisionCount > 0) {
+        std::stringstream reclaimDecisions;
+        reclaimDecisions << "    Reclaim Decisions: " << mReclaimDecisionCount
+                         << " Average: " << mReclaimDecisionTotalNs * 1e-6 / mReclaimDecisionCount
+                         << " ms Max: " << mReclaimDecisionMaxNs * 1e-6 << " ms\n";
+        metricsLog += reclaimDecisions.str();
+    }
 
     return std::move(metricsLog);
 }
@@ -163,6 +163,10 @@ public:
                          const std::vector<ClientInfo>& targetClients,
                          bool reclaimed);
 
+    // To be called with the time taken to find the clients to reclaim from,
+    // with the service lock held.
+    void notifyReclaimDecision(int64_t durationNs);
+
     // Add this pid/uid set to monitor for the process termination state.
     void addPid(int pid, uid_t uid = 0);
 
@@ -214,6 +218,11 @@ private:
 
     // Uid Observer to monitor the application termination.
     sp<UidObserver> mUidObserver;
+
+    // Time taken by the reclaim decisions.
+    int64_t mReclaimDecisionCount = 0;
+    int64_t mReclaimDecisionTotalNs = 0;
+    int64_t mReclaimDecisionMaxNs = 0;
 };
 
 } // namespace android
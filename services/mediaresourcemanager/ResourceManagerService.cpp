@@ -19,22 +19,28 @@
 #define LOG_TAG "ResourceManagerService"
 #include <utils/Log.h>
 
+#include <algorithm>
+#include <thread>
+
 #include <android/binder_manager.h>
 #include <android/binder_process.h>
 #include <binder/IPCThreadState.h>
 #include <binder/IServiceManager.h>
+#include <cutils/properties.h>
 #include <cutils/sched_policy.h>
 #include <media/MediaResourcePolicy.h>
 #include <media/stagefright/foundation/ABase.h>
 #include <mediautils/BatteryNotifier.h>
 #include <mediautils/ProcessInfo.h>
 #include <mediautils/SchedulingPolicyService.h>
+#include <utils/Timers.h>
 #include <com_android_media_codec_flags.h>
 
 #include "ResourceManagerMetrics.h"
 #include "ResourceManagerServiceNew.h"
 #include "ResourceObserverService.h"
 #include "ServiceLog.h"
+#include "UidObserver.h"
 
 namespace CodecFeatureFlags = com::android::media::codec::flags;
 
@@ -201,6 +207,10 @@ void ResourceManagerService::instantiate() {
     if (observerService != nullptr) {
         service->setObserverService(observerService);
     }
+
+    if (property_get_bool("media.resource_manager.pre_reclaim", false /* default_value */)) {
+        service->enablePreReclaim();
+    }
     // TODO: mediaserver main() is already starting the thread pool,
     // move this to mediaserver main() when other services in mediaserver
     // are converted to ndk-platform aidl.
@@ -488,6 +498,7 @@ bool ResourceManagerService::getTargetClients(
     int32_t callingPid = clientInfo.pid;
     int64_t clientId = clientInfo.id;
     std::scoped_lock lock{mLock};
+    ProcessPriorityCache::Scope priorityCacheScope(mPriorityCache);
     if (!mProcessInfo->isPidTrusted(callingPid)) {
         pid_t actualCallingPid = IPCThreadState::self()->getCallingPid();
         ALOGW("%s called with untrusted pid %d, using actual calling pid %d", __FUNCTION__,
@@ -603,9 +614,15 @@ Status ResourceManagerService::reclaimResource(const ClientInfoParcel& clientInf
     }
 
     std::vector<ClientInfo> targetClients;
-    if (getTargetClients(clientInfo, resources, targetClients)) {
+    const int64_t decisionStartNs = systemTime();
+    const bool foundTargetClients = getTargetClients(clientInfo, resources, targetClients);
+    mResourceManagerMetrics->notifyReclaimDecision(systemTime() - decisionStartNs);
+    if (foundTargetClients) {
         // Reclaim all the target clients.
         *_aidl_return = reclaimUnconditionallyFrom(targetClients);
+        if (*_aidl_return) {
+            notePreReclaimRequest(clientInfo, resources);
+        }
     } else {
         // No clients to reclaim from.
         ALOGI("%s: There aren't any clients to reclaim from", __func__);
@@ -636,6 +653,91 @@ void ResourceManagerService::pushReclaimAtom(const ClientInfoParcel& clientInfo,
     mResourceManagerMetrics->pushReclaimAtom(clientInfo, priorities, targetClients, reclaimed);
 }
 
+// Only the processes from ProcessList.CACHED_APP_MIN_ADJ are reclaimed from ahead of time,
+// as they aren't visible to the user.
+static constexpr int kPreReclaimMinPriority = 900;
+// The number of uids with a pre-reclaim request.
+static constexpr size_t kMaxPreReclaimRequests = 16;
+
+void ResourceManagerService::enablePreReclaim() {
+    std::weak_ptr<ResourceManagerService> weakService = ref<ResourceManagerService>();
+    sp<UidObserver> uidObserver = sp<UidObserver>::make(mProcessInfo,
+            [](int32_t /* pid */, uid_t /* uid */) {},
+            [weakService](uid_t uid) {
+                if (std::shared_ptr<ResourceManagerService> service = weakService.lock()) {
+                    service->onUidForeground(uid);
+                }
+            });
+    {
+        std::scoped_lock lock{mLock};
+        mForegroundUidObserver = uidObserver;
+    }
+    uidObserver->start();
+}
+
+void ResourceManagerService::notePreReclaimRequest(
+        const ClientInfoParcel& clientInfo,
+        const std::vector<MediaResourceParcel>& resources) {
+    std::scoped_lock lock{mLock};
+    if (mForegroundUidObserver == nullptr
+            || !mProcessInfo->isPidUidTrusted(clientInfo.pid, clientInfo.uid)) {
+        return;
+    }
+    const uid_t uid = clientInfo.uid;
+    if (mPreReclaimRequests.size() >= kMaxPreReclaimRequests
+            && mPreReclaimRequests.find(uid) == mPreReclaimRequests.end()) {
+        // Forget the oldest request.
+        mPreReclaimRequests.erase(std::min_element(
+                mPreReclaimRequests.begin(), mPreReclaimRequests.end(),
+                [](const auto& a, const auto& b) { return a.second.timeNs < b.second.timeNs; }));
+    }
+    mPreReclaimRequests[uid] = {clientInfo, resources, systemTime()};
+}
+
+void ResourceManagerService::onUidForeground(uid_t uid) {
+    PreReclaimRequest request;
+    {
+        std::scoped_lock lock{mLock};
+        auto found = mPreReclaimRequests.find(uid);
+        if (found == mPreReclaimRequests.end()) {
+            return;
+        }
+        request = found->second;
+    }
+
+    // Reclaiming calls into the clients, don't hold up the ActivityManager callbacks.
+    std::weak_ptr<ResourceManagerService> weakService = ref<ResourceManagerService>();
+    std::thread([weakService, request = std::move(request)] {
+        if (std::shared_ptr<ResourceManagerService> service = weakService.lock()) {
+            service->preReclaim(request.clientInfo, request.resources);
+        }
+    }).detach();
+}
+
+void ResourceManagerService::preReclaim(const ClientInfoParcel& clientInfo,
+                                        const std::vector<MediaResourceParcel>& resources) {
+    std::vector<ClientInfo> targetClients;
+    if (!getTargetClients(clientInfo, resources, targetClients)) {
+        return;
+    }
+    {
+        std::scoped_lock lock{mLock};
+        for (const ClientInfo& targetClient : targetClients) {
+            int priority = -1;
+            if (!getPriority_l(targetClient.mPid, &priority)
+                    || priority < kPreReclaimMinPriority) {
+                // Leave it to the reclaim upon request.
+                return;
+            }
+        }
+    }
+
+    String8 log = String8::format("preReclaim(callingPid %d, uid %d resources %s)",
+            clientInfo.pid, clientInfo.uid, getString(resources).c_str());
+    mServiceLog->add(log);
+    reclaimUnconditionallyFrom(targetClients);
+}
+
 std::shared_ptr<IResourceManagerClient> ResourceManagerService::getClient_l(
         int pid, const int64_t& clientId) const {
     std::map<int, ResourceInfos>::const_iterator found = mMap.find(pid);
@@ -910,16 +1012,18 @@ Status ResourceManagerService::reclaimResourcesFromClientsPendingRemoval(int32_t
 }
 
 bool ResourceManagerService::getPriority_l(int pid, int* priority) const {
-    int newPid = pid;
-
-    std::map<int, int>::const_iterator found = mOverridePidMap.find(pid);
-    if (found != mOverridePidMap.end()) {
-        newPid = found->second;
-        ALOGD("getPriority_l: use override pid %d instead original pid %d",
-                newPid, pid);
-    }
+    return mPriorityCache.getPriority(pid, priority, [this](int pid, int* priority) {
+        int newPid = pid;
+
+        std::map<int, int>::const_iterator found = mOverridePidMap.find(pid);
+        if (found != mOverridePidMap.end()) {
+            newPid = found->second;
+            ALOGD("getPriority_l: use override pid %d instead original pid %d",
+                    newPid, pid);
+        }
 
-    return mProcessInfo->getPriority(newPid, priority);
+        return mProcessInfo->getPriority(newPid, priority);
+    });
 }
 
 bool ResourceManagerService::getAllClients_l(
@@ -38,6 +38,7 @@ class ResourceObserverService;
 class ServiceLog;
 struct ProcessInfoInterface;
 class ResourceManagerMetrics;
+class UidObserver;
 
 using Status = ::ndk::ScopedAStatus;
 using ::aidl::android::media::IResourceManagerClient;
@@ -162,6 +163,17 @@ private:
     // Remove the override info for the given process
     void removeProcessInfoOverride_l(int pid);
 
+    // Pre-reclaim: when an application that had to reclaim resources becomes
+    // the top application again, the same resources are reclaimed ahead of its
+    // request, from the cached processes only.
+    void enablePreReclaim();
+    // Remembers a successful reclaim request, for when its uid becomes the top uid.
+    void notePreReclaimRequest(const ClientInfoParcel& clientInfo,
+                               const std::vector<MediaResourceParcel>& resources);
+    void onUidForeground(uid_t uid);
+    void preReclaim(const ClientInfoParcel& clientInfo,
+                    const std::vector<MediaResourceParcel>& resources);
+
     // Eventually we want to phase out this implementation of IResourceManagerService
     // (ResourceManagerService) and replace that with the newer implementation
     // (ResourceManagerServiceNew).
@@ -258,6 +270,17 @@ private:
     };
     std::map<int, int> mOverridePidMap;
     std::map<pid_t, ProcessInfoOverride> mProcessInfoOverrideMap;
+    // Priorities of the processes during a reclaim decision.
+    mutable ProcessPriorityCache mPriorityCache;
+    // The last reclaim request of each uid, when pre-reclaim is enabled.
+    struct PreReclaimRequest {
+        ClientInfoParcel clientInfo;
+        std::vector<MediaResourceParcel> resources;
+        int64_t timeNs = 0;
+    };
+    std::map<uid_t, PreReclaimRequest> mPreReclaimRequests;
+    // Non null when pre-reclaim is enabled.
+    sp<UidObserver> mForegroundUidObserver;
     std::shared_ptr<ResourceObserverService> mObserverService;
     std::unique_ptr<ResourceManagerMetrics> mResourceManagerMetrics;
 };
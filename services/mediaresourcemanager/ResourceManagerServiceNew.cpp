@@ -238,6 +238,7 @@ bool ResourceManagerServiceNew::getTargetClients(
         std::vector<ClientInfo>& targetClients) {
     int32_t callingPid = clientInfo.pid;
     std::scoped_lock lock{mLock};
+    ProcessPriorityCache::Scope priorityCacheScope(mResourceTracker->getPriorityCache());
     if (!mProcessInfo->isPidTrusted(callingPid)) {
         pid_t actualCallingPid = IPCThreadState::self()->getCallingPid();
         ALOGW("%s called with untrusted pid %d, using actual calling pid %d", __FUNCTION__,
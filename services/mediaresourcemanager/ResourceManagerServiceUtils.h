@@ -18,9 +18,12 @@
 #ifndef ANDROID_MEDIA_RESOURCEMANAGERSERVICEUTILS_H_
 #define ANDROID_MEDIA_RESOURCEMANAGERSERVICEUTILS_H_
 
+#include <atomic>
 #include <map>
+#include <optional>
 #include <set>
 #include <memory>
+#include <thread>
 #include <vector>
 
 #include <aidl/android/media/BnResourceManagerService.h>
@@ -214,6 +217,56 @@ typedef std::map<int64_t, ResourceInfo> ResourceInfos;
 // Map of Resource information indexed through the process id.
 typedef std::map<int, ResourceInfos> PidResourceInfosMap;
 
+/*
+ * Cache of the process priorities (oom scores) while a reclaim decision is made.
+ *
+ * Each ProcessInfo::getPriority() is a binder call, and a decision looks up
+ * the priority of the same processes for each of their clients and each pass.
+ * The cache is only used by the thread that made the Scope, so that
+ * the lookups made outside of a decision (such as dump) are unchanged.
+ */
+class ProcessPriorityCache {
+public:
+    // Caches the priorities until it goes out of scope.
+    class Scope {
+    public:
+        explicit Scope(ProcessPriorityCache& cache) : mCache(cache) {
+            mCache.mOwner = std::this_thread::get_id();
+        }
+        ~Scope() {
+            mCache.mOwner = std::thread::id{};
+            mCache.mPriorities.clear();
+        }
+    private:
+        ProcessPriorityCache& mCache;
+    };
+
+    // Returns the cached priority of pid, or gets it with getPriority(pid, priority).
+    template <typename GetPriority>
+    bool getPriority(int pid, int* priority, GetPriority&& getPriority) {
+        if (mOwner != std::this_thread::get_id()) {
+            return getPriority(pid, priority);
+        }
+        auto [it, inserted] = mPriorities.try_emplace(pid);
+        if (inserted) {
+            int newPriority = -1;
+            if (getPriority(pid, &newPriority)) {
+                it->second = newPriority;
+            }
+        }
+        if (!it->second.has_value()) {
+            return false;
+        }
+        *priority = *it->second;
+        return true;
+    }
+
+private:
+    std::atomic<std::thread::id> mOwner{};
+    // Only accessed by mOwner, std::nullopt if the priority couldn't be found.
+    std::map<int, std::optional<int>> mPriorities;
+};
+
 // templated function to stringify the given vector of items.
 template <typename T>
 String8 getString(const std::vector<T>& items) {
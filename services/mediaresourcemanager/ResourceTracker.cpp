@@ -699,14 +699,16 @@ void ResourceTracker::onLastRemoved(const MediaResourceParcel& resource, uid_t u
 }
 
 bool ResourceTracker::getPriority(int pid, int* priority) {
-    int newPid = pid;
+    return mPriorityCache.getPriority(pid, priority, [this](int pid, int* priority) {
+        int newPid = pid;
 
-    if (mOverridePidMap.find(pid) != mOverridePidMap.end()) {
-        newPid = mOverridePidMap[pid];
-        ALOGD("%s: use override pid %d instead original pid %d", __func__, newPid, pid);
-    }
+        if (mOverridePidMap.find(pid) != mOverridePidMap.end()) {
+            newPid = mOverridePidMap[pid];
+            ALOGD("getPriority: use override pid %d instead original pid %d", newPid, pid);
+        }
 
-    return mProcessInfo->getPriority(newPid, priority);
+        return mProcessInfo->getPriority(newPid, priority);
+    });
 }
 
 bool ResourceTracker::getNonConflictingClients(const ResourceRequestInfo& resourceRequestInfo,
@@ -195,6 +195,11 @@ public:
     // return false.
     bool getPriority(int pid, int* priority);
 
+    // The cache for getPriority(), to be scoped to a reclaim decision.
+    ProcessPriorityCache& getPriorityCache() {
+        return mPriorityCache;
+    }
+
     // Check if the given resource request has conflicting clients.
     // The resource conflict is defined by the ResourceModel (such as
     // co-existence of secure codec with another secure or non-secure codec).
@@ -249,6 +254,8 @@ private:
     std::map<pid_t, ProcessInfoOverride> mProcessInfoOverrideMap;
     // Interface that gets process specific information.
     sp<ProcessInfoInterface> mProcessInfo;
+    // Priorities of the processes during a reclaim decision.
+    ProcessPriorityCache mPriorityCache;
 };
 
 } // namespace android
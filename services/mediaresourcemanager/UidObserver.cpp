@@ -29,9 +29,11 @@ const char* kActivityServiceName = "activity";
 namespace android {
 
 UidObserver::UidObserver(const sp<ProcessInfoInterface>& processInfo,
-                         OnProcessTerminated onProcessTerminated) :
+                         OnProcessTerminated onProcessTerminated,
+                         OnUidForeground onUidForeground) :
      mRegistered(false),
      mOnProcessTerminated(std::move(onProcessTerminated)),
+     mOnUidForeground(std::move(onUidForeground)),
      mProcessInfo(processInfo) {
 }
 
@@ -88,10 +90,19 @@ void UidObserver::registerWithActivityManager() {
         return;
     }
     status_t res = mAm.linkToDeath(this);
-    // Register for UID gone.
-    mAm.registerUidObserver(this, ActivityManager::UID_OBSERVER_GONE,
-                            ActivityManager::PROCESS_STATE_UNKNOWN,
-                            String16("mediaserver"));
+    if (mOnUidForeground) {
+        // Register for UID gone, and the process state changes to and from top.
+        mAm.registerUidObserver(this,
+                                ActivityManager::UID_OBSERVER_GONE
+                                        | ActivityManager::UID_OBSERVER_PROCSTATE,
+                                ActivityManager::PROCESS_STATE_TOP,
+                                String16("mediaserver"));
+    } else {
+        // Register for UID gone.
+        mAm.registerUidObserver(this, ActivityManager::UID_OBSERVER_GONE,
+                                ActivityManager::PROCESS_STATE_UNKNOWN,
+                                String16("mediaserver"));
+    }
     if (res == OK) {
         mRegistered = true;
         ALOGV("UidObserver: Registered with ActivityManager");
@@ -164,10 +175,13 @@ void UidObserver::onUidActive(uid_t /*uid*/) {
 void UidObserver::onUidIdle(uid_t /*uid*/, bool /*disabled*/) {
 }
 
-void UidObserver::onUidStateChanged(uid_t /*uid*/,
-                                    int32_t /*procState*/,
+void UidObserver::onUidStateChanged(uid_t uid,
+                                    int32_t procState,
                                     int64_t /*procStateSeq*/,
                                     int32_t /*capability*/) {
+    if (mOnUidForeground && procState == ActivityManager::PROCESS_STATE_TOP) {
+        mOnUidForeground(uid);
+    }
 }
 
 void UidObserver::onUidProcAdjChanged(uid_t /*uid*/, int32_t /*adj*/) {
@@ -29,6 +29,7 @@
 namespace android {
 
 using OnProcessTerminated = std::function<void(int32_t pid, uid_t)>;
+using OnUidForeground = std::function<void(uid_t)>;
 
 struct ProcessInfoInterface;
 
@@ -40,6 +41,7 @@ struct ProcessInfoInterface;
 //
 // It uses ActivityManager get notification on when an UID is not existent
 // anymore.
+// Optionally, it also notifies when an UID becomes the top (foreground) UID.
 // Since one UID could have multiple PIDs, it uses ActivityManager
 // (through ProcessInfoInterface) to query for the process/application
 // state for the pids.
@@ -50,7 +52,8 @@ class UidObserver :
         public virtual IServiceManager::LocalRegistrationCallback {
 public:
     explicit UidObserver(const sp<ProcessInfoInterface>& processInfo,
-                         OnProcessTerminated onProcessTerminated);
+                         OnProcessTerminated onProcessTerminated,
+                         OnUidForeground onUidForeground = nullptr);
     virtual ~UidObserver();
 
     // Start registration (with Application Manager)
@@ -108,6 +111,7 @@ private:
     // as one UID could have multiple PIDs.
     std::map<uid_t, std::set<int32_t>> mUids;
     OnProcessTerminated mOnProcessTerminated;
+    OnUidForeground mOnUidForeground;
     sp<ProcessInfoInterface> mProcessInfo;
 };
 
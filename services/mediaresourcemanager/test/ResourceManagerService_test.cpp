@@ -1829,6 +1829,35 @@ public:
         // aren't any lower priority clients or lower priority processes.
         EXPECT_FALSE(doReclaimResource(lowPriPidClientInfos[0]));
     }
+
+    void testPreReclaim() {
+        addResource();
+        ClientInfoParcel highPriorityClient{.pid = static_cast<int32_t>(kHighPriorityPid),
+                                            .uid = static_cast<int32_t>(kTestUid2),
+                                            .id = 0,
+                                            .name = "none"};
+
+        // The clients holding the resources aren't cached, nothing is reclaimed.
+        std::vector<MediaResourceParcel> resources{
+                MediaResource(MediaResource::Type::kNonSecureCodec, 1)};
+        mService->preReclaim(highPriorityClient, resources);
+        EXPECT_FALSE(toTestClient(mTestClient1)->checkIfReclaimedAndReset());
+        EXPECT_FALSE(toTestClient(mTestClient2)->checkIfReclaimedAndReset());
+        EXPECT_FALSE(toTestClient(mTestClient3)->checkIfReclaimedAndReset());
+
+        // The priority is the pid in the tests, this one is a cached process.
+        const int kCachedPid = 950;
+        std::shared_ptr<IResourceManagerClient> cachedClient =
+                ::ndk::SharedRefBase::make<TestClient>(kCachedPid, kTestUid1, 0, mService);
+        ClientInfoParcel cachedClientInfo{.pid = static_cast<int32_t>(kCachedPid),
+                                          .uid = static_cast<int32_t>(kTestUid1),
+                                          .id = getId(cachedClient),
+                                          .name = "none"};
+        mService->addResource(cachedClientInfo, cachedClient, resources);
+        mService->preReclaim(highPriorityClient, resources);
+        EXPECT_TRUE(toTestClient(cachedClient)->checkIfReclaimedAndReset());
+        EXPECT_FALSE(toTestClient(mTestClient2)->checkIfReclaimedAndReset());
+    }
 };
 
 class ResourceManagerServiceNewTest : public ResourceManagerServiceTest {
@@ -1926,6 +1955,10 @@ TEST_F(ResourceManagerServiceTest, concurrentCodecs) {
     testConcurrentCodecs();
 }
 
+TEST_F(ResourceManagerServiceTest, preReclaim) {
+    testPreReclaim();
+}
+
 /////// test cases for ResourceManagerServiceNew ////
 TEST_F(ResourceManagerServiceNewTest, config) {
     testConfig();
@@ -2021,4 +2054,46 @@ TEST_F(ResourceManagerServiceNewTest, reclaimPolicies) {
     testReclaimPolicies();
 }
 
+TEST(ProcessPriorityCacheTest, cachesPrioritiesInScope) {
+    ProcessPriorityCache cache;
+    int queries = 0;
+    auto getPriority = [&queries](int pid, int* priority) {
+        ++queries;
+        if (pid < 0) return false;
+        *priority = pid;
+        return true;
+    };
+
+    int priority = -1;
+    EXPECT_TRUE(cache.getPriority(10, &priority, getPriority));
+    EXPECT_TRUE(cache.getPriority(10, &priority, getPriority));
+    EXPECT_EQ(10, priority);
+    EXPECT_EQ(2, queries);  // not cached out of scope
+
+    queries = 0;
+    {
+        ProcessPriorityCache::Scope scope(cache);
+        for (int i = 0; i < 3; ++i) {
+            EXPECT_TRUE(cache.getPriority(20, &priority, getPriority));
+            EXPECT_EQ(20, priority);
+            EXPECT_FALSE(cache.getPriority(-1, &priority, getPriority));
+        }
+        EXPECT_EQ(2, queries);
+
+        // other threads aren't using the cache.
+        std::thread([&] {
+            EXPECT_TRUE(cache.getPriority(20, &priority, getPriority));
+        }).join();
+        EXPECT_EQ(3, queries);
+    }
+
+    // the cache is cleared at the end of the scope.
+    queries = 0;
+    {
+        ProcessPriorityCache::Scope scope(cache);
+        EXPECT_TRUE(cache.getPriority(20, &priority, getPriority));
+    }
+    EXPECT_EQ(1, queries);
+}
+
 } // namespace android
@@ -17,14 +17,21 @@
 #define LOG_TAG "AAudioCommandQueue"
 //#define LOG_NDEBUG 0
 
+#include <algorithm>
 #include <chrono>
+#include <sstream>
 
 #include <utils/Log.h>
 
+#include "utility/AudioClock.h"
 #include "AAudioCommandQueue.h"
 
 namespace aaudio {
 
+std::mutex AAudioCommandQueue::sWaitTimeLock;
+AAudioCommandQueue::WaitTimeStats
+        AAudioCommandQueue::sWaitTimeStats[AAUDIO_COMMAND_LANE_COUNT];
+
 aaudio_result_t AAudioCommandQueue::sendCommand(const std::shared_ptr<AAudioCommand>& command) {
     {
         std::scoped_lock<std::mutex> _l(mLock);
@@ -32,7 +39,8 @@ aaudio_result_t AAudioCommandQueue::sendCommand(const std::shared_ptr<AAudioComm
             ALOGE("Tried to send command while it was not running");
             return AAUDIO_ERROR_INVALID_STATE;
         }
-        mCommands.push(command);
+        command->sendTime = std::chrono::steady_clock::now();
+        mCommands[command->lane].push(command);
         mWaitWorkCond.notify_one();
     }
 
@@ -64,22 +72,67 @@ std::shared_ptr<AAudioCommand> AAudioCommandQueue::waitForCommand(int64_t timeou
         if (timeoutNanos >= 0) {
             mWaitWorkCond.wait_for(_l, std::chrono::nanoseconds(timeoutNanos), [this]() {
                 android::base::ScopedLockAssertion lockAssertion(mLock);
-                return !mRunning || !mCommands.empty();
+                return !mRunning || !isEmpty_l();
             });
         } else {
             mWaitWorkCond.wait(_l, [this]() {
                 android::base::ScopedLockAssertion lockAssertion(mLock);
-                return !mRunning || !mCommands.empty();
+                return !mRunning || !isEmpty_l();
             });
         }
-        if (!mCommands.empty() && mRunning) {
-            command = mCommands.front();
-            mCommands.pop();
+        if (mRunning) {
+            for (int lane = AAUDIO_COMMAND_LANE_COUNT - 1; lane >= 0; --lane) {
+                if (!mCommands[lane].empty()) {
+                    command = mCommands[lane].front();
+                    mCommands[lane].pop();
+                    break;
+                }
+            }
         }
     }
+    if (command != nullptr) {
+        recordWaitTime(command->lane, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - command->sendTime).count());
+    }
     return command;
 }
 
+bool AAudioCommandQueue::isEmpty_l() const {
+    for (const auto& commands : mCommands) {
+        if (!commands.empty()) return false;
+    }
+    return true;
+}
+
+void AAudioCommandQueue::recordWaitTime(aaudio_command_lane lane, int64_t waitNanos) {
+    std::scoped_lock<std::mutex> _l(sWaitTimeLock);
+    WaitTimeStats& stats = sWaitTimeStats[lane];
+    stats.histogramMicros.add(static_cast<int32_t>(waitNanos / AAUDIO_NANOS_PER_MICROSECOND));
+    stats.count++;
+    stats.totalNanos += waitNanos;
+    stats.maxNanos = std::max(stats.maxNanos, waitNanos);
+}
+
+std::string AAudioCommandQueue::dumpWaitTimes() {
+    static const char* const kLaneNames[AAUDIO_COMMAND_LANE_COUNT] = { "normal", "priority" };
+    std::stringstream result;
+    std::scoped_lock<std::mutex> _l(sWaitTimeLock);
+    result << "Command queue wait times, " << kWaitHistogramBinWidthMicros
+           << " usec per bin:\n";
+    for (int lane = 0; lane < AAUDIO_COMMAND_LANE_COUNT; lane++) {
+        const WaitTimeStats& stats = sWaitTimeStats[lane];
+        result << "  " << kLaneNames[lane] << ": count = " << stats.count;
+        if (stats.count > 0) {
+            result << ", mean = " << (stats.totalNanos / stats.count / AAUDIO_NANOS_PER_MICROSECOND)
+                   << " usec, max = " << (stats.maxNanos / AAUDIO_NANOS_PER_MICROSECOND)
+                   << " usec\n";
+            result << "    " << stats.histogramMicros.dump();
+        }
+        result << "\n";
+    }
+    return result.str();
+}
+
 void AAudioCommandQueue::startWaiting() {
     std::scoped_lock<std::mutex> _l(mLock);
     mRunning = true;
@@ -89,16 +142,18 @@ void AAudioCommandQueue::stopWaiting() {
     std::scoped_lock<std::mutex> _l(mLock);
     mRunning = false;
     // Clear all commands in the queue as the command thread is stopped.
-    while (!mCommands.empty()) {
-        auto command = mCommands.front();
-        mCommands.pop();
-        std::scoped_lock<std::mutex> _cl(command->lock);
-        // If the command is waiting for result, returns AAUDIO_ERROR_INVALID_STATE
-        // as there is no thread waiting for the command.
-        if (command->isWaitingForReply) {
-            command->result = AAUDIO_ERROR_INVALID_STATE;
-            command->isWaitingForReply = false;
-            command->conditionVariable.notify_one();
+    for (auto& commands : mCommands) {
+        while (!commands.empty()) {
+            auto command = commands.front();
+            commands.pop();
+            std::scoped_lock<std::mutex> _cl(command->lock);
+            // If the command is waiting for result, returns AAUDIO_ERROR_INVALID_STATE
+            // as there is no thread waiting for the command.
+            if (command->isWaitingForReply) {
+                command->result = AAUDIO_ERROR_INVALID_STATE;
+                command->isWaitingForReply = false;
+                command->conditionVariable.notify_one();
+            }
         }
     }
     mWaitWorkCond.notify_one();
@@ -16,18 +16,31 @@
 
 #pragma once
 
+#include <chrono>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <string>
 
 #include <aaudio/AAudio.h>
 #include <android-base/thread_annotations.h>
+#include <audio_utils/Histogram.h>
 
 namespace aaudio {
 
 using aaudio_command_opcode = int32_t;
 
+/**
+ * Commands in the priority lane are executed before any command waiting in the normal lane.
+ * Commands within one lane are executed in the order they were sent.
+ */
+enum aaudio_command_lane : int32_t {
+    AAUDIO_COMMAND_LANE_NORMAL = 0,
+    AAUDIO_COMMAND_LANE_PRIORITY,
+    AAUDIO_COMMAND_LANE_COUNT,
+};
+
 class AAudioCommandParam {
 public:
     AAudioCommandParam() = default;
@@ -38,9 +51,10 @@ class AAudioCommand {
 public:
     explicit AAudioCommand(
             aaudio_command_opcode opCode, std::shared_ptr<AAudioCommandParam> param = nullptr,
-            bool waitForReply = false, int64_t timeoutNanos = 0)
+            bool waitForReply = false, int64_t timeoutNanos = 0,
+            aaudio_command_lane commandLane = AAUDIO_COMMAND_LANE_NORMAL)
             : operationCode(opCode), parameter(std::move(param)), isWaitingForReply(waitForReply),
-              timeoutNanoseconds(timeoutNanos) { }
+              timeoutNanoseconds(timeoutNanos), lane(commandLane) { }
     virtual ~AAudioCommand() = default;
 
     std::mutex lock;
@@ -50,7 +64,10 @@ public:
     std::shared_ptr<AAudioCommandParam> parameter;
     bool isWaitingForReply GUARDED_BY(lock);
     const int64_t timeoutNanoseconds;
+    const aaudio_command_lane lane;
     aaudio_result_t result GUARDED_BY(lock) = AAUDIO_OK;
+    // Set by the queue when the command is pushed, used to measure the queue wait time.
+    std::chrono::steady_clock::time_point sendTime;
 };
 
 class AAudioCommandQueue {
@@ -70,6 +87,7 @@ public:
 
     /**
      * Wait for next available command OR until the timeout is expired.
+     * A command in the priority lane is returned before any command in the normal lane.
      *
      * @param timeoutNanos the maximum time to wait for next command (0 means return immediately in
      *                     any case), negative to wait forever.
@@ -88,12 +106,36 @@ public:
      */
     void stopWaiting();
 
+    /**
+     * @return histograms of the time commands waited in each lane before being executed,
+     *         accumulated over all the command queues of the service. Does not include EOL.
+     */
+    static std::string dumpWaitTimes();
+
 private:
+    bool isEmpty_l() const REQUIRES(mLock);
+
+    static void recordWaitTime(aaudio_command_lane lane, int64_t waitNanos);
+
     std::mutex mLock;
     std::condition_variable mWaitWorkCond;
 
-    std::queue<std::shared_ptr<AAudioCommand>> mCommands GUARDED_BY(mLock);
+    std::queue<std::shared_ptr<AAudioCommand>> mCommands[AAUDIO_COMMAND_LANE_COUNT]
+            GUARDED_BY(mLock);
     bool mRunning GUARDED_BY(mLock) = false;
+
+    static constexpr int32_t kWaitHistogramBinWidthMicros = 500;
+    static constexpr int32_t kWaitHistogramBinCount       = 64;
+
+    struct WaitTimeStats {
+        WaitTimeStats() : histogramMicros(kWaitHistogramBinCount, kWaitHistogramBinWidthMicros) {}
+        android::audio_utils::Histogram histogramMicros;
+        int64_t count = 0;
+        int64_t maxNanos = 0;
+        int64_t totalNanos = 0;
+    };
+    static std::mutex sWaitTimeLock;
+    static WaitTimeStats sWaitTimeStats[AAUDIO_COMMAND_LANE_COUNT] GUARDED_BY(sWaitTimeLock);
 };
 
 } // namespace aaudio
\ No newline at end of file
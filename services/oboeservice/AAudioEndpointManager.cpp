@@ -19,11 +19,14 @@
 #include <utils/Log.h>
 
 #include <assert.h>
+#include <chrono>
 #include <functional>
+#include <limits>
 #include <map>
 #include <mutex>
 #include <sstream>
 #include <utility/AAudioUtilities.h>
+#include <utility/AudioClock.h>
 #include <media/AidlConversion.h>
 
 #include "AAudioClientTracker.h"
@@ -41,7 +44,24 @@ ANDROID_SINGLETON_STATIC_INSTANCE(AAudioEndpointManager);
 AAudioEndpointManager::AAudioEndpointManager()
         : Singleton<AAudioEndpointManager>()
         , mSharedStreams()
-        , mExclusiveStreams() {
+        , mExclusiveStreams()
+        , mLingerNanos(AAudioProperty_getEndpointLingerMillis() * AAUDIO_NANOS_PER_MILLISECOND) {
+    if (mLingerNanos > 0) {
+        ALOGD("%s() endpoints linger for %lld msec", __func__,
+              (long long) (mLingerNanos / AAUDIO_NANOS_PER_MILLISECOND));
+        mLingerThread.start(this);
+    }
+}
+
+AAudioEndpointManager::~AAudioEndpointManager() {
+    if (mLingerNanos > 0) {
+        {
+            std::lock_guard<std::mutex> lock(mLingerLock);
+            mLingerThreadExit = true;
+        }
+        mLingerCondition.notify_one();
+        mLingerThread.stop();
+    }
 }
 
 std::string AAudioEndpointManager::dump() const NO_THREAD_SAFETY_ANALYSIS {
@@ -79,6 +99,12 @@ std::string AAudioEndpointManager::dump() const NO_THREAD_SAFETY_ANALYSIS {
         result << "  ExclusiveOpenCount:    " << mExclusiveOpenCount << "\n";
         result << "  ExclusiveCloseCount:   " << mExclusiveCloseCount << "\n";
         result << "  ExclusiveStolenCount:  " << mExclusiveStolenCount << "\n";
+        if (mLingerNanos > 0) {
+            result << "  ExclusiveLingering:    " << mLingeringExclusiveStreams.size() << "\n";
+            result << "  ExclusiveLingerHit:    " << mExclusiveLingerHitCount << "\n";
+            result << "  ExclusiveLingerMiss:   " << mExclusiveLingerMissCount << "\n";
+            result << "  ExclusiveLingerExpired: " << mExclusiveLingerExpiredCount << "\n";
+        }
         result << "\n";
 
         if (isExclusiveLocked) {
@@ -97,6 +123,12 @@ std::string AAudioEndpointManager::dump() const NO_THREAD_SAFETY_ANALYSIS {
     result << "  SharedFoundCount:      " << mSharedFoundCount << "\n";
     result << "  SharedOpenCount:       " << mSharedOpenCount << "\n";
     result << "  SharedCloseCount:      " << mSharedCloseCount << "\n";
+    if (mLingerNanos > 0) {
+        result << "  SharedLingering:       " << mLingeringSharedStreams.size() << "\n";
+        result << "  SharedLingerHit:       " << mSharedLingerHitCount << "\n";
+        result << "  SharedLingerMiss:      " << mSharedLingerMissCount << "\n";
+        result << "  SharedLingerExpired:   " << mSharedLingerExpiredCount << "\n";
+    }
     result << "\n";
 
     if (isSharedLocked) {
@@ -142,9 +174,132 @@ sp<AAudioServiceEndpointShared> AAudioEndpointManager::findSharedEndpoint_l(
     return endpoint;
 }
 
+sp<AAudioServiceEndpointMMAP> AAudioEndpointManager::reuseLingeringExclusiveEndpoint_l(
+        const AAudioStreamConfiguration &configuration) {
+    sp<AAudioServiceEndpointMMAP> endpoint;
+    for (auto it = mLingeringExclusiveStreams.begin(); it != mLingeringExclusiveStreams.end();) {
+        if (!it->endpoint->isConnected()) {
+            it->endpoint->close();
+            mExclusiveCloseCount++;
+            it = mLingeringExclusiveStreams.erase(it);
+        } else if (endpoint == nullptr && it->endpoint->matches(configuration)) {
+            endpoint = it->endpoint;
+            it = mLingeringExclusiveStreams.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return endpoint;
+}
+
+sp<AAudioServiceEndpointShared> AAudioEndpointManager::reuseLingeringSharedEndpoint_l(
+        const AAudioStreamConfiguration &configuration) {
+    sp<AAudioServiceEndpointShared> endpoint;
+    for (auto it = mLingeringSharedStreams.begin(); it != mLingeringSharedStreams.end();) {
+        if (!it->endpoint->isConnected()) {
+            it->endpoint->close();
+            mSharedCloseCount++;
+            it = mLingeringSharedStreams.erase(it);
+        } else if (endpoint == nullptr && it->endpoint->matches(configuration)) {
+            endpoint = it->endpoint;
+            it = mLingeringSharedStreams.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return endpoint;
+}
+
+void AAudioEndpointManager::closeLingeringExclusiveEndpoints_l() {
+    for (const auto& lingering : mLingeringExclusiveStreams) {
+        lingering.endpoint->close();
+        mExclusiveCloseCount++;
+    }
+    mLingeringExclusiveStreams.clear();
+}
+
+void AAudioEndpointManager::closeLingeringSharedEndpoints() {
+    const std::lock_guard<std::mutex> lock(mSharedLock);
+    for (const auto& lingering : mLingeringSharedStreams) {
+        lingering.endpoint->close();
+        mSharedCloseCount++;
+    }
+    mLingeringSharedStreams.clear();
+}
+
+int64_t AAudioEndpointManager::closeExpiredEndpoints() {
+    int64_t nextExpiryNanos = std::numeric_limits<int64_t>::max();
+    {
+        const std::lock_guard<std::mutex> lock(mSharedLock);
+        const int64_t nowNanos = AudioClock::getNanoseconds();
+        for (auto it = mLingeringSharedStreams.begin(); it != mLingeringSharedStreams.end();) {
+            if (it->expiryNanos <= nowNanos) {
+                ALOGV("%s() shared %p expired", __func__, it->endpoint.get());
+                it->endpoint->close();
+                mSharedLingerExpiredCount++;
+                mSharedCloseCount++;
+                it = mLingeringSharedStreams.erase(it);
+            } else {
+                nextExpiryNanos = std::min(nextExpiryNanos, it->expiryNanos);
+                ++it;
+            }
+        }
+    }
+    const std::lock_guard<std::mutex> lock(mExclusiveLock);
+    const int64_t nowNanos = AudioClock::getNanoseconds();
+    for (auto it = mLingeringExclusiveStreams.begin(); it != mLingeringExclusiveStreams.end();) {
+        if (it->expiryNanos <= nowNanos) {
+            ALOGV("%s() exclusive %p expired", __func__, it->endpoint.get());
+            it->endpoint->close();
+            mExclusiveLingerExpiredCount++;
+            mExclusiveCloseCount++;
+            it = mLingeringExclusiveStreams.erase(it);
+        } else {
+            nextExpiryNanos = std::min(nextExpiryNanos, it->expiryNanos);
+            ++it;
+        }
+    }
+    return nextExpiryNanos;
+}
+
+void AAudioEndpointManager::notifyLingerThread() {
+    {
+        std::lock_guard<std::mutex> lock(mLingerLock);
+        mLingerChanged = true;
+    }
+    mLingerCondition.notify_one();
+}
+
+void AAudioEndpointManager::run() {
+    std::unique_lock<std::mutex> lock(mLingerLock);
+    android::base::ScopedLockAssertion lockAssertion(mLingerLock);
+    while (!mLingerThreadExit) {
+        mLingerChanged = false;
+        lock.unlock();
+        const int64_t nextExpiryNanos = closeExpiredEndpoints();
+        lock.lock();
+        const auto wakeUp = [this]() {
+            android::base::ScopedLockAssertion lockAssertion(mLingerLock);
+            return mLingerThreadExit || mLingerChanged;
+        };
+        if (nextExpiryNanos == std::numeric_limits<int64_t>::max()) {
+            mLingerCondition.wait(lock, wakeUp);
+        } else {
+            const int64_t timeoutNanos = nextExpiryNanos - AudioClock::getNanoseconds();
+            mLingerCondition.wait_for(lock,
+                    std::chrono::nanoseconds(std::max<int64_t>(0, timeoutNanos)), wakeUp);
+        }
+    }
+}
+
 sp<AAudioServiceEndpoint> AAudioEndpointManager::openEndpoint(AAudioService &audioService,
                                         const aaudio::AAudioStreamRequest &request) {
     if (request.getConstantConfiguration().getSharingMode() == AAUDIO_SHARING_MODE_EXCLUSIVE) {
+        if (mLingerNanos > 0) {
+            // A lingering shared endpoint holds an exclusive endpoint that would prevent
+            // this stream from getting the MMAP resource. Active streams take precedence.
+            closeLingeringSharedEndpoints();
+        }
         sp<AAudioServiceEndpoint> endpointToSteal;
         sp<AAudioServiceEndpoint> foundEndpoint =
                 openExclusiveEndpoint(audioService, request, endpointToSteal);
@@ -189,7 +344,20 @@ sp<AAudioServiceEndpoint> AAudioEndpointManager::openExclusiveEndpoint(
             endpointToSteal = endpoint; // return it to caller
         }
         return nullptr;
+    } else if (const sp<AAudioServiceEndpointMMAP> lingeringEndpoint =
+                    reuseLingeringExclusiveEndpoint_l(configuration);
+            lingeringEndpoint != nullptr) {
+        ALOGV("%s(), reuse lingering MMAP %p for dev %d",
+              __func__, lingeringEndpoint.get(), configuration.getDeviceId());
+        endpoint = lingeringEndpoint;
+        mExclusiveStreams.push_back(lingeringEndpoint);
+        mExclusiveLingerHitCount++;
     } else {
+        if (mLingerNanos > 0) {
+            mExclusiveLingerMissCount++;
+            // The lingering endpoints may hold the MMAP resource needed by this one.
+            closeLingeringExclusiveEndpoints_l();
+        }
         const sp<AAudioServiceEndpointMMAP> endpointMMap =
                 new AAudioServiceEndpointMMAP(aaudioService);
         ALOGV("%s(), no match so try to open MMAP %p for dev %d",
@@ -226,6 +394,17 @@ sp<AAudioServiceEndpoint> AAudioEndpointManager::openSharedEndpoint(
     // Try to find an existing endpoint.
     sp<AAudioServiceEndpointShared> endpoint = findSharedEndpoint_l(configuration);
 
+    if (endpoint.get() == nullptr) {
+        endpoint = reuseLingeringSharedEndpoint_l(configuration);
+        if (endpoint.get() != nullptr) {
+            ALOGV("%s(), reuse lingering endpoint %p", __func__, endpoint.get());
+            mSharedStreams.push_back(endpoint);
+            mSharedLingerHitCount++;
+        } else if (mLingerNanos > 0) {
+            mSharedLingerMissCount++;
+        }
+    }
+
     // If we can't find an existing one then open a new one.
     if (endpoint.get() == nullptr) {
         // we must call openStream with audioserver identity
@@ -287,6 +466,18 @@ void AAudioEndpointManager::closeExclusiveEndpoint(
                 std::remove(mExclusiveStreams.begin(), mExclusiveStreams.end(), serviceEndpoint),
                 mExclusiveStreams.end());
 
+        // The endpoint of a shared endpoint lingers with the shared endpoint, not by itself.
+        if (mLingerNanos > 0 && serviceEndpoint->isConnected()
+                && !serviceEndpoint->isForSharing()) {
+            mLingeringExclusiveStreams.push_back({
+                    static_cast<AAudioServiceEndpointMMAP *>(serviceEndpoint.get()),
+                    AudioClock::getNanoseconds() + mLingerNanos});
+            ALOGV("%s() %p lingers for device %d",
+                  __func__, serviceEndpoint.get(), serviceEndpoint->getDeviceId());
+            notifyLingerThread();
+            return;
+        }
+
         serviceEndpoint->close();
         mExclusiveCloseCount++;
         ALOGV("%s() %p for device %d",
@@ -310,6 +501,16 @@ void AAudioEndpointManager::closeSharedEndpoint(const sp<AAudioServiceEndpoint>&
                 std::remove(mSharedStreams.begin(), mSharedStreams.end(), serviceEndpoint),
                 mSharedStreams.end());
 
+        if (mLingerNanos > 0 && serviceEndpoint->isConnected()) {
+            mLingeringSharedStreams.push_back({
+                    static_cast<AAudioServiceEndpointShared *>(serviceEndpoint.get()),
+                    AudioClock::getNanoseconds() + mLingerNanos});
+            ALOGV("%s(%p) lingers for device %d",
+                  __func__, serviceEndpoint.get(), serviceEndpoint->getDeviceId());
+            notifyLingerThread();
+            return;
+        }
+
         serviceEndpoint->close();
 
         mSharedCloseCount++;
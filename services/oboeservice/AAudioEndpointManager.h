@@ -17,6 +17,7 @@
 #ifndef AAUDIO_AAUDIO_ENDPOINT_MANAGER_H
 #define AAUDIO_AAUDIO_ENDPOINT_MANAGER_H
 
+#include <condition_variable>
 #include <map>
 #include <mutex>
 #include <sys/types.h>
@@ -29,13 +30,22 @@
 #include "AAudioServiceEndpointCapture.h"
 #include "AAudioServiceEndpointMMAP.h"
 #include "AAudioServiceEndpointPlay.h"
+#include "AAudioThread.h"
 
 namespace aaudio {
 
-class AAudioEndpointManager : public android::Singleton<AAudioEndpointManager> {
+/**
+ * Opens and shares the service endpoints.
+ *
+ * If AAUDIO_PROP_ENDPOINT_LINGER_MSEC is set then an endpoint whose last stream is closed
+ * is kept open for that time. A stream with a matching configuration that is opened in
+ * the meantime reuses it without the latency of opening the HAL stream.
+ */
+class AAudioEndpointManager : public android::Singleton<AAudioEndpointManager>,
+                              private Runnable {
 public:
     AAudioEndpointManager();
-    ~AAudioEndpointManager() = default;
+    ~AAudioEndpointManager() override;
 
     /**
      * Returns information about the state of the this class.
@@ -90,6 +100,36 @@ private:
     void closeExclusiveEndpoint(const android::sp<AAudioServiceEndpoint>& serviceEndpoint);
     void closeSharedEndpoint(const android::sp<AAudioServiceEndpoint>& serviceEndpoint);
 
+    /**
+     * Remove a lingering endpoint that matches the configuration from the pool.
+     * Disconnected endpoints are closed on the way.
+     *
+     * @return the endpoint or null
+     */
+    android::sp<AAudioServiceEndpointMMAP> reuseLingeringExclusiveEndpoint_l(
+            const AAudioStreamConfiguration& configuration)
+            REQUIRES(mExclusiveLock);
+
+    android::sp<AAudioServiceEndpointShared> reuseLingeringSharedEndpoint_l(
+            const AAudioStreamConfiguration& configuration)
+            REQUIRES(mSharedLock);
+
+    void closeLingeringExclusiveEndpoints_l() REQUIRES(mExclusiveLock);
+    void closeLingeringSharedEndpoints() EXCLUDES(mSharedLock);
+
+    /**
+     * Close the lingering endpoints that have expired.
+     *
+     * @return the time at which the next lingering endpoint expires, or INT64_MAX if none
+     */
+    int64_t closeExpiredEndpoints() EXCLUDES(mExclusiveLock, mSharedLock);
+
+    // Wake up the linger thread to recompute the next expiration time.
+    void notifyLingerThread() EXCLUDES(mLingerLock);
+
+    // Closes the lingering endpoints when they expire.
+    void run() override EXCLUDES(mLingerLock);
+
     // Use separate locks because opening a Shared endpoint requires opening an Exclusive one.
     // That could cause a recursive lock.
     // Lock mSharedLock before mExclusiveLock.
@@ -115,6 +155,35 @@ private:
     int32_t mSharedOpenCount      GUARDED_BY(mSharedLock) = 0;
     int32_t mSharedCloseCount     GUARDED_BY(mSharedLock) = 0;
 
+    // An endpoint that has no stream anymore, and is closed at expiryNanos unless it is reused.
+    template <typename T>
+    struct LingeringEndpoint {
+        android::sp<T> endpoint;
+        int64_t expiryNanos;
+    };
+    std::vector<LingeringEndpoint<AAudioServiceEndpointMMAP>>   mLingeringExclusiveStreams
+            GUARDED_BY(mExclusiveLock);
+    std::vector<LingeringEndpoint<AAudioServiceEndpointShared>> mLingeringSharedStreams
+            GUARDED_BY(mSharedLock);
+
+    // Counts related to the lingering endpoints.
+    int32_t mExclusiveLingerHitCount     GUARDED_BY(mExclusiveLock) = 0; // # REUSED
+    int32_t mExclusiveLingerMissCount    GUARDED_BY(mExclusiveLock) = 0; // # OPENED instead
+    int32_t mExclusiveLingerExpiredCount GUARDED_BY(mExclusiveLock) = 0; // # CLOSED unused
+    int32_t mSharedLingerHitCount        GUARDED_BY(mSharedLock) = 0;
+    int32_t mSharedLingerMissCount       GUARDED_BY(mSharedLock) = 0;
+    int32_t mSharedLingerExpiredCount    GUARDED_BY(mSharedLock) = 0;
+
+    // Zero if endpoints are closed as soon as they are no longer used.
+    const int64_t mLingerNanos;
+
+    // Lock mLingerLock after mSharedLock and mExclusiveLock.
+    std::mutex              mLingerLock;
+    std::condition_variable mLingerCondition;
+    bool                    mLingerChanged    GUARDED_BY(mLingerLock) = false;
+    bool                    mLingerThreadExit GUARDED_BY(mLingerLock) = false;
+    AAudioThread            mLingerThread{"AALinger"};
+
     // For easily disabling the stealing of exclusive streams.
     static constexpr bool kStealingEnabled = true;
 };
@@ -29,6 +29,14 @@
 #define AAUDIO_MIXER_ATRACE_ENABLED    1
 #endif
 
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#define AAUDIO_MIXER_USE_NEON    1
+#include <arm_neon.h>
+#elif defined(__SSE__)
+#define AAUDIO_MIXER_USE_SSE     1
+#include <xmmintrin.h>
+#endif
+
 using android::WrappingBuffer;
 using android::FifoBuffer;
 using android::fifo_frames_t;
@@ -88,7 +96,7 @@ int32_t AAudioMixer::mix(
             if (framesToMixFromPart > framesAvailableFromPart) {
                 framesToMixFromPart = framesAvailableFromPart;
             }
-            mixPart(destination, (float *)wrappingBuffer.data[partIndex],
+            mixPart(destination, (const float *)wrappingBuffer.data[partIndex],
                     framesToMixFromPart);
 
             destination += framesToMixFromPart * mSamplesPerFrame;
@@ -105,10 +113,30 @@ int32_t AAudioMixer::mix(
     return (framesDesired - framesLeft); // framesRead
 }
 
-void AAudioMixer::mixPart(float *destination, float *source, int32_t numFrames) {
+void AAudioMixer::mixPart(float *destination, const float *source, int32_t numFrames) {
+    // The samples are accumulated independently of the channel layout, so the same
+    // kernel serves mono, stereo and multichannel endpoints.
     int32_t numSamples = numFrames * mSamplesPerFrame;
-    // TODO maybe optimize using SIMD
-    for (int sampleIndex = 0; sampleIndex < numSamples; sampleIndex++) {
+#if AAUDIO_MIXER_USE_NEON
+    for (; numSamples >= 8; numSamples -= 8) {
+        const float32x4_t sum0 = vaddq_f32(vld1q_f32(destination), vld1q_f32(source));
+        const float32x4_t sum1 = vaddq_f32(vld1q_f32(destination + 4), vld1q_f32(source + 4));
+        vst1q_f32(destination, sum0);
+        vst1q_f32(destination + 4, sum1);
+        destination += 8;
+        source += 8;
+    }
+#elif AAUDIO_MIXER_USE_SSE
+    for (; numSamples >= 8; numSamples -= 8) {
+        const __m128 sum0 = _mm_add_ps(_mm_loadu_ps(destination), _mm_loadu_ps(source));
+        const __m128 sum1 = _mm_add_ps(_mm_loadu_ps(destination + 4), _mm_loadu_ps(source + 4));
+        _mm_storeu_ps(destination, sum0);
+        _mm_storeu_ps(destination + 4, sum1);
+        destination += 8;
+        source += 8;
+    }
+#endif
+    for (; numSamples > 0; numSamples--) {
         *destination++ += *source++;
     }
 }
@@ -46,7 +46,8 @@ public:
     int32_t getFramesPerBurst() const { return mFramesPerBurst; }
 
 private:
-    void mixPart(float *destination, float *source, int32_t numFrames);
+    // Accumulates numFrames of source into destination, using SIMD when available.
+    void mixPart(float *destination, const float *source, int32_t numFrames);
 
     std::unique_ptr<float[]> mOutputBuffer;
     int32_t  mSamplesPerFrame = 0;
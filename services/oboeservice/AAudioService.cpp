@@ -30,6 +30,7 @@
 
 #include "binding/AAudioServiceMessage.h"
 #include "AAudioClientTracker.h"
+#include "AAudioCommandQueue.h"
 #include "AAudioEndpointManager.h"
 #include "AAudioService.h"
 #include "AAudioServiceStreamMMAP.h"
@@ -76,7 +77,8 @@ status_t AAudioService::dump(int fd, const Vector<String16>& /*args*/) {
         result = "------------ AAudio Service ------------\n"
                  + mStreamTracker.dump()
                  + AAudioClientTracker::getInstance().dump()
-                 + AAudioEndpointManager::getInstance().dump();
+                 + AAudioEndpointManager::getInstance().dump()
+                 + AAudioCommandQueue::dumpWaitTimes();
     }
     (void)write(fd, result.c_str(), result.size());
     return NO_ERROR;
@@ -19,6 +19,7 @@
 
 #include <atomic>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -34,6 +35,8 @@
 
 namespace aaudio {
 
+class SharedRingBuffer;
+
 /**
  * AAudioServiceEndpoint is used by a subclass of AAudioServiceStreamBase
  * to communicate with the underlying audio device or port.
@@ -89,6 +92,14 @@ public:
         return AAUDIO_ERROR_UNAVAILABLE;
     }
 
+    /**
+     * @return a ring filled by the endpoint that client streams can read directly,
+     *         see SharedRingBuffer::allocateReader(), or nullptr
+     */
+    virtual std::shared_ptr<SharedRingBuffer> getSharedCaptureRing() const {
+        return nullptr;
+    }
+
     /**
      * @param positionFrames
      * @param timeNanos
@@ -46,6 +46,18 @@ aaudio_result_t AAudioServiceEndpointCapture::open(const aaudio::AAudioStreamReq
         int distributionBufferSizeBytes = getStreamInternal()->getFramesPerBurst()
                                           * getStreamInternal()->getBytesPerFrame();
         mDistributionBuffer = std::make_unique<uint8_t[]>(distributionBufferSizeBytes);
+
+        // The data is read once into a ring mapped by the client streams,
+        // so it does not have to be copied for each client.
+        const int32_t ringCapacity = AAudioServiceStreamShared::calculateBufferCapacity(
+                AAUDIO_UNSPECIFIED, getFramesPerBurst());
+        auto captureRing = std::make_shared<SharedRingBuffer>();
+        if (ringCapacity > 0 && captureRing->allocateShared(
+                getStreamInternal()->getBytesPerFrame(), ringCapacity) == AAUDIO_OK) {
+            mCaptureRing = std::move(captureRing);
+        } else {
+            ALOGW("%s() could not allocate the capture ring, copy the data", __func__);
+        }
     }
     return result;
 }
@@ -61,9 +73,22 @@ void *AAudioServiceEndpointCapture::callbackLoop() {
 
         int64_t mmapFramesRead = getStreamInternal()->getFramesRead();
 
+        // Read directly into the capture ring if the next burst is contiguous.
+        // The ring does not wait for its readers, each stream detects its own overrun.
+        std::shared_ptr<FifoBuffer> ring =
+                mCaptureRing != nullptr ? mCaptureRing->getFifoBuffer() : nullptr;
+        uint8_t *buffer = mDistributionBuffer.get();
+        if (ring != nullptr) {
+            ring->setReadCounter(ring->getWriteCounter());
+            WrappingBuffer wrappingBuffer;
+            ring->getEmptyRoomAvailable(&wrappingBuffer);
+            if (wrappingBuffer.numFrames[0] >= getFramesPerBurst()) {
+                buffer = static_cast<uint8_t *>(wrappingBuffer.data[0]);
+            }
+        }
+
         // Read audio data from stream using a blocking read.
-        result = getStreamInternal()->read(mDistributionBuffer.get(),
-                getFramesPerBurst(), timeoutNanos);
+        result = getStreamInternal()->read(buffer, getFramesPerBurst(), timeoutNanos);
         if (result == AAUDIO_ERROR_DISCONNECTED) {
             ALOGD("%s() read() returned AAUDIO_ERROR_DISCONNECTED", __func__);
             AAudioServiceEndpointShared::handleDisconnectRegisteredStreamsAsync();
@@ -74,6 +99,15 @@ void *AAudioServiceEndpointCapture::callbackLoop() {
             break;
         }
 
+        // Publish the burst to the streams reading the ring.
+        if (ring != nullptr) {
+            if (buffer == mDistributionBuffer.get()) {
+                ring->write(buffer, getFramesPerBurst());
+            } else {
+                ring->advanceWriteIndex(getFramesPerBurst());
+            }
+        }
+
         // Distribute data to each active stream.
         { // brackets are for lock_guard
             std::lock_guard <std::mutex> lock(mLockStreams);
@@ -82,7 +116,7 @@ void *AAudioServiceEndpointCapture::callbackLoop() {
                     sp<AAudioServiceStreamShared> streamShared =
                             static_cast<AAudioServiceStreamShared *>(clientStream.get());
                     streamShared->writeDataIfRoom(mmapFramesRead,
-                                                  mDistributionBuffer.get(),
+                                                  buffer,
                                                   getFramesPerBurst());
                 }
             }
@@ -24,6 +24,7 @@
 
 #include "AAudioServiceEndpointShared.h"
 #include "AAudioServiceStreamShared.h"
+#include "SharedRingBuffer.h"
 
 namespace aaudio {
 
@@ -36,8 +37,15 @@ public:
 
     void *callbackLoop() override;
 
+    std::shared_ptr<SharedRingBuffer> getSharedCaptureRing() const override {
+        return mCaptureRing;
+    }
+
 private:
+    // Used to copy the data to the streams which do not read the capture ring.
     std::unique_ptr<uint8_t[]>  mDistributionBuffer;
+    // Read once from the MMAP stream and mapped by all the client streams, may be null.
+    std::shared_ptr<SharedRingBuffer> mCaptureRing;
 };
 
 } /* namespace aaudio */
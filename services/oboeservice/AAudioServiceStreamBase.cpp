@@ -747,32 +747,26 @@ aaudio_result_t AAudioServiceStreamBase::getDescription_l(AudioEndpointParcelabl
 }
 
 aaudio_result_t AAudioServiceStreamBase::exitStandby(AudioEndpointParcelable *parcelable) {
-    auto command = std::make_shared<AAudioCommand>(
-            EXIT_STANDBY,
-            std::make_shared<ExitStandbyParam>(parcelable),
-            true /*waitForReply*/,
-            TIMEOUT_NANOS);
-    return mCommandQueue.sendCommand(command);
+    return sendCommand(EXIT_STANDBY,
+                       std::make_shared<ExitStandbyParam>(parcelable),
+                       true /*waitForReply*/,
+                       TIMEOUT_NANOS);
 }
 
 aaudio_result_t AAudioServiceStreamBase::sendStartClientCommand(const android::AudioClient &client,
                                                                 const audio_attributes_t *attr,
                                                                 audio_port_handle_t *clientHandle) {
-    auto command = std::make_shared<AAudioCommand>(
-            START_CLIENT,
-            std::make_shared<StartClientParam>(client, attr, clientHandle),
-            true /*waitForReply*/,
-            TIMEOUT_NANOS);
-    return mCommandQueue.sendCommand(command);
+    return sendCommand(START_CLIENT,
+                       std::make_shared<StartClientParam>(client, attr, clientHandle),
+                       true /*waitForReply*/,
+                       TIMEOUT_NANOS);
 }
 
 aaudio_result_t AAudioServiceStreamBase::sendStopClientCommand(audio_port_handle_t clientHandle) {
-    auto command = std::make_shared<AAudioCommand>(
-            STOP_CLIENT,
-            std::make_shared<StopClientParam>(clientHandle),
-            true /*waitForReply*/,
-            TIMEOUT_NANOS);
-    return mCommandQueue.sendCommand(command);
+    return sendCommand(STOP_CLIENT,
+                       std::make_shared<StopClientParam>(clientHandle),
+                       true /*waitForReply*/,
+                       TIMEOUT_NANOS);
 }
 
 void AAudioServiceStreamBase::onVolumeChanged(float volume) {
@@ -784,7 +778,26 @@ aaudio_result_t AAudioServiceStreamBase::sendCommand(aaudio_command_opcode opCod
                                                      bool waitForReply,
                                                      int64_t timeoutNanos) {
     return mCommandQueue.sendCommand(std::make_shared<AAudioCommand>(
-            opCode, param, waitForReply, timeoutNanos));
+            opCode, param, waitForReply, timeoutNanos, getCommandLane(opCode)));
+}
+
+aaudio_command_lane AAudioServiceStreamBase::getCommandLane(aaudio_command_opcode opCode) const {
+    if (!isPriorityCommandLaneEnabled()) {
+        return AAUDIO_COMMAND_LANE_NORMAL;
+    }
+    switch (opCode) {
+        // Transport commands of an open stream do not wait behind slow commands,
+        // such as a CLOSE or a GET_DESCRIPTION, that are queued by other binder threads.
+        case START:
+        case PAUSE:
+        case STOP:
+        case FLUSH:
+        case START_CLIENT:
+        case STOP_CLIENT:
+            return AAUDIO_COMMAND_LANE_PRIORITY;
+        default:
+            return AAUDIO_COMMAND_LANE_NORMAL;
+    }
 }
 
 aaudio_result_t AAudioServiceStreamBase::closeAndClear() {
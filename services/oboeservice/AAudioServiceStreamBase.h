@@ -324,6 +324,13 @@ protected:
         return false;
     }
 
+    /**
+     * @return true if START, PAUSE, STOP and FLUSH may bypass the other queued commands.
+     */
+    virtual bool isPriorityCommandLaneEnabled() const {
+        return false;
+    }
+
     class ExitStandbyParam : public AAudioCommandParam {
     public:
         explicit ExitStandbyParam(AudioEndpointParcelable* parcelable)
@@ -447,6 +454,8 @@ private:
                                 bool waitForReply = false,
                                 int64_t timeoutNanos = 0);
 
+    aaudio_command_lane getCommandLane(aaudio_command_opcode opCode) const;
+
     void stopCommandThread();
 
     aaudio_result_t closeAndClear();
@@ -77,6 +77,11 @@ protected:
         return true;
     }
 
+    // An MMAP stream is started by the app on a latency critical path.
+    bool isPriorityCommandLaneEnabled() const override {
+        return true;
+    }
+
     aaudio_result_t exitStandby_l(AudioEndpointParcelable* parcelable) REQUIRES(mLock) override;
 
     aaudio_result_t getAudioDataDescription_l(
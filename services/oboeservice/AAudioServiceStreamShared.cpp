@@ -184,9 +184,27 @@ aaudio_result_t AAudioServiceStreamShared::open(const aaudio::AAudioStreamReques
 
     {
         std::lock_guard<std::mutex> lock(audioDataQueueLock);
-        // Create audio data shared memory buffer for client.
-        mAudioDataQueue = std::make_shared<SharedRingBuffer>();
-        result = mAudioDataQueue->allocate(calculateBytesPerFrame(), getBufferCapacity());
+        // Read captured data directly from the ring of the endpoint if it is large enough.
+        std::shared_ptr<SharedRingBuffer> captureRing = endpoint->getSharedCaptureRing();
+        result = AAUDIO_ERROR_UNAVAILABLE;
+        if (captureRing != nullptr) {
+            std::shared_ptr<FifoBuffer> ringFifo = captureRing->getFifoBuffer();
+            if (getBufferCapacity() <= ringFifo->getBufferCapacityInFrames()
+                    && calculateBytesPerFrame() == ringFifo->getBytesPerFrame()) {
+                mAudioDataQueue = std::make_shared<SharedRingBuffer>();
+                result = mAudioDataQueue->allocateReader(captureRing);
+                if (result == AAUDIO_OK) {
+                    setBufferCapacity(ringFifo->getBufferCapacityInFrames());
+                } else {
+                    ALOGW("%s() could not read the capture ring, copy the data", __func__);
+                }
+            }
+        }
+        if (result != AAUDIO_OK) {
+            // Create audio data shared memory buffer for client.
+            mAudioDataQueue = std::make_shared<SharedRingBuffer>();
+            result = mAudioDataQueue->allocate(calculateBytesPerFrame(), getBufferCapacity());
+        }
         if (result != AAUDIO_OK) {
             ALOGE("%s() could not allocate FIFO with %d frames",
                   __func__, getBufferCapacity());
@@ -274,7 +292,18 @@ void AAudioServiceStreamShared::writeDataIfRoom(int64_t mmapFramesRead,
     // Lock the AudioFifo to protect against close.
     std::lock_guard <std::mutex> lock(audioDataQueueLock);
 
-    if (mAudioDataQueue != nullptr) {
+    if (mAudioDataQueue != nullptr && mAudioDataQueue->isReader()) {
+        std::shared_ptr<FifoBuffer> fifo = mAudioDataQueue->getFifoBuffer();
+        // The endpoint has already written the burst to the capture ring.
+        clientFramesWritten = fifo->getWriteCounter();
+        int64_t positionOffset = mmapFramesRead - (clientFramesWritten - numFrames);
+        setTimestampPositionOffset(positionOffset);
+
+        // The ring does not wait for this client, the oldest data was overwritten.
+        if (fifo->getFullFramesAvailable() > fifo->getBufferCapacityInFrames()) {
+            incrementXRunCount();
+        }
+    } else if (mAudioDataQueue != nullptr) {
         std::shared_ptr<FifoBuffer> fifo = mAudioDataQueue->getFifoBuffer();
         // Determine offset between framePosition in client's stream
         // vs the underlying MMAP stream.
@@ -53,6 +53,11 @@ public:
     aaudio_result_t open(const aaudio::AAudioStreamRequest &request) override
             EXCLUDES(mUpMessageQueueLock);
 
+    /**
+     * Write a burst of captured data to the client.
+     * If the stream reads the shared capture ring of the endpoint then the data is already
+     * in the ring, and only the position offset and the overrun count are updated.
+     */
     void writeDataIfRoom(int64_t mmapFramesRead, const void *buffer, int32_t numFrames);
 
     /**
@@ -83,6 +88,14 @@ public:
 
     const char *getTypeText() const override { return "Shared"; }
 
+    /**
+     * @param requestedCapacityFrames
+     * @param framesPerBurst
+     * @return capacity or negative error
+     */
+    static int32_t calculateBufferCapacity(int32_t requestedCapacityFrames,
+                                            int32_t framesPerBurst);
+
     // This is public so that the thread safety annotation, GUARDED_BY(),
     // Can work when another object takes the lock.
     mutable std::mutex   audioDataQueueLock;
@@ -98,14 +111,6 @@ protected:
     aaudio_result_t getHardwareTimestamp_l(
             int64_t *positionFrames, int64_t *timeNanos) REQUIRES(mLock) override;
 
-    /**
-     * @param requestedCapacityFrames
-     * @param framesPerBurst
-     * @return capacity or negative error
-     */
-    static int32_t calculateBufferCapacity(int32_t requestedCapacityFrames,
-                                            int32_t framesPerBurst);
-
 private:
 
     std::shared_ptr<SharedRingBuffer> mAudioDataQueue PT_GUARDED_BY(audioDataQueueLock);
@@ -39,14 +39,9 @@ SharedRingBuffer::~SharedRingBuffer()
     }
 }
 
-aaudio_result_t SharedRingBuffer::allocate(fifo_frames_t   bytesPerFrame,
-                                         fifo_frames_t   capacityInFrames) {
-    mCapacityInFrames = capacityInFrames;
-
-    // Create shared memory large enough to hold the data and the read and write counters.
-    mDataMemorySizeInBytes = bytesPerFrame * capacityInFrames;
-    mSharedMemorySizeInBytes = mDataMemorySizeInBytes + (2 * (sizeof(fifo_counter_t)));
-    mFileDescriptor.reset(ashmem_create_region("AAudioSharedRingBuffer", mSharedMemorySizeInBytes));
+aaudio_result_t SharedRingBuffer::createSharedMemory(const char *name, int32_t sizeInBytes) {
+    mSharedMemorySizeInBytes = sizeInBytes;
+    mFileDescriptor.reset(ashmem_create_region(name, mSharedMemorySizeInBytes));
     if (mFileDescriptor.get() == -1) {
         ALOGE("allocate() ashmem_create_region() failed %d", errno);
         return AAUDIO_ERROR_INTERNAL;
@@ -72,6 +67,20 @@ aaudio_result_t SharedRingBuffer::allocate(fifo_frames_t   bytesPerFrame,
         return AAUDIO_ERROR_INTERNAL; // TODO convert errno to a better AAUDIO_ERROR;
     }
     mSharedMemory = tmpPtr;
+    return AAUDIO_OK;
+}
+
+aaudio_result_t SharedRingBuffer::allocate(fifo_frames_t   bytesPerFrame,
+                                         fifo_frames_t   capacityInFrames) {
+    mCapacityInFrames = capacityInFrames;
+
+    // Create shared memory large enough to hold the data and the read and write counters.
+    mDataMemorySizeInBytes = bytesPerFrame * capacityInFrames;
+    aaudio_result_t result = createSharedMemory("AAudioSharedRingBuffer",
+            mDataMemorySizeInBytes + SHARED_RINGBUFFER_DATA_OFFSET);
+    if (result != AAUDIO_OK) {
+        return result;
+    }
 
     // Get addresses for our counters and data from the shared memory.
     auto readCounterAddress = (fifo_counter_t *) &mSharedMemory[SHARED_RINGBUFFER_READ_OFFSET];
@@ -83,8 +92,72 @@ aaudio_result_t SharedRingBuffer::allocate(fifo_frames_t   bytesPerFrame,
     return AAUDIO_OK;
 }
 
+aaudio_result_t SharedRingBuffer::allocateShared(fifo_frames_t   bytesPerFrame,
+                                               fifo_frames_t   capacityInFrames) {
+    aaudio_result_t result = allocate(bytesPerFrame, capacityInFrames);
+    if (result != AAUDIO_OK) {
+        return result;
+    }
+    // The mapping of the service stays writable, later mappings by the clients
+    // can only read. So a client cannot modify the data read by other clients.
+    if (ashmem_set_prot_region(mFileDescriptor.get(), PROT_READ) < 0) {
+        ALOGE("allocateShared() ashmem_set_prot_region() failed %d", errno);
+        return AAUDIO_ERROR_INTERNAL;
+    }
+    mReadOnlyForClients = true;
+    return AAUDIO_OK;
+}
+
+aaudio_result_t SharedRingBuffer::allocateReader(
+        const std::shared_ptr<SharedRingBuffer>& sharedRing) {
+    if (sharedRing == nullptr || !sharedRing->mReadOnlyForClients) {
+        ALOGE("allocateReader() needs a ring created by allocateShared()");
+        return AAUDIO_ERROR_INVALID_STATE;
+    }
+    aaudio_result_t result = createSharedMemory("AAudioSharedRingReader",
+                                                SHARED_RINGBUFFER_READER_SIZE);
+    if (result != AAUDIO_OK) {
+        return result;
+    }
+    mSharedRing = sharedRing;
+    mCapacityInFrames = sharedRing->mCapacityInFrames;
+    mDataMemorySizeInBytes = sharedRing->mDataMemorySizeInBytes;
+
+    // Only the read counter is ours, the data and the write counter belong to the ring.
+    auto readCounterAddress = (fifo_counter_t *) mSharedMemory;
+    auto writeCounterAddress = (fifo_counter_t *)
+            &sharedRing->mSharedMemory[SHARED_RINGBUFFER_WRITE_OFFSET];
+    uint8_t *dataAddress = &sharedRing->mSharedMemory[SHARED_RINGBUFFER_DATA_OFFSET];
+
+    mFifoBuffer = std::make_shared<FifoBufferIndirect>(
+            sharedRing->mFifoBuffer->getBytesPerFrame(), mCapacityInFrames,
+            readCounterAddress, writeCounterAddress, dataAddress,
+            false /* resetCounters */);
+    mFifoBuffer->setReadCounter(mFifoBuffer->getWriteCounter());
+    return AAUDIO_OK;
+}
+
 void SharedRingBuffer::fillParcelable(AudioEndpointParcelable* endpointParcelable,
                     RingBufferParcelable &ringBufferParcelable) {
+    if (mSharedRing != nullptr) {
+        // The data and the write counter are in the read-only memory of the ring,
+        // the read counter is in our own memory.
+        const int ringIndex = endpointParcelable->addFileDescriptor(
+                mSharedRing->mFileDescriptor, mSharedRing->mSharedMemorySizeInBytes,
+                false /* writeable */);
+        const int readerIndex = endpointParcelable->addFileDescriptor(
+                mFileDescriptor, mSharedMemorySizeInBytes);
+        ringBufferParcelable.setupMemory(
+                {ringIndex, SHARED_RINGBUFFER_DATA_OFFSET, mDataMemorySizeInBytes},
+                {readerIndex, 0, sizeof(fifo_counter_t)},
+                {ringIndex, SHARED_RINGBUFFER_WRITE_OFFSET, sizeof(fifo_counter_t)});
+        ringBufferParcelable.setBytesPerFrame(mFifoBuffer->getBytesPerFrame());
+        ringBufferParcelable.setFramesPerBurst(1);
+        ringBufferParcelable.setCapacityInFrames(mCapacityInFrames);
+        ringBufferParcelable.setFlags(static_cast<RingbufferFlags>(
+                RingbufferFlags::COUNTERS_CACHE_ALIGNED | RingbufferFlags::SHARED_READ_ONLY));
+        return;
+    }
     int fdIndex = endpointParcelable->addFileDescriptor(mFileDescriptor, mSharedMemorySizeInBytes);
     ringBufferParcelable.setupMemory(fdIndex,
                                      SHARED_RINGBUFFER_DATA_OFFSET,
@@ -95,6 +168,7 @@ void SharedRingBuffer::fillParcelable(AudioEndpointParcelable* endpointParcelabl
     ringBufferParcelable.setBytesPerFrame(mFifoBuffer->getBytesPerFrame());
     ringBufferParcelable.setFramesPerBurst(1);
     ringBufferParcelable.setCapacityInFrames(mCapacityInFrames);
+    ringBufferParcelable.setFlags(RingbufferFlags::COUNTERS_CACHE_ALIGNED);
 }
 
 double SharedRingBuffer::getFractionalFullness() const {
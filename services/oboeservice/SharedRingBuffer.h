@@ -19,6 +19,7 @@
 
 #include <android-base/unique_fd.h>
 #include <cutils/ashmem.h>
+#include <memory>
 #include <stdint.h>
 #include <string>
 #include <sys/mman.h>
@@ -30,9 +31,14 @@
 namespace aaudio {
 
 // Determine the placement of the counters and data in shared memory.
+// Each counter has its own cache line so that the client and the service do not
+// contend for the same line when they advance their counter.
 #define SHARED_RINGBUFFER_READ_OFFSET   0
-#define SHARED_RINGBUFFER_WRITE_OFFSET  sizeof(fifo_counter_t)
-#define SHARED_RINGBUFFER_DATA_OFFSET   (SHARED_RINGBUFFER_WRITE_OFFSET + sizeof(fifo_counter_t))
+#define SHARED_RINGBUFFER_WRITE_OFFSET  android::kFifoCounterAlignment
+#define SHARED_RINGBUFFER_DATA_OFFSET   (SHARED_RINGBUFFER_WRITE_OFFSET \
+                                         + android::kFifoCounterAlignment)
+// A reader of a shared ring only owns its read counter.
+#define SHARED_RINGBUFFER_READER_SIZE   android::kFifoCounterAlignment
 
 /**
  * Atomic FIFO that uses shared memory.
@@ -45,6 +51,22 @@ public:
 
     aaudio_result_t allocate(android::fifo_frames_t bytesPerFrame, android::fifo_frames_t capacityInFrames);
 
+    /**
+     * Allocate a ring whose data and write counter are shared by several readers,
+     * see allocateReader(). The clients can only map the memory for reading.
+     * The ring is written by the service without waiting for the readers,
+     * each reader detects its own overrun.
+     */
+    aaudio_result_t allocateShared(android::fifo_frames_t bytesPerFrame,
+                                   android::fifo_frames_t capacityInFrames);
+
+    /**
+     * Allocate a private read counter for a ring created by allocateShared().
+     * The data and the write counter are not copied, the FIFO of this object reads the ring
+     * directly. The read counter starts at the current write counter of the ring.
+     */
+    aaudio_result_t allocateReader(const std::shared_ptr<SharedRingBuffer>& sharedRing);
+
     void fillParcelable(AudioEndpointParcelable* endpointParcelable,
                         RingBufferParcelable &ringBufferParcelable);
 
@@ -61,7 +83,14 @@ public:
         return mFifoBuffer;
     }
 
+    // True if this was created by allocateReader().
+    bool isReader() const {
+        return mSharedRing != nullptr;
+    }
+
 private:
+    aaudio_result_t createSharedMemory(const char *name, int32_t sizeInBytes);
+
     android::base::unique_fd  mFileDescriptor;
     std::shared_ptr<android::FifoBufferIndirect>  mFifoBuffer;
     uint8_t                  *mSharedMemory = nullptr; // mmap
@@ -69,6 +98,9 @@ private:
     // size of memory used for data vs counters
     int32_t                   mDataMemorySizeInBytes = 0;
     android::fifo_frames_t    mCapacityInFrames = 0;
+    bool                      mReadOnlyForClients = false; // set by allocateShared()
+    // The ring read by this reader, set by allocateReader().
+    std::shared_ptr<SharedRingBuffer> mSharedRing;
 };
 
 } /* namespace aaudio */
@@ -19,7 +19,9 @@
 #include "TunerDvr.h"
 
 #include <aidl/android/hardware/tv/tuner/Result.h>
+#include <inttypes.h>
 #include <utils/Log.h>
+#include <utils/Timers.h>
 
 #include "TunerFilter.h"
 
@@ -31,9 +33,10 @@ namespace media {
 namespace tv {
 namespace tuner {
 
-TunerDvr::TunerDvr(shared_ptr<IDvr> dvr, DvrType type) {
+TunerDvr::TunerDvr(shared_ptr<IDvr> dvr, DvrType type, shared_ptr<DvrCallback> callback) {
     mDvr = dvr;
     mType = type;
+    mCallback = callback;
 }
 
 TunerDvr::~TunerDvr() {
@@ -82,10 +85,15 @@ TunerDvr::~TunerDvr() {
 }
 
 ::ndk::ScopedAStatus TunerDvr::start() {
-    return mDvr->start();
+    ::ndk::ScopedAStatus s = mDvr->start();
+    if (s.isOk() && mStartTimeNs == 0) {
+        mStartTimeNs = systemTime();
+    }
+    return s;
 }
 
 ::ndk::ScopedAStatus TunerDvr::stop() {
+    logStats();
     return mDvr->stop();
 }
 
@@ -94,6 +102,7 @@ TunerDvr::~TunerDvr() {
 }
 
 ::ndk::ScopedAStatus TunerDvr::close() {
+    logStats();
     isClosed = true;
     return mDvr->close();
 }
@@ -113,8 +122,33 @@ TunerDvr::~TunerDvr() {
     return s;
 }
 
+void TunerDvr::logStats() {
+    if (mStartTimeNs == 0) {
+        return;
+    }
+    const int64_t durationMs = (systemTime() - mStartTimeNs) / 1000000;
+    mStartTimeNs = 0;
+    if (mCallback == nullptr) {
+        return;
+    }
+    // The data goes through the queue between the app and the HAL, the
+    // status events are what this service sees of it.
+    if (mType == DvrType::RECORD) {
+        const int64_t overflows = mCallback->getOverflowCount();
+        ALOGI_IF(overflows > 0, "record DVR overflowed %" PRId64
+                 " times since open, ran for %" PRId64 " ms", overflows, durationMs);
+    } else {
+        const int64_t empties = mCallback->getEmptyCount();
+        ALOGI_IF(empties > 0, "playback DVR ran empty %" PRId64
+                 " times since open, ran for %" PRId64 " ms", empties, durationMs);
+    }
+}
+
 /////////////// IDvrCallback ///////////////////////
 ::ndk::ScopedAStatus TunerDvr::DvrCallback::onRecordStatus(const RecordStatus status) {
+    if (status == RecordStatus::OVERFLOW) {
+        mOverflowCount++;
+    }
     if (mTunerDvrCallback != nullptr) {
         mTunerDvrCallback->onRecordStatus(status);
     }
@@ -122,6 +156,9 @@ TunerDvr::~TunerDvr() {
 }
 
 ::ndk::ScopedAStatus TunerDvr::DvrCallback::onPlaybackStatus(const PlaybackStatus status) {
+    if (status == PlaybackStatus::SPACE_EMPTY) {
+        mEmptyCount++;
+    }
     if (mTunerDvrCallback != nullptr) {
         mTunerDvrCallback->onPlaybackStatus(status);
     }
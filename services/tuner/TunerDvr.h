@@ -26,6 +26,8 @@
 #include <aidl/android/media/tv/tuner/BnTunerDvr.h>
 #include <aidl/android/media/tv/tuner/ITunerDvrCallback.h>
 
+#include <atomic>
+
 #include "TunerFilter.h"
 
 using ::aidl::android::hardware::common::fmq::MQDescriptor;
@@ -50,7 +52,9 @@ using AidlMQDesc = MQDescriptor<int8_t, SynchronizedReadWrite>;
 class TunerDvr : public BnTunerDvr {
 
 public:
-    TunerDvr(shared_ptr<IDvr> dvr, DvrType type);
+    struct DvrCallback;
+
+    TunerDvr(shared_ptr<IDvr> dvr, DvrType type, shared_ptr<DvrCallback> callback = nullptr);
     ~TunerDvr();
 
     ::ndk::ScopedAStatus getQueueDesc(AidlMQDesc* _aidl_return) override;
@@ -70,13 +74,24 @@ public:
         ::ndk::ScopedAStatus onRecordStatus(const RecordStatus status) override;
         ::ndk::ScopedAStatus onPlaybackStatus(const PlaybackStatus status) override;
 
+        // Number of times a record lost data, or a playback ran out of data.
+        int64_t getOverflowCount() const { return mOverflowCount; }
+        int64_t getEmptyCount() const { return mEmptyCount; }
+
     private:
         shared_ptr<ITunerDvrCallback> mTunerDvrCallback;
+        atomic<int64_t> mOverflowCount = 0;
+        atomic<int64_t> mEmptyCount = 0;
     };
 
 private:
+    void logStats();
+
     shared_ptr<IDvr> mDvr;
     DvrType mType;
+    shared_ptr<DvrCallback> mCallback;
+    // Start time of the running DVR, 0 when stopped.
+    int64_t mStartTimeNs = 0;
     bool isClosed = false;
 };
 
@@ -20,6 +20,7 @@
 
 #include <aidl/android/hardware/tv/tuner/Result.h>
 #include <binder/IPCThreadState.h>
+#include <cutils/properties.h>
 
 #include "TunerHelper.h"
 #include "TunerService.h"
@@ -334,8 +335,61 @@ shared_ptr<IFilter> TunerFilter::getHalFilter() {
 }
 
 /////////////// FilterCallback ///////////////////////
+TunerFilter::FilterCallback::FilterCallback(
+        const shared_ptr<ITunerFilterCallback>& tunerFilterCallback)
+      : mTunerFilterCallback(tunerFilterCallback),
+        mOriginalCallback(nullptr),
+        mMaxBatchEvents(max(property_get_int32("media.tuner.filter.event_batch_size", 1), 1)),
+        mBatchWindowNs(milliseconds_to_nanoseconds(
+                max(property_get_int32("media.tuner.filter.event_batch_window_ms", 10), 0))) {
+    if (mMaxBatchEvents > 1) {
+        mPendingEvents.reserve(mMaxBatchEvents);
+        mFlushThread = thread(&FilterCallback::flushThreadLoop, this);
+    }
+}
+
+TunerFilter::FilterCallback::~FilterCallback() {
+    if (mFlushThread.joinable()) {
+        {
+            Mutex::Autolock _l(mCallbackLock);
+            mExitFlushThread = true;
+            mPendingCondition.signal();
+        }
+        mFlushThread.join();
+    }
+}
+
+void TunerFilter::FilterCallback::flushEvents_l() {
+    if (mPendingEvents.empty()) {
+        return;
+    }
+    if (mTunerFilterCallback != nullptr) {
+        mTunerFilterCallback->onFilterEvent(mPendingEvents);
+    }
+    mPendingEvents.clear();
+}
+
+// Delivers the pending events when the oldest of them has waited for the batch window.
+void TunerFilter::FilterCallback::flushThreadLoop() {
+    Mutex::Autolock _l(mCallbackLock);
+    while (!mExitFlushThread) {
+        if (mPendingEvents.empty()) {
+            mPendingCondition.wait(mCallbackLock);
+            continue;
+        }
+        const nsecs_t remainingNs = mPendingSinceNs + mBatchWindowNs - systemTime();
+        if (remainingNs > 0) {
+            mPendingCondition.waitRelative(mCallbackLock, remainingNs);
+            continue;
+        }
+        flushEvents_l();
+    }
+}
+
 ::ndk::ScopedAStatus TunerFilter::FilterCallback::onFilterStatus(DemuxFilterStatus status) {
     Mutex::Autolock _l(mCallbackLock);
+    // The status may be about the data of the pending events.
+    flushEvents_l();
     if (mTunerFilterCallback != nullptr) {
         mTunerFilterCallback->onFilterStatus(status);
     }
@@ -345,14 +399,38 @@ shared_ptr<IFilter> TunerFilter::getHalFilter() {
 ::ndk::ScopedAStatus TunerFilter::FilterCallback::onFilterEvent(
         const vector<DemuxFilterEvent>& events) {
     Mutex::Autolock _l(mCallbackLock);
-    if (mTunerFilterCallback != nullptr) {
+    if (mTunerFilterCallback == nullptr) {
+        return ::ndk::ScopedAStatus::ok();
+    }
+    // Only the section events are coalesced, as the other events may carry handles
+    // (e.g. the media events) and are not copyable.
+    bool sectionsOnly = mMaxBatchEvents > 1;
+    for (size_t i = 0; i < events.size() && sectionsOnly; i++) {
+        sectionsOnly = events[i].getTag() == DemuxFilterEvent::Tag::section;
+    }
+    if (!sectionsOnly) {
+        flushEvents_l();
         mTunerFilterCallback->onFilterEvent(events);
+        return ::ndk::ScopedAStatus::ok();
+    }
+
+    if (mPendingEvents.empty()) {
+        mPendingSinceNs = systemTime();
+        mPendingCondition.signal();
+    }
+    for (const DemuxFilterEvent& event : events) {
+        mPendingEvents.push_back(DemuxFilterEvent::make<DemuxFilterEvent::Tag::section>(
+                event.get<DemuxFilterEvent::Tag::section>()));
+    }
+    if (mPendingEvents.size() >= mMaxBatchEvents) {
+        flushEvents_l();
     }
     return ::ndk::ScopedAStatus::ok();
 }
 
 void TunerFilter::FilterCallback::sendSharedFilterStatus(int32_t status) {
     Mutex::Autolock _l(mCallbackLock);
+    flushEvents_l();
     if (mTunerFilterCallback != nullptr && mOriginalCallback != nullptr) {
         mTunerFilterCallback->onFilterStatus(static_cast<DemuxFilterStatus>(status));
     }
@@ -361,12 +439,14 @@ void TunerFilter::FilterCallback::sendSharedFilterStatus(int32_t status) {
 void TunerFilter::FilterCallback::attachSharedFilterCallback(
         const shared_ptr<ITunerFilterCallback>& in_cb) {
     Mutex::Autolock _l(mCallbackLock);
+    flushEvents_l();
     mOriginalCallback = mTunerFilterCallback;
     mTunerFilterCallback = in_cb;
 }
 
 void TunerFilter::FilterCallback::detachSharedFilterCallback() {
     Mutex::Autolock _l(mCallbackLock);
+    flushEvents_l();
     if (mTunerFilterCallback != nullptr && mOriginalCallback != nullptr) {
         mTunerFilterCallback = mOriginalCallback;
         mOriginalCallback = nullptr;
@@ -375,6 +455,7 @@ void TunerFilter::FilterCallback::detachSharedFilterCallback() {
 
 void TunerFilter::FilterCallback::detachCallbacks() {
     Mutex::Autolock _l(mCallbackLock);
+    mPendingEvents.clear();
     mOriginalCallback = nullptr;
     mTunerFilterCallback = nullptr;
 }
@@ -27,7 +27,11 @@
 #include <aidl/android/hardware/tv/tuner/IFilter.h>
 #include <aidl/android/media/tv/tuner/BnTunerFilter.h>
 #include <aidl/android/media/tv/tuner/ITunerFilterCallback.h>
+#include <utils/Condition.h>
 #include <utils/Mutex.h>
+#include <utils/Timers.h>
+
+#include <thread>
 
 using ::aidl::android::hardware::common::NativeHandle;
 using ::aidl::android::hardware::common::fmq::MQDescriptor;
@@ -41,6 +45,7 @@ using ::aidl::android::hardware::tv::tuner::DemuxFilterType;
 using ::aidl::android::hardware::tv::tuner::FilterDelayHint;
 using ::aidl::android::hardware::tv::tuner::IFilter;
 using ::aidl::android::media::tv::tuner::BnTunerFilter;
+using ::android::Condition;
 using ::android::Mutex;
 
 using namespace std;
@@ -59,8 +64,8 @@ class TunerFilter : public BnTunerFilter {
 public:
     class FilterCallback : public BnFilterCallback {
     public:
-        FilterCallback(const shared_ptr<ITunerFilterCallback>& tunerFilterCallback)
-              : mTunerFilterCallback(tunerFilterCallback), mOriginalCallback(nullptr){};
+        FilterCallback(const shared_ptr<ITunerFilterCallback>& tunerFilterCallback);
+        ~FilterCallback();
 
         ::ndk::ScopedAStatus onFilterEvent(const vector<DemuxFilterEvent>& events) override;
         ::ndk::ScopedAStatus onFilterStatus(DemuxFilterStatus status) override;
@@ -71,9 +76,24 @@ public:
         void detachCallbacks();
 
     private:
+        void flushEvents_l();
+        void flushThreadLoop();
+
         shared_ptr<ITunerFilterCallback> mTunerFilterCallback;
         shared_ptr<ITunerFilterCallback> mOriginalCallback;
         Mutex mCallbackLock;
+
+        // Section events are coalesced into one callback of up to mMaxBatchEvents
+        // events, delivered at the latest mBatchWindowNs after the first of them.
+        // Set by media.tuner.filter.event_batch_size (1, the default, disables it)
+        // and media.tuner.filter.event_batch_window_ms.
+        const size_t mMaxBatchEvents;
+        const nsecs_t mBatchWindowNs;
+        vector<DemuxFilterEvent> mPendingEvents;
+        nsecs_t mPendingSinceNs = 0;
+        Condition mPendingCondition;
+        bool mExitFlushThread = false;
+        thread mFlushThread;
     };
 
     TunerFilter(const shared_ptr<IFilter> filter, const shared_ptr<FilterCallback> cb,